@@ -122,7 +122,9 @@ int vblk_prep_mmc_multi_ioc(struct vblk_dev *vblkdev,
 
 	ioctl_req->ioctl_id = VBLK_MMC_MULTI_IOC_ID;
 	ioctl_req->ioctl_buf = ioctl_buf;
-	ioctl_req->ioctl_len = ioctl_bytes;
+	/* Only the used part of the buffer goes through the mempool */
+	ioctl_req->ioctl_len = min_t(uint32_t, ALIGN(combo_cmd_size, SZ_512),
+			ioctl_bytes);
 
 free_ioc_buf:
 	if (err && ioctl_buf)
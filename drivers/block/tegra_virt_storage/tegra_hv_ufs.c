@@ -240,7 +240,8 @@ int vblk_prep_ufs_combo_ioc(struct vblk_dev *vblkdev,
 
 	ioctl_req->ioctl_id = VBLK_UFS_COMBO_IO_ID;
 	ioctl_req->ioctl_buf = ioctl_buf;
-	ioctl_req->ioctl_len = ioctl_bytes;
+	/* Only the used part of the buffer goes through the mempool */
+	ioctl_req->ioctl_len = combo_cmd_size;
 
 free_ioc_buf:
 	if (err && ioctl_buf)
@@ -62,22 +62,26 @@ static inline uint64_t _arch_counter_get_cntvct(void)
 }
 
 /**
- * vblk_get_req: Get a handle to free vsc request.
+ * vblk_get_req: Get a handle to free vsc request from the queue's slice.
  */
-static struct vsc_request *vblk_get_req(struct vblk_dev *vblkdev)
+static struct vsc_request *vblk_get_req(struct vblk_queue *vq)
 {
+	struct vblk_dev *vblkdev = vq->vblkdev;
 	struct vsc_request *req = NULL;
+	unsigned long end = vq->req_base + vq->req_count;
 	unsigned long bit;
 
 	if (vblkdev->queue_state != VBLK_QUEUE_ACTIVE)
 		goto exit;
 
-	bit = find_first_zero_bit(vblkdev->pending_reqs, vblkdev->max_requests);
-	if (bit < vblkdev->max_requests) {
+	bit = find_next_zero_bit(vblkdev->pending_reqs, end, vq->req_base);
+	if (bit < end) {
 		req = &vblkdev->reqs[bit];
 		req->vs_req.req_id = bit;
 		set_bit(bit, vblkdev->pending_reqs);
+		spin_lock(&vblkdev->lock);
 		vblkdev->inflight_reqs++;
+		spin_unlock(&vblkdev->lock);
 		mod_timer(&req->timer, jiffies + 30*HZ);
 	}
 
@@ -85,12 +89,13 @@ exit:
 	return req;
 }
 
-static struct vsc_request *vblk_get_req_by_sr_num(struct vblk_dev *vblkdev,
+static struct vsc_request *vblk_get_req_by_sr_num(struct vblk_queue *vq,
 		uint32_t num)
 {
+	struct vblk_dev *vblkdev = vq->vblkdev;
 	struct vsc_request *req;
 
-	if (num >= vblkdev->max_requests)
+	if ((num < vq->req_base) || (num >= vq->req_base + vq->req_count))
 		return NULL;
 
 	req = &vblkdev->reqs[num];
@@ -141,12 +146,15 @@ static void vblk_put_req(struct vsc_request *req)
 		memset(&req->vs_req, 0, sizeof(struct vs_request));
 		req->req = NULL;
 		memset(&req->iter, 0, sizeof(struct req_iterator));
+
+		spin_lock(&vblkdev->lock);
 		vblkdev->inflight_reqs--;
 
 		if ((vblkdev->inflight_reqs == 0) &&
 			(vblkdev->queue_state == VBLK_QUEUE_SUSPENDED)) {
 			complete(&vblkdev->req_queue_empty);
 		}
+		spin_unlock(&vblkdev->lock);
 		del_timer(&req->timer);
 	}
 }
@@ -227,6 +235,31 @@ static int vblk_get_configinfo(struct vblk_dev *vblkdev)
 	return 0;
 }
 
+/*
+ * Kernel address of the buffer shared with the storage server for a read or
+ * write, NULL if the server accesses the request pages directly.
+ */
+static void *vblk_bounce_buffer(struct vblk_dev *vblkdev,
+		struct vsc_request *vsc_req)
+{
+	if (!vblkdev->config.blk_config.use_vm_address)
+		return vsc_req->mempool_virt;
+
+	return vsc_req->pbuf_used ? vsc_req->pbuf : NULL;
+}
+
+static void vblk_unmap_data(struct vblk_dev *vblkdev,
+		struct vsc_request *vsc_req)
+{
+	if (vsc_req->sg_num_ents != 0) {
+		dma_unmap_sg(vblkdev->device, vsc_req->sg_lst,
+			vsc_req->sg_num_ents, DMA_BIDIRECTIONAL);
+		vsc_req->sg_num_ents = 0;
+	}
+
+	vsc_req->pbuf_used = false;
+}
+
 static void req_error_handler(struct vblk_dev *vblkdev, struct request *breq)
 {
 	dev_err(vblkdev->device,
@@ -250,6 +283,7 @@ static void handle_non_ioctl_resp(struct vblk_dev *vblkdev,
 	struct request *const bio_req = vsc_req->req;
 	struct vs_blk_request *const blk_req =
 		&(vsc_req->vs_req.blkdev_req.blk_req);
+	void *bounce = vblk_bounce_buffer(vblkdev, vsc_req);
 
 	if (blk_resp->status != 0) {
 		invoke_req_err_hand = true;
@@ -265,6 +299,11 @@ static void handle_non_ioctl_resp(struct vblk_dev *vblkdev,
 	}
 
 	if (req_op(bio_req) == REQ_OP_READ) {
+		if (vsc_req->pbuf_used)
+			dma_sync_single_for_cpu(vblkdev->device,
+				vsc_req->pbuf_iova, blk_rq_bytes(bio_req),
+				DMA_BIDIRECTIONAL);
+
 		rq_for_each_segment(bvec, bio_req, vsc_req->iter) {
 			size = bvec.bv_len;
 			buffer = page_address(bvec.bv_page) +
@@ -279,12 +318,8 @@ static void handle_non_ioctl_resp(struct vblk_dev *vblkdev,
 					total_size;
 			}
 
-			if (!vblkdev->config.blk_config.use_vm_address) {
-				memcpy(buffer,
-					vsc_req->mempool_virt +
-					total_size,
-					size);
-			}
+			if (bounce != NULL)
+				memcpy(buffer, bounce + total_size, size);
 
 			total_size += size;
 			if (total_size ==
@@ -295,16 +330,7 @@ static void handle_non_ioctl_resp(struct vblk_dev *vblkdev,
 	}
 
 end:
-	if (vblkdev->config.blk_config.use_vm_address) {
-		if ((req_op(bio_req) == REQ_OP_READ) ||
-			(req_op(bio_req) == REQ_OP_WRITE)) {
-			dma_unmap_sg(vblkdev->device,
-				vsc_req->sg_lst,
-				vsc_req->sg_num_ents,
-				DMA_BIDIRECTIONAL);
-			devm_kfree(vblkdev->device, vsc_req->sg_lst);
-		}
-	}
+	vblk_unmap_data(vblkdev, vsc_req);
 
 	if (!invoke_req_err_hand) {
 			blk_mq_end_request(bio_req, BLK_STS_OK);
@@ -318,8 +344,9 @@ end:
  * complete_bio_req: Complete a bio request after server is
  *		done processing the request.
  */
-static bool complete_bio_req(struct vblk_dev *vblkdev)
+static bool complete_bio_req(struct vblk_queue *vq)
 {
+	struct vblk_dev *vblkdev = vq->vblkdev;
 	int status = 0;
 	struct vsc_request *vsc_req = NULL;
 	struct vs_request *vs_req;
@@ -327,11 +354,11 @@ static bool complete_bio_req(struct vblk_dev *vblkdev)
 	struct request *bio_req;
 
 	/* First check if ivc read queue is empty */
-	if (!tegra_hv_ivc_can_read(vblkdev->ivck))
+	if (!tegra_hv_ivc_can_read(vq->ivck))
 		goto no_valid_io;
 
 	/* Copy the data and advance to next frame */
-	if ((tegra_hv_ivc_read(vblkdev->ivck, &req_resp,
+	if ((tegra_hv_ivc_read(vq->ivck, &req_resp,
 				sizeof(struct vs_request)) <= 0)) {
 		dev_err(vblkdev->device,
 				"Couldn't increment read frame pointer!\n");
@@ -347,7 +374,7 @@ static bool complete_bio_req(struct vblk_dev *vblkdev)
 #if (IS_ENABLED(CONFIG_TEGRA_HSIERRRPTINJ))
 	if (req_resp.req_id != HSI_ERROR_MAGIC) {
 #endif
-		vsc_req = vblk_get_req_by_sr_num(vblkdev, req_resp.req_id);
+		vsc_req = vblk_get_req_by_sr_num(vq, req_resp.req_id);
 		if (vsc_req == NULL) {
 			dev_err(vblkdev->device, "serial_number mismatch num %d!\n",
 					req_resp.req_id);
@@ -401,6 +428,7 @@ static bool complete_bio_req(struct vblk_dev *vblkdev)
 	}
 
 bio_null:
+	vblk_unmap_data(vblkdev, vsc_req);
 	vblk_put_req(vsc_req);
 
 complete_bio_exit:
@@ -476,8 +504,9 @@ static enum blk_cmd_op cleanup_op_supported(struct vblk_dev *vblkdev, uint32_t o
  * submit_bio_req: Fetch a bio request and submit it to
  * server for processing.
  */
-static bool submit_bio_req(struct vblk_dev *vblkdev)
+static bool submit_bio_req(struct vblk_queue *vq)
 {
+	struct vblk_dev *vblkdev = vq->vblkdev;
 	struct vsc_request *vsc_req = NULL;
 	struct request *bio_req = NULL;
 	struct vs_request *vs_req;
@@ -486,38 +515,38 @@ static bool submit_bio_req(struct vblk_dev *vblkdev)
 	size_t total_size = 0;
 	void *buffer;
 	struct req_entry *entry = NULL;
-	size_t sz;
+	void *bounce;
 	uint32_t sg_cnt;
 	uint32_t ops_supported = vblkdev->config.blk_config.req_ops_supported;
 	dma_addr_t  sg_dma_addr = 0;
 
 	/* Check if ivc queue is full */
-	if (!tegra_hv_ivc_can_write(vblkdev->ivck))
+	if (!tegra_hv_ivc_can_write(vq->ivck))
 		goto bio_exit;
 
 	if (vblkdev->queue == NULL)
 		goto bio_exit;
 
-	vsc_req = vblk_get_req(vblkdev);
+	vsc_req = vblk_get_req(vq);
 	if (vsc_req == NULL)
 		goto bio_exit;
 
-	spin_lock(&vblkdev->queue_lock);
-	if(!list_empty(&vblkdev->req_list)) {
-		entry = list_first_entry(&vblkdev->req_list, struct req_entry,
+	spin_lock(&vq->queue_lock);
+	if(!list_empty(&vq->req_list)) {
+		entry = list_first_entry(&vq->req_list, struct req_entry,
 						list_entry);
 		if ((vblkdev->config.blk_config.req_ops_supported & VS_BLK_IOCTL_OP_F) &&
 				(req_op(entry->req) == REQ_OP_DRV_IN) &&
 				(vblkdev->config.blk_config.use_vm_address) &&
 				(vblkdev->inflight_ioctl_reqs >= vblkdev->max_ioctl_requests)) {
-			spin_unlock(&vblkdev->queue_lock);
+			spin_unlock(&vq->queue_lock);
 			goto bio_exit;
 		}
 		list_del(&entry->list_entry);
 		bio_req = entry->req;
 		kfree(entry);
 	}
-	spin_unlock(&vblkdev->queue_lock);
+	spin_unlock(&vq->queue_lock);
 
 	if (bio_req == NULL)
 		goto bio_exit;
@@ -525,26 +554,26 @@ static bool submit_bio_req(struct vblk_dev *vblkdev)
 	if ((vblkdev->config.blk_config.use_vm_address) &&
 		((req_op(bio_req) == REQ_OP_READ) ||
 		(req_op(bio_req) == REQ_OP_WRITE))) {
-		sz = (sizeof(struct scatterlist)
-			* bio_req->nr_phys_segments);
-		vsc_req->sg_lst =  devm_kzalloc(vblkdev->device, sz,
-					GFP_KERNEL);
-		if (vsc_req->sg_lst == NULL) {
-			dev_err(vblkdev->device,
-				"SG mem allocation failed\n");
-			goto bio_exit;
-		}
-		sg_init_table(vsc_req->sg_lst,
-			bio_req->nr_phys_segments);
-		sg_cnt = blk_rq_map_sg(vblkdev->queue, bio_req,
-				vsc_req->sg_lst);
-		vsc_req->sg_num_ents = sg_nents(vsc_req->sg_lst);
-		if (dma_map_sg(vblkdev->device, vsc_req->sg_lst,
-			vsc_req->sg_num_ents, DMA_BIDIRECTIONAL) == 0) {
-			dev_err(vblkdev->device, "dma_map_sg failed\n");
-			goto bio_exit;
+		/*
+		 * Small requests are copied through the persistently mapped
+		 * buffer, which is cheaper than an IOMMU map and unmap.
+		 */
+		if ((vsc_req->pbuf != NULL) &&
+			(blk_rq_bytes(bio_req) <= vblkdev->pbuf_size)) {
+			vsc_req->pbuf_used = true;
+			sg_dma_addr = vsc_req->pbuf_iova;
+		} else {
+			sg_init_table(vsc_req->sg_lst, vblkdev->max_segments);
+			sg_cnt = blk_rq_map_sg(vblkdev->queue, bio_req,
+					vsc_req->sg_lst);
+			if (dma_map_sg(vblkdev->device, vsc_req->sg_lst,
+				sg_cnt, DMA_BIDIRECTIONAL) == 0) {
+				dev_err(vblkdev->device, "dma_map_sg failed\n");
+				goto bio_exit;
+			}
+			vsc_req->sg_num_ents = sg_cnt;
+			sg_dma_addr = sg_dma_address(vsc_req->sg_lst);
 		}
-		sg_dma_addr = sg_dma_address(vsc_req->sg_lst);
 	}
 
 	vsc_req->req = bio_req;
@@ -610,7 +639,8 @@ static bool submit_bio_req(struct vblk_dev *vblkdev)
 			}
 		}
 
-		if (req_op(bio_req) == REQ_OP_WRITE) {
+		bounce = vblk_bounce_buffer(vblkdev, vsc_req);
+		if ((req_op(bio_req) == REQ_OP_WRITE) && (bounce != NULL)) {
 			rq_for_each_segment(bvec, bio_req, vsc_req->iter) {
 				size = bvec.bv_len;
 				buffer = page_address(bvec.bv_page) +
@@ -625,14 +655,7 @@ static bool submit_bio_req(struct vblk_dev *vblkdev)
 						total_size;
 				}
 
-				/* memcpy to mempool not needed as VM IOVA is
-				 * provided
-				 */
-				if (!vblkdev->config.blk_config.use_vm_address) {
-					memcpy(
-					vsc_req->mempool_virt + total_size,
-					buffer, size);
-				}
+				memcpy(bounce + total_size, buffer, size);
 
 				total_size += size;
 				if (total_size == (vs_req->blkdev_req.blk_req.num_blks *
@@ -640,6 +663,11 @@ static bool submit_bio_req(struct vblk_dev *vblkdev)
 					break;
 				}
 			}
+
+			if (vsc_req->pbuf_used)
+				dma_sync_single_for_device(vblkdev->device,
+					vsc_req->pbuf_iova, total_size,
+					DMA_BIDIRECTIONAL);
 		}
 	} else {
 		if (vblkdev->config.blk_config.req_ops_supported & VS_BLK_IOCTL_OP_F
@@ -662,7 +690,7 @@ static bool submit_bio_req(struct vblk_dev *vblkdev)
 	}
 
 	vsc_req->time = _arch_counter_get_cntvct();
-	if (!tegra_hv_ivc_write(vblkdev->ivck, vs_req,
+	if (!tegra_hv_ivc_write(vq->ivck, vs_req,
 				sizeof(struct vs_request))) {
 		dev_err(vblkdev->device,
 			"Request Id %d IVC write failed!\n",
@@ -674,6 +702,7 @@ static bool submit_bio_req(struct vblk_dev *vblkdev)
 
 bio_exit:
 	if (vsc_req != NULL) {
+		vblk_unmap_data(vblkdev, vsc_req);
 		vblk_put_req(vsc_req);
 	}
 
@@ -687,25 +716,96 @@ bio_exit:
 
 static void vblk_request_work(struct work_struct *ws)
 {
-	struct vblk_dev *vblkdev =
-		container_of(ws, struct vblk_dev, work);
+	struct vblk_queue *vq =
+		container_of(ws, struct vblk_queue, work);
 	bool req_submitted, req_completed;
 
 	/* Taking ivc lock before performing IVC read/write */
-	mutex_lock(&vblkdev->ivc_lock);
-	if (tegra_hv_ivc_channel_notified(vblkdev->ivck) != 0) {
-		mutex_unlock(&vblkdev->ivc_lock);
+	mutex_lock(&vq->ivc_lock);
+	if (tegra_hv_ivc_channel_notified(vq->ivck) != 0) {
+		mutex_unlock(&vq->ivc_lock);
 		return;
 	}
 
 	req_submitted = true;
 	req_completed = true;
 	while (req_submitted || req_completed) {
-		req_completed = complete_bio_req(vblkdev);
+		req_completed = complete_bio_req(vq);
+
+		req_submitted = submit_bio_req(vq);
+	}
+	mutex_unlock(&vq->ivc_lock);
+}
 
-		req_submitted = submit_bio_req(vblkdev);
+/*
+ * Reap completions of a poll queue from the IVC RX ring directly in the
+ * context of the polling task, without waiting for the IRQ + work hop.
+ */
+#if defined(NV_BLK_MQ_OPS_STRUCT_POLL_HAS_IO_COMP_BATCH_ARG) /* Linux v5.16 */
+static int vblk_poll(struct blk_mq_hw_ctx *hctx, struct io_comp_batch *iob)
+#else
+static int vblk_poll(struct blk_mq_hw_ctx *hctx)
+#endif
+{
+	struct vblk_queue *vq = hctx->driver_data;
+	int found = 0;
+
+	/* Someone else is already working on this channel */
+	if (!mutex_trylock(&vq->ivc_lock))
+		return 0;
+
+	if (tegra_hv_ivc_channel_notified(vq->ivck) == 0) {
+		while (complete_bio_req(vq))
+			found++;
+
+		/* Requests sitting in req_list can use the freed slots now */
+		while (submit_bio_req(vq))
+			;
 	}
-	mutex_unlock(&vblkdev->ivc_lock);
+	mutex_unlock(&vq->ivc_lock);
+
+	return found;
+}
+
+#if defined(NV_BLK_MQ_OPS_STRUCT_MAP_QUEUES_HAS_VOID_RETURN) /* Linux v6.2 */
+static void vblk_map_queues(struct blk_mq_tag_set *set)
+#else
+static int vblk_map_queues(struct blk_mq_tag_set *set)
+#endif
+{
+	struct vblk_dev *vblkdev = set->driver_data;
+	struct blk_mq_queue_map *map;
+
+	map = &set->map[HCTX_TYPE_DEFAULT];
+	map->nr_queues = vblkdev->nr_queues - vblkdev->nr_poll_queues;
+	map->queue_offset = 0;
+	blk_mq_map_queues(map);
+
+	/* No dedicated read queues, blk-mq falls back to the default map */
+	set->map[HCTX_TYPE_READ].nr_queues = 0;
+
+	map = &set->map[HCTX_TYPE_POLL];
+	map->nr_queues = vblkdev->nr_poll_queues;
+	map->queue_offset = vblkdev->nr_queues - vblkdev->nr_poll_queues;
+	if (map->nr_queues != 0U)
+		blk_mq_map_queues(map);
+
+#if !defined(NV_BLK_MQ_OPS_STRUCT_MAP_QUEUES_HAS_VOID_RETURN)
+	return 0;
+#endif
+}
+
+static int vblk_init_hctx(struct blk_mq_hw_ctx *hctx, void *data,
+			unsigned int hctx_idx)
+{
+	struct vblk_dev *vblkdev = data;
+
+	if (hctx_idx >= vblkdev->nr_queues)
+		return -EINVAL;
+
+	hctx->driver_data = &vblkdev->queues[hctx_idx];
+
+	return 0;
 }
 
 /* The simple form of the request function. */
@@ -715,9 +815,14 @@ static blk_status_t vblk_request(struct blk_mq_hw_ctx *hctx,
 	struct req_entry *entry;
 	struct request *req = bd->rq;
 	struct vblk_dev *vblkdev = hctx->queue->queuedata;
+	struct vblk_queue *vq = hctx->driver_data;
 
 	blk_mq_start_request(req);
 
+	/* Pass-through commands share mempool slots, keep them on one channel */
+	if (req_op(req) == REQ_OP_DRV_IN)
+		vq = &vblkdev->queues[0];
+
 	/* malloc for req list entry */
 	entry = kmalloc(sizeof(struct req_entry), GFP_ATOMIC);
 	if (entry == NULL) {
@@ -730,12 +835,12 @@ static blk_status_t vblk_request(struct blk_mq_hw_ctx *hctx,
 	INIT_LIST_HEAD(&entry->list_entry);
 
 	/* Insert the req to list */
-	spin_lock(&vblkdev->queue_lock);
-	list_add_tail(&entry->list_entry, &vblkdev->req_list);
-	spin_unlock(&vblkdev->queue_lock);
+	spin_lock(&vq->queue_lock);
+	list_add_tail(&entry->list_entry, &vq->req_list);
+	spin_unlock(&vq->queue_lock);
 
 	/* Now invoke the queue to handle data inserted in queue */
-	queue_work_on(WORK_CPU_UNBOUND, vblkdev->wq, &vblkdev->work);
+	queue_work_on(WORK_CPU_UNBOUND, vblkdev->wq, &vq->work);
 
 	return BLK_STS_OK;
 }
@@ -894,6 +999,9 @@ static const struct device_attribute dev_attr_speed_mode_ro =
 
 static const struct blk_mq_ops vblk_mq_ops = {
 	.queue_rq	= vblk_request,
+	.init_hctx	= vblk_init_hctx,
+	.map_queues	= vblk_map_queues,
+	.poll		= vblk_poll,
 };
 
 #if (IS_ENABLED(CONFIG_TEGRA_HSIERRRPTINJ))
@@ -920,7 +1028,7 @@ static int vblk_inject_err_fsi(unsigned int inst_id, struct epl_error_report_fra
 		return -EINVAL;
 	}
 
-	mutex_lock(&vblkdev->ivc_lock);
+	mutex_lock(&vblkdev->queues[0].ivc_lock);
 	vblkdev->hsierror_status = 0;
 
 	/* This while loop exits as long as the remote endpoint cooperates. */
@@ -929,7 +1037,7 @@ static int vblk_inject_err_fsi(unsigned int inst_id, struct epl_error_report_fra
 		while (tegra_hv_ivc_channel_notified(vblkdev->ivck) != 0) {
 			if (i++ > IVC_RESET_RETRIES) {
 				dev_err(vblkdev->device, "ivc reset timeout\n");
-				mutex_unlock(&vblkdev->ivc_lock);
+				mutex_unlock(&vblkdev->queues[0].ivc_lock);
 				return -EIO;
 			}
 			set_current_state(TASK_INTERRUPTIBLE);
@@ -950,11 +1058,11 @@ static int vblk_inject_err_fsi(unsigned int inst_id, struct epl_error_report_fra
 
 	if (tegra_hv_ivc_write_advance(vblkdev->ivck)) {
 		dev_err(vblkdev->device, "ivc write failed\n");
-		mutex_unlock(&vblkdev->ivc_lock);
+		mutex_unlock(&vblkdev->queues[0].ivc_lock);
 		return -EIO;
 	}
 
-	mutex_unlock(&vblkdev->ivc_lock);
+	mutex_unlock(&vblkdev->queues[0].ivc_lock);
 
 	if (wait_for_completion_timeout(&vblkdev->hsierror_handle, msecs_to_jiffies(1000)) == 0) {
 		dev_err(vblkdev->device, "hsi response timeout\n");
@@ -967,6 +1075,76 @@ static int vblk_inject_err_fsi(unsigned int inst_id, struct epl_error_report_fra
 }
 #endif
 
+/*
+ * Allocate the per-request data buffers of an IOVA device. Every request gets
+ * a scatter list for mapping the request pages and, if the optional
+ * "persistent-buffer-size" property is set, a buffer of that size which stays
+ * mapped for the lifetime of the device.
+ */
+static int vblk_alloc_data_bufs(struct vblk_dev *vblkdev, uint32_t max_io_bytes)
+{
+	uint32_t pbuf_size = 0U;
+	struct vsc_request *req;
+	struct page *page;
+	uint32_t req_id;
+
+	vblkdev->max_segments = queue_max_segments(vblkdev->queue);
+
+	of_property_read_u32(vblkdev->device->of_node, "persistent-buffer-size",
+		&pbuf_size);
+	pbuf_size = min(pbuf_size, max_io_bytes);
+	vblkdev->pbuf_size = pbuf_size;
+
+	for (req_id = 0; req_id < vblkdev->max_requests; req_id++) {
+		req = &vblkdev->reqs[req_id];
+
+		req->sg_lst = devm_kcalloc(vblkdev->device, vblkdev->max_segments,
+				sizeof(*req->sg_lst), GFP_KERNEL);
+		if (req->sg_lst == NULL)
+			return -ENOMEM;
+
+		if (pbuf_size == 0U)
+			continue;
+
+		/* Requests without a buffer fall back to mapping their pages */
+		page = alloc_pages(GFP_KERNEL | __GFP_NOWARN, get_order(pbuf_size));
+		if (page == NULL) {
+			dev_warn(vblkdev->device,
+				"only %u persistent buffers allocated\n", req_id);
+			pbuf_size = 0U;
+			continue;
+		}
+
+		req->pbuf = page_address(page);
+		req->pbuf_iova = dma_map_single(vblkdev->device, req->pbuf,
+				vblkdev->pbuf_size, DMA_BIDIRECTIONAL);
+		if (dma_mapping_error(vblkdev->device, req->pbuf_iova)) {
+			__free_pages(page, get_order(pbuf_size));
+			req->pbuf = NULL;
+			pbuf_size = 0U;
+		}
+	}
+
+	return 0;
+}
+
+static void vblk_free_data_bufs(struct vblk_dev *vblkdev)
+{
+	struct vsc_request *req;
+	uint32_t req_id;
+
+	for (req_id = 0; req_id < vblkdev->max_requests; req_id++) {
+		req = &vblkdev->reqs[req_id];
+		if (req->pbuf == NULL)
+			continue;
+
+		dma_unmap_single(vblkdev->device, req->pbuf_iova,
+			vblkdev->pbuf_size, DMA_BIDIRECTIONAL);
+		free_pages((unsigned long)req->pbuf, get_order(vblkdev->pbuf_size));
+		req->pbuf = NULL;
+	}
+}
+
 /* Set up virtual device. */
 static void setup_device(struct vblk_dev *vblkdev)
 {
@@ -974,7 +1152,10 @@ static void setup_device(struct vblk_dev *vblkdev)
 	uint32_t req_id;
 	uint32_t max_requests;
 	uint32_t max_ioctl_requests = 0U;
+	unsigned int erase_sectors;
 	struct vsc_request *req;
+	struct vblk_queue *vq;
+	uint32_t qid;
 	int ret;
 	struct tegra_hv_ivm_cookie *ivmk;
 #if (IS_ENABLED(CONFIG_TEGRA_HSIERRRPTINJ))
@@ -987,11 +1168,13 @@ static void setup_device(struct vblk_dev *vblkdev)
 
 	memset(&vblkdev->tag_set, 0, sizeof(vblkdev->tag_set));
 	vblkdev->tag_set.ops = &vblk_mq_ops;
-	vblkdev->tag_set.nr_hw_queues = 1;
-	vblkdev->tag_set.nr_maps = 1;
+	vblkdev->tag_set.nr_hw_queues = vblkdev->nr_queues;
+	vblkdev->tag_set.nr_maps = (vblkdev->nr_poll_queues != 0U) ?
+					HCTX_MAX_TYPES : 1;
 	vblkdev->tag_set.queue_depth = 16;
 	vblkdev->tag_set.numa_node = NUMA_NO_NODE;
 	vblkdev->tag_set.flags = BLK_MQ_F_SHOULD_MERGE;
+	vblkdev->tag_set.driver_data = vblkdev;
 
 	ret = blk_mq_alloc_tag_set(&vblkdev->tag_set);
 	if (ret)
@@ -1063,11 +1246,13 @@ static void setup_device(struct vblk_dev *vblkdev)
 	}
 
 	/* If IOVA feature is enabled for virt partition, then set max_requests
-	 * to number of IVC frames. Since IOCTL's still use mempool, set
-	 * max_ioctl_requests based on mempool.
+	 * to number of IVC frames across all channels. Since IOCTL's still use
+	 * mempool, set max_ioctl_requests based on mempool.
 	 */
 	if (vblkdev->config.blk_config.use_vm_address == 1U) {
-		max_requests = vblkdev->ivck->nframes;
+		max_requests = 0U;
+		for (qid = 0; qid < vblkdev->nr_queues; qid++)
+			max_requests += vblkdev->queues[qid].ivck->nframes;
 		/* set max_ioctl_requests if pass through is supported */
 		if (vblkdev->config.blk_config.req_ops_supported & VS_BLK_IOCTL_OP_F) {
 			max_ioctl_requests = ((vblkdev->ivmk->size) / UFS_IOCTL_MAX_SIZE_SUPPORTED);
@@ -1098,9 +1283,24 @@ static void setup_device(struct vblk_dev *vblkdev)
 			MAX_VSC_REQS);
 	}
 
-	/* if the number of ivc frames is lesser than the  maximum requests that
-	 * can be supported(calculated based on mempool size above), treat this
-	 * as critical error and panic.
+	if (max_requests < vblkdev->nr_queues) {
+		dev_err(vblkdev->device,
+			"%d requests can not back %d queues!\n",
+			max_requests, vblkdev->nr_queues);
+		return;
+	}
+
+	/* Split the requests evenly between the queues */
+	for (qid = 0; qid < vblkdev->nr_queues; qid++) {
+		vq = &vblkdev->queues[qid];
+		vq->req_base = (qid * max_requests) / vblkdev->nr_queues;
+		vq->req_count = (((qid + 1U) * max_requests) /
+				vblkdev->nr_queues) - vq->req_base;
+	}
+
+	/* if the number of ivc frames of a channel is lesser than the maximum
+	 * requests that can be supported on it (calculated based on mempool
+	 * size above), treat this as critical error and panic.
 	 *
 	 *if (num_of_ivc_frames < max_supported_requests)
 	 *   PANIC
@@ -1121,7 +1321,11 @@ static void setup_device(struct vblk_dev *vblkdev)
 	 *
 	 *  In short, the optimal setting is when both of these are equal
 	 */
-	if (vblkdev->ivck->nframes < max_requests) {
+	for (qid = 0; qid < vblkdev->nr_queues; qid++) {
+		vq = &vblkdev->queues[qid];
+		if (vq->ivck->nframes >= vq->req_count)
+			continue;
+
 		/* Error if the virtual storage device supports
 		 * read, write and ioctl operations
 		 */
@@ -1130,8 +1334,8 @@ static void setup_device(struct vblk_dev *vblkdev)
 				 VS_BLK_WRITE_OP_F |
 				 VS_BLK_IOCTL_OP_F)) {
 			panic("hv_vblk: IVC Channel:%u IVC frames %d less than possible max requests %d!\n",
-				vblkdev->ivc_id, vblkdev->ivck->nframes,
-				max_requests);
+				vq->ivc_id, vq->ivck->nframes,
+				vq->req_count);
 			return;
 		}
 	}
@@ -1165,12 +1369,35 @@ static void setup_device(struct vblk_dev *vblkdev)
 	blk_queue_max_hw_sectors(vblkdev->queue, max_io_bytes / SECTOR_SIZE);
 	blk_queue_flag_set(QUEUE_FLAG_NONROT, vblkdev->queue);
 
-	if ((vblkdev->config.blk_config.req_ops_supported & VS_BLK_SECURE_ERASE_OP_F)
-	     || (vblkdev->config.blk_config.req_ops_supported & VS_BLK_ERASE_OP_F))
-#if defined(QUEUE_FLAG_SECERASE) /* Removed in Linux 5.19 */
+	if (vblkdev->config.blk_config.use_vm_address == 1U) {
 		/*
-		 * FIXME: Support for Linux v5.19+ kernels
+		 * The server takes a single IOVA per request, so all pages of a
+		 * request have to map to one contiguous IOVA range of up to
+		 * max_io_bytes. Otherwise anything past the first DMA segment
+		 * would be lost.
 		 */
+		if (dma_set_max_seg_size(vblkdev->device, max_io_bytes))
+			dev_warn(vblkdev->device, "Failed to set DMA segment size\n");
+		blk_queue_virt_boundary(vblkdev->queue, PAGE_SIZE - 1);
+		blk_queue_max_segment_size(vblkdev->queue, max_io_bytes);
+
+		if (vblk_alloc_data_bufs(vblkdev, max_io_bytes)) {
+			dev_err(vblkdev->device, "Failed to allocate data buffers\n");
+			vblk_free_data_bufs(vblkdev);
+			return;
+		}
+	}
+
+	/* The server limits are in blocks, the block layer ones in sectors */
+	erase_sectors = min_t(uint64_t, UINT_MAX,
+		(uint64_t)vblkdev->config.blk_config.max_erase_blks_per_io *
+		(vblkdev->config.blk_config.hardblk_size / SECTOR_SIZE));
+
+	if ((vblkdev->config.blk_config.req_ops_supported & VS_BLK_SECURE_ERASE_OP_F)
+	     || (vblkdev->config.blk_config.req_ops_supported & VS_BLK_ERASE_OP_F))
+#if defined(NV_BLK_QUEUE_MAX_SECURE_ERASE_SECTORS_PRESENT) /* Linux v5.19 */
+		blk_queue_max_secure_erase_sectors(vblkdev->queue, erase_sectors);
+#elif defined(QUEUE_FLAG_SECERASE)
 		blk_queue_flag_set(QUEUE_FLAG_SECERASE, vblkdev->queue);
 #endif
 
@@ -1179,13 +1406,9 @@ static void setup_device(struct vblk_dev *vblkdev)
 	  || (vblkdev->config.blk_config.req_ops_supported & VS_BLK_ERASE_OP_F))
 	  && vblkdev->config.phys_dev == VSC_DEV_UFS)) {
 #if defined(QUEUE_FLAG_DISCARD) /* Removed in Linux v5.19 */
-		/*
-		 * FIXME: Support for Linux v5.19+ kernels
-		 */
 		blk_queue_flag_set(QUEUE_FLAG_DISCARD, vblkdev->queue);
 #endif
-		blk_queue_max_discard_sectors(vblkdev->queue,
-			vblkdev->config.blk_config.max_erase_blks_per_io);
+		blk_queue_max_discard_sectors(vblkdev->queue, erase_sectors);
 		vblkdev->queue->limits.discard_granularity =
 			vblkdev->config.blk_config.hardblk_size;
 	}
@@ -1297,34 +1520,41 @@ static void setup_device(struct vblk_dev *vblkdev)
 static void vblk_init_device(struct work_struct *ws)
 {
 	struct vblk_dev *vblkdev = container_of(ws, struct vblk_dev, init);
+	struct vblk_queue *vq = &vblkdev->queues[0];
 
-	mutex_lock(&vblkdev->ivc_lock);
+	mutex_lock(&vq->ivc_lock);
 	/* wait for ivc channel reset to finish */
-	if (tegra_hv_ivc_channel_notified(vblkdev->ivck) != 0) {
-		mutex_unlock(&vblkdev->ivc_lock);
+	if (tegra_hv_ivc_channel_notified(vq->ivck) != 0) {
+		mutex_unlock(&vq->ivc_lock);
 		return;	/* this will be rescheduled by irq handler */
 	}
 
-	if (tegra_hv_ivc_can_read(vblkdev->ivck) && !vblkdev->initialized) {
+	if (tegra_hv_ivc_can_read(vq->ivck) && !vblkdev->initialized) {
 		if (vblk_get_configinfo(vblkdev)) {
-			mutex_unlock(&vblkdev->ivc_lock);
+			mutex_unlock(&vq->ivc_lock);
 			return;
 		}
 
-		mutex_unlock(&vblkdev->ivc_lock);
+		mutex_unlock(&vq->ivc_lock);
 		vblkdev->initialized = true;
 		setup_device(vblkdev);
 		return;
 	}
-	mutex_unlock(&vblkdev->ivc_lock);
+	mutex_unlock(&vq->ivc_lock);
 }
 
 static irqreturn_t ivc_irq_handler(int irq, void *data)
 {
-	struct vblk_dev *vblkdev = (struct vblk_dev *)data;
+	struct vblk_queue *vq = (struct vblk_queue *)data;
+	struct vblk_dev *vblkdev = vq->vblkdev;
+
+	/* Completions of poll queues are reaped by vblk_poll() */
+	if (vblkdev->initialized && vq->poll)
+		return IRQ_HANDLED;
 
-	if (vblkdev->initialized)
-		queue_work_on(WORK_CPU_UNBOUND, vblkdev->wq, &vblkdev->work);
+	/* Config handshake happens on the primary channel only */
+	if (vblkdev->initialized || (vq->qid != 0U))
+		queue_work_on(WORK_CPU_UNBOUND, vblkdev->wq, &vq->work);
 	else
 		schedule_work(&vblkdev->init);
 
@@ -1349,11 +1579,95 @@ static void tegra_create_timers(struct vblk_dev *vblkdev)
 
 }
 
+static void vblk_unreserve_queues(struct vblk_dev *vblkdev)
+{
+	uint32_t qid;
+
+	for (qid = 0; qid < vblkdev->nr_queues; qid++) {
+		if (vblkdev->queues[qid].ivck != NULL)
+			tegra_hv_ivc_unreserve(vblkdev->queues[qid].ivck);
+		vblkdev->queues[qid].ivck = NULL;
+	}
+}
+
+/*
+ * Reserve one IVC channel per hardware queue. The channels are listed as
+ * consecutive <&tegra_hv id> pairs in the "ivc" property and "num-queues"
+ * selects how many of them are used, one if absent. The last "poll-queues"
+ * of those serve REQ_POLLED I/O; queue 0 always stays interrupt driven.
+ */
+static int vblk_reserve_queues(struct vblk_dev *vblkdev)
+{
+	struct device_node *np = vblkdev->device->of_node;
+	struct vblk_queue *vq;
+	uint32_t nr_queues = 1U;
+	uint32_t nr_poll_queues = 0U;
+	int nr_channels;
+	uint32_t qid;
+
+	nr_channels = of_property_count_u32_elems(np, "ivc") / 2;
+	of_property_read_u32(np, "num-queues", &nr_queues);
+	of_property_read_u32(np, "poll-queues", &nr_poll_queues);
+	if ((nr_channels <= 0) || (nr_queues == 0U) ||
+		(nr_queues > VBLK_MAX_QUEUES) ||
+		(nr_queues > (uint32_t)nr_channels)) {
+		dev_err(vblkdev->device, "Invalid num-queues %u (%d ivc channels)\n",
+			nr_queues, nr_channels);
+		return -EINVAL;
+	}
+
+	if (nr_poll_queues >= nr_queues) {
+		dev_err(vblkdev->device, "Invalid poll-queues %u (%u queues)\n",
+			nr_poll_queues, nr_queues);
+		return -EINVAL;
+	}
+
+	vblkdev->nr_queues = nr_queues;
+	vblkdev->nr_poll_queues = nr_poll_queues;
+	for (qid = 0; qid < nr_queues; qid++) {
+		vq = &vblkdev->queues[qid];
+		vq->vblkdev = vblkdev;
+		vq->qid = qid;
+		vq->poll = (qid >= (nr_queues - nr_poll_queues));
+
+		if (of_property_read_u32_index(np, "ivc", (qid * 2U) + 1U,
+			&vq->ivc_id)) {
+			dev_err(vblkdev->device, "Failed to read ivc property\n");
+			goto fail;
+		}
+
+		vq->ivck = tegra_hv_ivc_reserve(NULL, vq->ivc_id, NULL);
+		if (IS_ERR_OR_NULL(vq->ivck)) {
+			dev_err(vblkdev->device, "Failed to reserve IVC channel %d\n",
+				vq->ivc_id);
+			vq->ivck = NULL;
+			goto fail;
+		}
+		tegra_hv_ivc_channel_reset(vq->ivck);
+
+		mutex_init(&vq->ivc_lock);
+		spin_lock_init(&vq->queue_lock);
+		INIT_WORK(&vq->work, vblk_request_work);
+		/* creating and initializing the an internal request list */
+		INIT_LIST_HEAD(&vq->req_list);
+	}
+
+	vblkdev->ivc_id = vblkdev->queues[0].ivc_id;
+	vblkdev->ivck = vblkdev->queues[0].ivck;
+
+	return 0;
+
+fail:
+	vblk_unreserve_queues(vblkdev);
+	return -ENODEV;
+}
+
 static int tegra_hv_vblk_probe(struct platform_device *pdev)
 {
 	static struct device_node *vblk_node;
 	struct vblk_dev *vblkdev;
 	struct device *dev = &pdev->dev;
+	uint32_t qid;
 	int ret;
 
 	if (!is_tegra_hypervisor_mode()) {
@@ -1380,34 +1694,21 @@ static int tegra_hv_vblk_probe(struct platform_device *pdev)
 	platform_set_drvdata(pdev, vblkdev);
 	vblkdev->device = dev;
 
-	/* Get properties of instance and ivc channel id */
+	/* Get properties of instance and ivc channel ids */
 	if (of_property_read_u32(vblk_node, "instance", &(vblkdev->devnum))) {
 		dev_err(dev, "Failed to read instance property\n");
 		ret = -ENODEV;
 		goto fail;
-	} else {
-		if (of_property_read_u32_index(vblk_node, "ivc", 1,
-			&(vblkdev->ivc_id))) {
-			dev_err(dev, "Failed to read ivc property\n");
-			ret = -ENODEV;
-			goto fail;
-		}
 	}
 
-	vblkdev->ivck = tegra_hv_ivc_reserve(NULL, vblkdev->ivc_id, NULL);
-	if (IS_ERR_OR_NULL(vblkdev->ivck)) {
-		dev_err(dev, "Failed to reserve IVC channel %d\n",
-			vblkdev->ivc_id);
-		vblkdev->ivck = NULL;
-		ret = -ENODEV;
+	ret = vblk_reserve_queues(vblkdev);
+	if (ret)
 		goto fail;
-	}
-	tegra_hv_ivc_channel_reset(vblkdev->ivck);
 	vblkdev->initialized = false;
 
 	vblkdev->wq = alloc_workqueue("vblk_req_wq%d",
 		WQ_UNBOUND | WQ_MEM_RECLAIM,
-		1, vblkdev->devnum);
+		vblkdev->nr_queues, vblkdev->devnum);
 	if (vblkdev->wq == NULL) {
 		dev_err(dev, "Failed to allocate workqueue\n");
 		ret = -ENOMEM;
@@ -1421,33 +1722,32 @@ static int tegra_hv_vblk_probe(struct platform_device *pdev)
 	vblkdev->queue_state = VBLK_QUEUE_ACTIVE;
 
 	spin_lock_init(&vblkdev->lock);
-	spin_lock_init(&vblkdev->queue_lock);
 	mutex_init(&vblkdev->ioctl_lock);
-	mutex_init(&vblkdev->ivc_lock);
 
 	INIT_WORK(&vblkdev->init, vblk_init_device);
-	INIT_WORK(&vblkdev->work, vblk_request_work);
-	/* creating and initializing the an internal request list */
-	INIT_LIST_HEAD(&vblkdev->req_list);
 
 	/* Create timers for each request going to storage server*/
 	tegra_create_timers(vblkdev);
 
-	if (devm_request_irq(vblkdev->device, vblkdev->ivck->irq,
-		ivc_irq_handler, 0, "vblk", vblkdev)) {
-		dev_err(dev, "Failed to request irq %d\n", vblkdev->ivck->irq);
-		ret = -EINVAL;
-		goto free_wq;
+	for (qid = 0; qid < vblkdev->nr_queues; qid++) {
+		if (devm_request_irq(vblkdev->device,
+			vblkdev->queues[qid].ivck->irq, ivc_irq_handler, 0,
+			"vblk", &vblkdev->queues[qid])) {
+			dev_err(dev, "Failed to request irq %d\n",
+				vblkdev->queues[qid].ivck->irq);
+			ret = -EINVAL;
+			goto free_wq;
+		}
 	}
 
-	mutex_lock(&vblkdev->ivc_lock);
+	mutex_lock(&vblkdev->queues[0].ivc_lock);
 	if (vblk_send_config_cmd(vblkdev)) {
 		dev_err(dev, "Failed to send config cmd\n");
 		ret = -EACCES;
-		mutex_unlock(&vblkdev->ivc_lock);
+		mutex_unlock(&vblkdev->queues[0].ivc_lock);
 		goto free_wq;
 	}
-	mutex_unlock(&vblkdev->ivc_lock);
+	mutex_unlock(&vblkdev->queues[0].ivc_lock);
 
 	return 0;
 
@@ -1455,7 +1755,7 @@ free_wq:
 	destroy_workqueue(vblkdev->wq);
 
 free_ivc:
-	tegra_hv_ivc_unreserve(vblkdev->ivck);
+	vblk_unreserve_queues(vblkdev);
 
 fail:
 	return ret;
@@ -1478,7 +1778,8 @@ static int tegra_hv_vblk_remove(struct platform_device *pdev)
 #endif
 
 	destroy_workqueue(vblkdev->wq);
-	tegra_hv_ivc_unreserve(vblkdev->ivck);
+	vblk_unreserve_queues(vblkdev);
+	vblk_free_data_bufs(vblkdev);
 
 	if ((vblkdev->config.blk_config.use_vm_address == 1U
 				&& vblkdev->config.blk_config.req_ops_supported & VS_BLK_IOCTL_OP_F)
@@ -1499,6 +1800,7 @@ static int tegra_hv_vblk_suspend(struct device *dev)
 {
 	struct vblk_dev *vblkdev = dev_get_drvdata(dev);
 	unsigned long flags;
+	uint32_t qid;
 
 	if (vblkdev->queue) {
 		spin_lock_irqsave(&vblkdev->queue->queue_lock, flags);
@@ -1514,7 +1816,8 @@ static int tegra_hv_vblk_suspend(struct device *dev)
 		spin_unlock(&vblkdev->lock);
 
 		wait_for_completion(&vblkdev->req_queue_empty);
-		disable_irq(vblkdev->ivck->irq);
+		for (qid = 0; qid < vblkdev->nr_queues; qid++)
+			disable_irq(vblkdev->queues[qid].ivck->irq);
 
 		flush_workqueue(vblkdev->wq);
 	}
@@ -1526,6 +1829,7 @@ static int tegra_hv_vblk_resume(struct device *dev)
 {
 	struct vblk_dev *vblkdev = dev_get_drvdata(dev);
 	unsigned long flags;
+	uint32_t qid;
 
 	if (vblkdev->queue) {
 		spin_lock(&vblkdev->lock);
@@ -1533,13 +1837,16 @@ static int tegra_hv_vblk_resume(struct device *dev)
 		reinit_completion(&vblkdev->req_queue_empty);
 		spin_unlock(&vblkdev->lock);
 
-		enable_irq(vblkdev->ivck->irq);
+		for (qid = 0; qid < vblkdev->nr_queues; qid++)
+			enable_irq(vblkdev->queues[qid].ivck->irq);
 
 		spin_lock_irqsave(&vblkdev->queue->queue_lock, flags);
 		blk_mq_start_hw_queues(vblkdev->queue);
 		spin_unlock_irqrestore(&vblkdev->queue->queue_lock, flags);
 
-		queue_work_on(WORK_CPU_UNBOUND, vblkdev->wq, &vblkdev->work);
+		for (qid = 0; qid < vblkdev->nr_queues; qid++)
+			queue_work_on(WORK_CPU_UNBOUND, vblkdev->wq,
+				&vblkdev->queues[qid].work);
 	}
 
 	return 0;
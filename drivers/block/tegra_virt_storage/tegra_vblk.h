@@ -28,6 +28,9 @@
 
 #define MAX_VSC_REQS 32
 
+/* Maximum number of blk-mq hardware queues, one IVC channel each. */
+#define VBLK_MAX_QUEUES 8
+
 struct vblk_ioctl_req {
 	uint32_t ioctl_id;
 	void *ioctl_buf;
@@ -53,11 +56,34 @@ struct vsc_request {
 	/* Scatter list for maping IOVA address */
 	struct scatterlist *sg_lst;
 	int sg_num_ents;
+	/* Persistently mapped buffer used instead of sg_lst for small I/O */
+	void *pbuf;
+	dma_addr_t pbuf_iova;
+	bool pbuf_used;
 	/* Timer to track bio request completion*/
 	struct timer_list timer;
 	uint64_t time;
 };
 
+/*
+* A blk-mq hardware queue and the IVC channel backing it. Every queue owns
+* the slice [req_base, req_base + req_count) of vblk_dev::reqs, so request
+* ids coming back on a channel always belong to that channel.
+*/
+struct vblk_queue {
+	struct vblk_dev *vblkdev;
+	uint32_t qid;
+	uint32_t ivc_id;
+	struct tegra_hv_ivc_cookie *ivck;
+	struct mutex ivc_lock;           /* Serializes IVC read/write */
+	struct work_struct work;
+	spinlock_t queue_lock;           /* Protects req_list */
+	struct list_head req_list;       /* List containing req */
+	uint32_t req_base;
+	uint32_t req_count;
+	bool poll;                       /* Completions reaped by ->poll() */
+};
+
 enum vblk_queue_state {
 	VBLK_UNKNOWN,
 	VBLK_QUEUE_SUSPENDED,
@@ -76,20 +102,22 @@ struct vblk_dev {
 	struct request_queue *queue;     /* The device request queue */
 	struct gendisk *gd;              /* The gendisk structure */
 	struct blk_mq_tag_set tag_set;
-	struct list_head req_list;	/* List containing req */
-	uint32_t ivc_id;
+	uint32_t ivc_id;                 /* Primary (queue 0) IVC channel */
 	uint32_t ivm_id;
-	struct tegra_hv_ivc_cookie *ivck;
+	struct tegra_hv_ivc_cookie *ivck; /* Primary channel, used for config */
 	struct tegra_hv_ivm_cookie *ivmk;
 	uint32_t devnum;
 	bool initialized;
 	struct work_struct init;
-	struct work_struct work;
 	struct workqueue_struct *wq;
 	struct device *device;
 	void *shared_buffer;
+	uint32_t pbuf_size;              /* Bytes per persistent buffer */
+	uint32_t max_segments;           /* Entries in vsc_request::sg_lst */
 	struct mutex ioctl_lock;
-	spinlock_t queue_lock;
+	uint32_t nr_queues;
+	uint32_t nr_poll_queues;         /* Trailing queues used for iopoll */
+	struct vblk_queue queues[VBLK_MAX_QUEUES];
 	struct vsc_request reqs[MAX_VSC_REQS];
 	DECLARE_BITMAP(pending_reqs, MAX_VSC_REQS);
 	uint32_t inflight_reqs;
@@ -103,7 +131,6 @@ struct vblk_dev {
 	uint32_t hsierror_status;
 	struct completion hsierror_handle;
 #endif
-	struct mutex ivc_lock;
 	enum vblk_queue_state queue_state;
 	struct completion req_queue_empty;
 };
@@ -605,7 +605,37 @@ static void rtk_vendor_cmd_to_fw(uint16_t opcode, uint8_t parameter_len,
 }
 
 static uint8_t profileinfo_cmd = 0;
+
+/* Minimum interval between two profile reports to fw */
+#define RTK_PROFILE_REPORT_INTERVAL	msecs_to_jiffies(20)
+
+/* Only the last report is kept, the previous ones are superseded by it. */
+static void rtk_profileinfo_report_set(uint8_t *buf, uint32_t len)
+{
+	kfree(btrtl_coex.profile_report);
+	btrtl_coex.profile_report = buf;
+	btrtl_coex.profile_report_len = len;
+}
+
+/*
+ * Profile changes come in bursts on busy links, e.g. a2dp streaming and le
+ * scanning. They are coalesced here: the report is built at most once per
+ * RTK_PROFILE_REPORT_INTERVAL from the state at that time, and sent only if
+ * it differs from the last report sent.
+ */
 static void rtk_notify_profileinfo_to_fw(void)
+{
+	unsigned long next = btrtl_coex.profile_report_tx +
+			     RTK_PROFILE_REPORT_INTERVAL;
+	unsigned long delay = 0;
+
+	if (time_before(jiffies, next))
+		delay = next - jiffies;
+
+	queue_delayed_work(btrtl_coex.fw_wq, &btrtl_coex.profile_work, delay);
+}
+
+static void rtk_profileinfo_work(struct work_struct *work)
 {
 	struct list_head *head = NULL;
 	struct list_head *iter = NULL;
@@ -629,7 +659,7 @@ static void rtk_notify_profileinfo_to_fw(void)
 		buffer_size = 1 + handle_number * 6;
 	}
 
-	p_buf = kmalloc(buffer_size, GFP_ATOMIC);
+	p_buf = kmalloc(buffer_size, GFP_KERNEL);
 
 	if (NULL == p_buf) {
 		RTKBT_ERR("%s: alloc error", __func__);
@@ -664,8 +694,19 @@ static void rtk_notify_profileinfo_to_fw(void)
 			break;
 	}
 
-	if(!profileinfo_cmd) {
+	if(!profileinfo_cmd)
 		*p++ = btrtl_coex.profile_status;
+
+	/* The legacy and the new report never have the same size */
+	if (btrtl_coex.profile_report &&
+	    btrtl_coex.profile_report_len == buffer_size &&
+	    !memcmp(btrtl_coex.profile_report, p_buf, buffer_size)) {
+		RTKBT_DBG("%s: profiles unchanged", __func__);
+		kfree(p_buf);
+		return;
+	}
+
+	if(!profileinfo_cmd) {
 		rtk_vendor_cmd_to_fw(HCI_VENDOR_SET_PROFILE_REPORT_LEGACY_COMMAND, buffer_size,
 			     p_buf);
 	} else {
@@ -673,7 +714,8 @@ static void rtk_notify_profileinfo_to_fw(void)
 				p_buf);
 	}
 
-	kfree(p_buf);
+	btrtl_coex.profile_report_tx = jiffies;
+	rtk_profileinfo_report_set(p_buf, buffer_size);
 	return;
 }
 
@@ -2951,6 +2993,8 @@ void rtk_btcoex_open(struct hci_dev *hdev)
 #endif
 #endif /* RTB_SOFTWARE_MAILBOX */
 	INIT_DELAYED_WORK(&btrtl_coex.l2_work, (void *)rtl_l2_work);
+	INIT_DELAYED_WORK(&btrtl_coex.profile_work, rtk_profileinfo_work);
+	btrtl_coex.profile_report_tx = jiffies - RTK_PROFILE_REPORT_INTERVAL;
 
 	btrtl_coex.hdev = hdev;
 #ifdef RTB_SOFTWARE_MAILBOX
@@ -3019,6 +3063,9 @@ void rtk_btcoex_close(void)
 
 	flush_connection_hash(&btrtl_coex);
 	flush_profile_hash(&btrtl_coex);
+	/* after the packet count timers, which may queue a report */
+	cancel_delayed_work_sync(&btrtl_coex.profile_work);
+	rtk_profileinfo_report_set(NULL, 0);
 	btrtl_coex.profile_bitmap = 0;
 	btrtl_coex.profile_status = 0;
 	for (kk = 0; kk < 8; kk++)
@@ -268,6 +268,12 @@ struct rtl_coex_struct {
 #endif
 	unsigned long cmd_last_tx;
 
+	/* coalesced profile reports to fw */
+	struct delayed_work profile_work;
+	unsigned long profile_report_tx;
+	uint8_t *profile_report;
+	uint32_t profile_report_len;
+
 	/* hci ev buff */
 	struct list_head ev_used_list;
 	struct list_head ev_free_list;
@@ -12,6 +12,17 @@
  *   accel_matrix    = [01 00 00 00 01 00 00 00 01];
  *   gyro_matrix        = [01 00 00 00 01 00 00 00 01];
  * };
+ *
+ * or on SPI, up to 10 MHz:
+ *
+ * bmi088@0 {
+ *   compatible = "bmi,bmi088";
+ *   reg = <0>; // <-- Must be gyroscope chip select
+ *   accel_spi_cs = <1>; // Must be specified
+ *   spi-max-frequency = <10000000>;
+ *   accel_irq-gpios = <&tegra_gpio TEGRA_GPIO(BB, 0) GPIO_ACTIVE_HIGH>;
+ *   gyro_irq-gpios = <&tegra_gpio TEGRA_GPIO(BB, 1) GPIO_ACTIVE_HIGH>;
+ * };
  */
 
 #include <nvidia/conftest.h>
@@ -19,6 +30,7 @@
 #include <linux/device.h>
 #include <linux/version.h>
 #include <linux/i2c.h>
+#include <linux/spi/spi.h>
 #include <linux/module.h>
 #include <linux/slab.h>
 #include <linux/err.h>
@@ -40,6 +52,7 @@
 #define BMI_HW_DELAY_POR_MS		(10)
 #define BMI_HW_DELAY_DEV_ON_US		(2)
 #define BMI_HW_DELAY_DEV_OFF_US		(1000)
+#define BMI_SPI_RD			(0x80)
 #define BMI_REG_ACC_CHIP_ID		(0x00)
 #define BMI_REG_ACC_ERR_REG		(0x02)
 #define BMI_REG_ACC_STATUS		(0x03)
@@ -47,14 +60,21 @@
 #define BMI_REG_SENSORTIME_2		(0x1A)
 #define BMI_REG_ACC_INT_STAT_1		(0x1D)
 #define BMI_REG_TEMP_MSB		(0x22)
+#define BMI_REG_ACC_FIFO_LENGTH_0	(0x24)
+#define BMI_REG_ACC_FIFO_LENGTH_MSK	(0x3FFF)
 #define BMI_REG_FIFO_DATA		(0x26)
 #define BMI_REG_ACC_CONF		(0x40)
 #define BMI_REG_ACC_CONF_BWP_POR	(0xA0)
 #define BMI_REG_ACC_CONF_BWP_MSK	(0xF0)
 #define BMI_REG_ACC_RANGE		(0x41)
 #define BMI_REG_FIFO_DOWNS		(0x45)
+#define BMI_REG_ACC_FIFO_WTM_0		(0x46)
+#define BMI_REG_ACC_FIFO_WTM_1		(0x47)
 #define BMI_REG_ACC_FIFO_CFG_0		(0x48)
+#define BMI_REG_ACC_FIFO_CFG_0_STREAM	(0x02)
 #define BMI_REG_ACC_FIFO_CFG_1		(0x49)
+#define BMI_REG_ACC_FIFO_CFG_1_DIS	(0x10)
+#define BMI_REG_ACC_FIFO_CFG_1_ACC_EN	(0x50)
 #define BMI_REG_INT1_IO_CTRL		(0x53)
 #define BMI_REG_INT2_IO_CTRL		(0x54)
 #define BMI_REG_ACCEL_INIT_CTRL		(0x59)
@@ -62,7 +82,10 @@
 #define BMI_REG_INTX_IO_CTRL_ACTV_HI	(0x02)
 #define BMI_REG_INT_MAP_DATA		(0x58)
 #define BMI_INT1_OUT_ACTIVE_HIGH	(0x0A)
+#define BMI_INT1_FWM			(0x01)
 #define BMI_INT1_DTRDY			(0x04)
+#define BMI_INT2_FWM			(0x10)
+#define BMI_INT2_DTRDY			(0x40)
 #define BMI_REG_ACC_PWR_CONF		(0x7C)
 #define BMI_REG_ACC_PWR_CONF_ACTV	(0x00)
 #define BMI_REG_ACC_PWR_CONF_SUSP	(0x03)
@@ -88,19 +111,40 @@
 #define BMI_REG_GYR_SOFTRESET_EXE	(0xB6)
 #define BMI_REG_GYR_INT_CTRL		(0x15)
 #define BMI_REG_GYR_INT_CTRL_DIS	(0x00)
+#define BMI_REG_GYR_INT_CTRL_FIFO_EN	(0x40)
 #define BMI_REG_GYR_INT_CTRL_DATA_EN	(0x80)
 #define BMI_REG_INT_3_4_IO_CONF		(0x16)
 #define BMI_REG_INT_3_4_IO_CONF_3_HI	(0x01)
 #define BMI_REG_INT_3_4_IO_CONF_4_HI	(0x04)
 #define BMI_REG_INT_3_4_IO_MAP		(0x18)
 #define BMI_REG_INT_3_4_IO_MAP_INT3	(0x01)
+#define BMI_REG_INT_3_4_IO_MAP_INT3_FIFO	(0x04)
+#define BMI_REG_INT_3_4_IO_MAP_INT4_FIFO	(0x20)
+#define BMI_REG_GYR_FIFO_WM_EN		(0x1E)
+#define BMI_REG_GYR_FIFO_WM_EN_OFF	(0x08)
+#define BMI_REG_GYR_FIFO_WM_EN_ON	(0x88)
 #define BMI_REG_INT_3_ACTIVE_HIGH	(0x01)
 #define BMI_REG_FIFO_EXT_INT_S		(0x34)
 #define BMI_REG_GYR_SELF_TEST		(0x3C)
+#define BMI_REG_GYR_FIFO_CFG_0		(0x3D)
 #define BMI_REG_GYR_FIFO_CFG_1		(0x3E)
+#define BMI_REG_GYR_FIFO_CFG_1_STREAM	(0x80)
+#define BMI_REG_GYR_FIFO_DATA		(0x3F)
+#define BMI_REG_FIFO_STATUS_FRAMES	(0x7F)
+#define BMI_REG_FIFO_STATUS_OVERRUN	(0x80)
 
 #define BMI_AXIS_N			(3)
 #define BMI_IMU_DATA			(6)
+/* accel FIFO is 1024 bytes of headed frames, gyro FIFO 100 frames */
+#define BMI_FIFO_SIZE			(1024)
+#define BMI_ACC_FIFO_WM_MAX		(128)
+#define BMI_GYR_FIFO_WM_MAX		(99)
+#define BMI_ACC_FIFO_HDR_MSK		(0xFC)
+#define BMI_ACC_FIFO_HDR_ACC		(0x84)
+#define BMI_ACC_FIFO_HDR_SKIP		(0x40)
+#define BMI_ACC_FIFO_HDR_TIME		(0x44)
+#define BMI_ACC_FIFO_HDR_CFG		(0x48)
+#define BMI_ACC_FIFO_HDR_DROP		(0x50)
 
 /* hardware devices */
 #define BMI_HW_ACC			(0)
@@ -187,6 +231,10 @@ static struct bmi_reg_rd bmi_reg_rds_gyr[] = {
 		.reg_lo			= BMI_REG_INT_3_4_IO_MAP,
 		.reg_hi			= BMI_REG_INT_3_4_IO_MAP,
 	},
+	{
+		.reg_lo			= BMI_REG_GYR_FIFO_WM_EN,
+		.reg_hi			= BMI_REG_GYR_FIFO_WM_EN,
+	},
 	{
 		.reg_lo			= BMI_REG_FIFO_EXT_INT_S,
 		.reg_hi			= BMI_REG_FIFO_EXT_INT_S,
@@ -357,24 +405,28 @@ static int bmi_acc_batch(struct bmi_state *st, unsigned int period_us,
 static int bmi_acc_softreset(struct bmi_state *st, unsigned int hw);
 static int bmi_acc_pm(struct bmi_state *st, unsigned int hw, int able);
 static unsigned long bmi_acc_irqflags(struct bmi_state *st);
+static int bmi_acc_fifo(struct bmi_state *st, u8 *buf);
 static int bmi_gyr_able(struct bmi_state *st, int en, bool fast);
 static int bmi_gyr_batch(struct bmi_state *st, unsigned int period_us,
 			 bool range);
 static int bmi_gyr_softreset(struct bmi_state *st, unsigned int hw);
 static int bmi_gyr_pm(struct bmi_state *st, unsigned int hw, int able);
 static unsigned long bmi_gyr_irqflags(struct bmi_state *st);
+static int bmi_gyr_fifo(struct bmi_state *st, u8 *buf);
 
 struct bmi_hw {
 	struct bmi_reg_rd *reg_rds;
 	struct bmi_rrs *rrs;
 	unsigned int reg_rds_n;
 	unsigned int rrs_0n;
+	unsigned int fifo_wm_max;
 	int (*fn_able)(struct bmi_state *st, int en, bool fast);
 	int (*fn_batch)(struct bmi_state *st, unsigned int period_us,
 			bool range);
 	int (*fn_softreset)(struct bmi_state *st, unsigned int hw);
 	int (*fn_pm)(struct bmi_state *st, unsigned int hw, int able);
 	unsigned long (*fn_irqflags)(struct bmi_state *st);
+	int (*fn_fifo)(struct bmi_state *st, u8 *buf);
 };
 
 static struct bmi_hw bmi_hws[] = {
@@ -383,22 +435,26 @@ static struct bmi_hw bmi_hws[] = {
 		.rrs			= bmi_rrs_acc,
 		.reg_rds_n		= ARRAY_SIZE(bmi_reg_rds_acc),
 		.rrs_0n			= ARRAY_SIZE(bmi_rrs_acc) - 1,
+		.fifo_wm_max		= BMI_ACC_FIFO_WM_MAX,
 		.fn_able		= &bmi_acc_able,
 		.fn_batch		= &bmi_acc_batch,
 		.fn_softreset		= &bmi_acc_softreset,
 		.fn_pm			= &bmi_acc_pm,
 		.fn_irqflags		= &bmi_acc_irqflags,
+		.fn_fifo		= &bmi_acc_fifo,
 	},
 	{
 		.reg_rds		= bmi_reg_rds_gyr,
 		.rrs			= bmi_rrs_gyr,
 		.reg_rds_n		= ARRAY_SIZE(bmi_reg_rds_gyr),
 		.rrs_0n			= ARRAY_SIZE(bmi_rrs_gyr) - 1,
+		.fifo_wm_max		= BMI_GYR_FIFO_WM_MAX,
 		.fn_able		= &bmi_gyr_able,
 		.fn_batch		= &bmi_gyr_batch,
 		.fn_softreset		= &bmi_gyr_softreset,
 		.fn_pm			= &bmi_gyr_pm,
 		.fn_irqflags		= &bmi_gyr_irqflags,
+		.fn_fifo		= &bmi_gyr_fifo,
 	},
 };
 
@@ -408,16 +464,27 @@ struct bmi_snsr {
 	struct sensor_cfg cfg;
 	unsigned int usr_cfg;
 	unsigned int period_us;
+	unsigned int fifo_wm;
 	u64 irq_ts;
 	u64 irq_ts_old;
 	u64 seq;
 	struct completion hte_ts_cmpl;
 	struct bmi_gpio_irq gis;
 	struct bmi_state *st;
+	u8 fifo_buf[BMI_FIFO_SIZE];
+};
+
+struct bmi_bus {
+	int (*rd)(struct bmi_state *st, unsigned int hw,
+		  u8 reg, u16 len, void *buf);
+	int (*w)(struct bmi_state *st, unsigned int hw, u16 len, u8 *buf);
 };
 
 struct bmi_state {
+	struct device *dev;
+	const struct bmi_bus *bus;
 	struct i2c_client *i2c;
+	struct spi_device *spi[BMI_HW_N];
 	struct bmi_snsr snsrs[BMI_HW_N];
 	bool iio_init_done[BMI_HW_N];
 	unsigned int part;
@@ -449,90 +516,137 @@ static int bmi_i2c_rd(struct bmi_state *st, unsigned int hw,
 		      u8 reg, u16 len, void *buf)
 {
 	struct i2c_msg msg[2];
-	int ret = -ENODEV;
-	s64 ts;
 
-	if (st->i2c_addrs[hw]) {
-		msg[0].addr = st->i2c_addrs[hw];
-		msg[0].flags = 0;
-		msg[0].len = 1;
-		msg[0].buf = &reg;
-		msg[1].addr = st->i2c_addrs[hw];
-		msg[1].flags = I2C_M_RD;
-		msg[1].len = len;
-		msg[1].buf = buf;
-		ts = st->ts_hw[hw];
-		if (st->hw_en & (1 << hw))
-			ts += (BMI_HW_DELAY_DEV_ON_US * 1000);
-		else
-			ts += (BMI_HW_DELAY_DEV_OFF_US * 1000);
-		ts -= get_ktime_timestamp();
-		if (ts > 0) {
-			ts /= 1000;
-			ts++;
-			udelay(ts);
-		}
-		ret = i2c_transfer(st->i2c->adapter, msg, 2);
-		st->ts_hw[hw] = get_ktime_timestamp();
-		if (ret != 2) {
-			st->errs_bus[hw]++;
-			ret = -EIO;
-		} else {
-			ret = 0;
-		}
-	}
+	if (!st->i2c_addrs[hw])
+		return -ENODEV;
 
-	return ret;
+	msg[0].addr = st->i2c_addrs[hw];
+	msg[0].flags = 0;
+	msg[0].len = 1;
+	msg[0].buf = &reg;
+	msg[1].addr = st->i2c_addrs[hw];
+	msg[1].flags = I2C_M_RD;
+	msg[1].len = len;
+	msg[1].buf = buf;
+
+	return (i2c_transfer(st->i2c->adapter, msg, 2) == 2) ? 0 : -EIO;
 }
 
 static int bmi_i2c_w(struct bmi_state *st, unsigned int hw,
 		     u16 len, u8 *buf)
 {
 	struct i2c_msg msg;
-	int ret;
+
+	if (!st->i2c_addrs[hw])
+		return -ENODEV;
+
+	msg.addr = st->i2c_addrs[hw];
+	msg.flags = 0;
+	msg.len = len;
+	msg.buf = buf;
+
+	return (i2c_transfer(st->i2c->adapter, &msg, 1) == 1) ? 0 : -EIO;
+}
+
+static const struct bmi_bus bmi_i2c_bus = {
+	.rd			= &bmi_i2c_rd,
+	.w			= &bmi_i2c_w,
+};
+
+/*
+ * The register address is sent with bit 7 set for reads. The accel clocks
+ * out one dummy byte before the data, skip it as part of the command.
+ * spi_write_then_read() bounces the buffers, so they need not be DMA safe.
+ */
+static int bmi_spi_rd(struct bmi_state *st, unsigned int hw,
+		      u8 reg, u16 len, void *buf)
+{
+	u8 cmd[2] = { reg | BMI_SPI_RD, 0 };
+
+	if (!st->spi[hw])
+		return -ENODEV;
+
+	return spi_write_then_read(st->spi[hw], cmd,
+				   hw == BMI_HW_ACC ? 2 : 1, buf, len) ?
+	       -EIO : 0;
+}
+
+static int bmi_spi_w(struct bmi_state *st, unsigned int hw,
+		     u16 len, u8 *buf)
+{
+	if (!st->spi[hw])
+		return -ENODEV;
+
+	return spi_write_then_read(st->spi[hw], buf, len, NULL, 0) ? -EIO : 0;
+}
+
+static const struct bmi_bus bmi_spi_bus = {
+	.rd			= &bmi_spi_rd,
+	.w			= &bmi_spi_w,
+};
+
+/* Keeps the minimum time between two accesses to the same device */
+static void bmi_bus_delay(struct bmi_state *st, unsigned int hw)
+{
 	s64 ts;
 
-	if (st->i2c_addrs[hw]) {
-		msg.addr = st->i2c_addrs[hw];
-		msg.flags = 0;
-		msg.len = len;
-		msg.buf = buf;
-		ts = st->ts_hw[hw];
-		if (st->hw_en & (1 << hw))
-			ts += (BMI_HW_DELAY_DEV_ON_US * 1000);
-		else
-			ts += (BMI_HW_DELAY_DEV_OFF_US * 1000);
-		ts -= get_ktime_timestamp();
-		if (ts > 0) {
-			ts /= 1000; /* ns => us */
-			ts++;
-			udelay(ts);
-		}
-		ret = i2c_transfer(st->i2c->adapter, &msg, 1);
-		st->ts_hw[hw] = get_ktime_timestamp();
-		if (ret != 1) {
-			st->errs_bus[hw]++;
-			ret = -EIO;
-		} else {
-			ret = 0;
-		}
-	} else {
-		ret = -ENODEV;
+	ts = st->ts_hw[hw];
+	if (st->hw_en & (1 << hw))
+		ts += (BMI_HW_DELAY_DEV_ON_US * 1000);
+	else
+		ts += (BMI_HW_DELAY_DEV_OFF_US * 1000);
+	ts -= get_ktime_timestamp();
+	if (ts > 0) {
+		ts /= 1000; /* ns => us */
+		ts++;
+		udelay(ts);
 	}
+}
+
+static int bmi_rd(struct bmi_state *st, unsigned int hw,
+		  u8 reg, u16 len, void *buf)
+{
+	int ret;
+
+	bmi_bus_delay(st, hw);
+	ret = st->bus->rd(st, hw, reg, len, buf);
+	if (ret == -ENODEV)
+		return ret;
+
+	st->ts_hw[hw] = get_ktime_timestamp();
+	if (ret)
+		st->errs_bus[hw]++;
+
+	return ret;
+}
+
+static int bmi_w(struct bmi_state *st, unsigned int hw,
+		 u16 len, u8 *buf)
+{
+	int ret;
+
+	bmi_bus_delay(st, hw);
+	ret = st->bus->w(st, hw, len, buf);
+	if (ret == -ENODEV)
+		return ret;
+
+	st->ts_hw[hw] = get_ktime_timestamp();
+	if (ret)
+		st->errs_bus[hw]++;
 
 	return ret;
 }
 
-static int bmi_i2c_wr(struct bmi_state *st, unsigned int hw, u8 reg, u8 val)
+static int bmi_wr(struct bmi_state *st, unsigned int hw, u8 reg, u8 val)
 {
 	int ret;
 	u8 buf[2];
 
 	buf[0] = reg;
 	buf[1] = val;
-	ret = bmi_i2c_w(st, hw, sizeof(buf), buf);
+	ret = bmi_w(st, hw, sizeof(buf), buf);
 	if (ret)
-		dev_err(&st->i2c->dev, "ERR: 0x%02X=>0x%02X\n", val, reg);
+		dev_err(st->dev, "ERR: 0x%02X=>0x%02X\n", val, reg);
 
 	return ret;
 }
@@ -598,7 +712,7 @@ static int bmi_pm(struct bmi_state *st, int snsr_id, bool en)
 			if (snsr_id >= st->hw_n)
 				return -ENODEV;
 
-			dev_dbg(&st->i2c->dev, "turning off:%d\n", snsr_id);
+			dev_dbg(st->dev, "turning off:%d\n", snsr_id);
 			ret = bmi_hws[snsr_id].fn_pm(st, snsr_id, 0);
 			st->enabled &= ~(1 << snsr_id);
 		}
@@ -606,10 +720,10 @@ static int bmi_pm(struct bmi_state *st, int snsr_id, bool en)
 
 	if (ret) {
 		if (snsr_id < 0)
-			dev_err(&st->i2c->dev, "ALL pm_en=%x  ERR=%d\n",
+			dev_err(st->dev, "ALL pm_en=%x  ERR=%d\n",
 				en, ret);
 		else
-			dev_err(&st->i2c->dev, "%s pm_en=%x  ERR=%d\n",
+			dev_err(st->dev, "%s pm_en=%x  ERR=%d\n",
 				st->snsrs[snsr_id].cfg.name, en, ret);
 	}
 
@@ -659,44 +773,143 @@ static int bmi_acc_batch(struct bmi_state *st, unsigned int period_us,
 
 	val = bmi_odrs_acc[odr_i].hw;
 	val |= BMI_REG_ACC_CONF_BWP_POR;
-	ret = bmi_i2c_wr(st, BMI_HW_ACC, BMI_REG_ACC_CONF, val);
+	ret = bmi_wr(st, BMI_HW_ACC, BMI_REG_ACC_CONF, val);
 	if (!ret)
 		st->snsrs[BMI_HW_ACC].period_us = bmi_odrs_acc[odr_i].period_us;
 
 	if (range)
-		ret |= bmi_i2c_wr(st, BMI_HW_ACC, BMI_REG_ACC_RANGE,
-				  (u8)st->snsrs[BMI_HW_ACC].usr_cfg);
+		ret |= bmi_wr(st, BMI_HW_ACC, BMI_REG_ACC_RANGE,
+			      (u8)st->snsrs[BMI_HW_ACC].usr_cfg);
+
+	return ret;
+}
+
+/* Sets up the FIFO in stream mode with a watermark of wm frames */
+static int bmi_acc_fifo_cfg(struct bmi_state *st, unsigned int wm)
+{
+	unsigned int wtm = wm * (BMI_IMU_DATA + 1);
+	int ret;
+
+	ret = bmi_wr(st, BMI_HW_ACC, BMI_REG_ACC_FIFO_WTM_0, wtm & 0xFF);
+	ret |= bmi_wr(st, BMI_HW_ACC, BMI_REG_ACC_FIFO_WTM_1, wtm >> 8);
+	ret |= bmi_wr(st, BMI_HW_ACC, BMI_REG_ACC_FIFO_CFG_0,
+		      BMI_REG_ACC_FIFO_CFG_0_STREAM);
+	ret |= bmi_wr(st, BMI_HW_ACC, BMI_REG_ACC_FIFO_CFG_1,
+		      BMI_REG_ACC_FIFO_CFG_1_ACC_EN);
+	ret |= bmi_wr(st, BMI_HW_ACC, BMI_REG_ACC_SOFTRESET,
+		      BMI_REG_ACC_SOFTRESET_FIFO);
 
 	return ret;
 }
 
-/* Maps and set/reset the data ready interrupt */
+/* Maps and set/reset the data ready or FIFO watermark interrupt */
 static int bmi_acc_able(struct bmi_state *st, int en, bool fast)
 {
+	unsigned int wm = st->snsrs[BMI_HW_ACC].fifo_wm;
 	int ret = 0;
-
-	if (!en)
-		return bmi_i2c_wr(st, BMI_HW_ACC, BMI_REG_INT_MAP_DATA, 0x0);
+	u8 map = st->ra_0x58;
+
+	if (!en) {
+		ret = bmi_wr(st, BMI_HW_ACC, BMI_REG_INT_MAP_DATA, 0x0);
+		if (!fast && wm > 1)
+			ret |= bmi_wr(st, BMI_HW_ACC,
+				      BMI_REG_ACC_FIFO_CFG_1,
+				      BMI_REG_ACC_FIFO_CFG_1_DIS);
+		return ret;
+	}
 
 	if (!fast) {
-		ret = bmi_i2c_wr(st, BMI_HW_ACC, BMI_REG_INT1_IO_CTRL,
-				 st->ra_0x53);
-		ret |= bmi_i2c_wr(st, BMI_HW_ACC, BMI_REG_INT2_IO_CTRL,
-				  st->ra_0x54);
+		ret = bmi_wr(st, BMI_HW_ACC, BMI_REG_INT1_IO_CTRL,
+			     st->ra_0x53);
+		ret |= bmi_wr(st, BMI_HW_ACC, BMI_REG_INT2_IO_CTRL,
+			      st->ra_0x54);
+		if (wm > 1)
+			ret |= bmi_acc_fifo_cfg(st, wm);
+	}
+
+	if (wm > 1) {
+		/* watermark on the pin(s) data ready is mapped to */
+		map = 0;
+		if (st->ra_0x58 & BMI_INT1_DTRDY)
+			map |= BMI_INT1_FWM;
+		if (st->ra_0x58 & BMI_INT2_DTRDY)
+			map |= BMI_INT2_FWM;
 	}
 
-	ret |= bmi_i2c_wr(st, BMI_HW_ACC, BMI_REG_INT_MAP_DATA, st->ra_0x58);
+	ret |= bmi_wr(st, BMI_HW_ACC, BMI_REG_INT_MAP_DATA, map);
 
 	return ret;
 }
 
+/*
+ * Reads out the FIFO and compacts the accel frames to the start of buf.
+ * Returns the number of frames.
+ */
+static int bmi_acc_fifo(struct bmi_state *st, u8 *buf)
+{
+	unsigned int len;
+	unsigned int i = 0;
+	unsigned int n = 0;
+	__le16 fifo_len;
+	u8 hdr;
+	int ret;
+
+	ret = bmi_rd(st, BMI_HW_ACC, BMI_REG_ACC_FIFO_LENGTH_0,
+		     sizeof(fifo_len), &fifo_len);
+	if (ret)
+		return ret;
+
+	len = le16_to_cpu(fifo_len) & BMI_REG_ACC_FIFO_LENGTH_MSK;
+	if (!len)
+		return 0;
+
+	len = min_t(unsigned int, len, BMI_FIFO_SIZE);
+	ret = bmi_rd(st, BMI_HW_ACC, BMI_REG_FIFO_DATA, len, buf);
+	if (ret)
+		return ret;
+
+	while (i < len) {
+		hdr = buf[i++];
+		if ((hdr & BMI_ACC_FIFO_HDR_MSK) == BMI_ACC_FIFO_HDR_ACC) {
+			if (i + BMI_IMU_DATA > len)
+				break;
+
+			memmove(&buf[n * BMI_IMU_DATA], &buf[i], BMI_IMU_DATA);
+			i += BMI_IMU_DATA;
+			n++;
+		} else if (hdr == BMI_ACC_FIFO_HDR_TIME) {
+			i += 3;
+		} else if (hdr == BMI_ACC_FIFO_HDR_SKIP ||
+			   hdr == BMI_ACC_FIFO_HDR_CFG ||
+			   hdr == BMI_ACC_FIFO_HDR_DROP) {
+			i++;
+		} else {
+			/* end of data */
+			break;
+		}
+	}
+
+	return n;
+}
+
+/* The accel powers up in I2C mode, a rising edge on CSB switches it to SPI */
+static void bmi_acc_spi_mode(struct bmi_state *st)
+{
+	u8 val;
+
+	if (st->spi[BMI_HW_ACC])
+		bmi_rd(st, BMI_HW_ACC, BMI_REG_ACC_CHIP_ID, 1, &val);
+}
+
 static int bmi_acc_softreset(struct bmi_state *st, unsigned int hw)
 {
 	int ret;
 
-	ret = bmi_i2c_wr(st, BMI_HW_ACC, BMI_REG_ACC_SOFTRESET,
-			 BMI_REG_ACC_SOFTRESET_EXE);
+	bmi_acc_spi_mode(st);
+	ret = bmi_wr(st, BMI_HW_ACC, BMI_REG_ACC_SOFTRESET,
+		     BMI_REG_ACC_SOFTRESET_EXE);
 	mdelay(BMI_ACC_SOFTRESET_DELAY_MS);
+	bmi_acc_spi_mode(st);
 
 	st->hw_en &= ~(1 << hw);
 	st->enabled &= ~(1 << hw);
@@ -720,14 +933,14 @@ static int bmi_acc_pm(struct bmi_state *st, unsigned int hw, int able)
 		st->hw_en &= ~(1 << hw);
 	}
 
-	ret = bmi_i2c_wr(st, BMI_HW_ACC, BMI_REG_ACC_PWR_CONF,
-			 pwr_conf);
+	ret = bmi_wr(st, BMI_HW_ACC, BMI_REG_ACC_PWR_CONF,
+		     pwr_conf);
 
 	mdelay(BMI_ACC_PM_DELAY_MS);
 
 
-	ret |= bmi_i2c_wr(st, BMI_HW_ACC, BMI_REG_ACC_PWR_CTRL,
-			  pwr_on_off);
+	ret |= bmi_wr(st, BMI_HW_ACC, BMI_REG_ACC_PWR_CTRL,
+		      pwr_on_off);
 
 	mdelay(BMI_ACC_PM_DELAY_MS);
 
@@ -773,46 +986,109 @@ static int bmi_gyr_batch(struct bmi_state *st, unsigned int period_us,
 	odr_i = bmi_odr_i(bmi_odrs_gyr, ARRAY_SIZE(bmi_odrs_gyr), period_us);
 
 	val = bmi_odrs_gyr[odr_i].hw;
-	ret = bmi_i2c_wr(st, BMI_HW_GYR, BMI_REG_GYR_BW, val);
+	ret = bmi_wr(st, BMI_HW_GYR, BMI_REG_GYR_BW, val);
 	if (!ret)
 		st->snsrs[BMI_HW_GYR].period_us = bmi_odrs_gyr[odr_i].period_us;
 
 	if (range) {
 		val = st->snsrs[BMI_HW_GYR].usr_cfg;
-		ret |= bmi_i2c_wr(st, BMI_HW_GYR, BMI_REG_GYR_RANGE, val);
+		ret |= bmi_wr(st, BMI_HW_GYR, BMI_REG_GYR_RANGE, val);
 	}
 
 	return ret;
 }
 
-/* Map and set/reset data ready interrupt */
+/* Sets up the FIFO in stream mode with a watermark of wm frames */
+static int bmi_gyr_fifo_cfg(struct bmi_state *st, unsigned int wm)
+{
+	u8 map;
+	int ret;
+
+	/* watermark on the pin data ready is mapped to */
+	if (st->rg_0x18 & BMI_REG_INT_3_4_IO_MAP_INT3)
+		map = BMI_REG_INT_3_4_IO_MAP_INT3_FIFO;
+	else
+		map = BMI_REG_INT_3_4_IO_MAP_INT4_FIFO;
+
+	ret = bmi_wr(st, BMI_HW_GYR, BMI_REG_INT_3_4_IO_MAP, map);
+	ret |= bmi_wr(st, BMI_HW_GYR, BMI_REG_GYR_FIFO_CFG_0, wm);
+	/* also clears the FIFO */
+	ret |= bmi_wr(st, BMI_HW_GYR, BMI_REG_GYR_FIFO_CFG_1,
+		      BMI_REG_GYR_FIFO_CFG_1_STREAM);
+	ret |= bmi_wr(st, BMI_HW_GYR, BMI_REG_GYR_FIFO_WM_EN,
+		      BMI_REG_GYR_FIFO_WM_EN_ON);
+
+	return ret;
+}
+
+/* Map and set/reset data ready or FIFO watermark interrupt */
 static int bmi_gyr_able(struct bmi_state *st, int en, bool fast)
 {
+	unsigned int wm = st->snsrs[BMI_HW_GYR].fifo_wm;
 	int ret = 0;
 
-	if (!en)
-		return bmi_i2c_wr(st, BMI_HW_GYR, BMI_REG_GYR_INT_CTRL,
-				  BMI_REG_GYR_INT_CTRL_DIS);
+	if (!en) {
+		ret = bmi_wr(st, BMI_HW_GYR, BMI_REG_GYR_INT_CTRL,
+			     BMI_REG_GYR_INT_CTRL_DIS);
+		if (!fast && wm > 1)
+			ret |= bmi_wr(st, BMI_HW_GYR,
+				      BMI_REG_GYR_FIFO_WM_EN,
+				      BMI_REG_GYR_FIFO_WM_EN_OFF);
+		return ret;
+	}
 
 	if (!fast) {
-		ret = bmi_i2c_wr(st, BMI_HW_GYR, BMI_REG_INT_3_4_IO_CONF,
-				 st->rg_0x16);
-		ret |= bmi_i2c_wr(st, BMI_HW_GYR, BMI_REG_INT_3_4_IO_MAP,
-				  st->rg_0x18);
+		ret = bmi_wr(st, BMI_HW_GYR, BMI_REG_INT_3_4_IO_CONF,
+			     st->rg_0x16);
+		if (wm > 1)
+			ret |= bmi_gyr_fifo_cfg(st, wm);
+		else
+			ret |= bmi_wr(st, BMI_HW_GYR,
+				      BMI_REG_INT_3_4_IO_MAP,
+				      st->rg_0x18);
 	}
 
-	ret |= bmi_i2c_wr(st, BMI_HW_GYR, BMI_REG_GYR_INT_CTRL,
-			  BMI_REG_GYR_INT_CTRL_DATA_EN);
+	ret |= bmi_wr(st, BMI_HW_GYR, BMI_REG_GYR_INT_CTRL,
+		      wm > 1 ? BMI_REG_GYR_INT_CTRL_FIFO_EN :
+		      BMI_REG_GYR_INT_CTRL_DATA_EN);
 
 	return ret;
 }
 
+/* Reads out the FIFO to buf, returns the number of frames */
+static int bmi_gyr_fifo(struct bmi_state *st, u8 *buf)
+{
+	unsigned int n;
+	u8 status;
+	int ret;
+
+	ret = bmi_rd(st, BMI_HW_GYR, BMI_REG_FIFO_STATUS, 1, &status);
+	if (ret)
+		return ret;
+
+	if (status & BMI_REG_FIFO_STATUS_OVERRUN) {
+		/* frames were lost, start over */
+		bmi_wr(st, BMI_HW_GYR, BMI_REG_GYR_FIFO_CFG_1,
+		       BMI_REG_GYR_FIFO_CFG_1_STREAM);
+		return -EOVERFLOW;
+	}
+
+	n = status & BMI_REG_FIFO_STATUS_FRAMES;
+	if (!n)
+		return 0;
+
+	ret = bmi_rd(st, BMI_HW_GYR, BMI_REG_GYR_FIFO_DATA,
+		     n * BMI_IMU_DATA, buf);
+
+	return ret ? ret : n;
+}
+
 static int bmi_gyr_softreset(struct bmi_state *st, unsigned int hw)
 {
 	int ret;
 
-	ret = bmi_i2c_wr(st, BMI_HW_GYR, BMI_REG_GYR_SOFTRESET,
-			 BMI_REG_GYR_SOFTRESET_EXE);
+	ret = bmi_wr(st, BMI_HW_GYR, BMI_REG_GYR_SOFTRESET,
+		     BMI_REG_GYR_SOFTRESET_EXE);
 	mdelay(BMI_GYR_SOFTRESET_DELAY_MS);
 
 	st->hw_en &= ~(1 << hw);
@@ -834,7 +1110,7 @@ static int bmi_gyr_pm(struct bmi_state *st, unsigned int hw, int able)
 		st->hw_en &= ~(1 << hw);
 	}
 
-	ret = bmi_i2c_wr(st, BMI_HW_GYR, BMI_REG_GYR_LPM1, val);
+	ret = bmi_wr(st, BMI_HW_GYR, BMI_REG_GYR_LPM1, val);
 	if (ret)
 		st->hw_en &= ~(1 << hw);
 
@@ -872,17 +1148,57 @@ static enum hte_return process_hw_ts(struct hte_ts_data *ts, void *p)
 
 	complete(&sensor->hte_ts_cmpl);
 
-	dev_dbg_ratelimited(&st->i2c->dev, "%s: seq %llu, ts:%llu\n",
+	dev_dbg_ratelimited(st->dev, "%s: seq %llu, ts:%llu\n",
 			    __func__, sensor->seq, sensor->irq_ts);
 
 	return HTE_CB_HANDLED;
 }
 
+/*
+ * Pushes the frames queued in the FIFO. The watermark frame was sampled at
+ * the HTE timestamp of the interrupt, the other frames are spaced by the
+ * ODR period around it, squeezed if needed to stay after the last frame
+ * of the previous batch.
+ */
+static void bmi_fifo_push(struct bmi_state *st, unsigned int hw,
+			  struct bmi_snsr *sensor)
+{
+	s64 period_ns = (s64)sensor->period_us * NSEC_PER_USEC;
+	u64 ts;
+	u64 ts_step = period_ns;
+	int n;
+
+	n = bmi_hws[hw].fn_fifo(st, sensor->fifo_buf);
+	if (n <= 0) {
+		if (n < 0)
+			dev_err_ratelimited(st->dev,
+					    "%s FIFO read ERR=%d\n",
+					    sensor->cfg.name, n);
+		return;
+	}
+
+	/* timestamp of the last frame */
+	ts = sensor->irq_ts + ((s64)n - (s64)sensor->fifo_wm) * period_ns;
+	if (sensor->irq_ts_old) {
+		if (ts <= sensor->irq_ts_old)
+			ts = sensor->irq_ts_old + n;
+		if (ts - (n - 1) * ts_step <= sensor->irq_ts_old)
+			ts_step = div_u64(ts - sensor->irq_ts_old, n);
+	}
+
+	bmi_iio_push_bufs(sensor->bmi_iio, sensor->fifo_buf, n, ts, ts_step);
+	dev_dbg(st->dev, "%d, frames= %d ts= %lld ts_old= %lld\n",
+		hw, n, ts, sensor->irq_ts_old);
+
+	sensor->irq_ts_old = ts;
+}
+
 static irqreturn_t bmi_irq_thread(int irq, void *dev_id)
 {
 	struct bmi_snsr *sensor = (struct bmi_snsr *)dev_id;
 	struct bmi_state *st = sensor->st;
 	unsigned int hw;
+	bool fifo = sensor->fifo_wm > 1;
 	int ret;
 	u8 reg;
 	u8 sample[BMI_IMU_DATA];
@@ -896,29 +1212,37 @@ static irqreturn_t bmi_irq_thread(int irq, void *dev_id)
 	}
 
 	/* Disable data ready interrupt before we read out data */
-	ret = bmi_hws[hw].fn_able(st, 0, true);
-	if (unlikely(ret)) {
-		dev_err_ratelimited(&st->i2c->dev,
-				    "can't disable sensor: %d\n", hw);
-		goto err;
+	if (!fifo) {
+		ret = bmi_hws[hw].fn_able(st, 0, true);
+		if (unlikely(ret)) {
+			dev_err_ratelimited(st->dev,
+					    "can't disable sensor: %d\n", hw);
+			goto err;
+		}
 	}
 
 	/* Wait for HTE IRQ to fetch the latest timestamp */
 	ret = wait_for_completion_interruptible_timeout(&sensor->hte_ts_cmpl, HTE_TIMEOUT);
 	if (!ret) {
-		dev_dbg_ratelimited(&st->i2c->dev,
+		dev_dbg_ratelimited(st->dev,
 				    "sample dropped due to timeout");
 		goto err;
 	}
 
 	mutex_lock(BMI_MUTEX(st->snsrs[hw].bmi_iio));
 
-	ret = bmi_i2c_rd(st, hw, reg, sizeof(sample), sample);
+	if (fifo) {
+		bmi_fifo_push(st, hw, sensor);
+		mutex_unlock(BMI_MUTEX(st->snsrs[hw].bmi_iio));
+		goto err;
+	}
+
+	ret = bmi_rd(st, hw, reg, sizeof(sample), sample);
 
 	if (!ret) {
 		bmi_iio_push_buf(st->snsrs[hw].bmi_iio, sample,
 				 sensor->irq_ts);
-		dev_dbg(&st->i2c->dev, "%d, ts= %lld ts_old= %lld\n",
+		dev_dbg(st->dev, "%d, ts= %lld ts_old= %lld\n",
 			hw, sensor->irq_ts, sensor->irq_ts_old);
 
 		sensor->irq_ts_old = sensor->irq_ts;
@@ -959,6 +1283,7 @@ static int bmi_enable(void *client, int snsr_id, int enable)
 		if (ret < 0)
 			return ret;
 
+		st->snsrs[snsr_id].irq_ts_old = 0;
 		ret = bmi_period(st, snsr_id, true);
 		ret |= bmi_hws[snsr_id].fn_able(st, 1, false);
 		if (!ret) {
@@ -1109,6 +1434,24 @@ static int bmi_max_range(void *client, int snsr_id, int max_range)
 	return 0;
 }
 
+static int bmi_set_watermark(void *client, int snsr_id, unsigned int wm)
+{
+	struct bmi_state *st = (struct bmi_state *)client;
+
+	if (snsr_id >= st->hw_n)
+		return -ENODEV;
+
+	if (st->enabled & (1 << snsr_id))
+		/* can't change settings on the fly (disable device first) */
+		return -EBUSY;
+
+	/* 1 reads each sample on data ready, larger batches in the FIFO */
+	st->snsrs[snsr_id].fifo_wm = clamp_t(unsigned int, wm, 1,
+					     bmi_hws[snsr_id].fifo_wm_max);
+
+	return 0;
+}
+
 static int bmi_scale_write(void *client, int snsr_id, int val, int val2)
 {
 	struct bmi_state *st = (struct bmi_state *)client;
@@ -1127,9 +1470,9 @@ static int bmi_scale_write(void *client, int snsr_id, int val, int val2)
 		return -EINVAL;
 
 	if (snsr_id == BMI_HW_GYR)
-		ret = bmi_i2c_wr(st, BMI_HW_GYR, BMI_REG_GYR_RANGE, i);
+		ret = bmi_wr(st, BMI_HW_GYR, BMI_REG_GYR_RANGE, i);
 	else if (snsr_id == BMI_HW_ACC)
-		ret = bmi_i2c_wr(st, BMI_HW_ACC, BMI_REG_ACC_RANGE, i);
+		ret = bmi_wr(st, BMI_HW_ACC, BMI_REG_ACC_RANGE, i);
 	else
 		return -ENODEV;
 
@@ -1158,7 +1501,7 @@ static int bmi_read_err(void *client, int snsr_id, char *buf)
 
 	t += snprintf(buf, PAGE_SIZE, "%s:\n", st->snsrs[snsr_id].cfg.name);
 	t += snprintf(buf + t, PAGE_SIZE - t,
-		      "I2C Bus Errors:%u\n", st->errs_bus[snsr_id]);
+		      "Bus Errors:%u\n", st->errs_bus[snsr_id]);
 	return t;
 }
 
@@ -1179,7 +1522,7 @@ static int bmi_get_data(void *client, int snsr_id, int axis, int *val)
 
 	reg += (axis - IIO_MOD_X) * sizeof(__le16);
 
-	ret = bmi_i2c_rd(st, snsr_id, reg, sizeof(__le16), &sample);
+	ret = bmi_rd(st, snsr_id, reg, sizeof(__le16), &sample);
 	if (!ret)
 		*val = sign_extend32(le16_to_cpu(sample), 15);
 
@@ -1203,7 +1546,7 @@ static int bmi_regs(void *client, int snsr_id, char *buf)
 	reg_rd = bmi_hws[snsr_id].reg_rds;
 	for (i = 0; i < bmi_hws[snsr_id].reg_rds_n; i++) {
 		for (reg = reg_rd[i].reg_lo; reg <= reg_rd[i].reg_hi; reg++) {
-			ret = bmi_i2c_rd(st, snsr_id, reg, 1, &val);
+			ret = bmi_rd(st, snsr_id, reg, 1, &val);
 			if (ret)
 				t += snprintf(buf + t, PAGE_SIZE - t,
 					      "0x%02X=ERR\n", i);
@@ -1224,12 +1567,12 @@ static struct iio_fn_dev bmi_fn_dev = {
 	.scale_write = bmi_scale_write,
 	.read_err = bmi_read_err,
 	.get_data = bmi_get_data,
+	.set_watermark = bmi_set_watermark,
 };
 
 static int __maybe_unused bmi_suspend(struct device *dev)
 {
-	struct i2c_client *client = to_i2c_client(dev);
-	struct bmi_state *st = i2c_get_clientdata(client);
+	struct bmi_state *st = dev_get_drvdata(dev);
 	unsigned int i;
 	unsigned int old_en_st;
 	int ret = 0;
@@ -1257,8 +1600,7 @@ static int __maybe_unused bmi_suspend(struct device *dev)
 
 static int __maybe_unused bmi_resume(struct device *dev)
 {
-	struct i2c_client *client = to_i2c_client(dev);
-	struct bmi_state *st = i2c_get_clientdata(client);
+	struct bmi_state *st = dev_get_drvdata(dev);
 	unsigned int i;
 	int ret = 0;
 
@@ -1276,9 +1618,8 @@ static int __maybe_unused bmi_resume(struct device *dev)
 
 static SIMPLE_DEV_PM_OPS(bmi_pm_ops, bmi_suspend, bmi_resume);
 
-static void bmi_shutdown(struct i2c_client *client)
+static void bmi_shutdown(struct bmi_state *st)
 {
-	struct bmi_state *st = i2c_get_clientdata(client);
 	unsigned int i;
 
 	st->sts |= BMI_STS_SHUTDOWN;
@@ -1297,19 +1638,60 @@ static void bmi_shutdown(struct i2c_client *client)
 
 static void bmi_remove(void *data)
 {
-	struct i2c_client *client = data;
-	struct bmi_state *st = i2c_get_clientdata(client);
+	struct bmi_state *st = data;
 	int i;
 
-	if (st != NULL) {
-		bmi_shutdown(client);
-		for (i = 0; i < st->hw_n; i++) {
-			if (st->iio_init_done[i])
-				bmi_iio_remove(st->snsrs[i].bmi_iio);
-		}
+	bmi_shutdown(st);
+	for (i = 0; i < st->hw_n; i++) {
+		if (st->iio_init_done[i])
+			bmi_iio_remove(st->snsrs[i].bmi_iio);
 	}
 
-	dev_info(&client->dev, "removed\n");
+	dev_info(st->dev, "removed\n");
+}
+
+static void bmi_spi_acc_remove(void *data)
+{
+	spi_unregister_device(data);
+}
+
+/*
+ * The accel and the gyro have their own chip select. The gyro is the
+ * probed device, add the accel on the same controller.
+ */
+static int bmi_spi_acc_add(struct bmi_state *st, u32 cs)
+{
+	struct spi_device *gyr = st->spi[BMI_HW_GYR];
+	struct spi_device *acc;
+	int ret;
+
+	acc = spi_alloc_device(gyr->controller);
+	if (!acc)
+		return -ENOMEM;
+
+#if defined(NV_SPI_GET_CHIPSELECT_PRESENT)
+	spi_set_chipselect(acc, 0, cs);
+#else
+	acc->chip_select = cs;
+#endif
+#if KERNEL_VERSION(6, 8, 0) <= LINUX_VERSION_CODE
+	acc->cs_index_mask = BIT(0);
+#endif
+	acc->max_speed_hz = gyr->max_speed_hz;
+	acc->mode = gyr->mode;
+	acc->bits_per_word = gyr->bits_per_word;
+	strscpy(acc->modalias, "bmi088_accel", sizeof(acc->modalias));
+
+	ret = spi_add_device(acc);
+	if (ret) {
+		dev_err(st->dev, "accel spi_add_device ERR=%d\n", ret);
+		spi_dev_put(acc);
+		return ret;
+	}
+
+	st->spi[BMI_HW_ACC] = acc;
+
+	return devm_add_action_or_reset(st->dev, bmi_spi_acc_remove, acc);
 }
 
 static int bmi_of_dt(struct bmi_state *st, struct device_node *dn)
@@ -1317,27 +1699,38 @@ static int bmi_of_dt(struct bmi_state *st, struct device_node *dn)
 	u32 val32 = 0;
 	const char *charp;
 	int lenp;
+	int ret;
 
 	if (!dn)
 		return 0;
 
-	if (!st->i2c_addrs[BMI_HW_ACC]) {
-		if (!of_property_read_u32(dn, "accel_i2c_addr", &val32))
-			st->i2c_addrs[BMI_HW_ACC] = val32;
-		else
+	if (st->i2c) {
+		if (!st->i2c_addrs[BMI_HW_ACC]) {
+			if (!of_property_read_u32(dn, "accel_i2c_addr",
+						  &val32))
+				st->i2c_addrs[BMI_HW_ACC] = val32;
+			else
+				return -ENODEV;
+		}
+	} else if (!st->spi[BMI_HW_ACC]) {
+		if (of_property_read_u32(dn, "accel_spi_cs", &val32))
 			return -ENODEV;
+
+		ret = bmi_spi_acc_add(st, val32);
+		if (ret)
+			return ret;
 	}
 
 
-	st->snsrs[BMI_HW_ACC].gis.gpio_in = devm_gpiod_get(&st->i2c->dev, "accel_irq", 0);
+	st->snsrs[BMI_HW_ACC].gis.gpio_in = devm_gpiod_get(st->dev, "accel_irq", 0);
 	if (IS_ERR(st->snsrs[BMI_HW_ACC].gis.gpio_in)) {
-		dev_err(&st->i2c->dev, "accel_irq is not set in DT\n");
+		dev_err(st->dev, "accel_irq is not set in DT\n");
 		return PTR_ERR(st->snsrs[BMI_HW_ACC].gis.gpio_in);
 	}
 
-	st->snsrs[BMI_HW_GYR].gis.gpio_in = devm_gpiod_get(&st->i2c->dev, "gyro_irq", 0);
+	st->snsrs[BMI_HW_GYR].gis.gpio_in = devm_gpiod_get(st->dev, "gyro_irq", 0);
 	if (IS_ERR(st->snsrs[BMI_HW_GYR].gis.gpio_in)) {
-		dev_err(&st->i2c->dev, "gyro_irq is not set in DT\n");
+		dev_err(st->dev, "gyro_irq is not set in DT\n");
 		return PTR_ERR(st->snsrs[BMI_HW_GYR].gis.gpio_in);
 	}
 
@@ -1374,16 +1767,13 @@ static int bmi_reset_all(struct bmi_state *st)
 	return ret;
 }
 
-static int bmi_init(struct bmi_state *st, const struct i2c_device_id *id)
+static int bmi_init(struct bmi_state *st, unsigned int part)
 {
 	unsigned long irqflags;
 	unsigned int i;
 	int ret;
 	struct hte_ts_desc *desc;
 
-	if (id == NULL)
-		return -EINVAL;
-
 	st->ra_0x53 = BMI_INT1_OUT_ACTIVE_HIGH;
 	st->ra_0x54 = 0x00;
 	st->ra_0x58 = BMI_INT1_DTRDY;
@@ -1394,17 +1784,18 @@ static int bmi_init(struct bmi_state *st, const struct i2c_device_id *id)
 	st->hw_en = 0;
 	st->enabled = 0;
 
-	ret = bmi_of_dt(st, st->i2c->dev.of_node);
+	ret = bmi_of_dt(st, st->dev->of_node);
 	if (ret) {
-		dev_err(&st->i2c->dev, "of_dt ERR\n");
+		dev_err(st->dev, "of_dt ERR\n");
 		return ret;
 	}
 
-	st->part = id->driver_data;
-	st->i2c_addrs[BMI_HW_GYR] = st->i2c->addr;
+	st->part = part;
+	if (st->i2c)
+		st->i2c_addrs[BMI_HW_GYR] = st->i2c->addr;
 	ret = bmi_reset_all(st);
 	if (ret) {
-		dev_err(&st->i2c->dev, "softreset failed\n");
+		dev_err(st->dev, "softreset failed\n");
 		return ret;
 	}
 
@@ -1419,7 +1810,7 @@ static int bmi_init(struct bmi_state *st, const struct i2c_device_id *id)
 		       sizeof(st->snsrs[i].cfg));
 
 		ret = bmi_08x_iio_init(&st->snsrs[i].bmi_iio, st,
-				       &st->i2c->dev, &bmi_fn_dev,
+				       st->dev, &bmi_fn_dev,
 				       &st->snsrs[i].cfg);
 		if (ret)
 			return -ENODEV;
@@ -1434,19 +1825,19 @@ static int bmi_init(struct bmi_state *st, const struct i2c_device_id *id)
 		init_completion(&st->snsrs[i].hte_ts_cmpl);
 	}
 
-	ret = bmi_setup_gpio(&st->i2c->dev, st, st->hw_n);
+	ret = bmi_setup_gpio(st->dev, st, st->hw_n);
 	if (ret < 0)
 		return ret;
 
 
-	desc = devm_kzalloc(&st->i2c->dev, sizeof(*desc)*BMI_HW_N, GFP_KERNEL);
+	desc = devm_kzalloc(st->dev, sizeof(*desc)*BMI_HW_N, GFP_KERNEL);
 	if (!desc)
 		return -ENOMEM;
 
 	for (i = 0; i < BMI_HW_N; i++) {
 		if (bmi_hws[i].fn_irqflags) {
 			irqflags = bmi_hws[i].fn_irqflags(st);
-			ret = devm_request_threaded_irq(&st->i2c->dev,
+			ret = devm_request_threaded_irq(st->dev,
 							st->snsrs[i].gis.irq,
 							NULL,
 							bmi_irq_thread,
@@ -1454,7 +1845,7 @@ static int bmi_init(struct bmi_state *st, const struct i2c_device_id *id)
 							st->snsrs[i].gis.dev_name,
 							&st->snsrs[i]);
 			if (ret) {
-				dev_err(&st->i2c->dev,
+				dev_err(st->dev,
 					"req_threaded_irq ERR %d\n", ret);
 				return ret;
 			}
@@ -1463,25 +1854,25 @@ static int bmi_init(struct bmi_state *st, const struct i2c_device_id *id)
 		ret = hte_init_line_attr(&desc[i], 0, 0, NULL,
 				st->snsrs[i].gis.gpio_in);
 		if (ret) {
-			dev_err(&st->i2c->dev,
+			dev_err(st->dev,
 					"hte_init_line_attr ERR %d\n", ret);
 			return ret;
 		}
 
-		ret = hte_ts_get(&st->i2c->dev, &desc[i], i);
+		ret = hte_ts_get(st->dev, &desc[i], i);
 
 		if (ret) {
-			dev_err(&st->i2c->dev,
+			dev_err(st->dev,
 					"hte_ts_get ERR %d\n", ret);
 			return ret;
 		}
 
-		ret = devm_hte_request_ts_ns(&st->i2c->dev, &desc[i],
+		ret = devm_hte_request_ts_ns(st->dev, &desc[i],
 						process_hw_ts, NULL,
 						&st->snsrs[i]);
 
 		if (ret) {
-			dev_err(&st->i2c->dev,
+			dev_err(st->dev,
 					"devm_hte_request_ts_ns ERR %d\n", ret);
 			return ret;
 		}
@@ -1491,49 +1882,88 @@ static int bmi_init(struct bmi_state *st, const struct i2c_device_id *id)
 	 * default rate to slowest speed, this gets reflected in register
 	 * during buffer enable time.
 	 */
-	for (i = 0; i < st->hw_n; i++)
+	for (i = 0; i < st->hw_n; i++) {
 		st->snsrs[i].period_us = st->snsrs[i].cfg.delay_us_max;
+		st->snsrs[i].fifo_wm = 1;
+	}
 
 	return ret;
 }
 
 
+static int bmi_probe(struct bmi_state *st, unsigned int part)
+{
+	int ret;
+
+	dev_set_drvdata(st->dev, st);
+	ret = bmi_init(st, part);
+	if (ret) {
+		bmi_remove(st);
+		return ret;
+	}
+
+	ret = devm_add_action_or_reset(st->dev, bmi_remove, st);
+	if (ret)
+		return ret;
+
+	dev_dbg(st->dev, "done\n");
+
+	return ret;
+}
+
 #if defined(NV_I2C_DRIVER_STRUCT_PROBE_WITHOUT_I2C_DEVICE_ID_ARG) /* Linux 6.3 */
-static int bmi_probe(struct i2c_client *client)
+static int bmi_i2c_probe(struct i2c_client *client)
 #else
-static int bmi_probe(struct i2c_client *client, const struct i2c_device_id *id)
+static int bmi_i2c_probe(struct i2c_client *client,
+			 const struct i2c_device_id *id)
 #endif
 {
 	struct bmi_state *st;
-	int ret;
+	unsigned int part = BMI_PART_BMI088;
 
 	st = devm_kzalloc(&client->dev, sizeof(*st), GFP_KERNEL);
 	if (st == NULL)
 		return -ENOMEM;
 
-	i2c_set_clientdata(client, st);
+	st->dev = &client->dev;
+	st->bus = &bmi_i2c_bus;
 	st->i2c = client;
-#if KERNEL_VERSION(6, 3, 0) <= LINUX_VERSION_CODE
-	ret = bmi_init(st, NULL);
-#else
-	ret = bmi_init(st, id);
+#if !defined(NV_I2C_DRIVER_STRUCT_PROBE_WITHOUT_I2C_DEVICE_ID_ARG)
+	if (id)
+		part = id->driver_data;
 #endif
-	if (ret) {
-		bmi_remove(client);
-		return ret;
-	}
 
-	ret = devm_add_action_or_reset(&client->dev, bmi_remove, client);
-	if (ret)
-		return ret;
+	return bmi_probe(st, part);
+}
+
+static int bmi_spi_probe(struct spi_device *spi)
+{
+	const struct spi_device_id *id = spi_get_device_id(spi);
+	struct bmi_state *st;
+	unsigned int part = BMI_PART_BMI088;
 
-	dev_dbg(&client->dev, "done\n");
+	st = devm_kzalloc(&spi->dev, sizeof(*st), GFP_KERNEL);
+	if (st == NULL)
+		return -ENOMEM;
 
-	return ret;
+	st->dev = &spi->dev;
+	st->bus = &bmi_spi_bus;
+	st->spi[BMI_HW_GYR] = spi;
+	if (id)
+		part = id->driver_data;
+
+	return bmi_probe(st, part);
 }
 
 MODULE_DEVICE_TABLE(i2c, bmi_i2c_device_ids);
 
+static const struct spi_device_id bmi_spi_device_ids[] = {
+	{ BMI_NAME, BMI_PART_BMI088 },
+	{},
+};
+
+MODULE_DEVICE_TABLE(spi, bmi_spi_device_ids);
+
 static const struct of_device_id bmi_of_match[] = {
 	{ .compatible = "bmi,bmi088", },
 	{}
@@ -1541,9 +1971,9 @@ static const struct of_device_id bmi_of_match[] = {
 
 MODULE_DEVICE_TABLE(of, bmi_of_match);
 
-static struct i2c_driver bmi_driver = {
+static struct i2c_driver bmi_i2c_driver = {
 	.class				= I2C_CLASS_HWMON,
-	.probe				= bmi_probe,
+	.probe				= bmi_i2c_probe,
 	.driver				= {
 		.name			= BMI_NAME,
 		.owner			= THIS_MODULE,
@@ -1553,9 +1983,41 @@ static struct i2c_driver bmi_driver = {
 	.id_table			= bmi_i2c_device_ids,
 };
 
-module_i2c_driver(bmi_driver);
+static struct spi_driver bmi_spi_driver = {
+	.probe				= bmi_spi_probe,
+	.driver				= {
+		.name			= BMI_NAME,
+		.owner			= THIS_MODULE,
+		.of_match_table		= of_match_ptr(bmi_of_match),
+		.pm			= &bmi_pm_ops,
+	},
+	.id_table			= bmi_spi_device_ids,
+};
+
+static int __init bmi_module_init(void)
+{
+	int ret;
+
+	ret = i2c_add_driver(&bmi_i2c_driver);
+	if (ret)
+		return ret;
+
+	ret = spi_register_driver(&bmi_spi_driver);
+	if (ret)
+		i2c_del_driver(&bmi_i2c_driver);
+
+	return ret;
+}
+module_init(bmi_module_init);
+
+static void __exit bmi_module_exit(void)
+{
+	spi_unregister_driver(&bmi_spi_driver);
+	i2c_del_driver(&bmi_i2c_driver);
+}
+module_exit(bmi_module_exit);
 
 MODULE_LICENSE("GPL v2");
-MODULE_DESCRIPTION("BMI088 I2C driver");
+MODULE_DESCRIPTION("BMI088 I2C/SPI driver");
 MODULE_AUTHOR("NVIDIA Corporation");
 
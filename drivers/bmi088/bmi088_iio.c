@@ -197,6 +197,50 @@ int bmi_iio_push_buf(struct iio_dev *indio_dev, unsigned char *data, u64 ts)
 }
 EXPORT_SYMBOL_GPL(bmi_iio_push_buf);
 
+/*
+ * Pushes n samples of NUM_CHANNELS axes back to back in data, the last one
+ * taken at ts and the others ts_step apart.
+ */
+int bmi_iio_push_bufs(struct iio_dev *indio_dev, unsigned char *data,
+		      unsigned int n, u64 ts, u64 ts_step)
+{
+	struct bmi_iio_state *st;
+	__le16 *sample = (__le16 *)data;
+	unsigned int i;
+	int ret = 0;
+	int bit;
+
+	if (!indio_dev || !data)
+		return -EINVAL;
+
+	if (!indio_dev->active_scan_mask)
+		return -EINVAL;
+
+	if (!iio_buffer_enabled(indio_dev))
+		return 0;
+
+	st = iio_priv(indio_dev);
+	memset(&st->data, 0, sizeof(st->data));
+	ts -= (u64)(n - 1) * ts_step;
+
+	for (i = 0; i < n; i++, sample += NUM_CHANNELS, ts += ts_step) {
+		for_each_set_bit(bit, indio_dev->active_scan_mask,
+				 indio_dev->masklength) {
+			st->data.chan[bit] = sample[bit];
+		}
+
+		ret = iio_push_to_buffers_with_timestamp(indio_dev, &st->data,
+							 ts);
+		if (ret)
+			break;
+
+		st->ts = ts;
+	}
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(bmi_iio_push_bufs);
+
 static int bmi_iio_enable(struct iio_dev *indio_dev, bool en)
 {
 	struct bmi_iio_state *st = iio_priv(indio_dev);
@@ -457,6 +501,16 @@ out:
 	return ret;
 }
 
+static int bmi_iio_set_watermark(struct iio_dev *indio_dev, unsigned int val)
+{
+	struct bmi_iio_state *st = iio_priv(indio_dev);
+
+	if (!st->fn_dev->set_watermark)
+		return -EINVAL;
+
+	return st->fn_dev->set_watermark(st->client, st->cfg->snsr_id, val);
+}
+
 static int bmi_iio_buffer_preenable(struct iio_dev *indio_dev)
 {
 	struct bmi_iio_state *st = iio_priv(indio_dev);
@@ -517,6 +571,7 @@ static int __bmi_08x_iio_init(struct iio_dev *indio_dev,
 	st->info.attrs = &st->attr_group;
 	st->info.read_raw = &bmi_iio_read_raw;
 	st->info.write_raw = &bmi_iio_write_raw;
+	st->info.hwfifo_set_watermark = &bmi_iio_set_watermark;
 	indio_dev->info = &st->info;
 	indio_dev->setup_ops = &bmi_iio_buffer_setup_ops;
 	buffer = iio_kfifo_allocate();
@@ -46,10 +46,13 @@ struct iio_fn_dev {
 	int (*regs)(void *client, int snsr_id, char *buf);
 	int (*read_err)(void *client, int snsr_id, char *buf);
 	int (*get_data)(void *client, int snsr_id, int axis, int *val);
+	int (*set_watermark)(void *client, int snsr_id, unsigned int wm);
 };
 
 void bmi_iio_remove(struct iio_dev *indio_dev);
 int bmi_iio_push_buf(struct iio_dev *indio_dev, unsigned char *data, u64 ts);
+int bmi_iio_push_bufs(struct iio_dev *indio_dev, unsigned char *data,
+		      unsigned int n, u64 ts, u64 ts_step);
 int bmi_08x_iio_init(struct iio_dev **handle, void *dev_client,
 		     struct device *dev, struct iio_fn_dev *fn_dev,
 		     struct sensor_cfg *snsr_cfg);
@@ -9,6 +9,8 @@
 #include <soc/tegra/bpmp.h>
 #include <soc/tegra/bpmp-abi.h>
 
+#include "../../firmware/tegra/bpmp-tegra186-hv.h"
+
 #define TEGRA_BPMP_DUMP_CLOCK_INFO	0
 
 #define TEGRA_BPMP_CLK_HAS_MUX		BIT(0)
@@ -31,6 +33,24 @@ struct tegra_bpmp_clk {
 
 	unsigned int num_parents;
 	unsigned int *parents;
+
+	/*
+	 * Last rate read back or set, and last rounded rate, so that requests
+	 * which change nothing do not cost an MRQ. Both are only valid for
+	 * the parent rate they were obtained with.
+	 */
+	struct {
+		bool valid;
+		unsigned long parent_rate;
+		unsigned long rate;
+	} cache;
+
+	struct {
+		bool valid;
+		unsigned long parent_rate;
+		unsigned long req;
+		unsigned long rate;
+	} round;
 };
 
 static inline struct tegra_bpmp_clk *to_tegra_bpmp_clk(struct clk_hw *hw)
@@ -147,6 +167,9 @@ static unsigned long tegra_bpmp_clk_recalc_rate(struct clk_hw *hw,
 	struct tegra_bpmp_clk_message msg;
 	int err;
 
+	if (clk->cache.valid && clk->cache.parent_rate == parent_rate)
+		return clk->cache.rate;
+
 	memset(&msg, 0, sizeof(msg));
 	msg.cmd = CMD_CLK_GET_RATE;
 	msg.id = clk->id;
@@ -159,6 +182,10 @@ static unsigned long tegra_bpmp_clk_recalc_rate(struct clk_hw *hw,
 	if (err < 0)
 		return 0;
 
+	clk->cache.parent_rate = parent_rate;
+	clk->cache.rate = response.rate;
+	clk->cache.valid = true;
+
 	return response.rate;
 }
 
@@ -174,6 +201,12 @@ static int tegra_bpmp_clk_determine_rate(struct clk_hw *hw,
 
 	rate = min(max(rate_req->rate, rate_req->min_rate), rate_req->max_rate);
 
+	if (clk->round.valid && clk->round.req == rate &&
+	    clk->round.parent_rate == rate_req->best_parent_rate) {
+		rate_req->rate = clk->round.rate;
+		return 0;
+	}
+
 	memset(&request, 0, sizeof(request));
 	request.rate = min_t(u64, rate, S64_MAX);
 
@@ -191,6 +224,11 @@ static int tegra_bpmp_clk_determine_rate(struct clk_hw *hw,
 
 	rate_req->rate = (unsigned long)response.rate;
 
+	clk->round.parent_rate = rate_req->best_parent_rate;
+	clk->round.req = rate;
+	clk->round.rate = rate_req->rate;
+	clk->round.valid = true;
+
 	return 0;
 }
 
@@ -213,6 +251,10 @@ static int tegra_bpmp_clk_set_parent(struct clk_hw *hw, u8 index)
 	msg.rx.data = &response;
 	msg.rx.size = sizeof(response);
 
+	/* the rate follows the parent, and so does rounding */
+	clk->cache.valid = false;
+	clk->round.valid = false;
+
 	err = tegra_bpmp_clk_transfer(clk->bpmp, &msg);
 	if (err < 0)
 		return err;
@@ -257,6 +299,7 @@ static int tegra_bpmp_clk_set_rate(struct clk_hw *hw, unsigned long rate,
 	struct cmd_clk_set_rate_response response;
 	struct cmd_clk_set_rate_request request;
 	struct tegra_bpmp_clk_message msg;
+	int err;
 
 	memset(&request, 0, sizeof(request));
 	request.rate = min_t(u64, rate, S64_MAX);
@@ -269,7 +312,22 @@ static int tegra_bpmp_clk_set_rate(struct clk_hw *hw, unsigned long rate,
 	msg.rx.data = &response;
 	msg.rx.size = sizeof(response);
 
-	return tegra_bpmp_clk_transfer(clk->bpmp, &msg);
+	err = tegra_bpmp_clk_transfer(clk->bpmp, &msg);
+	if (err < 0) {
+		clk->cache.valid = false;
+		return err;
+	}
+
+	/* BPMP applied something else than it rounded to, e.g. a new cap */
+	if (clk->round.valid && clk->round.rate == rate &&
+	    (unsigned long)response.rate != rate)
+		clk->round.valid = false;
+
+	clk->cache.parent_rate = parent_rate;
+	clk->cache.rate = response.rate;
+	clk->cache.valid = true;
+
+	return 0;
 }
 
 static const struct clk_ops tegra_bpmp_clk_gate_ops = {
@@ -651,6 +709,25 @@ static void tegra_bpmp_unregister_clocks(struct tegra_bpmp *bpmp)
 		clk_hw_unregister(&bpmp->clocks[i]->hw);
 }
 
+/*
+ * Drop the cached rates, BPMP may have changed any clock behind our back,
+ * e.g. across system suspend.
+ */
+void tegra_bpmp_clk_invalidate(struct tegra_bpmp *bpmp)
+{
+	unsigned int i;
+
+	for (i = 0; i < bpmp->num_clocks; i++) {
+		struct tegra_bpmp_clk *clk = bpmp->clocks[i];
+
+		if (IS_ERR_OR_NULL(clk))
+			continue;
+
+		clk->cache.valid = false;
+		clk->round.valid = false;
+	}
+}
+
 static struct clk_hw *tegra_bpmp_clk_of_xlate(struct of_phandle_args *clkspec,
 					      void *data)
 {
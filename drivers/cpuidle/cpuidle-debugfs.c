@@ -4,6 +4,10 @@
  *
  * Module to force cpuidle states through debugfs files.
  *
+ * Also keeps per-state histograms of the idle residency and of the resume
+ * latency constraint the CPU was under when entering the state, in
+ * cpuidle_debug/histograms. Writing to the file clears them.
+ *
  */
 #include <linux/module.h>
 #include <linux/irq.h>
@@ -12,11 +16,144 @@
 #include <linux/debugfs.h>
 #include <linux/cpu.h>
 #include <linux/cpuidle.h>
+#include <linux/log2.h>
+#include <linux/percpu.h>
+#include <linux/pm_qos.h>
+#include <linux/sched/clock.h>
+#include <linux/seq_file.h>
+#include <trace/events/power.h>
 
 #define US_TO_NS(x) (1000 * x)
 
+/* log2 buckets, the last one collects everything above 2^(N - 2) us */
+#define IDLE_HIST_BUCKETS 16
+
 static struct cpuidle_driver *drv;
 
+struct idle_hist {
+	u64 residency[CPUIDLE_STATE_MAX][IDLE_HIST_BUCKETS];
+	u64 latency[CPUIDLE_STATE_MAX][IDLE_HIST_BUCKETS];
+	u64 below_target[CPUIDLE_STATE_MAX];
+	u64 entry_ns;
+	int state;
+};
+
+static DEFINE_PER_CPU(struct idle_hist, idle_hist);
+
+static unsigned int idle_hist_bucket(u64 us)
+{
+	if (us == 0)
+		return 0;
+
+	return min_t(unsigned int, ilog2(us) + 1, IDLE_HIST_BUCKETS - 1);
+}
+
+static void idle_hist_probe(void *data, unsigned int state,
+			    unsigned int cpu_id)
+{
+	struct idle_hist *hist = this_cpu_ptr(&idle_hist);
+	u64 now = local_clock();
+	struct device *cpu_dev;
+	s32 latency_us;
+	u64 us;
+
+	if (state != PWR_EVENT_EXIT) {
+		if (state >= CPUIDLE_STATE_MAX)
+			return;
+
+		cpu_dev = get_cpu_device(cpu_id);
+		latency_us = cpu_dev ?
+			dev_pm_qos_read_value(cpu_dev, DEV_PM_QOS_RESUME_LATENCY) :
+			PM_QOS_RESUME_LATENCY_NO_CONSTRAINT;
+
+		hist->latency[state][idle_hist_bucket(latency_us)]++;
+		hist->state = state;
+		hist->entry_ns = now;
+		return;
+	}
+
+	if (hist->state < 0)
+		return;
+
+	us = div_u64(now - hist->entry_ns, NSEC_PER_USEC);
+	hist->residency[hist->state][idle_hist_bucket(us)]++;
+	if (us < drv->states[hist->state].target_residency)
+		hist->below_target[hist->state]++;
+	hist->state = -1;
+}
+
+static void idle_hist_print(struct seq_file *s, const char *name,
+			    const u64 *buckets)
+{
+	unsigned int i;
+
+	seq_printf(s, "  %s_us:", name);
+	for (i = 0; i < IDLE_HIST_BUCKETS; i++)
+		seq_printf(s, " %llu", buckets[i]);
+	seq_puts(s, "\n");
+}
+
+static int idle_hist_show(struct seq_file *s, void *unused)
+{
+	u64 residency[IDLE_HIST_BUCKETS], latency[IDLE_HIST_BUCKETS];
+	u64 below_target;
+	int cpu, i, j;
+
+	seq_puts(s, "buckets: 0 <2 <4 <8 ... >=16384\n");
+
+	for (i = 0; i < drv->state_count && i < CPUIDLE_STATE_MAX; i++) {
+		memset(residency, 0, sizeof(residency));
+		memset(latency, 0, sizeof(latency));
+		below_target = 0;
+
+		for_each_possible_cpu(cpu) {
+			struct idle_hist *hist = per_cpu_ptr(&idle_hist, cpu);
+
+			for (j = 0; j < IDLE_HIST_BUCKETS; j++) {
+				residency[j] += hist->residency[i][j];
+				latency[j] += hist->latency[i][j];
+			}
+			below_target += hist->below_target[i];
+		}
+
+		seq_printf(s, "%s: below_target_residency %llu\n",
+			   drv->states[i].name, below_target);
+		idle_hist_print(s, "residency", residency);
+		idle_hist_print(s, "latency_req", latency);
+	}
+
+	return 0;
+}
+
+static int idle_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, idle_hist_show, NULL);
+}
+
+static ssize_t idle_hist_write(struct file *file, const char __user *buf,
+			       size_t count, loff_t *ppos)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct idle_hist *hist = per_cpu_ptr(&idle_hist, cpu);
+
+		memset(hist->residency, 0, sizeof(hist->residency));
+		memset(hist->latency, 0, sizeof(hist->latency));
+		memset(hist->below_target, 0, sizeof(hist->below_target));
+	}
+
+	return count;
+}
+
+static const struct file_operations idle_hist_fops = {
+	.open = idle_hist_open,
+	.read = seq_read,
+	.write = idle_hist_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static bool is_timer_irq(struct irq_desc *desc)
 {
 	return desc && desc->action && (desc->action->flags & IRQF_TIMER);
@@ -88,6 +225,8 @@ static int init_debugfs(void)
 		debugfs_create_file(drv->states[i].name, 0200,
 			cpuidle_debugfs_node, &(drv->states[i]), &idle_state_fops);
 	}
+	debugfs_create_file("histograms", 0600, cpuidle_debugfs_node, NULL,
+			    &idle_hist_fops);
 	return 0;
 
 err_out:
@@ -98,7 +237,18 @@ err_out:
 
 static int __init cpuidle_debugfs_probe(void)
 {
+	int cpu;
+
 	drv = cpuidle_get_driver();
+	if (!drv)
+		return -ENODEV;
+
+	for_each_possible_cpu(cpu)
+		per_cpu_ptr(&idle_hist, cpu)->state = -1;
+
+	if (register_trace_cpu_idle(idle_hist_probe, NULL))
+		pr_warn("%s: idle histograms disabled\n", __func__);
+
 	init_debugfs();
 	return 0;
 }
@@ -106,6 +256,8 @@ static int __init cpuidle_debugfs_probe(void)
 static void __exit cpuidle_debugfs_remove(void)
 {
 	debugfs_remove_recursive(cpuidle_debugfs_node);
+	unregister_trace_cpu_idle(idle_hist_probe, NULL);
+	tracepoint_synchronize_unregister();
 }
 
 module_init(cpuidle_debugfs_probe);
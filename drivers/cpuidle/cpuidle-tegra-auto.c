@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0
 // Copyright (c) 2022-2023, NVIDIA CORPORATION.  All rights reserved.
 
+#include <linux/cpu.h>
 #include <linux/cpu_cooling.h>
 #include <linux/cpuidle.h>
 #include <linux/cpumask.h>
@@ -15,7 +16,9 @@
 #include <linux/delay.h>
 #include <linux/sched.h>
 #include <linux/platform_device.h>
+#include <linux/pm_qos.h>
 #include <asm/cpuidle.h>
+#include <asm/sysreg.h>
 #include <linux/suspend.h>
 #include <linux/wait.h>
 #include <soc/tegra/virt/syscalls.h>
@@ -27,9 +30,23 @@ enum {
 	CPUIDLE_TEGRA_AUTO_SC7_RESUME_START,
 };
 
+/* ISR_EL1.I and ISR_EL1.F, an IRQ or FIQ is pending */
+#define TEGRA_AUTO_ISR_EL1_IF	(BIT(7) | BIT(6))
+
+/*
+ * Per-CPU resume latency constraint, tracked through the PM QoS of the CPU
+ * device. Real-time drivers set it with dev_pm_qos_add_request() on
+ * get_cpu_device(cpu) while streaming.
+ */
+struct tegra_auto_cpu_qos {
+	struct notifier_block nb;
+	s32 latency_us;
+};
+
 static struct cpumask cpumask;
 static bool s2idle_sc7_state;
 static DEFINE_PER_CPU(struct cpuidle_driver *, tegra_auto_cpuidle_drivers);
+static DEFINE_PER_CPU(struct tegra_auto_cpu_qos, tegra_auto_cpu_qos);
 
 static bool tegra_auto_cpuidle_s2idle_exit(int cpu_number)
 {
@@ -54,6 +71,17 @@ static struct notifier_block suspend_notifier = {
 	.notifier_call = tegra_auto_suspend_notify_callback,
 };
 
+static int tegra_auto_cpu_qos_notify(struct notifier_block *nb,
+				     unsigned long value, void *data)
+{
+	struct tegra_auto_cpu_qos *qos =
+		container_of(nb, struct tegra_auto_cpu_qos, nb);
+
+	WRITE_ONCE(qos->latency_us, (s32)value);
+
+	return NOTIFY_OK;
+}
+
 /*
  * tegra_auto_enter_idle_state - Programs CPU to enter the specified state
  *
@@ -63,10 +91,25 @@ static struct notifier_block suspend_notifier = {
  *
  * Called from the CPUidle framework to program the device to the
  * specified target state selected by the governor.
+ *
+ * WFI traps to the hypervisor, which may power down the core. When the
+ * resume latency constraint of this CPU is below the exit latency of even
+ * the shallowest state, spin until an interrupt is pending instead, so the
+ * interrupt of the constraining driver is taken without the idle exit.
  */
 static int tegra_auto_enter_idle_state(struct cpuidle_device *dev,
 				       struct cpuidle_driver *drv, int idx)
 {
+	s32 latency_us = READ_ONCE(per_cpu(tegra_auto_cpu_qos,
+					   dev->cpu).latency_us);
+
+	if (latency_us < (s32)drv->states[0].exit_latency) {
+		while (!(read_sysreg(isr_el1) & TEGRA_AUTO_ISR_EL1_IF))
+			cpu_relax();
+
+		return 0;
+	}
+
 	asm volatile("wfi\n");
 
 	return 0;
@@ -144,15 +187,28 @@ static struct cpuidle_driver tegra_auto_idle_driver __initdata = {
 	},
 };
 
+static void tegra_auto_idle_remove_cpu_qos(int cpu)
+{
+	struct tegra_auto_cpu_qos *qos = &per_cpu(tegra_auto_cpu_qos, cpu);
+	struct device *cpu_dev = get_cpu_device(cpu);
+
+	if (cpu_dev)
+		dev_pm_qos_remove_notifier(cpu_dev, &qos->nb,
+					   DEV_PM_QOS_RESUME_LATENCY);
+}
+
 /*
  * tegra_auto_idle_init_cpu
  *
  * Registers the tegra_auto specific cpuidle driver with the cpuidle framework.
  */
-static int __init tegra_auto_idle_init_cpu(int cpu)
+static int __init tegra_auto_idle_init_cpu(struct device_node *np, int cpu)
 {
 	int ret = 0;
 	struct cpuidle_driver *drv;
+	struct device *cpu_dev;
+	struct tegra_auto_cpu_qos *qos = &per_cpu(tegra_auto_cpu_qos, cpu);
+	u32 latency;
 
 	drv = kmemdup(&tegra_auto_idle_driver, sizeof(*drv), GFP_KERNEL);
 	if (!drv)
@@ -160,15 +216,42 @@ static int __init tegra_auto_idle_init_cpu(int cpu)
 
 	drv->cpumask = (struct cpumask *)cpumask_of(cpu);
 
+	/* Cost of a WFI trapped to the hypervisor, 1us unless given in DT */
+	if (!of_property_read_u32(np, "nvidia,wfi-exit-latency-us", &latency)) {
+		drv->states[0].exit_latency = latency;
+		drv->states[1].exit_latency = latency;
+	}
+	if (!of_property_read_u32(np, "nvidia,wfi-target-residency-us",
+				  &latency)) {
+		drv->states[0].target_residency = latency;
+		drv->states[1].target_residency = latency;
+	}
+
+	qos->latency_us = PM_QOS_RESUME_LATENCY_NO_CONSTRAINT;
+	qos->nb.notifier_call = tegra_auto_cpu_qos_notify;
+	cpu_dev = get_cpu_device(cpu);
+	if (cpu_dev) {
+		ret = dev_pm_qos_add_notifier(cpu_dev, &qos->nb,
+					      DEV_PM_QOS_RESUME_LATENCY);
+		if (ret) {
+			pr_err("cpu%d pm qos notifier failed\n", cpu);
+			goto out_kfree_drv;
+		}
+		qos->latency_us = dev_pm_qos_read_value(cpu_dev,
+						DEV_PM_QOS_RESUME_LATENCY);
+	}
+
 	ret = cpuidle_register(drv, NULL);
 	if (ret) {
 		pr_err("cpu register failed\n");
-		goto out_kfree_drv;
+		goto out_remove_qos;
 	}
 	per_cpu(tegra_auto_cpuidle_drivers, cpu) = drv;
 
 	return 0;
 
+out_remove_qos:
+	tegra_auto_idle_remove_cpu_qos(cpu);
 out_kfree_drv:
 	kfree(drv);
 	return ret;
@@ -187,7 +270,7 @@ static int __init tegra_auto_cpuidle_probe(struct platform_device *pdev)
 	struct cpuidle_driver *drv;
 
 	for_each_possible_cpu(cpu) {
-		ret = tegra_auto_idle_init_cpu(cpu);
+		ret = tegra_auto_idle_init_cpu(pdev->dev.of_node, cpu);
 		if (ret)
 			goto out_fail;
 	}
@@ -199,6 +282,7 @@ out_fail:
 	while (--cpu >= 0) {
 		drv = per_cpu(tegra_auto_cpuidle_drivers, cpu);
 		cpuidle_unregister(drv);
+		tegra_auto_idle_remove_cpu_qos(cpu);
 		per_cpu(tegra_auto_cpuidle_drivers, cpu) = NULL;
 		kfree(drv);
 	}
@@ -214,6 +298,7 @@ static int tegra_auto_cpuidle_remove(struct platform_device *pdev)
 	for_each_possible_cpu(cpu) {
 		drv = per_cpu(tegra_auto_cpuidle_drivers, cpu);
 		cpuidle_unregister(drv);
+		tegra_auto_idle_remove_cpu_qos(cpu);
 		per_cpu(tegra_auto_cpuidle_drivers, cpu) = NULL;
 		kfree(drv);
 	}
@@ -14,10 +14,16 @@
 #include <linux/scatterlist.h>
 #include <linux/dma-mapping.h>
 #include <linux/hw_random.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/workqueue.h>
 #include <linux/io.h>
 #include <linux/of_device.h>
 #include <linux/of_platform.h>
 #include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/list.h>
+#include <linux/wait.h>
 #include <linux/types.h>
 #include <linux/errno.h>
 #include <crypto/scatterwalk.h>
@@ -42,7 +48,7 @@
 #include "tegra-hv-vse.h"
 
 #define SE_MAX_SCHEDULE_TIMEOUT					LONG_MAX
-#define TEGRA_HV_VSE_SHA_MAX_LL_NUM_1				1
+#define TEGRA_HV_VSE_SHA_MIN_DIRECT_SIZE			SZ_64K
 #define TEGRA_HV_VSE_AES_CMAC_MAX_LL_NUM			2
 #define TEGRA_HV_VSE_MAX_TASKS_PER_SUBMIT			1
 #define TEGRA_HV_VSE_TIMEOUT			(msecs_to_jiffies(10000))
@@ -289,6 +295,32 @@ static struct crypto_dev_to_ivc_map g_crypto_to_ivc_map[MAX_NUMBER_MISC_DEVICES]
 static bool gcm_supports_dma;
 static struct device *gpcdma_dev;
 
+/*
+ * Requests that may be outstanding on each IVC channel. The default of one
+ * keeps the strict send-then-wait sequence; larger values let several
+ * callers have requests in flight and complete skcipher requests
+ * asynchronously. The SE server has to accept the configured depth.
+ */
+static unsigned int ivc_queue_depth = 1;
+module_param(ivc_queue_depth, uint, 0444);
+MODULE_PARM_DESC(ivc_queue_depth, "Outstanding requests per IVC channel");
+
+/*
+ * hwrng reads are served from a pool of this many bytes that a worker
+ * refills in the background once it drops below the low watermark, up to
+ * the high watermark. Zero disables the pool and every read goes to the
+ * SE server. Watermarks of zero default to a quarter and all of the pool.
+ */
+static unsigned int rng_pool_size;
+module_param(rng_pool_size, uint, 0444);
+MODULE_PARM_DESC(rng_pool_size, "hwrng pool size in bytes, 0 disables the pool");
+static unsigned int rng_pool_low_wm;
+module_param(rng_pool_low_wm, uint, 0444);
+MODULE_PARM_DESC(rng_pool_low_wm, "hwrng pool refill threshold in bytes");
+static unsigned int rng_pool_high_wm;
+module_param(rng_pool_high_wm, uint, 0444);
+MODULE_PARM_DESC(rng_pool_high_wm, "hwrng pool refill target in bytes");
+
 /* Security Engine Linked List */
 struct tegra_virtual_se_ll {
 	dma_addr_t addr; /* DMA buffer address */
@@ -357,6 +389,10 @@ struct tegra_vse_priv_data {
 	uint32_t syncpt_id;
 	uint32_t syncpt_threshold;
 	uint32_t syncpt_id_valid;
+	/* entry in the channel inflight list when pipelined */
+	struct list_head inflight_node;
+	/* called instead of completing alg_complete for async requests */
+	void (*done)(struct tegra_vse_priv_data *priv);
 };
 
 struct tegra_virtual_se_addr {
@@ -648,6 +684,62 @@ static int read_and_validate_dummy_msg(
 	return err;
 }
 
+/* Copy the response of a command into its request, false if unknown */
+static bool tegra_hv_vse_safety_parse_resp(struct tegra_virtual_se_dev *se_dev,
+	struct tegra_vse_priv_data *priv,
+	struct tegra_virtual_se_ivc_msg_t *ivc_msg)
+{
+	struct tegra_virtual_se_aes_req_context *req_ctx;
+	struct tegra_virtual_se_ivc_resp_msg_t *ivc_rx;
+
+	priv->syncpt_id = ivc_msg->rx[0].syncpt_id;
+	priv->syncpt_threshold = ivc_msg->rx[0].syncpt_threshold;
+	priv->syncpt_id_valid = ivc_msg->rx[0].syncpt_id_valid;
+
+	switch (priv->cmd) {
+	case VIRTUAL_SE_AES_CRYPTO:
+		priv->rx_status = ivc_msg->rx[0].status;
+		req_ctx = skcipher_request_ctx(priv->req);
+		if ((!priv->rx_status) && (req_ctx->encrypt == true) &&
+				((req_ctx->op_mode == AES_CTR) ||
+				(req_ctx->op_mode == AES_CBC))) {
+			memcpy(priv->iv, ivc_msg->rx[0].iv,
+					TEGRA_VIRTUAL_SE_AES_IV_SIZE);
+		}
+		break;
+	case VIRTUAL_SE_KEY_SLOT:
+		ivc_rx = &ivc_msg->rx[0];
+		priv->slot_num = ivc_rx->keyslot;
+		break;
+	case VIRTUAL_SE_PROCESS:
+		ivc_rx = &ivc_msg->rx[0];
+		priv->rx_status = ivc_rx->status;
+		break;
+	case VIRTUAL_CMAC_PROCESS:
+		ivc_rx = &ivc_msg->rx[0];
+		priv->rx_status = ivc_rx->status;
+		priv->cmac.status = ivc_rx->status;
+		if (!ivc_rx->status) {
+			memcpy(priv->cmac.data, ivc_rx->cmac_result,
+				TEGRA_VIRTUAL_SE_AES_CMAC_DIGEST_SIZE);
+		}
+		break;
+	case VIRTUAL_SE_AES_GCM_ENC_PROCESS:
+		ivc_rx = &ivc_msg->rx[0];
+		priv->rx_status = ivc_rx->status;
+		if (!ivc_rx->status)
+			memcpy(priv->iv, ivc_rx->iv,
+					TEGRA_VIRTUAL_SE_AES_GCM_IV_SIZE);
+
+		break;
+	default:
+		dev_err(se_dev->dev, "Unknown command\n");
+		return false;
+	}
+
+	return true;
+}
+
 static int read_and_validate_valid_msg(
 	struct tegra_virtual_se_dev *se_dev,
 	struct tegra_hv_ivc_cookie *pivck,
@@ -657,8 +749,6 @@ static int read_and_validate_valid_msg(
 	struct tegra_vse_priv_data *priv;
 	struct tegra_virtual_se_ivc_msg_t *ivc_msg;
 	struct tegra_virtual_se_ivc_hdr_t *ivc_hdr;
-	struct tegra_virtual_se_aes_req_context *req_ctx;
-	struct tegra_virtual_se_ivc_resp_msg_t *ivc_rx;
 	enum ivc_irq_state *irq_state;
 
 	int read_size = -1, err = 0;
@@ -699,50 +789,8 @@ static int read_and_validate_valid_msg(
 		pr_err("%s no call back info\n", __func__);
 		goto deinit;
 	}
-	priv->syncpt_id = ivc_msg->rx[0].syncpt_id;
-	priv->syncpt_threshold = ivc_msg->rx[0].syncpt_threshold;
-	priv->syncpt_id_valid = ivc_msg->rx[0].syncpt_id_valid;
-
-	switch (priv->cmd) {
-	case VIRTUAL_SE_AES_CRYPTO:
-		priv->rx_status = ivc_msg->rx[0].status;
-		req_ctx = skcipher_request_ctx(priv->req);
-		if ((!priv->rx_status) && (req_ctx->encrypt == true) &&
-				((req_ctx->op_mode == AES_CTR) ||
-				(req_ctx->op_mode == AES_CBC))) {
-			memcpy(priv->iv, ivc_msg->rx[0].iv,
-					TEGRA_VIRTUAL_SE_AES_IV_SIZE);
-		}
-		break;
-	case VIRTUAL_SE_KEY_SLOT:
-		ivc_rx = &ivc_msg->rx[0];
-		priv->slot_num = ivc_rx->keyslot;
-		break;
-	case VIRTUAL_SE_PROCESS:
-		ivc_rx = &ivc_msg->rx[0];
-		priv->rx_status = ivc_rx->status;
-		break;
-	case VIRTUAL_CMAC_PROCESS:
-		ivc_rx = &ivc_msg->rx[0];
-		priv->rx_status = ivc_rx->status;
-		priv->cmac.status = ivc_rx->status;
-		if (!ivc_rx->status) {
-			memcpy(priv->cmac.data, ivc_rx->cmac_result,
-				TEGRA_VIRTUAL_SE_AES_CMAC_DIGEST_SIZE);
-		}
-		break;
-	case VIRTUAL_SE_AES_GCM_ENC_PROCESS:
-		ivc_rx = &ivc_msg->rx[0];
-		priv->rx_status = ivc_rx->status;
-		if (!ivc_rx->status)
-			memcpy(priv->iv, ivc_rx->iv,
-					TEGRA_VIRTUAL_SE_AES_GCM_IV_SIZE);
-
-		break;
-	default:
-		dev_err(se_dev->dev, "Unknown command\n");
+	if (!tegra_hv_vse_safety_parse_resp(se_dev, priv, ivc_msg))
 		waited = false;
-	}
 	if (waited)
 		complete(&priv->alg_complete);
 
@@ -795,6 +843,179 @@ static int tegra_hv_vse_safety_send_ivc(
 	return 0;
 }
 
+static bool tegra_hv_vse_safety_get_slot(struct crypto_dev_to_ivc_map *ivc_map)
+{
+	unsigned long flags;
+	bool ret = false;
+
+	spin_lock_irqsave(&ivc_map->inflight_lock, flags);
+	if (ivc_map->inflight_cnt < ivc_map->queue_depth) {
+		ivc_map->inflight_cnt++;
+		ret = true;
+	}
+	spin_unlock_irqrestore(&ivc_map->inflight_lock, flags);
+
+	return ret;
+}
+
+static void tegra_hv_vse_safety_put_slot(struct crypto_dev_to_ivc_map *ivc_map)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&ivc_map->inflight_lock, flags);
+	ivc_map->inflight_cnt--;
+	spin_unlock_irqrestore(&ivc_map->inflight_lock, flags);
+
+	wake_up(&ivc_map->inflight_wq);
+}
+
+/*
+ * Remove the request matching a response tag from the inflight list. The
+ * tag is only trusted once it is found on the list, so stale or corrupted
+ * responses are dropped. Releases the request's slot on success.
+ */
+static struct tegra_vse_priv_data *tegra_hv_vse_safety_take_inflight(
+	struct crypto_dev_to_ivc_map *ivc_map, void *tag)
+{
+	struct tegra_vse_priv_data *priv, *found = NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ivc_map->inflight_lock, flags);
+	list_for_each_entry(priv, &ivc_map->inflight, inflight_node) {
+		if ((void *)priv == tag) {
+			list_del_init(&priv->inflight_node);
+			found = priv;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&ivc_map->inflight_lock, flags);
+
+	if (found)
+		tegra_hv_vse_safety_put_slot(ivc_map);
+
+	return found;
+}
+
+/*
+ * Queue a request on a pipelined channel without waiting for its response.
+ * The tegra_vse kthread matches the response by tag and then either calls
+ * priv->done or completes priv->alg_complete.
+ */
+static int tegra_hv_vse_safety_send_ivc_pipelined(
+	struct tegra_virtual_se_dev *se_dev,
+	struct tegra_hv_ivc_cookie *pivck,
+	struct tegra_vse_priv_data *priv,
+	void *pbuf, int length, uint32_t node_id)
+{
+	struct crypto_dev_to_ivc_map *ivc_map = &g_crypto_to_ivc_map[node_id];
+	unsigned long flags;
+	int err = 0;
+
+	if (wait_event_timeout(ivc_map->inflight_wq,
+			tegra_hv_vse_safety_get_slot(ivc_map),
+			TEGRA_HV_VSE_TIMEOUT) == 0) {
+		dev_err(se_dev->dev, "%s: no free slot on channel %u\n",
+			__func__, ivc_map->ivc_id);
+		return -ETIMEDOUT;
+	}
+
+	mutex_lock(&ivc_map->se_ivc_lock);
+
+	/* Return error if engine is in suspended state */
+	if (atomic_read(&se_dev->se_suspended)) {
+		err = -ENODEV;
+		goto unlock;
+	}
+
+	/* track the request before the response can possibly arrive */
+	spin_lock_irqsave(&ivc_map->inflight_lock, flags);
+	list_add_tail(&priv->inflight_node, &ivc_map->inflight);
+	spin_unlock_irqrestore(&ivc_map->inflight_lock, flags);
+
+	err = tegra_hv_vse_safety_send_ivc(se_dev, pivck, pbuf, length);
+	if (err) {
+		dev_err(se_dev->dev,
+			"\n %s send ivc failed %d\n", __func__, err);
+		spin_lock_irqsave(&ivc_map->inflight_lock, flags);
+		list_del_init(&priv->inflight_node);
+		spin_unlock_irqrestore(&ivc_map->inflight_lock, flags);
+	}
+
+unlock:
+	mutex_unlock(&ivc_map->se_ivc_lock);
+	if (err)
+		tegra_hv_vse_safety_put_slot(ivc_map);
+
+	return err;
+}
+
+static int tegra_hv_vse_safety_wait_syncpt(struct tegra_virtual_se_dev *se_dev,
+	struct tegra_vse_priv_data *priv)
+{
+	struct host1x_syncpt *sp;
+	struct host1x *host1x;
+	int err;
+
+	if (!priv->syncpt_id_valid)
+		return 0;
+
+	host1x = platform_get_drvdata(se_dev->host1x_pdev);
+	if (!host1x) {
+		dev_err(se_dev->dev, "No platform data for host1x!\n");
+		return -ENODATA;
+	}
+
+	sp = host1x_syncpt_get_by_id_noref(host1x, priv->syncpt_id);
+	if (!sp) {
+		dev_err(se_dev->dev, "No syncpt for syncpt id %d\n", priv->syncpt_id);
+		return -ENODATA;
+	}
+
+	err = host1x_syncpt_wait(sp, priv->syncpt_threshold, (u32)SE_MAX_SCHEDULE_TIMEOUT, NULL);
+	if (err) {
+		dev_err(se_dev->dev, "timed out for syncpt %u threshold %u err %d\n",
+					 priv->syncpt_id, priv->syncpt_threshold, err);
+		return -ETIMEDOUT;
+	}
+
+	return 0;
+}
+
+static int tegra_hv_vse_safety_send_ivc_wait_pipelined(
+	struct tegra_virtual_se_dev *se_dev,
+	struct tegra_hv_ivc_cookie *pivck,
+	struct tegra_vse_priv_data *priv,
+	void *pbuf, int length, uint32_t node_id)
+{
+	int err;
+
+	if (!se_dev->host1x_pdev) {
+		dev_err(se_dev->dev, "host1x pdev not initialized\n");
+		return -ENODATA;
+	}
+
+	priv->done = NULL;
+	err = tegra_hv_vse_safety_send_ivc_pipelined(se_dev, pivck, priv,
+			pbuf, length, node_id);
+	if (err)
+		return err;
+
+	if (wait_for_completion_timeout(&priv->alg_complete,
+			TEGRA_HV_VSE_TIMEOUT) == 0) {
+		dev_err(se_dev->dev, "%s timeout\n", __func__);
+		/*
+		 * If the kthread already took the response it is about to
+		 * complete us; wait for it so priv is not freed under it.
+		 */
+		if (!tegra_hv_vse_safety_take_inflight(&g_crypto_to_ivc_map[node_id],
+				priv))
+			wait_for_completion(&priv->alg_complete);
+		return -ETIMEDOUT;
+	}
+
+	return tegra_hv_vse_safety_wait_syncpt(se_dev, priv);
+}
+
 static int tegra_hv_vse_safety_send_ivc_wait(
 	struct tegra_virtual_se_dev *se_dev,
 	struct tegra_hv_ivc_cookie *pivck,
@@ -808,6 +1029,10 @@ static int tegra_hv_vse_safety_send_ivc_wait(
 	u64 time_left;
 	enum ivc_irq_state *irq_state, local_irq_state;
 
+	if (g_crypto_to_ivc_map[node_id].queue_depth > 1U)
+		return tegra_hv_vse_safety_send_ivc_wait_pipelined(se_dev, pivck,
+				priv, pbuf, length, node_id);
+
 	mutex_lock(&g_crypto_to_ivc_map[node_id].se_ivc_lock);
 
 	if (!se_dev->host1x_pdev) {
@@ -1123,233 +1348,184 @@ exit:
 	return err;
 }
 
-static int tegra_hv_vse_safety_sha_fast_path(struct ahash_request *req,
-					bool is_last, bool process_cur_req)
+static int tegra_hv_vse_safety_sha_send_direct(struct ahash_request *req,
+				dma_addr_t addr, u32 nbytes)
 {
 	struct tegra_virtual_se_dev *se_dev = g_virtual_se_dev[VIRTUAL_SE_SHA];
-	u32 bytes_process_in_req = 0, num_blks;
 	struct tegra_virtual_se_ivc_msg_t *ivc_req_msg;
 	struct tegra_virtual_se_ivc_tx_msg_t *ivc_tx = NULL;
-	struct tegra_virtual_se_addr *src_addr = NULL;
 	struct tegra_virtual_se_req_context *req_ctx = ahash_request_ctx(req);
-	u32 num_mapped_sgs = 0;
-	u32 num_lists = 0;
-	struct scatterlist *sg;
 	int err = 0;
-	u32 nbytes_in_req = req->nbytes;
 
-	/* process_cur_req  is_last :
-	 *     false         false  : update()                   -> hash
-	 *     true          true   : finup(), digest()          -> hash
-	 *                   true   : finup(), digest(), final() -> result
-	 */
-	if ((process_cur_req == false && is_last == false) ||
-		(process_cur_req == true && is_last == true)) {
-		/* When calling update(), if req->nbytes is aligned with
-		 * req_ctx->blk_size, reduce req->nbytes with req_ctx->blk_size
-		 * to avoid hashing zero length input at the end.
-		 */
-		if (req_ctx->residual_bytes == req_ctx->blk_size) {
-			err = tegra_hv_vse_safety_sha_send_one(req,
-					req_ctx->residual_bytes, false);
-			if (err) {
-				dev_err(se_dev->dev,
-					"%s: failed to send residual data %u\n",
-					__func__, req_ctx->residual_bytes);
-				return err;
-			}
-			req_ctx->residual_bytes = 0;
-		}
+	ivc_req_msg = devm_kzalloc(se_dev->dev, sizeof(*ivc_req_msg),
+			GFP_KERNEL);
+	if (!ivc_req_msg)
+		return -ENOMEM;
 
-		num_blks = nbytes_in_req / req_ctx->blk_size;
-		req_ctx->residual_bytes =
-			nbytes_in_req - (num_blks * req_ctx->blk_size);
-
-		if (num_blks > 0 && req_ctx->residual_bytes == 0) {
-			/* blk_size aligned. reduce size with one blk and
-			 * handle it in the next call.
-			 */
-			req_ctx->residual_bytes = req_ctx->blk_size;
-			req_ctx->total_count += req_ctx->residual_bytes;
-			num_blks--;
-			sg_pcopy_to_buffer(req->src, (u32)sg_nents(req->src),
-				req_ctx->sha_buf, req_ctx->residual_bytes,
-				num_blks * req_ctx->blk_size);
-		} else {
-			/* not aligned at all */
-			req_ctx->total_count += req_ctx->residual_bytes;
-			sg_pcopy_to_buffer(req->src, (u32)sg_nents(req->src),
-				req_ctx->sha_buf, req_ctx->residual_bytes,
-				num_blks * req_ctx->blk_size);
-		}
-		nbytes_in_req -= req_ctx->residual_bytes;
-
-		dev_dbg(se_dev->dev, "%s: req_ctx->residual_bytes %u\n",
-			__func__, req_ctx->residual_bytes);
-
-		if (num_blks > 0) {
-			ivc_req_msg = devm_kzalloc(se_dev->dev,
-				sizeof(*ivc_req_msg), GFP_KERNEL);
-			if (!ivc_req_msg)
-				return -ENOMEM;
-
-			ivc_tx = &ivc_req_msg->tx[0];
-			src_addr = &ivc_tx->sha.op_hash.src_addr;
-
-			bytes_process_in_req = num_blks * req_ctx->blk_size;
-			dev_dbg(se_dev->dev, "%s: bytes_process_in_req %u\n",
-				__func__, bytes_process_in_req);
-
-			err = tegra_hv_vse_safety_prepare_ivc_linked_list(se_dev,
-					req->src, bytes_process_in_req,
-					(TEGRA_HV_VSE_SHA_MAX_LL_NUM_1 -
-						num_lists),
-					req_ctx->blk_size,
-					src_addr,
-					&num_lists,
-					DMA_TO_DEVICE, &num_mapped_sgs);
-			if (err) {
-				dev_err(se_dev->dev, "%s: ll error %d\n",
-					__func__, err);
-				goto unmap;
-			}
+	ivc_tx = &ivc_req_msg->tx[0];
+
+	ivc_tx->sha.op_hash.src_addr.lo = addr;
+	ivc_tx->sha.op_hash.src_addr.hi = nbytes;
+
+	ivc_tx->sha.op_hash.dst = (u64)req_ctx->hash_result_addr;
+	memcpy(ivc_tx->sha.op_hash.hash, req_ctx->hash_result,
+		req_ctx->intermediate_digest_size);
+	err = tegra_hv_vse_safety_send_sha_data(se_dev, req, ivc_req_msg,
+				nbytes, false);
+	if (err)
+		dev_err(se_dev->dev, "%s error %d\n", __func__, err);
+
+	devm_kfree(se_dev->dev, ivc_req_msg);
+	return err;
+}
+
+/*
+ * Hashes req->src on top of the residual_bytes already in sha_buf, leaving
+ * the last 1..blk_size bytes in sha_buf for final().
+ *
+ * req->src is DMA mapped as a whole, so that an IOMMU may merge its entries,
+ * and the block aligned part of every mapped segment of at least
+ * TEGRA_HV_VSE_SHA_MIN_DIRECT_SIZE bytes is hashed in place. Only the bytes
+ * that straddle a segment boundary and the short segments are copied to
+ * sha_buf, which is hashed whenever the next bytes go direct or it is full.
+ */
+static int tegra_hv_vse_safety_sha_update_sg(struct ahash_request *req)
+{
+	struct tegra_virtual_se_dev *se_dev = g_virtual_se_dev[VIRTUAL_SE_SHA];
+	struct tegra_virtual_se_req_context *req_ctx = ahash_request_ctx(req);
+	u32 blk_size = req_ctx->blk_size;
+	u32 buf_cap = rounddown(SZ_4M, blk_size);
+	u32 max_direct = rounddown(TEGRA_VIRTUAL_SE_MAX_BUFFER_SIZE - 1,
+				blk_size);
+	u32 buffered = req_ctx->residual_bytes;
+	u32 nbytes = req->nbytes;
+	u32 total, keep, left, pos = 0;
+	u32 seg_len, seg_off, len;
+	struct scatterlist *sg;
+	int nents, mapped, i;
+	int err = 0;
 
-			dev_dbg(se_dev->dev, "%s: num_lists %u\n",
-				__func__, num_lists);
+	/* bytes of sha_buf and req->src to hash now, a multiple of blk_size */
+	total = buffered + nbytes;
+	keep = total % blk_size;
+	if (keep == 0)
+		keep = blk_size;
+	left = total - keep;
 
-			ivc_tx->sha.op_hash.dst
-				= (u64)req_ctx->hash_result_addr;
-			memcpy(ivc_tx->sha.op_hash.hash,
-				req_ctx->hash_result,
-				req_ctx->intermediate_digest_size);
+	req_ctx->total_count += nbytes;
 
-			req_ctx->total_count += bytes_process_in_req;
+	if (left == 0)
+		goto save_tail;
 
-			err = tegra_hv_vse_safety_send_sha_data(se_dev, req,
-				ivc_req_msg, bytes_process_in_req, false);
-			if (err) {
-				dev_err(se_dev->dev, "%s error %d\n",
-					__func__, err);
-				goto unmap;
-			}
-unmap:
-			sg = req->src;
-			while (sg && num_mapped_sgs--) {
-				dma_unmap_sg(se_dev->dev, sg, 1, DMA_TO_DEVICE);
-				sg = sg_next(sg);
-			}
-			devm_kfree(se_dev->dev, ivc_req_msg);
-		}
+	nents = sg_nents_for_len(req->src, nbytes);
+	if (nents < 0)
+		return nents;
 
-		if (req_ctx->residual_bytes > 0 &&
-			req_ctx->residual_bytes < req_ctx->blk_size) {
-			/* At this point, the buffer is not aligned with
-			 * blk_size. Thus, buffer alignment need to be done via
-			 * slow path.
-			 */
-			req_ctx->force_align = true;
-		}
+	mapped = dma_map_sg(se_dev->dev, req->src, nents, DMA_TO_DEVICE);
+	if (!mapped) {
+		dev_err(se_dev->dev, "dma_map_sg() error\n");
+		return -EINVAL;
 	}
 
-	if (is_last) {
-		/* handle the last data in finup() , digest() */
-		if (req_ctx->residual_bytes > 0) {
-			err = tegra_hv_vse_safety_sha_send_one(req,
-					req_ctx->residual_bytes, true);
-			if (err) {
-				dev_err(se_dev->dev,
-					"%s: failed to send last data %u\n",
-					__func__, req_ctx->residual_bytes);
-				return err;
+	for_each_sg(req->src, sg, mapped, i) {
+		seg_len = sg_dma_len(sg);
+		seg_off = 0;
+
+		while (seg_off < seg_len && left > 0) {
+			len = seg_len - seg_off;
+
+			if (len >= TEGRA_HV_VSE_SHA_MIN_DIRECT_SIZE + blk_size ||
+				(buffered == 0 &&
+				 len >= TEGRA_HV_VSE_SHA_MIN_DIRECT_SIZE)) {
+				/* fill and flush the block in front of it */
+				if (buffered > 0) {
+					len = blk_size - (buffered % blk_size);
+					if (len == blk_size)
+						len = 0;
+					sg_pcopy_to_buffer(req->src, nents,
+						req_ctx->sha_buf + buffered,
+						len, pos);
+					buffered += len;
+					seg_off += len;
+					pos += len;
+
+					err = tegra_hv_vse_safety_sha_send_one(
+						req, buffered, false);
+					if (err)
+						goto unmap;
+					left -= buffered;
+					buffered = 0;
+					continue;
+				}
+
+				len = rounddown(min(len, left), blk_size);
+				len = min(len, max_direct);
+				err = tegra_hv_vse_safety_sha_send_direct(req,
+					sg_dma_address(sg) + seg_off, len);
+				if (err)
+					goto unmap;
+				left -= len;
+			} else {
+				len = min3(len, left - buffered,
+					buf_cap - buffered);
+				sg_pcopy_to_buffer(req->src, nents,
+					req_ctx->sha_buf + buffered, len, pos);
+				buffered += len;
+
+				if (buffered == left || buffered == buf_cap) {
+					err = tegra_hv_vse_safety_sha_send_one(
+						req, buffered, false);
+					if (err)
+						goto unmap;
+					left -= buffered;
+					buffered = 0;
+				}
 			}
-			req_ctx->residual_bytes = 0;
-		}
 
-		if (req->result) {
-			memcpy(req->result, req_ctx->hash_result,
-				req_ctx->digest_size);
-		} else {
-			dev_err(se_dev->dev, "Invalid clinet result buffer\n");
+			seg_off += len;
+			pos += len;
 		}
+
+		if (left == 0)
+			break;
 	}
 
-	return err;
+unmap:
+	dma_unmap_sg(se_dev->dev, req->src, nents, DMA_TO_DEVICE);
+	if (err) {
+		dev_err(se_dev->dev, "%s: failed to hash %u bytes\n",
+			__func__, nbytes);
+		return err;
+	}
+
+save_tail:
+	sg_pcopy_to_buffer(req->src, (u32)sg_nents(req->src),
+		req_ctx->sha_buf + buffered, nbytes - pos, pos);
+	req_ctx->residual_bytes = buffered + nbytes - pos;
+
+	dev_dbg(se_dev->dev, "%s: req_ctx->residual_bytes %u\n",
+		__func__, req_ctx->residual_bytes);
+
+	return 0;
 }
 
-static int tegra_hv_vse_safety_sha_slow_path(struct ahash_request *req,
+static int tegra_hv_vse_safety_sha_fast_path(struct ahash_request *req,
 					bool is_last, bool process_cur_req)
 {
 	struct tegra_virtual_se_dev *se_dev = g_virtual_se_dev[VIRTUAL_SE_SHA];
 	struct tegra_virtual_se_req_context *req_ctx = ahash_request_ctx(req);
-	u32 nblk_bytes = 0, num_blks, buflen = SZ_4M;
-	u32 length = 0, skip = 0, offset = 0;
-	u64 total_bytes = 0, left_bytes = 0;
 	int err = 0;
-	bool data_processed;
 
+	/* process_cur_req  is_last :
+	 *     false         false  : update()                   -> hash
+	 *     true          true   : finup(), digest()          -> hash
+	 *                   true   : finup(), digest(), final() -> result
+	 */
 	if ((process_cur_req == false && is_last == false) ||
 		(process_cur_req == true && is_last == true)) {
-
-		total_bytes = req_ctx->residual_bytes + req->nbytes;
-		num_blks = total_bytes / req_ctx->blk_size;
-		nblk_bytes = num_blks * req_ctx->blk_size;
-		offset = req_ctx->residual_bytes;
-
-		/* if blk_size aligned, reduce 1 blk_size for the last hash */
-		if ((total_bytes - nblk_bytes) == 0)
-			total_bytes -= req_ctx->blk_size;
-
-		left_bytes = req->nbytes;
-
-		data_processed = false;
-		while (total_bytes >= req_ctx->blk_size) {
-			/* Copy to linear buffer */
-			num_blks = total_bytes / req_ctx->blk_size;
-			nblk_bytes = num_blks * req_ctx->blk_size;
-			length = min(buflen, nblk_bytes) - offset;
-
-			sg_pcopy_to_buffer(req->src, (u32)sg_nents(req->src),
-				req_ctx->sha_buf + offset, length, skip);
-			skip += length;
-			req_ctx->total_count += length;
-
-			/* Hash */
-			err = tegra_hv_vse_safety_sha_send_one(req,
-						length + offset, false);
-			if (err) {
-				dev_err(se_dev->dev,
-					"%s: failed to send one %u\n",
-					__func__, length + offset);
-				return err;
-			}
-			total_bytes -= (length + offset);
-			left_bytes -= length;
-			offset = 0;
-			data_processed = true;
-		}
-
-		if (data_processed == true) {
-			/* Processed in while() loop */
-			sg_pcopy_to_buffer(req->src, (u32)sg_nents(req->src),
-					req_ctx->sha_buf, left_bytes, skip);
-			req_ctx->total_count += left_bytes;
-			req_ctx->residual_bytes = left_bytes;
-		} else {
-			/* Accumulate the request */
-			sg_pcopy_to_buffer(req->src, (u32)sg_nents(req->src),
-				req_ctx->sha_buf + req_ctx->residual_bytes,
-				req->nbytes, skip);
-			req_ctx->total_count += req->nbytes;
-			req_ctx->residual_bytes += req->nbytes;
-		}
-
-		if (req_ctx->force_align == true &&
-			req_ctx->residual_bytes == req_ctx->blk_size) {
-			/* At this point, the buffer is aligned with blk_size.
-			 * Thus, the next call can use fast path.
-			 */
-			req_ctx->force_align = false;
-		}
+		err = tegra_hv_vse_safety_sha_update_sg(req);
+		if (err)
+			return err;
 	}
 
 	if (is_last) {
@@ -1359,7 +1535,7 @@ static int tegra_hv_vse_safety_sha_slow_path(struct ahash_request *req,
 					req_ctx->residual_bytes, true);
 			if (err) {
 				dev_err(se_dev->dev,
-					"%s: failed to send last data%u\n",
+					"%s: failed to send last data %u\n",
 					__func__, req_ctx->residual_bytes);
 				return err;
 			}
@@ -1383,7 +1559,6 @@ static int tegra_hv_vse_safety_sha_op(struct ahash_request *req, bool is_last,
 	struct tegra_virtual_se_dev *se_dev = g_virtual_se_dev[VIRTUAL_SE_SHA];
 	struct tegra_virtual_se_req_context *req_ctx = ahash_request_ctx(req);
 	u32 mode;
-	u32 num_blks;
 	int ret;
 	struct sha_zero_length_vector zero_vec[] = {
 		{
@@ -1536,17 +1711,7 @@ static int tegra_hv_vse_safety_sha_op(struct ahash_request *req, bool is_last,
 		return 0;
 	}
 
-	num_blks = req->nbytes / req_ctx->blk_size;
-
-	if (sg_nents(req->src) > 1)
-		req_ctx->force_align = true;
-
-	if (req_ctx->force_align == false && num_blks > 0)
-		ret = tegra_hv_vse_safety_sha_fast_path(req, is_last, process_cur_req);
-	else
-		ret = tegra_hv_vse_safety_sha_slow_path(req, is_last, process_cur_req);
-
-	return ret;
+	return tegra_hv_vse_safety_sha_fast_path(req, is_last, process_cur_req);
 }
 
 static int tegra_hv_vse_safety_sha_init(struct ahash_request *req)
@@ -1664,7 +1829,6 @@ static int tegra_hv_vse_safety_sha_init(struct ahash_request *req)
 	req_ctx->is_first = true;
 	req_ctx->residual_bytes = 0;
 	req_ctx->req_context_initialized = true;
-	req_ctx->force_align = false;
 
 	return 0;
 }
@@ -1927,6 +2091,56 @@ static int tegra_hv_vse_safety_aes_gen_random_iv(
 	return err;
 }
 
+static int tegra_hv_vse_safety_aes_copy_result(struct tegra_vse_priv_data *priv)
+{
+	struct skcipher_request *req = priv->req;
+	struct tegra_virtual_se_aes_req_context *req_ctx = skcipher_request_ctx(req);
+	struct tegra_virtual_se_aes_context *aes_ctx =
+		crypto_skcipher_ctx(crypto_skcipher_reqtfm(req));
+	int num_sgs;
+
+	if (priv->rx_status == 0U) {
+		dma_sync_single_for_cpu(priv->se_dev->dev, priv->buf_addr,
+			req->cryptlen, DMA_BIDIRECTIONAL);
+
+		num_sgs = tegra_hv_vse_safety_count_sgs(req->dst, req->cryptlen);
+		if (num_sgs == 1)
+			memcpy(sg_virt(req->dst), priv->buf, req->cryptlen);
+		else
+			sg_copy_from_buffer(req->dst, num_sgs,
+					priv->buf, req->cryptlen);
+
+		if (((req_ctx->op_mode == AES_CBC)
+				|| (req_ctx->op_mode == AES_CTR))
+				&& req_ctx->encrypt == true && aes_ctx->user_nonce == 0U)
+			memcpy(req->iv, priv->iv, TEGRA_VIRTUAL_SE_AES_IV_SIZE);
+	} else {
+		dev_err(priv->se_dev->dev,
+				"%s: SE server returned error %u\n",
+				__func__, priv->rx_status);
+	}
+
+	return status_to_errno(priv->rx_status);
+}
+
+/* Completion of an AES request sent on a pipelined channel */
+static void tegra_hv_vse_safety_aes_done(struct tegra_vse_priv_data *priv)
+{
+	struct skcipher_request *req = priv->req;
+	struct tegra_virtual_se_dev *se_dev = priv->se_dev;
+	int err;
+
+	err = tegra_hv_vse_safety_wait_syncpt(se_dev, priv);
+	if (!err)
+		err = tegra_hv_vse_safety_aes_copy_result(priv);
+
+	dma_unmap_sg(se_dev->dev, &priv->sg, 1, DMA_BIDIRECTIONAL);
+	kfree(priv->buf);
+	devm_kfree(se_dev->dev, priv);
+
+	skcipher_request_complete(req, err);
+}
+
 static int tegra_hv_vse_safety_process_aes_req(struct tegra_virtual_se_dev *se_dev,
 		struct skcipher_request *req)
 {
@@ -2030,6 +2244,19 @@ static int tegra_hv_vse_safety_process_aes_req(struct tegra_virtual_se_dev *se_d
 
 	init_completion(&priv->alg_complete);
 
+	if (g_crypto_to_ivc_map[aes_ctx->node_id].queue_depth > 1U) {
+		/* the response completes the request from the kthread */
+		priv->done = tegra_hv_vse_safety_aes_done;
+		err = tegra_hv_vse_safety_send_ivc_pipelined(se_dev, pivck, priv,
+				ivc_req_msg, sizeof(struct tegra_virtual_se_ivc_msg_t),
+				aes_ctx->node_id);
+		if (err)
+			goto exit;
+
+		devm_kfree(se_dev->dev, ivc_req_msg);
+		return -EINPROGRESS;
+	}
+
 	err = tegra_hv_vse_safety_send_ivc_wait(se_dev, pivck, priv, ivc_req_msg,
 			sizeof(struct tegra_virtual_se_ivc_msg_t), aes_ctx->node_id);
 	if (err) {
@@ -2037,28 +2264,7 @@ static int tegra_hv_vse_safety_process_aes_req(struct tegra_virtual_se_dev *se_d
 		goto exit;
 	}
 
-	if (priv->rx_status == 0U) {
-		dma_sync_single_for_cpu(priv->se_dev->dev, priv->buf_addr,
-			req->cryptlen, DMA_BIDIRECTIONAL);
-
-		num_sgs = tegra_hv_vse_safety_count_sgs(req->dst, req->cryptlen);
-		if (num_sgs == 1)
-			memcpy(sg_virt(req->dst), priv->buf, req->cryptlen);
-		else
-			sg_copy_from_buffer(req->dst, num_sgs,
-					priv->buf, req->cryptlen);
-
-		if (((req_ctx->op_mode == AES_CBC)
-				|| (req_ctx->op_mode == AES_CTR))
-				&& req_ctx->encrypt == true && aes_ctx->user_nonce == 0U)
-			memcpy(req->iv, priv->iv, TEGRA_VIRTUAL_SE_AES_IV_SIZE);
-	} else {
-		dev_err(se_dev->dev,
-				"%s: SE server returned error %u\n",
-				__func__, priv->rx_status);
-	}
-
-	err = status_to_errno(priv->rx_status);
+	err = tegra_hv_vse_safety_aes_copy_result(priv);
 
 exit:
 	if (dma_ents > 0)
@@ -2114,7 +2320,7 @@ static int tegra_hv_vse_safety_aes_cbc_encrypt(struct skcipher_request *req)
 	req_ctx->engine_id = g_crypto_to_ivc_map[aes_ctx->node_id].se_engine;
 	req_ctx->se_dev = g_virtual_se_dev[g_crypto_to_ivc_map[aes_ctx->node_id].se_engine];
 	err = tegra_hv_vse_safety_process_aes_req(req_ctx->se_dev, req);
-	if (err)
+	if (err && err != -EINPROGRESS)
 		dev_err(req_ctx->se_dev->dev,
 				"%s failed with error %d\n", __func__, err);
 	return err;
@@ -2138,7 +2344,7 @@ static int tegra_hv_vse_safety_aes_cbc_decrypt(struct skcipher_request *req)
 	req_ctx->engine_id = g_crypto_to_ivc_map[aes_ctx->node_id].se_engine;
 	req_ctx->se_dev = g_virtual_se_dev[g_crypto_to_ivc_map[aes_ctx->node_id].se_engine];
 	err = tegra_hv_vse_safety_process_aes_req(req_ctx->se_dev, req);
-	if (err)
+	if (err && err != -EINPROGRESS)
 		dev_err(req_ctx->se_dev->dev,
 				"%s failed with error %d\n", __func__, err);
 	return err;
@@ -2162,7 +2368,7 @@ static int tegra_hv_vse_safety_aes_ecb_encrypt(struct skcipher_request *req)
 	req_ctx->engine_id = g_crypto_to_ivc_map[aes_ctx->node_id].se_engine;
 	req_ctx->se_dev = g_virtual_se_dev[g_crypto_to_ivc_map[aes_ctx->node_id].se_engine];
 	err = tegra_hv_vse_safety_process_aes_req(req_ctx->se_dev, req);
-	if (err)
+	if (err && err != -EINPROGRESS)
 		dev_err(req_ctx->se_dev->dev,
 				"%s failed with error %d\n", __func__, err);
 	return err;
@@ -2186,7 +2392,7 @@ static int tegra_hv_vse_safety_aes_ecb_decrypt(struct skcipher_request *req)
 	req_ctx->engine_id = g_crypto_to_ivc_map[aes_ctx->node_id].se_engine;
 	req_ctx->se_dev = g_virtual_se_dev[g_crypto_to_ivc_map[aes_ctx->node_id].se_engine];
 	err = tegra_hv_vse_safety_process_aes_req(req_ctx->se_dev, req);
-	if (err)
+	if (err && err != -EINPROGRESS)
 		dev_err(req_ctx->se_dev->dev,
 				"%s failed with error %d\n", __func__, err);
 	return err;
@@ -2217,7 +2423,7 @@ static int tegra_hv_vse_safety_aes_ctr_encrypt(struct skcipher_request *req)
 	req_ctx->engine_id = g_crypto_to_ivc_map[aes_ctx->node_id].se_engine;
 	req_ctx->se_dev = g_virtual_se_dev[g_crypto_to_ivc_map[aes_ctx->node_id].se_engine];
 	err = tegra_hv_vse_safety_process_aes_req(req_ctx->se_dev, req);
-	if (err)
+	if (err && err != -EINPROGRESS)
 		dev_err(req_ctx->se_dev->dev,
 				"%s failed with error %d\n", __func__, err);
 	return err;
@@ -2241,7 +2447,7 @@ static int tegra_hv_vse_safety_aes_ctr_decrypt(struct skcipher_request *req)
 	req_ctx->engine_id = g_crypto_to_ivc_map[aes_ctx->node_id].se_engine;
 	req_ctx->se_dev = g_virtual_se_dev[g_crypto_to_ivc_map[aes_ctx->node_id].se_engine];
 	err = tegra_hv_vse_safety_process_aes_req(req_ctx->se_dev, req);
-	if (err)
+	if (err && err != -EINPROGRESS)
 		dev_err(req_ctx->se_dev->dev,
 				"%s failed with error %d\n", __func__, err);
 	return err;
@@ -3285,7 +3491,7 @@ static int tegra_hv_vse_safety_get_random(struct tegra_virtual_se_rng_context *r
 exit:
 	devm_kfree(se_dev->dev, priv);
 	devm_kfree(se_dev->dev, ivc_req_msg);
-	return dlen;
+	return err ? err : dlen;
 }
 
 static int tegra_hv_vse_safety_rng_drbg_get_random(struct crypto_rng *tfm,
@@ -4633,6 +4839,50 @@ static irqreturn_t tegra_vse_irq_handler(int irq, void *data)
 	return IRQ_HANDLED;
 }
 
+/* Read every pending response of a pipelined channel and complete it */
+static void tegra_vse_dispatch_responses(struct tegra_virtual_se_dev *se_dev,
+	struct tegra_hv_ivc_cookie *pivck, uint32_t node_id,
+	struct tegra_virtual_se_ivc_msg_t *ivc_msg)
+{
+	struct crypto_dev_to_ivc_map *ivc_map = &g_crypto_to_ivc_map[node_id];
+	size_t size_ivc_msg = sizeof(struct tegra_virtual_se_ivc_msg_t);
+	struct tegra_vse_priv_data *priv;
+	struct tegra_vse_tag *p_dat;
+	bool is_dummy = false;
+	int read_size;
+
+	while (tegra_hv_ivc_can_read(pivck)) {
+		read_size = tegra_hv_ivc_read(pivck, ivc_msg, size_ivc_msg);
+		if (read_size < 0)
+			break;
+		if (read_size < size_ivc_msg) {
+			dev_err(se_dev->dev, "Wrong read msg len %d\n", read_size);
+			continue;
+		}
+
+		/* fillers carry no response in pipelined mode */
+		if (validate_header(se_dev, &ivc_msg->ivc_hdr, &is_dummy) != 0 ||
+				is_dummy)
+			continue;
+
+		p_dat = (struct tegra_vse_tag *)ivc_msg->ivc_hdr.tag;
+		priv = tegra_hv_vse_safety_take_inflight(ivc_map, p_dat->priv_data);
+		if (!priv) {
+			dev_err(se_dev->dev, "%s: response with unknown tag\n",
+				__func__);
+			continue;
+		}
+
+		if (!tegra_hv_vse_safety_parse_resp(se_dev, priv, ivc_msg))
+			priv->rx_status = 1U; /* VSE_MSG_ERR_INVALID_CMD */
+
+		if (priv->done)
+			priv->done(priv);
+		else
+			complete(&priv->alg_complete);
+	}
+}
+
 static int tegra_vse_kthread(void *data)
 {
 	uint32_t node_id = *((uint32_t *)data);
@@ -4685,6 +4935,11 @@ static int tegra_vse_kthread(void *data)
 			continue;
 		}
 
+		if (g_crypto_to_ivc_map[node_id].queue_depth > 1U) {
+			tegra_vse_dispatch_responses(se_dev, pivck, node_id, ivc_msg);
+			continue;
+		}
+
 		mutex_lock(&(se_dev->crypto_to_ivc_map[node_id].irq_state_lock));
 		irq_state = &(se_dev->crypto_to_ivc_map[node_id].wait_interrupt);
 		local_irq_state = *irq_state;
@@ -4742,15 +4997,227 @@ static int tegra_vse_kthread(void *data)
 }
 
 #if defined(CONFIG_HW_RANDOM)
+/* Bytes requested from the SE server per refill step */
+#define TEGRA_VSE_RNG_POOL_CHUNK	256U
+
+struct tegra_vse_rng_pool {
+	struct tegra_virtual_se_dev *se_dev;
+	struct tegra_virtual_se_rng_context *rng_ctx;
+	/* Serialises users of rng_ctx->rng_buf, the worker and direct reads */
+	struct mutex fill_lock;
+	struct work_struct refill_work;
+	/* Ring of random bytes, protected by lock */
+	spinlock_t lock;
+	u8 *buf;
+	u32 size;
+	u32 head;
+	u32 count;
+	u32 low_wm;
+	u32 high_wm;
+	u8 *chunk;
+	bool stopped;
+	/* Statistics, protected by lock */
+	u64 served_bytes;
+	u64 direct_bytes;
+	u64 refill_bytes;
+	u64 refills;
+	u64 underruns;
+	u64 refill_errors;
+	struct dentry *debugfs;
+};
+
+static u32 tegra_vse_rng_pool_take(struct tegra_vse_rng_pool *pool, u8 *dst, u32 len)
+{
+	u32 n, first, tail;
+
+	spin_lock(&pool->lock);
+	n = min(len, pool->count);
+	tail = (pool->head + pool->size - pool->count) % pool->size;
+	first = min(n, pool->size - tail);
+	memcpy(dst, pool->buf + tail, first);
+	memcpy(dst + first, pool->buf, n - first);
+	/* Never hand out the same bytes twice */
+	memzero_explicit(pool->buf + tail, first);
+	memzero_explicit(pool->buf, n - first);
+	pool->count -= n;
+	pool->served_bytes += n;
+	spin_unlock(&pool->lock);
+
+	return n;
+}
+
+static void tegra_vse_rng_pool_put(struct tegra_vse_rng_pool *pool, const u8 *src, u32 len)
+{
+	u32 first;
+
+	spin_lock(&pool->lock);
+	len = min(len, pool->size - pool->count);
+	first = min(len, pool->size - pool->head);
+	memcpy(pool->buf + pool->head, src, first);
+	memcpy(pool->buf, src + first, len - first);
+	pool->head = (pool->head + len) % pool->size;
+	pool->count += len;
+	pool->refill_bytes += len;
+	spin_unlock(&pool->lock);
+}
+
+static void tegra_vse_rng_pool_refill(struct work_struct *work)
+{
+	struct tegra_vse_rng_pool *pool =
+		container_of(work, struct tegra_vse_rng_pool, refill_work);
+	u32 space;
+	int ret;
+
+	spin_lock(&pool->lock);
+	pool->refills++;
+	spin_unlock(&pool->lock);
+
+	for (;;) {
+		spin_lock(&pool->lock);
+		space = (pool->count < pool->high_wm) ? pool->high_wm - pool->count : 0U;
+		spin_unlock(&pool->lock);
+
+		if (space == 0U || READ_ONCE(pool->stopped) ||
+				atomic_read(&pool->se_dev->se_suspended))
+			break;
+
+		space = min(space, TEGRA_VSE_RNG_POOL_CHUNK);
+
+		mutex_lock(&pool->fill_lock);
+		ret = tegra_hv_vse_safety_get_random(pool->rng_ctx, pool->chunk, space);
+		if (ret > 0)
+			tegra_vse_rng_pool_put(pool, pool->chunk, ret);
+		memzero_explicit(pool->chunk, space);
+		mutex_unlock(&pool->fill_lock);
+
+		if (ret <= 0) {
+			spin_lock(&pool->lock);
+			pool->refill_errors++;
+			spin_unlock(&pool->lock);
+			break;
+		}
+	}
+}
+
+static int tegra_vse_rng_pool_show(struct seq_file *s, void *data)
+{
+	struct tegra_vse_rng_pool *pool = s->private;
+
+	spin_lock(&pool->lock);
+	seq_printf(s, "size: %u\nlow_wm: %u\nhigh_wm: %u\navailable: %u\n",
+		   pool->size, pool->low_wm, pool->high_wm, pool->count);
+	seq_printf(s, "served_bytes: %llu\ndirect_bytes: %llu\nrefill_bytes: %llu\n",
+		   pool->served_bytes, pool->direct_bytes, pool->refill_bytes);
+	seq_printf(s, "refills: %llu\nunderruns: %llu\nrefill_errors: %llu\n",
+		   pool->refills, pool->underruns, pool->refill_errors);
+	spin_unlock(&pool->lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(tegra_vse_rng_pool);
+
+static void tegra_vse_rng_pool_init(struct tegra_virtual_se_dev *se_dev,
+		struct tegra_virtual_se_rng_context *rng_ctx)
+{
+	struct tegra_vse_rng_pool *pool;
+
+	if (rng_pool_size == 0U)
+		return;
+
+	pool = devm_kzalloc(se_dev->dev, sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		goto fail;
+
+	pool->buf = devm_kzalloc(se_dev->dev, rng_pool_size, GFP_KERNEL);
+	pool->chunk = devm_kzalloc(se_dev->dev, TEGRA_VSE_RNG_POOL_CHUNK, GFP_KERNEL);
+	if (!pool->buf || !pool->chunk)
+		goto fail;
+
+	pool->se_dev = se_dev;
+	pool->rng_ctx = rng_ctx;
+	pool->size = rng_pool_size;
+	pool->high_wm = rng_pool_high_wm ? min(rng_pool_high_wm, pool->size) : pool->size;
+	pool->low_wm = rng_pool_low_wm ? rng_pool_low_wm : pool->size / 4U;
+	if (pool->low_wm >= pool->high_wm)
+		pool->low_wm = pool->high_wm / 2U;
+	mutex_init(&pool->fill_lock);
+	spin_lock_init(&pool->lock);
+	INIT_WORK(&pool->refill_work, tegra_vse_rng_pool_refill);
+
+	pool->debugfs = debugfs_create_dir(dev_name(se_dev->dev), NULL);
+	debugfs_create_file("rng_pool", 0400, pool->debugfs, pool,
+			    &tegra_vse_rng_pool_fops);
+
+	se_dev->rng_pool = pool;
+	schedule_work(&pool->refill_work);
+	return;
+
+fail:
+	/* Without the pool every read goes to the SE server as before */
+	dev_warn(se_dev->dev, "hwrng pool disabled, allocation failed\n");
+	if (pool) {
+		devm_kfree(se_dev->dev, pool->buf);
+		devm_kfree(se_dev->dev, pool->chunk);
+		devm_kfree(se_dev->dev, pool);
+	}
+}
+
+static void tegra_vse_rng_pool_deinit(struct tegra_virtual_se_dev *se_dev)
+{
+	struct tegra_vse_rng_pool *pool = se_dev->rng_pool;
+
+	if (!pool)
+		return;
+
+	WRITE_ONCE(pool->stopped, true);
+	cancel_work_sync(&pool->refill_work);
+	debugfs_remove_recursive(pool->debugfs);
+
+	memzero_explicit(pool->buf, pool->size);
+	devm_kfree(se_dev->dev, pool->buf);
+	devm_kfree(se_dev->dev, pool->chunk);
+	devm_kfree(se_dev->dev, pool);
+	se_dev->rng_pool = NULL;
+}
+
 static int tegra_hv_vse_safety_hwrng_read(struct hwrng *rng, void *buf, size_t size, bool wait)
 {
 	struct tegra_virtual_se_rng_context *ctx;
-
-	if (!wait)
-		return 0;
+	struct tegra_vse_rng_pool *pool;
+	u32 len = min_t(size_t, size, U32_MAX);
+	u32 n;
+	int ret;
 
 	ctx = (struct tegra_virtual_se_rng_context *)rng->priv;
-	return tegra_hv_vse_safety_get_random(ctx, buf, size);
+	pool = ctx->se_dev->rng_pool;
+
+	if (!pool) {
+		if (!wait)
+			return 0;
+
+		return tegra_hv_vse_safety_get_random(ctx, buf, size);
+	}
+
+	n = tegra_vse_rng_pool_take(pool, buf, len);
+
+	if (READ_ONCE(pool->count) < pool->low_wm)
+		schedule_work(&pool->refill_work);
+
+	if (n || !wait)
+		return n;
+
+	/* Pool drained, serve this read straight from the SE server */
+	mutex_lock(&pool->fill_lock);
+	ret = tegra_hv_vse_safety_get_random(ctx, buf, len);
+	mutex_unlock(&pool->fill_lock);
+
+	spin_lock(&pool->lock);
+	pool->underruns++;
+	if (ret > 0)
+		pool->direct_bytes += ret;
+	spin_unlock(&pool->lock);
+
+	return ret;
 }
 #endif /* CONFIG_HW_RANDOM */
 
@@ -4787,7 +5254,12 @@ static int tegra_hv_vse_safety_register_hwrng(struct tegra_virtual_se_dev *se_de
 	vse_hwrng->quality = 1024;
 	vse_hwrng->priv = (unsigned long)rng_ctx;
 
+	/* Set up before registering, the hwrng core may read right away */
+	tegra_vse_rng_pool_init(se_dev, rng_ctx);
+
 	ret = devm_hwrng_register(se_dev->dev, vse_hwrng);
+	if (ret)
+		tegra_vse_rng_pool_deinit(se_dev);
 out:
 	if (ret) {
 		if (rng_ctx) {
@@ -4814,6 +5286,7 @@ static void tegra_hv_vse_safety_unregister_hwrng(struct tegra_virtual_se_dev *se
 
 	if (se_dev->hwrng) {
 		devm_hwrng_unregister(se_dev->dev, se_dev->hwrng);
+		tegra_vse_rng_pool_deinit(se_dev);
 		rng_ctx = (struct tegra_virtual_se_rng_context *)se_dev->hwrng->priv;
 
 		dma_free_coherent(se_dev->dev, TEGRA_VIRTUAL_SE_RNG_DT_SIZE,
@@ -5019,6 +5492,11 @@ static int tegra_hv_vse_safety_probe(struct platform_device *pdev)
 		init_completion(&crypto_dev->tegra_vse_complete);
 		mutex_init(&crypto_dev->se_ivc_lock);
 		mutex_init(&crypto_dev->irq_state_lock);
+		crypto_dev->queue_depth = max(ivc_queue_depth, 1U);
+		spin_lock_init(&crypto_dev->inflight_lock);
+		INIT_LIST_HEAD(&crypto_dev->inflight);
+		crypto_dev->inflight_cnt = 0;
+		init_waitqueue_head(&crypto_dev->inflight_wq);
 
 		crypto_dev->tegra_vse_task = kthread_run(tegra_vse_kthread, &crypto_dev->node_id,
 								"tegra_vse_kthread-%u", node_id);
@@ -5156,7 +5634,8 @@ static void tegra_hv_vse_safety_shutdown(struct platform_device *pdev)
 				&& g_crypto_to_ivc_map[cnt].ivck != NULL) {
 			/* Wait for  SE server to be free*/
 			while (mutex_is_locked(&g_crypto_to_ivc_map[cnt].se_ivc_lock)
-				|| mutex_is_locked(&g_crypto_to_ivc_map[cnt].irq_state_lock))
+				|| mutex_is_locked(&g_crypto_to_ivc_map[cnt].irq_state_lock)
+				|| READ_ONCE(g_crypto_to_ivc_map[cnt].inflight_cnt) != 0U)
 				usleep_range(8, 10);
 		}
 	}
@@ -47,8 +47,20 @@ struct crypto_dev_to_ivc_map {
 	 */
 	enum ivc_irq_state wait_interrupt;
 	struct mutex irq_state_lock;
+	/*
+	 * Number of requests that may be outstanding on the channel. With more
+	 * than one, responses are matched by tag against the inflight list,
+	 * which inflight_lock protects together with inflight_cnt.
+	 */
+	uint32_t queue_depth;
+	spinlock_t inflight_lock;
+	struct list_head inflight;
+	uint32_t inflight_cnt;
+	wait_queue_head_t inflight_wq;
 };
 
+struct tegra_vse_rng_pool;
+
 struct tegra_virtual_se_dev {
 	struct device *dev;
 	/* Engine id */
@@ -59,6 +71,8 @@ struct tegra_virtual_se_dev {
 #if defined(CONFIG_HW_RANDOM)
 	/* Integration with hwrng framework */
 	struct hwrng *hwrng;
+	/* Buffered pool serving hwrng reads, NULL when disabled */
+	struct tegra_vse_rng_pool *rng_pool;
 #endif /* CONFIG_HW_RANDOM */
 	struct platform_device *host1x_pdev;
 	struct crypto_dev_to_ivc_map *crypto_to_ivc_map;
@@ -156,7 +170,6 @@ struct tegra_virtual_se_req_context {
 	u32 blk_size;			/* SHA block size */
 	bool is_first;			/* Represents first block */
 	bool req_context_initialized;	/* Mark initialization status */
-	bool force_align;		/* Enforce buffer alignment */
 	/*Crypto dev instance*/
 	uint32_t node_id;
 };
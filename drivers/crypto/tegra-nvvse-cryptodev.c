@@ -16,6 +16,7 @@
 #include <linux/scatterlist.h>
 #include <linux/uaccess.h>
 #include <linux/nospec.h>
+#include <linux/mm.h>
 #include <linux/mutex.h>
 #include <linux/version.h>
 #include <linux/string.h>
@@ -69,6 +70,12 @@
 
 #define MISC_DEVICE_NAME_LEN		32U
 
+/**
+ * AES requests of at least this size work on pinned user pages instead of
+ * kernel bounce buffers, smaller ones are cheaper to copy than to pin
+ */
+#define NVVSE_ZERO_COPY_MIN_LEN		(64U * 1024U)
+
 struct nvvse_devnode {
 	struct miscdevice *g_misc_devices;
 	bool sha_init_done;
@@ -93,6 +100,14 @@ struct tnvvse_crypto_completion {
 	int req_err;
 };
 
+/* User buffer pinned for the duration of one request */
+struct tnvvse_user_sg {
+	struct page		**pages;
+	uint32_t		nr_pages;
+	bool			write;
+	struct sg_table		sgt;
+};
+
 struct crypto_sha_state {
 	uint32_t			sha_type;
 	uint32_t			digest_size;
@@ -296,6 +311,99 @@ static int tnvvse_crypt_copy_kern_buf(uint32_t user_buf_sz, uint8_t *user_buf,
 	return 0;
 }
 
+static int tnvvse_crypt_pin_user_buf(struct tnvvse_user_sg *usg, uint8_t *user_buf,
+		uint32_t size, bool write)
+{
+	unsigned long start = (unsigned long)user_buf;
+	uint32_t offset = offset_in_page(start);
+	int pinned, ret;
+
+	memset(usg, 0, sizeof(*usg));
+	usg->write = write;
+	if (size == 0U)
+		return 0;
+
+	usg->nr_pages = DIV_ROUND_UP(offset + size, PAGE_SIZE);
+	usg->pages = kvmalloc_array(usg->nr_pages, sizeof(*usg->pages), GFP_KERNEL);
+	if (!usg->pages)
+		return -ENOMEM;
+
+	pinned = pin_user_pages_fast(start & PAGE_MASK, usg->nr_pages,
+			write ? FOLL_WRITE : 0, usg->pages);
+	if (pinned != (int)usg->nr_pages) {
+		if (pinned > 0)
+			unpin_user_pages(usg->pages, pinned);
+		ret = (pinned < 0) ? pinned : -EFAULT;
+		goto free_pages;
+	}
+
+	ret = sg_alloc_table_from_pages(&usg->sgt, usg->pages, usg->nr_pages,
+			offset, size, GFP_KERNEL);
+	if (ret) {
+		unpin_user_pages(usg->pages, usg->nr_pages);
+		goto free_pages;
+	}
+
+	return 0;
+
+free_pages:
+	kvfree(usg->pages);
+	usg->pages = NULL;
+	usg->nr_pages = 0U;
+	return ret;
+}
+
+static void tnvvse_crypt_unpin_user_buf(struct tnvvse_user_sg *usg)
+{
+	if (!usg->pages)
+		return;
+
+	sg_free_table(&usg->sgt);
+	unpin_user_pages_dirty_lock(usg->pages, usg->nr_pages, usg->write);
+	kvfree(usg->pages);
+	usg->pages = NULL;
+	usg->nr_pages = 0U;
+}
+
+/* Copy the entries of the pinned buffers, plus an optional kernel tail, into sgt */
+static int tnvvse_crypt_concat_sg(struct sg_table *sgt, struct tnvvse_user_sg *head,
+		struct tnvvse_user_sg *body, uint8_t *tail, uint32_t tail_len)
+{
+	struct tnvvse_user_sg *parts[2] = { head, body };
+	struct scatterlist *sg, *src;
+	uint32_t nents = (tail_len != 0U) ? 1U : 0U;
+	uint32_t i, j;
+	int ret;
+
+	for (i = 0U; i < 2U; i++) {
+		if (parts[i]->pages)
+			nents += parts[i]->sgt.nents;
+	}
+
+	if (nents == 0U)
+		return -EINVAL;
+
+	ret = sg_alloc_table(sgt, nents, GFP_KERNEL);
+	if (ret)
+		return ret;
+
+	sg = sgt->sgl;
+	for (i = 0U; i < 2U; i++) {
+		if (!parts[i]->pages)
+			continue;
+
+		for_each_sg(parts[i]->sgt.sgl, src, parts[i]->sgt.nents, j) {
+			sg_set_page(sg, sg_page(src), src->length, src->offset);
+			sg = sg_next(sg);
+		}
+	}
+
+	if (tail_len != 0U)
+		sg_set_buf(sg, tail, tail_len);
+
+	return 0;
+}
+
 static int wait_async_op(struct tnvvse_crypto_completion *tr, int ret)
 {
 	if (ret == -EINPROGRESS || ret == -EBUSY) {
@@ -875,6 +983,276 @@ free_result:
 	return ret;
 }
 
+/* Batch request state, transforms are allocated on first use and reused across jobs */
+struct tnvvse_batch_state {
+	struct crypto_ahash		*sha_tfm[TEGRA_NVVSE_SHA_TYPE_MAX];
+	struct crypto_ahash		*cmac_tfm;
+	struct tnvvse_crypto_completion	complete;
+	struct sg_table			in_sgt;
+	uint8_t				*in_buf[NVVSE_MAX_CHUNKS];
+	uint32_t			in_sz;
+	char				*result;
+};
+
+static int tnvvse_crypto_batch_check_job(struct tnvvse_crypto_ctx *ctx,
+		struct tegra_nvvse_batch_job *job)
+{
+	if (job->job_type >= TEGRA_NVVSE_BATCH_JOB_MAX)
+		return -EINVAL;
+
+	if (job->data_length > ivc_database.max_buffer_size[ctx->node_id])
+		return -EINVAL;
+
+	if (job->job_type != TEGRA_NVVSE_BATCH_JOB_SHA)
+		return (job->data_length == 0U) ? -EINVAL : 0;
+
+	if (job->sha_type < TEGRA_NVVSE_SHA_TYPE_SHA256 ||
+			job->sha_type >= TEGRA_NVVSE_SHA_TYPE_MAX)
+		return -EINVAL;
+
+	if ((job->sha_type == TEGRA_NVVSE_SHA_TYPE_SHAKE128 ||
+	     job->sha_type == TEGRA_NVVSE_SHA_TYPE_SHAKE256) &&
+	    (job->digest_size == 0U ||
+	     job->digest_size > NVVSE_MAX_ALLOCATED_SHA_RESULT_BUFF_SIZE))
+		return -EINVAL;
+
+	/* A streaming SHA owns the SHA context of this node */
+	if (nvvse_devnode[ctx->node_id].sha_init_done)
+		return -EAGAIN;
+
+	return 0;
+}
+
+static struct crypto_ahash *tnvvse_crypto_batch_get_tfm(struct tnvvse_crypto_ctx *ctx,
+		struct tnvvse_batch_state *st, struct tegra_nvvse_batch_job *job)
+{
+	struct tegra_virtual_se_aes_cmac_context *cmac_ctx;
+	struct tegra_virtual_se_sha_context *sha_ctx;
+	struct crypto_ahash **slot;
+	const char *alg_name;
+
+	if (job->job_type == TEGRA_NVVSE_BATCH_JOB_SHA) {
+		slot = &st->sha_tfm[job->sha_type];
+		alg_name = sha_alg_names[job->sha_type];
+	} else {
+		slot = &st->cmac_tfm;
+		alg_name = "cmac-vse(aes)";
+	}
+
+	if (*slot)
+		return *slot;
+
+	*slot = crypto_alloc_ahash(alg_name, 0, 0);
+	if (IS_ERR(*slot)) {
+		struct crypto_ahash *err = *slot;
+
+		pr_err("%s(): Failed to allocate ahash for %s: %ld\n",
+				__func__, alg_name, PTR_ERR(err));
+		*slot = NULL;
+		return err;
+	}
+
+	if (job->job_type == TEGRA_NVVSE_BATCH_JOB_SHA) {
+		sha_ctx = crypto_ahash_ctx(*slot);
+		sha_ctx->node_id = ctx->node_id;
+	} else {
+		cmac_ctx = crypto_ahash_ctx(*slot);
+		cmac_ctx->node_id = ctx->node_id;
+	}
+
+	return *slot;
+}
+
+static int tnvvse_crypto_batch_run_job(struct tnvvse_crypto_ctx *ctx,
+		struct tnvvse_batch_state *st, struct tegra_nvvse_batch_job *job)
+{
+	struct tegra_virtual_se_sha_context *sha_ctx;
+	char key_as_keyslot[AES_KEYSLOT_NAME_SIZE] = {0,};
+	struct tnvvse_cmac_req_data priv_data;
+	struct crypto_ahash *tfm;
+	struct ahash_request *req;
+	uint32_t digest_size;
+	int ret;
+
+	tfm = tnvvse_crypto_batch_get_tfm(ctx, st, job);
+	if (IS_ERR(tfm))
+		return PTR_ERR(tfm);
+
+	req = ahash_request_alloc(tfm, GFP_KERNEL);
+	if (!req)
+		return -ENOMEM;
+
+	ahash_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
+				   tnvvse_crypto_complete, &st->complete);
+
+	ret = tnvvse_crypt_copy_user_buf(st->in_sz, st->in_buf,
+			job->data_length, (char *)job->src_buffer);
+	if (ret)
+		goto free_req;
+
+	memset(st->result, 0, NVVSE_MAX_ALLOCATED_SHA_RESULT_BUFF_SIZE);
+
+	if (job->job_type == TEGRA_NVVSE_BATCH_JOB_SHA) {
+		digest_size = crypto_ahash_digestsize(tfm);
+		/* Shake128/Shake256 have variable digest size */
+		if ((job->sha_type == TEGRA_NVVSE_SHA_TYPE_SHAKE128) ||
+		    (job->sha_type == TEGRA_NVVSE_SHA_TYPE_SHAKE256)) {
+			sha_ctx = crypto_ahash_ctx(tfm);
+			sha_ctx->digest_size = job->digest_size;
+			digest_size = job->digest_size;
+		}
+
+		ret = wait_async_op(&st->complete, crypto_ahash_init(req));
+		if (ret)
+			goto free_req;
+
+		ahash_request_set_crypt(req, st->in_sgt.sgl, st->result, job->data_length);
+		ret = wait_async_op(&st->complete, crypto_ahash_update(req));
+		if (ret)
+			goto free_req;
+
+		ret = wait_async_op(&st->complete, crypto_ahash_final(req));
+		if (ret)
+			goto free_req;
+	} else {
+		digest_size = crypto_ahash_digestsize(tfm);
+		crypto_ahash_clear_flags(tfm, ~0U);
+
+		snprintf(key_as_keyslot, AES_KEYSLOT_NAME_SIZE, "NVSEAES ");
+		memcpy(key_as_keyslot + KEYSLOT_OFFSET_BYTES, job->key_slot, KEYSLOT_SIZE_BYTES);
+
+		if (job->job_type == TEGRA_NVVSE_BATCH_JOB_CMAC_SIGN)
+			priv_data.request_type = CMAC_SIGN;
+		else
+			priv_data.request_type = CMAC_VERIFY;
+		priv_data.result = 0;
+		req->priv = &priv_data;
+
+		ret = crypto_ahash_setkey(tfm, key_as_keyslot, job->key_length);
+		if (ret)
+			goto free_req;
+
+		ret = wait_async_op(&st->complete, crypto_ahash_init(req));
+		if (ret)
+			goto free_req;
+
+		if (job->job_type == TEGRA_NVVSE_BATCH_JOB_CMAC_VERIFY) {
+			if (copy_from_user((void *)st->result,
+					(void __user *)job->digest_buffer,
+					TEGRA_NVVSE_AES_CMAC_LEN)) {
+				ret = -EFAULT;
+				goto free_req;
+			}
+		}
+
+		ahash_request_set_crypt(req, st->in_sgt.sgl, st->result, job->data_length);
+		ret = wait_async_op(&st->complete, crypto_ahash_finup(req));
+		if (ret)
+			goto free_req;
+
+		if (job->job_type == TEGRA_NVVSE_BATCH_JOB_CMAC_VERIFY) {
+			job->result = priv_data.result;
+			goto free_req;
+		}
+	}
+
+	if (copy_to_user((void __user *)job->digest_buffer, (const void *)st->result,
+				digest_size))
+		ret = -EFAULT;
+
+free_req:
+	ahash_request_free(req);
+
+	return ret;
+}
+
+static int tnvvse_crypto_batch(struct tnvvse_crypto_ctx *ctx,
+		struct tegra_nvvse_batch_ctl *batch_ctl)
+{
+	struct tegra_nvvse_batch_job *jobs;
+	struct tnvvse_batch_state *st;
+	uint32_t i, max_len = 0U;
+	int ret = 0;
+
+	if (batch_ctl->num_jobs == 0U || batch_ctl->num_jobs > TEGRA_NVVSE_BATCH_MAX_JOBS) {
+		pr_err("%s(): Number of jobs %u is not supported\n",
+				__func__, batch_ctl->num_jobs);
+		return -EINVAL;
+	}
+
+	jobs = kcalloc(batch_ctl->num_jobs, sizeof(*jobs), GFP_KERNEL);
+	if (!jobs)
+		return -ENOMEM;
+
+	if (copy_from_user(jobs, (void __user *)batch_ctl->jobs,
+				batch_ctl->num_jobs * sizeof(*jobs))) {
+		pr_err("%s(): Failed to copy_from_user jobs\n", __func__);
+		ret = -EFAULT;
+		goto free_jobs;
+	}
+
+	for (i = 0U; i < batch_ctl->num_jobs; i++) {
+		jobs[i].result = 0U;
+		jobs[i].status = tnvvse_crypto_batch_check_job(ctx, &jobs[i]);
+		if (jobs[i].status == 0 && jobs[i].data_length > max_len)
+			max_len = jobs[i].data_length;
+	}
+
+	st = kzalloc(sizeof(*st), GFP_KERNEL);
+	if (!st) {
+		ret = -ENOMEM;
+		goto free_jobs;
+	}
+
+	st->result = kzalloc(NVVSE_MAX_ALLOCATED_SHA_RESULT_BUFF_SIZE, GFP_KERNEL);
+	if (!st->result) {
+		ret = -ENOMEM;
+		goto free_state;
+	}
+
+	/* One bounce buffer sized for the largest job serves the whole batch */
+	st->in_sz = max_len;
+	ret = tnvvse_crypt_alloc_buf(&st->in_sgt, st->in_buf, max_len);
+	if (ret < 0) {
+		pr_err("%s(): Failed to allocate in_buffer: %d\n", __func__, ret);
+		goto free_result;
+	}
+
+	init_completion(&st->complete.restart);
+	st->complete.req_err = 0;
+
+	for (i = 0U; i < batch_ctl->num_jobs; i++) {
+		if (jobs[i].status != 0)
+			continue;
+
+		jobs[i].status = tnvvse_crypto_batch_run_job(ctx, st, &jobs[i]);
+		if (jobs[i].status)
+			pr_debug("%s(): job %u failed: %d\n", __func__, i, jobs[i].status);
+	}
+
+	if (copy_to_user((void __user *)batch_ctl->jobs, jobs,
+				batch_ctl->num_jobs * sizeof(*jobs))) {
+		pr_err("%s(): Failed to copy_to_user jobs\n", __func__);
+		ret = -EFAULT;
+	}
+
+	tnvvse_crypt_free_buf(&st->in_sgt, st->in_buf);
+	for (i = 0U; i < TEGRA_NVVSE_SHA_TYPE_MAX; i++) {
+		if (st->sha_tfm[i])
+			crypto_free_ahash(st->sha_tfm[i]);
+	}
+	if (st->cmac_tfm)
+		crypto_free_ahash(st->cmac_tfm);
+free_result:
+	kfree(st->result);
+free_state:
+	kfree(st);
+free_jobs:
+	kfree(jobs);
+
+	return ret;
+}
+
 static int tnvvse_crypto_aes_gmac_init(struct tnvvse_crypto_ctx *ctx,
 		struct tegra_nvvse_aes_gmac_init_ctl *gmac_init_ctl)
 {
@@ -1168,6 +1546,8 @@ static int tnvvse_crypto_aes_enc_dec(struct tnvvse_crypto_ctx *ctx,
 	char key_as_keyslot[AES_KEYSLOT_NAME_SIZE] = {0,};
 	uint8_t next_block_iv[TEGRA_NVVSE_AES_IV_LEN];
 	uint32_t in_sz, out_sz;
+	struct tnvvse_user_sg in_usg, out_usg;
+	bool zero_copy = false;
 
 	if (aes_enc_dec_ctl->aes_mode >= TEGRA_NVVSE_AES_MODE_MAX) {
 		pr_err("%s(): The requested AES ENC/DEC (%d) is not supported\n",
@@ -1248,16 +1628,29 @@ static int tnvvse_crypto_aes_enc_dec(struct tnvvse_crypto_ctx *ctx,
 
 	in_sz = aes_enc_dec_ctl->data_length;
 	out_sz = aes_enc_dec_ctl->data_length;
-	ret = tnvvse_crypt_alloc_buf(&in_sgt, in_buf, in_sz);
-	if (ret < 0) {
-		pr_err("%s(): Failed to allocate in_buffer: %d\n", __func__, ret);
-		goto free_req;
+
+	/* Large requests work on the user pages directly, fall back to bounce buffers */
+	if (in_sz >= NVVSE_ZERO_COPY_MIN_LEN &&
+	    !tnvvse_crypt_pin_user_buf(&in_usg, aes_enc_dec_ctl->src_buffer, in_sz, false)) {
+		if (!tnvvse_crypt_pin_user_buf(&out_usg, aes_enc_dec_ctl->dest_buffer,
+					out_sz, true))
+			zero_copy = true;
+		else
+			tnvvse_crypt_unpin_user_buf(&in_usg);
 	}
 
-	ret = tnvvse_crypt_alloc_buf(&out_sgt, out_buf, out_sz);
-	if (ret < 0) {
-		pr_err("%s(): Failed to allocate out_buffer: %d\n", __func__, ret);
-		goto free_in_buf;
+	if (!zero_copy) {
+		ret = tnvvse_crypt_alloc_buf(&in_sgt, in_buf, in_sz);
+		if (ret < 0) {
+			pr_err("%s(): Failed to allocate in_buffer: %d\n", __func__, ret);
+			goto free_req;
+		}
+
+		ret = tnvvse_crypt_alloc_buf(&out_sgt, out_buf, out_sz);
+		if (ret < 0) {
+			pr_err("%s(): Failed to allocate out_buffer: %d\n", __func__, ret);
+			goto free_in_buf;
+		}
 	}
 
 	init_completion(&tcrypt_complete.restart);
@@ -1283,15 +1676,21 @@ static int tnvvse_crypto_aes_enc_dec(struct tnvvse_crypto_ctx *ctx,
 	pr_debug("%s(): %scryption\n", __func__, (aes_enc_dec_ctl->is_encryption ? "en" : "de"));
 
 
-	/* copy input buffer */
-	ret = tnvvse_crypt_copy_user_buf(in_sz, in_buf,
-			in_sz, aes_enc_dec_ctl->src_buffer);
-	if (ret) {
-		pr_err("%s(): Failed to copy_from_user input data: %d\n", __func__, ret);
-		goto free_out_buf;
-	}
+	if (zero_copy) {
+		skcipher_request_set_crypt(req, in_usg.sgt.sgl, out_usg.sgt.sgl,
+				in_sz, next_block_iv);
+	} else {
+		/* copy input buffer */
+		ret = tnvvse_crypt_copy_user_buf(in_sz, in_buf,
+				in_sz, aes_enc_dec_ctl->src_buffer);
+		if (ret) {
+			pr_err("%s(): Failed to copy_from_user input data: %d\n",
+					__func__, ret);
+			goto free_out_buf;
+		}
 
-	skcipher_request_set_crypt(req, in_sgt.sgl, out_sgt.sgl, in_sz, next_block_iv);
+		skcipher_request_set_crypt(req, in_sgt.sgl, out_sgt.sgl, in_sz, next_block_iv);
+	}
 
 	reinit_completion(&tcrypt_complete.restart);
 	skcipher_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
@@ -1328,10 +1727,13 @@ static int tnvvse_crypto_aes_enc_dec(struct tnvvse_crypto_ctx *ctx,
 	}
 
 	/* copy output of size NVVSE_CHUNK_SIZE */
-	ret = tnvvse_crypt_copy_kern_buf(out_sz, aes_enc_dec_ctl->dest_buffer, out_sz, out_buf);
-	if (ret) {
-		pr_err("%s(): Failed to copy_to_user output: %d\n", __func__, ret);
-		goto free_out_buf;
+	if (!zero_copy) {
+		ret = tnvvse_crypt_copy_kern_buf(out_sz, aes_enc_dec_ctl->dest_buffer,
+				out_sz, out_buf);
+		if (ret) {
+			pr_err("%s(): Failed to copy_to_user output: %d\n", __func__, ret);
+			goto free_out_buf;
+		}
 	}
 
 	if ((aes_enc_dec_ctl->is_encryption) &&
@@ -1358,6 +1760,11 @@ static int tnvvse_crypto_aes_enc_dec(struct tnvvse_crypto_ctx *ctx,
 	}
 
 free_out_buf:
+	if (zero_copy) {
+		tnvvse_crypt_unpin_user_buf(&out_usg);
+		tnvvse_crypt_unpin_user_buf(&in_usg);
+		goto free_req;
+	}
 	tnvvse_crypt_free_buf(&out_sgt, out_buf);
 
 free_in_buf:
@@ -1373,6 +1780,106 @@ out:
 	return ret;
 }
 
+/*
+ * Run a GCM request directly on pinned user pages, only the tag goes through a
+ * kernel buffer. Returns -ENOTBLK when the user buffers cannot be pinned.
+ */
+static int tnvvse_crypto_aes_gcm_zero_copy(struct aead_request *req,
+		struct tegra_nvvse_aes_enc_dec_ctl *aes_enc_dec_ctl,
+		struct tnvvse_crypto_completion *tcrypt_complete, uint8_t *iv)
+{
+	struct tnvvse_user_sg aad_usg, src_usg, dst_usg;
+	struct sg_table in_sgt, out_sgt;
+	uint8_t *tag;
+	uint32_t data_length = aes_enc_dec_ctl->data_length;
+	uint32_t tag_length = aes_enc_dec_ctl->tag_length;
+	bool enc = aes_enc_dec_ctl->is_encryption;
+	int ret;
+
+	/* The tag is referenced from a scatterlist, so it can not live on the stack */
+	tag = kzalloc(TEGRA_NVVSE_AES_GCM_TAG_SIZE, GFP_KERNEL);
+	if (!tag)
+		return -ENOMEM;
+
+	ret = -ENOTBLK;
+	if (tnvvse_crypt_pin_user_buf(&aad_usg, aes_enc_dec_ctl->aad_buffer,
+				aes_enc_dec_ctl->aad_length, false))
+		goto free_tag;
+
+	if (tnvvse_crypt_pin_user_buf(&src_usg, aes_enc_dec_ctl->src_buffer,
+				data_length, false))
+		goto unpin_aad;
+
+	if (tnvvse_crypt_pin_user_buf(&dst_usg, aes_enc_dec_ctl->dest_buffer,
+				data_length, true))
+		goto unpin_src;
+
+	if (!enc && copy_from_user(tag, (void __user *)aes_enc_dec_ctl->tag_buffer,
+				tag_length)) {
+		pr_err("%s(): Failed copy_from_user tag data\n", __func__);
+		ret = -EFAULT;
+		goto unpin_dst;
+	}
+
+	ret = tnvvse_crypt_concat_sg(&in_sgt, &aad_usg, &src_usg,
+			tag, enc ? 0U : tag_length);
+	if (ret)
+		goto unpin_dst;
+
+	/* The driver never writes the first assoclen bytes of dst, aad only pads them */
+	ret = tnvvse_crypt_concat_sg(&out_sgt, &aad_usg, &dst_usg,
+			tag, enc ? tag_length : 0U);
+	if (ret)
+		goto free_in_sgt;
+
+	aead_request_set_crypt(req, in_sgt.sgl, out_sgt.sgl,
+				enc ? data_length : data_length + tag_length,
+				iv);
+
+	ret = enc ? crypto_aead_encrypt(req) : crypto_aead_decrypt(req);
+	if ((ret == -EINPROGRESS) || (ret == -EBUSY)) {
+		/* crypto driver is asynchronous */
+		if (!wait_for_completion_timeout(&tcrypt_complete->restart,
+					msecs_to_jiffies(5000))) {
+			ret = -ETIMEDOUT;
+			goto free_out_sgt;
+		}
+		ret = tcrypt_complete->req_err;
+	}
+
+	if (ret < 0) {
+		pr_err("%s(): Failed to %scrypt: %d\n", __func__, enc ? "en" : "de", ret);
+		goto free_out_sgt;
+	}
+
+	if (enc) {
+		if (copy_to_user((void __user *)aes_enc_dec_ctl->tag_buffer, tag, tag_length)) {
+			pr_err("%s(): Failed copy_to_user tag data\n", __func__);
+			ret = -EFAULT;
+			goto free_out_sgt;
+		}
+
+		if (aes_enc_dec_ctl->user_nonce == 0U)
+			memcpy(aes_enc_dec_ctl->initial_vector, req->iv,
+					TEGRA_NVVSE_AES_GCM_IV_LEN);
+	}
+
+free_out_sgt:
+	sg_free_table(&out_sgt);
+free_in_sgt:
+	sg_free_table(&in_sgt);
+unpin_dst:
+	tnvvse_crypt_unpin_user_buf(&dst_usg);
+unpin_src:
+	tnvvse_crypt_unpin_user_buf(&src_usg);
+unpin_aad:
+	tnvvse_crypt_unpin_user_buf(&aad_usg);
+free_tag:
+	kfree(tag);
+
+	return ret;
+}
+
 static int tnvvse_crypto_aes_enc_dec_gcm(struct tnvvse_crypto_ctx *ctx,
 				struct tegra_nvvse_aes_enc_dec_ctl *aes_enc_dec_ctl)
 {
@@ -1487,6 +1994,12 @@ static int tnvvse_crypto_aes_enc_dec_gcm(struct tnvvse_crypto_ctx *ctx,
 		 */
 		iv[0] = 1;
 
+	if (data_length >= NVVSE_ZERO_COPY_MIN_LEN) {
+		ret = tnvvse_crypto_aes_gcm_zero_copy(req, aes_enc_dec_ctl, &tcrypt_complete, iv);
+		if (ret != -ENOTBLK)
+			goto free_req;
+	}
+
 	/* Prepare buffers
 	 * - AEAD encryption input:  assoc data || plaintext
 	 * - AEAD encryption output: assoc data || ciphertext || auth tag
@@ -1888,6 +2401,7 @@ static long tnvvse_crypto_dev_ioctl(struct file *filp,
 	struct tegra_nvvse_aes_gmac_init_ctl *aes_gmac_init_ctl;
 	struct tegra_nvvse_aes_gmac_sign_verify_ctl *aes_gmac_sign_verify_ctl;
 	struct tegra_nvvse_tsec_get_keyload_status *tsec_keyload_status;
+	struct tegra_nvvse_batch_ctl *batch_ctl;
 	int ret = 0;
 
 	/*
@@ -2193,6 +2707,25 @@ static long tnvvse_crypto_dev_ioctl(struct file *filp,
 		kfree(tsec_keyload_status);
 		break;
 
+	case NVVSE_IOCTL_CMDID_BATCH:
+		batch_ctl = kzalloc(sizeof(*batch_ctl), GFP_KERNEL);
+		if (!batch_ctl) {
+			pr_err("%s(): failed to allocate memory\n", __func__);
+			ret = -ENOMEM;
+			goto out;
+		}
+
+		ret = copy_from_user(batch_ctl, (void __user *)arg, sizeof(*batch_ctl));
+		if (ret) {
+			pr_err("%s(): Failed to copy_from_user batch_ctl:%d\n", __func__, ret);
+			kfree(batch_ctl);
+			goto out;
+		}
+
+		ret = tnvvse_crypto_batch(ctx, batch_ctl);
+		kfree(batch_ctl);
+		break;
+
 	default:
 		pr_err("%s(): invalid ioctl code(%d[0x%08x])", __func__, ioctl_num, ioctl_num);
 		ret = -EINVAL;
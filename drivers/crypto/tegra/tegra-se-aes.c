@@ -24,6 +24,14 @@
 
 #include "tegra-se.h"
 
+/*
+ * AEAD requests with less than this many bytes of AAD plus payload go to
+ * the software implementation, the host1x round trip costs more than it saves
+ */
+static unsigned int aead_sw_threshold = 256;
+module_param(aead_sw_threshold, uint, 0644);
+MODULE_PARM_DESC(aead_sw_threshold, "AEAD requests below this size in bytes use software");
+
 struct tegra_aes_ctx {
 #ifndef NV_CONFTEST_REMOVE_STRUCT_CRYPTO_ENGINE_CTX
 	struct crypto_engine_ctx enginectx;
@@ -48,6 +56,7 @@ struct tegra_aead_ctx {
 #ifndef NV_CONFTEST_REMOVE_STRUCT_CRYPTO_ENGINE_CTX
 	struct crypto_engine_ctx enginectx;
 #endif
+	struct crypto_aead *fallback_tfm;
 	struct tegra_se *se;
 	unsigned int authsize;
 	u32 alg;
@@ -69,6 +78,8 @@ struct tegra_aead_reqctx {
 	u32 key_id;
 	u32 iv[4];
 	u8 authdata[16];
+	/* Must be last, the fallback request context follows it */
+	struct aead_request fallback_req;
 };
 
 struct tegra_cmac_ctx {
@@ -425,7 +436,6 @@ static int tegra_xts_setkey(struct crypto_skcipher *tfm,
 			       const u8 *key, u32 keylen)
 {
 	struct tegra_aes_ctx *ctx = crypto_skcipher_ctx(tfm);
-	int ret;
 	u32 len;
 
 	len = keylen / 2;
@@ -434,17 +444,8 @@ static int tegra_xts_setkey(struct crypto_skcipher *tfm,
 		return -EINVAL;
 	}
 
-	ret = tegra_key_submit(ctx->se, key, len,
-			ctx->alg, &ctx->key1_id);
-	if (ret)
-		return ret;
-
-	ret = tegra_key_submit(ctx->se, key + len, len,
-			ctx->alg, &ctx->key2_id);
-	if (ret)
-		return ret;
-
-	return 0;
+	return tegra_key_submit_pair(ctx->se, key, len, ctx->alg,
+				     &ctx->key1_id, &ctx->key2_id);
 }
 
 static int tegra_aes_kac_manifest(u32 user, u32 alg, u32 keylen)
@@ -1417,6 +1418,23 @@ static int tegra_aead_unprep_req(struct crypto_engine *engine, void *areq)
 	return 0;
 }
 
+static void tegra_aead_init_fallback(struct crypto_aead *tfm, const char *algname)
+{
+	struct tegra_aead_ctx *ctx = crypto_aead_ctx(tfm);
+	unsigned int reqsize = sizeof(struct tegra_aead_reqctx);
+
+	ctx->fallback_tfm = crypto_alloc_aead(algname, 0,
+				    CRYPTO_ALG_ASYNC | CRYPTO_ALG_NEED_FALLBACK);
+	if (IS_ERR(ctx->fallback_tfm)) {
+		dev_warn(ctx->se->dev, "failed to allocate fallback for %s\n", algname);
+		ctx->fallback_tfm = NULL;
+	} else {
+		reqsize += crypto_aead_reqsize(ctx->fallback_tfm);
+	}
+
+	crypto_aead_set_reqsize(tfm, reqsize);
+}
+
 static int tegra_ccm_cra_init(struct crypto_aead *tfm)
 {
 	struct tegra_aead_ctx *ctx = crypto_aead_ctx(tfm);
@@ -1432,12 +1450,12 @@ static int tegra_ccm_cra_init(struct crypto_aead *tfm)
 	se_alg = container_of(alg, struct tegra_se_alg, alg.aead);
 #endif
 
-	crypto_aead_set_reqsize(tfm, sizeof(struct tegra_aead_reqctx));
-
 	ctx->se = se_alg->se_dev;
 	ctx->key_id = 0;
 	ctx->alg = se_algname_to_algid(algname);
 
+	tegra_aead_init_fallback(tfm, algname);
+
 #ifndef NV_CONFTEST_REMOVE_STRUCT_CRYPTO_ENGINE_CTX
 	ctx->enginectx.op.prepare_request = tegra_aead_prep_req;
 	ctx->enginectx.op.do_one_request = tegra_ccm_do_one_req;
@@ -1466,6 +1484,9 @@ static int tegra_ccm_setauthsize(struct crypto_aead *tfm,  unsigned int authsize
 
 	ctx->authsize = authsize;
 
+	if (ctx->fallback_tfm)
+		return crypto_aead_setauthsize(ctx->fallback_tfm, authsize);
+
 	return 0;
 }
 
@@ -1483,12 +1504,12 @@ static int tegra_gcm_cra_init(struct crypto_aead *tfm)
 	se_alg = container_of(alg, struct tegra_se_alg, alg.aead);
 #endif
 
-	crypto_aead_set_reqsize(tfm, sizeof(struct tegra_aead_reqctx));
-
 	ctx->se = se_alg->se_dev;
 	ctx->key_id = 0;
 	ctx->alg = se_algname_to_algid(algname);
 
+	tegra_aead_init_fallback(tfm, algname);
+
 #ifndef NV_CONFTEST_REMOVE_STRUCT_CRYPTO_ENGINE_CTX
 	ctx->enginectx.op.prepare_request = tegra_aead_prep_req;
 	ctx->enginectx.op.do_one_request = tegra_gcm_do_one_req;
@@ -1509,6 +1530,9 @@ static int tegra_gcm_setauthsize(struct crypto_aead *tfm,  unsigned int authsize
 
 	ctx->authsize = authsize;
 
+	if (ctx->fallback_tfm)
+		return crypto_aead_setauthsize(ctx->fallback_tfm, authsize);
+
 	return 0;
 }
 
@@ -1518,6 +1542,26 @@ static void tegra_aead_cra_exit(struct crypto_aead *tfm)
 
 	if (ctx->key_id)
 		tegra_key_invalidate(ctx->se, ctx->key_id);
+
+	if (ctx->fallback_tfm)
+		crypto_free_aead(ctx->fallback_tfm);
+}
+
+static int tegra_aead_do_fallback(struct aead_request *req, bool encrypt)
+{
+	struct crypto_aead *tfm = crypto_aead_reqtfm(req);
+	struct tegra_aead_ctx *ctx = crypto_aead_ctx(tfm);
+	struct tegra_aead_reqctx *rctx = aead_request_ctx(req);
+
+	aead_request_set_tfm(&rctx->fallback_req, ctx->fallback_tfm);
+	aead_request_set_callback(&rctx->fallback_req, req->base.flags,
+				  req->base.complete, req->base.data);
+	aead_request_set_crypt(&rctx->fallback_req, req->src, req->dst,
+			       req->cryptlen, req->iv);
+	aead_request_set_ad(&rctx->fallback_req, req->assoclen);
+
+	return encrypt ? crypto_aead_encrypt(&rctx->fallback_req) :
+			 crypto_aead_decrypt(&rctx->fallback_req);
 }
 
 static int tegra_aead_crypt(struct aead_request *req, bool encrypt)
@@ -1526,6 +1570,10 @@ static int tegra_aead_crypt(struct aead_request *req, bool encrypt)
 	struct tegra_aead_ctx *ctx = crypto_aead_ctx(tfm);
 	struct tegra_aead_reqctx *rctx = aead_request_ctx(req);
 
+	if (ctx->fallback_tfm &&
+	    (req->assoclen + req->cryptlen) < aead_sw_threshold)
+		return tegra_aead_do_fallback(req, encrypt);
+
 	rctx->encrypt = encrypt;
 
 	return crypto_transfer_aead_request_to_engine(ctx->se->engine, req);
@@ -1546,11 +1594,22 @@ static int tegra_aead_setkey(struct crypto_aead *tfm,
 {
 	struct tegra_aead_ctx *ctx = crypto_aead_ctx(tfm);
 
+	int ret;
+
 	if (aes_check_keylen(keylen)) {
 		dev_err(ctx->se->dev, "key length validation failed\n");
 		return -EINVAL;
 	}
 
+	if (ctx->fallback_tfm) {
+		crypto_aead_clear_flags(ctx->fallback_tfm, CRYPTO_TFM_REQ_MASK);
+		crypto_aead_set_flags(ctx->fallback_tfm,
+				      crypto_aead_get_flags(tfm) & CRYPTO_TFM_REQ_MASK);
+		ret = crypto_aead_setkey(ctx->fallback_tfm, key, keylen);
+		if (ret)
+			return ret;
+	}
+
 	return tegra_key_submit(ctx->se, key, keylen, ctx->alg, &ctx->key_id);
 }
 
@@ -1913,6 +1972,7 @@ static struct tegra_se_alg tegra_aead_algs[] = {
 				.cra_name	   = "gcm(aes)",
 				.cra_driver_name   = "gcm-aes-tegra",
 				.cra_priority	   = 500,
+				.cra_flags	   = CRYPTO_ALG_ASYNC | CRYPTO_ALG_NEED_FALLBACK,
 				.cra_blocksize	   = AES_BLOCK_SIZE,
 				.cra_ctxsize	   = sizeof(struct tegra_aead_ctx),
 				.cra_alignmask	   = 0,
@@ -1941,6 +2001,7 @@ static struct tegra_se_alg tegra_aead_algs[] = {
 				.cra_name	   = "ccm(aes)",
 				.cra_driver_name   = "ccm-aes-tegra",
 				.cra_priority	   = 500,
+				.cra_flags	   = CRYPTO_ALG_ASYNC | CRYPTO_ALG_NEED_FALLBACK,
 				.cra_blocksize	   = AES_BLOCK_SIZE,
 				.cra_ctxsize	   = sizeof(struct tegra_aead_ctx),
 				.cra_alignmask	   = 0,
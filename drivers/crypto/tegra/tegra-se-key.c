@@ -98,11 +98,19 @@ static int tegra_key_insert(struct tegra_se *se, const u8 *key,
 				u32 keylen, u16 slot, u32 alg)
 {
 	const u32 *keyval = (u32 *)key;
-	u32 *addr = se->cmdbuf->addr, size;
+	struct tegra_se_cmdbuf *cmdbuf;
+	u32 size;
+	int ret;
+
+	/* setkey runs outside the crypto engine, do not touch se->cmdbuf */
+	cmdbuf = tegra_se_cmdbuf_acquire(se);
+
+	size = tegra_key_prep_ins_cmd(se, cmdbuf->addr, keyval, keylen, slot, alg);
+	ret = tegra_se_host1x_submit_cmdbuf(se, cmdbuf, size, 1);
 
-	size = tegra_key_prep_ins_cmd(se, addr, keyval, keylen, slot, alg);
+	tegra_se_cmdbuf_recycle(se, cmdbuf);
 
-	return tegra_se_host1x_submit(se, size);
+	return ret;
 }
 
 void tegra_key_invalidate(struct tegra_se *se, u32 keyid)
@@ -130,3 +138,37 @@ int tegra_key_submit(struct tegra_se *se, const u8 *key, u32 keylen, u32 alg, u3
 
 	return 0;
 }
+
+/* Insert two keys of @keylen bytes each, chained into a single host1x job */
+int tegra_key_submit_pair(struct tegra_se *se, const u8 *key, u32 keylen, u32 alg,
+			  u32 *key1id, u32 *key2id)
+{
+	struct tegra_se_cmdbuf *cmdbuf;
+	u32 size;
+	int ret;
+
+	if (!tegra_key_in_kslt(*key1id)) {
+		*key1id = tegra_keyslot_alloc();
+		if (!(*key1id))
+			return -ENOMEM;
+	}
+
+	if (!tegra_key_in_kslt(*key2id)) {
+		*key2id = tegra_keyslot_alloc();
+		if (!(*key2id))
+			return -ENOMEM;
+	}
+
+	cmdbuf = tegra_se_cmdbuf_acquire(se);
+
+	size = tegra_key_prep_ins_cmd(se, cmdbuf->addr, (u32 *)key, keylen,
+				      *key1id, alg);
+	size += tegra_key_prep_ins_cmd(se, cmdbuf->addr + size,
+				       (u32 *)(key + keylen), keylen, *key2id, alg);
+
+	ret = tegra_se_host1x_submit_cmdbuf(se, cmdbuf, size, 2);
+
+	tegra_se_cmdbuf_recycle(se, cmdbuf);
+
+	return ret;
+}
@@ -63,8 +63,12 @@ tegra_se_cmdbuf_pin(struct device *dev, struct host1x_bo *bo, enum dma_data_dire
 		goto free;
 	}
 
+	/*
+	 * Map the whole buffer, the gather carries the word count. This lets
+	 * the mapping be cached and reused by every job on this cmdbuf.
+	 */
 	err = dma_get_sgtable(dev, map->sgt, cmdbuf->addr,
-			      cmdbuf->iova, cmdbuf->words * 4);
+			      cmdbuf->iova, cmdbuf->size);
 	if (err)
 		goto free_sgt;
 
@@ -73,7 +77,7 @@ tegra_se_cmdbuf_pin(struct device *dev, struct host1x_bo *bo, enum dma_data_dire
 		goto free_sgt;
 
 	map->phys = sg_dma_address(map->sgt->sgl);
-	map->size = cmdbuf->words * 4;
+	map->size = cmdbuf->size;
 	map->chunks = err;
 
 	return map;
@@ -130,8 +134,10 @@ static struct tegra_se_cmdbuf *tegra_se_host1x_bo_alloc(struct tegra_se *se, ssi
 
 	cmdbuf->addr = dma_alloc_attrs(dev, size, &cmdbuf->iova,
 				       GFP_KERNEL, 0);
-	if (!cmdbuf->addr)
+	if (!cmdbuf->addr) {
+		kfree(cmdbuf);
 		return NULL;
+	}
 
 	cmdbuf->size = size;
 	cmdbuf->dev  = dev;
@@ -142,7 +148,109 @@ static struct tegra_se_cmdbuf *tegra_se_host1x_bo_alloc(struct tegra_se *se, ssi
 	return cmdbuf;
 }
 
-int tegra_se_host1x_submit(struct tegra_se *se, u32 size)
+static void tegra_se_host1x_bo_free(struct tegra_se *se)
+{
+	struct host1x_bo_mapping *map, *tmp;
+	int i;
+
+	/* Drop the references held by the pinned mapping cache */
+	list_for_each_entry_safe(map, tmp, &se->cmdbuf_cache.mappings, entry)
+		host1x_bo_unpin(map);
+
+	for (i = 0; i < SE_CMDBUF_POOL_SIZE; i++) {
+		if (se->cmdbuf_pool[i])
+			tegra_se_cmdbuf_put(&se->cmdbuf_pool[i]->bo);
+		se->cmdbuf_pool[i] = NULL;
+	}
+
+	if (se->cmdbuf)
+		tegra_se_cmdbuf_put(&se->cmdbuf->bo);
+	se->cmdbuf = NULL;
+
+	host1x_bo_cache_destroy(&se->cmdbuf_cache);
+}
+
+static int tegra_se_host1x_bo_init(struct tegra_se *se)
+{
+	int i;
+
+	host1x_bo_cache_init(&se->cmdbuf_cache);
+	spin_lock_init(&se->cmdbuf_lock);
+	init_waitqueue_head(&se->cmdbuf_wq);
+
+	se->cmdbuf = tegra_se_host1x_bo_alloc(se, SZ_4K);
+	if (!se->cmdbuf)
+		goto err;
+
+	for (i = 0; i < SE_CMDBUF_POOL_SIZE; i++) {
+		se->cmdbuf_pool[i] = tegra_se_host1x_bo_alloc(se, SZ_4K);
+		if (!se->cmdbuf_pool[i])
+			goto err;
+	}
+
+	se->cmdbuf_free = GENMASK(SE_CMDBUF_POOL_SIZE - 1, 0);
+
+	return 0;
+
+err:
+	tegra_se_host1x_bo_free(se);
+	return -ENOMEM;
+}
+
+static bool tegra_se_cmdbuf_try_acquire(struct tegra_se *se, struct tegra_se_cmdbuf **cmdbuf)
+{
+	unsigned long flags;
+	unsigned int idx;
+
+	spin_lock_irqsave(&se->cmdbuf_lock, flags);
+	idx = ffs(se->cmdbuf_free);
+	if (idx) {
+		se->cmdbuf_free &= ~BIT(idx - 1);
+		*cmdbuf = se->cmdbuf_pool[idx - 1];
+	}
+	spin_unlock_irqrestore(&se->cmdbuf_lock, flags);
+
+	return idx != 0;
+}
+
+/*
+ * Take a cmdbuf from the pool. se->cmdbuf belongs to the crypto engine
+ * worker, requests issued outside of it (key insertion from setkey) use
+ * the pool so they never overwrite commands of an in-flight request.
+ */
+struct tegra_se_cmdbuf *tegra_se_cmdbuf_acquire(struct tegra_se *se)
+{
+	struct tegra_se_cmdbuf *cmdbuf = NULL;
+
+	wait_event(se->cmdbuf_wq, tegra_se_cmdbuf_try_acquire(se, &cmdbuf));
+
+	return cmdbuf;
+}
+
+void tegra_se_cmdbuf_recycle(struct tegra_se *se, struct tegra_se_cmdbuf *cmdbuf)
+{
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&se->cmdbuf_lock, flags);
+	for (i = 0; i < SE_CMDBUF_POOL_SIZE; i++) {
+		if (se->cmdbuf_pool[i] == cmdbuf) {
+			se->cmdbuf_free |= BIT(i);
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&se->cmdbuf_lock, flags);
+
+	wake_up(&se->cmdbuf_wq);
+}
+
+/*
+ * Submit @size words of @cmdbuf as a single host1x job. The buffer may hold
+ * several chained command sequences, each ending with a syncpoint increment,
+ * @incrs is the number of those increments.
+ */
+int tegra_se_host1x_submit_cmdbuf(struct tegra_se *se, struct tegra_se_cmdbuf *cmdbuf,
+				  u32 size, u32 incrs)
 {
 	struct host1x_job *job;
 	int ret;
@@ -154,16 +262,17 @@ int tegra_se_host1x_submit(struct tegra_se *se, u32 size)
 	}
 
 	job->syncpt =  host1x_syncpt_get(se->syncpt);
-	job->syncpt_incrs = 1;
+	job->syncpt_incrs = incrs;
 	job->client = &se->client;
 	job->class = se->client.class;
 	job->serialize = true;
 	job->engine_fallback_streamid = se->stream_id;
 	job->engine_streamid_offset = SE_STREAM_ID;
+	job->gather_cache = &se->cmdbuf_cache;
 
-	se->cmdbuf->words = size;
+	cmdbuf->words = size;
 
-	host1x_job_add_gather(job, &se->cmdbuf->bo, size, 0);
+	host1x_job_add_gather(job, &cmdbuf->bo, size, 0);
 
 	ret = host1x_job_pin(job, se->dev);
 	if (ret) {
@@ -195,6 +304,11 @@ err_job_pin:
 	return ret;
 }
 
+int tegra_se_host1x_submit(struct tegra_se *se, u32 size)
+{
+	return tegra_se_host1x_submit_cmdbuf(se, se->cmdbuf, size, 1);
+}
+
 static int tegra_se_client_init(struct host1x_client *client)
 {
 	struct tegra_se *se = container_of(client, struct tegra_se, client);
@@ -215,11 +329,9 @@ static int tegra_se_client_init(struct host1x_client *client)
 
 	se->syncpt_id =  host1x_syncpt_id(se->syncpt);
 
-	se->cmdbuf = tegra_se_host1x_bo_alloc(se, SZ_4K);
-	if (!se->cmdbuf) {
-		ret = -ENOMEM;
+	ret = tegra_se_host1x_bo_init(se);
+	if (ret)
 		goto err_bo;
-	}
 
 	ret = se->hw->init_alg(se);
 	if (ret) {
@@ -230,7 +342,7 @@ static int tegra_se_client_init(struct host1x_client *client)
 	return 0;
 
 err_alg_reg:
-	tegra_se_cmdbuf_put(&se->cmdbuf->bo);
+	tegra_se_host1x_bo_free(se);
 err_bo:
 	host1x_syncpt_put(se->syncpt);
 err_syncpt:
@@ -244,7 +356,7 @@ static int tegra_se_client_deinit(struct host1x_client *client)
 	struct tegra_se *se = container_of(client, struct tegra_se, client);
 
 	se->hw->deinit_alg();
-	tegra_se_cmdbuf_put(&se->cmdbuf->bo);
+	tegra_se_host1x_bo_free(se);
 	host1x_syncpt_put(se->syncpt);
 	host1x_channel_put(se->channel);
 
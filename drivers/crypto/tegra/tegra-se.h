@@ -29,6 +29,9 @@
 
 #define SE_STREAM_ID					0x90
 
+/* Pre-pinned command buffers for submissions outside the crypto engine */
+#define SE_CMDBUF_POOL_SIZE				4
+
 #define SE_SHA_CFG					0x4004
 #define SE_SHA_KEY_ADDR					0x4094
 #define SE_SHA_KEY_DATA					0x4098
@@ -461,6 +464,11 @@ struct tegra_se {
 	struct host1x_syncpt *syncpt;
 	struct clk_bulk_data *clks;
 	struct tegra_se_cmdbuf *cmdbuf;
+	struct tegra_se_cmdbuf *cmdbuf_pool[SE_CMDBUF_POOL_SIZE];
+	struct host1x_bo_cache cmdbuf_cache;
+	wait_queue_head_t cmdbuf_wq;
+	spinlock_t cmdbuf_lock;
+	unsigned long cmdbuf_free;
 	struct device *dev;
 	unsigned int opcode_addr;
 	unsigned int stream_id;
@@ -544,11 +552,17 @@ void tegra_deinit_aes(void);
 void tegra_deinit_hash(void);
 
 int tegra_key_submit(struct tegra_se *se, const u8 *key, u32 keylen, u32 alg, u32 *keyid);
+int tegra_key_submit_pair(struct tegra_se *se, const u8 *key, u32 keylen, u32 alg,
+			  u32 *key1id, u32 *key2id);
 unsigned int tegra_key_get_idx(struct tegra_se *se, u32 keyid);
 void tegra_key_invalidate(struct tegra_se *se, u32 keyid);
 
 int tegra_se_host1x_register(struct tegra_se *se);
 int tegra_se_host1x_submit(struct tegra_se *se, u32 size);
+int tegra_se_host1x_submit_cmdbuf(struct tegra_se *se, struct tegra_se_cmdbuf *cmdbuf,
+				  u32 size, u32 incrs);
+struct tegra_se_cmdbuf *tegra_se_cmdbuf_acquire(struct tegra_se *se);
+void tegra_se_cmdbuf_recycle(struct tegra_se *se, struct tegra_se_cmdbuf *cmdbuf);
 
 static inline void se_writel(struct tegra_se *se, unsigned int val,
 			     unsigned int offset)
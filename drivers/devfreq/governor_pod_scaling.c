@@ -20,6 +20,8 @@
 #include <linux/export.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
+#include <linux/platform/tegra/throttle-event.h>
+#include <linux/pm_qos.h>
 #include <linux/pm_runtime.h>
 #include <linux/slab.h>
 #include <linux/types.h>
@@ -62,6 +64,7 @@ struct podgov_info_rec {
 	int			p_bias;
 	unsigned int		p_user;
 	unsigned int		p_freq_request;
+	unsigned int		p_throttle_pct;
 
 	unsigned long		cycles_norm;
 	unsigned long		cycles_avg;
@@ -89,6 +92,9 @@ struct podgov_info_rec {
 	struct kobj_attribute	user_attr;
 	struct kobj_attribute	freq_request_attr;
 
+	struct notifier_block	throttle_nb;
+	struct dev_pm_qos_request throttle_qos;
+
 	struct mutex		lock;
 };
 
@@ -432,6 +438,7 @@ static void nvhost_scale_emc_debug_init(struct devfreq *df)
 	CREATE_PODGOV_FILE(bias);
 	CREATE_PODGOV_FILE(damp);
 	CREATE_PODGOV_FILE(smooth);
+	CREATE_PODGOV_FILE(throttle_pct);
 #undef CREATE_PODGOV_FILE
 }
 
@@ -687,6 +694,38 @@ static int nvhost_pod_estimate_freq(struct devfreq *df,
 	return 0;
 }
 
+/*******************************************************************************
+ * Thermal trip and overcurrent events
+ *
+ * While an event is active the device is capped to p_throttle_pct percent of
+ * its highest frequency through a PM QoS request, before the hardware
+ * throttling would cut the clocks harder. 100 disables the cap.
+ ******************************************************************************/
+
+static void podgov_update_throttle(struct podgov_info_rec *podgov)
+{
+	s32 value = PM_QOS_MAX_FREQUENCY_DEFAULT_VALUE;
+	unsigned int pct = READ_ONCE(podgov->p_throttle_pct);
+
+	if (tegra_throttle_event_is_active() && pct < 100)
+		value = tegra_throttle_event_cap_freq(podgov->freqlist,
+						      podgov->freq_count,
+						      pct) / HZ_PER_KHZ;
+
+	dev_pm_qos_update_request(&podgov->throttle_qos, value);
+}
+
+static int podgov_throttle_notify(struct notifier_block *nb,
+				  unsigned long event, void *data)
+{
+	struct podgov_info_rec *podgov =
+		container_of(nb, struct podgov_info_rec, throttle_nb);
+
+	podgov_update_throttle(podgov);
+
+	return NOTIFY_DONE;
+}
+
 /*******************************************************************************
  * nvhost_pod_init(struct devfreq *df)
  *
@@ -732,6 +771,7 @@ static int nvhost_pod_init(struct devfreq *df)
 
 	podgov->adjustment_type = ADJUSTMENT_DEVICE_REQ;
 	podgov->p_user = 0;
+	podgov->p_throttle_pct = 80;
 
 	/* Reset clock counters */
 	podgov->last_scale = now;
@@ -777,12 +817,26 @@ static int nvhost_pod_init(struct devfreq *df)
 
 	podgov->freq_avg = 0;
 
+	if (dev_pm_qos_add_request(df->dev.parent, &podgov->throttle_qos,
+				   DEV_PM_QOS_MAX_FREQUENCY,
+				   PM_QOS_MAX_FREQUENCY_DEFAULT_VALUE) < 0)
+		goto err_get_freqs;
+
+	podgov->throttle_nb.notifier_call = podgov_throttle_notify;
+	if (tegra_throttle_event_register_notifier(&podgov->throttle_nb))
+		goto err_register_throttle;
+
 	nvhost_scale_emc_debug_init(df);
 
 	devfreq_monitor_start(df);
 
+	/* an event may already be active */
+	podgov_update_throttle(podgov);
+
 	return 0;
 
+err_register_throttle:
+	dev_pm_qos_remove_request(&podgov->throttle_qos);
 err_get_freqs:
 	sysfs_remove_file(&df->dev.parent->kobj, &podgov->user_attr.attr);
 err_create_user_sysfs_entry:
@@ -812,6 +866,9 @@ static void nvhost_pod_exit(struct devfreq *df)
 
 	devfreq_monitor_stop(df);
 
+	tegra_throttle_event_unregister_notifier(&podgov->throttle_nb);
+	dev_pm_qos_remove_request(&podgov->throttle_qos);
+
 	sysfs_remove_file(&df->dev.parent->kobj, &podgov->user_attr.attr);
 	sysfs_remove_file(&df->dev.parent->kobj,
 			  &podgov->freq_request_attr.attr);
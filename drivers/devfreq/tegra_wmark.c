@@ -8,6 +8,7 @@
 #include <linux/device.h>
 #include <linux/errno.h>
 #include <linux/module.h>
+#include <linux/platform/tegra/throttle-event.h>
 #include <linux/pm_opp.h>
 #include <linux/pm_qos.h>
 #include <linux/slab.h>
@@ -48,9 +49,14 @@
  *			when consecutive upper watermark interrupt get triggered.
  * @down_freq_margin:	Number of frequency steps for scaling down the frequency
  *			when consecutive lower watermark interrupt get triggered.
+ * @throttle_freq_pct:	Percentage of the highest frequency the device is
+ *			capped to while a thermal trip or overcurrent event is
+ *			active, 100 to disable the cap.
  * @curr_freq_index:		Index value of current frequency in the frequency table.
  * @df:			The devfreq instance of own device.
  * @nb:			Notifier block for DEVFREQ_TRANSITION_NOTIFIER list.
+ * @throttle_nb:	Notifier block for the Tegra throttle event chain.
+ * @throttle_qos:	PM QoS max frequency request applying the cap.
  */
 struct tegra_wmark_data {
 	unsigned int load_target;
@@ -58,9 +64,12 @@ struct tegra_wmark_data {
 	unsigned int down_wmark_margin;
 	unsigned int up_freq_margin;
 	unsigned int down_freq_margin;
+	unsigned int throttle_freq_pct;
 	int curr_freq_index;
 	struct devfreq *df;
 	struct notifier_block nb;
+	struct notifier_block throttle_nb;
+	struct dev_pm_qos_request throttle_qos;
 };
 
 static int devfreq_get_freq_index(struct devfreq *df, unsigned long freq)
@@ -433,12 +442,74 @@ static ssize_t load_target_show(struct device *dev,
 }
 static DEVICE_ATTR_RW(load_target);
 
+static void devfreq_tegra_wmark_update_throttle(struct tegra_wmark_data *govdata)
+{
+	struct devfreq *df = govdata->df;
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 19, 0)
+	unsigned long *freq_table = df->profile->freq_table;
+	unsigned int max_state = df->profile->max_state;
+#else
+	unsigned long *freq_table = df->freq_table;
+	unsigned int max_state = df->max_state;
+#endif
+	s32 value = PM_QOS_MAX_FREQUENCY_DEFAULT_VALUE;
+	unsigned int pct = READ_ONCE(govdata->throttle_freq_pct);
+
+	if (tegra_throttle_event_is_active() && pct < 100)
+		value = tegra_throttle_event_cap_freq(freq_table, max_state, pct) / 1000;
+
+	dev_pm_qos_update_request(&govdata->throttle_qos, value);
+}
+
+static ssize_t throttle_freq_pct_store(struct device *dev,
+				 struct device_attribute *attr,
+				 const char *buf,
+				 size_t count)
+{
+	struct devfreq *df = to_devfreq(dev);
+	struct tegra_wmark_data *govdata;
+	unsigned int pct;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &pct);
+	if (ret)
+		return ret;
+
+	pct = min_t(unsigned int, pct, 100);
+
+	mutex_lock(&df->lock);
+	govdata = df->governor_data;
+	govdata->throttle_freq_pct = pct;
+	mutex_unlock(&df->lock);
+
+	devfreq_tegra_wmark_update_throttle(govdata);
+
+	return count;
+}
+
+static ssize_t throttle_freq_pct_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct devfreq *df = to_devfreq(dev);
+	struct tegra_wmark_data *govdata;
+	int err;
+
+	mutex_lock(&df->lock);
+	govdata = df->governor_data;
+	err = sprintf(buf, "%u\n", govdata->throttle_freq_pct);
+	mutex_unlock(&df->lock);
+
+	return err;
+}
+static DEVICE_ATTR_RW(throttle_freq_pct);
+
 static struct attribute *dev_entries[] = {
 	&dev_attr_load_target.attr,
 	&dev_attr_up_wmark_margin.attr,
 	&dev_attr_down_wmark_margin.attr,
 	&dev_attr_up_freq_margin.attr,
 	&dev_attr_down_freq_margin.attr,
+	&dev_attr_throttle_freq_pct.attr,
 	NULL,
 };
 
@@ -464,6 +535,17 @@ static int devfreq_tegra_wmark_notifier_call(struct notifier_block *nb,
 	return NOTIFY_DONE;
 }
 
+static int devfreq_tegra_wmark_throttle_call(struct notifier_block *nb,
+					     unsigned long event, void *ptr)
+{
+	struct tegra_wmark_data *govdata
+			= container_of(nb, struct tegra_wmark_data, throttle_nb);
+
+	devfreq_tegra_wmark_update_throttle(govdata);
+
+	return NOTIFY_DONE;
+}
+
 static int tegra_wmark_init(struct devfreq *df)
 {
 	struct tegra_wmark_data *govdata;
@@ -486,6 +568,7 @@ static int tegra_wmark_init(struct devfreq *df)
 	govdata->down_wmark_margin = 100;
 	govdata->up_freq_margin = 4;
 	govdata->down_freq_margin = 1;
+	govdata->throttle_freq_pct = 80;
 	govdata->curr_freq_index = 0;
 
 	govdata->df = df;
@@ -500,7 +583,27 @@ static int tegra_wmark_init(struct devfreq *df)
 	if (err)
 		goto out_create_sysfs;
 
-	return err;
+	err = dev_pm_qos_add_request(df->dev.parent, &govdata->throttle_qos,
+				     DEV_PM_QOS_MAX_FREQUENCY,
+				     PM_QOS_MAX_FREQUENCY_DEFAULT_VALUE);
+	if (err < 0)
+		goto out_add_qos;
+
+	govdata->throttle_nb.notifier_call = devfreq_tegra_wmark_throttle_call;
+	err = tegra_throttle_event_register_notifier(&govdata->throttle_nb);
+	if (err)
+		goto out_register_throttle;
+
+	/* an event may already be active */
+	devfreq_tegra_wmark_update_throttle(govdata);
+
+	return 0;
+
+out_register_throttle:
+	dev_pm_qos_remove_request(&govdata->throttle_qos);
+
+out_add_qos:
+	sysfs_remove_group(&df->dev.kobj, &dev_attr_group);
 
 out_create_sysfs:
 	devfreq_unregister_notifier(df, &govdata->nb, DEVFREQ_TRANSITION_NOTIFIER);
@@ -516,6 +619,8 @@ static void tegra_wmark_exit(struct devfreq *df)
 {
 	struct tegra_wmark_data *govdata = df->governor_data;
 
+	tegra_throttle_event_unregister_notifier(&govdata->throttle_nb);
+	dev_pm_qos_remove_request(&govdata->throttle_qos);
 	devfreq_unregister_notifier(df, &govdata->nb, DEVFREQ_TRANSITION_NOTIFIER);
 	sysfs_remove_group(&df->dev.kobj, &dev_attr_group);
 	kfree(df->governor_data);
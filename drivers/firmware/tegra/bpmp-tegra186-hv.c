@@ -29,6 +29,8 @@
 
 static struct tegra186_hv_bpmp {
 	struct tegra_bpmp *parent;
+	/* writable copy of the match data, thread.count depends on the guest */
+	struct tegra_bpmp_soc *soc;
 } tegra186_hv_bpmp;
 
 /* utilizing the struct tegra_ivc *ivc in struct tegra_bpmp_channel
@@ -188,7 +190,7 @@ static int tegra186_hv_bpmp_channel_init(struct tegra_bpmp_channel *channel,
 				hv_ivc->irq,
 				tegra186_hv_bpmp_rx_handler, NULL,
 				IRQF_NO_SUSPEND,
-				"bpmp_irq_handler", &hv_ivc);
+				"bpmp_irq_handler", hv_ivc);
 	} else {
 		err = 0;
 	}
@@ -308,6 +310,44 @@ static int tegra186_hv_ivc_notify(struct tegra_bpmp *bpmp)
 	return 0;
 }
 
+/*
+ * The queues between the tx and rx channels back the per-CPU tx channels of
+ * native BPMP. The ones the hypervisor exposes to this guest are used as
+ * additional threaded channels, up to one per CPU, so that concurrent
+ * non-atomic transfers do not wait for each other to get a channel.
+ */
+static void tegra186_hv_bpmp_init_extra_threads(struct tegra_bpmp *bpmp,
+				uint32_t first_ivc_queue, uint32_t num_ivc_queues)
+{
+	struct tegra186_hv_bpmp *priv = bpmp->priv;
+	struct tegra_hv_ivc_cookie *hv_ivc;
+	unsigned int queue, last, max;
+	int err;
+
+	last = bpmp->soc->channels.cpu_rx.count ?
+		bpmp->soc->channels.cpu_rx.offset : num_ivc_queues;
+	max = bpmp->soc->channels.thread.count + num_possible_cpus();
+
+	for (queue = bpmp->soc->channels.cpu_tx.offset + 1;
+	     queue < last && bpmp->threaded.count < max; queue++) {
+		hv_ivc = tegra_hv_ivc_reserve(hv_of_node,
+					      queue + first_ivc_queue, NULL);
+		if (IS_ERR_OR_NULL(hv_ivc))
+			break;
+		tegra_hv_ivc_unreserve(hv_ivc);
+
+		err = tegra186_hv_bpmp_channel_init(
+				&bpmp->threaded_channels[bpmp->threaded.count],
+				bpmp, queue + first_ivc_queue, true);
+		if (err < 0)
+			break;
+
+		bpmp->threaded.count++;
+	}
+
+	priv->soc->channels.thread.count = bpmp->threaded.count;
+}
+
 static int tegra186_hv_bpmp_init(struct tegra_bpmp *bpmp)
 {
 	struct tegra186_hv_bpmp *priv;
@@ -319,6 +359,12 @@ static int tegra186_hv_bpmp_init(struct tegra_bpmp *bpmp)
 	if (!priv)
 		return -ENOMEM;
 
+	priv->soc = devm_kmemdup(bpmp->dev, bpmp->soc, sizeof(*bpmp->soc),
+				 GFP_KERNEL);
+	if (!priv->soc)
+		return -ENOMEM;
+
+	bpmp->soc = priv->soc;
 	bpmp->priv = priv;
 	priv->parent = bpmp;
 	tegra186_hv_bpmp.parent = bpmp;
@@ -400,6 +446,9 @@ static int tegra186_hv_bpmp_init(struct tegra_bpmp *bpmp)
 		}
 	}
 
+	tegra186_hv_bpmp_init_extra_threads(bpmp, first_ivc_queue,
+					    num_ivc_queues);
+
 	tegra186_hv_bpmp_resume(bpmp);
 	of_node_put(hv_of_node);
 
@@ -419,11 +468,13 @@ cleanup:
 	return -ENOMEM;
 }
 
-static void tegra186_hv_bpmp_channel_cleanup(struct tegra_bpmp_channel *channel)
+static void tegra186_hv_bpmp_channel_cleanup(struct tegra_bpmp_channel *channel,
+					     bool threaded)
 {
 	struct tegra_hv_ivc_cookie *hv_ivc = to_hv_ivc(channel->ivc);
 
-	free_irq(hv_ivc->irq, &hv_ivc);
+	if (threaded)
+		free_irq(hv_ivc->irq, hv_ivc);
 	tegra_hv_ivc_unreserve(hv_ivc);
 	kfree(hv_ivc);
 }
@@ -432,13 +483,14 @@ static void tegra186_hv_bpmp_deinit(struct tegra_bpmp *bpmp)
 {
 	unsigned int i;
 
-	tegra186_hv_bpmp_channel_cleanup(bpmp->tx_channel);
+	tegra186_hv_bpmp_channel_cleanup(bpmp->tx_channel, false);
 
 	if (bpmp->soc->channels.cpu_rx.count == MAX_POSSIBLE_RX_CHANNEL)
-		tegra186_hv_bpmp_channel_cleanup(bpmp->rx_channel);
+		tegra186_hv_bpmp_channel_cleanup(bpmp->rx_channel, true);
 
 	for (i = 0; i < bpmp->threaded.count; i++) {
-		tegra186_hv_bpmp_channel_cleanup(&bpmp->threaded_channels[i]);
+		tegra186_hv_bpmp_channel_cleanup(&bpmp->threaded_channels[i],
+						 true);
 	}
 }
 
@@ -556,6 +608,7 @@ static int tegra_bpmp_hv_probe(struct platform_device *pdev)
 {
 	struct tegra_bpmp *bpmp;
 	char tag[TAG_SZ];
+	unsigned int max_threads;
 	size_t size;
 	int err;
 
@@ -569,10 +622,11 @@ static int tegra_bpmp_hv_probe(struct platform_device *pdev)
 	INIT_LIST_HEAD(&bpmp->mrqs);
 	spin_lock_init(&bpmp->lock);
 
+	/* room for the extra threaded channels found by ops->init */
 	bpmp->threaded.count = bpmp->soc->channels.thread.count;
-	sema_init(&bpmp->threaded.lock, bpmp->threaded.count);
+	max_threads = bpmp->threaded.count + num_possible_cpus();
 
-	size = BITS_TO_LONGS(bpmp->threaded.count) * sizeof(long);
+	size = BITS_TO_LONGS(max_threads) * sizeof(long);
 
 	bpmp->threaded.allocated = devm_kzalloc(&pdev->dev, size, GFP_KERNEL);
 	if (!bpmp->threaded.allocated)
@@ -593,7 +647,7 @@ static int tegra_bpmp_hv_probe(struct platform_device *pdev)
 	if (!bpmp->rx_channel)
 		return -ENOMEM;
 
-	bpmp->threaded_channels = devm_kcalloc(&pdev->dev, bpmp->threaded.count,
+	bpmp->threaded_channels = devm_kcalloc(&pdev->dev, max_threads,
 					       sizeof(*bpmp->threaded_channels),
 					       GFP_KERNEL);
 	if (!bpmp->threaded_channels)
@@ -603,6 +657,9 @@ static int tegra_bpmp_hv_probe(struct platform_device *pdev)
 	if (err < 0)
 		return err;
 
+	sema_init(&bpmp->threaded.lock, bpmp->threaded.count);
+	dev_dbg(&pdev->dev, "%u threaded channels\n", bpmp->threaded.count);
+
 	err = tegra_bpmp_request_mrq(bpmp, MRQ_PING,
 				     tegra_bpmp_mrq_handle_ping, bpmp);
 	if (err < 0)
@@ -667,6 +724,8 @@ static int __maybe_unused tegra_bpmp_hv_resume(struct device *dev)
 {
 	struct tegra_bpmp *bpmp = dev_get_drvdata(dev);
 
+	tegra_bpmp_clk_invalidate(bpmp);
+
 	if (bpmp->soc->ops->resume)
 		return bpmp->soc->ops->resume(bpmp);
 	else
@@ -21,4 +21,6 @@ struct tegra_bpmp_ops {
 	int (*resume)(struct tegra_bpmp *bpmp);
 };
 
+void tegra_bpmp_clk_invalidate(struct tegra_bpmp *bpmp);
+
 #endif /* __BPMP_TEGRA186_HV_H */
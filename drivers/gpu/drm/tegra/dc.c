@@ -2294,7 +2294,8 @@ static void tegra_crtc_atomic_begin(struct drm_crtc *crtc,
 
 	tegra_crtc_update_memory_bandwidth(crtc, state, true);
 
-	if (crtc->state->event) {
+	/* async flips complete once latched, see tegra_crtc_atomic_flush() */
+	if (crtc->state->event && !crtc->state->async_flip) {
 		spin_lock_irqsave(&crtc->dev->event_lock, flags);
 
 		if (drm_crtc_vblank_get(crtc) != 0)
@@ -2324,6 +2325,18 @@ static void tegra_crtc_atomic_flush(struct drm_crtc *crtc,
 	value = dc_state->planes | GENERAL_ACT_REQ;
 	tegra_dc_writel(dc, value, DC_CMD_STATE_CONTROL);
 	value = tegra_dc_readl(dc, DC_CMD_STATE_CONTROL);
+
+	/*
+	 * Windows of an async flip are latched at the end of the current line,
+	 * so there is no point in holding the event back until VBLANK.
+	 */
+	if (crtc_state->async_flip && crtc_state->event) {
+		spin_lock_irq(&crtc->dev->event_lock);
+		drm_crtc_send_vblank_event(crtc, crtc_state->event);
+		spin_unlock_irq(&crtc->dev->event_lock);
+
+		crtc_state->event = NULL;
+	}
 }
 
 static bool tegra_plane_is_cursor(const struct drm_plane_state *state)
@@ -178,6 +178,7 @@ void drm_dp_link_update_rates(struct drm_dp_link *link)
 int drm_dp_link_probe(struct drm_dp_aux *aux, struct drm_dp_link *link)
 {
 	u8 dpcd[DP_RECEIVER_CAP_SIZE], value;
+	u8 sink[sizeof(link->cache.sink)];
 	unsigned int rd_interval;
 	int err;
 
@@ -187,6 +188,20 @@ int drm_dp_link_probe(struct drm_dp_aux *aux, struct drm_dp_link *link)
 	if (err < 0)
 		return err;
 
+	/* drop the cached training result if a different sink is connected */
+	memset(sink, 0, sizeof(sink));
+	memcpy(sink, dpcd, sizeof(dpcd));
+
+	err = drm_dp_dpcd_read(aux, DP_SINK_OUI, sink + sizeof(dpcd),
+			       sizeof(sink) - sizeof(dpcd));
+	if (err < 0)
+		DRM_DEBUG_KMS("failed to read sink ID: %d\n", err);
+
+	if (memcmp(link->cache.sink, sink, sizeof(sink)) != 0) {
+		link->cache.valid = false;
+		memcpy(link->cache.sink, sink, sizeof(sink));
+	}
+
 	link->revision = dpcd[DP_DPCD_REV];
 	link->max_rate = drm_dp_max_link_rate(dpcd);
 	link->max_lanes = drm_dp_max_lane_count(dpcd);
@@ -466,11 +481,6 @@ void drm_dp_link_train_init(struct drm_dp_link_train *train)
 	train->channel_equalized = false;
 }
 
-static bool drm_dp_link_train_valid(const struct drm_dp_link_train *train)
-{
-	return train->clock_recovered && train->channel_equalized;
-}
-
 static int drm_dp_link_apply_training(struct drm_dp_link *link)
 {
 	struct drm_dp_link_train_set *request = &link->train.request;
@@ -850,6 +860,38 @@ out:
 	return err;
 }
 
+/*
+ * Restores the rate, lane count and drive settings of the last successful
+ * training if it was done for the same sink and the same link configuration.
+ */
+static bool drm_dp_link_train_restore(struct drm_dp_link *link)
+{
+	struct drm_dp_link_train_cache *cache = &link->cache;
+
+	if (!cache->valid || cache->rate != link->rate ||
+	    cache->lanes != link->lanes)
+		return false;
+
+	link->rate = cache->trained_rate;
+	link->lanes = cache->trained_lanes;
+	link->train.request = cache->request;
+
+	return true;
+}
+
+static void drm_dp_link_train_save(struct drm_dp_link *link,
+				   unsigned int rate, unsigned int lanes)
+{
+	struct drm_dp_link_train_cache *cache = &link->cache;
+
+	cache->rate = rate;
+	cache->lanes = lanes;
+	cache->trained_rate = link->rate;
+	cache->trained_lanes = link->lanes;
+	cache->request = link->train.request;
+	cache->valid = true;
+}
+
 /**
  * drm_dp_link_train() - perform DisplayPort link training
  * @link: a DP link object
@@ -858,36 +900,53 @@ out:
  * is expected that drivers will call drm_dp_link_probe() to obtain the link
  * capabilities before performing link training.
  *
- * If the sink supports fast link training (no AUX CH handshake) and valid
- * training settings are available, this function will try to perform fast
- * link training and fall back to full link training on failure.
+ * If the same sink was trained successfully before with the same link
+ * configuration, the previous result is tried first: with fast link training
+ * (no AUX CH handshake) if the sink supports it, otherwise with full link
+ * training starting from the previous drive settings, which normally
+ * converges on the first iteration. Full link training from scratch is only
+ * performed if that fails.
  *
  * Returns: 0 on success or a negative error code on failure.
  */
 int drm_dp_link_train(struct drm_dp_link *link)
 {
+	unsigned int rate = link->rate, lanes = link->lanes;
 	int err;
 
 	drm_dp_link_train_init(&link->train);
 
-	if (link->caps.fast_training) {
-		if (drm_dp_link_train_valid(&link->train)) {
+	if (drm_dp_link_train_restore(link)) {
+		if (link->caps.fast_training) {
 			err = drm_dp_link_train_fast(link);
 			if (err < 0)
 				DRM_ERROR("fast link training failed: %d\n",
 					  err);
-			else
-				return 0;
 		} else {
-			DRM_DEBUG_KMS("training parameters not available\n");
+			err = drm_dp_link_train_full(link);
+			if (err < 0)
+				DRM_ERROR("cached link training failed: %d\n",
+					  err);
 		}
+
+		if (err == 0)
+			goto out;
+
+		link->cache.valid = false;
+		link->rate = rate;
+		link->lanes = lanes;
+		drm_dp_link_train_init(&link->train);
 	} else {
-		DRM_DEBUG_KMS("fast link training not supported\n");
+		DRM_DEBUG_KMS("training parameters not available\n");
 	}
 
 	err = drm_dp_link_train_full(link);
-	if (err < 0)
+	if (err < 0) {
 		DRM_ERROR("full link training failed: %d\n", err);
+		return err;
+	}
 
-	return err;
+out:
+	drm_dp_link_train_save(link, rate, lanes);
+	return 0;
 }
@@ -106,6 +106,28 @@ struct drm_dp_link_train {
 	bool channel_equalized;
 };
 
+/**
+ * struct drm_dp_link_train_cache - last successful link training result
+ * @valid: the cache holds a result for the sink identified by @sink
+ * @sink: receiver capabilities and sink OUI/device ID of the sink
+ * @rate: link rate chosen for the mode before training
+ * @lanes: number of lanes chosen for the mode before training
+ * @trained_rate: link rate the training succeeded at
+ * @trained_lanes: number of lanes the training succeeded with
+ * @request: drive settings the training succeeded with
+ */
+struct drm_dp_link_train_cache {
+	bool valid;
+	u8 sink[DP_RECEIVER_CAP_SIZE + 9];
+
+	unsigned int rate;
+	unsigned int lanes;
+
+	unsigned int trained_rate;
+	unsigned int trained_lanes;
+	struct drm_dp_link_train_set request;
+};
+
 /**
  * struct drm_dp_link - DP link capabilities and configuration
  * @revision: DP specification revision supported on the link
@@ -157,6 +179,12 @@ struct drm_dp_link {
 	 * @train: DP link training state
 	 */
 	struct drm_dp_link_train train;
+
+	/**
+	 * @cache: last successful training, kept across drm_dp_link_probe()
+	 * as long as the same sink is connected
+	 */
+	struct drm_dp_link_train_cache cache;
 };
 
 int drm_dp_link_add_rate(struct drm_dp_link *link, unsigned long rate);
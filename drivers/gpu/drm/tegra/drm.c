@@ -21,10 +21,12 @@
 #include <drm/drm_atomic_helper.h>
 #include <drm/drm_debugfs.h>
 #include <drm/drm_drv.h>
+#include <drm/drm_file.h>
 #include <drm/drm_fourcc.h>
 #include <drm/drm_framebuffer.h>
 #include <drm/drm_ioctl.h>
 #include <drm/drm_prime.h>
+#include <drm/drm_print.h>
 #include <drm/drm_vblank.h>
 #include <drm/tegra_drm-next.h>
 
@@ -79,6 +81,20 @@ static void tegra_atomic_post_commit(struct drm_device *drm,
 		tegra_crtc_atomic_post_commit(crtc, old_state);
 }
 
+/* Async flips are not synchronized to VBLANK, so don't wait for one either. */
+static bool tegra_atomic_is_async_flip(struct drm_atomic_state *state)
+{
+	struct drm_crtc_state *crtc_state;
+	struct drm_crtc *crtc;
+	unsigned int i;
+
+	for_each_new_crtc_in_state(state, crtc, crtc_state, i)
+		if (!crtc_state->async_flip)
+			return false;
+
+	return true;
+}
+
 static void tegra_atomic_commit_tail(struct drm_atomic_state *old_state)
 {
 	struct drm_device *drm = old_state->dev;
@@ -93,7 +109,12 @@ static void tegra_atomic_commit_tail(struct drm_atomic_state *old_state)
 		drm_atomic_helper_commit_modeset_enables(drm, old_state);
 		drm_atomic_helper_commit_hw_done(old_state);
 		dma_fence_end_signalling(fence_cookie);
-		drm_atomic_helper_wait_for_vblanks(drm, old_state);
+
+		if (tegra_atomic_is_async_flip(old_state))
+			drm_atomic_helper_wait_for_flip_done(drm, old_state);
+		else
+			drm_atomic_helper_wait_for_vblanks(drm, old_state);
+
 		drm_atomic_helper_cleanup_planes(drm, old_state);
 	} else {
 		drm_atomic_helper_commit_tail_rpm(old_state);
@@ -110,11 +131,18 @@ tegra_drm_mode_config_helpers = {
 static int tegra_drm_open(struct drm_device *drm, struct drm_file *filp)
 {
 	struct tegra_drm_file *fpriv;
+	int err;
 
 	fpriv = kzalloc(sizeof(*fpriv), GFP_KERNEL);
 	if (!fpriv)
 		return -ENOMEM;
 
+	err = tegra_drm_uapi_open_file(fpriv);
+	if (err < 0) {
+		kfree(fpriv);
+		return err;
+	}
+
 	idr_init_base(&fpriv->legacy_contexts, 1);
 	xa_init_flags(&fpriv->contexts, XA_FLAGS_ALLOC1);
 	xa_init(&fpriv->syncpoints);
@@ -760,6 +788,12 @@ static const struct drm_ioctl_desc tegra_drm_ioctls[] = {
 			  DRM_RENDER_ALLOW),
 	DRM_IOCTL_DEF_DRV(TEGRA_CHANNEL_SUBMIT, tegra_drm_ioctl_channel_submit,
 			  DRM_RENDER_ALLOW),
+	DRM_IOCTL_DEF_DRV(TEGRA_CHANNEL_JOB_CREATE, tegra_drm_ioctl_channel_job_create,
+			  DRM_RENDER_ALLOW),
+	DRM_IOCTL_DEF_DRV(TEGRA_CHANNEL_JOB_SUBMIT, tegra_drm_ioctl_channel_job_submit,
+			  DRM_RENDER_ALLOW),
+	DRM_IOCTL_DEF_DRV(TEGRA_CHANNEL_JOB_DESTROY, tegra_drm_ioctl_channel_job_destroy,
+			  DRM_RENDER_ALLOW),
 	DRM_IOCTL_DEF_DRV(TEGRA_SYNCPOINT_ALLOCATE, tegra_drm_ioctl_syncpoint_allocate,
 			  DRM_RENDER_ALLOW),
 	DRM_IOCTL_DEF_DRV(TEGRA_SYNCPOINT_FREE, tegra_drm_ioctl_syncpoint_free,
@@ -805,6 +839,9 @@ static const struct file_operations tegra_drm_fops = {
 	.read = drm_read,
 	.compat_ioctl = drm_compat_ioctl,
 	.llseek = noop_llseek,
+#if defined(NV_DRM_DRIVER_STRUCT_HAS_SHOW_FDINFO) /* Linux v6.5 */
+	.show_fdinfo = drm_show_fdinfo,
+#endif
 };
 
 static int tegra_drm_context_cleanup(int id, void *p, void *data)
@@ -830,6 +867,15 @@ static void tegra_drm_postclose(struct drm_device *drm, struct drm_file *file)
 	kfree(fpriv);
 }
 
+#if defined(NV_DRM_DRIVER_STRUCT_HAS_SHOW_FDINFO) /* Linux v6.5 */
+static void tegra_drm_show_fdinfo(struct drm_printer *p, struct drm_file *file)
+{
+	struct tegra_drm *tegra = file->minor->dev->dev_private;
+
+	tegra_drm_uapi_show_fdinfo(tegra, file->driver_priv, p);
+}
+#endif
+
 #ifdef CONFIG_DEBUG_FS
 static int tegra_debugfs_framebuffers(struct seq_file *s, void *data)
 {
@@ -887,6 +933,9 @@ static const struct drm_driver tegra_drm_driver = {
 	.open = tegra_drm_open,
 	.postclose = tegra_drm_postclose,
 	.lastclose = drm_fb_helper_lastclose,
+#if defined(NV_DRM_DRIVER_STRUCT_HAS_SHOW_FDINFO) /* Linux v6.5 */
+	.show_fdinfo = tegra_drm_show_fdinfo,
+#endif
 
 #if defined(CONFIG_DEBUG_FS)
 	.debugfs_init = tegra_debugfs_init,
@@ -925,6 +974,8 @@ int tegra_drm_register_client(struct tegra_drm *tegra,
 	if (!client->shared_channel)
 		return -EBUSY;
 
+	tegra_drm_sched_init(&client->sched);
+
 	mutex_lock(&tegra->clients_lock);
 	list_add_tail(&client->list, &tegra->clients);
 	client->drm = tegra;
@@ -1320,12 +1371,24 @@ static int host1x_drm_probe(struct host1x_device *dev)
 	if (err < 0)
 		goto hub;
 
-	err = drm_dev_register(drm, 0);
+	err = tegra_drm_mapping_cache_init(tegra);
 	if (err < 0)
 		goto fb;
 
+	err = tegra_bo_page_pool_init(tegra);
+	if (err < 0)
+		goto mapping_cache;
+
+	err = drm_dev_register(drm, 0);
+	if (err < 0)
+		goto page_pool;
+
 	return 0;
 
+page_pool:
+	tegra_bo_page_pool_fini(tegra);
+mapping_cache:
+	tegra_drm_mapping_cache_fini(tegra);
 fb:
 	tegra_drm_fb_exit(drm);
 hub:
@@ -1383,6 +1446,8 @@ static int host1x_drm_remove(struct host1x_device *dev)
 		iommu_domain_free(tegra->domain);
 	}
 
+	tegra_bo_page_pool_fini(tegra);
+	tegra_drm_mapping_cache_fini(tegra);
 	kfree(tegra);
 	drm_dev_put(drm);
 
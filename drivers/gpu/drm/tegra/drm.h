@@ -22,12 +22,15 @@
 
 #include "gem.h"
 #include "hub.h"
+#include "sched.h"
 #include <trace/events/trace.h>
 
 /* XXX move to include/uapi/drm/drm_fourcc.h? */
 #define DRM_FORMAT_MOD_NVIDIA_SECTOR_LAYOUT BIT_ULL(22)
 
 struct reset_control;
+struct tegra_drm_mapping_cache;
+struct tegra_bo_page_pool;
 
 #ifdef CONFIG_DRM_FBDEV_EMULATION
 struct tegra_fbdev {
@@ -62,6 +65,9 @@ struct tegra_drm {
 	unsigned int num_crtcs;
 
 	struct tegra_display_hub *hub;
+
+	struct tegra_drm_mapping_cache *mapping_cache;
+	struct tegra_bo_page_pool *page_pool;
 };
 
 static inline struct host1x *tegra_drm_to_host1x(struct tegra_drm *tegra)
@@ -70,6 +76,8 @@ static inline struct host1x *tegra_drm_to_host1x(struct tegra_drm *tegra)
 }
 
 struct tegra_drm_client;
+struct tegra_drm_dvfs;
+struct tegra_drm_fw_cache;
 
 struct tegra_drm_context {
 	struct tegra_drm_client *client;
@@ -80,7 +88,13 @@ struct tegra_drm_context {
 
 	/* Only used by new UAPI. */
 	struct xarray mappings;
+	struct xarray jobs;
+	struct tegra_drm_fw_cache *fw_cache;
+	struct list_head cached_mappings;
+	size_t cached_mappings_size;
+	struct list_head mapping_cache_node;
 	struct host1x_memory_context *memory_context;
+	struct tegra_drm_sched_entity *sched_entity;
 };
 
 struct tegra_drm_client_ops {
@@ -109,15 +123,31 @@ tegra_drm_get_streamid_offset_thi(struct tegra_drm_client *client, u32 *offset)
 	return 0;
 }
 
+/* Engine types that job usage is accounted to, see drm-usage-stats */
+enum tegra_drm_engine {
+	TEGRA_DRM_ENGINE_NONE,
+	TEGRA_DRM_ENGINE_GR2D,
+	TEGRA_DRM_ENGINE_GR3D,
+	TEGRA_DRM_ENGINE_VIC,
+	TEGRA_DRM_ENGINE_NVDEC,
+	TEGRA_DRM_ENGINE_NVENC,
+	TEGRA_DRM_ENGINE_NVJPG,
+	TEGRA_DRM_ENGINE_OFA,
+	TEGRA_DRM_NUM_ENGINES
+};
+
 struct tegra_drm_client {
 	struct host1x_client base;
 	struct list_head list;
 	struct tegra_drm *drm;
 	struct host1x_channel *shared_channel;
+	struct tegra_drm_sched sched;
 
 	/* Set by driver */
 	unsigned int version;
 	const struct tegra_drm_client_ops *ops;
+	struct tegra_drm_dvfs *dvfs;
+	enum tegra_drm_engine engine;
 };
 
 static inline struct tegra_drm_client *
@@ -0,0 +1,348 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024, NVIDIA Corporation.
+ */
+
+#include <linux/clk.h>
+#include <linux/device.h>
+#include <linux/math64.h>
+#include <linux/of.h>
+#include <linux/pm_opp.h>
+
+#include "dvfs.h"
+
+/* Run the queued jobs within about one 60 Hz frame by default */
+#define TEGRA_DRM_DVFS_BOOST_WINDOW_US	16000
+#define TEGRA_DRM_DVFS_BOOST_HOLD_MS	100
+
+static void tegra_drm_dvfs_devres_release(struct device *dev, void *res)
+{
+}
+
+/* The devfreq profile callbacks only get the engine device */
+static struct tegra_drm_dvfs *dev_to_dvfs(struct device *dev)
+{
+	struct tegra_drm_dvfs **ptr;
+
+	ptr = devres_find(dev, tegra_drm_dvfs_devres_release, NULL, NULL);
+
+	return ptr ? *ptr : NULL;
+}
+
+static void tegra_drm_dvfs_update_wmark_threshold(struct devfreq *devfreq,
+						  struct devfreq_tegra_wmark_config *cfg)
+{
+	struct tegra_drm_dvfs *dvfs = container_of(devfreq->data,
+						   struct tegra_drm_dvfs, wmark);
+
+	host1x_actmon_update_active_wmark(dvfs->client,
+					  cfg->avg_upper_wmark,
+					  cfg->avg_lower_wmark,
+					  cfg->consec_upper_wmark,
+					  cfg->consec_lower_wmark,
+					  cfg->upper_wmark_enabled,
+					  cfg->lower_wmark_enabled);
+}
+
+static int tegra_drm_dvfs_target(struct device *dev, unsigned long *freq, u32 flags)
+{
+	struct tegra_drm_dvfs *dvfs = dev_to_dvfs(dev);
+	int err;
+
+	if (dvfs->set_rate)
+		err = dvfs->set_rate(dev, *freq);
+	else
+		err = clk_set_rate(dvfs->clk, *freq);
+	if (err < 0) {
+		dev_err(dev, "failed to set clock rate\n");
+		return err;
+	}
+
+	*freq = clk_get_rate(dvfs->clk);
+
+	return 0;
+}
+
+static int tegra_drm_dvfs_get_dev_status(struct device *dev,
+					 struct devfreq_dev_status *stat)
+{
+	struct tegra_drm_dvfs *dvfs = dev_to_dvfs(dev);
+	unsigned long usage;
+
+	/* Update load information */
+	host1x_actmon_read_active_norm(dvfs->client, &usage);
+	stat->total_time = dvfs->total_time;
+	stat->busy_time = usage;
+
+	/* Update device frequency */
+	stat->current_frequency = clk_get_rate(dvfs->clk);
+
+	return 0;
+}
+
+static int tegra_drm_dvfs_get_cur_freq(struct device *dev, unsigned long *freq)
+{
+	struct tegra_drm_dvfs *dvfs = dev_to_dvfs(dev);
+
+	*freq = clk_get_rate(dvfs->clk);
+
+	return 0;
+}
+
+static void tegra_drm_dvfs_boost_release(struct work_struct *work)
+{
+	struct tegra_drm_dvfs *dvfs = container_of(to_delayed_work(work),
+						   struct tegra_drm_dvfs,
+						   boost_release);
+	unsigned long flags;
+	bool idle;
+
+	mutex_lock(&dvfs->boost_lock);
+
+	spin_lock_irqsave(&dvfs->lock, flags);
+	idle = !dvfs->queued;
+	spin_unlock_irqrestore(&dvfs->lock, flags);
+
+	/* Leave the clock to the actmon watermarks again */
+	if (idle)
+		dev_pm_qos_update_request(&dvfs->boost_req,
+					  PM_QOS_MIN_FREQUENCY_DEFAULT_VALUE);
+
+	mutex_unlock(&dvfs->boost_lock);
+}
+
+int tegra_drm_dvfs_init(struct tegra_drm_dvfs *dvfs)
+{
+	struct device *dev = dvfs->dev;
+	unsigned long max_rate = clk_round_rate(dvfs->clk, ULONG_MAX);
+	unsigned long min_rate = clk_round_rate(dvfs->clk, 0);
+	unsigned long margin = clk_round_rate(dvfs->clk, min_rate + 1) - min_rate;
+	unsigned long rate = min_rate;
+	struct tegra_drm_dvfs **ptr;
+	struct devfreq *devfreq;
+	int err;
+
+	spin_lock_init(&dvfs->lock);
+	mutex_init(&dvfs->boost_lock);
+	INIT_DELAYED_WORK(&dvfs->boost_release, tegra_drm_dvfs_boost_release);
+
+	dvfs->boost_window_us = TEGRA_DRM_DVFS_BOOST_WINDOW_US;
+	of_property_read_u32(dev->of_node, "nvidia,dvfs-boost-window-us",
+			     &dvfs->boost_window_us);
+	dvfs->boost_hold_ms = TEGRA_DRM_DVFS_BOOST_HOLD_MS;
+
+	while (rate <= max_rate) {
+		dev_pm_opp_add(dev, rate, 0);
+		rate += margin;
+	}
+
+	ptr = devres_alloc(tegra_drm_dvfs_devres_release, sizeof(*ptr),
+			   GFP_KERNEL);
+	if (!ptr)
+		return -ENOMEM;
+
+	*ptr = dvfs;
+	devres_add(dev, ptr);
+
+	dvfs->wmark.event = DEVFREQ_TEGRA_AVG_WMARK_BELOW;
+	dvfs->wmark.update_wmark_threshold = tegra_drm_dvfs_update_wmark_threshold;
+
+	dvfs->profile.target = tegra_drm_dvfs_target;
+	dvfs->profile.get_dev_status = tegra_drm_dvfs_get_dev_status;
+	dvfs->profile.get_cur_freq = tegra_drm_dvfs_get_cur_freq;
+	dvfs->profile.initial_freq = max_rate;
+	dvfs->profile.polling_ms = 100;
+
+	devfreq = devm_devfreq_add_device(dev, &dvfs->profile,
+					  DEVFREQ_GOV_USERSPACE, &dvfs->wmark);
+	if (IS_ERR(devfreq)) {
+		err = PTR_ERR(devfreq);
+		goto release;
+	}
+
+	err = dev_pm_qos_add_request(dev, &dvfs->boost_req,
+				     DEV_PM_QOS_MIN_FREQUENCY,
+				     PM_QOS_MIN_FREQUENCY_DEFAULT_VALUE);
+	if (err < 0) {
+		devm_devfreq_remove_device(dev, devfreq);
+		goto release;
+	}
+
+	dvfs->devfreq = devfreq;
+
+	return 0;
+
+release:
+	devres_release(dev, tegra_drm_dvfs_devres_release, NULL, NULL);
+	return err;
+}
+
+void tegra_drm_dvfs_exit(struct tegra_drm_dvfs *dvfs)
+{
+	if (!dvfs->devfreq)
+		return;
+
+	cancel_delayed_work_sync(&dvfs->boost_release);
+	dev_pm_qos_remove_request(&dvfs->boost_req);
+
+	devm_devfreq_remove_device(dvfs->dev, dvfs->devfreq);
+	dvfs->devfreq = NULL;
+
+	devres_release(dvfs->dev, tegra_drm_dvfs_devres_release, NULL, NULL);
+}
+
+int tegra_drm_dvfs_resume(struct tegra_drm_dvfs *dvfs)
+{
+	/* Forcely set frequency as Fmax when device is resumed back */
+	dvfs->devfreq->resume_freq = dvfs->devfreq->scaling_max_freq;
+
+	return devfreq_resume_device(dvfs->devfreq);
+}
+
+int tegra_drm_dvfs_suspend(struct tegra_drm_dvfs *dvfs)
+{
+	return devfreq_suspend_device(dvfs->devfreq);
+}
+
+void tegra_drm_dvfs_actmon_event(struct tegra_drm_dvfs *dvfs,
+				 enum host1x_actmon_wmark_event event)
+{
+	struct devfreq *df = dvfs->devfreq;
+
+	if (!df)
+		return;
+
+	switch (event) {
+	case HOST1X_ACTMON_AVG_WMARK_BELOW:
+		dvfs->wmark.event = DEVFREQ_TEGRA_AVG_WMARK_BELOW;
+		break;
+	case HOST1X_ACTMON_AVG_WMARK_ABOVE:
+		dvfs->wmark.event = DEVFREQ_TEGRA_AVG_WMARK_ABOVE;
+		break;
+	case HOST1X_ACTMON_CONSEC_WMARK_BELOW:
+		dvfs->wmark.event = DEVFREQ_TEGRA_CONSEC_WMARK_BELOW;
+		break;
+	case HOST1X_ACTMON_CONSEC_WMARK_ABOVE:
+		dvfs->wmark.event = DEVFREQ_TEGRA_CONSEC_WMARK_ABOVE;
+		break;
+	default:
+		return;
+	}
+
+	mutex_lock(&df->lock);
+	update_devfreq(df);
+	mutex_unlock(&df->lock);
+}
+
+/*
+ * Called before a job is handed to host1x. The clock floor is raised so
+ * that all queued jobs, this one included, complete within the boost
+ * window, or within the job's deadline if it has one. Each queued job
+ * counts with its expected cycles, or the recent average cycles per job
+ * of the engine. Reactive actmon scaling only catches up after the
+ * watermark period, which is too late for the first frames of a burst.
+ *
+ * Jobs run in order on the engine channel, so a latency critical job is
+ * only helped by running everything queued ahead of it faster. The floor
+ * is not lowered while a job with a deadline is outstanding.
+ */
+void tegra_drm_dvfs_job_submit(struct tegra_drm_dvfs *dvfs,
+			       struct tegra_drm_dvfs_job *job,
+			       u64 expected_cycles, u32 deadline_us)
+{
+	unsigned long flags;
+	u64 cycles, khz;
+	bool raise_only;
+	u32 window_us;
+
+	if (!dvfs || !dvfs->devfreq)
+		return;
+
+	window_us = deadline_us ?: dvfs->boost_window_us;
+
+	spin_lock_irqsave(&dvfs->lock, flags);
+
+	raise_only = dvfs->deadline_jobs > 0;
+
+	job->cycles = expected_cycles ?: dvfs->avg_cycles;
+	job->deadline = deadline_us != 0;
+	job->submitted = ktime_get();
+
+	dvfs->queued++;
+	dvfs->queued_cycles += job->cycles;
+	if (job->deadline)
+		dvfs->deadline_jobs++;
+	cycles = dvfs->queued_cycles;
+
+	spin_unlock_irqrestore(&dvfs->lock, flags);
+
+	if (!window_us || !cycles)
+		return;
+
+	/* cycles per window in kHz */
+	khz = min_t(u64, div_u64(cycles * 1000, window_us), S32_MAX);
+
+	mutex_lock(&dvfs->boost_lock);
+	if (!raise_only || khz > dev_pm_qos_read_value(dvfs->dev,
+						       DEV_PM_QOS_MIN_FREQUENCY))
+		dev_pm_qos_update_request(&dvfs->boost_req, khz);
+	mutex_unlock(&dvfs->boost_lock);
+}
+
+/*
+ * Called once the job has been retired, or with completed set to false if
+ * it never reached the hardware. Jobs of an engine run in order, so the
+ * job was busy from the later of its submission and the previous
+ * completion. Returns that busy time in nanoseconds, zero if the job was
+ * not tracked or not completed.
+ */
+u64 tegra_drm_dvfs_job_done(struct tegra_drm_dvfs *dvfs,
+			    struct tegra_drm_dvfs_job *job, bool completed)
+{
+	ktime_t now = ktime_get();
+	u64 busy_ns = 0, cycles;
+	unsigned long flags;
+	ktime_t start;
+	bool idle;
+
+	if (!dvfs || !dvfs->devfreq || !job->submitted)
+		return 0;
+
+	spin_lock_irqsave(&dvfs->lock, flags);
+
+	if (!WARN_ON(!dvfs->queued))
+		dvfs->queued--;
+	dvfs->queued_cycles -= min(job->cycles, dvfs->queued_cycles);
+	if (job->deadline && !WARN_ON(!dvfs->deadline_jobs))
+		dvfs->deadline_jobs--;
+
+	if (completed) {
+		start = ktime_after(job->submitted, dvfs->last_done) ?
+			job->submitted : dvfs->last_done;
+		busy_ns = ktime_to_ns(ktime_sub(now, start));
+		cycles = mul_u64_u64_div_u64(busy_ns,
+					     READ_ONCE(dvfs->devfreq->previous_freq),
+					     NSEC_PER_SEC);
+
+		/* Exponential average with a weight of 1/8 per job */
+		if (dvfs->avg_cycles)
+			dvfs->avg_cycles += div_s64((s64)cycles -
+						    (s64)dvfs->avg_cycles, 8);
+		else
+			dvfs->avg_cycles = cycles;
+
+		dvfs->last_done = now;
+	}
+
+	idle = !dvfs->queued;
+
+	spin_unlock_irqrestore(&dvfs->lock, flags);
+
+	job->submitted = 0;
+
+	if (idle)
+		mod_delayed_work(system_wq, &dvfs->boost_release,
+				 msecs_to_jiffies(dvfs->boost_hold_ms));
+
+	return busy_ns;
+}
@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024, NVIDIA Corporation.
+ */
+
+#ifndef _TEGRA_DRM_DVFS_H_
+#define _TEGRA_DRM_DVFS_H_
+
+#include <linux/devfreq.h>
+#include <linux/devfreq/tegra_wmark.h>
+#include <linux/host1x-next.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
+#include <linux/pm_qos.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+
+struct clk;
+
+/*
+ * Engine clock scaling shared by the host1x multimedia clients. The
+ * devfreq device is driven reactively from the actmon watermarks and,
+ * on top of that, boosted at job submit time: the engine clock floor is
+ * raised to run the queued jobs within boost_window_us or the deadline
+ * hinted by userspace, estimated from the hinted or the recent per-job
+ * cycle count of the engine.
+ */
+struct tegra_drm_dvfs {
+	/* Set by the engine driver */
+	struct device *dev;
+	struct host1x_client *client;
+	struct clk *clk;
+	int (*set_rate)(struct device *dev, unsigned long rate);
+	unsigned long total_time;
+
+	struct devfreq *devfreq;
+	struct devfreq_dev_profile profile;
+	struct devfreq_tegra_wmark_data wmark;
+
+	/* Predictive boost */
+	struct dev_pm_qos_request boost_req;
+	struct mutex boost_lock;
+	struct delayed_work boost_release;
+	spinlock_t lock;
+	unsigned int queued;
+	unsigned int deadline_jobs;
+	u64 queued_cycles;
+	ktime_t last_done;
+	u64 avg_cycles;
+	u32 boost_window_us;
+	u32 boost_hold_ms;
+};
+
+/* Per-job state, zero until the job has been submitted */
+struct tegra_drm_dvfs_job {
+	ktime_t submitted;
+	u64 cycles;
+	bool deadline;
+};
+
+int tegra_drm_dvfs_init(struct tegra_drm_dvfs *dvfs);
+void tegra_drm_dvfs_exit(struct tegra_drm_dvfs *dvfs);
+int tegra_drm_dvfs_resume(struct tegra_drm_dvfs *dvfs);
+int tegra_drm_dvfs_suspend(struct tegra_drm_dvfs *dvfs);
+void tegra_drm_dvfs_actmon_event(struct tegra_drm_dvfs *dvfs,
+				 enum host1x_actmon_wmark_event event);
+void tegra_drm_dvfs_job_submit(struct tegra_drm_dvfs *dvfs,
+			       struct tegra_drm_dvfs_job *job,
+			       u64 expected_cycles, u32 deadline_us);
+u64 tegra_drm_dvfs_job_done(struct tegra_drm_dvfs *dvfs,
+			    struct tegra_drm_dvfs_job *job, bool completed);
+
+#endif /* _TEGRA_DRM_DVFS_H_ */
@@ -1,10 +1,44 @@
 // SPDX-License-Identifier: GPL-2.0-only
 /* Copyright (c) 2010-2020 NVIDIA Corporation */
 
+#include <linux/slab.h>
+#include <linux/string.h>
+
 #include "drm.h"
 #include "submit.h"
 #include "uapi.h"
 
+/*
+ * Number of validated gathers remembered per channel context. Fixed pipelines
+ * submit the same few command streams over and over, so a handful is enough.
+ */
+#define TEGRA_DRM_FW_CACHE_ENTRIES 4
+
+struct tegra_drm_fw_range {
+	dma_addr_t start;
+	dma_addr_t end;
+};
+
+/*
+ * A gather that passed validation. The result only depends on the gather
+ * words, the class at the start of the gather and the address ranges of the
+ * mappings used by the job, so all of those are kept and compared exactly.
+ */
+struct tegra_drm_fw_cache_entry {
+	u32 *data;
+	u32 words;
+	u32 class_in;
+	u32 class_out;
+	struct tegra_drm_fw_range *ranges;
+	u32 num_ranges;
+	unsigned long last_used;
+};
+
+struct tegra_drm_fw_cache {
+	struct tegra_drm_fw_cache_entry entries[TEGRA_DRM_FW_CACHE_ENTRIES];
+	unsigned long clock;
+};
+
 struct tegra_drm_firewall {
 	struct tegra_drm_submit_data *submit;
 	struct tegra_drm_client *client;
@@ -141,9 +175,9 @@ enum {
 	HOST1X_OPCODE_EXTEND    = 0x0e,
 };
 
-int tegra_drm_fw_validate(struct tegra_drm_client *client, u32 *data, u32 start,
-			  u32 words, struct tegra_drm_submit_data *submit,
-			  u32 *job_class)
+static int fw_validate(struct tegra_drm_client *client, u32 *data, u32 start,
+		       u32 words, struct tegra_drm_submit_data *submit,
+		       u32 *job_class)
 {
 	struct tegra_drm_firewall fw = {
 		.submit = submit,
@@ -255,3 +289,145 @@ int tegra_drm_fw_validate(struct tegra_drm_client *client, u32 *data, u32 start,
 
 	return 0;
 }
+
+static bool fw_cache_ranges_match(struct tegra_drm_fw_cache_entry *entry,
+				  struct tegra_drm_submit_data *submit)
+{
+	u32 i;
+
+	if (entry->num_ranges != submit->num_used_mappings)
+		return false;
+
+	for (i = 0; i < entry->num_ranges; i++) {
+		struct tegra_drm_mapping *m = submit->used_mappings[i].mapping;
+
+		if (entry->ranges[i].start != m->iova || entry->ranges[i].end != m->iova_end)
+			return false;
+	}
+
+	return true;
+}
+
+static struct tegra_drm_fw_cache_entry *
+fw_cache_lookup(struct tegra_drm_fw_cache *cache, u32 *data, u32 start, u32 words,
+		struct tegra_drm_submit_data *submit, u32 class)
+{
+	unsigned int i;
+
+	for (i = 0; i < TEGRA_DRM_FW_CACHE_ENTRIES; i++) {
+		struct tegra_drm_fw_cache_entry *entry = &cache->entries[i];
+
+		if (!entry->data || entry->words != words || entry->class_in != class)
+			continue;
+
+		if (!fw_cache_ranges_match(entry, submit))
+			continue;
+
+		if (memcmp(entry->data, data + start, words * sizeof(u32)))
+			continue;
+
+		entry->last_used = ++cache->clock;
+
+		return entry;
+	}
+
+	return NULL;
+}
+
+static void fw_cache_entry_free(struct tegra_drm_fw_cache_entry *entry)
+{
+	kvfree(entry->data);
+	kfree(entry->ranges);
+	memset(entry, 0, sizeof(*entry));
+}
+
+static void fw_cache_insert(struct tegra_drm_fw_cache *cache, u32 *data, u32 start, u32 words,
+			    struct tegra_drm_submit_data *submit, u32 class_in, u32 class_out)
+{
+	struct tegra_drm_fw_cache_entry *entry = &cache->entries[0];
+	unsigned int i;
+
+	/* Reuse a free slot if there is one, otherwise evict the least recently used. */
+	for (i = 0; i < TEGRA_DRM_FW_CACHE_ENTRIES; i++) {
+		if (!cache->entries[i].data) {
+			entry = &cache->entries[i];
+			break;
+		}
+
+		if (cache->entries[i].last_used < entry->last_used)
+			entry = &cache->entries[i];
+	}
+
+	fw_cache_entry_free(entry);
+
+	entry->data = kvmalloc_array(words, sizeof(u32), GFP_KERNEL);
+	if (!entry->data)
+		return;
+
+	if (submit->num_used_mappings) {
+		entry->ranges = kcalloc(submit->num_used_mappings, sizeof(*entry->ranges),
+					GFP_KERNEL);
+		if (!entry->ranges) {
+			fw_cache_entry_free(entry);
+			return;
+		}
+	}
+
+	for (i = 0; i < submit->num_used_mappings; i++) {
+		struct tegra_drm_mapping *m = submit->used_mappings[i].mapping;
+
+		entry->ranges[i].start = m->iova;
+		entry->ranges[i].end = m->iova_end;
+	}
+
+	memcpy(entry->data, data + start, words * sizeof(u32));
+	entry->num_ranges = submit->num_used_mappings;
+	entry->words = words;
+	entry->class_in = class_in;
+	entry->class_out = class_out;
+	entry->last_used = ++cache->clock;
+}
+
+int tegra_drm_fw_validate(struct tegra_drm_context *context, u32 *data, u32 start,
+			  u32 words, struct tegra_drm_submit_data *submit,
+			  u32 *job_class)
+{
+	struct tegra_drm_fw_cache_entry *entry;
+	u32 class = *job_class;
+	int err;
+
+	if (!context->fw_cache)
+		context->fw_cache = kzalloc(sizeof(*context->fw_cache), GFP_KERNEL);
+
+	/* Without a cache, fall back to validating every time. */
+	if (!context->fw_cache)
+		return fw_validate(context->client, data, start, words, submit, job_class);
+
+	entry = fw_cache_lookup(context->fw_cache, data, start, words, submit, class);
+	if (entry) {
+		*job_class = entry->class_out;
+		return 0;
+	}
+
+	err = fw_validate(context->client, data, start, words, submit, job_class);
+	if (err)
+		return err;
+
+	fw_cache_insert(context->fw_cache, data, start, words, submit, class, *job_class);
+
+	return 0;
+}
+
+void tegra_drm_fw_cache_free(struct tegra_drm_context *context)
+{
+	unsigned int i;
+
+	if (!context->fw_cache)
+		return;
+
+	for (i = 0; i < TEGRA_DRM_FW_CACHE_ENTRIES; i++)
+		fw_cache_entry_free(&context->fw_cache->entries[i]);
+
+	kfree(context->fw_cache);
+	context->fw_cache = NULL;
+}
@@ -13,8 +13,14 @@
 #include <nvidia/conftest.h>
 
 #include <linux/dma-buf.h>
+#include <linux/highmem.h>
 #include <linux/iommu.h>
+#include <linux/list.h>
 #include <linux/module.h>
+#include <linux/shrinker.h>
+#include <linux/sizes.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
 
 #include <drm/drm_drv.h>
 #include <drm/drm_prime.h>
@@ -230,6 +236,17 @@ static const struct host1x_bo_ops tegra_bo_ops = {
 	.munmap = tegra_bo_munmap,
 };
 
+/*
+ * Align the I/O virtual address to the largest IOMMU page size that fits
+ * the buffer, so that physically contiguous chunks get mapped with it.
+ */
+static unsigned long tegra_bo_iova_align(struct tegra_drm *tegra, size_t size)
+{
+	unsigned long pgsizes = tegra->domain->pgsize_bitmap & GENMASK(__fls(size), 0);
+
+	return pgsizes ? max(1UL << __fls(pgsizes), PAGE_SIZE) : PAGE_SIZE;
+}
+
 static int tegra_bo_iommu_map(struct tegra_drm *tegra, struct tegra_bo *bo)
 {
 	int prot = IOMMU_READ | IOMMU_WRITE;
@@ -244,8 +261,8 @@ static int tegra_bo_iommu_map(struct tegra_drm *tegra, struct tegra_bo *bo)
 
 	mutex_lock(&tegra->mm_lock);
 
-	err = drm_mm_insert_node_generic(&tegra->mm,
-					 bo->mm, bo->gem.size, PAGE_SIZE, 0, 0);
+	err = drm_mm_insert_node_generic(&tegra->mm, bo->mm, bo->gem.size,
+					 tegra_bo_iova_align(tegra, bo->gem.size), 0, 0);
 	if (err < 0) {
 		dev_err(tegra->drm->dev, "out of I/O virtual memory: %d\n",
 			err);
@@ -326,11 +343,327 @@ free:
 	return ERR_PTR(err);
 }
 
+/*
+ * Pages of freed buffer objects are kept in a pool and cleared from a worker,
+ * so that frequent buffer churn (for example Wayland clients reallocating
+ * their buffers) doesn't pay for page allocation and zeroing inline. The pool
+ * holds up to page_pool_size bytes and is drained by a shrinker under memory
+ * pressure.
+ */
+static unsigned long page_pool_size = SZ_64M;
+module_param(page_pool_size, ulong, 0644);
+MODULE_PARM_DESC(page_pool_size,
+		 "Bytes of freed buffer object pages kept for reuse (0 to disable)");
+
+struct tegra_bo_page_pool {
+	spinlock_t lock;
+	/* Pages waiting to be cleared and pages ready for reuse */
+	struct list_head dirty;
+	struct list_head clean;
+	unsigned long count;
+
+	struct work_struct clear_work;
+
+#if defined(NV_SHRINKER_ALLOC_PRESENT) /* Linux 6.7 */
+	struct shrinker *shrinker;
+#else
+	struct shrinker shrinker;
+#endif
+};
+
+static struct page *tegra_bo_page_pool_get(struct tegra_bo_page_pool *pool)
+{
+	struct page *page;
+
+	spin_lock(&pool->lock);
+
+	page = list_first_entry_or_null(&pool->clean, struct page, lru);
+	if (page) {
+		list_del(&page->lru);
+		pool->count--;
+	}
+
+	spin_unlock(&pool->lock);
+
+	return page;
+}
+
+static void tegra_bo_page_pool_put(struct tegra_bo_page_pool *pool, struct page **pages,
+				   unsigned long num_pages)
+{
+	unsigned long limit = READ_ONCE(page_pool_size) >> PAGE_SHIFT;
+	unsigned long i;
+
+	spin_lock(&pool->lock);
+
+	for (i = 0; i < num_pages && pool->count < limit; i++) {
+		list_add_tail(&pages[i]->lru, &pool->dirty);
+		pool->count++;
+	}
+
+	spin_unlock(&pool->lock);
+
+	for (; i < num_pages; i++)
+		__free_page(pages[i]);
+
+	schedule_work(&pool->clear_work);
+}
+
+static void tegra_bo_page_pool_clear_work(struct work_struct *work)
+{
+	struct tegra_bo_page_pool *pool =
+		container_of(work, struct tegra_bo_page_pool, clear_work);
+	struct page *page;
+
+	for (;;) {
+		spin_lock(&pool->lock);
+
+		page = list_first_entry_or_null(&pool->dirty, struct page, lru);
+		if (page)
+			list_del(&page->lru);
+
+		spin_unlock(&pool->lock);
+
+		if (!page)
+			break;
+
+		clear_highpage(page);
+
+		spin_lock(&pool->lock);
+		list_add_tail(&page->lru, &pool->clean);
+		spin_unlock(&pool->lock);
+
+		cond_resched();
+	}
+}
+
+static unsigned long tegra_bo_page_pool_drain(struct tegra_bo_page_pool *pool,
+					      unsigned long nr)
+{
+	unsigned long freed = 0;
+	struct page *page;
+	LIST_HEAD(list);
+
+	spin_lock(&pool->lock);
+
+	/* Give back the pages that haven't been cleared yet first */
+	while (freed < nr) {
+		page = list_first_entry_or_null(&pool->dirty, struct page, lru);
+		if (!page)
+			page = list_first_entry_or_null(&pool->clean, struct page, lru);
+		if (!page)
+			break;
+
+		list_move(&page->lru, &list);
+		pool->count--;
+		freed++;
+	}
+
+	spin_unlock(&pool->lock);
+
+	while ((page = list_first_entry_or_null(&list, struct page, lru))) {
+		list_del(&page->lru);
+		__free_page(page);
+	}
+
+	return freed;
+}
+
+static struct tegra_bo_page_pool *to_page_pool(struct shrinker *shrinker)
+{
+#if defined(NV_SHRINKER_ALLOC_PRESENT) /* Linux 6.7 */
+	return shrinker->private_data;
+#else
+	return container_of(shrinker, struct tegra_bo_page_pool, shrinker);
+#endif
+}
+
+static unsigned long tegra_bo_page_pool_count(struct shrinker *shrinker,
+					      struct shrink_control *sc)
+{
+	struct tegra_bo_page_pool *pool = to_page_pool(shrinker);
+
+	return READ_ONCE(pool->count) ?: SHRINK_EMPTY;
+}
+
+static unsigned long tegra_bo_page_pool_scan(struct shrinker *shrinker,
+					     struct shrink_control *sc)
+{
+	struct tegra_bo_page_pool *pool = to_page_pool(shrinker);
+	unsigned long freed;
+
+	freed = tegra_bo_page_pool_drain(pool, sc->nr_to_scan);
+
+	return freed ?: SHRINK_STOP;
+}
+
+int tegra_bo_page_pool_init(struct tegra_drm *tegra)
+{
+	struct tegra_bo_page_pool *pool;
+	int err = 0;
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return -ENOMEM;
+
+	spin_lock_init(&pool->lock);
+	INIT_LIST_HEAD(&pool->dirty);
+	INIT_LIST_HEAD(&pool->clean);
+	INIT_WORK(&pool->clear_work, tegra_bo_page_pool_clear_work);
+
+#if defined(NV_SHRINKER_ALLOC_PRESENT) /* Linux 6.7 */
+	pool->shrinker = shrinker_alloc(0, "tegra-drm-pages");
+	if (!pool->shrinker) {
+		err = -ENOMEM;
+		goto free;
+	}
+
+	pool->shrinker->count_objects = tegra_bo_page_pool_count;
+	pool->shrinker->scan_objects = tegra_bo_page_pool_scan;
+	pool->shrinker->private_data = pool;
+
+	shrinker_register(pool->shrinker);
+#else
+	pool->shrinker.count_objects = tegra_bo_page_pool_count;
+	pool->shrinker.scan_objects = tegra_bo_page_pool_scan;
+	pool->shrinker.seeks = DEFAULT_SEEKS;
+
+#if defined(NV_REGISTER_SHRINKER_HAS_FMT_ARG) /* Linux v6.0 */
+	err = register_shrinker(&pool->shrinker, "tegra-drm-pages");
+#else
+	err = register_shrinker(&pool->shrinker);
+#endif
+	if (err)
+		goto free;
+#endif
+
+	tegra->page_pool = pool;
+
+	return 0;
+
+free:
+	kfree(pool);
+	return err;
+}
+
+void tegra_bo_page_pool_fini(struct tegra_drm *tegra)
+{
+	struct tegra_bo_page_pool *pool = tegra->page_pool;
+
+#if defined(NV_SHRINKER_ALLOC_PRESENT) /* Linux 6.7 */
+	shrinker_free(pool->shrinker);
+#else
+	unregister_shrinker(&pool->shrinker);
+#endif
+	cancel_work_sync(&pool->clear_work);
+	tegra_bo_page_pool_drain(pool, ULONG_MAX);
+
+	tegra->page_pool = NULL;
+	kfree(pool);
+}
+
+/*
+ * Physically contiguous chunks that large buffers are built from where
+ * possible, so that the IOMMU can map them with 2 MiB (or 64 KiB) pages and
+ * the display and engine SMMU TLBs cover more of the buffer. These are only
+ * opportunistic: fall back to order-0 pages instead of compacting memory.
+ */
+static const unsigned int tegra_bo_page_orders[] = {
+	get_order(SZ_2M),
+	get_order(SZ_64K),
+};
+
+#define TEGRA_BO_HIGH_ORDER_GFP \
+	((GFP_HIGHUSER | __GFP_ZERO | __GFP_NOWARN | __GFP_NORETRY) & ~__GFP_DIRECT_RECLAIM)
+
+static unsigned int tegra_bo_alloc_chunk(struct page **pages, unsigned long count,
+					 unsigned int *min_order)
+{
+	unsigned int i, j, order;
+	struct page *page;
+
+	for (i = *min_order; i < ARRAY_SIZE(tegra_bo_page_orders); i++) {
+		order = tegra_bo_page_orders[i];
+
+		if (count < (1UL << order))
+			continue;
+
+		page = alloc_pages(TEGRA_BO_HIGH_ORDER_GFP, order);
+		if (!page) {
+			/* don't retry a failed order for the rest of the buffer */
+			*min_order = i + 1;
+			continue;
+		}
+
+		/* callers take and release the pages one by one */
+		split_page(page, order);
+
+		for (j = 0; j < (1U << order); j++)
+			pages[j] = page + j;
+
+		return 1U << order;
+	}
+
+	return 0;
+}
+
+/*
+ * Fill the page array with high-order chunks for large buffers and with
+ * pages from the pool otherwise, allocating cleared pages if it runs dry.
+ */
+static struct page **tegra_bo_pool_get_pages(struct tegra_bo_page_pool *pool,
+					     unsigned long num_pages)
+{
+	unsigned int min_order = 0, count;
+	struct page **pages;
+	unsigned long i;
+
+	pages = kvmalloc_array(num_pages, sizeof(*pages), GFP_KERNEL);
+	if (!pages)
+		return ERR_PTR(-ENOMEM);
+
+	for (i = 0; i < num_pages; i++) {
+		count = tegra_bo_alloc_chunk(&pages[i], num_pages - i, &min_order);
+		if (count) {
+			i += count - 1;
+			continue;
+		}
+
+		pages[i] = tegra_bo_page_pool_get(pool);
+		if (pages[i])
+			continue;
+
+		pages[i] = alloc_page(GFP_HIGHUSER | __GFP_ZERO | __GFP_NOWARN);
+		if (!pages[i])
+			goto put_pages;
+	}
+
+	return pages;
+
+put_pages:
+	tegra_bo_page_pool_put(pool, pages, i);
+	kvfree(pages);
+	return ERR_PTR(-ENOMEM);
+}
+
+static void tegra_bo_put_pages(struct tegra_drm *tegra, struct tegra_bo *bo,
+			       bool dirty, bool accessed)
+{
+	if (bo->flags & TEGRA_BO_POOLED) {
+		tegra_bo_page_pool_put(tegra->page_pool, bo->pages, bo->num_pages);
+		kvfree(bo->pages);
+	} else {
+		drm_gem_put_pages(&bo->gem, bo->pages, dirty, accessed);
+	}
+
+	bo->pages = NULL;
+}
+
 static void tegra_bo_free(struct drm_device *drm, struct tegra_bo *bo)
 {
 	if (bo->pages) {
 		dma_unmap_sgtable(drm->dev, bo->sgt, DMA_FROM_DEVICE, 0);
-		drm_gem_put_pages(&bo->gem, bo->pages, true, true);
+		tegra_bo_put_pages(drm->dev_private, bo, true, true);
 		sg_free_table(bo->sgt);
 		kfree(bo->sgt);
 	} else if (bo->vaddr) {
@@ -340,14 +673,26 @@ static void tegra_bo_free(struct drm_device *drm, struct tegra_bo *bo)
 
 static int tegra_bo_get_pages(struct drm_device *drm, struct tegra_bo *bo)
 {
+	struct tegra_drm *tegra = drm->dev_private;
 	int err;
 
-	bo->pages = drm_gem_get_pages(&bo->gem);
-	if (IS_ERR(bo->pages))
-		return PTR_ERR(bo->pages);
-
 	bo->num_pages = bo->gem.size >> PAGE_SHIFT;
 
+	/* large buffers always take the high-order path, even without a pool */
+	if (READ_ONCE(page_pool_size) || bo->gem.size >= SZ_64K) {
+		bo->pages = tegra_bo_pool_get_pages(tegra->page_pool, bo->num_pages);
+		if (!IS_ERR(bo->pages))
+			bo->flags |= TEGRA_BO_POOLED;
+	} else {
+		bo->pages = drm_gem_get_pages(&bo->gem);
+	}
+
+	if (IS_ERR(bo->pages)) {
+		err = PTR_ERR(bo->pages);
+		bo->pages = NULL;
+		return err;
+	}
+
 	bo->sgt = drm_prime_pages_to_sg(bo->gem.dev, bo->pages, bo->num_pages);
 	if (IS_ERR(bo->sgt)) {
 		err = PTR_ERR(bo->sgt);
@@ -364,7 +709,7 @@ free_sgt:
 	sg_free_table(bo->sgt);
 	kfree(bo->sgt);
 put_pages:
-	drm_gem_put_pages(&bo->gem, bo->pages, false, false);
+	tegra_bo_put_pages(tegra, bo, false, false);
 	return err;
 }
 
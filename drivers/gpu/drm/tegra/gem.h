@@ -14,6 +14,10 @@
 #include <drm/drm_gem.h>
 
 #define TEGRA_BO_BOTTOM_UP (1 << 0)
+/* pages are taken from and returned to the page pool */
+#define TEGRA_BO_POOLED (1 << 1)
+
+struct tegra_drm;
 
 enum tegra_bo_tiling_mode {
 	TEGRA_BO_TILING_MODE_PITCH,
@@ -82,4 +86,7 @@ struct drm_gem_object *tegra_gem_prime_import(struct drm_device *drm,
 
 struct host1x_bo *tegra_gem_lookup(struct drm_file *file, u32 handle);
 
+int tegra_bo_page_pool_init(struct tegra_drm *tegra);
+void tegra_bo_page_pool_fini(struct tegra_drm *tegra);
+
 #endif
@@ -271,6 +271,7 @@ static int gr2d_probe(struct platform_device *pdev)
 	INIT_LIST_HEAD(&gr2d->client.list);
 	gr2d->client.version = gr2d->soc->version;
 	gr2d->client.ops = &gr2d_ops;
+	gr2d->client.engine = TEGRA_DRM_ENGINE_GR2D;
 
 #if defined(NV_DEVM_TEGRA_CORE_DEV_INIT_OPP_TABLE_COMMON_PRESENT) /* Linux v5.17 */
 	err = devm_tegra_core_dev_init_opp_table_common(dev);
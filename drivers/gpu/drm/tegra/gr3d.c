@@ -529,6 +529,7 @@ static int gr3d_probe(struct platform_device *pdev)
 	INIT_LIST_HEAD(&gr3d->client.list);
 	gr3d->client.version = gr3d->soc->version;
 	gr3d->client.ops = &gr3d_ops;
+	gr3d->client.engine = TEGRA_DRM_ENGINE_GR3D;
 
 #if defined(NV_DEVM_TEGRA_CORE_DEV_INIT_OPP_TABLE_COMMON_PRESENT) /* Linux v5.17 */
 	err = devm_tegra_core_dev_init_opp_table_common(&pdev->dev);
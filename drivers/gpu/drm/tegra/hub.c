@@ -21,6 +21,7 @@
 #include <drm/drm_fourcc.h>
 #include <drm/drm_framebuffer.h>
 #include <drm/drm_probe_helper.h>
+#include <drm/drm_rect.h>
 
 #include "drm.h"
 #include "dc.h"
@@ -422,6 +423,36 @@ static void tegra_dc_remove_shared_plane(struct tegra_dc *dc,
 	tegra_shared_plane_set_owner(plane, NULL);
 }
 
+/*
+ * Async flips are latched at the end of the current line rather than at the
+ * start of the next frame, so only the scanout address may change. Anything
+ * else would be applied to a window that is partially scanned out already.
+ */
+static int tegra_shared_plane_async_check(struct drm_plane_state *old_state,
+					  struct drm_plane_state *new_state)
+{
+	struct drm_framebuffer *old_fb = old_state->fb, *new_fb = new_state->fb;
+	unsigned int i;
+
+	if (!old_fb || !old_state->visible || !new_state->visible ||
+	    old_state->crtc != new_state->crtc)
+		return -EINVAL;
+
+	if (old_fb->format != new_fb->format || old_fb->modifier != new_fb->modifier)
+		return -EINVAL;
+
+	for (i = 0; i < new_fb->format->num_planes; i++)
+		if (old_fb->pitches[i] != new_fb->pitches[i])
+			return -EINVAL;
+
+	if (!drm_rect_equals(&old_state->src, &new_state->src) ||
+	    !drm_rect_equals(&old_state->dst, &new_state->dst) ||
+	    old_state->zpos != new_state->zpos)
+		return -EINVAL;
+
+	return 0;
+}
+
 static int tegra_shared_plane_atomic_check(struct drm_plane *plane,
 					   struct drm_atomic_state *state)
 {
@@ -431,6 +462,8 @@ static int tegra_shared_plane_atomic_check(struct drm_plane *plane,
 	struct tegra_shared_plane *tegra = to_tegra_shared_plane(plane);
 	struct tegra_bo_tiling *tiling = &plane_state->tiling;
 	struct tegra_dc *dc = to_tegra_dc(new_plane_state->crtc);
+	struct drm_plane_state *old_plane_state;
+	struct drm_crtc_state *crtc_state;
 	int err;
 
 	/* no need for further checks if the plane is being disabled */
@@ -477,6 +510,18 @@ static int tegra_shared_plane_atomic_check(struct drm_plane *plane,
 	if (err < 0)
 		return err;
 
+	crtc_state = drm_atomic_get_new_crtc_state(state, new_plane_state->crtc);
+
+	if (crtc_state->async_flip) {
+		old_plane_state = drm_atomic_get_old_plane_state(state, plane);
+
+		err = tegra_shared_plane_async_check(old_plane_state, new_plane_state);
+		if (err < 0) {
+			DRM_DEBUG_KMS("async flip may only change the framebuffer\n");
+			return err;
+		}
+	}
+
 	return 0;
 }
 
@@ -542,6 +587,7 @@ static void tegra_shared_plane_atomic_update(struct drm_plane *plane,
 	struct drm_framebuffer *fb = new_state->fb;
 	struct tegra_plane *p = to_tegra_plane(plane);
 	u32 value, min_width, bypass = 0;
+	struct drm_crtc_state *crtc_state;
 	dma_addr_t base, addr_flag = 0;
 	unsigned int bpc, planes;
 	bool yuv;
@@ -551,6 +597,8 @@ static void tegra_shared_plane_atomic_update(struct drm_plane *plane,
 	if (!new_state->crtc || !new_state->fb)
 		return;
 
+	crtc_state = drm_atomic_get_new_crtc_state(state, new_state->crtc);
+
 	if (!new_state->visible) {
 		tegra_shared_plane_atomic_disable(plane, state);
 		return;
@@ -566,7 +614,11 @@ static void tegra_shared_plane_atomic_update(struct drm_plane *plane,
 
 	tegra_dc_assign_shared_plane(dc, p);
 
-	tegra_plane_writel(p, VCOUNTER, DC_WIN_CORE_ACT_CONTROL);
+	/* async flips take effect at the end of the current line */
+	if (crtc_state && crtc_state->async_flip)
+		tegra_plane_writel(p, HCOUNTER, DC_WIN_CORE_ACT_CONTROL);
+	else
+		tegra_plane_writel(p, VCOUNTER, DC_WIN_CORE_ACT_CONTROL);
 
 	/* blending */
 	value = BLEND_FACTOR_DST_ALPHA_ZERO | BLEND_FACTOR_SRC_ALPHA_K2 |
@@ -950,6 +1002,9 @@ static int tegra_display_hub_init(struct host1x_client *client)
 	drm_atomic_private_obj_init(drm, &hub->base, &state->base,
 				    &tegra_display_hub_state_funcs);
 
+	/* windows can be latched mid-frame, see tegra_shared_plane_async_check() */
+	drm->mode_config.async_page_flip = true;
+
 	tegra->hub = hub;
 
 	return 0;
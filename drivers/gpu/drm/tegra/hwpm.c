@@ -67,6 +67,43 @@ static int tegra_drm_hwpm_ip_reg_op(void *ip_dev,
 	return 0;
 }
 
+#ifdef NV_TEGRA_SOC_HWPM_IP_OPS_HAS_REG_OPS
+/*
+ * Applies count operations of the same kind with a single runtime PM
+ * reference instead of one HWPM framework call per register.
+ */
+static int tegra_drm_hwpm_ip_reg_ops(void *ip_dev,
+	enum tegra_soc_hwpm_ip_reg_op reg_op, u32 inst_element_index,
+	const u64 *reg_offsets, u32 *reg_data, u32 count)
+{
+	struct tegra_drm_hwpm *hwpm = (struct tegra_drm_hwpm *)ip_dev;
+	int err;
+	u32 i;
+
+	if (reg_op != TEGRA_SOC_HWPM_IP_REG_OP_READ &&
+	    reg_op != TEGRA_SOC_HWPM_IP_REG_OP_WRITE)
+		return -EINVAL;
+
+	err = pm_runtime_resume_and_get(hwpm->dev);
+	if (err < 0) {
+		dev_err(hwpm->dev, "runtime resume failed %d", err);
+		return err;
+	}
+
+	if (reg_op == TEGRA_SOC_HWPM_IP_REG_OP_READ) {
+		for (i = 0; i < count; i++)
+			reg_data[i] = tegra_drm_hwpm_readl(hwpm, reg_offsets[i]);
+	} else {
+		for (i = 0; i < count; i++)
+			tegra_drm_hwpm_writel(hwpm, reg_data[i], reg_offsets[i]);
+	}
+
+	pm_runtime_put_autosuspend(hwpm->dev);
+
+	return 0;
+}
+#endif
+
 static u32 tegra_drm_hwpm_get_resource_index(enum tegra_drm_hwpm_ip hwpm_ip)
 {
 	switch (hwpm_ip) {
@@ -99,6 +136,9 @@ void tegra_drm_hwpm_register(struct tegra_drm_hwpm *drm_hwpm, u64 resource_base,
 	hwpm_ip_ops.resource_enum = tegra_drm_hwpm_get_resource_index(hwpm_ip);
 	hwpm_ip_ops.hwpm_ip_pm = &tegra_drm_hwpm_ip_pm;
 	hwpm_ip_ops.hwpm_ip_reg_op = &tegra_drm_hwpm_ip_reg_op;
+#ifdef NV_TEGRA_SOC_HWPM_IP_OPS_HAS_REG_OPS
+	hwpm_ip_ops.hwpm_ip_reg_ops = &tegra_drm_hwpm_ip_reg_ops;
+#endif
 	tegra_soc_hwpm_ip_register(&hwpm_ip_ops);
 }
 
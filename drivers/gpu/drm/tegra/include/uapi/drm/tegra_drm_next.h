@@ -667,6 +667,13 @@ struct drm_tegra_gem_get_flags {
  */
 #define DRM_TEGRA_CHANNEL_CAP_CACHE_COHERENT (1 << 0)
 
+/*
+ * Specified by userspace in the `flags` field.
+ *
+ * DRM_TEGRA_CHANNEL_OPEN_WEIGHT: The `weight` field is valid.
+ */
+#define DRM_TEGRA_CHANNEL_OPEN_WEIGHT (1 << 0)
+
 struct drm_tegra_channel_open {
 	/**
 	 * @host1x_class: [in]
@@ -704,7 +711,15 @@ struct drm_tegra_channel_open {
 	 * Flags describing the hardware capabilities.
 	 */
 	__u32 capabilities;
-	__u32 padding;
+
+	/**
+	 * @weight: [in]
+	 *
+	 * Share of the engine given to jobs of this channel, relative to the
+	 * other channels open on the same engine, from 1 to 1000. Used if
+	 * DRM_TEGRA_CHANNEL_OPEN_WEIGHT is set, the default is 100.
+	 */
+	__u32 weight;
 };
 
 struct drm_tegra_channel_close {
@@ -757,6 +772,15 @@ struct drm_tegra_channel_map {
 	 * relocations or unmapping later.
 	 */
 	__u32 mapping;
+
+	/**
+	 * @iova: [out]
+	 *
+	 * Address of the memory as seen by the engine. It stays the same
+	 * until the mapping is unmapped and can be written into gathers
+	 * directly with DRM_TEGRA_SUBMIT_BUF_FIXED_IOVA.
+	 */
+	__u64 iova;
 };
 
 struct drm_tegra_channel_unmap {
@@ -784,6 +808,14 @@ struct drm_tegra_channel_unmap {
  */
 #define DRM_TEGRA_SUBMIT_RELOC_SECTOR_LAYOUT (1 << 0)
 
+/**
+ * Specify that the gather already contains the address of the buffer, taken
+ * from &drm_tegra_channel_map.iova, at `reloc.gather_offset_words` shifted
+ * right by `reloc.shift`. The word is checked to point into the mapping and
+ * is not patched, `reloc.target_offset` is ignored.
+ */
+#define DRM_TEGRA_SUBMIT_BUF_FIXED_IOVA (1 << 1)
+
 struct drm_tegra_submit_buf {
 	/**
 	 * @mapping: [in]
@@ -917,6 +949,7 @@ struct drm_tegra_submit_syncpt {
 };
 
 #define DRM_TEGRA_SUBMIT_SECONDARY_SYNCPT		(1<<0)
+#define DRM_TEGRA_SUBMIT_PERF_HINT			(1<<1)
 
 struct drm_tegra_channel_submit {
 	/**
@@ -1005,6 +1038,183 @@ struct drm_tegra_channel_submit {
 	 * Secondary syncpoint the job may increment, not used for job tracking.
 	 */
 	__u32 secondary_syncpt_id;
+
+	/**
+	 * @expected_cycles: [in]
+	 *
+	 * Engine clock cycles the job is expected to take, used if
+	 * DRM_TEGRA_SUBMIT_PERF_HINT is set. Zero lets the kernel estimate it
+	 * from the recent jobs of the engine.
+	 */
+	__u64 expected_cycles;
+
+	/**
+	 * @deadline_us: [in]
+	 *
+	 * Time in microseconds from submission by which the job should
+	 * complete, used if DRM_TEGRA_SUBMIT_PERF_HINT is set. The engine
+	 * clock is raised so that the job and all jobs queued ahead of it
+	 * on the engine finish in time. Zero means no deadline.
+	 */
+	__u32 deadline_us;
+
+	/**
+	 * @reserved: [in]
+	 *
+	 * Must be zero.
+	 */
+	__u32 reserved;
+};
+
+/* Persistent jobs */
+
+struct drm_tegra_channel_job_create {
+	/**
+	 * @context: [in]
+	 *
+	 * Identifier of the channel the job will be submitted to.
+	 */
+	__u32 context;
+
+	/**
+	 * @num_bufs: [in]
+	 *
+	 * Number of elements in the `bufs_ptr` array.
+	 */
+	__u32 num_bufs;
+
+	/**
+	 * @num_cmds: [in]
+	 *
+	 * Number of elements in the `cmds_ptr` array.
+	 */
+	__u32 num_cmds;
+
+	/**
+	 * @gather_data_words: [in]
+	 *
+	 * Number of 32-bit words in the `gather_data_ptr` array.
+	 */
+	__u32 gather_data_words;
+
+	/**
+	 * @bufs_ptr: [in]
+	 *
+	 * Pointer to an array of drm_tegra_submit_buf structures.
+	 */
+	__u64 bufs_ptr;
+
+	/**
+	 * @cmds_ptr: [in]
+	 *
+	 * Pointer to an array of drm_tegra_submit_cmd structures. Absolute
+	 * syncpoint waits are not allowed, since the job is executed more
+	 * than once; use relative waits or `syncobj_in` at submission.
+	 */
+	__u64 cmds_ptr;
+
+	/**
+	 * @gather_data_ptr: [in]
+	 *
+	 * Pointer to an array of Host1x opcodes to be used by GATHER_UPTR
+	 * commands.
+	 */
+	__u64 gather_data_ptr;
+
+	/**
+	 * @syncpt: [in]
+	 *
+	 * Information about the syncpoint each execution of the job will
+	 * increment. The `value` field is unused.
+	 */
+	struct drm_tegra_submit_syncpt syncpt;
+
+	/**
+	 * @flags: [in]
+	 *
+	 * Flags. Same as for drm_tegra_channel_submit.
+	 */
+	__u32 flags;
+
+	/**
+	 * @secondary_syncpt_id: [in]
+	 *
+	 * Secondary syncpoint the job may increment, not used for job tracking.
+	 */
+	__u32 secondary_syncpt_id;
+
+	/**
+	 * @job: [out]
+	 *
+	 * Identifier of the persistent job, to be used for submitting or
+	 * destroying it later.
+	 */
+	__u32 job;
+	__u32 padding;
+};
+
+struct drm_tegra_channel_job_submit {
+	/**
+	 * @context: [in]
+	 *
+	 * Identifier of the channel the job was created on.
+	 */
+	__u32 context;
+
+	/**
+	 * @job: [in]
+	 *
+	 * Identifier of the persistent job to execute.
+	 */
+	__u32 job;
+
+	/**
+	 * @syncobj_in: [in]
+	 *
+	 * Handle for DRM syncobj that will be waited before submission.
+	 * Ignored if zero.
+	 */
+	__u32 syncobj_in;
+
+	/**
+	 * @syncobj_out: [in]
+	 *
+	 * Handle for DRM syncobj that will have its fence replaced with
+	 * the job's completion fence. Ignored if zero.
+	 */
+	__u32 syncobj_out;
+
+	/**
+	 * @flags: [in]
+	 *
+	 * Flags.
+	 */
+	__u32 flags;
+
+	/**
+	 * @syncpt_value: [out]
+	 *
+	 * Value the job syncpoint will have once this execution of the job
+	 * has completed all its syncpoint increments.
+	 */
+	__u32 syncpt_value;
+};
+
+struct drm_tegra_channel_job_destroy {
+	/**
+	 * @context: [in]
+	 *
+	 * Identifier of the channel the job was created on.
+	 */
+	__u32 context;
+
+	/**
+	 * @job: [in]
+	 *
+	 * Identifier of the persistent job to destroy. Executions that are
+	 * still in flight are not affected.
+	 */
+	__u32 job;
 };
 
 struct drm_tegra_syncpoint_allocate {
@@ -1071,6 +1281,9 @@ struct drm_tegra_syncpoint_wait {
 #define DRM_IOCTL_TEGRA_CHANNEL_MAP DRM_IOWR(DRM_COMMAND_BASE + 0x12, struct drm_tegra_channel_map)
 #define DRM_IOCTL_TEGRA_CHANNEL_UNMAP DRM_IOWR(DRM_COMMAND_BASE + 0x13, struct drm_tegra_channel_unmap)
 #define DRM_IOCTL_TEGRA_CHANNEL_SUBMIT DRM_IOWR(DRM_COMMAND_BASE + 0x14, struct drm_tegra_channel_submit)
+#define DRM_IOCTL_TEGRA_CHANNEL_JOB_CREATE DRM_IOWR(DRM_COMMAND_BASE + 0x15, struct drm_tegra_channel_job_create)
+#define DRM_IOCTL_TEGRA_CHANNEL_JOB_SUBMIT DRM_IOWR(DRM_COMMAND_BASE + 0x16, struct drm_tegra_channel_job_submit)
+#define DRM_IOCTL_TEGRA_CHANNEL_JOB_DESTROY DRM_IOWR(DRM_COMMAND_BASE + 0x17, struct drm_tegra_channel_job_destroy)
 
 #define DRM_IOCTL_TEGRA_SYNCPOINT_ALLOCATE DRM_IOWR(DRM_COMMAND_BASE + 0x20, struct drm_tegra_syncpoint_allocate)
 #define DRM_IOCTL_TEGRA_SYNCPOINT_FREE DRM_IOWR(DRM_COMMAND_BASE + 0x21, struct drm_tegra_syncpoint_free)
@@ -6,8 +6,6 @@
 #include <linux/bitops.h>
 #include <linux/clk.h>
 #include <linux/delay.h>
-#include <linux/devfreq.h>
-#include <linux/devfreq/tegra_wmark.h>
 #include <linux/dma-mapping.h>
 #include <linux/host1x-next.h>
 #include <linux/interconnect.h>
@@ -18,7 +16,6 @@
 #include <linux/of_device.h>
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
-#include <linux/pm_opp.h>
 #include <linux/pm_runtime.h>
 #include <linux/reset.h>
 #include <linux/version.h>
@@ -26,6 +23,7 @@
 #include <soc/tegra/mc.h>
 
 #include "drm.h"
+#include "dvfs.h"
 #include "falcon.h"
 #include "riscv.h"
 #include "util.h"
@@ -68,8 +66,7 @@ struct nvdec {
 	struct clk_bulk_data clks[3];
 	unsigned int num_clks;
 	struct reset_control *reset;
-	struct devfreq *devfreq;
-	struct devfreq_dev_profile *devfreq_profile;
+	struct tegra_drm_dvfs dvfs;
 	struct icc_path *icc_write;
 
 	/* Platform configuration */
@@ -91,8 +88,9 @@ static inline void nvdec_writel(struct nvdec *nvdec, u32 value,
 	writel(value, nvdec->regs + offset);
 }
 
-static int nvdec_set_rate(struct nvdec *nvdec, unsigned long rate)
+static int nvdec_set_rate(struct device *dev, unsigned long rate)
 {
+	struct nvdec *nvdec = dev_get_drvdata(dev);
 	unsigned long dev_rate;
 	u32 emc_kbps;
 	int err;
@@ -194,117 +192,6 @@ release_reset:
 	return err;
 }
 
-static void nvdec_devfreq_update_wmark_threshold(struct devfreq *devfreq,
-						 struct devfreq_tegra_wmark_config *cfg)
-{
-	struct nvdec *nvdec = dev_get_drvdata(devfreq->dev.parent);
-	struct host1x_client *client = &nvdec->client.base;
-
-	host1x_actmon_update_active_wmark(client,
-					  cfg->avg_upper_wmark,
-					  cfg->avg_lower_wmark,
-					  cfg->consec_upper_wmark,
-					  cfg->consec_lower_wmark,
-					  cfg->upper_wmark_enabled,
-					  cfg->lower_wmark_enabled);
-}
-
-static int nvdec_devfreq_target(struct device *dev, unsigned long *freq, u32 flags)
-{
-	struct nvdec *nvdec = dev_get_drvdata(dev);
-	int err;
-
-	err = nvdec_set_rate(nvdec, *freq);
-	if (err < 0) {
-		dev_err(dev, "failed to set clock rate\n");
-		return err;
-	}
-
-	*freq = clk_get_rate(nvdec->clks[0].clk);
-
-	return 0;
-}
-
-static int nvdec_devfreq_get_dev_status(struct device *dev, struct devfreq_dev_status *stat)
-{
-	struct nvdec *nvdec = dev_get_drvdata(dev);
-	struct host1x_client *client = &nvdec->client.base;
-	unsigned long usage;
-
-	/* Update load information */
-	host1x_actmon_read_active_norm(client, &usage);
-	stat->total_time = 1;
-	stat->busy_time = usage;
-
-	/* Update device frequency */
-	stat->current_frequency = clk_get_rate(nvdec->clks[0].clk);
-
-	return 0;
-}
-
-static int nvdec_devfreq_get_cur_freq(struct device *dev, unsigned long *freq)
-{
-	struct nvdec *nvdec = dev_get_drvdata(dev);
-
-	*freq = clk_get_rate(nvdec->clks[0].clk);
-
-	return 0;
-}
-
-static int nvdec_devfreq_init(struct nvdec *nvdec)
-{
-	struct clk *clk = nvdec->clks[0].clk;
-	unsigned long max_rate = clk_round_rate(clk, ULONG_MAX);
-	unsigned long min_rate = clk_round_rate(clk, 0);
-	unsigned long margin = clk_round_rate(clk, min_rate + 1) - min_rate;
-	unsigned long rate = min_rate;
-	struct devfreq_tegra_wmark_data *data;
-	struct devfreq_dev_profile *devfreq_profile;
-	struct devfreq *devfreq;
-
-	while (rate <= max_rate) {
-		dev_pm_opp_add(nvdec->dev, rate, 0);
-		rate += margin;
-	}
-
-	data = devm_kzalloc(nvdec->dev, sizeof(*data), GFP_KERNEL);
-	if (!data)
-		return -ENOMEM;
-
-	data->event = DEVFREQ_TEGRA_AVG_WMARK_BELOW;
-	data->update_wmark_threshold = nvdec_devfreq_update_wmark_threshold;
-
-	devfreq_profile = devm_kzalloc(nvdec->dev, sizeof(*devfreq_profile), GFP_KERNEL);
-	if (!devfreq_profile)
-		return -ENOMEM;
-
-	devfreq_profile->target = nvdec_devfreq_target;
-	devfreq_profile->get_dev_status = nvdec_devfreq_get_dev_status;
-	devfreq_profile->get_cur_freq = nvdec_devfreq_get_cur_freq;
-	devfreq_profile->initial_freq = max_rate;
-	devfreq_profile->polling_ms = 100;
-
-	devfreq = devm_devfreq_add_device(nvdec->dev,
-					  devfreq_profile,
-					  DEVFREQ_GOV_USERSPACE,
-					  data);
-	if (IS_ERR(devfreq))
-		return PTR_ERR(devfreq);
-
-	nvdec->devfreq = devfreq;
-
-	return 0;
-}
-
-static void nvdec_devfreq_deinit(struct nvdec *nvdec)
-{
-	if (!nvdec->devfreq)
-		return;
-
-	devm_devfreq_remove_device(nvdec->dev, nvdec->devfreq);
-	nvdec->devfreq = NULL;
-}
-
 static int nvdec_init(struct host1x_client *client)
 {
 	struct tegra_drm_client *drm = host1x_to_drm_client(client);
@@ -405,34 +292,8 @@ static void nvdec_actmon_event(struct host1x_client *client,
 {
 	struct platform_device *pdev = to_platform_device(client->dev);
 	struct nvdec *nvdec = platform_get_drvdata(pdev);
-	struct devfreq *df = nvdec->devfreq;
-	struct devfreq_tegra_wmark_data *data;
-
-	if (!df)
-		return;
 
-	data = df->data;
-
-	switch (event) {
-	case HOST1X_ACTMON_AVG_WMARK_BELOW:
-		data->event = DEVFREQ_TEGRA_AVG_WMARK_BELOW;
-		break;
-	case HOST1X_ACTMON_AVG_WMARK_ABOVE:
-		data->event = DEVFREQ_TEGRA_AVG_WMARK_ABOVE;
-		break;
-	case HOST1X_ACTMON_CONSEC_WMARK_BELOW:
-		data->event = DEVFREQ_TEGRA_CONSEC_WMARK_BELOW;
-		break;
-	case HOST1X_ACTMON_CONSEC_WMARK_ABOVE:
-		data->event = DEVFREQ_TEGRA_CONSEC_WMARK_ABOVE;
-		break;
-	default:
-		return;
-	}
-
-	mutex_lock(&df->lock);
-	update_devfreq(df);
-	mutex_unlock(&df->lock);
+	tegra_drm_dvfs_actmon_event(&nvdec->dvfs, event);
 }
 
 static const struct host1x_client_ops nvdec_client_ops = {
@@ -582,15 +443,13 @@ static __maybe_unused int nvdec_runtime_resume(struct device *dev)
 			goto disable;
 	}
 
-	/* Forcely set frequency as Fmax when device is resumed back */
-	nvdec->devfreq->resume_freq = nvdec->devfreq->scaling_max_freq;
-	err = devfreq_resume_device(nvdec->devfreq);
+	err = tegra_drm_dvfs_resume(&nvdec->dvfs);
 	if (err < 0)
 		goto disable;
 
 	nvdec_actmon_reg_init(nvdec);
 
-	nvdec_count_weight_init(nvdec, nvdec->devfreq->scaling_max_freq);
+	nvdec_count_weight_init(nvdec, nvdec->dvfs.devfreq->scaling_max_freq);
 
 	host1x_actmon_enable(&nvdec->client.base);
 
@@ -606,7 +465,7 @@ static __maybe_unused int nvdec_runtime_suspend(struct device *dev)
 	struct nvdec *nvdec = dev_get_drvdata(dev);
 	int err;
 
-	err = devfreq_suspend_device(nvdec->devfreq);
+	err = tegra_drm_dvfs_suspend(&nvdec->dvfs);
 	if (err < 0)
 		return err;
 
@@ -627,7 +486,7 @@ static __maybe_unused int nvdec_runtime_suspend(struct device *dev)
 	return 0;
 
 devfreq_resume:
-	devfreq_resume_device(nvdec->devfreq);
+	tegra_drm_dvfs_resume(&nvdec->dvfs);
 	return err;
 }
 
@@ -821,6 +680,8 @@ static int nvdec_probe(struct platform_device *pdev)
 	INIT_LIST_HEAD(&nvdec->client.list);
 	nvdec->client.version = nvdec->config->version;
 	nvdec->client.ops = &nvdec_ops;
+	nvdec->client.engine = TEGRA_DRM_ENGINE_NVDEC;
+	nvdec->client.dvfs = &nvdec->dvfs;
 
 	err = host1x_client_register(&nvdec->client.base);
 	if (err < 0) {
@@ -839,7 +700,13 @@ static int nvdec_probe(struct platform_device *pdev)
 		goto exit_actmon;
 	}
 
-	err = nvdec_devfreq_init(nvdec);
+	nvdec->dvfs.dev = dev;
+	nvdec->dvfs.client = &nvdec->client.base;
+	nvdec->dvfs.clk = nvdec->clks[0].clk;
+	nvdec->dvfs.set_rate = nvdec_set_rate;
+	nvdec->dvfs.total_time = 1;
+
+	err = tegra_drm_dvfs_init(&nvdec->dvfs);
 	if (err < 0) {
 		dev_err(&pdev->dev, "failed to init devfreq: %d\n", err);
 		goto exit_actmon;
@@ -874,7 +741,7 @@ static int nvdec_remove(struct platform_device *pdev)
 	tegra_drm_hwpm_unregister(&nvdec->hwpm, pdev->resource[0].start,
 		TEGRA_DRM_HWPM_IP_NVDEC);
 
-	nvdec_devfreq_deinit(nvdec);
+	tegra_drm_dvfs_exit(&nvdec->dvfs);
 
 	host1x_actmon_unregister(&nvdec->client.base);
 
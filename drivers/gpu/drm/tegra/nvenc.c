@@ -6,8 +6,6 @@
 #include <linux/bitops.h>
 #include <linux/clk.h>
 #include <linux/delay.h>
-#include <linux/devfreq.h>
-#include <linux/devfreq/tegra_wmark.h>
 #include <linux/host1x-next.h>
 #include <linux/interconnect.h>
 #include <linux/iommu.h>
@@ -16,7 +14,6 @@
 #include <linux/of_device.h>
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
-#include <linux/pm_opp.h>
 #include <linux/pm_runtime.h>
 #include <linux/reset.h>
 #include <linux/version.h>
@@ -24,6 +21,7 @@
 #include <soc/tegra/pmc.h>
 
 #include "drm.h"
+#include "dvfs.h"
 #include "falcon.h"
 #include "util.h"
 #include "hwpm.h"
@@ -56,8 +54,7 @@ struct nvenc {
 	struct host1x_channel *channel;
 	struct device *dev;
 	struct clk *clk;
-	struct devfreq *devfreq;
-	struct devfreq_dev_profile *devfreq_profile;
+	struct tegra_drm_dvfs dvfs;
 	struct icc_path *icc_write;
 
 	/* Platform configuration */
@@ -74,8 +71,9 @@ static inline void nvenc_writel(struct nvenc *nvenc, u32 value, unsigned int off
 	writel(value, nvenc->regs + offset);
 }
 
-static int nvenc_set_rate(struct nvenc *nvenc, unsigned long rate)
+static int nvenc_set_rate(struct device *dev, unsigned long rate)
 {
+	struct nvenc *nvenc = dev_get_drvdata(dev);
 	unsigned long dev_rate;
 	u32 emc_kbps;
 	int err;
@@ -119,116 +117,6 @@ static int nvenc_boot(struct nvenc *nvenc)
 	return 0;
 }
 
-static void nvenc_devfreq_update_wmark_threshold(struct devfreq *devfreq,
-						 struct devfreq_tegra_wmark_config *cfg)
-{
-	struct nvenc *nvenc = dev_get_drvdata(devfreq->dev.parent);
-	struct host1x_client *client = &nvenc->client.base;
-
-	host1x_actmon_update_active_wmark(client,
-					  cfg->avg_upper_wmark,
-					  cfg->avg_lower_wmark,
-					  cfg->consec_upper_wmark,
-					  cfg->consec_lower_wmark,
-					  cfg->upper_wmark_enabled,
-					  cfg->lower_wmark_enabled);
-}
-
-static int nvenc_devfreq_target(struct device *dev, unsigned long *freq, u32 flags)
-{
-	struct nvenc *nvenc = dev_get_drvdata(dev);
-	int err;
-
-	err = nvenc_set_rate(nvenc, *freq);
-	if (err < 0) {
-		dev_err(dev, "failed to set clock rate\n");
-		return err;
-	}
-
-	*freq = clk_get_rate(nvenc->clk);
-
-	return 0;
-}
-
-static int nvenc_devfreq_get_dev_status(struct device *dev, struct devfreq_dev_status *stat)
-{
-	struct nvenc *nvenc = dev_get_drvdata(dev);
-	struct host1x_client *client = &nvenc->client.base;
-	unsigned long usage;
-
-	/* Update load information */
-	host1x_actmon_read_active_norm(client, &usage);
-	stat->total_time = 1;
-	stat->busy_time = usage;
-
-	/* Update device frequency */
-	stat->current_frequency = clk_get_rate(nvenc->clk);
-
-	return 0;
-}
-
-static int nvenc_devfreq_get_cur_freq(struct device *dev, unsigned long *freq)
-{
-	struct nvenc *nvenc = dev_get_drvdata(dev);
-
-	*freq = clk_get_rate(nvenc->clk);
-
-	return 0;
-}
-
-static int nvenc_devfreq_init(struct nvenc *nvenc)
-{
-	unsigned long max_rate = clk_round_rate(nvenc->clk, ULONG_MAX);
-	unsigned long min_rate = clk_round_rate(nvenc->clk, 0);
-	unsigned long margin = clk_round_rate(nvenc->clk, min_rate + 1) - min_rate;
-	unsigned long rate = min_rate;
-	struct devfreq_tegra_wmark_data *data;
-	struct devfreq_dev_profile *devfreq_profile;
-	struct devfreq *devfreq;
-
-	while (rate <= max_rate) {
-		dev_pm_opp_add(nvenc->dev, rate, 0);
-		rate += margin;
-	}
-
-	data = devm_kzalloc(nvenc->dev, sizeof(*data), GFP_KERNEL);
-	if (!data)
-		return -ENOMEM;
-
-	data->event = DEVFREQ_TEGRA_AVG_WMARK_BELOW;
-	data->update_wmark_threshold = nvenc_devfreq_update_wmark_threshold;
-
-	devfreq_profile = devm_kzalloc(nvenc->dev, sizeof(*devfreq_profile), GFP_KERNEL);
-	if (!devfreq_profile)
-		return -ENOMEM;
-
-	devfreq_profile->target = nvenc_devfreq_target;
-	devfreq_profile->get_dev_status = nvenc_devfreq_get_dev_status;
-	devfreq_profile->get_cur_freq = nvenc_devfreq_get_cur_freq;
-	devfreq_profile->initial_freq = max_rate;
-	devfreq_profile->polling_ms = 100;
-
-	devfreq = devm_devfreq_add_device(nvenc->dev,
-					  devfreq_profile,
-					  DEVFREQ_GOV_USERSPACE,
-					  data);
-	if (IS_ERR(devfreq))
-		return PTR_ERR(devfreq);
-
-	nvenc->devfreq = devfreq;
-
-	return 0;
-}
-
-static void nvenc_devfreq_deinit(struct nvenc *nvenc)
-{
-	if (!nvenc->devfreq)
-		return;
-
-	devm_devfreq_remove_device(nvenc->dev, nvenc->devfreq);
-	nvenc->devfreq = NULL;
-}
-
 static int nvenc_init(struct host1x_client *client)
 {
 	struct tegra_drm_client *drm = host1x_to_drm_client(client);
@@ -329,34 +217,8 @@ static void nvenc_actmon_event(struct host1x_client *client,
 {
 	struct platform_device *pdev = to_platform_device(client->dev);
 	struct nvenc *nvenc = platform_get_drvdata(pdev);
-	struct devfreq *df = nvenc->devfreq;
-	struct devfreq_tegra_wmark_data *data;
-
-	if (!df)
-		return;
-
-	data = df->data;
-
-	switch (event) {
-	case HOST1X_ACTMON_AVG_WMARK_BELOW:
-		data->event = DEVFREQ_TEGRA_AVG_WMARK_BELOW;
-		break;
-	case HOST1X_ACTMON_AVG_WMARK_ABOVE:
-		data->event = DEVFREQ_TEGRA_AVG_WMARK_ABOVE;
-		break;
-	case HOST1X_ACTMON_CONSEC_WMARK_BELOW:
-		data->event = DEVFREQ_TEGRA_CONSEC_WMARK_BELOW;
-		break;
-	case HOST1X_ACTMON_CONSEC_WMARK_ABOVE:
-		data->event = DEVFREQ_TEGRA_CONSEC_WMARK_ABOVE;
-		break;
-	default:
-		return;
-	}
 
-	mutex_lock(&df->lock);
-	update_devfreq(df);
-	mutex_unlock(&df->lock);
+	tegra_drm_dvfs_actmon_event(&nvenc->dvfs, event);
 }
 
 static const struct host1x_client_ops nvenc_client_ops = {
@@ -472,15 +334,13 @@ static __maybe_unused int nvenc_runtime_resume(struct device *dev)
 	if (err < 0)
 		goto disable;
 
-	/* Forcely set frequency as Fmax when device is resumed back */
-	nvenc->devfreq->resume_freq = nvenc->devfreq->scaling_max_freq;
-	err = devfreq_resume_device(nvenc->devfreq);
+	err = tegra_drm_dvfs_resume(&nvenc->dvfs);
 	if (err < 0)
 		goto disable;
 
 	nvenc_actmon_reg_init(nvenc);
 
-	nvenc_count_weight_init(nvenc, nvenc->devfreq->scaling_max_freq);
+	nvenc_count_weight_init(nvenc, nvenc->dvfs.devfreq->scaling_max_freq);
 
 	host1x_actmon_enable(&nvenc->client.base);
 
@@ -496,7 +356,7 @@ static __maybe_unused int nvenc_runtime_suspend(struct device *dev)
 	struct nvenc *nvenc = dev_get_drvdata(dev);
 	int err;
 
-	err = devfreq_suspend_device(nvenc->devfreq);
+	err = tegra_drm_dvfs_suspend(&nvenc->dvfs);
 	if (err < 0)
 		return err;
 
@@ -517,7 +377,7 @@ static __maybe_unused int nvenc_runtime_suspend(struct device *dev)
 	return 0;
 
 devfreq_resume:
-	devfreq_resume_device(nvenc->devfreq);
+	tegra_drm_dvfs_resume(&nvenc->dvfs);
 	return err;
 }
 
@@ -687,6 +547,8 @@ static int nvenc_probe(struct platform_device *pdev)
 	INIT_LIST_HEAD(&nvenc->client.list);
 	nvenc->client.version = nvenc->config->version;
 	nvenc->client.ops = &nvenc_ops;
+	nvenc->client.engine = TEGRA_DRM_ENGINE_NVENC;
+	nvenc->client.dvfs = &nvenc->dvfs;
 
 	err = host1x_client_register(&nvenc->client.base);
 	if (err < 0) {
@@ -705,7 +567,13 @@ static int nvenc_probe(struct platform_device *pdev)
 		goto exit_actmon;
 	}
 
-	err = nvenc_devfreq_init(nvenc);
+	nvenc->dvfs.dev = dev;
+	nvenc->dvfs.client = &nvenc->client.base;
+	nvenc->dvfs.clk = nvenc->clk;
+	nvenc->dvfs.set_rate = nvenc_set_rate;
+	nvenc->dvfs.total_time = 1;
+
+	err = tegra_drm_dvfs_init(&nvenc->dvfs);
 	if (err < 0) {
 		dev_err(&pdev->dev, "failed to init devfreq: %d\n", err);
 		goto exit_actmon;
@@ -740,7 +608,7 @@ static int nvenc_remove(struct platform_device *pdev)
 	tegra_drm_hwpm_unregister(&nvenc->hwpm, pdev->resource[0].start,
 		TEGRA_DRM_HWPM_IP_NVENC);
 
-	nvenc_devfreq_deinit(nvenc);
+	tegra_drm_dvfs_exit(&nvenc->dvfs);
 
 	host1x_actmon_unregister(&nvenc->client.base);
 
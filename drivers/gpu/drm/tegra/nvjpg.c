@@ -6,8 +6,6 @@
 #include <linux/bitops.h>
 #include <linux/clk.h>
 #include <linux/delay.h>
-#include <linux/devfreq.h>
-#include <linux/devfreq/tegra_wmark.h>
 #include <linux/host1x-next.h>
 #include <linux/interconnect.h>
 #include <linux/iommu.h>
@@ -16,7 +14,6 @@
 #include <linux/of_device.h>
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
-#include <linux/pm_opp.h>
 #include <linux/pm_runtime.h>
 #include <linux/reset.h>
 #include <linux/version.h>
@@ -24,6 +21,7 @@
 #include <soc/tegra/pmc.h>
 
 #include "drm.h"
+#include "dvfs.h"
 #include "falcon.h"
 #include "util.h"
 
@@ -53,8 +51,7 @@ struct nvjpg {
 	struct host1x_channel *channel;
 	struct device *dev;
 	struct clk *clk;
-	struct devfreq *devfreq;
-	struct devfreq_dev_profile *devfreq_profile;
+	struct tegra_drm_dvfs dvfs;
 	struct icc_path *icc_write;
 
 	/* Platform configuration */
@@ -71,8 +68,9 @@ static inline void nvjpg_writel(struct nvjpg *nvjpg, u32 value, unsigned int off
 	writel(value, nvjpg->regs + offset);
 }
 
-static int nvjpg_set_rate(struct nvjpg *nvjpg, unsigned long rate)
+static int nvjpg_set_rate(struct device *dev, unsigned long rate)
 {
+	struct nvjpg *nvjpg = dev_get_drvdata(dev);
 	unsigned long dev_rate;
 	u32 emc_kbps;
 	int err;
@@ -116,116 +114,6 @@ static int nvjpg_boot(struct nvjpg *nvjpg)
 	return 0;
 }
 
-static void nvjpg_devfreq_update_wmark_threshold(struct devfreq *devfreq,
-						 struct devfreq_tegra_wmark_config *cfg)
-{
-	struct nvjpg *nvjpg = dev_get_drvdata(devfreq->dev.parent);
-	struct host1x_client *client = &nvjpg->client.base;
-
-	host1x_actmon_update_active_wmark(client,
-					  cfg->avg_upper_wmark,
-					  cfg->avg_lower_wmark,
-					  cfg->consec_upper_wmark,
-					  cfg->consec_lower_wmark,
-					  cfg->upper_wmark_enabled,
-					  cfg->lower_wmark_enabled);
-}
-
-static int nvjpg_devfreq_target(struct device *dev, unsigned long *freq, u32 flags)
-{
-	struct nvjpg *nvjpg = dev_get_drvdata(dev);
-	int err;
-
-	err = nvjpg_set_rate(nvjpg, *freq);
-	if (err < 0) {
-		dev_err(dev, "failed to set clock rate\n");
-		return err;
-	}
-
-	*freq = clk_get_rate(nvjpg->clk);
-
-	return 0;
-}
-
-static int nvjpg_devfreq_get_dev_status(struct device *dev, struct devfreq_dev_status *stat)
-{
-	struct nvjpg *nvjpg = dev_get_drvdata(dev);
-	struct host1x_client *client = &nvjpg->client.base;
-	unsigned long usage;
-
-	/* Update load information */
-	host1x_actmon_read_active_norm(client, &usage);
-	stat->total_time = 1;
-	stat->busy_time = usage;
-
-	/* Update device frequency */
-	stat->current_frequency = clk_get_rate(nvjpg->clk);
-
-	return 0;
-}
-
-static int nvjpg_devfreq_get_cur_freq(struct device *dev, unsigned long *freq)
-{
-	struct nvjpg *nvjpg = dev_get_drvdata(dev);
-
-	*freq = clk_get_rate(nvjpg->clk);
-
-	return 0;
-}
-
-static int nvjpg_devfreq_init(struct nvjpg *nvjpg)
-{
-	unsigned long max_rate = clk_round_rate(nvjpg->clk, ULONG_MAX);
-	unsigned long min_rate = clk_round_rate(nvjpg->clk, 0);
-	unsigned long margin = clk_round_rate(nvjpg->clk, min_rate + 1) - min_rate;
-	unsigned long rate = min_rate;
-	struct devfreq_tegra_wmark_data *data;
-	struct devfreq_dev_profile *devfreq_profile;
-	struct devfreq *devfreq;
-
-	while (rate <= max_rate) {
-		dev_pm_opp_add(nvjpg->dev, rate, 0);
-		rate += margin;
-	}
-
-	data = devm_kzalloc(nvjpg->dev, sizeof(*data), GFP_KERNEL);
-	if (!data)
-		return -ENOMEM;
-
-	data->event = DEVFREQ_TEGRA_AVG_WMARK_BELOW;
-	data->update_wmark_threshold = nvjpg_devfreq_update_wmark_threshold;
-
-	devfreq_profile = devm_kzalloc(nvjpg->dev, sizeof(*devfreq_profile), GFP_KERNEL);
-	if (!devfreq_profile)
-		return -ENOMEM;
-
-	devfreq_profile->target = nvjpg_devfreq_target;
-	devfreq_profile->get_dev_status = nvjpg_devfreq_get_dev_status;
-	devfreq_profile->get_cur_freq = nvjpg_devfreq_get_cur_freq;
-	devfreq_profile->initial_freq = max_rate;
-	devfreq_profile->polling_ms = 100;
-
-	devfreq = devm_devfreq_add_device(nvjpg->dev,
-					  devfreq_profile,
-					  DEVFREQ_GOV_USERSPACE,
-					  data);
-	if (IS_ERR(devfreq))
-		return PTR_ERR(devfreq);
-
-	nvjpg->devfreq = devfreq;
-
-	return 0;
-}
-
-static void nvjpg_devfreq_deinit(struct nvjpg *nvjpg)
-{
-	if (!nvjpg->devfreq)
-		return;
-
-	devm_devfreq_remove_device(nvjpg->dev, nvjpg->devfreq);
-	nvjpg->devfreq = NULL;
-}
-
 static int nvjpg_init(struct host1x_client *client)
 {
 	struct tegra_drm_client *drm = host1x_to_drm_client(client);
@@ -326,34 +214,8 @@ static void nvjpg_actmon_event(struct host1x_client *client,
 {
 	struct platform_device *pdev = to_platform_device(client->dev);
 	struct nvjpg *nvjpg = platform_get_drvdata(pdev);
-	struct devfreq *df = nvjpg->devfreq;
-	struct devfreq_tegra_wmark_data *data;
-
-	if (!df)
-		return;
-
-	data = df->data;
-
-	switch (event) {
-	case HOST1X_ACTMON_AVG_WMARK_BELOW:
-		data->event = DEVFREQ_TEGRA_AVG_WMARK_BELOW;
-		break;
-	case HOST1X_ACTMON_AVG_WMARK_ABOVE:
-		data->event = DEVFREQ_TEGRA_AVG_WMARK_ABOVE;
-		break;
-	case HOST1X_ACTMON_CONSEC_WMARK_BELOW:
-		data->event = DEVFREQ_TEGRA_CONSEC_WMARK_BELOW;
-		break;
-	case HOST1X_ACTMON_CONSEC_WMARK_ABOVE:
-		data->event = DEVFREQ_TEGRA_CONSEC_WMARK_ABOVE;
-		break;
-	default:
-		return;
-	}
 
-	mutex_lock(&df->lock);
-	update_devfreq(df);
-	mutex_unlock(&df->lock);
+	tegra_drm_dvfs_actmon_event(&nvjpg->dvfs, event);
 }
 
 static const struct host1x_client_ops nvjpg_client_ops = {
@@ -469,15 +331,13 @@ static __maybe_unused int nvjpg_runtime_resume(struct device *dev)
 	if (err < 0)
 		goto disable;
 
-	/* Forcely set frequency as Fmax when device is resumed back */
-	nvjpg->devfreq->resume_freq = nvjpg->devfreq->scaling_max_freq;
-	err = devfreq_resume_device(nvjpg->devfreq);
+	err = tegra_drm_dvfs_resume(&nvjpg->dvfs);
 	if (err < 0)
 		goto disable;
 
 	nvjpg_actmon_reg_init(nvjpg);
 
-	nvjpg_count_weight_init(nvjpg, nvjpg->devfreq->scaling_max_freq);
+	nvjpg_count_weight_init(nvjpg, nvjpg->dvfs.devfreq->scaling_max_freq);
 
 	host1x_actmon_enable(&nvjpg->client.base);
 
@@ -493,7 +353,7 @@ static __maybe_unused int nvjpg_runtime_suspend(struct device *dev)
 	struct nvjpg *nvjpg = dev_get_drvdata(dev);
 	int err;
 
-	err = devfreq_suspend_device(nvjpg->devfreq);
+	err = tegra_drm_dvfs_suspend(&nvjpg->dvfs);
 	if (err < 0)
 		return err;
 
@@ -514,7 +374,7 @@ static __maybe_unused int nvjpg_runtime_suspend(struct device *dev)
 	return 0;
 
 devfreq_resume:
-	devfreq_resume_device(nvjpg->devfreq);
+	tegra_drm_dvfs_resume(&nvjpg->dvfs);
 	return err;
 }
 
@@ -672,6 +532,8 @@ static int nvjpg_probe(struct platform_device *pdev)
 	INIT_LIST_HEAD(&nvjpg->client.list);
 	nvjpg->client.version = nvjpg->config->version;
 	nvjpg->client.ops = &nvjpg_ops;
+	nvjpg->client.engine = TEGRA_DRM_ENGINE_NVJPG;
+	nvjpg->client.dvfs = &nvjpg->dvfs;
 
 	err = host1x_client_register(&nvjpg->client.base);
 	if (err < 0) {
@@ -690,7 +552,13 @@ static int nvjpg_probe(struct platform_device *pdev)
 		goto exit_actmon;
 	}
 
-	err = nvjpg_devfreq_init(nvjpg);
+	nvjpg->dvfs.dev = dev;
+	nvjpg->dvfs.client = &nvjpg->client.base;
+	nvjpg->dvfs.clk = nvjpg->clk;
+	nvjpg->dvfs.set_rate = nvjpg_set_rate;
+	nvjpg->dvfs.total_time = 1;
+
+	err = tegra_drm_dvfs_init(&nvjpg->dvfs);
 	if (err < 0) {
 		dev_err(&pdev->dev, "failed to init devfreq: %d\n", err);
 		goto exit_actmon;
@@ -717,7 +585,7 @@ static int nvjpg_remove(struct platform_device *pdev)
 
 	pm_runtime_disable(&pdev->dev);
 
-	nvjpg_devfreq_deinit(nvjpg);
+	tegra_drm_dvfs_exit(&nvjpg->dvfs);
 
 	host1x_actmon_unregister(&nvjpg->client.base);
 
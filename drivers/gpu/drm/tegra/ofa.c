@@ -5,8 +5,6 @@
 
 #include <linux/clk.h>
 #include <linux/delay.h>
-#include <linux/devfreq.h>
-#include <linux/devfreq/tegra_wmark.h>
 #include <linux/host1x-next.h>
 #include <linux/iommu.h>
 #include <linux/iopoll.h>
@@ -21,6 +19,7 @@
 #include <soc/tegra/pmc.h>
 
 #include "drm.h"
+#include "dvfs.h"
 #include "falcon.h"
 #include "util.h"
 #include "vic.h"
@@ -53,8 +52,7 @@ struct ofa {
 	struct host1x_channel *channel;
 	struct device *dev;
 	struct clk *clk;
-	struct devfreq *devfreq;
-	struct devfreq_dev_profile *devfreq_profile;
+	struct tegra_drm_dvfs dvfs;
 
 	/* Platform configuration */
 	const struct ofa_config *config;
@@ -97,116 +95,6 @@ static int ofa_boot(struct ofa *ofa)
 	return 0;
 }
 
-static void ofa_devfreq_update_wmark_threshold(struct devfreq *devfreq,
-						 struct devfreq_tegra_wmark_config *cfg)
-{
-	struct ofa *ofa = dev_get_drvdata(devfreq->dev.parent);
-	struct host1x_client *client = &ofa->client.base;
-
-	host1x_actmon_update_active_wmark(client,
-					  cfg->avg_upper_wmark,
-					  cfg->avg_lower_wmark,
-					  cfg->consec_upper_wmark,
-					  cfg->consec_lower_wmark,
-					  cfg->upper_wmark_enabled,
-					  cfg->lower_wmark_enabled);
-}
-
-static int ofa_devfreq_target(struct device *dev, unsigned long *freq, u32 flags)
-{
-	struct ofa *ofa = dev_get_drvdata(dev);
-	int err;
-
-	err = clk_set_rate(ofa->clk, *freq);
-	if (err < 0) {
-		dev_err(dev, "failed to set clock rate\n");
-		return err;
-	}
-
-	*freq = clk_get_rate(ofa->clk);
-
-	return 0;
-}
-
-static int ofa_devfreq_get_dev_status(struct device *dev, struct devfreq_dev_status *stat)
-{
-	struct ofa *ofa = dev_get_drvdata(dev);
-	struct host1x_client *client = &ofa->client.base;
-	unsigned long usage;
-
-	/* Update load information */
-	host1x_actmon_read_active_norm(client, &usage);
-	stat->total_time = 1000;
-	stat->busy_time = usage;
-
-	/* Update device frequency */
-	stat->current_frequency = clk_get_rate(ofa->clk);
-
-	return 0;
-}
-
-static int ofa_devfreq_get_cur_freq(struct device *dev, unsigned long *freq)
-{
-	struct ofa *ofa = dev_get_drvdata(dev);
-
-	*freq = clk_get_rate(ofa->clk);
-
-	return 0;
-}
-
-static int ofa_devfreq_init(struct ofa *ofa)
-{
-	unsigned long max_rate = clk_round_rate(ofa->clk, ULONG_MAX);
-	unsigned long min_rate = clk_round_rate(ofa->clk, 0);
-	unsigned long margin = clk_round_rate(ofa->clk, min_rate + 1) - min_rate;
-	unsigned long rate = min_rate;
-	struct devfreq_tegra_wmark_data *data;
-	struct devfreq_dev_profile *devfreq_profile;
-	struct devfreq *devfreq;
-
-	while (rate <= max_rate) {
-		dev_pm_opp_add(ofa->dev, rate, 0);
-		rate += margin;
-	}
-
-	data = devm_kzalloc(ofa->dev, sizeof(*data), GFP_KERNEL);
-	if (!data)
-		return -ENOMEM;
-
-	data->event = DEVFREQ_TEGRA_AVG_WMARK_BELOW;
-	data->update_wmark_threshold = ofa_devfreq_update_wmark_threshold;
-
-	devfreq_profile = devm_kzalloc(ofa->dev, sizeof(*devfreq_profile), GFP_KERNEL);
-	if (!devfreq_profile)
-		return -ENOMEM;
-
-	devfreq_profile->target = ofa_devfreq_target;
-	devfreq_profile->get_dev_status = ofa_devfreq_get_dev_status;
-	devfreq_profile->get_cur_freq = ofa_devfreq_get_cur_freq;
-	devfreq_profile->initial_freq = max_rate;
-	devfreq_profile->polling_ms = 100;
-
-	devfreq = devm_devfreq_add_device(ofa->dev,
-					  devfreq_profile,
-					  DEVFREQ_GOV_USERSPACE,
-					  data);
-	if (IS_ERR(devfreq))
-		return PTR_ERR(devfreq);
-
-	ofa->devfreq = devfreq;
-
-	return 0;
-}
-
-static void ofa_devfreq_deinit(struct ofa *ofa)
-{
-	if (!ofa->devfreq)
-		return;
-
-	devm_devfreq_remove_device(ofa->dev, ofa->devfreq);
-	ofa->devfreq = NULL;
-}
-
 static int ofa_init(struct host1x_client *client)
 {
 	struct tegra_drm_client *drm = host1x_to_drm_client(client);
@@ -290,34 +178,8 @@ static void ofa_actmon_event(struct host1x_client *client,
 			     enum host1x_actmon_wmark_event event)
 {
 	struct ofa *ofa = dev_get_drvdata(client->dev);
-	struct devfreq *df = ofa->devfreq;
-	struct devfreq_tegra_wmark_data *data;
-
-	if (!df)
-		return;
-
-	data = df->data;
-
-	switch (event) {
-	case HOST1X_ACTMON_AVG_WMARK_BELOW:
-		data->event = DEVFREQ_TEGRA_AVG_WMARK_BELOW;
-		break;
-	case HOST1X_ACTMON_AVG_WMARK_ABOVE:
-		data->event = DEVFREQ_TEGRA_AVG_WMARK_ABOVE;
-		break;
-	case HOST1X_ACTMON_CONSEC_WMARK_BELOW:
-		data->event = DEVFREQ_TEGRA_CONSEC_WMARK_BELOW;
-		break;
-	case HOST1X_ACTMON_CONSEC_WMARK_ABOVE:
-		data->event = DEVFREQ_TEGRA_CONSEC_WMARK_ABOVE;
-		break;
-	default:
-		return;
-	}
 
-	mutex_lock(&df->lock);
-	update_devfreq(df);
-	mutex_unlock(&df->lock);
+	tegra_drm_dvfs_actmon_event(&ofa->dvfs, event);
 }
 
 static const struct host1x_client_ops ofa_client_ops = {
@@ -407,14 +269,13 @@ static __maybe_unused int ofa_runtime_resume(struct device *dev)
 	if (err < 0)
 		goto disable;
 
-	ofa->devfreq->resume_freq = ofa->devfreq->scaling_max_freq;
-	err = devfreq_resume_device(ofa->devfreq);
+	err = tegra_drm_dvfs_resume(&ofa->dvfs);
 	if (err < 0)
 		goto disable;
 
 	ofa_actmon_reg_init(ofa);
 
-	ofa_count_weight_init(ofa, ofa->devfreq->scaling_max_freq);
+	ofa_count_weight_init(ofa, ofa->dvfs.devfreq->scaling_max_freq);
 
 	host1x_actmon_enable(&ofa->client.base);
 
@@ -430,7 +291,7 @@ static __maybe_unused int ofa_runtime_suspend(struct device *dev)
 	struct ofa *ofa = dev_get_drvdata(dev);
 	int err;
 
-	err = devfreq_suspend_device(ofa->devfreq);
+	err = tegra_drm_dvfs_suspend(&ofa->dvfs);
 	if (err < 0)
 		return err;
 
@@ -569,6 +430,8 @@ static int ofa_probe(struct platform_device *pdev)
 	INIT_LIST_HEAD(&ofa->client.list);
 	ofa->client.version = ofa->config->version;
 	ofa->client.ops = &ofa_ops;
+	ofa->client.engine = TEGRA_DRM_ENGINE_OFA;
+	ofa->client.dvfs = &ofa->dvfs;
 
 	err = host1x_client_register(&ofa->client.base);
 	if (err < 0) {
@@ -580,7 +443,12 @@ static int ofa_probe(struct platform_device *pdev)
 	if (err < 0)
 		dev_info(dev, "failed to register host1x actmon: %d\n", err);
 
-	err = ofa_devfreq_init(ofa);
+	ofa->dvfs.dev = dev;
+	ofa->dvfs.client = &ofa->client.base;
+	ofa->dvfs.clk = ofa->clk;
+	ofa->dvfs.total_time = 1000;
+
+	err = tegra_drm_dvfs_init(&ofa->dvfs);
 	if (err < 0) {
 		dev_err(&pdev->dev, "failed to init devfreq: %d\n", err);
 		goto exit_actmon;
@@ -612,7 +480,7 @@ static int ofa_remove(struct platform_device *pdev)
 
 	pm_runtime_disable(&pdev->dev);
 
-	ofa_devfreq_deinit(ofa);
+	tegra_drm_dvfs_exit(&ofa->dvfs);
 
 	tegra_drm_hwpm_unregister(&ofa->hwpm, pdev->resource[0].start,
 		TEGRA_DRM_HWPM_IP_OFA);
@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024, NVIDIA Corporation.
+ */
+
+#include <linux/minmax.h>
+#include <linux/moduleparam.h>
+#include <linux/slab.h>
+
+#include "sched.h"
+
+/*
+ * Jobs an engine channel may have in flight, shared between the contexts
+ * submitting to it in proportion to their weights.
+ */
+static unsigned int sched_queue_depth = 8;
+module_param(sched_queue_depth, uint, 0644);
+MODULE_PARM_DESC(sched_queue_depth,
+		 "Jobs in flight per engine shared by weight between channel contexts (0 to disable)");
+
+void tegra_drm_sched_init(struct tegra_drm_sched *sched)
+{
+	spin_lock_init(&sched->lock);
+	init_waitqueue_head(&sched->wq);
+	sched->active_weight = 0;
+}
+
+struct tegra_drm_sched_entity *
+tegra_drm_sched_entity_create(struct tegra_drm_sched *sched, unsigned int weight)
+{
+	struct tegra_drm_sched_entity *entity;
+
+	entity = kzalloc(sizeof(*entity), GFP_KERNEL);
+	if (!entity)
+		return NULL;
+
+	kref_init(&entity->ref);
+	entity->sched = sched;
+	entity->weight = weight;
+
+	return entity;
+}
+
+struct tegra_drm_sched_entity *
+tegra_drm_sched_entity_get(struct tegra_drm_sched_entity *entity)
+{
+	kref_get(&entity->ref);
+
+	return entity;
+}
+
+static void tegra_drm_sched_entity_release(struct kref *ref)
+{
+	struct tegra_drm_sched_entity *entity =
+		container_of(ref, struct tegra_drm_sched_entity, ref);
+
+	kfree(entity);
+}
+
+void tegra_drm_sched_entity_put(struct tegra_drm_sched_entity *entity)
+{
+	kref_put(&entity->ref, tegra_drm_sched_entity_release);
+}
+
+/* Must be called with the scheduler lock held. */
+static void tegra_drm_sched_entity_idle(struct tegra_drm_sched_entity *entity)
+{
+	struct tegra_drm_sched *sched = entity->sched;
+
+	if (entity->inflight || entity->waiting)
+		return;
+
+	sched->active_weight -= entity->weight;
+
+	/* The shares of the remaining contexts grow */
+	wake_up_all(&sched->wq);
+}
+
+static bool tegra_drm_sched_admit(struct tegra_drm_sched_entity *entity)
+{
+	struct tegra_drm_sched *sched = entity->sched;
+	unsigned int depth = READ_ONCE(sched_queue_depth);
+	unsigned long flags;
+	unsigned int share;
+	bool admit;
+
+	spin_lock_irqsave(&sched->lock, flags);
+
+	share = max(1U, depth * entity->weight / sched->active_weight);
+	admit = !depth || entity->inflight < share;
+	if (admit) {
+		entity->waiting--;
+		entity->inflight++;
+	}
+
+	spin_unlock_irqrestore(&sched->lock, flags);
+
+	return admit;
+}
+
+/*
+ * Wait until the context may submit another job to the engine. Every
+ * successful call must be paired with tegra_drm_sched_job_end() once the
+ * job has completed or failed to submit, and keeps the entity alive until
+ * then. Returns -ERESTARTSYS if interrupted by a signal.
+ */
+int tegra_drm_sched_job_begin(struct tegra_drm_sched_entity *entity)
+{
+	struct tegra_drm_sched *sched = entity->sched;
+	unsigned long flags;
+	int err;
+
+	spin_lock_irqsave(&sched->lock, flags);
+
+	if (!entity->inflight && !entity->waiting)
+		sched->active_weight += entity->weight;
+
+	entity->waiting++;
+
+	spin_unlock_irqrestore(&sched->lock, flags);
+
+	err = wait_event_interruptible(sched->wq, tegra_drm_sched_admit(entity));
+	if (err < 0) {
+		spin_lock_irqsave(&sched->lock, flags);
+		entity->waiting--;
+		tegra_drm_sched_entity_idle(entity);
+		spin_unlock_irqrestore(&sched->lock, flags);
+
+		return err;
+	}
+
+	tegra_drm_sched_entity_get(entity);
+
+	return 0;
+}
+
+void tegra_drm_sched_job_end(struct tegra_drm_sched_entity *entity)
+{
+	struct tegra_drm_sched *sched = entity->sched;
+	unsigned long flags;
+
+	spin_lock_irqsave(&sched->lock, flags);
+
+	entity->inflight--;
+	tegra_drm_sched_entity_idle(entity);
+
+	/* A slot of the context's share is free again */
+	if (entity->waiting)
+		wake_up_all(&sched->wq);
+
+	spin_unlock_irqrestore(&sched->lock, flags);
+
+	tegra_drm_sched_entity_put(entity);
+}
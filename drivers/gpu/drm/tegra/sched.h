@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2024, NVIDIA Corporation.
+ */
+
+#ifndef _TEGRA_DRM_SCHED_H_
+#define _TEGRA_DRM_SCHED_H_
+
+#include <linux/kref.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+
+#define TEGRA_DRM_SCHED_WEIGHT_DEFAULT	100
+#define TEGRA_DRM_SCHED_WEIGHT_MAX	1000
+
+/*
+ * Weighted sharing of an engine channel between the channel contexts that
+ * submit to it. Jobs run in submission order on the channel, so a context
+ * is only admitted to submit while it has fewer jobs in flight than its
+ * weighted share of the queue depth; otherwise the submitting task waits
+ * for its own jobs to complete. A context with a few latency sensitive
+ * jobs thus never queues behind more than the shares of the others.
+ */
+struct tegra_drm_sched {
+	spinlock_t lock;
+	wait_queue_head_t wq;
+	/* Sum of the weights of the contexts with jobs in flight or waiting */
+	unsigned int active_weight;
+};
+
+struct tegra_drm_sched_entity {
+	struct kref ref;
+	struct tegra_drm_sched *sched;
+	unsigned int weight;
+
+	/* Protected by the scheduler lock */
+	unsigned int inflight;
+	unsigned int waiting;
+};
+
+void tegra_drm_sched_init(struct tegra_drm_sched *sched);
+struct tegra_drm_sched_entity *
+tegra_drm_sched_entity_create(struct tegra_drm_sched *sched, unsigned int weight);
+struct tegra_drm_sched_entity *
+tegra_drm_sched_entity_get(struct tegra_drm_sched_entity *entity);
+void tegra_drm_sched_entity_put(struct tegra_drm_sched_entity *entity);
+int tegra_drm_sched_job_begin(struct tegra_drm_sched_entity *entity);
+void tegra_drm_sched_job_end(struct tegra_drm_sched_entity *entity);
+
+#endif /* _TEGRA_DRM_SCHED_H_ */
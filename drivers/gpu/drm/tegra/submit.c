@@ -10,6 +10,7 @@
 #include <linux/iommu.h>
 #include <linux/kref.h>
 #include <linux/list.h>
+#include <linux/math64.h>
 #include <linux/nospec.h>
 #include <linux/overflow.h>
 #include <linux/pm_runtime.h>
@@ -21,7 +22,10 @@
 #include <drm/drm_file.h>
 #include <drm/drm_syncobj.h>
 
+#include <asm/arch_timer.h>
+
 #include "drm.h"
+#include "dvfs.h"
 #include "falcon.h"
 #include "gem.h"
 #include "submit.h"
@@ -45,6 +49,47 @@ struct gather_bo {
 	size_t gather_data_words;
 };
 
+/*
+ * Command of a persistent job that has already been validated, replayed as-is
+ * on every submission of the job.
+ */
+struct tegra_drm_job_cmd {
+	u32 type;
+
+	union {
+		struct {
+			u32 words;
+			u32 offset;
+		} gather;
+
+		struct {
+			u32 id;
+			u32 value;
+			u32 next_class;
+		} wait;
+	};
+};
+
+/*
+ * A job whose gather data has been copied, relocated and validated once. The
+ * gather buffer mapping is kept in @cache after the first submission, so
+ * resubmitting only allocates the host1x job and patches syncpoint thresholds.
+ */
+struct tegra_drm_persistent_job {
+	struct kref ref;
+
+	struct gather_bo *bo;
+	struct host1x_bo_cache cache;
+	struct tegra_drm_submit_data job_data;
+
+	struct tegra_drm_job_cmd *cmds;
+	u32 num_cmds;
+
+	struct host1x_syncpt *syncpt;
+	struct host1x_syncpt *secondary_syncpt;
+	u32 syncpt_incrs;
+};
+
 static struct host1x_bo *gather_bo_get(struct host1x_bo *host_bo)
 {
 	struct gather_bo *bo = container_of(host_bo, struct gather_bo, base);
@@ -265,6 +310,50 @@ static int submit_write_reloc(struct tegra_drm_context *context, struct gather_b
 	return 0;
 }
 
+/*
+ * With DRM_TEGRA_SUBMIT_BUF_FIXED_IOVA userspace has already written the
+ * address from drm_tegra_channel_map.iova into the gather, so the word is
+ * only checked to point into the mapping instead of being patched.
+ */
+static int submit_check_fixed_iova(struct tegra_drm_context *context, struct gather_bo *bo,
+				   struct drm_tegra_submit_buf *buf,
+				   struct tegra_drm_mapping *mapping)
+{
+	dma_addr_t start, addr;
+	u32 offset;
+
+	if (buf->reloc.gather_offset_words >= bo->gather_data_words) {
+		SUBMIT_ERR(context,
+			   "fixed address has too large gather offset (%u vs gather length %zu)",
+			   buf->reloc.gather_offset_words, bo->gather_data_words);
+		return -EINVAL;
+	}
+
+	if (buf->reloc.shift >= 32) {
+		SUBMIT_ERR(context, "invalid shift %u for fixed address", buf->reloc.shift);
+		return -EINVAL;
+	}
+
+	offset = array_index_nospec(buf->reloc.gather_offset_words, bo->gather_data_words);
+	addr = (dma_addr_t)bo->gather_data[offset] << buf->reloc.shift;
+
+#ifdef CONFIG_ARCH_DMA_ADDR_T_64BIT
+	if (buf->flags & DRM_TEGRA_SUBMIT_RELOC_SECTOR_LAYOUT)
+		addr &= ~BIT_ULL(39);
+#endif
+
+	/* the low bits dropped by the shift may be below the mapping start */
+	start = mapping->iova & ~(((dma_addr_t)1 << buf->reloc.shift) - 1);
+
+	if (addr < start || addr >= mapping->iova_end) {
+		SUBMIT_ERR(context, "fixed address %pad at word %u is outside of mapping %u",
+			   &addr, offset, buf->mapping);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 static int submit_process_bufs(struct tegra_drm_context *context, struct gather_bo *bo,
 			       struct drm_tegra_channel_submit *args,
 			       struct tegra_drm_submit_data *job_data)
@@ -292,7 +381,8 @@ static int submit_process_bufs(struct tegra_drm_context *context, struct gather_
 		struct drm_tegra_submit_buf *buf = &bufs[i];
 		struct tegra_drm_mapping *mapping;
 
-		if (buf->flags & ~DRM_TEGRA_SUBMIT_RELOC_SECTOR_LAYOUT) {
+		if (buf->flags & ~(DRM_TEGRA_SUBMIT_RELOC_SECTOR_LAYOUT |
+				   DRM_TEGRA_SUBMIT_BUF_FIXED_IOVA)) {
 			SUBMIT_ERR(context, "invalid flag specified for buffer");
 			err = -EINVAL;
 			goto drop_refs;
@@ -305,7 +395,10 @@ static int submit_process_bufs(struct tegra_drm_context *context, struct gather_
 			goto drop_refs;
 		}
 
-		err = submit_write_reloc(context, bo, buf, mapping);
+		if (buf->flags & DRM_TEGRA_SUBMIT_BUF_FIXED_IOVA)
+			err = submit_check_fixed_iova(context, bo, buf, mapping);
+		else
+			err = submit_write_reloc(context, bo, buf, mapping);
 		if (err) {
 			tegra_drm_mapping_put(mapping);
 			goto drop_refs;
@@ -397,7 +490,7 @@ static int submit_job_add_gather(struct host1x_job *job, struct tegra_drm_contex
 		return -EINVAL;
 	}
 
-	if (tegra_drm_fw_validate(context->client, bo->gather_data, *offset,
+	if (tegra_drm_fw_validate(context, bo->gather_data, *offset,
 				  cmd->words, job_data, class)) {
 		SUBMIT_ERR(context, "job was rejected by firewall");
 		return -EINVAL;
@@ -413,7 +506,8 @@ static int submit_job_add_gather(struct host1x_job *job, struct tegra_drm_contex
 static struct host1x_job *
 submit_create_job(struct tegra_drm_context *context, struct gather_bo *bo,
 		  struct drm_tegra_channel_submit *args, struct tegra_drm_submit_data *job_data,
-		  struct xarray *syncpoints, struct drm_tegra_submit_cmd *cmds)
+		  struct xarray *syncpoints, struct drm_tegra_submit_cmd *cmds,
+		  struct tegra_drm_job_cmd *recorded)
 {
 	u32 i, gather_offset = 0, class;
 	bool first_gather = true;
@@ -460,6 +554,8 @@ submit_create_job(struct tegra_drm_context *context, struct gather_bo *bo,
 		}
 
 		if (cmd->type == DRM_TEGRA_SUBMIT_CMD_GATHER_UPTR) {
+			u32 offset = gather_offset;
+
 			if (first_gather && job_data->timestamps.virt) {
 				first_gather = false;
 
@@ -473,6 +569,12 @@ submit_create_job(struct tegra_drm_context *context, struct gather_bo *bo,
 						    &gather_offset, job_data, &class);
 			if (err)
 				goto free_job;
+
+			if (recorded) {
+				recorded[i].type = cmd->type;
+				recorded[i].gather.words = cmd->gather_uptr.words;
+				recorded[i].gather.offset = offset;
+			}
 		} else if (cmd->type == DRM_TEGRA_SUBMIT_CMD_WAIT_SYNCPT) {
 			if (cmd->wait_syncpt.reserved[0] || cmd->wait_syncpt.reserved[1]) {
 				SUBMIT_ERR(context, "non-zero reserved value");
@@ -480,6 +582,12 @@ submit_create_job(struct tegra_drm_context *context, struct gather_bo *bo,
 				goto free_job;
 			}
 
+			if (recorded) {
+				SUBMIT_ERR(context, "CMD_WAIT_SYNCPT is not allowed in persistent jobs");
+				err = -EINVAL;
+				goto free_job;
+			}
+
 			host1x_job_add_wait(job, cmd->wait_syncpt.id, cmd->wait_syncpt.value,
 					    false, class);
 		} else if (cmd->type == DRM_TEGRA_SUBMIT_CMD_WAIT_SYNCPT_RELATIVE) {
@@ -497,6 +605,13 @@ submit_create_job(struct tegra_drm_context *context, struct gather_bo *bo,
 
 			host1x_job_add_wait(job, cmd->wait_syncpt.id, cmd->wait_syncpt.value,
 					    true, class);
+
+			if (recorded) {
+				recorded[i].type = cmd->type;
+				recorded[i].wait.id = cmd->wait_syncpt.id;
+				recorded[i].wait.value = cmd->wait_syncpt.value;
+				recorded[i].wait.next_class = class;
+			}
 		} else {
 			SUBMIT_ERR(context, "unknown cmd type");
 			err = -EINVAL;
@@ -520,10 +635,22 @@ done:
 	return job;
 }
 
+/* Engine timestamps run at 32 times CNTVCT */
+static u64 submit_timestamps_busy_ns(const u64 *timestamps)
+{
+	u32 rate = arch_timer_get_cntfrq();
+
+	if (!rate || timestamps[1] <= timestamps[0])
+		return 0;
+
+	return mul_u64_u32_div((timestamps[1] - timestamps[0]) >> 5, NSEC_PER_SEC, rate);
+}
+
 static void release_job(struct host1x_job *job)
 {
 	struct tegra_drm_client *client = container_of(job->client, struct tegra_drm_client, base);
 	struct tegra_drm_submit_data *job_data = job->user_data;
+	u64 busy_ns = 0, estimated_ns;
 	u32 i;
 
 	if (job->memory_context)
@@ -532,8 +659,10 @@ static void release_job(struct host1x_job *job)
 	if (IS_ENABLED(CONFIG_TRACING) && job_data->timestamps.virt) {
 		u64 *timestamps = job_data->timestamps.virt;
 
-		if (timestamps[0] != 0)
+		if (timestamps[0] != 0) {
 			trace_job_timestamps(job_data->id, timestamps[0] >> 5, timestamps[1] >> 5);
+			busy_ns = submit_timestamps_busy_ns(timestamps);
+		}
 
 		dma_free_coherent(job_data->timestamps.dev, 256, job_data->timestamps.virt,
 				  job_data->timestamps.iova);
@@ -543,6 +672,19 @@ static void release_job(struct host1x_job *job)
 		tegra_drm_mapping_put(job_data->used_mappings[i].mapping);
 
 	kfree(job_data->used_mappings);
+
+	estimated_ns = tegra_drm_dvfs_job_done(client->dvfs, &job_data->dvfs, true);
+
+	/* Fall back to the software estimate without engine timestamps */
+	if (job_data->usage) {
+		atomic64_add(busy_ns ?: estimated_ns,
+			     &job_data->usage->engines[client->engine].busy_ns);
+		tegra_drm_file_usage_put(job_data->usage);
+	}
+
+	if (job_data->sched_entity)
+		tegra_drm_sched_job_end(job_data->sched_entity);
+
 	kfree(job_data);
 
 	if (pm_runtime_enabled(client->base.dev)) {
@@ -578,6 +720,75 @@ static int submit_init_profiling(struct tegra_drm_context *context,
 	return 0;
 }
 
+static int submit_wait_syncobj_in(struct tegra_drm_context *context, struct drm_file *file,
+				  u32 handle)
+{
+	struct dma_fence *fence;
+	int err;
+
+	err = drm_syncobj_find_fence(file, handle, 0, 0, &fence);
+	if (err) {
+		SUBMIT_ERR(context, "invalid syncobj_in '%#x'", handle);
+		return err;
+	}
+
+	err = dma_fence_wait_timeout(fence, true, msecs_to_jiffies(10000));
+	dma_fence_put(fence);
+	if (err) {
+		SUBMIT_ERR(context, "wait for syncobj_in timed out");
+		return err;
+	}
+
+	return 0;
+}
+
+static int submit_init_stream_id(struct tegra_drm_context *context, struct host1x_job *job)
+{
+	int err;
+
+	if (context->client->ops->get_streamid_offset) {
+		err = context->client->ops->get_streamid_offset(
+			context->client, &job->engine_streamid_offset);
+		if (err) {
+			SUBMIT_ERR(context, "failed to get streamid offset: %d", err);
+			return err;
+		}
+	}
+
+	if (context->memory_context && context->client->ops->can_use_memory_ctx) {
+		bool supported;
+
+		err = context->client->ops->can_use_memory_ctx(context->client, &supported);
+		if (err) {
+			SUBMIT_ERR(context, "failed to detect if engine can use memory context: %d", err);
+			return err;
+		}
+
+		if (supported) {
+			job->memory_context = context->memory_context;
+			host1x_memory_context_get(job->memory_context);
+		}
+	} else if (context->client->ops->get_streamid_offset) {
+#ifdef CONFIG_IOMMU_API
+		struct iommu_fwspec *spec;
+
+		/*
+		 * Job submission will need to temporarily change stream ID,
+		 * so need to tell it what to change it back to.
+		 */
+		spec = dev_iommu_fwspec_get(context->client->base.dev);
+		if (spec && spec->num_ids > 0)
+			job->engine_fallback_streamid = spec->ids[0] & 0xffff;
+		else
+			job->engine_fallback_streamid = 0x7f;
+#else
+		job->engine_fallback_streamid = 0x7f;
+#endif
+	}
+
+	return 0;
+}
+
 int tegra_drm_ioctl_channel_submit(struct drm_device *drm, void *data,
 				   struct drm_file *file)
 {
@@ -604,26 +815,21 @@ int tegra_drm_ioctl_channel_submit(struct drm_device *drm, void *data,
 		return -EINVAL;
 	}
 
-	if (args->flags & ~(DRM_TEGRA_SUBMIT_SECONDARY_SYNCPT)) {
+	if (args->flags & ~(DRM_TEGRA_SUBMIT_SECONDARY_SYNCPT |
+			    DRM_TEGRA_SUBMIT_PERF_HINT)) {
 		SUBMIT_ERR(context, "invalid flags '%#x'", args->flags);
 		goto unlock;
 	}
 
-	if (args->syncobj_in) {
-		struct dma_fence *fence;
-
-		err = drm_syncobj_find_fence(file, args->syncobj_in, 0, 0, &fence);
-		if (err) {
-			SUBMIT_ERR(context, "invalid syncobj_in '%#x'", args->syncobj_in);
-			goto unlock;
-		}
+	if (args->reserved) {
+		SUBMIT_ERR(context, "invalid reserved field '%#x'", args->reserved);
+		goto unlock;
+	}
 
-		err = dma_fence_wait_timeout(fence, true, msecs_to_jiffies(10000));
-		dma_fence_put(fence);
-		if (err) {
-			SUBMIT_ERR(context, "wait for syncobj_in timed out");
+	if (args->syncobj_in) {
+		err = submit_wait_syncobj_in(context, file, args->syncobj_in);
+		if (err)
 			goto unlock;
-		}
 	}
 
 	if (args->syncobj_out) {
@@ -672,7 +878,7 @@ int tegra_drm_ioctl_channel_submit(struct drm_device *drm, void *data,
 	}
 
 	/* Allocate host1x_job and add gathers and waits to it. */
-	job = submit_create_job(context, bo, args, job_data, &fpriv->syncpoints, cmds);
+	job = submit_create_job(context, bo, args, job_data, &fpriv->syncpoints, cmds, NULL);
 	if (IS_ERR(job)) {
 		err = PTR_ERR(job);
 		goto free_cmds;
@@ -685,45 +891,9 @@ int tegra_drm_ioctl_channel_submit(struct drm_device *drm, void *data,
 		goto put_job;
 	}
 
-	if (context->client->ops->get_streamid_offset) {
-		err = context->client->ops->get_streamid_offset(
-			context->client, &job->engine_streamid_offset);
-		if (err) {
-			SUBMIT_ERR(context, "failed to get streamid offset: %d", err);
-			goto unpin_job;
-		}
-	}
-
-	if (context->memory_context && context->client->ops->can_use_memory_ctx) {
-		bool supported;
-
-		err = context->client->ops->can_use_memory_ctx(context->client, &supported);
-		if (err) {
-			SUBMIT_ERR(context, "failed to detect if engine can use memory context: %d", err);
-			goto unpin_job;
-		}
-
-		if (supported) {
-			job->memory_context = context->memory_context;
-			host1x_memory_context_get(job->memory_context);
-		}
-	} else if (context->client->ops->get_streamid_offset) {
-#ifdef CONFIG_IOMMU_API
-		struct iommu_fwspec *spec;
-
-		/*
-		 * Job submission will need to temporarily change stream ID,
-		 * so need to tell it what to change it back to.
-		 */
-		spec = dev_iommu_fwspec_get(context->client->base.dev);
-		if (spec && spec->num_ids > 0)
-			job->engine_fallback_streamid = spec->ids[0] & 0xffff;
-		else
-			job->engine_fallback_streamid = 0x7f;
-#else
-		job->engine_fallback_streamid = 0x7f;
-#endif
-	}
+	err = submit_init_stream_id(context, job);
+	if (err)
+		goto unpin_job;
 
 	/* Boot engine, if necessary. */
 	if (pm_runtime_enabled(context->client->base.dev)) {
@@ -734,10 +904,28 @@ int tegra_drm_ioctl_channel_submit(struct drm_device *drm, void *data,
 		}
 	}
 
+	/* Wait for the context's share of the engine queue */
+	err = tegra_drm_sched_job_begin(context->sched_entity);
+	if (err < 0)
+		goto put_runtime_pm;
+
+	job_data->sched_entity = context->sched_entity;
 	job->user_data = job_data;
 	job->release = release_job;
 	job->timeout = 10000;
 
+	/* Raise the engine clock ahead of the job if the queue needs it */
+	if (args->flags & DRM_TEGRA_SUBMIT_PERF_HINT)
+		tegra_drm_dvfs_job_submit(context->client->dvfs, &job_data->dvfs,
+					  args->expected_cycles,
+					  args->deadline_us);
+	else
+		tegra_drm_dvfs_job_submit(context->client->dvfs, &job_data->dvfs,
+					  0, 0);
+
+	/* Account the busy time to the file once the job completes */
+	job_data->usage = tegra_drm_file_usage_get(fpriv->usage);
+
 	/*
 	 * job_data is now part of job reference counting, so don't release
 	 * it from here.
@@ -751,10 +939,20 @@ int tegra_drm_ioctl_channel_submit(struct drm_device *drm, void *data,
 	/* Submit job to hardware. */
 	err = host1x_job_submit(job);
 	if (err) {
+		struct tegra_drm_submit_data *data = job->user_data;
+
+		/* Never ran, keep it out of the per-job cycle history */
+		tegra_drm_dvfs_job_done(context->client->dvfs, &data->dvfs,
+					false);
+		tegra_drm_file_usage_put(data->usage);
+		data->usage = NULL;
+
 		SUBMIT_ERR(context, "host1x job submission failed: %d", err);
 		goto unpin_job;
 	}
 
+	atomic64_inc(&fpriv->usage->engines[context->client->engine].jobs);
+
 	/* Return postfences to userspace and add fences to DMA reservations. */
 	args->syncpt.value = job->syncpt_end;
 
@@ -796,6 +994,9 @@ int tegra_drm_ioctl_channel_submit(struct drm_device *drm, void *data,
 
 	goto put_job;
 
+put_runtime_pm:
+	if (pm_runtime_enabled(context->client->base.dev))
+		pm_runtime_put_autosuspend(context->client->base.dev);
 put_memory_context:
 	if (job->memory_context)
 		host1x_memory_context_put(job->memory_context);
@@ -829,3 +1030,352 @@ unlock:
 	mutex_unlock(&fpriv->lock);
 	return err;
 }
+
+static void tegra_drm_persistent_job_release(struct kref *ref)
+{
+	struct tegra_drm_persistent_job *pjob =
+		container_of(ref, struct tegra_drm_persistent_job, ref);
+	struct host1x_bo_mapping *map, *tmp;
+	u32 i;
+
+	/* Drop the reference the cache holds on the gather mapping. */
+	list_for_each_entry_safe(map, tmp, &pjob->cache.mappings, entry)
+		host1x_bo_unpin(map);
+
+	host1x_bo_cache_destroy(&pjob->cache);
+
+	if (pjob->secondary_syncpt)
+		host1x_syncpt_put(pjob->secondary_syncpt);
+
+	if (pjob->syncpt)
+		host1x_syncpt_put(pjob->syncpt);
+
+	for (i = 0; i < pjob->job_data.num_used_mappings; i++)
+		tegra_drm_mapping_put(pjob->job_data.used_mappings[i].mapping);
+
+	kfree(pjob->job_data.used_mappings);
+	kvfree(pjob->cmds);
+
+	if (pjob->job_data.sched_entity)
+		tegra_drm_sched_entity_put(pjob->job_data.sched_entity);
+
+	if (pjob->bo)
+		gather_bo_put(&pjob->bo->base);
+
+	kfree(pjob);
+}
+
+void tegra_drm_persistent_job_put(struct tegra_drm_persistent_job *pjob)
+{
+	kref_put(&pjob->ref, tegra_drm_persistent_job_release);
+}
+
+static void release_persistent_job(struct host1x_job *job)
+{
+	struct tegra_drm_client *client = container_of(job->client, struct tegra_drm_client, base);
+	struct tegra_drm_persistent_job *pjob = job->user_data;
+
+	if (job->memory_context)
+		host1x_memory_context_put(job->memory_context);
+
+	tegra_drm_sched_job_end(pjob->job_data.sched_entity);
+	tegra_drm_persistent_job_put(pjob);
+
+	if (pm_runtime_enabled(client->base.dev)) {
+		pm_runtime_mark_last_busy(client->base.dev);
+		pm_runtime_put_autosuspend(client->base.dev);
+	}
+}
+
+int tegra_drm_ioctl_channel_job_create(struct drm_device *drm, void *data,
+				       struct drm_file *file)
+{
+	struct tegra_drm_file *fpriv = file->driver_priv;
+	struct drm_tegra_channel_job_create *args = data;
+	struct drm_tegra_channel_submit submit = {
+		.context = args->context,
+		.num_bufs = args->num_bufs,
+		.num_cmds = args->num_cmds,
+		.gather_data_words = args->gather_data_words,
+		.bufs_ptr = args->bufs_ptr,
+		.cmds_ptr = args->cmds_ptr,
+		.gather_data_ptr = args->gather_data_ptr,
+		.syncpt = args->syncpt,
+		.flags = args->flags,
+		.secondary_syncpt_id = args->secondary_syncpt_id,
+	};
+	struct tegra_drm_persistent_job *pjob;
+	struct drm_tegra_submit_cmd *cmds;
+	struct tegra_drm_context *context;
+	struct host1x_job *job;
+	int err;
+
+	mutex_lock(&fpriv->lock);
+
+	context = xa_load(&fpriv->contexts, args->context);
+	if (!context) {
+		mutex_unlock(&fpriv->lock);
+		pr_err_ratelimited("%s: %s: invalid channel context '%#x'", __func__,
+				   current->comm, args->context);
+		return -EINVAL;
+	}
+
+	if (args->flags & ~(DRM_TEGRA_SUBMIT_SECONDARY_SYNCPT)) {
+		SUBMIT_ERR(context, "invalid flags '%#x'", args->flags);
+		err = -EINVAL;
+		goto unlock;
+	}
+
+	pjob = kzalloc(sizeof(*pjob), GFP_KERNEL);
+	if (!pjob) {
+		SUBMIT_ERR(context, "failed to allocate memory for persistent job");
+		err = -ENOMEM;
+		goto unlock;
+	}
+
+	kref_init(&pjob->ref);
+	host1x_bo_cache_init(&pjob->cache);
+	pjob->job_data.sched_entity = tegra_drm_sched_entity_get(context->sched_entity);
+
+	/*
+	 * From here on the release function copes with a partially set up
+	 * job, so every failure can simply drop the reference.
+	 */
+	err = submit_copy_gather_data(&pjob->bo, drm->dev, context, &submit);
+	if (err)
+		goto put_pjob;
+
+	err = submit_process_bufs(context, pjob->bo, &submit, &pjob->job_data);
+	if (err)
+		goto put_pjob;
+
+	cmds = alloc_copy_user_array(u64_to_user_ptr(args->cmds_ptr), args->num_cmds,
+				     sizeof(*cmds));
+	if (IS_ERR(cmds)) {
+		SUBMIT_ERR(context, "failed to copy cmds array from userspace");
+		err = PTR_ERR(cmds);
+		goto put_pjob;
+	}
+
+	pjob->cmds = kvcalloc(args->num_cmds, sizeof(*pjob->cmds), GFP_KERNEL);
+	if (!pjob->cmds) {
+		SUBMIT_ERR(context, "failed to allocate memory for persistent job cmds");
+		err = -ENOMEM;
+		goto free_cmds;
+	}
+
+	/*
+	 * Run the job through the regular validation once and keep only the
+	 * recorded commands and syncpoints; the job itself is never submitted.
+	 */
+	job = submit_create_job(context, pjob->bo, &submit, &pjob->job_data, &fpriv->syncpoints,
+				cmds, pjob->cmds);
+	if (IS_ERR(job)) {
+		err = PTR_ERR(job);
+		goto free_cmds;
+	}
+
+	pjob->num_cmds = args->num_cmds;
+	pjob->syncpt = host1x_syncpt_get(job->syncpt);
+	pjob->syncpt_incrs = job->syncpt_incrs;
+
+	if (job->secondary_syncpt)
+		pjob->secondary_syncpt = host1x_syncpt_get(job->secondary_syncpt);
+
+	host1x_job_put(job);
+	kvfree(cmds);
+
+	err = xa_alloc(&context->jobs, &args->job, pjob, XA_LIMIT(1, U32_MAX), GFP_KERNEL);
+	if (err < 0)
+		goto put_pjob;
+
+	mutex_unlock(&fpriv->lock);
+	return 0;
+
+free_cmds:
+	kvfree(cmds);
+put_pjob:
+	tegra_drm_persistent_job_put(pjob);
+unlock:
+	mutex_unlock(&fpriv->lock);
+	return err;
+}
+
+int tegra_drm_ioctl_channel_job_submit(struct drm_device *drm, void *data,
+				       struct drm_file *file)
+{
+	struct tegra_drm_file *fpriv = file->driver_priv;
+	struct drm_tegra_channel_job_submit *args = data;
+	struct tegra_drm_persistent_job *pjob;
+	struct drm_syncobj *syncobj = NULL;
+	struct tegra_drm_context *context;
+	struct host1x_job *job;
+	u32 i;
+	int err;
+
+	mutex_lock(&fpriv->lock);
+
+	context = xa_load(&fpriv->contexts, args->context);
+	if (!context) {
+		mutex_unlock(&fpriv->lock);
+		pr_err_ratelimited("%s: %s: invalid channel context '%#x'", __func__,
+				   current->comm, args->context);
+		return -EINVAL;
+	}
+
+	if (args->flags) {
+		SUBMIT_ERR(context, "invalid flags '%#x'", args->flags);
+		err = -EINVAL;
+		goto unlock;
+	}
+
+	pjob = xa_load(&context->jobs, args->job);
+	if (!pjob) {
+		SUBMIT_ERR(context, "invalid persistent job '%#x'", args->job);
+		err = -EINVAL;
+		goto unlock;
+	}
+
+	if (args->syncobj_in) {
+		err = submit_wait_syncobj_in(context, file, args->syncobj_in);
+		if (err)
+			goto unlock;
+	}
+
+	if (args->syncobj_out) {
+		syncobj = drm_syncobj_find(file, args->syncobj_out);
+		if (!syncobj) {
+			SUBMIT_ERR(context, "invalid syncobj_out '%#x'", args->syncobj_out);
+			err = -ENOENT;
+			goto unlock;
+		}
+	}
+
+	job = host1x_job_alloc(context->channel, pjob->num_cmds, 0, true);
+	if (!job) {
+		SUBMIT_ERR(context, "failed to allocate memory for job");
+		err = -ENOMEM;
+		goto unlock;
+	}
+
+	job->syncpt = host1x_syncpt_get(pjob->syncpt);
+	job->syncpt_incrs = pjob->syncpt_incrs;
+
+	if (pjob->secondary_syncpt)
+		job->secondary_syncpt = host1x_syncpt_get(pjob->secondary_syncpt);
+
+	job->client = &context->client->base;
+	job->class = context->client->base.class;
+	job->serialize = true;
+	job->gather_cache = &pjob->cache;
+
+	/* Commands were validated at creation; relative waits get patched at submit. */
+	for (i = 0; i < pjob->num_cmds; i++) {
+		struct tegra_drm_job_cmd *cmd = &pjob->cmds[i];
+
+		if (cmd->type == DRM_TEGRA_SUBMIT_CMD_GATHER_UPTR)
+			host1x_job_add_gather(job, &pjob->bo->base, cmd->gather.words,
+					      cmd->gather.offset * 4);
+		else
+			host1x_job_add_wait(job, cmd->wait.id, cmd->wait.value, true,
+					    cmd->wait.next_class);
+	}
+
+	/* Map gather data for Host1x, reusing the cached mapping if possible. */
+	err = host1x_job_pin(job, context->client->base.dev);
+	if (err) {
+		SUBMIT_ERR(context, "failed to pin job: %d", err);
+		goto put_job;
+	}
+
+	err = submit_init_stream_id(context, job);
+	if (err)
+		goto unpin_job;
+
+	/* Boot engine, if necessary. */
+	if (pm_runtime_enabled(context->client->base.dev)) {
+		err = pm_runtime_resume_and_get(context->client->base.dev);
+		if (err < 0) {
+			SUBMIT_ERR(context, "could not power up engine: %d", err);
+			goto put_memory_context;
+		}
+	}
+
+	/* Wait for the context's share of the engine queue */
+	err = tegra_drm_sched_job_begin(pjob->job_data.sched_entity);
+	if (err < 0)
+		goto put_runtime_pm;
+
+	kref_get(&pjob->ref);
+	job->user_data = pjob;
+	job->release = release_persistent_job;
+	job->timeout = 10000;
+
+	err = host1x_job_submit(job);
+	if (err) {
+		SUBMIT_ERR(context, "host1x job submission failed: %d", err);
+		goto unpin_job;
+	}
+
+	atomic64_inc(&fpriv->usage->engines[context->client->engine].jobs);
+
+	args->syncpt_value = job->syncpt_end;
+
+	if (syncobj) {
+		struct dma_fence *fence = host1x_fence_create(job->syncpt, job->syncpt_end, true);
+
+		if (IS_ERR(fence)) {
+			err = PTR_ERR(fence);
+			SUBMIT_ERR(context, "failed to create postfence: %d", err);
+		} else {
+			drm_syncobj_replace_fence(syncobj, fence);
+			dma_fence_put(fence);
+		}
+	}
+
+	goto put_job;
+
+put_runtime_pm:
+	if (pm_runtime_enabled(context->client->base.dev))
+		pm_runtime_put_autosuspend(context->client->base.dev);
+put_memory_context:
+	if (job->memory_context)
+		host1x_memory_context_put(job->memory_context);
+unpin_job:
+	host1x_job_unpin(job);
+put_job:
+	host1x_job_put(job);
+unlock:
+	if (syncobj)
+		drm_syncobj_put(syncobj);
+
+	mutex_unlock(&fpriv->lock);
+	return err;
+}
+
+int tegra_drm_ioctl_channel_job_destroy(struct drm_device *drm, void *data,
+					struct drm_file *file)
+{
+	struct tegra_drm_file *fpriv = file->driver_priv;
+	struct drm_tegra_channel_job_destroy *args = data;
+	struct tegra_drm_persistent_job *pjob;
+	struct tegra_drm_context *context;
+
+	mutex_lock(&fpriv->lock);
+
+	context = xa_load(&fpriv->contexts, args->context);
+	if (!context) {
+		mutex_unlock(&fpriv->lock);
+		return -EINVAL;
+	}
+
+	pjob = xa_erase(&context->jobs, args->job);
+
+	mutex_unlock(&fpriv->lock);
+
+	if (!pjob)
+		return -EINVAL;
+
+	tegra_drm_persistent_job_put(pjob);
+	return 0;
+}
@@ -4,6 +4,11 @@
 #ifndef _TEGRA_DRM_UAPI_SUBMIT_H
 #define _TEGRA_DRM_UAPI_SUBMIT_H
 
+#include "dvfs.h"
+
+struct tegra_drm_file_usage;
+struct tegra_drm_sched_entity;
+
 struct tegra_drm_used_mapping {
 	struct tegra_drm_mapping *mapping;
 	u32 flags;
@@ -13,6 +18,9 @@ struct tegra_drm_submit_data {
 	struct tegra_drm_used_mapping *used_mappings;
 	u32 num_used_mappings;
 	u32 id;
+	struct tegra_drm_dvfs_job dvfs;
+	struct tegra_drm_file_usage *usage;
+	struct tegra_drm_sched_entity *sched_entity;
 
 	struct {
 		struct device *dev;
@@ -21,8 +29,9 @@ struct tegra_drm_submit_data {
 	} timestamps;
 };
 
-int tegra_drm_fw_validate(struct tegra_drm_client *client, u32 *data, u32 start,
+int tegra_drm_fw_validate(struct tegra_drm_context *context, u32 *data, u32 start,
 			  u32 words, struct tegra_drm_submit_data *submit,
 			  u32 *job_class);
+void tegra_drm_fw_cache_free(struct tegra_drm_context *context);
 
 #endif
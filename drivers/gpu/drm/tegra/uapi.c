@@ -1,15 +1,23 @@
 // SPDX-License-Identifier: GPL-2.0-only
 /* Copyright (c) 2020 NVIDIA Corporation */
 
+#include <nvidia/conftest.h>
+
 #include <linux/host1x-next.h>
 #include <linux/iommu.h>
 #include <linux/list.h>
+#include <linux/moduleparam.h>
+#include <linux/shrinker.h>
+#include <linux/sizes.h>
+#include <linux/workqueue.h>
 
 #include <drm/drm_drv.h>
 #include <drm/drm_file.h>
+#include <drm/drm_print.h>
 #include <drm/drm_utils.h>
 
 #include "drm.h"
+#include "submit.h"
 #include "uapi.h"
 
 static void tegra_drm_mapping_release(struct kref *ref)
@@ -28,11 +36,291 @@ void tegra_drm_mapping_put(struct tegra_drm_mapping *mapping)
 	kref_put(&mapping->ref, tegra_drm_mapping_release);
 }
 
+/*
+ * Mappings that userspace has unmapped are kept per channel context, up to
+ * this many bytes of buffer memory, so that mapping the same buffer again
+ * (typically once per frame) reuses the existing IOMMU mapping.
+ */
+static unsigned long mapping_cache_size = SZ_256M;
+module_param(mapping_cache_size, ulong, 0644);
+MODULE_PARM_DESC(mapping_cache_size,
+		 "Bytes of unmapped buffers kept mapped per channel context (0 to disable)");
+
+struct tegra_drm_mapping_cache {
+	/* Protects the context list and the cached mappings of every context */
+	struct mutex lock;
+	struct list_head contexts;
+	unsigned long count;
+
+	/* Evicted mappings are released from a worker, outside of reclaim */
+	struct list_head evicted;
+	struct work_struct release_work;
+
+#if defined(NV_SHRINKER_ALLOC_PRESENT) /* Linux 6.7 */
+	struct shrinker *shrinker;
+#else
+	struct shrinker shrinker;
+#endif
+};
+
+static size_t tegra_drm_mapping_size(struct tegra_drm_mapping *mapping)
+{
+	return mapping->iova_end - mapping->iova;
+}
+
+static void tegra_drm_mapping_cache_release_work(struct work_struct *work)
+{
+	struct tegra_drm_mapping_cache *cache =
+		container_of(work, struct tegra_drm_mapping_cache, release_work);
+	struct tegra_drm_mapping *mapping, *tmp;
+	LIST_HEAD(evicted);
+
+	mutex_lock(&cache->lock);
+	list_splice_init(&cache->evicted, &evicted);
+	mutex_unlock(&cache->lock);
+
+	list_for_each_entry_safe(mapping, tmp, &evicted, cache_entry) {
+		list_del(&mapping->cache_entry);
+		tegra_drm_mapping_put(mapping);
+	}
+}
+
+/* Must be called with the cache lock held. */
+static void tegra_drm_mapping_cache_evict(struct tegra_drm_mapping_cache *cache,
+					  struct tegra_drm_context *context,
+					  struct list_head *evicted)
+{
+	struct tegra_drm_mapping *mapping;
+
+	mapping = list_last_entry(&context->cached_mappings, struct tegra_drm_mapping,
+				  cache_entry);
+	list_move(&mapping->cache_entry, evicted);
+	context->cached_mappings_size -= tegra_drm_mapping_size(mapping);
+	cache->count--;
+}
+
+static struct tegra_drm_mapping *
+tegra_drm_mapping_cache_lookup(struct tegra_drm_context *context, struct host1x_bo *bo,
+			       enum dma_data_direction direction)
+{
+	struct tegra_drm_mapping_cache *cache = context->client->drm->mapping_cache;
+	struct tegra_drm_mapping *mapping;
+
+	mutex_lock(&cache->lock);
+
+	list_for_each_entry(mapping, &context->cached_mappings, cache_entry) {
+		if (mapping->bo == bo && mapping->map->direction == direction) {
+			list_del(&mapping->cache_entry);
+			context->cached_mappings_size -= tegra_drm_mapping_size(mapping);
+			cache->count--;
+			mutex_unlock(&cache->lock);
+			return mapping;
+		}
+	}
+
+	mutex_unlock(&cache->lock);
+
+	return NULL;
+}
+
+/* Takes over the caller's reference to the mapping. */
+static void tegra_drm_mapping_cache_add(struct tegra_drm_context *context,
+					struct tegra_drm_mapping *mapping)
+{
+	struct tegra_drm_mapping_cache *cache = context->client->drm->mapping_cache;
+	unsigned long limit = READ_ONCE(mapping_cache_size);
+	struct tegra_drm_mapping *evicted, *tmp;
+	LIST_HEAD(list);
+
+	if (tegra_drm_mapping_size(mapping) > limit) {
+		tegra_drm_mapping_put(mapping);
+		return;
+	}
+
+	mutex_lock(&cache->lock);
+
+	list_add(&mapping->cache_entry, &context->cached_mappings);
+	context->cached_mappings_size += tegra_drm_mapping_size(mapping);
+	cache->count++;
+
+	while (context->cached_mappings_size > limit)
+		tegra_drm_mapping_cache_evict(cache, context, &list);
+
+	mutex_unlock(&cache->lock);
+
+	list_for_each_entry_safe(evicted, tmp, &list, cache_entry) {
+		list_del(&evicted->cache_entry);
+		tegra_drm_mapping_put(evicted);
+	}
+}
+
+static void tegra_drm_mapping_cache_open(struct tegra_drm_context *context)
+{
+	struct tegra_drm_mapping_cache *cache = context->client->drm->mapping_cache;
+
+	INIT_LIST_HEAD(&context->cached_mappings);
+	context->cached_mappings_size = 0;
+
+	mutex_lock(&cache->lock);
+	list_add_tail(&context->mapping_cache_node, &cache->contexts);
+	mutex_unlock(&cache->lock);
+}
+
+static void tegra_drm_mapping_cache_close(struct tegra_drm_context *context)
+{
+	struct tegra_drm_mapping_cache *cache = context->client->drm->mapping_cache;
+	struct tegra_drm_mapping *mapping, *tmp;
+	LIST_HEAD(list);
+
+	mutex_lock(&cache->lock);
+
+	while (!list_empty(&context->cached_mappings))
+		tegra_drm_mapping_cache_evict(cache, context, &list);
+
+	list_del(&context->mapping_cache_node);
+
+	mutex_unlock(&cache->lock);
+
+	list_for_each_entry_safe(mapping, tmp, &list, cache_entry) {
+		list_del(&mapping->cache_entry);
+		tegra_drm_mapping_put(mapping);
+	}
+}
+
+static struct tegra_drm_mapping_cache *to_mapping_cache(struct shrinker *shrinker)
+{
+#if defined(NV_SHRINKER_ALLOC_PRESENT) /* Linux 6.7 */
+	return shrinker->private_data;
+#else
+	return container_of(shrinker, struct tegra_drm_mapping_cache, shrinker);
+#endif
+}
+
+static unsigned long tegra_drm_mapping_cache_count(struct shrinker *shrinker,
+						   struct shrink_control *sc)
+{
+	struct tegra_drm_mapping_cache *cache = to_mapping_cache(shrinker);
+	unsigned long count = READ_ONCE(cache->count);
+
+	return count ? count : SHRINK_EMPTY;
+}
+
+static unsigned long tegra_drm_mapping_cache_scan(struct shrinker *shrinker,
+						  struct shrink_control *sc)
+{
+	struct tegra_drm_mapping_cache *cache = to_mapping_cache(shrinker);
+	struct tegra_drm_context *context;
+	unsigned long freed = 0;
+	bool progress = true;
+
+	/* Map and unmap allocate memory with the lock held, don't recurse. */
+	if (!mutex_trylock(&cache->lock))
+		return SHRINK_STOP;
+
+	/* Take the least recently used mapping of each context in turn. */
+	while (freed < sc->nr_to_scan && progress) {
+		progress = false;
+
+		list_for_each_entry(context, &cache->contexts, mapping_cache_node) {
+			if (list_empty(&context->cached_mappings))
+				continue;
+
+			tegra_drm_mapping_cache_evict(cache, context, &cache->evicted);
+			progress = true;
+
+			if (++freed >= sc->nr_to_scan)
+				break;
+		}
+	}
+
+	mutex_unlock(&cache->lock);
+
+	if (freed)
+		schedule_work(&cache->release_work);
+
+	return freed ? freed : SHRINK_STOP;
+}
+
+int tegra_drm_mapping_cache_init(struct tegra_drm *tegra)
+{
+	struct tegra_drm_mapping_cache *cache;
+	int err = 0;
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache)
+		return -ENOMEM;
+
+	mutex_init(&cache->lock);
+	INIT_LIST_HEAD(&cache->contexts);
+	INIT_LIST_HEAD(&cache->evicted);
+	INIT_WORK(&cache->release_work, tegra_drm_mapping_cache_release_work);
+
+#if defined(NV_SHRINKER_ALLOC_PRESENT) /* Linux 6.7 */
+	cache->shrinker = shrinker_alloc(0, "tegra-drm-mappings");
+	if (!cache->shrinker) {
+		err = -ENOMEM;
+		goto free;
+	}
+
+	cache->shrinker->count_objects = tegra_drm_mapping_cache_count;
+	cache->shrinker->scan_objects = tegra_drm_mapping_cache_scan;
+	cache->shrinker->private_data = cache;
+
+	shrinker_register(cache->shrinker);
+#else
+	cache->shrinker.count_objects = tegra_drm_mapping_cache_count;
+	cache->shrinker.scan_objects = tegra_drm_mapping_cache_scan;
+	cache->shrinker.seeks = DEFAULT_SEEKS;
+
+#if defined(NV_REGISTER_SHRINKER_HAS_FMT_ARG) /* Linux v6.0 */
+	err = register_shrinker(&cache->shrinker, "tegra-drm-mappings");
+#else
+	err = register_shrinker(&cache->shrinker);
+#endif
+	if (err)
+		goto free;
+#endif
+
+	tegra->mapping_cache = cache;
+
+	return 0;
+
+free:
+	mutex_destroy(&cache->lock);
+	kfree(cache);
+	return err;
+}
+
+void tegra_drm_mapping_cache_fini(struct tegra_drm *tegra)
+{
+	struct tegra_drm_mapping_cache *cache = tegra->mapping_cache;
+
+#if defined(NV_SHRINKER_ALLOC_PRESENT) /* Linux 6.7 */
+	shrinker_free(cache->shrinker);
+#else
+	unregister_shrinker(&cache->shrinker);
+#endif
+	flush_work(&cache->release_work);
+
+	mutex_destroy(&cache->lock);
+	kfree(cache);
+	tegra->mapping_cache = NULL;
+}
+
 static void tegra_drm_channel_context_close(struct tegra_drm_context *context)
 {
+	struct tegra_drm_persistent_job *job;
 	struct tegra_drm_mapping *mapping;
 	unsigned long id;
 
+	xa_for_each(&context->jobs, id, job)
+		tegra_drm_persistent_job_put(job);
+
+	tegra_drm_mapping_cache_close(context);
+
+	xa_destroy(&context->jobs);
+	tegra_drm_fw_cache_free(context);
+
 	if (context->memory_context)
 		host1x_memory_context_put(context->memory_context);
 
@@ -41,11 +329,91 @@ static void tegra_drm_channel_context_close(struct tegra_drm_context *context)
 
 	xa_destroy(&context->mappings);
 
+	tegra_drm_sched_entity_put(context->sched_entity);
 	host1x_channel_put(context->channel);
 
 	kfree(context);
 }
 
+static void tegra_drm_file_usage_release(struct kref *ref)
+{
+	struct tegra_drm_file_usage *usage =
+		container_of(ref, struct tegra_drm_file_usage, ref);
+
+	kfree(usage);
+}
+
+struct tegra_drm_file_usage *tegra_drm_file_usage_get(struct tegra_drm_file_usage *usage)
+{
+	kref_get(&usage->ref);
+
+	return usage;
+}
+
+void tegra_drm_file_usage_put(struct tegra_drm_file_usage *usage)
+{
+	kref_put(&usage->ref, tegra_drm_file_usage_release);
+}
+
+int tegra_drm_uapi_open_file(struct tegra_drm_file *file)
+{
+	file->usage = kzalloc(sizeof(*file->usage), GFP_KERNEL);
+	if (!file->usage)
+		return -ENOMEM;
+
+	kref_init(&file->usage->ref);
+
+	return 0;
+}
+
+static const char * const tegra_drm_engine_names[TEGRA_DRM_NUM_ENGINES] = {
+	[TEGRA_DRM_ENGINE_GR2D] = "gr2d",
+	[TEGRA_DRM_ENGINE_GR3D] = "gr3d",
+	[TEGRA_DRM_ENGINE_VIC] = "vic",
+	[TEGRA_DRM_ENGINE_NVDEC] = "nvdec",
+	[TEGRA_DRM_ENGINE_NVENC] = "nvenc",
+	[TEGRA_DRM_ENGINE_NVJPG] = "nvjpg",
+	[TEGRA_DRM_ENGINE_OFA] = "ofa",
+};
+
+/*
+ * Print the drm-engine-<engine> busy time of the file for every engine
+ * type present, see Documentation/gpu/drm-usage-stats.rst. Instances of
+ * the same engine type are reported together, with their number as the
+ * engine capacity. The number of jobs submitted to each engine type is
+ * reported in the driver specific tegra-jobs-<engine> key.
+ */
+void tegra_drm_uapi_show_fdinfo(struct tegra_drm *tegra, struct tegra_drm_file *file,
+				struct drm_printer *p)
+{
+	unsigned int capacity[TEGRA_DRM_NUM_ENGINES] = { 0 };
+	struct tegra_drm_file_usage *usage = file->usage;
+	struct tegra_drm_client *client;
+	unsigned int i;
+
+	mutex_lock(&tegra->clients_lock);
+
+	list_for_each_entry(client, &tegra->clients, list)
+		capacity[client->engine]++;
+
+	mutex_unlock(&tegra->clients_lock);
+
+	for (i = TEGRA_DRM_ENGINE_NONE + 1; i < TEGRA_DRM_NUM_ENGINES; i++) {
+		if (!capacity[i])
+			continue;
+
+		drm_printf(p, "drm-engine-%s:\t%llu ns\n", tegra_drm_engine_names[i],
+			   (u64)atomic64_read(&usage->engines[i].busy_ns));
+
+		if (capacity[i] > 1)
+			drm_printf(p, "drm-engine-capacity-%s:\t%u\n",
+				   tegra_drm_engine_names[i], capacity[i]);
+
+		drm_printf(p, "tegra-jobs-%s:\t%llu\n", tegra_drm_engine_names[i],
+			   (u64)atomic64_read(&usage->engines[i].jobs));
+	}
+}
+
 void tegra_drm_uapi_close_file(struct tegra_drm_file *file)
 {
 	struct tegra_drm_context *context;
@@ -60,6 +428,8 @@ void tegra_drm_uapi_close_file(struct tegra_drm_file *file)
 
 	xa_destroy(&file->contexts);
 	xa_destroy(&file->syncpoints);
+
+	tegra_drm_file_usage_put(file->usage);
 }
 
 static struct tegra_drm_client *tegra_drm_find_client(struct tegra_drm *tegra, u32 class)
@@ -80,12 +450,20 @@ int tegra_drm_ioctl_channel_open(struct drm_device *drm, void *data, struct drm_
 	struct tegra_drm *tegra = drm->dev_private;
 	struct drm_tegra_channel_open *args = data;
 	struct tegra_drm_client *client = NULL;
+	unsigned int weight = TEGRA_DRM_SCHED_WEIGHT_DEFAULT;
 	struct tegra_drm_context *context;
 	int err;
 
-	if (args->flags)
+	if (args->flags & ~DRM_TEGRA_CHANNEL_OPEN_WEIGHT)
 		return -EINVAL;
 
+	if (args->flags & DRM_TEGRA_CHANNEL_OPEN_WEIGHT) {
+		if (!args->weight || args->weight > TEGRA_DRM_SCHED_WEIGHT_MAX)
+			return -EINVAL;
+
+		weight = args->weight;
+	}
+
 	context = kzalloc(sizeof(*context), GFP_KERNEL);
 	if (!context)
 		return -ENOMEM;
@@ -132,13 +510,21 @@ int tegra_drm_ioctl_channel_open(struct drm_device *drm, void *data, struct drm_
 		}
 	}
 
+	context->sched_entity = tegra_drm_sched_entity_create(&client->sched, weight);
+	if (!context->sched_entity) {
+		err = -ENOMEM;
+		goto put_memctx;
+	}
+
 	err = xa_alloc(&fpriv->contexts, &args->context, context, XA_LIMIT(1, U32_MAX),
 		       GFP_KERNEL);
 	if (err < 0)
-		goto put_memctx;
+		goto put_entity;
 
 	context->client = client;
 	xa_init_flags(&context->mappings, XA_FLAGS_ALLOC1);
+	xa_init_flags(&context->jobs, XA_FLAGS_ALLOC1);
+	tegra_drm_mapping_cache_open(context);
 
 	args->version = client->version;
 	args->capabilities = 0;
@@ -148,6 +534,8 @@ int tegra_drm_ioctl_channel_open(struct drm_device *drm, void *data, struct drm_
 
 	return 0;
 
+put_entity:
+	tegra_drm_sched_entity_put(context->sched_entity);
 put_memctx:
 	if (context->memory_context)
 		host1x_memory_context_put(context->memory_context);
@@ -186,7 +574,7 @@ int tegra_drm_ioctl_channel_map(struct drm_device *drm, void *data, struct drm_f
 {
 	struct tegra_drm_file *fpriv = file->driver_priv;
 	struct drm_tegra_channel_map *args = data;
-	struct tegra_drm_mapping *mapping;
+	struct tegra_drm_mapping *mapping, *cached;
 	struct tegra_drm_context *context;
 	enum dma_data_direction direction;
 	int err = 0;
@@ -234,6 +622,24 @@ int tegra_drm_ioctl_channel_map(struct drm_device *drm, void *data, struct drm_f
 		goto put_gem;
 	}
 
+	/* Reuse the mapping if this buffer was recently unmapped. */
+	cached = tegra_drm_mapping_cache_lookup(context, mapping->bo, direction);
+	if (cached) {
+		host1x_bo_put(mapping->bo);
+		kfree(mapping);
+		mapping = cached;
+
+		err = xa_alloc(&context->mappings, &args->mapping, mapping,
+			       XA_LIMIT(1, U32_MAX), GFP_KERNEL);
+		if (err < 0)
+			tegra_drm_mapping_put(mapping);
+		else
+			args->iova = mapping->iova;
+
+		mutex_unlock(&fpriv->lock);
+		return err;
+	}
+
 	mapping->map = host1x_bo_pin(tegra_drm_context_get_memory_device(context),
 				     mapping->bo, direction, NULL);
 	if (IS_ERR(mapping->map)) {
@@ -249,6 +655,8 @@ int tegra_drm_ioctl_channel_map(struct drm_device *drm, void *data, struct drm_f
 	if (err < 0)
 		goto unpin;
 
+	args->iova = mapping->iova;
+
 	mutex_unlock(&fpriv->lock);
 
 	return 0;
@@ -280,13 +688,14 @@ int tegra_drm_ioctl_channel_unmap(struct drm_device *drm, void *data, struct drm
 	}
 
 	mapping = xa_erase(&context->mappings, args->mapping);
+	if (mapping)
+		tegra_drm_mapping_cache_add(context, mapping);
 
 	mutex_unlock(&fpriv->lock);
 
 	if (!mapping)
 		return -EINVAL;
 
-	tegra_drm_mapping_put(mapping);
 	return 0;
 }
 
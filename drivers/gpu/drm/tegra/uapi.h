@@ -4,6 +4,7 @@
 #ifndef _TEGRA_DRM_UAPI_H
 #define _TEGRA_DRM_UAPI_H
 
+#include <linux/atomic.h>
 #include <linux/dma-mapping.h>
 #include <linux/idr.h>
 #include <linux/kref.h>
@@ -11,8 +12,27 @@
 
 #include <drm/drm.h>
 
+#include "drm.h"
+
 struct drm_file;
 struct drm_device;
+struct drm_printer;
+struct tegra_drm;
+struct tegra_drm_persistent_job;
+
+/*
+ * Engine usage of the channel jobs submitted through a file, reported in
+ * its fdinfo. Jobs in flight hold a reference, so that their busy time is
+ * still accounted once they complete after the file has been closed.
+ */
+struct tegra_drm_file_usage {
+	struct kref ref;
+
+	struct {
+		atomic64_t busy_ns;
+		atomic64_t jobs;
+	} engines[TEGRA_DRM_NUM_ENGINES];
+};
 
 struct tegra_drm_file {
 	/* Legacy UAPI state */
@@ -22,6 +42,7 @@ struct tegra_drm_file {
 	/* New UAPI state */
 	struct xarray contexts;
 	struct xarray syncpoints;
+	struct tegra_drm_file_usage *usage;
 };
 
 struct tegra_drm_mapping {
@@ -32,6 +53,9 @@ struct tegra_drm_mapping {
 
 	dma_addr_t iova;
 	dma_addr_t iova_end;
+
+	/* Entry in the context's cache of unmapped mappings */
+	struct list_head cache_entry;
 };
 
 int tegra_drm_ioctl_channel_open(struct drm_device *drm, void *data,
@@ -44,6 +68,12 @@ int tegra_drm_ioctl_channel_unmap(struct drm_device *drm, void *data,
 				  struct drm_file *file);
 int tegra_drm_ioctl_channel_submit(struct drm_device *drm, void *data,
 				   struct drm_file *file);
+int tegra_drm_ioctl_channel_job_create(struct drm_device *drm, void *data,
+				       struct drm_file *file);
+int tegra_drm_ioctl_channel_job_submit(struct drm_device *drm, void *data,
+				       struct drm_file *file);
+int tegra_drm_ioctl_channel_job_destroy(struct drm_device *drm, void *data,
+					struct drm_file *file);
 int tegra_drm_ioctl_syncpoint_allocate(struct drm_device *drm, void *data,
 				       struct drm_file *file);
 int tegra_drm_ioctl_syncpoint_free(struct drm_device *drm, void *data,
@@ -51,7 +81,15 @@ int tegra_drm_ioctl_syncpoint_free(struct drm_device *drm, void *data,
 int tegra_drm_ioctl_syncpoint_wait(struct drm_device *drm, void *data,
 				   struct drm_file *file);
 
+int tegra_drm_uapi_open_file(struct tegra_drm_file *file);
 void tegra_drm_uapi_close_file(struct tegra_drm_file *file);
+void tegra_drm_uapi_show_fdinfo(struct tegra_drm *tegra, struct tegra_drm_file *file,
+				struct drm_printer *p);
+struct tegra_drm_file_usage *tegra_drm_file_usage_get(struct tegra_drm_file_usage *usage);
+void tegra_drm_file_usage_put(struct tegra_drm_file_usage *usage);
+int tegra_drm_mapping_cache_init(struct tegra_drm *tegra);
+void tegra_drm_mapping_cache_fini(struct tegra_drm *tegra);
 void tegra_drm_mapping_put(struct tegra_drm_mapping *mapping);
+void tegra_drm_persistent_job_put(struct tegra_drm_persistent_job *job);
 
 #endif
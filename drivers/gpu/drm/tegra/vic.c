@@ -6,8 +6,6 @@
 #include <linux/bitops.h>
 #include <linux/clk.h>
 #include <linux/delay.h>
-#include <linux/devfreq.h>
-#include <linux/devfreq/tegra_wmark.h>
 #include <linux/dma-mapping.h>
 #include <linux/host1x-next.h>
 #include <linux/interconnect.h>
@@ -17,7 +15,6 @@
 #include <linux/of_device.h>
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
-#include <linux/pm_opp.h>
 #include <linux/pm_runtime.h>
 #include <linux/reset.h>
 #include <linux/version.h>
@@ -25,6 +22,7 @@
 #include <soc/tegra/pmc.h>
 
 #include "drm.h"
+#include "dvfs.h"
 #include "falcon.h"
 #include "util.h"
 #include "vic.h"
@@ -47,8 +45,7 @@ struct vic {
 	struct device *dev;
 	struct clk *clk;
 	struct reset_control *rst;
-	struct devfreq *devfreq;
-	struct devfreq_dev_profile *devfreq_profile;
+	struct tegra_drm_dvfs dvfs;
 	struct icc_path *icc_write;
 
 	bool can_use_context;
@@ -112,8 +109,9 @@ static int vic_boot(struct vic *vic)
 	return 0;
 }
 
-static int vic_set_rate(struct vic *vic, unsigned long rate)
+static int vic_set_rate(struct device *dev, unsigned long rate)
 {
+	struct vic *vic = dev_get_drvdata(dev);
 	unsigned long dev_rate;
 	u32 emc_kbps;
 	int err;
@@ -137,116 +135,6 @@ static int vic_set_rate(struct vic *vic, unsigned long rate)
 	return 0;
 }
 
-static void vic_devfreq_update_wmark_threshold(struct devfreq *devfreq,
-					       struct devfreq_tegra_wmark_config *cfg)
-{
-	struct vic *vic = dev_get_drvdata(devfreq->dev.parent);
-	struct host1x_client *client = &vic->client.base;
-
-	host1x_actmon_update_active_wmark(client,
-					  cfg->avg_upper_wmark,
-					  cfg->avg_lower_wmark,
-					  cfg->consec_upper_wmark,
-					  cfg->consec_lower_wmark,
-					  cfg->upper_wmark_enabled,
-					  cfg->lower_wmark_enabled);
-}
-
-static int vic_devfreq_target(struct device *dev, unsigned long *freq, u32 flags)
-{
-	struct vic *vic = dev_get_drvdata(dev);
-	int err;
-
-	err = vic_set_rate(vic, *freq);
-	if (err < 0) {
-		dev_err(dev, "failed to set clock rate\n");
-		return err;
-	}
-
-	*freq = clk_get_rate(vic->clk);
-
-	return 0;
-}
-
-static int vic_devfreq_get_dev_status(struct device *dev, struct devfreq_dev_status *stat)
-{
-	struct vic *vic = dev_get_drvdata(dev);
-	struct host1x_client *client = &vic->client.base;
-	unsigned long usage;
-
-	/* Update load information */
-	host1x_actmon_read_active_norm(client, &usage);
-	stat->total_time = 1;
-	stat->busy_time = usage;
-
-	/* Update device frequency */
-	stat->current_frequency = clk_get_rate(vic->clk);
-
-	return 0;
-}
-
-static int vic_devfreq_get_cur_freq(struct device *dev, unsigned long *freq)
-{
-	struct vic *vic = dev_get_drvdata(dev);
-
-	*freq = clk_get_rate(vic->clk);
-
-	return 0;
-}
-
-static int vic_devfreq_init(struct vic *vic)
-{
-	unsigned long max_rate = clk_round_rate(vic->clk, ULONG_MAX);
-	unsigned long min_rate = clk_round_rate(vic->clk, 0);
-	unsigned long margin = clk_round_rate(vic->clk, min_rate + 1) - min_rate;
-	unsigned long rate = min_rate;
-	struct devfreq_tegra_wmark_data *data;
-	struct devfreq_dev_profile *devfreq_profile;
-	struct devfreq *devfreq;
-
-	while (rate <= max_rate) {
-		dev_pm_opp_add(vic->dev, rate, 0);
-		rate += margin;
-	}
-
-	data = devm_kzalloc(vic->dev, sizeof(*data), GFP_KERNEL);
-	if (!data)
-		return -ENOMEM;
-
-	data->event = DEVFREQ_TEGRA_AVG_WMARK_BELOW;
-	data->update_wmark_threshold = vic_devfreq_update_wmark_threshold;
-
-	devfreq_profile = devm_kzalloc(vic->dev, sizeof(*devfreq_profile), GFP_KERNEL);
-	if (!devfreq_profile)
-		return -ENOMEM;
-
-	devfreq_profile->target = vic_devfreq_target;
-	devfreq_profile->get_dev_status = vic_devfreq_get_dev_status;
-	devfreq_profile->get_cur_freq = vic_devfreq_get_cur_freq;
-	devfreq_profile->initial_freq = max_rate;
-	devfreq_profile->polling_ms = 100;
-
-	devfreq = devm_devfreq_add_device(vic->dev,
-					  devfreq_profile,
-					  DEVFREQ_GOV_USERSPACE,
-					  data);
-	if (IS_ERR(devfreq))
-		return PTR_ERR(devfreq);
-
-	vic->devfreq = devfreq;
-
-	return 0;
-}
-
-static void vic_devfreq_deinit(struct vic *vic)
-{
-	if (!vic->devfreq)
-		return;
-
-	devm_devfreq_remove_device(vic->dev, vic->devfreq);
-	vic->devfreq = NULL;
-}
-
 static int vic_init(struct host1x_client *client)
 {
 	struct tegra_drm_client *drm = host1x_to_drm_client(client);
@@ -347,34 +235,8 @@ static void vic_actmon_event(struct host1x_client *client,
 {
 	struct platform_device *pdev = to_platform_device(client->dev);
 	struct vic *vic = platform_get_drvdata(pdev);
-	struct devfreq *df = vic->devfreq;
-	struct devfreq_tegra_wmark_data *data;
-
-	if (!df)
-		return;
-
-	data = df->data;
-
-	switch (event) {
-	case HOST1X_ACTMON_AVG_WMARK_BELOW:
-		data->event = DEVFREQ_TEGRA_AVG_WMARK_BELOW;
-		break;
-	case HOST1X_ACTMON_AVG_WMARK_ABOVE:
-		data->event = DEVFREQ_TEGRA_AVG_WMARK_ABOVE;
-		break;
-	case HOST1X_ACTMON_CONSEC_WMARK_BELOW:
-		data->event = DEVFREQ_TEGRA_CONSEC_WMARK_BELOW;
-		break;
-	case HOST1X_ACTMON_CONSEC_WMARK_ABOVE:
-		data->event = DEVFREQ_TEGRA_CONSEC_WMARK_ABOVE;
-		break;
-	default:
-		return;
-	}
 
-	mutex_lock(&df->lock);
-	update_devfreq(df);
-	mutex_unlock(&df->lock);
+	tegra_drm_dvfs_actmon_event(&vic->dvfs, event);
 }
 
 static const struct host1x_client_ops vic_client_ops = {
@@ -529,15 +391,13 @@ static int __maybe_unused vic_runtime_resume(struct device *dev)
 	if (err < 0)
 		goto assert;
 
-	/* Forcely set frequency as Fmax when device is resumed back */
-	vic->devfreq->resume_freq = vic->devfreq->scaling_max_freq;
-	err = devfreq_resume_device(vic->devfreq);
+	err = tegra_drm_dvfs_resume(&vic->dvfs);
 	if (err < 0)
 		goto assert;
 
 	vic_actmon_reg_init(vic);
 
-	vic_count_weight_init(vic, vic->devfreq->scaling_max_freq);
+	vic_count_weight_init(vic, vic->dvfs.devfreq->scaling_max_freq);
 
 	host1x_actmon_enable(&vic->client.base);
 
@@ -555,7 +415,7 @@ static int __maybe_unused vic_runtime_suspend(struct device *dev)
 	struct vic *vic = dev_get_drvdata(dev);
 	int err;
 
-	err = devfreq_suspend_device(vic->devfreq);
+	err = tegra_drm_dvfs_suspend(&vic->dvfs);
 	if (err < 0)
 		return err;
 
@@ -582,7 +442,7 @@ static int __maybe_unused vic_runtime_suspend(struct device *dev)
 	return 0;
 
 devfreq_resume:
-	devfreq_resume_device(vic->devfreq);
+	tegra_drm_dvfs_resume(&vic->dvfs);
 	return err;
 }
 
@@ -755,6 +615,8 @@ static int vic_probe(struct platform_device *pdev)
 	INIT_LIST_HEAD(&vic->client.list);
 	vic->client.version = vic->config->version;
 	vic->client.ops = &vic_ops;
+	vic->client.engine = TEGRA_DRM_ENGINE_VIC;
+	vic->client.dvfs = &vic->dvfs;
 
 	err = host1x_client_register(&vic->client.base);
 	if (err < 0) {
@@ -773,7 +635,13 @@ static int vic_probe(struct platform_device *pdev)
 		goto exit_actmon;
 	}
 
-	err = vic_devfreq_init(vic);
+	vic->dvfs.dev = dev;
+	vic->dvfs.client = &vic->client.base;
+	vic->dvfs.clk = vic->clk;
+	vic->dvfs.set_rate = vic_set_rate;
+	vic->dvfs.total_time = 1;
+
+	err = tegra_drm_dvfs_init(&vic->dvfs);
 	if (err < 0) {
 		dev_err(&pdev->dev, "failed to init devfreq: %d\n", err);
 		goto exit_actmon;
@@ -809,7 +677,7 @@ static int vic_remove(struct platform_device *pdev)
 	tegra_drm_hwpm_unregister(&vic->hwpm, pdev->resource[0].start,
 		TEGRA_DRM_HWPM_IP_VIC);
 
-	vic_devfreq_deinit(vic);
+	tegra_drm_dvfs_exit(&vic->dvfs);
 
 	host1x_actmon_unregister(&vic->client.base);
 
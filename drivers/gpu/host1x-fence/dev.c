@@ -12,6 +12,7 @@
 #include <linux/file.h>
 #include <linux/fs.h>
 #include <linux/host1x-next.h>
+#include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_platform.h>
@@ -19,6 +20,7 @@
 #include <linux/poll.h>
 #include <linux/slab.h>
 #include <linux/sync_file.h>
+#include <linux/vmalloc.h>
 
 #include "include/uapi/linux/host1x-fence.h"
 
@@ -388,6 +390,276 @@ put_file:
 	return err;
 }
 
+struct host1x_multi_pollfd;
+
+struct host1x_multi_pollfd_slot {
+	struct host1x_multi_pollfd *pollfd;
+	unsigned int index;
+
+	struct dma_fence *fence;
+	struct dma_fence_cb callback;
+	bool callback_set;
+};
+
+struct host1x_multi_pollfd {
+	struct mutex lock;
+	wait_queue_head_t wq;
+
+	/* Completion bitmap shared with userspace */
+	unsigned long *bitmap;
+	size_t bitmap_size;
+
+	unsigned int num_slots;
+	struct host1x_multi_pollfd_slot slots[];
+};
+
+static void host1x_multi_pollfd_slot_disarm(struct host1x_multi_pollfd_slot *slot)
+{
+	if (!slot->fence)
+		return;
+
+	if (slot->callback_set &&
+	    dma_fence_remove_callback(slot->fence, &slot->callback))
+		host1x_fence_cancel(slot->fence);
+
+	dma_fence_put(slot->fence);
+	slot->fence = NULL;
+	slot->callback_set = false;
+}
+
+static int host1x_multi_pollfd_release(struct inode *inode, struct file *file)
+{
+	struct host1x_multi_pollfd *pollfd = file->private_data;
+	unsigned int i;
+
+	for (i = 0; i < pollfd->num_slots; i++)
+		host1x_multi_pollfd_slot_disarm(&pollfd->slots[i]);
+
+	vfree(pollfd->bitmap);
+	mutex_destroy(&pollfd->lock);
+	kfree(pollfd);
+
+	return 0;
+}
+
+static unsigned int host1x_multi_pollfd_poll(struct file *file, poll_table *wait)
+{
+	struct host1x_multi_pollfd *pollfd = file->private_data;
+	unsigned int i, words = pollfd->bitmap_size / sizeof(u64);
+	u64 *bitmap = (u64 *)pollfd->bitmap;
+
+	poll_wait(file, &pollfd->wq, wait);
+
+	/* Userspace may have cleared bits, so check the whole bitmap */
+	for (i = 0; i < words; i++)
+		if (READ_ONCE(bitmap[i]))
+			return POLLPRI | POLLIN;
+
+	return 0;
+}
+
+static int host1x_multi_pollfd_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct host1x_multi_pollfd *pollfd = file->private_data;
+
+	if (vma->vm_pgoff || vma->vm_end - vma->vm_start > PAGE_ALIGN(pollfd->bitmap_size))
+		return -EINVAL;
+
+	return remap_vmalloc_range(vma, pollfd->bitmap, 0);
+}
+
+static const struct file_operations host1x_multi_pollfd_ops = {
+	.release = host1x_multi_pollfd_release,
+	.poll = host1x_multi_pollfd_poll,
+	.mmap = host1x_multi_pollfd_mmap,
+};
+
+static int dev_file_ioctl_create_multi_pollfd(struct host1x *host1x, void __user *data)
+{
+	struct host1x_create_multi_pollfd args;
+	struct host1x_multi_pollfd *pollfd;
+	unsigned long copy_err;
+	struct file *file;
+	unsigned int i;
+	int fd, err;
+
+	copy_err = copy_from_user(&args, data, sizeof(args));
+	if (copy_err)
+		return -EFAULT;
+
+	if (args.reserved[0] || args.reserved[1])
+		return -EINVAL;
+
+	if (!args.num_slots || args.num_slots > HOST1X_POLLFD_MAX_SLOTS)
+		return -EINVAL;
+
+	pollfd = kzalloc(struct_size(pollfd, slots, args.num_slots), GFP_KERNEL);
+	if (!pollfd)
+		return -ENOMEM;
+
+	pollfd->bitmap_size = DIV_ROUND_UP(args.num_slots, 64) * sizeof(u64);
+	pollfd->bitmap = vmalloc_user(PAGE_ALIGN(pollfd->bitmap_size));
+	if (!pollfd->bitmap) {
+		err = -ENOMEM;
+		goto free_pollfd;
+	}
+
+	init_waitqueue_head(&pollfd->wq);
+	mutex_init(&pollfd->lock);
+	pollfd->num_slots = args.num_slots;
+
+	for (i = 0; i < args.num_slots; i++) {
+		pollfd->slots[i].pollfd = pollfd;
+		pollfd->slots[i].index = i;
+	}
+
+	file = anon_inode_getfile("host1x_multi_pollfd", &host1x_multi_pollfd_ops, pollfd,
+				  O_RDWR);
+	if (IS_ERR(file)) {
+		err = PTR_ERR(file);
+		goto free_bitmap;
+	}
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		/* The release callback frees the pollfd */
+		fput(file);
+		return fd;
+	}
+
+	args.fd = fd;
+
+	copy_err = copy_to_user(data, &args, sizeof(args));
+	if (copy_err) {
+		put_unused_fd(fd);
+		fput(file);
+		return -EFAULT;
+	}
+
+	fd_install(fd, file);
+
+	return 0;
+
+free_bitmap:
+	vfree(pollfd->bitmap);
+free_pollfd:
+	kfree(pollfd);
+
+	return err;
+}
+
+static void host1x_multi_pollfd_callback(struct dma_fence *fence, struct dma_fence_cb *cb)
+{
+	struct host1x_multi_pollfd_slot *slot =
+		container_of(cb, struct host1x_multi_pollfd_slot, callback);
+	struct host1x_multi_pollfd *pollfd = slot->pollfd;
+
+	set_bit(slot->index, pollfd->bitmap);
+	wake_up_all(&pollfd->wq);
+}
+
+static int host1x_multi_pollfd_arm(struct host1x *host1x, struct host1x_multi_pollfd *pollfd,
+				   const struct host1x_multi_pollfd_wait *wait)
+{
+	struct host1x_multi_pollfd_slot *slot;
+	struct host1x_syncpt *syncpt;
+	struct dma_fence *fence;
+	int err;
+
+	if (wait->reserved || wait->slot >= pollfd->num_slots)
+		return -EINVAL;
+
+	slot = &pollfd->slots[wait->slot];
+
+	syncpt = host1x_syncpt_get_by_id_noref(host1x, wait->id);
+	if (!syncpt)
+		return -EINVAL;
+
+	if (slot->fence) {
+		if (!dma_fence_is_signaled(slot->fence))
+			return -EBUSY;
+
+		dma_fence_put(slot->fence);
+		slot->fence = NULL;
+		slot->callback_set = false;
+	}
+
+	fence = host1x_fence_create(syncpt, wait->threshold, false);
+	if (IS_ERR(fence))
+		return PTR_ERR(fence);
+
+	clear_bit(slot->index, pollfd->bitmap);
+	slot->fence = fence;
+
+	err = dma_fence_add_callback(fence, &slot->callback, host1x_multi_pollfd_callback);
+	if (err == -ENOENT) {
+		/* Already reached */
+		set_bit(slot->index, pollfd->bitmap);
+		wake_up_all(&pollfd->wq);
+	} else if (err) {
+		dma_fence_put(fence);
+		slot->fence = NULL;
+		return err;
+	} else {
+		slot->callback_set = true;
+	}
+
+	return 0;
+}
+
+static int dev_file_ioctl_arm_multi_pollfd(struct host1x *host1x, void __user *data)
+{
+	struct host1x_multi_pollfd_wait __user *waits_user_ptr;
+	struct host1x_arm_multi_pollfd args;
+	struct host1x_multi_pollfd_wait wait;
+	struct host1x_multi_pollfd *pollfd;
+	unsigned long copy_err;
+	struct file *file;
+	unsigned int i;
+	int err = 0;
+
+	copy_err = copy_from_user(&args, data, sizeof(args));
+	if (copy_err)
+		return -EFAULT;
+
+	if (args.reserved[0] || args.reserved[1])
+		return -EINVAL;
+
+	waits_user_ptr = u64_to_user_ptr(args.waits_ptr);
+
+	file = fget(args.fd);
+	if (!file)
+		return -EINVAL;
+
+	if (file->f_op != &host1x_multi_pollfd_ops) {
+		err = -EINVAL;
+		goto put_file;
+	}
+
+	pollfd = file->private_data;
+
+	mutex_lock(&pollfd->lock);
+
+	for (i = 0; i < args.num_waits; i++) {
+		copy_err = copy_from_user(&wait, waits_user_ptr + i, sizeof(wait));
+		if (copy_err) {
+			err = -EFAULT;
+			break;
+		}
+
+		err = host1x_multi_pollfd_arm(host1x, pollfd, &wait);
+		if (err)
+			break;
+	}
+
+	mutex_unlock(&pollfd->lock);
+
+put_file:
+	fput(file);
+
+	return err;
+}
+
 static long dev_file_ioctl(struct file *file, unsigned int cmd,
 			   unsigned long arg)
 {
@@ -411,6 +683,14 @@ static long dev_file_ioctl(struct file *file, unsigned int cmd,
 		err = dev_file_ioctl_fence_extract(file->private_data, data);
 		break;
 
+	case HOST1X_IOCTL_CREATE_MULTI_POLLFD:
+		err = dev_file_ioctl_create_multi_pollfd(file->private_data, data);
+		break;
+
+	case HOST1X_IOCTL_ARM_MULTI_POLLFD:
+		err = dev_file_ioctl_arm_multi_pollfd(file->private_data, data);
+		break;
+
 	default:
 		err = -ENOTTY;
 	}
@@ -418,9 +698,49 @@ static long dev_file_ioctl(struct file *file, unsigned int cmd,
 	return err;
 }
 
+static int dev_file_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct host1x *host1x = file->private_data;
+	struct host1x_syncpt *syncpt;
+	phys_addr_t addr;
+	size_t size;
+	int err;
+
+	/* Writes to the shim increment the syncpoint */
+	if (vma->vm_flags & (VM_WRITE | VM_EXEC))
+		return -EPERM;
+
+	if (vma->vm_end - vma->vm_start != PAGE_SIZE || vma->vm_pgoff > U32_MAX)
+		return -EINVAL;
+
+	syncpt = host1x_syncpt_get_by_id_noref(host1x, vma->vm_pgoff);
+	if (!syncpt)
+		return -EINVAL;
+
+	err = host1x_syncpt_get_shim(syncpt, &addr, &size);
+	if (err)
+		return err;
+
+	/* A page must not expose the neighbouring syncpoints */
+	if (size < PAGE_SIZE)
+		return -ENODEV;
+
+#if defined(NV_VM_AREA_STRUCT_HAS_CONST_VM_FLAGS) /* Linux v6.3 */
+	vm_flags_clear(vma, VM_MAYWRITE | VM_MAYEXEC);
+#else
+	vma->vm_flags &= ~(VM_MAYWRITE | VM_MAYEXEC);
+#endif
+
+	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+
+	return io_remap_pfn_range(vma, vma->vm_start, PHYS_PFN(addr), PAGE_SIZE,
+				  vma->vm_page_prot);
+}
+
 static const struct file_operations dev_file_fops = {
 	.owner = THIS_MODULE,
 	.open = dev_file_open,
+	.mmap = dev_file_mmap,
 	.unlocked_ioctl = dev_file_ioctl,
 	.compat_ioctl = dev_file_ioctl,
 };
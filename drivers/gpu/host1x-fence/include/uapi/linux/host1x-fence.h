@@ -84,10 +84,85 @@ struct host1x_trigger_pollfd {
 	__u32 reserved;
 };
 
+/*
+ * Multi-threshold pollfd. Every slot of the pollfd can be armed with a
+ * (syncpoint, threshold) pair; once the threshold is reached, the kernel sets
+ * the slot's bit in the completion bitmap mapped with mmap() at offset 0.
+ * The bitmap is an array of __u64 words, slot n being bit (n % 64) of word
+ * (n / 64). poll() reports POLLIN while any bit is set.
+ *
+ * Userspace clears the bits of the slots it has consumed with an atomic
+ * and-not; arming a slot clears its bit too. A slot can only be re-armed
+ * once its previous threshold has been reached.
+ */
+#define HOST1X_POLLFD_MAX_SLOTS		4096
+
+struct host1x_create_multi_pollfd {
+	/**
+	 * @num_slots: [in]
+	 *
+	 * Number of slots, 1 to HOST1X_POLLFD_MAX_SLOTS.
+	 */
+	__u32 num_slots;
+
+	/**
+	 * @fd: [out]
+	 *
+	 * New pollfd file descriptor.
+	 */
+	__s32 fd;
+
+	__u32 reserved[2];
+};
+
+struct host1x_multi_pollfd_wait {
+	__u32 slot;
+	__u32 id;
+	__u32 threshold;
+	__u32 reserved;
+};
+
+struct host1x_arm_multi_pollfd {
+	/**
+	 * @fd: [in]
+	 *
+	 * Pollfd created with HOST1X_IOCTL_CREATE_MULTI_POLLFD.
+	 */
+	__s32 fd;
+
+	/**
+	 * @num_waits: [in]
+	 *
+	 * Number of elements in the `waits_ptr` array.
+	 */
+	__u32 num_waits;
+
+	/**
+	 * @waits_ptr: [in]
+	 *
+	 * Pointer to array of `struct host1x_multi_pollfd_wait`. The waits are
+	 * armed in order; on failure, the waits before the failing one stay
+	 * armed.
+	 */
+	__u64 waits_ptr;
+
+	__u32 reserved[2];
+};
+
+/*
+ * On Tegra194 and later, mmap() of one page at offset (id * page size) maps
+ * the syncpoint shim page of syncpoint id read-only. The first __u32 of the
+ * mapping is the current syncpoint value, so completion can be checked with
+ * a load instead of a syscall. mmap() fails with ENODEV where there is no
+ * shim or a shim page is smaller than the page size.
+ */
+
 #define HOST1X_IOCTL_CREATE_FENCE        _IOWR('X', 0x02, struct host1x_create_fence)
 #define HOST1X_IOCTL_FENCE_EXTRACT       _IOWR('X', 0x05, struct host1x_fence_extract)
 #define HOST1X_IOCTL_CREATE_POLLFD       _IOWR('X', 0x10, struct host1x_create_pollfd)
 #define HOST1X_IOCTL_TRIGGER_POLLFD      _IOWR('X', 0x11, struct host1x_trigger_pollfd)
+#define HOST1X_IOCTL_CREATE_MULTI_POLLFD _IOWR('X', 0x12, struct host1x_create_multi_pollfd)
+#define HOST1X_IOCTL_ARM_MULTI_POLLFD    _IOW('X', 0x13, struct host1x_arm_multi_pollfd)
 
 #if defined(__cplusplus)
 }
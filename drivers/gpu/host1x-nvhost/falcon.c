@@ -32,6 +32,17 @@ int falcon_wait_idle(struct falcon *falcon)
 static int falcon_dma_wait_idle(struct falcon *falcon)
 {
 	u32 value;
+	int err;
+
+	/*
+	 * A 256 byte chunk transfers in about a microsecond, so spin for a
+	 * little while before falling back to sleeping. Sleeping after every
+	 * chunk adds tens of milliseconds to each boot of the firmware.
+	 */
+	err = readl_poll_timeout_atomic(falcon->regs + FALCON_DMATRFCMD, value,
+					(value & FALCON_DMATRFCMD_IDLE), 1, 50);
+	if (!err)
+		return 0;
 
 	return readl_poll_timeout(falcon->regs + FALCON_DMATRFCMD, value,
 				  (value & FALCON_DMATRFCMD_IDLE), 10, 100000);
@@ -591,6 +591,28 @@ int host1x_cdma_begin(struct host1x_cdma *cdma, struct host1x_job *job)
 	return 0;
 }
 
+/*
+ * Reserve a number of two word slots in the push buffer for the current
+ * submit. Waiting for space and flushing happen here, once, instead of in the
+ * middle of the job, so pushes made within the reservation never block and
+ * the job is handed to hardware by the single flush in host1x_cdma_end().
+ * Reservations larger than the push buffer are clamped, in which case the
+ * remaining pushes wait for space as usual.
+ */
+void host1x_cdma_reserve(struct host1x_cdma *cdma, unsigned int slots)
+{
+	struct host1x *host1x = cdma_to_host1x(cdma);
+
+	/* An empty push buffer has one slot less than its size free. */
+	slots = min_t(unsigned int, slots, HOST1X_PUSHBUFFER_SLOTS - 1);
+
+	if (cdma->slots_free >= slots)
+		return;
+
+	host1x_cdma_wait_pushbuffer_space(host1x, cdma, slots);
+	cdma->slots_free = host1x_pushbuffer_space(&cdma->push_buffer);
+}
+
 /*
  * Push two words into a push buffer slot
  * Blocks as necessary if the push buffer is full.
@@ -644,8 +666,11 @@ void host1x_cdma_push_wide(struct host1x_cdma *cdma, u32 op1, u32 op2,
 		needed += extra;
 	}
 
-	host1x_cdma_wait_pushbuffer_space(host1x, cdma, needed);
-	space = host1x_pushbuffer_space(pb);
+	/* slots_free never exceeds the real space, so it is safe to use here */
+	if (space < needed) {
+		host1x_cdma_wait_pushbuffer_space(host1x, cdma, needed);
+		space = host1x_pushbuffer_space(pb);
+	}
 
 	cdma->slots_free = space - needed;
 	cdma->slots_used += needed;
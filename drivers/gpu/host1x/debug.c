@@ -78,7 +78,6 @@ static int show_channel(struct host1x_channel *ch, void *data, bool show_fifo)
 static void show_syncpts(struct host1x *m, struct output *o, bool show_all)
 {
 	unsigned long irqflags;
-	struct list_head *pos;
 	unsigned int i;
 	int err;
 
@@ -94,8 +93,7 @@ static void show_syncpts(struct host1x *m, struct output *o, bool show_all)
 		unsigned int waiters = 0;
 
 		spin_lock_irqsave(&m->syncpt[i].fences.lock, irqflags);
-		list_for_each(pos, &m->syncpt[i].fences.list)
-			waiters++;
+		waiters = m->syncpt[i].fences.count;
 		spin_unlock_irqrestore(&m->syncpt[i].fences.lock, irqflags);
 
 		if (!kref_read(&m->syncpt[i].ref))
@@ -252,6 +252,8 @@ static const struct host1x_info host1x07_info = {
 	.has_hypervisor = true,
 	.num_sid_entries = ARRAY_SIZE(tegra194_sid_table),
 	.sid_table = tegra194_sid_table,
+	.syncpt_shim_base = 0x60000000,
+	.syncpt_shim_stride = 0x1000,
 	.reserve_vblank_syncpts = false,
 };
 
@@ -501,6 +503,8 @@ static const struct host1x_info host1x08_info = {
 	.streamid_vm_table = { 0x1004, 128 },
 	.classid_vm_table = { 0x1404, 25 },
 	.mmio_vm_table = { 0x1504, 25 },
+	.syncpt_shim_base = 0x60000000,
+	.syncpt_shim_stride = 0x10000,
 	.reserve_vblank_syncpts = false,
 };
 
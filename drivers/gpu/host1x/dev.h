@@ -127,6 +127,8 @@ struct host1x_info {
 	struct host1x_table_desc streamid_vm_table;
 	struct host1x_table_desc classid_vm_table;
 	struct host1x_table_desc mmio_vm_table;
+	phys_addr_t syncpt_shim_base; /* read-only syncpoint shim aperture */
+	unsigned int syncpt_shim_stride; /* bytes between syncpoints in the shim */
 	/*
 	 * On T20-T148, the boot chain may setup DC to increment syncpoints
 	 * 26/27 on VBLANK. As such we cannot use these syncpoints until
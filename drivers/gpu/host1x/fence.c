@@ -147,6 +147,7 @@ struct dma_fence *host1x_fence_create(struct host1x_syncpt *sp, u32 threshold,
 		       dma_fence_context_alloc(1), 0);
 
 	INIT_DELAYED_WORK(&fence->timeout_work, do_fence_timeout);
+	RB_CLEAR_NODE(&fence->node);
 
 	return &fence->base;
 }
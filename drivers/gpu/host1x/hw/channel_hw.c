@@ -213,11 +213,43 @@ static void host1x_enable_gather_filter(struct host1x_channel *ch)
 #endif
 }
 
+/*
+ * Upper bound of push buffer slots channel_program_cdma() uses for a job: the
+ * fixed prologue and epilogue, per-command opcodes assuming wide gathers, and
+ * one padding slot in case a wide opcode straddles the end of the buffer.
+ */
+static unsigned int channel_job_slots(struct host1x_job *job)
+{
+	unsigned int slots = 16, i;
+
+	for (i = 0; i < job->num_cmds; i++) {
+		switch (job->cmds[i].type) {
+		case HOST1X_JOB_CMD_WAIT:
+			/* Wait followed by a setclass */
+			slots += 4;
+			break;
+
+		case HOST1X_JOB_CMD_GATHER:
+			slots += 2;
+			break;
+
+		case HOST1X_JOB_CMD_REG_WRITE:
+			slots += 1;
+			break;
+		}
+	}
+
+	return slots;
+}
+
 static void channel_program_cdma(struct host1x_job *job)
 {
 	struct host1x_cdma *cdma = &job->channel->cdma;
 	struct host1x_syncpt *sp = job->syncpt;
 
+	/* Wait for space once so the job is pushed without stalling midway. */
+	host1x_cdma_reserve(cdma, channel_job_slots(job));
+
 #if HOST1X_HW >= 6
 	u32 fence;
 	int i = 0;
@@ -244,6 +244,7 @@ struct host1x_syncpt *host1x_syncpt_alloc(struct host1x *host,
 
 struct host1x_syncpt_base *host1x_syncpt_get_base(struct host1x_syncpt *sp);
 u32 host1x_syncpt_base_id(struct host1x_syncpt_base *base);
+int host1x_syncpt_get_shim(struct host1x_syncpt *sp, phys_addr_t *addr, size_t *size);
 
 void host1x_syncpt_release_vblank_reservation(struct host1x_client *client,
 					      u32 syncpt_id);
@@ -370,6 +371,9 @@ struct host1x_job {
 	u32 engine_fallback_streamid;
 	/* Engine offset to program stream ID to */
 	u32 engine_streamid_offset;
+
+	/* Cache to pin gather buffers through; mappings outlive the job */
+	struct host1x_bo_cache *gather_cache;
 };
 
 struct host1x_job *host1x_job_alloc(struct host1x_channel *ch,
@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Tegra host1x syncpoint interrupt events
+ *
+ * Copyright (c) 2024, NVIDIA Corporation.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM host1x_intr
+
+#if !defined(_TRACE_HOST1X_INTR_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_HOST1X_INTR_H
+
+#include <linux/ktime.h>
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(host1x_intr_add_fence,
+	TP_PROTO(u32 id, u32 threshold, unsigned int pending, s64 insert_ns),
+
+	TP_ARGS(id, threshold, pending, insert_ns),
+
+	TP_STRUCT__entry(
+		__field(u32, id)
+		__field(u32, threshold)
+		__field(unsigned int, pending)
+		__field(s64, insert_ns)
+	),
+
+	TP_fast_assign(
+		__entry->id = id;
+		__entry->threshold = threshold;
+		__entry->pending = pending;
+		__entry->insert_ns = insert_ns;
+	),
+
+	TP_printk("id=%u threshold=%u pending=%u insert_ns=%lld",
+		  __entry->id, __entry->threshold, __entry->pending,
+		  __entry->insert_ns)
+);
+
+TRACE_EVENT(host1x_intr_signal_fence,
+	TP_PROTO(u32 id, u32 threshold, s64 wait_ns, s64 signal_ns),
+
+	TP_ARGS(id, threshold, wait_ns, signal_ns),
+
+	TP_STRUCT__entry(
+		__field(u32, id)
+		__field(u32, threshold)
+		__field(s64, wait_ns)
+		__field(s64, signal_ns)
+	),
+
+	TP_fast_assign(
+		__entry->id = id;
+		__entry->threshold = threshold;
+		__entry->wait_ns = wait_ns;
+		__entry->signal_ns = signal_ns;
+	),
+
+	TP_printk("id=%u threshold=%u wait_ns=%lld signal_ns=%lld",
+		  __entry->id, __entry->threshold, __entry->wait_ns,
+		  __entry->signal_ns)
+);
+
+#endif /* _TRACE_HOST1X_INTR_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
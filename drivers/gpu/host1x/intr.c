@@ -11,29 +11,59 @@
 #include "fence.h"
 #include "intr.h"
 
-static void host1x_intr_add_fence_to_list(struct host1x_fence_list *list,
+#define CREATE_TRACE_POINTS
+#include <trace/events/host1x_intr.h>
+
+/*
+ * Pending fences are kept in a tree ordered by threshold, so inserting a fence
+ * that is not the newest one stays O(log n) and the interrupt handler finds
+ * the next fence to expire in constant time. Thresholds are compared with
+ * wrap-around, which is consistent as long as all pending thresholds of a
+ * syncpoint are within 2^31 of each other.
+ */
+static void host1x_intr_add_fence_to_tree(struct host1x_fence_list *list,
 					  struct host1x_syncpt_fence *fence)
 {
-	struct host1x_syncpt_fence *fence_in_list;
-
-	list_for_each_entry_reverse(fence_in_list, &list->list, list) {
-		if ((s32)(fence_in_list->threshold - fence->threshold) <= 0) {
-			/* Fence in list is before us, we can insert here */
-			list_add(&fence->list, &fence_in_list->list);
-			return;
+	struct rb_node **link = &list->root.rb_root.rb_node;
+	struct rb_node *parent = NULL;
+	bool leftmost = true;
+
+	while (*link) {
+		struct host1x_syncpt_fence *fence_in_tree;
+
+		parent = *link;
+		fence_in_tree = rb_entry(parent, struct host1x_syncpt_fence, node);
+
+		if ((s32)(fence_in_tree->threshold - fence->threshold) <= 0) {
+			/* Fence in tree is before us, keep submission order for equal values */
+			link = &parent->rb_right;
+			leftmost = false;
+		} else {
+			link = &parent->rb_left;
 		}
 	}
 
-	/* Add as first in list */
-	list_add(&fence->list, &list->list);
+	rb_link_node(&fence->node, parent, link);
+	rb_insert_color_cached(&fence->node, &list->root, leftmost);
+	list->count++;
+}
+
+static void host1x_intr_remove_fence_from_tree(struct host1x_fence_list *list,
+					       struct host1x_syncpt_fence *fence)
+{
+	rb_erase_cached(&fence->node, &list->root);
+	RB_CLEAR_NODE(&fence->node);
+	list->count--;
 }
 
 static void host1x_intr_update_hw_state(struct host1x *host, struct host1x_syncpt *sp)
 {
 	struct host1x_syncpt_fence *fence;
+	struct rb_node *node;
 
-	if (!list_empty(&sp->fences.list)) {
-		fence = list_first_entry(&sp->fences.list, struct host1x_syncpt_fence, list);
+	node = rb_first_cached(&sp->fences.root);
+	if (node) {
+		fence = rb_entry(node, struct host1x_syncpt_fence, node);
 
 		host1x_hw_intr_set_syncpt_threshold(host, sp->id, fence->threshold);
 		host1x_hw_intr_enable_syncpt_intr(host, sp->id);
@@ -45,11 +75,20 @@ static void host1x_intr_update_hw_state(struct host1x *host, struct host1x_syncp
 void host1x_intr_add_fence_locked(struct host1x *host, struct host1x_syncpt_fence *fence)
 {
 	struct host1x_fence_list *fence_list = &fence->sp->fences;
+	ktime_t start = 0;
 
-	INIT_LIST_HEAD(&fence->list);
+	if (trace_host1x_intr_add_fence_enabled() ||
+	    trace_host1x_intr_signal_fence_enabled())
+		start = ktime_get();
 
-	host1x_intr_add_fence_to_list(fence_list, fence);
+	fence->wait_start = start;
+
+	host1x_intr_add_fence_to_tree(fence_list, fence);
 	host1x_intr_update_hw_state(host, fence->sp);
+
+	if (trace_host1x_intr_add_fence_enabled())
+		trace_host1x_intr_add_fence(fence->sp->id, fence->threshold, fence_list->count,
+					    ktime_to_ns(ktime_sub(ktime_get(), start)));
 }
 
 bool host1x_intr_remove_fence(struct host1x *host, struct host1x_syncpt_fence *fence)
@@ -59,12 +98,12 @@ bool host1x_intr_remove_fence(struct host1x *host, struct host1x_syncpt_fence *f
 
 	spin_lock_irqsave(&fence_list->lock, irqflags);
 
-	if (list_empty(&fence->list)) {
+	if (RB_EMPTY_NODE(&fence->node)) {
 		spin_unlock_irqrestore(&fence_list->lock, irqflags);
 		return false;
 	}
 
-	list_del_init(&fence->list);
+	host1x_intr_remove_fence_from_tree(fence_list, fence);
 	host1x_intr_update_hw_state(host, fence->sp);
 
 	spin_unlock_irqrestore(&fence_list->lock, irqflags);
@@ -75,20 +114,33 @@ bool host1x_intr_remove_fence(struct host1x *host, struct host1x_syncpt_fence *f
 void host1x_intr_handle_interrupt(struct host1x *host, unsigned int id, ktime_t ts)
 {
 	struct host1x_syncpt *sp = &host->syncpt[id];
-	struct host1x_syncpt_fence *fence, *tmp;
+	struct host1x_syncpt_fence *fence;
+	struct rb_node *node;
 	unsigned int value;
 
 	value = host1x_syncpt_load(sp);
 
+	/*
+	 * The lock is also the dma_fence lock of every fence on this syncpoint,
+	 * which signalling needs to hold, so it is taken once for the batch.
+	 */
 	spin_lock(&sp->fences.lock);
 
-	list_for_each_entry_safe(fence, tmp, &sp->fences.list, list) {
+	while ((node = rb_first_cached(&sp->fences.root))) {
+		fence = rb_entry(node, struct host1x_syncpt_fence, node);
+
 		if (((value - fence->threshold) & 0x80000000U) != 0U) {
 			/* Fence is not yet expired, we are done */
 			break;
 		}
 
-		list_del_init(&fence->list);
+		host1x_intr_remove_fence_from_tree(&sp->fences, fence);
+
+		if (trace_host1x_intr_signal_fence_enabled() && fence->wait_start)
+			trace_host1x_intr_signal_fence(id, fence->threshold,
+				ktime_to_ns(ktime_sub(ts, fence->wait_start)),
+				ktime_to_ns(ktime_sub(ktime_get(), ts)));
+
 		host1x_fence_signal(fence, ts);
 	}
 
@@ -108,7 +160,8 @@ int host1x_intr_init(struct host1x *host)
 		struct host1x_syncpt *syncpt = &host->syncpt[id];
 
 		spin_lock_init(&syncpt->fences.lock);
-		INIT_LIST_HEAD(&syncpt->fences.list);
+		syncpt->fences.root = RB_ROOT_CACHED;
+		syncpt->fences.count = 0;
 	}
 
 	return 0;
@@ -244,7 +244,7 @@ static unsigned int pin_job(struct host1x *host, struct host1x_job *job)
 			goto unpin;
 		}
 
-		map = host1x_bo_pin(host->dev, g->bo, DMA_TO_DEVICE, NULL);
+		map = host1x_bo_pin(host->dev, g->bo, DMA_TO_DEVICE, job->gather_cache);
 		if (IS_ERR(map)) {
 			err = PTR_ERR(map);
 			goto unpin;
@@ -572,6 +572,33 @@ u32 host1x_syncpt_base_id(struct host1x_syncpt_base *base)
 }
 EXPORT_SYMBOL(host1x_syncpt_base_id);
 
+/**
+ * host1x_syncpt_get_shim() - locate a syncpoint in the syncpoint shim
+ * @sp: host1x syncpoint
+ * @addr: physical address of the syncpoint's shim page
+ * @size: size of the syncpoint's shim page
+ *
+ * Reading the first word of the shim page returns the current value of the
+ * syncpoint, writing to it increments the syncpoint. Returns -ENODEV if the
+ * host1x has no shim or the syncpoint is not accessible to this VM.
+ */
+int host1x_syncpt_get_shim(struct host1x_syncpt *sp, phys_addr_t *addr, size_t *size)
+{
+	struct host1x *host = sp->host;
+
+	if (!host->info->syncpt_shim_base)
+		return -ENODEV;
+
+	if (sp->id < host->syncpt_base || sp->id >= host->syncpt_end)
+		return -ENODEV;
+
+	*addr = host->info->syncpt_shim_base + (phys_addr_t)sp->id * host->info->syncpt_shim_stride;
+	*size = host->info->syncpt_shim_stride;
+
+	return 0;
+}
+EXPORT_SYMBOL(host1x_syncpt_get_shim);
+
 static void do_nothing(struct kref *ref)
 {
 }
@@ -770,6 +770,7 @@ static struct i2c_driver lt6911uxc_i2c_driver = {
 		.name = "lt6911uxc",
 		.owner = THIS_MODULE,
 		.of_match_table = of_match_ptr(lt6911uxc_of_match),
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = lt6911uxc_probe,
 	.remove = lt6911uxc_remove,
@@ -1212,6 +1212,7 @@ static struct i2c_driver ar0234_i2c_driver = {
 		.name = "ar0234",
 		.owner = THIS_MODULE,
 		.of_match_table = of_match_ptr(ar0234_of_match),
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = ar0234_probe,
 	.remove = ar0234_remove,
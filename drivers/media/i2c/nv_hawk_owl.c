@@ -1464,12 +1464,7 @@ static int ar0234_hawk_owl_deser_ser_program(struct ar0234 *priv)
 	return err;
 }
 
-#if defined(NV_I2C_DRIVER_STRUCT_PROBE_WITHOUT_I2C_DEVICE_ID_ARG) /* Linux 6.3 */
-static int ar0234_probe(struct i2c_client *client)
-#else
-static int ar0234_probe(struct i2c_client *client,
-		const struct i2c_device_id *id)
-#endif
+static int ar0234_do_probe(struct i2c_client *client)
 {
 	struct device *dev = &client->dev;
 	struct device_node *node = dev->of_node;
@@ -1610,6 +1605,24 @@ un_register:
 	return err;
 }
 
+#if defined(NV_I2C_DRIVER_STRUCT_PROBE_WITHOUT_I2C_DEVICE_ID_ARG) /* Linux 6.3 */
+static int ar0234_probe(struct i2c_client *client)
+#else
+static int ar0234_probe(struct i2c_client *client,
+		const struct i2c_device_id *id)
+#endif
+{
+	struct tegracam_probe_group *group;
+	int err;
+
+	/* the sensors of a module reuse i2c addresses while probing */
+	group = tegracam_probe_group_lock(client);
+	err = ar0234_do_probe(client);
+	tegracam_probe_group_unlock(group);
+
+	return err;
+}
+
 #if defined(NV_I2C_DRIVER_STRUCT_REMOVE_RETURN_TYPE_INT) /* Linux 6.1 */
 static int ar0234_remove(struct i2c_client *client)
 #else
@@ -1643,6 +1656,7 @@ static struct i2c_driver ar0234_i2c_driver = {
 		.name = "ar0234",
 		.owner = THIS_MODULE,
 		.of_match_table = of_match_ptr(ar0234_of_match),
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = ar0234_probe,
 	.remove = ar0234_remove,
@@ -879,6 +879,7 @@ static struct i2c_driver imx185_i2c_driver = {
 		.name = "imx185",
 		.owner = THIS_MODULE,
 		.of_match_table = of_match_ptr(imx185_of_match),
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = imx185_probe,
 	.remove = imx185_remove,
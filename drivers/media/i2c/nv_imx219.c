@@ -794,6 +794,7 @@ static struct i2c_driver imx219_i2c_driver = {
 		.name = "imx219",
 		.owner = THIS_MODULE,
 		.of_match_table = of_match_ptr(imx219_of_match),
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = imx219_probe,
 	.remove = imx219_remove,
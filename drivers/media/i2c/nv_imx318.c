@@ -808,6 +808,7 @@ static struct i2c_driver imx318_i2c_driver = {
 		.name = "imx318",
 		.owner = THIS_MODULE,
 		.of_match_table = of_match_ptr(imx318_of_match),
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = imx318_probe,
 	.remove = imx318_remove,
@@ -165,7 +165,7 @@ static int imx390_write_table(struct imx390 *priv,
 					 IMX390_TABLE_END);
 }
 
-static struct mutex serdes_lock__;
+static DEFINE_MUTEX(serdes_lock__);
 
 static int imx390_gmsl_serdes_setup(struct imx390 *priv)
 {
@@ -754,12 +754,7 @@ error:
 	return err;
 }
 
-#if defined(NV_I2C_DRIVER_STRUCT_PROBE_WITHOUT_I2C_DEVICE_ID_ARG) /* Linux 6.3 */
-static int imx390_probe(struct i2c_client *client)
-#else
-static int imx390_probe(struct i2c_client *client,
-			const struct i2c_device_id *id)
-#endif
+static int imx390_do_probe(struct i2c_client *client)
 {
 	struct device *dev = &client->dev;
 	struct device_node *node = dev->of_node;
@@ -808,8 +803,6 @@ static int imx390_probe(struct i2c_client *client,
 		return err;
 	}
 
-	mutex_init(&serdes_lock__);
-
 	/* Pair sensor to serializer dev */
 	err = max9295_sdev_pair(priv->ser_dev, &priv->g_ctx);
 	if (err) {
@@ -856,6 +849,24 @@ static int imx390_probe(struct i2c_client *client,
 	return 0;
 }
 
+#if defined(NV_I2C_DRIVER_STRUCT_PROBE_WITHOUT_I2C_DEVICE_ID_ARG) /* Linux 6.3 */
+static int imx390_probe(struct i2c_client *client)
+#else
+static int imx390_probe(struct i2c_client *client,
+			const struct i2c_device_id *id)
+#endif
+{
+	struct tegracam_probe_group *group;
+	int err;
+
+	/* serdes setup of sensors sharing a deserializer must not interleave */
+	group = tegracam_probe_group_lock(client);
+	err = imx390_do_probe(client);
+	tegracam_probe_group_unlock(group);
+
+	return err;
+}
+
 #if defined(NV_I2C_DRIVER_STRUCT_REMOVE_RETURN_TYPE_INT) /* Linux 6.1 */
 static int imx390_remove(struct i2c_client *client)
 #else
@@ -876,7 +887,6 @@ static void imx390_remove(struct i2c_client *client)
 
 	imx390_gmsl_serdes_reset(priv);
 
-	mutex_destroy(&serdes_lock__);
 	tegracam_v4l2subdev_unregister(priv->tc_dev);
 	tegracam_device_unregister(priv->tc_dev);
 
@@ -897,6 +907,7 @@ static struct i2c_driver imx390_i2c_driver = {
 		.name = "imx390",
 		.owner = THIS_MODULE,
 		.of_match_table = of_match_ptr(imx390_of_match),
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = imx390_probe,
 	.remove = imx390_remove,
@@ -822,6 +822,7 @@ static struct i2c_driver imx477_i2c_driver = {
 		   .name = "imx477",
 		   .owner = THIS_MODULE,
 		   .of_match_table = of_match_ptr(imx477_of_match),
+		   .probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		   },
 	.probe = imx477_probe,
 	.remove = imx477_remove,
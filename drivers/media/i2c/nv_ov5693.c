@@ -1283,6 +1283,7 @@ static struct i2c_driver ov5693_i2c_driver = {
 		.name = "ov5693",
 		.owner = THIS_MODULE,
 		.of_match_table = of_match_ptr(ov5693_of_match),
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = ov5693_probe,
 	.remove = ov5693_remove,
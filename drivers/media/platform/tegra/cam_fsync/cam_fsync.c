@@ -16,6 +16,7 @@
 #include <linux/lcm.h>
 #include <linux/list.h>
 #include <linux/kernel.h>
+#include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_address.h>
@@ -106,6 +107,10 @@ struct cam_fsync_controller_features {
  *   @freq_hz: Frequency (hz) of the generator.
  *   @duty_cycle: Duty cycle (%) of the generator.
  *   @offset_ms: Offset (ms) to shift the signal by.
+ * @ticks:
+ *   @start: Absolute TSC tick of the first rising edge.
+ *   @period: TSC ticks in one period.
+ *   @active: TSC ticks the signal is high in one period.
  * @debugfs:
  *   @regset_ro: Debug FS read-only register set.
  * @list: List node
@@ -118,6 +123,11 @@ struct cam_fsync_generator {
 		u32 duty_cycle;
 		u32 offset_ms;
 	} config;
+	struct {
+		u64 start;
+		u32 period;
+		u32 active;
+	} ticks;
 	struct {
 		struct debugfs_regset32 regset_ro;
 	} debugfs;
@@ -131,6 +141,7 @@ struct cam_fsync_generator {
  * @features: Feature support for the group.
  * @abs_start_ticks: Start time in TSC ticks to start all generators in group
  * @active: Is group active
+ * @schedule: Page holding the edge schedule mapped by userspace
  * @generators: Linked list of child generators
  * @list: List node
  */
@@ -140,6 +151,7 @@ struct fsync_generator_group {
 	const struct cam_fsync_controller_features *features;
 	uint64_t abs_start_ticks;
 	bool active;
+	struct cam_fsync_group_schedule *schedule;
 	struct list_head generators;
 	struct list_head list;
 };
@@ -354,6 +366,9 @@ static int cam_fsync_program_group_generator_edges(struct fsync_generator_group
 		ticks_active = mult_frac(ticks_in_period, generator->config.duty_cycle, 100);
 		ticks_inactive = ticks_in_period - ticks_active;
 
+		generator->ticks.period = ticks_in_period;
+		generator->ticks.active = ticks_active;
+
 		cam_fsync_generator_writel(generator, TSC_GENX_EDGE0,
 			TSC_GENX_EDGEX_TOGGLE |
 			FIELD_PREP(TSC_GENX_EDGEX_OFFSET, ticks_active));
@@ -383,6 +398,8 @@ static void cam_fsync_program_group_generator_start_values(struct fsync_generato
 			abs_start_tsc_ticks += mult_frac(generator->config.offset_ms,
 				NS_PER_MS, TSC_NS_PER_TICK);
 
+		generator->ticks.start = abs_start_tsc_ticks;
+
 		cam_fsync_generator_writel(generator, TSC_GENX_START0,
 			FIELD_PREP(TSC_GENX_START0_LSB_VAL, lower_32_bits(abs_start_tsc_ticks)));
 
@@ -391,6 +408,43 @@ static void cam_fsync_program_group_generator_start_values(struct fsync_generato
 	}
 }
 
+/**
+ * @brief Publish the edge schedule of a group to its userspace mapping
+ *
+ * @param[in]	group	pointer to struct fsync_generator_group (non-null)
+ * @param[in]	running	whether the group generators are running
+ */
+static void cam_fsync_publish_group_schedule(struct fsync_generator_group *group,
+						bool running)
+{
+	struct cam_fsync_group_schedule *schedule = group->schedule;
+	struct cam_fsync_generator *generator;
+	u32 n = 0;
+
+	WRITE_ONCE(schedule->seq, schedule->seq + 1);
+	smp_wmb();
+
+	if (running) {
+		list_for_each_entry(generator, &group->generators, list) {
+			if (n == CAM_FSYNC_SCHEDULE_MAX_GENERATORS) {
+				dev_warn(group->dev,
+					"Group %u schedule limited to %u generators\n",
+					group->id, n);
+				break;
+			}
+			schedule->generators[n].start_ticks = generator->ticks.start;
+			schedule->generators[n].period_ticks = generator->ticks.period;
+			schedule->generators[n].active_ticks = generator->ticks.active;
+			n++;
+		}
+	}
+	schedule->num_generators = n;
+	schedule->tsc_hz = TSC_TICKS_PER_HZ;
+
+	smp_wmb();
+	WRITE_ONCE(schedule->seq, schedule->seq + 1);
+}
+
 /**
  * @brief Get current tsc ticks
  *
@@ -504,6 +558,7 @@ static int cam_fsync_start_group_generators(struct fsync_generator_group *group)
 			}
 	}
 	group->active = true;
+	cam_fsync_publish_group_schedule(group, true);
 
 	return 0;
 }
@@ -519,6 +574,8 @@ static int cam_fsync_stop_group_generators(struct fsync_generator_group *group)
 {
 	struct cam_fsync_generator *generator;
 
+	cam_fsync_publish_group_schedule(group, false);
+
 	list_for_each_entry(generator, &group->generators, list) {
 		cam_fsync_generator_writel(generator, TSC_GENX_CTRL, TSC_GENX_CTRL_RST);
 
@@ -700,9 +757,42 @@ static long cam_fsync_ioctl(struct file *file, unsigned int cmd, unsigned long s
 	return err;
 }
 
+/**
+ * @brief Map the group edge schedule
+ *
+ * Maps the single read-only page holding struct cam_fsync_group_schedule so
+ * userspace can derive generator edge timestamps without a syscall per frame.
+ *
+ * @param[in]	file	cam fsync group character device file struct (non-null)
+ * @param[in]	vma	user mapping of exactly one page at offset 0 (non-null)
+ *
+ * @returns	0 (success), neg. errno (failure)
+ */
+static int cam_fsync_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct fsync_generator_group *group = file->private_data;
+
+	if (vma->vm_pgoff != 0 || vma->vm_end - vma->vm_start != PAGE_SIZE)
+		return -EINVAL;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+#if defined(NV_VM_AREA_STRUCT_HAS_CONST_VM_FLAGS) /* Linux v6.3 */
+	vm_flags_clear(vma, VM_MAYWRITE);
+#else
+	vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+
+	return remap_pfn_range(vma, vma->vm_start,
+			page_to_pfn(virt_to_page(group->schedule)),
+			PAGE_SIZE, vma->vm_page_prot);
+}
+
 static const struct file_operations cam_fsync_fileops = {
 	.owner = THIS_MODULE,
 	.open = cam_fsync_open,
+	.mmap = cam_fsync_mmap,
 	.unlocked_ioctl = cam_fsync_ioctl,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl = cam_fsync_ioctl,
@@ -775,6 +865,12 @@ static struct fsync_generator_group *cam_fsync_group_init(
 	if (IS_ERR(group))
 		return group;
 
+	BUILD_BUG_ON(sizeof(*group->schedule) > PAGE_SIZE);
+	group->schedule = (struct cam_fsync_group_schedule *)
+		devm_get_free_pages(controller->dev, GFP_KERNEL | __GFP_ZERO, 0);
+	if (group->schedule == NULL)
+		return ERR_PTR(-ENOMEM);
+
 	INIT_LIST_HEAD(&group->generators);
 	INIT_LIST_HEAD(&group->list);
 	group->id = group_id;
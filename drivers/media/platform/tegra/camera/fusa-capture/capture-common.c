@@ -12,16 +12,26 @@
 
 #include <linux/dma-buf.h>
 #include <linux/dma-mapping.h>
+#include <linux/eventfd.h>
 #include <linux/nospec.h>
 #include <linux/nvhost.h>
+#include <linux/rcupdate.h>
 #include <linux/slab.h>
 #include <linux/hashtable.h>
 #include <linux/atomic.h>
+#include <linux/debugfs.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include <asm/arch_timer.h>
 #include <media/mc_common.h>
 
 #include <media/fusa-capture/capture-common.h>
 
 
+struct capture_buffer_ring;
+
 /**
  * @brief Capture buffer management table.
  */
@@ -30,6 +40,27 @@ struct capture_buffer_table {
 	struct kmem_cache *cache; /**< SLAB allocator cache */
 	rwlock_t hlock; /**< Reader/writer lock on table contents */
 	DECLARE_HASHTABLE(hhead, 4U); /**< Buffer hashtable head */
+	struct capture_buffer_ring *ring;
+		/**< Pre-pinned buffer ring, NULL until registered */
+};
+
+/**
+ * @brief Pre-pinned capture buffer ring slot.
+ */
+struct capture_buffer_ring_slot {
+	struct capture_mapping *pin; /**< Mapping held by the ring */
+	dma_addr_t iova; /**< IOVA of the buffer start */
+	uint64_t size; /**< Size of the buffer [byte] */
+	bool contiguous; /**< Buffer is contiguous in IOVA space */
+};
+
+/**
+ * @brief Capture buffers pinned and IOVA-resolved once at setup, referenced
+ * from capture descriptors by @ref CAPTURE_BUFFER_RING_HANDLE.
+ */
+struct capture_buffer_ring {
+	uint32_t num_slots; /**< No. of entries in slots[] */
+	struct capture_buffer_ring_slot slots[]; /**< Ring slots */
 };
 
 /**
@@ -332,6 +363,7 @@ struct capture_buffer_table *create_buffer_table(
 
 		if (likely(tab->cache != NULL)) {
 			tab->dev = dev;
+			tab->ring = NULL;
 			hash_init(tab->hhead);
 			rwlock_init(&tab->hlock);
 		} else {
@@ -368,6 +400,8 @@ void destroy_buffer_table(
 
 
 	kmem_cache_destroy(tab->cache);
+	/* The ring mappings were released with the hashtable above */
+	kfree(tab->ring);
 	kfree(tab);
 }
 EXPORT_SYMBOL_GPL(destroy_buffer_table);
@@ -436,6 +470,125 @@ end:
 }
 EXPORT_SYMBOL_GPL(capture_buffer_request);
 
+int capture_buffer_ring_register(
+	struct capture_buffer_table *tab,
+	const uint32_t *memfds,
+	uint32_t count)
+{
+	struct capture_buffer_ring *ring;
+	struct capture_buffer_ring_slot *slot;
+	uint32_t i;
+	int err = 0;
+
+	if (unlikely(tab == NULL)) {
+		pr_err("%s: invalid buffer table\n", __func__);
+		return -EINVAL;
+	}
+
+	if (count == 0U || count > CAPTURE_BUFFER_RING_MAX_SLOTS) {
+		dev_err(tab->dev, "%s: invalid ring size %u\n",
+			__func__, count);
+		return -EINVAL;
+	}
+
+	ring = kzalloc(struct_size(ring, slots, count), GFP_KERNEL);
+	if (unlikely(ring == NULL))
+		return -ENOMEM;
+
+	mutex_lock(&req_lock);
+
+	if (tab->ring != NULL) {
+		dev_err(tab->dev, "%s: buffer ring already registered\n",
+			__func__);
+		err = -EBUSY;
+		goto unlock;
+	}
+
+	for (i = 0U; i < count; i++) {
+		slot = &ring->slots[i];
+
+		slot->pin = get_mapping(tab, memfds[i], BUFFER_RDWR);
+		if (IS_ERR(slot->pin)) {
+			err = PTR_ERR(slot->pin);
+			slot->pin = NULL;
+			goto put_slots;
+		}
+
+		slot->iova = mapping_iova(slot->pin, 0U);
+		slot->size = mapping_buf(slot->pin)->size;
+		slot->contiguous = (slot->pin->sgt->nents == 1U);
+		if (slot->iova == 0) {
+			err = -EINVAL;
+			goto put_slots;
+		}
+	}
+
+	ring->num_slots = count;
+
+	/* Pairs with smp_load_acquire() in capture_common_pin_and_get_iova() */
+	smp_store_release(&tab->ring, ring);
+
+	mutex_unlock(&req_lock);
+
+	return 0;
+
+put_slots:
+	dev_err(tab->dev, "%s: ring slot %u memfd %u; errno %d\n",
+		__func__, i, memfds[i], err);
+	for (i = 0U; i < count; i++) {
+		if (ring->slots[i].pin != NULL)
+			put_mapping(tab, ring->slots[i].pin);
+	}
+unlock:
+	mutex_unlock(&req_lock);
+	kfree(ring);
+
+	return err;
+}
+EXPORT_SYMBOL_GPL(capture_buffer_ring_register);
+
+/**
+ * @brief Resolve a buffer ring handle to an IOVA range; ring buffers stay
+ * pinned until the table is destroyed, so nothing is added to @a unpins.
+ */
+static int capture_buffer_ring_get_iova(
+	struct capture_buffer_table *tab,
+	uint32_t mem_handle, uint64_t mem_offset,
+	uint64_t *meminfo_base_address, uint64_t *meminfo_size)
+{
+	struct capture_buffer_ring *ring = smp_load_acquire(&tab->ring);
+	struct capture_buffer_ring_slot *slot;
+	uint32_t index = mem_handle & ~CAPTURE_BUFFER_RING_HANDLE_FLAG;
+	uint64_t iova;
+
+	if (ring == NULL || index >= ring->num_slots) {
+		pr_err("%s: invalid ring handle %#x\n", __func__, mem_handle);
+		return -EINVAL;
+	}
+
+	index = array_index_nospec(index, ring->num_slots);
+	slot = &ring->slots[index];
+
+	if (mem_offset >= slot->size) {
+		pr_err("%s: offset is out of bounds\n", __func__);
+		return -EINVAL;
+	}
+
+	if (slot->contiguous)
+		iova = slot->iova + mem_offset;
+	else
+		iova = mapping_iova(slot->pin, mem_offset);
+	if (iova == 0) {
+		pr_err("%s: Invalid iova\n", __func__);
+		return -EINVAL;
+	}
+
+	*meminfo_base_address = iova;
+	*meminfo_size = slot->size - mem_offset;
+
+	return 0;
+}
+
 int capture_buffer_add(
 	struct capture_buffer_table *t,
 	uint32_t fd)
@@ -487,6 +640,10 @@ int capture_common_pin_and_get_iova(struct capture_buffer_table *buf_ctx,
 		return 0;
 	}
 
+	if (mem_handle & CAPTURE_BUFFER_RING_HANDLE_FLAG)
+		return capture_buffer_ring_get_iova(buf_ctx, mem_handle,
+				mem_offset, meminfo_base_address, meminfo_size);
+
 	if (unpins->num_unpins >= MAX_PIN_BUFFER_PER_REQUEST) {
 		pr_err("%s: too many buffers per request\n", __func__);
 			return -ENOMEM;
@@ -588,6 +745,9 @@ int capture_common_release_progress_status_notifier(
 		dma_buf_put(dmabuf);
 	}
 
+	(void)capture_common_set_progress_status_eventfd(
+			progress_status_notifier, -1);
+
 	progress_status_notifier->buf = NULL;
 	progress_status_notifier->va = NULL;
 	progress_status_notifier->offset = 0;
@@ -596,6 +756,33 @@ int capture_common_release_progress_status_notifier(
 }
 EXPORT_SYMBOL_GPL(capture_common_release_progress_status_notifier);
 
+int capture_common_set_progress_status_eventfd(
+	struct capture_common_status_notifier *progress_status_notifier,
+	int fd)
+{
+	struct eventfd_ctx *ctx = NULL;
+	struct eventfd_ctx *old;
+
+	if (fd >= 0) {
+		ctx = eventfd_ctx_fdget(fd);
+		if (IS_ERR(ctx))
+			return PTR_ERR(ctx);
+	}
+
+	/*
+	 * The status callback only reads the pointer under rcu_read_lock(),
+	 * so wait for any in-flight signal before dropping the old context.
+	 */
+	old = xchg(&progress_status_notifier->eventfd, ctx);
+	if (old != NULL) {
+		synchronize_rcu();
+		eventfd_ctx_put(old);
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(capture_common_set_progress_status_eventfd);
+
 int capture_common_set_progress_status(
 	struct capture_common_status_notifier *progress_status_notifier,
 	uint32_t buffer_slot,
@@ -604,6 +791,7 @@ int capture_common_set_progress_status(
 {
 	uint32_t *status_notifier = (uint32_t *) (progress_status_notifier->va +
 			progress_status_notifier->offset);
+	struct eventfd_ctx *ctx;
 
 	if (buffer_slot >= buffer_depth) {
 		pr_err("%s: Invalid offset!", __func__);
@@ -621,6 +809,16 @@ int capture_common_set_progress_status(
 
 	status_notifier[buffer_slot] = new_val;
 
+	rcu_read_lock();
+	ctx = READ_ONCE(progress_status_notifier->eventfd);
+	if (ctx != NULL)
+#if defined(NV_EVENTFD_SIGNAL_HAS_COUNTER_ARG) /* Linux v6.8 */
+		eventfd_signal(ctx, 1);
+#else
+		eventfd_signal(ctx);
+#endif
+	rcu_read_unlock();
+
 	return 0;
 }
 EXPORT_SYMBOL_GPL(capture_common_set_progress_status);
@@ -708,3 +906,259 @@ void capture_common_unpin_memory(
 	unpin_data->va = NULL;
 }
 EXPORT_SYMBOL_GPL(capture_common_unpin_memory);
+
+/**
+ * @brief Capture pipeline latency histograms.
+ *
+ * Power of two buckets, bucket b counts the samples below 1us << b; the
+ * last bucket also holds anything slower. The last frames delivered to vb2
+ * are kept in a ring for correlation with the RCE trace.
+ */
+#define CAPTURE_LATENCY_BUCKETS		22
+#define CAPTURE_LATENCY_MIN_SHIFT	10
+#define CAPTURE_LATENCY_FRAMES		64
+
+struct capture_latency_frame {
+	uint32_t channel;
+	uint32_t sequence;
+	uint64_t sof_ns;
+	uint64_t eof_ns;
+	uint64_t status_ns;
+	uint64_t done_ns;
+};
+
+static struct capture_latency {
+	atomic64_t count[CAPTURE_LATENCY_NUM][CAPTURE_LATENCY_BUCKETS];
+	atomic64_t sum_ns[CAPTURE_LATENCY_NUM];
+	atomic64_t max_ns[CAPTURE_LATENCY_NUM];
+
+	spinlock_t frames_lock;
+	struct capture_latency_frame frames[CAPTURE_LATENCY_FRAMES];
+	uint32_t frames_next;
+
+	struct dentry *debugfs;
+} capture_latency = {
+	.frames_lock = __SPIN_LOCK_UNLOCKED(capture_latency.frames_lock),
+};
+
+static const char * const capture_latency_names[CAPTURE_LATENCY_NUM] = {
+	[CAPTURE_LATENCY_VI_FRAME] = "vi_sof_to_eof",
+	[CAPTURE_LATENCY_VI_STATUS] = "vi_eof_to_status",
+	[CAPTURE_LATENCY_VI_DONE] = "vi_status_to_done",
+	[CAPTURE_LATENCY_VI_TOTAL] = "vi_sof_to_done",
+	[CAPTURE_LATENCY_ISP_PROGRAM] = "isp_program",
+};
+
+uint64_t capture_latency_now(void)
+{
+	return mul_u64_u32_div(__arch_counter_get_cntvct(), NSEC_PER_SEC,
+			arch_timer_get_cntfrq());
+}
+EXPORT_SYMBOL_GPL(capture_latency_now);
+
+void capture_latency_record(enum capture_latency_stage stage,
+		uint64_t start_ns, uint64_t end_ns)
+{
+	uint64_t ns, max;
+	int b;
+
+	/* the stage is missing a timestamp, or the clocks disagree */
+	if (start_ns == 0ULL || end_ns < start_ns)
+		return;
+
+	ns = end_ns - start_ns;
+	b = (ns >> CAPTURE_LATENCY_MIN_SHIFT) ?
+		ilog2(ns) - CAPTURE_LATENCY_MIN_SHIFT + 1 : 0;
+	b = min(b, CAPTURE_LATENCY_BUCKETS - 1);
+
+	atomic64_inc(&capture_latency.count[stage][b]);
+	atomic64_add(ns, &capture_latency.sum_ns[stage]);
+
+	max = atomic64_read(&capture_latency.max_ns[stage]);
+	while (ns > max) {
+		uint64_t old = atomic64_cmpxchg(
+				&capture_latency.max_ns[stage], max, ns);
+
+		if (old == max)
+			break;
+		max = old;
+	}
+}
+EXPORT_SYMBOL_GPL(capture_latency_record);
+
+void capture_latency_vi_frame(uint32_t channel, uint32_t sequence,
+		uint64_t sof_ns, uint64_t eof_ns, uint64_t status_ns,
+		uint64_t done_ns)
+{
+	struct capture_latency_frame *frame;
+	unsigned long flags;
+
+	capture_latency_record(CAPTURE_LATENCY_VI_FRAME, sof_ns, eof_ns);
+	capture_latency_record(CAPTURE_LATENCY_VI_STATUS, eof_ns, status_ns);
+	capture_latency_record(CAPTURE_LATENCY_VI_DONE, status_ns, done_ns);
+	capture_latency_record(CAPTURE_LATENCY_VI_TOTAL, sof_ns, done_ns);
+
+	spin_lock_irqsave(&capture_latency.frames_lock, flags);
+	frame = &capture_latency.frames[capture_latency.frames_next];
+	capture_latency.frames_next = (capture_latency.frames_next + 1U) %
+			CAPTURE_LATENCY_FRAMES;
+	frame->channel = channel;
+	frame->sequence = sequence;
+	frame->sof_ns = sof_ns;
+	frame->eof_ns = eof_ns;
+	frame->status_ns = status_ns;
+	frame->done_ns = done_ns;
+	spin_unlock_irqrestore(&capture_latency.frames_lock, flags);
+}
+EXPORT_SYMBOL_GPL(capture_latency_vi_frame);
+
+/* Upper bound of the bucket holding the given percentile [ns]. */
+static uint64_t capture_latency_percentile(const uint64_t *count,
+		uint64_t total, uint32_t pct)
+{
+	uint64_t target = div_u64(total * pct + 99U, 100U);
+	uint64_t seen = 0;
+	int b;
+
+	for (b = 0; b < CAPTURE_LATENCY_BUCKETS - 1; b++) {
+		seen += count[b];
+		if (seen >= target)
+			break;
+	}
+
+	return 1ULL << (CAPTURE_LATENCY_MIN_SHIFT + b);
+}
+
+static int capture_latency_show(struct seq_file *s, void *data)
+{
+	uint64_t count[CAPTURE_LATENCY_BUCKETS];
+	int stage, b;
+
+	seq_printf(s, "%-18s %10s %10s %10s %10s %10s %10s\n", "STAGE",
+		"COUNT", "AVG_US", "P50_US", "P90_US", "P99_US", "MAX_US");
+
+	for (stage = 0; stage < CAPTURE_LATENCY_NUM; stage++) {
+		uint64_t total = 0;
+
+		for (b = 0; b < CAPTURE_LATENCY_BUCKETS; b++) {
+			count[b] = atomic64_read(
+					&capture_latency.count[stage][b]);
+			total += count[b];
+		}
+		if (total == 0ULL)
+			continue;
+
+		seq_printf(s, "%-18s %10llu %10llu %10llu %10llu %10llu %10llu\n",
+			capture_latency_names[stage], total,
+			div64_u64(atomic64_read(&capture_latency.sum_ns[stage]),
+				total * NSEC_PER_USEC),
+			div_u64(capture_latency_percentile(count, total, 50),
+				NSEC_PER_USEC),
+			div_u64(capture_latency_percentile(count, total, 90),
+				NSEC_PER_USEC),
+			div_u64(capture_latency_percentile(count, total, 99),
+				NSEC_PER_USEC),
+			div_u64(atomic64_read(&capture_latency.max_ns[stage]),
+				NSEC_PER_USEC));
+	}
+
+	return 0;
+}
+
+static int capture_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, capture_latency_show, inode->i_private);
+}
+
+static ssize_t capture_latency_reset(struct file *file,
+		const char __user *buf, size_t count, loff_t *ppos)
+{
+	int stage, b;
+
+	for (stage = 0; stage < CAPTURE_LATENCY_NUM; stage++) {
+		for (b = 0; b < CAPTURE_LATENCY_BUCKETS; b++)
+			atomic64_set(&capture_latency.count[stage][b], 0);
+		atomic64_set(&capture_latency.sum_ns[stage], 0);
+		atomic64_set(&capture_latency.max_ns[stage], 0);
+	}
+
+	return count;
+}
+
+static const struct file_operations capture_latency_fops = {
+	.open = capture_latency_open,
+	.read = seq_read,
+	.write = capture_latency_reset,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int capture_latency_frames_show(struct seq_file *s, void *data)
+{
+	struct capture_latency_frame *frames;
+	unsigned long flags;
+	uint32_t next, i;
+
+	frames = kmalloc(sizeof(capture_latency.frames), GFP_KERNEL);
+	if (frames == NULL)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&capture_latency.frames_lock, flags);
+	memcpy(frames, capture_latency.frames, sizeof(capture_latency.frames));
+	next = capture_latency.frames_next;
+	spin_unlock_irqrestore(&capture_latency.frames_lock, flags);
+
+	seq_printf(s, "%-8s %10s %20s %10s %10s %10s\n", "CHANNEL",
+		"SEQUENCE", "SOF_NS", "EOF_US", "STATUS_US", "DONE_US");
+
+	/* oldest first, the deltas are relative to SOF */
+	for (i = 0; i < CAPTURE_LATENCY_FRAMES; i++) {
+		struct capture_latency_frame *f =
+			&frames[(next + i) % CAPTURE_LATENCY_FRAMES];
+
+		if (f->sof_ns == 0ULL)
+			continue;
+
+		seq_printf(s, "%-8u %10u %20llu %10lld %10lld %10lld\n",
+			f->channel, f->sequence, f->sof_ns,
+			div_s64((s64)(f->eof_ns - f->sof_ns), NSEC_PER_USEC),
+			div_s64((s64)(f->status_ns - f->sof_ns), NSEC_PER_USEC),
+			div_s64((s64)(f->done_ns - f->sof_ns), NSEC_PER_USEC));
+	}
+
+	kfree(frames);
+	return 0;
+}
+
+static int capture_latency_frames_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, capture_latency_frames_show, inode->i_private);
+}
+
+static const struct file_operations capture_latency_frames_fops = {
+	.open = capture_latency_frames_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+void capture_latency_init(void)
+{
+	capture_latency.debugfs = debugfs_create_dir("tegra_capture_latency",
+			NULL);
+	if (IS_ERR_OR_NULL(capture_latency.debugfs))
+		return;
+
+	debugfs_create_file("latency", 0644, capture_latency.debugfs, NULL,
+			&capture_latency_fops);
+	debugfs_create_file("frames", 0444, capture_latency.debugfs, NULL,
+			&capture_latency_frames_fops);
+}
+EXPORT_SYMBOL_GPL(capture_latency_init);
+
+void capture_latency_exit(void)
+{
+	debugfs_remove_recursive(capture_latency.debugfs);
+	capture_latency.debugfs = NULL;
+}
+EXPORT_SYMBOL_GPL(capture_latency_exit);
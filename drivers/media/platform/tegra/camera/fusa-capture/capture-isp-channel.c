@@ -196,6 +196,18 @@ struct isp_channel_drv {
 #define ISP_CAPTURE_BUFFER_REQUEST \
 	_IOW('I', 11, struct isp_buffer_req)
 
+/**
+ * @brief Attach an eventfd that is signalled after each status write to the
+ * progress status notifier; pass -1 to detach it. Requires
+ * @ref ISP_CAPTURE_SET_PROGRESS_STATUS_NOTIFIER.
+ *
+ * @param[in]	ptr	Pointer to an eventfd file descriptor (__s32)
+ *
+ * @returns	0 (success), neg. errno (failure)
+ */
+#define ISP_CAPTURE_SET_STATUS_EVENTFD \
+	_IOW('I', 12, __s32)
+
 /** @} */
 
 /**
@@ -501,6 +513,17 @@ static long isp_channel_ioctl(
 				"isp capture set progress status buffers failed\n");
 		break;
 	}
+	case _IOC_NR(ISP_CAPTURE_SET_STATUS_EVENTFD): {
+		int32_t fd;
+
+		if (copy_from_user(&fd, ptr, sizeof(fd)))
+			break;
+		err = isp_capture_set_status_eventfd(chan, fd);
+		if (err)
+			dev_err(chan->isp_dev,
+				"isp capture set status eventfd failed\n");
+		break;
+	}
 	case _IOC_NR(ISP_CAPTURE_BUFFER_REQUEST): {
 		struct isp_buffer_req req;
 
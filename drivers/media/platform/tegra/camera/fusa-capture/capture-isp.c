@@ -56,6 +56,18 @@ struct isp_desc_rec {
 		/**< List of process request buffer unpins */
 };
 
+/**
+ * @brief Pinned ISP program cached in a program descriptor queue slot.
+ *
+ * A resident program may back several in-flight process requests; the
+ * slot's pushbuffer mapping is released when the last one retires.
+ */
+struct isp_program_cache_entry {
+	uint64_t isp_pb1_mem; /**< Pushbuffer handle and offset when pinned */
+	uint32_t refs; /**< No. of in-flight requests using the program */
+	uint64_t submit_ns; /**< Submit time of the latest request [ns] */
+};
+
 /**
  * @brief ISP channel capture context.
  */
@@ -70,6 +82,10 @@ struct isp_capture {
 		/**< Capture process descriptor queue context */
 	struct isp_desc_rec program_desc_ctx;
 		/**< Program process descriptor queue context */
+	struct isp_program_cache_entry *program_cache;
+		/**< Per-slot cache of pinned programs, one per program_desc_ctx
+		 *   descriptor; protected by program_desc_ctx.unpins_list_lock
+		 */
 
 	struct capture_common_status_notifier progress_status_notifier;
 		/**< Process progress status notifier context */
@@ -514,21 +530,33 @@ static void isp_capture_request_unpin(
 }
 
 /**
- * @brief Unpin and free the list of pinned capture_mapping's associated with an
- * ISP program request.
+ * @brief Drop a reference to the program cached in a program descriptor slot,
+ * and unpin and free its list of pinned capture_mapping's once the last
+ * request using it has retired.
  *
  * @param[in]	chan		ISP channel context
  * @param[in]	buffer_index	Program descriptor queue index
+ * @param[in]	force		Drop all references (channel reset/release)
  */
 static void isp_capture_program_request_unpin(
 	struct tegra_isp_channel *chan,
-	uint32_t buffer_index)
+	uint32_t buffer_index,
+	bool force)
 {
 	struct isp_capture *capture = chan->capture_data;
+	struct isp_program_cache_entry *entry;
 	struct capture_common_unpins *unpins;
 	int i = 0;
 
 	mutex_lock(&capture->program_desc_ctx.unpins_list_lock);
+	entry = &capture->program_cache[buffer_index];
+	if (!force && entry->refs > 1U) {
+		entry->refs--;
+		mutex_unlock(&capture->program_desc_ctx.unpins_list_lock);
+		return;
+	}
+	entry->refs = 0U;
+
 	unpins = &capture->program_desc_ctx.unpins_list[buffer_index];
 	if (unpins->num_unpins != 0U) {
 		for (i = 0; i < unpins->num_unpins; i++)
@@ -543,19 +571,26 @@ static void isp_capture_program_request_unpin(
  * descriptor, the resultant mappings are added to the channel program
  * descriptor queue's @em unpins_list.
  *
+ * If @a reuse is set and the slot still holds the same pinned program for an
+ * in-flight request, the cached mapping is reused and only its reference
+ * count is raised.
+ *
  * @param[in]	chan	ISP channel context
  * @param[in]	req	ISP program request
+ * @param[in]	reuse	Whether a resident program may be shared
  *
  * @returns	0 (success), neg. errno (failure)
  */
 static int isp_capture_program_prepare(
 	struct tegra_isp_channel *chan,
-	struct isp_program_req *req)
+	struct isp_program_req *req,
+	bool reuse)
 {
 	struct isp_capture *capture = chan->capture_data;
 	int err = 0;
 	struct memoryinfo_surface *meminfo;
 	struct isp_program_descriptor *desc;
+	struct isp_program_cache_entry *entry;
 	uint32_t request_offset;
 
 	if (capture == NULL) {
@@ -599,7 +634,21 @@ static int isp_capture_program_prepare(
 
 	mutex_lock(&capture->program_desc_ctx.unpins_list_lock);
 
+	desc = (struct isp_program_descriptor *)
+		(capture->program_desc_ctx.requests.va + req->buffer_index *
+				capture->program_desc_ctx.request_size);
+	entry = &capture->program_cache[req->buffer_index];
+
 	if (capture->program_desc_ctx.unpins_list[req->buffer_index].num_unpins != 0) {
+		if (reuse && entry->refs != 0U && entry->refs < U32_MAX &&
+				entry->isp_pb1_mem == desc->isp_pb1_mem) {
+			/* program is resident, reuse the pinned pushbuffer */
+			entry->refs++;
+			entry->submit_ns = capture_latency_now();
+			mutex_unlock(&capture->program_desc_ctx.unpins_list_lock);
+			return 0;
+		}
+
 		dev_err(chan->isp_dev,
 			"%s: program request is still in use by rtcpu\n",
 			__func__);
@@ -611,10 +660,6 @@ static int isp_capture_program_prepare(
 			capture->program_desc_ctx.requests_memoryinfo)
 				[req->buffer_index];
 
-	desc = (struct isp_program_descriptor *)
-		(capture->program_desc_ctx.requests.va + req->buffer_index *
-				capture->program_desc_ctx.request_size);
-
 	/* Pushbuffer 1 is located after program desc in same ringbuffer */
 	request_offset = req->buffer_index *
 			capture->program_desc_ctx.request_size;
@@ -626,6 +671,13 @@ static int isp_capture_program_prepare(
 		&meminfo->size,
 		&capture->program_desc_ctx.unpins_list[req->buffer_index]);
 
+	if (err == 0 &&
+		capture->program_desc_ctx.unpins_list[req->buffer_index].num_unpins != 0) {
+		entry->isp_pb1_mem = desc->isp_pb1_mem;
+		entry->refs = 1U;
+		entry->submit_ns = capture_latency_now();
+	}
+
 	mutex_unlock(&capture->program_desc_ctx.unpins_list_lock);
 
 	return err;
@@ -692,7 +744,7 @@ static inline void isp_capture_ivc_program_cleanup(
 {
 	struct tegra_isp_channel *chan = capture->isp_channel;
 
-	isp_capture_program_request_unpin(chan, buffer_index);
+	isp_capture_program_request_unpin(chan, buffer_index, false);
 	dma_sync_single_range_for_cpu(capture->rtcpu_dev,
 		capture->program_desc_ctx.requests.iova,
 		buffer_index * capture->program_desc_ctx.request_size,
@@ -772,6 +824,11 @@ static void isp_capture_ivc_status_callback(
 	case CAPTURE_ISP_PROGRAM_STATUS_IND:
 		buffer_index =
 			status_msg->capture_isp_program_status_ind.buffer_index;
+		if (capture->program_cache != NULL &&
+				buffer_index < capture->program_desc_ctx.queue_depth)
+			capture_latency_record(CAPTURE_LATENCY_ISP_PROGRAM,
+				capture->program_cache[buffer_index].submit_ns,
+				capture_latency_now());
 		isp_capture_ivc_program_cleanup(capture, buffer_index);
 		isp_capture_ivc_program_signal(capture, buffer_index);
 		dev_dbg(chan->isp_dev,
@@ -1100,6 +1157,16 @@ int isp_capture_setup(
 		goto prog_unpins_list_fail;
 	}
 
+	capture->program_cache = vzalloc(
+			capture->program_desc_ctx.queue_depth *
+				sizeof(*capture->program_cache));
+	if (unlikely(capture->program_cache == NULL)) {
+		dev_err(chan->isp_dev,
+			"failed to allocate isp program cache\n");
+		err = -ENOMEM;
+		goto prog_cache_fail;
+	}
+
 	/* Allocate memory info ring buffer for program descriptors */
 	capture->program_desc_ctx.requests_memoryinfo =
 		dma_alloc_coherent(capture->rtcpu_dev,
@@ -1215,6 +1282,9 @@ syncpt_fail:
 		capture->program_desc_ctx.requests_memoryinfo,
 		capture->program_desc_ctx.requests_memoryinfo_iova);
 program_meminfo_alloc_fail:
+	vfree(capture->program_cache);
+	capture->program_cache = NULL;
+prog_cache_fail:
 	vfree(capture->program_desc_ctx.unpins_list);
 prog_unpins_list_fail:
 	capture_common_unpin_memory(&capture->program_desc_ctx.requests);
@@ -1293,7 +1363,7 @@ int isp_capture_release(
 
 	for (i = 0; i < capture->program_desc_ctx.queue_depth; i++) {
 		complete(&capture->capture_program_resp);
-		isp_capture_program_request_unpin(chan, i);
+		isp_capture_program_request_unpin(chan, i, true);
 	}
 
 	capture_common_unpin_memory(&capture->program_desc_ctx.requests);
@@ -1311,6 +1381,8 @@ int isp_capture_release(
 
 	vfree(capture->program_desc_ctx.unpins_list);
 	capture->program_desc_ctx.unpins_list = NULL;
+	vfree(capture->program_cache);
+	capture->program_cache = NULL;
 	vfree(capture->capture_desc_ctx.unpins_list);
 	capture->capture_desc_ctx.unpins_list = NULL;
 
@@ -1413,7 +1485,7 @@ int isp_capture_reset(
 	}
 
 	for (i = 0; i < capture->program_desc_ctx.queue_depth; i++) {
-		isp_capture_program_request_unpin(chan, i);
+		isp_capture_program_request_unpin(chan, i, true);
 		complete(&capture->capture_program_resp);
 	}
 	spec_bar();
@@ -1781,7 +1853,7 @@ int isp_capture_program_request(
 		__arch_counter_get_cntvct(),
 		NVHOST_CAMERA_ISP_CAPTURE_PROGRAM_REQUEST);
 
-	err = isp_capture_program_prepare(chan, req);
+	err = isp_capture_program_prepare(chan, req, false);
 	if (err < 0) {
 		/* no cleanup needed */
 		return err;
@@ -1801,7 +1873,8 @@ int isp_capture_program_request(
 			sizeof(capture_msg));
 	if (err < 0) {
 		dev_err(chan->isp_dev, "IVC program submit failed\n");
-		isp_capture_program_request_unpin(chan, req->buffer_index);
+		isp_capture_program_request_unpin(chan, req->buffer_index,
+			false);
 		return err;
 	}
 
@@ -1866,7 +1939,7 @@ int isp_capture_request_ex(
 		return isp_capture_request(chan, &req->capture_req);
 	}
 
-	err = isp_capture_program_prepare(chan, &req->program_req);
+	err = isp_capture_program_prepare(chan, &req->program_req, true);
 
 	if (err < 0) {
 		/* no cleanup required */
@@ -1878,7 +1951,7 @@ int isp_capture_request_ex(
 	if (err < 0) {
 		/* unpin prepared program */
 		isp_capture_program_request_unpin(
-			chan, req->program_req.buffer_index);
+			chan, req->program_req.buffer_index, false);
 	}
 
 	return err;
@@ -1977,6 +2050,28 @@ int isp_capture_set_progress_status_notifier(
 	return err;
 }
 
+int isp_capture_set_status_eventfd(
+	struct tegra_isp_channel *chan,
+	int32_t fd)
+{
+	struct isp_capture *capture = chan->capture_data;
+
+	if (capture == NULL) {
+		dev_err(chan->isp_dev,
+				"%s: isp capture uninitialized\n", __func__);
+		return -ENODEV;
+	}
+
+	if (!capture->is_progress_status_notifier_set) {
+		dev_err(chan->isp_dev,
+			"%s: progress status notifier is not set\n", __func__);
+		return -EINVAL;
+	}
+
+	return capture_common_set_progress_status_eventfd(
+			&capture->progress_status_notifier, fd);
+}
+
 int isp_capture_buffer_request(
 	struct tegra_isp_channel *chan,
 	struct isp_buffer_req *req)
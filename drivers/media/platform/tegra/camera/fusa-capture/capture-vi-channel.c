@@ -13,6 +13,7 @@
 #include <asm/ioctls.h>
 #include <linux/cdev.h>
 #include <linux/device.h>
+#include <linux/file.h>
 #include <linux/fs.h>
 #include <linux/of_platform.h>
 #include <linux/nvhost.h>
@@ -153,6 +154,45 @@
 #define VI_CAPTURE_BUFFER_REQUEST \
 	_IOW('I', 10, struct vi_buffer_req)
 
+/**
+ * @brief Enqueue capture requests for a group of synchronized VI channels to
+ * RCE in a single pass; the buffers of every request are pinned and patched
+ * as for @ref VI_CAPTURE_REQUEST before any request is sent.
+ *
+ * On return, num_submitted holds the number of requests handed to RCE. The
+ * requests that were not submitted are unpinned.
+ *
+ * @param[in,out]	ptr	Pointer to a struct @ref vi_capture_group_req
+ *
+ * @returns	0 (success), neg. errno (failure)
+ */
+#define VI_CAPTURE_GROUP_REQUEST \
+	_IOWR('I', 11, struct vi_capture_group_req)
+
+/**
+ * @brief Pin and IOVA-resolve a ring of surface buffers once; capture
+ * descriptors then reference ring buffer @a i with the memory handle
+ * @ref CAPTURE_BUFFER_RING_HANDLE(i) instead of its NvRm handle, which skips
+ * the per-request mapping lookup. The ring stays pinned until the channel is
+ * released, and can be registered once per channel setup.
+ *
+ * @param[in]	ptr	Pointer to a struct @ref vi_buffer_ring_req
+ * @returns	0 (success), neg. errno (failure)
+ */
+#define VI_CAPTURE_BUFFER_RING_REGISTER \
+	_IOW('I', 12, struct vi_buffer_ring_req)
+
+/**
+ * @brief Attach an eventfd that is signalled after each status write to the
+ * progress status notifier; pass -1 to detach it. Requires
+ * @ref VI_CAPTURE_SET_PROGRESS_STATUS_NOTIFIER.
+ *
+ * @param[in]	ptr	Pointer to an eventfd file descriptor (__s32)
+ * @returns	0 (success), neg. errno (failure)
+ */
+#define VI_CAPTURE_SET_STATUS_EVENTFD \
+	_IOW('I', 13, __s32)
+
 /** @} */
 
 void vi_capture_request_unpin(
@@ -353,6 +393,141 @@ fail:
 	return err;
 }
 
+/**
+ * Validate a capture request and pin its buffers; on failure the request is
+ * left unpinned.
+ */
+static int vi_channel_pin_request(struct tegra_vi_channel *chan,
+		struct vi_capture_req *req)
+{
+	struct vi_capture *capture = chan->capture_data;
+	struct capture_common_unpins *request_unpins;
+	int err;
+
+	if (req->num_relocs == 0) {
+		dev_err(chan->dev, "request must have non-zero relocs\n");
+		return -EINVAL;
+	}
+
+	if (req->buffer_index >= capture->queue_depth) {
+		dev_err(chan->dev, "buffer index is out of bound\n");
+		return -EINVAL;
+	}
+
+	/* Don't let to speculate with invalid buffer_index value */
+	spec_bar();
+
+	if (capture->unpins_list == NULL) {
+		dev_err(chan->dev, "Channel setup incomplete\n");
+		return -EINVAL;
+	}
+
+	mutex_lock(&capture->unpins_list_lock);
+
+	request_unpins = &capture->unpins_list[req->buffer_index];
+
+	if (request_unpins->num_unpins != 0U) {
+		dev_err(chan->dev, "Descriptor is still in use by rtcpu\n");
+		mutex_unlock(&capture->unpins_list_lock);
+		return -EBUSY;
+	}
+	err = pin_vi_capture_request_buffers_locked(chan, req,
+			request_unpins);
+
+	mutex_unlock(&capture->unpins_list_lock);
+
+	if (err < 0) {
+		dev_err(chan->dev,
+			"pin request failed\n");
+		vi_capture_request_unpin(chan, req->buffer_index);
+	}
+
+	return err;
+}
+
+static const struct file_operations vi_channel_fops;
+
+/**
+ * Resolve the channels of a group request, pin all requests and submit them
+ * together.
+ */
+static int vi_channel_group_request(struct tegra_vi_channel *chan,
+		struct vi_capture_group_req *group)
+{
+	struct vi_capture_group_entry *entries;
+	struct tegra_vi_channel *chans[VI_CAPTURE_GROUP_MAX_REQUESTS];
+	struct vi_capture_req reqs[VI_CAPTURE_GROUP_MAX_REQUESTS];
+	struct file *files[VI_CAPTURE_GROUP_MAX_REQUESTS] = { NULL };
+	uint32_t count = group->num_requests;
+	uint32_t pinned = 0U;
+	uint32_t i;
+	int err = 0;
+
+	group->num_submitted = 0U;
+
+	if (count == 0U || count > VI_CAPTURE_GROUP_MAX_REQUESTS) {
+		dev_err(chan->dev, "invalid group request count %u\n", count);
+		return -EINVAL;
+	}
+
+	entries = kcalloc(count, sizeof(*entries), GFP_KERNEL);
+	if (entries == NULL)
+		return -ENOMEM;
+
+	if (copy_from_user(entries, (void __user *)(uintptr_t)group->entries,
+			count * sizeof(*entries))) {
+		err = -EFAULT;
+		goto free_entries;
+	}
+
+	for (i = 0U; i < count; i++) {
+		if (entries[i].channel_fd < 0) {
+			chans[i] = chan;
+		} else {
+			/* Hold the file so the channel cannot be released */
+			files[i] = fget(entries[i].channel_fd);
+			if (files[i] == NULL || files[i]->f_op != &vi_channel_fops) {
+				dev_err(chan->dev,
+					"group entry %u is not a VI channel\n", i);
+				err = -EINVAL;
+				goto put_files;
+			}
+			chans[i] = files[i]->private_data;
+		}
+
+		if (chans[i]->capture_data == NULL) {
+			err = -ENODEV;
+			goto put_files;
+		}
+
+		reqs[i] = entries[i].req;
+	}
+
+	for (pinned = 0U; pinned < count; pinned++) {
+		err = vi_channel_pin_request(chans[pinned], &reqs[pinned]);
+		if (err < 0)
+			goto unpin;
+	}
+
+	err = vi_capture_request_group(chans, reqs, count,
+			&group->num_submitted);
+	if (err < 0)
+		dev_err(chan->dev, "vi capture group request submit failed\n");
+
+unpin:
+	for (i = group->num_submitted; i < pinned; i++)
+		vi_capture_request_unpin(chans[i], reqs[i].buffer_index);
+put_files:
+	for (i = 0U; i < count; i++) {
+		if (files[i] != NULL)
+			fput(files[i]);
+	}
+free_entries:
+	kfree(entries);
+
+	return err;
+}
+
 /**
  * @brief Process an IOCTL call on a VI channel character device.
  *
@@ -514,49 +689,13 @@ static long vi_channel_ioctl(
 
 	case _IOC_NR(VI_CAPTURE_REQUEST): {
 		struct vi_capture_req req;
-		struct capture_common_unpins *request_unpins;
 
 		if (copy_from_user(&req, ptr, sizeof(req)))
 			break;
 
-		if (req.num_relocs == 0) {
-			dev_err(chan->dev, "request must have non-zero relocs\n");
-			return -EINVAL;
-		}
-
-		if (req.buffer_index >= capture->queue_depth) {
-			dev_err(chan->dev, "buffer index is out of bound\n");
-			return -EINVAL;
-		}
-
-		/* Don't let to speculate with invalid buffer_index value */
-		spec_bar();
-
-		if (capture->unpins_list == NULL) {
-			dev_err(chan->dev, "Channel setup incomplete\n");
-			return -EINVAL;
-		}
-
-		mutex_lock(&capture->unpins_list_lock);
-
-		request_unpins = &capture->unpins_list[req.buffer_index];
-
-		if (request_unpins->num_unpins != 0U) {
-			dev_err(chan->dev, "Descriptor is still in use by rtcpu\n");
-			mutex_unlock(&capture->unpins_list_lock);
-			return -EBUSY;
-		}
-		err = pin_vi_capture_request_buffers_locked(chan, &req,
-				request_unpins);
-
-		mutex_unlock(&capture->unpins_list_lock);
-
-		if (err < 0) {
-			dev_err(chan->dev,
-				"pin request failed\n");
-			vi_capture_request_unpin(chan, req.buffer_index);
+		err = vi_channel_pin_request(chan, &req);
+		if (err < 0)
 			break;
-		}
 
 		err = vi_capture_request(chan, &req);
 		if (err < 0) {
@@ -592,6 +731,30 @@ static long vi_channel_ioctl(
 		break;
 	}
 
+	case _IOC_NR(VI_CAPTURE_SET_STATUS_EVENTFD): {
+		int32_t fd;
+
+		if (copy_from_user(&fd, ptr, sizeof(fd)))
+			break;
+		err = vi_capture_set_status_eventfd(chan, fd);
+		if (err < 0)
+			dev_err(chan->dev,
+					"setting status eventfd failed\n");
+		break;
+	}
+
+	case _IOC_NR(VI_CAPTURE_GROUP_REQUEST): {
+		struct vi_capture_group_req group;
+
+		if (copy_from_user(&group, ptr, sizeof(group)))
+			break;
+
+		err = vi_channel_group_request(chan, &group);
+		if (copy_to_user(ptr, &group, sizeof(group)) && err == 0)
+			err = -EFAULT;
+		break;
+	}
+
 	case _IOC_NR(VI_CAPTURE_BUFFER_REQUEST): {
 		struct vi_buffer_req req;
 
@@ -605,6 +768,37 @@ static long vi_channel_ioctl(
 		break;
 	}
 
+	case _IOC_NR(VI_CAPTURE_BUFFER_RING_REGISTER): {
+		struct vi_buffer_ring_req req;
+		uint32_t *mems;
+
+		if (copy_from_user(&req, ptr, sizeof(req)) != 0U)
+			break;
+
+		if (req.num_buffers == 0U ||
+				req.num_buffers > CAPTURE_BUFFER_RING_MAX_SLOTS) {
+			dev_err(chan->dev, "invalid buffer ring size\n");
+			return -EINVAL;
+		}
+
+		mems = kcalloc(req.num_buffers, sizeof(*mems), GFP_KERNEL);
+		if (mems == NULL)
+			return -ENOMEM;
+
+		if (copy_from_user(mems, (void __user *)(uintptr_t)req.mems,
+				req.num_buffers * sizeof(*mems)) != 0U) {
+			kfree(mems);
+			break;
+		}
+
+		err = capture_buffer_ring_register(capture->buf_ctx, mems,
+				req.num_buffers);
+		if (err < 0)
+			dev_err(chan->dev, "vi buffer ring register failed\n");
+		kfree(mems);
+		break;
+	}
+
 	default: {
 		dev_err(chan->dev, "%s:Unknown ioctl\n", __func__);
 		return -ENOIOCTLCMD;
@@ -297,7 +297,10 @@ static void vi_capture_ivc_status_callback(
 			buffer_index * capture->request_size,
 			capture->request_size, DMA_FROM_DEVICE);
 
-		if (capture->is_progress_status_notifier_set) {
+		if (capture->status_notify != NULL) {
+			capture->status_notify(capture->status_notify_priv,
+					buffer_index);
+		} else if (capture->is_progress_status_notifier_set) {
 			capture_common_set_progress_status(
 					&capture->progress_status_notifier,
 					buffer_index,
@@ -981,6 +984,9 @@ int vi_capture_release(
 		err = ret;
 	}
 
+	capture->status_notify = NULL;
+	capture->status_notify_priv = NULL;
+
 	for (i = 0; i < capture->queue_depth; i++)
 		complete(&capture->capture_resp);
 
@@ -1419,6 +1425,102 @@ int vi_capture_request(
 }
 EXPORT_SYMBOL_GPL(vi_capture_request);
 
+/**
+ * Serializes group submissions, so that the reset locks of all channels in a
+ * group can be taken in any order without risking a lock inversion between
+ * two groups.
+ */
+static DEFINE_MUTEX(vi_capture_group_lock);
+
+int vi_capture_request_group(
+	struct tegra_vi_channel **chans,
+	struct vi_capture_req *reqs,
+	uint32_t count,
+	uint32_t *submitted)
+{
+	struct CAPTURE_MSG *capture_descs;
+	struct vi_capture *capture;
+	uint32_t i, j;
+	uint32_t locked = 0U;
+	int err = 0;
+
+	*submitted = 0U;
+
+	if (count == 0U || count > VI_CAPTURE_GROUP_MAX_REQUESTS)
+		return -EINVAL;
+
+	for (i = 0U; i < count; i++) {
+		capture = chans[i]->capture_data;
+		if (capture == NULL ||
+				capture->channel_id == CAPTURE_CHANNEL_INVALID_ID) {
+			dev_err(chans[i]->dev,
+				"%s: setup channel first\n", __func__);
+			return -ENODEV;
+		}
+
+		for (j = 0U; j < i; j++) {
+			if (chans[j] == chans[i]) {
+				dev_err(chans[i]->dev,
+					"%s: channel listed twice in group\n",
+					__func__);
+				return -EINVAL;
+			}
+		}
+	}
+
+	capture_descs = kcalloc(count, sizeof(*capture_descs), GFP_KERNEL);
+	if (capture_descs == NULL)
+		return -ENOMEM;
+
+	mutex_lock(&vi_capture_group_lock);
+
+	for (locked = 0U; locked < count; locked++) {
+		capture = chans[locked]->capture_data;
+
+		mutex_lock_nest_lock(&capture->reset_lock,
+				&vi_capture_group_lock);
+
+		nv_camera_log(chans[locked]->ndev,
+			__arch_counter_get_cntvct(),
+			NVHOST_CAMERA_VI_CAPTURE_REQUEST);
+
+		capture_descs[locked].header.msg_id = CAPTURE_REQUEST_REQ;
+		capture_descs[locked].header.channel_id = capture->channel_id;
+		capture_descs[locked].capture_request_req.buffer_index =
+				reqs[locked].buffer_index;
+
+		nv_camera_log_vi_submit(
+				chans[locked]->ndev,
+				capture->progress_sp.id,
+				capture->progress_sp.threshold,
+				capture->channel_id,
+				__arch_counter_get_cntvct());
+	}
+
+	err = tegra_capture_ivc_capture_submit_batch(capture_descs,
+			sizeof(*capture_descs), count);
+	if (err > 0) {
+		*submitted = (uint32_t)err;
+		err = (*submitted == count) ? 0 : -EIO;
+	}
+
+	for (i = 0U; i < locked; i++) {
+		capture = chans[i]->capture_data;
+		mutex_unlock(&capture->reset_lock);
+	}
+
+	mutex_unlock(&vi_capture_group_lock);
+
+	kfree(capture_descs);
+
+	if (err < 0)
+		pr_err("%s: IVC group submit failed after %u of %u requests\n",
+			__func__, *submitted, count);
+
+	return err;
+}
+EXPORT_SYMBOL_GPL(vi_capture_request_group);
+
 int vi_capture_status(
 	struct tegra_vi_channel *chan,
 	int32_t timeout_ms)
@@ -1520,6 +1622,55 @@ int vi_capture_set_progress_status_notifier(
 }
 EXPORT_SYMBOL_GPL(vi_capture_set_progress_status_notifier);
 
+int vi_capture_set_status_eventfd(
+	struct tegra_vi_channel *chan,
+	int32_t fd)
+{
+	struct vi_capture *capture = chan->capture_data;
+
+	if (capture == NULL) {
+		dev_err(chan->dev,
+				"%s: vi capture uninitialized\n", __func__);
+		return -ENODEV;
+	}
+
+	if (!capture->is_progress_status_notifier_set) {
+		dev_err(chan->dev,
+			"%s: progress status notifier is not set\n", __func__);
+		return -EINVAL;
+	}
+
+	return capture_common_set_progress_status_eventfd(
+			&capture->progress_status_notifier, fd);
+}
+EXPORT_SYMBOL_GPL(vi_capture_set_status_eventfd);
+
+int vi_capture_set_status_notify(
+	struct tegra_vi_channel *chan,
+	vi_capture_status_notify_fn notify,
+	void *priv)
+{
+	struct vi_capture *capture = chan->capture_data;
+
+	if (capture == NULL) {
+		dev_err(chan->dev,
+				"%s: vi capture uninitialized\n", __func__);
+		return -ENODEV;
+	}
+
+	if (capture->channel_id == CAPTURE_CHANNEL_INVALID_ID) {
+		dev_err(chan->dev,
+			"%s: setup channel first\n", __func__);
+		return -ENODEV;
+	}
+
+	capture->status_notify = notify;
+	capture->status_notify_priv = priv;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(vi_capture_set_status_notify);
+
 static int csi_vi_get_mapping_table(struct platform_device *pdev)
 {
 	uint32_t index = 0;
@@ -1741,10 +1892,13 @@ static int __init capture_vi_init(void)
 		return err;
 	}
 
+	capture_latency_init();
+
 	return 0;
 }
 static void __exit capture_vi_exit(void)
 {
+	capture_latency_exit();
 	vi_channel_drv_exit();
 	platform_driver_unregister(&capture_vi_driver);
 }
@@ -30,6 +30,22 @@ static inline u32 csi5_port_to_stream(u32 csi_port)
 		csi_port : (((csi_port - NVCSI_PORT_E) >> 1U) + NVCSI_PORT_E);
 }
 
+/* Map an NVCSI stream to the ganged VI channel capturing it */
+static int csi5_stream_vi_port(struct tegra_channel *tegra_chan, u32 stream_id)
+{
+	int i;
+
+	if (tegra_chan->valid_ports <= 1)
+		return 0;
+
+	for (i = 0; i < tegra_chan->valid_ports; i++) {
+		if (tegra_chan->port[i] == stream_id)
+			return i;
+	}
+
+	return (stream_id > 0) ? 1 : 0;
+}
+
 static int csi5_power_on(struct tegra_csi_device *csi)
 {
 	int err = 0;
@@ -154,10 +170,7 @@ static int csi5_stream_open(struct tegra_csi_channel *chan, u32 stream_id,
 	msg.phy_stream_open_req.stream_id = stream_id;
 	msg.phy_stream_open_req.csi_port = csi_port;
 
-	if (tegra_chan->valid_ports > 1)
-		vi_port = (stream_id > 0) ? 1 : 0;
-	else
-		vi_port = 0;
+	vi_port = csi5_stream_vi_port(tegra_chan, stream_id);
 
 	return csi5_send_control_message(tegra_chan->tegra_vi_channel[vi_port], &msg,
 							&msg.phy_stream_open_resp.result);
@@ -181,10 +194,7 @@ static void csi5_stream_close(struct tegra_csi_channel *chan, u32 stream_id,
 	msg.phy_stream_close_req.stream_id = stream_id;
 	msg.phy_stream_close_req.csi_port = csi_port;
 
-	if (tegra_chan->valid_ports > 1)
-		vi_port = (stream_id > 0) ? 1 : 0;
-	else
-		vi_port = 0;
+	vi_port = csi5_stream_vi_port(tegra_chan, stream_id);
 
 	err = csi5_send_control_message(tegra_chan->tegra_vi_channel[vi_port], &msg,
 							&msg.phy_stream_open_resp.result);
@@ -294,10 +304,7 @@ static int csi5_stream_set_config(struct tegra_csi_channel *chan, u32 stream_id,
 	msg.csi_stream_set_config_req.brick_config = brick_config;
 	msg.csi_stream_set_config_req.cil_config = cil_config;
 
-	if (tegra_chan->valid_ports > 1)
-		vi_port = (stream_id > 0) ? 1 : 0;
-	else
-		vi_port = 0;
+	vi_port = csi5_stream_vi_port(tegra_chan, stream_id);
 
 	return csi5_send_control_message(tegra_chan->tegra_vi_channel[vi_port], &msg,
 							&msg.csi_stream_set_config_resp.result);
@@ -5,6 +5,7 @@
  * Copyright (c) 2013-2022, NVIDIA Corporation. All Rights Reserved.
  */
 
+#include <linux/i2c.h>
 #include <linux/regmap.h>
 #include <linux/module.h>
 #include <media/camera_common.h>
@@ -165,5 +166,146 @@ regmap_util_write_table_16_as_8(struct regmap *regmap,
 }
 
 EXPORT_SYMBOL_GPL(regmap_util_write_table_16_as_8);
+
+void regmap_util_txn_begin(struct regmap_util_txn *txn,
+			   struct regmap *regmap,
+			   struct i2c_client *client,
+			   unsigned int reg_bits)
+{
+	txn->regmap = regmap;
+	txn->num_msgs = 0;
+	txn->buf_len = 0;
+
+	/*
+	 * Raw bursts are only built for byte-wide registers behind 8 or
+	 * 16 bit addresses; anything else goes through regmap on commit,
+	 * and the bursts then carry no address bytes.
+	 */
+	if (client != NULL && regmap_get_val_bytes(regmap) == 1 &&
+	    (reg_bits == 8 || reg_bits == 16)) {
+		txn->client = client;
+		txn->reg_bytes = reg_bits / 8;
+	} else {
+		txn->client = NULL;
+		txn->reg_bytes = 0;
+	}
+}
+EXPORT_SYMBOL_GPL(regmap_util_txn_begin);
+
+static u8 *regmap_util_txn_data(struct regmap_util_txn *txn,
+				unsigned int idx)
+{
+	return txn->msgs[idx].buf + txn->reg_bytes;
+}
+
+static unsigned int regmap_util_txn_data_len(struct regmap_util_txn *txn,
+					     unsigned int idx)
+{
+	return txn->msgs[idx].len - txn->reg_bytes;
+}
+
+int regmap_util_txn_write(struct regmap_util_txn *txn, unsigned int reg,
+			  const u8 *vals, unsigned int count)
+{
+	struct i2c_msg *msg;
+	unsigned int last, len;
+	u8 *buf;
+	int err;
+
+	while (count > 0) {
+		/* extend the previous burst if this register follows it */
+		if (txn->num_msgs > 0) {
+			last = txn->num_msgs - 1;
+			len = regmap_util_txn_data_len(txn, last);
+
+			if (txn->regs[last] + len == reg &&
+			    len < REGMAP_UTIL_TXN_MAX_BURST) {
+				len = min_t(unsigned int, count,
+					REGMAP_UTIL_TXN_MAX_BURST - len);
+				len = min_t(unsigned int, len,
+					REGMAP_UTIL_TXN_BUF_SIZE -
+					txn->buf_len);
+				if (len > 0) {
+					memcpy(&txn->buf[txn->buf_len], vals,
+					       len);
+					txn->buf_len += len;
+					txn->msgs[last].len += len;
+					goto next;
+				}
+			}
+		}
+
+		len = min_t(unsigned int, count, REGMAP_UTIL_TXN_MAX_BURST);
+		if (txn->num_msgs == REGMAP_UTIL_TXN_MAX_MSGS ||
+		    txn->buf_len + txn->reg_bytes + len >
+				REGMAP_UTIL_TXN_BUF_SIZE) {
+			err = regmap_util_txn_commit(txn);
+			if (err)
+				return err;
+		}
+
+		buf = &txn->buf[txn->buf_len];
+		if (txn->reg_bytes == 2)
+			*buf++ = (u8)(reg >> 8);
+		if (txn->reg_bytes > 0)
+			*buf++ = (u8)reg;
+		memcpy(buf, vals, len);
+
+		msg = &txn->msgs[txn->num_msgs];
+		msg->addr = txn->client ? txn->client->addr : 0;
+		msg->flags = txn->client ?
+				(txn->client->flags & I2C_M_TEN) : 0;
+		msg->buf = &txn->buf[txn->buf_len];
+		msg->len = txn->reg_bytes + len;
+
+		txn->regs[txn->num_msgs++] = reg;
+		txn->buf_len += txn->reg_bytes + len;
+next:
+		reg += len;
+		vals += len;
+		count -= len;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(regmap_util_txn_write);
+
+int regmap_util_txn_commit(struct regmap_util_txn *txn)
+{
+	unsigned int i;
+	int err = 0;
+
+	if (txn->num_msgs == 0)
+		return 0;
+
+	if (txn->client == NULL) {
+		for (i = 0; i < txn->num_msgs && !err; i++)
+			err = regmap_bulk_write(txn->regmap, txn->regs[i],
+					regmap_util_txn_data(txn, i),
+					regmap_util_txn_data_len(txn, i));
+	} else {
+		err = i2c_transfer(txn->client->adapter, txn->msgs,
+				   txn->num_msgs);
+		if (err == txn->num_msgs)
+			err = 0;
+		else if (err >= 0)
+			err = -EIO;
+
+		/* the bursts bypassed regmap, so forget any cached values */
+		for (i = 0; i < txn->num_msgs; i++)
+			(void)regcache_drop_region(txn->regmap, txn->regs[i],
+				txn->regs[i] +
+				regmap_util_txn_data_len(txn, i) - 1);
+	}
+
+	if (err)
+		pr_err("%s:regmap_util_txn_commit:%d", __func__, err);
+
+	txn->num_msgs = 0;
+	txn->buf_len = 0;
+
+	return err;
+}
+EXPORT_SYMBOL_GPL(regmap_util_txn_commit);
 MODULE_LICENSE("GPL");
 
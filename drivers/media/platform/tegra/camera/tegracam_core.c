@@ -4,6 +4,7 @@
  *
  * Copyright (c) 2017-2022, NVIDIA CORPORATION.  All rights reserved.
  */
+#include <linux/i2c.h>
 #include <linux/list.h>
 #include <linux/mutex.h>
 #include <linux/of.h>
@@ -20,6 +21,27 @@ static struct list_head tc_device_list_head =
 	LIST_HEAD_INIT(tc_device_list_head);
 static DEFINE_MUTEX(tc_device_list_mutex);
 
+/*
+ * Sensors are probed asynchronously; probes in the same group are
+ * serialised, those in different groups run in parallel. The group is
+ * nvidia,probe-group of the sensor node if present, else the root I2C
+ * bus of the sensor, which covers a deserializer and its sensors.
+ */
+#define TEGRACAM_PROBE_GROUPS		16
+#define TEGRACAM_PROBE_GROUP_DT		(1ULL << 63)
+
+struct tegracam_probe_group {
+	u64 key;
+	bool used;
+	struct mutex lock;
+};
+
+static struct tegracam_probe_group tc_probe_groups[TEGRACAM_PROBE_GROUPS];
+static struct tegracam_probe_group tc_probe_group_default = {
+	.lock = __MUTEX_INITIALIZER(tc_probe_group_default.lock),
+};
+static DEFINE_MUTEX(tc_probe_groups_mutex);
+
 /* use semantic versioning convention */
 #define TEGRACAM_MAJOR_VERSION 2
 #define TEGRACAM_MINOR_VERSION 0
@@ -54,6 +76,88 @@ u32 tegracam_query_version(const char *of_dev_name)
 }
 EXPORT_SYMBOL_GPL(tegracam_query_version);
 
+int tegracam_call_device(const char *of_dev_name,
+		int (*fn)(struct tegracam_device *tc_dev, void *data),
+		void *data)
+{
+	struct tegracam_device_entry *entry = NULL;
+	struct device_node *node;
+	int err = -ENODEV;
+
+	if (of_dev_name == NULL || fn == NULL)
+		return -EINVAL;
+
+	/* holding the list lock keeps the device from being unregistered */
+	mutex_lock(&tc_device_list_mutex);
+	list_for_each_entry(entry, &tc_device_list_head, list) {
+		node = entry->tc_dev->dev->of_node;
+		if (strcmp(of_dev_name, node->name) == 0) {
+			err = fn(entry->tc_dev, data);
+			break;
+		}
+	}
+	mutex_unlock(&tc_device_list_mutex);
+
+	return err;
+}
+EXPORT_SYMBOL_GPL(tegracam_call_device);
+
+static u64 tegracam_probe_group_key(struct i2c_client *client)
+{
+	struct i2c_adapter *root = client->adapter;
+	struct i2c_adapter *parent;
+	u32 group;
+
+	if (client->dev.of_node &&
+	    !of_property_read_u32(client->dev.of_node, "nvidia,probe-group",
+				  &group))
+		return TEGRACAM_PROBE_GROUP_DT | group;
+
+	while ((parent = i2c_parent_is_i2c_adapter(root)) != NULL)
+		root = parent;
+
+	return (u64)root->nr;
+}
+
+struct tegracam_probe_group *tegracam_probe_group_lock(
+		struct i2c_client *client)
+{
+	struct tegracam_probe_group *group = NULL;
+	u64 key = tegracam_probe_group_key(client);
+	int i;
+
+	mutex_lock(&tc_probe_groups_mutex);
+	for (i = 0; i < TEGRACAM_PROBE_GROUPS; i++) {
+		if (tc_probe_groups[i].used && tc_probe_groups[i].key == key) {
+			group = &tc_probe_groups[i];
+			break;
+		}
+		if (!tc_probe_groups[i].used && group == NULL)
+			group = &tc_probe_groups[i];
+	}
+
+	if (group == NULL) {
+		/* out of groups, fall back to serial probing */
+		group = &tc_probe_group_default;
+	} else if (!group->used) {
+		mutex_init(&group->lock);
+		group->key = key;
+		group->used = true;
+	}
+	mutex_unlock(&tc_probe_groups_mutex);
+
+	mutex_lock(&group->lock);
+
+	return group;
+}
+EXPORT_SYMBOL_GPL(tegracam_probe_group_lock);
+
+void tegracam_probe_group_unlock(struct tegracam_probe_group *group)
+{
+	mutex_unlock(&group->lock);
+}
+EXPORT_SYMBOL_GPL(tegracam_probe_group_unlock);
+
 struct tegracam_device *to_tegracam_device(struct camera_common_data *data)
 {
 	/* fix this by moving subdev to base struct */
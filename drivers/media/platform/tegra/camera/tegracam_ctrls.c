@@ -361,7 +361,6 @@ static int tegracam_set_grouphold_ex(struct tegracam_device *tc_dev,
 				bool status)
 {
 	const struct tegracam_ctrl_ops *ops = tc_dev->tcctrl_ops;
-	struct camera_common_data *s_data = tc_dev->s_data;
 	int err = 0;
 
 	/*
@@ -383,7 +382,7 @@ static int tegracam_set_grouphold_ex(struct tegracam_device *tc_dev,
 
 		/* TODO: block this write selectively from VI5 */
 		if (tc_dev->is_streaming) {
-			err = write_sensor_blob(s_data->regmap, blob);
+			err = tegracam_write_sensor_blob(tc_dev, blob);
 			if (err)
 				return err;
 		}
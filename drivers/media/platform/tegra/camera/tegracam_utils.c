@@ -212,6 +212,59 @@ int write_sensor_blob(struct regmap *regmap, struct sensor_blob *blob)
 }
 EXPORT_SYMBOL_GPL(write_sensor_blob);
 
+/*
+ * Same as write_sensor_blob(), but the writes between two sleep commands
+ * are coalesced into one regmap_util transaction: adjacent registers go
+ * out as a single auto-increment burst and all bursts share one
+ * i2c_transfer(), instead of one transfer per register.
+ */
+int tegracam_write_sensor_blob(struct tegracam_device *tc_dev,
+			       struct sensor_blob *blob)
+{
+	const struct regmap_config *config = tc_dev->dev_regmap_config;
+	struct regmap_util_txn txn;
+	int err = 0;
+	int cmd_idx = 0;
+	int buf_index = 0;
+
+	regmap_util_txn_begin(&txn, tc_dev->s_data->regmap, tc_dev->client,
+			config ? config->reg_bits : 0);
+
+	while (cmd_idx < blob->num_cmds) {
+		struct sensor_cmd *cmd = &blob->cmds[cmd_idx++];
+		u32 val;
+
+		val = cmd->opcode;
+		if ((val >> 24) == SENSOR_OPCODE_DONE)
+			break;
+
+		if ((val >> 24) == SENSOR_OPCODE_SLEEP) {
+			err = regmap_util_txn_commit(&txn);
+			if (err)
+				return err;
+			val = val & 0x00FFFFFF;
+			usleep_range(val, val + 10);
+			continue;
+		}
+
+		if ((val >> 24) == SENSOR_OPCODE_WRITE) {
+			int size = val & 0x00FFFFFF;
+
+			err = regmap_util_txn_write(&txn, cmd->addr,
+					&blob->buf[buf_index], size);
+			if (err)
+				return err;
+			buf_index += size;
+		} else {
+			pr_err("blob has been packaged with errors\n");
+			return -EINVAL;
+		}
+	}
+
+	return regmap_util_txn_commit(&txn);
+}
+EXPORT_SYMBOL_GPL(tegracam_write_sensor_blob);
+
 int tegracam_write_blobs(struct tegracam_ctrl_handler *hdl)
 {
 	struct camera_common_data *s_data = hdl->tc_dev->s_data;
@@ -231,14 +284,14 @@ int tegracam_write_blobs(struct tegracam_ctrl_handler *hdl)
 	 * and stop streaming cases
 	 */
 	if (mode_blob->num_cmds) {
-		err = write_sensor_blob(s_data->regmap, mode_blob);
+		err = tegracam_write_sensor_blob(hdl->tc_dev, mode_blob);
 		if (err) {
 			dev_err(s_data->dev, "Error writing mode blob\n");
 			return err;
 		}
 	}
 
-	err = write_sensor_blob(s_data->regmap, ctrl_blob);
+	err = tegracam_write_sensor_blob(hdl->tc_dev, ctrl_blob);
 	if (err) {
 		dev_err(s_data->dev, "Error writing control blob\n");
 		return err;
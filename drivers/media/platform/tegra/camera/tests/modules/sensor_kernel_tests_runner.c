@@ -36,6 +36,21 @@ static struct skt_test skt_available_tests[] = {
 		.description = "Asserts compliance of sensor DT",
 		.run = sensor_verify_dt,
 	},
+	{
+		.name = "Sensor Stream Perf",
+		.description = "Measures stream start and stop latency",
+		.run = sensor_perf_stream,
+	},
+	{
+		.name = "Sensor Mode Switch Perf",
+		.description = "Measures set_fmt and stream on latency per mode",
+		.run = sensor_perf_mode_switch,
+	},
+	{
+		.name = "Sensor Control Perf",
+		.description = "Measures exposure and gain control latency",
+		.run = sensor_perf_ctrls,
+	},
 };
 
 int skt_runner_num_tests(void)
@@ -0,0 +1,328 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * sensor_perf_test - sensor streaming, mode switch and control latency
+ *
+ * Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ *
+ */
+
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/of.h>
+#include <media/tegra-v4l2-camera.h>
+#include <media/v4l2-ctrls.h>
+#include <media/v4l2-subdev.h>
+
+#include "media/tegracam_core.h"
+#include "media/tegracam_utils.h"
+#include "tegracam_tests.h"
+#include "utils/tegracam_log.h"
+
+#define SP_STREAM_ITERATIONS          (8U)
+#define SP_CTRL_ITERATIONS            (32U)
+
+/**
+ * sp_stat - latency samples of one operation
+ *
+ * @min: fastest sample in ns
+ * @max: slowest sample in ns
+ * @sum: sum of the samples in ns
+ * @n:   number of samples
+ */
+struct sp_stat {
+	u64 min;
+	u64 max;
+	u64 sum;
+	u32 n;
+};
+
+static void sp_stat_add(struct sp_stat *stat, const u64 start)
+{
+	u64 ns = ktime_get_ns() - start;
+
+	if (stat->n == 0 || ns < stat->min)
+		stat->min = ns;
+	if (ns > stat->max)
+		stat->max = ns;
+	stat->sum += ns;
+	stat->n++;
+}
+
+static void sp_stat_log(const char *name, const struct sp_stat *stat)
+{
+	if (stat->n == 0) {
+		camtest_log("%-24s no samples\n", name);
+		return;
+	}
+
+	camtest_log("%-24s n %3u min %8llu avg %8llu max %8llu us\n",
+			name, stat->n, div_u64(stat->min, NSEC_PER_USEC),
+			div_u64(div_u64(stat->sum, stat->n), NSEC_PER_USEC),
+			div_u64(stat->max, NSEC_PER_USEC));
+}
+
+static inline struct v4l2_subdev *sp_subdev(struct tegracam_device *tc_dev)
+{
+	return &tc_dev->s_data->subdev;
+}
+
+/*
+ * The tests drive the sensor subdev directly, so they refuse to run
+ * while a capture client holds the sensor powered or streaming.
+ */
+static int sp_power_on(struct tegracam_device *tc_dev)
+{
+	struct camera_common_power_rail *pw = tc_dev->s_data->power;
+	int err;
+
+	if (tc_dev->is_streaming || (pw != NULL && pw->state == SWITCH_ON)) {
+		camtest_log("Sensor %s is in use, stop capture first\n",
+				tc_dev->name);
+		return -EBUSY;
+	}
+
+	err = v4l2_subdev_call(sp_subdev(tc_dev), core, s_power, 1);
+	if (err != 0)
+		camtest_log("Sensor %s power on failed (%d)\n",
+				tc_dev->name, err);
+
+	return err;
+}
+
+static void sp_power_off(struct tegracam_device *tc_dev)
+{
+	v4l2_subdev_call(sp_subdev(tc_dev), core, s_power, 0);
+}
+
+static int sp_stream(struct tegracam_device *tc_dev, const int enable,
+		struct sp_stat *stat)
+{
+	u64 start = ktime_get_ns();
+	int err;
+
+	err = v4l2_subdev_call(sp_subdev(tc_dev), video, s_stream, enable);
+	if (err != 0) {
+		camtest_log("Stream %s failed (%d)\n",
+				enable ? "on" : "off", err);
+		return err;
+	}
+
+	if (stat != NULL)
+		sp_stat_add(stat, start);
+
+	return 0;
+}
+
+static int sp_set_fmt(struct tegracam_device *tc_dev,
+		struct v4l2_subdev_format *fmt)
+{
+	struct v4l2_subdev_pad_config pad_cfg;
+	struct v4l2_subdev_state cfg = {.pads = &pad_cfg};
+
+	fmt->which = V4L2_SUBDEV_FORMAT_ACTIVE;
+	fmt->pad = 0;
+
+	return v4l2_subdev_call(sp_subdev(tc_dev), pad, set_fmt, &cfg, fmt);
+}
+
+static int sp_get_fmt(struct tegracam_device *tc_dev,
+		struct v4l2_subdev_format *fmt)
+{
+	struct v4l2_subdev_pad_config pad_cfg;
+	struct v4l2_subdev_state cfg = {.pads = &pad_cfg};
+
+	fmt->which = V4L2_SUBDEV_FORMAT_ACTIVE;
+	fmt->pad = 0;
+
+	return v4l2_subdev_call(sp_subdev(tc_dev), pad, get_fmt, &cfg, fmt);
+}
+
+static int sp_stream_test(struct tegracam_device *tc_dev, void *data)
+{
+	struct sp_stat start = {0};
+	struct sp_stat stop = {0};
+	int err;
+	u32 i;
+
+	err = sp_power_on(tc_dev);
+	if (err != 0)
+		return err;
+
+	for (i = 0; i < SP_STREAM_ITERATIONS; i++) {
+		err = sp_stream(tc_dev, 1, &start);
+		if (err != 0)
+			break;
+
+		err = sp_stream(tc_dev, 0, &stop);
+		if (err != 0)
+			break;
+	}
+
+	sp_power_off(tc_dev);
+
+	sp_stat_log("stream start", &start);
+	sp_stat_log("stream stop", &stop);
+
+	return err;
+}
+
+static int sp_mode_switch_test(struct tegracam_device *tc_dev, void *data)
+{
+	struct camera_common_data *s_data = tc_dev->s_data;
+	struct v4l2_subdev_format def_fmt = {0};
+	struct v4l2_subdev_format fmt;
+	struct sp_stat set_fmt;
+	struct sp_stat stream_on;
+	char name[32];
+	u64 start;
+	int err;
+	int i;
+
+	err = sp_get_fmt(tc_dev, &def_fmt);
+	if (err != 0) {
+		camtest_log("Could not get sensor format (%d)\n", err);
+		return err;
+	}
+
+	err = sp_power_on(tc_dev);
+	if (err != 0)
+		return err;
+
+	/*
+	 * The mode is written to the sensor at stream on, so a switch is
+	 * measured as set_fmt plus the following stream on.
+	 */
+	for (i = 0; i < s_data->numfmts; i++) {
+		memset(&set_fmt, 0, sizeof(set_fmt));
+		memset(&stream_on, 0, sizeof(stream_on));
+
+		fmt = def_fmt;
+		fmt.format.width = s_data->frmfmt[i].size.width;
+		fmt.format.height = s_data->frmfmt[i].size.height;
+
+		start = ktime_get_ns();
+		err = sp_set_fmt(tc_dev, &fmt);
+		if (err != 0) {
+			camtest_log("Mode %d set_fmt failed (%d)\n", i, err);
+			break;
+		}
+		sp_stat_add(&set_fmt, start);
+
+		err = sp_stream(tc_dev, 1, &stream_on);
+		if (err != 0)
+			break;
+
+		err = sp_stream(tc_dev, 0, NULL);
+		if (err != 0)
+			break;
+
+		snprintf(name, sizeof(name), "mode %d %ux%u set_fmt",
+				i, fmt.format.width, fmt.format.height);
+		sp_stat_log(name, &set_fmt);
+		snprintf(name, sizeof(name), "mode %d %ux%u stream on",
+				i, fmt.format.width, fmt.format.height);
+		sp_stat_log(name, &stream_on);
+	}
+
+	sp_power_off(tc_dev);
+
+	/* restore the format the sensor was left in */
+	if (sp_set_fmt(tc_dev, &def_fmt) != 0)
+		camtest_log("Could not restore sensor format\n");
+
+	return err;
+}
+
+static int sp_ctrl_test_one(struct tegracam_device *tc_dev, const u32 cid,
+		const char *name)
+{
+	struct v4l2_ctrl_handler *hdl =
+		&tc_dev->s_data->tegracam_ctrl_hdl->ctrl_handler;
+	struct sp_stat stat = {0};
+	struct v4l2_ctrl *ctrl;
+	s64 def;
+	u64 start;
+	int err = 0;
+	u32 i;
+
+	ctrl = v4l2_ctrl_find(hdl, cid);
+	if (ctrl == NULL) {
+		camtest_log("%-24s not supported\n", name);
+		return 0;
+	}
+
+	def = v4l2_ctrl_g_ctrl_int64(ctrl);
+
+	/* alternate between the range ends so that every write reaches hw */
+	for (i = 0; i < SP_CTRL_ITERATIONS; i++) {
+		start = ktime_get_ns();
+		err = v4l2_ctrl_s_ctrl_int64(ctrl,
+				(i & 1U) ? ctrl->minimum : ctrl->maximum);
+		if (err != 0) {
+			camtest_log("%s write failed (%d)\n", name, err);
+			break;
+		}
+		sp_stat_add(&stat, start);
+	}
+
+	v4l2_ctrl_s_ctrl_int64(ctrl, def);
+	sp_stat_log(name, &stat);
+
+	return err;
+}
+
+static int sp_ctrl_test(struct tegracam_device *tc_dev, void *data)
+{
+	int err;
+
+	err = sp_power_on(tc_dev);
+	if (err != 0)
+		return err;
+
+	err = sp_stream(tc_dev, 1, NULL);
+	if (err != 0)
+		goto power_off;
+
+	err = sp_ctrl_test_one(tc_dev, TEGRA_CAMERA_CID_EXPOSURE, "exposure");
+	if (err == 0)
+		err = sp_ctrl_test_one(tc_dev, TEGRA_CAMERA_CID_GAIN, "gain");
+
+	if (sp_stream(tc_dev, 0, NULL) != 0)
+		err = -EIO;
+
+power_off:
+	sp_power_off(tc_dev);
+
+	return err;
+}
+
+static int sp_run(struct device_node *node,
+		int (*test)(struct tegracam_device *tc_dev, void *data))
+{
+	int err;
+
+	if (node == NULL)
+		return -EINVAL;
+
+	err = tegracam_call_device(node->name, test, NULL);
+	if (err == -ENODEV)
+		camtest_log("Sensor %s not registered with TVCF\n", node->name);
+
+	return err;
+}
+
+int sensor_perf_stream(struct device_node *node, const u32 tvcf_version)
+{
+	return sp_run(node, sp_stream_test);
+}
+
+int sensor_perf_mode_switch(struct device_node *node, const u32 tvcf_version)
+{
+	return sp_run(node, sp_mode_switch_test);
+}
+
+int sensor_perf_ctrls(struct device_node *node, const u32 tvcf_version)
+{
+	return sp_run(node, sp_ctrl_test);
+}
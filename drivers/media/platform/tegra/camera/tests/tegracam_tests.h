@@ -13,4 +13,11 @@
  */
 int sensor_verify_dt(struct device_node *node, const u32 tvcf_version);
 
+/*
+ * Tegra Camera Kernel Performance Tests
+ */
+int sensor_perf_stream(struct device_node *node, const u32 tvcf_version);
+int sensor_perf_mode_switch(struct device_node *node, const u32 tvcf_version);
+int sensor_perf_ctrls(struct device_node *node, const u32 tvcf_version);
+
 #endif // __TEGRACAM_TESTS_H__
@@ -64,9 +64,15 @@ static bool tegra_channel_verify_focuser(struct tegra_channel *chan)
 	return (focuser != NULL);
 }
 
+/*
+ * Each ganged port writes one tile of the stitched surface: tiles sit
+ * side by side for L_R/R_L and stacked for T_B/B_T, and the R_L/B_T
+ * layouts place the tiles in reverse port order.
+ */
 static void gang_buffer_offsets(struct tegra_channel *chan)
 {
 	int i;
+	unsigned int tile;
 	u32 offset = 0;
 
 	for (i = 0; i < chan->total_ports; i++) {
@@ -78,44 +84,59 @@ static void gang_buffer_offsets(struct tegra_channel *chan)
 			break;
 		case CAMERA_GANG_T_B:
 		case CAMERA_GANG_B_T:
-			offset = chan->gang_sizeimage;
+			offset = chan->format.bytesperline * chan->gang_height;
 			break;
 		default:
 			offset = 0;
 		}
 		offset = ((offset + TEGRA_SURFACE_ALIGNMENT - 1) &
 					~(TEGRA_SURFACE_ALIGNMENT - 1));
-		chan->buffer_offset[i] = i * offset;
+
+		tile = i;
+		if (((chan->gang_mode == CAMERA_GANG_R_L) ||
+			(chan->gang_mode == CAMERA_GANG_B_T)) &&
+			(i < chan->valid_ports))
+			tile = chan->valid_ports - 1 - i;
+		chan->buffer_offset[i] = tile * offset;
 	}
 	spec_bar();
 }
 
 static u32 gang_mode_width(enum camera_gang_mode gang_mode,
-					unsigned int width)
+					unsigned int width, unsigned int ports)
 {
 	if ((gang_mode == CAMERA_GANG_L_R) ||
 		(gang_mode == CAMERA_GANG_R_L))
-		return width >> 1;
+		return width / ports;
 	else
 		return width;
 }
 
 static u32 gang_mode_height(enum camera_gang_mode gang_mode,
-					unsigned int height)
+					unsigned int height, unsigned int ports)
 {
 	if ((gang_mode == CAMERA_GANG_T_B) ||
 		(gang_mode == CAMERA_GANG_B_T))
-		return height >> 1;
+		return height / ports;
 	else
 		return height;
 }
 
 static void update_gang_mode_params(struct tegra_channel *chan)
 {
+	unsigned int ports = max(chan->valid_ports, 1U);
+
 	chan->gang_width = gang_mode_width(chan->gang_mode,
-						chan->format.width);
+						chan->format.width, ports);
 	chan->gang_height = gang_mode_height(chan->gang_mode,
-						chan->format.height);
+						chan->format.height, ports);
+	if ((chan->gang_width != chan->format.width &&
+		chan->gang_width * ports != chan->format.width) ||
+		(chan->gang_height != chan->format.height &&
+		chan->gang_height * ports != chan->format.height))
+		dev_warn(chan->vi->dev,
+			"%ux%u does not split evenly across %u ganged ports\n",
+			chan->format.width, chan->format.height, ports);
 	chan->gang_bytesperline = ((chan->gang_width *
 					chan->fmtinfo->bpp.numerator) /
 					chan->fmtinfo->bpp.denominator);
@@ -130,13 +151,14 @@ static void update_gang_mode(struct tegra_channel *chan)
 	int height = chan->format.height;
 
 	/*
-	 * At present only 720p, 1080p and 4k resolutions
-	 * are supported and only 4K requires gang mode
-	 * Update this code with CID for future extensions
-	 * Also, validate width and height of images based
-	 * on gang mode and surface stride alignment
+	 * A layout requested through TEGRA_CAMERA_CID_VI_GANG_MODE gangs
+	 * all ports of the channel into one stitched surface. Otherwise
+	 * only 4K requires gang mode, split left/right across the ports.
 	 */
-	if ((width > 1920) && (height > 1080)) {
+	if (chan->requested_gang_mode != CAMERA_NO_GANG_MODE) {
+		chan->gang_mode = chan->requested_gang_mode;
+		chan->valid_ports = chan->total_ports;
+	} else if ((width > 1920) && (height > 1080)) {
 		chan->gang_mode = CAMERA_GANG_L_R;
 		chan->valid_ports = chan->total_ports;
 	} else {
@@ -421,16 +443,26 @@ EXPORT_SYMBOL(release_buffer);
 /*
  * `buf` has been successfully setup to receive a frame and is
  * "in flight" through the VI hardware. We are currently waiting
- * on it to be filled. Moves the pointer into the `release` list
+ * on it to be filled. Publishes the pointer in the inflight ring
  * for the release thread to wait on.
+ *
+ * The inflight ring has a single producer (the capture thread) and a
+ * single consumer (the release thread). Each side advances only its
+ * own capture sequence counter and publishes it with release semantics,
+ * so neither side takes a lock. A vb2 buffer is in flight at most once
+ * and the ring has one slot per vb2 buffer, so it cannot overflow.
  */
 void enqueue_inflight(struct tegra_channel *chan,
 			struct tegra_channel_buffer *buf)
 {
-	/* Put buffer into the release queue */
-	spin_lock(&chan->release_lock);
-	list_add_tail(&buf->queue, &chan->release);
-	spin_unlock(&chan->release_lock);
+	u32 head = chan->inflight_head;
+	u32 tail = smp_load_acquire(&chan->inflight_tail);
+
+	if (WARN_ON_ONCE(head - tail >= chan->capture_queue_depth))
+		return;
+
+	chan->inflight[head % chan->capture_queue_depth] = buf;
+	smp_store_release(&chan->inflight_head, head + 1);
 
 	/* Wake up kthread for release */
 	wake_up_interruptible(&chan->release_wait);
@@ -439,25 +471,27 @@ EXPORT_SYMBOL(enqueue_inflight);
 
 struct tegra_channel_buffer *dequeue_inflight(struct tegra_channel *chan)
 {
-	struct tegra_channel_buffer *buf = NULL;
+	struct tegra_channel_buffer *buf;
+	u32 tail = chan->inflight_tail;
+	u32 head = smp_load_acquire(&chan->inflight_head);
 
-	spin_lock(&chan->release_lock);
-	if (list_empty(&chan->release)) {
-		spin_unlock(&chan->release_lock);
+	if (head == tail)
 		return NULL;
-	}
-
-	buf = list_entry(chan->release.next,
-			 struct tegra_channel_buffer, queue);
 
-	if (buf)
-		list_del_init(&buf->queue);
+	buf = chan->inflight[tail % chan->capture_queue_depth];
+	smp_store_release(&chan->inflight_tail, tail + 1);
 
-	spin_unlock(&chan->release_lock);
 	return buf;
 }
 EXPORT_SYMBOL(dequeue_inflight);
 
+bool tegra_channel_has_inflight(struct tegra_channel *chan)
+{
+	return smp_load_acquire(&chan->inflight_head) !=
+		READ_ONCE(chan->inflight_tail);
+}
+EXPORT_SYMBOL(tegra_channel_has_inflight);
+
 void tegra_channel_init_ring_buffer(struct tegra_channel *chan)
 {
 	chan->released_bufs = 0;
@@ -653,6 +687,10 @@ int tegra_channel_error_recover(struct tegra_channel *chan, bool queue_error)
 
 	dev_warn(vi->dev, "err_rec: attempting to reset the capture channel\n");
 
+	/* the cached deskew may be stale, recalibrate on the next start */
+	if (chan->deskew_ctx && chan->deskew_ctx->deskew_lanes)
+		nvcsi_deskew_invalidate(chan->deskew_ctx->deskew_lanes);
+
 	err = vi->fops->vi_error_recover(chan, queue_error);
 	if (!err)
 		dev_warn(vi->dev,
@@ -718,7 +756,15 @@ int tegra_channel_alloc_buffer_queue(struct tegra_channel *chan,
 	if (!chan->buffers)
 		goto alloc_error;
 
+	chan->inflight = devm_krealloc(vi_unit_dev, chan->inflight,
+		(num_buffers * sizeof(*chan->inflight)),
+		GFP_KERNEL | __GFP_ZERO);
+	if (!chan->inflight)
+		goto alloc_error;
+
 	chan->capture_queue_depth = num_buffers;
+	chan->inflight_head = 0;
+	chan->inflight_tail = 0;
 
 	return 0;
 
@@ -741,6 +787,8 @@ void tegra_channel_dealloc_buffer_queue(struct tegra_channel *chan)
 		devm_kfree(vi_unit_dev, chan->buffer_state);
 	if (chan->buffers)
 		devm_kfree(vi_unit_dev, chan->buffers);
+	if (chan->inflight)
+		devm_kfree(vi_unit_dev, chan->inflight);
 }
 
 static int tegra_channel_buffer_prepare(struct vb2_buffer *vb)
@@ -783,6 +831,9 @@ static void tegra_channel_buffer_queue(struct vb2_buffer *vb)
 
 	/* Wake up kthread for capture */
 	wake_up_interruptible(&chan->start_wait);
+
+	if (chan->vi->fops && chan->vi->fops->vi_buffer_queued)
+		chan->vi->fops->vi_buffer_queued(chan);
 }
 
 
@@ -815,9 +866,7 @@ static void tegra_channel_queued_buf_done_multi_thread(
 {
 	struct tegra_channel_buffer *buf, *nbuf;
 	spinlock_t *lock = &chan->start_lock;
-	spinlock_t *release_lock = &chan->release_lock;
 	struct list_head *q = &chan->capture;
-	struct list_head *rel_q = &chan->release;
 
 	spin_lock(lock);
 	list_for_each_entry_safe(buf, nbuf, q, queue) {
@@ -826,13 +875,12 @@ static void tegra_channel_queued_buf_done_multi_thread(
 	}
 	spin_unlock(lock);
 
-	/* delete release list */
-	spin_lock(release_lock);
-	list_for_each_entry_safe(buf, nbuf, rel_q, queue) {
+	/*
+	 * Drain the inflight ring; the release thread has been stopped, so
+	 * this is its only consumer and no channel lock is needed.
+	 */
+	while ((buf = dequeue_inflight(chan)) != NULL)
 		vb2_buffer_done(&buf->buf.vb2_buf, state);
-		list_del(&buf->queue);
-	}
-	spin_unlock(release_lock);
 }
 
 /* Return all queued buffers back to videobuf2 */
@@ -1313,6 +1361,15 @@ int tegra_channel_s_ctrl(struct v4l2_ctrl *ctrl)
 	case TEGRA_CAMERA_CID_LOW_LATENCY:
 		chan->low_latency = ctrl->val;
 		break;
+	case TEGRA_CAMERA_CID_VI_GANG_MODE:
+		if (vb2_is_busy(&chan->queue)) {
+			err = -EBUSY;
+			break;
+		}
+		chan->requested_gang_mode = ctrl->val;
+		if (chan->total_ports > 1)
+			update_gang_mode(chan);
+		break;
 	case TEGRA_CAMERA_CID_VI_PREFERRED_STRIDE:
 		chan->preferred_stride = ctrl->val;
 		tegra_channel_update_format(chan, chan->format.width,
@@ -1486,6 +1543,16 @@ static const struct v4l2_ctrl_config common_custom_ctrls[] = {
 		.step = 1,
 		.def = 0,
 	},
+	{
+		.ops = &channel_ctrl_ops,
+		.id = TEGRA_CAMERA_CID_VI_GANG_MODE,
+		.name = "Gang Mode",
+		.type = V4L2_CTRL_TYPE_INTEGER,
+		.min = CAMERA_NO_GANG_MODE,
+		.max = CAMERA_GANG_B_T,
+		.step = 1,
+		.def = CAMERA_NO_GANG_MODE,
+	},
 };
 
 #define GET_TEGRA_CAMERA_CTRL(id, c)					\
@@ -2443,6 +2510,7 @@ static int tegra_channel_csi_init(struct tegra_channel *chan)
 	int ret = 0;
 
 	chan->gang_mode = CAMERA_NO_GANG_MODE;
+	chan->requested_gang_mode = CAMERA_NO_GANG_MODE;
 	chan->total_ports = 0;
 	memset(&chan->port[0], INVALID_CSI_PORT, TEGRA_CSI_BLOCKS);
 	memset(&chan->syncpoint_fifo[0], 0, sizeof(chan->syncpoint_fifo));
@@ -2566,18 +2634,17 @@ int tegra_channel_init(struct tegra_channel *chan)
 	chan->capture_descr_index = 0;
 	chan->capture_descr_sequence = 0;
 	INIT_LIST_HEAD(&chan->capture);
-	INIT_LIST_HEAD(&chan->release);
 	INIT_LIST_HEAD(&chan->entities);
 	init_waitqueue_head(&chan->start_wait);
 	init_waitqueue_head(&chan->release_wait);
 	atomic_set(&chan->restart_version, 1);
 	chan->capture_version = 0;
 	spin_lock_init(&chan->start_lock);
-	spin_lock_init(&chan->release_lock);
 	INIT_LIST_HEAD(&chan->dequeue);
 	init_waitqueue_head(&chan->dequeue_wait);
 	spin_lock_init(&chan->dequeue_lock);
 	mutex_init(&chan->stop_kthread_lock);
+	mutex_init(&chan->capture_event_lock);
 	init_rwsem(&chan->reset_lock);
 	atomic_set(&chan->is_streaming, DISABLE);
 	spin_lock_init(&chan->capture_state_lock);
@@ -35,6 +35,12 @@
 
 #define CAPTURE_TIMEOUT_MS	2500
 
+static bool event_driven_capture = true;
+module_param(event_driven_capture, bool, 0644);
+MODULE_PARM_DESC(event_driven_capture,
+	"Complete and requeue capture buffers from the RCE status callback "
+	"instead of per-channel kthreads (single-port channels only)");
+
 static const struct vi_capture_setup default_setup = {
 	.channel_flags = 0
 	| CAPTURE_CHANNEL_FLAG_VIDEO
@@ -377,7 +383,8 @@ static void vi5_setup_surface(struct tegra_channel *chan,
 	if (chan->valid_ports > NVCSI_STREAM_1) {
 		height = chan->gang_height;
 		width = chan->gang_width;
-		offset = buf->addr + chan->buffer_offset[1 - vi_port];
+		offset = buf->addr +
+			chan->buffer_offset[chan->valid_ports - 1 - vi_port];
 	}
 
 	memcpy(desc, &capture_template, sizeof(capture_template));
@@ -449,9 +456,7 @@ static void vi5_capture_enqueue(struct tegra_channel *chan,
 	unsigned int vi_port;
 	unsigned long flags;
 	struct tegra_mc_vi *vi = chan->vi;
-	struct vi_capture_req request[2] = {{
-		.buffer_index = 0,
-	}, {
+	struct vi_capture_req request[TEGRA_CSI_BLOCKS] = {{
 		.buffer_index = 0,
 	}};
 
@@ -500,7 +505,7 @@ static inline int32_t vi5_capture_timeout(struct tegra_channel *chan)
 }
 
 static void vi5_capture_dequeue(struct tegra_channel *chan,
-	struct tegra_channel_buffer *buf)
+	struct tegra_channel_buffer *buf, bool status_ready)
 {
 	int err = 0;
 	bool frame_err = false;
@@ -512,6 +517,7 @@ static void vi5_capture_dequeue(struct tegra_channel *chan,
 	struct timespec64 ts;
 	struct capture_descriptor *descr = NULL;
 	const int32_t capture_timeout = vi5_capture_timeout(chan);
+	uint64_t status_ns = 0;
 
 	for (vi_port = 0; vi_port < chan->valid_ports; vi_port++) {
 		descr = &chan->request[vi_port][buf->capture_descr_index[vi_port]];
@@ -520,7 +526,11 @@ static void vi5_capture_dequeue(struct tegra_channel *chan,
 			goto rel_buf;
 
 		/* Dequeue a frame and check its capture status */
-		err = vi_capture_status(chan->tegra_vi_channel[vi_port], capture_timeout);
+		if (!status_ready)
+			err = vi_capture_status(chan->tegra_vi_channel[vi_port],
+					capture_timeout);
+		if (!vi_port)
+			status_ns = capture_latency_now();
 		if (err) {
 			if (err == -ETIMEDOUT) {
 				dev_err(vi->dev,
@@ -585,8 +595,17 @@ uncorr_err:
 
 rel_buf:
 	vi5_release_buffer(chan, buf);
+
+	if (buf->vb2_state == VB2_BUF_STATE_DONE)
+		capture_latency_vi_frame(chan->vi_channel_id[0],
+			vb->sequence, descr->status.sof_timestamp,
+			descr->status.eof_timestamp, status_ns,
+			capture_latency_now());
 }
 
+static void vi5_capture_event_fill(struct tegra_channel *chan);
+static void vi5_capture_status_notify(void *priv, uint32_t buffer_index);
+
 static int vi5_channel_error_recover(struct tegra_channel *chan,
 	bool queue_error)
 {
@@ -622,7 +641,7 @@ static int vi5_channel_error_recover(struct tegra_channel *chan,
 		if (!buf)
 			break;
 		buf->vb2_state = VB2_BUF_STATE_ERROR;
-		vi5_capture_dequeue(chan, buf);
+		vi5_capture_dequeue(chan, buf, false);
 	}
 
 	/* report queue error to application */
@@ -662,15 +681,37 @@ static int vi5_channel_error_recover(struct tegra_channel *chan,
 	/* clear capture channel error state */
 	chan->capture_state = CAPTURE_IDLE;
 
+	/* event-driven mode: the caller holds capture_event_lock */
+	if (chan->capture_event_mode) {
+		err = vi_capture_set_status_notify(chan->tegra_vi_channel[0],
+				vi5_capture_status_notify, chan);
+		if (err < 0)
+			goto done;
+		vi5_capture_event_fill(chan);
+	}
+
 done:
 	return err;
 }
 
+static bool vi5_capture_can_enqueue(struct tegra_channel *chan)
+{
+	unsigned long flags;
+	bool ret;
+
+	spin_lock_irqsave(&chan->capture_state_lock, flags);
+	ret = (chan->capture_state != CAPTURE_ERROR)
+		&& (chan->capture_reqs_enqueued
+			< (chan->capture_queue_depth * chan->valid_ports));
+	spin_unlock_irqrestore(&chan->capture_state_lock, flags);
+
+	return ret;
+}
+
 static int tegra_channel_kthread_capture_enqueue(void *data)
 {
 	struct tegra_channel *chan = data;
 	struct tegra_channel_buffer *buf;
-	unsigned long flags;
 	set_freezable();
 
 	while (1) {
@@ -680,16 +721,8 @@ static int tegra_channel_kthread_capture_enqueue(void *data)
 			(kthread_should_stop() || !list_empty(&chan->capture)));
 
 		while (!(kthread_should_stop() || list_empty(&chan->capture))) {
-			spin_lock_irqsave(&chan->capture_state_lock, flags);
-			if ((chan->capture_state == CAPTURE_ERROR)
-					|| !(chan->capture_reqs_enqueued
-					< (chan->capture_queue_depth * chan->valid_ports))) {
-				spin_unlock_irqrestore(
-					&chan->capture_state_lock, flags);
+			if (!vi5_capture_can_enqueue(chan))
 				break;
-			}
-			spin_unlock_irqrestore(&chan->capture_state_lock,
-				flags);
 
 			buf = dequeue_buffer(chan, false);
 			if (!buf)
@@ -731,7 +764,7 @@ static int tegra_channel_kthread_capture_dequeue(void *data)
 			if (!buf)
 				break;
 
-			vi5_capture_dequeue(chan, buf);
+			vi5_capture_dequeue(chan, buf, false);
 		}
 
 		spin_lock_irqsave(&chan->capture_state_lock, flags);
@@ -754,6 +787,117 @@ static int tegra_channel_kthread_capture_dequeue(void *data)
 	return 0;
 }
 
+static bool vi5_capture_in_error(struct tegra_channel *chan)
+{
+	unsigned long flags;
+	bool ret;
+
+	spin_lock_irqsave(&chan->capture_state_lock, flags);
+	ret = (chan->capture_state == CAPTURE_ERROR);
+	spin_unlock_irqrestore(&chan->capture_state_lock, flags);
+
+	return ret;
+}
+
+/*
+ * Event-driven capture: buffers are submitted from QBUF and from the RCE
+ * status callback, and completed directly in that callback, so a channel
+ * needs no kthreads. Error recovery still needs process context outside
+ * the callback and runs from chan->error_work.
+ *
+ * All of these run with chan->capture_event_lock held.
+ */
+static void vi5_capture_event_fill(struct tegra_channel *chan)
+{
+	struct tegra_channel_buffer *buf;
+
+	while (!list_empty(&chan->capture) && vi5_capture_can_enqueue(chan)) {
+		buf = dequeue_buffer(chan, false);
+		if (!buf)
+			break;
+
+		buf->vb2_state = VB2_BUF_STATE_ACTIVE;
+
+		vi5_capture_enqueue(chan, buf);
+	}
+
+	if (vi5_capture_in_error(chan))
+		schedule_work(&chan->error_work);
+}
+
+static void vi5_capture_status_notify(void *priv, uint32_t buffer_index)
+{
+	struct tegra_channel *chan = priv;
+	struct tegra_channel_buffer *buf;
+	unsigned long flags;
+
+	mutex_lock(&chan->capture_event_lock);
+
+	if (!chan->capture_event_mode)
+		goto done;
+
+	buf = dequeue_dequeue_buffer(chan);
+	if (buf) {
+		if (buf->capture_descr_index[0] != buffer_index) {
+			dev_err(chan->vi->dev,
+				"uncorr_err: status for descriptor %u, expected %u\n",
+				buffer_index, buf->capture_descr_index[0]);
+			spin_lock_irqsave(&chan->capture_state_lock, flags);
+			chan->capture_state = CAPTURE_ERROR;
+			spin_unlock_irqrestore(&chan->capture_state_lock, flags);
+			buf->vb2_state = VB2_BUF_STATE_ERROR;
+		}
+		vi5_capture_dequeue(chan, buf, true);
+	}
+
+	vi5_capture_event_fill(chan);
+
+done:
+	mutex_unlock(&chan->capture_event_lock);
+}
+
+static void vi5_capture_error_work(struct work_struct *work)
+{
+	struct tegra_channel *chan =
+		container_of(work, struct tegra_channel, error_work);
+	int err;
+
+	mutex_lock(&chan->capture_event_lock);
+	if (chan->capture_event_mode && vi5_capture_in_error(chan)) {
+		err = tegra_channel_error_recover(chan, false);
+		if (err)
+			dev_err(chan->vi->dev,
+				"fatal: error recovery failed\n");
+	}
+	mutex_unlock(&chan->capture_event_lock);
+}
+
+static void vi5_buffer_queued(struct tegra_channel *chan)
+{
+	mutex_lock(&chan->capture_event_lock);
+	if (chan->capture_event_mode)
+		vi5_capture_event_fill(chan);
+	mutex_unlock(&chan->capture_event_lock);
+}
+
+static int vi5_channel_start_event_mode(struct tegra_channel *chan)
+{
+	int err;
+
+	INIT_WORK(&chan->error_work, vi5_capture_error_work);
+
+	mutex_lock(&chan->capture_event_lock);
+	err = vi_capture_set_status_notify(chan->tegra_vi_channel[0],
+			vi5_capture_status_notify, chan);
+	if (!err) {
+		chan->capture_event_mode = true;
+		vi5_capture_event_fill(chan);
+	}
+	mutex_unlock(&chan->capture_event_lock);
+
+	return err;
+}
+
 static int vi5_channel_start_kthreads(struct tegra_channel *chan)
 {
 	int err = 0;
@@ -811,6 +955,29 @@ static void vi5_channel_stop_kthreads(struct tegra_channel *chan)
 	mutex_unlock(&chan->stop_kthread_lock);
 }
 
+static int vi5_channel_start_capture(struct tegra_channel *chan)
+{
+	/* Gang mode pairs two status streams per frame; keep the kthreads */
+	if (event_driven_capture && chan->valid_ports == 1)
+		return vi5_channel_start_event_mode(chan);
+
+	return vi5_channel_start_kthreads(chan);
+}
+
+static void vi5_channel_stop_capture(struct tegra_channel *chan)
+{
+	if (!chan->capture_event_mode) {
+		vi5_channel_stop_kthreads(chan);
+		return;
+	}
+
+	mutex_lock(&chan->capture_event_lock);
+	chan->capture_event_mode = false;
+	mutex_unlock(&chan->capture_event_lock);
+
+	cancel_work_sync(&chan->error_work);
+}
+
 static void vi5_unit_get_device_handle(struct platform_device *pdev,
 		uint32_t csi_stream_id, struct device **dev)
 {
@@ -922,7 +1089,7 @@ static int vi5_channel_start_streaming(struct vb2_queue *vq, u32 count)
 		chan->sequence = 0;
 		tegra_channel_init_ring_buffer(chan);
 
-		ret = vi5_channel_start_kthreads(chan);
+		ret = vi5_channel_start_capture(chan);
 		if (ret != 0)
 			goto err_start_kthreads;
 	}
@@ -943,7 +1110,7 @@ err_write_blobs:
 
 err_set_stream:
 	if (!chan->bypass)
-		vi5_channel_stop_kthreads(chan);
+		vi5_channel_stop_capture(chan);
 
 err_start_kthreads:
 	if (!chan->bypass)
@@ -976,7 +1143,7 @@ static int vi5_channel_stop_streaming(struct vb2_queue *vq)
 			vi_capture_abort(chan->tegra_vi_channel[vi_port]);
 		}
 		
-		vi5_channel_stop_kthreads(chan);
+		vi5_channel_stop_capture(chan);
 	}
 		
 
@@ -1109,5 +1276,6 @@ struct tegra_vi_fops vi5_fops = {
 	.vi_add_ctrls = vi5_add_ctrls,
 	.vi_init_video_formats = vi5_init_video_formats,
 	.vi_unit_get_device_handle = vi5_unit_get_device_handle,
+	.vi_buffer_queued = vi5_buffer_queued,
 };
 EXPORT_SYMBOL(vi5_fops);
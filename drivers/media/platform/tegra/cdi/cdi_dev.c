@@ -24,6 +24,9 @@
 /* i2c payload size is only 12 bit */
 #define MAX_MSG_SIZE	(0xFFF - 1)
 
+/* upper bound on the staged payload of one vectored transfer */
+#define MAX_VEC_DATA_SIZE	(64 * 1024)
+
 /*#define DEBUG_I2C_TRAFFIC*/
 
 /* CDI Dev Debugfs functions
@@ -342,6 +345,181 @@ static int cdi_dev_raw_rw(struct cdi_dev_info *info)
 	return ret;
 }
 
+/* Execute a vector of user packages as one i2c_transfer().
+ * The package array is fetched with a single copy and all payloads
+ * are staged in one kmalloc'ed buffer. Each package opens a new
+ * segment with a repeated start; writes larger than MAX_MSG_SIZE are
+ * continued with I2C_M_NOSTART as in cdi_dev_raw_wr(), and reads are
+ * preceded by their offset message. The staging buffer is DMA-safe,
+ * so large blocks are handed to the controller's DMA path without
+ * another bounce copy.
+ */
+static int cdi_dev_raw_rw_vec(struct cdi_dev_info *info, unsigned long arg)
+{
+	struct cdi_dev_package_vec vec;
+	struct cdi_dev_package *pkgs;
+	struct i2c_msg *i2cmsg = NULL;
+	u8 *buf = NULL, *ptr;
+	size_t total_size = 0;
+	unsigned int num_msgs = 0, n = 0, i;
+	int ret = 0;
+
+	dev_dbg(info->dev, "%s\n", __func__);
+
+	if (copy_from_user(&vec, (const void __user *)arg, sizeof(vec))) {
+		dev_err(info->dev, "%s copy_from_user err line %d\n",
+			__func__, __LINE__);
+		return -EFAULT;
+	}
+
+	if (vec.num_pkgs == 0 || vec.num_pkgs > CDI_DEV_VEC_MAX_PKGS ||
+		vec.reserved) {
+		dev_err(info->dev, "%s: invalid package vector, num %u\n",
+			__func__, vec.num_pkgs);
+		return -EINVAL;
+	}
+
+	pkgs = memdup_user(u64_to_user_ptr(vec.pkgs),
+			array_size(vec.num_pkgs, sizeof(*pkgs)));
+	if (IS_ERR(pkgs)) {
+		dev_err(info->dev, "%s copy_from_user err line %d\n",
+			__func__, __LINE__);
+		return PTR_ERR(pkgs);
+	}
+
+	for (i = 0; i < vec.num_pkgs; i++) {
+		if (pkgs[i].size == 0 || pkgs[i].size > MAX_VEC_DATA_SIZE ||
+			pkgs[i].offset_len > 2) {
+			dev_err(info->dev, "%s: invalid package %u\n",
+				__func__, i);
+			ret = -EINVAL;
+			goto out;
+		}
+
+		if (pkgs[i].flags & CDI_DEV_PKG_FLAG_WR) {
+			num_msgs += DIV_ROUND_UP(pkgs[i].size, MAX_MSG_SIZE);
+		} else {
+			/* offset message followed by the read */
+			num_msgs += 2;
+			total_size += 2;
+		}
+		total_size += pkgs[i].size;
+	}
+
+	if (total_size > MAX_VEC_DATA_SIZE) {
+		dev_err(info->dev, "%s: vector too large: %zu\n",
+			__func__, total_size);
+		ret = -EINVAL;
+		goto out;
+	}
+
+	buf = kmalloc(total_size, GFP_KERNEL);
+	i2cmsg = kcalloc(num_msgs, sizeof(*i2cmsg), GFP_KERNEL);
+	if (buf == NULL || i2cmsg == NULL) {
+		dev_err(info->dev, "%s: Unable to allocate memory!\n",
+			__func__);
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	ptr = buf;
+	for (i = 0; i < vec.num_pkgs; i++) {
+		struct cdi_dev_package *pkg = &pkgs[i];
+		unsigned int offset_len = pkg->offset_len;
+		u32 remain = pkg->size;
+		u32 len;
+
+		if (!(pkg->flags & CDI_DEV_PKG_FLAG_WR)) {
+			if (!offset_len)
+				offset_len = info->reg_len;
+
+			if (offset_len == 2) {
+				ptr[0] = (u8)((pkg->offset >> 8) & 0xff);
+				ptr[1] = (u8)(pkg->offset & 0xff);
+			} else if (offset_len == 1)
+				ptr[0] = (u8)(pkg->offset & 0xff);
+
+			i2cmsg[n].addr = info->i2c_client->addr;
+			i2cmsg[n].flags = I2C_M_DMA_SAFE;
+			i2cmsg[n].len = offset_len;
+			i2cmsg[n].buf = ptr;
+			ptr += 2;
+			n++;
+
+			i2cmsg[n].addr = info->i2c_client->addr;
+			i2cmsg[n].flags = I2C_M_RD | I2C_M_DMA_SAFE;
+			i2cmsg[n].len = pkg->size;
+			i2cmsg[n].buf = ptr;
+			ptr += pkg->size;
+			n++;
+			continue;
+		}
+
+		if (copy_from_user(ptr,
+			(const void __user *)pkg->buffer, pkg->size)) {
+			dev_err(info->dev, "%s copy_from_user err line %d\n",
+				__func__, __LINE__);
+			ret = -EFAULT;
+			goto out;
+		}
+		cdi_dev_dump(__func__, info, -1, ptr, pkg->size);
+
+		while (remain) {
+			len = min_t(u32, remain, MAX_MSG_SIZE);
+			i2cmsg[n].addr = info->i2c_client->addr;
+			i2cmsg[n].flags = I2C_M_DMA_SAFE;
+			if (remain != pkg->size)
+				i2cmsg[n].flags |= I2C_M_NOSTART;
+			i2cmsg[n].len = len;
+			i2cmsg[n].buf = ptr;
+			ptr += len;
+			remain -= len;
+			n++;
+		}
+	}
+
+	mutex_lock(&info->mutex);
+	if (!info->power_is_on) {
+		dev_err(info->dev, "%s: power is off.\n", __func__);
+		ret = -ENODEV;
+	} else {
+		ret = i2c_transfer(info->i2c_client->adapter, i2cmsg, n);
+		if (ret == n)
+			ret = 0;
+		else if (ret >= 0)
+			ret = -EIO;
+	}
+	mutex_unlock(&info->mutex);
+	if (ret)
+		goto out;
+
+	ptr = buf;
+	for (i = 0; i < vec.num_pkgs; i++) {
+		struct cdi_dev_package *pkg = &pkgs[i];
+
+		if (pkg->flags & CDI_DEV_PKG_FLAG_WR) {
+			ptr += pkg->size;
+			continue;
+		}
+
+		ptr += 2;
+		cdi_dev_dump(__func__, info, pkg->offset, ptr, pkg->size);
+		if (copy_to_user((void __user *)pkg->buffer, ptr, pkg->size)) {
+			dev_err(info->dev, "%s copy_to_user err line %d\n",
+				__func__, __LINE__);
+			ret = -EFAULT;
+			break;
+		}
+		ptr += pkg->size;
+	}
+
+out:
+	kfree(i2cmsg);
+	kfree(buf);
+	kfree(pkgs);
+	return ret;
+}
+
 static int cdi_dev_get_package(
 	struct cdi_dev_info *info, unsigned long arg)
 {
@@ -486,6 +664,9 @@ static long cdi_dev_ioctl(struct file *file,
 
 		err = cdi_dev_raw_rw(info);
 		break;
+	case CDI_DEV_IOCTL_RW_VEC:
+		err = cdi_dev_raw_rw_vec(info, arg);
+		break;
 	case CDI_DEV_IOCTL_GET_PWR_INFO:
 		err = cdi_dev_get_pwr_info(info, (void __user *)arg);
 		break;
@@ -8,6 +8,7 @@
 #include <linux/module.h>
 #include <linux/slab.h>
 #include <linux/gpio.h>
+#include <linux/gpio/consumer.h>
 #include <linux/of_gpio.h>
 #include <linux/of.h>
 #include <linux/regmap.h>
@@ -430,10 +431,37 @@ pwr_info_end:
 	return err;
 }
 
-int isc_mgr_power_up(struct isc_mgr_priv *isc_mgr, unsigned long arg)
+/*
+ * Drive all power GPIOs in one call so that the writes to each GPIO
+ * controller are batched instead of issued one GPIO at a time.
+ */
+static void isc_mgr_power_set_all(struct isc_mgr_priv *isc_mgr, bool on)
 {
 	struct isc_mgr_platform_data *pd = isc_mgr->pdata;
+	struct gpio_desc *descs[MAX_ISC_GPIOS];
+	DECLARE_BITMAP(values, MAX_ISC_GPIOS);
 	int i;
+
+	bitmap_zero(values, MAX_ISC_GPIOS);
+	for (i = 0; i < pd->num_pwr_gpios; i++) {
+		dev_dbg(isc_mgr->pdev, "  - %d, %d\n", pd->pwr_gpios[i],
+			on ? PW_ON(pd->pwr_flags[i]) : PW_OFF(pd->pwr_flags[i]));
+		descs[i] = gpio_to_desc(pd->pwr_gpios[i]);
+		if (on ? PW_ON(pd->pwr_flags[i]) : PW_OFF(pd->pwr_flags[i]))
+			__set_bit(i, values);
+	}
+
+	gpiod_set_raw_array_value(pd->num_pwr_gpios, descs, NULL, values);
+
+	if (on)
+		isc_mgr->pwr_state |= BIT(pd->num_pwr_gpios) - 1;
+	else
+		isc_mgr->pwr_state &= ~(BIT(pd->num_pwr_gpios) - 1);
+}
+
+int isc_mgr_power_up(struct isc_mgr_priv *isc_mgr, unsigned long arg)
+{
+	struct isc_mgr_platform_data *pd = isc_mgr->pdata;
 	u32 pwr_gpio;
 
 	dev_dbg(isc_mgr->pdev, "%s - %lu\n", __func__, arg);
@@ -455,12 +483,7 @@ int isc_mgr_power_up(struct isc_mgr_priv *isc_mgr, unsigned long arg)
 		return 0;
 	}
 
-	for (i = 0; i < pd->num_pwr_gpios; i++) {
-		dev_dbg(isc_mgr->pdev, "  - %d, %d\n",
-			pd->pwr_gpios[i], PW_ON(pd->pwr_flags[i]));
-		gpio_set_value(pd->pwr_gpios[i], PW_ON(pd->pwr_flags[i]));
-		isc_mgr->pwr_state |= BIT(i);
-	}
+	isc_mgr_power_set_all(isc_mgr, true);
 
 pwr_up_end:
 	return 0;
@@ -469,7 +492,6 @@ pwr_up_end:
 int isc_mgr_power_down(struct isc_mgr_priv *isc_mgr, unsigned long arg)
 {
 	struct isc_mgr_platform_data *pd = isc_mgr->pdata;
-	int i;
 	u32 pwr_gpio;
 
 	dev_dbg(isc_mgr->pdev, "%s - %lx\n", __func__, arg);
@@ -492,13 +514,9 @@ int isc_mgr_power_down(struct isc_mgr_priv *isc_mgr, unsigned long arg)
 		return 0;
 	}
 
-	for (i = 0; i < pd->num_pwr_gpios; i++) {
-		dev_dbg(isc_mgr->pdev, "  - %d, %d\n",
-			pd->pwr_gpios[i], PW_OFF(pd->pwr_flags[i]));
-		gpio_set_value(pd->pwr_gpios[i], PW_OFF(pd->pwr_flags[i]));
-		isc_mgr->pwr_state &= ~BIT(i);
-	}
-	mdelay(7);
+	isc_mgr_power_set_all(isc_mgr, false);
+	/* let the rails discharge, sleeping rather than spinning */
+	usleep_range(7000, 7500);
 
 pwr_dn_end:
 	return 0;
@@ -1,16 +1,20 @@
 // SPDX-License-Identifier: GPL-2.0-only
 /* SPDX-FileCopyrightText: Copyright (c) 2017-2024, NVIDIA CORPORATION.  All rights reserved. */
 
+#include <linux/completion.h>
 #include <linux/device.h>
 #include <linux/dmaengine.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/platform_device.h>
+#include <linux/slab.h>
 #include <linux/uaccess.h>
 #include "mods_internal.h"
 
 static struct device *mods_tegra_dma_dev;
 
 #define MODS_DMA_MAX_CHANNEL 32
+#define MODS_DMA_SG_TIMEOUT_MS 1000
 struct mods_dma_chan_info {
 	rwlock_t lock;
 	bool    in_use;
@@ -371,6 +375,159 @@ failed:
 	return err;
 }
 
+static void mods_dma_sg_callback(void *param)
+{
+	complete(param);
+}
+
+/* The channel may have been released while its lock was not held */
+static void mods_dma_sg_terminate(struct mods_dma_chan_info *p_mods_chan,
+				  struct dma_chan *pch)
+{
+	bool same_chan;
+
+	read_lock(&(p_mods_chan->lock));
+	same_chan = p_mods_chan->in_use && p_mods_chan->pch == pch;
+	read_unlock(&(p_mods_chan->lock));
+
+	if (same_chan)
+		dmaengine_terminate_sync(pch);
+}
+
+int esc_mods_dma_submit_sg(struct mods_client *client,
+			   struct MODS_DMA_TX_SG_DESC *p_sg_desc)
+{
+	int err = OK;
+	struct mods_dma_chan_info *p_mods_chan;
+	struct dma_async_tx_descriptor *desc = NULL;
+	struct MODS_DMA_SG_ENTRY *entries = p_sg_desc->entries;
+	struct scatterlist *sgl = NULL;
+	struct dma_chan *pch;
+	enum dma_ctrl_flags flags;
+	mods_dma_cookie_t cookie = -EINVAL;
+	DECLARE_COMPLETION_ONSTACK(done);
+	bool wait = (p_sg_desc->flags & MODS_DMA_SG_FLAG_WAIT) != 0;
+	u32 num = p_sg_desc->num_entries;
+	u32 timeout_ms;
+	ktime_t start;
+	u32 i;
+
+	LOG_ENT();
+
+	if (num == 0 || num > MODS_DMA_MAX_SG_ENTRIES) {
+		cl_error("invalid number of sg entries: %u\n", num);
+		LOG_EXT();
+		return -EINVAL;
+	}
+
+	err = mods_get_inuse_chan_by_handle(&p_sg_desc->handle, &p_mods_chan);
+	if (err != OK) {
+		LOG_EXT();
+		return err;
+	}
+
+	/* Slave transfers take the whole list as a single descriptor */
+	if (p_sg_desc->data_dir != MODS_DMA_MEM_TO_MEM) {
+		sgl = kcalloc(num, sizeof(*sgl), GFP_KERNEL);
+		if (!sgl) {
+			LOG_EXT();
+			return -ENOMEM;
+		}
+
+		sg_init_table(sgl, num);
+		for (i = 0; i < num; i++) {
+			sg_dma_address(&sgl[i]) = entries[i].phys;
+			sg_dma_len(&sgl[i]) = entries[i].length;
+		}
+	}
+
+	cl_debug(DEBUG_TEGRADMA, "submit %u sg entries on chan %d\n",
+		 num, p_sg_desc->handle.dma_id);
+
+	start = ktime_get();
+
+	write_lock(&(p_mods_chan->lock));
+	pch = p_mods_chan->pch;
+	for (i = 0; i < num; i++) {
+		/* only the last descriptor interrupts */
+		flags = DMA_CTRL_ACK;
+		if (sgl || i == num - 1)
+			flags |= DMA_PREP_INTERRUPT;
+
+		if (sgl)
+			desc = dmaengine_prep_slave_sg(pch, sgl, num,
+						       p_sg_desc->data_dir,
+						       flags);
+		else
+			desc = pch->device->device_prep_dma_memcpy(
+							pch,
+							entries[i].phys,
+							entries[i].phys_2,
+							entries[i].length,
+							flags);
+		if (desc == NULL) {
+			cookie = -EINVAL;
+			break;
+		}
+
+		if (sgl || i == num - 1) {
+			desc->callback = wait ? mods_dma_sg_callback : NULL;
+			desc->callback_param = wait ? &done : NULL;
+		} else {
+			desc->callback = NULL;
+			desc->callback_param = NULL;
+		}
+
+		cookie = dmaengine_submit(desc);
+		if (dma_submit_error(cookie) || sgl)
+			break;
+	}
+	write_unlock(&(p_mods_chan->lock));
+
+	p_sg_desc->submit_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	kfree(sgl);
+
+	if (dma_submit_error(cookie)) {
+		cl_error("unable to submit sg entry %u of %u\n", i, num);
+		err = -EIO;
+		goto failed;
+	}
+
+	p_sg_desc->cookie = cookie;
+	p_sg_desc->transfer_ns = 0;
+
+	if (!wait)
+		goto done;
+
+	timeout_ms = p_sg_desc->timeout_ms ? p_sg_desc->timeout_ms :
+					     MODS_DMA_SG_TIMEOUT_MS;
+
+	read_lock(&(p_mods_chan->lock));
+	start = ktime_get();
+	dma_async_issue_pending(pch);
+	read_unlock(&(p_mods_chan->lock));
+
+	if (!wait_for_completion_timeout(&done,
+					 msecs_to_jiffies(timeout_ms))) {
+		cl_error("sg transfer timed out after %u ms\n", timeout_ms);
+		err = -ETIMEDOUT;
+		goto failed;
+	}
+
+	p_sg_desc->transfer_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	cl_debug(DEBUG_TEGRADMA, "sg transfer done in %llu ns\n",
+		 p_sg_desc->transfer_ns);
+	goto done;
+
+failed:
+	/* drop what was queued, the callback must not run after we return */
+	mods_dma_sg_terminate(p_mods_chan, pch);
+done:
+	LOG_EXT();
+	return err;
+}
+
 int esc_mods_dma_async_issue_pending(struct mods_client *client,
 					struct MODS_DMA_HANDLE *p_handle)
 {
@@ -638,6 +638,8 @@ int esc_mods_dma_set_config(struct mods_client             *client,
 int esc_mods_dma_wait(struct mods_client *client, struct MODS_DMA_WAIT_DESC *p);
 int esc_mods_dma_submit_request(struct mods_client      *client,
 				struct MODS_DMA_TX_DESC *p);
+int esc_mods_dma_submit_sg(struct mods_client         *client,
+			   struct MODS_DMA_TX_SG_DESC *p);
 int esc_mods_dma_async_issue_pending(struct mods_client     *client,
 				     struct MODS_DMA_HANDLE *p);
 #endif
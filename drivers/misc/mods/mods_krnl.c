@@ -2669,6 +2669,11 @@ static long mods_krnl_ioctl(struct file  *fp,
 			   esc_mods_dma_wait,
 			   MODS_DMA_WAIT_DESC);
 		break;
+	case MODS_ESC_DMA_TX_SUBMIT_SG:
+		MODS_IOCTL(MODS_ESC_DMA_TX_SUBMIT_SG,
+			   esc_mods_dma_submit_sg,
+			   MODS_DMA_TX_SG_DESC);
+		break;
 #endif
 #if defined(MODS_HAS_TEGRA) && defined(CONFIG_NET)
 	case MODS_ESC_NET_FORCE_LINK:
@@ -16,6 +16,15 @@
 #include <linux/cache.h>
 #endif
 
+/* Largest chunk the page allocator can return */
+#if defined(MAX_PAGE_ORDER)
+#define MODS_MAX_CHUNK_ORDER MAX_PAGE_ORDER
+#elif KERNEL_VERSION(6, 4, 0) <= MODS_KERNEL_VERSION
+#define MODS_MAX_CHUNK_ORDER MAX_ORDER
+#else
+#define MODS_MAX_CHUNK_ORDER (MAX_ORDER - 1)
+#endif
+
 static struct MODS_MEM_INFO *get_mem_handle(struct mods_client *client,
 					    u64                 handle)
 {
@@ -399,6 +408,24 @@ static void clear_contiguous_cache(struct mods_client *client,
 				   u32                 size);
 #endif
 
+static int set_cache_attr_range(struct mods_client   *client,
+				struct MODS_MEM_INFO *p_mem_info,
+				void                 *ptr,
+				u32                   size)
+{
+#ifdef CONFIG_ARM64
+	clear_contiguous_cache(client, (u64)(size_t)ptr, size);
+	return 0;
+#else
+	if (p_mem_info->cache_type == MODS_ALLOC_WRITECOMBINE)
+		return MODS_SET_MEMORY_WC((unsigned long)ptr,
+					  size >> PAGE_SHIFT);
+	else
+		return MODS_SET_MEMORY_UC((unsigned long)ptr,
+					  size >> PAGE_SHIFT);
+#endif
+}
+
 static int setup_cache_attr(struct mods_client   *client,
 			    struct MODS_MEM_INFO *p_mem_info,
 			    u32                   ichunk)
@@ -410,6 +437,20 @@ static int setup_cache_attr(struct mods_client   *client,
 		struct scatterlist *sg = &p_mem_info->alloc_sg[ichunk];
 		unsigned int        offs;
 
+		/* Chunks in the linear map are changed in one go */
+		if (!PageHighMem(sg_page(sg))) {
+			mark_chunk_wc(p_mem_info, ichunk);
+
+			err = set_cache_attr_range(client,
+						   p_mem_info,
+						   page_address(sg_page(sg)),
+						   sg->length);
+			if (unlikely(err))
+				cl_error("set cache type failed\n");
+
+			return err;
+		}
+
 		for (offs = 0; offs < sg->length; offs += PAGE_SIZE) {
 			void *ptr;
 
@@ -418,16 +459,8 @@ static int setup_cache_attr(struct mods_client   *client,
 				cl_error("kmap failed\n");
 				return -ENOMEM;
 			}
-#ifdef CONFIG_ARM64
-			clear_contiguous_cache(client,
-					       (u64)(size_t)ptr,
-					       PAGE_SIZE);
-#else
-			if (p_mem_info->cache_type == MODS_ALLOC_WRITECOMBINE)
-				err = MODS_SET_MEMORY_WC((unsigned long)ptr, 1);
-			else
-				err = MODS_SET_MEMORY_UC((unsigned long)ptr, 1);
-#endif
+			err = set_cache_attr_range(client, p_mem_info,
+						   ptr, PAGE_SIZE);
 			MODS_KUNMAP(ptr);
 			if (unlikely(err)) {
 				cl_error("set cache type failed\n");
@@ -540,6 +573,10 @@ static int restore_cache_one_chunk(struct page *p_page, u8 order)
 	u32 num_pages = 1U << order;
 	u32 i;
 
+	if (!PageHighMem(p_page))
+		return MODS_SET_MEMORY_WB((unsigned long)page_address(p_page),
+					  num_pages);
+
 	for (i = 0; i < num_pages; i++) {
 		void *ptr = MODS_KMAP(p_page + i);
 		int   err = -ENOMEM;
@@ -822,7 +859,8 @@ failed:
 
 static u32 get_max_order_needed(u32 num_pages)
 {
-	const u32 order = min(10, get_order(num_pages << PAGE_SHIFT));
+	const u32 order = min(MODS_MAX_CHUNK_ORDER,
+			      get_order((u64)num_pages << PAGE_SHIFT));
 
 	return ((1u << order) <= num_pages) ? order : (order >> 1u);
 }
@@ -10,6 +10,8 @@
 #include <linux/iommu.h>
 #include <linux/kernel.h>
 #include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/moduleparam.h>
 #include <linux/platform_device.h>
 #include <linux/slab.h>
 #include <linux/types.h>
@@ -39,6 +41,15 @@
 #define COMM_CHANNEL_NFRAMES	(1024)
 #define COMM_CHANNEL_FRAME_SZ	(64)
 
+/*
+ * the receive task polls for new frames for up to these many microseconds
+ * before going back to wait for a notification from peer. 0 disables polling.
+ */
+static uint busy_poll_us;
+module_param(busy_poll_us, uint, 0644);
+MODULE_PARM_DESC(busy_poll_us,
+		 "Max time in us the comm-channel receive task polls for messages before sleeping, 0 to disable");
+
 /* fifo header.*/
 struct header {
 	u32 wr_count;
@@ -181,6 +192,23 @@ can_recv(struct fifo_t *fifo, int *ret)
 	return recv;
 }
 
+/*
+ * peer publishes rd_count once per batch of frames and checks for frames
+ * again before it waits for a notification (see recv_msgs()). If peer has
+ * not yet published consumption of all the frames before this one, it is
+ * still processing and shall pick this frame too, without a notification.
+ *
+ * the read-back flushes the write of wr_count to peer before rd_count is
+ * sampled, peer does the same for rd_count.
+ */
+static inline bool
+peer_needs_notify(struct fifo_t *fifo, u32 prev_wr_count)
+{
+	(void)readl((void __iomem *)(&fifo->send_hdr->wr_count));
+
+	return (READ_ONCE(fifo->recv_hdr->rd_count) == prev_wr_count);
+}
+
 static int
 send_msg(struct comm_channel_ctx_t *comm_ctx, struct comm_msg *msg)
 {
@@ -216,8 +244,8 @@ send_msg(struct comm_channel_ctx_t *comm_ctx, struct comm_msg *msg)
 	if (peer_cpu == NVCPU_X86_64) {
 	/* comm-channel irq verctor always take from index 0 */
 		ret = pci_client_raise_irq(comm_ctx->pci_client_h, PCI_EPC_IRQ_MSI, 0);
-	} else {
-	/* notify peer for each write.*/
+	} else if (peer_needs_notify(fifo, fifo->local_hdr->wr_count - 1)) {
+	/* notify peer only when it may be waiting for this write.*/
 		writel(0x1, syncpt->peer_mem.pva);
 	}
 
@@ -278,19 +306,95 @@ comm_channel_msg_send(void *comm_channel_h, struct comm_msg *msg)
 	return send_msg(comm_ctx, msg);
 }
 
+static void
+process_msg(struct comm_channel_ctx_t *comm_ctx, struct comm_msg *msg)
+{
+	struct callback_ops *cb_ops = NULL;
+
+	if (msg->type > COMM_MSG_TYPE_INVALID &&
+	    msg->type < COMM_MSG_TYPE_MAXIMUM) {
+		mutex_lock(&comm_ctx->cb_ops_lock);
+		cb_ops = &comm_ctx->cb_ops[msg->type];
+
+		if (cb_ops->callback)
+			cb_ops->callback((void *)msg, cb_ops->ctx);
+		mutex_unlock(&comm_ctx->cb_ops_lock);
+	}
+}
+
+/* read all available frames.*/
+static void
+recv_msgs(struct comm_channel_ctx_t *comm_ctx)
+{
+	int ret = 0;
+	struct comm_msg *msg = NULL;
+	struct fifo_t *fifo = &comm_ctx->fifo;
+
+	while (can_recv(fifo, &ret)) {
+		do {
+			msg = (struct comm_msg *)
+				(fifo->recv + (fifo->rd_pos * fifo->frame_sz));
+			process_msg(comm_ctx, msg);
+
+			fifo->local_hdr->rd_count++;
+			fifo->rd_pos = fifo->rd_pos + 1;
+			if (fifo->rd_pos >= fifo->nframes)
+				fifo->rd_pos = 0;
+		} while (can_recv(fifo, &ret));
+
+		/*
+		 * publish consumption once for the batch. peer decides on
+		 * notifications with it (see peer_needs_notify()), so flush it
+		 * before checking for frames again.
+		 *
+		 * do not noifty peer for space availability.
+		 */
+		writel(fifo->local_hdr->rd_count,
+		       (void __iomem *)(&fifo->send_hdr->rd_count));
+		(void)readl((void __iomem *)(&fifo->send_hdr->rd_count));
+	}
+}
+
+/*
+ * poll for new frames for up to @poll_us before waiting for a notification.
+ * A window which catches a frame resets the next one to busy_poll_us, one
+ * which expires halves the next one, down to busy_poll_us / 8 so that bursts
+ * after an idle period are still caught at a bounded cost.
+ */
+static bool
+recv_poll(struct comm_channel_ctx_t *comm_ctx, u32 *poll_us)
+{
+	int ret = 0;
+	u64 deadline = 0;
+	u32 max_us = READ_ONCE(busy_poll_us);
+
+	if (!max_us)
+		return false;
+
+	*poll_us = clamp_t(u32, *poll_us, max_t(u32, max_us >> 3, 1), max_us);
+	deadline = ktime_get_ns() + ((u64)*poll_us * NSEC_PER_USEC);
+	do {
+		if (can_recv(&comm_ctx->fifo, &ret)) {
+			*poll_us = max_us;
+			return true;
+		}
+		cpu_relax();
+	} while (!comm_ctx->r_task.shutdown && ktime_get_ns() < deadline);
+
+	*poll_us = *poll_us >> 1;
+	return false;
+}
+
 static int
 recv_taskfn(void *arg)
 {
-	int ret = 0;
 	struct comm_channel_ctx_t *comm_ctx = NULL;
-	struct comm_msg *msg = NULL;
 	struct task_t *task = NULL;
-	struct fifo_t *fifo = NULL;
-	struct callback_ops *cb_ops = NULL;
+	u32 poll_us = 0;
 
 	comm_ctx = (struct comm_channel_ctx_t *)(arg);
 	task = &comm_ctx->r_task;
-	fifo = &comm_ctx->fifo;
+	poll_us = READ_ONCE(busy_poll_us);
 
 	while (!task->shutdown) {
 		/* wait for notification from peer or shutdown. */
@@ -301,37 +405,16 @@ recv_taskfn(void *arg)
 		if (task->shutdown)
 			continue;
 
-		/* read all on single notify.*/
-		atomic_dec(&comm_ctx->recv_count);
-		while (can_recv(fifo, &ret)) {
-			msg = (struct comm_msg *)
-				(fifo->recv + (fifo->rd_pos * fifo->frame_sz));
-
-			if (msg->type > COMM_MSG_TYPE_INVALID &&
-			    msg->type < COMM_MSG_TYPE_MAXIMUM) {
-				mutex_lock(&comm_ctx->cb_ops_lock);
-				cb_ops = &comm_ctx->cb_ops[msg->type];
-
-				if (cb_ops->callback)
-					cb_ops->callback
-						((void *)msg, cb_ops->ctx);
-				mutex_unlock(&comm_ctx->cb_ops_lock);
-			}
-
-			fifo->local_hdr->rd_count++;
-
-			writel(fifo->local_hdr->rd_count,
-			       (void __iomem *)(&fifo->send_hdr->rd_count));
-
-			/* do not noifty peer for space availability. */
-
-			fifo->rd_pos = fifo->rd_pos + 1;
-			if (fifo->rd_pos >= fifo->nframes)
-				fifo->rd_pos = 0;
-		}
+		/*
+		 * read all on single notify: consume all notifications so far
+		 * before reading, later ones wake us again.
+		 */
+		atomic_set(&comm_ctx->recv_count, 0);
+		do {
+			recv_msgs(comm_ctx);
+		} while (recv_poll(comm_ctx, &poll_us));
 
 		/* if nothing (left) to read, go back waiting. */
-		continue;
 	}
 
 	/* we do not use kthread_stop(), but wait on this.*/
@@ -12,6 +12,7 @@
 #include <linux/host1x-next.h>
 #include <linux/iommu.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/platform_device.h>
 #include <linux/poll.h>
 #include <linux/printk.h>
@@ -77,6 +78,9 @@ struct syncpt_t {
 	void (*notifier)(void *data);
 	void *notifier_data;
 	bool fence_release;
+
+	/* last syncpoint value whose notification was propagated.*/
+	atomic_t seen;
 };
 
 /* private data structure for each endpoint. */
@@ -111,6 +115,9 @@ struct endpoint_t {
 	/* syncpoint shim for notifications (rx). */
 	struct syncpt_t syncpt;
 
+	/* poll() spins for these many us on syncpoint before sleeping.*/
+	u32 busy_poll_us;
+
 	/* msi irq to x86 RP */
 	u16 msi_irq;
 
@@ -189,6 +196,13 @@ disable_event_handling(struct endpoint_t *endpoint);
 static int
 ioctl_notify_remote_impl(struct endpoint_t *endpoint);
 
+static int
+ioctl_set_busy_poll_impl(struct endpoint_t *endpoint,
+			 struct nvscic2c_pcie_busy_poll_args *args);
+
+static bool
+busy_poll_syncpt(struct syncpt_t *syncpt, u32 timeout_us);
+
 /* prototype. */
 static int
 ioctl_get_info_impl(struct endpoint_t *endpoint,
@@ -239,6 +253,7 @@ endpoint_fops_open(struct inode *inode, struct file *filp)
 	}
 
 	/* start link, data event handling.*/
+	endpoint->busy_poll_us = 0;
 	enable_event_handling(endpoint);
 
 	atomic_set(&endpoint->in_use, 1);
@@ -375,6 +390,7 @@ static __poll_t
 endpoint_fops_poll(struct file *filp, poll_table *wait)
 {
 	__poll_t mask = 0;
+	u32 busy_poll_us = 0;
 	struct endpoint_t *endpoint = filp->private_data;
 
 	if (WARN_ON(!endpoint))
@@ -398,8 +414,19 @@ endpoint_fops_poll(struct file *filp, poll_table *wait)
 		mask = (__force __poll_t)(POLLPRI | POLLIN | POLLOUT);
 	}
 
+	/* spin only on the first call of a blocking poll().*/
+	if (!mask && !poll_does_not_wait(wait))
+		busy_poll_us = endpoint->busy_poll_us;
+
 	mutex_unlock(&endpoint->fops_lock);
 
+	/*
+	 * spin without fops_lock for other threads to notify peer meanwhile,
+	 * the endpoint stays in use for as long as poll() is in progress.
+	 */
+	if (busy_poll_us && busy_poll_syncpt(&endpoint->syncpt, busy_poll_us))
+		mask = (__force __poll_t)(POLLPRI | POLLIN | POLLOUT);
+
 	return mask;
 }
 
@@ -441,6 +468,10 @@ endpoint_fops_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 	case NVSCIC2C_PCIE_IOCTL_NOTIFY_REMOTE:
 		ret = ioctl_notify_remote_impl(endpoint);
 		break;
+	case NVSCIC2C_PCIE_IOCTL_SET_BUSY_POLL:
+		ret = ioctl_set_busy_poll_impl
+			(endpoint, (struct nvscic2c_pcie_busy_poll_args *)buf);
+		break;
 	default:
 		ret = stream_extension_ioctl(endpoint->stream_ext_h, cmd, buf);
 		break;
@@ -525,6 +556,59 @@ ioctl_notify_remote_impl(struct endpoint_t *endpoint)
 	return ret;
 }
 
+/*
+ * implement NVSCIC2C_PCIE_IOCTL_SET_BUSY_POLL ioctl call.
+ */
+static int
+ioctl_set_busy_poll_impl(struct endpoint_t *endpoint,
+			 struct nvscic2c_pcie_busy_poll_args *args)
+{
+	if (args->timeout_us > NVSCIC2C_PCIE_MAX_BUSY_POLL_US)
+		return -EINVAL;
+
+	endpoint->busy_poll_us = args->timeout_us;
+
+	return 0;
+}
+
+/*
+ * mark the notifications from peer up to syncpoint value @val propagated,
+ * returns true if any of them was not already.
+ *
+ * Both a busy-polling poll() and the host1x fence callback propagate
+ * notifications, whichever sees the syncpoint increment first does.
+ */
+static bool
+syncpt_propagate(struct syncpt_t *syncpt, u32 val)
+{
+	int seen = atomic_read(&syncpt->seen);
+
+	do {
+		if ((s32)(val - (u32)seen) <= 0)
+			return false;
+	} while (!atomic_try_cmpxchg(&syncpt->seen, &seen, (int)val));
+
+	return true;
+}
+
+/*
+ * spin on the syncpoint value for up to @timeout_us for a notification
+ * from peer, bypassing the host1x interrupt to workqueue to wakeup path.
+ */
+static bool
+busy_poll_syncpt(struct syncpt_t *syncpt, u32 timeout_us)
+{
+	u64 deadline = ktime_get_ns() + ((u64)timeout_us * NSEC_PER_USEC);
+
+	do {
+		if (syncpt_propagate(syncpt, host1x_syncpt_read(syncpt->sp)))
+			return true;
+		cpu_relax();
+	} while (ktime_get_ns() < deadline);
+
+	return false;
+}
+
 static void
 enable_event_handling(struct endpoint_t *endpoint)
 {
@@ -532,6 +616,8 @@ enable_event_handling(struct endpoint_t *endpoint)
 	 * propagate link and state change events that occur after the device
 	 * is opened and not the stale ones.
 	 */
+	atomic_set(&endpoint->syncpt.seen,
+		   (int)host1x_syncpt_read(endpoint->syncpt.sp));
 	atomic_set(&endpoint->event_count, 0);
 	atomic_set(&endpoint->event_handling, 1);
 }
@@ -644,9 +730,14 @@ fence_do_work(struct work_struct *work)
 static void
 syncpt_callback(void *data)
 {
+	struct endpoint_t *endpoint = (struct endpoint_t *)data;
+	struct syncpt_t *syncpt = &endpoint->syncpt;
+
 	/* Skip args ceck, trusting host1x. */
 
-	event_callback(NULL, data);
+	/* skip the ones already propagated by busy-polling poll().*/
+	if (syncpt_propagate(syncpt, syncpt->threshold))
+		event_callback(NULL, data);
 }
 
 /*
@@ -788,6 +879,7 @@ allocate_syncpoint(struct endpoint_drv_ctx_t *eps_ctx,
 	}
 
 	syncpt->threshold = host1x_syncpt_read(syncpt->sp);
+	atomic_set(&syncpt->seen, (int)syncpt->threshold);
 
 	/* enable syncpt notifications handling from peer.*/
 	mutex_init(&syncpt->lock);
@@ -12,8 +12,11 @@
 #include <linux/file.h>
 #include <linux/fs.h>
 #include <linux/host1x-next.h>
+#include <linux/mm.h>
+#include <linux/moduleparam.h>
 #include <linux/of.h>
 #include <linux/of_platform.h>
+#include <linux/sizes.h>
 #include <linux/slab.h>
 #include <linux/syscalls.h>
 #include <linux/tegra-pcie-edma.h>
@@ -32,9 +35,22 @@
 MODULE_IMPORT_NS(VFS_internal_I_am_really_a_filesystem_and_am_NOT_a_driver);
 #endif
 
+/*
+ * copy requests of at least these many bytes are striped across all the eDMA
+ * write channels. 0 disables striping.
+ */
+static ulong stripe_threshold = SZ_4M;
+module_param(stripe_threshold, ulong, 0644);
+MODULE_PARM_DESC(stripe_threshold,
+		 "Min copy request size in bytes to stripe over all eDMA write channels, 0 to disable");
+
+/* each stripe of a flush range is aligned to this size.*/
+#define STRIPE_ALIGN	(SZ_64K)
+
 /* forward declaration.*/
 struct stream_ext_ctx_t;
 struct stream_ext_obj;
+struct copy_request;
 
 /* limits as set for copy requests.*/
 struct copy_req_limits {
@@ -59,11 +75,37 @@ struct copy_req_params {
 	struct nvscic2c_pcie_flush_range *flush_ranges;
 };
 
+/* part of one copy request scheduled on one eDMA write channel.*/
+struct copy_stripe {
+	/* back-reference to the copy request, used in eDMA callback.*/
+	struct copy_request *cr;
+
+	/*
+	 * actual number of edma-desc on this channel and space for them
+	 * considering worst-case allocation: (max_flush_ranges).
+	 */
+	u64 num_edma_desc;
+	struct tegra_pcie_edma_desc *edma_desc;
+};
+
 /* one copy request.*/
 struct copy_request {
 	/* book-keeping for copy completion.*/
 	struct list_head node;
 
+	/*
+	 * book-keeping for in-flight copy requests. Post-fences are signalled
+	 * in submission order even when eDMA channels complete out of order.
+	 */
+	struct list_head inflight_node;
+	bool xfer_done;
+	edma_xfer_status_t xfer_status;
+
+	/* striping: stripes still in progress and their aggregated status.*/
+	atomic_t stripes_pending;
+	edma_xfer_status_t stripe_status;
+	struct copy_stripe stripes[DMA_WR_CHNL_NUM];
+
 	/*
 	 * back-reference to stream_ext_context, used in eDMA callback.
 	 * to add this copy_request back in free_list for reuse. Also,
@@ -128,6 +170,22 @@ struct copy_request {
 	enum peer_cpu_t peer_cpu;
 };
 
+/*
+ * batch of copy requests submitted as one eDMA transfer. Flush ranges of all
+ * the copy requests are chained back-to-back in edma_desc.
+ */
+struct copy_batch {
+	/* back-reference to stream_ext_context, used in eDMA callback.*/
+	struct stream_ext_ctx_t *ctx;
+
+	/* copy requests of the batch, in submission order.*/
+	struct list_head cr_list;
+
+	/* actual number of edma-desc in the batch.*/
+	u64 num_edma_desc;
+	struct tegra_pcie_edma_desc edma_desc[];
+};
+
 struct stream_ext_obj {
 	/* book-keeping for cleanup.*/
 	struct list_head node;
@@ -206,6 +264,8 @@ struct stream_ext_ctx_t {
 	struct list_head free_list;
 	/* guard free_list.*/
 	struct mutex free_lock;
+	/* in-flight copy requests in submission order, guarded by free_lock.*/
+	struct list_head inflight_list;
 	atomic_t transfer_count;
 	wait_queue_head_t transfer_waitq;
 
@@ -230,11 +290,28 @@ prepare_edma_desc(enum drv_mode_t drv_mode, struct copy_req_params *params,
 		  struct tegra_pcie_edma_desc *desc, u64 *num_desc);
 
 static edma_xfer_status_t
-schedule_edma_xfer(void *edma_h, void *priv, u64 num_desc,
-		   struct tegra_pcie_edma_desc *desc);
+schedule_edma_xfer(void *edma_h, u32 channel_num, void *priv, u64 num_desc,
+		   struct tegra_pcie_edma_desc *desc,
+		   edma_complete_t *complete);
+static edma_xfer_status_t
+schedule_edma_stripes(struct stream_ext_ctx_t *ctx, struct copy_request *cr);
+static void
+callback_edma_stripe_xfer(void *priv, edma_xfer_status_t status,
+			  struct tegra_pcie_edma_desc *desc);
 static void
 callback_edma_xfer(void *priv, edma_xfer_status_t status,
 		   struct tegra_pcie_edma_desc *desc);
+static void
+callback_edma_batch_xfer(void *priv, edma_xfer_status_t status,
+			 struct tegra_pcie_edma_desc *desc);
+static void
+complete_copy_request(struct copy_request *cr, edma_xfer_status_t status);
+static void
+track_copy_request(struct stream_ext_ctx_t *ctx, struct copy_request *cr);
+static void
+untrack_copy_request(struct stream_ext_ctx_t *ctx, struct copy_request *cr);
+static void
+retire_copy_request(struct copy_request *cr, edma_xfer_status_t status);
 static int
 validate_handle(struct stream_ext_ctx_t *ctx, s32 handle,
 		enum nvscic2c_pcie_obj_type type);
@@ -548,19 +625,70 @@ ioctl_map_obj(struct stream_ext_ctx_t *ctx,
 	return ret;
 }
 
-/* implement NVSCIC2C_PCIE_IOCTL_SUBMIT_COPY_REQUEST ioctl call. */
+/* implement NVSCIC2C_PCIE_IOCTL_MAP_BATCH ioctl call. */
 static int
-ioctl_submit_copy_request(struct stream_ext_ctx_t *ctx,
-			  struct nvscic2c_pcie_submit_copy_args *args)
+ioctl_map_batch(struct stream_ext_ctx_t *ctx,
+		struct nvscic2c_pcie_map_batch_args *args)
 {
 	int ret = 0;
-	struct copy_request *cr = NULL;
-	edma_xfer_status_t edma_status = EDMA_XFER_FAIL_INVAL_INPUTS;
-	enum nvscic2c_pcie_link link = NVSCIC2C_PCIE_LINK_DOWN;
+	u64 i = 0;
+	struct nvscic2c_pcie_map_obj_args *objs = NULL;
+	struct nvscic2c_pcie_free_obj_args free_args = {0};
+	struct nvscic2c_pcie_map_obj_args __user *user_objs = NULL;
 
-	link = pci_client_query_link_status(ctx->pci_client_h);
-	if (link != NVSCIC2C_PCIE_LINK_UP)
-		return -ENOLINK;
+	if (WARN_ON(!args->num_objs || !args->objs))
+		return -EINVAL;
+
+	if (args->num_objs > (MAX_STREAM_MEMOBJS + MAX_STREAM_SYNCOBJS))
+		return -EINVAL;
+
+	objs = kvcalloc(args->num_objs, sizeof(*objs), GFP_KERNEL);
+	if (WARN_ON(!objs))
+		return -ENOMEM;
+
+	user_objs = (struct nvscic2c_pcie_map_obj_args __user *)args->objs;
+	if (copy_from_user(objs, user_objs, args->num_objs * sizeof(*objs))) {
+		ret = -EFAULT;
+		goto err;
+	}
+
+	for (i = 0; i < args->num_objs; i++) {
+		ret = ioctl_map_obj(ctx, &objs[i]);
+		if (ret)
+			goto unwind;
+	}
+
+	if (copy_to_user(user_objs, objs, args->num_objs * sizeof(*objs))) {
+		ret = -EFAULT;
+		goto unwind;
+	}
+
+	kvfree(objs);
+	return 0;
+
+unwind:
+	while (i--) {
+		free_args.obj_type = objs[i].obj_type;
+		free_args.handle = objs[i].out.handle;
+		ioctl_free_obj(ctx, &free_args);
+	}
+err:
+	kvfree(objs);
+	return ret;
+}
+
+/*
+ * copy and validate one set of user-supplied submit-copy args and turn it into
+ * a copy_request with its eDMA descriptors ready. On success, the copy_request
+ * holds references on all its handles and is off the free list.
+ */
+static int
+prepare_copy_request(struct stream_ext_ctx_t *ctx,
+		     struct nvscic2c_pcie_submit_copy_args *args,
+		     struct copy_request **copy_request)
+{
+	int ret = 0;
+	struct copy_request *cr = NULL;
 
 	/* copy user-supplied submit-copy args.*/
 	ret = copy_args_from_user(ctx, args, &ctx->cr_params);
@@ -607,23 +735,165 @@ ioctl_submit_copy_request(struct stream_ext_ctx_t *ctx,
 		goto reclaim_cr;
 	}
 
-	/* schedule asynchronous eDMA.*/
+	*copy_request = cr;
+	return ret;
+
+reclaim_cr:
+	mutex_lock(&ctx->free_lock);
+	list_add_tail(&cr->node, &ctx->free_list);
+	mutex_unlock(&ctx->free_lock);
+	return ret;
+}
+
+/* undo prepare_copy_request() for a copy_request that was never scheduled.*/
+static void
+reclaim_copy_request(struct stream_ext_ctx_t *ctx, struct copy_request *cr)
+{
+	release_copy_request_handles(cr);
+
+	mutex_lock(&ctx->free_lock);
+	list_add_tail(&cr->node, &ctx->free_list);
+	mutex_unlock(&ctx->free_lock);
+}
+
+/* total bytes to be transferred by a prepared copy_request.*/
+static u64
+copy_request_size(struct copy_request *cr)
+{
+	u64 i = 0;
+	u64 size = 0;
+
+	for (i = 0; i < cr->num_edma_desc; i++)
+		size += cr->edma_desc[i].sz;
+
+	return size;
+}
+
+/* implement NVSCIC2C_PCIE_IOCTL_SUBMIT_COPY_REQUEST ioctl call. */
+static int
+ioctl_submit_copy_request(struct stream_ext_ctx_t *ctx,
+			  struct nvscic2c_pcie_submit_copy_args *args)
+{
+	int ret = 0;
+	ulong threshold = 0;
+	struct copy_request *cr = NULL;
+	edma_xfer_status_t edma_status = EDMA_XFER_FAIL_INVAL_INPUTS;
+	enum nvscic2c_pcie_link link = NVSCIC2C_PCIE_LINK_DOWN;
+
+	link = pci_client_query_link_status(ctx->pci_client_h);
+	if (link != NVSCIC2C_PCIE_LINK_UP)
+		return -ENOLINK;
+
+	ret = prepare_copy_request(ctx, args, &cr);
+	if (ret)
+		return ret;
+
+	/* schedule asynchronous eDMA, striped when large enough.*/
+	track_copy_request(ctx, cr);
 	atomic_inc(&ctx->transfer_count);
-	edma_status = schedule_edma_xfer(ctx->edma_h, (void *)cr,
-					 cr->num_edma_desc, cr->edma_desc);
+	threshold = READ_ONCE(stripe_threshold);
+	if (threshold && copy_request_size(cr) >= threshold)
+		edma_status = schedule_edma_stripes(ctx, cr);
+	else
+		edma_status = schedule_edma_xfer(ctx->edma_h, 0, (void *)cr,
+						 cr->num_edma_desc,
+						 cr->edma_desc,
+						 callback_edma_xfer);
 	if (edma_status != EDMA_XFER_SUCCESS) {
 		ret = -EIO;
 		atomic_dec(&ctx->transfer_count);
-		release_copy_request_handles(cr);
-		goto reclaim_cr;
+		untrack_copy_request(ctx, cr);
+		reclaim_copy_request(ctx, cr);
 	}
 
 	return ret;
+}
+
+/* implement NVSCIC2C_PCIE_IOCTL_SUBMIT_COPY_BATCH ioctl call. */
+static int
+ioctl_submit_copy_batch(struct stream_ext_ctx_t *ctx,
+			struct nvscic2c_pcie_submit_copy_batch_args *args)
+{
+	int ret = 0;
+	u64 i = 0;
+	u64 max_desc = 0;
+	struct copy_batch *batch = NULL;
+	struct copy_request *cr = NULL, *tmp = NULL;
+	struct nvscic2c_pcie_submit_copy_args cr_args = {0};
+	struct nvscic2c_pcie_submit_copy_args __user *user_args = NULL;
+	edma_xfer_status_t edma_status = EDMA_XFER_FAIL_INVAL_INPUTS;
+	enum nvscic2c_pcie_link link = NVSCIC2C_PCIE_LINK_DOWN;
+
+	if (WARN_ON(!args->num_copy_requests || !args->copy_requests))
+		return -EINVAL;
+
+	if (args->num_copy_requests > ctx->cr_limits.max_copy_requests ||
+	    args->num_copy_requests > NUM_EDMA_DESC)
+		return -EINVAL;
+
+	/* all the flush ranges of the batch must fit one eDMA ring.*/
+	max_desc = NUM_EDMA_DESC;
+	if (ctx->cr_limits.max_flush_ranges < NUM_EDMA_DESC)
+		max_desc = min_t(u64, max_desc,
+				 args->num_copy_requests *
+				 ctx->cr_limits.max_flush_ranges);
+
+	link = pci_client_query_link_status(ctx->pci_client_h);
+	if (link != NVSCIC2C_PCIE_LINK_UP)
+		return -ENOLINK;
+
+	batch = kvzalloc(struct_size(batch, edma_desc, max_desc), GFP_KERNEL);
+	if (WARN_ON(!batch))
+		return -ENOMEM;
+	batch->ctx = ctx;
+	INIT_LIST_HEAD(&batch->cr_list);
+
+	user_args = (struct nvscic2c_pcie_submit_copy_args __user *)
+		    args->copy_requests;
+	for (i = 0; i < args->num_copy_requests; i++) {
+		if (copy_from_user(&cr_args, &user_args[i], sizeof(cr_args))) {
+			ret = -EFAULT;
+			goto reclaim_batch;
+		}
+
+		ret = prepare_copy_request(ctx, &cr_args, &cr);
+		if (ret)
+			goto reclaim_batch;
+
+		if ((batch->num_edma_desc + cr->num_edma_desc) > max_desc) {
+			reclaim_copy_request(ctx, cr);
+			ret = -EINVAL;
+			goto reclaim_batch;
+		}
+
+		/* chain this copy request's descriptors behind the previous.*/
+		memcpy(&batch->edma_desc[batch->num_edma_desc], cr->edma_desc,
+		       cr->num_edma_desc * sizeof(*cr->edma_desc));
+		batch->num_edma_desc += cr->num_edma_desc;
+		list_add_tail(&cr->node, &batch->cr_list);
+		track_copy_request(ctx, cr);
+	}
+
+	/* schedule asynchronous eDMA for the whole batch.*/
+	atomic_inc(&ctx->transfer_count);
+	edma_status = schedule_edma_xfer(ctx->edma_h, 0, (void *)batch,
+					 batch->num_edma_desc, batch->edma_desc,
+					 callback_edma_batch_xfer);
+	if (edma_status != EDMA_XFER_SUCCESS) {
+		ret = -EIO;
+		atomic_dec(&ctx->transfer_count);
+		goto reclaim_batch;
+	}
 
-reclaim_cr:
-	mutex_lock(&ctx->free_lock);
-	list_add_tail(&cr->node, &ctx->free_list);
-	mutex_unlock(&ctx->free_lock);
+	return ret;
+
+reclaim_batch:
+	list_for_each_entry_safe(cr, tmp, &batch->cr_list, node) {
+		list_del(&cr->node);
+		untrack_copy_request(ctx, cr);
+		reclaim_copy_request(ctx, cr);
+	}
+	kvfree(batch);
 	return ret;
 }
 
@@ -705,6 +975,11 @@ stream_extension_ioctl(void *stream_ext_h, unsigned int cmd, void *args)
 			((struct stream_ext_ctx_t *)ctx,
 			 (struct nvscic2c_pcie_map_obj_args *)args);
 		break;
+	case NVSCIC2C_PCIE_IOCTL_MAP_BATCH:
+		ret = ioctl_map_batch
+			((struct stream_ext_ctx_t *)ctx,
+			 (struct nvscic2c_pcie_map_batch_args *)args);
+		break;
 	case NVSCIC2C_PCIE_IOCTL_GET_AUTH_TOKEN:
 		ret = ioctl_export_obj
 			((struct stream_ext_ctx_t *)ctx,
@@ -725,6 +1000,11 @@ stream_extension_ioctl(void *stream_ext_h, unsigned int cmd, void *args)
 			((struct stream_ext_ctx_t *)ctx,
 			 (struct nvscic2c_pcie_submit_copy_args *)args);
 		break;
+	case NVSCIC2C_PCIE_IOCTL_SUBMIT_COPY_BATCH:
+		ret = ioctl_submit_copy_batch
+			((struct stream_ext_ctx_t *)ctx,
+			 (struct nvscic2c_pcie_submit_copy_batch_args *)args);
+		break;
 	case NVSCIC2C_PCIE_IOCTL_MAX_COPY_REQUESTS:
 		ret = ioctl_set_max_copy_requests
 			((struct stream_ext_ctx_t *)ctx,
@@ -773,6 +1053,7 @@ stream_extension_init(struct stream_ext_params *params, void **stream_ext_h)
 	/* copy operations.*/
 	mutex_init(&ctx->free_lock);
 	INIT_LIST_HEAD(&ctx->free_list);
+	INIT_LIST_HEAD(&ctx->inflight_list);
 	atomic_set(&ctx->transfer_count, 0);
 	init_waitqueue_head(&ctx->transfer_waitq);
 
@@ -935,8 +1216,9 @@ allocate_handle(struct stream_ext_ctx_t *ctx, enum nvscic2c_pcie_obj_type type,
 }
 
 static edma_xfer_status_t
-schedule_edma_xfer(void *edma_h, void *priv, u64 num_desc,
-		   struct tegra_pcie_edma_desc *desc)
+schedule_edma_xfer(void *edma_h, u32 channel_num, void *priv, u64 num_desc,
+		   struct tegra_pcie_edma_desc *desc,
+		   edma_complete_t *complete)
 {
 	struct tegra_pcie_edma_xfer_info info = {0};
 
@@ -944,23 +1226,22 @@ schedule_edma_xfer(void *edma_h, void *priv, u64 num_desc,
 		return -EINVAL;
 
 	info.type = EDMA_XFER_WRITE;
-	info.channel_num = 0; // no use-case to use all WR channels yet.
+	info.channel_num = channel_num;
 	info.desc = desc;
 	info.nents = num_desc;
-	info.complete = callback_edma_xfer;
+	info.complete = complete;
 	info.priv = priv;
 
 	return tegra_pcie_edma_submit_xfer(edma_h, &info);
 }
 
-/* Callback with each async eDMA submit xfer.*/
+/*
+ * signal or fail one copy_request whose eDMA is done, and put it back on the
+ * free list. Must be called with free_lock held.
+ */
 static void
-callback_edma_xfer(void *priv, edma_xfer_status_t status,
-		   struct tegra_pcie_edma_desc *desc)
+complete_copy_request(struct copy_request *cr, edma_xfer_status_t status)
 {
-	struct copy_request *cr = (struct copy_request *)priv;
-
-	mutex_lock(&cr->ctx->free_lock);
 	/* increment post fences: local and remote.*/
 	if (status == EDMA_XFER_SUCCESS) {
 		signal_remote_post_fences(cr);
@@ -977,10 +1258,196 @@ callback_edma_xfer(void *priv, edma_xfer_status_t status,
 
 	/* reclaim the copy_request for reuse.*/
 	list_add_tail(&cr->node, &cr->ctx->free_list);
-	mutex_unlock(&cr->ctx->free_lock);
+}
+
+/* Callback with each async eDMA submit xfer.*/
+static void
+callback_edma_xfer(void *priv, edma_xfer_status_t status,
+		   struct tegra_pcie_edma_desc *desc)
+{
+	struct copy_request *cr = (struct copy_request *)priv;
+	struct stream_ext_ctx_t *ctx = cr->ctx;
+
+	mutex_lock(&ctx->free_lock);
+	retire_copy_request(cr, status);
+	mutex_unlock(&ctx->free_lock);
+
+	if (atomic_dec_and_test(&ctx->transfer_count))
+		wake_up_all(&ctx->transfer_waitq);
+}
+
+/* Callback with each async eDMA submit xfer of a copy batch.*/
+static void
+callback_edma_batch_xfer(void *priv, edma_xfer_status_t status,
+			 struct tegra_pcie_edma_desc *desc)
+{
+	struct copy_batch *batch = (struct copy_batch *)priv;
+	struct stream_ext_ctx_t *ctx = batch->ctx;
+	struct copy_request *cr = NULL, *tmp = NULL;
+
+	/* signal each copy request of the batch, in submission order.*/
+	mutex_lock(&ctx->free_lock);
+	list_for_each_entry_safe(cr, tmp, &batch->cr_list, node) {
+		list_del(&cr->node);
+		retire_copy_request(cr, status);
+	}
+	mutex_unlock(&ctx->free_lock);
+
+	kvfree(batch);
+
+	if (atomic_dec_and_test(&ctx->transfer_count))
+		wake_up_all(&ctx->transfer_waitq);
+}
 
-	if (atomic_dec_and_test(&cr->ctx->transfer_count))
-		wake_up_all(&cr->ctx->transfer_waitq);
+/* all stripes of a copy request are done, retire it.*/
+static void
+finish_copy_stripes(struct copy_request *cr)
+{
+	struct stream_ext_ctx_t *ctx = cr->ctx;
+
+	mutex_lock(&ctx->free_lock);
+	retire_copy_request(cr, READ_ONCE(cr->stripe_status));
+	mutex_unlock(&ctx->free_lock);
+
+	if (atomic_dec_and_test(&ctx->transfer_count))
+		wake_up_all(&ctx->transfer_waitq);
+}
+
+/* Callback with each async eDMA submit xfer of a copy stripe.*/
+static void
+callback_edma_stripe_xfer(void *priv, edma_xfer_status_t status,
+			  struct tegra_pcie_edma_desc *desc)
+{
+	struct copy_stripe *stripe = (struct copy_stripe *)priv;
+	struct copy_request *cr = stripe->cr;
+
+	if (status != EDMA_XFER_SUCCESS)
+		WRITE_ONCE(cr->stripe_status, status);
+
+	if (atomic_dec_and_test(&cr->stripes_pending))
+		finish_copy_stripes(cr);
+}
+
+/*
+ * split every flush range of the copy request into one stripe per eDMA write
+ * channel. Small ranges may occupy fewer channels.
+ */
+static void
+prepare_edma_stripes(struct copy_request *cr)
+{
+	u32 ch = 0;
+	u64 i = 0;
+	u64 off = 0, len = 0, chunk = 0;
+	struct copy_stripe *stripe = NULL;
+	struct tegra_pcie_edma_desc *desc = NULL, *sdesc = NULL;
+
+	for (ch = 0; ch < DMA_WR_CHNL_NUM; ch++)
+		cr->stripes[ch].num_edma_desc = 0;
+
+	for (i = 0; i < cr->num_edma_desc; i++) {
+		desc = &cr->edma_desc[i];
+		chunk = ALIGN(DIV_ROUND_UP((u64)desc->sz, DMA_WR_CHNL_NUM),
+			      STRIPE_ALIGN);
+		for (ch = 0, off = 0; ch < DMA_WR_CHNL_NUM && off < desc->sz;
+		     ch++, off += len) {
+			len = min_t(u64, chunk, desc->sz - off);
+			stripe = &cr->stripes[ch];
+			sdesc = &stripe->edma_desc[stripe->num_edma_desc++];
+			sdesc->src = desc->src + off;
+			sdesc->dst = desc->dst + off;
+			sdesc->sz = len;
+		}
+	}
+}
+
+/*
+ * schedule a copy request striped over all eDMA write channels. It completes
+ * as one unit once the last stripe is done. If only some of the stripes could
+ * be scheduled, the copy request is in flight and fails through the callback
+ * path like any other failed eDMA transfer.
+ */
+static edma_xfer_status_t
+schedule_edma_stripes(struct stream_ext_ctx_t *ctx, struct copy_request *cr)
+{
+	u32 ch = 0;
+	u32 nr_stripes = 0, nr_scheduled = 0;
+	struct copy_stripe *stripe = NULL;
+	edma_xfer_status_t edma_status = EDMA_XFER_SUCCESS;
+
+	prepare_edma_stripes(cr);
+	for (ch = 0; ch < DMA_WR_CHNL_NUM; ch++) {
+		if (cr->stripes[ch].num_edma_desc)
+			nr_stripes++;
+	}
+
+	cr->stripe_status = EDMA_XFER_SUCCESS;
+	atomic_set(&cr->stripes_pending, nr_stripes);
+	for (ch = 0; ch < DMA_WR_CHNL_NUM; ch++) {
+		stripe = &cr->stripes[ch];
+		if (!stripe->num_edma_desc)
+			continue;
+
+		edma_status = schedule_edma_xfer(ctx->edma_h, ch, (void *)stripe,
+						 stripe->num_edma_desc,
+						 stripe->edma_desc,
+						 callback_edma_stripe_xfer);
+		if (edma_status != EDMA_XFER_SUCCESS)
+			break;
+		nr_scheduled++;
+	}
+
+	if (edma_status == EDMA_XFER_SUCCESS || !nr_scheduled)
+		return edma_status;
+
+	/* account the stripes which never made it to eDMA as failed.*/
+	WRITE_ONCE(cr->stripe_status, edma_status);
+	if (atomic_sub_and_test(nr_stripes - nr_scheduled, &cr->stripes_pending))
+		finish_copy_stripes(cr);
+
+	return EDMA_XFER_SUCCESS;
+}
+
+/* add copy_request at the tail of in-flight ones before scheduling eDMA.*/
+static void
+track_copy_request(struct stream_ext_ctx_t *ctx, struct copy_request *cr)
+{
+	mutex_lock(&ctx->free_lock);
+	cr->xfer_done = false;
+	list_add_tail(&cr->inflight_node, &ctx->inflight_list);
+	mutex_unlock(&ctx->free_lock);
+}
+
+/* drop a copy_request whose eDMA could not be scheduled.*/
+static void
+untrack_copy_request(struct stream_ext_ctx_t *ctx, struct copy_request *cr)
+{
+	mutex_lock(&ctx->free_lock);
+	list_del(&cr->inflight_node);
+	mutex_unlock(&ctx->free_lock);
+}
+
+/*
+ * mark the copy_request done and complete all the done ones at the head of the
+ * in-flight list. Must be called with free_lock held.
+ */
+static void
+retire_copy_request(struct copy_request *cr, edma_xfer_status_t status)
+{
+	struct stream_ext_ctx_t *ctx = cr->ctx;
+	struct copy_request *head = NULL;
+
+	cr->xfer_status = status;
+	cr->xfer_done = true;
+
+	while (!list_empty(&ctx->inflight_list)) {
+		head = list_first_entry(&ctx->inflight_list,
+					struct copy_request, inflight_node);
+		if (!head->xfer_done)
+			break;
+
+		list_del(&head->inflight_node);
+		complete_copy_request(head, head->xfer_status);
+	}
 }
 
 static int
@@ -1355,11 +1822,14 @@ copy_args_from_user(struct stream_ext_ctx_t *ctx,
 static void
 free_copy_request(struct copy_request **copy_request)
 {
+	u32 i = 0;
 	struct copy_request *cr = *copy_request;
 
 	if (!cr)
 		return;
 
+	for (i = 0; i < DMA_WR_CHNL_NUM; i++)
+		kfree(cr->stripes[i].edma_desc);
 	kfree(cr->local_post_fences);
 	kfree(cr->remote_post_fences);
 	kfree(cr->remote_buf_objs);
@@ -1375,6 +1845,7 @@ static int
 allocate_copy_request(struct stream_ext_ctx_t *ctx,
 		      struct copy_request **copy_request)
 {
+	u32 i = 0;
 	int ret = 0;
 	struct copy_request *cr = NULL;
 
@@ -1439,6 +1910,19 @@ allocate_copy_request(struct stream_ext_ctx_t *ctx,
 		goto err;
 	}
 
+	/* each stripe can have a part of every flush range.*/
+	for (i = 0; i < DMA_WR_CHNL_NUM; i++) {
+		cr->stripes[i].cr = cr;
+		cr->stripes[i].edma_desc =
+				kzalloc((sizeof(*cr->stripes[i].edma_desc) *
+				ctx->cr_limits.max_flush_ranges),
+				GFP_KERNEL);
+		if (WARN_ON(!cr->stripes[i].edma_desc)) {
+			ret = -ENOMEM;
+			goto err;
+		}
+	}
+
 	*copy_request = cr;
 	return ret;
 err:
@@ -5,6 +5,7 @@
 #define __VMAP_INTERNAL_H__
 
 #include <linux/dma-buf.h>
+#include <linux/hashtable.h>
 #include <linux/pci.h>
 
 #include "common.h"
@@ -13,6 +14,9 @@
 /* forward declaration. */
 struct vmap_ctx_t;
 
+/* buckets of the per object type registry lookups.*/
+#define VMAP_HASH_BITS	(8)
+
 struct memobj_pin_t {
 	/* Input param fd -> dma_buf to be mapped.*/
 	struct dma_buf *dmabuf;
@@ -86,6 +90,7 @@ struct importobj_reg_t {
 struct memobj_map_ref {
 	s32 obj_id;
 	struct kref refcount;
+	struct hlist_node node;
 	struct memobj_pin_t pin;
 	struct vmap_ctx_t *vmap_ctx;
 };
@@ -94,6 +99,7 @@ struct memobj_map_ref {
 struct syncobj_map_ref {
 	s32 obj_id;
 	struct kref refcount;
+	struct hlist_node node;
 	struct syncobj_pin_t pin;
 	struct vmap_ctx_t *vmap_ctx;
 };
@@ -102,6 +108,7 @@ struct syncobj_map_ref {
 struct importobj_map_ref {
 	s32 obj_id;
 	struct kref refcount;
+	struct hlist_node node;
 	struct importobj_reg_t reg;
 	struct vmap_ctx_t *vmap_ctx;
 };
@@ -139,6 +146,15 @@ struct vmap_ctx_t {
 	struct idr sync_idr;
 	struct idr import_idr;
 
+	/*
+	 * Registry of the mapped objects, protected by the idr locks:
+	 * Mem objects hashed by dma_buf, Sync objects by syncpoint Id and
+	 * Import objects by export descriptor.
+	 */
+	DECLARE_HASHTABLE(mem_hash, VMAP_HASH_BITS);
+	DECLARE_HASHTABLE(sync_hash, VMAP_HASH_BITS);
+	DECLARE_HASHTABLE(import_hash, VMAP_HASH_BITS);
+
 	/* exclusive access to mem idr.*/
 	struct mutex mem_idr_lock;
 	/* exclusive access to sync idr.*/
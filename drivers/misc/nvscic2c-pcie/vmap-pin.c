@@ -130,13 +130,37 @@ memobj_clientmngd_unpin(struct vmap_ctx_t *vmap_ctx,
 	}
 }
 
+/* map one run of physically contiguous sg entries.*/
+static int
+clientmngd_map_run(struct vmap_ctx_t *vmap_ctx, struct memobj_pin_t *pin,
+		   u32 nent, u64 iova, phys_addr_t paddr, size_t len, int prot)
+{
+	int ret = 0;
+
+	pin->nents[nent].iova = iova;
+	pin->nents[nent].len = len;
+	ret = pci_client_map_addr(vmap_ctx->pci_client_h, iova, paddr, len,
+				  (IOMMU_CACHE | prot));
+	if (ret < 0) {
+		pr_err("Failed: to iommu_map nent: (%u), size: (%zu)\n",
+		       nent, len);
+		return ret;
+	}
+	pin->nents[nent].mapped_iova = true;
+
+	return ret;
+}
+
 int
 memobj_clientmngd_pin(struct vmap_ctx_t *vmap_ctx,
 		      struct memobj_pin_t *pin)
 {
 	int ret = 0;
 	u64 iova = 0;
+	u32 nent = 0;
 	u32 sg_index = 0;
+	size_t run_len = 0;
+	phys_addr_t run_paddr = 0;
 	int prot = IOMMU_WRITE;
 	struct scatterlist *sg = NULL;
 
@@ -186,25 +210,35 @@ memobj_clientmngd_pin(struct vmap_ctx_t *vmap_ctx,
 		goto err;
 	}
 
+	/*
+	 * iova is contiguous, so sg entries which are physically contiguous
+	 * too are merged and mapped with one call. Each merged run takes one
+	 * nent, the unused ones stay unmapped.
+	 */
 	iova = pin->attrib.iova;
 	for_each_sg(pin->sgt->sgl, sg, pin->sgt->nents, sg_index) {
 		phys_addr_t paddr = (phys_addr_t)(sg_phys(sg));
 
-		pin->nents[sg_index].iova = iova;
-		pin->nents[sg_index].len = sg->length;
-		ret = pci_client_map_addr(vmap_ctx->pci_client_h,
-					  pin->nents[sg_index].iova, paddr,
-					  pin->nents[sg_index].len,
-					  (IOMMU_CACHE | prot));
-		if (ret < 0) {
-			pr_err("Failed: to iommu_map sg_nent: (%u), size: (%u)\n",
-			       sg_index, sg->length);
-			goto err;
+		if (nent && sg_phys(sg) == run_paddr + run_len) {
+			run_len += sg->length;
+			continue;
 		}
-		pin->nents[sg_index].mapped_iova = true;
-
-		/* store information for unmap.*/
-		iova += sg->length;
+		if (run_len) {
+			ret = clientmngd_map_run(vmap_ctx, pin, nent - 1, iova,
+						 run_paddr, run_len, prot);
+			if (ret < 0)
+				goto err;
+			iova += run_len;
+		}
+		run_paddr = paddr;
+		run_len = sg->length;
+		nent++;
+	}
+	if (run_len) {
+		ret = clientmngd_map_run(vmap_ctx, pin, nent - 1, iova,
+					 run_paddr, run_len, prot);
+		if (ret < 0)
+			goto err;
 	}
 
 	return ret;
@@ -30,16 +30,19 @@
 #define SYNCOBJ_END	(MAX_STREAM_SYNCOBJS)
 #define IMPORTOBJ_END	(MAX_STREAM_MEMOBJS + MAX_STREAM_SYNCOBJS)
 
-static int
-match_dmabuf(int id, void *entry, void *data)
+/* must be called with mem idr lock held.*/
+static struct memobj_map_ref *
+memobj_lookup(struct vmap_ctx_t *vmap_ctx, struct dma_buf *dmabuf)
 {
-	struct memobj_map_ref *map = (struct memobj_map_ref *)entry;
+	struct memobj_map_ref *map = NULL;
 
-	if (map->pin.dmabuf == (struct dma_buf *)data)
-		return id;
+	hash_for_each_possible(vmap_ctx->mem_hash, map, node,
+			       (unsigned long)dmabuf) {
+		if (map->pin.dmabuf == dmabuf)
+			return map;
+	}
 
-	/* 0 shall pick-up next entry.*/
-	return 0;
+	return NULL;
 }
 
 static int
@@ -48,7 +51,6 @@ memobj_map(struct vmap_ctx_t *vmap_ctx,
 	   struct vmap_obj_attributes *attrib)
 {
 	int ret = 0;
-	s32 id_exist = 0;
 	struct memobj_map_ref *map = NULL;
 	struct dma_buf *dmabuf = NULL;
 
@@ -62,9 +64,7 @@ memobj_map(struct vmap_ctx_t *vmap_ctx,
 	mutex_lock(&vmap_ctx->mem_idr_lock);
 
 	/* check if the dma_buf is already mapped ? */
-	id_exist = idr_for_each(&vmap_ctx->mem_idr, match_dmabuf, &dmabuf);
-	if (id_exist > 0)
-		map = idr_find(&vmap_ctx->mem_idr, id_exist);
+	map = memobj_lookup(vmap_ctx, dmabuf);
 
 	if (map) {
 		/* already mapped.*/
@@ -113,6 +113,7 @@ memobj_map(struct vmap_ctx_t *vmap_ctx,
 			kfree(map);
 			goto err;
 		}
+		hash_add(vmap_ctx->mem_hash, &map->node, (unsigned long)dmabuf);
 	}
 
 	attrib->type = VMAP_OBJ_TYPE_MEM;
@@ -137,6 +138,7 @@ memobj_free(struct kref *kref)
 
 	map = container_of(kref, struct memobj_map_ref, refcount);
 	if (map) {
+		hash_del(&map->node);
 		memobj_unpin(map->vmap_ctx, &map->pin);
 		idr_remove(&map->vmap_ctx->mem_idr, map->obj_id);
 		kfree(map);
@@ -185,16 +187,18 @@ memobj_getref(struct vmap_ctx_t *vmap_ctx, s32 obj_id)
 	return 0;
 }
 
-static int
-match_syncpt_id(int id, void *entry, void *data)
+/* must be called with sync idr lock held.*/
+static struct syncobj_map_ref *
+syncobj_lookup(struct vmap_ctx_t *vmap_ctx, u32 syncpt_id)
 {
-	struct syncobj_map_ref *map = (struct syncobj_map_ref *)entry;
+	struct syncobj_map_ref *map = NULL;
 
-	if (map->pin.syncpt_id == *((u32 *)data))
-		return id;
+	hash_for_each_possible(vmap_ctx->sync_hash, map, node, syncpt_id) {
+		if (map->pin.syncpt_id == syncpt_id)
+			return map;
+	}
 
-	/* 0 shall pick-up next entry.*/
-	return 0;
+	return NULL;
 }
 
 static int
@@ -203,7 +207,6 @@ syncobj_map(struct vmap_ctx_t *vmap_ctx,
 	    struct vmap_obj_attributes *attrib)
 {
 	int ret = 0;
-	s32 id_exist = 0;
 	u32 syncpt_id = 0;
 	struct syncobj_map_ref *map = NULL;
 
@@ -211,10 +214,7 @@ syncobj_map(struct vmap_ctx_t *vmap_ctx,
 	mutex_lock(&vmap_ctx->sync_idr_lock);
 
 	/* check if the syncpt is already mapped ? */
-	id_exist = idr_for_each(&vmap_ctx->sync_idr, match_syncpt_id,
-				&syncpt_id);
-	if (id_exist > 0)
-		map = idr_find(&vmap_ctx->sync_idr, id_exist);
+	map = syncobj_lookup(vmap_ctx, syncpt_id);
 
 	if (map) {
 		/* mapping again a SYNC obj(local or remote) is not permitted.*/
@@ -253,6 +253,7 @@ syncobj_map(struct vmap_ctx_t *vmap_ctx,
 			kfree(map);
 			goto err;
 		}
+		hash_add(vmap_ctx->sync_hash, &map->node, syncpt_id);
 		attrib->type = VMAP_OBJ_TYPE_SYNC;
 		attrib->id = map->obj_id;
 		attrib->iova = map->pin.attrib.iova;
@@ -277,6 +278,7 @@ syncobj_free(struct kref *kref)
 
 	map = container_of(kref, struct syncobj_map_ref, refcount);
 	if (map) {
+		hash_del(&map->node);
 		syncobj_unpin(map->vmap_ctx, &map->pin);
 		idr_remove(&map->vmap_ctx->sync_idr, map->obj_id);
 		kfree(map);
@@ -328,16 +330,18 @@ syncobj_getref(struct vmap_ctx_t *vmap_ctx, s32 obj_id)
 	return 0;
 }
 
-static int
-match_export_desc(int id, void *entry, void *data)
+/* must be called with import idr lock held.*/
+static struct importobj_map_ref *
+importobj_lookup(struct vmap_ctx_t *vmap_ctx, u64 export_desc)
 {
-	struct importobj_map_ref *map = (struct importobj_map_ref *)entry;
+	struct importobj_map_ref *map = NULL;
 
-	if (map->reg.export_desc == *((u64 *)data))
-		return id;
+	hash_for_each_possible(vmap_ctx->import_hash, map, node, export_desc) {
+		if (map->reg.export_desc == export_desc)
+			return map;
+	}
 
-	/* 0 shall pick-up next entry.*/
-	return 0;
+	return NULL;
 }
 
 static int
@@ -346,16 +350,12 @@ importobj_map(struct vmap_ctx_t *vmap_ctx,
 	      struct vmap_obj_attributes *attrib)
 {
 	int ret = 0;
-	s32 id_exist = 0;
 	struct importobj_map_ref *map = NULL;
 
 	mutex_lock(&vmap_ctx->import_idr_lock);
 
 	/* check if we have export descriptor from remote already ? */
-	id_exist = idr_for_each(&vmap_ctx->import_idr, match_export_desc,
-				&params->export_desc);
-	if (id_exist > 0)
-		map = idr_find(&vmap_ctx->import_idr, id_exist);
+	map = importobj_lookup(vmap_ctx, params->export_desc);
 
 	if (!map) {
 		ret = -EAGAIN;
@@ -393,6 +393,7 @@ importobj_free(struct kref *kref)
 
 	map = container_of(kref, struct importobj_map_ref, refcount);
 	if (map) {
+		hash_del(&map->node);
 		idr_remove(&map->vmap_ctx->import_idr, map->obj_id);
 		kfree(map);
 	}
@@ -591,7 +592,6 @@ vmap_importobj_register(void *data, void *ctx)
 	struct vmap_ctx_t *vmap_ctx = (struct vmap_ctx_t *)ctx;
 	struct comm_msg *msg = (struct comm_msg *)data;
 	struct importobj_map_ref *map = NULL;
-	s32 id_exist = 0;
 
 	WARN_ON(!vmap_ctx);
 	WARN_ON(!msg);
@@ -600,10 +600,7 @@ vmap_importobj_register(void *data, void *ctx)
 	mutex_lock(&vmap_ctx->import_idr_lock);
 
 	/* check if we have export descriptor from remote already ? */
-	id_exist = idr_for_each(&vmap_ctx->import_idr, match_export_desc,
-				&msg->u.reg.export_desc);
-	if (id_exist > 0)
-		map = idr_find(&vmap_ctx->import_idr, id_exist);
+	map = importobj_lookup(vmap_ctx, msg->u.reg.export_desc);
 
 	if (map) {
 		if (msg->u.reg.iova != map->reg.attrib.iova) {
@@ -643,6 +640,8 @@ vmap_importobj_register(void *data, void *ctx)
 			kfree(map);
 			goto err;
 		}
+		hash_add(vmap_ctx->import_hash, &map->node,
+			 map->reg.export_desc);
 		pr_debug("Registered descriptor: (%llu)\n", map->reg.export_desc);
 	}
 err:
@@ -671,6 +670,9 @@ vmap_init(struct driver_ctx_t *drv_ctx, void **vmap_h)
 	idr_init(&vmap_ctx->mem_idr);
 	idr_init(&vmap_ctx->sync_idr);
 	idr_init(&vmap_ctx->import_idr);
+	hash_init(vmap_ctx->mem_hash);
+	hash_init(vmap_ctx->sync_hash);
+	hash_init(vmap_ctx->import_hash);
 	mutex_init(&vmap_ctx->mem_idr_lock);
 	mutex_init(&vmap_ctx->sync_idr_lock);
 	mutex_init(&vmap_ctx->import_idr_lock);
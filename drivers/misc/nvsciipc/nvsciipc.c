@@ -24,6 +24,11 @@
 #include <linux/cred.h>
 #include <linux/of.h>
 #include <linux/fs.h>
+#include <linux/hash.h>
+#include <linux/jhash.h>
+#include <linux/log2.h>
+#include <linux/rculist.h>
+#include <linux/rcupdate.h>
 
 #ifdef CONFIG_TEGRA_VIRTUALIZATION
 #include <soc/tegra/virt/syscalls.h>
@@ -51,6 +56,123 @@ static struct nvsciipc *ctx;
 static int32_t s_guestid = -1;
 #endif /* CONFIG_TEGRA_VIRTUALIZATION */
 
+static uint32_t nvsciipc_name_hash(const char *name, uint32_t bits)
+{
+	return hash_32(jhash(name, strnlen(name, NVSCIIPC_MAX_EP_NAME), 0),
+		bits);
+}
+
+/*
+ * Both lookups must be called under rcu_read_lock(). Entries are linked
+ * in reverse database order, so the first match is the lowest index as
+ * with a linear search.
+ */
+static struct nvsciipc_db_node *nvsciipc_find_by_name(struct nvsciipc *ctx,
+		const char *name)
+{
+	struct nvsciipc_db_index *index = rcu_dereference(ctx->index);
+	struct nvsciipc_db_node *node;
+
+	if (index == NULL)
+		return NULL;
+
+	hlist_for_each_entry_rcu(node,
+			&index->by_name[nvsciipc_name_hash(name, index->hash_bits)],
+			name_node) {
+		if (!strncmp(name, node->entry->ep_name, NVSCIIPC_MAX_EP_NAME))
+			return node;
+	}
+
+	return NULL;
+}
+
+static struct nvsciipc_db_node *nvsciipc_find_by_vuid(struct nvsciipc *ctx,
+		uint64_t vuid)
+{
+	struct nvsciipc_db_index *index = rcu_dereference(ctx->index);
+	struct nvsciipc_db_node *node;
+
+	if (index == NULL)
+		return NULL;
+
+	hlist_for_each_entry_rcu(node,
+			&index->by_vuid[hash_64(vuid, index->hash_bits)],
+			vuid_node) {
+		if (node->entry->vuid == vuid)
+			return node;
+	}
+
+	return NULL;
+}
+
+static void nvsciipc_free_index(struct nvsciipc_db_index *index)
+{
+	if (index == NULL)
+		return;
+
+	kvfree(index->nodes);
+	kvfree(index->by_vuid);
+	kvfree(index->by_name);
+	kfree(index);
+}
+
+/* Called with nvsciipc_mutex held once ctx->db is complete */
+static int nvsciipc_build_index(struct nvsciipc *ctx)
+{
+	struct nvsciipc_db_index *index, *old;
+	struct nvsciipc_db_node *node;
+	uint32_t buckets;
+	int i;
+
+	index = kzalloc(sizeof(*index), GFP_KERNEL);
+	if (index == NULL)
+		return -ENOMEM;
+
+	buckets = roundup_pow_of_two(ctx->num_eps);
+	index->hash_bits = ilog2(buckets);
+	index->by_name = kvcalloc(buckets, sizeof(*index->by_name), GFP_KERNEL);
+	index->by_vuid = kvcalloc(buckets, sizeof(*index->by_vuid), GFP_KERNEL);
+	index->nodes = kvcalloc(ctx->num_eps, sizeof(*index->nodes), GFP_KERNEL);
+	if ((index->by_name == NULL) || (index->by_vuid == NULL) ||
+	    (index->nodes == NULL)) {
+		nvsciipc_free_index(index);
+		return -ENOMEM;
+	}
+
+	for (i = ctx->num_eps - 1; i >= 0; i--) {
+		node = &index->nodes[i];
+		node->entry = ctx->db[i];
+		node->idx = i;
+		hlist_add_head(&node->name_node, &index->by_name[
+			nvsciipc_name_hash(node->entry->ep_name, index->hash_bits)]);
+		hlist_add_head(&node->vuid_node, &index->by_vuid[
+			hash_64(node->entry->vuid, index->hash_bits)]);
+	}
+
+	old = rcu_dereference_protected(ctx->index,
+			lockdep_is_held(&nvsciipc_mutex));
+	rcu_assign_pointer(ctx->index, index);
+	if (old != NULL) {
+		synchronize_rcu();
+		nvsciipc_free_index(old);
+	}
+
+	return 0;
+}
+
+static void nvsciipc_drop_index(struct nvsciipc *ctx)
+{
+	struct nvsciipc_db_index *index;
+
+	index = rcu_dereference_protected(ctx->index, true);
+	if (index == NULL)
+		return;
+
+	RCU_INIT_POINTER(ctx->index, NULL);
+	synchronize_rcu();
+	nvsciipc_free_index(index);
+}
+
 NvSciError NvSciIpcEndpointGetAuthToken(NvSciIpcEndpoint handle,
 		NvSciIpcEndpointAuthToken *authToken)
 {
@@ -129,8 +251,8 @@ NvSciError NvSciIpcEndpointMapVuid(NvSciIpcEndpointVuid localUserVuid,
 		NvSciIpcTopoId *peerTopoId, NvSciIpcEndpointVuid *peerUserVuid)
 {
 	uint32_t backend = NVSCIIPC_BACKEND_UNKNOWN;
-	struct nvsciipc_config_entry *entry;
-	int i;
+	struct nvsciipc_db_node *node;
+	struct nvsciipc_config_entry entry;
 	NvSciError ret;
 
 	if ((peerTopoId == NULL) || (peerUserVuid == NULL)) {
@@ -143,15 +265,15 @@ NvSciError NvSciIpcEndpointMapVuid(NvSciIpcEndpointVuid localUserVuid,
 		return NvSciError_NotInitialized;
 	}
 
-	for (i = 0; i < ctx->num_eps; i++) {
-		if (ctx->db[i]->vuid == localUserVuid) {
-			backend = ctx->db[i]->backend;
-			entry = ctx->db[i];
-			break;
-		}
+	rcu_read_lock();
+	node = nvsciipc_find_by_vuid(ctx, localUserVuid);
+	if (node != NULL) {
+		entry = *node->entry;
+		backend = entry.backend;
 	}
+	rcu_read_unlock();
 
-	if (i == ctx->num_eps) {
+	if (node == NULL) {
 		ERR("wrong localUserVuid passed\n");
 		return NvSciError_BadParameter;
 	}
@@ -170,9 +292,9 @@ NvSciError NvSciIpcEndpointMapVuid(NvSciIpcEndpointVuid localUserVuid,
 			union nvsciipc_vuid_64 vuid64;
 
 			peerTopoId->SocId = NVSCIIPC_SELF_SOCID;
-			peerTopoId->VmId = entry->peer_vmid;
-			vuid64.value = entry->vuid;
-			vuid64.bit.vmid = entry->peer_vmid;
+			peerTopoId->VmId = entry.peer_vmid;
+			vuid64.value = entry.vuid;
+			vuid64.bit.vmid = entry.peer_vmid;
 			*peerUserVuid = vuid64.value;
 
 			ret = NvSciError_Success;
@@ -202,6 +324,8 @@ static void nvsciipc_free_db(struct nvsciipc *ctx)
 {
 	int i;
 
+	nvsciipc_drop_index(ctx);
+
 	if ((ctx->num_eps != 0) && (ctx->set_db_f == true)) {
 		for (i = 0; i < ctx->num_eps; i++)
 			kfree(ctx->db[i]);
@@ -301,7 +425,7 @@ static int nvsciipc_ioctl_get_db_by_name(struct nvsciipc *ctx, unsigned int cmd,
 		unsigned long arg)
 {
 	struct nvsciipc_get_db_by_name get_db;
-	int i;
+	struct nvsciipc_db_node *node;
 
 	if ((ctx->num_eps == 0) || (ctx->set_db_f != true)) {
 		ERR("%s[%d] need to set endpoint database first\n", __func__,
@@ -315,16 +439,15 @@ static int nvsciipc_ioctl_get_db_by_name(struct nvsciipc *ctx, unsigned int cmd,
 	}
 
 	/* read operation */
-	for (i = 0; i < ctx->num_eps; i++) {
-		if (!strncmp(get_db.ep_name, ctx->db[i]->ep_name,
-			NVSCIIPC_MAX_EP_NAME)) {
-			get_db.entry = *ctx->db[i];
-			get_db.idx = i;
-			break;
-		}
+	rcu_read_lock();
+	node = nvsciipc_find_by_name(ctx, get_db.ep_name);
+	if (node != NULL) {
+		get_db.entry = *node->entry;
+		get_db.idx = node->idx;
 	}
+	rcu_read_unlock();
 
-	if (i == ctx->num_eps) {
+	if (node == NULL) {
 		INFO("%s: no entry (%s)\n", __func__, get_db.ep_name);
 		return -ENOENT;
 	} else if (copy_to_user((void __user *)arg, &get_db,
@@ -340,7 +463,7 @@ static int nvsciipc_ioctl_get_db_by_vuid(struct nvsciipc *ctx, unsigned int cmd,
 		unsigned long arg)
 {
 	struct nvsciipc_get_db_by_vuid get_db;
-	int i;
+	struct nvsciipc_db_node *node;
 
 	if ((ctx->num_eps == 0) || (ctx->set_db_f != true)) {
 		ERR("%s[%d] need to set endpoint database first\n", __func__,
@@ -354,15 +477,15 @@ static int nvsciipc_ioctl_get_db_by_vuid(struct nvsciipc *ctx, unsigned int cmd,
 	}
 
 	/* read operation */
-	for (i = 0; i < ctx->num_eps; i++) {
-		if (get_db.vuid == ctx->db[i]->vuid) {
-			get_db.entry = *ctx->db[i];
-			get_db.idx = i;
-			break;
-		}
+	rcu_read_lock();
+	node = nvsciipc_find_by_vuid(ctx, get_db.vuid);
+	if (node != NULL) {
+		get_db.entry = *node->entry;
+		get_db.idx = node->idx;
 	}
+	rcu_read_unlock();
 
-	if (i == ctx->num_eps) {
+	if (node == NULL) {
 		INFO("%s: no entry (0x%llx)\n", __func__, get_db.vuid);
 		return -ENOENT;
 	} else if (copy_to_user((void __user *)arg, &get_db,
@@ -378,7 +501,7 @@ static int nvsciipc_ioctl_get_vuid(struct nvsciipc *ctx, unsigned int cmd,
 		unsigned long arg)
 {
 	struct nvsciipc_get_vuid get_vuid;
-	int i;
+	struct nvsciipc_db_node *node;
 
 	if ((ctx->num_eps == 0) || (ctx->set_db_f != true)) {
 		ERR("%s[%d] need to set endpoint database first\n", __func__,
@@ -392,15 +515,13 @@ static int nvsciipc_ioctl_get_vuid(struct nvsciipc *ctx, unsigned int cmd,
 	}
 
 	/* read operation */
-	for (i = 0; i < ctx->num_eps; i++) {
-		if (!strncmp(get_vuid.ep_name, ctx->db[i]->ep_name,
-			NVSCIIPC_MAX_EP_NAME)) {
-			get_vuid.vuid = ctx->db[i]->vuid;
-			break;
-		}
-	}
+	rcu_read_lock();
+	node = nvsciipc_find_by_name(ctx, get_vuid.ep_name);
+	if (node != NULL)
+		get_vuid.vuid = node->entry->vuid;
+	rcu_read_unlock();
 
-	if (i == ctx->num_eps) {
+	if (node == NULL) {
 		INFO("%s: no entry (%s)\n", __func__, get_vuid.ep_name);
 		return -ENOENT;
 	} else if (copy_to_user((void __user *)arg, &get_vuid,
@@ -523,6 +644,12 @@ static int nvsciipc_ioctl_set_db(struct nvsciipc *ctx, unsigned int cmd,
 	}
 #endif /* CONFIG_TEGRA_VIRTUALIZATION */
 
+	ret = nvsciipc_build_index(ctx);
+	if (ret < 0) {
+		ERR("building db index failed\n");
+		goto ptr_error;
+	}
+
 	kfree(entry_ptr);
 
 	ctx->set_db_f = true;
@@ -532,6 +659,8 @@ static int nvsciipc_ioctl_set_db(struct nvsciipc *ctx, unsigned int cmd,
 	return ret;
 
 ptr_error:
+	nvsciipc_drop_index(ctx);
+
 	if (ctx->db != NULL) {
 		for (i = 0; i < ctx->num_eps; i++) {
 			if (ctx->db[i] != NULL) {
@@ -24,6 +24,21 @@
 #define NVSCIIPC_BACKEND_C2C_NPM	4U
 #define NVSCIIPC_BACKEND_UNKNOWN	0xFFFFFFFFU
 
+/* Hash lookup of the endpoint database by name and by VUID */
+struct nvsciipc_db_node {
+	struct hlist_node name_node;
+	struct hlist_node vuid_node;
+	struct nvsciipc_config_entry *entry;
+	uint32_t idx;
+};
+
+struct nvsciipc_db_index {
+	uint32_t hash_bits;
+	struct hlist_head *by_name;
+	struct hlist_head *by_vuid;
+	struct nvsciipc_db_node *nodes;
+};
+
 struct nvsciipc {
 	struct device *dev;
 
@@ -35,6 +50,7 @@ struct nvsciipc {
 
 	int num_eps;
 	struct nvsciipc_config_entry **db;
+	struct nvsciipc_db_index __rcu *index;
 	volatile bool set_db_f;
 };
 
@@ -83,10 +83,8 @@ static void  tegra_pci_dma_put_host_bridge_device(struct device *dev)
 	kobject_put(&dev->kobj);
 }
 
-/* debugfs to perform eDMA lib transfers */
-static int edmalib_test(struct seq_file *s, void *data)
+static void edmalib_prepare(struct ep_pvt *ep)
 {
-	struct ep_pvt *ep = (struct ep_pvt *)dev_get_drvdata(s->private);
 	struct pcie_epf_bar0 *epf_bar0 = (__force struct pcie_epf_bar0 *)ep->bar0_virt;
 	 /* RP uses 128M(used by EP) + 1M(reserved) offset for source and dest data transfers */
 	dma_addr_t ep_dma_addr = epf_bar0->ep_phy_addr + SZ_128M + SZ_1M;
@@ -120,13 +118,32 @@ static int edmalib_test(struct seq_file *s, void *data)
 		ep->edma.of_node = rdev->of_node;
 		ep->edma.dst_dma_addr = bar0_dma_addr;
 	}
+}
+
+/* debugfs to perform eDMA lib transfers */
+static int edmalib_test(struct seq_file *s, void *data)
+{
+	struct ep_pvt *ep = (struct ep_pvt *)dev_get_drvdata(s->private);
+
+	edmalib_prepare(ep);
 
 	return edmalib_common_test(&ep->edma);
 }
 
+/* debugfs to benchmark eDMA lib transfers */
+static int edmalib_bench(struct seq_file *s, void *data)
+{
+	struct ep_pvt *ep = (struct ep_pvt *)dev_get_drvdata(s->private);
+
+	edmalib_prepare(ep);
+
+	return edmalib_common_bench(&ep->edma, s);
+}
+
 static void init_debugfs(struct ep_pvt *ep)
 {
 	debugfs_create_devm_seqfile(&ep->pdev->dev, "edmalib_test", ep->debugfs, edmalib_test);
+	debugfs_create_devm_seqfile(&ep->pdev->dev, "edmalib_bench", ep->debugfs, edmalib_bench);
 
 	debugfs_create_u32("edma_ch", 0644, ep->debugfs, &ep->edma.edma_ch);
 	/* Enable remote dma ASYNC for ch 0 as default */
@@ -37,6 +37,20 @@
 static uint32_t total_instance_id;
 #endif
 
+/* Upper limit of data requests in flight on the IVC channel */
+#define VMTD_MAX_REQS	16U
+
+/*
+ * A data request in flight. Request i uses the mempool window at
+ * i * io_bytes and carries i as req_id.
+ */
+struct vmtd_req {
+	loff_t offset;
+	uint32_t size;
+	u_char *buf;
+	bool busy;
+};
+
 struct vmtd_dev {
 	struct vs_config_info config;
 	uint64_t size;                   /* Device size in bytes */
@@ -49,6 +63,9 @@ struct vmtd_dev {
 	struct mutex lock;
 	struct completion msg_complete;
 	void *cmd_frame;
+	struct vmtd_req reqs[VMTD_MAX_REQS];
+	uint32_t max_requests;
+	uint32_t io_bytes;
 	struct mtd_info mtd;
 	bool is_setup;
 #if (IS_ENABLED(CONFIG_TEGRA_HSIERRRPTINJ))
@@ -202,6 +219,122 @@ static int vmtd_get_configinfo(struct vmtd_dev *vmtddev,
 	return 0;
 }
 
+/* Issues one chunk of a read or write on the free request req_id. */
+static int vmtd_issue_data_req(struct vmtd_dev *vmtddev, uint32_t req_id,
+	enum mtd_cmd_op op, loff_t offset, uint32_t size, u_char *buf)
+{
+	struct vs_request *vs_req = (struct vs_request *)vmtddev->cmd_frame;
+	struct vmtd_req *req = &vmtddev->reqs[req_id];
+	uint32_t data_offset = req_id * vmtddev->io_bytes;
+
+	vs_req->type = VS_DATA_REQ;
+	vs_req->mtddev_req.req_op = op;
+	vs_req->mtddev_req.mtd_req.offset = offset;
+	vs_req->mtddev_req.mtd_req.size = size;
+	vs_req->mtddev_req.mtd_req.data_offset = data_offset;
+	vs_req->req_id = req_id;
+
+	if (op == VS_MTD_WRITE)
+		memcpy(vmtddev->shared_buffer + data_offset, buf, size);
+
+	req->offset = offset;
+	req->size = size;
+	req->buf = buf;
+	req->busy = true;
+
+	return vmtd_send_cmd(vmtddev, vs_req);
+}
+
+/* Retires the request a response was fetched for. */
+static int vmtd_complete_data_req(struct vmtd_dev *vmtddev,
+	struct vs_request *vs_resp, enum mtd_cmd_op op)
+{
+	struct vmtd_req *req;
+
+	if ((vs_resp->req_id >= vmtddev->max_requests) ||
+		!vmtddev->reqs[vs_resp->req_id].busy) {
+		dev_err(vmtddev->device, "response for unknown request %u!\n",
+			vs_resp->req_id);
+		return -EIO;
+	}
+
+	req = &vmtddev->reqs[vs_resp->req_id];
+	req->busy = false;
+
+	if ((vs_resp->status != 0) ||
+		(vs_resp->mtddev_resp.mtd_resp.status != 0)) {
+		dev_err(vmtddev->device,
+			"Response status for offset %llx size %x failed!\n",
+			req->offset, req->size);
+		return -EIO;
+	}
+
+	if (vs_resp->mtddev_resp.mtd_resp.size != req->size) {
+		dev_err(vmtddev->device,
+			"size mismatch for offset %llx size %x returned %x!\n",
+			req->offset, req->size,
+			vs_resp->mtddev_resp.mtd_resp.size);
+		return -EIO;
+	}
+
+	if (op == VS_MTD_READ)
+		memcpy(req->buf, vmtddev->shared_buffer +
+			(vs_resp->req_id * vmtddev->io_bytes), req->size);
+
+	return 0;
+}
+
+/*
+ * Splits a read or write into chunks of at most max_io_bytes and keeps up
+ * to max_requests of them in flight, each in its own mempool window, so
+ * that the server works on the next chunk while the previous one is
+ * copied. Called with vmtddev->lock held.
+ */
+static int vmtd_rw(struct vmtd_dev *vmtddev, enum mtd_cmd_op op,
+	loff_t offset, size_t len, u_char *buf, uint32_t max_io_bytes)
+{
+	struct vs_request vs_resp;
+	uint32_t inflight = 0;
+	uint32_t req_id = 0;
+	uint32_t size;
+	int32_t err = 0;
+	int32_t ret;
+
+	while ((len != 0 && err == 0) || inflight != 0) {
+		while (len != 0 && err == 0 &&
+			inflight < vmtddev->max_requests) {
+			while (vmtddev->reqs[req_id].busy)
+				req_id = (req_id + 1) % vmtddev->max_requests;
+
+			size = min_t(size_t, max_io_bytes, len);
+			ret = vmtd_issue_data_req(vmtddev, req_id, op, offset,
+				size, buf);
+			if (ret != 0) {
+				vmtddev->reqs[req_id].busy = false;
+				return ret;
+			}
+
+			inflight++;
+			buf += size;
+			offset += size;
+			len -= size;
+		}
+
+		/* A broken channel fails the whole transfer right away */
+		ret = vmtd_get_resp(vmtddev, &vs_resp);
+		if (ret != 0)
+			return ret;
+		inflight--;
+
+		/* Otherwise drain the requests in flight before failing */
+		ret = vmtd_complete_data_req(vmtddev, &vs_resp, op);
+		if (ret != 0 && err == 0)
+			err = ret;
+	}
+
+	return err;
+}
+
 /*
  * Read an address range from the flash chip.  The address range
  * may be any size provided it is within the physical boundaries.
@@ -210,10 +343,7 @@ static int vmtd_read(struct mtd_info *mtd, loff_t from, size_t len,
 		size_t *retlen, u_char *buf)
 {
 	struct vmtd_dev *vmtddev = mtd_to_vmtd(mtd);
-	struct vs_request *vs_req;
 	size_t remaining_size = len;
-	size_t read_size;
-	u_char *buf_addr = buf;
 	loff_t offset = from;
 	int32_t ret = 0;
 
@@ -229,29 +359,13 @@ static int vmtd_read(struct mtd_info *mtd, loff_t from, size_t len,
 	}
 
 	mutex_lock(&vmtddev->lock);
-	while (remaining_size) {
-		read_size = min_t(size_t, (size_t)vmtddev->config.mtd_config.max_read_bytes_per_io,
-				remaining_size);
-		vs_req = (struct vs_request *)vmtddev->cmd_frame;
-		vs_req->type = VS_DATA_REQ;
-		vs_req->mtddev_req.req_op = VS_MTD_READ;
-		vs_req->mtddev_req.mtd_req.offset = offset;
-		vs_req->mtddev_req.mtd_req.size = read_size;
-		vs_req->mtddev_req.mtd_req.data_offset = 0;
-		vs_req->req_id = 0;
-
-		ret = vmtd_process_request(vmtddev, vs_req);
-		if (ret != 0) {
-			dev_err(vmtddev->device,
-				"Read for offset %llx size %lx failed!\n",
-				offset, read_size);
-			goto fail;
-		}
-
-		memcpy(buf_addr, vmtddev->shared_buffer, read_size);
-		buf_addr += read_size;
-		offset += read_size;
-		remaining_size -= read_size;
+	ret = vmtd_rw(vmtddev, VS_MTD_READ, offset, remaining_size, buf,
+		vmtddev->config.mtd_config.max_read_bytes_per_io);
+	if (ret != 0) {
+		dev_err(vmtddev->device,
+			"Read for offset %llx size %lx failed!\n",
+			offset, remaining_size);
+		goto fail;
 	}
 	*retlen = len;
 
@@ -268,10 +382,7 @@ static int vmtd_write(struct mtd_info *mtd, loff_t to, size_t len,
 		size_t *retlen, const u_char *buf)
 {
 	struct vmtd_dev *vmtddev = mtd_to_vmtd(mtd);
-	struct vs_request *vs_req;
 	size_t remaining_size = len;
-	size_t write_size;
-	const u_char *buf_addr = buf;
 	loff_t offset = to;
 	int32_t ret = 0;
 
@@ -286,31 +397,15 @@ static int vmtd_write(struct mtd_info *mtd, loff_t to, size_t len,
 	}
 
 	mutex_lock(&vmtddev->lock);
-	while (remaining_size) {
-		write_size = min_t(size_t,
-			(size_t)vmtddev->config.mtd_config.max_write_bytes_per_io,
-				remaining_size);
-		vs_req = (struct vs_request *)vmtddev->cmd_frame;
-		vs_req->type = VS_DATA_REQ;
-		vs_req->mtddev_req.req_op = VS_MTD_WRITE;
-		vs_req->mtddev_req.mtd_req.offset = offset;
-		vs_req->mtddev_req.mtd_req.size = write_size;
-		vs_req->mtddev_req.mtd_req.data_offset = 0;
-		vs_req->req_id = 0;
-
-		memcpy(vmtddev->shared_buffer, buf_addr, write_size);
-
-		ret = vmtd_process_request(vmtddev, vs_req);
-		if (ret != 0) {
-			dev_err(vmtddev->device,
-				"write for offset %llx size %lx failed!\n",
-				offset, write_size);
-			goto fail;
-		}
-
-		buf_addr += write_size;
-		offset += write_size;
-		remaining_size -= write_size;
+	/* write requests only read from buf */
+	ret = vmtd_rw(vmtddev, VS_MTD_WRITE, offset, remaining_size,
+		(u_char *)buf,
+		vmtddev->config.mtd_config.max_write_bytes_per_io);
+	if (ret != 0) {
+		dev_err(vmtddev->device,
+			"write for offset %llx size %lx failed!\n",
+			offset, remaining_size);
+		goto fail;
 	}
 	*retlen = len;
 
@@ -438,6 +533,23 @@ static int vmtd_setup_device(struct vmtd_dev *vmtddev)
 			vmtddev->ivmk->size;
 	}
 
+	/*
+	 * Split the mempool into one window per request in flight, bounded
+	 * by the frames of the IVC channel. A mempool that fits a single
+	 * transfer keeps the requests serialized.
+	 */
+	vmtddev->io_bytes = max(vmtddev->config.mtd_config.max_read_bytes_per_io,
+		vmtddev->config.mtd_config.max_write_bytes_per_io);
+	vmtddev->max_requests = 1;
+	if (vmtddev->io_bytes != 0)
+		vmtddev->max_requests = min3(
+			(uint32_t)(vmtddev->ivmk->size / vmtddev->io_bytes),
+			(uint32_t)vmtddev->ivck->nframes, VMTD_MAX_REQS);
+	if (vmtddev->max_requests == 0)
+		vmtddev->max_requests = 1;
+	dev_info(vmtddev->device, "%u requests in flight\n",
+		vmtddev->max_requests);
+
 	vmtddev->mtd.dev.parent = vmtddev->device;
 	vmtddev->mtd.writebufsize = 1;
 
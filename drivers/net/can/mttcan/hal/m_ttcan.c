@@ -500,6 +500,12 @@ void ttcan_tx_trigger_msg_transmit(struct ttcan_controller *ttcan, u8 index)
 	ttcan_write32(ttcan, ADR_MTTCAN_TXBAR, (1 << index));
 }
 
+/* Set add request for several Tx buffers with a single register write */
+void ttcan_tx_trigger_msgs_transmit(struct ttcan_controller *ttcan, u32 txbar)
+{
+	ttcan_write32(ttcan, ADR_MTTCAN_TXBAR, txbar);
+}
+
 int ttcan_tx_msg_buffer_write(struct ttcan_controller *ttcan,
 			      struct ttcanfd_frame *ttcanfd)
 {
@@ -579,6 +585,11 @@ int ttcan_tx_fifo_queue_msg(struct ttcan_controller *ttcan,
 {
 	u32 txfqs_reg;
 	u32 put_idx;
+	u32 ded_num = ttcan->tx_config.ded_buff_num;
+	u32 fifo_num = ttcan->tx_config.fifo_q_num;
+	u32 fifo_bmsk = ((1 << fifo_num) - 1) << ded_num;
+	u32 pending = hweight32(ttcan->tx_pending & fifo_bmsk);
+	u32 free_level;
 
 	txfqs_reg = ttcan_read32(ttcan, ADR_MTTCAN_TXFQS);
 
@@ -586,8 +597,31 @@ int ttcan_tx_fifo_queue_msg(struct ttcan_controller *ttcan,
 	if (txfqs_reg & MTT_TXFQS_TFQF_MASK)
 		return -ENOMEM;
 
-	/* Test if Tx index is previously reserved in SW */
 	put_idx = (txfqs_reg & MTT_TXFQS_TFQPI_MASK) >> MTT_TXFQS_TFQPI_SHIFT;
+
+	/* The put index only advances once the add request is set, so skip
+	 * over elements which are written but not yet requested.
+	 */
+	if (pending) {
+		if (ttcan->tx_config.flags & 0x1) {
+			/* Queue mode: any free element may be used */
+			u32 txbrp_free = ~ttcan_read32(ttcan, ADR_MTTCAN_TXBRP);
+
+			txbrp_free &= ~ttcan->tx_object & fifo_bmsk;
+			if (!txbrp_free)
+				return -ENOMEM;
+			put_idx = ffs(txbrp_free) - 1;
+		} else {
+			free_level = (txfqs_reg & MTT_TXFQS_TFFL_MASK) >>
+				MTT_TXFQS_TFFL_SHIFT;
+			if (pending >= free_level)
+				return -ENOMEM;
+			put_idx = ded_num +
+				(put_idx - ded_num + pending) % fifo_num;
+		}
+	}
+
+	/* Test if Tx index is previously reserved in SW */
 	if (ttcan->tx_object & (1 << put_idx))
 		return -ENOMEM;
 
@@ -660,6 +694,8 @@ unsigned int ttcan_read_txevt_fifo(struct ttcan_controller *ttcan)
 	struct mttcan_tx_evt_element txevt;
 	u32 txefs;
 	u32 read_addr;
+	u32 get_idx;
+	u32 et;
 	int q_read = 0;
 	int msgs_read = 0;
 
@@ -669,11 +705,15 @@ unsigned int ttcan_read_txevt_fifo(struct ttcan_controller *ttcan)
 		pr_debug("%s: Tx Event FIFO empty\n", __func__);
 		return 0;
 	}
-	q_read = ttcan->tx_config.evt_q_num;
-	while ((txefs & MTT_TXEFS_EFFL_MASK) && q_read--) {
 
-		u32 get_idx =
-		    (txefs & MTT_TXEFS_EFGI_MASK) >> MTT_TXEFS_EFGI_SHIFT;
+	/* Drain the current fill level and acknowledge the batch once,
+	 * writing TXEFA releases the given element and all older ones.
+	 */
+	q_read = min_t(u32, (txefs & MTT_TXEFS_EFFL_MASK) >>
+		       MTT_TXEFS_EFFL_SHIFT, ttcan->tx_config.evt_q_num);
+	get_idx = (txefs & MTT_TXEFS_EFGI_MASK) >> MTT_TXEFS_EFGI_SHIFT;
+
+	while (q_read--) {
 		read_addr =
 		    ttcan->mram_cfg[MRAM_TXE].off +
 		    (get_idx * TX_EVENT_FIFO_ELEM_SIZE);
@@ -682,14 +722,30 @@ unsigned int ttcan_read_txevt_fifo(struct ttcan_controller *ttcan)
 			 read_addr, get_idx);
 
 		ttcan_read_txevt_ram(ttcan, read_addr, &txevt);
+
+		et = (txevt.f1 & MTT_TXEVT_ELE_F1_ET_MASK) >>
+			MTT_TXEVT_ELE_F1_ET_SHIFT;
+		if (et == MTT_TXEVT_ELE_F1_ET_TX ||
+		    et == MTT_TXEVT_ELE_F1_ET_TXC)
+			ttcan->tx_evt_done |= 1U <<
+				((txevt.f1 & MTT_TXEVT_ELE_F1_MM_MASK) >>
+				 MTT_TXEVT_ELE_F1_MM_SHIFT);
+
+		/* The event list only feeds debug output, keep draining so
+		 * that completions are not held back by it.
+		 */
 		if (add_event_controller_list(ttcan, &txevt,
-					      &ttcan->tx_evt) < 0) {
+					      &ttcan->tx_evt) < 0)
 			pr_err("%s: failed to add to list\n", __func__);
-			return msgs_read;
-		}
-		ttcan_write32(ttcan, ADR_MTTCAN_TXEFA, get_idx);
-		txefs = ttcan_read32(ttcan, ADR_MTTCAN_TXEFS);
 		msgs_read++;
+		if (++get_idx >= ttcan->tx_config.evt_q_num)
+			get_idx = 0;
+	}
+
+	if (msgs_read) {
+		get_idx = get_idx ? get_idx - 1 :
+			ttcan->tx_config.evt_q_num - 1;
+		ttcan_write32(ttcan, ADR_MTTCAN_TXEFA, get_idx);
 	}
 	return msgs_read;
 }
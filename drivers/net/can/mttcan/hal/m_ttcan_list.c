@@ -21,6 +21,9 @@ int add_msg_controller_list(struct ttcan_controller *ttcan,
 
 	struct ttcan_rx_msg_list *msg_list;
 
+	if (ttcan->rx_direct)
+		return ttcan->rx_direct(ttcan->rx_direct_ctx, ttcanfd, rxtype);
+
 	msg_list = (struct ttcan_rx_msg_list *)
 		kzalloc(sizeof(struct ttcan_rx_msg_list), GFP_ATOMIC);
 	if (msg_list == NULL) {
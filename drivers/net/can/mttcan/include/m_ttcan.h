@@ -92,6 +92,10 @@
 #define GFC_RRFS_REJECT		1U
 #define GFC_RRFE_REJECT		1U
 
+/* Filter Type: classic filter, ID1 = filter, ID2 = mask */
+#define SFT_CLASSIC		2U
+#define EFT_CLASSIC		2U
+
 /* Filter Element Configuration */
 #define FEC_RXFIFO_0            1U
 #define FEC_RXFIFO_1            2U
@@ -308,12 +312,20 @@ struct ttcan_controller {
 	u32 tdc_offset;
 	unsigned long tx_object;
 	unsigned long tx_obj_cancelled;
+	u32 tx_pending;		/* written, add request not yet set */
+	u32 tx_evt_done;	/* buffers reported sent by Tx event FIFO */
 	int rxq0_mem;
 	int rxq1_mem;
 	int rxb_mem;
 	int evt_mem;
 	u16 list_status;	/* bit 0: 1=Full; */
 	u16 resv0;
+	/* When set, received messages are handed to rx_direct instead of
+	 * being queued on rx_q0/rx_q1/rx_b.
+	 */
+	int (*rx_direct)(void *ctx, struct ttcanfd_frame *ttcanfd,
+			 enum ttcan_rx_type rxtype);
+	void *rx_direct_ctx;
 };
 
 struct ttcan_ivc_msg {
@@ -457,6 +469,7 @@ void ttcan_tx_ded_msg_write(struct ttcan_controller *ttcan,
 			    struct ttcanfd_frame *ttcanfd,
 			    u8 index);
 void ttcan_tx_trigger_msg_transmit(struct ttcan_controller *ttcan, u8 index);
+void ttcan_tx_trigger_msgs_transmit(struct ttcan_controller *ttcan, u32 txbar);
 int ttcan_tx_msg_buffer_write(struct ttcan_controller *ttcan,
 				struct ttcanfd_frame *ttcanfd);
 
@@ -34,6 +34,10 @@
 #include <linux/tegra-oot-prod.h>
 #include <linux/platform/tegra/ptp-notifier.h>
 #include <linux/mailbox_client.h>
+#include <linux/miscdevice.h>
+#include <linux/wait.h>
+#include <uapi/linux/mttcan_rx_ring.h>
+#include <uapi/linux/mttcan_filter.h>
 #ifdef CONFIG_CLK_SRC_TEGRA18_US_TIMER
 #include <linux/tegra-us-timer.h>
 #endif
@@ -66,6 +70,25 @@
 #define MTTCAN_TSC_MASK		0xFFFFULL
 #define TSC_REF_CLK_SHIFT	9U
 
+#define MTTCAN_RX_RING_MAX_ENTRIES	65536U
+
+/* Optional bulk Rx ring shared with userspace through mmap */
+struct mttcan_rx_ring {
+	struct miscdevice misc;
+	char name[IFNAMSIZ + 8];
+	struct mutex lock; /* protects enable/disable against open/mmap */
+	wait_queue_head_t wq;
+	struct mttcan_rx_ring_hdr *hdr;
+	struct mttcan_rx_ring_entry *entries;
+	size_t size;
+	u32 mask;
+	u32 head;	/* producer index, published to hdr->head per batch */
+	u32 pending;	/* entries queued since the last wakeup */
+	u64 tsc;	/* TSC sampled once per batch for timestamp extension */
+	int users;
+	bool registered;
+};
+
 struct tegra_mttcan_soc_info {
 	bool set_can_core_clk;
 	unsigned long can_core_clk_rate;
@@ -120,8 +143,15 @@ struct mttcan_priv {
 	bool poll;
 	bool hwts_rx_en;
 	u32 resp;
+	struct mttcan_rx_ring rx_ring;
 };
 
 int mttcan_create_sys_files(struct device *dev);
 void mttcan_delete_sys_files(struct device *dev);
+
+int mttcan_rx_ring_register(struct mttcan_priv *priv);
+void mttcan_rx_ring_unregister(struct mttcan_priv *priv);
+int mttcan_rx_ring_resize(struct mttcan_priv *priv, u32 num_entries);
+u32 mttcan_rx_ring_entries(struct mttcan_priv *priv);
+void mttcan_rx_ring_flush(struct mttcan_priv *priv);
 #endif
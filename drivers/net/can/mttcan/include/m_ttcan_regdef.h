@@ -774,6 +774,8 @@
 #define MTT_TXEVT_ELE_F1_FDF_MASK (((1<<1)-1) << MTT_TXEVT_ELE_F1_FDF_SHIFT)
 #define MTT_TXEVT_ELE_F1_ET_SHIFT 22
 #define MTT_TXEVT_ELE_F1_ET_MASK (((1<<2)-1) << MTT_TXEVT_ELE_F1_ET_SHIFT)
+#define MTT_TXEVT_ELE_F1_ET_TX 1	/* Tx event */
+#define MTT_TXEVT_ELE_F1_ET_TXC 2	/* Tx in spite of cancellation */
 #define MTT_TXEVT_ELE_F1_MM_SHIFT 24
 #define MTT_TXEVT_ELE_F1_MM_MASK (((1<<8)-1) << MTT_TXEVT_ELE_F1_MM_SHIFT)
 #define MTT_TXEVT_ELE_F0_ID_SHIFT 0
@@ -118,6 +118,12 @@ static int mttcan_hw_init(struct mttcan_priv *priv)
 	ttcan_set_txevt_fifo_conf(ttcan);
 	ttcan_set_tx_buffer_addr(ttcan);
 
+	/* With a Tx event FIFO, completions are taken in bulk from it and
+	 * the per buffer transmission completed interrupt is not needed.
+	 */
+	if (ttcan->tx_config.evt_q_num)
+		ttcan->intr_enable_reg &= ~MTT_IE_TCE_MASK;
+
 	if (priv->tt_param[0]) {
 		dev_info(priv->device, "TTCAN Enabled\n");
 		ttcan_disable_auto_retransmission(ttcan, true);
@@ -182,6 +188,7 @@ static int mttcan_hw_reinit(const struct mttcan_priv *priv)
 
 	/* Reset XIDAM to default */
 	ttcan_set_xidam(ttcan, priv->xidam_reg);
+	ttcan_set_gfc(ttcan, priv->gfc_reg);
 
 	/* Rx buffers set */
 	ttcan_set_rx_buffers_elements(ttcan);
@@ -305,19 +312,18 @@ static void mttcan_handle_lost_frame(struct net_device *dev, int fifo_num)
 	netif_receive_skb(skb);
 }
 
-static void mttcan_rx_hwtstamp(struct mttcan_priv *priv,
-			       struct sk_buff *skb, struct ttcanfd_frame *msg)
+/* tsc is the current TSC, only used with the external timer */
+static u64 mttcan_rx_tstamp_ns(struct mttcan_priv *priv,
+			       struct ttcanfd_frame *msg, u64 tsc)
 {
 	u64 ns;
-	u64 tsc, extended_tsc;
+	u64 extended_tsc;
 	unsigned long flags;
-	struct skb_shared_hwtstamps *hwtstamps = skb_hwtstamps(skb);
 
 	if (priv->sinfo->use_external_timer) {
-		/* Read the current TSC and calculate the MSB of captured
-		 * CAN TSC timestamp. Finally convert it to nsec.
+		/* Calculate the MSB of captured CAN TSC timestamp from the
+		 * current TSC. Finally convert it to nsec.
 		 */
-		tsc = _arch_counter_get_cntvct();
 		extended_tsc = mttcan_extend_timestamp(msg->tstamp, tsc,
 						       TSC_REF_CLK_SHIFT);
 		ns = extended_tsc << 5;
@@ -327,8 +333,91 @@ static void mttcan_rx_hwtstamp(struct mttcan_priv *priv,
 		raw_spin_unlock_irqrestore(&priv->tc_lock, flags);
 	}
 
+	return ns;
+}
+
+static void mttcan_rx_hwtstamp(struct mttcan_priv *priv,
+			       struct sk_buff *skb, struct ttcanfd_frame *msg)
+{
+	u64 tsc = 0;
+	struct skb_shared_hwtstamps *hwtstamps = skb_hwtstamps(skb);
+
+	if (priv->sinfo->use_external_timer)
+		tsc = _arch_counter_get_cntvct();
+
 	memset(hwtstamps, 0, sizeof(struct skb_shared_hwtstamps));
-	hwtstamps->hwtstamp = ns_to_ktime(ns);
+	hwtstamps->hwtstamp = ns_to_ktime(mttcan_rx_tstamp_ns(priv, msg, tsc));
+}
+
+/* Store one frame in the bulk Rx ring, called from NAPI poll only */
+static void mttcan_rx_ring_store(struct mttcan_priv *priv,
+				 struct ttcanfd_frame *msg, u16 source)
+{
+	struct mttcan_rx_ring *ring = &priv->rx_ring;
+	struct net_device_stats *stats = &priv->dev->stats;
+	struct mttcan_rx_ring_entry *entry;
+	u8 len;
+
+	/* pairs with the release store of tail by the reader */
+	if (ring->head - smp_load_acquire(&ring->hdr->tail) > ring->mask) {
+		WRITE_ONCE(ring->hdr->dropped, ring->hdr->dropped + 1);
+		stats->rx_dropped++;
+		return;
+	}
+
+	entry = &ring->entries[ring->head & ring->mask];
+	entry->source = source;
+	entry->flags = 0;
+	entry->reserved = 0;
+	entry->frame.can_id = msg->can_id;
+	if (msg->flags & CAN_FD_FLAG) {
+		len = min_t(u8, msg->d_len, CANFD_MAX_DLEN);
+		entry->flags |= MTTCAN_RX_RING_FL_FD;
+		entry->frame.flags = msg->flags;
+	} else {
+		len = min_t(u8, msg->d_len, CAN_MAX_DLEN);
+		entry->frame.flags = 0;
+	}
+	entry->frame.len = len;
+	entry->frame.__res0 = 0;
+	entry->frame.__res1 = 0;
+	memcpy(entry->frame.data, msg->data, len);
+
+	if (priv->hwts_rx_en) {
+		entry->tstamp_ns = mttcan_rx_tstamp_ns(priv, msg, ring->tsc);
+		entry->flags |= MTTCAN_RX_RING_FL_TSTAMP;
+	} else {
+		entry->tstamp_ns = 0;
+	}
+
+	ring->head++;
+	ring->pending++;
+	stats->rx_bytes += len;
+	stats->rx_packets++;
+}
+
+/* rx_direct hook: message RAM is drained straight into the ring */
+static int mttcan_rx_ring_push(void *ctx, struct ttcanfd_frame *msg,
+			       enum ttcan_rx_type rx_type)
+{
+	struct mttcan_priv *priv = ctx;
+	u16 source;
+
+	switch (rx_type) {
+	case FIFO_0:
+		source = MTTCAN_RX_RING_SRC_FIFO0;
+		break;
+	case FIFO_1:
+		source = MTTCAN_RX_RING_SRC_FIFO1;
+		break;
+	default:
+		source = MTTCAN_RX_RING_SRC_BUFFER;
+		break;
+	}
+
+	mttcan_rx_ring_store(priv, msg, source);
+
+	return 0;
 }
 
 static int mttcan_hpm_do_receive(struct net_device *dev,
@@ -340,6 +429,11 @@ static int mttcan_hpm_do_receive(struct net_device *dev,
 	struct canfd_frame *fd_frame;
 	struct can_frame *frame;
 
+	if (priv->ttcan->rx_direct) {
+		mttcan_rx_ring_store(priv, msg, MTTCAN_RX_RING_SRC_HPM);
+		return 1;
+	}
+
 	if (msg->flags & CAN_FD_FLAG) {
 		skb = alloc_canfd_skb(dev, &fd_frame);
 		if (!skb) {
@@ -381,6 +475,10 @@ static int mttcan_read_rcv_list(struct net_device *dev,
 	struct net_device_stats *stats = &dev->stats;
 	struct list_head *cur, *next, rx_q;
 
+	/* frames already went from message RAM to the bulk Rx ring */
+	if (priv->ttcan->rx_direct)
+		return rec_msgs;
+
 	if (list_empty(rcv))
 		return 0;
 
@@ -628,19 +726,20 @@ static void mttcan_tx_event(struct net_device *dev)
 	}
 }
 
-static void mttcan_tx_complete(struct net_device *dev)
+/* Called with tx_lock held */
+static void mttcan_tx_complete_msgs(struct net_device *dev, u32 completed_tx)
 {
 	struct mttcan_priv *priv = netdev_priv(dev);
 	struct ttcan_controller *ttcan = priv->ttcan;
 	struct net_device_stats *stats = &dev->stats;
 	u32 msg_no;
-	u32 completed_tx;
 
-	spin_lock(&priv->tx_lock);
-	completed_tx = ttcan_read_tx_complete_reg(ttcan);
-
-	/* apply mask to consider only active CAN Tx transactions */
-	completed_tx &= ttcan->tx_object;
+	/* TXBTO of a buffer is only cleared by its next add request, so
+	 * ignore buffers which are written but not yet requested.
+	 */
+	completed_tx &= ttcan->tx_object & ~ttcan->tx_pending;
+	if (!completed_tx)
+		return;
 
 	while (completed_tx) {
 		msg_no = ffs(completed_tx) - 1;
@@ -655,6 +754,35 @@ static void mttcan_tx_complete(struct net_device *dev)
 
 	if (netif_queue_stopped(dev))
 		netif_wake_queue(dev);
+}
+
+static void mttcan_tx_complete(struct net_device *dev)
+{
+	struct mttcan_priv *priv = netdev_priv(dev);
+
+	spin_lock(&priv->tx_lock);
+	mttcan_tx_complete_msgs(dev,
+				ttcan_read_tx_complete_reg(priv->ttcan));
+	spin_unlock(&priv->tx_lock);
+}
+
+/* Complete the batch of buffers reported by the Tx event FIFO */
+static void mttcan_tx_evt_complete(struct net_device *dev)
+{
+	struct mttcan_priv *priv = netdev_priv(dev);
+	struct ttcan_controller *ttcan = priv->ttcan;
+	u32 done = ttcan->tx_evt_done;
+
+	ttcan->tx_evt_done = 0;
+	if (!done)
+		return;
+
+	/* A stale event may name a buffer that is already reused, TXBTO
+	 * tells whether the current request of that buffer has finished.
+	 */
+	spin_lock(&priv->tx_lock);
+	mttcan_tx_complete_msgs(dev,
+				done & ttcan_read_tx_complete_reg(ttcan));
 	spin_unlock(&priv->tx_lock);
 }
 
@@ -708,6 +836,11 @@ static int mttcan_poll_ir(struct napi_struct *napi, int quota)
 	if (!ir && !ttir)
 		goto end;
 
+	/* one TSC sample extends the timestamps of the whole batch */
+	if (priv->ttcan->rx_direct && priv->hwts_rx_en &&
+	    priv->sinfo->use_external_timer)
+		priv->rx_ring.tsc = _arch_counter_get_cntvct();
+
 	if (ir) {
 		if (ir & MTTCAN_ERR_INTR) {
 			psr = priv->ttcan->proto_state;
@@ -886,7 +1019,8 @@ static int mttcan_poll_ir(struct napi_struct *napi, int quota)
 		if (ir & MTT_IR_TC_MASK) {
 			ack = MTT_IR_TC_MASK;
 			ttcan_ir_write(priv->ttcan, ack);
-			mttcan_tx_complete(dev);
+			if (!priv->ttcan->tx_config.evt_q_num)
+				mttcan_tx_complete(dev);
 		}
 
 		if (ir & MTT_IR_TFE_MASK) {
@@ -903,13 +1037,17 @@ static int mttcan_poll_ir(struct napi_struct *napi, int quota)
 			if ((ir & MTT_IR_TEFN_MASK) ||
 				(ir & MTT_IR_TEFW_MASK)) {
 				ttcan_read_txevt_fifo(priv->ttcan);
+				mttcan_tx_evt_complete(dev);
 				mttcan_tx_event(dev);
 			}
 
 			if ((ir & MTT_IR_TEFL_MASK) &&
-				priv->ttcan->tx_config.evt_q_num)
+				priv->ttcan->tx_config.evt_q_num) {
 				if (printk_ratelimit())
 					netdev_warn(dev, "Tx event lost\n");
+				/* recover the lost completions from TXBTO */
+				mttcan_tx_complete(dev);
+			}
 
 			ack = MTTCAN_TX_EV_FIFO_INTR;
 			ttcan_ir_write(priv->ttcan, ack);
@@ -965,6 +1103,9 @@ static int mttcan_poll_ir(struct napi_struct *napi, int quota)
 		ttcan_ttir_write(priv->ttcan, ttack);
 	}
 end:
+	if (priv->ttcan->rx_direct)
+		mttcan_rx_ring_flush(priv);
+
 	if (work_done < quota) {
 		napi_complete(napi);
 
@@ -1335,6 +1476,12 @@ static int mttcan_open(struct net_device *dev)
 		goto fail;
 	}
 
+	/* the ring can only be resized while the interface is down */
+	if (priv->rx_ring.hdr) {
+		priv->ttcan->rx_direct = mttcan_rx_ring_push;
+		priv->ttcan->rx_direct_ctx = priv;
+	}
+
 	napi_enable(&priv->napi);
 #if defined(CONFIG_CAN_LEDS)
 	can_led_event(dev, CAN_LED_EVENT_OPEN);
@@ -1360,12 +1507,16 @@ static int mttcan_close(struct net_device *dev)
 	napi_disable(&priv->napi);
 	mttcan_stop(priv);
 	free_irq(dev->irq, dev);
+	priv->ttcan->rx_direct = NULL;
+	priv->ttcan->rx_direct_ctx = NULL;
 
 	/* When we do power_down, it resets the mttcan HW by setting
 	 * INIT bit. This clears the internal state of mttcan HW.
 	 * We also then need to clear the internal states of driver.
 	 */
 	priv->ttcan->tx_object = 0;
+	priv->ttcan->tx_pending = 0;
+	priv->ttcan->tx_evt_done = 0;
 	priv->hwts_rx_en = false;
 
 	close_candev(dev);
@@ -1378,15 +1529,40 @@ static int mttcan_close(struct net_device *dev)
 	return 0;
 }
 
+/* Called with tx_lock held */
+static void mttcan_tx_flush_pending(struct ttcan_controller *ttcan)
+{
+	if (!ttcan->tx_pending)
+		return;
+
+	ttcan_tx_trigger_msgs_transmit(ttcan, ttcan->tx_pending);
+	ttcan->tx_pending = 0;
+}
+
 static netdev_tx_t mttcan_start_xmit(struct sk_buff *skb,
 				     struct net_device *dev)
 {
 	int msg_no = -1;
 	struct mttcan_priv *priv = netdev_priv(dev);
+	struct ttcan_controller *ttcan = priv->ttcan;
 	struct canfd_frame *frame = (struct canfd_frame *)skb->data;
+	bool xmit_more;
 
-	if (can_dropped_invalid_skb(dev, skb))
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 2, 0)
+	xmit_more = netdev_xmit_more();
+#else
+	xmit_more = skb->xmit_more;
+#endif
+
+	if (can_dropped_invalid_skb(dev, skb)) {
+		/* the dropped frame may have closed a batch */
+		if (!xmit_more) {
+			spin_lock_bh(&priv->tx_lock);
+			mttcan_tx_flush_pending(ttcan);
+			spin_unlock_bh(&priv->tx_lock);
+		}
 		return NETDEV_TX_OK;
+	}
 
 	if (can_is_canfd_skb(skb))
 		frame->flags |= CAN_FD_FLAG;
@@ -1402,20 +1578,29 @@ static netdev_tx_t mttcan_start_xmit(struct sk_buff *skb,
 
 	if (msg_no < 0) {
 		netif_stop_queue(dev);
+		/* do not leave a deferred batch behind a stopped queue */
+		mttcan_tx_flush_pending(ttcan);
 		spin_unlock_bh(&priv->tx_lock);
 		return NETDEV_TX_BUSY;
 	}
-	can_put_echo_skb(skb, dev, msg_no, 0);
 
-	/* Set go bit for non-TTCAN messages */
-	if (!priv->tt_param[0])
-		ttcan_tx_trigger_msg_transmit(priv->ttcan, msg_no);
+	can_put_echo_skb(skb, dev, msg_no, 0);
 
 	/* State management for Tx complete/cancel processing */
-	if (test_and_set_bit(msg_no, &priv->ttcan->tx_object) &&
+	if (test_and_set_bit(msg_no, &ttcan->tx_object) &&
 		printk_ratelimit())
 		netdev_err(dev, "Writing to occupied echo_skb buffer\n");
-	clear_bit(msg_no, &priv->ttcan->tx_obj_cancelled);
+	clear_bit(msg_no, &ttcan->tx_obj_cancelled);
+
+	/* Set go bit for non-TTCAN messages. While the stack has more
+	 * frames queued, collect them and set all add requests with one
+	 * TXBAR write.
+	 */
+	if (!priv->tt_param[0]) {
+		ttcan->tx_pending |= 1U << msg_no;
+		if (!xmit_more)
+			mttcan_tx_flush_pending(ttcan);
+	}
 
 	spin_unlock_bh(&priv->tx_lock);
 
@@ -1538,11 +1723,157 @@ static int mttcan_handle_hwtstamp_get(struct mttcan_priv *priv,
 			sizeof(struct hwtstamp_config)) ? -EFAULT : 0;
 }
 
+/* Which ID filter lists a CAN_RAW filter entry has to be programmed in */
+static void mttcan_hw_filter_type(const struct can_filter *f, bool *std,
+				  bool *xtd)
+{
+	*std = true;
+	*xtd = true;
+
+	if (f->can_mask & CAN_EFF_FLAG) {
+		*std = !(f->can_id & CAN_EFF_FLAG);
+		*xtd = !!(f->can_id & CAN_EFF_FLAG);
+	}
+
+	/* a standard ID has no bits set above CAN_SFF_MASK */
+	if (f->can_id & f->can_mask & CAN_EFF_MASK & ~CAN_SFF_MASK)
+		*std = false;
+}
+
+/* Called under rtnl, so the interface cannot be brought up meanwhile */
+static int mttcan_set_hw_filters(struct mttcan_priv *priv, void __user *data)
+{
+	struct ttcan_controller *ttcan = priv->ttcan;
+	u32 sidf_num = ttcan->mram_cfg[MRAM_SIDF].num;
+	u32 xidf_num = ttcan->mram_cfg[MRAM_XIDF].num;
+	struct mttcan_hw_filters hdr;
+	struct can_filter *fltrs;
+	u32 nstd = 0, nxtd = 0;
+	bool accept_all = false;
+	bool std, xtd;
+	u32 fec, gfc, i;
+	int ret;
+
+	if (priv->dev->flags & IFF_UP) {
+		netdev_err(priv->dev, "device is running\n");
+		return -EBUSY;
+	}
+
+	if (copy_from_user(&hdr, data, sizeof(hdr)))
+		return -EFAULT;
+
+	if (hdr.reserved || hdr.count > MTTCAN_HW_FILTERS_MAX)
+		return -EINVAL;
+
+	if (ttcan->mram_cfg[MRAM_RXF0].num)
+		fec = FEC_RXFIFO_0;
+	else if (ttcan->mram_cfg[MRAM_RXF1].num)
+		fec = FEC_RXFIFO_1;
+	else
+		return -EOPNOTSUPP;
+
+	fltrs = memdup_user(data + sizeof(hdr),
+			    array_size(hdr.count, sizeof(*fltrs)));
+	if (IS_ERR(fltrs))
+		return PTR_ERR(fltrs);
+
+	for (i = 0; i < hdr.count; i++) {
+		/* hardware can only reject on a match of all elements */
+		if (fltrs[i].can_id & CAN_INV_FILTER) {
+			accept_all = true;
+			break;
+		}
+		mttcan_hw_filter_type(&fltrs[i], &std, &xtd);
+		nstd += std;
+		nxtd += xtd;
+	}
+
+	if (accept_all || !hdr.count) {
+		accept_all = true;
+		nstd = 0;
+		nxtd = 0;
+	} else if (nstd > sidf_num || nxtd > xidf_num) {
+		netdev_err(priv->dev, "filter set needs %u std/%u xtd elements\n",
+			   nstd, nxtd);
+		ret = -ENOSPC;
+		goto out;
+	}
+
+	mttcan_pm_runtime_get_sync(priv);
+
+	nstd = 0;
+	nxtd = 0;
+	for (i = 0; i < hdr.count && !accept_all; i++) {
+		mttcan_hw_filter_type(&fltrs[i], &std, &xtd);
+		if (std)
+			ttcan_set_std_id_filter(ttcan, priv->std_shadow, nstd++,
+				SFT_CLASSIC, fec, fltrs[i].can_id & CAN_SFF_MASK,
+				fltrs[i].can_mask & CAN_SFF_MASK);
+		if (xtd)
+			ttcan_set_xtd_id_filter(ttcan, priv->xtd_shadow, nxtd++,
+				EFT_CLASSIC, fec, fltrs[i].can_id & CAN_EFF_MASK,
+				fltrs[i].can_mask & CAN_EFF_MASK);
+	}
+
+	/* disable the remaining elements, SFEC/EFEC 0 */
+	for (i = nstd; i < sidf_num; i++)
+		ttcan_set_std_id_filter(ttcan, priv->std_shadow, i, 0, 0, 0, 0);
+	for (i = nxtd; i < xidf_num; i++)
+		ttcan_set_xtd_id_filter(ttcan, priv->xtd_shadow, i, 0, 0, 0, 0);
+
+	ttcan->fltr_config.std_fltr_size = nstd;
+	ttcan->fltr_config.xtd_fltr_size = nxtd;
+
+	/* keep the remote frame handling, set the non-matching frame one */
+	gfc = priv->gfc_reg & (MTT_GFC_RRFS_MASK | MTT_GFC_RRFE_MASK);
+	if (!accept_all) {
+		gfc |= (GFC_ANFS_REJECT << MTT_GFC_ANFS_SHIFT) &
+			MTT_GFC_ANFS_MASK;
+		gfc |= (GFC_ANFE_REJECT << MTT_GFC_ANFE_SHIFT) &
+			MTT_GFC_ANFE_MASK;
+	} else if (fec == FEC_RXFIFO_1) {
+		gfc |= (GFC_ANFS_RXFIFO_1 << MTT_GFC_ANFS_SHIFT) &
+			MTT_GFC_ANFS_MASK;
+		gfc |= (GFC_ANFE_RXFIFO_1 << MTT_GFC_ANFE_SHIFT) &
+			MTT_GFC_ANFE_MASK;
+	}
+
+	ret = ttcan_set_gfc(ttcan, gfc);
+	if (!ret)
+		priv->gfc_reg = gfc;
+
+	mttcan_pm_runtime_put_sync(priv);
+out:
+	kfree(fltrs);
+	return ret;
+}
+
+#if KERNEL_VERSION(5, 15, 0) <= LINUX_VERSION_CODE
+static int mttcan_siocdevprivate(struct net_device *dev, struct ifreq *ifr,
+				 void __user *data, int cmd)
+{
+	struct mttcan_priv *priv = netdev_priv(dev);
+
+	switch (cmd) {
+	case MTTCAN_IOCTL_SET_FILTERS:
+		return mttcan_set_hw_filters(priv, data);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+#endif
+
 static int mttcan_ioctl(struct net_device *dev, struct ifreq *ifr, int cmd)
 {
 	struct mttcan_priv *priv = netdev_priv(dev);
 	int ret = 0;
 
+#if KERNEL_VERSION(5, 15, 0) > LINUX_VERSION_CODE
+	/* may sleep, so handle it before taking tslock */
+	if (cmd == MTTCAN_IOCTL_SET_FILTERS)
+		return mttcan_set_hw_filters(priv, ifr->ifr_data);
+#endif
+
 	spin_lock(&priv->tslock);
 	switch (cmd) {
 	case SIOCSHWTSTAMP:
@@ -1566,6 +1897,7 @@ static const struct net_device_ops mttcan_netdev_ops = {
 	.ndo_change_mtu = mttcan_change_mtu,
 #if KERNEL_VERSION(5, 15, 0) <= LINUX_VERSION_CODE
 	.ndo_eth_ioctl = mttcan_ioctl,
+	.ndo_siocdevprivate = mttcan_siocdevprivate,
 #else
 	.ndo_do_ioctl = mttcan_ioctl,
 #endif
@@ -1898,6 +2230,10 @@ static int mttcan_probe(struct platform_device *pdev)
 	if (ret)
 		goto exit_unreg_candev;
 
+	ret = mttcan_rx_ring_register(priv);
+	if (ret)
+		goto exit_delete_sys_files;
+
 #if LINUX_VERSION_CODE > KERNEL_VERSION(4,15,0)
 	timer_setup(&priv->timer, mttcan_timer_cb, 0);
 #else
@@ -1909,6 +2245,8 @@ static int mttcan_probe(struct platform_device *pdev)
 
 	return 0;
 
+exit_delete_sys_files:
+	mttcan_delete_sys_files(&dev->dev);
 exit_unreg_candev:
 	unregister_mttcan_dev(dev);
 exit_hw_deinit:
@@ -1934,6 +2272,7 @@ static int mttcan_remove(struct platform_device *pdev)
 	dev_info(&dev->dev, "%s\n", __func__);
 
 	del_timer_sync(&priv->timer);
+	mttcan_rx_ring_unregister(priv);
 	mttcan_delete_sys_files(&dev->dev);
 	unregister_mttcan_dev(dev);
 	mttcan_unprepare_clock(priv);
@@ -0,0 +1,193 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#include "../include/m_ttcan.h"
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
+#include <linux/rtnetlink.h>
+#include <linux/sched/signal.h>
+
+static int mttcan_rx_ring_open(struct inode *inode, struct file *filp)
+{
+	struct mttcan_rx_ring *ring = container_of(filp->private_data,
+						   struct mttcan_rx_ring, misc);
+	int ret = 0;
+
+	mutex_lock(&ring->lock);
+	if (!ring->hdr)
+		ret = -ENODEV;
+	else
+		ring->users++;
+	mutex_unlock(&ring->lock);
+
+	filp->private_data = ring;
+
+	return ret;
+}
+
+static int mttcan_rx_ring_release(struct inode *inode, struct file *filp)
+{
+	struct mttcan_rx_ring *ring = filp->private_data;
+
+	mutex_lock(&ring->lock);
+	ring->users--;
+	mutex_unlock(&ring->lock);
+
+	return 0;
+}
+
+static int mttcan_rx_ring_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct mttcan_rx_ring *ring = filp->private_data;
+	unsigned long size = vma->vm_end - vma->vm_start;
+
+	if (vma->vm_pgoff || size > ring->size)
+		return -EINVAL;
+
+	/* The buffer cannot be resized while a file is open. Pages mapped
+	 * here hold a reference, so they stay valid after close as well.
+	 */
+	return remap_vmalloc_range(vma, ring->hdr, 0);
+}
+
+static __poll_t mttcan_rx_ring_poll(struct file *filp, poll_table *wait)
+{
+	struct mttcan_rx_ring *ring = filp->private_data;
+
+	poll_wait(filp, &ring->wq, wait);
+
+	if (smp_load_acquire(&ring->hdr->head) != READ_ONCE(ring->hdr->tail))
+		return EPOLLIN | EPOLLRDNORM;
+
+	return 0;
+}
+
+static const struct file_operations mttcan_rx_ring_fops = {
+	.owner = THIS_MODULE,
+	.open = mttcan_rx_ring_open,
+	.release = mttcan_rx_ring_release,
+	.mmap = mttcan_rx_ring_mmap,
+	.poll = mttcan_rx_ring_poll,
+	.llseek = noop_llseek,
+};
+
+u32 mttcan_rx_ring_entries(struct mttcan_priv *priv)
+{
+	struct mttcan_rx_ring *ring = &priv->rx_ring;
+	u32 num_entries;
+
+	mutex_lock(&ring->lock);
+	num_entries = ring->hdr ? ring->mask + 1 : 0;
+	mutex_unlock(&ring->lock);
+
+	return num_entries;
+}
+
+/* A num_entries of 0 frees the ring and restores per-frame skb delivery */
+int mttcan_rx_ring_resize(struct mttcan_priv *priv, u32 num_entries)
+{
+	struct mttcan_rx_ring *ring = &priv->rx_ring;
+	struct mttcan_rx_ring_hdr *hdr = NULL;
+	size_t size = 0;
+	int ret = 0;
+
+	if (num_entries && (!is_power_of_2(num_entries) ||
+			    num_entries > MTTCAN_RX_RING_MAX_ENTRIES))
+		return -EINVAL;
+
+	/* ndo_open runs under rtnl and picks the Rx path from ring->hdr.
+	 * Called from sysfs, so do not block on rtnl against unregister.
+	 */
+	if (!rtnl_trylock())
+		return restart_syscall();
+	mutex_lock(&ring->lock);
+
+	if (netif_running(priv->dev) || ring->users) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	if (num_entries) {
+		size = PAGE_ALIGN(PAGE_SIZE +
+			num_entries * sizeof(struct mttcan_rx_ring_entry));
+		hdr = vmalloc_user(size);
+		if (!hdr) {
+			ret = -ENOMEM;
+			goto out;
+		}
+
+		hdr->magic = MTTCAN_RX_RING_MAGIC;
+		hdr->version = MTTCAN_RX_RING_VERSION;
+		hdr->entry_size = sizeof(struct mttcan_rx_ring_entry);
+		hdr->num_entries = num_entries;
+		hdr->entries_offset = PAGE_SIZE;
+	}
+
+	vfree(ring->hdr);
+	ring->hdr = hdr;
+	ring->entries = hdr ? (void *)hdr + PAGE_SIZE : NULL;
+	ring->size = size;
+	ring->mask = num_entries ? num_entries - 1 : 0;
+	ring->head = 0;
+	ring->pending = 0;
+out:
+	mutex_unlock(&ring->lock);
+	rtnl_unlock();
+
+	return ret;
+}
+
+/* Called from NAPI poll: publish the batch and wake readers once */
+void mttcan_rx_ring_flush(struct mttcan_priv *priv)
+{
+	struct mttcan_rx_ring *ring = &priv->rx_ring;
+
+	if (!ring->pending)
+		return;
+
+	smp_store_release(&ring->hdr->head, ring->head);
+	ring->pending = 0;
+	wake_up_interruptible(&ring->wq);
+}
+
+int mttcan_rx_ring_register(struct mttcan_priv *priv)
+{
+	struct mttcan_rx_ring *ring = &priv->rx_ring;
+	int ret;
+
+	mutex_init(&ring->lock);
+	init_waitqueue_head(&ring->wq);
+
+	snprintf(ring->name, sizeof(ring->name), "%s_rxring", priv->dev->name);
+	ring->misc.minor = MISC_DYNAMIC_MINOR;
+	ring->misc.name = ring->name;
+	ring->misc.fops = &mttcan_rx_ring_fops;
+	ring->misc.parent = priv->device;
+
+	ret = misc_register(&ring->misc);
+	if (ret) {
+		dev_err(priv->device, "failed to register %s\n", ring->name);
+		return ret;
+	}
+	ring->registered = true;
+
+	return 0;
+}
+
+void mttcan_rx_ring_unregister(struct mttcan_priv *priv)
+{
+	struct mttcan_rx_ring *ring = &priv->rx_ring;
+
+	if (!ring->registered)
+		return;
+
+	misc_deregister(&ring->misc);
+	ring->registered = false;
+
+	vfree(ring->hdr);
+	ring->hdr = NULL;
+	ring->entries = NULL;
+}
@@ -688,6 +688,34 @@ static ssize_t store_tdc_offset(struct device *dev,
 	return count;
 }
 
+static ssize_t show_rx_ring_entries(struct device *dev,
+				    struct device_attribute *devattr, char *buf)
+{
+	struct mttcan_priv *priv = netdev_priv(to_net_dev(dev));
+
+	return sprintf(buf, "%u\n", mttcan_rx_ring_entries(priv));
+}
+
+static ssize_t store_rx_ring_entries(struct device *dev,
+				     struct device_attribute *devattr,
+				     const char *buf, size_t count)
+{
+	struct mttcan_priv *priv = netdev_priv(to_net_dev(dev));
+	unsigned int num_entries = 0;
+	int ret;
+
+	if ((sscanf(buf, "%u", &num_entries) != 1)) {
+		dev_err(dev, "wrong rx_ring_entries\n");
+		return -EINVAL;
+	}
+
+	ret = mttcan_rx_ring_resize(priv, num_entries);
+	if (ret)
+		return ret;
+
+	return count;
+}
+
 static DEVICE_ATTR(std_filter, S_IRUGO | S_IWUSR, show_std_fltr,
 	store_std_fltr);
 static DEVICE_ATTR(xtd_filter, S_IRUGO | S_IWUSR, show_xtd_fltr,
@@ -708,6 +736,8 @@ static DEVICE_ATTR(trigger_mem, S_IRUGO | S_IWUSR, show_trigger_mem,
 		store_trigger_mem);
 static DEVICE_ATTR(tdc_offset, S_IRUGO | S_IWUSR, show_tdc_offset,
 		store_tdc_offset);
+static DEVICE_ATTR(rx_ring_entries, S_IRUGO | S_IWUSR, show_rx_ring_entries,
+		store_rx_ring_entries);
 
 static struct attribute *mttcan_attr[] = {
 	&dev_attr_std_filter.attr,
@@ -723,6 +753,7 @@ static struct attribute *mttcan_attr[] = {
 	&dev_attr_cccr_init_txbar.attr,
 	&dev_attr_trigger_mem.attr,
 	&dev_attr_tdc_offset.attr,
+	&dev_attr_rx_ring_entries.attr,
 	NULL
 };
 
@@ -77,9 +77,11 @@ static const struct net_device_ops oak_netdev_ops = {
 	.ndo_start_xmit = oak_net_xmit_frame,
 	.ndo_do_ioctl = oak_net_ioctl,
 	.ndo_set_mac_address = oak_net_set_mac_addr,
-	.ndo_select_queue = oak_net_select_queue,
 	.ndo_change_mtu = oak_net_esu_set_mtu,
 	.ndo_validate_addr      = eth_validate_addr,
+#ifdef OAK_PAGE_POOL
+	.ndo_bpf = oak_net_bpf,
+#endif
 };
 
 /* global variable declaration */
@@ -51,6 +51,7 @@ typedef struct oak_driver_rx_statstruct {
 	u64 rx_1024;
 	u64 rx_2048;
 	u64 rx_fragments;
+	u64 rx_xdp_drop;
 } oak_driver_rx_stat;
 
 typedef struct oak_driver_tx_statstruct {
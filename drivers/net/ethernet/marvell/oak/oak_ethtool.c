@@ -51,6 +51,7 @@ static const u8 rx_strings[][ETH_GSTRING_LEN] = {
 	{"rx_1024"},
 	{"rx_2048"},
 	{"rx_fragments"},
+	{"rx_xdp_drop"},
 };
 
 static const u8 tx_strings[][ETH_GSTRING_LEN] = {
@@ -62,71 +62,60 @@ static void oak_irq_reset_gicu_ldg(struct oak_tstruct *np)
 	}
 }
 
-/* Name        : oak_irq_set_tx_rx_dma_bit
- * Returns     : int
- * Parameters  : struct oak_tstruct *np, int grp
- * Description : This function sets the tx and rx bit of a dma channel
+/* Name        : oak_irq_set_ring_bits
+ * Returns     : void
+ * Parameters  : struct oak_tstruct *np
+ * Description : This function maps the DMA and error bits of tx ring n and
+ * rx ring n to the same logical device group n. Every ring pair then gets
+ * its own MSI-X vector, CPU and NAPI context as long as there are enough
+ * vectors, otherwise the ring pairs wrap around the available groups.
  */
-static u32 oak_irq_set_tx_rx_dma_bit(struct oak_tstruct *np, u32 grp)
+static void oak_irq_set_ring_bits(struct oak_tstruct *np)
 {
 	u32 i = 0;
-	u64 val;
+	u32 grp;
+	u32 shift;
 
-	val = (1UL << TX_DMA_BIT);
-	/* Set tx DMA bit for all the tx channels */
-	while (i < np->num_tx_chan) {
+	while (i < OAK_MAX_CHAN_NUM) {
 		if (np->gicu.num_ldg > 0)
-			grp = (grp % np->gicu.num_ldg);
-		np->gicu.ldg[grp].msi_tx |= val;
-		val <<= 4ULL;
-		++grp;
-		++i;
-	}
-
-	i = 0;
-	val = (1UL << RX_DMA_BIT);
-	/* Set rx DMA bit for all the rx channels */
-	while (i < np->num_rx_chan) {
-		if (np->gicu.num_ldg > 0)
-			grp = (grp % np->gicu.num_ldg);
-		np->gicu.ldg[grp].msi_rx |= val;
-		val <<= 4UL;
-		++grp;
+			grp = (i % np->gicu.num_ldg);
+		else
+			grp = 0;
+		/* Each ring owns 4 consecutive bits of the GICU mask */
+		shift = 4U * i;
+
+		if (i < np->num_tx_chan) {
+			np->gicu.ldg[grp].msi_tx |= (1ULL << (TX_DMA_BIT + shift));
+			np->gicu.ldg[grp].msi_te |= (1ULL << (TX_ERR_BIT + shift));
+		}
+		if (i < np->num_rx_chan) {
+			np->gicu.ldg[grp].msi_rx |= (1ULL << (RX_DMA_BIT + shift));
+			np->gicu.ldg[grp].msi_re |= (1ULL << (RX_ERR_BIT + shift));
+		}
 		++i;
 	}
-	return grp;
 }
 
-/* Name        : oak_irq_set_tx_rx_err_bit
+/* Name        : oak_irq_set_xps
  * Returns     : void
- * Parameters  : struct oak_tstruct *np, int grp
- * Description : This function sets the tx and rx err bit of a dma channel
+ * Parameters  : struct oak_tstruct *np, ldg_t *ldg, u32 cpu
+ * Description : This function points XPS of every tx ring served by the
+ * logical device group at the CPU its vector is bound to, so the stack
+ * transmits on the ring whose completions are handled on the same CPU.
  */
-static void oak_irq_set_tx_rx_err_bit(struct oak_tstruct *np, u32 grp)
+static void oak_irq_set_xps(struct oak_tstruct *np, ldg_t *ldg, u32 cpu)
 {
 	u32 i = 0;
-	u64 val;
+	int err;
 
-	val = (1UL << TX_ERR_BIT);
-	/* Set tx error bit for all the tx channels */
 	while (i < np->num_tx_chan) {
-		if (np->gicu.num_ldg > 0)
-			grp = (grp % np->gicu.num_ldg);
-		np->gicu.ldg[grp].msi_te |= val;
-		val <<= 4ULL;
-		++grp;
-		++i;
-	}
-
-	i = 0;
-	val = (1UL << RX_ERR_BIT);
-	/* Set rx error bit for all the rx channels */
-	while (i < np->num_rx_chan) {
-		if (np->gicu.num_ldg > 0)
-			grp = (grp % np->gicu.num_ldg);
-		np->gicu.ldg[grp].msi_re |= val;
-		val <<= 4ULL;
-		++grp;
+		if ((ldg->msi_tx & (1ULL << (TX_DMA_BIT + 4U * i))) != 0) {
+			err = netif_set_xps_queue(np->netdev, get_cpu_mask(cpu),
+						  (u16)i);
+			if (err != 0)
+				oakdbg(debug, INTR, "txq %d xps cpu %d err=%d",
+				       i, cpu, err);
+		}
 		++i;
 	}
 }
@@ -235,6 +224,8 @@ static int oak_irq_request_single_ivec(struct oak_tstruct *np, ldg_t *ldg,
 		str = "re";
 	if (val == ldg->msi_ge)
 		str = "ge";
+	if (val == (ldg->msi_tx | ldg->msi_rx | ldg->msi_te | ldg->msi_re))
+		str = "txrx";
 
 	retval = oak_request_irq(np, ldg, str, idx, cpu);
 
@@ -266,6 +257,8 @@ static int oak_irq_allocate_ivec(struct oak_tstruct *np)
 				| p->msi_ge);
 		if (val != 0) {
 			err = oak_irq_request_single_ivec(np, p, val, i, cpu);
+			if (err == 0)
+				oak_irq_set_xps(np, p, cpu);
 			cpu = cpumask_next(cpu, cpu_online_mask);
 			if (cpu >= nr_cpu_ids)
 				cpu = cpumask_first(cpu_online_mask);
@@ -290,7 +283,6 @@ static int oak_irq_allocate_ivec(struct oak_tstruct *np)
  */
 int oak_irq_request_ivec(struct oak_tstruct *np)
 {
-	u32 grp = 0;
 	u32 num_chan_req;
 	int err = 0;
 
@@ -304,8 +296,7 @@ int oak_irq_request_ivec(struct oak_tstruct *np)
 
 	if (num_chan_req <= MAX_NUM_OF_CHANNELS) {
 		oak_irq_reset_gicu_ldg(np);
-		grp = oak_irq_set_tx_rx_dma_bit(np, grp);
-		oak_irq_set_tx_rx_err_bit(np, grp);
+		oak_irq_set_ring_bits(np);
 	} else {
 		err = -ENOMEM;
 	}
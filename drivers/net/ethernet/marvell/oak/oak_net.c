@@ -40,6 +40,9 @@ static u32 oak_net_tx_work(ldg_t *ldg, u32 ring, int budget);
 static u32 oak_net_rx_work(ldg_t *ldg, u32 ring, int budget);
 static int oak_net_process_rx_pkt(oak_rx_chan_t *rxc, u32 desc_num,
 				  struct sk_buff **target);
+#ifdef OAK_PAGE_POOL
+static bool oak_net_run_xdp(oak_rx_chan_t *rxc, struct bpf_prog *prog);
+#endif
 static u32 oak_net_process_channel(ldg_t *ldg, u32 ring, u32 reason,
 				   int budget);
 static int oak_net_poll(struct napi_struct *napi, int budget);
@@ -87,6 +90,12 @@ int oak_net_esu_set_mtu(struct net_device *net_dev, int new_mtu)
 	u32 data;
 	int retval = 0;
 
+#ifdef OAK_PAGE_POOL
+	/* XDP only sees frames that fit into a single Rx buffer */
+	if (READ_ONCE(np->xdp_prog) && new_mtu > OAK_XDP_MAX_MTU)
+		return -EINVAL;
+#endif
+
 	/* sr32 is a macro defined in oak_unimac.h file which will be expand
 	 * as readl. The readl is a linux kernel function used to read from
 	 * directly mapped IO memory.
@@ -293,11 +302,15 @@ int oak_net_rbr_refill(oak_t *np, u32 ring)
 	int num;
 	u32 sum = 0;
 	struct page *page;
-	dma_addr_t dma;
 	dma_addr_t offs;
 	oak_rx_chan_t *rxc = &np->rx_channel[ring];
 	int rc = 0;
+#ifdef OAK_PAGE_POOL
+	unsigned int pp_offs;
+#else
+	dma_addr_t dma;
 	u32 loop_cnt;
+#endif
 
 	num = atomic_read(&rxc->rbr_pend);
 	count = rxc->rbr_size - 1;
@@ -319,6 +332,44 @@ int oak_net_rbr_refill(oak_t *np, u32 ring)
 		 * buffer ring so that driver can process them and give it to
 		 * upper layer in linux kernel.
 		 */
+#ifdef OAK_PAGE_POOL
+		/* Every descriptor takes a rbr_bsize fragment of a page_pool
+		 * page. The pool keeps the pages DMA mapped and syncs them for
+		 * the device when they get recycled, so nothing is mapped or
+		 * unmapped per packet.
+		 */
+		while ((count > 0) && (rc == 0)) {
+			oak_rxa_t *rba = &rxc->rba[widx];
+			oak_rxd_t *rbr = &rxc->rbr[widx];
+
+			page = page_pool_dev_alloc_frag(rxc->page_pool, &pp_offs,
+							rxc->rbr_bsize);
+			if (page) {
+				offs = page_pool_get_dma_addr(page) + pp_offs;
+				rba->page_virt = page;
+				rba->page_phys = offs;
+				rba->page_offs = pp_offs;
+				rbr->buf_ptr_lo = (offs & 0xFFFFFFFFU);
+#ifdef CONFIG_ARCH_DMA_ADDR_T_64BIT
+				/* High 32 bit */
+				rbr->buf_ptr_hi = ((offs >> 32) & 0xFFFFFFFFU);
+#else
+				rbr->buf_ptr_hi = 0;
+#endif
+				/* move to next write position */
+				widx = NEXT_IDX(widx, rxc->rbr_size);
+				--count;
+				++num;
+				if (pp_offs == 0) {
+					++sum;
+					++rxc->stat.rx_alloc_pages;
+				}
+			} else {
+				rc = -ENOMEM;
+				++rxc->stat.rx_alloc_error;
+			}
+		}
+#else
 		while ((count > 0) && (rc == 0)) {
 			/* Allocate a page */
 			page = oak_net_alloc_page(np, &dma, DMA_FROM_DEVICE);
@@ -368,6 +419,7 @@ int oak_net_rbr_refill(oak_t *np, u32 ring)
 				++rxc->stat.rx_alloc_error;
 			}
 		}
+#endif
 		/* Add integer to atomic variable */
 		atomic_add(num, &rxc->rbr_pend);
 		oakdbg(debug, PKTDATA,
@@ -695,45 +747,6 @@ struct page *oak_net_alloc_page(oak_t *np, dma_addr_t *dma,
 	return page;
 }
 
-/* Name        : oak_net_select_queue
- * Returns     : u16
- * Parameters  : struct net_device *dev, struct sk_buff *skb,
- * struct net_device *sb_dev
- * Description : This function pre-seed the SKB by recording the RX queue
- */
-u16 oak_net_select_queue(struct net_device *dev, struct sk_buff *skb,
-			 struct net_device *sb_dev)
-{
-	oak_t *np = netdev_priv(dev);
-	u32 txq = 0;
-	bool rec;
-	u16 retval = 0;
-
-	/* The idea is that drivers which implement multiqueue RX
-	 * pre-seed the SKB by recording the RX queue selected by
-	 * the hardware.
-	 * If such a seed is found on TX, we'll use that to select
-	 * the outgoing TX queue.
-	 * This helps get more consistent load balancing on router
-	 * and firewall loads.
-	 */
-	rec = skb_rx_queue_recorded(skb);
-
-	if (!rec)
-		txq = smp_processor_id();
-	else
-		txq = skb_get_rx_queue(skb);
-
-	if (txq >= np->num_tx_chan && np->num_tx_chan > 0)
-		txq %= np->num_tx_chan;
-
-	retval = (u16)txq;
-
-	oakdbg(debug, DRV, "queue=%d of %d", txq, dev->real_num_tx_queues);
-
-	return retval;
-}
-
 /* Name      : xmit_frame
  * Returns   : int
  * Parameters:  struct sk_buff * skb,  struct net_device * net_dev
@@ -977,6 +990,7 @@ static void oak_net_rbr_reset(oak_rx_chan_t *rxp)
 		rxp->rbr_ridx = NEXT_IDX(rxp->rbr_ridx, rxp->rbr_size);
 }
 
+#ifndef OAK_PAGE_POOL
 /* Name        : oak_net_rbr_unmap
  * Returns     : void
  * Parameters  : oak_rx_chan_t *rxp = rxp, struct page *page, dma_addr_t dma
@@ -995,6 +1009,7 @@ static void oak_net_rbr_unmap(oak_rx_chan_t *rxp, struct page *page,
 	page->mapping = NULL;
 	__free_page(page);
 }
+#endif
 
 /* Name        : oak_net_rbr_free
  * Returns     : void
@@ -1005,18 +1020,26 @@ void oak_net_rbr_free(oak_rx_chan_t *rxp)
 {
 	u32 sum = 0;
 	struct page *page;
+#ifndef OAK_PAGE_POOL
 	dma_addr_t dma;
+#endif
 
 	while (rxp->rbr_ridx != rxp->rbr_widx) {
 		page = rxp->rba[rxp->rbr_ridx].page_virt;
 
 		if (page) {
-			dma = rxp->rba[rxp->rbr_ridx].page_phys;
 			++sum;
+#ifdef OAK_PAGE_POOL
+			/* Give the fragment back to the pool */
+			page_pool_put_full_page(rxp->page_pool, page, false);
+			rxp->rba[rxp->rbr_ridx].page_phys = 0;
+#else
+			dma = rxp->rba[rxp->rbr_ridx].page_phys;
 
 			if (dma != 0)
 				/* Unmap the memory */
 				oak_net_rbr_unmap(rxp, page, dma);
+#endif
 		}
 		/* Reset the buffer index */
 		oak_net_rbr_reset(rxp);
@@ -1288,9 +1311,10 @@ static void oak_net_rx_update_counters(oak_t *np, struct sk_buff *skb,
 	/* Update skb protocol */
 	skb->protocol = eth_type_trans(skb, np->netdev);
 	/* Calling skb_record_rx_queue() to set the rx queue to the queue_index
-	 * fixes the association between descriptor and rx queue.
+	 * fixes the association between descriptor and rx queue. Several rx
+	 * rings can share a group, so record the ring and not the group.
 	 */
-	skb_record_rx_queue(skb, ldg->msi_grp);
+	skb_record_rx_queue(skb, (u16)(rxc - np->rx_channel));
 	/* GRO (Generic receive offload) of the Linux kernel network protocol
 	 * stack If the driver supported by GRO is processed in this way, read
 	 * the data packet in the callback method of NAPI, and then call the
@@ -1393,6 +1417,10 @@ static int oak_net_process_alloc_skb(oak_rx_chan_t *rxc, int *tlen)
 		rxc->skb = netdev_alloc_skb(np->netdev, OAK_RX_SKB_ALLOC_SIZE);
 		/* Default checksum */
 		rxc->skb->ip_summed = CHECKSUM_NONE;
+#ifdef OAK_PAGE_POOL
+		/* Page fragments go back to the page pool on free */
+		skb_mark_for_recycle(rxc->skb);
+#endif
 		good_frame = 0;
 	} else {
 		/* continue last good frame == 1 */
@@ -1444,6 +1472,12 @@ static void oak_net_unmap_and_free_page(oak_t *np, oak_rxa_t *rba,
 					oak_rx_chan_t *rxc,
 					struct page *page, int good_frame)
 {
+#ifdef OAK_PAGE_POOL
+	/* A good buffer hands its fragment reference over to the skb */
+	if (good_frame == 0)
+		page_pool_put_full_page(rxc->page_pool, page, true);
+	rba->page_phys = 0;
+#else
 	if (rba->page_phys != 0) {
 		dma_unmap_page(np->device, rba->page_phys,
 			       np->page_size, DMA_FROM_DEVICE);
@@ -1462,6 +1496,7 @@ static void oak_net_unmap_and_free_page(oak_t *np, oak_rxa_t *rba,
 		if (good_frame == 1)
 			get_page(page);
 	}
+#endif
 	rba->page_virt = NULL;
 }
 
@@ -1522,6 +1557,170 @@ static void oak_net_update_stats(oak_rx_chan_t *rxc, oak_rxs_t *rsr,
 	}
 }
 
+#ifdef OAK_PAGE_POOL
+/* Name        : oak_net_rx_pool_create
+ * Returns     : int
+ * Parameters  : oak_t *np, oak_rx_chan_t *rxc, u32 ring
+ * Description : This function creates the page pool of a rx channel and
+ * registers it as the XDP memory model of the channel.
+ */
+int oak_net_rx_pool_create(oak_t *np, oak_rx_chan_t *rxc, u32 ring)
+{
+	struct page_pool_params pp_params = { 0 };
+	int retval = 0;
+
+	pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
+#ifdef PP_FLAG_PAGE_FRAG
+	/* rbr_bpage buffers share one page */
+	pp_params.flags |= PP_FLAG_PAGE_FRAG;
+#endif
+	pp_params.order = 0;
+	pp_params.pool_size = rxc->rbr_size;
+	pp_params.nid = dev_to_node(np->device);
+	pp_params.dev = np->device;
+	pp_params.dma_dir = DMA_FROM_DEVICE;
+	pp_params.offset = 0;
+	pp_params.max_len = PAGE_SIZE;
+
+	rxc->page_pool = page_pool_create(&pp_params);
+	if (IS_ERR(rxc->page_pool)) {
+		retval = PTR_ERR(rxc->page_pool);
+		rxc->page_pool = NULL;
+	} else {
+		retval = xdp_rxq_info_reg(&rxc->xdp_rxq, np->netdev, ring, 0);
+		if (retval == 0)
+			retval = xdp_rxq_info_reg_mem_model(&rxc->xdp_rxq,
+							    MEM_TYPE_PAGE_POOL,
+							    rxc->page_pool);
+		if (retval != 0)
+			oak_net_rx_pool_destroy(rxc);
+	}
+	rxc->xdp_bc = 0;
+	oakdbg(debug, PROBE, "ring=%d page_pool=%p rc=%d", ring,
+	       rxc->page_pool, retval);
+
+	return retval;
+}
+
+/* Name        : oak_net_rx_pool_destroy
+ * Returns     : void
+ * Parameters  : oak_rx_chan_t *rxc
+ * Description : This function destroys the page pool of a rx channel
+ */
+void oak_net_rx_pool_destroy(oak_rx_chan_t *rxc)
+{
+	if (xdp_rxq_info_is_reg(&rxc->xdp_rxq))
+		xdp_rxq_info_unreg(&rxc->xdp_rxq);
+	if (rxc->page_pool) {
+		page_pool_destroy(rxc->page_pool);
+		rxc->page_pool = NULL;
+	}
+}
+
+/* Name        : oak_net_run_xdp
+ * Returns     : bool
+ * Parameters  : oak_rx_chan_t *rxc, struct bpf_prog *prog
+ * Description : This function runs the XDP program on the frame at the
+ * current read index. Only single buffer frames are handed to the program,
+ * which oak_net_bpf guarantees by limiting the MTU. On XDP_PASS the frame
+ * boundaries chosen by the program are recorded for the regular rx path
+ * and false is returned. Every other verdict drops the frame, recycles its
+ * buffer and returns true.
+ */
+static bool oak_net_run_xdp(oak_rx_chan_t *rxc, struct bpf_prog *prog)
+{
+	oak_t *np = rxc->oak;
+	oak_rxs_t *rsr = &rxc->rsr[rxc->rbr_ridx];
+	oak_rxa_t *rba = &rxc->rba[rxc->rbr_ridx];
+	struct page *page = rba->page_virt;
+	u32 off = (mhdr != 0) ? 2 : 0;
+	struct xdp_buff xdp;
+	bool consumed = false;
+	u8 *va;
+	u32 act;
+
+	if (!page || rsr->first_last != 3 || rsr->bc <= off)
+		return false;
+
+	dma_sync_single_range_for_cpu(np->device,
+				      page_pool_get_dma_addr(page),
+				      rba->page_offs, rsr->bc,
+				      DMA_FROM_DEVICE);
+	va = page_address(page) + rba->page_offs;
+	xdp_init_buff(&xdp, rxc->rbr_bsize, &rxc->xdp_rxq);
+	xdp_prepare_buff(&xdp, va, off, rsr->bc - off, false);
+
+	act = bpf_prog_run_xdp(prog, &xdp);
+	switch (act) {
+	case XDP_PASS:
+		break;
+	default:
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 17, 0)
+		bpf_warn_invalid_xdp_action(np->netdev, prog, act);
+#else
+		bpf_warn_invalid_xdp_action(act);
+#endif
+		fallthrough;
+	case XDP_ABORTED:
+		trace_xdp_exception(np->netdev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		consumed = true;
+		break;
+	}
+
+	if (!consumed && xdp.data_end > xdp.data) {
+		/* Program may have moved the start or end of the frame.
+		 * The rx path adds the Marvell header offset itself.
+		 */
+		rba->page_offs += (u32)((u8 *)xdp.data - va) - off;
+		rxc->xdp_bc = (u32)((u8 *)xdp.data_end - (u8 *)xdp.data) + off;
+	} else {
+		consumed = true;
+		page_pool_put_full_page(rxc->page_pool, page, true);
+		rba->page_virt = NULL;
+		rba->page_phys = 0;
+		++rxc->stat.rx_xdp_drop;
+		if (rxc->rbr_size > 0)
+			rxc->rbr_ridx = NEXT_IDX(rxc->rbr_ridx, rxc->rbr_size);
+		atomic_dec(&rxc->rbr_pend);
+	}
+
+	return consumed;
+}
+
+/* Name        : oak_net_bpf
+ * Returns     : int
+ * Parameters  : struct net_device *net_dev, struct netdev_bpf *bpf
+ * Description : This function attaches or detaches the XDP program
+ */
+int oak_net_bpf(struct net_device *net_dev, struct netdev_bpf *bpf)
+{
+	oak_t *np = netdev_priv(net_dev);
+	struct bpf_prog *old_prog;
+	int retval = 0;
+
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		if (bpf->prog && net_dev->mtu > OAK_XDP_MAX_MTU) {
+			NL_SET_ERR_MSG_MOD(bpf->extack,
+					   "MTU too large for XDP, frames must fit one Rx buffer");
+			retval = -EOPNOTSUPP;
+		} else {
+			old_prog = xchg(&np->xdp_prog, bpf->prog);
+			if (old_prog)
+				bpf_prog_put(old_prog);
+		}
+		break;
+	default:
+		retval = -EINVAL;
+		break;
+	}
+
+	return retval;
+}
+#endif
+
 /* Name        : oak_net_process_rx_pkt
  * Returns     : int
  * Parameters  : oak_rx_chan_t * rxc, u32 desc_num, struct sk_buff **target
@@ -1539,6 +1738,16 @@ static int oak_net_process_rx_pkt(oak_rx_chan_t *rxc, u32 desc_num,
 	struct page *page;
 	u32 off = 0;
 	int retval;
+#ifdef OAK_PAGE_POOL
+	struct bpf_prog *xdp_prog = READ_ONCE(np->xdp_prog);
+
+	/* An XDP verdict other than XDP_PASS consumes the buffer before
+	 * any skb is allocated for it.
+	 */
+	if (xdp_prog && !rxc->skb && desc_num > 0 &&
+	    oak_net_run_xdp(rxc, xdp_prog))
+		return 1;
+#endif
 
 	good_frame = oak_net_process_alloc_skb(rxc, &tlen);
 
@@ -1558,8 +1767,20 @@ static int oak_net_process_rx_pkt(oak_rx_chan_t *rxc, u32 desc_num,
 			 * Page address
 			 */
 			blen = rsr->bc;
-			tlen += blen;
 			page = rba->page_virt;
+#ifdef OAK_PAGE_POOL
+			if (rxc->xdp_bc != 0) {
+				/* Already synced and seen by the XDP program */
+				blen = rxc->xdp_bc;
+				rxc->xdp_bc = 0;
+			} else if (page) {
+				dma_sync_single_range_for_cpu(np->device,
+							      page_pool_get_dma_addr(page),
+							      rba->page_offs, blen,
+							      DMA_FROM_DEVICE);
+			}
+#endif
+			tlen += blen;
 
 			/* If the page is valid then, the received frame is a
 			 * good frame.  We do the following
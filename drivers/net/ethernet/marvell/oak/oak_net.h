@@ -33,6 +33,14 @@
 
 #define OAK_ONEBYTE 1
 
+#ifdef OAK_PAGE_POOL
+/* Largest MTU for which a frame, including VLAN tag, FCS and the optional
+ * Marvell header, fits into one Rx buffer
+ */
+#define OAK_XDP_MAX_MTU (OAK_RX_BUFFER_SIZE - ETH_HLEN - VLAN_HLEN - \
+			 ETH_FCS_LEN - 2)
+#endif
+
 extern u32 rxs;
 extern u32 txs;
 extern int chan;
@@ -108,14 +116,14 @@ int oak_net_set_mac_addr(struct net_device *dev, void *p_addr);
 struct page *oak_net_alloc_page(oak_t *np, dma_addr_t *dma,
 				enum dma_data_direction dir);
 
-/* Name        : oak_net_select_queue
- * Returns     : u16
- * Parameters  : struct net_device *dev, struct sk_buff *skb,
- * struct net_device *sb_dev
- * Description : This function pre-seed the SKB by recording the RX queue
+#ifdef OAK_PAGE_POOL
+/* Name        : oak_net_bpf
+ * Returns     : int
+ * Parameters  : struct net_device *net_dev, struct netdev_bpf *bpf
+ * Description : This function attaches or detaches the XDP program
  */
-u16 oak_net_select_queue(struct net_device *dev, struct sk_buff *skb,
-			 struct net_device *sb_dev);
+int oak_net_bpf(struct net_device *net_dev, struct netdev_bpf *bpf);
+#endif
 
 /* Name      : xmit_frame
  * Returns   : int
@@ -277,6 +277,10 @@ int oak_unimac_alloc_channels(oak_t *np, u32 rxs, u32 txs, int chan, int rto)
 
 		retval = oak_unimac_alloc_memory_rx(np, rxc, max_rx_size);
 
+#ifdef OAK_PAGE_POOL
+		if (retval == 0)
+			retval = oak_net_rx_pool_create(np, rxc, i);
+#endif
 		if (retval == 0) {
 			++np->num_rx_chan;
 			++i;
@@ -386,6 +390,9 @@ static void oak_unimac_free_rx_channels(oak_t *np)
 		/* Free previously allocated memory for rba */
 		kfree(chan->rba);
 		chan->rba = NULL;
+#ifdef OAK_PAGE_POOL
+		oak_net_rx_pool_destroy(chan);
+#endif
 
 		--num_rx_chan;
 	}
@@ -40,6 +40,24 @@
 /* Include for relation to classifier oak_irq */
 #include "oak_irq.h"
 
+#include <nvidia/conftest.h>
+#include <linux/version.h>
+#if IS_ENABLED(CONFIG_PAGE_POOL) && \
+	(LINUX_VERSION_CODE >= KERNEL_VERSION(5, 15, 0))
+#if defined(NV_NET_PAGE_POOL_H_PRESENT)
+#include <net/page_pool.h>
+#else
+#include <net/page_pool/types.h>
+#include <net/page_pool/helpers.h>
+#endif
+#include <linux/bpf.h>
+#include <linux/bpf_trace.h>
+#include <linux/filter.h>
+#include <net/xdp.h>
+/* Rx buffers come from a per channel page_pool and XDP is supported */
+#define OAK_PAGE_POOL
+#endif
+
 #define OAK_REVISION_B0 1
 
 #define OAK_PCIE_REGOFF_UNIMAC 0x00050000U
@@ -379,6 +397,12 @@ typedef struct oak_rx_chan_tstruct {
 	oak_mbox_t *mbox;
 	oak_driver_rx_stat stat;
 	struct sk_buff *skb;
+#ifdef OAK_PAGE_POOL
+	struct page_pool *page_pool;
+	struct xdp_rxq_info xdp_rxq;
+	/* Byte count of the current buffer after an XDP_PASS, 0 if unused */
+	u32 xdp_bc;
+#endif
 } oak_rx_chan_t;
 
 typedef struct oak_txi_tstruct {
@@ -467,10 +491,29 @@ typedef struct oak_tstruct {
 	u16 rrs;
 	u32 speed;
 	char mac_address[ETH_ALEN];
+#ifdef OAK_PAGE_POOL
+	struct bpf_prog *xdp_prog;
+#endif
 } oak_t;
 
 int oak_net_rbr_refill(oak_t *np, u32 ring);
 
+#ifdef OAK_PAGE_POOL
+/* Name        : oak_net_rx_pool_create
+ * Returns     : int
+ * Parameters  : oak_t *np, oak_rx_chan_t *rxc, u32 ring
+ * Description : This function creates the page pool of a rx channel
+ */
+int oak_net_rx_pool_create(oak_t *np, oak_rx_chan_t *rxc, u32 ring);
+
+/* Name        : oak_net_rx_pool_destroy
+ * Returns     : void
+ * Parameters  : oak_rx_chan_t *rxc
+ * Description : This function destroys the page pool of a rx channel
+ */
+void oak_net_rx_pool_destroy(oak_rx_chan_t *rxc);
+#endif
+
 /* Name        : oak_unimac_disable_and_get_tx_irq_reason
  * Returns     : u32
  * Parameters  : oak_t *np, u32 ring, u32 *dma_ptr
@@ -18,6 +18,7 @@
 #include <linux/rtnetlink.h>
 #include <linux/iopoll.h>
 #include <linux/crc16.h>
+#include <net/page_pool.h>
 #include "lan743x_main.h"
 #include "lan743x_ethtool.h"
 
@@ -524,6 +525,7 @@ static int lan743x_intr_open(struct lan743x_adapter *adapter)
 	u32 flags = 0;
 
 	intr->number_of_vectors = 0;
+	intr->number_of_rx_vectors = 0;
 
 	/* Try to set up MSIX interrupts */
 	max_vector_count = adapter->max_vector_count;
@@ -693,6 +695,7 @@ static int lan743x_intr_open(struct lan743x_adapter *adapter)
 
 		if (number_of_rx_vectors > LAN743X_USED_RX_CHANNELS)
 			number_of_rx_vectors = LAN743X_USED_RX_CHANNELS;
+		intr->number_of_rx_vectors = number_of_rx_vectors;
 
 		flags = LAN743X_VECTOR_FLAG_SOURCE_STATUS_READ |
 			LAN743X_VECTOR_FLAG_SOURCE_STATUS_W2C |
@@ -1581,8 +1584,48 @@ return_error:
 	return ret;
 }
 
+static void lan743x_rfe_rss_init(struct lan743x_adapter *adapter)
+{
+	int rx_queues = max(adapter->intr.number_of_rx_vectors, 1);
+	int dword_index, byte_index;
+	u32 value;
+	u8 key[40];
+
+	/* keep a table configured through ethtool -X */
+	if (netif_is_rxfh_configured(adapter->netdev))
+		return;
+
+	netdev_rss_key_fill(key, sizeof(key));
+	for (dword_index = 0; dword_index < 10; dword_index++) {
+		byte_index = dword_index << 2;
+		value = ((((u32)(key[byte_index + 0])) << 0) |
+			(((u32)(key[byte_index + 1])) << 8) |
+			(((u32)(key[byte_index + 2])) << 16) |
+			(((u32)(key[byte_index + 3])) << 24));
+		lan743x_csr_write(adapter, RFE_HASH_KEY(dword_index), value);
+	}
+
+	/* only spread flows over channels that own an MSI-X vector, the
+	 * others are serviced from the shared vector 0 handler
+	 */
+	for (dword_index = 0; dword_index < 32; dword_index++) {
+		byte_index = dword_index << 2;
+		value = ((ethtool_rxfh_indir_default(byte_index + 0,
+						     rx_queues) << 0) |
+			(ethtool_rxfh_indir_default(byte_index + 1,
+						    rx_queues) << 8) |
+			(ethtool_rxfh_indir_default(byte_index + 2,
+						    rx_queues) << 16) |
+			(ethtool_rxfh_indir_default(byte_index + 3,
+						    rx_queues) << 24));
+		lan743x_csr_write(adapter, RFE_INDX(dword_index), value);
+	}
+}
+
 static void lan743x_rfe_open(struct lan743x_adapter *adapter)
 {
+	lan743x_rfe_rss_init(adapter);
+
 	lan743x_csr_write(adapter, RFE_RSS_CFG,
 		RFE_RSS_CFG_UDP_IPV6_EX_ |
 		RFE_RSS_CFG_TCP_IPV6_EX_ |
@@ -2482,26 +2525,19 @@ static void lan743x_rx_update_tail(struct lan743x_rx *rx, int index)
 static int lan743x_rx_init_ring_element(struct lan743x_rx *rx, int index,
 					gfp_t gfp)
 {
-	struct net_device *netdev = rx->adapter->netdev;
 	struct device *dev = &rx->adapter->pdev->dev;
 	struct lan743x_rx_buffer_info *buffer_info;
 	unsigned int buffer_length, used_length;
 	struct lan743x_rx_descriptor *descriptor;
-	struct sk_buff *skb;
-	dma_addr_t dma_ptr;
+	struct page *page;
 
-	buffer_length = netdev->mtu + ETH_HLEN + ETH_FCS_LEN + RX_HEAD_PADDING;
+	buffer_length = LAN743X_RX_BUFFER_SIZE;
 
 	descriptor = &rx->ring_cpu_ptr[index];
 	buffer_info = &rx->buffer_info[index];
-	skb = __netdev_alloc_skb(netdev, buffer_length, gfp);
-	if (!skb)
-		return -ENOMEM;
-	dma_ptr = dma_map_single(dev, skb->data, buffer_length, DMA_FROM_DEVICE);
-	if (dma_mapping_error(dev, dma_ptr)) {
-		dev_kfree_skb_any(skb);
+	page = page_pool_alloc_pages(rx->page_pool, gfp | __GFP_NOWARN);
+	if (!page)
 		return -ENOMEM;
-	}
 	if (buffer_info->dma_ptr) {
 		/* sync used area of buffer only */
 		if (le32_to_cpu(descriptor->data0) & RX_DESC_DATA0_LS_)
@@ -2514,17 +2550,15 @@ static int lan743x_rx_init_ring_element(struct lan743x_rx *rx, int index,
 					  buffer_info->buffer_length);
 		else
 			used_length = buffer_info->buffer_length;
+		/* the mapping itself stays with the page pool */
 		dma_sync_single_for_cpu(dev, buffer_info->dma_ptr,
 					used_length,
 					DMA_FROM_DEVICE);
-		dma_unmap_single_attrs(dev, buffer_info->dma_ptr,
-				       buffer_info->buffer_length,
-				       DMA_FROM_DEVICE,
-				       DMA_ATTR_SKIP_CPU_SYNC);
 	}
 
-	buffer_info->skb = skb;
-	buffer_info->dma_ptr = dma_ptr;
+	buffer_info->page = page;
+	buffer_info->dma_ptr = page_pool_get_dma_addr(page) +
+			       LAN743X_RX_HEADROOM;
 	buffer_info->buffer_length = buffer_length;
 	descriptor->data1 = cpu_to_le32(DMA_ADDR_LOW32(buffer_info->dma_ptr));
 	descriptor->data2 = cpu_to_le32(DMA_ADDR_HIGH32(buffer_info->dma_ptr));
@@ -2563,17 +2597,10 @@ static void lan743x_rx_release_ring_element(struct lan743x_rx *rx, int index)
 
 	memset(descriptor, 0, sizeof(*descriptor));
 
-	if (buffer_info->dma_ptr) {
-		dma_unmap_single(&rx->adapter->pdev->dev,
-				 buffer_info->dma_ptr,
-				 buffer_info->buffer_length,
-				 DMA_FROM_DEVICE);
-		buffer_info->dma_ptr = 0;
-	}
-
-	if (buffer_info->skb) {
-		dev_kfree_skb(buffer_info->skb);
-		buffer_info->skb = NULL;
+	if (buffer_info->page) {
+		page_pool_put_full_page(rx->page_pool, buffer_info->page,
+					false);
+		buffer_info->page = NULL;
 	}
 
 	memset(buffer_info, 0, sizeof(*buffer_info));
@@ -2582,15 +2609,11 @@ static void lan743x_rx_release_ring_element(struct lan743x_rx *rx, int index)
 static struct sk_buff *
 lan743x_rx_trim_skb(struct sk_buff *skb, int frame_length)
 {
-	if (skb_linearize(skb)) {
+	frame_length = max_t(int, 0, frame_length - ETH_FCS_LEN);
+	if (pskb_trim(skb, frame_length)) {
 		dev_kfree_skb_irq(skb);
 		return NULL;
 	}
-	frame_length = max_t(int, 0, frame_length - ETH_FCS_LEN);
-	if (skb->len > frame_length) {
-		skb->tail -= skb->len - frame_length;
-		skb->len = frame_length;
-	}
 	return skb;
 }
 
@@ -2606,6 +2629,7 @@ static int lan743x_rx_process_buffer(struct lan743x_rx *rx)
 	int extension_index = -1;
 	bool is_last, is_first;
 	struct sk_buff *skb;
+	struct page *page;
 
 	if (current_head_index < 0 || current_head_index >= rx->ring_size)
 		goto done;
@@ -2658,11 +2682,10 @@ static int lan743x_rx_process_buffer(struct lan743x_rx *rx)
 		   is_last  ? "last  " : "      ",
 		   frame_length, buffer_length);
 
-	/* save existing skb, allocate new skb and map to dma */
-	skb = buffer_info->skb;
-	if (lan743x_rx_init_ring_element(rx, rx->last_head,
-					 GFP_ATOMIC | GFP_DMA)) {
-		/* failed to allocate next skb.
+	/* save existing page, allocate a new one from the page pool */
+	page = buffer_info->page;
+	if (lan743x_rx_init_ring_element(rx, rx->last_head, GFP_ATOMIC)) {
+		/* failed to allocate next page.
 		 * Memory is very low.
 		 * Drop this packet and reuse buffer.
 		 */
@@ -2673,29 +2696,35 @@ static int lan743x_rx_process_buffer(struct lan743x_rx *rx)
 		goto process_extension;
 	}
 
-	/* add buffers to skb via skb->frag_list */
+	/* build the skb on the first page, add the others as page frags */
 	if (is_first) {
-		skb_reserve(skb, RX_HEAD_PADDING);
-		skb_put(skb, buffer_length - RX_HEAD_PADDING);
 		if (rx->skb_head)
 			dev_kfree_skb_irq(rx->skb_head);
+		rx->skb_head = NULL;
+		skb = napi_build_skb(page_address(page), PAGE_SIZE);
+		if (!skb) {
+			page_pool_recycle_direct(rx->page_pool, page);
+			goto process_extension;
+		}
+		skb_mark_for_recycle(skb);
+		skb_reserve(skb, LAN743X_RX_HEADROOM + RX_HEAD_PADDING);
+		skb_put(skb, buffer_length - RX_HEAD_PADDING);
 		rx->skb_head = skb;
-	} else if (rx->skb_head) {
-		skb_put(skb, buffer_length);
-		if (skb_shinfo(rx->skb_head)->frag_list)
-			rx->skb_tail->next = skb;
-		else
-			skb_shinfo(rx->skb_head)->frag_list = skb;
-		rx->skb_tail = skb;
-		rx->skb_head->len += skb->len;
-		rx->skb_head->data_len += skb->len;
-		rx->skb_head->truesize += skb->truesize;
+	} else if (rx->skb_head &&
+		   skb_shinfo(rx->skb_head)->nr_frags < MAX_SKB_FRAGS) {
+		skb_add_rx_frag(rx->skb_head,
+				skb_shinfo(rx->skb_head)->nr_frags, page,
+				LAN743X_RX_HEADROOM, buffer_length, PAGE_SIZE);
 	} else {
 		/* packet to assemble has already been dropped because one or
-		 * more of its buffers could not be allocated
+		 * more of its buffers could not be allocated, or it has more
+		 * buffers than an skb can hold
 		 */
 		netdev_dbg(netdev, "drop buffer intended for dropped packet");
-		dev_kfree_skb_irq(skb);
+		page_pool_recycle_direct(rx->page_pool, page);
+		if (rx->skb_head)
+			dev_kfree_skb_irq(rx->skb_head);
+		rx->skb_head = NULL;
 	}
 
 process_extension:
@@ -2722,7 +2751,7 @@ process_extension:
 							rx->adapter->netdev);
 		if (rx->adapter->netdev->features & NETIF_F_RXCSUM) {
 			if (!is_ice && !is_tce && !is_icsm)
-				skb->ip_summed = CHECKSUM_UNNECESSARY;
+				rx->skb_head->ip_summed = CHECKSUM_UNNECESSARY;
 		}
 		netdev_dbg(netdev, "sending %d byte frame to OS",
 			   rx->skb_head->len);
@@ -2810,10 +2839,37 @@ static void lan743x_rx_ring_cleanup(struct lan743x_rx *rx)
 		rx->ring_dma_ptr = 0;
 	}
 
+	if (rx->page_pool) {
+		page_pool_destroy(rx->page_pool);
+		rx->page_pool = NULL;
+	}
+
 	rx->ring_size = 0;
 	rx->last_head = 0;
 }
 
+static int lan743x_rx_page_pool_create(struct lan743x_rx *rx)
+{
+	struct page_pool_params pp_params = { 0 };
+	struct page_pool *page_pool;
+
+	pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
+	pp_params.order = 0;
+	pp_params.pool_size = rx->ring_size;
+	pp_params.nid = dev_to_node(&rx->adapter->pdev->dev);
+	pp_params.dev = &rx->adapter->pdev->dev;
+	pp_params.dma_dir = DMA_FROM_DEVICE;
+	pp_params.offset = LAN743X_RX_HEADROOM;
+	pp_params.max_len = LAN743X_RX_BUFFER_SIZE;
+
+	page_pool = page_pool_create(&pp_params);
+	if (IS_ERR(page_pool))
+		return PTR_ERR(page_pool);
+
+	rx->page_pool = page_pool;
+	return 0;
+}
+
 static int lan743x_rx_ring_init(struct lan743x_rx *rx)
 {
 	size_t ring_allocation_size = 0;
@@ -2875,6 +2931,11 @@ static int lan743x_rx_ring_init(struct lan743x_rx *rx)
 		goto cleanup;
 	}
 
+	/* DMA mask must be set before the pool maps any page */
+	ret = lan743x_rx_page_pool_create(rx);
+	if (ret)
+		goto cleanup;
+
 	rx->last_head = 0;
 	for (index = 0; index < rx->ring_size; index++) {
 		ret = lan743x_rx_init_ring_element(rx, index, GFP_KERNEL);
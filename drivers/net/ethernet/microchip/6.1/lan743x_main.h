@@ -905,6 +905,7 @@ struct lan743x_intr {
 
 	struct lan743x_vector	vector_list[PCI11X1X_MAX_VECTOR_COUNT];
 	int			number_of_vectors;
+	int			number_of_rx_vectors;
 	bool			using_vectors;
 
 	bool			software_isr_flag;
@@ -993,7 +994,9 @@ struct lan743x_rx {
 
 	u32		frame_count;
 
-	struct sk_buff *skb_head, *skb_tail;
+	struct page_pool *page_pool;
+
+	struct sk_buff *skb_head;
 };
 
 /* SGMII Link Speed Duplex status */
@@ -1140,6 +1143,14 @@ struct lan743x_tx_buffer_info {
 
 #define RX_HEAD_PADDING		NET_IP_ALIGN
 
+/* Rx buffers are order-0 page_pool pages with room for build_skb(); larger
+ * frames span several buffers and are assembled as page frags.
+ */
+#define LAN743X_RX_HEADROOM		NET_SKB_PAD
+#define LAN743X_RX_BUFFER_SIZE		\
+	min_t(unsigned int, RX_DESC_DATA0_BUF_LENGTH_MASK_, \
+	      SKB_WITH_OVERHEAD(PAGE_SIZE - LAN743X_RX_HEADROOM))
+
 struct lan743x_rx_descriptor {
 	__le32     data0;
 	__le32     data1;
@@ -1150,7 +1161,7 @@ struct lan743x_rx_descriptor {
 #define RX_BUFFER_INFO_FLAG_ACTIVE      BIT(0)
 struct lan743x_rx_buffer_info {
 	int flags;
-	struct sk_buff *skb;
+	struct page *page;
 
 	dma_addr_t      dma_ptr;
 	unsigned int    buffer_length;
@@ -258,11 +258,66 @@ static irqreturn_t ether_common_isr_thread(int irq, void *data)
 }
 #endif
 
+/**
+ * @brief Refresh MMC and core stats from the ethernet server
+ *
+ * @param[in] pdata: OSD private data.
+ * @param[in] force: Refresh even if the last snapshot is still fresh.
+ *
+ * @retval 0 on success
+ * @retval negative value on failure.
+ */
+int ether_ivc_read_stats(struct ether_priv_data *pdata, bool force)
+{
+	struct osi_core_priv_data *osi_core = pdata->osi_core;
+	struct ether_ivc_ctxt *ictxt = &pdata->ictxt;
+	struct osi_ioctl ioctl_data = {};
+	int ret = 0;
+
+	mutex_lock(&ictxt->stats_lock);
+	/*
+	 * Every read is two synchronous IVC round trips to the ethernet
+	 * server, so concurrent readers (stats work, ethtool -S, sysfs
+	 * snapshot) within ETHER_IVC_STATS_MAX_AGE share one refresh.
+	 */
+	if (!force && ictxt->stats_valid &&
+	    time_before(jiffies, ictxt->stats_expires))
+		goto unlock;
+
+	ioctl_data.cmd = OSI_CMD_READ_MMC;
+	ret = osi_handle_ioctl(osi_core, &ioctl_data);
+	if (ret < 0) {
+		dev_err(pdata->dev, "failed to read MMC counters\n");
+		goto invalidate;
+	}
+
+	ioctl_data.cmd = OSI_CMD_READ_STATS;
+	ret = osi_handle_ioctl(osi_core, &ioctl_data);
+	if (ret < 0) {
+		dev_err(pdata->dev, "failed to read core stats\n");
+		goto invalidate;
+	}
+
+	ictxt->stats_expires = jiffies +
+			       msecs_to_jiffies(ETHER_IVC_STATS_MAX_AGE);
+	ictxt->stats_valid = true;
+	goto unlock;
+
+invalidate:
+	ictxt->stats_valid = false;
+unlock:
+	mutex_unlock(&ictxt->stats_lock);
+	return ret;
+}
+
 /**
  * @brief Work Queue function to call osi_read_mmc() periodically.
  *
  * Algorithm: call osi_read_mmc in periodic manner to avoid possibility of
- * overrun of 32 bit MMC hw registers.
+ * overrun of 32 bit MMC hw registers. With virtualization the MMC and core
+ * stats (EST gate errors, HLBS/HLBF per queue) live with the ethernet
+ * server, the work keeps a local snapshot of them so that stats readers
+ * normally do not need an IVC round trip.
  *
  * @param[in] work: work structure
  *
@@ -277,11 +332,15 @@ static inline void ether_stats_work_func(struct work_struct *work)
 	struct osi_ioctl ioctl_data = {};
 	int ret;
 
-	ioctl_data.cmd = OSI_CMD_READ_MMC;
-	ret = osi_handle_ioctl(osi_core, &ioctl_data);
-	if (ret < 0) {
-		dev_err(pdata->dev, "failed to read MMC counters %s\n",
-			__func__);
+	if (osi_core->use_virtualization == OSI_ENABLE) {
+		ether_ivc_read_stats(pdata, true);
+	} else {
+		ioctl_data.cmd = OSI_CMD_READ_MMC;
+		ret = osi_handle_ioctl(osi_core, &ioctl_data);
+		if (ret < 0) {
+			dev_err(pdata->dev, "failed to read MMC counters %s\n",
+				__func__);
+		}
 	}
 	schedule_delayed_work(&pdata->ether_stats_work,
 			      msecs_to_jiffies(pdata->stats_timer));
@@ -361,10 +420,7 @@ static inline void ether_hsi_work_func(struct work_struct *work)
  */
 static inline void ether_stats_work_queue_start(struct ether_priv_data *pdata)
 {
-	struct osi_core_priv_data *osi_core = pdata->osi_core;
-
-	if (pdata->hw_feat.mmc_sel == OSI_ENABLE &&
-	    osi_core->use_virtualization == OSI_DISABLE) {
+	if (pdata->hw_feat.mmc_sel == OSI_ENABLE) {
 		schedule_delayed_work(&pdata->ether_stats_work,
 				      msecs_to_jiffies(pdata->stats_timer));
 	}
@@ -380,11 +436,9 @@ static inline void ether_stats_work_queue_start(struct ether_priv_data *pdata)
  */
 static inline void ether_stats_work_queue_stop(struct ether_priv_data *pdata)
 {
-	struct osi_core_priv_data *osi_core = pdata->osi_core;
-
-	if (pdata->hw_feat.mmc_sel == OSI_ENABLE &&
-	    osi_core->use_virtualization == OSI_DISABLE) {
+	if (pdata->hw_feat.mmc_sel == OSI_ENABLE) {
 		cancel_delayed_work_sync(&pdata->ether_stats_work);
+		pdata->ictxt.stats_valid = false;
 	}
 }
 
@@ -1415,7 +1469,12 @@ static irqreturn_t ether_rx_chan_isr(int irq, void *data)
 /**
  * @brief Common ISR Routine
  *
- * Algorithm: Invoke OSI layer to handle common interrupt.
+ * Algorithm:
+ * 1) Invoke OSI layer to handle common interrupt.
+ * 2) MAC Tx timestamp status is reported through the common interrupt, so
+ *    hand over any delayed Tx timestamps to the stack right away instead of
+ *    waiting for the polling work. The work is only kicked if a timestamp
+ *    is still not available.
  *
  * @param[in] irq: IRQ number.
  * @param[in] data: Private data from ISR.
@@ -1438,6 +1497,11 @@ static irqreturn_t ether_common_isr(int irq, void *data)
 		dev_err(pdata->dev,
 			"%s() failure in handling ISR\n", __func__);
 	}
+
+	if (!list_empty(&pdata->tx_ts_skb_head) &&
+	    ether_get_tx_ts(pdata) == -EAGAIN)
+		schedule_delayed_work(&pdata->tx_ts_work,
+				      msecs_to_jiffies(ETHER_TS_MS_TIMER));
 #ifdef HSI_SUPPORT
 	if (pdata->osi_core->hsi.enabled == OSI_ENABLE &&
 	    pdata->osi_core->hsi.report_err == OSI_ENABLE)
@@ -1515,6 +1579,7 @@ static void ether_start_ivc(struct ether_priv_data *pdata)
 		tegra_hv_ivc_channel_reset(ictxt->ivck);
 		ictxt->ivc_state = 1;
 		raw_spin_lock_init(&ictxt->ivck_lock);
+		ictxt->stats_valid = false;
 	}
 }
 
@@ -1586,6 +1651,7 @@ static int ether_init_ivc(struct ether_priv_data *pdata)
 	dev_info(dev, "Reserved IVC channel #%u - frame_size=%d irq %d\n",
 		 id, ictxt->ivck->frame_size, ictxt->ivck->irq);
 	osi_core->osd_ops.ivc_send = osd_ivc_send_cmd;
+	mutex_init(&ictxt->stats_lock);
 	ether_start_ivc(pdata);
 	return 0;
 }
@@ -1733,9 +1799,33 @@ static void ether_napi_disable(struct ether_priv_data *pdata)
 		napi_disable(&pdata->tx_napi[chan]->napi);
 		napi_synchronize(&pdata->rx_napi[chan]->napi);
 		napi_disable(&pdata->rx_napi[chan]->napi);
+#ifdef ETHER_DIM
+		/* NAPI is off, nothing can re-arm the DIM hold-off anymore */
+		hrtimer_cancel(&pdata->rx_napi[chan]->dim_timer);
+		cancel_work_sync(&pdata->rx_napi[chan]->rx_dim.work);
+		cancel_work_sync(&pdata->tx_napi[chan]->tx_dim.work);
+#endif
 	}
 }
 
+#ifdef ETHER_DIM
+/**
+ * @brief Reset a DIM context before its channel is started.
+ *
+ * @param[in] dim: DIM context.
+ */
+static void ether_dim_reset(struct dim *dim)
+{
+	dim->state = DIM_START_MEASURE;
+	dim->tune_state = DIM_PARKING_ON_TOP;
+	dim->profile_ix = 0;
+	dim->steps_left = 0;
+	dim->steps_right = 0;
+	dim->tired = 0;
+	dim->mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+}
+#endif
+
 /**
  * @brief Enable NAPI.
  *
@@ -1754,6 +1844,13 @@ static void ether_napi_enable(struct ether_priv_data *pdata)
 	for (i = 0; i < osi_dma->num_dma_chans; i++) {
 		chan = osi_dma->dma_chans[i];
 
+		/* Start from the statically configured coalescing */
+		pdata->tx_napi[chan]->tx_usecs = osi_dma->tx_usecs;
+#ifdef ETHER_DIM
+		ether_dim_reset(&pdata->tx_napi[chan]->tx_dim);
+		pdata->rx_napi[chan]->dim_usecs = 0U;
+		ether_dim_reset(&pdata->rx_napi[chan]->rx_dim);
+#endif
 		napi_enable(&pdata->tx_napi[chan]->napi);
 		napi_enable(&pdata->rx_napi[chan]->napi);
 	}
@@ -1836,6 +1933,11 @@ static void free_rx_dma_resources(struct osi_dma_priv_data *osi_dma,
 			kfree(rx_ring);
 			osi_dma->rx_ring[i] = NULL;
 		}
+#ifdef ETHER_XDP
+		if (chan != ETHER_INVALID_CHAN_NUM &&
+		    xdp_rxq_info_is_reg(&pdata->xdp_rxq[chan]))
+			xdp_rxq_info_unreg(&pdata->xdp_rxq[chan]);
+#endif
 #ifdef ETHER_PAGE_POOL
 		if (chan != ETHER_INVALID_CHAN_NUM && pdata->page_pool[chan]) {
 			page_pool_destroy(pdata->page_pool[chan]);
@@ -1947,7 +2049,8 @@ static int ether_allocate_rx_buffers(struct ether_priv_data *pdata,
 				return -ENOMEM;
 			}
 
-			dma_addr = page_pool_get_dma_addr(page);
+			dma_addr = page_pool_get_dma_addr(page) +
+				   ETHER_RX_HEADROOM;
 			rx_swcx->buf_virt_addr = page;
 		}
 #else
@@ -1996,11 +2099,18 @@ static int ether_page_pool_create_per_chan(struct ether_priv_data *pdata,
 
 	pp_params.flags = PP_FLAG_DMA_MAP;
 	pp_params.pool_size = pool_size;
-	num_pages = DIV_ROUND_UP(osi_dma->rx_buf_len, PAGE_SIZE);
+	num_pages = DIV_ROUND_UP(osi_dma->rx_buf_len + ETHER_RX_HEADROOM,
+				 PAGE_SIZE);
 	pp_params.order = ilog2(roundup_pow_of_two(num_pages));
 	pp_params.nid = dev_to_node(pdata->dev);
 	pp_params.dev = pdata->dev;
 	pp_params.dma_dir = DMA_FROM_DEVICE;
+#ifdef ETHER_XDP
+	/* XDP programs may write the packet, sync it back on recycle */
+	pp_params.flags |= PP_FLAG_DMA_SYNC_DEV;
+	pp_params.offset = ETHER_RX_HEADROOM;
+	pp_params.max_len = osi_dma->rx_buf_len;
+#endif
 
 	pdata->page_pool[chan] = page_pool_create(&pp_params);
 	if (IS_ERR(pdata->page_pool[chan])) {
@@ -2013,6 +2123,41 @@ static int ether_page_pool_create_per_chan(struct ether_priv_data *pdata,
 }
 #endif
 
+#ifdef ETHER_XDP
+/**
+ * @brief Register XDP Rx queue info for a channel
+ *
+ * Algorithm: Registers the Rx queue with the XDP core and attaches the
+ * channel page pool as its memory model so that XDP_REDIRECT targets
+ * return pages to the right pool.
+ *
+ * @param[in] pdata: OSD private data.
+ * @param[in] qinx: Queue index of the channel.
+ * @param[in] chan: Rx DMA channel number.
+ *
+ * @retval 0 on success
+ * @retval "negative value" on failure.
+ */
+static int ether_xdp_rxq_reg(struct ether_priv_data *pdata,
+			     unsigned int qinx, unsigned int chan)
+{
+	struct xdp_rxq_info *xdp_rxq = &pdata->xdp_rxq[chan];
+	int ret;
+
+	ret = xdp_rxq_info_reg(xdp_rxq, pdata->ndev, qinx,
+			       pdata->rx_napi[chan]->napi.napi_id);
+	if (ret < 0)
+		return ret;
+
+	ret = xdp_rxq_info_reg_mem_model(xdp_rxq, MEM_TYPE_PAGE_POOL,
+					 pdata->page_pool[chan]);
+	if (ret < 0)
+		xdp_rxq_info_unreg(xdp_rxq);
+
+	return ret;
+}
+#endif
+
 /**
  * @brief Allocate Receive DMA channel ring resources.
  *
@@ -2046,6 +2191,14 @@ static int ether_allocate_rx_dma_resources(struct osi_dma_priv_data *osi_dma,
 				goto exit;
 			}
 #endif
+#ifdef ETHER_XDP
+			ret = ether_xdp_rxq_reg(pdata, i, chan);
+			if (ret < 0) {
+				pr_err("%s(): failed to register XDP rxq\n",
+				       __func__);
+				goto exit;
+			}
+#endif
 
 			ret = allocate_rx_dma_resource(osi_dma, pdata->dev,
 						       chan);
@@ -2562,6 +2715,27 @@ exit:
 	return ret;
 }
 
+/**
+ * @brief ether_reset_tx_queues - Reset BQL state of all Tx queues
+ *
+ * Algorithm: Tx rings are re-initialized on open/resume, drop whatever
+ * in-flight byte accounting was left behind for them.
+ *
+ * @param[in] pdata: OSD private data.
+ */
+static void ether_reset_tx_queues(struct ether_priv_data *pdata)
+{
+	struct osi_dma_priv_data *osi_dma = pdata->osi_dma;
+	unsigned int i, chan;
+
+	for (i = 0; i < osi_dma->num_dma_chans; i++) {
+		chan = osi_dma->dma_chans[i];
+		pdata->tx_napi[chan]->bql_pkts = 0U;
+		pdata->tx_napi[chan]->bql_bytes = 0U;
+		netdev_tx_reset_queue(netdev_get_tx_queue(pdata->ndev, i));
+	}
+}
+
 /**
  * @brief Call back to handle bring up of Ethernet interface
  *
@@ -2716,6 +2890,9 @@ static int ether_open(struct net_device *dev)
 	pdata->vlan_hash_filtering = OSI_PERFECT_FILTER_MODE;
 #endif /* ETHER_VLAN_VID_SUPPORT */
 	pdata->l2_filtering_mode = OSI_PERFECT_FILTER_MODE;
+	if (pdata->ntuple_rules)
+		memset(pdata->ntuple_rules, 0, pdata->hw_feat.l3l4_filter_num *
+		       sizeof(struct ether_ntuple_rule));
 #endif /* !OSI_STRIPPED_LIB */
 
 	/* Initialize PTP */
@@ -2748,6 +2925,7 @@ static int ether_open(struct net_device *dev)
 	phy_start(pdata->phydev);
 
 	/* start network queues */
+	ether_reset_tx_queues(pdata);
 	netif_tx_start_all_queues(pdata->ndev);
 
 	pdata->stats_timer = ETHER_STATS_TIMER;
@@ -3410,6 +3588,8 @@ static int ether_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 #ifdef OSI_ERR_DEBUG
 	unsigned int cur_tx_idx = tx_ring->cur_tx_idx;
 #endif
+	struct netdev_queue *txq = netdev_get_tx_queue(ndev, qinx);
+	unsigned int len;
 	int count = 0;
 	int ret;
 
@@ -3424,9 +3604,14 @@ static int ether_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 		return NETDEV_TX_OK;
 	}
 
+	/* Account before the ring is kicked, completion may run right away */
+	len = skb->len;
+	netdev_tx_sent_queue(txq, len);
+
 	ret = osi_hw_transmit(osi_dma, chan);
 #ifdef OSI_ERR_DEBUG
 	if (ret < 0) {
+		netdev_tx_completed_queue(txq, 1, len);
 		INCR_TX_DESC_INDEX(cur_tx_idx, count);
 		ether_tx_swcx_rollback(pdata, tx_ring, cur_tx_idx, count);
 		netdev_err(ndev, "%s() dropping corrupted skb\n", __func__);
@@ -3440,13 +3625,17 @@ static int ether_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 		netdev_dbg(ndev, "Tx ring[%d] insufficient desc.\n", chan);
 	}
 
+	/* Within a burst the coalescing timer is armed by its last skb */
+	if (netdev_xmit_more() && !netif_xmit_stopped(txq))
+		return NETDEV_TX_OK;
+
 	if (osi_dma->use_tx_usecs == OSI_ENABLE &&
 	    atomic_read(&pdata->tx_napi[chan]->tx_usecs_timer_armed) ==
 			OSI_DISABLE) {
 		atomic_set(&pdata->tx_napi[chan]->tx_usecs_timer_armed,
 			   OSI_ENABLE);
 		hrtimer_start(&pdata->tx_napi[chan]->tx_usecs_timer,
-			      osi_dma->tx_usecs * NSEC_PER_USEC,
+			      pdata->tx_napi[chan]->tx_usecs * NSEC_PER_USEC,
 			      HRTIMER_MODE_REL);
 	}
 	return NETDEV_TX_OK;
@@ -4267,6 +4456,53 @@ static int ether_setup_tc(struct net_device *ndev, enum tc_setup_type type,
 	}
 }
 
+#ifdef ETHER_XDP
+/**
+ * @brief ether_xdp_setup - Attach or detach an XDP program
+ *
+ * Algorithm: Swaps the program pointer read by the Rx path. Rx buffers
+ * always carry XDP headroom and are sized for the MTU, so neither the
+ * rings nor the page pools have to be rebuilt.
+ *
+ * @param[in] pdata: OSD private data.
+ * @param[in] prog: New XDP program, NULL to detach.
+ *
+ * @retval 0 always.
+ */
+static int ether_xdp_setup(struct ether_priv_data *pdata,
+			   struct bpf_prog *prog)
+{
+	struct bpf_prog *old_prog;
+
+	old_prog = xchg(&pdata->xdp_prog, prog);
+	if (old_prog)
+		bpf_prog_put(old_prog);
+
+	return 0;
+}
+
+/**
+ * @brief ether_bpf - ndo_bpf handler
+ *
+ * @param[in] ndev: Network device structure
+ * @param[in] bpf: BPF command
+ *
+ * @retval 0 on success
+ * @retval "negative value" on failure.
+ */
+static int ether_bpf(struct net_device *ndev, struct netdev_bpf *bpf)
+{
+	struct ether_priv_data *pdata = netdev_priv(ndev);
+
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		return ether_xdp_setup(pdata, bpf->prog);
+	default:
+		return -EINVAL;
+	}
+}
+#endif
+
 /**
  * @brief Ethernet network device operations
  */
@@ -4289,8 +4525,100 @@ static const struct net_device_ops ether_netdev_ops = {
 	.ndo_vlan_rx_kill_vid = ether_vlan_rx_kill_vid,
 #endif /* ETHER_VLAN_VID_SUPPORT */
 	.ndo_setup_tc = ether_setup_tc,
+#ifdef ETHER_XDP
+	.ndo_bpf = ether_bpf,
+#endif
 };
 
+#ifdef ETHER_DIM
+/**
+ * @brief Feed one NAPI completion to a DIM context.
+ *
+ * @param[in] dim: DIM context.
+ * @param[in] events: Completion event counter.
+ * @param[in] pkts: Packets handled so far.
+ * @param[in] bytes: Bytes handled so far.
+ */
+static void ether_dim_update(struct dim *dim, u16 events, u64 pkts,
+			     u64 bytes)
+{
+	struct dim_sample sample = {};
+
+	dim_update_sample(events, pkts, bytes, &sample);
+#if defined(NV_NET_DIM_HAS_SAMPLE_PTR_ARG) /* Linux v6.13 */
+	net_dim(dim, &sample);
+#else
+	net_dim(dim, sample);
+#endif
+}
+
+/**
+ * @brief Apply a new Rx DIM profile.
+ *
+ * Algorithm: RIWT is programmed by OSI when the DMA is initialized, so
+ * the profile is applied as a software interrupt hold-off: after a busy
+ * poll the Rx interrupt stays masked for dim_usecs and NAPI is scheduled
+ * from dim_timer instead. Periods below the HW RIWT minimum disable the
+ * hold-off.
+ *
+ * @param[in] work: Work embedded in the Rx DIM context.
+ */
+static void ether_rx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct ether_rx_napi *rx_napi = container_of(dim, struct ether_rx_napi,
+						     rx_dim);
+	struct dim_cq_moder moder;
+	unsigned int usecs;
+
+	moder = net_dim_get_rx_moderation(dim->mode, dim->profile_ix);
+	usecs = min_t(unsigned int, moder.usec, ETHER_MAX_RX_COALESCE_USEC);
+	if (usecs < ETHER_EQOS_MIN_RX_COALESCE_USEC)
+		usecs = 0U;
+
+	WRITE_ONCE(rx_napi->dim_usecs, usecs);
+	dim->state = DIM_START_MEASURE;
+}
+
+/**
+ * @brief Apply a new Tx DIM profile to the channel Tx SW timer.
+ *
+ * @param[in] work: Work embedded in the Tx DIM context.
+ */
+static void ether_tx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct ether_tx_napi *tx_napi = container_of(dim, struct ether_tx_napi,
+						     tx_dim);
+	struct dim_cq_moder moder;
+
+	moder = net_dim_get_tx_moderation(dim->mode, dim->profile_ix);
+	WRITE_ONCE(tx_napi->tx_usecs,
+		   clamp_t(unsigned int, moder.usec,
+			   ETHER_MIN_TX_COALESCE_USEC,
+			   ETHER_MAX_TX_COALESCE_USEC));
+	dim->state = DIM_START_MEASURE;
+}
+
+/**
+ * @brief Rx DIM hold-off expiry, poll the channel again.
+ *
+ * @param[in] data: Rx DIM hold-off timer.
+ *
+ * @retval HRTIMER_NORESTART
+ */
+static enum hrtimer_restart ether_rx_dim_hrtimer(struct hrtimer *data)
+{
+	struct ether_rx_napi *rx_napi = container_of(data, struct ether_rx_napi,
+						     dim_timer);
+
+	if (likely(napi_schedule_prep(&rx_napi->napi)))
+		__napi_schedule_irqoff(&rx_napi->napi);
+
+	return HRTIMER_NORESTART;
+}
+#endif
+
 /**
  * @brief NAPI poll handler for receive.
  *
@@ -4312,13 +4640,37 @@ static int ether_napi_poll_rx(struct napi_struct *napi, int budget)
 	struct osi_dma_priv_data *osi_dma = pdata->osi_dma;
 	unsigned int chan = rx_napi->chan;
 	unsigned int more_data_avail;
+#ifdef ETHER_DIM
+	unsigned int usecs;
+#endif
 	unsigned long flags;
 	int received = 0;
 
 	received = osi_process_rx_completions(osi_dma, chan, budget,
 					      &more_data_avail);
+#ifdef ETHER_XDP
+	if (rx_napi->xdp_redirect) {
+		rx_napi->xdp_redirect = false;
+		xdp_do_flush();
+	}
+#endif
 	if (received < budget) {
 		napi_complete(napi);
+#ifdef ETHER_DIM
+		if (pdata->use_rx_dim == OSI_ENABLE) {
+			rx_napi->dim_events++;
+			ether_dim_update(&rx_napi->rx_dim, rx_napi->dim_events,
+					 rx_napi->dim_pkts, rx_napi->dim_bytes);
+			/* Keep the Rx interrupt masked while traffic flows */
+			usecs = READ_ONCE(rx_napi->dim_usecs);
+			if (received > 0 && usecs != 0U) {
+				hrtimer_start(&rx_napi->dim_timer,
+					      usecs * NSEC_PER_USEC,
+					      HRTIMER_MODE_REL);
+				return received;
+			}
+		}
+#endif
 		raw_spin_lock_irqsave(&pdata->rlock, flags);
 		osi_handle_dma_intr(osi_dma, chan,
 				    OSI_DMA_CH_RX_INTR,
@@ -4354,18 +4706,35 @@ static int ether_napi_poll_tx(struct napi_struct *napi, int budget)
 
 	processed = osi_process_tx_completions(osi_dma, chan, budget);
 
+	/* Report the whole poll to BQL in one go */
+	if (tx_napi->bql_pkts != 0U) {
+		netdev_tx_completed_queue(netdev_get_tx_queue(pdata->ndev,
+							      tx_napi->qinx),
+					  tx_napi->bql_pkts,
+					  tx_napi->bql_bytes);
+		tx_napi->bql_pkts = 0U;
+		tx_napi->bql_bytes = 0U;
+	}
+
 	/* re-arm the timer if tx ring is not empty */
 	if (!osi_txring_empty(osi_dma, chan) &&
 	    osi_dma->use_tx_usecs == OSI_ENABLE &&
 	    atomic_read(&tx_napi->tx_usecs_timer_armed) == OSI_DISABLE) {
 		atomic_set(&tx_napi->tx_usecs_timer_armed, OSI_ENABLE);
 		hrtimer_start(&tx_napi->tx_usecs_timer,
-			      osi_dma->tx_usecs * NSEC_PER_USEC,
+			      tx_napi->tx_usecs * NSEC_PER_USEC,
 			      HRTIMER_MODE_REL);
 	}
 
 	if (processed < budget) {
 		napi_complete(napi);
+#ifdef ETHER_DIM
+		if (pdata->use_tx_dim == OSI_ENABLE) {
+			tx_napi->dim_events++;
+			ether_dim_update(&tx_napi->tx_dim, tx_napi->dim_events,
+					 tx_napi->dim_pkts, tx_napi->dim_bytes);
+		}
+#endif
 		raw_spin_lock_irqsave(&pdata->rlock, flags);
 		osi_handle_dma_intr(osi_dma, chan,
 				    OSI_DMA_CH_TX_INTR,
@@ -4429,6 +4798,7 @@ static int ether_alloc_napi(struct ether_priv_data *pdata)
 
 		pdata->tx_napi[chan]->pdata = pdata;
 		pdata->tx_napi[chan]->chan = chan;
+		pdata->tx_napi[chan]->qinx = i;
 #if defined(NV_NETIF_NAPI_ADD_WEIGHT_PRESENT) /* Linux v6.1 */
 		netif_napi_add_weight(ndev, &pdata->tx_napi[chan]->napi,
 			       ether_napi_poll_tx, 64);
@@ -6651,6 +7021,16 @@ static int ether_probe(struct platform_device *pdev)
 			     CLOCK_MONOTONIC, HRTIMER_MODE_REL);
 		pdata->tx_napi[chan]->tx_usecs_timer.function =
 			ether_tx_usecs_hrtimer;
+#ifdef ETHER_DIM
+		INIT_WORK(&pdata->tx_napi[chan]->tx_dim.work,
+			  ether_tx_dim_work);
+		INIT_WORK(&pdata->rx_napi[chan]->rx_dim.work,
+			  ether_rx_dim_work);
+		hrtimer_init(&pdata->rx_napi[chan]->dim_timer,
+			     CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+		pdata->rx_napi[chan]->dim_timer.function =
+			ether_rx_dim_hrtimer;
+#endif
 	}
 
 	ret = register_netdev(ndev);
@@ -6676,6 +7056,7 @@ static int ether_probe(struct platform_device *pdev)
 	}
 #endif /*  MACSEC_SUPPORT */
 
+	mutex_init(&pdata->stats_blob_lock);
 	/* Register sysfs entry */
 	ret = ether_sysfs_register(pdata);
 	if (ret < 0) {
@@ -6901,6 +7282,7 @@ static int ether_resume(struct ether_priv_data *pdata)
 		phy_start(pdata->phydev);
 	}
 	/* start network queues */
+	ether_reset_tx_queues(pdata);
 	netif_tx_start_all_queues(ndev);
 	/* re-start workqueue */
 	ether_stats_work_queue_start(pdata);
@@ -46,6 +46,19 @@
 #include <net/page_pool/helpers.h>
 #endif
 #define ETHER_PAGE_POOL
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 15, 0)
+#include <linux/bpf.h>
+#include <linux/bpf_trace.h>
+#include <linux/filter.h>
+#include <net/xdp.h>
+#define ETHER_XDP
+/* Rx payload stays in page pool fragments, see ether_build_rx_skb() */
+#define ETHER_RX_PP_FRAGS
+#endif
+#endif
+#if IS_ENABLED(CONFIG_DIMLIB)
+#include <linux/dim.h>
+#define ETHER_DIM
 #endif
 #include <osi_core.h>
 #include <osi_dma.h>
@@ -73,6 +86,22 @@
 #define MULTIPLIER_32			32
 #define MULTIPLIER_8			8
 #define MULTIPLIER_4			4
+/**
+ * @brief Headroom reserved in front of each page pool Rx buffer so that an
+ * XDP program can grow the packet head without a copy.
+ */
+#ifdef ETHER_XDP
+#define ETHER_RX_HEADROOM		XDP_PACKET_HEADROOM
+#else
+#define ETHER_RX_HEADROOM		0U
+#endif
+
+/**
+ * @brief Rx packets up to this length are copied into a linear skb, larger
+ * ones only get their headers copied and keep the payload in the page.
+ */
+#define ETHER_RX_COPYBREAK		256U
+
 /**
  * @brief Max number of Ethernet IRQs supported in HW
  */
@@ -303,6 +332,12 @@ static inline int ether_avail_txdesc_cnt(struct osi_dma_priv_data *osi_dma,
  */
 #define ETHER_STATS_TIMER		3000U
 
+/**
+ * @brief Maximum age in msec of the stats snapshot read from the ethernet
+ * server before a stats reader refreshes it over IVC.
+ */
+#define ETHER_IVC_STATS_MAX_AGE		1000U
+
 /**
  * @brief Timer to trigger Work queue periodically which read TX timestamp
  * for PTP packets. Timer is in milisecond.
@@ -329,6 +364,24 @@ struct ether_tx_napi {
 	struct hrtimer tx_usecs_timer;
 	/** SW timer flag associated with transmit channel */
 	atomic_t tx_usecs_timer_armed;
+	/** Netdev Tx queue index served by this channel */
+	unsigned int qinx;
+	/** SW timer period in usec used by this channel */
+	unsigned int tx_usecs;
+#ifdef ETHER_DIM
+	/** Tx DIM context, adapts tx_usecs */
+	struct dim tx_dim;
+	/** Tx NAPI completions, DIM event counter */
+	u16 dim_events;
+	/** Packets completed, fed to DIM */
+	u64 dim_pkts;
+	/** Bytes completed, fed to DIM */
+	u64 dim_bytes;
+#endif
+	/** Packets completed in the current poll, reported to BQL */
+	unsigned int bql_pkts;
+	/** Bytes completed in the current poll, reported to BQL */
+	unsigned int bql_bytes;
 };
 
 /**
@@ -341,6 +394,24 @@ struct ether_rx_napi {
 	struct ether_priv_data *pdata;
 	/** NAPI instance associated with transmit channel */
 	struct napi_struct napi;
+#ifdef ETHER_XDP
+	/** Set when XDP_REDIRECT was issued in the current poll */
+	bool xdp_redirect;
+#endif
+#ifdef ETHER_DIM
+	/** Rx DIM context, adapts dim_usecs */
+	struct dim rx_dim;
+	/** Rx NAPI completions, DIM event counter */
+	u16 dim_events;
+	/** Packets received, fed to DIM */
+	u64 dim_pkts;
+	/** Bytes received, fed to DIM */
+	u64 dim_bytes;
+	/** Rx interrupt hold-off in usec chosen by DIM */
+	unsigned int dim_usecs;
+	/** Timer re-enabling the Rx interrupt after the hold-off */
+	struct hrtimer dim_timer;
+#endif
 };
 
 /**
@@ -363,6 +434,12 @@ struct ether_ivc_ctxt {
 	raw_spinlock_t ivck_lock;
 	/** Flag to indicate ivc started or stopped */
 	unsigned int ivc_state;
+	/** Serializes stats refreshes from the ethernet server */
+	struct mutex stats_lock;
+	/** Flag to indicate the stats snapshot below is valid */
+	bool stats_valid;
+	/** jiffies after which the stats snapshot is stale */
+	unsigned long stats_expires;
 };
 
 /**
@@ -417,12 +494,61 @@ struct ether_xtra_stat_counters {
 	nveu64_t tx_usecs_swtimer_n[OSI_MGBE_MAX_NUM_QUEUES];
 	/** RX per channel interrupt count */
 	nveu64_t rx_normal_irq_n[OSI_MGBE_MAX_NUM_QUEUES];
+	/** TX completed bytes per queue, i.e. per TSN traffic class */
+	nveu64_t q_tx_bytes[OSI_MGBE_MAX_NUM_QUEUES];
 	/** link connect count */
 	nveu64_t link_connect_count;
 	/** link disconnect count */
 	nveu64_t link_disconnect_count;
+#ifdef ETHER_XDP
+	/** Packets dropped by XDP (XDP_DROP/XDP_ABORTED/failed actions) */
+	nveu64_t rx_xdp_drop;
+	/** Packets sent back out by XDP_TX */
+	nveu64_t rx_xdp_tx;
+	/** Packets redirected by XDP_REDIRECT */
+	nveu64_t rx_xdp_redirect;
+#endif
+};
+
+#ifndef OSI_STRIPPED_LIB
+/**
+ * @brief Stats blob magic ("NVES") and layout version
+ */
+#define ETHER_STATS_BLOB_MAGIC		0x4E564553U
+#define ETHER_STATS_BLOB_VERSION	1U
+
+/**
+ * @brief Header of the binary stats snapshot exported through sysfs.
+ *
+ * The header is followed by num_stats u64 counters, in the same order as
+ * the names reported by ethtool --statistics for the interface.
+ */
+struct ether_stats_blob_hdr {
+	/** ETHER_STATS_BLOB_MAGIC */
+	u32 magic;
+	/** ETHER_STATS_BLOB_VERSION */
+	u16 version;
+	/** Size of this header in bytes */
+	u16 hdr_len;
+	/** Number of u64 counters following the header */
+	u32 num_stats;
+	/** Reserved, always zero */
+	u32 reserved;
+	/** CLOCK_MONOTONIC time of the snapshot in ns */
+	u64 timestamp_ns;
 };
 
+/**
+ * @brief ethtool ntuple rule programmed into an L3/L4 filter
+ */
+struct ether_ntuple_rule {
+	/** Rule as passed by ethtool */
+	struct ethtool_rx_flow_spec fs;
+	/** Rule is programmed in HW */
+	bool active;
+};
+#endif /* !OSI_STRIPPED_LIB */
+
 /**
  * @brief Ethernet driver private data
  */
@@ -578,6 +704,18 @@ struct ether_priv_data {
 	/** Pointer to page pool */
 	struct page_pool *page_pool[OSI_MGBE_MAX_NUM_CHANS];
 #endif
+#ifdef ETHER_DIM
+	/** Adaptive Rx interrupt moderation enabled */
+	unsigned int use_rx_dim;
+	/** Adaptive Tx completion moderation enabled */
+	unsigned int use_tx_dim;
+#endif
+#ifdef ETHER_XDP
+	/** Attached XDP program, NULL when XDP is disabled */
+	struct bpf_prog *xdp_prog;
+	/** XDP Rx queue info per DMA channel */
+	struct xdp_rxq_info xdp_rxq[OSI_MGBE_MAX_NUM_CHANS];
+#endif
 #ifdef CONFIG_DEBUG_FS
 	/** Debug fs directory pointer */
 	struct dentry *dbgfs_dir;
@@ -668,6 +806,16 @@ struct ether_priv_data {
 	struct tasklet_struct lane_restart_task;
 	/** xtra sw error counters */
 	struct ether_xtra_stat_counters xstats;
+#ifndef OSI_STRIPPED_LIB
+	/** ethtool ntuple rules, indexed by L3/L4 filter number */
+	struct ether_ntuple_rule *ntuple_rules;
+#endif /* !OSI_STRIPPED_LIB */
+	/** Last stats snapshot served through the stats_blob sysfs node */
+	void *stats_blob;
+	/** Length of stats_blob in bytes */
+	size_t stats_blob_len;
+	/** Serialize stats_blob snapshot and read */
+	struct mutex stats_blob_lock;
 };
 
 /**
@@ -756,6 +904,37 @@ int ether_conf_eee(struct ether_priv_data *pdata, unsigned int tx_lpi_enable);
  */
 int ether_padctrl_mii_rx_pins(void *priv, unsigned int enable);
 
+/**
+ * @brief Get the number of counters reported by ethtool --statistics
+ *
+ * @param[in] pdata: Ethernet driver private data
+ *
+ * @return Number of u64 counters
+ */
+int ether_get_stats_count(struct ether_priv_data *pdata);
+
+/**
+ * @brief Read HW counters and fill all ethtool statistics in one pass
+ *
+ * @param[in] pdata: Ethernet driver private data
+ * @param[out] data: Array of ether_get_stats_count() u64 entries
+ *
+ * @retval 0 on success
+ * @retval negative value on failure.
+ */
+int ether_snapshot_stats(struct ether_priv_data *pdata, u64 *data);
+
+/**
+ * @brief Refresh MMC and core stats from the ethernet server
+ *
+ * @param[in] pdata: Ethernet driver private data
+ * @param[in] force: Refresh even if the last snapshot is still fresh
+ *
+ * @retval 0 on success
+ * @retval negative value on failure.
+ */
+int ether_ivc_read_stats(struct ether_priv_data *pdata, bool force);
+
 #ifndef OSI_STRIPPED_LIB
 void ether_selftest_run(struct net_device *dev,
 			struct ethtool_test *etest, u64 *buf);
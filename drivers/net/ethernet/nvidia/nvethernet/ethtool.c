@@ -196,8 +196,25 @@ static const struct ether_stats ether_gstrings_stats[] = {
 	ETHER_EXTRA_STAT(rx_normal_irq_n[7]),
 	ETHER_EXTRA_STAT(rx_normal_irq_n[8]),
 	ETHER_EXTRA_STAT(rx_normal_irq_n[9]),
+
+	/* Tx bytes per queue */
+	ETHER_EXTRA_STAT(q_tx_bytes[0]),
+	ETHER_EXTRA_STAT(q_tx_bytes[1]),
+	ETHER_EXTRA_STAT(q_tx_bytes[2]),
+	ETHER_EXTRA_STAT(q_tx_bytes[3]),
+	ETHER_EXTRA_STAT(q_tx_bytes[4]),
+	ETHER_EXTRA_STAT(q_tx_bytes[5]),
+	ETHER_EXTRA_STAT(q_tx_bytes[6]),
+	ETHER_EXTRA_STAT(q_tx_bytes[7]),
+	ETHER_EXTRA_STAT(q_tx_bytes[8]),
+	ETHER_EXTRA_STAT(q_tx_bytes[9]),
 	ETHER_EXTRA_STAT(link_disconnect_count),
 	ETHER_EXTRA_STAT(link_connect_count),
+#ifdef ETHER_XDP
+	ETHER_EXTRA_STAT(rx_xdp_drop),
+	ETHER_EXTRA_STAT(rx_xdp_tx),
+	ETHER_EXTRA_STAT(rx_xdp_redirect),
+#endif
 };
 
 /**
@@ -503,6 +520,31 @@ static void ether_get_ethtool_stats(struct net_device *dev,
 				    u64 *data)
 {
 	struct ether_priv_data *pdata = netdev_priv(dev);
+
+	if (!netif_running(dev)) {
+		netdev_err(pdata->ndev, "%s: iface not up\n", __func__);
+		return;
+	}
+
+	ether_snapshot_stats(pdata, data);
+}
+
+/**
+ * @brief Read HW counters and fill all ethtool statistics in one pass
+ *
+ * Algorithm: Refresh MMC (and with virtualization the core) counters once
+ * and copy every counter, in ethtool string order, into data. With
+ * virtualization a snapshot younger than ETHER_IVC_STATS_MAX_AGE is reused
+ * instead of reading the ethernet server again.
+ *
+ * @param[in] pdata: OSD private data.
+ * @param[out] data: Array of ether_get_stats_count() u64 entries.
+ *
+ * @retval 0 on success
+ * @retval negative value on failure.
+ */
+int ether_snapshot_stats(struct ether_priv_data *pdata, u64 *data)
+{
 	struct osi_core_priv_data *osi_core = pdata->osi_core;
 #ifndef OSI_STRIPPED_LIB
 	struct osi_dma_priv_data *osi_dma = pdata->osi_dma;
@@ -511,26 +553,17 @@ static void ether_get_ethtool_stats(struct net_device *dev,
 	int i, j = 0;
 	int ret;
 
-	if (!netif_running(dev)) {
-		netdev_err(pdata->ndev, "%s: iface not up\n", __func__);
-		return;
-	}
-
 	if (pdata->hw_feat.mmc_sel == 1U) {
-		ioctl_data.cmd = OSI_CMD_READ_MMC;
-		ret = osi_handle_ioctl(osi_core, &ioctl_data);
-		if (ret == -1) {
-			dev_err(pdata->dev, "Error in reading MMC counter\n");
-			return;
-		}
-
 		if (osi_core->use_virtualization == OSI_ENABLE) {
-			ioctl_data.cmd = OSI_CMD_READ_STATS;
+			if (ether_ivc_read_stats(pdata, false) < 0)
+				return -EIO;
+		} else {
+			ioctl_data.cmd = OSI_CMD_READ_MMC;
 			ret = osi_handle_ioctl(osi_core, &ioctl_data);
 			if (ret == -1) {
 				dev_err(pdata->dev,
-					"Fail to read core stats\n");
-				return;
+					"Error in reading MMC counter\n");
+				return -EIO;
 			}
 		}
 
@@ -585,6 +618,8 @@ static void ether_get_ethtool_stats(struct net_device *dev,
 				     sizeof(u64)) ? (*(u64 *)p) : (*(u32 *)p);
 		}
 	}
+
+	return 0;
 }
 
 /**
@@ -650,6 +685,11 @@ static int ether_get_sset_count(struct net_device *dev, int sset)
 	return len;
 }
 
+int ether_get_stats_count(struct ether_priv_data *pdata)
+{
+	return ether_get_sset_count(pdata->ndev, ETH_SS_STATS);
+}
+
 /**	
  * @brief This function returns a set of strings that describe
  * the requested objects.
@@ -932,7 +972,9 @@ static int ether_set_coalesce(struct net_device *dev,
 	/* Check for not supported parameters  */
 	if ((ec->rx_coalesce_usecs_irq) ||
 	    (ec->rx_max_coalesced_frames_irq) || (ec->tx_coalesce_usecs_irq) ||
+#ifndef ETHER_DIM
 	    (ec->use_adaptive_rx_coalesce) || (ec->use_adaptive_tx_coalesce) ||
+#endif
 	    (ec->pkt_rate_low) || (ec->rx_coalesce_usecs_low) ||
 	    (ec->rx_max_coalesced_frames_low) || (ec->tx_coalesce_usecs_high) ||
 	    (ec->tx_max_coalesced_frames_low) || (ec->pkt_rate_high) ||
@@ -1027,6 +1069,22 @@ static int ether_set_coalesce(struct net_device *dev,
 			   " along with rx-usecs\n");
 		return -EINVAL;
 	}
+#ifdef ETHER_DIM
+	/* Tx DIM adapts the tx-usecs SW timer, it needs it running */
+	if (ec->use_adaptive_tx_coalesce &&
+	    osi_dma->use_tx_usecs == OSI_DISABLE) {
+		netdev_err(dev, "invalid settings : adaptive-tx must be enabled"
+			   " along with tx-usecs\n");
+		return -EINVAL;
+	}
+	pdata->use_rx_dim = ec->use_adaptive_rx_coalesce ? OSI_ENABLE :
+			    OSI_DISABLE;
+	pdata->use_tx_dim = ec->use_adaptive_tx_coalesce ? OSI_ENABLE :
+			    OSI_DISABLE;
+	netdev_err(dev, "ADAPTIVE RX/TX COALESCING is %s/%s\n",
+		   pdata->use_rx_dim ? "ENABLED" : "DISABLED",
+		   pdata->use_tx_dim ? "ENABLED" : "DISABLED");
+#endif
 	netdev_err(dev, "RX COALESCING USECS is %s\n", osi_dma->use_riwt ?
 		   "ENABLED" : "DISABLED");
 
@@ -1073,6 +1131,10 @@ static int ether_get_coalesce(struct net_device *dev,
 	ec->rx_max_coalesced_frames = osi_dma->rx_frames;
 	ec->tx_coalesce_usecs = osi_dma->tx_usecs;
 	ec->tx_max_coalesced_frames = osi_dma->tx_frames;
+#ifdef ETHER_DIM
+	ec->use_adaptive_rx_coalesce = pdata->use_rx_dim;
+	ec->use_adaptive_tx_coalesce = pdata->use_tx_dim;
+#endif
 
 	return 0;
 }
@@ -1378,14 +1440,183 @@ static void ether_get_wol(struct net_device *ndev, struct ethtool_wolinfo *wol)
 	phy_ethtool_get_wol(pdata->phydev, wol);
 }
 
+/**
+ * @brief Check that an ethtool ntuple rule fits the L3/L4 filter HW.
+ *
+ * Algorithm: Only IPv4 TCP/UDP rules with exact (all ones) or no (zero)
+ * match on addresses and ports, steering to one of the enabled DMA
+ * channels, can be expressed by an L3/L4 filter.
+ *
+ * param[in] pdata: OSD private data.
+ * param[in] fs: ethtool flow spec.
+ *
+ * @retval 0 on success
+ * @retval negative on failure
+ */
+static int ether_ntuple_validate(struct ether_priv_data *pdata,
+				 struct ethtool_rx_flow_spec *fs)
+{
+	struct osi_dma_priv_data *osi_dma = pdata->osi_dma;
+	struct ethtool_tcpip4_spec *m = &fs->m_u.tcp_ip4_spec;
+	unsigned int i;
+
+	if (fs->location >= pdata->hw_feat.l3l4_filter_num)
+		return -EINVAL;
+
+	if (fs->flow_type != TCP_V4_FLOW && fs->flow_type != UDP_V4_FLOW)
+		return -EOPNOTSUPP;
+
+	if (m->tos ||
+	    (m->ip4src && m->ip4src != htonl(0xFFFFFFFFU)) ||
+	    (m->ip4dst && m->ip4dst != htonl(0xFFFFFFFFU)) ||
+	    (m->psrc && m->psrc != htons(0xFFFFU)) ||
+	    (m->pdst && m->pdst != htons(0xFFFFU)))
+		return -EOPNOTSUPP;
+
+	if (fs->ring_cookie == RX_CLS_FLOW_DISC)
+		return -EOPNOTSUPP;
+
+	for (i = 0; i < osi_dma->num_dma_chans; i++) {
+		if (osi_dma->dma_chans[i] == fs->ring_cookie)
+			return 0;
+	}
+
+	return -EINVAL;
+}
+
+/**
+ * @brief Program or clear an L3/L4 filter from an ethtool ntuple rule.
+ *
+ * param[in] pdata: OSD private data.
+ * param[in] fs: ethtool flow spec, location is the filter number.
+ * param[in] enable: OSI_ENABLE to program, OSI_DISABLE to clear.
+ *
+ * @retval 0 on success
+ * @retval negative on failure
+ */
+static int ether_ntuple_program(struct ether_priv_data *pdata,
+				struct ethtool_rx_flow_spec *fs,
+				unsigned int enable)
+{
+	struct ethtool_tcpip4_spec *h = &fs->h_u.tcp_ip4_spec;
+	struct ethtool_tcpip4_spec *m = &fs->m_u.tcp_ip4_spec;
+	struct osi_ioctl ioctl_data = {};
+	struct osi_l3_l4_filter *f = &ioctl_data.l3l4_filter;
+
+	f->filter_no = fs->location;
+	f->filter_enb_dis = enable;
+	f->dma_routing_enable = OSI_ENABLE;
+	f->dma_chan = (unsigned int)fs->ring_cookie;
+	f->data.is_udp = (fs->flow_type == UDP_V4_FLOW) ? OSI_ENABLE :
+			  OSI_DISABLE;
+	f->data.is_ipv6 = OSI_DISABLE;
+
+	if (m->ip4src) {
+		memcpy(f->data.src.ip4_addr, &h->ip4src, sizeof(h->ip4src));
+		f->data.src.addr_match = OSI_ENABLE;
+	}
+
+	if (m->ip4dst) {
+		memcpy(f->data.dst.ip4_addr, &h->ip4dst, sizeof(h->ip4dst));
+		f->data.dst.addr_match = OSI_ENABLE;
+	}
+
+	if (m->psrc) {
+		f->data.src.port_no = ntohs(h->psrc);
+		f->data.src.port_match = OSI_ENABLE;
+	}
+
+	if (m->pdst) {
+		f->data.dst.port_no = ntohs(h->pdst);
+		f->data.dst.port_match = OSI_ENABLE;
+	}
+
+	ioctl_data.cmd = OSI_CMD_L3L4_FILTER;
+	return osi_handle_ioctl(pdata->osi_core, &ioctl_data);
+}
+
+/**
+ * @brief Add an ethtool ntuple rule steering a flow to a DMA channel.
+ *
+ * param[in] pdata: OSD private data.
+ * param[in] fs: ethtool flow spec.
+ *
+ * @retval 0 on success
+ * @retval negative on failure
+ */
+static int ether_add_ntuple_rule(struct ether_priv_data *pdata,
+				 struct ethtool_rx_flow_spec *fs)
+{
+	struct ether_ntuple_rule *rule;
+	int ret;
+
+	ret = ether_ntuple_validate(pdata, fs);
+	if (ret < 0)
+		return ret;
+
+	if (!pdata->ntuple_rules) {
+		pdata->ntuple_rules = devm_kcalloc(pdata->dev,
+					pdata->hw_feat.l3l4_filter_num,
+					sizeof(struct ether_ntuple_rule),
+					GFP_KERNEL);
+		if (!pdata->ntuple_rules)
+			return -ENOMEM;
+	}
+
+	rule = &pdata->ntuple_rules[fs->location];
+	if (rule->active)
+		return -EBUSY;
+
+	ret = ether_ntuple_program(pdata, fs, OSI_ENABLE);
+	if (ret < 0)
+		return ret;
+
+	rule->fs = *fs;
+	rule->active = true;
+
+	return 0;
+}
+
+/**
+ * @brief Delete an ethtool ntuple rule.
+ *
+ * param[in] pdata: OSD private data.
+ * param[in] location: Rule location, i.e. L3/L4 filter number.
+ *
+ * @retval 0 on success
+ * @retval negative on failure
+ */
+static int ether_del_ntuple_rule(struct ether_priv_data *pdata, u32 location)
+{
+	struct ether_ntuple_rule *rule;
+	int ret;
+
+	if (!pdata->ntuple_rules ||
+	    location >= pdata->hw_feat.l3l4_filter_num)
+		return -EINVAL;
+
+	rule = &pdata->ntuple_rules[location];
+	if (!rule->active)
+		return -ENOENT;
+
+	ret = ether_ntuple_program(pdata, &rule->fs, OSI_DISABLE);
+	if (ret < 0)
+		return ret;
+
+	rule->active = false;
+
+	return 0;
+}
+
 /**
  * @brief Get RX flow classification rules
  *
- * Algorithm: Returns RX flow classification rules.
+ * Algorithm: Returns number of RX rings and the ethtool ntuple rules
+ * programmed into the L3/L4 filters.
  *
  * param[in] ndev: Pointer to net device structure.
  * param[in] rxnfc: Pointer to rxflow data
- * param[in] rule_locs: TBD
+ * param[in] rule_locs: Rule locations for ETHTOOL_GRXCLSRLALL
  *
  * @note MAC and PHY need to be initialized.
  *
@@ -1398,11 +1629,38 @@ static int ether_get_rxnfc(struct net_device *ndev,
 {
 	struct ether_priv_data *pdata = netdev_priv(ndev);
 	struct osi_core_priv_data *osi_core = pdata->osi_core;
+	struct ether_ntuple_rule *rules = pdata->ntuple_rules;
+	unsigned int i, cnt = 0;
 
 	switch (rxnfc->cmd) {
 	case ETHTOOL_GRXRINGS:
 		rxnfc->data = osi_core->num_mtl_queues;
 		break;
+	case ETHTOOL_GRXCLSRLCNT:
+		for (i = 0; rules && i < pdata->hw_feat.l3l4_filter_num; i++)
+			cnt += rules[i].active ? 1U : 0U;
+		rxnfc->rule_cnt = cnt;
+		rxnfc->data = pdata->hw_feat.l3l4_filter_num |
+			      RX_CLS_LOC_SPECIAL;
+		break;
+	case ETHTOOL_GRXCLSRULE:
+		if (!rules ||
+		    rxnfc->fs.location >= pdata->hw_feat.l3l4_filter_num ||
+		    !rules[rxnfc->fs.location].active)
+			return -ENOENT;
+		rxnfc->fs = rules[rxnfc->fs.location].fs;
+		break;
+	case ETHTOOL_GRXCLSRLALL:
+		for (i = 0; rules && i < pdata->hw_feat.l3l4_filter_num; i++) {
+			if (!rules[i].active)
+				continue;
+			if (cnt == rxnfc->rule_cnt)
+				return -EMSGSIZE;
+			rule_locs[cnt++] = i;
+		}
+		rxnfc->rule_cnt = cnt;
+		rxnfc->data = pdata->hw_feat.l3l4_filter_num;
+		break;
 	default:
 		return -EOPNOTSUPP;
 	}
@@ -1410,6 +1668,44 @@ static int ether_get_rxnfc(struct net_device *ndev,
 	return 0;
 }
 
+/**
+ * @brief Set RX flow classification rules
+ *
+ * Algorithm: Adds or deletes an ethtool ntuple rule, which is programmed
+ * into the L3/L4 filter at the rule location with DMA channel routing
+ * to the requested ring.
+ *
+ * param[in] ndev: Pointer to net device structure.
+ * param[in] rxnfc: Pointer to rxflow data
+ *
+ * @note MAC and PHY need to be initialized.
+ *
+ * @retval 0 on success
+ * @retval negative on failure
+ */
+static int ether_set_rxnfc(struct net_device *ndev,
+			   struct ethtool_rxnfc *rxnfc)
+{
+	struct ether_priv_data *pdata = netdev_priv(ndev);
+
+	if (!netif_running(ndev)) {
+		netdev_err(pdata->ndev, "interface must be up\n");
+		return -ENODEV;
+	}
+
+	if (pdata->hw_feat.l3l4_filter_num == OSI_DISABLE)
+		return -EOPNOTSUPP;
+
+	switch (rxnfc->cmd) {
+	case ETHTOOL_SRXCLSRLINS:
+		return ether_add_ntuple_rule(pdata, &rxnfc->fs);
+	case ETHTOOL_SRXCLSRLDEL:
+		return ether_del_ntuple_rule(pdata, rxnfc->fs.location);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
 /**
  * @brief Get the size of the RX flow hash key
  *
@@ -1628,14 +1924,21 @@ static const struct ethtool_ops ether_ethtool_ops = {
 	.get_ethtool_stats = ether_get_ethtool_stats,
 	.get_sset_count = ether_get_sset_count,
 	.get_coalesce = ether_get_coalesce,
+#ifdef ETHER_DIM
+	.supported_coalesce_params = (ETHTOOL_COALESCE_USECS |
+		ETHTOOL_COALESCE_MAX_FRAMES |
+		ETHTOOL_COALESCE_USE_ADAPTIVE),
+#else
 	.supported_coalesce_params = (ETHTOOL_COALESCE_USECS |
 		ETHTOOL_COALESCE_MAX_FRAMES),
+#endif
 	.set_coalesce = ether_set_coalesce,
 #ifndef OSI_STRIPPED_LIB
 	.get_wol = ether_get_wol,
 	.set_wol = ether_set_wol,
 	.self_test = ether_selftest_run,
 	.get_rxnfc = ether_get_rxnfc,
+	.set_rxnfc = ether_set_rxnfc,
 	.get_pauseparam = ether_get_pauseparam,
 	.set_pauseparam = ether_set_pauseparam,
 	.get_eee = ether_get_eee,
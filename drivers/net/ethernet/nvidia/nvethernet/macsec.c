@@ -16,6 +16,9 @@ static int macsec_tz_kt_config(struct ether_priv_data *pdata,
 			unsigned char cmd,
 			struct osi_macsec_kt_config *const kt_config,
 			struct genl_info *const info, struct nvpkcs_data *pkcs);
+static int macsec_tz_kt_config_bulk(struct ether_priv_data *pdata,
+				    struct macsec_bulk_sa *const sa_list,
+				    int num, struct genl_info *const info);
 #endif
 
 static irqreturn_t macsec_s_isr(int irq, void *data)
@@ -475,15 +478,11 @@ exit:
 	return ret;
 }
 
-static int parse_sa_config(struct nlattr **attrs, struct nlattr **tb_sa,
-			   struct osi_macsec_sc_info *sc_info,
-			   struct nvpkcs_data *pkcs)
+static int parse_sa_nest(struct nlattr *nest, struct nlattr **tb_sa,
+			 struct osi_macsec_sc_info *sc_info,
+			 struct nvpkcs_data *pkcs)
 {
-	if (!attrs[NV_MACSEC_ATTR_SA_CONFIG])
-		return -EINVAL;
-
-	if (nla_parse_nested(tb_sa, NV_MACSEC_SA_ATTR_MAX,
-			     attrs[NV_MACSEC_ATTR_SA_CONFIG],
+	if (nla_parse_nested(tb_sa, NV_MACSEC_SA_ATTR_MAX, nest,
 			     nv_macsec_sa_genl_policy, NULL))
 		return -EINVAL;
 
@@ -520,6 +519,68 @@ static int parse_sa_config(struct nlattr **attrs, struct nlattr **tb_sa,
 	return 0;
 }
 
+static int parse_sa_config(struct nlattr **attrs, struct nlattr **tb_sa,
+			   struct osi_macsec_sc_info *sc_info,
+			   struct nvpkcs_data *pkcs)
+{
+	if (!attrs[NV_MACSEC_ATTR_SA_CONFIG])
+		return -EINVAL;
+
+	return parse_sa_nest(attrs[NV_MACSEC_ATTR_SA_CONFIG], tb_sa, sc_info,
+			     pkcs);
+}
+
+/**
+ * @brief parse_sa_list - Parse the nested SA list of a bulk request.
+ *
+ * Every entry of NV_MACSEC_ATTR_SA_LIST is an NV_MACSEC_ATTR_SA_CONFIG
+ * nest which additionally carries NV_MACSEC_SA_ATTR_CTLR.
+ *
+ * @param[in] macsec_pdata: MACsec private data structure.
+ * @param[in] attrs: Netlink attributes of the request.
+ * @param[out] sa_list: Array of NV_MACSEC_MAX_BULK_SA entries to fill.
+ *
+ * @retval number of entries parsed on success
+ * @retval negative value on failure.
+ */
+static int parse_sa_list(struct macsec_priv_data *macsec_pdata,
+			 struct nlattr **attrs,
+			 struct macsec_bulk_sa *sa_list)
+{
+	struct nlattr *tb_sa[NUM_NV_MACSEC_SA_ATTR];
+	struct nlattr *nla;
+	int num = 0;
+	int rem;
+
+	if (!attrs[NV_MACSEC_ATTR_SA_LIST])
+		return -EINVAL;
+
+	nla_for_each_nested(nla, attrs[NV_MACSEC_ATTR_SA_LIST], rem) {
+		if (nla_type(nla) != NV_MACSEC_ATTR_SA_CONFIG)
+			return -EINVAL;
+
+		if (num >= NV_MACSEC_MAX_BULK_SA)
+			return -E2BIG;
+
+		if (parse_sa_nest(nla, tb_sa, &sa_list[num].sa,
+				  &sa_list[num].pkcs))
+			return -EINVAL;
+
+		if (!tb_sa[NV_MACSEC_SA_ATTR_CTLR])
+			return -EINVAL;
+
+		sa_list[num].ctlr = nla_get_u8(tb_sa[NV_MACSEC_SA_ATTR_CTLR]);
+		if (sa_list[num].ctlr != OSI_CTLR_SEL_TX &&
+		    sa_list[num].ctlr != OSI_CTLR_SEL_RX)
+			return -EINVAL;
+
+		sa_list[num].sa.pn_window = macsec_pdata->pn_window;
+		num++;
+	}
+
+	return (num > 0) ? num : -EINVAL;
+}
+
 static int macsec_dis_rx_sa(struct sk_buff *skb, struct genl_info *info)
 {
 	struct nlattr **attrs = info->attrs;
@@ -1015,6 +1076,221 @@ exit:
 	return ret;
 }
 
+/**
+ * @brief macsec_create_sa_bulk - Install the keys of several SAs at once.
+ *
+ * Algorithm: All SAs in the list are created with a single hold of the
+ * MACsec lock. When the keys are programmed through TZ, one reply
+ * carrying every key table entry is sent back instead of a reply per SA.
+ * If any SA fails, the SAs already created by this request are removed
+ * again so the caller sees all or nothing. The currently active SAs are
+ * not touched and keep protecting traffic until NV_MACSEC_CMD_EN_SA_BULK
+ * switches over to the new ones.
+ *
+ * @param[in] skb: Netlink request buffer.
+ * @param[in] info: Pointer to netlink msg structure
+ *
+ * @retval 0 on success
+ * @retval negative value on failure.
+ */
+static int macsec_create_sa_bulk(struct sk_buff *skb, struct genl_info *info)
+{
+	struct nlattr **attrs = info->attrs;
+	struct macsec_priv_data *macsec_pdata;
+	struct ether_priv_data *pdata;
+	struct macsec_bulk_sa *sa_list = NULL;
+	struct osi_macsec_sc_info del_sa;
+	unsigned short kt_idx;
+	struct device *dev = NULL;
+	int num, i;
+	int ret = 0;
+
+	PRINT_ENTRY();
+	if (!attrs[NV_MACSEC_ATTR_IFNAME]) {
+		ret = -EINVAL;
+		goto exit;
+	}
+
+	macsec_pdata = genl_to_macsec_pdata(info);
+	if (macsec_pdata) {
+		pdata = macsec_pdata->ether_pdata;
+	} else {
+		ret = -EPROTO;
+		goto exit;
+	}
+	dev = pdata->dev;
+
+	if (!netif_running(pdata->ndev)) {
+		ret = -ENETDOWN;
+		dev_err(dev, "%s: MAC interface down!!\n", __func__);
+		goto exit;
+	}
+
+	sa_list = kcalloc(NV_MACSEC_MAX_BULK_SA, sizeof(*sa_list), GFP_KERNEL);
+	if (!sa_list) {
+		ret = -ENOMEM;
+		goto exit;
+	}
+
+	num = parse_sa_list(macsec_pdata, attrs, sa_list);
+	if (num < 0) {
+		dev_err(dev, "%s: failed to parse nlattrs", __func__);
+		ret = num;
+		goto exit;
+	}
+
+	mutex_lock(&macsec_pdata->lock);
+	for (i = 0; i < num; i++) {
+#ifdef MACSEC_KEY_PROGRAM
+		sa_list[i].sa.flags = OSI_CREATE_SA;
+		ret = hkey_generation(sa_list[i].sa.sak, sa_list[i].sa.hkey);
+		if (ret != 0) {
+			dev_err(dev, "%s: failed to Generate HKey", __func__);
+			ret = -EINVAL;
+			break;
+		}
+#endif /* MACSEC_KEY_PROGRAM */
+		ret = osi_macsec_config(pdata->osi_core, &sa_list[i].sa,
+					OSI_ENABLE, sa_list[i].ctlr,
+					&sa_list[i].kt_idx);
+		if (ret < 0) {
+			dev_err(dev, "%s: failed to create %s SA %d\n",
+				__func__, (sa_list[i].ctlr == OSI_CTLR_SEL_TX) ?
+				"Tx" : "Rx", i);
+			break;
+		}
+	}
+
+	if (ret < 0) {
+		/* Remove what this request created, older SAs stay intact */
+		while (--i >= 0) {
+			del_sa = sa_list[i].sa;
+			del_sa.flags = 0;
+			if (osi_macsec_config(pdata->osi_core, &del_sa,
+					      OSI_DISABLE, sa_list[i].ctlr,
+					      &kt_idx) < 0)
+				dev_err(dev, "%s: failed to remove SA %d\n",
+					__func__, i);
+		}
+		mutex_unlock(&macsec_pdata->lock);
+		goto exit;
+	}
+	mutex_unlock(&macsec_pdata->lock);
+
+#ifndef MACSEC_KEY_PROGRAM
+	ret = macsec_tz_kt_config_bulk(pdata, sa_list, num, info);
+	if (ret < 0) {
+		dev_err(dev, "%s: failed to program SAKs through TZ %d",
+			__func__, ret);
+		goto exit;
+	}
+#endif /* !MACSEC_KEY_PROGRAM */
+	dev_info(dev, "%s: created %d SAs\n", __func__, num);
+
+exit:
+	kfree(sa_list);
+	PRINT_EXIT();
+	return ret;
+}
+
+/**
+ * @brief macsec_en_sa_bulk - Enable several previously created SAs at once.
+ *
+ * Algorithm: With a single hold of the MACsec lock, all Rx SAs in the list
+ * are enabled first and the Tx SAs after them. This way the new keys are
+ * accepted on receive before this end starts sending with them, which
+ * avoids dropping frames while the SAKs of many secure channels rotate.
+ *
+ * @param[in] skb: Netlink request buffer.
+ * @param[in] info: Pointer to netlink msg structure
+ *
+ * @retval 0 on success
+ * @retval negative value on failure.
+ */
+static int macsec_en_sa_bulk(struct sk_buff *skb, struct genl_info *info)
+{
+	static const unsigned short ctlr_order[] = {
+		OSI_CTLR_SEL_RX, OSI_CTLR_SEL_TX
+	};
+	struct nlattr **attrs = info->attrs;
+	struct macsec_priv_data *macsec_pdata;
+	struct ether_priv_data *pdata;
+	struct macsec_bulk_sa *sa_list = NULL;
+	struct device *dev = NULL;
+	unsigned int an_bit;
+	int num, i, j;
+	int ret = 0;
+
+	PRINT_ENTRY();
+	if (!attrs[NV_MACSEC_ATTR_IFNAME]) {
+		ret = -EINVAL;
+		goto exit;
+	}
+
+	macsec_pdata = genl_to_macsec_pdata(info);
+	if (macsec_pdata) {
+		pdata = macsec_pdata->ether_pdata;
+	} else {
+		ret = -EPROTO;
+		goto exit;
+	}
+	dev = pdata->dev;
+
+	if (!netif_running(pdata->ndev)) {
+		ret = -ENETDOWN;
+		dev_err(dev, "%s: MAC interface down!!\n", __func__);
+		goto exit;
+	}
+
+	sa_list = kcalloc(NV_MACSEC_MAX_BULK_SA, sizeof(*sa_list), GFP_KERNEL);
+	if (!sa_list) {
+		ret = -ENOMEM;
+		goto exit;
+	}
+
+	num = parse_sa_list(macsec_pdata, attrs, sa_list);
+	if (num < 0) {
+		dev_err(dev, "%s: failed to parse nlattrs", __func__);
+		ret = num;
+		goto exit;
+	}
+
+	mutex_lock(&macsec_pdata->lock);
+	for (j = 0; j < ARRAY_SIZE(ctlr_order); j++) {
+		for (i = 0; i < num; i++) {
+			if (sa_list[i].ctlr != ctlr_order[j])
+				continue;
+
+			sa_list[i].sa.flags = OSI_ENABLE_SA;
+			ret = osi_macsec_config(pdata->osi_core,
+						&sa_list[i].sa, OSI_ENABLE,
+						sa_list[i].ctlr,
+						&sa_list[i].kt_idx);
+			if (ret < 0) {
+				dev_err(dev, "%s: failed to enable %s SA %d\n",
+					__func__,
+					(sa_list[i].ctlr == OSI_CTLR_SEL_TX) ?
+					"Tx" : "Rx", i);
+				goto err_unlock;
+			}
+
+			/* Update the macsec pdata when AN is enabled */
+			an_bit = (1U) << (sa_list[i].sa.curr_an & 0xFU);
+			if (sa_list[i].ctlr == OSI_CTLR_SEL_TX)
+				macsec_pdata->macsec_tx_an_map |= an_bit;
+			else
+				macsec_pdata->macsec_rx_an_map |= an_bit;
+		}
+	}
+
+err_unlock:
+	mutex_unlock(&macsec_pdata->lock);
+exit:
+	kfree(sa_list);
+	PRINT_EXIT();
+	return ret;
+}
+
 static int macsec_deinit(struct sk_buff *skb, struct genl_info *info)
 {
 	struct nlattr **attrs = info->attrs;
@@ -1264,6 +1540,16 @@ static const struct genl_ops nv_macsec_genl_ops[] = {
 		.doit = macsec_get_tx_next_pn,
 		.flags = GENL_ADMIN_PERM,
 	},
+	{
+		.cmd = NV_MACSEC_CMD_CREATE_SA_BULK,
+		.doit = macsec_create_sa_bulk,
+		.flags = GENL_ADMIN_PERM,
+	},
+	{
+		.cmd = NV_MACSEC_CMD_EN_SA_BULK,
+		.doit = macsec_en_sa_bulk,
+		.flags = GENL_ADMIN_PERM,
+	},
 };
 
 void macsec_remove(struct ether_priv_data *pdata)
@@ -1444,6 +1730,137 @@ exit:
 }
 
 #ifndef MACSEC_KEY_PROGRAM
+/**
+ * @brief macsec_tz_put_kt_config - Add one key table entry to a TZ reply.
+ *
+ * @param[in] msg: Netlink reply being built.
+ * @param[in] pdata: OSD private data structure.
+ * @param[in] kt_config: Pointer to osi_macsec_kt_config structure
+ * @param[in] pkcs: Wrapped key data, may be NULL.
+ *
+ * @retval 0 on success
+ * @retval negative value on failure.
+ */
+static int macsec_tz_put_kt_config(struct sk_buff *msg,
+				   struct ether_priv_data *pdata,
+				   struct osi_macsec_kt_config *const kt_config,
+				   struct nvpkcs_data *pkcs)
+{
+	struct nlattr *nest;
+
+	nest = nla_nest_start(msg, NV_MACSEC_ATTR_TZ_CONFIG);
+	if (!nest) {
+		return -EMSGSIZE;
+	}
+	if (nla_put_u32(msg, NV_MACSEC_TZ_INSTANCE_ID,
+			pdata->osi_core->instance_id) ||
+	    nla_put_u8(msg, NV_MACSEC_TZ_ATTR_CTRL,
+		       kt_config->table_config.ctlr_sel) ||
+	    nla_put_u8(msg, NV_MACSEC_TZ_ATTR_RW,
+		       kt_config->table_config.rw) ||
+	    nla_put_u8(msg, NV_MACSEC_TZ_ATTR_INDEX,
+		       kt_config->table_config.index) ||
+	    nla_put_u32(msg, NV_MACSEC_TZ_ATTR_FLAG, kt_config->flags)) {
+		goto cancel;
+	}
+#ifdef NVPKCS_MACSEC
+	if (pkcs) {
+		if (nla_put(msg, NV_MACSEC_TZ_PKCS_KEY_WRAP,
+			    sizeof(pkcs->nv_key), pkcs->nv_key) ||
+		    nla_put_u64_64bit(msg, NV_MACSEC_TZ_PKCS_KEK_HANDLE,
+				      pkcs->nv_kek, NL_POLICY_TYPE_ATTR_PAD)) {
+			goto cancel;
+		}
+	}
+#else
+	if (nla_put(msg, NV_MACSEC_TZ_ATTR_KEY, OSI_KEY_LEN_256,
+		    kt_config->entry.sak)) {
+		goto cancel;
+	}
+#endif /* NVPKCS_MACSEC */
+	nla_nest_end(msg, nest);
+	return 0;
+
+cancel:
+	nla_nest_cancel(msg, nest);
+	return -EMSGSIZE;
+}
+
+/**
+ * @brief macsec_tz_kt_config_bulk - Program several key table entries.
+ *
+ * Algorithm: Builds a single TZ config reply carrying one
+ * NV_MACSEC_ATTR_TZ_CONFIG nest per SA so that the supplicant programs
+ * all the keys of a bulk request in one round trip.
+ *
+ * @param[in] pdata: OSD private data structure.
+ * @param[in] sa_list: SAs created by the bulk request.
+ * @param[in] num: Number of entries in sa_list.
+ * @param[in] info: Pointer to netlink msg structure
+ *
+ * @retval 0 on success
+ * @retval negative value on failure.
+ */
+static int macsec_tz_kt_config_bulk(struct ether_priv_data *pdata,
+				    struct macsec_bulk_sa *const sa_list,
+				    int num, struct genl_info *const info)
+{
+	struct macsec_priv_data *macsec_pdata = pdata->macsec_pdata;
+	struct osi_macsec_kt_config kt_config;
+	struct device *dev = pdata->dev;
+	struct sk_buff *msg;
+	void *msg_head;
+	int ret = 0;
+	int i;
+
+	PRINT_ENTRY();
+	msg = genlmsg_new(NLMSG_GOODSIZE, GFP_KERNEL);
+	if (msg == NULL) {
+		dev_err(dev, "Unable to alloc genl reply\n");
+		ret = -ENOMEM;
+		goto fail;
+	}
+
+	msg_head = genlmsg_put_reply(msg, info, &macsec_pdata->nv_macsec_fam,
+				     0, NV_MACSEC_CMD_TZ_CONFIG);
+	if (msg_head == NULL) {
+		dev_err(dev, "unable to get replyhead\n");
+		ret = -EINVAL;
+		goto failure;
+	}
+
+	for (i = 0; i < num; i++) {
+		memset(&kt_config, 0, sizeof(kt_config));
+		kt_config.table_config.ctlr_sel = sa_list[i].ctlr;
+		kt_config.table_config.rw = OSI_LUT_WRITE;
+		kt_config.table_config.index = sa_list[i].kt_idx;
+		kt_config.flags |= OSI_LUT_FLAGS_ENTRY_VALID;
+		memcpy(kt_config.entry.sak, sa_list[i].sa.sak,
+		       OSI_KEY_LEN_256);
+
+		ret = macsec_tz_put_kt_config(msg, pdata, &kt_config,
+					      &sa_list[i].pkcs);
+		if (ret < 0) {
+			dev_err(dev, "%s: reply full at SA %d\n", __func__, i);
+			goto failure;
+		}
+	}
+
+	genlmsg_end(msg, msg_head);
+	ret = genlmsg_reply(msg, info);
+	if (ret != 0) {
+		dev_err(dev, "Unable to send reply\n");
+	}
+
+	PRINT_EXIT();
+	return ret;
+failure:
+	nlmsg_free(msg);
+fail:
+	PRINT_EXIT();
+	return ret;
+}
+
 /**
  * @brief macsec_tz_kt_config - Program macsec key table entry.
  *
@@ -1517,34 +1934,10 @@ static int macsec_tz_kt_config(struct ether_priv_data *pdata,
 		 *	 kt_config->flags);
 		 */
 
-		nest = nla_nest_start(msg, NV_MACSEC_ATTR_TZ_CONFIG);
-		if (!nest) {
-			ret = EINVAL;
+		ret = macsec_tz_put_kt_config(msg, pdata, kt_config, pkcs);
+		if (ret < 0) {
 			goto failure;
 		}
-		nla_put_u32(msg, NV_MACSEC_TZ_INSTANCE_ID,
-			    pdata->osi_core->instance_id);
-		nla_put_u8(msg, NV_MACSEC_TZ_ATTR_CTRL,
-			   kt_config->table_config.ctlr_sel);
-		nla_put_u8(msg, NV_MACSEC_TZ_ATTR_RW,
-			   kt_config->table_config.rw);
-		nla_put_u8(msg, NV_MACSEC_TZ_ATTR_INDEX,
-			   kt_config->table_config.index);
-		nla_put_u32(msg, NV_MACSEC_TZ_ATTR_FLAG, kt_config->flags);
-#ifdef NVPKCS_MACSEC
-		if (pkcs) {
-			nla_put(msg, NV_MACSEC_TZ_PKCS_KEY_WRAP,
-				sizeof(pkcs->nv_key),
-				pkcs->nv_key);
-			nla_put_u64_64bit(msg, NV_MACSEC_TZ_PKCS_KEK_HANDLE,
-					  pkcs->nv_kek,
-					  NL_POLICY_TYPE_ATTR_PAD);
-		}
-#else
-		nla_put(msg, NV_MACSEC_TZ_ATTR_KEY, OSI_KEY_LEN_256,
-			kt_config->entry.sak);
-#endif /* NVPKCS_MACSEC */
-		nla_nest_end(msg, nest);
 	}
 	genlmsg_end(msg, msg_head);
 	ret = genlmsg_reply(msg, info);
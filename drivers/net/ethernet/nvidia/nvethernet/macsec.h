@@ -54,6 +54,11 @@
 /* PKCS KEK CK_OBJECT_HANDLE is u64 type */
 #define NV_KEK_HANDLE_SIZE 8
 
+/**
+ * @brief Maximum number of SAs carried by one bulk create/enable request
+ */
+#define NV_MACSEC_MAX_BULK_SA		(2U * OSI_MAX_NUM_SC)
+
 /* keep the same enum definition in nv macsec supplicant driver */
 enum nv_macsec_sa_attrs {
 	NV_MACSEC_SA_ATTR_UNSPEC,
@@ -67,6 +72,7 @@ enum nv_macsec_sa_attrs {
 #else
 	NV_MACSEC_SA_ATTR_KEY,
 #endif /* NVPKCS_MACSEC */
+	NV_MACSEC_SA_ATTR_CTLR, /* Tx or Rx controller, bulk cmds only */
 	__NV_MACSEC_SA_ATTR_END,
 	NUM_NV_MACSEC_SA_ATTR = __NV_MACSEC_SA_ATTR_END,
 	NV_MACSEC_SA_ATTR_MAX = __NV_MACSEC_SA_ATTR_END - 1,
@@ -108,6 +114,7 @@ enum nv_macsec_attrs {
 	NV_MACSEC_ATTR_SA_CONFIG, /* Nested SA config */
 	NV_MACSEC_ATTR_TZ_CONFIG, /* Nested TZ config */
 	NV_MACSEC_ATTR_TZ_KT_RESET, /* Nested TZ KT config */
+	NV_MACSEC_ATTR_SA_LIST, /* Nested list of SA configs */
 	__NV_MACSEC_ATTR_END,
 	NUM_NV_MACSEC_ATTR = __NV_MACSEC_ATTR_END,
 	NV_MACSEC_ATTR_MAX = __NV_MACSEC_ATTR_END - 1,
@@ -127,6 +134,7 @@ static const struct nla_policy nv_macsec_sa_genl_policy[NUM_NV_MACSEC_SA_ATTR] =
 	[NV_MACSEC_SA_ATTR_KEY] = { .type = NLA_BINARY,
 				    .len = OSI_KEY_LEN_256,},
 #endif /* NVPKCS_MACSEC */
+	[NV_MACSEC_SA_ATTR_CTLR] = { .type = NLA_U8 },
 };
 
 static const struct nla_policy nv_macsec_tz_genl_policy[NUM_NV_MACSEC_TZ_ATTR] = {
@@ -157,6 +165,7 @@ static const struct nla_policy nv_macsec_genl_policy[NUM_NV_MACSEC_ATTR] = {
 	[NV_MACSEC_ATTR_SA_CONFIG] = { .type = NLA_NESTED },
 	[NV_MACSEC_ATTR_TZ_CONFIG] = { .type = NLA_NESTED },
 	[NV_MACSEC_ATTR_TZ_KT_RESET] = { .type = NLA_NESTED },
+	[NV_MACSEC_ATTR_SA_LIST] = { .type = NLA_NESTED },
 };
 
 enum nv_macsec_nl_commands {
@@ -173,6 +182,8 @@ enum nv_macsec_nl_commands {
 	NV_MACSEC_CMD_TZ_CONFIG,
 	NV_MACSEC_CMD_TZ_KT_RESET,
 	NV_MACSEC_CMD_DEINIT,
+	NV_MACSEC_CMD_CREATE_SA_BULK,
+	NV_MACSEC_CMD_EN_SA_BULK,
 };
 
 /**
@@ -203,6 +214,20 @@ struct nvpkcs_data {
 	u64 nv_kek;
 };
 
+/**
+ * @brief MACsec bulk SA request entry
+ */
+struct macsec_bulk_sa {
+	/** SA parameters parsed from the nested SA config */
+	struct osi_macsec_sc_info sa;
+	/** wrapped key data for the SA */
+	struct nvpkcs_data pkcs;
+	/** controller the SA belongs to, OSI_CTLR_SEL_TX or OSI_CTLR_SEL_RX */
+	unsigned short ctlr;
+	/** key table index returned by OSI on create */
+	unsigned short kt_idx;
+};
+
 /**
  * @brief MACsec private data structure
  */
@@ -253,7 +253,8 @@ static inline int ether_alloc_skb(struct ether_priv_data *pdata,
 		return 0;
 	}
 
-	rx_swcx->buf_phy_addr = page_pool_get_dma_addr(rx_swcx->buf_virt_addr);
+	rx_swcx->buf_phy_addr = page_pool_get_dma_addr(rx_swcx->buf_virt_addr) +
+				ETHER_RX_HEADROOM;
 #endif
 #ifndef ETHER_PAGE_POOL
 	rx_swcx->buf_virt_addr = skb;
@@ -590,6 +591,196 @@ exit:
 }
 #endif
 
+#ifdef ETHER_XDP
+/**
+ * @brief Send an XDP_TX frame back out of the interface.
+ *
+ * Algorithm: OSI Tx completion only knows how to release skbs, so the
+ * frame is copied into an skb and pushed through the regular transmit
+ * path on the Tx queue paired with the Rx channel.
+ *
+ * @param[in] pdata: OSD private data structure.
+ * @param[in] xdp: XDP buffer holding the frame.
+ * @param[in] chan: DMA Rx channel number.
+ *
+ * @retval 0 on success
+ * @retval "negative value" on failure.
+ */
+static int ether_xdp_xmit_back(struct ether_priv_data *pdata,
+			       struct xdp_buff *xdp, unsigned int chan)
+{
+	struct osi_dma_priv_data *osi_dma = pdata->osi_dma;
+	struct net_device *ndev = pdata->ndev;
+	unsigned int len = xdp->data_end - xdp->data;
+	struct netdev_queue *txq;
+	struct sk_buff *skb;
+	netdev_tx_t ret;
+	unsigned int qinx;
+
+	for (qinx = 0; qinx < osi_dma->num_dma_chans; qinx++) {
+		if (osi_dma->dma_chans[qinx] == chan)
+			break;
+	}
+
+	if (qinx == osi_dma->num_dma_chans)
+		return -EINVAL;
+
+	skb = napi_alloc_skb(&pdata->rx_napi[chan]->napi, len);
+	if (unlikely(!skb))
+		return -ENOMEM;
+
+	skb_copy_to_linear_data(skb, xdp->data, len);
+	skb_put(skb, len);
+	skb->dev = ndev;
+	skb_set_queue_mapping(skb, qinx);
+
+	txq = netdev_get_tx_queue(ndev, qinx);
+	__netif_tx_lock(txq, smp_processor_id());
+	if (netif_xmit_frozen_or_stopped(txq))
+		ret = NETDEV_TX_BUSY;
+	else
+		ret = netdev_start_xmit(skb, ndev, txq, false);
+	__netif_tx_unlock(txq);
+
+	if (ret != NETDEV_TX_OK) {
+		dev_kfree_skb_any(skb);
+		return -EBUSY;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Run the attached XDP program on a received page.
+ *
+ * Algorithm:
+ * 1) Build an XDP buffer over the page pool page, headroom included.
+ * 2) Run the program and carry out its verdict. Every verdict except
+ *    XDP_PASS consumes the page.
+ * 3) On XDP_PASS return the possibly adjusted packet offset and length.
+ *
+ * @param[in] pdata: OSD private data structure.
+ * @param[in] prog: XDP program.
+ * @param[in] chan: DMA Rx channel number.
+ * @param[in] page: Page pool page holding the packet.
+ * @param[in, out] offset: Packet offset into the page.
+ * @param[in, out] len: Packet length.
+ *
+ * @retval XDP verdict that was applied.
+ */
+static u32 ether_run_xdp(struct ether_priv_data *pdata,
+			 struct bpf_prog *prog, unsigned int chan,
+			 struct page *page, unsigned int *offset,
+			 unsigned int *len)
+{
+	struct page_pool *pool = pdata->page_pool[chan];
+	struct net_device *ndev = pdata->ndev;
+	struct xdp_buff xdp;
+	unsigned long val;
+	u32 act;
+
+	xdp_init_buff(&xdp, PAGE_SIZE << pool->p.order, &pdata->xdp_rxq[chan]);
+	xdp_prepare_buff(&xdp, page_address(page), *offset, *len, false);
+
+	act = bpf_prog_run_xdp(prog, &xdp);
+	switch (act) {
+	case XDP_PASS:
+		*offset = xdp.data - page_address(page);
+		*len = xdp.data_end - xdp.data;
+		return act;
+	case XDP_TX:
+		if (ether_xdp_xmit_back(pdata, &xdp, chan) < 0)
+			goto xdp_fail;
+		/* Frame was copied, the page goes back to the pool */
+		page_pool_recycle_direct(pool, page);
+		val = pdata->xstats.rx_xdp_tx;
+		pdata->xstats.rx_xdp_tx = osi_update_stats_counter(val, 1UL);
+		return act;
+	case XDP_REDIRECT:
+		if (xdp_do_redirect(ndev, &xdp, prog) < 0)
+			goto xdp_fail;
+		pdata->rx_napi[chan]->xdp_redirect = true;
+		val = pdata->xstats.rx_xdp_redirect;
+		pdata->xstats.rx_xdp_redirect =
+			osi_update_stats_counter(val, 1UL);
+		return act;
+	default:
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 17, 0)
+		bpf_warn_invalid_xdp_action(ndev, prog, act);
+#else
+		bpf_warn_invalid_xdp_action(act);
+#endif
+		fallthrough;
+	case XDP_ABORTED:
+xdp_fail:
+		trace_xdp_exception(ndev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		break;
+	}
+
+	page_pool_recycle_direct(pool, page);
+	val = pdata->xstats.rx_xdp_drop;
+	pdata->xstats.rx_xdp_drop = osi_update_stats_counter(val, 1UL);
+	ndev->stats.rx_dropped++;
+
+	return act;
+}
+#endif
+
+#ifdef ETHER_RX_PP_FRAGS
+/**
+ * @brief Build an Rx skb over a page pool page.
+ *
+ * Algorithm:
+ * 1) Packets up to ETHER_RX_COPYBREAK are copied into a linear skb and
+ *    the page is recycled right away.
+ * 2) For larger packets only the protocol headers are copied, the payload
+ *    is attached as a page fragment that goes back to the page pool when
+ *    the stack frees the skb. GRO then merges fragments instead of
+ *    copying whole linear buffers.
+ *
+ * @param[in] pdata: OSD private data structure.
+ * @param[in] chan: DMA Rx channel number.
+ * @param[in] page: Page pool page holding the packet.
+ * @param[in] pkt_off: Packet offset into the page.
+ * @param[in] pkt_len: Packet length.
+ *
+ * @retval skb on success
+ * @retval NULL on failure, page is left to the caller.
+ */
+static struct sk_buff *ether_build_rx_skb(struct ether_priv_data *pdata,
+					  unsigned int chan,
+					  struct page *page,
+					  unsigned int pkt_off,
+					  unsigned int pkt_len)
+{
+	struct page_pool *pool = pdata->page_pool[chan];
+	void *va = page_address(page) + pkt_off;
+	unsigned int hlen = pkt_len;
+	struct sk_buff *skb;
+
+	skb = napi_alloc_skb(&pdata->rx_napi[chan]->napi, ETHER_RX_COPYBREAK);
+	if (unlikely(!skb))
+		return NULL;
+
+	if (pkt_len > ETHER_RX_COPYBREAK)
+		hlen = eth_get_headlen(pdata->ndev, va, ETHER_RX_COPYBREAK);
+
+	skb_put_data(skb, va, hlen);
+	if (hlen == pkt_len) {
+		page_pool_recycle_direct(pool, page);
+		return skb;
+	}
+
+	skb_add_rx_frag(skb, 0, page, pkt_off + hlen, pkt_len - hlen,
+			PAGE_SIZE << pool->p.order);
+	skb_mark_for_recycle(skb);
+
+	return skb;
+}
+#endif
+
 /**
  * @brief Handover received packet to network stack.
  *
@@ -618,7 +809,12 @@ static void osd_receive_packet(void *priv, struct osi_rx_ring *rx_ring,
 	struct ether_rx_napi *rx_napi = pdata->rx_napi[chan];
 #ifdef ETHER_PAGE_POOL
 	struct page *page = (struct page *)rx_swcx->buf_virt_addr;
+	unsigned int pkt_off = ETHER_RX_HEADROOM;
+	unsigned int pkt_len = rx_pkt_cx->pkt_len;
 	struct sk_buff *skb = NULL;
+#ifdef ETHER_XDP
+	struct bpf_prog *xdp_prog;
+#endif
 #else
 	struct sk_buff *skb = (struct sk_buff *)rx_swcx->buf_virt_addr;
 #endif
@@ -647,8 +843,22 @@ static void osd_receive_packet(void *priv, struct osi_rx_ring *rx_ring,
 	if (likely((rx_pkt_cx->flags & OSI_PKT_CX_VALID) ==
 		   OSI_PKT_CX_VALID)) {
 #ifdef ETHER_PAGE_POOL
-		skb = netdev_alloc_skb_ip_align(pdata->ndev,
-						rx_pkt_cx->pkt_len);
+		dma_sync_single_for_cpu(pdata->dev, dma_addr,
+					pkt_len, DMA_FROM_DEVICE);
+#ifdef ETHER_XDP
+		xdp_prog = READ_ONCE(pdata->xdp_prog);
+		if (xdp_prog &&
+		    ether_run_xdp(pdata, xdp_prog, chan, page, &pkt_off,
+				  &pkt_len) != XDP_PASS) {
+			ndev->stats.rx_bytes += rx_pkt_cx->pkt_len;
+			goto done;
+		}
+#endif
+#ifdef ETHER_RX_PP_FRAGS
+		skb = ether_build_rx_skb(pdata, chan, page, pkt_off, pkt_len);
+#else
+		skb = netdev_alloc_skb_ip_align(pdata->ndev, pkt_len);
+#endif
 		if (unlikely(!skb)) {
 			pdata->ndev->stats.rx_dropped++;
 			dev_err(pdata->dev,
@@ -658,12 +868,12 @@ static void osd_receive_packet(void *priv, struct osi_rx_ring *rx_ring,
 			return;
 		}
 
-		dma_sync_single_for_cpu(pdata->dev, dma_addr,
-					rx_pkt_cx->pkt_len, DMA_FROM_DEVICE);
-		skb_copy_to_linear_data(skb, page_address(page),
-					rx_pkt_cx->pkt_len);
-		skb_put(skb, rx_pkt_cx->pkt_len);
+#ifndef ETHER_RX_PP_FRAGS
+		skb_copy_to_linear_data(skb, page_address(page) + pkt_off,
+					pkt_len);
+		skb_put(skb, pkt_len);
 		page_pool_recycle_direct(pdata->page_pool[chan], page);
+#endif
 #else
 		skb_put(skb, rx_pkt_cx->pkt_len);
 #endif
@@ -699,6 +909,10 @@ static void osd_receive_packet(void *priv, struct osi_rx_ring *rx_ring,
 		skb->dev = ndev;
 		skb->protocol = eth_type_trans(skb, ndev);
 		ndev->stats.rx_bytes += skb->len;
+#ifdef ETHER_DIM
+		rx_napi->dim_pkts++;
+		rx_napi->dim_bytes += skb->len;
+#endif
 #ifdef ETHER_NVGRO
 		if ((ndev->features & NETIF_F_GRO) &&
 		    ether_do_nvgro(pdata, &rx_napi->napi, skb))
@@ -722,7 +936,7 @@ static void osd_receive_packet(void *priv, struct osi_rx_ring *rx_ring,
 		dev_kfree_skb_any(skb);
 	}
 
-#ifdef ETHER_NVGRO
+#if defined(ETHER_NVGRO) || defined(ETHER_XDP)
 done:
 #endif
 	ndev->stats.rx_packets++;
@@ -803,6 +1017,15 @@ static void osd_transmit_complete(void *priv, const struct osi_tx_swcx *swcx,
 		}
 
 		ndev->stats.tx_packets++;
+		pdata->xstats.q_tx_bytes[qinx] =
+			osi_update_stats_counter(pdata->xstats.q_tx_bytes[qinx],
+						 skb->len);
+		pdata->tx_napi[chan]->bql_pkts++;
+		pdata->tx_napi[chan]->bql_bytes += skb->len;
+#ifdef ETHER_DIM
+		pdata->tx_napi[chan]->dim_pkts++;
+		pdata->tx_napi[chan]->dim_bytes += skb->len;
+#endif
 		if ((txdone_pkt_cx->flags & OSI_TXDONE_CX_TS_DELAYED) ==
 		    OSI_TXDONE_CX_TS_DELAYED) {
 			add_skb_node(pdata, skb, txdone_pkt_cx->pktid);
@@ -2,6 +2,11 @@
 /* Copyright (c) 2019-2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved */
 
 #include <linux/version.h>
+#include <linux/math64.h>
+#include <linux/timekeeping.h>
+#ifdef CONFIG_ARM64
+#include <asm/arch_timer.h>
+#endif
 #include "ether_linux.h"
 
 /**
@@ -242,6 +247,63 @@ static int ether_set_time(struct ptp_clock_info *ptp,
 	return ret;
 }
 
+#ifdef CONFIG_ARM64
+/**
+ * @brief Get precise cross timestamp of MAC and system time
+ *
+ * Algorithm: This function latches the MAC PTP time together with the
+ * TSC using the MAC PTP-TSC capture logic, takes a system time snapshot
+ * right after and moves the snapshot back to the instant of the capture
+ * using the snapshot counter value. The TSC is the ARM architected
+ * counter, which is the timekeeping clocksource, so the correlation does
+ * not depend on how long the register accesses take.
+ *
+ * @param[in] ptp: Pointer to ptp_clock_info structure.
+ * @param[out] xtstamp: Captured device and system time.
+ *
+ * @retval 0 on success
+ * @retval "negative value" on failure.
+ */
+static int ether_get_crosststamp(struct ptp_clock_info *ptp,
+				 struct system_device_crosststamp *xtstamp)
+{
+	struct ether_priv_data *pdata = container_of(ptp,
+						     struct ether_priv_data,
+						     ptp_clock_ops);
+	struct system_time_snapshot snap;
+	struct ptp_tsc_data ptp_tsc;
+	u32 cntfrq = arch_timer_get_cntfrq();
+	u64 cycles, delta_ns;
+	int ret;
+
+	if (cntfrq == 0U)
+		return -EOPNOTSUPP;
+
+	ret = ether_get_hw_time(pdata->ndev, &ptp_tsc, PTP_TSC_HWTIME);
+	if (ret != 0)
+		return ret;
+
+	ktime_get_snapshot(&snap);
+#if KERNEL_VERSION(5, 13, 0) <= LINUX_VERSION_CODE
+	if (snap.cs_id != CSID_ARM_ARCH_COUNTER)
+		return -ENODEV;
+#endif
+
+	/* MAC reports the TSC in ns, timekeeping counts in TSC ticks */
+	cycles = mul_u64_u32_div(ptp_tsc.tsc_ts, cntfrq, NSEC_PER_SEC);
+	if (snap.cycles < cycles)
+		return -EAGAIN;
+
+	delta_ns = mul_u64_u32_div(snap.cycles - cycles, NSEC_PER_SEC, cntfrq);
+
+	xtstamp->device = ns_to_ktime(ptp_tsc.ptp_ts);
+	xtstamp->sys_realtime = ktime_sub_ns(snap.real, delta_ns);
+	xtstamp->sys_monoraw = ktime_sub_ns(snap.raw, delta_ns);
+
+	return 0;
+}
+#endif
+
 /**
  * @brief Describing Ethernet PTP hardware clock
  */
@@ -261,6 +323,9 @@ static struct ptp_clock_info ether_ptp_clock_ops = {
 	.adjtime = ether_adjust_time,
 	.gettime64 = ether_get_time,
 	.settime64 = ether_set_time,
+#ifdef CONFIG_ARM64
+	.getcrosststamp = ether_get_crosststamp,
+#endif
 };
 
 static int ether_early_ptp_init(struct ether_priv_data *pdata)
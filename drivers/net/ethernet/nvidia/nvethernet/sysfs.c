@@ -2735,12 +2735,112 @@ static struct attribute *ether_sysfs_attrs[] = {
 	NULL
 };
 
+/**
+ * @brief ether_stats_blob_read - Read the binary stats snapshot.
+ *
+ * Algorithm: A read at offset 0 refreshes the HW counters once and takes
+ * a new snapshot of all ethtool statistics behind a
+ * struct ether_stats_blob_hdr. Reads at other offsets are served from the
+ * same snapshot, so a reader sees one consistent set of counters even when
+ * the blob spans several read calls.
+ *
+ * @param[in] filp: Pointer to file structure.
+ * @param[in] kobj: Kernel object of the ethernet device.
+ * @param[in] attr: Binary attribute.
+ * @param[out] buf: Buffer to copy the blob into.
+ * @param[in] off: Offset in the blob.
+ * @param[in] count: Number of bytes to read.
+ *
+ * @return Number of bytes copied or negative value on failure.
+ */
+static ssize_t ether_stats_blob_read(struct file *filp, struct kobject *kobj,
+				     struct bin_attribute *attr, char *buf,
+				     loff_t off, size_t count)
+{
+	struct device *dev = kobj_to_dev(kobj);
+	struct net_device *ndev = (struct net_device *)dev_get_drvdata(dev);
+	struct ether_priv_data *pdata = netdev_priv(ndev);
+	struct ether_stats_blob_hdr *hdr;
+	ssize_t ret = 0;
+	int num;
+
+	mutex_lock(&pdata->stats_blob_lock);
+	if (off == 0) {
+		if (!netif_running(ndev)) {
+			ret = -ENETDOWN;
+			goto unlock;
+		}
+
+		num = ether_get_stats_count(pdata);
+		if (num < 0) {
+			ret = num;
+			goto unlock;
+		}
+
+		if (pdata->stats_blob == NULL) {
+			pdata->stats_blob = devm_kzalloc(dev, sizeof(*hdr) +
+							 num * sizeof(u64),
+							 GFP_KERNEL);
+			if (pdata->stats_blob == NULL) {
+				ret = -ENOMEM;
+				goto unlock;
+			}
+		}
+
+		hdr = pdata->stats_blob;
+		ret = ether_snapshot_stats(pdata, (u64 *)(hdr + 1));
+		if (ret < 0) {
+			pdata->stats_blob_len = 0;
+			goto unlock;
+		}
+
+		hdr->magic = ETHER_STATS_BLOB_MAGIC;
+		hdr->version = ETHER_STATS_BLOB_VERSION;
+		hdr->hdr_len = sizeof(*hdr);
+		hdr->num_stats = num;
+		hdr->reserved = 0;
+		hdr->timestamp_ns = ktime_get_ns();
+		pdata->stats_blob_len = sizeof(*hdr) + num * sizeof(u64);
+	}
+
+	if (off >= pdata->stats_blob_len) {
+		ret = 0;
+		goto unlock;
+	}
+
+	count = min_t(size_t, count, pdata->stats_blob_len - off);
+	memcpy(buf, (char *)pdata->stats_blob + off, count);
+	ret = count;
+unlock:
+	mutex_unlock(&pdata->stats_blob_lock);
+	return ret;
+}
+
+/**
+ * @brief Sysfs binary attribute for the stats snapshot
+ *
+ * Usage: cat /sys/devices/<ether_device>/nvethernet/stats_blob
+ */
+static struct bin_attribute bin_attr_stats_blob = {
+	.attr = { .name = "stats_blob", .mode = 0444 },
+	.read = ether_stats_blob_read,
+};
+
+/**
+ * @brief Binary attributes for nvethernet sysfs
+ */
+static struct bin_attribute *ether_sysfs_bin_attrs[] = {
+	&bin_attr_stats_blob,
+	NULL
+};
+
 /**
  * @brief Ethernet sysfs attribute group
  */
 static struct attribute_group ether_attribute_group = {
 	.name = "nvethernet",
 	.attrs = ether_sysfs_attrs,
+	.bin_attrs = ether_sysfs_bin_attrs,
 };
 
 #ifndef OSI_STRIPPED_LIB
@@ -23,6 +23,16 @@
 #include <linux/netdevice.h>
 #include <linux/pci.h>
 #include <linux/tegra_vnet.h>
+#include <linux/version.h>
+#if IS_ENABLED(CONFIG_PAGE_POOL) && (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 15, 0))
+#if defined(NV_NET_PAGE_POOL_H_PRESENT)
+#include <net/page_pool.h>
+#else
+#include <net/page_pool/types.h>
+#include <net/page_pool/helpers.h>
+#endif
+#define TVNET_PAGE_POOL
+#endif
 
 struct tvnet_priv {
 	struct net_device *ndev;
@@ -37,6 +47,10 @@ struct tvnet_priv {
 	struct list_head ep2h_empty_list;
 	/* To protect ep2h empty list */
 	spinlock_t ep2h_empty_lock;
+#ifdef TVNET_PAGE_POOL
+	/* Rx buffers posted to EP, recycled once stack frees the skb */
+	struct page_pool *page_pool;
+#endif
 	struct tvnet_dma_desc *dma_desc;
 #if ENABLE_DMA
 	struct dma_desc_cnt desc_cnt;
@@ -162,15 +176,29 @@ static void tvnet_host_alloc_empty_buffers(struct tvnet_priv *tvnet)
 	struct host_ring_buf *host_mem = &tvnet->host_mem;
 	struct data_msg *ep2h_empty_msg = host_mem->ep2h_empty_msgs;
 	struct ep2h_empty_list *ep2h_empty_ptr;
+#ifndef TVNET_PAGE_POOL
 	struct device *d = &tvnet->pdev->dev;
+#endif
 	unsigned long flags;
 
 	while (!tvnet_ivc_full(&tvnet->ep2h_empty)) {
+#ifdef TVNET_PAGE_POOL
+		struct page *page;
+#else
 		struct sk_buff *skb;
+#endif
 		dma_addr_t iova;
 		int len = ndev->mtu + ETH_HLEN;
 		u32 idx;
 
+#ifdef TVNET_PAGE_POOL
+		page = page_pool_dev_alloc_pages(tvnet->page_pool);
+		if (!page) {
+			pr_err("%s: alloc page failed\n", __func__);
+			break;
+		}
+		iova = page_pool_get_dma_addr(page);
+#else
 		skb = netdev_alloc_skb(ndev, len);
 		if (!skb) {
 			pr_err("%s: alloc skb failed\n", __func__);
@@ -182,14 +210,24 @@ static void tvnet_host_alloc_empty_buffers(struct tvnet_priv *tvnet)
 			dev_kfree_skb_any(skb);
 			break;
 		}
+#endif
 
 		ep2h_empty_ptr = kmalloc(sizeof(*ep2h_empty_ptr), GFP_ATOMIC);
 		if (!ep2h_empty_ptr) {
+#ifdef TVNET_PAGE_POOL
+			page_pool_recycle_direct(tvnet->page_pool, page);
+#else
 			dma_unmap_single(d, iova, len, DMA_FROM_DEVICE);
 			dev_kfree_skb_any(skb);
+#endif
 			break;
 		}
+#ifdef TVNET_PAGE_POOL
+		ep2h_empty_ptr->page = page;
+		ep2h_empty_ptr->skb = NULL;
+#else
 		ep2h_empty_ptr->skb = skb;
+#endif
 		ep2h_empty_ptr->iova = iova;
 		ep2h_empty_ptr->len = len;
 		spin_lock_irqsave(&tvnet->ep2h_empty_lock, flags);
@@ -213,21 +251,69 @@ static void tvnet_host_alloc_empty_buffers(struct tvnet_priv *tvnet)
 static void tvnet_host_free_empty_buffers(struct tvnet_priv *tvnet)
 {
 	struct ep2h_empty_list *ep2h_empty_ptr, *temp;
+#ifndef TVNET_PAGE_POOL
 	struct device *d = &tvnet->pdev->dev;
+#endif
 	unsigned long flags;
+	LIST_HEAD(list);
 
+	/* Release buffers outside the lock, page pool puts need BH enabled */
 	spin_lock_irqsave(&tvnet->ep2h_empty_lock, flags);
-	list_for_each_entry_safe(ep2h_empty_ptr, temp, &tvnet->ep2h_empty_list,
-				 list) {
+	list_splice_init(&tvnet->ep2h_empty_list, &list);
+	spin_unlock_irqrestore(&tvnet->ep2h_empty_lock, flags);
+
+	list_for_each_entry_safe(ep2h_empty_ptr, temp, &list, list) {
 		list_del(&ep2h_empty_ptr->list);
+#ifdef TVNET_PAGE_POOL
+		page_pool_put_full_page(tvnet->page_pool, ep2h_empty_ptr->page,
+					false);
+#else
 		dma_unmap_single(d, ep2h_empty_ptr->iova, ep2h_empty_ptr->len,
 				 DMA_FROM_DEVICE);
 		dev_kfree_skb_any(ep2h_empty_ptr->skb);
+#endif
 		kfree(ep2h_empty_ptr);
 	}
-	spin_unlock_irqrestore(&tvnet->ep2h_empty_lock, flags);
 }
 
+#ifdef TVNET_PAGE_POOL
+static int tvnet_host_page_pool_create(struct tvnet_priv *tvnet)
+{
+	struct page_pool_params pp_params = { 0 };
+	struct device *d = &tvnet->pdev->dev;
+	unsigned int len = tvnet->ndev->mtu + ETH_HLEN;
+	int ret;
+
+	/* Rx page is handed to stack with build_skb(), leave room for shinfo */
+	pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
+	pp_params.pool_size = RING_COUNT;
+	pp_params.order = get_order(SKB_DATA_ALIGN(len) +
+				    SKB_DATA_ALIGN(sizeof(struct skb_shared_info)));
+	pp_params.nid = dev_to_node(d);
+	pp_params.dev = d;
+	pp_params.dma_dir = DMA_FROM_DEVICE;
+	pp_params.offset = 0;
+	pp_params.max_len = len;
+
+	tvnet->page_pool = page_pool_create(&pp_params);
+	if (IS_ERR(tvnet->page_pool)) {
+		ret = PTR_ERR(tvnet->page_pool);
+		tvnet->page_pool = NULL;
+		return ret;
+	}
+
+	return 0;
+}
+
+static void tvnet_host_page_pool_destroy(struct tvnet_priv *tvnet)
+{
+	if (tvnet->page_pool) {
+		page_pool_destroy(tvnet->page_pool);
+		tvnet->page_pool = NULL;
+	}
+}
+#endif
+
 static void tvnet_host_stop_tx_queue(struct tvnet_priv *tvnet)
 {
 	struct net_device *ndev = tvnet->ndev;
@@ -293,7 +379,10 @@ static void tvnet_host_user_link_up_req(struct tvnet_priv *tvnet)
 	struct ctrl_msg msg = {};
 
 	tvnet_host_clear_data_msg_counters(tvnet);
+	/* NAPI is not enabled yet, refill from BH context like poll does */
+	local_bh_disable();
 	tvnet_host_alloc_empty_buffers(tvnet);
+	local_bh_enable();
 	msg.msg_id = CTRL_MSG_LINK_UP;
 	tvnet_host_write_ctrl_msg(tvnet, &msg);
 	tvnet->rx_link_state = DIR_LINK_STATE_UP;
@@ -330,9 +419,11 @@ static void tvnet_host_rcv_link_down_msg(struct tvnet_priv *tvnet)
 
 static void tvnet_host_rcv_link_down_ack(struct tvnet_priv *tvnet)
 {
-	/* Stop using empty buffers(which are full in rx) of local system */
+	/*
+	 * Stop using empty buffers(which are full in rx) of local system,
+	 * they are released from ndo_stop once link down completes.
+	 */
 	tvnet_host_stop_rx_work(tvnet);
-	tvnet_host_free_empty_buffers(tvnet);
 	tvnet->rx_link_state = DIR_LINK_STATE_DOWN;
 	wake_up_interruptible(&tvnet->link_state_wq);
 	tvnet_host_update_link_sm(tvnet);
@@ -341,10 +432,25 @@ static void tvnet_host_rcv_link_down_ack(struct tvnet_priv *tvnet)
 static int tvnet_host_open(struct net_device *ndev)
 {
 	struct tvnet_priv *tvnet = netdev_priv(ndev);
+#ifdef TVNET_PAGE_POOL
+	int ret;
+#endif
 
 	mutex_lock(&tvnet->link_state_lock);
-	if (tvnet->rx_link_state == DIR_LINK_STATE_DOWN)
+	if (tvnet->rx_link_state == DIR_LINK_STATE_DOWN) {
+#ifdef TVNET_PAGE_POOL
+		/* Pool page order follows current MTU */
+		tvnet_host_page_pool_destroy(tvnet);
+		ret = tvnet_host_page_pool_create(tvnet);
+		if (ret < 0) {
+			pr_err("%s: page pool create failed: %d\n", __func__,
+			       ret);
+			mutex_unlock(&tvnet->link_state_lock);
+			return ret;
+		}
+#endif
 		tvnet_host_user_link_up_req(tvnet);
+	}
 	napi_enable(&tvnet->napi);
 	mutex_unlock(&tvnet->link_state_lock);
 
@@ -371,6 +477,11 @@ static int tvnet_host_close(struct net_device *ndev)
 		       __func__, tvnet->tx_link_state, tvnet->rx_link_state,
 		       ret);
 		tvnet->rx_link_state = DIR_LINK_STATE_UP;
+	} else {
+		tvnet_host_free_empty_buffers(tvnet);
+#ifdef TVNET_PAGE_POOL
+		tvnet_host_page_pool_destroy(tvnet);
+#endif
 	}
 	mutex_unlock(&tvnet->link_state_lock);
 
@@ -415,18 +526,16 @@ static netdev_tx_t tvnet_host_start_xmit(struct sk_buff *skb,
 	struct tvnet_dma_desc *dma_desc = tvnet->dma_desc;
 	struct dma_desc_cnt *desc_cnt = &tvnet->desc_cnt;
 	u32 desc_widx, desc_ridx, val;
-	u32 ctrl_d;
+	u32 ctrl_d, off;
 	unsigned long timeout;
+	int i;
 #endif
-	dma_addr_t src_iova;
+	struct tvnet_tx_seg seg[TVNET_TX_MAX_SEGS];
 	dma_addr_t dst_iova;
 	u32 rd_idx;
 	u32 wr_idx;
 	void *dst_virt;
-	int len;
-
-	/* TODO Not expecting skb frags, remove this after testing */
-	WARN_ON(info->nr_frags);
+	int len, nsegs;
 
 	/* Check if H2EP_EMPTY_BUF available to read */
 	if (!tvnet_ivc_rd_available(&tvnet->h2ep_empty)) {
@@ -445,19 +554,25 @@ static netdev_tx_t tvnet_host_start_xmit(struct sk_buff *skb,
 	}
 
 #if ENABLE_DMA
-	/* Check if dma desc available */
-	if ((desc_cnt->wr_cnt - desc_cnt->rd_cnt) >= DMA_DESC_COUNT) {
+	/* Check if dma desc available for linear part and all frags */
+	if ((desc_cnt->wr_cnt - desc_cnt->rd_cnt) + info->nr_frags + 1 >
+	    DMA_DESC_COUNT) {
 		pr_debug("%s: dma descriptors are not available\n", __func__);
 		netif_stop_queue(ndev);
 		return NETDEV_TX_BUSY;
 	}
 #endif
 
-	len = skb_headlen(skb);
+	if (skb->ip_summed == CHECKSUM_PARTIAL && skb_checksum_help(skb)) {
+		dev_kfree_skb_any(skb);
+		return NETDEV_TX_OK;
+	}
 
-	src_iova = dma_map_single(d, skb->data, len, DMA_TO_DEVICE);
-	if (dma_mapping_error(d, src_iova)) {
-		pr_err("%s: dma_map_single failed\n", __func__);
+	len = skb->len;
+
+	nsegs = tvnet_map_skb(d, skb, seg);
+	if (nsegs < 0) {
+		pr_err("%s: skb dma map failed\n", __func__);
 		dev_kfree_skb_any(skb);
 		return NETDEV_TX_OK;
 	}
@@ -475,20 +590,34 @@ static netdev_tx_t tvnet_host_start_xmit(struct sk_buff *skb,
 	tvnet_host_raise_ep_ctrl_irq(tvnet);
 
 #if ENABLE_DMA
-	/* Trigger DMA write from src_iova to dst_iova */
-	desc_widx = desc_cnt->wr_cnt % DMA_DESC_COUNT;
-	dma_desc[desc_widx].size = len;
-	dma_desc[desc_widx].sar_low = lower_32_bits(src_iova);
-	dma_desc[desc_widx].sar_high = upper_32_bits(src_iova);
-	dma_desc[desc_widx].dar_low = lower_32_bits(dst_iova);
-	dma_desc[desc_widx].dar_high = upper_32_bits(dst_iova);
+	/*
+	 * Gather skb segments to dst_iova, one link list element per segment
+	 * and a single doorbell for the whole packet.
+	 */
+	off = 0;
+	for (i = 0; i < nsegs; i++) {
+		desc_widx = (desc_cnt->wr_cnt + i) % DMA_DESC_COUNT;
+		dma_desc[desc_widx].size = seg[i].len;
+		dma_desc[desc_widx].sar_low = lower_32_bits(seg[i].iova);
+		dma_desc[desc_widx].sar_high = upper_32_bits(seg[i].iova);
+		dma_desc[desc_widx].dar_low = lower_32_bits(dst_iova + off);
+		dma_desc[desc_widx].dar_high = upper_32_bits(dst_iova + off);
+		off += seg[i].len;
+	}
 	/* CB bit should be set at the end */
 	mb();
-	/* RIE is not required for polling mode */
-	ctrl_d = DMA_CH_CONTROL1_OFF_RDCH_RIE;
-	ctrl_d |= DMA_CH_CONTROL1_OFF_RDCH_LIE;
-	ctrl_d |= DMA_CH_CONTROL1_OFF_RDCH_CB;
-	dma_desc[desc_widx].ctrl_reg.ctrl_d = ctrl_d;
+	for (i = 0; i < nsegs; i++) {
+		desc_widx = (desc_cnt->wr_cnt + i) % DMA_DESC_COUNT;
+		ctrl_d = DMA_CH_CONTROL1_OFF_RDCH_CB;
+		/* Only last element reports completion, RIE is not required
+		 * for polling mode.
+		 */
+		if (i == nsegs - 1) {
+			ctrl_d |= DMA_CH_CONTROL1_OFF_RDCH_RIE;
+			ctrl_d |= DMA_CH_CONTROL1_OFF_RDCH_LIE;
+		}
+		dma_desc[desc_widx].ctrl_reg.ctrl_d = ctrl_d;
+	}
 	/*
 	 * Read after write to avoid EP DMA reading LLE before CB is written to
 	 * EP's system memory.
@@ -501,7 +630,7 @@ static netdev_tx_t tvnet_host_start_xmit(struct sk_buff *skb,
 	timeout = jiffies + msecs_to_jiffies(1000);
 	dma_common_wr(tvnet->dma_base, DMA_RD_DATA_CH, DMA_READ_DOORBELL_OFF);
 
-	desc_cnt->wr_cnt++;
+	desc_cnt->wr_cnt += nsegs;
 
 	while (true) {
 		val = dma_common_rd(tvnet->dma_base, DMA_READ_INT_STATUS_OFF);
@@ -519,21 +648,23 @@ static netdev_tx_t tvnet_host_start_xmit(struct sk_buff *skb,
 			dma_common_wr(tvnet->dma_base,
 				      DMA_READ_ENGINE_EN_OFF_ENABLE,
 				      DMA_READ_ENGINE_EN_OFF);
-			desc_cnt->wr_cnt--;
-			dma_unmap_single(d, src_iova, len, DMA_TO_DEVICE);
+			desc_cnt->wr_cnt -= nsegs;
+			tvnet_unmap_skb(d, skb, seg, nsegs);
 			return NETDEV_TX_BUSY;
 		}
 	}
 
-	desc_ridx = tvnet->desc_cnt.rd_cnt % DMA_DESC_COUNT;
-	/* Clear DMA cycle bit and increment rd_cnt */
-	dma_desc[desc_ridx].ctrl_reg.ctrl_e.cb = 0;
+	/* Clear DMA cycle bit of all elements and advance rd_cnt */
+	for (i = 0; i < nsegs; i++) {
+		desc_ridx = (tvnet->desc_cnt.rd_cnt + i) % DMA_DESC_COUNT;
+		dma_desc[desc_ridx].ctrl_reg.ctrl_e.cb = 0;
+	}
 	mb();
 
-	tvnet->desc_cnt.rd_cnt++;
+	tvnet->desc_cnt.rd_cnt += nsegs;
 #else
-	/* Copy skb->data to endpoint dst address, use CPU virt addr */
-	memcpy(dst_virt, skb->data, len);
+	/* Copy skb data to endpoint dst address, use CPU virt addr */
+	skb_copy_bits(skb, 0, dst_virt, len);
 	/* BAR0 mmio address is wc mem, add mb to make sure that complete
 	 * skb->data is written before updating counters.
 	 */
@@ -554,7 +685,7 @@ static netdev_tx_t tvnet_host_start_xmit(struct sk_buff *skb,
 	tvnet_host_raise_ep_data_irq(tvnet);
 
 	/* Free skb */
-	dma_unmap_single(d, src_iova, len, DMA_TO_DEVICE);
+	tvnet_unmap_skb(d, skb, seg, nsegs);
 	dev_kfree_skb_any(skb);
 
 	return NETDEV_TX_OK;
@@ -666,8 +797,24 @@ static int tvnet_host_process_ep2h_msg(struct tvnet_priv *tvnet)
 		 */
 		tvnet_host_raise_ep_ctrl_irq(tvnet);
 
+#ifdef TVNET_PAGE_POOL
+		dma_sync_single_for_cpu(d, pcie_address, len, DMA_FROM_DEVICE);
+		skb = build_skb(page_address(ep2h_empty_ptr->page),
+				PAGE_SIZE << tvnet->page_pool->p.order);
+		if (!skb) {
+			page_pool_recycle_direct(tvnet->page_pool,
+						 ep2h_empty_ptr->page);
+			ndev->stats.rx_dropped++;
+			kfree(ep2h_empty_ptr);
+			count++;
+			continue;
+		}
+		/* Page goes back to the pool when stack frees the skb */
+		skb_mark_for_recycle(skb);
+#else
 		dma_unmap_single(d, pcie_address, ndev->mtu + ETH_HLEN, DMA_FROM_DEVICE);
 		skb = ep2h_empty_ptr->skb;
+#endif
 		skb_put(skb, len);
 		skb->protocol = eth_type_trans(skb, ndev);
 		napi_gro_receive(&tvnet->napi, skb);
@@ -697,9 +844,16 @@ static irqreturn_t tvnet_irq_ctrl(int irq, void *data)
 	if (tvnet_ivc_rd_available(&tvnet->ep2h_ctrl))
 		tvnet_host_process_ctrl_msg(tvnet);
 
+	/*
+	 * Refill is done from NAPI context, hand over to poll the same way
+	 * as data irq does.
+	 */
 	if (!tvnet_ivc_full(&tvnet->ep2h_empty) &&
-	    (tvnet->os_link_state == OS_LINK_STATE_UP))
-		tvnet_host_alloc_empty_buffers(tvnet);
+	    (tvnet->os_link_state == OS_LINK_STATE_UP) &&
+	    napi_schedule_prep(&tvnet->napi)) {
+		disable_irq_nosync(pci_irq_vector(tvnet->pdev, 1));
+		__napi_schedule(&tvnet->napi);
+	}
 
 	return IRQ_HANDLED;
 }
@@ -723,6 +877,10 @@ static int tvnet_host_poll(struct napi_struct *napi, int budget)
 	int work_done;
 
 	work_done = tvnet_host_process_ep2h_msg(tvnet);
+	if (!tvnet_ivc_full(&tvnet->ep2h_empty) &&
+	    (tvnet->os_link_state == OS_LINK_STATE_UP))
+		tvnet_host_alloc_empty_buffers(tvnet);
+
 	if (work_done < budget) {
 		napi_complete(napi);
 		enable_irq(pci_irq_vector(tvnet->pdev, 1));
@@ -815,6 +973,11 @@ static int tvnet_host_probe(struct pci_dev *pdev,
 #endif
 
 	ndev->mtu = TVNET_DEFAULT_MTU;
+#if ENABLE_DMA
+	/* Frags are gathered by EP DMA, checksum is resolved in xmit */
+	ndev->hw_features = NETIF_F_SG | NETIF_F_HW_CSUM;
+	ndev->features |= ndev->hw_features;
+#endif
 
 	ret = register_netdev(ndev);
 	if (ret) {
@@ -823,6 +986,16 @@ static int tvnet_host_probe(struct pci_dev *pdev,
 	}
 	netif_carrier_off(ndev);
 
+#if defined(NV_DEV_SET_THREADED_PRESENT) /* Linux v5.12 */
+	/*
+	 * Run the data NAPI in its own kthread so that Rx processing is not
+	 * pinned to the CPU servicing the data MSI-X vector.
+	 */
+	ret = dev_set_threaded(ndev, true);
+	if (ret)
+		dev_warn(&pdev->dev, "threaded NAPI not enabled: %d\n", ret);
+#endif
+
 	tvnet->rx_link_state = DIR_LINK_STATE_DOWN;
 	tvnet->tx_link_state = DIR_LINK_STATE_DOWN;
 	tvnet->os_link_state = OS_LINK_STATE_DOWN;
@@ -140,6 +140,21 @@ do { \
 #endif
 #endif
 
+/* Rx buffers come from a page_pool and are handed to GRO as page frags */
+#if defined(ENABLE_RX_PAGE_POOL)
+#if !defined(CONFIG_R8168_NAPI) || !IS_ENABLED(CONFIG_PAGE_POOL) || \
+    (LINUX_VERSION_CODE < KERNEL_VERSION(5,15,0))
+#undef ENABLE_RX_PAGE_POOL
+#else
+#if defined(NV_NET_PAGE_POOL_H_PRESENT)
+#include <net/page_pool.h>
+#else
+#include <net/page_pool/types.h>
+#include <net/page_pool/helpers.h>
+#endif
+#endif
+#endif //ENABLE_RX_PAGE_POOL
+
 #if LINUX_VERSION_CODE < KERNEL_VERSION(3,6,0)
 #define eth_random_addr(addr) random_ether_addr(addr)
 #endif //LINUX_VERSION_CODE < KERNEL_VERSION(3,6,0)
@@ -1530,6 +1545,11 @@ struct rtl8168_private {
         u32 TxDescAllocSize;
         u32 RxDescAllocSize;
         struct sk_buff *Rx_skbuff[MAX_NUM_RX_DESC]; /* Rx data buffers */
+#ifdef ENABLE_RX_PAGE_POOL
+        struct page_pool *page_pool;
+        struct page *Rx_page[MAX_NUM_RX_DESC]; /* Rx page_pool buffers */
+        u32 Rx_page_offset[MAX_NUM_RX_DESC];
+#endif //ENABLE_RX_PAGE_POOL
         struct ring_info tx_skb[MAX_NUM_TX_DESC];   /* Tx data buffers */
         unsigned rx_buf_sz;
         struct timer_list esd_timer;
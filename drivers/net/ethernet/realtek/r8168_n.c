@@ -3705,8 +3705,9 @@ static void rtl8168_mac_loopback_test(struct rtl8168_private *tp)
 {
         struct pci_dev *pdev = tp->pci_dev;
         struct net_device *dev = tp->dev;
-        struct sk_buff *skb, *rx_skb;
+        struct sk_buff *skb;
         dma_addr_t mapping;
+        void *rx_data;
         struct TxDesc *txd;
         struct RxDesc *rxd;
         void *tmpAddr;
@@ -3723,7 +3724,11 @@ static void rtl8168_mac_loopback_test(struct rtl8168_private *tp)
         type = htons(ETH_P_IP);
         txd = tp->TxDescArray;
         rxd = tp->RxDescArray;
-        rx_skb = tp->Rx_skbuff[0];
+#ifdef ENABLE_RX_PAGE_POOL
+        rx_data = page_address(tp->Rx_page[0]) + tp->Rx_page_offset[0];
+#else
+        rx_data = tp->Rx_skbuff[0]->data;
+#endif //ENABLE_RX_PAGE_POOL
         RTL_W32(tp, TxConfig, (RTL_R32(tp, TxConfig) & ~0x00060000) | 0x00020000);
 
         do {
@@ -3772,7 +3777,7 @@ static void rtl8168_mac_loopback_test(struct rtl8168_private *tp)
 
                 if (rx_len == len) {
                         dma_sync_single_for_cpu(tp_to_dev(tp), le64_to_cpu(rxd->addr), tp->rx_buf_sz, DMA_FROM_DEVICE);
-                        i = memcmp(skb->data, rx_skb->data, rx_len);
+                        i = memcmp(skb->data, rx_data, rx_len);
                         dma_sync_single_for_device(&tp->pci_dev->dev, le64_to_cpu(rxd->addr), tp->rx_buf_sz, DMA_FROM_DEVICE);
                         if (i == 0) {
 //              dev_printk(KERN_INFO, tp_to_dev(tp), "loopback test finished\n",rx_len,len);
@@ -27296,6 +27301,12 @@ static int rtl8168_open(struct net_device *dev)
         if (!tp->RxDescArray)
                 goto err_free_all_allocated_mem;
 
+#ifdef ENABLE_RX_PAGE_POOL
+        retval = rtl8168_rx_create_page_pool(tp);
+        if (retval < 0)
+                goto err_free_all_allocated_mem;
+#endif //ENABLE_RX_PAGE_POOL
+
         retval = rtl8168_init_ring(dev);
         if (retval < 0)
                 goto err_free_all_allocated_mem;
@@ -27366,6 +27377,10 @@ out:
         return retval;
 
 err_free_all_allocated_mem:
+#ifdef ENABLE_RX_PAGE_POOL
+        rtl8168_rx_destroy_page_pool(tp);
+#endif //ENABLE_RX_PAGE_POOL
+
         if (tp->RxDescArray != NULL) {
                 dma_free_coherent(&pdev->dev,
                                   tp->RxDescAllocSize,
@@ -28599,6 +28614,15 @@ rtl8168_change_mtu(struct net_device *dev,
 
         rtl8168_down(dev);
 
+#ifdef ENABLE_RX_PAGE_POOL
+        /* the pool page order follows the new rx buffer size */
+        rtl8168_rx_destroy_page_pool(tp);
+        rtl8168_set_rxbufsize(tp, dev);
+        ret = rtl8168_rx_create_page_pool(tp);
+        if (ret < 0)
+                goto err_out;
+#endif //ENABLE_RX_PAGE_POOL
+
         spin_lock_irqsave(&tp->lock, flags);
 
         rtl8168_set_rxbufsize(tp, dev);
@@ -28642,6 +28666,7 @@ rtl8168_make_unusable_by_asic(struct RxDesc *desc)
         desc->opts1 &= ~cpu_to_le32(DescOwn | RsvdMask);
 }
 
+#ifndef ENABLE_RX_PAGE_POOL
 static void
 rtl8168_free_rx_skb(struct rtl8168_private *tp,
                     struct sk_buff **sk_buff,
@@ -28655,6 +28680,7 @@ rtl8168_free_rx_skb(struct rtl8168_private *tp,
         *sk_buff = NULL;
         rtl8168_make_unusable_by_asic(desc);
 }
+#endif //ENABLE_RX_PAGE_POOL
 
 static inline void
 rtl8168_mark_to_asic(struct RxDesc *desc,
@@ -28675,6 +28701,7 @@ rtl8168_map_to_asic(struct RxDesc *desc,
         rtl8168_mark_to_asic(desc, rx_buf_sz);
 }
 
+#ifndef ENABLE_RX_PAGE_POOL
 static int
 rtl8168_alloc_rx_skb(struct rtl8168_private *tp,
                      struct sk_buff **sk_buff,
@@ -28716,6 +28743,90 @@ err_out:
         rtl8168_make_unusable_by_asic(desc);
         goto out;
 }
+#endif //ENABLE_RX_PAGE_POOL
+
+#ifdef ENABLE_RX_PAGE_POOL
+static inline dma_addr_t
+rtl8168_rx_page_dma(struct rtl8168_private *tp,
+                    int i)
+{
+        return page_pool_get_dma_addr(tp->Rx_page[i]) + tp->Rx_page_offset[i];
+}
+
+static int
+rtl8168_alloc_rx_page(struct rtl8168_private *tp,
+                      int i)
+{
+        struct RxDesc *desc = tp->RxDescArray + i;
+        unsigned int offset;
+        struct page *page;
+
+        page = page_pool_dev_alloc_frag(tp->page_pool, &offset, tp->rx_buf_sz);
+        if (unlikely(!page)) {
+                rtl8168_make_unusable_by_asic(desc);
+                return -ENOMEM;
+        }
+
+        tp->Rx_page[i] = page;
+        tp->Rx_page_offset[i] = offset;
+        rtl8168_map_to_asic(desc, rtl8168_rx_page_dma(tp, i), tp->rx_buf_sz);
+
+        return 0;
+}
+
+static int
+rtl8168_rx_create_page_pool(struct rtl8168_private *tp)
+{
+        struct page_pool_params pp_params = { 0 };
+        int ret = 0;
+
+        pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
+#ifdef PP_FLAG_PAGE_FRAG
+        /* small frames share one pool page */
+        pp_params.flags |= PP_FLAG_PAGE_FRAG;
+#endif
+        pp_params.order = get_order(tp->rx_buf_sz);
+        pp_params.pool_size = tp->num_rx_desc;
+        pp_params.nid = dev_to_node(tp_to_dev(tp));
+        pp_params.dev = tp_to_dev(tp);
+        pp_params.dma_dir = DMA_FROM_DEVICE;
+        pp_params.offset = 0;
+        pp_params.max_len = PAGE_SIZE << pp_params.order;
+
+        tp->page_pool = page_pool_create(&pp_params);
+        if (IS_ERR(tp->page_pool)) {
+                ret = PTR_ERR(tp->page_pool);
+                tp->page_pool = NULL;
+        }
+
+        return ret;
+}
+
+/*
+ * Rx pages stay on their ring slot across rtl8168_rx_clear(), which runs
+ * under tp->lock with interrupts off where they cannot be returned to the
+ * pool. They are released here, from process context, with the pool.
+ */
+static void
+rtl8168_rx_destroy_page_pool(struct rtl8168_private *tp)
+{
+        int i;
+
+        if (!tp->page_pool)
+                return;
+
+        for (i = 0; i < tp->num_rx_desc; i++) {
+                if (!tp->Rx_page[i])
+                        continue;
+
+                page_pool_put_full_page(tp->page_pool, tp->Rx_page[i], false);
+                tp->Rx_page[i] = NULL;
+        }
+
+        page_pool_destroy(tp->page_pool);
+        tp->page_pool = NULL;
+}
+#endif //ENABLE_RX_PAGE_POOL
 
 static void
 rtl8168_rx_clear(struct rtl8168_private *tp)
@@ -28723,9 +28834,14 @@ rtl8168_rx_clear(struct rtl8168_private *tp)
         int i;
 
         for (i = 0; i < tp->num_rx_desc; i++) {
+#ifdef ENABLE_RX_PAGE_POOL
+                if (tp->Rx_page[i])
+                        rtl8168_make_unusable_by_asic(tp->RxDescArray + i);
+#else
                 if (tp->Rx_skbuff[i])
                         rtl8168_free_rx_skb(tp, tp->Rx_skbuff + i,
                                             tp->RxDescArray + i);
+#endif //ENABLE_RX_PAGE_POOL
         }
 }
 
@@ -28741,6 +28857,12 @@ rtl8168_rx_fill(struct rtl8168_private *tp,
         for (cur = start; end - cur > 0; cur++) {
                 int ret, i = cur % tp->num_rx_desc;
 
+#ifdef ENABLE_RX_PAGE_POOL
+                if (tp->Rx_page[i])
+                        continue;
+
+                ret = rtl8168_alloc_rx_page(tp, i);
+#else
                 if (tp->Rx_skbuff[i])
                         continue;
 
@@ -28748,6 +28870,7 @@ rtl8168_rx_fill(struct rtl8168_private *tp,
                                            tp->RxDescArray + i,
                                            tp->rx_buf_sz,
                                            in_intr);
+#endif //ENABLE_RX_PAGE_POOL
                 if (ret < 0)
                         break;
         }
@@ -28815,6 +28938,9 @@ static int
 rtl8168_init_ring(struct net_device *dev)
 {
         struct rtl8168_private *tp = netdev_priv(dev);
+#ifdef ENABLE_RX_PAGE_POOL
+        int i;
+#endif
 
         rtl8168_init_ring_indexes(tp);
 
@@ -28824,6 +28950,16 @@ rtl8168_init_ring(struct net_device *dev)
         rtl8168_tx_desc_init(tp);
         rtl8168_rx_desc_init(tp);
 
+#ifdef ENABLE_RX_PAGE_POOL
+        /* hand the pages kept by rtl8168_rx_clear() back to the asic */
+        for (i = 0; i < tp->num_rx_desc; i++) {
+                if (tp->Rx_page[i])
+                        rtl8168_map_to_asic(tp->RxDescArray + i,
+                                            rtl8168_rx_page_dma(tp, i),
+                                            tp->rx_buf_sz);
+        }
+#endif //ENABLE_RX_PAGE_POOL
+
         if (rtl8168_rx_fill(tp, dev, 0, tp->num_rx_desc, 0) != tp->num_rx_desc)
                 goto err_out;
 
@@ -28883,6 +29019,9 @@ rtl8168_tx_clear(struct rtl8168_private *tp)
 {
         rtl8168_tx_clear_range(tp, tp->dirty_tx, tp->num_tx_desc);
         tp->cur_tx = tp->dirty_tx = 0;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3,3,0)
+        netdev_reset_queue(tp->dev);
+#endif
 }
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(2,6,20)
@@ -29302,6 +29441,8 @@ rtl8168_start_xmit(struct sk_buff *skb,
         u32 opts[2];
         netdev_tx_t ret = NETDEV_TX_OK;
         unsigned long flags, large_send;
+        bool door_bell = true;
+        unsigned int bytes;
         int frags;
 
         spin_lock_irqsave(&tp->lock, flags);
@@ -29403,6 +29544,9 @@ rtl8168_start_xmit(struct sk_buff *skb,
                 opts[0] |= FirstFrag | LastFrag;
         }
 
+        /* the skb may be completed as soon as the first desc is handed over */
+        bytes = skb->len;
+
         opts[0] = rtl8168_get_txd_opts1(tp, opts[0], len, entry);
         mapping = dma_map_single(tp_to_dev(tp), skb->data, len, DMA_TO_DEVICE);
         if (unlikely(dma_mapping_error(tp_to_dev(tp), mapping))) {
@@ -29426,8 +29570,6 @@ rtl8168_start_xmit(struct sk_buff *skb,
 
         wmb();
 
-        RTL_W8(tp, TxPoll, NPQ);    /* set polling bit */
-
         if (!rtl8168_tx_slots_avail(tp, MAX_SKB_FRAGS)) {
                 netif_stop_queue(dev);
                 smp_rmb();
@@ -29435,6 +29577,20 @@ rtl8168_start_xmit(struct sk_buff *skb,
                         netif_wake_queue(dev);
         }
 
+        /*
+         * Defer the doorbell while the stack has more frames queued,
+         * unless BQL or a full ring has stopped the queue.
+         */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,2,0)
+        door_bell = __netdev_tx_sent_queue(netdev_get_tx_queue(dev, 0),
+                                           bytes, netdev_xmit_more());
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(3,3,0)
+        netdev_sent_queue(dev, bytes);
+#endif
+
+        if (door_bell)
+                RTL_W8(tp, TxPoll, NPQ);    /* set polling bit */
+
         spin_unlock_irqrestore(&tp->lock, flags);
 out:
         return ret;
@@ -29461,6 +29617,7 @@ rtl8168_tx_interrupt(struct net_device *dev,
                      struct rtl8168_private *tp)
 {
         unsigned int dirty_tx, tx_left;
+        unsigned int pkts_compl = 0, bytes_compl = 0;
 
         assert(dev != NULL);
         assert(tp != NULL);
@@ -29483,12 +29640,14 @@ rtl8168_tx_interrupt(struct net_device *dev,
 
                 RTLDEV->stats.tx_bytes += len;
                 RTLDEV->stats.tx_packets++;
+                bytes_compl += len;
 
                 rtl8168_unmap_tx_skb(tp->pci_dev,
                                      tx_skb,
                                      tp->TxDescArray + entry);
 
                 if (tx_skb->skb!=NULL) {
+                        pkts_compl++;
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3,14,0)
                         dev_consume_skb_any(tx_skb->skb);
 #else
@@ -29503,6 +29662,9 @@ rtl8168_tx_interrupt(struct net_device *dev,
         tp->dynamic_aspm_packet_count -= tx_left;
 
         if (tp->dirty_tx != dirty_tx) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(3,3,0)
+                netdev_completed_queue(dev, pkts_compl, bytes_compl);
+#endif
                 tp->dirty_tx = dirty_tx;
                 smp_wmb();
                 if (netif_queue_stopped(dev) &&
@@ -29598,6 +29760,53 @@ rtl8168_rx_skb(struct rtl8168_private *tp,
 #endif
 }
 
+#ifdef ENABLE_RX_PAGE_POOL
+static void
+rtl8168_rx_page(struct rtl8168_private *tp,
+                struct net_device *dev,
+                struct RxDesc *desc,
+                unsigned int entry,
+                int pkt_size)
+{
+        struct page *page = tp->Rx_page[entry];
+        u32 offset = tp->Rx_page_offset[entry];
+        struct sk_buff *skb;
+        u8 *data;
+
+        dma_sync_single_range_for_cpu(tp_to_dev(tp),
+                                      page_pool_get_dma_addr(page), offset,
+                                      pkt_size, DMA_FROM_DEVICE);
+
+        skb = napi_get_frags(&tp->napi);
+        if (unlikely(!skb)) {
+                RTLDEV->stats.rx_dropped++;
+                rtl8168_mark_to_asic(desc, tp->rx_buf_sz);
+                return;
+        }
+
+        data = page_address(page) + offset;
+        prefetch(data);
+        if (is_multicast_ether_addr(data) && !is_broadcast_ether_addr(data))
+                RTLDEV->stats.multicast++;
+
+        tp->Rx_page[entry] = NULL;
+        skb_add_rx_frag(skb, 0, page, offset, pkt_size, tp->rx_buf_sz);
+        /* the page goes back to tp->page_pool when the skb is freed */
+        skb_mark_for_recycle(skb);
+
+        if (tp->cp_cmd & RxChkSum)
+                rtl8168_rx_csum(tp, skb, desc);
+
+        rtl8168_rx_vlan_skb(tp, desc, skb);
+
+        /* eth_type_trans() is done by napi_gro_frags() on the frag head */
+        napi_gro_frags(&tp->napi);
+
+        RTLDEV->stats.rx_bytes += pkt_size;
+        RTLDEV->stats.rx_packets++;
+}
+#endif //ENABLE_RX_PAGE_POOL
+
 static int
 rtl8168_rx_interrupt(struct net_device *dev,
                      struct rtl8168_private *tp,
@@ -29648,7 +29857,9 @@ rtl8168_rx_interrupt(struct net_device *dev,
 
                         rtl8168_mark_to_asic(desc, tp->rx_buf_sz);
                 } else {
+#ifndef ENABLE_RX_PAGE_POOL
                         struct sk_buff *skb;
+#endif
                         int pkt_size;
 
 process_pkt:
@@ -29669,6 +29880,9 @@ process_pkt:
                                 continue;
                         }
 
+#ifdef ENABLE_RX_PAGE_POOL
+                        rtl8168_rx_page(tp, dev, desc, entry, pkt_size);
+#else
                         skb = tp->Rx_skbuff[entry];
 
                         dma_sync_single_for_cpu(tp_to_dev(tp),
@@ -29702,6 +29916,7 @@ process_pkt:
 #endif //LINUX_VERSION_CODE < KERNEL_VERSION(4,11,0)
                         RTLDEV->stats.rx_bytes += pkt_size;
                         RTLDEV->stats.rx_packets++;
+#endif //ENABLE_RX_PAGE_POOL
                 }
 
                 cur_rx++;
@@ -30035,6 +30250,10 @@ static int rtl8168_close(struct net_device *dev)
 
                 free_irq(tp->irq, dev);
 
+#ifdef ENABLE_RX_PAGE_POOL
+                rtl8168_rx_destroy_page_pool(tp);
+#endif //ENABLE_RX_PAGE_POOL
+
                 dma_free_coherent(&pdev->dev,
                                   tp->RxDescAllocSize,
                                   tp->RxDescArray,
@@ -3893,6 +3893,10 @@ void rtw_init_xmitframe(struct xmit_frame *pxframe)
 
 		pxframe->frame_tag = DATA_FRAMETAG;
 
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+		pxframe->xmit_more = 0;
+#endif
+
 #ifdef CONFIG_USB_HCI
 		pxframe->pkt = NULL;
 #ifdef USB_PACKET_OFFSET_SZ
@@ -5189,6 +5193,10 @@ s32 rtw_xmit(_adapter *padapter, _pkt **ppkt, u16 os_qid)
 		return -1;
 	}
 
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+	pxmitframe->xmit_more = rtw_os_xmit_more(*ppkt);
+#endif
+
 #ifdef CONFIG_BR_EXT
 	if (!adapter_use_wds(padapter) && check_fwstate(&padapter->mlmepriv, WIFI_STATION_STATE | WIFI_ADHOC_STATE) == _TRUE) {
 		void *br_port = NULL;
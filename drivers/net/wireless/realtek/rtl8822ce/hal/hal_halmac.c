@@ -3747,6 +3747,64 @@ exit:
 	return err;
 }
 
+#ifdef CONFIG_RTW_REQUEST_FW
+/*
+ * Get FW image @name from the kernel firmware loader. halmac only reads the
+ * image, so it is used in place without a copy.
+ */
+static int _halmac_request_fw(struct dvobj_priv *d, const char *name,
+			      u8 **fw, u32 *size, void **fw_priv)
+{
+	const u8 *data = NULL;
+	u32 fwmaxsize = 0;
+	int err;
+
+
+	err = rtw_halmac_get_fw_max_size(d, &fwmaxsize);
+	if (err) {
+		RTW_ERR("%s: Fail to get Firmware MAX size(err=%d)\n", __FUNCTION__, err);
+		return -1;
+	}
+
+	err = rtw_request_firmware(dvobj_to_dev(d), name, &data, size, fw_priv);
+	if (err)
+		return -1;
+
+	if (!*size || *size > fwmaxsize) {
+		RTW_ERR("%s: %s invalid size %u(max %u)\n",
+			__FUNCTION__, name, *size, fwmaxsize);
+		rtw_release_firmware(*fw_priv);
+		return -1;
+	}
+
+	*fw = (u8 *)data;
+
+	return 0;
+}
+
+/*
+ * Notices:
+ *	Same as rtw_halmac_init_hal_fw_file().
+ */
+int rtw_halmac_init_hal_fw_request(struct dvobj_priv *d, const char *name)
+{
+	u8 *fw = NULL;
+	u32 size = 0;
+	void *fw_priv = NULL;
+	int err;
+
+
+	err = _halmac_request_fw(d, name, &fw, &size, &fw_priv);
+	if (err)
+		return -1;
+
+	err = _halmac_init_hal(d, fw, size);
+	rtw_release_firmware(fw_priv);
+
+	return err;
+}
+#endif /* CONFIG_RTW_REQUEST_FW */
+
 int rtw_halmac_deinit_hal(struct dvobj_priv *d)
 {
 	PADAPTER adapter;
@@ -4060,6 +4118,26 @@ int rtw_halmac_dlfw_from_file(struct dvobj_priv *d, u8 *fwpath)
 	return err;
 }
 
+#ifdef CONFIG_RTW_REQUEST_FW
+int rtw_halmac_dlfw_request(struct dvobj_priv *d, const char *name)
+{
+	u8 *fw = NULL;
+	u32 size = 0;
+	void *fw_priv = NULL;
+	int err;
+
+
+	err = _halmac_request_fw(d, name, &fw, &size, &fw_priv);
+	if (err)
+		return -1;
+
+	err = rtw_halmac_dlfw(d, fw, size);
+	rtw_release_firmware(fw_priv);
+
+	return err;
+}
+#endif /* CONFIG_RTW_REQUEST_FW */
+
 /*
  * Description:
  *	Power on/off BB/RF domain.
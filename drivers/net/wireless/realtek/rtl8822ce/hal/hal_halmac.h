@@ -168,11 +168,17 @@ int rtw_halmac_poweroff(struct dvobj_priv *);
 int rtw_halmac_init_hal(struct dvobj_priv *);
 int rtw_halmac_init_hal_fw(struct dvobj_priv *, u8 *fw, u32 fwsize);
 int rtw_halmac_init_hal_fw_file(struct dvobj_priv *, u8 *fwpath);
+#ifdef CONFIG_RTW_REQUEST_FW
+int rtw_halmac_init_hal_fw_request(struct dvobj_priv *, const char *name);
+#endif /* CONFIG_RTW_REQUEST_FW */
 int rtw_halmac_deinit_hal(struct dvobj_priv *);
 int rtw_halmac_self_verify(struct dvobj_priv *);
 int rtw_halmac_txfifo_wait_empty(struct dvobj_priv *d, u32 timeout);
 int rtw_halmac_dlfw(struct dvobj_priv *, u8 *fw, u32 fwsize);
 int rtw_halmac_dlfw_from_file(struct dvobj_priv *, u8 *fwpath);
+#ifdef CONFIG_RTW_REQUEST_FW
+int rtw_halmac_dlfw_request(struct dvobj_priv *, const char *name);
+#endif /* CONFIG_RTW_REQUEST_FW */
 int rtw_halmac_dlfw_mem(struct dvobj_priv *d, u8 *fw, u32 fwsize, enum fw_mem mem);
 int rtw_halmac_dlfw_mem_from_file(struct dvobj_priv *d, u8 *fwpath, enum fw_mem mem);
 int rtw_halmac_phy_power_switch(struct dvobj_priv *, u8 enable);
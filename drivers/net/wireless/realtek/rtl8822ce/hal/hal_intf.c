@@ -875,6 +875,14 @@ s32	rtw_hal_xmit(_adapter *padapter, struct xmit_frame *pxmitframe)
 	return padapter->hal_func.hal_xmit(padapter, pxmitframe);
 }
 
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+void	rtw_hal_xmit_kick(_adapter *padapter)
+{
+	if (padapter->hal_func.hal_xmit_kick)
+		padapter->hal_func.hal_xmit_kick(padapter);
+}
+#endif
+
 /*
  * [IMPORTANT] This function would be run in interrupt context.
  */
@@ -1222,6 +1230,22 @@ s32 rtw_hal_recv_hdl(_adapter *adapter)
 }
 #endif
 
+#ifdef CONFIG_RTW_NAPI_PCI_RX
+/* return -1 if the HAL does not drain its rx ring from NAPI */
+s32 rtw_hal_rx_napi_poll(_adapter *adapter, int budget)
+{
+	if (adapter->hal_func.rx_napi_poll)
+		return adapter->hal_func.rx_napi_poll(adapter, budget);
+	return -1;
+}
+
+void rtw_hal_rx_napi_complete(_adapter *adapter)
+{
+	if (adapter->hal_func.rx_napi_complete)
+		adapter->hal_func.rx_napi_complete(adapter);
+}
+#endif
+
 void rtw_hal_notch_filter(_adapter *adapter, bool enable)
 {
 	if (adapter->hal_func.hal_notch_filter)
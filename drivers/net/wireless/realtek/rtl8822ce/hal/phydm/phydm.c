@@ -272,6 +272,9 @@ void phydm_common_info_self_init(struct dm_struct *dm)
 
 	dm->phydm_sys_up_time = 0;
 
+	odm_memory_set(dm, &dm->wd_ctrl, 0, sizeof(struct phydm_wd_ctrl));
+	dm->wd_ctrl.chg_detect_en = true;
+
 	if (dm->support_ic_type & ODM_IC_1SS)
 		dm->num_rf_path = 1;
 	else if (dm->support_ic_type & ODM_IC_2SS)
@@ -2404,10 +2407,72 @@ u8 phydm_stop_dm_watchdog_check(void *dm_void)
 	}
 }
 
+/*@
+ * Change detection: once link state, client number, channel, traffic load,
+ * rssi_min and the false alarm count stayed put for PHYDM_WD_STABLE_TH
+ * periods, DIG/CCK_PD, CCX, RA, CFO tracking and antenna diversity only run
+ * every PHYDM_WD_SLOW_PERIOD periods. Any change resumes them right away.
+ * FA counters are still read every period since they are reset on read
+ * and feed the detection itself.
+ */
+void phydm_wd_chg_detect(struct dm_struct *dm)
+{
+	struct phydm_wd_ctrl *wd = &dm->wd_ctrl;
+	struct phydm_fa_struct *fa_t = &dm->false_alm_cnt;
+	boolean is_stable = true;
+
+	if (!wd->chg_detect_en || dm->is_link_in_process ||
+	    dm->first_connect || dm->first_disconnect)
+		is_stable = false;
+	else if (dm->is_linked != wd->pre_is_linked ||
+		 dm->number_linked_client != wd->pre_num_linked ||
+		 *dm->channel != wd->pre_channel ||
+		 dm->traffic_load != wd->pre_traffic_load)
+		is_stable = false;
+	else if (DIFF_2(dm->rssi_min, wd->pre_rssi_min) >
+		 PHYDM_WD_RSSI_DIFF_TH ||
+		 DIFF_2(fa_t->cnt_all, wd->pre_fa_cnt) > PHYDM_WD_FA_DIFF_TH)
+		is_stable = false;
+
+	wd->pre_is_linked = dm->is_linked;
+	wd->pre_num_linked = dm->number_linked_client;
+	wd->pre_channel = *dm->channel;
+	wd->pre_traffic_load = dm->traffic_load;
+	wd->pre_rssi_min = dm->rssi_min;
+	wd->pre_fa_cnt = fa_t->cnt_all;
+
+	if (!is_stable) {
+		wd->stable_cnt = 0;
+		wd->slow_cnt = 0;
+		wd->is_slow = false;
+	} else {
+		if (wd->stable_cnt < PHYDM_WD_STABLE_TH)
+			wd->stable_cnt++;
+
+		if (wd->stable_cnt < PHYDM_WD_STABLE_TH) {
+			wd->is_slow = false;
+		} else {
+			wd->slow_cnt++;
+			wd->is_slow = (wd->slow_cnt % PHYDM_WD_SLOW_PERIOD) != 0;
+		}
+	}
+
+	if (wd->is_slow)
+		wd->skip_cnt++;
+	else
+		wd->run_cnt++;
+
+	PHYDM_DBG(dm, DBG_COMMON_FLOW, "[WD] stable_cnt=%d, is_slow=%d\n",
+		  wd->stable_cnt, wd->is_slow);
+}
+
 void phydm_watchdog(struct dm_struct *dm)
 {
+	struct phydm_wd_ctrl *wd = &dm->wd_ctrl;
+
 	PHYDM_DBG(dm, DBG_COMMON_FLOW, "%s ======>\n", __func__);
 
+	phydm_wd_cost_start(dm);
 	phydm_common_info_self_update(dm);
 	phydm_phy_info_update(dm);
 	phydm_rssi_monitor_check(dm);
@@ -2422,30 +2487,44 @@ void phydm_watchdog(struct dm_struct *dm)
 		return;
 
 	phydm_hw_setting(dm);
-
-	phydm_env_mntr_result_watchdog(dm);
+	phydm_wd_cost_mark(dm, PHYDM_WD_COST_COMMON);
 
 #ifdef PHYDM_TDMA_DIG_SUPPORT
 	if (dm->original_dig_restore == 0) {
+		wd->is_slow = false;
+		phydm_env_mntr_result_watchdog(dm);
+		phydm_wd_cost_mark(dm, PHYDM_WD_COST_CCX);
 		phydm_tdma_dig_timer_check(dm);
+		phydm_wd_cost_mark(dm, PHYDM_WD_COST_DIG);
 	} else
 #endif
 	{
 		phydm_false_alarm_counter_statistics(dm);
+		phydm_wd_cost_mark(dm, PHYDM_WD_COST_FA);
+		phydm_wd_chg_detect(dm);
+
+		if (!wd->is_slow) {
+			phydm_env_mntr_result_watchdog(dm);
+			phydm_wd_cost_mark(dm, PHYDM_WD_COST_CCX);
+		}
+
 	#if (ODM_IC_11N_SERIES_SUPPORT || ODM_IC_11AC_SERIES_SUPPORT)
 		if (dm->support_ic_type & (ODM_IC_11N_SERIES |
 					   ODM_IC_11AC_SERIES))
 			phydm_noisy_detection(dm);
 	#endif
 
+		if (!wd->is_slow) {
 	#if defined(PHYDM_DCC_ENHANCE) && defined(PHYDM_SUPPORT_CCKPD)
-		phydm_dig_cckpd_coex(dm);
+			phydm_dig_cckpd_coex(dm);
 	#else
-		phydm_dig(dm);
+			phydm_dig(dm);
 		#ifdef PHYDM_SUPPORT_CCKPD
-		phydm_cck_pd_th(dm);
+			phydm_cck_pd_th(dm);
 		#endif
 	#endif
+		}
+		phydm_wd_cost_mark(dm, PHYDM_WD_COST_DIG);
 	}
 
 #ifdef PHYDM_HW_IGI
@@ -2454,17 +2533,30 @@ void phydm_watchdog(struct dm_struct *dm)
 #ifdef PHYDM_POWER_TRAINING_SUPPORT
 	phydm_update_power_training_state(dm);
 #endif
+	phydm_wd_cost_mark(dm, PHYDM_WD_COST_OTHER);
 	phydm_adaptivity(dm);
-	phydm_ra_info_watchdog(dm);
+	phydm_wd_cost_mark(dm, PHYDM_WD_COST_ADAPTIVITY);
+	if (!wd->is_slow) {
+		phydm_ra_info_watchdog(dm);
+		phydm_wd_cost_mark(dm, PHYDM_WD_COST_RA);
+	}
 #ifdef CONFIG_PATH_DIVERSITY
 	phydm_tx_path_diversity(dm);
 #endif
-	phydm_cfo_tracking(dm);
+	phydm_wd_cost_mark(dm, PHYDM_WD_COST_OTHER);
+	if (!wd->is_slow) {
+		phydm_cfo_tracking(dm);
+		phydm_wd_cost_mark(dm, PHYDM_WD_COST_CFO);
+	}
 #ifdef CONFIG_DYNAMIC_TX_TWR
 	phydm_dynamic_tx_power(dm);
+	phydm_wd_cost_mark(dm, PHYDM_WD_COST_OTHER);
 #endif
 #ifdef CONFIG_PHYDM_ANTENNA_DIVERSITY
-	odm_antenna_diversity(dm);
+	if (!wd->is_slow) {
+		odm_antenna_diversity(dm);
+		phydm_wd_cost_mark(dm, PHYDM_WD_COST_ANTDIV);
+	}
 #endif
 #ifdef CONFIG_ADAPTIVE_SOML
 	phydm_adaptive_soml(dm);
@@ -2473,8 +2565,10 @@ void phydm_watchdog(struct dm_struct *dm)
 #ifdef PHYDM_BEAMFORMING_VERSION1
 	phydm_beamforming_watchdog(dm);
 #endif
+	phydm_wd_cost_mark(dm, PHYDM_WD_COST_OTHER);
 
 	halrf_watchdog(dm);
+	phydm_wd_cost_mark(dm, PHYDM_WD_COST_HALRF);
 #ifdef PHYDM_PRIMARY_CCA
 	phydm_primary_cca(dm);
 #endif
@@ -2484,8 +2578,12 @@ void phydm_watchdog(struct dm_struct *dm)
 #if (DM_ODM_SUPPORT_TYPE == ODM_CE)
 	odm_dtc(dm);
 #endif
+	phydm_wd_cost_mark(dm, PHYDM_WD_COST_OTHER);
 
-	phydm_env_mntr_set_watchdog(dm);
+	if (!wd->is_slow) {
+		phydm_env_mntr_set_watchdog(dm);
+		phydm_wd_cost_mark(dm, PHYDM_WD_COST_CCX);
+	}
 
 #ifdef PHYDM_LNA_SAT_CHK_SUPPORT
 	phydm_lna_sat_chk_watchdog(dm);
@@ -2500,6 +2598,7 @@ void phydm_watchdog(struct dm_struct *dm)
 #endif
 
 	phydm_common_info_self_reset(dm);
+	phydm_wd_cost_mark(dm, PHYDM_WD_COST_OTHER);
 }
 
 void phydm_fw_dm_ctrl_en(void *dm_void, enum phydm_func_idx fun_idx,
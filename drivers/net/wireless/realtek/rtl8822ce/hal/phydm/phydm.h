@@ -131,6 +131,12 @@ extern const u16	phy_rate_table[84];
 
 #define	NONE				0
 
+/*@watchdog change detection*/
+#define PHYDM_WD_STABLE_TH		3	/*@stable periods to slow down*/
+#define PHYDM_WD_SLOW_PERIOD		4	/*@run dym mech every N periods*/
+#define PHYDM_WD_RSSI_DIFF_TH		3	/*@dB*/
+#define PHYDM_WD_FA_DIFF_TH		300
+
 #if defined(DM_ODM_CE_MAC80211)
 #define MAX_2(x, y)					\
 	__max2(typeof(x), typeof(y),			\
@@ -389,6 +395,39 @@ struct odm_phy_dbg_info {
 	struct phydm_phystatus_avg		phystatus_statistic_avg;
 };
 
+enum phydm_wd_cost_idx {
+	PHYDM_WD_COST_COMMON	= 0,	/*@info update, rssi, dbg msg*/
+	PHYDM_WD_COST_FA	= 1,
+	PHYDM_WD_COST_DIG	= 2,	/*@DIG, CCK_PD*/
+	PHYDM_WD_COST_ADAPTIVITY = 3,
+	PHYDM_WD_COST_RA	= 4,
+	PHYDM_WD_COST_CFO	= 5,
+	PHYDM_WD_COST_ANTDIV	= 6,
+	PHYDM_WD_COST_HALRF	= 7,
+	PHYDM_WD_COST_CCX	= 8,	/*@env_mntr: NHM, CLM, FAHM*/
+	PHYDM_WD_COST_OTHER	= 9,
+	PHYDM_WD_COST_NUM	= 10
+};
+
+struct phydm_wd_ctrl {
+	boolean			chg_detect_en;
+	boolean			is_slow;	/*@skip dym mech this period*/
+	u8			stable_cnt;
+	u8			slow_cnt;
+	boolean			pre_is_linked;
+	u8			pre_num_linked;
+	u8			pre_rssi_min;
+	u8			pre_traffic_load;
+	u8			pre_channel;
+	u32			pre_fa_cnt;
+	u32			run_cnt;
+	u32			skip_cnt;
+	/*@CPU time per mechanism, us*/
+	u64			cost_start;
+	u64			cost_us[PHYDM_WD_COST_NUM];
+	u32			cost_max_us[PHYDM_WD_COST_NUM];
+};
+
 enum odm_cmninfo {
 	/*@Fixed value*/
 	/*@-----------HOOK BEFORE REG INIT-----------*/
@@ -1257,6 +1296,7 @@ struct dm_struct {
 #endif
 	struct odm_noise_monitor	noise_level;
 	struct odm_phy_dbg_info		phy_dbg_info;
+	struct phydm_wd_ctrl		wd_ctrl;
 #if (DM_ODM_SUPPORT_TYPE & ODM_WIN)
 	struct odm_phy_dbg_info		phy_dbg_info_win_bkp;
 #endif
@@ -1491,6 +1531,9 @@ phydm_supportability_en(void *dm_void, char input[][16], u32 *_used,
 void
 phydm_pause_dm_watchdog(void *dm_void, enum phydm_pause_type pause_type);
 
+void
+phydm_wd_chg_detect(struct dm_struct *dm);
+
 void
 phydm_watchdog(struct dm_struct *dm);
 
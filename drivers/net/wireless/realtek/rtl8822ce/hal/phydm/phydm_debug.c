@@ -2605,6 +2605,27 @@ void phydm_dm_summary(void *dm_void, u8 macid)
 #endif
 }
 
+void phydm_wd_cost_start(void *dm_void)
+{
+	struct dm_struct *dm = (struct dm_struct *)dm_void;
+
+	dm->wd_ctrl.cost_start = odm_get_current_time_us(dm);
+}
+
+/*@Charge the time since the last mark to the mechanism "idx"*/
+void phydm_wd_cost_mark(void *dm_void, enum phydm_wd_cost_idx idx)
+{
+	struct dm_struct *dm = (struct dm_struct *)dm_void;
+	struct phydm_wd_ctrl *wd = &dm->wd_ctrl;
+	u64 now = odm_get_current_time_us(dm);
+	u32 cost = (u32)(now - wd->cost_start);
+
+	wd->cost_us[idx] += cost;
+	if (cost > wd->cost_max_us[idx])
+		wd->cost_max_us[idx] = cost;
+	wd->cost_start = now;
+}
+
 void phydm_basic_dbg_message(void *dm_void)
 {
 	struct dm_struct *dm = (struct dm_struct *)dm_void;
@@ -4711,6 +4732,59 @@ void phydm_dd_dbg_dump(void *dm_void, char input[][16], u32 *_used,
 	}
 }
 
+void phydm_wd_cost_dbg(void *dm_void, char input[][16], u32 *_used,
+		       char *output, u32 *_out_len)
+{
+	struct dm_struct *dm = (struct dm_struct *)dm_void;
+	struct phydm_wd_ctrl *wd = &dm->wd_ctrl;
+	char help[] = "-h";
+	char *name[PHYDM_WD_COST_NUM] = {"common", "fa_cnt", "dig", "adaptivity",
+					 "ra", "cfo", "antdiv", "halrf", "ccx",
+					 "other"};
+	u32 var1[10] = {0};
+	u32 used = *_used;
+	u32 out_len = *_out_len;
+	u32 rounds = wd->run_cnt + wd->skip_cnt;
+	u8 i = 0;
+
+	PHYDM_SSCANF(input[1], DCMD_DECIMAL, &var1[0]);
+	PHYDM_SSCANF(input[2], DCMD_DECIMAL, &var1[1]);
+
+	if ((strcmp(input[1], help) == 0)) {
+		PDM_SNPF(out_len, used, output + used, out_len - used,
+			 "show: {0}, reset: {1}, chg_detect: {2} {en}\n");
+	} else if (var1[0] == 1) {
+		odm_memory_set(dm, wd->cost_us, 0, sizeof(wd->cost_us));
+		odm_memory_set(dm, wd->cost_max_us, 0,
+			       sizeof(wd->cost_max_us));
+		wd->run_cnt = 0;
+		wd->skip_cnt = 0;
+		PDM_SNPF(out_len, used, output + used, out_len - used,
+			 "reset cost\n");
+	} else if (var1[0] == 2) {
+		wd->chg_detect_en = (boolean)var1[1];
+		wd->stable_cnt = 0;
+		PDM_SNPF(out_len, used, output + used, out_len - used,
+			 "chg_detect_en=%d\n", wd->chg_detect_en);
+	} else {
+		PDM_SNPF(out_len, used, output + used, out_len - used,
+			 "chg_detect_en=%d stable_cnt=%d run=%d skip=%d\n",
+			 wd->chg_detect_en, wd->stable_cnt, wd->run_cnt,
+			 wd->skip_cnt);
+		for (i = 0; i < PHYDM_WD_COST_NUM; i++) {
+			PDM_SNPF(out_len, used, output + used, out_len - used,
+				 "%-12s: total=%llu us, avg=%llu us, max=%u us\n",
+				 name[i], wd->cost_us[i],
+				 (rounds == 0) ? 0 :
+				 phydm_division64(wd->cost_us[i], rounds),
+				 wd->cost_max_us[i]);
+		}
+	}
+
+	*_used = used;
+	*_out_len = out_len;
+}
+
 void phydm_nss_hitogram_mp(void *dm_void, enum PDM_RATE_TYPE rate_type,
 			   u32 *_used, char *output, u32 *_out_len)
 {
@@ -5327,7 +5401,8 @@ enum PHYDM_CMD_ID {
 	PHYDM_IFS_CLM,
 	PHYDM_ENHANCE_MNTR,
 	PHYDM_CSI_DBG,
-	PHYDM_EDCCA_CLM
+	PHYDM_EDCCA_CLM,
+	PHYDM_WD_COST
 };
 
 struct phydm_command phy_dm_ary[] = {
@@ -5403,7 +5478,8 @@ struct phydm_command phy_dm_ary[] = {
 	{"ifs_clm", PHYDM_IFS_CLM},
 	{"enh_mntr", PHYDM_ENHANCE_MNTR},
 	{"csi_dbg", PHYDM_CSI_DBG},
-	{"edcca_clm", PHYDM_EDCCA_CLM}
+	{"edcca_clm", PHYDM_EDCCA_CLM},
+	{"wd_cost", PHYDM_WD_COST}
 	};
 
 #endif /*@#ifdef CONFIG_PHYDM_DEBUG_FUNCTION*/
@@ -5810,6 +5886,9 @@ void phydm_cmd_parser(struct dm_struct *dm, char input[][MAX_ARGV],
 		phydm_edcca_clm_dbg(dm, input, &used, output, &out_len);
 	#endif
 		break;
+	case PHYDM_WD_COST:
+		phydm_wd_cost_dbg(dm, input, &used, output, &out_len);
+		break;
 	default:
 		PDM_SNPF(out_len, used, output + used, out_len - used,
 			 "Do not support this command\n");
@@ -446,6 +446,10 @@ void phydm_get_phy_statistic(void *dm_void);
 
 void phydm_dm_summary(void *dm_void, u8 macid);
 
+void phydm_wd_cost_start(void *dm_void);
+
+void phydm_wd_cost_mark(void *dm_void, enum phydm_wd_cost_idx idx);
+
 void phydm_basic_dbg_message(void *dm_void);
 
 void phydm_basic_profile(void *dm_void, u32 *_used, char *output,
@@ -337,6 +337,7 @@ void phydm_fa_cnt_statistics_jgr3(void *dm_void)
 	struct dm_struct *dm = (struct dm_struct *)dm_void;
 	struct phydm_fa_struct *fa_t = &dm->false_alm_cnt;
 	u32 ret_value = 0;
+	u32 reg_2d10 = 0;
 	u32 cck_enable = 0;
 
 	if (!(dm->support_ic_type & ODM_IC_JGR3_SERIES))
@@ -360,8 +361,9 @@ void phydm_fa_cnt_statistics_jgr3(void *dm_void)
 	fa_t->cnt_rate_illegal = ret_value & 0xffff;
 	fa_t->cnt_crc8_fail = (ret_value & 0xffff0000) >> 16;
 
-	ret_value = odm_get_bb_reg(dm, R_0x2d10, MASKDWORD);
-	fa_t->cnt_mcs_fail = ret_value & 0xffff;
+	/* 0x2d10 holds both the HT and VHT MCS fail counters */
+	reg_2d10 = odm_get_bb_reg(dm, R_0x2d10, MASKDWORD);
+	fa_t->cnt_mcs_fail = reg_2d10 & 0xffff;
 
 	/* read CCK CRC32 counter */
 	if (dm->support_ic_type & ODM_RTL8723F)
@@ -404,8 +406,7 @@ void phydm_fa_cnt_statistics_jgr3(void *dm_void)
 		fa_t->cnt_vht2_crc32_ok = ret_value & 0xffff;
 		fa_t->cnt_vht2_crc32_error = (ret_value & 0xffff0000) >> 16;
 
-		ret_value = odm_get_bb_reg(dm, R_0x2d10, MASKDWORD);
-		fa_t->cnt_mcs_fail_vht = (ret_value & 0xffff0000) >> 16;
+		fa_t->cnt_mcs_fail_vht = (reg_2d10 & 0xffff0000) >> 16;
 
 		ret_value = odm_get_bb_reg(dm, R_0x2d0c, MASKDWORD);
 		fa_t->cnt_crc8_fail_vhta = ret_value & 0xffff;
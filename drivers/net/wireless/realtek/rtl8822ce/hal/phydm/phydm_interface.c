@@ -1148,6 +1148,20 @@ u64 odm_get_progressing_time(struct dm_struct *dm, u64 start_time)
 #endif
 }
 
+/*@Monotonic time in us, 0 where the platform has no fine clock*/
+u64 odm_get_current_time_us(struct dm_struct *dm)
+{
+#if (DM_ODM_SUPPORT_TYPE & ODM_CE) && defined(DM_ODM_CE_MAC80211)
+	return div_u64(ktime_get_ns(), 1000);
+#elif (DM_ODM_SUPPORT_TYPE & ODM_CE) && defined(DM_ODM_CE_MAC80211_V2)
+	return div_u64(ktime_get_ns(), 1000);
+#elif (DM_ODM_SUPPORT_TYPE & ODM_CE)
+	return (u64)rtw_sptime_to_us(rtw_sptime_get());
+#else
+	return 0;
+#endif
+}
+
 #if (DM_ODM_SUPPORT_TYPE & (ODM_WIN | ODM_CE)) && \
 	(!defined(DM_ODM_CE_MAC80211) && !defined(DM_ODM_CE_MAC80211_V2))
 
@@ -270,6 +270,7 @@ u8 phydm_c2H_content_parsing(void *dm_void, u8 c2h_cmd_id, u8 c2h_cmd_len,
 
 u64 odm_get_current_time(struct dm_struct *dm);
 u64 odm_get_progressing_time(struct dm_struct *dm, u64 start_time);
+u64 odm_get_current_time_us(struct dm_struct *dm);
 
 #if (DM_ODM_SUPPORT_TYPE & (ODM_WIN | ODM_CE)) && \
 	(!defined(DM_ODM_CE_MAC80211) && !defined(DM_ODM_CE_MAC80211_V2))
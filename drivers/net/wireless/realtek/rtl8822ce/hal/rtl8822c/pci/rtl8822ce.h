@@ -123,6 +123,9 @@ s32 rtl8822ce_hal_xmit(PADAPTER, struct xmit_frame *);
 s32 rtl8822ce_hal_mgmt_xmitframe_enqueue(PADAPTER, struct xmit_frame *);
 #endif
 s32 rtl8822ce_hal_xmitframe_enqueue(PADAPTER, struct xmit_frame *);
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+void rtl8822ce_xmit_kick(PADAPTER);
+#endif
 
 #ifdef CONFIG_XMIT_THREAD_MODE
 	s32 rtl8822ce_xmit_buf_handler(PADAPTER);
@@ -136,6 +139,10 @@ void rtl8822ce_hci_flush(PADAPTER Adapter, u32 queue);
 /* rtl8822cs_recv.c */
 s32 rtl8822ce_init_recv_priv(PADAPTER);
 void rtl8822ce_free_recv_priv(PADAPTER);
+#ifdef CONFIG_RTW_NAPI_PCI_RX
+s32 rtl8822ce_rx_napi_poll(PADAPTER, int budget);
+void rtl8822ce_rx_napi_complete(PADAPTER);
+#endif
 int rtl8822ce_init_rxbd_ring(PADAPTER);
 void rtl8822ce_free_rxbd_ring(PADAPTER);
 
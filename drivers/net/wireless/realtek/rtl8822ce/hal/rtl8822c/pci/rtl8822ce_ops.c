@@ -364,6 +364,14 @@ static void rtl8822ce_rx_handler(PADAPTER Adapter, u32 handled[])
 		pHalData->IntrMask[1] &= (~(BIT_FOVW_MSK | BIT_RXERR_MSK));
 		rtw_write32(Adapter, REG_HIMR0, pHalData->IntrMask[0]);
 		rtw_write32(Adapter, REG_HIMR1, pHalData->IntrMask[1]);
+#ifdef CONFIG_RTW_NAPI_PCI_RX
+		/* rx ring is drained from NAPI once the netdev enabled it */
+		if (Adapter->registrypriv.en_napi &&
+		    Adapter->napi_state == NAPI_ENABLE) {
+			Adapter->recvpriv.napi_rx_sched = _TRUE;
+			napi_schedule(&Adapter->napi);
+		} else
+#endif
 		tasklet_hi_schedule(&Adapter->recvpriv.recv_tasklet);
 		handled[0] |= pHalData->IntArray[0] & (BIT_RXOK | BIT_RDU);
 		handled[1] |= pHalData->IntArray[1] & (BIT_FOVW | BIT_RXERR_INT);
@@ -874,6 +882,10 @@ void rtl8822ce_set_hal_ops(PADAPTER padapter)
 	ops->free_xmit_priv = rtl8822ce_free_xmit_priv;
 	ops->init_recv_priv = rtl8822ce_init_recv_priv;
 	ops->free_recv_priv = rtl8822ce_free_recv_priv;
+#ifdef CONFIG_RTW_NAPI_PCI_RX
+	ops->rx_napi_poll = rtl8822ce_rx_napi_poll;
+	ops->rx_napi_complete = rtl8822ce_rx_napi_complete;
+#endif
 
 #ifdef CONFIG_RTW_SW_LED
 	ops->InitSwLeds = rtl8822ce_InitSwLeds;
@@ -908,6 +920,9 @@ void rtl8822ce_set_hal_ops(PADAPTER padapter)
 	ops->hal_mgmt_xmitframe_enqueue = rtl8822ce_hal_mgmt_xmitframe_enqueue;
 #endif
 	ops->hal_xmitframe_enqueue = rtl8822ce_hal_xmitframe_enqueue;
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+	ops->hal_xmit_kick = rtl8822ce_xmit_kick;
+#endif
 #ifdef CONFIG_HOSTAPD_MLME
 	ops->hostap_mgnt_xmit_entry = rtl8822ce_hostap_mgnt_xmit_entry;
 #endif
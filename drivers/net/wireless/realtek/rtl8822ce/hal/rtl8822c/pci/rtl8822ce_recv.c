@@ -152,7 +152,11 @@ static u16 rtl8822ce_check_rxdesc_remain(_adapter *padapter, int rx_queue_idx)
 	return num_rxdesc_to_handle;
 }
 
-static void rtl8822ce_rx_mpdu(_adapter *padapter)
+/*
+ * Handle at most budget rx descriptors
+ *	return value: number of rx descriptors handled
+ */
+static int rtl8822ce_rx_mpdu(_adapter *padapter, int budget)
 {
 	struct recv_priv *r_priv = &padapter->recvpriv;
 	struct dvobj_priv *pdvobjpriv = adapter_to_dvobj(padapter);
@@ -166,6 +170,7 @@ static void rtl8822ce_rx_mpdu(_adapter *padapter)
 	u8 *rx_bd;
 	struct sk_buff *skb;
 	u32 desc_size;
+	int handled = 0;
 
 
 	desc_size = rtl8822c_get_rx_desc_size(padapter);
@@ -173,6 +178,9 @@ static void rtl8822ce_rx_mpdu(_adapter *padapter)
 	/* RX NORMAL PKT */
 
 	remaing_rxdesc = rtl8822ce_check_rxdesc_remain(padapter, rx_q_idx);
+	if (remaing_rxdesc > budget)
+		remaing_rxdesc = budget;
+
 	while (remaing_rxdesc) {
 
 		/* rx descriptor */
@@ -296,24 +304,28 @@ done:
 			(r_priv->rx_ring[rx_q_idx].idx + 1) %
 			r_priv->rxringcount;
 
+		remaing_rxdesc--;
+		handled++;
+	}
+
+	/* return the whole batch of rx descriptors to hardware at once */
+	if (handled) {
 		rtw_write16(padapter, REG_RXQ_RXBD_IDX,
 			    r_priv->rx_ring[rx_q_idx].idx);
 
 		buf_desc_debug("RX:%s(%d) reg_value %x\n", __func__, __LINE__,
 			       rtw_read32(padapter, REG_RXQ_RXBD_IDX));
-
-		remaing_rxdesc--;
 	}
+
+	return handled;
 }
 
-static void rtl8822ce_recv_tasklet(unsigned long priv)
+static void rtl8822ce_rx_irq_enable(_adapter *padapter)
 {
 	_irqL	irqL;
-	_adapter	*padapter = (_adapter *)priv;
 	HAL_DATA_TYPE	*pHalData = GET_HAL_DATA(padapter);
 	struct dvobj_priv	*pdvobjpriv = adapter_to_dvobj(padapter);
 
-	rtl8822ce_rx_mpdu(padapter);
 	_enter_critical(&pdvobjpriv->irq_th_lock, &irqL);
 	pHalData->IntrMask[0] |= (BIT_RXOK_MSK_8822C | BIT_RDU_MSK_8822C);
 	pHalData->IntrMask[1] |= BIT_FOVW_MSK_8822C;
@@ -322,6 +334,28 @@ static void rtl8822ce_recv_tasklet(unsigned long priv)
 	_exit_critical(&pdvobjpriv->irq_th_lock, &irqL);
 }
 
+static void rtl8822ce_recv_tasklet(unsigned long priv)
+{
+	_adapter	*padapter = (_adapter *)priv;
+
+	rtl8822ce_rx_mpdu(padapter, padapter->recvpriv.rxringcount);
+	rtl8822ce_rx_irq_enable(padapter);
+}
+
+#ifdef CONFIG_RTW_NAPI_PCI_RX
+/* Called from the NAPI poll of the primary adapter, rx interrupts masked */
+s32 rtl8822ce_rx_napi_poll(_adapter *padapter, int budget)
+{
+	return rtl8822ce_rx_mpdu(padapter, budget);
+}
+
+/* Called after napi_complete_done() once the ring ran dry */
+void rtl8822ce_rx_napi_complete(_adapter *padapter)
+{
+	rtl8822ce_rx_irq_enable(padapter);
+}
+#endif /* CONFIG_RTW_NAPI_PCI_RX */
+
 static void rtl8822ce_xmit_beacon(PADAPTER Adapter)
 {
 #if defined(CONFIG_AP_MODE) && defined(CONFIG_NATIVEAP_MLME)
@@ -209,15 +209,54 @@ struct xmit_frame *__rtw_alloc_cmdxmitframe_8822ce(struct xmit_priv *pxmitpriv,
 	return __rtw_alloc_cmdxmitframe(pxmitpriv, CMDBUF_BEACON);
 }
 
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+/*
+ * Write the host pointer of every AC ring that got tx buffer descriptors
+ * without one, so that a batch of frames costs one register write per ring.
+ * Caller must hold irq_th_lock.
+ */
+static void _rtl8822ce_xmit_kick(_adapter *padapter)
+{
+	struct xmit_priv *pxmitpriv = &GET_PRIMARY_ADAPTER(padapter)->xmitpriv;
+	struct rtw_tx_ring *ring;
+	u16 host_wp;
+	u8 q_idx;
+
+	for (q_idx = VO_QUEUE_INX; q_idx <= BK_QUEUE_INX; q_idx++) {
+		if (!(pxmitpriv->tx_kick_pending & BIT(q_idx)))
+			continue;
+
+		ring = &pxmitpriv->tx_ring[q_idx];
+		host_wp = (ring->idx + ring->qlen) % ring->entries;
+		rtw_write16(padapter, get_txbd_rw_reg(q_idx), host_wp);
+	}
+
+	pxmitpriv->tx_kick_pending = 0;
+}
+
+void rtl8822ce_xmit_kick(_adapter *padapter)
+{
+	struct dvobj_priv *pdvobjpriv = adapter_to_dvobj(padapter);
+	_irqL irqL;
+
+	_enter_critical(&pdvobjpriv->irq_th_lock, &irqL);
+	_rtl8822ce_xmit_kick(padapter);
+	_exit_critical(&pdvobjpriv->irq_th_lock, &irqL);
+}
+#endif
+
 /*
  * Update Read/Write pointer
  *	Read pointer is h/w descriptor index
  *	Write pointer is host desciptor index:
  *	For tx side, if own bit is set in packet index n,
  *	host pointer (write pointer) point to index n + 1.)
+ *
+ * With defer set, the write pointer of an AC ring is only marked pending
+ * and written by the next non deferred fill or rtl8822ce_xmit_kick().
  */
 void fill_txbd_own(_adapter *padapter, u8 *txbd, u16 queue_idx,
-	struct rtw_tx_ring *ptxring)
+	struct rtw_tx_ring *ptxring, u8 defer)
 {
 	struct xmit_priv *pxmitpriv = &padapter->xmitpriv;
 	struct rtw_tx_ring *ring;
@@ -239,6 +278,14 @@ void fill_txbd_own(_adapter *padapter, u8 *txbd, u16 queue_idx,
 	 * for tx side, if own bit is set in packet index n,
 	 * host pointer (write pointer) point to index n + 1.
 	 */
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+	if (queue_idx <= BK_QUEUE_INX) {
+		GET_PRIMARY_ADAPTER(padapter)->xmitpriv.tx_kick_pending |= BIT(queue_idx);
+		if (!defer)
+			_rtl8822ce_xmit_kick(padapter);
+		return;
+	}
+#endif
 
         /* for current tx packet, enqueue has been ring->qlen++ before.
          * so, host_wp = ring->idx + ring->qlen.
@@ -717,7 +764,12 @@ s32 rtl8822ce_dump_xframe(_adapter *padapter, struct xmit_frame *pxmitframe)
 
 		/* Please comment here */
 		wmb();
-		fill_txbd_own(padapter, txbd, ff_hwaddr, ptx_ring);
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+		fill_txbd_own(padapter, txbd, ff_hwaddr, ptx_ring,
+			      pxmitframe->xmit_more || t != (pattrib->nr_frags - 1));
+#else
+		fill_txbd_own(padapter, txbd, ff_hwaddr, ptx_ring, _FALSE);
+#endif
 
 #ifdef DBG_TXBD_DESC_DUMP
 		if (pxmitpriv->dump_txbd_desc == DUMP_TXBD_ON ||
@@ -922,6 +974,10 @@ static s32 xmitframe_amsdu_direct(_adapter *padapter, struct xmit_frame *pxmitfr
 	#ifdef CONFIG_XMIT_THREAD_MODE
 		enqueue_pending_xmitbuf(pxmitpriv, pxmitframe->pxmitbuf);
 	#else
+		#ifdef CONFIG_RTW_PCI_TX_BATCH
+		/* only used by rtl8822ce_xmitframe_resume(), which kicks at the end */
+		pxmitframe->xmit_more = _TRUE;
+		#endif
 		res = rtl8822ce_dump_xframe(padapter, pxmitframe);
 	#endif
 	} else {
@@ -1122,6 +1178,9 @@ void rtl8822ce_xmitframe_resume(_adapter *padapter)
 #ifdef CONFIG_XMIT_THREAD_MODE
 					enqueue_pending_xmitbuf(pxmitpriv, pxmitframe_next->pxmitbuf);
 #else
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+					pxmitframe_next->xmit_more = _TRUE;
+#endif
 					rtl8822ce_dump_xframe(padapter, pxmitframe_next);
 #endif
 					pxmitpriv->amsdu_debug_coalesce_two++;
@@ -1160,6 +1219,9 @@ dump_pkt:
 			#ifdef CONFIG_XMIT_THREAD_MODE
 				enqueue_pending_xmitbuf(pxmitpriv, pxmitframe->pxmitbuf);
 			#else
+				#ifdef CONFIG_RTW_PCI_TX_BATCH
+				pxmitframe->xmit_more = _TRUE;
+				#endif
 				rtl8822ce_dump_xframe(padapter, pxmitframe);
 			#endif
 			} else {
@@ -1173,6 +1235,12 @@ dump_pkt:
 			break;
 		}
 	}
+
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+	/* one host pointer write per AC ring for everything dequeued above */
+	if (GET_PRIMARY_ADAPTER(padapter)->xmitpriv.tx_kick_pending)
+		rtl8822ce_xmit_kick(padapter);
+#endif
 }
 
 
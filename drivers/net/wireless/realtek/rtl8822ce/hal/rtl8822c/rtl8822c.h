@@ -22,6 +22,13 @@
 #include <hal_intf.h>		/* HAL_DEF_VARIABLE */
 #include "hal8822c_fw.h"	/* FW array */
 
+#ifdef CONFIG_RTW_REQUEST_FW
+extern char *rtw_fw_name;
+#ifdef CONFIG_WOWLAN
+extern char *rtw_fw_wow_name;
+#endif /* CONFIG_WOWLAN */
+#endif /* CONFIG_RTW_REQUEST_FW */
+
 #define DRIVER_EARLY_INT_TIME_8822C	0x05
 #define BCN_DMA_ATIME_INT_TIME_8822C	0x02
 
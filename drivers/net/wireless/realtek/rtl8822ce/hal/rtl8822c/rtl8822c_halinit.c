@@ -145,6 +145,7 @@ u8 rtl8822c_hal_init(PADAPTER adapter)
 	PHAL_DATA_TYPE hal;
 	int err;
 	u8 fw_bin = _TRUE;
+	const char *fw_src = "file";
 
 	d = adapter_to_dvobj(adapter);
 	hal = GET_HAL_DATA(adapter);
@@ -168,7 +169,12 @@ u8 rtl8822c_hal_init(PADAPTER adapter)
 	} else
 #endif /* CONFIG_FILE_FWIMG */
 	{
-		RTW_INFO("%s fw source from array\n", __FUNCTION__);
+#ifdef CONFIG_RTW_REQUEST_FW
+		fw_src = rtw_fw_name;
+#else
+		fw_src = "array";
+#endif /* CONFIG_RTW_REQUEST_FW */
+		RTW_INFO("%s fw source from %s\n", __FUNCTION__, fw_src);
 		fw_bin = _FALSE;
 	}
 
@@ -177,16 +183,20 @@ u8 rtl8822c_hal_init(PADAPTER adapter)
 		err = rtw_halmac_init_hal_fw_file(d, rtw_phy_para_file_path);
 	else
 #endif /* CONFIG_FILE_FWIMG */
+#ifdef CONFIG_RTW_REQUEST_FW
+		err = rtw_halmac_init_hal_fw_request(d, rtw_fw_name);
+#else
 		err = rtw_halmac_init_hal_fw(d, array_mp_8822c_fw_nic, array_length_mp_8822c_fw_nic);
+#endif /* CONFIG_RTW_REQUEST_FW */
 
 	if (err) {
-		RTW_ERR("%s Download Firmware from %s failed\n", __FUNCTION__, (fw_bin) ? "file" : "array");
+		RTW_ERR("%s Download Firmware from %s failed\n", __FUNCTION__, fw_src);
 		return _FALSE;
 	}
 
 	
 
-	RTW_INFO("%s Download Firmware from %s success\n", __FUNCTION__, (fw_bin) ? "file" : "array");
+	RTW_INFO("%s Download Firmware from %s success\n", __FUNCTION__, fw_src);
 	RTW_INFO("%s FW Version:%d SubVersion:%d FW size:%d\n", "NIC",
 		hal->firmware_version, hal->firmware_sub_version, hal->firmware_size);
 
@@ -110,6 +110,7 @@ s32 rtl8822c_fw_dl(PADAPTER adapter, u8 wowlan)
 	struct pwrctrl_priv *pwrpriv = adapter_to_pwrctl(adapter);
 	int err;
 	u8 fw_bin = _TRUE;
+	const char *fw_src = "file";
 
 #ifdef CONFIG_FILE_FWIMG
 #ifdef CONFIG_WOWLAN
@@ -125,7 +126,16 @@ s32 rtl8822c_fw_dl(PADAPTER adapter, u8 wowlan)
 	} else
 #endif /* CONFIG_FILE_FWIMG */
 	{
-		RTW_INFO("%s fw source from array\n", __FUNCTION__);
+#ifdef CONFIG_RTW_REQUEST_FW
+		fw_src = rtw_fw_name;
+		#ifdef CONFIG_WOWLAN
+		if (_TRUE == wowlan)
+			fw_src = rtw_fw_wow_name;
+		#endif /* CONFIG_WOWLAN */
+#else
+		fw_src = "array";
+#endif /* CONFIG_RTW_REQUEST_FW */
+		RTW_INFO("%s fw source from %s\n", __FUNCTION__, fw_src);
 		fw_bin = _FALSE;
 	}
 
@@ -134,6 +144,12 @@ s32 rtl8822c_fw_dl(PADAPTER adapter, u8 wowlan)
 		err = rtw_halmac_dlfw_from_file(d, rtw_phy_para_file_path);
 	} else
 #endif /* CONFIG_FILE_FWIMG */
+#ifdef CONFIG_RTW_REQUEST_FW
+	{
+		/* the firmware loader keeps the image cached over resume */
+		err = rtw_halmac_dlfw_request(d, fw_src);
+	}
+#else
 	{
 		#ifdef CONFIG_WOWLAN
 		if (_TRUE == wowlan)
@@ -142,18 +158,19 @@ s32 rtl8822c_fw_dl(PADAPTER adapter, u8 wowlan)
 		#endif /* CONFIG_WOWLAN */
 			err = rtw_halmac_dlfw(d, array_mp_8822c_fw_nic, array_length_mp_8822c_fw_nic);
 	}
+#endif /* CONFIG_RTW_REQUEST_FW */
 
 	if (!err) {
 		hal->bFWReady = _TRUE;
 		hal->fw_ractrl = _TRUE;
-		RTW_INFO("%s Download Firmware from %s success\n", __FUNCTION__, (fw_bin) ? "file" : "array");
+		RTW_INFO("%s Download Firmware from %s success\n", __FUNCTION__, fw_src);
 		RTW_INFO("%s FW Version:%d SubVersion:%d FW size:%d\n", (wowlan) ? "WOW" : "NIC",
 			hal->firmware_version, hal->firmware_sub_version, hal->firmware_size);
 		return _SUCCESS;
 	} else {
 		hal->bFWReady = _FALSE;
 		hal->fw_ractrl = _FALSE;
-		RTW_ERR("%s Download Firmware from %s failed\n", __FUNCTION__, (fw_bin) ? "file" : "array");
+		RTW_ERR("%s Download Firmware from %s failed\n", __FUNCTION__, fw_src);
 		return _FAIL;
 	}
 }
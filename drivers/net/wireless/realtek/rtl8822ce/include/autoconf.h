@@ -66,7 +66,9 @@
 #define CONFIG_TRX_BD_ARCH	/* PCI only */
 #define USING_RX_TAG
 
+#ifndef CONFIG_RTW_REQUEST_FW
 #define CONFIG_EMBEDDED_FWIMG
+#endif
 
 #ifdef CONFIG_EMBEDDED_FWIMG
 	#define	LOAD_FW_HEADER_FROM_DRIVER
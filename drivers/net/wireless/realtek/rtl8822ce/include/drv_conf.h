@@ -66,6 +66,18 @@
 
 #endif
 
+#if defined(CONFIG_RTW_NAPI_PCI_RX) && (!defined(CONFIG_RTW_NAPI) || !defined(CONFIG_PCI_HCI))
+
+	#undef CONFIG_RTW_NAPI_PCI_RX
+
+#endif
+
+#if defined(CONFIG_RTW_PCI_TX_BATCH) && (!defined(CONFIG_PCI_HCI) || defined(CONFIG_XMIT_THREAD_MODE))
+
+	#undef CONFIG_RTW_PCI_TX_BATCH
+
+#endif
+
 #if defined(CONFIG_RTW_80211R) && !defined(CONFIG_LAYER2_ROAMING)
 
 	#error "Enable CONFIG_LAYER2_ROAMING before enable CONFIG_RTW_80211R\n"
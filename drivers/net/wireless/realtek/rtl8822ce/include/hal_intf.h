@@ -308,6 +308,10 @@ struct hal_ops {
 	s32(*hal_mgmt_xmitframe_enqueue)(_adapter *padapter, struct xmit_frame *pxmitframe);
 #endif
 	s32(*hal_xmitframe_enqueue)(_adapter *padapter, struct xmit_frame *pxmitframe);
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+	/* write the tx host pointers left behind by xmit_more frames */
+	void (*hal_xmit_kick)(_adapter *padapter);
+#endif
 	#if defined (CONFIG_CONCURRENT_MODE)  && defined (CONFIG_TSF_SYNC)
 	void(*tsf_sync)(_adapter *Adapter);
 	#endif
@@ -320,6 +324,10 @@ struct hal_ops {
 	/*** recv section ***/
 	s32(*init_recv_priv)(_adapter *padapter);
 	void	(*free_recv_priv)(_adapter *padapter);
+#ifdef CONFIG_RTW_NAPI_PCI_RX
+	s32 (*rx_napi_poll)(_adapter *adapter, int budget);
+	void (*rx_napi_complete)(_adapter *adapter);
+#endif
 #ifdef CONFIG_RECV_THREAD_MODE
 	s32 (*recv_hdl)(_adapter *adapter);
 #endif
@@ -767,6 +775,9 @@ s32	rtw_hal_mgmt_xmitframe_enqueue(_adapter *padapter, struct xmit_frame *pxmitf
 s32	rtw_hal_xmitframe_enqueue(_adapter *padapter, struct xmit_frame *pxmitframe);
 s32	rtw_hal_xmit(_adapter *padapter, struct xmit_frame *pxmitframe);
 s32	rtw_hal_mgnt_xmit(_adapter *padapter, struct xmit_frame *pmgntframe);
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+void	rtw_hal_xmit_kick(_adapter *padapter);
+#endif
 
 s32	rtw_hal_init_xmit_priv(_adapter *padapter);
 void	rtw_hal_free_xmit_priv(_adapter *padapter);
@@ -840,6 +851,11 @@ s32 rtw_hal_xmit_thread_handler(_adapter *padapter);
 s32 rtw_hal_recv_hdl(_adapter *adapter);
 #endif
 
+#ifdef CONFIG_RTW_NAPI_PCI_RX
+s32 rtw_hal_rx_napi_poll(_adapter *adapter, int budget);
+void rtw_hal_rx_napi_complete(_adapter *adapter);
+#endif
+
 void rtw_hal_notch_filter(_adapter *adapter, bool enable);
 
 #ifdef CONFIG_FW_C2H_REG
@@ -176,6 +176,7 @@ struct sk_buff *dbg_rtw_skb_copy(const struct sk_buff *skb, const enum mstat_f f
 struct sk_buff *dbg_rtw_skb_clone(struct sk_buff *skb, const enum mstat_f flags, const char *func, const int line);
 int dbg_rtw_netif_rx(_nic_hdl ndev, struct sk_buff *skb, const enum mstat_f flags, const char *func, int line);
 #ifdef CONFIG_RTW_NAPI
+struct sk_buff *dbg_rtw_napi_alloc_skb(struct napi_struct *napi, unsigned int size, const enum mstat_f flags, const char *func, const int line);
 int dbg_rtw_netif_receive_skb(_nic_hdl ndev, struct sk_buff *skb, const enum mstat_f flags, const char *func, int line);
 #ifdef CONFIG_RTW_GRO
 gro_result_t dbg_rtw_napi_gro_receive(struct napi_struct *napi, struct sk_buff *skb, const enum mstat_f flags, const char *func, int line);
@@ -219,6 +220,7 @@ void dbg_rtw_usb_buffer_free(struct usb_device *dev, size_t size, void *addr, dm
 #define rtw_skb_clone_f(skb, mstat_f)	dbg_rtw_skb_clone((skb), ((mstat_f) & 0xff00) | MSTAT_TYPE_SKB, __FUNCTION__, __LINE__)
 #define rtw_netif_rx(ndev, skb)	dbg_rtw_netif_rx(ndev, skb, MSTAT_TYPE_SKB, __FUNCTION__, __LINE__)
 #ifdef CONFIG_RTW_NAPI
+#define rtw_napi_alloc_skb(napi, size) dbg_rtw_napi_alloc_skb(napi, size, MSTAT_TYPE_SKB, __FUNCTION__, __LINE__)
 #define rtw_netif_receive_skb(ndev, skb) dbg_rtw_netif_receive_skb(ndev, skb, MSTAT_TYPE_SKB, __FUNCTION__, __LINE__)
 #ifdef CONFIG_RTW_GRO
 #define rtw_napi_gro_receive(napi, skb) dbg_rtw_napi_gro_receive(napi, skb, MSTAT_TYPE_SKB, __FUNCTION__, __LINE__)
@@ -252,6 +254,7 @@ struct sk_buff *_rtw_skb_copy(const struct sk_buff *skb);
 struct sk_buff *_rtw_skb_clone(struct sk_buff *skb);
 int _rtw_netif_rx(_nic_hdl ndev, struct sk_buff *skb);
 #ifdef CONFIG_RTW_NAPI
+struct sk_buff *_rtw_napi_alloc_skb(struct napi_struct *napi, u32 sz);
 int _rtw_netif_receive_skb(_nic_hdl ndev, struct sk_buff *skb);
 #ifdef CONFIG_RTW_GRO
 gro_result_t _rtw_napi_gro_receive(struct napi_struct *napi, struct sk_buff *skb);
@@ -296,6 +299,7 @@ void _rtw_usb_buffer_free(struct usb_device *dev, size_t size, void *addr, dma_a
 #define rtw_skb_clone_f(skb, mstat_f)	_rtw_skb_clone((skb))
 #define rtw_netif_rx(ndev, skb) _rtw_netif_rx(ndev, skb)
 #ifdef CONFIG_RTW_NAPI
+#define rtw_napi_alloc_skb(napi, size) _rtw_napi_alloc_skb(napi, size)
 #define rtw_netif_receive_skb(ndev, skb) _rtw_netif_receive_skb(ndev, skb)
 #ifdef CONFIG_RTW_GRO
 #define rtw_napi_gro_receive(napi, skb) _rtw_napi_gro_receive(napi, skb)
@@ -725,6 +729,11 @@ extern int rtw_is_file_readable(const char *path);
 extern int rtw_is_file_readable_with_size(const char *path, u32 *sz);
 extern int rtw_readable_file_sz_chk(const char *path, u32 sz);
 extern int rtw_retrieve_from_file(const char *path, u8 *buf, u32 sz);
+#ifdef CONFIG_RTW_REQUEST_FW
+extern int rtw_request_firmware(void *dev, const char *name,
+				const u8 **data, u32 *sz, void **fw);
+extern void rtw_release_firmware(void *fw);
+#endif /* CONFIG_RTW_REQUEST_FW */
 
 
 #ifndef PLATFORM_FREEBSD
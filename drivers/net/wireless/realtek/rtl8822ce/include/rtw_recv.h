@@ -475,6 +475,10 @@ struct recv_priv {
 #ifdef CONFIG_RTW_NAPI
 		struct sk_buff_head rx_napi_skb_queue;
 #endif 
+#ifdef CONFIG_RTW_NAPI_PCI_RX
+	u8 napi_rx_sched;	/* rx interrupt handed the rx ring to NAPI */
+	u8 napi_rx_polling;	/* rx ring is being drained from NAPI poll */
+#endif
 #ifdef CONFIG_RX_INDICATE_QUEUE
 	_tasklet rx_indicate_tasklet;
 	struct ifqueue rx_indicate_queue;
@@ -100,7 +100,9 @@
 	#define MAX_CMDBUF_SZ	(512 * 18)
 #elif defined(CONFIG_RTL8723D) && defined(CONFIG_LPS_POFF)
 	#define MAX_CMDBUF_SZ	(128*70) /*(8960)*/
-#elif defined(CONFIG_RTL8822C) && defined(CONFIG_WAR_OFFLOAD)
+#elif defined(CONFIG_RTL8822C) && \
+	(defined(CONFIG_WAR_OFFLOAD) || defined(CONFIG_PCI_HCI))
+	/* PCIe: also the FW download chunk, halmac allows up to 31K */
 	#define MAX_CMDBUF_SZ	(128*128) /*(16k) */
 #else
 	#define MAX_CMDBUF_SZ	(5120)	/* (4096) */
@@ -677,6 +679,9 @@ struct xmit_frame {
 	u8 *alloc_addr; /* the actual address this xmitframe allocated */
 	u8 ext_tag; /* 0:data, 1:mgmt */
 
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+	u8 xmit_more; /* more frames follow, leave the txbd write pointer to the last one */
+#endif
 };
 
 struct tx_servq {
@@ -812,6 +817,9 @@ struct	xmit_priv	{
 	int	txringcount[PCI_MAX_TX_QUEUE_COUNT];
 	u8 	beaconDMAing;		/* flag of indicating beacon is transmiting to HW by DMA */
 	_tasklet xmit_tasklet;
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+	u32	tx_kick_pending;	/* BIT(q_idx): host write pointer not written yet, under irq_th_lock */
+#endif
 #endif
 
 #if defined(CONFIG_SDIO_HCI) || defined(CONFIG_GSPI_HCI)
@@ -94,6 +94,9 @@ extern void rtw_os_xmit_complete(_adapter *padapter, struct xmit_frame *pxframe)
 
 void rtw_os_check_wakup_queue(_adapter *adapter, u16 os_qid);
 bool rtw_os_check_stop_queue(_adapter *adapter, u16 os_qid);
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+u8 rtw_os_xmit_more(_pkt *pkt);
+#endif
 void rtw_os_wake_queue_at_free_stainfo(_adapter *padapter, int *qcnt_freed);
 
 void dump_os_queue(void *sel, _adapter *padapter);
@@ -676,6 +676,20 @@ MODULE_PARM_DESC(rtw_fw_mp_bt_file_path, "The path of fw for MP-BT image");
 #endif /* CONFIG_MP_INCLUDED */
 #endif /* CONFIG_FILE_FWIMG */
 
+#ifdef CONFIG_RTW_REQUEST_FW
+char *rtw_fw_name = "rtlwifi/rtl8822cefw.bin";
+module_param(rtw_fw_name, charp, 0644);
+MODULE_PARM_DESC(rtw_fw_name, "FW image for request_firmware, .xz/.zst also found");
+MODULE_FIRMWARE("rtlwifi/rtl8822cefw.bin");
+
+#ifdef CONFIG_WOWLAN
+char *rtw_fw_wow_name = "rtlwifi/rtl8822cefw_wowlan.bin";
+module_param(rtw_fw_wow_name, charp, 0644);
+MODULE_PARM_DESC(rtw_fw_wow_name, "Wake on Wireless FW image for request_firmware");
+MODULE_FIRMWARE("rtlwifi/rtl8822cefw_wowlan.bin");
+#endif /* CONFIG_WOWLAN */
+#endif /* CONFIG_RTW_REQUEST_FW */
+
 #ifdef CONFIG_ADVANCE_OTA
 /*	BIT(0): OTA continuous rotated test within low RSSI,1R CCA in path B
 	BIT(1) & BIT(2): OTA continuous rotated test with low high RSSI */
@@ -86,6 +86,11 @@ int rtw_os_alloc_recvframe(_adapter *padapter, union recv_frame *precvframe, u8
 		alloc_sz += 14;
 	}
 
+#ifdef CONFIG_RTW_NAPI_PCI_RX
+	if (padapter->recvpriv.napi_rx_polling)
+		pkt_copy = rtw_napi_alloc_skb(&padapter->napi, alloc_sz);
+	else
+#endif
 	pkt_copy = rtw_skb_alloc(alloc_sz);
 
 	if (pkt_copy) {
@@ -437,14 +442,38 @@ int rtw_recv_napi_poll(struct napi_struct *napi, int budget)
 	_adapter *padapter = container_of(napi, _adapter, napi);
 	int work_done = 0;
 	struct recv_priv *precvpriv = &padapter->recvpriv;
-
+#ifdef CONFIG_RTW_NAPI_PCI_RX
+	int rx_done = -1;
+
+	/*
+	 * Drain the rx ring here instead of in recv_tasklet, frames indicated
+	 * meanwhile are queued to rx_napi_skb_queue and delivered below in
+	 * the same poll. The ring is only ours while the rx interrupt stays
+	 * masked after it scheduled us.
+	 */
+	if (precvpriv->napi_rx_sched) {
+		precvpriv->napi_rx_polling = _TRUE;
+		rx_done = rtw_hal_rx_napi_poll(padapter, budget);
+		precvpriv->napi_rx_polling = _FALSE;
+	}
+#endif
 
 	work_done = napi_recv(padapter, budget);
+#ifdef CONFIG_RTW_NAPI_PCI_RX
+	if (rx_done > work_done)
+		work_done = rx_done;
+#endif
 	if (work_done < budget) {
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3, 19, 0)) && defined(CONFIG_PCI_HCI)
 		napi_complete_done(napi, work_done);
 #else
 		napi_complete(napi);
+#endif
+#ifdef CONFIG_RTW_NAPI_PCI_RX
+		if (rx_done >= 0) {
+			precvpriv->napi_rx_sched = _FALSE;
+			rtw_hal_rx_napi_complete(padapter);
+		}
 #endif
 		if (!skb_queue_empty(&precvpriv->rx_napi_skb_queue))
 			napi_schedule(napi);
@@ -548,6 +577,10 @@ void rtw_os_recv_indicate_pkt(_adapter *padapter, _pkt *pkt, union recv_frame *r
 		) {
 			skb_queue_tail(&precvpriv->rx_napi_skb_queue, pkt);
 			#ifndef CONFIG_RTW_NAPI_V2
+			#ifdef CONFIG_RTW_NAPI_PCI_RX
+			/* already inside our poll, which delivers the queue */
+			if (!precvpriv->napi_rx_polling)
+			#endif
 			napi_schedule(&padapter->napi);
 			#endif
 			return;
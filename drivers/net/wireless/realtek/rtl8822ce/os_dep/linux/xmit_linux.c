@@ -216,14 +216,22 @@ void dump_os_queue(void *sel, _adapter *padapter)
 }
 
 #define WMM_XMIT_THRESHOLD	(NR_XMITFRAME*2/5)
+#define XMIT_STOP_THRESHOLD	4
+
+/*
+ * A stopped queue is woken only after it has drained below the stop level
+ * by a margin, so that under load it is not stopped and woken again for
+ * every xmitframe freed by the tx completion.
+ */
+#define WMM_XMIT_WAKE_THRESHOLD	(WMM_XMIT_THRESHOLD*3/4)
+#define XMIT_WAKE_THRESHOLD	(XMIT_STOP_THRESHOLD + NR_XMITFRAME/16)
 
 static inline bool rtw_os_need_wake_queue(_adapter *padapter, u16 os_qid)
 {
-#if (LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 35))
 	struct xmit_priv *pxmitpriv = &padapter->xmitpriv;
-
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 35))
 	if (padapter->registrypriv.wifi_spec) {
-		if (pxmitpriv->hwxmits[os_qid].accnt < WMM_XMIT_THRESHOLD)
+		if (pxmitpriv->hwxmits[os_qid].accnt < WMM_XMIT_WAKE_THRESHOLD)
 			return _TRUE;
 #ifdef DBG_CONFIG_ERROR_DETECT
 #ifdef DBG_CONFIG_ERROR_RESET
@@ -239,6 +247,8 @@ static inline bool rtw_os_need_wake_queue(_adapter *padapter, u16 os_qid)
 				return _FALSE;
 		}
 #endif /* CONFIG_MCC_MODE */
+		if (pxmitpriv->free_xmitframe_cnt < XMIT_WAKE_THRESHOLD)
+			return _FALSE;
 		return _TRUE;
 	}
 	return _FALSE;
@@ -250,6 +260,8 @@ static inline bool rtw_os_need_wake_queue(_adapter *padapter, u16 os_qid)
 			return _FALSE;
 	}
 #endif /* CONFIG_MCC_MODE */
+	if (pxmitpriv->free_xmitframe_cnt < XMIT_WAKE_THRESHOLD)
+		return _FALSE;
 	return _TRUE;
 #endif
 }
@@ -263,11 +275,11 @@ static inline bool rtw_os_need_stop_queue(_adapter *padapter, u16 os_qid)
 		if (pxmitpriv->hwxmits[os_qid].accnt > WMM_XMIT_THRESHOLD)
 			return _TRUE;
 	} else {
-		if (pxmitpriv->free_xmitframe_cnt <= 4)
+		if (pxmitpriv->free_xmitframe_cnt <= XMIT_STOP_THRESHOLD)
 			return _TRUE;
 	}
 #else
-	if (pxmitpriv->free_xmitframe_cnt <= 4)
+	if (pxmitpriv->free_xmitframe_cnt <= XMIT_STOP_THRESHOLD)
 		return _TRUE;
 #endif
 	return _FALSE;
@@ -363,6 +375,20 @@ bool rtw_os_check_stop_queue(_adapter *adapter, u16 os_qid)
 	return busy;
 }
 
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+/* the stack has more frames for this device right behind pkt */
+u8 rtw_os_xmit_more(_pkt *pkt)
+{
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 2, 0))
+	return netdev_xmit_more() ? _TRUE : _FALSE;
+#elif (LINUX_VERSION_CODE >= KERNEL_VERSION(3, 18, 0))
+	return pkt->xmit_more ? _TRUE : _FALSE;
+#else
+	return _FALSE;
+#endif
+}
+#endif
+
 void rtw_os_wake_queue_at_free_stainfo(_adapter *padapter, int *qcnt_freed)
 {
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 35))
@@ -400,6 +426,9 @@ int _rtw_xmit_entry(_pkt *pkt, _nic_hdl pnetdev)
 #endif
 	u16 os_qid = 0;
 	s32 res = 0;
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+	u8 xmit_more = rtw_os_xmit_more(pkt);
+#endif
 
 	if (padapter->registrypriv.mp_mode) {
 		RTW_INFO("MP_TX_DROP_OS_FRAME\n");
@@ -465,7 +494,15 @@ drop_packet:
 	rtw_os_pkt_complete(padapter, pkt);
 
 exit:
-
+#ifdef CONFIG_RTW_PCI_TX_BATCH
+	/*
+	 * Frames sent with xmit_more only queued their tx buffer descriptors.
+	 * Write the host pointers at the end of the batch, or right away when
+	 * the queue got stopped and no further frame would come to flush them.
+	 */
+	if (!xmit_more || __netif_subqueue_stopped(pnetdev, os_qid))
+		rtw_hal_xmit_kick(padapter);
+#endif
 
 	return 0;
 }
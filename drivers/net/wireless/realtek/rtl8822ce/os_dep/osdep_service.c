@@ -537,6 +537,17 @@ inline int _rtw_netif_rx(_nic_hdl ndev, struct sk_buff *skb)
 }
 
 #ifdef CONFIG_RTW_NAPI
+/* Only valid from NAPI poll, takes rx buffers from the per-cpu page frag cache */
+inline struct sk_buff *_rtw_napi_alloc_skb(struct napi_struct *napi, u32 sz)
+{
+#if defined(PLATFORM_LINUX)
+	return napi_alloc_skb(napi, sz);
+#else
+	rtw_warn_on(1);
+	return NULL;
+#endif
+}
+
 inline int _rtw_netif_receive_skb(_nic_hdl ndev, struct sk_buff *skb)
 {
 #if defined(PLATFORM_LINUX)
@@ -964,6 +975,28 @@ inline int dbg_rtw_netif_rx(_nic_hdl ndev, struct sk_buff *skb, const enum mstat
 }
 
 #ifdef CONFIG_RTW_NAPI
+inline struct sk_buff *dbg_rtw_napi_alloc_skb(struct napi_struct *napi, unsigned int size, const enum mstat_f flags, const char *func, int line)
+{
+	struct sk_buff *skb;
+	unsigned int truesize = 0;
+
+	skb = _rtw_napi_alloc_skb(napi, size);
+
+	if (skb)
+		truesize = skb->truesize;
+
+	if (!skb || truesize < size || match_mstat_sniff_rules(flags, truesize))
+		RTW_INFO("DBG_MEM_ALLOC %s:%d %s(%d), skb:%p, truesize=%u\n", func, line, __FUNCTION__, size, skb, truesize);
+
+	rtw_mstat_update(
+		flags
+		, skb ? MSTAT_ALLOC_SUCCESS : MSTAT_ALLOC_FAIL
+		, truesize
+	);
+
+	return skb;
+}
+
 inline int dbg_rtw_netif_receive_skb(_nic_hdl ndev, struct sk_buff *skb, const enum mstat_f flags, const char *func, int line)
 {
 	int ret;
@@ -2998,6 +3031,50 @@ int rtw_retrieve_from_file(const char *path, u8 *buf, u32 sz)
 #endif
 }
 
+#ifdef CONFIG_RTW_REQUEST_FW
+/*
+* Load the image @param name with the kernel firmware loader, which also looks
+* for name.xz/name.zst when the kernel has CONFIG_FW_LOADER_COMPRESS, and
+* keeps it cached over suspend/resume for @param dev
+* @param dev the struct device requesting the image
+* @param name the image name relative to the firmware search path
+* @param data returns the image content
+* @param sz returns the image size
+* @param fw returns the handle to pass to rtw_release_firmware()
+* @return 0 on success, negative errno otherwise
+*/
+int rtw_request_firmware(void *dev, const char *name,
+			 const u8 **data, u32 *sz, void **fw)
+{
+#ifdef PLATFORM_LINUX
+	const struct firmware *img = NULL;
+	int ret;
+
+	ret = request_firmware(&img, name, (struct device *)dev);
+	if (ret) {
+		RTW_ERR("%s: request %s fail(%d)\n", __func__, name, ret);
+		return ret;
+	}
+
+	*data = img->data;
+	*sz = (u32)img->size;
+	*fw = (void *)img;
+
+	return 0;
+#else
+	/* Todo... */
+	return -1;
+#endif
+}
+
+void rtw_release_firmware(void *fw)
+{
+#ifdef PLATFORM_LINUX
+	release_firmware((const struct firmware *)fw);
+#endif
+}
+#endif /* CONFIG_RTW_REQUEST_FW */
+
 #if !defined(CONFIG_RTW_ANDROID_GKI)
 /*
 * Open the file with @param path and wirte @param sz byte of data starting from @param buf into the file
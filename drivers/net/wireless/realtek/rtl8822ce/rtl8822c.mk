@@ -10,8 +10,11 @@ _HAL_INTFS_FILES +=	hal/rtl8822c/rtl8822c_halinit.o \
 			hal/rtl8822c/rtl8822c_mac.o \
 			hal/rtl8822c/rtl8822c_cmd.o \
 			hal/rtl8822c/rtl8822c_phy.o \
-			hal/rtl8822c/rtl8822c_ops.o \
-			hal/rtl8822c/hal8822c_fw.o
+			hal/rtl8822c/rtl8822c_ops.o
+
+ifneq ($(CONFIG_RTW_REQUEST_FW), y)
+_HAL_INTFS_FILES +=	hal/rtl8822c/hal8822c_fw.o
+endif
 
 ifeq ($(CONFIG_USB_HCI), y)
 _HAL_INTFS_FILES +=	hal/rtl8822c/$(HCI_NAME)/rtl8822cu_halinit.o \
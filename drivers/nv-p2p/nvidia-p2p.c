@@ -1,7 +1,9 @@
 // SPDX-License-Identifier: GPL-2.0-only
 // Copyright (c) 2023 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
 
+#include <linux/sizes.h>
 #include <linux/slab.h>
+#include <linux/spinlock.h>
 #include <linux/version.h>
 #include <linux/mmu_notifier.h>
 #include <linux/module.h>
@@ -61,6 +63,357 @@ static inline s32 safe_cast_s64_to_s32(s64 sl_a)
 	}
 }
 
+static unsigned int reg_cache_entries;
+module_param(reg_cache_entries, uint, 0644);
+MODULE_PARM_DESC(reg_cache_entries,
+	"Released ranges kept pinned per process for reuse, 0 to disable");
+
+/* Largest NVIDIA_P2P_PAGE_SIZE_* the pinned range is made of */
+static u32 nvidia_p2p_phys_page_size(u64 vaddr, struct page **pages,
+		u32 nr_pages)
+{
+	static const struct {
+		u32 type;
+		u64 size;
+	} sizes[] = {
+		{ NVIDIA_P2P_PAGE_SIZE_2MB, SZ_2M },
+		{ NVIDIA_P2P_PAGE_SIZE_128KB, SZ_128K },
+		{ NVIDIA_P2P_PAGE_SIZE_64KB, SZ_64K },
+	};
+	unsigned long pfn, n;
+	u32 i, j;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		if (sizes[i].size <= PAGE_SIZE)
+			return sizes[i].type;
+
+		n = sizes[i].size >> PAGE_SHIFT;
+		if ((vaddr & (sizes[i].size - 1)) || (nr_pages % n))
+			continue;
+
+		for (j = 0; j < nr_pages; j++) {
+			pfn = page_to_pfn(pages[j]);
+			if ((j % n) ? (pfn != page_to_pfn(pages[j - 1]) + 1) :
+				      (pfn & (n - 1)))
+				break;
+		}
+
+		if (j == nr_pages)
+			return sizes[i].type;
+	}
+
+	return NVIDIA_P2P_PAGE_SIZE_4KB;
+}
+
+/*
+ * Registration cache of one process. Every page table pinned with the
+ * cache enabled has an in use entry; put_pages turns it idle and leaves
+ * its pages pinned for the next get_pages of the same range. Idle entries
+ * are dropped, and in use ones marked stale, as soon as their range is
+ * invalidated. Each entry holds a reference of the notifier.
+ */
+struct nvidia_p2p_mm_cache {
+	struct mmu_notifier mn;
+	struct list_head node;
+	spinlock_t lock;
+	struct list_head entries;
+	unsigned int idle;
+	u32 seq;
+};
+
+struct nvidia_p2p_cache_entry {
+	struct list_head node;
+	struct nvidia_p2p_mm_cache *cache;
+	u64 vaddr;
+	u64 size;
+	u32 entries;
+	u32 phys_page_size;
+	struct page **pages;
+	bool in_use;
+	bool stale;
+};
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 4, 0)
+static LIST_HEAD(nvidia_p2p_caches);
+static DEFINE_SPINLOCK(nvidia_p2p_caches_lock);
+
+/* Unpin idle entries already unlinked from their cache */
+static void nvidia_p2p_cache_free(struct list_head *list)
+{
+	struct nvidia_p2p_cache_entry *entry, *tmp;
+	s32 i;
+
+	list_for_each_entry_safe(entry, tmp, list, node) {
+		list_del(&entry->node);
+		for (i = safe_cast_u32_to_s32(entry->entries) - 1; i >= 0; i--)
+			put_page(entry->pages[i]);
+		kfree(entry->pages);
+		mmu_notifier_put(&entry->cache->mn);
+		kfree(entry);
+	}
+}
+
+static void nvidia_p2p_cache_drop(struct nvidia_p2p_mm_cache *cache,
+		unsigned long start, unsigned long end)
+{
+	struct nvidia_p2p_cache_entry *entry, *tmp;
+	LIST_HEAD(stale);
+
+	spin_lock(&cache->lock);
+	cache->seq++;
+	list_for_each_entry_safe(entry, tmp, &cache->entries, node) {
+		if ((entry->vaddr >= end) || (entry->vaddr + entry->size <= start))
+			continue;
+
+		if (entry->in_use) {
+			entry->stale = true;
+		} else {
+			list_move(&entry->node, &stale);
+			cache->idle--;
+		}
+	}
+	spin_unlock(&cache->lock);
+
+	nvidia_p2p_cache_free(&stale);
+}
+
+static int nvidia_p2p_cache_invl_range_start(struct mmu_notifier *mn,
+	const struct mmu_notifier_range *range)
+{
+	nvidia_p2p_cache_drop(container_of(mn, struct nvidia_p2p_mm_cache, mn),
+			range->start, range->end);
+
+	return 0;
+}
+
+static void nvidia_p2p_cache_release(struct mmu_notifier *mn,
+	struct mm_struct *mm)
+{
+	nvidia_p2p_cache_drop(container_of(mn, struct nvidia_p2p_mm_cache, mn),
+			0, ULONG_MAX);
+}
+
+static struct mmu_notifier *nvidia_p2p_cache_alloc(struct mm_struct *mm)
+{
+	struct nvidia_p2p_mm_cache *cache;
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache) {
+		return ERR_PTR(-ENOMEM);
+	}
+
+	spin_lock_init(&cache->lock);
+	INIT_LIST_HEAD(&cache->entries);
+
+	spin_lock(&nvidia_p2p_caches_lock);
+	list_add(&cache->node, &nvidia_p2p_caches);
+	spin_unlock(&nvidia_p2p_caches_lock);
+
+	return &cache->mn;
+}
+
+static void nvidia_p2p_cache_free_notifier(struct mmu_notifier *mn)
+{
+	struct nvidia_p2p_mm_cache *cache = container_of(mn,
+						struct nvidia_p2p_mm_cache,
+						mn);
+
+	spin_lock(&nvidia_p2p_caches_lock);
+	list_del(&cache->node);
+	spin_unlock(&nvidia_p2p_caches_lock);
+	kfree(cache);
+}
+
+static const struct mmu_notifier_ops nvidia_p2p_cache_ops = {
+	.release		= nvidia_p2p_cache_release,
+	.invalidate_range_start	= nvidia_p2p_cache_invl_range_start,
+	.alloc_notifier		= nvidia_p2p_cache_alloc,
+	.free_notifier		= nvidia_p2p_cache_free_notifier,
+};
+
+/* Takes the reference of the cache of current->mm used by one entry */
+static struct nvidia_p2p_mm_cache *nvidia_p2p_cache_get(void)
+{
+	struct mmu_notifier *mn;
+
+	if (!reg_cache_entries) {
+		return NULL;
+	}
+
+	mn = mmu_notifier_get(&nvidia_p2p_cache_ops, current->mm);
+	if (IS_ERR(mn)) {
+		return NULL;
+	}
+
+	return container_of(mn, struct nvidia_p2p_mm_cache, mn);
+}
+
+static void nvidia_p2p_cache_unget(struct nvidia_p2p_mm_cache *cache)
+{
+	mmu_notifier_put(&cache->mn);
+}
+
+/* Reuse an idle entry for the range, dropping the cache reference */
+static struct nvidia_p2p_cache_entry *nvidia_p2p_cache_lookup(
+		struct nvidia_p2p_mm_cache *cache, u64 vaddr, u64 size)
+{
+	struct nvidia_p2p_cache_entry *entry;
+
+	spin_lock(&cache->lock);
+	list_for_each_entry(entry, &cache->entries, node) {
+		if (!entry->in_use && !entry->stale &&
+		    entry->vaddr == vaddr && entry->size == size) {
+			entry->in_use = true;
+			cache->idle--;
+			spin_unlock(&cache->lock);
+			/* The entry already holds a reference */
+			nvidia_p2p_cache_unget(cache);
+			return entry;
+		}
+	}
+	spin_unlock(&cache->lock);
+
+	return NULL;
+}
+
+/*
+ * Track a newly pinned range, handing the cache reference to its entry.
+ * Invalidations since seq may have hit the range before it was tracked,
+ * so the entry is stale from the start then.
+ */
+static struct nvidia_p2p_cache_entry *nvidia_p2p_cache_add(
+		struct nvidia_p2p_mm_cache *cache, u32 seq, u64 vaddr, u64 size,
+		struct page **pages, u32 nr_pages)
+{
+	struct nvidia_p2p_cache_entry *entry;
+
+	entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+	if (!entry) {
+		nvidia_p2p_cache_unget(cache);
+		return NULL;
+	}
+
+	entry->cache = cache;
+	entry->vaddr = vaddr;
+	entry->size = size;
+	entry->pages = pages;
+	entry->entries = nr_pages;
+	entry->phys_page_size = nvidia_p2p_phys_page_size(vaddr, pages,
+							  nr_pages);
+	entry->in_use = true;
+
+	spin_lock(&cache->lock);
+	entry->stale = (cache->seq != seq);
+	list_add(&entry->node, &cache->entries);
+	spin_unlock(&cache->lock);
+
+	return entry;
+}
+
+/* Called with page_table->lock held */
+static void nvidia_p2p_cache_put(struct nvidia_p2p_page_table *page_table,
+		bool keep)
+{
+	struct nvidia_p2p_cache_entry *entry = page_table->cache_entry;
+	struct nvidia_p2p_cache_entry *victim;
+	struct nvidia_p2p_mm_cache *cache;
+	LIST_HEAD(evicted);
+
+	if (!entry) {
+		return;
+	}
+	cache = entry->cache;
+	page_table->cache_entry = NULL;
+
+	spin_lock(&cache->lock);
+	if (keep && !entry->stale && reg_cache_entries) {
+		entry->in_use = false;
+		list_move(&entry->node, &cache->entries);
+		cache->idle++;
+
+		/* Let the page table forget pages now owned by the cache */
+		page_table->pages = NULL;
+		page_table->mapped &= ~NVIDIA_P2P_PINNED;
+
+		/* Entries are kept most recently released first */
+		while (cache->idle > reg_cache_entries) {
+			list_for_each_entry_reverse(victim, &cache->entries, node) {
+				if (!victim->in_use)
+					break;
+			}
+			list_move(&victim->node, &evicted);
+			cache->idle--;
+		}
+		entry = NULL;
+	} else {
+		list_del(&entry->node);
+	}
+	spin_unlock(&cache->lock);
+
+	nvidia_p2p_cache_free(&evicted);
+
+	if (entry) {
+		/* The page table still owns and unpins the pages */
+		kfree(entry);
+		mmu_notifier_put(&cache->mn);
+	}
+}
+
+static void nvidia_p2p_cache_exit(void)
+{
+	struct nvidia_p2p_cache_entry *entry, *tmp;
+	struct nvidia_p2p_mm_cache *cache;
+	LIST_HEAD(idle);
+
+	spin_lock(&nvidia_p2p_caches_lock);
+	list_for_each_entry(cache, &nvidia_p2p_caches, node) {
+		spin_lock(&cache->lock);
+		list_for_each_entry_safe(entry, tmp, &cache->entries, node) {
+			if (!entry->in_use) {
+				list_move(&entry->node, &idle);
+			}
+		}
+		cache->idle = 0;
+		spin_unlock(&cache->lock);
+	}
+	spin_unlock(&nvidia_p2p_caches_lock);
+
+	nvidia_p2p_cache_free(&idle);
+	mmu_notifier_synchronize();
+}
+#else
+static inline struct nvidia_p2p_mm_cache *nvidia_p2p_cache_get(void)
+{
+	return NULL;
+}
+
+static inline void nvidia_p2p_cache_unget(struct nvidia_p2p_mm_cache *cache)
+{
+}
+
+static inline struct nvidia_p2p_cache_entry *nvidia_p2p_cache_lookup(
+		struct nvidia_p2p_mm_cache *cache, u64 vaddr, u64 size)
+{
+	return NULL;
+}
+
+static inline struct nvidia_p2p_cache_entry *nvidia_p2p_cache_add(
+		struct nvidia_p2p_mm_cache *cache, u32 seq, u64 vaddr, u64 size,
+		struct page **pages, u32 nr_pages)
+{
+	return NULL;
+}
+
+static inline void nvidia_p2p_cache_put(
+		struct nvidia_p2p_page_table *page_table, bool keep)
+{
+}
+
+static inline void nvidia_p2p_cache_exit(void)
+{
+}
+#endif
+
 static void nvidia_p2p_mn_release(struct mmu_notifier *mn,
 	struct mm_struct *mm)
 {
@@ -130,7 +483,10 @@ int nvidia_p2p_get_pages(u64 vaddr, u64 size,
 	int ret = 0;
 	int user_pages = 0;
 	int nr_pages = safe_cast_u64_to_s32(size >> PAGE_SHIFT);
+	struct nvidia_p2p_cache_entry *entry = NULL;
+	struct nvidia_p2p_mm_cache *cache;
 	struct page **pages;
+	u32 seq = 0;
 
 	if (nr_pages <= 0) {
 		return -EINVAL;
@@ -141,19 +497,40 @@ int nvidia_p2p_get_pages(u64 vaddr, u64 size,
 		return -ENOMEM;
 	}
 
+	cache = nvidia_p2p_cache_get();
+	if (cache) {
+		entry = nvidia_p2p_cache_lookup(cache, vaddr, size);
+		seq = READ_ONCE(cache->seq);
+	}
+
+	if (entry) {
+		pages = entry->pages;
+		user_pages = safe_cast_u32_to_s32(entry->entries);
+		goto pinned;
+	}
+
 	pages = kcalloc(nr_pages, sizeof(*pages), GFP_KERNEL);
 	if (!pages) {
 		ret = -ENOMEM;
-		goto free_page_table;
+		goto put_cache;
 	}
 
 	user_pages = safe_cast_s64_to_s32(get_user_pages_unlocked(vaddr & PAGE_MASK, nr_pages,
 					  pages, FOLL_WRITE | FOLL_FORCE));
 	if (user_pages != nr_pages) {
 		ret = user_pages < 0 ? user_pages : -ENOMEM;
+		if (cache) {
+			nvidia_p2p_cache_unget(cache);
+		}
 		goto free_pages;
 	}
 
+	if (cache) {
+		entry = nvidia_p2p_cache_add(cache, seq, vaddr, size, pages,
+					     user_pages);
+	}
+
+pinned:
 	(*page_table)->version = NVIDIA_P2P_PAGE_TABLE_VERSION;
 	(*page_table)->pages = pages;
 	(*page_table)->entries = user_pages;
@@ -167,9 +544,13 @@ int nvidia_p2p_get_pages(u64 vaddr, u64 size,
 	(*page_table)->vaddr = vaddr;
 	mutex_init(&(*page_table)->lock);
 	(*page_table)->mapped = NVIDIA_P2P_PINNED;
+	(*page_table)->cache_entry = entry;
+	(*page_table)->phys_page_size = entry ? entry->phys_page_size :
+		nvidia_p2p_phys_page_size(vaddr, pages, user_pages);
 
 	ret = mmu_notifier_register(&(*page_table)->mn, (*page_table)->mm);
 	if (ret) {
+		nvidia_p2p_cache_put(*page_table, false);
 		goto free_pages;
 	}
 
@@ -179,6 +560,11 @@ free_pages:
 		put_page(pages[user_pages]);
 	}
 	kfree(pages);
+	goto free_page_table;
+put_cache:
+	if (cache) {
+		nvidia_p2p_cache_unget(cache);
+	}
 free_page_table:
 	kfree(*page_table);
 	*page_table = NULL;
@@ -192,6 +578,13 @@ int nvidia_p2p_put_pages(struct nvidia_p2p_page_table *page_table)
 		return -EINVAL;
 	}
 
+	/* Keep the pages of an unmapped range pinned for reuse */
+	mutex_lock(&page_table->lock);
+	nvidia_p2p_cache_put(page_table,
+		(page_table->mapped & (NVIDIA_P2P_PINNED | NVIDIA_P2P_MAPPED)) ==
+		NVIDIA_P2P_PINNED);
+	mutex_unlock(&page_table->lock);
+
 	mmu_notifier_unregister(&page_table->mn, page_table->mm);
 
 	return 0;
@@ -213,6 +606,8 @@ int nvidia_p2p_free_page_table(struct nvidia_p2p_page_table *page_table)
 		WARN(1, "Attempting to free unmapped pages");
 	}
 
+	nvidia_p2p_cache_put(page_table, false);
+
 	if (page_table->mapped & NVIDIA_P2P_PINNED) {
 		pages = page_table->pages;
 		user_pages = safe_cast_u32_to_s32(page_table->entries);
@@ -240,6 +635,9 @@ int nvidia_p2p_dma_map_pages(struct device *dev,
 	struct scatterlist *sg;
 	struct page **pages = NULL;
 	u32 nr_pages = 0;
+	u64 max_seg;
+	dma_addr_t addr;
+	u32 len, n = 0;
 	int ret = 0;
 	int i, count;
 
@@ -280,6 +678,7 @@ int nvidia_p2p_dma_map_pages(struct device *dev,
 
 	count = dma_map_sg(dev, sgt->sgl, sgt->nents, direction);
 	if (count < 1) {
+		ret = -EIO;
 		goto free_sg_table;
 	}
 
@@ -296,10 +695,27 @@ int nvidia_p2p_dma_map_pages(struct device *dev,
 		goto free_hw_address;
 	}
 
+	/*
+	 * Hand out runs that are contiguous in the device address space as
+	 * one entry, up to the max segment size of the peer device.
+	 */
+	max_seg = dma_get_max_seg_size(dev);
 	for_each_sg(sgt->sgl, sg, count, i) {
-		(*dma_mapping)->hw_address[i] = sg_dma_address(sg);
-		(*dma_mapping)->hw_len[i] = sg_dma_len(sg);
+		addr = sg_dma_address(sg);
+		len = sg_dma_len(sg);
+
+		if (n && ((*dma_mapping)->hw_address[n - 1] +
+			  (*dma_mapping)->hw_len[n - 1] == addr) &&
+		    ((u64)(*dma_mapping)->hw_len[n - 1] + len <= max_seg)) {
+			(*dma_mapping)->hw_len[n - 1] += len;
+			continue;
+		}
+
+		(*dma_mapping)->hw_address[n] = addr;
+		(*dma_mapping)->hw_len[n] = len;
+		n++;
 	}
+	(*dma_mapping)->entries = n;
 	(*dma_mapping)->page_table->mapped |= NVIDIA_P2P_MAPPED;
 	mutex_unlock(&page_table->lock);
 
@@ -360,3 +776,9 @@ int nvidia_p2p_free_dma_mapping(struct nvidia_p2p_dma_mapping *dma_mapping)
 	return nvidia_p2p_dma_unmap_pages(dma_mapping);
 }
 EXPORT_SYMBOL(nvidia_p2p_free_dma_mapping);
+
+static void __exit nvidia_p2p_exit(void)
+{
+	nvidia_p2p_cache_exit();
+}
+module_exit(nvidia_p2p_exit);
@@ -4,6 +4,7 @@
 #include <linux/clk.h>
 #include <linux/kobject.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
 #include <linux/printk.h>
@@ -21,11 +22,28 @@ struct nvpmodel_clk {
 
 struct nvpmodel_clk_cap {
 	struct kobject *clk_cap_kobject;
+	struct kobj_attribute caps_attr;
 	struct nvpmodel_clk *clks;
 	struct tegra_bpmp *bpmp;
 	int num_clocks;
 };
 
+/* One clock of a cap set written to the caps attribute */
+struct nvpmodel_clk_req {
+	unsigned long rate;
+	long prev_rate;
+	bool requested;
+	bool applied;
+};
+
+/* Serializes the per-clock cap writes against the cap set writes */
+static DEFINE_MUTEX(clk_cap_lock);
+
+static bool nvpmodel_clk_is_emc(struct nvpmodel_clk *nvpm_clk)
+{
+	return !strncmp(nvpm_clk->attr.attr.name, "emc", strlen("emc"));
+}
+
 static ssize_t ccf_set_max_rate(struct clk *clk, unsigned long rate)
 {
 	int ret = 0;
@@ -82,17 +100,10 @@ static ssize_t clk_cap_show(struct kobject *kobj, struct kobj_attribute *attr, c
 	return sprintf(buf, "%ld\n", rate);
 }
 
-static ssize_t clk_cap_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf,
-			     size_t count)
+static ssize_t __clk_cap_store(struct nvpmodel_clk *nvpm_clk, unsigned long rate, size_t count)
 {
 	int ccf_ret, bpmp_ret;
 	long prev_max_rate, rounded_max_rate;
-	unsigned long rate;
-	struct nvpmodel_clk *nvpm_clk = container_of(attr, struct nvpmodel_clk, attr);
-
-	ccf_ret = kstrtoul(buf, 0, &rate);
-	if (ccf_ret)
-		return ccf_ret;
 
 	/* Store previous max freq in case of later failure */
 	prev_max_rate = clk_round_rate(nvpm_clk->clk, S64_MAX);
@@ -105,7 +116,7 @@ static ssize_t clk_cap_store(struct kobject *kobj, struct kobj_attribute *attr,
 		return ccf_ret;
 
 	/* Early return for the clocks that do not require additional BPMP MRQ involvement */
-	if (strncmp(nvpm_clk->attr.attr.name, "emc", strlen("emc")))
+	if (!nvpmodel_clk_is_emc(nvpm_clk))
 		return count;
 
 	/*
@@ -140,6 +151,181 @@ static ssize_t clk_cap_store(struct kobject *kobj, struct kobj_attribute *attr,
 	return count;
 }
 
+static ssize_t clk_cap_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf,
+			     size_t count)
+{
+	struct nvpmodel_clk *nvpm_clk = container_of(attr, struct nvpmodel_clk, attr);
+	unsigned long rate;
+	ssize_t ret;
+
+	ret = kstrtoul(buf, 0, &rate);
+	if (ret)
+		return ret;
+
+	mutex_lock(&clk_cap_lock);
+	ret = __clk_cap_store(nvpm_clk, rate, count);
+	mutex_unlock(&clk_cap_lock);
+
+	return ret;
+}
+
+static ssize_t clk_caps_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	struct nvpmodel_clk_cap *nvpm_clk_cap = container_of(attr, struct nvpmodel_clk_cap,
+							     caps_attr);
+	struct nvpmodel_clk *nvpm_clk;
+	ssize_t len = 0;
+	long rate;
+	int i;
+
+	for (i = 0; i < nvpm_clk_cap->num_clocks; i++) {
+		nvpm_clk = &nvpm_clk_cap->clks[i];
+		if (!nvpm_clk->clk || !nvpm_clk->attr.attr.name)
+			continue;
+
+		rate = clk_round_rate(nvpm_clk->clk, S64_MAX);
+		if (rate < 0)
+			return rate;
+
+		len += sysfs_emit_at(buf, len, "%s%s=%ld", len ? " " : "",
+				     nvpm_clk->attr.attr.name, rate);
+	}
+
+	len += sysfs_emit_at(buf, len, "\n");
+
+	return len;
+}
+
+/*
+ * Applies a whole power mode in one write of "<clock>=<rate> ..." pairs.
+ * The set is parsed and validated before anything is changed. Lowered caps
+ * are applied before raised ones, so that the intermediate states never run
+ * more clocks high than either the old or the new mode does, and unchanged
+ * caps are skipped. EMC is capped in BPMP once, after the CCF caps are in
+ * place. On failure the caps already applied are rolled back.
+ */
+static ssize_t clk_caps_store(struct kobject *kobj, struct kobj_attribute *attr, const char *buf,
+			      size_t count)
+{
+	struct nvpmodel_clk_cap *nvpm_clk_cap = container_of(attr, struct nvpmodel_clk_cap,
+							     caps_attr);
+	int num = nvpm_clk_cap->num_clocks;
+	struct nvpmodel_clk *nvpm_clk, *emc = NULL;
+	struct nvpmodel_clk_req *reqs;
+	char *str, *cur, *tok, *val;
+	int i, pass, ret = 0;
+	long emc_rate;
+
+	reqs = kcalloc(num, sizeof(*reqs), GFP_KERNEL);
+	str = kstrdup(buf, GFP_KERNEL);
+	if (!reqs || !str) {
+		ret = -ENOMEM;
+		goto free;
+	}
+
+	cur = str;
+	while ((tok = strsep(&cur, " \t\n")) != NULL) {
+		if (!*tok)
+			continue;
+
+		val = strchr(tok, '=');
+		if (!val) {
+			ret = -EINVAL;
+			goto free;
+		}
+		*val++ = '\0';
+
+		for (i = 0; i < num; i++) {
+			nvpm_clk = &nvpm_clk_cap->clks[i];
+			if (nvpm_clk->clk && nvpm_clk->attr.attr.name &&
+			    !strcmp(nvpm_clk->attr.attr.name, tok))
+				break;
+		}
+
+		if (i == num) {
+			pr_debug("Unknown clock %s in cap set\n", tok);
+			ret = -EINVAL;
+			goto free;
+		}
+
+		ret = kstrtoul(val, 0, &reqs[i].rate);
+		if (ret)
+			goto free;
+
+		reqs[i].requested = true;
+	}
+
+	mutex_lock(&clk_cap_lock);
+
+	for (i = 0; i < num; i++) {
+		if (!reqs[i].requested)
+			continue;
+
+		reqs[i].prev_rate = clk_round_rate(nvpm_clk_cap->clks[i].clk, S64_MAX);
+		if (reqs[i].prev_rate < 0) {
+			ret = reqs[i].prev_rate;
+			goto unlock;
+		}
+	}
+
+	/* pass 0 lowers caps, pass 1 raises them */
+	for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i < num; i++) {
+			if (!reqs[i].requested ||
+			    reqs[i].rate == (unsigned long)reqs[i].prev_rate)
+				continue;
+			if ((pass == 0) != (reqs[i].rate < (unsigned long)reqs[i].prev_rate))
+				continue;
+
+			nvpm_clk = &nvpm_clk_cap->clks[i];
+			ret = ccf_set_max_rate(nvpm_clk->clk, reqs[i].rate);
+			if (ret) {
+				pr_debug("CCF failed to cap %s\n", nvpm_clk->attr.attr.name);
+				goto rollback;
+			}
+
+			reqs[i].applied = true;
+			if (nvpmodel_clk_is_emc(nvpm_clk))
+				emc = nvpm_clk;
+		}
+	}
+
+	if (emc) {
+		emc_rate = clk_round_rate(emc->clk, S64_MAX);
+		if (emc_rate < 0) {
+			ret = emc_rate;
+			goto rollback;
+		}
+
+		ret = bpmp_set_emc_cap_rate(emc->bpmp, emc_rate);
+		if (ret) {
+			pr_debug("BPMP failed to update emc max rate\n");
+			goto rollback;
+		}
+	}
+
+	mutex_unlock(&clk_cap_lock);
+	ret = count;
+	goto free;
+
+rollback:
+	for (i = num - 1; i >= 0; i--) {
+		if (!reqs[i].applied)
+			continue;
+
+		if (ccf_set_max_rate(nvpm_clk_cap->clks[i].clk, reqs[i].prev_rate))
+			pr_debug("CCF failed to restore previous max rate for %s\n",
+				 nvpm_clk_cap->clks[i].attr.attr.name);
+	}
+unlock:
+	mutex_unlock(&clk_cap_lock);
+free:
+	kfree(str);
+	kfree(reqs);
+
+	return ret;
+}
+
 static const struct of_device_id of_nvpmodel_clk_cap_match[] = {
 	{ .compatible = "nvidia,nvpmodel", },
 	{},
@@ -227,6 +413,14 @@ static int nvpmodel_clk_cap_probe(struct platform_device *pdev)
 		}
 	}
 
+	sysfs_attr_init(&nvpm_clk_cap->caps_attr.attr);
+	nvpm_clk_cap->caps_attr.attr.name = "caps";
+	nvpm_clk_cap->caps_attr.attr.mode = 0664;
+	nvpm_clk_cap->caps_attr.show = clk_caps_show;
+	nvpm_clk_cap->caps_attr.store = clk_caps_store;
+	if (sysfs_create_file(nvpm_clk_cap->clk_cap_kobject, &nvpm_clk_cap->caps_attr.attr))
+		dev_warn(&pdev->dev, "Couldn't create clock cap set sysfs\n");
+
 	return ret;
 
 put_bpmp:
@@ -245,6 +439,8 @@ static int nvpmodel_clk_cap_remove(struct platform_device *pdev)
 
 	tegra_bpmp_put(nvpm_clk_cap->bpmp);
 
+	sysfs_remove_file(nvpm_clk_cap->clk_cap_kobject, &nvpm_clk_cap->caps_attr.attr);
+
 	if (nvpm_clk_cap->clks) {
 		for (i = 0; i < nvpm_clk_cap->num_clocks; i++) {
 			if ((nvpm_clk_cap->clks)[i].attr.attr.name)
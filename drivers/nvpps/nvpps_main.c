@@ -9,6 +9,8 @@
 #include <linux/platform_device.h>
 #include <linux/module.h>
 #include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
 #include <linux/cdev.h>
 #include <linux/poll.h>
 #include <linux/gpio.h>
@@ -93,6 +95,8 @@ struct nvpps_device_data {
 	uint16_t	lock_threshold_val;
 	struct hte_ts_desc	desc;
 	struct gpio_desc	*gpio_in;
+	/* event history shared with userspace, written under lock */
+	struct nvpps_ring	*ring;
 };
 
 
@@ -235,6 +239,38 @@ static inline u64 get_systime(struct nvpps_device_data *pdev_data, u64 *tsc)
 	return ns;
 }
 
+/*
+ * Append the current event to the ring, must be called with lock held
+ */
+static void nvpps_ring_put(struct nvpps_device_data *pdev_data, u64 sys_ns)
+{
+	struct nvpps_ring	*ring = pdev_data->ring;
+	struct nvpps_ring_event	*ev;
+	u64			head;
+
+	if (!ring)
+		return;
+
+	head = ring->head;
+	ev = &ring->events[head % NVPPS_RING_EVENTS];
+
+	WRITE_ONCE(ev->seq, ev->seq + 1);
+	smp_wmb();
+
+	ev->evt_nb = pdev_data->pps_event_id;
+	ev->evt_mode = pdev_data->actual_evt_mode;
+	ev->tsc = pdev_data->tsc;
+	ev->ptp = pdev_data->phc;
+	ev->secondary_ptp = pdev_data->secondary_phc;
+	ev->irq_latency = pdev_data->irq_latency;
+	ev->sys_ns = sys_ns;
+
+	smp_wmb();
+	WRITE_ONCE(ev->seq, ev->seq + 1);
+
+	smp_store_release(&ring->head, head + 1);
+}
+
 /*
  * Report the PPS event
  */
@@ -244,6 +280,7 @@ static void nvpps_get_ts(struct nvpps_device_data *pdev_data, u64 irq_tsc)
 	u64		phc = 0;
 	u64		secondary_phc = 0;
 	u64		irq_latency = 0;
+	u64		sys_ns;
 	unsigned long	flags;
 	struct ptp_tsc_data ptp_tsc_ts = {0}, sec_ptp_tsc_ts = {0};
 
@@ -314,6 +351,8 @@ static void nvpps_get_ts(struct nvpps_device_data *pdev_data, u64 irq_tsc)
 		irq_latency = (tsc - irq_tsc) * pdev_data->tsc_res_ns;
 	}
 
+	sys_ns = ktime_get_real_ns();
+
 	raw_spin_lock_irqsave(&pdev_data->lock, flags);
 	pdev_data->pps_event_id_valid = true;
 	pdev_data->pps_event_id++;
@@ -330,6 +369,7 @@ static void nvpps_get_ts(struct nvpps_device_data *pdev_data, u64 irq_tsc)
 	 * irq_latency will be 0 if TIMER mode,  >0 if GPIO mode
 	 */
 	pdev_data->secondary_phc = secondary_phc ? secondary_phc - irq_latency : secondary_phc;
+	nvpps_ring_put(pdev_data, sys_ns);
 	raw_spin_unlock_irqrestore(&pdev_data->lock, flags);
 
 	/* event notification */
@@ -742,8 +782,31 @@ static int nvpps_close(struct inode *inode, struct file *file)
 
 
 
+static int nvpps_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct nvpps_file_data		*pfile_data = (struct nvpps_file_data *)file->private_data;
+	struct nvpps_device_data	*pdev_data = pfile_data->pdev_data;
+
+	if (!pdev_data->ring)
+		return -ENODEV;
+
+	if ((vma->vm_flags & VM_WRITE) || vma->vm_pgoff != 0)
+		return -EINVAL;
+
+#if defined(NV_VM_AREA_STRUCT_HAS_CONST_VM_FLAGS) /* Linux v6.3 */
+	vm_flags_clear(vma, VM_MAYWRITE);
+#else
+	vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+
+	return remap_vmalloc_range(vma, pdev_data->ring, 0);
+}
+
+
+
 static const struct file_operations nvpps_fops = {
 	.owner		= THIS_MODULE,
+	.mmap		= nvpps_mmap,
 	.poll		= nvpps_poll,
 	.fasync		= nvpps_fasync,
 	.unlocked_ioctl	= nvpps_ioctl,
@@ -763,6 +826,7 @@ static void nvpps_dev_release(struct device *dev)
 	idr_remove(&s_nvpps_idr, pdev_data->id);
 	mutex_unlock(&s_nvpps_lock);
 
+	vfree(pdev_data->ring);
 	kfree(dev);
 }
 
@@ -1051,10 +1115,21 @@ static int nvpps_probe(struct platform_device *pdev)
 	devt = MKDEV(MAJOR(s_nvpps_devt), pdev_data->id);
 	pdev_data->cdev.owner = THIS_MODULE;
 
+	/* event history, freed with the device, the driver works without it */
+	pdev_data->ring = vmalloc_user(sizeof(struct nvpps_ring));
+	if (pdev_data->ring) {
+		pdev_data->ring->num_events = NVPPS_RING_EVENTS;
+		pdev_data->ring->tsc_res_ns = pdev_data->tsc_res_ns;
+	} else {
+		dev_warn(&pdev->dev, "failed to allocate event ring\n");
+	}
+
 	/* create the device node */
 	pdev_data->dev = device_create(s_nvpps_class, NULL, devt, pdev_data, "nvpps%d", pdev_data->id);
 	if (IS_ERR(pdev_data->dev)) {
 		err = PTR_ERR(pdev_data->dev);
+		vfree(pdev_data->ring);
+		pdev_data->ring = NULL;
 		goto error_ret;
 	}
 
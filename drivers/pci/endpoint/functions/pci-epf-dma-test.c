@@ -74,11 +74,8 @@ static void edma_lib_test_raise_irq(void *p)
 	lpci_epc_raise_irq(epfnv->epc, epfnv->epf->func_no, PCI_EPC_IRQ_MSI, 1);
 }
 
-/* debugfs to perform eDMA lib transfers and do CRC check */
-static int edmalib_test(struct seq_file *s, void *data)
+static int edmalib_prepare(struct pcie_epf_dma *epfnv)
 {
-	struct pcie_epf_dma *epfnv = (struct pcie_epf_dma *)
-						dev_get_drvdata(s->private);
 	struct pcie_epf_bar0 *epf_bar0 = (struct pcie_epf_bar0 *)
 						epfnv->bar0_virt;
 
@@ -101,13 +98,39 @@ static int edmalib_test(struct seq_file *s, void *data)
 	epfnv->edma.priv = (void *)epfnv;
 	epfnv->edma.raise_irq = edma_lib_test_raise_irq;
 
+	return 0;
+}
+
+/* debugfs to perform eDMA lib transfers and do CRC check */
+static int edmalib_test(struct seq_file *s, void *data)
+{
+	struct pcie_epf_dma *epfnv = (struct pcie_epf_dma *)
+						dev_get_drvdata(s->private);
+
+	if (edmalib_prepare(epfnv))
+		return -1;
+
 	return edmalib_common_test(&epfnv->edma);
 }
 
+/* debugfs to benchmark eDMA lib transfers */
+static int edmalib_bench(struct seq_file *s, void *data)
+{
+	struct pcie_epf_dma *epfnv = (struct pcie_epf_dma *)
+						dev_get_drvdata(s->private);
+
+	if (edmalib_prepare(epfnv))
+		return -1;
+
+	return edmalib_common_bench(&epfnv->edma, s);
+}
+
 static void init_debugfs(struct pcie_epf_dma *epfnv)
 {
 	debugfs_create_devm_seqfile(epfnv->fdev, "edmalib_test", epfnv->debugfs,
 				    edmalib_test);
+	debugfs_create_devm_seqfile(epfnv->fdev, "edmalib_bench", epfnv->debugfs,
+				    edmalib_bench);
 
 	debugfs_create_u32("dma_size", 0644, epfnv->debugfs, &epfnv->dma_size);
 	epfnv->dma_size = SZ_1M;
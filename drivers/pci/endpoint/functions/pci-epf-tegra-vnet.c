@@ -606,18 +606,16 @@ static netdev_tx_t tvnet_ep_start_xmit(struct sk_buff *skb,
 	struct dma_desc_cnt *desc_cnt = &tvnet->desc_cnt;
 	struct tvnet_dma_desc *ep_dma_virt =
 				(struct tvnet_dma_desc *)tvnet->ep_dma_virt;
-	u32 desc_widx, desc_ridx, val, ctrl_d;
+	u32 desc_widx, desc_ridx, val, ctrl_d, off;
 	unsigned long timeout;
+	int i;
 #else
 	int ret;
 #endif
-	dma_addr_t src_iova;
+	struct tvnet_tx_seg seg[TVNET_TX_MAX_SEGS];
 	u32 rd_idx, wr_idx;
 	u64 dst_masked, dst_off, dst_iova;
-	int dst_len, len;
-
-	/*TODO Not expecting skb frags, remove this after testing */
-	WARN_ON(info->nr_frags);
+	int dst_len, len, nsegs;
 
 	/* Check if EP2H_EMPTY_BUF available to read */
 	if (!tvnet_ivc_rd_available(&tvnet->ep2h_empty)) {
@@ -644,19 +642,25 @@ static netdev_tx_t tvnet_ep_start_xmit(struct sk_buff *skb,
 	}
 
 #if ENABLE_DMA
-	/* Check if dma desc available */
-	if ((desc_cnt->wr_cnt - desc_cnt->rd_cnt) >= DMA_DESC_COUNT) {
+	/* Check if dma desc available for linear part and all frags */
+	if ((desc_cnt->wr_cnt - desc_cnt->rd_cnt) + info->nr_frags + 1 >
+	    DMA_DESC_COUNT) {
 		dev_dbg(fdev, "%s: dma descs are not available\n", __func__);
 		netif_stop_queue(ndev);
 		return NETDEV_TX_BUSY;
 	}
 #endif
 
-	len = skb_headlen(skb);
+	if (skb->ip_summed == CHECKSUM_PARTIAL && skb_checksum_help(skb)) {
+		dev_kfree_skb_any(skb);
+		return NETDEV_TX_OK;
+	}
+
+	len = skb->len;
 
-	src_iova = dma_map_single(cdev, skb->data, len, DMA_TO_DEVICE);
-	if (dma_mapping_error(cdev, src_iova)) {
-		dev_err(fdev, "%s: dma_map_single failed\n", __func__);
+	nsegs = tvnet_map_skb(cdev, skb, seg);
+	if (nsegs < 0) {
+		dev_err(fdev, "%s: skb dma map failed\n", __func__);
 		dev_kfree_skb_any(skb);
 		return NETDEV_TX_OK;
 	}
@@ -683,7 +687,7 @@ static netdev_tx_t tvnet_ep_start_xmit(struct sk_buff *skb,
 #endif
 	if (ret < 0) {
 		dev_err(fdev, "failed to map dst addr to PCIe addr range\n");
-		dma_unmap_single(cdev, src_iova, len, DMA_TO_DEVICE);
+		tvnet_unmap_skb(cdev, skb, seg, nsegs);
 		dev_kfree_skb_any(skb);
 		return NETDEV_TX_OK;
 	}
@@ -695,25 +699,37 @@ static netdev_tx_t tvnet_ep_start_xmit(struct sk_buff *skb,
 	tvnet_ivc_advance_rd(&tvnet->ep2h_empty);
 
 #if ENABLE_DMA
-	/* Trigger DMA write from src_iova to dst_iova */
-	desc_widx = desc_cnt->wr_cnt % DMA_DESC_COUNT;
-	ep_dma_virt[desc_widx].size = len;
-	ep_dma_virt[desc_widx].sar_low = lower_32_bits(src_iova);
-	ep_dma_virt[desc_widx].sar_high = upper_32_bits(src_iova);
-	ep_dma_virt[desc_widx].dar_low = lower_32_bits(dst_iova);
-	ep_dma_virt[desc_widx].dar_high = upper_32_bits(dst_iova);
+	/*
+	 * Scatter skb segments to dst_iova, one link list element per segment
+	 * and a single doorbell for the whole packet.
+	 */
+	off = 0;
+	for (i = 0; i < nsegs; i++) {
+		desc_widx = (desc_cnt->wr_cnt + i) % DMA_DESC_COUNT;
+		ep_dma_virt[desc_widx].size = seg[i].len;
+		ep_dma_virt[desc_widx].sar_low = lower_32_bits(seg[i].iova);
+		ep_dma_virt[desc_widx].sar_high = upper_32_bits(seg[i].iova);
+		ep_dma_virt[desc_widx].dar_low = lower_32_bits(dst_iova + off);
+		ep_dma_virt[desc_widx].dar_high = upper_32_bits(dst_iova + off);
+		off += seg[i].len;
+	}
 	/* CB bit should be set at the end */
 	mb();
-	ctrl_d = DMA_CH_CONTROL1_OFF_WRCH_LIE;
-	ctrl_d |= DMA_CH_CONTROL1_OFF_WRCH_CB;
-	ep_dma_virt[desc_widx].ctrl_reg.ctrl_d = ctrl_d;
+	for (i = 0; i < nsegs; i++) {
+		desc_widx = (desc_cnt->wr_cnt + i) % DMA_DESC_COUNT;
+		ctrl_d = DMA_CH_CONTROL1_OFF_WRCH_CB;
+		/* Only last element reports completion */
+		if (i == nsegs - 1)
+			ctrl_d |= DMA_CH_CONTROL1_OFF_WRCH_LIE;
+		ep_dma_virt[desc_widx].ctrl_reg.ctrl_d = ctrl_d;
+	}
 
 	/* DMA write should not go out of order wrt CB bit set */
 	mb();
 
 	timeout = jiffies + msecs_to_jiffies(1000);
 	dma_common_wr8(tvnet->dma_base, DMA_WR_DATA_CH, DMA_WRITE_DOORBELL_OFF);
-	desc_cnt->wr_cnt++;
+	desc_cnt->wr_cnt += nsegs;
 
 	while (true) {
 		val = dma_common_rd(tvnet->dma_base, DMA_WRITE_INT_STATUS_OFF);
@@ -731,26 +747,28 @@ static netdev_tx_t tvnet_ep_start_xmit(struct sk_buff *skb,
 			dma_common_wr(tvnet->dma_base,
 				      DMA_WRITE_ENGINE_EN_OFF_ENABLE,
 				      DMA_WRITE_ENGINE_EN_OFF);
-			desc_cnt->wr_cnt--;
+			desc_cnt->wr_cnt -= nsegs;
 #if (LINUX_VERSION_CODE > KERNEL_VERSION(4, 15, 0))
 			lpci_epc_unmap_addr(epc, epf->func_no, tvnet->tx_dst_pci_addr);
 #else
 			pci_epc_unmap_addr(epc, tvnet->tx_dst_pci_addr);
 #endif
-			dma_unmap_single(cdev, src_iova, len, DMA_TO_DEVICE);
+			tvnet_unmap_skb(cdev, skb, seg, nsegs);
 			return NETDEV_TX_BUSY;
 		}
 	}
 
-	desc_ridx = tvnet->desc_cnt.rd_cnt % DMA_DESC_COUNT;
-	/* Clear DMA cycle bit and increment rd_cnt */
-	ep_dma_virt[desc_ridx].ctrl_reg.ctrl_e.cb = 0;
+	/* Clear DMA cycle bit of all elements and advance rd_cnt */
+	for (i = 0; i < nsegs; i++) {
+		desc_ridx = (tvnet->desc_cnt.rd_cnt + i) % DMA_DESC_COUNT;
+		ep_dma_virt[desc_ridx].ctrl_reg.ctrl_e.cb = 0;
+	}
 	mb();
 
-	tvnet->desc_cnt.rd_cnt++;
+	tvnet->desc_cnt.rd_cnt += nsegs;
 #else
-	/* Copy skb->data to host dst address, use CPU virt addr */
-	memcpy((void *)(tvnet->tx_dst_va + dst_off), skb->data, len);
+	/* Copy skb data to host dst address, use CPU virt addr */
+	skb_copy_bits(skb, 0, (void *)(tvnet->tx_dst_va + dst_off), len);
 	/*
 	 * tx_dst_va is ioremap_wc() mem, add mb to make sure complete skb->data
 	 * written to dst before adding it to full buffer
@@ -772,7 +790,7 @@ static netdev_tx_t tvnet_ep_start_xmit(struct sk_buff *skb,
 	pci_epc_unmap_addr(epc, tvnet->tx_dst_pci_addr);
 #endif
 #endif
-	dma_unmap_single(cdev, src_iova, len, DMA_TO_DEVICE);
+	tvnet_unmap_skb(cdev, skb, seg, nsegs);
 	dev_kfree_skb_any(skb);
 	schedule_work(&tvnet->raise_irq_work);
 
@@ -1891,6 +1909,11 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	netif_napi_add(ndev, &tvnet->napi, tvnet_ep_poll, TVNET_NAPI_WEIGHT);
 #endif
 	ndev->mtu = TVNET_DEFAULT_MTU;
+#if ENABLE_DMA
+	/* Frags are scattered by EP DMA, checksum is resolved in xmit */
+	ndev->hw_features = NETIF_F_SG | NETIF_F_HW_CSUM;
+	ndev->features |= ndev->hw_features;
+#endif
 
 	ret = register_netdev(ndev);
 	if (ret < 0) {
@@ -1899,6 +1922,16 @@ static int tvnet_ep_pci_epf_bind(struct pci_epf *epf)
 	}
 	netif_carrier_off(ndev);
 
+#if defined(NV_DEV_SET_THREADED_PRESENT) /* Linux v5.12 */
+	/*
+	 * Run the data NAPI in its own kthread so that Rx processing is not
+	 * pinned to the CPU servicing the data syncpoint interrupt.
+	 */
+	ret = dev_set_threaded(ndev, true);
+	if (ret)
+		dev_warn(fdev, "threaded NAPI not enabled: %d\n", ret);
+#endif
+
 	tvnet->rx_link_state = DIR_LINK_STATE_DOWN;
 	tvnet->tx_link_state = DIR_LINK_STATE_DOWN;
 	tvnet->os_link_state = OS_LINK_STATE_DOWN;
@@ -150,6 +150,16 @@ static inline int tegra_aon_debugfs_create(struct tegra_aon *aon) { return 0; }
 static inline void tegra_aon_debugfs_remove(struct tegra_aon *aon) { return; }
 #endif
 
+struct ivc;
+struct tegra_aon_stream;
+
+struct tegra_aon_stream *tegra_aon_stream_create(struct tegra_aon *aon,
+						 struct ivc *ivc,
+						 const char *name,
+						 u32 rx_off, u32 rx_size);
+void tegra_aon_stream_destroy(struct tegra_aon_stream *stream);
+void tegra_aon_stream_notify(struct tegra_aon_stream *stream);
+
 int tegra_aon_reset(struct tegra_aon *aon);
 int tegra_aon_mail_init(struct tegra_aon *aon);
 int tegra_aon_ipc_init(struct tegra_aon *aon);
@@ -29,6 +29,11 @@ struct tegra_aon_ivc_chan {
 	int chan_id;
 	struct tegra_aon *aon;
 	bool last_tx_done;
+	/* nvidia,stream channels are exported to userspace, not mbox clients */
+	bool is_stream;
+	u32 rx_off;
+	u32 rx_size;
+	struct tegra_aon_stream *stream;
 };
 
 static struct tegra_aon_ivc aon_ivc;
@@ -88,7 +93,11 @@ static int tegra_aon_mbox_send_data(struct mbox_chan *mbox_chan, void *data)
 
 static int tegra_aon_mbox_startup(struct mbox_chan *mbox_chan)
 {
-	return 0;
+	struct tegra_aon_ivc_chan *ivc_chan;
+
+	ivc_chan = (struct tegra_aon_ivc_chan *)mbox_chan->con_priv;
+
+	return ivc_chan->is_stream ? -EBUSY : 0;
 }
 
 static void tegra_aon_mbox_shutdown(struct mbox_chan *mbox_chan)
@@ -139,6 +148,12 @@ static void tegra_aon_rx_handler(u32 ivc_chans)
 		ivc_chans &= ~BIT(i);
 		mbox_chan = &aon_ivc.mbox.chans[i];
 		ivc_chan = (struct tegra_aon_ivc_chan *)mbox_chan->con_priv;
+		/* stream frames are consumed in place by userspace */
+		if (ivc_chan->is_stream) {
+			if (ivc_chan->stream)
+				tegra_aon_stream_notify(ivc_chan->stream);
+			continue;
+		}
 		/* check if mailbox client exists */
 		if (ivc_chan->chan_id == -1)
 			continue;
@@ -240,6 +255,21 @@ static int tegra_aon_parse_channel(struct tegra_aon *aon,
 
 	ivc_chan->chan_id = chan_id;
 
+	/*
+	 * The rx queue of a stream channel is mapped to userspace, it must
+	 * not share a page with anything else in the ipc buffer.
+	 */
+	if (of_property_read_bool(ch_node, NV("stream"))) {
+		if (!PAGE_ALIGNED(start.rx) || !PAGE_ALIGNED(end.rx)) {
+			dev_err(dev, "stream channel %s rx queue not page aligned\n",
+				ch_node->name);
+			return -EINVAL;
+		}
+		ivc_chan->is_stream = true;
+		ivc_chan->rx_off = start.rx;
+		ivc_chan->rx_size = end.rx - start.rx;
+	}
+
 	/* Allocate the IVC links */
 	ret = tegra_ivc_init(&ivc_chan->ivc,
 				 (unsigned long)aon->ipcbuf + start.rx,
@@ -346,6 +376,45 @@ static int tegra_aon_parse_channels(struct tegra_aon *aon)
 	return tegra_aon_validate_channels(dev);
 }
 
+static void tegra_aon_destroy_streams(void)
+{
+	struct tegra_aon_ivc_chan *ivc_chan;
+	int i;
+
+	for (i = 0; i < aon_ivc.mbox.num_chans; i++) {
+		ivc_chan = aon_ivc.mbox.chans[i].con_priv;
+		if (ivc_chan && ivc_chan->stream) {
+			tegra_aon_stream_destroy(ivc_chan->stream);
+			ivc_chan->stream = NULL;
+		}
+	}
+}
+
+static int tegra_aon_create_streams(struct tegra_aon *aon)
+{
+	struct tegra_aon_ivc_chan *ivc_chan;
+	struct tegra_aon_stream *stream;
+	int i;
+
+	for (i = 0; i < aon_ivc.mbox.num_chans; i++) {
+		ivc_chan = aon_ivc.mbox.chans[i].con_priv;
+		if (!ivc_chan->is_stream)
+			continue;
+
+		stream = tegra_aon_stream_create(aon, &ivc_chan->ivc,
+						 ivc_chan->name,
+						 ivc_chan->rx_off,
+						 ivc_chan->rx_size);
+		if (IS_ERR(stream)) {
+			tegra_aon_destroy_streams();
+			return PTR_ERR(stream);
+		}
+		ivc_chan->stream = stream;
+	}
+
+	return 0;
+}
+
 static int tegra_aon_count_ivc_channels(struct device_node *dev_node)
 {
 	int num = 0;
@@ -412,6 +481,15 @@ int tegra_aon_mail_init(struct tegra_aon *aon)
 		goto exit;
 	}
 
+	ret = tegra_aon_create_streams(aon);
+	if (ret) {
+		dev_err(dev, "failed to create ivc streams: %d\n", ret);
+		mbox_controller_unregister(&aonivc->mbox);
+		tegra_aon_hsp_sm_pair_free(aon);
+		tegra_aon_destroy_streams();
+		goto exit;
+	}
+
 exit:
 	return ret;
 }
@@ -420,4 +498,5 @@ void tegra_aon_mail_deinit(struct tegra_aon *aon)
 {
 	mbox_controller_unregister(&aon_ivc.mbox);
 	tegra_aon_hsp_sm_pair_free(aon);
+	tegra_aon_destroy_streams();
 }
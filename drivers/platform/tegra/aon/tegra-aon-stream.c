@@ -0,0 +1,274 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#include <linux/device.h>
+#include <linux/dma-mapping.h>
+#include <linux/fs.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/poll.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/wait.h>
+#include <linux/tegra-ivc.h>
+#include <linux/tegra-ivc-instance.h>
+#include <uapi/linux/tegra-aon-stream.h>
+
+#include <aon.h>
+
+#define AON_STREAM_NAME_LEN	32
+
+/**
+ * struct tegra_aon_stream - Zero-copy rx stream over an IVC channel.
+ *
+ * @misc : /dev/aon_<channel>
+ * @name : name of @misc
+ * @aon : Pointer to tegra_aon struct.
+ * @ivc : IVC channel of the stream.
+ * @rx_off : offset of the rx queue in the ipc buffer, page aligned.
+ * @rx_size : size of the rx queue, page aligned.
+ * @lock : serialises the users of @ivc.
+ * @wq : readers waiting for frames.
+ * @in_use : the device is open.
+ */
+struct tegra_aon_stream {
+	struct miscdevice misc;
+	char name[AON_STREAM_NAME_LEN];
+	struct tegra_aon *aon;
+	struct ivc *ivc;
+	u32 rx_off;
+	u32 rx_size;
+	struct mutex lock;
+	wait_queue_head_t wq;
+	bool in_use;
+};
+
+static int tegra_aon_stream_open(struct inode *inode, struct file *file)
+{
+	struct tegra_aon_stream *stream = container_of(file->private_data,
+					struct tegra_aon_stream, misc);
+	int ret = 0;
+
+	mutex_lock(&stream->lock);
+	if (stream->in_use)
+		ret = -EBUSY;
+	else
+		stream->in_use = true;
+	mutex_unlock(&stream->lock);
+
+	if (!ret) {
+		file->private_data = stream;
+		nonseekable_open(inode, file);
+	}
+
+	return ret;
+}
+
+static int tegra_aon_stream_release(struct inode *inode, struct file *file)
+{
+	struct tegra_aon_stream *stream = file->private_data;
+
+	mutex_lock(&stream->lock);
+	stream->in_use = false;
+	mutex_unlock(&stream->lock);
+
+	return 0;
+}
+
+static int tegra_aon_stream_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct tegra_aon_stream *stream = file->private_data;
+	struct tegra_aon *aon = stream->aon;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	if (vma->vm_pgoff != 0 ||
+	    vma->vm_end - vma->vm_start > stream->rx_size)
+		return -EINVAL;
+
+#if defined(NV_VM_AREA_STRUCT_HAS_CONST_VM_FLAGS) /* Linux v6.3 */
+	vm_flags_clear(vma, VM_MAYWRITE);
+#else
+	vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+
+	/* map the rx queue only, not the other channels of the ipc buffer */
+	vma->vm_pgoff = stream->rx_off >> PAGE_SHIFT;
+
+	return dma_mmap_coherent(aon->dev, vma, aon->ipcbuf, aon->ipcbuf_dma,
+				 aon->ipcbuf_size);
+}
+
+static __poll_t tegra_aon_stream_poll(struct file *file,
+				      struct poll_table_struct *wait)
+{
+	struct tegra_aon_stream *stream = file->private_data;
+	__poll_t mask = 0;
+
+	poll_wait(file, &stream->wq, wait);
+
+	mutex_lock(&stream->lock);
+	if (tegra_ivc_can_read(stream->ivc))
+		mask = EPOLLIN | EPOLLRDNORM;
+	mutex_unlock(&stream->lock);
+
+	return mask;
+}
+
+static int tegra_aon_stream_acquire(struct tegra_aon_stream *stream,
+				    struct tegra_aon_stream_frames *frames)
+{
+	struct ivc *ivc = stream->ivc;
+	void *first;
+	u8 *frame0;
+	int ret;
+
+	if (!frames->count)
+		return -EINVAL;
+
+	ret = tegra_ivc_read_get_frames(ivc, &first, frames->count);
+	if (ret == -ENOMEM)
+		return -EAGAIN;
+	if (ret < 0)
+		return ret;
+
+	frame0 = (u8 *)ivc->rx_channel + tegra_ivc_total_queue_size(0);
+	frames->index = ((u8 *)first - frame0) / ivc->frame_size;
+	frames->count = ret;
+
+	return 0;
+}
+
+static long tegra_aon_stream_ioctl(struct file *file, unsigned int cmd,
+				   unsigned long arg)
+{
+	struct tegra_aon_stream *stream = file->private_data;
+	struct ivc *ivc = stream->ivc;
+	struct tegra_aon_stream_frames frames;
+	struct tegra_aon_stream_info info;
+	void __user *uarg = (void __user *)arg;
+	u32 count;
+	long ret = 0;
+
+	switch (cmd) {
+	case TEGRA_AON_STREAM_GET_INFO:
+		info.frame_size = ivc->frame_size;
+		info.nframes = ivc->nframes;
+		info.frames_offset = tegra_ivc_total_queue_size(0);
+		info.map_size = stream->rx_size;
+		if (copy_to_user(uarg, &info, sizeof(info)))
+			ret = -EFAULT;
+		break;
+	case TEGRA_AON_STREAM_ACQUIRE:
+		if (copy_from_user(&frames, uarg, sizeof(frames)))
+			return -EFAULT;
+		mutex_lock(&stream->lock);
+		ret = tegra_aon_stream_acquire(stream, &frames);
+		mutex_unlock(&stream->lock);
+		if (!ret && copy_to_user(uarg, &frames, sizeof(frames)))
+			ret = -EFAULT;
+		break;
+	case TEGRA_AON_STREAM_RELEASE:
+		if (get_user(count, (u32 __user *)uarg))
+			return -EFAULT;
+		mutex_lock(&stream->lock);
+		ret = tegra_ivc_read_advance_frames(ivc, count);
+		mutex_unlock(&stream->lock);
+		break;
+	default:
+		ret = -ENOTTY;
+		break;
+	}
+
+	return ret;
+}
+
+static const struct file_operations tegra_aon_stream_fops = {
+	.owner = THIS_MODULE,
+	.open = tegra_aon_stream_open,
+	.release = tegra_aon_stream_release,
+	.mmap = tegra_aon_stream_mmap,
+	.poll = tegra_aon_stream_poll,
+	.unlocked_ioctl = tegra_aon_stream_ioctl,
+	.llseek = no_llseek,
+};
+
+/**
+ * tegra_aon_stream_notify - Wakes up the readers of a stream.
+ *
+ * @stream : Pointer to tegra_aon_stream struct.
+ *
+ * Return : void
+ */
+void tegra_aon_stream_notify(struct tegra_aon_stream *stream)
+{
+	wake_up_interruptible(&stream->wq);
+}
+
+/**
+ * tegra_aon_stream_create - Exports the rx queue of an IVC channel to
+ * userspace as /dev/aon_<name>.
+ *
+ * @aon : Pointer to tegra_aon struct.
+ * @ivc : IVC channel of the stream.
+ * @name : name of the channel.
+ * @rx_off : page aligned offset of the rx queue in the ipc buffer.
+ * @rx_size : page aligned size of the rx queue.
+ *
+ * Return : Pointer to tegra_aon_stream struct or ERR_PTR.
+ */
+struct tegra_aon_stream *tegra_aon_stream_create(struct tegra_aon *aon,
+						 struct ivc *ivc,
+						 const char *name,
+						 u32 rx_off, u32 rx_size)
+{
+	struct tegra_aon_stream *stream;
+	int ret;
+
+	stream = kzalloc(sizeof(*stream), GFP_KERNEL);
+	if (!stream)
+		return ERR_PTR(-ENOMEM);
+
+	stream->aon = aon;
+	stream->ivc = ivc;
+	stream->rx_off = rx_off;
+	stream->rx_size = rx_size;
+	mutex_init(&stream->lock);
+	init_waitqueue_head(&stream->wq);
+
+	snprintf(stream->name, sizeof(stream->name), "aon_%s", name);
+	stream->misc.minor = MISC_DYNAMIC_MINOR;
+	stream->misc.name = stream->name;
+	stream->misc.fops = &tegra_aon_stream_fops;
+	stream->misc.parent = aon->dev;
+
+	ret = misc_register(&stream->misc);
+	if (ret) {
+		dev_err(aon->dev, "failed to register %s: %d\n",
+			stream->name, ret);
+		mutex_destroy(&stream->lock);
+		kfree(stream);
+		return ERR_PTR(ret);
+	}
+
+	return stream;
+}
+
+/**
+ * tegra_aon_stream_destroy - Removes a stream created by
+ * tegra_aon_stream_create.
+ *
+ * @stream : Pointer to tegra_aon_stream struct.
+ *
+ * Return : void
+ */
+void tegra_aon_stream_destroy(struct tegra_aon_stream *stream)
+{
+	misc_deregister(&stream->misc);
+	mutex_destroy(&stream->lock);
+	kfree(stream);
+}
@@ -659,3 +659,40 @@ out:
 		d->boot_status |= DCE_FW_ADMIN_SEQ_FAILED;
 	return ret;
 }
+
+/**
+ * dce_admin_check_resume - Checks that the admin channel restored by a warm
+ *			    resume of DCE fw answers rpcs again.
+ *
+ * @d - Pointer to tegra_dce struct.
+ *
+ * Return - 0 if successful
+ */
+int dce_admin_check_resume(struct tegra_dce *d)
+{
+	int ret = 0;
+	struct dce_ipc_message *msg;
+	struct dce_admin_ipc_resp *resp_msg;
+
+	msg = dce_admin_allocate_message(d);
+	if (!msg)
+		return -ENOMEM;
+
+	resp_msg = (struct dce_admin_ipc_resp *) (msg->rx.data);
+
+	ret = dce_admin_send_cmd_ver(d, msg);
+	if (ret) {
+		dce_err(d, "RPC failed for DCE_ADMIN_CMD_VERSION");
+		goto out;
+	}
+
+	if (resp_msg->error != DCE_ERR_CORE_SUCCESS) {
+		dce_err(d, "DCE_ADMIN_CMD_VERSION failed after resume : [0x%x]",
+			resp_msg->error);
+		ret = -EIO;
+	}
+
+out:
+	dce_admin_free_message(d, msg);
+	return ret;
+}
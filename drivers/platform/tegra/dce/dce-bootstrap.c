@@ -174,6 +174,36 @@ exit:
 	return ret;
 }
 
+/**
+ * dce_start_warm_boot_flow : Complete a warm resume of dce
+ *
+ * DCE fw restored the bootstrap and IPC configuration it saved at SC7
+ * entry, and the IPC region and AST setup are kept by this driver across
+ * SC7, so the mailbox bootstrap and admin sequence are skipped. Only check
+ * that the admin channel works again.
+ *
+ * @d : Pointer to tegra_dce struct.
+ *
+ * Return : 0 if successful else error code
+ */
+int
+dce_start_warm_boot_flow(struct tegra_dce *d)
+{
+	int ret = 0;
+
+	ret = dce_admin_check_resume(d);
+	if (ret) {
+		dce_err(d, "DCE_WARM_BOOT_FAILED: Admin channel didn't resume");
+		return ret;
+	}
+
+	d->boot_status |= DCE_FW_BOOT_DONE;
+	dce_info(d, "DCE_BOOT_DONE (warm)");
+	dce_cond_broadcast_interruptible(&d->dce_bootstrap_done);
+
+	return ret;
+}
+
 /**
  * dce_bootstrap_work_fn : execute fsm start and bootstrap flow
  *
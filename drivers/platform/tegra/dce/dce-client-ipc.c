@@ -109,6 +109,168 @@ static int dce_client_ipc_handle_free(u32 handle)
 	return 0;
 }
 
+/*
+ * Write pending rpcs to the channel while it has free frames and move
+ * them to the in-flight list. rpcs which fail to be written are moved to
+ * @failed, to be completed by the caller once req_lock is dropped.
+ *
+ * Must be called with cl->req_lock held.
+ */
+static void dce_client_ipc_kick(struct tegra_dce_client_ipc *cl,
+				struct list_head *failed)
+{
+	int ret;
+	struct dce_client_ipc_req *req;
+
+	while (cl->n_inflight < cl->max_inflight) {
+		req = list_first_entry_or_null(&cl->pending,
+					       struct dce_client_ipc_req, node);
+		if (req == NULL)
+			break;
+
+		/*
+		 * Track the rpc before writing it so that a response racing
+		 * with the write already finds it in flight.
+		 */
+		list_move_tail(&req->node, &cl->inflight);
+		cl->n_pending--;
+		cl->n_inflight++;
+
+		ret = dce_ipc_send_message(cl->d, cl->int_type,
+					   req->msg->tx.data, req->msg->tx.size);
+		if (ret) {
+			dce_err(cl->d, "Error in sending rpc [%u] to DCE",
+				req->seq);
+			req->status = ret;
+			list_move_tail(&req->node, failed);
+			cl->n_inflight--;
+		}
+	}
+}
+
+static void dce_client_ipc_complete(struct tegra_dce_client_ipc *cl,
+				    struct dce_client_ipc_req *req)
+{
+	dce_perf_stream_rpc(cl->d, cl->type, req->seq, req->queue_depth,
+			    req->queued, req->status);
+
+	if (req->callback_fn == NULL) {
+		/* Synchronous rpc, req lives on the waiter's stack. */
+		atomic_set(&req->done, 1);
+		dce_cond_broadcast_interruptible(&cl->recv_wait);
+		return;
+	}
+
+	req->callback_fn(cl->handle, req->seq, req->status, req->msg,
+			 req->data);
+	dce_kfree(cl->d, req);
+}
+
+static void dce_client_ipc_complete_list(struct tegra_dce_client_ipc *cl,
+					 struct list_head *list)
+{
+	struct dce_client_ipc_req *req, *tmp;
+
+	list_for_each_entry_safe(req, tmp, list, node) {
+		list_del(&req->node);
+		dce_client_ipc_complete(cl, req);
+	}
+}
+
+/*
+ * DCE answers the rpcs of a channel in order, so each response belongs
+ * to the oldest in-flight rpc of the client.
+ */
+static void dce_client_ipc_rx_work(struct work_struct *data)
+{
+	LIST_HEAD(done);
+	struct tegra_dce_client_ipc *cl = container_of(data,
+			struct tegra_dce_client_ipc, rx_work);
+	struct tegra_dce *d = cl->d;
+	struct dce_client_ipc_req *req;
+
+	dce_mutex_lock(&cl->req_lock);
+
+	while (!list_empty(&cl->inflight) &&
+	       dce_ipc_is_data_available(d, cl->int_type)) {
+		req = list_first_entry(&cl->inflight,
+				       struct dce_client_ipc_req, node);
+		req->status = dce_ipc_read_message(d, cl->int_type,
+						   req->msg->rx.data,
+						   req->msg->rx.size);
+		if (req->status)
+			dce_err(d, "Error in reading rpc [%u] for ch_type [%d]",
+				req->seq, cl->int_type);
+		list_move_tail(&req->node, &done);
+		cl->n_inflight--;
+	}
+
+	dce_client_ipc_kick(cl, &done);
+
+	dce_mutex_unlock(&cl->req_lock);
+
+	dce_client_ipc_complete_list(cl, &done);
+}
+
+/*
+ * Queue @req and write it to the channel if there is room. Once req_lock
+ * is dropped an asynchronous req may complete at any time, so its result
+ * is only looked at with the lock held.
+ */
+static int dce_client_ipc_queue(struct tegra_dce_client_ipc *cl,
+				struct dce_client_ipc_req *req, u32 *seqp)
+{
+	LIST_HEAD(failed);
+	struct dce_client_ipc_req *f, *tmp;
+	int ret = 0;
+
+	dce_mutex_lock(&cl->req_lock);
+
+	req->seq = cl->next_seq++;
+	if (seqp != NULL)
+		*seqp = req->seq;
+	req->queued = ktime_get();
+	req->queue_depth = cl->n_pending + cl->n_inflight;
+	list_add_tail(&req->node, &cl->pending);
+	cl->n_pending++;
+	dce_client_ipc_kick(cl, &failed);
+
+	list_for_each_entry_safe(f, tmp, &failed, node) {
+		if (f == req) {
+			ret = req->status;
+			list_del(&req->node);
+		}
+	}
+
+	dce_mutex_unlock(&cl->req_lock);
+
+	dce_client_ipc_complete_list(cl, &failed);
+
+	return ret;
+}
+
+static void dce_client_ipc_cancel(struct tegra_dce_client_ipc *cl)
+{
+	LIST_HEAD(cancelled);
+	struct dce_client_ipc_req *req;
+
+	cancel_work_sync(&cl->rx_work);
+
+	dce_mutex_lock(&cl->req_lock);
+
+	list_splice_tail_init(&cl->inflight, &cancelled);
+	list_splice_tail_init(&cl->pending, &cancelled);
+	cl->n_pending = 0;
+	cl->n_inflight = 0;
+
+	dce_mutex_unlock(&cl->req_lock);
+
+	list_for_each_entry(req, &cancelled, node)
+		req->status = -ECANCELED;
+
+	dce_client_ipc_complete_list(cl, &cancelled);
+}
+
 static void dce_client_async_event_work(struct work_struct *data)
 {
 	struct tegra_dce_client_ipc *cl;
@@ -130,6 +292,7 @@ int tegra_dce_register_ipc_client(u32 type,
 	uint32_t int_type;
 	struct tegra_dce *d = NULL;
 	struct tegra_dce_client_ipc *cl;
+	struct dce_ipc_queue_info q_info;
 	u32 handle = DCE_CLIENT_IPC_HANDLE_INVALID;
 
 	if (handlep == NULL) {
@@ -178,6 +341,24 @@ int tegra_dce_register_ipc_client(u32 type,
 	cl->callback_fn = callback_fn;
 	atomic_set(&cl->complete, 0);
 
+	INIT_LIST_HEAD(&cl->pending);
+	INIT_LIST_HEAD(&cl->inflight);
+	INIT_WORK(&cl->rx_work, dce_client_ipc_rx_work);
+	cl->n_pending = 0;
+	cl->n_inflight = 0;
+	cl->next_seq = 0;
+	cl->max_inflight = 1;
+	if (!dce_ipc_get_channel_info(d, &q_info, int_type) &&
+	    q_info.nframes > 0)
+		cl->max_inflight = q_info.nframes;
+
+	ret = dce_mutex_init(&cl->req_lock);
+	if (ret) {
+		dce_err(d, "dce lock initialization failed for int_type: [%u]",
+			int_type);
+		goto out;
+	}
+
 	ret = dce_cond_init(&cl->recv_wait);
 	if (ret) {
 		dce_err(d, "dce condition initialization failed for int_type: [%u]",
@@ -208,6 +389,9 @@ int tegra_dce_unregister_ipc_client(u32 handle)
 		return -EINVAL;
 	}
 
+	dce_client_ipc_cancel(cl);
+
+	dce_mutex_destroy(&cl->req_lock);
 	dce_cond_destroy(&cl->recv_wait);
 
 	return dce_client_ipc_handle_free(handle);
@@ -218,6 +402,7 @@ int tegra_dce_client_ipc_send_recv(u32 handle, struct dce_ipc_message *msg)
 {
 	int ret;
 	struct tegra_dce_client_ipc *cl;
+	struct dce_client_ipc_req req = { 0 };
 
 	if (msg == NULL) {
 		ret = -1;
@@ -230,13 +415,64 @@ int tegra_dce_client_ipc_send_recv(u32 handle, struct dce_ipc_message *msg)
 		goto out;
 	}
 
-	ret = dce_ipc_send_message_sync(cl->d, cl->int_type, msg);
+	/*
+	 * Synchronous rpcs are queued behind the asynchronous ones of the
+	 * client, since both share the channel and its response order.
+	 */
+	req.msg = msg;
+	atomic_set(&req.done, 0);
+
+	ret = dce_client_ipc_queue(cl, &req, NULL);
+	if (ret)
+		goto out;
+
+retry_wait:
+	DCE_COND_WAIT_INTERRUPTIBLE(&cl->recv_wait,
+			atomic_read(&req.done) == 1);
+	if (atomic_read(&req.done) != 1)
+		goto retry_wait;
+
+	ret = req.status;
 
 out:
 	return ret;
 }
 EXPORT_SYMBOL(tegra_dce_client_ipc_send_recv);
 
+int tegra_dce_client_ipc_send_async(u32 handle, struct dce_ipc_message *msg,
+		tegra_dce_client_ipc_async_cb_t callback_fn, void *usr_ctx,
+		u32 *seqp)
+{
+	int ret;
+	struct tegra_dce_client_ipc *cl;
+	struct dce_client_ipc_req *req;
+
+	if ((msg == NULL) || (callback_fn == NULL))
+		return -EINVAL;
+
+	cl = dce_client_ipc_lookup_handle(handle);
+	if ((cl == NULL) || (cl->valid == false))
+		return -EINVAL;
+
+	if (cl->type == DCE_CLIENT_IPC_TYPE_RM_EVENT)
+		return -EINVAL;
+
+	req = dce_kzalloc(cl->d, sizeof(*req), false);
+	if (req == NULL)
+		return -ENOMEM;
+
+	req->msg = msg;
+	req->callback_fn = callback_fn;
+	req->data = usr_ctx;
+
+	ret = dce_client_ipc_queue(cl, req, seqp);
+	if (ret)
+		dce_kfree(cl->d, req);
+
+	return ret;
+}
+EXPORT_SYMBOL(tegra_dce_client_ipc_send_async);
+
 int dce_client_init(struct tegra_dce *d)
 {
 	int ret = 0;
@@ -246,6 +482,13 @@ int dce_client_init(struct tegra_dce *d)
 	d_aipc->async_event_wq =
 		create_singlethread_workqueue("dce-async-ipc-wq");
 
+	/*
+	 * Separate from async_event_wq, so that event callbacks can wait on
+	 * client rpcs.
+	 */
+	d_aipc->client_rx_wq =
+		create_singlethread_workqueue("dce-client-ipc-wq");
+
 	for (i = 0; i < DCE_MAX_ASYNC_WORK; i++) {
 		struct dce_async_work *d_work = &d_aipc->work[i];
 
@@ -264,6 +507,9 @@ void dce_client_deinit(struct tegra_dce *d)
 
 	flush_workqueue(d_aipc->async_event_wq);
 	destroy_workqueue(d_aipc->async_event_wq);
+
+	flush_workqueue(d_aipc->client_rx_wq);
+	destroy_workqueue(d_aipc->client_rx_wq);
 }
 
 int dce_client_ipc_wait(struct tegra_dce *d, u32 int_type)
@@ -377,6 +623,15 @@ void dce_client_ipc_wakeup(struct tegra_dce *d, u32 ch_type)
 	if (type == DCE_CLIENT_IPC_TYPE_RM_EVENT)
 		return dce_client_schedule_event_work(d);
 
+	dce_mutex_lock(&cl->req_lock);
+	if (cl->n_inflight > 0U) {
+		queue_work(d->d_async_ipc.client_rx_wq, &cl->rx_work);
+		dce_mutex_unlock(&cl->req_lock);
+		return;
+	}
+	dce_mutex_unlock(&cl->req_lock);
+
+	/* Response to an rpc sent with dce_ipc_send_message_sync(). */
 	atomic_set(&cl->complete, 1);
 	dce_cond_signal_interruptible(&cl->recv_wait);
 }
@@ -24,6 +24,7 @@ static const struct dce_platform_data t234_dce_platform_data = {
 	.fw_dce_addr = 0x40000000,
 	.fw_info_valid = true,
 	.use_physical_id = false,
+	.sc7_warm_resume = true,
 };
 
 __weak const struct of_device_id tegra_dce_of_match[] = {
@@ -236,6 +237,9 @@ static int tegra_dce_probe(struct platform_device *pdev)
 
 	dce_set_irqs(pdev, true);
 
+	/* Not fatal, DCE works without the perf stream. */
+	(void)dce_perf_stream_init(d);
+
 #ifdef CONFIG_DEBUG_FS
 	dce_init_debug(d);
 #endif
@@ -278,6 +282,8 @@ static int tegra_dce_remove(struct platform_device *pdev)
 	dce_remove_debug(d);
 #endif
 
+	dce_perf_stream_deinit(d);
+
 	dce_set_irqs(pdev, false);
 	dce_driver_deinit(d);
 	return 0;
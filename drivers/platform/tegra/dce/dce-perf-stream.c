@@ -0,0 +1,373 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#include <linux/fs.h>
+#include <linux/poll.h>
+#include <linux/uaccess.h>
+#include <dce.h>
+#include <dce-perf-stream.h>
+#include <dce-util-common.h>
+#include <interface/dce-admin-cmds.h>
+
+#define DCE_PERF_RING_RECORDS	512U
+
+static inline struct dce_perf_stream *perf_from_dce(struct tegra_dce *d)
+{
+	return &dce_device_from_dce(d)->perf;
+}
+
+static inline struct tegra_dce *dce_from_perf(struct dce_perf_stream *perf)
+{
+	return &container_of(perf, struct dce_device, perf)->d;
+}
+
+/*
+ * Queue one record, reporting the records lost on a full ring first once
+ * there is room again. enabled is checked under ring_lock so that no
+ * record is queued once the stream has been stopped.
+ */
+static void dce_perf_stream_put(struct dce_perf_stream *perf,
+				struct tegra_dce_perf_record *rec)
+{
+	struct tegra_dce_perf_record lost = { 0 };
+	unsigned long flags;
+
+	spin_lock_irqsave(&perf->ring_lock, flags);
+
+	if (!atomic_read(&perf->enabled))
+		goto out;
+
+	if (perf->lost != 0U) {
+		if (kfifo_avail(&perf->ring) < 2U) {
+			perf->lost++;
+			goto out;
+		}
+
+		lost.type = TEGRA_DCE_PERF_REC_LOST;
+		lost.tstamp_ns = rec->tstamp_ns;
+		lost.lost = perf->lost;
+		kfifo_put(&perf->ring, lost);
+		perf->lost = 0U;
+	}
+
+	if (!kfifo_put(&perf->ring, *rec))
+		perf->lost++;
+
+out:
+	spin_unlock_irqrestore(&perf->ring_lock, flags);
+
+	wake_up_interruptible(&perf->wq);
+}
+
+/**
+ * dce_perf_stream_rpc - Records the completion of a client rpc.
+ *
+ * @d : Pointer to tegra_dce struct.
+ * @client : DCE_CLIENT_IPC_TYPE_* of the client.
+ * @seq : sequence number of the rpc.
+ * @queue_depth : rpcs of the client queued when this one was submitted.
+ * @queued : submission time of the rpc.
+ * @status : result of the rpc.
+ *
+ * Return : void
+ */
+void dce_perf_stream_rpc(struct tegra_dce *d, u32 client, u32 seq,
+			 u32 queue_depth, ktime_t queued, int status)
+{
+	struct dce_perf_stream *perf = perf_from_dce(d);
+	struct tegra_dce_perf_record rec = { 0 };
+	ktime_t now;
+
+	if (!atomic_read(&perf->enabled))
+		return;
+
+	now = ktime_get();
+
+	rec.type = TEGRA_DCE_PERF_REC_RPC;
+	rec.id = client;
+	rec.tstamp_ns = ktime_to_ns(now);
+	rec.rpc.seq = seq;
+	rec.rpc.queue_depth = queue_depth;
+	rec.rpc.latency_ns = ktime_to_ns(ktime_sub(now, queued));
+	rec.rpc.status = status;
+
+	dce_perf_stream_put(perf, &rec);
+}
+
+static void dce_perf_stream_fw_work(struct work_struct *work)
+{
+	struct dce_perf_stream *perf = container_of(to_delayed_work(work),
+			struct dce_perf_stream, fw_work);
+	struct tegra_dce *d = dce_from_perf(perf);
+	struct tegra_dce_perf_record rec = { 0 };
+	struct dce_admin_event_info *events;
+	struct dce_admin_ipc_resp *resp_msg;
+	struct dce_ipc_message *msg;
+	u32 i;
+
+	if (!atomic_read(&perf->enabled))
+		return;
+
+	/* Not across SC7 or before boot, the admin channel is down then. */
+	if (!dce_is_bootstrap_done(d))
+		goto resched;
+
+	msg = dce_admin_allocate_message(d);
+	if (!msg)
+		goto resched;
+
+	if (dce_admin_send_cmd_get_perf_events(d, msg))
+		goto free;
+
+	resp_msg = (struct dce_admin_ipc_resp *)(msg->rx.data);
+	events = &resp_msg->args.perf.info.events_stats;
+
+	rec.type = TEGRA_DCE_PERF_REC_FW_EVENT;
+	rec.tstamp_ns = ktime_get_ns();
+	for (i = 0U; i < DCE_ADMIN_NUM_EVENTS; i++) {
+		if (events->events[i].name[0] == '\0')
+			continue;
+
+		rec.id = i;
+		strscpy(rec.fw_event.name, events->events[i].name,
+			sizeof(rec.fw_event.name));
+		rec.fw_event.accumulate = events->events[i].event.accumulate;
+		rec.fw_event.iterations = events->events[i].event.iterations;
+		rec.fw_event.min = events->events[i].event.min;
+		rec.fw_event.max = events->events[i].event.max;
+		dce_perf_stream_put(perf, &rec);
+	}
+
+free:
+	dce_admin_free_message(d, msg);
+resched:
+	schedule_delayed_work(&perf->fw_work,
+			      msecs_to_jiffies(perf->fw_period_ms));
+}
+
+static int dce_perf_stream_set_fw_events(struct tegra_dce *d, u32 events)
+{
+	struct dce_admin_ipc_cmd *req_msg;
+	struct dce_ipc_message *msg;
+	int ret;
+
+	msg = dce_admin_allocate_message(d);
+	if (!msg)
+		return -ENOMEM;
+
+	req_msg = (struct dce_admin_ipc_cmd *)(msg->tx.data);
+	req_msg->args.perf.event_cmd.clear = DCE_ADMIN_EVENT_CLEAR_RETAIN;
+	req_msg->args.perf.event_cmd.enable = events;
+
+	ret = dce_admin_send_cmd_clear_perf_events(d, msg);
+
+	dce_admin_free_message(d, msg);
+	return ret ? -EIO : 0;
+}
+
+/* Must be called with perf->lock held. */
+static void dce_perf_stream_stop(struct dce_perf_stream *perf)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&perf->ring_lock, flags);
+	atomic_set(&perf->enabled, 0);
+	spin_unlock_irqrestore(&perf->ring_lock, flags);
+
+	cancel_delayed_work_sync(&perf->fw_work);
+}
+
+static int dce_perf_stream_start(struct dce_perf_stream *perf,
+				 struct tegra_dce_perf_cfg *cfg)
+{
+	struct tegra_dce *d = dce_from_perf(perf);
+	int ret;
+
+	dce_perf_stream_stop(perf);
+
+	if (cfg->fw_events != 0U) {
+		ret = dce_perf_stream_set_fw_events(d, cfg->fw_events);
+		if (ret) {
+			dce_err(d, "Failed to enable perf events 0x%x",
+				cfg->fw_events);
+			return ret;
+		}
+	}
+
+	perf->fw_period_ms = cfg->fw_period_ms;
+	atomic_set(&perf->enabled, 1);
+
+	if (perf->fw_period_ms != 0U)
+		schedule_delayed_work(&perf->fw_work, 0);
+
+	return 0;
+}
+
+static int dce_perf_stream_open(struct inode *inode, struct file *file)
+{
+	struct dce_perf_stream *perf = container_of(file->private_data,
+			struct dce_perf_stream, misc);
+	int ret;
+
+	mutex_lock(&perf->lock);
+
+	if (perf->in_use) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	ret = kfifo_alloc(&perf->ring, DCE_PERF_RING_RECORDS, GFP_KERNEL);
+	if (ret)
+		goto out;
+
+	perf->lost = 0U;
+	perf->in_use = true;
+	file->private_data = perf;
+
+out:
+	mutex_unlock(&perf->lock);
+	return ret;
+}
+
+static int dce_perf_stream_release(struct inode *inode, struct file *file)
+{
+	struct dce_perf_stream *perf = file->private_data;
+
+	mutex_lock(&perf->lock);
+
+	dce_perf_stream_stop(perf);
+	kfifo_free(&perf->ring);
+	perf->in_use = false;
+
+	mutex_unlock(&perf->lock);
+	return 0;
+}
+
+static ssize_t dce_perf_stream_read(struct file *file, char __user *buf,
+				    size_t count, loff_t *ppos)
+{
+	struct dce_perf_stream *perf = file->private_data;
+	unsigned int copied = 0U;
+	int ret;
+
+	if (count < sizeof(struct tegra_dce_perf_record))
+		return -EINVAL;
+
+	while (kfifo_is_empty(&perf->ring)) {
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+
+		ret = wait_event_interruptible(perf->wq,
+					       !kfifo_is_empty(&perf->ring));
+		if (ret)
+			return ret;
+	}
+
+	ret = kfifo_to_user(&perf->ring, buf, count, &copied);
+
+	return ret ? ret : copied;
+}
+
+static __poll_t dce_perf_stream_poll(struct file *file,
+				     struct poll_table_struct *wait)
+{
+	struct dce_perf_stream *perf = file->private_data;
+
+	poll_wait(file, &perf->wq, wait);
+
+	return kfifo_is_empty(&perf->ring) ? 0 : (EPOLLIN | EPOLLRDNORM);
+}
+
+static long dce_perf_stream_ioctl(struct file *file, unsigned int cmd,
+				  unsigned long arg)
+{
+	struct dce_perf_stream *perf = file->private_data;
+	struct tegra_dce_perf_cfg cfg;
+	long ret = 0;
+
+	mutex_lock(&perf->lock);
+
+	switch (cmd) {
+	case TEGRA_DCE_PERF_START:
+		if (copy_from_user(&cfg, (void __user *)arg, sizeof(cfg))) {
+			ret = -EFAULT;
+			break;
+		}
+		ret = dce_perf_stream_start(perf, &cfg);
+		break;
+	case TEGRA_DCE_PERF_STOP:
+		dce_perf_stream_stop(perf);
+		break;
+	default:
+		ret = -ENOTTY;
+		break;
+	}
+
+	mutex_unlock(&perf->lock);
+	return ret;
+}
+
+static const struct file_operations dce_perf_stream_fops = {
+	.owner = THIS_MODULE,
+	.open = dce_perf_stream_open,
+	.release = dce_perf_stream_release,
+	.read = dce_perf_stream_read,
+	.poll = dce_perf_stream_poll,
+	.unlocked_ioctl = dce_perf_stream_ioctl,
+	.llseek = noop_llseek,
+};
+
+/**
+ * dce_perf_stream_init - Registers /dev/tegra_dce_perf.
+ *
+ * @d : Pointer to tegra_dce struct.
+ *
+ * Return : 0 if successful
+ */
+int dce_perf_stream_init(struct tegra_dce *d)
+{
+	struct dce_perf_stream *perf = perf_from_dce(d);
+	int ret;
+
+	mutex_init(&perf->lock);
+	spin_lock_init(&perf->ring_lock);
+	init_waitqueue_head(&perf->wq);
+	INIT_DELAYED_WORK(&perf->fw_work, dce_perf_stream_fw_work);
+	atomic_set(&perf->enabled, 0);
+
+	perf->misc.minor = MISC_DYNAMIC_MINOR;
+	perf->misc.name = "tegra_dce_perf";
+	perf->misc.fops = &dce_perf_stream_fops;
+	perf->misc.parent = dev_from_dce(d);
+
+	ret = misc_register(&perf->misc);
+	if (ret) {
+		dce_err(d, "Failed to register perf stream device [%d]", ret);
+		return ret;
+	}
+
+	perf->registered = true;
+
+	return ret;
+}
+
+/**
+ * dce_perf_stream_deinit - Unregisters /dev/tegra_dce_perf.
+ *
+ * @d : Pointer to tegra_dce struct.
+ *
+ * Return : void
+ */
+void dce_perf_stream_deinit(struct tegra_dce *d)
+{
+	struct dce_perf_stream *perf = perf_from_dce(d);
+
+	if (!perf->registered)
+		return;
+
+	misc_deregister(&perf->misc);
+	perf->registered = false;
+	mutex_destroy(&perf->lock);
+}
@@ -4,8 +4,16 @@
  */
 
 #include <dce.h>
+#include <interface/dce-interface.h>
 
 #define CCPLEX_HSP_IE 1U /* TODO : Have an api to read from platform data */
+#define DCE_SC7_RESUME_BPOS 29U /* DCE_SC7_RESUME */
+
+static bool dce_pm_can_warm_resume(struct tegra_dce *d)
+{
+	return d->sc7_state.fw_state_saved &&
+	       pdata_from_dce(d)->sc7_warm_resume;
+}
 
 static void dce_pm_save_state(struct tegra_dce *d)
 {
@@ -29,18 +37,32 @@ static void dce_pm_restore_state(struct tegra_dce *d)
 void dce_resume_work_fn(struct tegra_dce *d)
 {
 	int ret = 0;
+	bool warm;
 
 	if (d == NULL) {
 		dce_err(d, "tegra_dce struct is NULL");
 		return;
 	}
 
+	warm = dce_pm_can_warm_resume(d);
+	d->sc7_state.fw_state_saved = false;
+
 	ret = dce_fsm_post_event(d, EVENT_ID_DCE_BOOT_COMPLETE_REQUESTED, NULL);
 	if (ret) {
 		dce_err(d, "Error while posting DCE_BOOT_COMPLETE_REQUESTED event");
 		return;
 	}
 
+	if (warm) {
+		dce_ss_clear(d, DCE_SC7_RESUME_BPOS, DCE_BOOT_SEMA);
+
+		ret = dce_start_warm_boot_flow(d);
+		if (!ret)
+			return;
+
+		dce_info(d, "DCE warm resume failed, bootstrapping again");
+	}
+
 	ret = dce_start_boot_flow(d);
 	if (ret) {
 		dce_err(d, "DCE bootstrapping failed\n");
@@ -93,6 +115,7 @@ out:
  */
 int dce_pm_handle_sc7_enter_received_event(struct tegra_dce *d, void *params)
 {
+	d->sc7_state.fw_state_saved = true;
 	dce_wakeup_interruptible(d, DCE_WAIT_SC7_ENTER);
 	return 0;
 }
@@ -160,6 +183,13 @@ int dce_pm_exit_sc7(struct tegra_dce *d)
 
 	dce_pm_restore_state(d);
 
+	/*
+	 * Ask DCE fw to resume from its saved state rather than restart, it
+	 * checks the boot semaphore before raising boot complete.
+	 */
+	if (dce_pm_can_warm_resume(d))
+		dce_ss_set(d, DCE_SC7_RESUME_BPOS, DCE_BOOT_SEMA);
+
 	ret = dce_fsm_post_event(d, EVENT_ID_DCE_SC7_EXIT_RECEIVED, NULL);
 	if (ret) {
 		dce_err(d, "Error while posting SC7_EXIT event [%d]", ret);
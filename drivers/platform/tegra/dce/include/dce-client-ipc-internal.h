@@ -6,8 +6,35 @@
 #ifndef DCE_CLIENT_IPC_INTERNAL_H
 #define DCE_CLIENT_IPC_INTERNAL_H
 
+#include <linux/ktime.h>
+#include <linux/list.h>
 #include <linux/platform/tegra/dce/dce-client-ipc.h>
 
+/**
+ * struct dce_client_ipc_req - Data Structure to hold a queued client rpc
+ *
+ * @node : entry in the pending or in-flight list of the client
+ * @seq : sequence number of the rpc
+ * @msg : message to be sent and received
+ * @callback_fn : completion callback, NULL for a synchronous rpc
+ * @data : user context passed to @callback_fn
+ * @status : result of the rpc
+ * @done : set once a synchronous rpc has completed
+ * @queued : submission time, for the perf stream
+ * @queue_depth : rpcs of the client queued ahead of this one
+ */
+struct dce_client_ipc_req {
+	struct list_head node;
+	u32 seq;
+	ktime_t queued;
+	u32 queue_depth;
+	struct dce_ipc_message *msg;
+	tegra_dce_client_ipc_async_cb_t callback_fn;
+	void *data;
+	int status;
+	atomic_t done;
+};
+
 /**
  * struct tegra_dce_client_ipc - Data Structure to hold client specific ipc
  *				data pertaining to IPC type
@@ -24,6 +51,14 @@
  * @complete : atomic variable used for IPC synchronization
  * @callback_fn : function pointer to the callback function passed by the
  *                client during registration
+ * @req_lock : protects the rpc lists and counters below
+ * @pending : rpcs queued but not yet written to the channel
+ * @inflight : rpcs written to the channel, oldest first
+ * @n_pending : number of entries in @pending
+ * @n_inflight : number of entries in @inflight
+ * @max_inflight : number of frames of the channel
+ * @next_seq : sequence number of the next rpc
+ * @rx_work : reads the responses of the in-flight rpcs
  */
 struct tegra_dce_client_ipc {
 	bool valid;
@@ -35,6 +70,14 @@ struct tegra_dce_client_ipc {
 	struct dce_cond recv_wait;
 	atomic_t complete;
 	tegra_dce_client_ipc_callback_t callback_fn;
+	struct dce_mutex req_lock;
+	struct list_head pending;
+	struct list_head inflight;
+	u32 n_pending;
+	u32 n_inflight;
+	u32 max_inflight;
+	u32 next_seq;
+	struct work_struct rx_work;
 };
 
 #define DCE_MAX_ASYNC_WORK	8
@@ -46,9 +89,11 @@ struct dce_async_work {
 
 /**
  * @async_event_wq - Workqueue to process async events from DCE
+ * @client_rx_wq - Workqueue to read the responses of client rpcs
  */
 struct tegra_dce_async_ipc_info {
 	struct workqueue_struct *async_event_wq;
+	struct workqueue_struct *client_rx_wq;
 	struct dce_async_work work[DCE_MAX_ASYNC_WORK];
 };
 
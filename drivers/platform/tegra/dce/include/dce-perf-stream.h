@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#ifndef DCE_PERF_STREAM_H
+#define DCE_PERF_STREAM_H
+
+#include <linux/kfifo.h>
+#include <linux/ktime.h>
+#include <linux/miscdevice.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
+#include <uapi/linux/tegra-dce-perf.h>
+
+struct tegra_dce;
+
+/**
+ * struct dce_perf_stream - State of the binary perf stream
+ *
+ * @misc : /dev/tegra_dce_perf
+ * @registered : @misc was registered
+ * @lock : serialises open, start and stop
+ * @ring_lock : serialises the record producers
+ * @ring : records not yet read
+ * @wq : readers waiting for records
+ * @lost : records dropped on a full ring, not yet reported
+ * @enabled : records are being produced
+ * @in_use : the device is open
+ * @fw_work : samples the fw event counters
+ * @fw_period_ms : sampling period of @fw_work
+ */
+struct dce_perf_stream {
+	struct miscdevice misc;
+	bool registered;
+	struct mutex lock;
+	spinlock_t ring_lock;
+	DECLARE_KFIFO_PTR(ring, struct tegra_dce_perf_record);
+	wait_queue_head_t wq;
+	u64 lost;
+	atomic_t enabled;
+	bool in_use;
+	struct delayed_work fw_work;
+	u32 fw_period_ms;
+};
+
+int dce_perf_stream_init(struct tegra_dce *d);
+void dce_perf_stream_deinit(struct tegra_dce *d);
+void dce_perf_stream_rpc(struct tegra_dce *d, u32 client, u32 seq,
+			 u32 queue_depth, ktime_t queued, int status);
+
+#endif
@@ -8,8 +8,15 @@
 
 #include <dce.h>
 
+/**
+ * struct dce_sc7_state - CPU side state saved across SC7
+ *
+ * @hsp_ie : HSP interrupt enable register of the CCPLEX
+ * @fw_state_saved : DCE fw reported its state saved for a warm resume
+ */
 struct dce_sc7_state {
 	uint32_t hsp_ie;
+	bool fw_state_saved;
 };
 
 int dce_pm_enter_sc7(struct tegra_dce *d);
@@ -21,6 +21,7 @@
 #include <dce-mailbox.h>
 #include <dce-client-ipc-internal.h>
 #include <dce-workqueue.h>
+#include <dce-perf-stream.h>
 
 #define DCE_MAX_CPU_IRQS 4
 
@@ -110,6 +111,11 @@ struct dce_platform_data {
 	 * @use_physical_id : Use physical streamid
 	 */
 	bool use_physical_id;
+	/**
+	 * @sc7_warm_resume : DCE fw can resume from the state it saved at SC7
+	 * entry instead of being bootstrapped again.
+	 */
+	bool sc7_warm_resume;
 };
 
 /**
@@ -238,6 +244,10 @@ struct dce_device {
 	 * used for MMIO transactions to DCE elements.
 	 */
 	void __iomem *regs;
+	/**
+	 * @perf : Binary perf stream exported to userspace.
+	 */
+	struct dce_perf_stream perf;
 #ifdef CONFIG_DEBUG_FS
 	/**
 	 * @debugfs : Debugfs node for DCE Linux device.
@@ -386,6 +396,7 @@ int dce_driver_init(struct tegra_dce *d);
 void dce_driver_deinit(struct tegra_dce *d);
 
 int dce_start_boot_flow(struct tegra_dce *d);
+int dce_start_warm_boot_flow(struct tegra_dce *d);
 void dce_bootstrap_work_fn(struct tegra_dce *d);
 int dce_start_bootstrap_flow(struct tegra_dce *d);
 int dce_boot_interface_init(struct tegra_dce *d);
@@ -398,6 +409,7 @@ int dce_handle_boot_complete_received_event(struct tegra_dce *d, void *params);
 int dce_admin_init(struct tegra_dce *d);
 void dce_admin_deinit(struct tegra_dce *d);
 int dce_start_admin_seq(struct tegra_dce *d);
+int dce_admin_check_resume(struct tegra_dce *d);
 struct dce_ipc_message
 		*dce_admin_allocate_message(struct tegra_dce *d);
 void dce_admin_free_message(struct tegra_dce *d,
@@ -74,6 +74,48 @@ static int tegra_mc_hwpm_reg_op(void *ip_dev,
 	return 0;
 }
 
+#ifdef NV_TEGRA_SOC_HWPM_IP_OPS_HAS_REG_OPS
+/*
+ * Applies count operations of the same kind on one channel, looking up
+ * and validating the channel once for the whole list.
+ */
+static int tegra_mc_hwpm_reg_ops(void *ip_dev,
+	enum tegra_soc_hwpm_ip_reg_op reg_op, u32 inst_element_index,
+	const u64 *reg_offsets, u32 *reg_data, u32 count)
+{
+	struct device *dev = (struct device *)ip_dev;
+	struct tegra_mc_hwpm *mc;
+	void __iomem *regs;
+	u32 i;
+
+	mc = dev_get_drvdata(dev);
+	if (!mc) {
+		pr_err("tegra-mc-hwpm: Invalid device\n");
+		return -ENODEV;
+	}
+
+	if (inst_element_index >= mc->no_ch) {
+		dev_err(mc->dev, "Incorrect channel number: %u\n", inst_element_index);
+		return -EINVAL;
+	}
+
+	regs = mc->ch_regs[inst_element_index];
+
+	if (reg_op == TEGRA_SOC_HWPM_IP_REG_OP_READ) {
+		for (i = 0; i < count; i++)
+			reg_data[i] = readl(regs + (u32)reg_offsets[i]);
+	} else if (reg_op == TEGRA_SOC_HWPM_IP_REG_OP_WRITE) {
+		for (i = 0; i < count; i++)
+			writel(reg_data[i], regs + (u32)reg_offsets[i]);
+	} else {
+		dev_err(mc->dev, "Invalid operation\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+#endif
+
 static const struct of_device_id mc_hwpm_of_ids[] = {
 	{ .compatible = "nvidia,tegra-t23x-mc-hwpm" },
 	{ }
@@ -120,6 +162,9 @@ static int tegra_mc_hwpm_hwpm_probe(struct platform_device *pdev)
 	hwpm_ip_ops.resource_enum = TEGRA_SOC_HWPM_RESOURCE_MSS_CHANNEL;
 	hwpm_ip_ops.ip_base_address = mc->base_addr;
 	hwpm_ip_ops.hwpm_ip_reg_op = &tegra_mc_hwpm_reg_op;
+#ifdef NV_TEGRA_SOC_HWPM_IP_OPS_HAS_REG_OPS
+	hwpm_ip_ops.hwpm_ip_reg_ops = &tegra_mc_hwpm_reg_ops;
+#endif
 	tegra_soc_hwpm_ip_register(&hwpm_ip_ops);
 
 	return 0;
@@ -140,6 +185,9 @@ static int tegra_mc_hwpm_remove(struct platform_device *pdev)
 	hwpm_ip_ops.resource_enum = TEGRA_SOC_HWPM_RESOURCE_MSS_CHANNEL;
 	hwpm_ip_ops.ip_base_address = mc->base_addr;
 	hwpm_ip_ops.hwpm_ip_reg_op = NULL;
+#ifdef NV_TEGRA_SOC_HWPM_IP_OPS_HAS_REG_OPS
+	hwpm_ip_ops.hwpm_ip_reg_ops = NULL;
+#endif
 	tegra_soc_hwpm_ip_unregister(&hwpm_ip_ops);
 
 	return 0;
@@ -13,7 +13,11 @@
 #include <linux/version.h>
 #include <soc/tegra/fuse.h>
 #include <linux/io.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
 
 #include <soc/tegra/virt/hv-ivc.h>
 
@@ -78,6 +82,38 @@ struct emc_params {
 	u32 dram;
 };
 
+/*
+ * Share of the theoretical EMC bandwidth usable by ISO and non-ISO
+ * clients, in percent. Fewer channels leave fewer banks to interleave
+ * over, so the efficiency drops with the channel count. These are
+ * conservative defaults and can be tuned through debugfs.
+ */
+struct emc_bw_efficiency {
+	u32 ch_num;
+	u32 iso_pct;
+	u32 noniso_pct;
+};
+
+static const struct emc_bw_efficiency emc_bw_efficiency_t23x[] = {
+	{ .ch_num = CH_16, .iso_pct = 70, .noniso_pct = 80 },
+	{ .ch_num = CH_8,  .iso_pct = 65, .noniso_pct = 75 },
+	{ .ch_num = CH_4,  .iso_pct = 60, .noniso_pct = 70 },
+};
+
+struct tegra_emc_bw_req {
+	struct list_head node;
+	const char *name;
+	unsigned long iso_kbps;
+	unsigned long noniso_kbps;
+};
+
+static LIST_HEAD(emc_bw_reqs);
+static DEFINE_MUTEX(emc_bw_lock);
+static struct clk *emc_bw_clk;
+static u32 emc_bw_iso_pct = 100;
+static u32 emc_bw_noniso_pct = 100;
+static unsigned long emc_bw_floor_khz;
+
 static struct emc_params emc_param;
 static u32 ch_num;
 
@@ -294,7 +330,141 @@ enum dram_types tegra_dram_types(void)
 }
 EXPORT_SYMBOL(tegra_dram_types);
 
+/* Must be called with emc_bw_lock held */
+static int tegra_emc_bw_update(void)
+{
+	struct tegra_emc_bw_req *req;
+	unsigned long iso = 0, noniso = 0, total;
+	u32 iso_pct = max_t(u32, emc_bw_iso_pct, 1);
+	u32 noniso_pct = max_t(u32, emc_bw_noniso_pct, 1);
+
+	list_for_each_entry(req, &emc_bw_reqs, node) {
+		iso += req->iso_kbps;
+		noniso += req->noniso_kbps;
+	}
+
+	total = DIV_ROUND_UP(iso * 100, iso_pct) +
+		DIV_ROUND_UP(noniso * 100, noniso_pct);
+	emc_bw_floor_khz = emc_bw_to_freq(total);
+
+	if (!emc_bw_clk)
+		return 0;
+
+	return clk_set_min_rate(emc_bw_clk, emc_bw_floor_khz * 1000);
+}
+
+struct tegra_emc_bw_req *tegra_emc_bw_register(const char *name)
+{
+	struct tegra_emc_bw_req *req;
+
+	if (!ops)
+		return ERR_PTR(-ENODEV);
+
+	req = kzalloc(sizeof(*req), GFP_KERNEL);
+	if (!req)
+		return ERR_PTR(-ENOMEM);
+
+	req->name = kstrdup_const(name, GFP_KERNEL);
+	if (!req->name) {
+		kfree(req);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	mutex_lock(&emc_bw_lock);
+	list_add_tail(&req->node, &emc_bw_reqs);
+	mutex_unlock(&emc_bw_lock);
+
+	return req;
+}
+EXPORT_SYMBOL(tegra_emc_bw_register);
+
+int tegra_emc_bw_set(struct tegra_emc_bw_req *req, unsigned long iso_kbps,
+		     unsigned long noniso_kbps)
+{
+	int ret = 0;
+
+	if (IS_ERR_OR_NULL(req))
+		return -EINVAL;
+
+	mutex_lock(&emc_bw_lock);
+	if (req->iso_kbps != iso_kbps || req->noniso_kbps != noniso_kbps) {
+		req->iso_kbps = iso_kbps;
+		req->noniso_kbps = noniso_kbps;
+		ret = tegra_emc_bw_update();
+	}
+	mutex_unlock(&emc_bw_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL(tegra_emc_bw_set);
+
+void tegra_emc_bw_unregister(struct tegra_emc_bw_req *req)
+{
+	if (IS_ERR_OR_NULL(req))
+		return;
+
+	mutex_lock(&emc_bw_lock);
+	list_del(&req->node);
+	tegra_emc_bw_update();
+	mutex_unlock(&emc_bw_lock);
+
+	kfree_const(req->name);
+	kfree(req);
+}
+EXPORT_SYMBOL(tegra_emc_bw_unregister);
+
+unsigned long tegra_emc_bw_floor(void)
+{
+	unsigned long floor_khz;
+
+	mutex_lock(&emc_bw_lock);
+	floor_khz = emc_bw_floor_khz;
+	mutex_unlock(&emc_bw_lock);
+
+	return floor_khz;
+}
+EXPORT_SYMBOL(tegra_emc_bw_floor);
+
+static void tegra_emc_bw_init_t23x(void)
+{
+	struct device_node *np;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(emc_bw_efficiency_t23x); i++) {
+		if (emc_bw_efficiency_t23x[i].ch_num <= ch_num) {
+			emc_bw_iso_pct = emc_bw_efficiency_t23x[i].iso_pct;
+			emc_bw_noniso_pct = emc_bw_efficiency_t23x[i].noniso_pct;
+			break;
+		}
+	}
+
+	/* Without the EMC clock the floor is only computed and reported */
+	np = of_find_compatible_node(NULL, NULL, "nvidia,tegra234-emc");
+	if (np) {
+		emc_bw_clk = of_clk_get_by_name(np, "emc");
+		if (IS_ERR(emc_bw_clk))
+			emc_bw_clk = NULL;
+		of_node_put(np);
+	}
+}
+
 #if defined(CONFIG_DEBUG_FS)
+static int tegra_emc_bw_requests_show(struct seq_file *s, void *data)
+{
+	struct tegra_emc_bw_req *req;
+
+	mutex_lock(&emc_bw_lock);
+	seq_printf(s, "%-24s %12s %12s\n", "client", "iso_kbps", "noniso_kbps");
+	list_for_each_entry(req, &emc_bw_reqs, node)
+		seq_printf(s, "%-24s %12lu %12lu\n", req->name, req->iso_kbps,
+			   req->noniso_kbps);
+	seq_printf(s, "floor: %lu kHz\n", emc_bw_floor_khz);
+	mutex_unlock(&emc_bw_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(tegra_emc_bw_requests);
+
 static void tegra_mc_utils_debugfs_init(void)
 {
 	struct dentry *tegra_mc_debug_root = NULL;
@@ -310,6 +480,13 @@ static void tegra_mc_utils_debugfs_init(void)
 
 	debugfs_create_u32("num_channel", 0444, tegra_mc_debug_root,
 			&ch_num);
+
+	debugfs_create_file("emc_bw_requests", 0444, tegra_mc_debug_root,
+			NULL, &tegra_emc_bw_requests_fops);
+	debugfs_create_u32("emc_bw_iso_efficiency", 0644, tegra_mc_debug_root,
+			&emc_bw_iso_pct);
+	debugfs_create_u32("emc_bw_noniso_efficiency", 0644,
+			tegra_mc_debug_root, &emc_bw_noniso_pct);
 }
 #endif
 
@@ -384,6 +561,7 @@ static int __init tegra_mc_utils_init_t23x(void)
 	emc_param.dram = dram;
 
 	set_dram_type();
+	tegra_emc_bw_init_t23x();
 
 #if defined(CONFIG_DEBUG_FS)
 	tegra_mc_utils_debugfs_init();
@@ -404,6 +582,8 @@ module_init(tegra_mc_utils_init);
 
 static void __exit tegra_mc_utils_exit(void)
 {
+	if (emc_bw_clk)
+		clk_put(emc_bw_clk);
 }
 module_exit(tegra_mc_utils_exit);
 
@@ -43,6 +43,13 @@ void actmon_rate_change(unsigned long freq, bool override)
 #define MBOX_TIMEOUT 5000 /* in ms */
 #define HOST_ADSP_DFS_MBOX_ID 3
 
+/*
+ * Number of consecutive lower rate requests from actmon needed before
+ * the adsp cpu clock is actually stepped down. Rate increases are
+ * always applied right away so that deadlines are not missed.
+ */
+#define ADSP_DFS_DOWN_HYSTERESIS 3
+
 enum adsp_dfs_reply {
 	ACK,
 	NACK,
@@ -111,6 +118,10 @@ struct adsp_dfs_policy {
 	struct dentry *root;
 #endif
 	unsigned long ovr_freq;
+
+	unsigned long app_min;	/* Sum of active apps min freq(KHz) */
+	unsigned long down_freq; /* Highest lower freq(KHz) requested */
+	unsigned int down_count;
 };
 
 
@@ -408,23 +419,19 @@ err_out:
 	return tfreq_hz / 1000;
 }
 
-/* Set adsp dfs policy min freq(Khz) */
-static int policy_min_set(void *data, u64 val)
+/*
+ * Set adsp dfs policy min freq(Khz).
+ * Must be called with policy_mutex held.
+ */
+static int __policy_min_set(unsigned long min)
 {
-	int ret = -EINVAL;
-	unsigned long min = (unsigned long)val;
-
-	if (!is_os_running(device))
-		return ret;
-
-	mutex_lock(&policy_mutex);
 	if (!policy->enable) {
 		dev_err(device, "adsp dfs policy is not enabled\n");
-		goto exit_out;
+		return -EINVAL;
 	}
 
 	if (min == policy->min)
-		goto exit_out;
+		return 0;
 	else if (min < policy->cpu_min)
 		min = policy->cpu_min;
 	else if (min >= policy->cpu_max)
@@ -439,8 +446,19 @@ static int policy_min_set(void *data, u64 val)
 	if (min)
 		policy->min = min;
 
-	ret = 0;
-exit_out:
+	return 0;
+}
+
+/* Set adsp dfs policy min freq(Khz) */
+static int policy_min_set(void *data, u64 val)
+{
+	int ret;
+
+	if (!is_os_running(device))
+		return -EINVAL;
+
+	mutex_lock(&policy_mutex);
+	ret = __policy_min_set((unsigned long)val);
 	mutex_unlock(&policy_mutex);
 	return ret;
 }
@@ -705,6 +723,21 @@ void adsp_cpu_set_rate(unsigned long freq)
 	else if (freq > policy->max)
 		freq = policy->max;
 
+	/*
+	 * Step down only once actmon has asked for a lower rate for
+	 * ADSP_DFS_DOWN_HYSTERESIS samples in a row, and then only as far
+	 * as the highest of those requests, to avoid bouncing the clock
+	 * (and the EMC floor that follows it) on bursty load.
+	 */
+	if (freq < policy->cur) {
+		policy->down_freq = max(policy->down_freq, freq);
+		if (++policy->down_count < ADSP_DFS_DOWN_HYSTERESIS)
+			goto exit_out;
+		freq = policy->down_freq;
+	}
+	policy->down_count = 0;
+	policy->down_freq = 0;
+
 	freq = update_freq(freq);
 	if (freq)
 		policy->cur = freq;
@@ -785,6 +818,32 @@ void adsp_update_dfs_min_rate(unsigned long freq)
 }
 EXPORT_SYMBOL(adsp_update_dfs_min_rate);
 
+/*
+ * Account the min ADSP freq needed by an app that is becoming active
+ * (add = true) or inactive (add = false). The dfs policy min freq is
+ * kept at the sum of the requirements of all active apps, so that
+ * stopping one app does not drop the floor of the others.
+ *
+ * @params:
+ * freq: adsp freq in KHz needed by the app
+ */
+void adsp_update_dfs_app_min_rate(unsigned long freq, bool add)
+{
+	if (!freq || !policy)
+		return;
+
+	mutex_lock(&policy_mutex);
+	if (add)
+		policy->app_min += freq;
+	else
+		policy->app_min -= min(freq, policy->app_min);
+
+	if (is_os_running(device))
+		__policy_min_set(policy->app_min);
+	mutex_unlock(&policy_mutex);
+}
+EXPORT_SYMBOL(adsp_update_dfs_app_min_rate);
+
 /* Enable / disable dynamic freq scaling */
 void adsp_update_dfs(bool val)
 {
@@ -26,6 +26,8 @@
 #include <linux/debugfs.h>
 #include <linux/platform_device.h>
 #include <linux/list.h>
+#include <linux/jiffies.h>
+#include <linux/version.h>
 
 #include <linux/tegra_nvadsp.h>
 #include <uapi/linux/sched/types.h>
@@ -36,12 +38,32 @@
 
 #define ADSPFF_MAX_OPEN_FILES	(32)
 
+/* page cache readahead window for sequential reads */
+#define ADSPFF_READAHEAD_SIZE	(512 * 1024)
+
+/* write-behind buffer of write only files and its max age */
+#define ADSPFF_WB_SIZE		(16 * 1024)
+#define ADSPFF_WB_FLUSH_MS	(100)
+
+/*
+ * ra_next: offset the next sequential read starts at
+ * ra_end: end of the range already requested from the page cache
+ * wb_buf: writes not yet passed to the file, NULL for write through
+ * wb_deadline: jiffies by which wb_buf shall be flushed
+ * wb_err: a write-behind failed, reported in the next fwrite ack
+ */
 struct file_struct {
 	struct file *fp;
 	uint8_t file_name[ADSPFF_MAX_FILENAME_SIZE];
 	unsigned int flags;
 	unsigned long long wr_offset;
 	unsigned long long rd_offset;
+	unsigned long long ra_next;
+	unsigned long long ra_end;
+	uint8_t *wb_buf;
+	uint32_t wb_len;
+	unsigned long wb_deadline;
+	bool wb_err;
 	struct list_head list;
 };
 
@@ -106,6 +128,14 @@ static uint32_t file_read(struct file *file, unsigned long long *offset,
 	return ret;
 }
 
+static void file_readahead(struct file *file, unsigned long long offset,
+				unsigned int size)
+{
+#if KERNEL_VERSION(4, 19, 0) <= LINUX_VERSION_CODE
+	vfs_fadvise(file, offset, size, POSIX_FADV_WILLNEED);
+#endif
+}
+
 static uint32_t file_size(struct file *file)
 {
 	mm_segment_t oldfs;
@@ -247,10 +277,19 @@ static void adspff_fopen(void)
 
 		file->wr_offset = 0;
 		file->rd_offset = 0;
+		file->ra_next = 0;
+		file->ra_end = 0;
 		memcpy(file->file_name,
 				message->msg.payload.fopen_msg.fname,
 				ADSPFF_MAX_FILENAME_SIZE);
 		file->flags = flags;
+
+		/* logs: buffer writes, write through if no memory */
+		if (file->fp && !(flags & O_RDWR) && (flags & O_WRONLY) &&
+				!file->wb_buf)
+			file->wb_buf = kmalloc(ADSPFF_WB_SIZE, GFP_KERNEL);
+		file->wb_len = 0;
+		file->wb_err = false;
 	}
 
 	if (file && !file->fp) {
@@ -293,6 +332,78 @@ static inline unsigned int is_write_file(struct file_struct *file)
 	return file->flags & (O_WRONLY | O_RDWR);
 }
 
+static void adspff_wb_flush(struct file_struct *file)
+{
+	int ret;
+
+	if (!file->wb_len)
+		return;
+
+	ret = file_write(file->fp, &file->wr_offset, file->wb_buf,
+			file->wb_len);
+	if (ret != file->wb_len) {
+		pr_err("write-behind of %u bytes to %s failed %d\n",
+			file->wb_len, file->file_name, ret);
+		file->wb_err = true;
+	}
+	file->wb_len = 0;
+}
+
+static void adspff_wb_flush_all(bool expired_only)
+{
+	struct file_struct *file;
+
+	list_for_each_entry(file, &file_list, list) {
+		if (!file->wb_len)
+			continue;
+		if (expired_only && time_before(jiffies, file->wb_deadline))
+			continue;
+		adspff_wb_flush(file);
+	}
+}
+
+static bool adspff_wb_pending(void)
+{
+	struct file_struct *file;
+
+	list_for_each_entry(file, &file_list, list) {
+		if (file->wb_len)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * copies size bytes at the read index of the shared write buffer into the
+ * write-behind buffer of file, returns false if they do not fit even into
+ * an empty one.
+ */
+static bool adspff_wb_write(struct file_struct *file, uint32_t size)
+{
+	uint32_t ri = adspff->write_buf.read_index;
+	uint32_t first;
+
+	if (size > ADSPFF_WB_SIZE)
+		return false;
+
+	if (size > ADSPFF_WB_SIZE - file->wb_len)
+		adspff_wb_flush(file);
+
+	if (!file->wb_len)
+		file->wb_deadline = jiffies +
+			msecs_to_jiffies(ADSPFF_WB_FLUSH_MS);
+
+	first = min_t(uint32_t, size, ADSPFF_SHARED_BUFFER_SIZE - ri);
+	memcpy(file->wb_buf + file->wb_len, adspff->write_buf.data + ri,
+			first);
+	memcpy(file->wb_buf + file->wb_len + first, adspff->write_buf.data,
+			size - first);
+	file->wb_len += size;
+
+	return true;
+}
+
 static void adspff_fclose(void)
 {
 	union adspff_message_t *message;
@@ -316,9 +427,13 @@ static void adspff_fclose(void)
 
 	file = (struct file_struct *)message->msg.payload.fclose_msg.file;
 	if (file) {
+		adspff_wb_flush(file);
 		if ((file->flags & O_APPEND) == 0) {
-			if (is_read_file(file))
+			if (is_read_file(file)) {
 				file->rd_offset = 0;
+				file->ra_next = 0;
+				file->ra_end = 0;
+			}
 			if (is_write_file(file))
 				file->wr_offset = 0;
 		}
@@ -348,6 +463,7 @@ static void adspff_fsize(void)
 	}
 	file = (struct file_struct *)message.msg.payload.fsize_msg.file;
 	if (file) {
+		adspff_wb_flush(file);
 		size = file_size(file->fp);
 	}
 
@@ -394,6 +510,14 @@ static void adspff_fwrite(void)
 	file = (struct file_struct *)message.msg.payload.fwrite_msg.file;
 	size = message.msg.payload.fwrite_msg.size;
 
+	/* ack a buffered write as done, a failure is acked with the next */
+	if (file->wb_buf && adspff_wb_write(file, size)) {
+		bytes_written = file->wb_err ? 0 : size;
+		file->wb_err = false;
+		goto advance;
+	}
+	adspff_wb_flush(file);
+
 	bytes_to_write = ((adspff->write_buf.read_index + size) < ADSPFF_SHARED_BUFFER_SIZE) ?
 		size : (ADSPFF_SHARED_BUFFER_SIZE - adspff->write_buf.read_index);
 	ret = file_write(file->fp, &file->wr_offset,
@@ -406,6 +530,7 @@ static void adspff_fwrite(void)
 		bytes_written += ret;
 	}
 
+advance:
 	adspff->write_buf.read_index =
 		(adspff->write_buf.read_index + size) % ADSPFF_SHARED_BUFFER_SIZE;
 
@@ -424,6 +549,29 @@ static void adspff_fwrite(void)
 	kfree(msg_recv);
 }
 
+/*
+ * keeps the page cache ADSPFF_READAHEAD_SIZE / 2 to ADSPFF_READAHEAD_SIZE
+ * ahead of sequential reads, so that the small ADSP reads are copies from
+ * the page cache instead of waiting for storage.
+ */
+static void adspff_readahead(struct file_struct *file)
+{
+	unsigned long long offset = file->rd_offset;
+
+	if (offset != file->ra_next) {
+		file->ra_end = offset;
+		return;
+	}
+
+	if (file->ra_end < offset)
+		file->ra_end = offset;
+	if (file->ra_end - offset >= ADSPFF_READAHEAD_SIZE / 2)
+		return;
+
+	file_readahead(file->fp, file->ra_end, ADSPFF_READAHEAD_SIZE);
+	file->ra_end += ADSPFF_READAHEAD_SIZE;
+}
+
 static void adspff_fread(void)
 {
 	union adspff_message_t *message;
@@ -473,6 +621,9 @@ static void adspff_fread(void)
 		goto send_ack;
 	}
 
+	adspff_wb_flush(file);
+	adspff_readahead(file);
+
 	if (can_wrap) {
 		uint32_t bytes_to_read = (size < (ADSPFF_SHARED_BUFFER_SIZE - wi)) ?
 			size : (ADSPFF_SHARED_BUFFER_SIZE - wi);
@@ -494,6 +645,7 @@ static void adspff_fread(void)
 		goto send_ack;
 	}
 send_ack:
+	file->ra_next = file->rd_offset;
 	msg_recv->msg.payload.ack_msg.size = size_read;
 	ret = msgq_queue_message(&adspff->msgq_recv.msgq,
 			(msgq_message_t *)msg_recv);
@@ -531,20 +683,33 @@ struct adspff_kthread_msg {
 static int adspff_kthread_fn(void *data)
 {
 	int ret = 0;
-	struct adspff_kthread_msg *kmsg;
+	struct adspff_kthread_msg *kmsg, *n;
 	unsigned long flags;
+	LIST_HEAD(msgs);
 
 	while (1) {
 
-		ret = wait_event_interruptible(wait_queue, kthread_should_stop()
-				 || !list_empty(&adspff_kthread_msgq_head));
-
-		if (kthread_should_stop())
+		if (adspff_wb_pending())
+			ret = wait_event_interruptible_timeout(wait_queue,
+				kthread_should_stop() ||
+				!list_empty(&adspff_kthread_msgq_head),
+				msecs_to_jiffies(ADSPFF_WB_FLUSH_MS));
+		else
+			ret = wait_event_interruptible(wait_queue,
+				kthread_should_stop() ||
+				!list_empty(&adspff_kthread_msgq_head));
+
+		if (kthread_should_stop()) {
+			adspff_wb_flush_all(false);
 			do_exit(0);
+		}
 
-		if (!list_empty(&adspff_kthread_msgq_head)) {
-			kmsg = list_first_entry(&adspff_kthread_msgq_head,
-					struct adspff_kthread_msg, list);
+		/* service all the requests ADSP has outstanding */
+		spin_lock_irqsave(&adspff_lock, flags);
+		list_splice_tail_init(&adspff_kthread_msgq_head, &msgs);
+		spin_unlock_irqrestore(&adspff_lock, flags);
+
+		list_for_each_entry_safe(kmsg, n, &msgs, list) {
 			switch (kmsg->msg_id) {
 			case adspff_cmd_fopen:
 				adspff_fopen();
@@ -565,11 +730,11 @@ static int adspff_kthread_fn(void *data)
 				pr_warn("adspff: kthread unsupported msg %d\n",
 					kmsg->msg_id);
 			}
-			spin_lock_irqsave(&adspff_lock, flags);
 			list_del(&kmsg->list);
-			spin_unlock_irqrestore(&adspff_lock, flags);
 			kfree(kmsg);
 		}
+
+		adspff_wb_flush_all(true);
 	}
 
 	do_exit(ret);
@@ -610,8 +775,11 @@ static int adspff_set(void *data, u64 val)
 	list_for_each_safe(pos, n, &file_list) {
 		file = list_entry(pos, struct file_struct, list);
 		list_del(pos);
-		if (file->fp)
+		if (file->fp) {
+			adspff_wb_flush(file);
 			file_close(file->fp);
+		}
+		kfree(file->wb_buf);
 		kfree(file);
 	}
 
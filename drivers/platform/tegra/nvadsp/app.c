@@ -10,6 +10,8 @@
 #include <linux/dma-buf.h>
 #include <linux/slab.h>
 #include <linux/elf.h>
+#include <linux/ktime.h>
+#include <linux/mm.h>
 
 #include "aram_manager.h"
 #include "os.h"
@@ -256,10 +258,121 @@ err_out:
 	return ret;
 }
 
+/*
+ * Fixed size record per app instance returned by adsp_apps/stats.
+ * Whole table is snapshot at open so that a single read gives a
+ * consistent view without per app file walks.
+ */
+struct nvadsp_app_stats_record {
+	char name[NVADSP_NAME_SZ];
+	int32_t instance_id;
+	int32_t state;
+	uint32_t run_count;
+	uint32_t reserved;
+	uint64_t run_ns;
+	uint64_t dram;
+	uint64_t dram_shared;
+	uint64_t dram_shared_wc;
+	uint64_t aram;
+	uint64_t aram_x;
+};
+
+struct nvadsp_app_stats_buf {
+	size_t size;
+	struct nvadsp_app_stats_record rec[];
+};
+
+static void fill_app_stats_record(struct nvadsp_app_stats_record *rec,
+	nvadsp_app_info_t *app, const struct app_mem_size *mem_size)
+{
+	u64 run_ns = READ_ONCE(app->run_ns);
+	ktime_t start_ts = READ_ONCE(app->start_ts);
+
+	/* include the ongoing run of an app that has not completed yet */
+	if (start_ts)
+		run_ns += ktime_to_ns(ktime_sub(ktime_get(), start_ts));
+
+	strscpy(rec->name, app->name, NVADSP_NAME_SZ);
+	rec->instance_id = app->instance_id;
+	rec->state = READ_ONCE(app->state);
+	rec->run_count = READ_ONCE(app->run_count);
+	rec->run_ns = run_ns;
+	rec->dram = mem_size->dram;
+	rec->dram_shared = mem_size->dram_shared;
+	rec->dram_shared_wc = mem_size->dram_shared_wc;
+	rec->aram = mem_size->aram;
+	rec->aram_x = mem_size->aram_x;
+}
+
+static int app_stats_open(struct inode *inode, struct file *file)
+{
+	struct nvadsp_app_stats_buf *buf;
+	struct nvadsp_app_service *ser;
+	nvadsp_app_info_t *app;
+	int count = 0, i = 0;
+
+	mutex_lock(&priv.service_lock_list);
+	list_for_each_entry(ser, &priv.service_list, node)
+		count += ser->instance;
+
+	buf = kvzalloc(struct_size(buf, rec, count), GFP_KERNEL);
+	if (!buf) {
+		mutex_unlock(&priv.service_lock_list);
+		return -ENOMEM;
+	}
+
+	list_for_each_entry(ser, &priv.service_list, node) {
+		mutex_lock(&ser->lock);
+		list_for_each_entry(app, &ser->app_head, node) {
+			if (i == count)
+				break;
+			fill_app_stats_record(&buf->rec[i++], app,
+					      ser->mem_size);
+		}
+		mutex_unlock(&ser->lock);
+	}
+	mutex_unlock(&priv.service_lock_list);
+
+	buf->size = i * sizeof(buf->rec[0]);
+	file->private_data = buf;
+
+	return 0;
+}
+
+static ssize_t app_stats_read(struct file *file, char __user *user_buf,
+	size_t count, loff_t *ppos)
+{
+	struct nvadsp_app_stats_buf *buf = file->private_data;
+
+	return simple_read_from_buffer(user_buf, count, ppos, buf->rec,
+				       buf->size);
+}
+
+static int app_stats_release(struct inode *inode, struct file *file)
+{
+	kvfree(file->private_data);
+	return 0;
+}
+
+static const struct file_operations app_stats_node_operations = {
+	.open = app_stats_open,
+	.read = app_stats_read,
+	.llseek = default_llseek,
+	.release = app_stats_release,
+};
+
 static int __init adsp_app_debug_init(struct dentry *root)
 {
 	priv.adsp_app_debugfs_root = debugfs_create_dir("adsp_apps", root);
-	return IS_ERR_OR_NULL(priv.adsp_app_debugfs_root) ? -ENOMEM : 0;
+	if (IS_ERR_OR_NULL(priv.adsp_app_debugfs_root))
+		return -ENOMEM;
+
+	if (IS_ERR_OR_NULL(debugfs_create_file("stats", S_IRUSR,
+			priv.adsp_app_debugfs_root, NULL,
+			&app_stats_node_operations)))
+		return -ENOMEM;
+
+	return 0;
 }
 #endif /* CONFIG_DEBUG_FS */
 
@@ -293,49 +406,65 @@ static nvadsp_app_handle_t app_load(const char *appfile,
 	struct nvadsp_drv_data *drv_data;
 	struct device *dev = &priv.pdev->dev;
 	char appname[NVADSP_NAME_SZ] = { };
-	struct nvadsp_app_service *ser;
+	struct nvadsp_app_service *ser, *loaded;
 
 	drv_data = platform_get_drvdata(priv.pdev);
 	extract_appname(appname, appfile);
 	mutex_lock(&priv.service_lock_list);
 	ser = get_loaded_service(appname);
-	if (!ser) {
-
-		/* dynamic loading is disabled when running in secure mode */
-		if (drv_data->adsp_os_secload && dynamic)
-			goto err;
-		dev_dbg(dev, "loading app %s %s\n", appfile, appname);
-		ser = devm_kzalloc(dev, sizeof(*ser), GFP_KERNEL);
-		if (!ser)
-			goto err;
-		strscpy(ser->name, appname, NVADSP_NAME_SZ);
-
-		/*load the module in to memory */
-		ser->mod = dynamic ?
-			load_adsp_dynamic_module(appfile, appfile, dev) :
-			load_adsp_static_module(appfile, shared_app, dev);
-		if (IS_ERR_OR_NULL(ser->mod))
-			goto err_free_service;
-		ser->mem_size = &ser->mod->mem_size;
-
-		mutex_init(&ser->lock);
-		INIT_LIST_HEAD(&ser->app_head);
-
-		/* add the app instance service to the list */
-		list_add_tail(&ser->node, &priv.service_list);
+	mutex_unlock(&priv.service_lock_list);
+	if (ser)
+		return ser;
+
+	/* dynamic loading is disabled when running in secure mode */
+	if (drv_data->adsp_os_secload && dynamic)
+		return NULL;
+
+	dev_dbg(dev, "loading app %s %s\n", appfile, appname);
+	ser = devm_kzalloc(dev, sizeof(*ser), GFP_KERNEL);
+	if (!ser)
+		return NULL;
+	strscpy(ser->name, appname, NVADSP_NAME_SZ);
+
+	/*
+	 * Load the module in to memory without holding the service list
+	 * lock, so that independent apps can be loaded in parallel.
+	 */
+	ser->mod = dynamic ?
+		load_adsp_dynamic_module(appfile, appfile, dev) :
+		load_adsp_static_module(appfile, shared_app, dev);
+	if (IS_ERR_OR_NULL(ser->mod))
+		goto err_free_service;
+	ser->mem_size = &ser->mod->mem_size;
+
+	mutex_init(&ser->lock);
+	INIT_LIST_HEAD(&ser->app_head);
+
+	mutex_lock(&priv.service_lock_list);
+	/* the same app may have been loaded concurrently */
+	loaded = get_loaded_service(appname);
+	if (loaded) {
+		mutex_unlock(&priv.service_lock_list);
+		if (ser->mod->dynamic)
+			unload_adsp_module(ser->mod);
+		else
+			kfree(ser->mod);
+		devm_kfree(dev, ser);
+		return loaded;
+	}
+
+	/* add the app instance service to the list */
+	list_add_tail(&ser->node, &priv.service_list);
 #ifdef CONFIG_DEBUG_FS
-		create_adsp_app_debugfs(ser);
+	create_adsp_app_debugfs(ser);
 #endif
-		dev_dbg(dev, "loaded app %s\n", ser->name);
-	}
 	mutex_unlock(&priv.service_lock_list);
+	dev_dbg(dev, "loaded app %s\n", ser->name);
 
 	return ser;
 
 err_free_service:
 	devm_kfree(dev, ser);
-err:
-	mutex_unlock(&priv.service_lock_list);
 	return NULL;
 }
 
@@ -698,6 +827,8 @@ static int start_app_on_adsp(nvadsp_app_info_t *app,
 	msgq_queue_message(msgq_send, &message->msgq_msg);
 	spin_unlock_irqrestore(&drv_data->mbox_lock, flags);
 
+	WRITE_ONCE(app->start_ts, ktime_get());
+	WRITE_ONCE(app->run_count, app->run_count + 1);
 	state = (int *)&app->state;
 	*state = NVADSP_APP_STATE_STARTED;
 
@@ -708,6 +839,7 @@ static int start_app_on_adsp(nvadsp_app_info_t *app,
 		if (app->return_status) {
 			dev_err(dev, "%s app instance %d failed to start\n",
 				app->name, app->instance_id);
+			WRITE_ONCE(app->start_ts, 0);
 			state = (int *)&app->state;
 			*state = NVADSP_APP_STATE_INITIALIZED;
 		}
@@ -938,6 +1070,11 @@ static status_t nvadsp_app_receive_handler(uint32_t msg, void *hdata)
 		complete_all(&app->wait_for_app_start);
 		break;
 	case ADSP_APP_COMPLETE_STATUS:
+		if (app->start_ts) {
+			WRITE_ONCE(app->run_ns, app->run_ns + ktime_to_ns(
+				ktime_sub(ktime_get(), app->start_ts)));
+			WRITE_ONCE(app->start_ts, 0);
+		}
 		complete_all(&app->wait_for_app_complete);
 		break;
 	}
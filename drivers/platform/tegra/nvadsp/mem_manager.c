@@ -8,98 +8,156 @@
 #include <linux/string.h>
 #include <linux/err.h>
 #include <linux/seq_file.h>
+#include <linux/bitops.h>
+#include <linux/kernel.h>
 
 #include "mem_manager.h"
 
 static void clear_alloc_list(struct mem_manager_info *mm_info);
 
+static inline unsigned int mem_size_class(unsigned long size)
+{
+	return fls_long(size) - 1;
+}
+
+static void mem_class_add(struct mem_manager_info *mm_info,
+		struct mem_chunk *mc)
+{
+	unsigned int class = mem_size_class(mc->size);
+
+	list_add(&mc->class_node, &mm_info->classes[class]);
+	__set_bit(class, &mm_info->class_map);
+}
+
+static void mem_class_del(struct mem_manager_info *mm_info,
+		struct mem_chunk *mc)
+{
+	unsigned int class = mem_size_class(mc->size);
+
+	list_del(&mc->class_node);
+	if (list_empty(&mm_info->classes[class]))
+		__clear_bit(class, &mm_info->class_map);
+}
+
+/*
+ * Find the free chunk to carve size bytes from. Chunks in the size class
+ * of the request may still be smaller than it, so that class is searched
+ * for the best fit. Otherwise any chunk of the next non empty class fits,
+ * which is found through the class bitmap without walking the free list.
+ */
+static struct mem_chunk *mem_find_free(struct mem_manager_info *mm_info,
+		size_t size)
+{
+	unsigned int class = mem_size_class(size);
+	struct mem_chunk *mc_iterator, *best_match_chunk = NULL;
+
+	list_for_each_entry(mc_iterator, &mm_info->classes[class], class_node) {
+		if (mc_iterator->size < size)
+			continue;
+		if (best_match_chunk == NULL ||
+		    mc_iterator->size < best_match_chunk->size)
+			best_match_chunk = mc_iterator;
+	}
+
+	if (best_match_chunk)
+		return best_match_chunk;
+
+	class = find_next_bit(&mm_info->class_map, MEM_NR_CLASSES, class + 1);
+	if (class >= MEM_NR_CLASSES)
+		return NULL;
+
+	return list_first_entry(&mm_info->classes[class],
+			struct mem_chunk, class_node);
+}
+
+/* Keep the alloc list sorted by address for dumps */
+static void mem_alloc_list_add(struct mem_manager_info *mm_info,
+		struct mem_chunk *mc)
+{
+	struct mem_chunk *mc_iterator;
+
+	list_for_each_entry(mc_iterator, mm_info->alloc_list, node) {
+		if (mc->address < mc_iterator->address) {
+			list_add_tail(&mc->node, &mc_iterator->node);
+			return;
+		}
+	}
+	list_add_tail(&mc->node, mm_info->alloc_list);
+}
+
 void *mem_request(void *mem_handle, const char *name, size_t size)
 {
 	unsigned long flags;
 	struct mem_manager_info *mm_info =
 		(struct mem_manager_info *)mem_handle;
-	struct mem_chunk *mc_iterator = NULL, *best_match_chunk = NULL;
+	struct mem_chunk *best_match_chunk = NULL;
 	struct mem_chunk *new_mc = NULL;
 
+	if (!size)
+		return ERR_PTR(-EINVAL);
+
 	spin_lock_irqsave(&mm_info->lock, flags);
 
 	/* Is mem full? */
 	if (list_empty(mm_info->free_list)) {
 		pr_err("%s : memory full\n", mm_info->name);
+		mm_info->alloc_failures++;
 		spin_unlock_irqrestore(&mm_info->lock, flags);
 		return ERR_PTR(-ENOMEM);
 	}
 
-	/* Find the best size match */
-	list_for_each_entry(mc_iterator, mm_info->free_list, node) {
-		if (mc_iterator->size >= size) {
-			if (best_match_chunk == NULL)
-				best_match_chunk = mc_iterator;
-			else if (mc_iterator->size < best_match_chunk->size)
-				best_match_chunk = mc_iterator;
-		}
-	}
+	best_match_chunk = mem_find_free(mm_info, size);
 
 	/* Is free node found? */
 	if (best_match_chunk == NULL) {
 		pr_err("%s : no enough memory available\n", mm_info->name);
+		mm_info->alloc_failures++;
 		spin_unlock_irqrestore(&mm_info->lock, flags);
 		return ERR_PTR(-ENOMEM);
 	}
 
 	/* Is it exact match? */
 	if (best_match_chunk->size == size) {
+		mem_class_del(mm_info, best_match_chunk);
 		list_del(&best_match_chunk->node);
-		list_for_each_entry(mc_iterator, mm_info->alloc_list, node) {
-			if (best_match_chunk->address < mc_iterator->address) {
-				list_add_tail(&best_match_chunk->node,
-						&mc_iterator->node);
-				strscpy(best_match_chunk->name, name,
-						NAME_SIZE);
-				spin_unlock_irqrestore(&mm_info->lock, flags);
-				return best_match_chunk;
-			}
-		}
-		list_add(&best_match_chunk->node, mm_info->alloc_list);
 		strscpy(best_match_chunk->name, name, NAME_SIZE);
+		mem_alloc_list_add(mm_info, best_match_chunk);
 		spin_unlock_irqrestore(&mm_info->lock, flags);
 		return best_match_chunk;
-	} else {
-		new_mc = kzalloc(sizeof(struct mem_chunk), GFP_ATOMIC);
-		if (unlikely(!new_mc)) {
-			pr_err("failed to allocate memory for mem_chunk\n");
+	}
+
+	new_mc = kzalloc(sizeof(struct mem_chunk), GFP_ATOMIC);
+	if (unlikely(!new_mc)) {
+		pr_err("failed to allocate memory for mem_chunk\n");
 
-			spin_unlock_irqrestore(&mm_info->lock, flags);
-			return ERR_PTR(-ENOMEM);
-		}
-		new_mc->address = best_match_chunk->address;
-		new_mc->size = size;
-		strscpy(new_mc->name, name, NAME_SIZE);
-		best_match_chunk->address += size;
-		best_match_chunk->size -= size;
-		list_for_each_entry(mc_iterator, mm_info->alloc_list, node) {
-			if (new_mc->address < mc_iterator->address) {
-				list_add_tail(&new_mc->node,
-						&mc_iterator->node);
-				spin_unlock_irqrestore(&mm_info->lock, flags);
-				return new_mc;
-			}
-		}
-		list_add_tail(&new_mc->node, mm_info->alloc_list);
 		spin_unlock_irqrestore(&mm_info->lock, flags);
-		return new_mc;
+		return ERR_PTR(-ENOMEM);
 	}
+	new_mc->address = best_match_chunk->address;
+	new_mc->size = size;
+	strscpy(new_mc->name, name, NAME_SIZE);
+
+	/* Remainder may drop into a lower size class */
+	mem_class_del(mm_info, best_match_chunk);
+	best_match_chunk->address += size;
+	best_match_chunk->size -= size;
+	mem_class_add(mm_info, best_match_chunk);
+
+	mem_alloc_list_add(mm_info, new_mc);
+	spin_unlock_irqrestore(&mm_info->lock, flags);
+	return new_mc;
 }
 
 /*
- * Find the node with sepcified address and remove it from list
+ * Return the chunk to the address sorted free list and coalesce it
+ * with its free neighbours on either side.
  */
 bool mem_release(void *mem_handle, void *handle)
 {
 	unsigned long flags;
 	struct mem_manager_info *mm_info =
 		(struct mem_manager_info *)mem_handle;
-	struct mem_chunk *mc_curr = NULL, *mc_prev = NULL;
+	struct mem_chunk *mc_curr = NULL, *mc_prev = NULL, *mc_next = NULL;
 	struct mem_chunk *mc_free = (struct mem_chunk *)handle;
 
 	pr_debug(" addr = %lu, size = %lu, name = %s\n",
@@ -109,48 +167,42 @@ bool mem_release(void *mem_handle, void *handle)
 
 	list_for_each_entry(mc_curr, mm_info->free_list, node) {
 		if (mc_free->address < mc_curr->address) {
-
-			strscpy(mc_free->name, "FREE", NAME_SIZE);
-
-			/* adjacent next free node */
-			if (mc_curr->address ==
-				(mc_free->address + mc_free->size)) {
-
-				mc_curr->address = mc_free->address;
-				mc_curr->size += mc_free->size;
-				list_del(&mc_free->node);
-				kfree(mc_free);
-
-				/* and adjacent prev free node */
-				if ((mc_prev != NULL) &&
-				   ((mc_prev->address + mc_prev->size) ==
-						mc_curr->address)) {
-
-					mc_prev->size += mc_curr->size;
-					list_del(&mc_curr->node);
-					kfree(mc_curr);
-				}
-			}
-			/* adjacent prev free node */
-			else if ((mc_prev != NULL) &&
-				((mc_prev->address + mc_prev->size) ==
-						mc_free->address)) {
-
-				mc_prev->size += mc_free->size;
-				list_del(&mc_free->node);
-				kfree(mc_free);
-			} else {
-				list_del(&mc_free->node);
-				list_add_tail(&mc_free->node,
-						&mc_curr->node);
-			}
-			spin_unlock_irqrestore(&mm_info->lock, flags);
-			return true;
+			mc_next = mc_curr;
+			break;
 		}
 		mc_prev = mc_curr;
 	}
+
+	strscpy(mc_free->name, "FREE", NAME_SIZE);
+	list_del(&mc_free->node);
+	if (mc_next)
+		list_add_tail(&mc_free->node, &mc_next->node);
+	else
+		list_add_tail(&mc_free->node, mm_info->free_list);
+
+	/* adjacent prev free node */
+	if ((mc_prev != NULL) &&
+	    ((mc_prev->address + mc_prev->size) == mc_free->address)) {
+		mem_class_del(mm_info, mc_prev);
+		mc_prev->size += mc_free->size;
+		list_del(&mc_free->node);
+		kfree(mc_free);
+		mc_free = mc_prev;
+	}
+
+	/* adjacent next free node */
+	if ((mc_next != NULL) &&
+	    ((mc_free->address + mc_free->size) == mc_next->address)) {
+		mem_class_del(mm_info, mc_next);
+		mc_free->size += mc_next->size;
+		list_del(&mc_next->node);
+		kfree(mc_next);
+	}
+
+	mem_class_add(mm_info, mc_free);
+
 	spin_unlock_irqrestore(&mm_info->lock, flags);
-	return false;
+	return true;
 }
 
 inline unsigned long mem_get_address(void *handle)
@@ -183,6 +235,37 @@ void mem_print(void *mem_handle)
 	pr_info("------------------------------------\n");
 }
 
+static void mem_dump_stats(struct mem_manager_info *mm_info,
+		struct seq_file *s)
+{
+	unsigned long free = 0, largest = 0, chunks = 0;
+	unsigned long class_chunks[MEM_NR_CLASSES] = { 0 };
+	struct mem_chunk *mc_iterator = NULL;
+	unsigned long flags;
+	unsigned int class;
+
+	spin_lock_irqsave(&mm_info->lock, flags);
+	list_for_each_entry(mc_iterator, mm_info->free_list, node) {
+		free += mc_iterator->size;
+		largest = max(largest, mc_iterator->size);
+		class_chunks[mem_size_class(mc_iterator->size)]++;
+		chunks++;
+	}
+	spin_unlock_irqrestore(&mm_info->lock, flags);
+
+	/* Share of free memory not usable by a single largest request */
+	seq_printf(s, "%s STATS\n", mm_info->name);
+	seq_printf(s, "  free = %lu, chunks = %lu, largest = %lu, fragmentation = %lu%%\n",
+		free, chunks, largest,
+		free ? 100 - (largest * 100 / free) : 0);
+	seq_printf(s, "  alloc failures = %lu\n", mm_info->alloc_failures);
+	for (class = 0; class < MEM_NR_CLASSES; class++) {
+		if (class_chunks[class])
+			seq_printf(s, "  class %u (>= %lu): chunks = %lu\n",
+				class, 1UL << class, class_chunks[class]);
+	}
+}
+
 void mem_dump(void *mem_handle, struct seq_file *s)
 {
 	struct mem_manager_info *mm_info =
@@ -204,6 +287,8 @@ void mem_dump(void *mem_handle, struct seq_file *s)
 			mc_iterator->name);
 	}
 
+	mem_dump_stats(mm_info, s);
+
 	seq_puts(s, "---------------------------------------\n");
 }
 
@@ -226,6 +311,7 @@ void *create_mem_manager(const char *name, unsigned long start_address,
 {
 	void *ret = NULL;
 	struct mem_chunk *mc;
+	unsigned int i;
 	struct mem_manager_info *mm_info =
 			kzalloc(sizeof(struct mem_manager_info), GFP_KERNEL);
 	if (unlikely(!mm_info)) {
@@ -251,6 +337,8 @@ void *create_mem_manager(const char *name, unsigned long start_address,
 
 	INIT_LIST_HEAD(mm_info->alloc_list);
 	INIT_LIST_HEAD(mm_info->free_list);
+	for (i = 0; i < MEM_NR_CLASSES; i++)
+		INIT_LIST_HEAD(&mm_info->classes[i]);
 
 	mm_info->start_address = start_address;
 	mm_info->size = size;
@@ -267,6 +355,7 @@ void *create_mem_manager(const char *name, unsigned long start_address,
 	mc->size = mm_info->size;
 	strscpy(mc->name, "FREE", NAME_SIZE);
 	list_add(&mc->node, mm_info->free_list);
+	mem_class_add(mm_info, mc);
 	spin_lock_init(&mm_info->lock);
 
 	return (void *)mm_info;
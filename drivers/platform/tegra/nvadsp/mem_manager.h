@@ -7,11 +7,16 @@
 #define __TEGRA_NVADSP_MEM_MANAGER_H
 
 #include <linux/sizes.h>
+#include <linux/bitops.h>
 
 #define NAME_SIZE SZ_16
 
+/* Free chunks are binned by size class, i.e. by fls(size) - 1 */
+#define MEM_NR_CLASSES BITS_PER_LONG
+
 struct mem_chunk {
 	struct list_head node;
+	struct list_head class_node;	/* size class bin, free chunks only */
 	char name[NAME_SIZE];
 	unsigned long address;
 	unsigned long size;
@@ -23,6 +28,9 @@ struct mem_manager_info {
 	char name[NAME_SIZE];
 	unsigned long start_address;
 	unsigned long size;
+	struct list_head classes[MEM_NR_CLASSES];
+	unsigned long class_map;	/* bitmap of non empty classes */
+	unsigned long alloc_failures;
 	spinlock_t lock;
 };
 
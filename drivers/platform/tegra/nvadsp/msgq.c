@@ -166,3 +166,122 @@ int32_t msgq_dequeue_message(msgq_t *msgq, msgq_message_t *message)
 	return ret;
 }
 EXPORT_SYMBOL(msgq_dequeue_message);
+/**
+ * msgq_peek_message - Returns the top message in place
+ * @msgq:           pointer to the client message queue
+ * @message:        set to the top message within the queue
+ *
+ * This function returns 0 if no error has occurred. The message is
+ * not removed from the queue and it must be released by
+ * msgq_commit_message() once processed. -ENOMSG will be returned if
+ * there is no message in the queue and -EAGAIN if the message wraps
+ * around the queue end, in which case it has to be copied out with
+ * msgq_dequeue_message().
+ *
+ *
+ */
+int32_t msgq_peek_message(msgq_t *msgq, msgq_message_t **message)
+{
+	int32_t ri;
+	int32_t msize;
+	msgq_message_t *msg;
+
+	if (!msgq || !message) {
+		pr_err("NULL: msgq %p message %p\n", msgq, message);
+		return -EFAULT; /* Bad Address */
+	}
+
+	ri = msgq->read_index;
+	if (ri == msgq->write_index)
+		return -ENOMSG;
+
+	/* read message only after the write index update is seen */
+	rmb();
+	msg = (msgq_message_t *)&msgq->queue[ri];
+	msize = MSGQ_MESSAGE_HEADER_WSIZE + msg->size;
+	if (msize > msgq->size - ri)
+		return -EAGAIN;
+
+	*message = msg;
+	return 0;
+}
+EXPORT_SYMBOL(msgq_peek_message);
+/**
+ * msgq_commit_message - Releases the message returned by peek
+ * @msgq:           pointer to the client message queue
+ *
+ * This function returns 0 if no error has occurred. The queue space
+ * of the top message is handed back to the writer, the message must
+ * not be accessed after this call.
+ *
+ *
+ */
+int32_t msgq_commit_message(msgq_t *msgq)
+{
+	/* finish in place accesses before the writer can reuse the space */
+	mb();
+	return msgq_dequeue_message(msgq, NULL);
+}
+EXPORT_SYMBOL(msgq_commit_message);
+/**
+ * msgq_queue_messages - Queues a batch of messages in the queue
+ * @msgq:           pointer to the client message queue
+ * @messages:       array of messages to copy from
+ * @count:          number of messages in the array
+ *
+ * This function returns 0 if no error has occurred. Either all
+ * messages are queued or none, ERR_NO_MEMORY will be returned if the
+ * queue cannot hold the whole batch. The write index is updated once,
+ * so the reader sees the batch after a single notification.
+ *
+ *
+ */
+int32_t msgq_queue_messages(msgq_t *msgq, const msgq_message_t **messages,
+	int32_t count)
+{
+	int32_t ri, wi, qsize, total = 0;
+	int32_t i;
+
+	if (!msgq || !messages || count <= 0) {
+		pr_err("NULL: msgq %p messages %p count %d\n", msgq,
+			messages, count);
+		return -EFAULT; /* Bad Address */
+	}
+
+	ri = msgq->read_index;
+	wi = msgq->write_index;
+	qsize = ri <= wi ? msgq->size - wi + ri : ri - wi;
+
+	for (i = 0; i < count; i++)
+		total += MSGQ_MESSAGE_HEADER_WSIZE + messages[i]->size;
+
+	if (qsize <= total) {
+		/* don't allow read == write */
+		pr_err("%s failed: msgq ri: %d, wi %d, batch size %d\n",
+			__func__, ri, wi, total);
+		return -ENOSPC;
+	}
+
+	for (i = 0; i < count; i++) {
+		int32_t msize = MSGQ_MESSAGE_HEADER_WSIZE + messages[i]->size;
+		int32_t qremainder = msgq->size - wi;
+
+		if (msize < qremainder) {
+			msgq_wmemcpy(&msgq->queue[wi], messages[i], msize);
+			wi += msize;
+		} else {
+			/* message wrapped */
+			msgq_wmemcpy(&msgq->queue[wi], messages[i], qremainder);
+			msgq_wmemcpy(msgq->queue, (int32_t *)messages[i] +
+				qremainder, msize - qremainder);
+			wi += msize - msgq->size;
+		}
+	}
+
+	/* publish the batch only after all messages are written */
+	wmb();
+	msgq->write_index = wi;
+
+	return 0;
+}
+EXPORT_SYMBOL(msgq_queue_messages);
@@ -12,6 +12,7 @@
 #include <linux/dma-mapping.h>
 #include <linux/types.h>
 #include <linux/completion.h>
+#include <linux/slab.h>
 #include "tegra23x_psc.h"
 
 /* EXT_CFG register offset */
@@ -29,6 +30,12 @@
 /* 256MB max size to use for dma_alloc* */
 #define MAX_SHARED_MEM (256 * 1024 * 1024U)
 
+/* Max transfers queued by one PSCIOC_XFER_BATCH */
+#define MAX_BATCH_XFERS 16
+
+/* Alignment of the payloads within the shared memory */
+#define SHARED_MEM_ALIGN 64
+
 struct xfer_info {
 	__u32 opcode[2];
 	void __user *tx_buf;
@@ -51,8 +58,22 @@ union mbox_msg {
 	u32 data[16];
 };
 
+struct xfer_batch {
+	__u32 num_xfers;	/* in: xfers queued, out: xfers completed */
+	__u32 reserved;
+	struct xfer_info __user *xfers;
+};
+
+/* A queued transfer and the offsets of its payloads in the shared memory */
+struct xfer_req {
+	struct xfer_info info;
+	size_t tx_off;
+	size_t rx_off;
+};
+
 #define PSCDBG_IOCTL_BASE 'P'
 #define PSCIOC_XFER_DATA _IOWR(PSCDBG_IOCTL_BASE, 0, struct xfer_info)
+#define PSCIOC_XFER_BATCH _IOWR(PSCDBG_IOCTL_BASE, 1, struct xfer_batch)
 
 struct psc_debug_dev {
 	struct mutex lock;
@@ -65,6 +86,11 @@ struct psc_debug_dev {
 	struct mbox_controller *mbox;	/* our mbox controller */
 
 	bool is_cfg_inited;	/* did we initialize SIDTABLE, etc? */
+
+	/* shared memory for the payloads, kept across transfers */
+	void *shm_virt;
+	dma_addr_t shm_iova;
+	size_t shm_size;
 };
 
 static struct psc_debug_dev psc_debug;
@@ -147,6 +173,13 @@ static int psc_debug_release(struct inode *inode, struct file *file)
 
 	mbox_free_channel(dbg->chan);
 
+	if (dbg->shm_virt) {
+		dma_free_coherent(&dbg->pdev->dev, dbg->shm_size,
+				dbg->shm_virt, dbg->shm_iova);
+		dbg->shm_virt = NULL;
+		dbg->shm_size = 0;
+	}
+
 	file->private_data = NULL;
 
 	mutex_unlock(&dbg->lock);
@@ -219,99 +252,191 @@ return_unlock:
 	return ret < 0 ? ret : count;
 }
 
-static long xfer_data(struct file *file, char __user *data)
+/*
+ * Make the shared memory at least size bytes. It is only grown, so that
+ * transfers of similar size do not allocate and free coherent memory
+ * every time.
+ */
+static int shm_reserve(struct psc_debug_dev *dbg, size_t size)
 {
-	struct psc_debug_dev *dbg = file->private_data;
-	struct platform_device *pdev = dbg->pdev;
-	struct device *dev = &pdev->dev;
-	void *tx_virt = NULL;
-	void *rx_virt = NULL;
-	dma_addr_t tx_phys = 0;
-	dma_addr_t rx_phys = 0;
-	long ret = 0;
-	union mbox_msg msg = {};
-	struct xfer_info info;
-	struct xfer_info __user *ptr_xfer = (struct xfer_info __user *)data;
-
-	if (copy_from_user(&info, data, sizeof(struct xfer_info))) {
-		dev_err(&pdev->dev, "failed to copy data.\n");
-		ret = -EFAULT;
+	struct device *dev = &dbg->pdev->dev;
+
+	if (size <= dbg->shm_size)
+		return 0;
+
+	if (dbg->shm_virt)
+		dma_free_coherent(dev, dbg->shm_size, dbg->shm_virt,
+				dbg->shm_iova);
+	dbg->shm_size = 0;
+
+	size = PAGE_ALIGN(size);
+	dbg->shm_virt = dma_alloc_coherent(dev, size, &dbg->shm_iova,
+				GFP_KERNEL);
+	if (dbg->shm_virt == NULL || dbg->shm_iova == 0) {
+		dev_err(dev, "dma_alloc_coherent() failed!\n");
+		if (dbg->shm_virt)
+			dma_free_coherent(dev, size, dbg->shm_virt,
+					dbg->shm_iova);
+		dbg->shm_virt = NULL;
+		return -ENOMEM;
 	}
+	dbg->shm_size = size;
 
-	dev_dbg(dev, "opcode[%x %x]\n", info.opcode[0], info.opcode[1]);
-	dev_dbg(dev, "tx[%p, size:%u], rx[%p, size:%u]\n",
-		info.tx_buf, info.tx_size, info.rx_buf, info.rx_size);
+	return 0;
+}
 
-	if (info.tx_size > MAX_SHARED_MEM || info.rx_size > MAX_SHARED_MEM)
-		return -ENOMEM;
+/*
+ * Run the queued transfers back to back over the mailbox, one mailbox
+ * message per transfer with the payloads passed in the shared memory.
+ * The outputs of the completed transfers are copied back to userspace
+ * even if a later one fails, and their number is returned in completed.
+ */
+static long xfer_run(struct psc_debug_dev *dbg, struct xfer_req *reqs,
+		u32 num, struct xfer_info __user *uxfers, u32 *completed)
+{
+	struct device *dev = &dbg->pdev->dev;
+	union mbox_msg msg = {};
+	struct xfer_info *info;
+	size_t off = 0;
+	long ret = 0;
+	u32 done;
+	u32 i;
+
+	*completed = 0;
+	for (i = 0; i < num; i++) {
+		info = &reqs[i].info;
+
+		dev_dbg(dev, "opcode[%x %x]\n", info->opcode[0], info->opcode[1]);
+		dev_dbg(dev, "tx[%p, size:%u], rx[%p, size:%u]\n",
+			info->tx_buf, info->tx_size, info->rx_buf, info->rx_size);
+
+		if (info->tx_size > MAX_SHARED_MEM || info->rx_size > MAX_SHARED_MEM)
+			return -ENOMEM;
+
+		reqs[i].tx_off = off;
+		if (info->tx_buf && info->tx_size > 0)
+			off += ALIGN(info->tx_size, SHARED_MEM_ALIGN);
+		reqs[i].rx_off = off;
+		if (info->rx_buf && info->rx_size > 0)
+			off += ALIGN(info->rx_size, SHARED_MEM_ALIGN);
+		if (off > MAX_SHARED_MEM)
+			return -ENOMEM;
+	}
 
-	if (info.tx_buf && info.tx_size > 0) {
-		tx_virt = dma_alloc_coherent(dev, info.tx_size,
-					&tx_phys, GFP_KERNEL);
-		if (tx_virt == NULL || tx_phys == 0) {
-			dev_err(dev, "dma_alloc_coherent() failed!\n");
-			ret = -ENOMEM;
-			goto fail;
-		}
+	if (off > 0) {
+		ret = shm_reserve(dbg, off);
+		if (ret)
+			return ret;
+	}
 
-		if (copy_from_user(tx_virt, info.tx_buf, info.tx_size)) {
+	/* stage all the tx payloads first to keep the requests back to back */
+	for (i = 0; i < num; i++) {
+		info = &reqs[i].info;
+		if (!info->tx_buf || info->tx_size == 0)
+			continue;
+
+		if (copy_from_user(dbg->shm_virt + reqs[i].tx_off,
+				info->tx_buf, info->tx_size)) {
 			dev_err(dev, "failed to copy data.\n");
-			ret = -EFAULT;
-			goto free_rx;
+			return -EFAULT;
 		}
-		dma_sync_single_for_device(dev, tx_phys,
-				info.tx_size, DMA_TO_DEVICE);
 	}
 
-	if (info.rx_buf && info.rx_size > 0) {
-		rx_virt = dma_alloc_coherent(dev, info.rx_size,
-				&rx_phys, GFP_KERNEL);
-		if (rx_virt == NULL || rx_phys == 0) {
-			dev_err(dev, "dma_alloc_coherent() failed!\n");
-			ret = -ENOMEM;
-			goto free_tx;
+	for (done = 0; done < num; done++) {
+		info = &reqs[done].info;
+
+		msg.opcode[0] = info->opcode[0];
+		msg.opcode[1] = info->opcode[1];
+		msg.tx_size = info->tx_size;
+		msg.rx_size = info->rx_size;
+		msg.tx_iova = (info->tx_buf && info->tx_size > 0) ?
+			dbg->shm_iova + reqs[done].tx_off : 0;
+		msg.rx_iova = (info->rx_buf && info->rx_size > 0) ?
+			dbg->shm_iova + reqs[done].rx_off : 0;
+
+		ret = send_msg_block(dbg, &msg);
+		if (ret != 0)
+			break;
+
+		memcpy(info->out, dbg->rx_msg, sizeof(info->out));
+	}
+
+	for (i = 0; i < done; i++) {
+		info = &reqs[i].info;
+
+		/* copy mbox payload */
+		if (copy_to_user(&uxfers[i].out[0], &info->out[0],
+				sizeof(info->out))) {
+			dev_err(dev, "failed to mbox out data.\n");
+			return -EFAULT;
+		}
+
+		if (info->rx_buf && info->rx_size > 0 &&
+		    copy_to_user(info->rx_buf, dbg->shm_virt + reqs[i].rx_off,
+				info->rx_size)) {
+			dev_err(dev, "failed to copy_to_user.\n");
+			return -EFAULT;
 		}
+		*completed = i + 1;
 	}
-	dev_dbg(dev, "tx_virt:%p, tx_phys: %p\n", tx_virt, (void *)tx_phys);
-	dev_dbg(dev, "rx_virt:%p, rx_phys: %p\n", rx_virt, (void *)rx_phys);
-
-	msg.opcode[0] = info.opcode[0];
-	msg.opcode[1] = info.opcode[1];
-	msg.tx_iova = tx_phys;
-	msg.rx_iova = rx_phys;
-	msg.tx_size = info.tx_size;
-	msg.rx_size = info.rx_size;
-
-	ret = send_msg_block(dbg, &msg);
-	if (ret != 0)
-		goto free_rx;
-
-	/* copy mbox payload */
-	if (copy_to_user(&ptr_xfer->out[0],
-			&dbg->rx_msg[0], sizeof(dbg->rx_msg))) {
-		dev_err(dev, "failed to mbox out data.\n");
-		ret = -EFAULT;
-		goto free_rx;
+
+	return ret;
+}
+
+static long xfer_data(struct file *file, char __user *data)
+{
+	struct psc_debug_dev *dbg = file->private_data;
+	struct xfer_info __user *ptr_xfer = (struct xfer_info __user *)data;
+	struct xfer_req req = {};
+	u32 completed;
+
+	if (copy_from_user(&req.info, data, sizeof(struct xfer_info))) {
+		dev_err(&dbg->pdev->dev, "failed to copy data.\n");
+		return -EFAULT;
 	}
 
-	if (rx_phys && info.rx_size > 0) {
-		dma_sync_single_for_cpu(dev, rx_phys,
-				info.rx_size, DMA_BIDIRECTIONAL);
+	return xfer_run(dbg, &req, 1, ptr_xfer, &completed);
+}
+
+/*
+ * Queue several transfers at once, e.g. the certificate chain and key
+ * blobs of attestation, sharing one shared memory allocation and without
+ * a round trip to userspace between the requests.
+ */
+static long xfer_batch(struct file *file, char __user *data)
+{
+	struct psc_debug_dev *dbg = file->private_data;
+	struct xfer_batch __user *ptr_batch = (struct xfer_batch __user *)data;
+	struct xfer_batch batch;
+	struct xfer_req *reqs;
+	u32 completed;
+	long ret;
+	u32 i;
 
-		if (copy_to_user(info.rx_buf, rx_virt, msg.rx_size)) {
-			dev_err(dev, "failed to copy_to_user.\n");
+	if (copy_from_user(&batch, data, sizeof(batch)))
+		return -EFAULT;
+
+	if (batch.num_xfers == 0 || batch.num_xfers > MAX_BATCH_XFERS)
+		return -EINVAL;
+
+	reqs = kcalloc(batch.num_xfers, sizeof(*reqs), GFP_KERNEL);
+	if (!reqs)
+		return -ENOMEM;
+
+	for (i = 0; i < batch.num_xfers; i++) {
+		if (copy_from_user(&reqs[i].info, &batch.xfers[i],
+				sizeof(struct xfer_info))) {
 			ret = -EFAULT;
-			goto free_rx;
+			goto free_reqs;
 		}
 	}
 
-free_rx:
-	if (rx_phys)
-		dma_free_coherent(dev, info.rx_size, rx_virt, rx_phys);
-free_tx:
-	if (tx_phys)
-		dma_free_coherent(dev, info.tx_size, tx_virt, tx_phys);
-fail:
+	ret = xfer_run(dbg, reqs, batch.num_xfers, batch.xfers, &completed);
+	if (copy_to_user(&ptr_batch->num_xfers, &completed, sizeof(completed)))
+		ret = -EFAULT;
+
+free_reqs:
+	kfree(reqs);
 	return ret;
 }
 
@@ -327,6 +452,9 @@ psc_debug_ioctl(struct file *file, unsigned int cmd, unsigned long data)
 	case PSCIOC_XFER_DATA:
 		ret = xfer_data(file, (char __user *)data);
 		break;
+	case PSCIOC_XFER_BATCH:
+		ret = xfer_batch(file, (char __user *)data);
+		break;
 	default:
 		break;
 	}
@@ -52,6 +52,12 @@ struct tegra_capture_ivc {
 	spinlock_t avl_ctx_list_lock;
 	/** Linked list holding callback contexts */
 	struct list_head avl_ctx_list;
+	/** Number of capture channels registered, protected by cb_ctx_lock */
+	uint32_t num_streams;
+	/** CPU resume latency while streaming in us, 0 if unconstrained */
+	uint32_t cpu_latency_us;
+	/** Per-CPU resume latency requests, held while streaming */
+	struct dev_pm_qos_request *cpu_qos;
 };
 
 /**
@@ -6,10 +6,12 @@
 #include <linux/tegra-capture-ivc.h>
 
 #include <linux/completion.h>
+#include <linux/cpu.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
+#include <linux/pm_qos.h>
 #include <linux/pm_runtime.h>
 #include <soc/tegra/ivc_ext.h>
 #include <linux/tegra-ivc-bus.h>
@@ -23,12 +25,47 @@
 
 #include "capture-ivc-priv.h"
 
+static void tegra_capture_ivc_trace_tx(struct tegra_capture_ivc *civc,
+				const void *req, size_t len, int ret)
+{
+	struct tegra_capture_ivc_msg_header hdr;
+	size_t hdrlen = sizeof(hdr);
+	char const *ch_name = "NULL";
+
+	if (civc->chan)
+		ch_name = dev_name(&civc->chan->dev);
+
+	if (len < hdrlen) {
+		memset(&hdr, 0, hdrlen);
+		memcpy(&hdr, req, len);
+	} else {
+		memcpy(&hdr, req, hdrlen);
+	}
+
+	if (ret < 0)
+		trace_capture_ivc_send_error(ch_name, hdr.msg_id, hdr.channel_id, ret);
+	else
+		trace_capture_ivc_send(ch_name, hdr.msg_id, hdr.channel_id);
+}
+
+/*
+ * Write @count messages of @len bytes each back to back. The messages are
+ * written under a single hold of the write lock and the doorbell is held
+ * back until the whole batch is in the queue, so the peer gets one HSP
+ * notification per batch. The number of messages written is returned in
+ * @sent, the return value is the result of the last write.
+ */
 static int tegra_capture_ivc_tx_(struct tegra_capture_ivc *civc,
-				const void *req, size_t len)
+				const void *req, size_t len, unsigned int count,
+				unsigned int *sent)
 {
 	struct tegra_ivc_channel *chan;
+	const u8 *msg = req;
+	unsigned int i;
 	int ret;
 
+	*sent = 0U;
+
 	chan = civc->chan;
 	if (chan == NULL || WARN_ON(!chan->is_ready))
 		return -EIO;
@@ -39,45 +76,44 @@ static int tegra_capture_ivc_tx_(struct tegra_capture_ivc *civc,
 	if (unlikely(ret))
 		return ret;
 
-	ret = wait_event_interruptible(civc->write_q,
-				tegra_ivc_can_write(&chan->ivc));
-	if (likely(ret == 0))
-		ret = tegra_ivc_write(&chan->ivc, NULL, req, len);
+	if (count > 1U)
+		tegra_ivc_channel_ring_hold(chan);
+
+	for (i = 0U; i < count; i++, msg += len) {
+		/* let the peer drain what is queued before waiting on it */
+		if (count > 1U && !tegra_ivc_can_write(&chan->ivc))
+			tegra_ivc_channel_ring_flush(chan);
+
+		ret = wait_event_interruptible(civc->write_q,
+					tegra_ivc_can_write(&chan->ivc));
+		if (likely(ret == 0))
+			ret = tegra_ivc_write(&chan->ivc, NULL, msg, len);
+
+		tegra_capture_ivc_trace_tx(civc, msg, len, ret);
+
+		if (unlikely(ret < 0))
+			break;
+	}
+
+	if (count > 1U)
+		tegra_ivc_channel_ring_release(chan);
 
 	mutex_unlock(&civc->ivc_wr_lock);
 
 	if (unlikely(ret < 0))
 		dev_err(&chan->dev, "tegra_ivc_write: error %d\n", ret);
 
+	*sent = i;
+
 	return ret;
 }
 
 static int tegra_capture_ivc_tx(struct tegra_capture_ivc *civc,
 				const void *req, size_t len)
 {
-	int ret;
-	struct tegra_capture_ivc_msg_header hdr;
-	size_t hdrlen = sizeof(hdr);
-	char const *ch_name = "NULL";
-
-	if (civc->chan)
-		ch_name = dev_name(&civc->chan->dev);
-
-	if (len < hdrlen) {
-		memset(&hdr, 0, hdrlen);
-		memcpy(&hdr, req, len);
-	} else {
-		memcpy(&hdr, req, hdrlen);
-	}
-
-	ret = tegra_capture_ivc_tx_(civc, req, len);
+	unsigned int sent;
 
-	if (ret < 0)
-		trace_capture_ivc_send_error(ch_name, hdr.msg_id, hdr.channel_id, ret);
-	else
-		trace_capture_ivc_send(ch_name, hdr.msg_id, hdr.channel_id);
-
-	return ret;
+	return tegra_capture_ivc_tx_(civc, req, len, 1U, &sent);
 }
 
 int tegra_capture_ivc_control_submit(const void *control_desc, size_t len)
@@ -98,6 +134,25 @@ int tegra_capture_ivc_capture_submit(const void *capture_desc, size_t len)
 }
 EXPORT_SYMBOL(tegra_capture_ivc_capture_submit);
 
+int tegra_capture_ivc_capture_submit_batch(const void *capture_descs,
+		size_t len, unsigned int count)
+{
+	unsigned int sent;
+	int ret;
+
+	if (WARN_ON(__scivc_capture == NULL))
+		return -ENODEV;
+
+	if (count == 0U)
+		return 0;
+
+	ret = tegra_capture_ivc_tx_(__scivc_capture, capture_descs, len,
+			count, &sent);
+
+	return (sent > 0U) ? (int)sent : ret;
+}
+EXPORT_SYMBOL(tegra_capture_ivc_capture_submit_batch);
+
 int tegra_capture_ivc_register_control_cb(
 		tegra_capture_ivc_cb_func control_resp_cb,
 		uint32_t *trans_id, const void *priv_context)
@@ -217,6 +272,42 @@ int tegra_capture_ivc_notify_chan_id(uint32_t chan_id, uint32_t trans_id)
 }
 EXPORT_SYMBOL(tegra_capture_ivc_notify_chan_id);
 
+/*
+ * Keep the CPUs out of deep idle while capture channels are registered, so
+ * that the capture status indications are not delayed by idle exits.
+ * Must be called with cb_ctx_lock held.
+ */
+static void tegra_capture_ivc_stream_get(struct tegra_capture_ivc *civc)
+{
+	int cpu;
+
+	if (civc->num_streams++ != 0 || civc->cpu_qos == NULL)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct device *cpu_dev = get_cpu_device(cpu);
+
+		if (cpu_dev)
+			dev_pm_qos_add_request(cpu_dev, &civc->cpu_qos[cpu],
+					DEV_PM_QOS_RESUME_LATENCY,
+					civc->cpu_latency_us);
+	}
+}
+
+/* Must be called with cb_ctx_lock held. */
+static void tegra_capture_ivc_stream_put(struct tegra_capture_ivc *civc)
+{
+	int cpu;
+
+	if (--civc->num_streams != 0 || civc->cpu_qos == NULL)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		if (dev_pm_qos_request_active(&civc->cpu_qos[cpu]))
+			dev_pm_qos_remove_request(&civc->cpu_qos[cpu]);
+	}
+}
+
 int tegra_capture_ivc_register_capture_cb(
 		tegra_capture_ivc_cb_func capture_status_ind_cb,
 		uint32_t chan_id, const void *priv_context)
@@ -251,6 +342,7 @@ int tegra_capture_ivc_register_capture_cb(
 
 	civc->cb_ctx[chan_id].cb_func = capture_status_ind_cb;
 	civc->cb_ctx[chan_id].priv_context = priv_context;
+	tegra_capture_ivc_stream_get(civc);
 	mutex_unlock(&civc->cb_ctx_lock);
 
 	return 0;
@@ -330,6 +422,7 @@ int tegra_capture_ivc_unregister_capture_cb(uint32_t chan_id)
 
 	civc->cb_ctx[chan_id].cb_func = NULL;
 	civc->cb_ctx[chan_id].priv_context = NULL;
+	tegra_capture_ivc_stream_put(civc);
 
 	mutex_unlock(&civc->cb_ctx_lock);
 
@@ -451,6 +544,15 @@ static int tegra_capture_ivc_probe(struct tegra_ivc_channel *chan)
 
 	civc->chan = chan;
 
+	/* Optional CPU resume latency to hold while capture is streaming */
+	if (!of_property_read_u32(dev->of_node, NV(cpu-resume-latency-us),
+			&civc->cpu_latency_us)) {
+		civc->cpu_qos = devm_kcalloc(dev, nr_cpu_ids,
+				sizeof(*civc->cpu_qos), GFP_KERNEL);
+		if (unlikely(civc->cpu_qos == NULL))
+			return -ENOMEM;
+	}
+
 	mutex_init(&civc->cb_ctx_lock);
 	mutex_init(&civc->ivc_wr_lock);
 
@@ -40,9 +40,41 @@ static void tegra_ivc_channel_ring(struct tegra_ivc *ivc, void *data)
 		container_of(ivc, struct tegra_ivc_channel, ivc);
 	struct camrtc_hsp *camhsp = (struct camrtc_hsp *) data;
 
+	if (READ_ONCE(chan->ring_holder) == current) {
+		chan->ring_pending = true;
+		return;
+	}
+
 	camrtc_hsp_group_ring(camhsp, chan->group);
 }
 
+void tegra_ivc_channel_ring_hold(struct tegra_ivc_channel *chan)
+{
+	WRITE_ONCE(chan->ring_holder, current);
+}
+EXPORT_SYMBOL(tegra_ivc_channel_ring_hold);
+
+void tegra_ivc_channel_ring_flush(struct tegra_ivc_channel *chan)
+{
+	struct tegra_ivc *ivc = &chan->ivc;
+
+	if (WARN_ON(READ_ONCE(chan->ring_holder) != current))
+		return;
+
+	if (chan->ring_pending) {
+		chan->ring_pending = false;
+		camrtc_hsp_group_ring(ivc->notify_data, chan->group);
+	}
+}
+EXPORT_SYMBOL(tegra_ivc_channel_ring_flush);
+
+void tegra_ivc_channel_ring_release(struct tegra_ivc_channel *chan)
+{
+	tegra_ivc_channel_ring_flush(chan);
+	WRITE_ONCE(chan->ring_holder, NULL);
+}
+EXPORT_SYMBOL(tegra_ivc_channel_ring_release);
+
 struct device_type tegra_ivc_channel_type = {
 	.name = "tegra-ivc-channel",
 };
@@ -442,6 +442,8 @@ static void tegra_camrtc_ivc_notify(struct device *dev, u16 group)
 {
 	struct tegra_cam_rtcpu *rtcpu = dev_get_drvdata(dev);
 
+	tegra_rtcpu_trace_doorbell(rtcpu->tracer, group);
+
 	if (rtcpu->ivc)
 		tegra_ivc_bus_notify(rtcpu->ivc, group);
 }
@@ -1,6 +1,8 @@
 // SPDX-License-Identifier: GPL-2.0
 // Copyright (c) 2022-2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
 
+#include <nvidia/conftest.h>
+
 #include "soc/tegra/camrtc-trace.h"
 
 #include <linux/completion.h>
@@ -10,6 +12,7 @@
 #include <linux/ioport.h>
 #include <linux/jiffies.h>
 #include <linux/kernel.h>
+#include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/nospec.h>
 #include <linux/of.h>
@@ -41,6 +44,7 @@ EXPORT_TRACEPOINT_SYMBOL_GPL(capture_ivc_recv);
 #define NV(p) "nvidia," #p
 
 #define WORK_INTERVAL_DEFAULT		100
+#define WORK_INTERVAL_MIN_DEFAULT	10
 #define EXCEPTION_STR_LENGTH		2048
 
 /*
@@ -77,11 +81,17 @@ struct tegra_rtcpu_trace {
 	/* worker */
 	struct delayed_work work;
 	unsigned long work_interval_jiffies;
+	unsigned long work_interval_min_jiffies;
+	unsigned long work_interval_max_jiffies;
+	u32 doorbell_group;
 
 	/* statistics */
 	u32 n_exceptions;
 	u64 n_events;
 
+	/* raw consumers mapping the trace memory, protected by lock */
+	u32 raw_users;
+
 	/* copy of the latest exception and event */
 	char last_exception_str[EXCEPTION_STR_LENGTH];
 	struct camrtc_event_struct copy_last_event;
@@ -1199,6 +1209,20 @@ static inline void rtcpu_trace_events(struct tegra_rtcpu_trace *tracer)
 	if (old_next == new_next)
 		return;
 
+	/*
+	 * A raw consumer reads the events straight from its own mapping
+	 * of the trace memory, so only account for them here.
+	 */
+	if (tracer->raw_users > 0) {
+		if (new_next > old_next)
+			tracer->n_events += new_next - old_next;
+		else
+			tracer->n_events += tracer->event_entries - old_next +
+				new_next;
+		tracer->event_last_idx = new_next;
+		return;
+	}
+
 	rtcpu_trace_invalidate_entries(tracer,
 				tracer->dma_handle_events,
 				old_next, new_next,
@@ -1240,13 +1264,39 @@ void tegra_rtcpu_trace_flush(struct tegra_rtcpu_trace *tracer)
 }
 EXPORT_SYMBOL(tegra_rtcpu_trace_flush);
 
+void tegra_rtcpu_trace_doorbell(struct tegra_rtcpu_trace *tracer, u16 group)
+{
+	if (tracer == NULL || (tracer->doorbell_group & group) == 0)
+		return;
+
+	/* firmware crossed its fill watermark, drain the ring now */
+	mod_delayed_work(system_wq, &tracer->work, 0);
+}
+EXPORT_SYMBOL(tegra_rtcpu_trace_doorbell);
+
 static void rtcpu_trace_worker(struct work_struct *work)
 {
 	struct tegra_rtcpu_trace *tracer;
+	unsigned long interval;
+	u64 n_events;
 
 	tracer = container_of(work, struct tegra_rtcpu_trace, work.work);
 
+	n_events = tracer->n_events;
 	tegra_rtcpu_trace_flush(tracer);
+	n_events = tracer->n_events - n_events;
+
+	/*
+	 * Poll faster while more than a quarter of the ring fills up
+	 * between runs, and back off towards the configured interval
+	 * while the ring stays empty.
+	 */
+	interval = tracer->work_interval_jiffies;
+	if (n_events > tracer->event_entries / 4)
+		interval = max(interval / 2, tracer->work_interval_min_jiffies);
+	else if (n_events == 0)
+		interval = min(interval * 2, tracer->work_interval_max_jiffies);
+	tracer->work_interval_jiffies = interval;
 
 	/* reschedule */
 	schedule_delayed_work(&tracer->work, tracer->work_interval_jiffies);
@@ -1341,6 +1391,69 @@ static int rtcpu_trace_debugfs_last_event_read(
 DEFINE_SEQ_FOPS(rtcpu_trace_debugfs_last_event,
 	rtcpu_trace_debugfs_last_event_read);
 
+/*
+ * The "raw" file maps the whole trace memory read-only. Userspace
+ * parses struct camrtc_trace_memory_header at offset 0 for the event
+ * ring layout and follows event_next_idx with its own read pointer.
+ * While the file is open the worker skips decoding events to ftrace.
+ */
+static int rtcpu_trace_debugfs_raw_open(struct inode *inode,
+	struct file *file)
+{
+	struct tegra_rtcpu_trace *tracer = inode->i_private;
+
+	file->private_data = tracer;
+
+	mutex_lock(&tracer->lock);
+	tracer->raw_users++;
+	mutex_unlock(&tracer->lock);
+
+	return nonseekable_open(inode, file);
+}
+
+static int rtcpu_trace_debugfs_raw_release(struct inode *inode,
+	struct file *file)
+{
+	struct tegra_rtcpu_trace *tracer = file->private_data;
+
+	mutex_lock(&tracer->lock);
+	tracer->raw_users--;
+	mutex_unlock(&tracer->lock);
+
+	return 0;
+}
+
+static int rtcpu_trace_debugfs_raw_mmap(struct file *file,
+	struct vm_area_struct *vma)
+{
+	struct tegra_rtcpu_trace *tracer = file->private_data;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	if (vma->vm_pgoff != 0 ||
+	    vma->vm_end - vma->vm_start >
+	    PAGE_ALIGN(tracer->trace_memory_size))
+		return -EINVAL;
+
+#if defined(NV_VM_AREA_STRUCT_HAS_CONST_VM_FLAGS) /* Linux v6.3 */
+	vm_flags_clear(vma, VM_MAYWRITE);
+#else
+	vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+
+	return dma_mmap_coherent(tracer->dev, vma, tracer->trace_memory,
+			tracer->dma_handle, tracer->trace_memory_size);
+}
+
+static const struct file_operations rtcpu_trace_debugfs_raw = {
+	.owner = THIS_MODULE,
+	.open = rtcpu_trace_debugfs_raw_open,
+	.release = rtcpu_trace_debugfs_raw_release,
+	.mmap = rtcpu_trace_debugfs_raw_mmap,
+	.llseek = no_llseek,
+};
+
 static void rtcpu_trace_debugfs_deinit(struct tegra_rtcpu_trace *tracer)
 {
 	debugfs_remove_recursive(tracer->debugfs_root);
@@ -1369,6 +1482,11 @@ static void rtcpu_trace_debugfs_init(struct tegra_rtcpu_trace *tracer)
 	if (IS_ERR_OR_NULL(entry))
 		goto failed_create;
 
+	entry = debugfs_create_file("raw", S_IRUSR,
+	    tracer->debugfs_root, tracer, &rtcpu_trace_debugfs_raw);
+	if (IS_ERR_OR_NULL(entry))
+		goto failed_create;
+
 	return;
 
 failed_create:
@@ -1451,6 +1569,16 @@ struct tegra_rtcpu_trace *tegra_rtcpu_trace_create(struct device *dev,
 
 	INIT_DELAYED_WORK(&tracer->work, rtcpu_trace_worker);
 	tracer->work_interval_jiffies = msecs_to_jiffies(param);
+	tracer->work_interval_max_jiffies = tracer->work_interval_jiffies;
+
+	param = min_t(u32, param, WORK_INTERVAL_MIN_DEFAULT);
+	of_property_read_u32(tracer->of_node, NV(interval-min-ms), &param);
+	tracer->work_interval_min_jiffies = clamp(msecs_to_jiffies(param),
+			1UL, tracer->work_interval_max_jiffies);
+
+	/* optional IVC group bits rung by firmware at its fill watermark */
+	of_property_read_u32(tracer->of_node, NV(doorbell-group),
+			&tracer->doorbell_group);
 
 	/* Done with initialization */
 	schedule_delayed_work(&tracer->work, 0);
@@ -7,10 +7,18 @@
 #include <linux/debugfs.h>
 #include <linux/device.h>
 #include <linux/fs.h>
+#include <linux/hrtimer.h>
 #include <linux/io.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/of.h>
+#include <linux/of_device.h>
+#include <linux/perf_event.h>
 #include <linux/platform_device.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
 #include <linux/types.h>
 
 #define	CENTRAL_ACTMON_CTRL_REG			0x0
@@ -19,12 +27,56 @@
 #define CENTRAL_ACTMON_CTRL_SAMPLE_TICK(v)	((v & (0x1 << 10)) >> 10)
 #define CENTRAL_ACTMON_CTRL_SAMPLE_PERIOD(v)	((v & (0xff << 0)) >> 0)
 
+/* Max monitored devices, event config is the device index */
+#define CENTRAL_ACTMON_MAX_DEVS			32
+
+/*
+ * Interval at which counting perf events integrate the average counts,
+ * short enough for avg_count * elapsed_ns not to overflow.
+ */
+#define CENTRAL_ACTMON_PMU_INTERVAL_MS		100
+
+/* A device monitored by the central actmon and its average count */
+struct central_actmon_dev {
+	const char *name;
+	u32 avg_count_reg;
+};
+
+struct central_actmon_soc {
+	const struct central_actmon_dev *devs;
+	u32 num_devs;
+};
+
 struct central_actmon {
 	struct device *dev;
 	struct clk *clk;
 	unsigned long rate;
 	void __iomem *regs;
 	struct dentry *debugfs;
+
+	struct central_actmon_dev *devs;
+	u32 num_devs;
+
+	/* perf PMU counting the activity of each device */
+	struct pmu pmu;
+	struct hrtimer timer;
+	spinlock_t lock;
+	struct list_head active;
+	struct perf_pmu_events_attr *event_attrs;
+	struct attribute **event_attr_ptrs;
+	struct attribute_group events_group;
+	const struct attribute_group *attr_groups[4];
+};
+
+#define to_central_actmon(p) container_of(p, struct central_actmon, pmu)
+
+static const struct central_actmon_dev t234_central_actmon_devs[] = {
+	{ .name = "mc_all", .avg_count_reg = 0x124 },
+};
+
+static const struct central_actmon_soc t234_central_actmon_soc = {
+	.devs = t234_central_actmon_devs,
+	.num_devs = ARRAY_SIZE(t234_central_actmon_devs),
 };
 
 static u32 cactmon_readl(struct central_actmon *cactmon, u32 offset)
@@ -54,6 +106,273 @@ static u32 __central_actmon_sample_period_get(struct central_actmon *cactmon)
 	return sample_period;
 }
 
+/*
+ * The average counts are the activity of the device per sample period,
+ * integrate them over the time elapsed since the event was last updated.
+ * Must be called with cactmon->lock held.
+ */
+static void central_actmon_event_update(struct perf_event *event)
+{
+	struct central_actmon *cactmon = to_central_actmon(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	u64 now = ktime_get_ns();
+	u64 prev = local64_xchg(&hwc->prev_count, now);
+	u64 period_ns;
+	u32 actives;
+
+	period_ns = (u64)__central_actmon_sample_period_get(cactmon) * NSEC_PER_USEC;
+	if (!period_ns || now <= prev)
+		return;
+
+	actives = cactmon_readl(cactmon, cactmon->devs[hwc->idx].avg_count_reg);
+	local64_add(div64_u64((u64)actives * (now - prev), period_ns),
+		    &event->count);
+}
+
+static enum hrtimer_restart central_actmon_pmu_timer(struct hrtimer *timer)
+{
+	struct central_actmon *cactmon = container_of(timer,
+			struct central_actmon, timer);
+	struct perf_event *event;
+	unsigned long flags;
+	bool active;
+
+	spin_lock_irqsave(&cactmon->lock, flags);
+	list_for_each_entry(event, &cactmon->active, active_entry)
+		central_actmon_event_update(event);
+	active = !list_empty(&cactmon->active);
+	spin_unlock_irqrestore(&cactmon->lock, flags);
+
+	if (!active)
+		return HRTIMER_NORESTART;
+
+	hrtimer_forward_now(timer, ms_to_ktime(CENTRAL_ACTMON_PMU_INTERVAL_MS));
+	return HRTIMER_RESTART;
+}
+
+static int central_actmon_event_init(struct perf_event *event)
+{
+	struct central_actmon *cactmon = to_central_actmon(event->pmu);
+
+	if (event->attr.type != event->pmu->type)
+		return -ENOENT;
+
+	/* the central actmon is not per-CPU, count system wide only */
+	if (is_sampling_event(event) || event->attach_state & PERF_ATTACH_TASK)
+		return -EOPNOTSUPP;
+
+	if (event->cpu < 0)
+		return -EINVAL;
+
+	if (event->attr.config >= cactmon->num_devs)
+		return -ENOENT;
+
+	event->hw.idx = event->attr.config;
+
+	return 0;
+}
+
+static void central_actmon_event_start(struct perf_event *event, int flags)
+{
+	struct central_actmon *cactmon = to_central_actmon(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	unsigned long flags_irq;
+	bool first;
+
+	spin_lock_irqsave(&cactmon->lock, flags_irq);
+	local64_set(&hwc->prev_count, ktime_get_ns());
+	first = list_empty(&cactmon->active);
+	list_add_tail(&event->active_entry, &cactmon->active);
+	hwc->state = 0;
+	spin_unlock_irqrestore(&cactmon->lock, flags_irq);
+
+	if (first)
+		hrtimer_start(&cactmon->timer,
+			      ms_to_ktime(CENTRAL_ACTMON_PMU_INTERVAL_MS),
+			      HRTIMER_MODE_REL);
+}
+
+static void central_actmon_event_stop(struct perf_event *event, int flags)
+{
+	struct central_actmon *cactmon = to_central_actmon(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	unsigned long flags_irq;
+
+	if (hwc->state & PERF_HES_STOPPED)
+		return;
+
+	/* the timer stops itself once no event is active */
+	spin_lock_irqsave(&cactmon->lock, flags_irq);
+	central_actmon_event_update(event);
+	list_del(&event->active_entry);
+	hwc->state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+	spin_unlock_irqrestore(&cactmon->lock, flags_irq);
+}
+
+static int central_actmon_event_add(struct perf_event *event, int flags)
+{
+	event->hw.state = PERF_HES_STOPPED | PERF_HES_UPTODATE;
+
+	if (flags & PERF_EF_START)
+		central_actmon_event_start(event, flags);
+
+	return 0;
+}
+
+static void central_actmon_event_del(struct perf_event *event, int flags)
+{
+	central_actmon_event_stop(event, PERF_EF_UPDATE);
+}
+
+static void central_actmon_event_read(struct perf_event *event)
+{
+	struct central_actmon *cactmon = to_central_actmon(event->pmu);
+	unsigned long flags;
+
+	spin_lock_irqsave(&cactmon->lock, flags);
+	if (!(event->hw.state & PERF_HES_STOPPED))
+		central_actmon_event_update(event);
+	spin_unlock_irqrestore(&cactmon->lock, flags);
+}
+
+static ssize_t central_actmon_event_show(struct device *dev,
+		struct device_attribute *attr, char *page)
+{
+	struct perf_pmu_events_attr *pmu_attr;
+
+	pmu_attr = container_of(attr, struct perf_pmu_events_attr, attr);
+	return sprintf(page, "event=0x%02llx\n", pmu_attr->id);
+}
+
+PMU_FORMAT_ATTR(event, "config:0-7");
+
+static struct attribute *central_actmon_pmu_formats[] = {
+	&format_attr_event.attr,
+	NULL,
+};
+
+static const struct attribute_group central_actmon_pmu_format_group = {
+	.name = "format",
+	.attrs = central_actmon_pmu_formats,
+};
+
+static ssize_t cpumask_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return cpumap_print_to_pagebuf(true, buf, cpumask_of(0));
+}
+static DEVICE_ATTR_RO(cpumask);
+
+static struct attribute *central_actmon_pmu_cpumask_attrs[] = {
+	&dev_attr_cpumask.attr,
+	NULL,
+};
+
+static const struct attribute_group central_actmon_pmu_cpumask_group = {
+	.attrs = central_actmon_pmu_cpumask_attrs,
+};
+
+/*
+ * The devices monitored are the ones of the SoC plus any described by
+ * the nvidia,actmon-device-names and nvidia,actmon-device-avg-count-regs
+ * properties, e.g. the per client activity monitors routed by the board.
+ */
+static int central_actmon_parse_devs(struct central_actmon *cactmon,
+		const struct central_actmon_soc *soc)
+{
+	struct device_node *np = cactmon->dev->of_node;
+	int num_dt, i, ret;
+	u32 num;
+
+	num_dt = of_property_count_strings(np, "nvidia,actmon-device-names");
+	if (num_dt < 0)
+		num_dt = 0;
+
+	num = soc->num_devs + num_dt;
+	if (num > CENTRAL_ACTMON_MAX_DEVS)
+		return -EINVAL;
+
+	cactmon->devs = devm_kcalloc(cactmon->dev, num,
+				     sizeof(*cactmon->devs), GFP_KERNEL);
+	if (!cactmon->devs)
+		return -ENOMEM;
+
+	memcpy(cactmon->devs, soc->devs, soc->num_devs * sizeof(*soc->devs));
+
+	for (i = 0; i < num_dt; i++) {
+		struct central_actmon_dev *adev = &cactmon->devs[soc->num_devs + i];
+
+		ret = of_property_read_string_index(np,
+				"nvidia,actmon-device-names", i, &adev->name);
+		if (ret)
+			return ret;
+
+		ret = of_property_read_u32_index(np,
+				"nvidia,actmon-device-avg-count-regs", i,
+				&adev->avg_count_reg);
+		if (ret) {
+			dev_err(cactmon->dev, "no avg count reg for %s\n",
+				adev->name);
+			return ret;
+		}
+	}
+
+	cactmon->num_devs = num;
+
+	return 0;
+}
+
+static int central_actmon_pmu_init(struct central_actmon *cactmon)
+{
+	struct perf_pmu_events_attr *pattr;
+	u32 i;
+
+	cactmon->event_attrs = devm_kcalloc(cactmon->dev, cactmon->num_devs,
+			sizeof(*cactmon->event_attrs), GFP_KERNEL);
+	cactmon->event_attr_ptrs = devm_kcalloc(cactmon->dev,
+			cactmon->num_devs + 1,
+			sizeof(*cactmon->event_attr_ptrs), GFP_KERNEL);
+	if (!cactmon->event_attrs || !cactmon->event_attr_ptrs)
+		return -ENOMEM;
+
+	for (i = 0; i < cactmon->num_devs; i++) {
+		pattr = &cactmon->event_attrs[i];
+		sysfs_attr_init(&pattr->attr.attr);
+		pattr->attr.attr.name = cactmon->devs[i].name;
+		pattr->attr.attr.mode = 0444;
+		pattr->attr.show = central_actmon_event_show;
+		pattr->id = i;
+		cactmon->event_attr_ptrs[i] = &pattr->attr.attr;
+	}
+
+	cactmon->events_group.name = "events";
+	cactmon->events_group.attrs = cactmon->event_attr_ptrs;
+	cactmon->attr_groups[0] = &cactmon->events_group;
+	cactmon->attr_groups[1] = &central_actmon_pmu_format_group;
+	cactmon->attr_groups[2] = &central_actmon_pmu_cpumask_group;
+	cactmon->attr_groups[3] = NULL;
+
+	spin_lock_init(&cactmon->lock);
+	INIT_LIST_HEAD(&cactmon->active);
+	hrtimer_init(&cactmon->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	cactmon->timer.function = central_actmon_pmu_timer;
+
+	cactmon->pmu = (struct pmu) {
+		.module		= THIS_MODULE,
+		.task_ctx_nr	= perf_invalid_context,
+		.event_init	= central_actmon_event_init,
+		.add		= central_actmon_event_add,
+		.del		= central_actmon_event_del,
+		.start		= central_actmon_event_start,
+		.stop		= central_actmon_event_stop,
+		.read		= central_actmon_event_read,
+		.attr_groups	= cactmon->attr_groups,
+		.capabilities	= PERF_PMU_CAP_NO_INTERRUPT,
+	};
+
+	return perf_pmu_register(&cactmon->pmu, "cactmon", -1);
+}
+
 static int central_actmon_sample_period_get(void *data, u64 *val)
 {
 	struct central_actmon *cactmon = (struct central_actmon *)data;
@@ -97,7 +416,9 @@ static void central_actmon_debugfs_init(struct central_actmon *cactmon)
 
 static int central_actmon_probe(struct platform_device *pdev)
 {
+	const struct central_actmon_soc *soc;
 	struct central_actmon *cactmon;
+	int err;
 
 	cactmon = devm_kzalloc(&pdev->dev, sizeof(*cactmon), GFP_KERNEL);
 	if (!cactmon)
@@ -117,6 +438,17 @@ static int central_actmon_probe(struct platform_device *pdev)
 	cactmon->dev = &pdev->dev;
 	platform_set_drvdata(pdev, cactmon);
 
+	soc = of_device_get_match_data(&pdev->dev);
+	err = central_actmon_parse_devs(cactmon, soc);
+	if (err)
+		return dev_err_probe(&pdev->dev, err,
+				     "failed to parse actmon devices\n");
+
+	err = central_actmon_pmu_init(cactmon);
+	if (err)
+		return dev_err_probe(&pdev->dev, err,
+				     "failed to register actmon PMU\n");
+
 	central_actmon_debugfs_init(cactmon);
 
 	return 0;
@@ -127,13 +459,18 @@ static int central_actmon_remove(struct platform_device *pdev)
 	struct central_actmon *cactmon = platform_get_drvdata(pdev);
 
 	debugfs_remove_recursive(cactmon->debugfs);
+	perf_pmu_unregister(&cactmon->pmu);
+	hrtimer_cancel(&cactmon->timer);
 
 	return 0;
 }
 
 
 static const struct of_device_id central_actmon_of_match[] = {
-	{ .compatible = "nvidia,tegra234-cactmon-mc-all", .data = NULL, },
+	{
+		.compatible = "nvidia,tegra234-cactmon-mc-all",
+		.data = &t234_central_actmon_soc,
+	},
 	{},
 };
 MODULE_DEVICE_TABLE(of, central_actmon_of_match);
@@ -255,6 +255,20 @@ static inline void ivc_advance_rx(struct ivc *ivc)
 		ivc->r_pos++;
 }
 
+static inline void ivc_advance_tx_frames(struct ivc *ivc, uint32_t count)
+{
+	WRITE_ONCE(ivc->tx_channel->w_count,
+		   (READ_ONCE(ivc->tx_channel->w_count) + count));
+	ivc->w_pos = (ivc->w_pos + count) % ivc->nframes;
+}
+
+static inline void ivc_advance_rx_frames(struct ivc *ivc, uint32_t count)
+{
+	WRITE_ONCE(ivc->rx_channel->r_count,
+		   (READ_ONCE(ivc->rx_channel->r_count) + count));
+	ivc->r_pos = (ivc->r_pos + count) % ivc->nframes;
+}
+
 static inline int ivc_check_read(struct ivc *ivc)
 {
 	/*
@@ -693,6 +707,170 @@ int tegra_ivc_write_advance(struct ivc *ivc)
 }
 EXPORT_SYMBOL(tegra_ivc_write_advance);
 
+/*
+ * Batched in-place access.
+ *
+ * The *_get_frames() calls expose up to max_frames frames that are
+ * contiguous in memory, starting at the current queue position and never
+ * wrapping past the end of the queue, so a caller may need two calls to
+ * drain or fill the whole ring. The *_advance_frames() calls then consume or
+ * post any number of frames with a single counter update, barrier and
+ * notification check, instead of one per frame.
+ */
+
+/* directly peek at the next frames rx'ed, returns the number of frames */
+int tegra_ivc_read_get_frames(struct ivc *ivc, void **frames,
+		uint32_t max_frames)
+{
+	uint32_t count;
+	int result;
+
+	if (!frames || !max_frames)
+		return -EINVAL;
+
+	result = ivc_check_read(ivc);
+	if (result)
+		return result;
+
+	/* pick up everything the peer has posted so far */
+	ivc_invalidate_counter(ivc, ivc->rx_handle +
+			offsetof(struct ivc_channel_header, w_count));
+	if (ivc_channel_empty(ivc, ivc->rx_channel))
+		return -ENOMEM;
+
+	count = ivc_channel_avail_count(ivc, ivc->rx_channel);
+	count = min3(count, max_frames, ivc->nframes - ivc->r_pos);
+
+	/*
+	 * Order observation of w_pos potentially indicating new data before
+	 * data read.
+	 */
+	ivc_rmb();
+
+	ivc_invalidate_frame(ivc, ivc->rx_handle, ivc->r_pos, 0,
+			safe_mult_u32_u32__u64(ivc->frame_size, count));
+	*frames = ivc_frame_pointer(ivc, ivc->rx_channel, ivc->r_pos);
+
+	return (int)count;
+}
+EXPORT_SYMBOL(tegra_ivc_read_get_frames);
+
+/* release count rx'ed frames at once */
+int tegra_ivc_read_advance_frames(struct ivc *ivc, uint32_t count)
+{
+	int result = ivc_check_read(ivc);
+	if (result)
+		return result;
+
+	if (!count || count > ivc->nframes ||
+	    count > ivc_channel_avail_count(ivc, ivc->rx_channel))
+		return -EINVAL;
+
+	ivc_advance_rx_frames(ivc, count);
+	ivc_flush_counter(ivc, ivc->rx_handle +
+			offsetof(struct ivc_channel_header, r_count));
+
+	/*
+	 * Ensure our write to r_pos occurs before our read from w_pos.
+	 */
+	ivc_mb();
+
+	/*
+	 * Notify only upon transition from full to non-full, which is the case
+	 * if the queue was full before these count frames were released. The
+	 * available count can only asynchronously increase, so the worst
+	 * possible side-effect will be a spurious notification.
+	 */
+	ivc_invalidate_counter(ivc, ivc->rx_handle +
+		offsetof(struct ivc_channel_header, w_count));
+
+	if (ivc_channel_avail_count(ivc, ivc->rx_channel) >=
+			ivc->nframes - count)
+		ivc->notify(ivc);
+
+	return 0;
+}
+EXPORT_SYMBOL(tegra_ivc_read_advance_frames);
+
+/* directly poke at the next frames to be tx'ed, returns the number of frames */
+int tegra_ivc_write_get_frames(struct ivc *ivc, void **frames,
+		uint32_t max_frames)
+{
+	uint32_t used, count;
+	int result;
+
+	if (!frames || !max_frames)
+		return -EINVAL;
+
+	result = ivc_check_write(ivc);
+	if (result)
+		return result;
+
+	/* pick up everything the peer has consumed so far */
+	ivc_invalidate_counter(ivc, ivc->tx_handle +
+			offsetof(struct ivc_channel_header, r_count));
+	used = ivc_channel_avail_count(ivc, ivc->tx_channel);
+	if (used >= ivc->nframes)
+		return -ENOMEM;
+
+	count = min3(ivc->nframes - used, max_frames, ivc->nframes - ivc->w_pos);
+	*frames = ivc_frame_pointer(ivc, ivc->tx_channel, ivc->w_pos);
+
+	return (int)count;
+}
+EXPORT_SYMBOL(tegra_ivc_write_get_frames);
+
+/* post count tx frames at once */
+int tegra_ivc_write_advance_frames(struct ivc *ivc, uint32_t count)
+{
+	uint32_t used, first;
+	int result = ivc_check_write(ivc);
+	if (result)
+		return result;
+
+	used = ivc_channel_avail_count(ivc, ivc->tx_channel);
+	if (!count || used > ivc->nframes || count > ivc->nframes - used)
+		return -EINVAL;
+
+	/* the frames may wrap when posting what two get_frames() returned */
+	first = min(count, ivc->nframes - ivc->w_pos);
+	ivc_flush_frame(ivc, ivc->tx_handle, ivc->w_pos, 0,
+			safe_mult_u32_u32__u64(ivc->frame_size, first));
+	if (count > first)
+		ivc_flush_frame(ivc, ivc->tx_handle, 0, 0,
+				safe_mult_u32_u32__u64(ivc->frame_size,
+						       count - first));
+
+	/*
+	 * Order any possible stores to the frames before update of w_pos.
+	 */
+	ivc_wmb();
+
+	ivc_advance_tx_frames(ivc, count);
+	ivc_flush_counter(ivc, ivc->tx_handle +
+			offsetof(struct ivc_channel_header, w_count));
+
+	/*
+	 * Ensure our write to w_pos occurs before our read from r_pos.
+	 */
+	ivc_mb();
+
+	/*
+	 * Notify only upon transition from empty to non-empty, which is the
+	 * case if no more than these count frames are pending now. The
+	 * available count can only asynchronously decrease, so the worst
+	 * possible side-effect will be a spurious notification.
+	 */
+	ivc_invalidate_counter(ivc, ivc->tx_handle +
+		offsetof(struct ivc_channel_header, r_count));
+
+	if (ivc_channel_avail_count(ivc, ivc->tx_channel) <= count)
+		ivc->notify(ivc);
+
+	return 0;
+}
+EXPORT_SYMBOL(tegra_ivc_write_advance_frames);
+
 void tegra_ivc_channel_reset(struct ivc *ivc)
 {
 	ivc->tx_channel->state = ivc_state_sync;
@@ -130,11 +130,31 @@ static const struct attribute_group *scf_uncore_pmu_attr_grps[] = {
 	NULL,
 };
 
+/* NV_PMEVTYPER of a counter not programmed yet */
+#define EVTYPER_INVALID	0xFFFFFFFF
+
 struct uncore_unit {
 	u32 nv_group_id;
 	u32 nv_unit_id;
 	struct perf_event *events[UNIT_CTRS];
 	DECLARE_BITMAP(used_ctrs, UNIT_CTRS);
+
+	/*
+	 * Every register access is an MCE call, so the registers that are
+	 * only written by this driver are cached to skip redundant writes.
+	 */
+	u32 evtyper[UNIT_CTRS];
+	bool pmcr_known;
+	bool pmcr_enabled;
+
+	/*
+	 * A read transaction reads a whole event group. The counters in use
+	 * are read once at its first read, and every event of the group is
+	 * then updated from that snapshot.
+	 */
+	unsigned int txn_flags;
+	bool snapshot_valid;
+	u32 snapshot[UNIT_CTRS];
 };
 
 struct uncore_pmu {
@@ -205,6 +225,36 @@ static void mce_perfmon_write(struct uncore_unit* unit, uint8_t reg,
 			reg, counter, &value);
 }
 
+static void scf_uncore_set_pmcr(struct uncore_unit *uncore_unit, bool enable)
+{
+	union dmce_perfmon_pmcr_t pmcr = {0};
+
+	if (uncore_unit->pmcr_known && uncore_unit->pmcr_enabled == enable)
+		return;
+
+	pmcr.bits.e = enable;
+	mce_perfmon_write(uncore_unit, NV_PMCR, 0, pmcr.flat);
+	uncore_unit->pmcr_known = true;
+	uncore_unit->pmcr_enabled = enable;
+}
+
+static u32 scf_uncore_read_counter(struct uncore_unit *uncore_unit, u32 idx)
+{
+	u32 i;
+
+	if (!(uncore_unit->txn_flags & PERF_PMU_TXN_READ))
+		return mce_perfmon_read(uncore_unit, NV_PMEVCNTR, idx);
+
+	if (!uncore_unit->snapshot_valid) {
+		for_each_set_bit(i, uncore_unit->used_ctrs, UNIT_CTRS)
+			uncore_unit->snapshot[i] =
+				mce_perfmon_read(uncore_unit, NV_PMEVCNTR, i);
+		uncore_unit->snapshot_valid = true;
+	}
+
+	return uncore_unit->snapshot[idx];
+}
+
 /*
  * Enable the SCF counters.
  */
@@ -215,15 +265,12 @@ static void scf_uncore_pmu_enable(struct pmu *pmu)
 	struct uncore_pmu *uncore_pmu = to_uncore_pmu(pmu);
 	struct uncore_unit *uncore_unit = &uncore_pmu->scf;
 
-	union dmce_perfmon_pmcr_t pmcr = {0};
-
 	enabled = bitmap_weight(uncore_unit->used_ctrs, UNIT_CTRS);
 
 	if (!enabled)
 		return;
 
-	pmcr.bits.e = 1;
-	mce_perfmon_write(uncore_unit, NV_PMCR, 0, pmcr.flat);
+	scf_uncore_set_pmcr(uncore_unit, true);
 }
 
 /*
@@ -234,15 +281,60 @@ static void scf_uncore_pmu_disable(struct pmu *pmu)
 	struct uncore_pmu *uncore_pmu = to_uncore_pmu(pmu);
 	struct uncore_unit *uncore_unit = &uncore_pmu->scf;
 
-	union dmce_perfmon_pmcr_t pmcr = {0};
-
 	int enabled = bitmap_weight(uncore_unit->used_ctrs, UNIT_CTRS);
 
 	if (!enabled)
 		return;
 
-	pmcr.bits.e = 0;
-	mce_perfmon_write(uncore_unit, NV_PMCR, 0, pmcr.flat);
+	scf_uncore_set_pmcr(uncore_unit, false);
+}
+
+/*
+ * Transactions: an ADD transaction schedules a whole event group with
+ * the counters disabled once, a READ transaction reads it from a single
+ * snapshot of the counters.
+ */
+static void scf_uncore_start_txn(struct pmu *pmu, unsigned int txn_flags)
+{
+	struct uncore_unit *uncore_unit = &to_uncore_pmu(pmu)->scf;
+
+	WARN_ON_ONCE(uncore_unit->txn_flags);
+
+	uncore_unit->txn_flags = txn_flags;
+	uncore_unit->snapshot_valid = false;
+
+	if (txn_flags & ~PERF_PMU_TXN_ADD)
+		return;
+
+	perf_pmu_disable(pmu);
+}
+
+static int scf_uncore_commit_txn(struct pmu *pmu)
+{
+	struct uncore_unit *uncore_unit = &to_uncore_pmu(pmu)->scf;
+	unsigned int txn_flags = uncore_unit->txn_flags;
+
+	uncore_unit->txn_flags = 0;
+
+	if (txn_flags & ~PERF_PMU_TXN_ADD)
+		return 0;
+
+	/* add() already failed if the group did not fit the counters */
+	perf_pmu_enable(pmu);
+	return 0;
+}
+
+static void scf_uncore_cancel_txn(struct pmu *pmu)
+{
+	struct uncore_unit *uncore_unit = &to_uncore_pmu(pmu)->scf;
+	unsigned int txn_flags = uncore_unit->txn_flags;
+
+	uncore_unit->txn_flags = 0;
+
+	if (txn_flags & ~PERF_PMU_TXN_ADD)
+		return;
+
+	perf_pmu_enable(pmu);
 }
 
 /*
@@ -289,9 +381,12 @@ static void scf_uncore_event_start(struct perf_event *event, int flags) {
 
 	scf_uncore_event_set_period(uncore_unit, event);
 
-	/* Program unit's event register */
+	/* Program unit's event register, unless it still counts this event */
 	event_id = CONFIG_EVENT(event->attr.config);
-	mce_perfmon_write(uncore_unit, NV_PMEVTYPER, idx, event_id);
+	if (uncore_unit->evtyper[idx] != event_id) {
+		mce_perfmon_write(uncore_unit, NV_PMEVTYPER, idx, event_id);
+		uncore_unit->evtyper[idx] = event_id;
+	}
 
 	/* Enable interrupt and start counter */
 	mce_perfmon_write(uncore_unit, NV_PMINTENSET, 0, BIT(idx));
@@ -309,7 +404,7 @@ static void scf_uncore_event_update(
 
 	do {
 		prev = local64_read(&hwc->prev_count);
-		now = mce_perfmon_read(uncore_unit, NV_PMEVCNTR, idx);
+		now = scf_uncore_read_counter(uncore_unit, idx);
 	} while (local64_cmpxchg(&hwc->prev_count, prev, now) != prev);
 
 	if (prev > now)
@@ -381,9 +476,9 @@ static int scf_uncore_event_add(struct perf_event *event, int flags)
 	}
 
 	idx = find_first_zero_bit(uncore_unit->used_ctrs, UNIT_CTRS);
-	/* All counters are in use */
+	/* All counters are in use, perf core multiplexes the events */
 	if (idx == UNIT_CTRS)
-		return -EOPNOTSUPP;
+		return -EAGAIN;
 
 	set_bit(idx, uncore_unit->used_ctrs);
 	uncore_unit->events[idx] = event;
@@ -484,6 +579,35 @@ static irqreturn_t scf_handle_irq(int irq_num, void *data)
 	return IRQ_HANDLED;
 }
 
+/*
+ * A group can only be scheduled at once if its events of this PMU fit in
+ * the counters of the unit. Software events can be grouped with them,
+ * events of other PMUs can't.
+ */
+static bool scf_uncore_validate_group(struct perf_event *event)
+{
+	struct perf_event *leader = event->group_leader;
+	struct perf_event *sibling;
+	int counters = 1;
+
+	if (leader == event)
+		return true;
+
+	if (leader->pmu == event->pmu)
+		counters++;
+	else if (!is_software_event(leader))
+		return false;
+
+	for_each_sibling_event(sibling, leader) {
+		if (sibling->pmu == event->pmu)
+			counters++;
+		else if (!is_software_event(sibling))
+			return false;
+	}
+
+	return counters <= UNIT_CTRS;
+}
+
 /*
  * event_init: Verify this PMU can handle the desired event
  */
@@ -541,6 +665,11 @@ static int scf_uncore_event_init(struct perf_event *event)
 			break;
 	}
 
+	if (!scf_uncore_validate_group(event)) {
+		dev_dbg(&pdev->dev, "Can't schedule event group\n");
+		return -EINVAL;
+	}
+
 	/* Event is valid, hw not allocated yet */
 	hwc->idx = -1;
 	hwc->config_base = event->attr.config;
@@ -553,6 +682,7 @@ static int scf_pmu_device_probe(struct platform_device *pdev)
 	struct uncore_pmu *uncore_pmu;
 	int err;
 	int irq;
+	int i;
 
 	uncore_pmu = devm_kzalloc(&pdev->dev, sizeof(*uncore_pmu), GFP_KERNEL);
 	if(!uncore_pmu)
@@ -560,6 +690,8 @@ static int scf_pmu_device_probe(struct platform_device *pdev)
 
 	uncore_pmu->scf.nv_group_id = PMSELR_GROUP_SCF;
 	uncore_pmu->scf.nv_unit_id = PMSELR_UNIT_SCF_SCF;
+	for (i = 0; i < UNIT_CTRS; i++)
+		uncore_pmu->scf.evtyper[i] = EVTYPER_INVALID;
 
 	platform_set_drvdata(pdev, uncore_pmu);
 	uncore_pmu->pmu = (struct pmu) {
@@ -573,6 +705,9 @@ static int scf_pmu_device_probe(struct platform_device *pdev)
 		.start			= scf_uncore_event_start,
 		.stop			= scf_uncore_event_stop,
 		.read			= scf_uncore_event_read,
+		.start_txn		= scf_uncore_start_txn,
+		.commit_txn		= scf_uncore_commit_txn,
+		.cancel_txn		= scf_uncore_cancel_txn,
 		.attr_groups	= scf_uncore_pmu_attr_grps,
 		.type			= PERF_TYPE_HARDWARE,
 	};
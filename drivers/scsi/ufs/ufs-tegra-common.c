@@ -17,6 +17,10 @@
 #include <linux/gpio/consumer.h>
 #include <linux/gpio.h>
 #include <linux/jiffies.h>
+#include <linux/bitfield.h>
+#include <linux/log2.h>
+#include <linux/iopoll.h>
+#include <linux/seq_file.h>
 
 #include <linux/of.h>
 #include <linux/of_device.h>
@@ -32,6 +36,7 @@
 #include <ufs/ufshcd.h>
 #include <ufs/unipro.h>
 #include <ufs/ufshci.h>
+#include <drivers-private/scsi/ufs/ufshcd-priv.h>
 #else
 #include <drivers-private/scsi/ufs/ufshcd-pltfrm.h>
 #include <drivers-private/scsi/ufs/ufshcd.h>
@@ -45,6 +50,27 @@
 static void ufs_tegra_mphy_startup_sequence(struct ufs_tegra_host *ufs_tegra);
 
 #ifdef CONFIG_DEBUG_FS
+static int ufs_tegra_gear_stats_show(struct seq_file *s, void *data)
+{
+	struct ufs_tegra_host *ufs_tegra = s->private;
+	struct ufs_tegra_gear_stats *stats = &ufs_tegra->gear_stats;
+	struct ufs_pa_layer_attr *cur = &ufs_tegra->hba->pwr_info;
+	u64 count = stats->up + stats->down;
+
+	seq_printf(s, "gear: rx %u tx %u\n", cur->gear_rx, cur->gear_tx);
+	seq_printf(s, "lanes: rx %u tx %u\n", cur->lane_rx, cur->lane_tx);
+	seq_printf(s, "up: %llu\n", stats->up);
+	seq_printf(s, "down: %llu\n", stats->down);
+	seq_printf(s, "failed: %llu\n", stats->failed);
+	seq_printf(s, "last_us: %llu\n", div_u64(stats->last_ns, NSEC_PER_USEC));
+	seq_printf(s, "max_us: %llu\n", div_u64(stats->max_ns, NSEC_PER_USEC));
+	seq_printf(s, "avg_us: %llu\n", count ?
+		   div64_u64(stats->total_ns, count * NSEC_PER_USEC) : 0);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(ufs_tegra_gear_stats);
+
 static void ufs_tegra_init_debugfs(struct ufs_hba *hba)
 {
 	struct dentry *device_root;
@@ -54,6 +80,43 @@ static void ufs_tegra_init_debugfs(struct ufs_hba *hba)
 
 	if (ufs_tegra->enable_ufs_provisioning)
 		debugfs_provision_init(hba, device_root);
+
+	if (ufs_tegra->adaptive_intr_aggr) {
+		debugfs_create_u32("intr_aggr_max_cnt", 0644, device_root,
+				   &ufs_tegra->intr_aggr_max_cnt);
+		debugfs_create_u32("intr_aggr_timeout", 0644, device_root,
+				   &ufs_tegra->intr_aggr_timeout);
+	}
+
+	if (ufs_tegra->adaptive_ahit) {
+		debugfs_create_u32("load_period_ms", 0644, device_root,
+				   &ufs_tegra->load_period_ms);
+		debugfs_create_u32("load_busy_reqs", 0644, device_root,
+				   &ufs_tegra->load_busy_reqs);
+		debugfs_create_u32("load_busy_depth", 0644, device_root,
+				   &ufs_tegra->load_busy_depth);
+		debugfs_create_u32("load_idle_after", 0644, device_root,
+				   &ufs_tegra->load_idle_after);
+		debugfs_create_u32("idle_ahit_us", 0644, device_root,
+				   &ufs_tegra->idle_ahit_us);
+	}
+
+	if (ufs_tegra->gear_scaling) {
+		if (!ufs_tegra->adaptive_ahit) {
+			debugfs_create_u32("load_period_ms", 0644, device_root,
+					   &ufs_tegra->load_period_ms);
+			debugfs_create_u32("load_busy_depth", 0644, device_root,
+					   &ufs_tegra->load_busy_depth);
+		}
+		debugfs_create_u32("gear_up_kbps", 0644, device_root,
+				   &ufs_tegra->gear_up_kbps);
+		debugfs_create_u32("gear_down_kbps", 0644, device_root,
+				   &ufs_tegra->gear_down_kbps);
+		debugfs_create_u32("gear_down_windows", 0644, device_root,
+				   &ufs_tegra->gear_down_windows);
+		debugfs_create_file("gear_scaling_stats", 0444, device_root,
+				    ufs_tegra, &ufs_tegra_gear_stats_fops);
+	}
 }
 #endif
 
@@ -971,6 +1034,291 @@ static void ufs_tegra_context_restore(struct ufs_tegra_host *ufs_tegra)
 	}
 }
 
+/*
+ * Interrupt aggregation follows the queue depth: with few requests in
+ * flight the completion interrupt fires on the first completion instead of
+ * waiting for the aggregation timeout, and with a deep queue about half of
+ * the outstanding requests are reaped per interrupt. Called from the core
+ * with the outstanding request lock held, before the tag is marked busy.
+ */
+static void ufs_tegra_update_intr_aggr(struct ufs_hba *hba, u32 depth)
+{
+	struct ufs_tegra_host *ufs_tegra = hba->priv;
+	u32 max_cnt, tmout, thld;
+
+	max_cnt = clamp_t(u32, ufs_tegra->intr_aggr_max_cnt, 1,
+			  min(hba->nutrs - 1, 0x1F));
+	thld = clamp_t(u32, rounddown_pow_of_two(depth) / 2, 1, max_cnt);
+	if (thld == ufs_tegra->intr_aggr_thld)
+		return;
+
+	/* A zero timeout would leave a partial batch without an interrupt */
+	tmout = clamp_t(u32, ufs_tegra->intr_aggr_timeout, 1, 0xFF);
+
+	ufshcd_writel(hba, INT_AGGR_ENABLE | INT_AGGR_PARAM_WRITE |
+		      INT_AGGR_COUNTER_THLD_VAL(thld) |
+		      INT_AGGR_TIMEOUT_VAL(tmout),
+		      REG_UTP_TRANSFER_REQ_INT_AGG_CONTROL);
+	ufs_tegra->intr_aggr_thld = thld;
+}
+
+static void ufs_tegra_load_queue(struct ufs_tegra_host *ufs_tegra)
+{
+	queue_delayed_work(system_power_efficient_wq, &ufs_tegra->load_work,
+			   msecs_to_jiffies(max(ufs_tegra->load_period_ms, 10U)));
+}
+
+static void ufs_tegra_setup_xfer_req(struct ufs_hba *hba, int tag,
+				     bool is_scsi_cmd)
+{
+	struct ufs_tegra_host *ufs_tegra = hba->priv;
+	u32 depth = hweight_long(hba->outstanding_reqs) + 1;
+
+	if (ufs_tegra->adaptive_intr_aggr && ufshcd_is_intr_aggr_allowed(hba))
+		ufs_tegra_update_intr_aggr(hba, depth);
+
+	if (!ufs_tegra->adaptive_ahit && !ufs_tegra->gear_scaling)
+		return;
+
+	atomic_inc(&ufs_tegra->load_reqs);
+	if (depth > atomic_read(&ufs_tegra->load_peak_depth))
+		atomic_set(&ufs_tegra->load_peak_depth, depth);
+	if (is_scsi_cmd && hba->lrb[tag].cmd)
+		atomic_long_add(scsi_bufflen(hba->lrb[tag].cmd),
+				&ufs_tegra->load_bytes);
+
+	/* The load work stops itself on an idle link, restart it */
+	if (!READ_ONCE(ufs_tegra->load_seen)) {
+		WRITE_ONCE(ufs_tegra->load_seen, true);
+		ufs_tegra_load_queue(ufs_tegra);
+	}
+}
+
+static u32 ufs_tegra_ahit_encode(u32 us)
+{
+	u32 scale = 0;
+
+	/* Scale values above 5 (100 ms units) are reserved */
+	while (us > UFSHCI_AHIBERN8_TIMER_MASK && scale < 5) {
+		us /= UFSHCI_AHIBERN8_SCALE_FACTOR;
+		scale++;
+	}
+
+	return FIELD_PREP(UFSHCI_AHIBERN8_TIMER_MASK,
+			  min_t(u32, us, UFSHCI_AHIBERN8_TIMER_MASK)) |
+	       FIELD_PREP(UFSHCI_AHIBERN8_SCALE_MASK, scale);
+}
+
+/*
+ * Under sustained load the auto-hibern8 timer configured through the core
+ * (sysfs auto_hibern8) is kept, so the link does not bounce in and out of
+ * hibern8 between bursts. After load_idle_after light windows the short
+ * idle timer is used, so a mostly idle link enters hibern8 right after the
+ * last request. Returns true once the idle timer is in place.
+ */
+static bool ufs_tegra_ahit_policy(struct ufs_tegra_host *ufs_tegra,
+				  u32 reqs, u32 depth)
+{
+	struct ufs_hba *hba = ufs_tegra->hba;
+	u32 ahit = 0;
+
+	/* A timer set by someone else becomes the new busy timer */
+	if (hba->ahit != ufs_tegra->applied_ahit)
+		ufs_tegra->busy_ahit = hba->ahit;
+
+	if (reqs >= ufs_tegra->load_busy_reqs ||
+	    depth >= ufs_tegra->load_busy_depth) {
+		ufs_tegra->load_idle_windows = 0;
+		ahit = ufs_tegra->busy_ahit;
+	} else {
+		if (ufs_tegra->load_idle_windows < ufs_tegra->load_idle_after)
+			ufs_tegra->load_idle_windows++;
+		if (ufs_tegra->load_idle_windows >= ufs_tegra->load_idle_after)
+			ahit = ufs_tegra_ahit_encode(ufs_tegra->idle_ahit_us);
+	}
+
+	/* Auto-hibern8 disabled by the user or not supported, leave it be */
+	if (ahit && ufs_tegra->busy_ahit && ahit != hba->ahit)
+		ufshcd_auto_hibern8_update(hba, ahit);
+	ufs_tegra->applied_ahit = hba->ahit;
+
+	return ufs_tegra->load_idle_windows >= ufs_tegra->load_idle_after;
+}
+
+static int ufs_tegra_wait_doorbell_clr(struct ufs_hba *hba)
+{
+	u32 val;
+	int ret;
+
+	ret = read_poll_timeout(ufshcd_readl, val, !val, 100,
+				UFS_TEGRA_GEAR_DB_CLR_TIMEOUT_US, false,
+				hba, REG_UTP_TRANSFER_REQ_DOOR_BELL);
+	if (ret)
+		return ret;
+
+	return read_poll_timeout(ufshcd_readl, val, !val, 100,
+				 UFS_TEGRA_GEAR_DB_CLR_TIMEOUT_US, false,
+				 hba, REG_UTP_TASK_REQ_DOOR_BELL);
+}
+
+/*
+ * Switch between the negotiated power mode and the low gear/lane setup.
+ * Like the core clock scaling, new requests are held back and the queues
+ * are drained before the PA layer is reconfigured.
+ */
+static int ufs_tegra_scale_gear(struct ufs_tegra_host *ufs_tegra, bool up)
+{
+	struct ufs_hba *hba = ufs_tegra->hba;
+	struct ufs_tegra_gear_stats *stats = &ufs_tegra->gear_stats;
+	struct ufs_pa_layer_attr pwr = hba->max_pwr_info.info;
+	ktime_t start;
+	u64 delta;
+	int ret;
+
+	if (!up) {
+		pwr.gear_rx = min(pwr.gear_rx, ufs_tegra->gear_low);
+		pwr.gear_tx = min(pwr.gear_tx, ufs_tegra->gear_low);
+		pwr.lane_rx = min(pwr.lane_rx, ufs_tegra->gear_low_lanes);
+		pwr.lane_tx = min(pwr.lane_tx, ufs_tegra->gear_low_lanes);
+	}
+
+	/* A suspended link keeps its power mode, nothing to gain */
+	if (pm_runtime_get_if_in_use(hba->dev) <= 0)
+		return 0;
+
+	start = ktime_get();
+
+	if (atomic_inc_return(&hba->scsi_block_reqs_cnt) == 1)
+		scsi_block_requests(hba->host);
+	down_write(&hba->clk_scaling_lock);
+
+	ret = ufs_tegra_wait_doorbell_clr(hba);
+	if (!ret) {
+		ufs_tegra->gear_scaling_active = true;
+		ret = ufshcd_config_pwr_mode(hba, &pwr);
+		ufs_tegra->gear_scaling_active = false;
+	}
+
+	up_write(&hba->clk_scaling_lock);
+	if (atomic_dec_and_test(&hba->scsi_block_reqs_cnt))
+		scsi_unblock_requests(hba->host);
+
+	pm_runtime_put(hba->dev);
+
+	if (ret) {
+		stats->failed++;
+		dev_err(hba->dev, "gear scaling %s failed %d\n",
+			up ? "up" : "down", ret);
+		return ret;
+	}
+
+	delta = ktime_to_ns(ktime_sub(ktime_get(), start));
+	if (up)
+		stats->up++;
+	else
+		stats->down++;
+	stats->last_ns = delta;
+	stats->max_ns = max(stats->max_ns, delta);
+	stats->total_ns += delta;
+
+	return 0;
+}
+
+/*
+ * Run the negotiated gear and lanes while the throughput or the queue
+ * depth asks for it, and drop to the low gear/lane setup after
+ * gear_down_windows light windows. Returns true once the link runs at the
+ * low setup.
+ */
+static bool ufs_tegra_gear_policy(struct ufs_tegra_host *ufs_tegra,
+				  u64 bytes, u32 depth)
+{
+	struct ufs_hba *hba = ufs_tegra->hba;
+	struct ufs_pa_layer_attr *max = &hba->max_pwr_info.info;
+	struct ufs_pa_layer_attr *cur = &hba->pwr_info;
+	u32 period = max(ufs_tegra->load_period_ms, 10U);
+	u64 kbps = div_u64(bytes * MSEC_PER_SEC, period * 1024);
+	bool at_max, at_low;
+
+	if (!ufshcd_is_hs_mode(max) || !ufshcd_is_hs_mode(cur))
+		return true;
+
+	at_max = cur->gear_rx == max->gear_rx &&
+		 cur->gear_tx == max->gear_tx &&
+		 cur->lane_rx == max->lane_rx &&
+		 cur->lane_tx == max->lane_tx;
+	at_low = cur->gear_rx <= ufs_tegra->gear_low &&
+		 cur->gear_tx <= ufs_tegra->gear_low &&
+		 cur->lane_rx <= ufs_tegra->gear_low_lanes &&
+		 cur->lane_tx <= ufs_tegra->gear_low_lanes;
+
+	if (kbps >= ufs_tegra->gear_up_kbps ||
+	    depth >= ufs_tegra->load_busy_depth) {
+		ufs_tegra->gear_idle_windows = 0;
+		if (!at_max)
+			ufs_tegra_scale_gear(ufs_tegra, true);
+		return false;
+	}
+
+	if (kbps >= ufs_tegra->gear_down_kbps) {
+		ufs_tegra->gear_idle_windows = 0;
+		return at_low;
+	}
+
+	if (ufs_tegra->gear_idle_windows < ufs_tegra->gear_down_windows)
+		ufs_tegra->gear_idle_windows++;
+	if (ufs_tegra->gear_idle_windows < ufs_tegra->gear_down_windows ||
+	    at_low)
+		return at_low;
+
+	/* Back off for another set of windows before retrying */
+	if (ufs_tegra_scale_gear(ufs_tegra, false)) {
+		ufs_tegra->gear_idle_windows = 0;
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Sample the request load once per period and feed it to the enabled
+ * policies. The work stops re-arming once nothing was queued during a
+ * window and every policy has settled in its idle state.
+ */
+static void ufs_tegra_load_work(struct work_struct *work)
+{
+	struct ufs_tegra_host *ufs_tegra = container_of(to_delayed_work(work),
+					struct ufs_tegra_host, load_work);
+	u32 reqs = atomic_xchg(&ufs_tegra->load_reqs, 0);
+	u32 depth = atomic_xchg(&ufs_tegra->load_peak_depth, 0);
+	u64 bytes = atomic_long_xchg(&ufs_tegra->load_bytes, 0);
+	bool settled = true;
+
+	if (ufs_tegra->adaptive_ahit)
+		settled &= ufs_tegra_ahit_policy(ufs_tegra, reqs, depth);
+	if (ufs_tegra->gear_scaling)
+		settled &= ufs_tegra_gear_policy(ufs_tegra, bytes, depth);
+
+	if (!reqs && settled) {
+		WRITE_ONCE(ufs_tegra->load_seen, false);
+		return;
+	}
+
+	ufs_tegra_load_queue(ufs_tegra);
+}
+
+static void ufs_tegra_load_stop(struct ufs_tegra_host *ufs_tegra)
+{
+	if (!ufs_tegra->adaptive_ahit && !ufs_tegra->gear_scaling)
+		return;
+
+	cancel_delayed_work_sync(&ufs_tegra->load_work);
+	atomic_set(&ufs_tegra->load_reqs, 0);
+	atomic_set(&ufs_tegra->load_peak_depth, 0);
+	atomic_long_set(&ufs_tegra->load_bytes, 0);
+	WRITE_ONCE(ufs_tegra->load_seen, false);
+}
+
 #if defined(NV_UFS_HBA_VARIANT_OPS_SUSPEND_HAS_STATUS_ARG)
 static int ufs_tegra_suspend(struct ufs_hba *hba, enum ufs_pm_op pm_op,
 		enum ufs_notify_change_status status)
@@ -988,6 +1336,9 @@ static int ufs_tegra_suspend(struct ufs_hba *hba, enum ufs_pm_op pm_op)
 	if (pm_op != UFS_SYSTEM_PM)
 		return 0;
 
+	/* The first request after resume restarts the load sampling */
+	ufs_tegra_load_stop(ufs_tegra);
+
 	ufs_tegra->ufshc_state = UFSHC_SUSPEND;
 
 	if (ufs_tegra->soc->chip_id < TEGRA234) {
@@ -1257,10 +1608,14 @@ static int ufs_tegra_pwr_change_notify(struct ufs_hba *hba,
 			dev_req_params->pwr_tx = SLOWAUTO_MODE;
 			dev_req_params->hs_rate = 0;
 		}
-		memcpy(&hba->max_pwr_info.info, dev_req_params,
-			sizeof(struct ufs_pa_layer_attr));
+		/* Gear scaling must not lower the negotiated maximum */
+		if (!ufs_tegra->gear_scaling_active)
+			memcpy(&hba->max_pwr_info.info, dev_req_params,
+				sizeof(struct ufs_pa_layer_attr));
 		break;
 	case POST_CHANGE:
+		if (ufs_tegra->gear_scaling_active)
+			break;
 		ufs_tegra_print_power_mode_config(hba, dev_req_params);
 		ufshcd_dme_get(hba, UIC_ARG_MIB(PA_SCRAMBLING), &pa_reg_check);
 		if (pa_reg_check & SCREN)
@@ -1304,6 +1659,8 @@ static int ufs_tegra_hce_enable_notify(struct ufs_hba *hba,
 			clk_disable_unprepare(ufs_tegra->mphy_force_ls_mode);
 		if (ufs_tegra->soc->chip_id >= TEGRA234)
 			ufs_tegra_ufs_mmio_axi(hba);
+		/* The core programs its default aggregation setup next */
+		ufs_tegra->intr_aggr_thld = 0;
 		break;
 	default:
 		break;
@@ -1430,6 +1787,31 @@ static int ufs_tegra_config_soc_data(struct ufs_tegra_host *ufs_tegra)
 	ufs_tegra->enable_scramble =
 		of_property_read_bool(np, "nvidia,enable-scramble");
 
+	ufs_tegra->adaptive_intr_aggr =
+		of_property_read_bool(np, "nvidia,enable-adaptive-intr-aggr");
+	ufs_tegra->intr_aggr_max_cnt = UFS_TEGRA_INTR_AGGR_MAX_CNT;
+	ufs_tegra->intr_aggr_timeout = UFS_TEGRA_INTR_AGGR_TIMEOUT;
+
+	ufs_tegra->adaptive_ahit =
+		of_property_read_bool(np, "nvidia,enable-adaptive-auto-hibern8");
+	ufs_tegra->load_period_ms = UFS_TEGRA_LOAD_PERIOD_MS;
+	ufs_tegra->load_busy_reqs = UFS_TEGRA_LOAD_BUSY_REQS;
+	ufs_tegra->load_busy_depth = UFS_TEGRA_LOAD_BUSY_DEPTH;
+	ufs_tegra->load_idle_after = UFS_TEGRA_LOAD_IDLE_AFTER;
+	ufs_tegra->idle_ahit_us = UFS_TEGRA_IDLE_AHIT_US;
+
+	ufs_tegra->gear_scaling =
+		of_property_read_bool(np, "nvidia,enable-gear-scaling");
+	ufs_tegra->gear_low = UFS_HS_G1;
+	of_property_read_u32(np, "nvidia,gear-scaling-low-gear",
+			     &ufs_tegra->gear_low);
+	ufs_tegra->gear_low_lanes = 1;
+	of_property_read_u32(np, "nvidia,gear-scaling-low-lanes",
+			     &ufs_tegra->gear_low_lanes);
+	ufs_tegra->gear_up_kbps = UFS_TEGRA_GEAR_UP_KBPS;
+	ufs_tegra->gear_down_kbps = UFS_TEGRA_GEAR_DOWN_KBPS;
+	ufs_tegra->gear_down_windows = UFS_TEGRA_GEAR_DOWN_WINDOWS;
+
 	if (ufs_tegra->soc->chip_id >= TEGRA234) {
 #if defined(NV_UFSHCD_QUIRKS_ENUM_HAS_UFSHCD_QUIRK_BROKEN_64BIT_ADDRESS) /* Linux 6.0 */
 		ufs_tegra->hba->quirks |= UFSHCD_QUIRK_BROKEN_64BIT_ADDRESS;
@@ -1690,6 +2072,7 @@ static int ufs_tegra_init(struct ufs_hba *hba)
 	ufs_tegra->ufshc_state = UFSHC_INIT;
 	ufs_tegra->hba = hba;
 	hba->priv = (void *)ufs_tegra;
+	INIT_DELAYED_WORK(&ufs_tegra->load_work, ufs_tegra_load_work);
 
 	err = ufs_tegra_config_soc_data(ufs_tegra);
 	if (err)
@@ -1866,6 +2249,7 @@ static void ufs_tegra_exit(struct ufs_hba *hba)
 {
 	struct ufs_tegra_host *ufs_tegra = hba->priv;
 
+	ufs_tegra_load_stop(ufs_tegra);
 	ufs_tegra_disable_mphylane_clks(ufs_tegra);
 
 #ifdef CONFIG_DEBUG_FS
@@ -1887,6 +2271,7 @@ struct ufs_hba_variant_ops ufs_hba_tegra_vops = {
 	.suspend		= ufs_tegra_suspend,
 	.resume			= ufs_tegra_resume,
 	.hce_enable_notify      = ufs_tegra_hce_enable_notify,
+	.setup_xfer_req		= ufs_tegra_setup_xfer_req,
 	.link_startup_notify	= ufs_tegra_link_startup_notify,
 	.pwr_change_notify      = ufs_tegra_pwr_change_notify,
 };
@@ -6,6 +6,7 @@
 #define _UFS_TEGRA_H
 
 #include <linux/io.h>
+#include <linux/workqueue.h>
 
 #define NV_ADDRESS_MAP_MPHY_L0_BASE		0x02470000
 #define NV_ADDRESS_MAP_MPHY_L1_BASE		0x02480000
@@ -143,6 +144,23 @@
 #define VS_BURSTMBLREGISTER		0xc0
 #define VS_TXBURSTCLOSUREDELAY		0xD084
 
+/* Adaptive interrupt aggregation defaults, timeout in 40us units */
+#define UFS_TEGRA_INTR_AGGR_MAX_CNT		16
+#define UFS_TEGRA_INTR_AGGR_TIMEOUT		2
+
+/* Load sampling defaults for the auto-hibern8 policy */
+#define UFS_TEGRA_LOAD_PERIOD_MS		100
+#define UFS_TEGRA_LOAD_BUSY_REQS		64
+#define UFS_TEGRA_LOAD_BUSY_DEPTH		4
+#define UFS_TEGRA_LOAD_IDLE_AFTER		10
+#define UFS_TEGRA_IDLE_AHIT_US			1000
+
+/* Gear scaling defaults, throughput in KiB/s per sampling period */
+#define UFS_TEGRA_GEAR_UP_KBPS			40000
+#define UFS_TEGRA_GEAR_DOWN_KBPS		5000
+#define UFS_TEGRA_GEAR_DOWN_WINDOWS		10
+#define UFS_TEGRA_GEAR_DB_CLR_TIMEOUT_US	1000000
+
 /*UFS Clock Defines*/
 #define UFSHC_CLK_FREQ		204000000
 #define UFSDEV_CLK_FREQ		19200000
@@ -325,6 +343,15 @@ struct ufs_tegra_soc_data {
 	u8 chip_id;
 };
 
+struct ufs_tegra_gear_stats {
+	u64 up;
+	u64 down;
+	u64 failed;
+	u64 last_ns;
+	u64 max_ns;
+	u64 total_ns;
+};
+
 struct ufs_tegra_host {
 	struct ufs_hba *hba;
 	bool is_lane_clks_enabled;
@@ -391,6 +418,36 @@ struct ufs_tegra_host {
 	u32 ref_clk_freq;
 	struct ufs_tegra_soc_data *soc;
 	u32 streamid;
+	/* interrupt aggregation threshold following the queue depth */
+	bool adaptive_intr_aggr;
+	u32 intr_aggr_max_cnt;
+	u32 intr_aggr_timeout;
+	u32 intr_aggr_thld;
+	/* auto-hibern8 idle timer following the request load */
+	bool adaptive_ahit;
+	struct delayed_work load_work;
+	atomic_t load_reqs;
+	atomic_t load_peak_depth;
+	u32 load_idle_windows;
+	bool load_seen;
+	u32 load_period_ms;
+	u32 load_busy_reqs;
+	u32 load_busy_depth;
+	u32 load_idle_after;
+	u32 busy_ahit;
+	u32 applied_ahit;
+	u32 idle_ahit_us;
+	/* HS gear and lane count following the throughput */
+	bool gear_scaling;
+	bool gear_scaling_active;
+	atomic_long_t load_bytes;
+	u32 gear_low;
+	u32 gear_low_lanes;
+	u32 gear_up_kbps;
+	u32 gear_down_kbps;
+	u32 gear_down_windows;
+	u32 gear_idle_windows;
+	struct ufs_tegra_gear_stats gear_stats;
 #ifdef CONFIG_DEBUG_FS
 	u32 refclk_value;
 	long program_refclk;
@@ -3,13 +3,19 @@
 
 #include <nvidia/conftest.h>
 
+#include <linux/delay.h>
 #include <linux/kthread.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/of.h>
+#include <linux/poll.h>
 #include <linux/spi/spi.h>
+#include <linux/vmalloc.h>
 //#include <soc/tegra/virt/tegra_hv_pm_ctl.h>
 #include <linux/version.h>
 #include <linux/sched/signal.h>
+#include <uapi/linux/aurix-tegra-spi.h>
 
 #define AURIX			0x3
 #define TEGRA			0x2
@@ -24,6 +30,9 @@
 #define TEGRA_AURIX		0x1
 #define REQ_TYPE(x)		((x) << 7)
 #define SPI_DEBUG		1
+#define MAX_FRAME_PACKETS	64
+#define DEF_RING_FRAMES		32
+#define MAX_RING_FRAMES		1024
 
 /*
  * Command-Response packet shall follow the structure shown below.
@@ -43,15 +52,39 @@ struct packet {
 	u8 msg_spec_payload[12];
 } __attribute__((__packed__));
 
+/* mmap-ed message link, see uapi/linux/aurix-tegra-spi.h */
+struct aurix_tegra_link {
+	struct miscdevice misc;
+	bool registered;
+	struct mutex lock;	/* protects users */
+	int users;
+	wait_queue_head_t wq;
+	struct aurix_tegra_spi_hdr *hdr;
+	struct packet *tx_ring;
+	u8 *rx_ring;
+	size_t size;
+	u32 tx_mask;
+	u32 rx_mask;
+	/* owned by the kthread */
+	u32 tx_tail;
+	u32 rx_head;
+};
+
 struct aurix_tegra_spi_data {
 	struct spi_device *spi;
 	struct task_struct *thread;
+	struct completion thread_done;
+	/* idle packets sent after the queued ones */
 	struct packet *transmit;
+	/* frame received with no room in the link */
 	struct packet *receive;
 	spinlock_t lock;
 	bool exited;
-	u8 buf_len;
+	bool stopping;
+	u32 frame_packets;
+	u32 buf_len;
 	u8 command;
+	struct aurix_tegra_link link;
 };
 
 
@@ -71,11 +104,10 @@ static int tegra_hv_pm_ctl_trigger_sys_reboot(void)
 	return -ENOTSUPP;
 }
 
-static void print_message(struct aurix_tegra_spi_data *data)
+static void print_message(struct aurix_tegra_spi_data *data, u8 *msg)
 {
 #if SPI_DEBUG == 1
 	struct spi_device *spi = data->spi;
-	u8 *msg = (u8*) data->receive;
 	int len = data->buf_len;
 	int i;
 
@@ -89,28 +121,28 @@ static void print_message(struct aurix_tegra_spi_data *data)
 
 /*
  * return value: cmd_msg_id (SHUTDOWN, RESET or SUSPEND),
- * -1 otherwise (command not valid).
+ * -1 otherwise (not a command, e.g. an application message).
  */
-static int read_cmd_message_id(struct aurix_tegra_spi_data *data)
+static int read_cmd_message_id(struct aurix_tegra_spi_data *data,
+			       struct packet *msg)
 {
 	int ret;
 	struct spi_device *spi = data->spi;
-	struct packet *msg = data->receive;
 
 	if (msg->src_layer_id != AURIX) {
-		dev_err(&spi->dev, "Source is not Aurix\n");
+		dev_dbg(&spi->dev, "Source is not Aurix\n");
 		return -1;
 	}
 	if (msg->dest_layer_id != TEGRA) {
-		dev_err(&spi->dev, "Destination is not Tegra\n");
+		dev_dbg(&spi->dev, "Destination is not Tegra\n");
 		return -1;
 	}
 	if (msg->class_id != FUSA) {
-		dev_err(&spi->dev, "Class id not valid\n");
+		dev_dbg(&spi->dev, "Class id not valid\n");
 		return -1;
 	}
 	if (msg->rsp_flag != AURIX_TEGRA) {
-		dev_err(&spi->dev, "RSP flag not valid\n");
+		dev_dbg(&spi->dev, "RSP flag not valid\n");
 		return -1;
 	}
 
@@ -131,29 +163,72 @@ static int read_cmd_message_id(struct aurix_tegra_spi_data *data)
 	return ret;
 }
 
+static bool is_idle_packet(struct packet *msg)
+{
+	u8 *buf = (u8 *) msg;
+	int i;
+
+	for (i = 0; i < sizeof(*msg); i++)
+		if (buf[i] != 0xFF)
+			return false;
+
+	return true;
+}
+
 /*
- * return value: 0 on success (valid command received),
- * negative value otherwise (failure to receive or command is not valid)
+ * Exchange one frame: the Tx packets queued in the link, padded with idle
+ * packets, go out while the frame from Aurix lands in the next Rx slot.
+ * The transfers point into the link rings, so nothing is copied.
+ *
+ * return value: 0 on success (data->command is set if a power management
+ * command was received), negative value on failure to exchange the frame.
  */
 static int aurix_tegra_receive(struct aurix_tegra_spi_data *data)
 {
-	int ret;
+	int ret, i, n = 0;
 	struct spi_device *spi = data->spi;
+	struct aurix_tegra_link *link = &data->link;
+	struct aurix_tegra_spi_hdr *hdr = link->hdr;
+	struct spi_transfer tr[3] = { };
 	struct spi_message msg;
-	u8	*tx_buf = (u8*) data->transmit;
-	u8	*rx_buf = (u8*) data->receive;
-	u8 len = data->buf_len;
-	struct spi_transfer	tr = {
-		.rx_buf = rx_buf,
-		.tx_buf = tx_buf,
-		.len = len,
-	};
-
-	memset(rx_buf, 0, len);
-	memset(tx_buf, 0xFF, len);
-
-	spi_message_init(&msg);
-	spi_message_add_tail(&tr, &msg);
+	struct packet *pkt;
+	u32 tx_entries = link->tx_mask + 1;
+	u32 pending, count, sent = 0, idx, seg;
+	u32 len = data->buf_len, off = 0;
+	bool app_msg = false;
+	u8 *rx_buf;
+
+	if (link->rx_head - smp_load_acquire(&hdr->rx_tail) <= link->rx_mask)
+		rx_buf = link->rx_ring +
+			(link->rx_head & link->rx_mask) * len;
+	else
+		rx_buf = (u8 *) data->receive;
+
+	pending = smp_load_acquire(&hdr->tx_head) - link->tx_tail;
+	/* ignore a tx_head that runs ahead of the ring */
+	if (pending > tx_entries)
+		pending = 0;
+	count = min(pending, data->frame_packets);
+
+	/* at most two ring segments, when the queued packets wrap */
+	while (sent < count) {
+		idx = (link->tx_tail + sent) & link->tx_mask;
+		seg = min(count - sent, tx_entries - idx);
+		tr[n].tx_buf = &link->tx_ring[idx];
+		tr[n].rx_buf = rx_buf + off;
+		tr[n].len = seg * sizeof(struct packet);
+		off += tr[n].len;
+		sent += seg;
+		n++;
+	}
+	if (off < len) {
+		tr[n].tx_buf = data->transmit;
+		tr[n].rx_buf = rx_buf + off;
+		tr[n].len = len - off;
+		n++;
+	}
+
+	spi_message_init_with_transfers(&msg, tr, n);
 	ret = spi_sync(spi, &msg);
 
 	BUG_ON(ret > 0);
@@ -163,16 +238,36 @@ static int aurix_tegra_receive(struct aurix_tegra_spi_data *data)
 			__func__, ret);
 		return ret;
 	}
-	print_message(data);
+	print_message(data, rx_buf);
 
-	ret = read_cmd_message_id(data);
-	if (ret < 0) {
-		dev_err(&spi->dev, "%s: Command received not valid\n",
-			__func__);
-		return -1;
+	if (count) {
+		link->tx_tail += count;
+		smp_store_release(&hdr->tx_tail, link->tx_tail);
+		wake_up_interruptible(&link->wq);
+	}
+
+	data->command = 0;
+	for (i = 0; i < data->frame_packets; i++) {
+		pkt = (struct packet *) rx_buf + i;
+		if (is_idle_packet(pkt))
+			continue;
+
+		ret = read_cmd_message_id(data, pkt);
+		if (ret < 0)
+			app_msg = true;
+		else if (!data->command)
+			data->command = ret;
 	}
 
-	data->command = ret;
+	if (app_msg) {
+		if (rx_buf == (u8 *) data->receive) {
+			WRITE_ONCE(hdr->rx_dropped, hdr->rx_dropped + 1);
+		} else {
+			link->rx_head++;
+			smp_store_release(&hdr->rx_head, link->rx_head);
+			wake_up_interruptible(&link->wq);
+		}
+	}
 
 	return 0;
 }
@@ -221,23 +316,36 @@ static int aurix_tegra_read_thread(void *data)
 	struct aurix_tegra_spi_data *aurix_data = (struct aurix_tegra_spi_data *) data;
 	struct device *dev = &aurix_data->spi->dev;
 	unsigned long flags;
+	bool stopping;
 	int err = 0;
 
 	/*
-	 * Error from aurix_tegra_receive() is raised in one of
-	 * the following cases:
-	 * i) spi_sync() failed
-	 * ii) command received not valid.
-	 * On aurix_tegra_stop_kthread(), SIGINT is sent to kthread
-	 * ONLY if kthread is still running (exited = false). That way,
-	 * kthread unblocks from spi_sync() and exits with error value.
-	 * Thus, checking if kthread_should_stop is not necessary.
+	 * Frames are exchanged until a valid command is received.
+	 * On aurix_tegra_stop_kthread(), stopping is set and SIGINT is
+	 * sent to kthread ONLY if kthread is still running (exited = false).
+	 * That way, kthread unblocks from spi_sync() and exits with error
+	 * value. Thus, checking if kthread_should_stop is not necessary.
 	 */
-	err = aurix_tegra_receive(aurix_data);
-	if (err < 0) {
-		dev_dbg(dev, "%s: Error receiving\n", __func__);
-		goto ret;
+	for (;;) {
+		err = aurix_tegra_receive(aurix_data);
+
+		spin_lock_irqsave(&aurix_data->lock, flags);
+		stopping = aurix_data->stopping;
+		spin_unlock_irqrestore(&aurix_data->lock, flags);
+		if (stopping)
+			goto ret;
+
+		if (err < 0) {
+			dev_dbg(dev, "%s: Error receiving\n", __func__);
+			/* do not spin on a controller that keeps failing */
+			usleep_range(1000, 2000);
+			continue;
+		}
+
+		if (aurix_data->command)
+			break;
 	}
+
 	err = trigger_command(aurix_data);
 	if (err < 0)
 		goto ret;
@@ -247,12 +355,146 @@ ret:
 	aurix_data->exited = true;
 	spin_unlock_irqrestore(&aurix_data->lock, flags);
 #if defined(NV_KTHREAD_COMPLETE_AND_EXIT_PRESENT) /* Linux v5.17 */
-	kthread_complete_and_exit(NULL, err);
+	kthread_complete_and_exit(&aurix_data->thread_done, err);
 #else
-	complete_and_exit(NULL, err);
+	complete_and_exit(&aurix_data->thread_done, err);
 #endif
 }
 
+static int aurix_tegra_link_open(struct inode *inode, struct file *filp)
+{
+	struct aurix_tegra_link *link = container_of(filp->private_data,
+					struct aurix_tegra_link, misc);
+	int ret = 0;
+
+	/* a single user produces Tx packets and consumes Rx frames */
+	mutex_lock(&link->lock);
+	if (link->users)
+		ret = -EBUSY;
+	else
+		link->users++;
+	mutex_unlock(&link->lock);
+
+	filp->private_data = link;
+
+	return ret;
+}
+
+static int aurix_tegra_link_release(struct inode *inode, struct file *filp)
+{
+	struct aurix_tegra_link *link = filp->private_data;
+
+	mutex_lock(&link->lock);
+	link->users--;
+	mutex_unlock(&link->lock);
+
+	return 0;
+}
+
+static int aurix_tegra_link_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct aurix_tegra_link *link = filp->private_data;
+	unsigned long size = vma->vm_end - vma->vm_start;
+
+	if (vma->vm_pgoff || size > link->size)
+		return -EINVAL;
+
+	return remap_vmalloc_range(vma, link->hdr, 0);
+}
+
+static __poll_t aurix_tegra_link_poll(struct file *filp, poll_table *wait)
+{
+	struct aurix_tegra_link *link = filp->private_data;
+	struct aurix_tegra_spi_hdr *hdr = link->hdr;
+	__poll_t mask = 0;
+
+	poll_wait(filp, &link->wq, wait);
+
+	if (smp_load_acquire(&hdr->rx_head) != READ_ONCE(hdr->rx_tail))
+		mask |= EPOLLIN | EPOLLRDNORM;
+	if (READ_ONCE(hdr->tx_head) - smp_load_acquire(&hdr->tx_tail) <=
+			link->tx_mask)
+		mask |= EPOLLOUT | EPOLLWRNORM;
+
+	return mask;
+}
+
+static const struct file_operations aurix_tegra_link_fops = {
+	.owner = THIS_MODULE,
+	.open = aurix_tegra_link_open,
+	.release = aurix_tegra_link_release,
+	.mmap = aurix_tegra_link_mmap,
+	.poll = aurix_tegra_link_poll,
+	.llseek = noop_llseek,
+};
+
+static int aurix_tegra_link_init(struct aurix_tegra_spi_data *data,
+				 u32 num_frames)
+{
+	struct aurix_tegra_link *link = &data->link;
+	struct aurix_tegra_spi_hdr *hdr;
+	struct device *dev = &data->spi->dev;
+	u32 tx_offset, rx_offset;
+	int err;
+
+	mutex_init(&link->lock);
+	init_waitqueue_head(&link->wq);
+
+	tx_offset = PAGE_SIZE;
+	rx_offset = tx_offset + PAGE_ALIGN(num_frames * data->buf_len);
+	link->size = rx_offset + PAGE_ALIGN(num_frames * data->buf_len);
+	hdr = vmalloc_user(link->size);
+	if (!hdr)
+		return -ENOMEM;
+
+	hdr->magic = AURIX_TEGRA_SPI_MAGIC;
+	hdr->version = AURIX_TEGRA_SPI_VERSION;
+	hdr->packet_size = sizeof(struct packet);
+	hdr->frame_packets = data->frame_packets;
+	hdr->tx_offset = tx_offset;
+	hdr->tx_entries = num_frames * data->frame_packets;
+	hdr->rx_offset = rx_offset;
+	hdr->rx_entries = num_frames;
+	hdr->rx_frame_size = data->buf_len;
+
+	link->hdr = hdr;
+	link->tx_ring = (void *) hdr + tx_offset;
+	link->rx_ring = (void *) hdr + rx_offset;
+	link->tx_mask = hdr->tx_entries - 1;
+	link->rx_mask = num_frames - 1;
+
+	link->misc.minor = MISC_DYNAMIC_MINOR;
+	link->misc.name = "aurix_tegra_spi";
+	link->misc.fops = &aurix_tegra_link_fops;
+	link->misc.parent = dev;
+
+	err = misc_register(&link->misc);
+	if (err < 0) {
+		dev_err(dev, "failed to register %s\n", link->misc.name);
+		vfree(hdr);
+		link->hdr = NULL;
+		return err;
+	}
+	link->registered = true;
+
+	return 0;
+}
+
+static void aurix_tegra_link_deinit(struct aurix_tegra_spi_data *data)
+{
+	struct aurix_tegra_link *link = &data->link;
+
+	if (!link->registered)
+		return;
+
+	misc_deregister(&link->misc);
+	link->registered = false;
+
+	/* pages still mapped by userspace hold a reference */
+	vfree(link->hdr);
+	link->hdr = NULL;
+}
+
 static const struct of_device_id aurix_tegra_ids[] = {
 	{ .compatible = "aurix-tegra-spi", },
 	{}
@@ -261,7 +503,7 @@ MODULE_DEVICE_TABLE(of, aurix_tegra_ids);
 
 static int aurix_tegra_spi_probe(struct spi_device *spi)
 {
-	u32 value;
+	u32 value, num_frames;
 	int err = 0;
 	struct aurix_tegra_spi_data *data;
 	struct device_node *np = spi->dev.of_node;
@@ -271,7 +513,9 @@ static int aurix_tegra_spi_probe(struct spi_device *spi)
 		return -ENOMEM;
 
 	spin_lock_init(&data->lock);
+	init_completion(&data->thread_done);
 	data->exited = false;
+	data->stopping = false;
 
 	err = of_property_read_u32(np, "spi-max-frequency", &value);
 	if (err < 0) {
@@ -291,19 +535,42 @@ static int aurix_tegra_spi_probe(struct spi_device *spi)
 		goto error;
 	}
 
+	/*
+	 * Packets per frame and frames per ring, both sides of the link
+	 * must agree on the frame size.
+	 */
+	data->frame_packets = 1;
+	of_property_read_u32(np, "nvidia,frame-packets", &data->frame_packets);
+	num_frames = DEF_RING_FRAMES;
+	of_property_read_u32(np, "nvidia,ring-frames", &num_frames);
+	if (!data->frame_packets || data->frame_packets > MAX_FRAME_PACKETS ||
+	    !is_power_of_2(data->frame_packets) ||
+	    !is_power_of_2(num_frames) || num_frames > MAX_RING_FRAMES) {
+		dev_err(&spi->dev, "invalid frame-packets or ring-frames\n");
+		err = -EINVAL;
+		goto error;
+	}
+
 	data->spi = spi;
-	data->buf_len = sizeof(struct packet);
+	data->buf_len = data->frame_packets * sizeof(struct packet);
 	data->transmit = devm_kzalloc(&spi->dev, data->buf_len, GFP_KERNEL);
 	if (IS_ERR_OR_NULL(data->transmit)) {
 		err = -ENOMEM;
 		goto error;
 	}
+	memset(data->transmit, 0xFF, data->buf_len);
 	data->receive = devm_kzalloc(&spi->dev, data->buf_len, GFP_KERNEL);
 	if (IS_ERR_OR_NULL(data->receive)) {
 		err = -ENOMEM;
 		goto error;
 	}
 
+	err = aurix_tegra_link_init(data, num_frames);
+	if (err < 0)
+		goto error;
+
+	spi_set_drvdata(spi, data);
+
 	/*
 	 * Kernel thread handles the communication between Aurix and Tegra.
 	 * It remains idle, until a request from Aurix is sent. Upon receiving,
@@ -313,12 +580,13 @@ static int aurix_tegra_spi_probe(struct spi_device *spi)
 		(void*) data, "aurix_tegra_kthread");
 	if (IS_ERR_OR_NULL(data->thread)) {
 		err = PTR_ERR(data->thread);
-		goto error;
+		goto error_link;
 	}
 
-	spi_set_drvdata(spi, data);
 	return 0;
 
+error_link:
+	aurix_tegra_link_deinit(data);
 error:
 	return err;
 }
@@ -338,6 +606,7 @@ static int aurix_tegra_stop_kthread(struct device *dev)
 
 	if (data->thread) {
 		spin_lock_irqsave(&data->lock, flags);
+		data->stopping = true;
 		if (!data->exited)
 			ret = send_sig(SIGINT, data->thread, 0);
 		spin_unlock_irqrestore(&data->lock, flags);
@@ -355,32 +624,52 @@ static int aurix_tegra_start_kthread(struct device *dev)
 	int ret = 0;
 	unsigned long flags;
 
+	spin_lock_irqsave(&data->lock, flags);
+	data->exited = false;
+	data->stopping = false;
+	spin_unlock_irqrestore(&data->lock, flags);
+	reinit_completion(&data->thread_done);
+
 	data->thread = kthread_run(aurix_tegra_read_thread,
 		(void*) data, "aurix_tegra_kthread");
 	if (IS_ERR_OR_NULL(data->thread)) {
 		ret = PTR_ERR(data->thread);
 		dev_err(dev, "%s: Error creating thread\n", __func__);
+		spin_lock_irqsave(&data->lock, flags);
+		data->exited = true;
+		spin_unlock_irqrestore(&data->lock, flags);
+		complete(&data->thread_done);
 		return ret;
 	}
-
-	spin_lock_irqsave(&data->lock, flags);
-	data->exited = false;
-	spin_unlock_irqrestore(&data->lock, flags);
 	return ret;
 }
 
 /*
  * remove, shutdown, suspend, resume functions
  */
+/* the kthread uses the link rings, let it exit before freeing them */
+static int aurix_tegra_teardown(struct spi_device *spi)
+{
+	struct aurix_tegra_spi_data *data = spi_get_drvdata(spi);
+	int ret;
+
+	ret = aurix_tegra_stop_kthread(&spi->dev);
+	if (!ret)
+		wait_for_completion(&data->thread_done);
+	aurix_tegra_link_deinit(data);
+
+	return ret;
+}
+
 #if LINUX_VERSION_CODE < KERNEL_VERSION(5, 18, 0)
 static int aurix_tegra_spi_remove(struct spi_device *spi)
 {
-	return aurix_tegra_stop_kthread(&spi->dev);
+	return aurix_tegra_teardown(spi);
 }
 #else
 static void aurix_tegra_spi_remove(struct spi_device *spi)
 {
-	aurix_tegra_stop_kthread(&spi->dev);
+	aurix_tegra_teardown(spi);
 }
 #endif
 
@@ -18,15 +18,20 @@
 #include <linux/kernel.h>
 #include <linux/kthread.h>
 #include <linux/sched/signal.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
+#include <linux/poll.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
 #include <linux/spi/spi.h>
 #include <linux/spi/spi-tegra124-slave.h>
 #include <linux/clk/tegra.h>
+#include <linux/uaccess.h>
 #include <linux/version.h>
+#include <uapi/linux/tegra-spi-slave-ring.h>
 
 #define SPI_COMMAND1				0x000
 #define SPI_BIT_LENGTH(x)			(((x) & 0x1f) << 0)
@@ -157,6 +162,10 @@
 /* multiplication facotr for slave timeout, See code below */
 #define DELAY_MUL_FACTOR			1000
 
+/* frames with a dma descriptor queued ahead of the controller in ring mode */
+#define SPI_RING_INFLIGHT			4
+#define SPI_RING_MAX_SIZE			(16 * 1024 * 1024)
+
 #define PROFILE_SPI_SLAVE	/* profile spi sw overhead */
 #define VERBOSE_DUMP_REGS	/* register dumps */
 #define TEGRA_SPI_SLAVE_DEBUG	/* to enable debug interfaces, sysfs ... */
@@ -280,6 +289,45 @@ struct tegra_spi_controller_data {
 	int cs_gpio;
 };
 
+/* continuous rx mode, see uapi/linux/tegra-spi-slave-ring.h */
+struct tegra_spi_rx_ring {
+	struct miscdevice			misc;
+	char					name[32];
+	bool					registered;
+	/* serializes open/ioctl/release, protects users and running */
+	struct mutex				lock;
+	wait_queue_head_t			wq;
+	int					users;
+	bool					running;
+	struct spi_device			*spi;
+
+	struct tegra_spi_slave_ring_hdr		*hdr;
+	struct tegra_spi_slave_ring_desc	*descs;
+	void					*buf;
+	dma_addr_t				buf_phys;
+	size_t					alloc_size;
+	size_t					map_size;
+	u32					data_offset;
+	u32					frame_len;
+	u32					frame_stride;
+	u32					frame_words;
+	u32					mask;
+
+	/* below are protected by tspi->lock */
+	bool					active;
+	bool					stopping;
+	bool					armed;
+	u32					reserved;
+	u32					head;
+	u32					queued;
+	u32					published;
+	u32					hw_frames;
+	u32					dma_frames;
+	/* ring slot per unpublished frame, -1 for the scratch buffer */
+	int					slot[SPI_RING_INFLIGHT];
+	u64					tstamp[SPI_RING_INFLIGHT];
+};
+
 struct tegra_spi_data {
 	struct device				*dev;
 	struct spi_controller			*controller;
@@ -350,6 +398,9 @@ struct tegra_spi_data {
 	int				rx_trig_words;
 	int				force_unpacked_mode;
 	bool				lsbyte_first;
+	/* a spi_message is being transferred, protected by lock */
+	bool				msg_active;
+	struct tegra_spi_rx_ring	ring;
 #ifdef PROFILE_SPI_SLAVE
 	ktime_t				start_time;
 	ktime_t				end_time;
@@ -839,6 +890,37 @@ static inline int tegra_spi_ext_clk_enable(bool enable,
 	}
 	return ret;
 }
+/* Set attention level based on length of transfer, dt can override it */
+static unsigned long tegra_spi_dma_trig(struct tegra_spi_data *tspi,
+		unsigned int len, int *maxburst)
+{
+	unsigned long val = 0;
+
+	*maxburst = 0;
+	if (!tspi->rx_trig_words) {
+		if (len & 0xF) {
+			val |= SPI_TX_TRIG_1 | SPI_RX_TRIG_1;
+			*maxburst = 1;
+		} else if (((len) >> 4) & 0x1) {
+			val |= SPI_TX_TRIG_4 | SPI_RX_TRIG_4;
+			*maxburst = 4;
+		} else {
+			val |= SPI_TX_TRIG_8 | SPI_RX_TRIG_8;
+			*maxburst = 8;
+		}
+	} else {
+		if (tspi->rx_trig_words == 4) {
+			val |= SPI_TX_TRIG_4 | SPI_RX_TRIG_4;
+			*maxburst = 4;
+		} else if (tspi->rx_trig_words == 8) {
+			val |= SPI_TX_TRIG_8 | SPI_RX_TRIG_8;
+			*maxburst = 8;
+		}
+	}
+
+	return val;
+}
+
 static int tegra_spi_start_dma_based_transfer(struct
 			tegra_spi_data * tspi, struct spi_transfer *t)
 {
@@ -857,35 +939,13 @@ static int tegra_spi_start_dma_based_transfer(struct
 	val = SPI_DMA_BLK_SET(tspi->curr_dma_words - 1);
 	tegra_spi_writel(tspi, val, SPI_DMA_BLK);
 
-	val = 0; /* Reset the variable for reuse */
-
 	if (tspi->is_packed)
 		len = DIV_ROUND_UP(tspi->curr_dma_words * tspi->bytes_per_word,
 					4) * 4;
 	else
 		len = tspi->curr_dma_words * 4;
 
-	if (!tspi->rx_trig_words) {
-		/* Set attention level based on length of transfer */
-		if (len & 0xF) {
-			val |= SPI_TX_TRIG_1 | SPI_RX_TRIG_1;
-			maxburst = 1;
-		} else if (((len) >> 4) & 0x1) {
-			val |= SPI_TX_TRIG_4 | SPI_RX_TRIG_4;
-			maxburst = 4;
-		} else {
-			val |= SPI_TX_TRIG_8 | SPI_RX_TRIG_8;
-			maxburst = 8;
-		}
-	} else { /* dt can override the trigger */
-		if (tspi->rx_trig_words == 4) {
-			val |= SPI_TX_TRIG_4 | SPI_RX_TRIG_4;
-			maxburst = 4;
-		} else if (tspi->rx_trig_words == 8) {
-			val |= SPI_TX_TRIG_8 | SPI_RX_TRIG_8;
-			maxburst = 8;
-		}
-	}
+	val = tegra_spi_dma_trig(tspi, len, &maxburst);
 
 	if (tspi->variable_length_transfer &&
 		tspi->chip_data->new_features &&
@@ -1251,22 +1311,12 @@ static void set_best_clk_source(struct spi_device *spi,
 	}
 }
 
-static int tegra_spi_start_transfer_one(struct spi_device *spi,
-		struct spi_transfer *t, bool is_first_of_msg,
-		bool is_single_xfer)
+static int tegra_spi_set_core_clk(struct spi_device *spi, u32 speed)
 {
 	struct tegra_spi_data *tspi = spi_master_get_devdata(spi->controller);
-	struct tegra_spi_controller_data *cdata = spi->controller_data;
-	u32 speed;
 	u32 core_speed;
-	u8 bits_per_word;
-	unsigned int total_fifo_words;
 	int ret;
-	unsigned long command1;
-	int req_mode;
 
-	bits_per_word = t->bits_per_word;
-	speed = t->speed_hz ? t->speed_hz : spi->max_speed_hz;
 	/* Set slave controller clk 1.5 times the bus frequency */
 	if (!speed)
 		speed = spi->max_speed_hz;
@@ -1302,6 +1352,28 @@ static int tegra_spi_start_transfer_one(struct spi_device *spi,
 		tspi->cur_speed = core_speed;
 	}
 
+	return 0;
+}
+
+static int tegra_spi_start_transfer_one(struct spi_device *spi,
+		struct spi_transfer *t, bool is_first_of_msg,
+		bool is_single_xfer)
+{
+	struct tegra_spi_data *tspi = spi_master_get_devdata(spi->controller);
+	struct tegra_spi_controller_data *cdata = spi->controller_data;
+	u32 speed;
+	u8 bits_per_word;
+	unsigned int total_fifo_words;
+	int ret;
+	unsigned long command1;
+	int req_mode;
+
+	bits_per_word = t->bits_per_word;
+	speed = t->speed_hz ? t->speed_hz : spi->max_speed_hz;
+	ret = tegra_spi_set_core_clk(spi, speed);
+	if (ret < 0)
+		return ret;
+
 	tspi->cur_spi = spi;
 	tspi->curr_xfer = t;
 	tspi->curr_rx_pos = 0;
@@ -1766,14 +1838,32 @@ static int tegra_spi_transfer_one_message(struct spi_controller *controller,
 	struct tegra_spi_data *tspi = spi_master_get_devdata(controller);
 	struct spi_transfer *xfer;
 	struct spi_device *spi = msg->spi;
-	int ret;
+	unsigned long flags;
+	int ret = 0;
 
 	msg->status = 0;
 	msg->actual_length = 0;
 
+	/* the controller belongs to the rx ring while it runs */
+	spin_lock_irqsave(&tspi->lock, flags);
+	if (tspi->ring.active)
+		ret = -EBUSY;
+	else
+		tspi->msg_active = true;
+	spin_unlock_irqrestore(&tspi->lock, flags);
+	if (ret < 0) {
+		dev_dbg(tspi->dev, "rx ring is running\n");
+		msg->status = ret;
+		spi_finalize_current_message(controller);
+		return ret;
+	}
+
 	ret = pm_runtime_get_sync(tspi->dev);
 	if (ret < 0) {
 		dev_err(tspi->dev, "runtime PM get failed: %d\n", ret);
+		spin_lock_irqsave(&tspi->lock, flags);
+		tspi->msg_active = false;
+		spin_unlock_irqrestore(&tspi->lock, flags);
 		msg->status = ret;
 		spi_finalize_current_message(controller);
 		return ret;
@@ -1844,11 +1934,647 @@ static int tegra_spi_transfer_one_message(struct spi_controller *controller,
 exit:
 	tegra_spi_writel(tspi, tspi->def_command1_reg, SPI_COMMAND1);
 	pm_runtime_put(tspi->dev);
+	spin_lock_irqsave(&tspi->lock, flags);
+	tspi->msg_active = false;
+	spin_unlock_irqrestore(&tspi->lock, flags);
 	msg->status = ret;
 	spi_finalize_current_message(controller);
 	return ret;
 }
 
+static void tegra_spi_ring_dma_complete(void *args);
+
+/* called with tspi->lock held */
+static int tegra_spi_ring_queue(struct tegra_spi_data *tspi)
+{
+	struct tegra_spi_rx_ring *ring = &tspi->ring;
+	struct dma_async_tx_descriptor *desc;
+	dma_addr_t addr;
+	int slot = -1;
+
+	/* Userspace is done with the slots up to tail once it is published */
+	if (ring->reserved - smp_load_acquire(&ring->hdr->tail) <= ring->mask) {
+		slot = ring->reserved & ring->mask;
+		addr = ring->buf_phys + ring->data_offset +
+				slot * ring->frame_stride;
+	} else {
+		/* ring is full, keep the controller fed with the scratch slot */
+		addr = ring->buf_phys + ring->map_size;
+	}
+
+	desc = dmaengine_prep_slave_single(tspi->rx_dma_chan, addr,
+				ring->frame_len, DMA_DEV_TO_MEM,
+				DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!desc) {
+		dev_err_ratelimited(tspi->dev, "Not able to get desc for Rx\n");
+		return -EIO;
+	}
+
+	desc->callback = tegra_spi_ring_dma_complete;
+	desc->callback_param = tspi;
+
+	if (slot >= 0)
+		ring->reserved++;
+	ring->slot[ring->queued % SPI_RING_INFLIGHT] = slot;
+	ring->queued++;
+
+	dmaengine_submit(desc);
+	dma_async_issue_pending(tspi->rx_dma_chan);
+	return 0;
+}
+
+/* called with tspi->lock held */
+static void tegra_spi_ring_arm(struct tegra_spi_data *tspi)
+{
+	unsigned long intr_mask;
+
+	if (tspi->chip_data->intr_mask_reg) {
+		intr_mask = tegra_spi_readl(tspi, SPI_INTR_MASK);
+		intr_mask &= ~(SPI_INTR_CS_MASK |
+				SPI_INTR_RDY_MASK |
+				SPI_INTR_RX_FIFO_UNF_MASK |
+				SPI_INTR_RX_FIFO_OVF_MASK);
+		tegra_spi_writel(tspi, intr_mask, SPI_INTR_MASK);
+	}
+
+	atomic_set(&tspi->isr_expected, 1);
+	wmb(); /* to complete the register writes and the atomic var update */
+	tegra_spi_writel(tspi, tspi->dma_control_reg | SPI_DMA_EN, SPI_DMA_CTL);
+	tspi->ring.armed = true;
+
+	tegra_spi_slave_ready(tspi);
+}
+
+/* called with tspi->lock held */
+static void tegra_spi_ring_fail(struct tegra_spi_data *tspi)
+{
+	struct tegra_spi_rx_ring *ring = &tspi->ring;
+
+	/* leave the controller unarmed, userspace restarts the ring */
+	ring->stopping = true;
+	atomic_set(&tspi->isr_expected, 0);
+	tegra_spi_slave_busy(tspi);
+	WRITE_ONCE(ring->hdr->status,
+		   ring->hdr->status | TEGRA_SPI_SLAVE_RING_ST_ERROR);
+	wake_up_interruptible(&ring->wq);
+}
+
+/* Publish the frames that both the controller and the dma are done with,
+ * keep SPI_RING_INFLIGHT descriptors queued and re-arm the controller if
+ * the descriptor for its next frame is queued. Called with tspi->lock held.
+ */
+static void tegra_spi_ring_advance(struct tegra_spi_data *tspi)
+{
+	struct tegra_spi_rx_ring *ring = &tspi->ring;
+	struct tegra_spi_slave_ring_desc *desc;
+	u32 head = ring->head;
+	u32 done;
+	int idx;
+
+	done = ((s32)(ring->hw_frames - ring->dma_frames) < 0) ?
+			ring->hw_frames : ring->dma_frames;
+
+	while (ring->published != done) {
+		idx = ring->published % SPI_RING_INFLIGHT;
+		if (ring->slot[idx] >= 0) {
+			desc = &ring->descs[ring->slot[idx]];
+			desc->tstamp_ns = ring->tstamp[idx];
+			desc->len = ring->frame_len;
+			ring->head++;
+		} else {
+			WRITE_ONCE(ring->hdr->dropped,
+				   ring->hdr->dropped + 1);
+		}
+		ring->published++;
+	}
+
+	if (ring->head != head) {
+		smp_store_release(&ring->hdr->head, ring->head);
+		wake_up_interruptible(&ring->wq);
+	}
+
+	while (ring->queued - ring->published < SPI_RING_INFLIGHT) {
+		if (tegra_spi_ring_queue(tspi) < 0) {
+			tegra_spi_ring_fail(tspi);
+			return;
+		}
+	}
+
+	if (!ring->armed && ring->hw_frames != ring->queued)
+		tegra_spi_ring_arm(tspi);
+}
+
+static void tegra_spi_ring_dma_complete(void *args)
+{
+	struct tegra_spi_data *tspi = args;
+	struct tegra_spi_rx_ring *ring = &tspi->ring;
+	unsigned long flags;
+
+	spin_lock_irqsave(&tspi->lock, flags);
+	if (ring->active && !ring->stopping) {
+		ring->dma_frames++;
+		tegra_spi_ring_advance(tspi);
+	}
+	spin_unlock_irqrestore(&tspi->lock, flags);
+}
+
+static irqreturn_t tegra_spi_ring_isr(struct tegra_spi_data *tspi,
+		unsigned long status_reg)
+{
+	struct tegra_spi_rx_ring *ring = &tspi->ring;
+	u32 words;
+
+	spin_lock(&tspi->lock);
+	if (!ring->active || ring->stopping)
+		goto out;
+
+	ring->armed = false;
+	/* the 16bit block count reads 0 for 64K packets */
+	words = SPI_BLK_CNT(tegra_spi_readl(tspi, SPI_TRANS_STATUS));
+	if ((status_reg & (SPI_RX_FIFO_OVF | SPI_RX_FIFO_UNF)) ||
+	    words != (ring->frame_words & (MAX_PACKETS - 1)) ||
+	    (tspi->chip_data->mask_cs_inactive_intr &&
+	     (status_reg & SPI_CS_INACTIVE))) {
+		dump_regs(err_ratelimited, tspi,
+			"ring-rx-err [status:%08lx words:%u]", status_reg, words);
+		tegra_spi_ring_fail(tspi);
+		goto out;
+	}
+
+	ring->tstamp[ring->hw_frames % SPI_RING_INFLIGHT] = ktime_get_ns();
+	ring->hw_frames++;
+	tegra_spi_ring_advance(tspi);
+
+	/* dma is behind by SPI_RING_INFLIGHT frames, hold off the master */
+	if (!ring->armed)
+		tegra_spi_slave_busy(tspi);
+out:
+	spin_unlock(&tspi->lock);
+	return IRQ_HANDLED;
+}
+
+static void tegra_spi_ring_free(struct tegra_spi_data *tspi)
+{
+	struct tegra_spi_rx_ring *ring = &tspi->ring;
+
+	if (!ring->buf)
+		return;
+
+	dma_free_coherent(tspi->dev, ring->alloc_size, ring->buf,
+			  ring->buf_phys);
+	ring->buf = NULL;
+	ring->hdr = NULL;
+	ring->descs = NULL;
+}
+
+static int tegra_spi_ring_alloc(struct tegra_spi_data *tspi,
+		struct tegra_spi_slave_ring_cfg *cfg)
+{
+	struct tegra_spi_rx_ring *ring = &tspi->ring;
+	struct tegra_spi_slave_ring_hdr *hdr;
+	u32 descs_offset, data_offset, stride;
+	size_t map_size;
+
+	/* the memory may be mapped, only a new open can change its layout */
+	if (ring->buf) {
+		if (cfg->frame_len != ring->frame_len ||
+		    cfg->num_frames != ring->mask + 1)
+			return -EBUSY;
+		return 0;
+	}
+
+	descs_offset = ALIGN(sizeof(*hdr), SMP_CACHE_BYTES);
+	data_offset = PAGE_ALIGN(descs_offset + cfg->num_frames *
+			sizeof(struct tegra_spi_slave_ring_desc));
+	stride = ALIGN(cfg->frame_len, SMP_CACHE_BYTES);
+	map_size = PAGE_ALIGN(data_offset + (size_t)cfg->num_frames * stride);
+	if (map_size > SPI_RING_MAX_SIZE)
+		return -EMSGSIZE;
+
+	/* one extra frame at the end takes the data of a full ring */
+	ring->alloc_size = map_size + stride;
+	ring->buf = dma_alloc_coherent(tspi->dev, ring->alloc_size,
+				       &ring->buf_phys, GFP_KERNEL);
+	if (!ring->buf)
+		return -ENOMEM;
+
+	hdr = ring->buf;
+	memset(hdr, 0, data_offset);
+	hdr->magic = TEGRA_SPI_SLAVE_RING_MAGIC;
+	hdr->version = TEGRA_SPI_SLAVE_RING_VERSION;
+	hdr->frame_len = cfg->frame_len;
+	hdr->frame_stride = stride;
+	hdr->num_frames = cfg->num_frames;
+	hdr->descs_offset = descs_offset;
+	hdr->data_offset = data_offset;
+
+	ring->hdr = hdr;
+	ring->descs = ring->buf + descs_offset;
+	ring->map_size = map_size;
+	ring->data_offset = data_offset;
+	ring->frame_len = cfg->frame_len;
+	ring->frame_stride = stride;
+	ring->mask = cfg->num_frames - 1;
+
+	return 0;
+}
+
+struct tegra_spi_ring_lookup {
+	u8 chip_select;
+	struct spi_device *spi;
+};
+
+static int tegra_spi_ring_match_cs(struct device *dev, void *data)
+{
+	struct tegra_spi_ring_lookup *lookup = data;
+	struct spi_device *spi = to_spi_device(dev);
+
+#if defined(NV_SPI_GET_CHIPSELECT_PRESENT)
+	if (spi_get_chipselect(spi, 0) != lookup->chip_select)
+#else
+	if (spi->chip_select != lookup->chip_select)
+#endif
+		return 0;
+
+	lookup->spi = to_spi_device(get_device(dev));
+	return 1;
+}
+
+static void tegra_spi_ring_stop(struct tegra_spi_data *tspi)
+{
+	struct tegra_spi_rx_ring *ring = &tspi->ring;
+	unsigned long flags;
+
+	if (!ring->running)
+		return;
+
+	spin_lock_irqsave(&tspi->lock, flags);
+	ring->stopping = true;
+	atomic_set(&tspi->isr_expected, 0);
+	spin_unlock_irqrestore(&tspi->lock, flags);
+
+	dmaengine_terminate_sync(tspi->rx_dma_chan);
+	tegra_spi_slave_busy(tspi);
+	tegra_spi_ext_clk_enable(false, tspi);
+
+	/* resetting controller to unarm spi */
+	tspi->is_curr_dma_xfer = false;
+	tspi->dma_control_reg = 0;
+	tspi->reset_ctrl_status = true;
+	reset_controller(tspi);
+	pm_runtime_put(tspi->dev);
+
+	put_device(&ring->spi->dev);
+	ring->spi = NULL;
+	ring->running = false;
+	WRITE_ONCE(ring->hdr->status, ring->hdr->status &
+		   ~TEGRA_SPI_SLAVE_RING_ST_RUNNING);
+
+	spin_lock_irqsave(&tspi->lock, flags);
+	ring->active = false;
+	ring->stopping = false;
+	spin_unlock_irqrestore(&tspi->lock, flags);
+
+	wake_up_interruptible(&ring->wq);
+}
+
+static int tegra_spi_ring_start(struct tegra_spi_data *tspi,
+		struct tegra_spi_slave_ring_cfg *cfg)
+{
+	struct tegra_spi_rx_ring *ring = &tspi->ring;
+	struct tegra_spi_ring_lookup lookup = { 0 };
+	struct dma_slave_config dma_sconfig = { 0 };
+	struct tegra_spi_slave_ring_hdr *hdr;
+	struct spi_device *spi;
+	unsigned long command1, val, flags;
+	u8 bits_per_word;
+	int maxburst;
+	int ret;
+
+	if (ring->running)
+		return -EBUSY;
+
+	if (cfg->reserved[0] || cfg->reserved[1] || cfg->reserved[2] ||
+	    !cfg->frame_len || cfg->frame_len % 4 ||
+	    cfg->num_frames < 2 ||
+	    cfg->num_frames > TEGRA_SPI_SLAVE_RING_MAX_FRAMES ||
+	    !is_power_of_2(cfg->num_frames) ||
+	    cfg->chip_select >= MAX_CHIP_SELECT)
+		return -EINVAL;
+
+	lookup.chip_select = cfg->chip_select;
+	device_for_each_child(&tspi->controller->dev, &lookup,
+			      tegra_spi_ring_match_cs);
+	spi = lookup.spi;
+	if (!spi)
+		return -ENODEV;
+
+	/* frames are always received packed, straight into the ring */
+	bits_per_word = spi->bits_per_word ? spi->bits_per_word : 8;
+	if (bits_per_word != 8 && bits_per_word != 16 && bits_per_word != 32) {
+		ret = -EINVAL;
+		goto exit_put_spi;
+	}
+
+	if (cfg->frame_len / (bits_per_word / 8) > MAX_PACKETS) {
+		ret = -EMSGSIZE;
+		goto exit_put_spi;
+	}
+
+	val = tegra_spi_dma_trig(tspi, cfg->frame_len, &maxburst);
+	/* a partial burst at the end of a frame would never be fetched */
+	if (!maxburst || cfg->frame_len % (maxburst * 4)) {
+		ret = -EINVAL;
+		goto exit_put_spi;
+	}
+
+	ret = tegra_spi_ring_alloc(tspi, cfg);
+	if (ret < 0)
+		goto exit_put_spi;
+
+	spin_lock_irqsave(&tspi->lock, flags);
+	if (tspi->msg_active)
+		ret = -EBUSY;
+	else
+		ring->active = true;
+	spin_unlock_irqrestore(&tspi->lock, flags);
+	if (ret < 0)
+		goto exit_put_spi;
+
+	ret = pm_runtime_get_sync(tspi->dev);
+	if (ret < 0) {
+		dev_err(tspi->dev, "runtime PM get failed: %d\n", ret);
+		pm_runtime_put_noidle(tspi->dev);
+		goto exit_inactive;
+	}
+
+	tegra_spi_ext_clk_enable(false, tspi);
+	tspi->reset_ctrl_status = true;
+	reset_controller(tspi);
+
+	ret = tegra_spi_set_core_clk(spi, cfg->speed_hz);
+	if (ret < 0)
+		goto exit_pm_put;
+
+	tspi->cur_spi = spi;
+	tspi->is_packed = true;
+	tspi->bytes_per_word = bits_per_word / 8;
+	tspi->cur_direction = DATA_DIR_RX;
+	tspi->variable_length_transfer = false;
+	ring->frame_words = cfg->frame_len / tspi->bytes_per_word;
+
+	tegra_spi_clear_status(tspi);
+
+	command1 = tspi->def_command1_reg;
+	command1 |= SPI_BIT_LENGTH(bits_per_word - 1);
+	command1 &= ~SPI_CONTROL_MODE_MASK;
+	command1 |= SPI_MODE_SEL(spi->mode & 0x3);
+	if (spi->mode & SPI_LSB_FIRST)
+		command1 |= SPI_LSBIT_FE;
+	command1 &= ~SPI_CS_SEL_MASK;
+	command1 |= SPI_PACKED | SPI_RX_EN | SPI_CS_SEL(cfg->chip_select);
+	tegra_spi_writel(tspi, command1, SPI_COMMAND1);
+	tspi->command1_reg = command1;
+
+	ret = check_and_clear_fifo(tspi);
+	if (ret < 0)
+		goto exit_reset;
+
+	tegra_spi_writel(tspi, SPI_DMA_BLK_SET(ring->frame_words - 1),
+			 SPI_DMA_BLK);
+
+	if (!tspi->chip_data->intr_mask_reg && !tspi->chip_data->new_features)
+		val |= SPI_IE_RX;
+	tegra_spi_writel(tspi, val, SPI_DMA_CTL);
+	tspi->dma_control_reg = val;
+
+	dma_sconfig.src_addr = tspi->phys + SPI_RX_FIFO;
+	dma_sconfig.src_addr_width = DMA_SLAVE_BUSWIDTH_4_BYTES;
+	dma_sconfig.src_maxburst = maxburst;
+	ret = dmaengine_slave_config(tspi->rx_dma_chan, &dma_sconfig);
+	if (ret < 0) {
+		dev_err(tspi->dev, "DMA slave config failed: %d\n", ret);
+		goto exit_reset;
+	}
+	tspi->is_curr_dma_xfer = true;
+
+	hdr = ring->hdr;
+	WRITE_ONCE(hdr->head, 0);
+	WRITE_ONCE(hdr->tail, 0);
+	WRITE_ONCE(hdr->dropped, 0);
+	WRITE_ONCE(hdr->status, TEGRA_SPI_SLAVE_RING_ST_RUNNING);
+
+	ring->spi = spi;
+	ring->running = true;
+
+	spin_lock_irqsave(&tspi->lock, flags);
+	ring->stopping = false;
+	ring->armed = false;
+	ring->reserved = 0;
+	ring->head = 0;
+	ring->queued = 0;
+	ring->published = 0;
+	ring->hw_frames = 0;
+	ring->dma_frames = 0;
+	/* pre-arm the dma for the first frames and the controller */
+	tegra_spi_ring_advance(tspi);
+	spin_unlock_irqrestore(&tspi->lock, flags);
+
+	tegra_spi_ext_clk_enable(true, tspi);
+
+	if (hdr->status & TEGRA_SPI_SLAVE_RING_ST_ERROR) {
+		tegra_spi_ring_stop(tspi);
+		return -EIO;
+	}
+
+	/* Inform client that we are ready now. */
+	if (tspi->spi_slave_ready_callback)
+		tspi->spi_slave_ready_callback(tspi->client_data);
+
+	return 0;
+
+exit_reset:
+	tspi->is_curr_dma_xfer = false;
+	tspi->dma_control_reg = 0;
+	tspi->reset_ctrl_status = true;
+	reset_controller(tspi);
+exit_pm_put:
+	pm_runtime_put(tspi->dev);
+exit_inactive:
+	spin_lock_irqsave(&tspi->lock, flags);
+	ring->active = false;
+	spin_unlock_irqrestore(&tspi->lock, flags);
+exit_put_spi:
+	put_device(&spi->dev);
+	return ret;
+}
+
+static inline struct tegra_spi_data *
+tegra_spi_ring_to_tspi(struct tegra_spi_rx_ring *ring)
+{
+	return container_of(ring, struct tegra_spi_data, ring);
+}
+
+static int tegra_spi_ring_open(struct inode *inode, struct file *filp)
+{
+	struct tegra_spi_rx_ring *ring = container_of(filp->private_data,
+					struct tegra_spi_rx_ring, misc);
+	int ret = 0;
+
+	mutex_lock(&ring->lock);
+	if (!ring->registered)
+		ret = -ENODEV;
+	else if (ring->users)
+		ret = -EBUSY;
+	else
+		ring->users++;
+	mutex_unlock(&ring->lock);
+
+	filp->private_data = ring;
+
+	return ret;
+}
+
+static int tegra_spi_ring_release(struct inode *inode, struct file *filp)
+{
+	struct tegra_spi_rx_ring *ring = filp->private_data;
+	struct tegra_spi_data *tspi = tegra_spi_ring_to_tspi(ring);
+
+	/* all mappings are gone, they hold a reference on the file */
+	mutex_lock(&ring->lock);
+	tegra_spi_ring_stop(tspi);
+	tegra_spi_ring_free(tspi);
+	ring->users--;
+	mutex_unlock(&ring->lock);
+
+	return 0;
+}
+
+static long tegra_spi_ring_ioctl(struct file *filp, unsigned int cmd,
+		unsigned long arg)
+{
+	struct tegra_spi_rx_ring *ring = filp->private_data;
+	struct tegra_spi_data *tspi = tegra_spi_ring_to_tspi(ring);
+	struct tegra_spi_slave_ring_cfg cfg;
+	long ret;
+
+	switch (cmd) {
+	case TEGRA_SPI_SLAVE_RING_START:
+		if (copy_from_user(&cfg, (void __user *)arg, sizeof(cfg)))
+			return -EFAULT;
+
+		mutex_lock(&ring->lock);
+		ret = tegra_spi_ring_start(tspi, &cfg);
+		mutex_unlock(&ring->lock);
+		break;
+	case TEGRA_SPI_SLAVE_RING_STOP:
+		mutex_lock(&ring->lock);
+		tegra_spi_ring_stop(tspi);
+		mutex_unlock(&ring->lock);
+		ret = 0;
+		break;
+	default:
+		ret = -ENOTTY;
+		break;
+	}
+
+	return ret;
+}
+
+static int tegra_spi_ring_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct tegra_spi_rx_ring *ring = filp->private_data;
+	struct tegra_spi_data *tspi = tegra_spi_ring_to_tspi(ring);
+	unsigned long size = vma->vm_end - vma->vm_start;
+	int ret;
+
+	mutex_lock(&ring->lock);
+	if (!ring->buf)
+		ret = -ENODEV;
+	else if (vma->vm_pgoff || size > ring->map_size)
+		ret = -EINVAL;
+	else
+		ret = dma_mmap_coherent(tspi->dev, vma, ring->buf,
+					ring->buf_phys, ring->map_size);
+	mutex_unlock(&ring->lock);
+
+	return ret;
+}
+
+static __poll_t tegra_spi_ring_poll(struct file *filp, poll_table *wait)
+{
+	struct tegra_spi_rx_ring *ring = filp->private_data;
+	__poll_t mask = 0;
+
+	poll_wait(filp, &ring->wq, wait);
+
+	mutex_lock(&ring->lock);
+	if (ring->hdr) {
+		if (smp_load_acquire(&ring->hdr->head) !=
+				READ_ONCE(ring->hdr->tail))
+			mask |= EPOLLIN | EPOLLRDNORM;
+		if (READ_ONCE(ring->hdr->status) &
+				TEGRA_SPI_SLAVE_RING_ST_ERROR)
+			mask |= EPOLLERR;
+	}
+	mutex_unlock(&ring->lock);
+
+	return mask;
+}
+
+static const struct file_operations tegra_spi_ring_fops = {
+	.owner = THIS_MODULE,
+	.open = tegra_spi_ring_open,
+	.release = tegra_spi_ring_release,
+	.unlocked_ioctl = tegra_spi_ring_ioctl,
+	.compat_ioctl = tegra_spi_ring_ioctl,
+	.mmap = tegra_spi_ring_mmap,
+	.poll = tegra_spi_ring_poll,
+	.llseek = noop_llseek,
+};
+
+static int tegra_spi_ring_register(struct tegra_spi_data *tspi)
+{
+	struct tegra_spi_rx_ring *ring = &tspi->ring;
+	int ret;
+
+	mutex_init(&ring->lock);
+	init_waitqueue_head(&ring->wq);
+
+	snprintf(ring->name, sizeof(ring->name), "spi%d_rxring",
+		 tspi->controller->bus_num);
+	ring->misc.minor = MISC_DYNAMIC_MINOR;
+	ring->misc.name = ring->name;
+	ring->misc.fops = &tegra_spi_ring_fops;
+	ring->misc.parent = tspi->dev;
+
+	ret = misc_register(&ring->misc);
+	if (ret) {
+		dev_err(tspi->dev, "failed to register %s\n", ring->name);
+		return ret;
+	}
+	ring->registered = true;
+
+	return 0;
+}
+
+static void tegra_spi_ring_unregister(struct tegra_spi_data *tspi)
+{
+	struct tegra_spi_rx_ring *ring = &tspi->ring;
+
+	if (!ring->registered)
+		return;
+
+	misc_deregister(&ring->misc);
+
+	mutex_lock(&ring->lock);
+	ring->registered = false;
+	tegra_spi_ring_stop(tspi);
+	if (!ring->users)
+		tegra_spi_ring_free(tspi);
+	mutex_unlock(&ring->lock);
+}
+
 static irqreturn_t tegra_spi_isr(int irq, void *context_data)
 {
 	struct tegra_spi_data *tspi = context_data;
@@ -1867,6 +2593,9 @@ static irqreturn_t tegra_spi_isr(int irq, void *context_data)
 		return IRQ_NONE;
 	}
 
+	if (READ_ONCE(tspi->ring.active))
+		return tegra_spi_ring_isr(tspi, status_reg);
+
 #ifdef PROFILE_SPI_SLAVE
 	tspi->start_time = ktime_get();
 #endif
@@ -2147,17 +2876,23 @@ static int tegra_spi_probe(struct platform_device *pdev)
 		goto exit_pm_disable;
 	}
 
+	ret = tegra_spi_ring_register(tspi);
+	if (ret < 0)
+		goto exit_unregister_master;
+
 #ifdef TEGRA_SPI_SLAVE_DEBUG
 	ret = device_create_file(&pdev->dev, &dev_attr_force_unpacked_mode);
 	if (ret != 0)
-		goto exit_unregister_master;
-
+		goto exit_unregister_ring;
+#endif
 	return ret;
 
+#ifdef TEGRA_SPI_SLAVE_DEBUG
+exit_unregister_ring:
+	tegra_spi_ring_unregister(tspi);
+#endif
 exit_unregister_master:
 	spi_unregister_master(controller);
-
-#endif
 	return ret;
 
 exit_pm_disable:
@@ -2185,6 +2920,7 @@ static int tegra_spi_remove(struct platform_device *pdev)
 #ifdef TEGRA_SPI_SLAVE_DEBUG
 	device_remove_file(&pdev->dev, &dev_attr_force_unpacked_mode);
 #endif
+	tegra_spi_ring_unregister(tspi);
 	free_irq(tspi->irq, tspi);
 	spi_unregister_master(controller);
 
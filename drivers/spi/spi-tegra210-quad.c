@@ -22,6 +22,7 @@
 #include <linux/of_device.h>
 #include <linux/reset.h>
 #include <linux/spi/spi.h>
+#include <linux/spi/spi-mem.h>
 #include <linux/acpi.h>
 #include <linux/property.h>
 #include <linux/version.h>
@@ -465,12 +466,13 @@ tegra_qspi_read_rx_fifo_to_client_rxbuf(struct tegra_qspi *tqspi, struct spi_tra
 static void
 tegra_qspi_copy_client_txbuf_to_qspi_txbuf(struct tegra_qspi *tqspi, struct spi_transfer *t)
 {
-	dma_sync_single_for_cpu(tqspi->dev, tqspi->tx_dma_phys,
-				tqspi->dma_buf_size, DMA_TO_DEVICE);
+	u8 *tx_buf = (u8 *)t->tx_buf + tqspi->cur_tx_pos;
+	unsigned int i, count, consume, write_bytes;
 
 	/*
 	 * In packed mode, each word in FIFO may contain multiple packets
 	 * based on bits per word. So all bytes in each FIFO word are valid.
+	 * The client buffer is mapped for DMA directly, tx_dma_buf is unused.
 	 *
 	 * In unpacked mode, each word in FIFO contains single packet and
 	 * based on bits per word any remaining bits in FIFO word will be
@@ -478,29 +480,30 @@ tegra_qspi_copy_client_txbuf_to_qspi_txbuf(struct tegra_qspi *tqspi, struct spi_
 	 */
 	if (tqspi->is_packed) {
 		tqspi->cur_tx_pos += tqspi->curr_dma_words * tqspi->bytes_per_word;
-	} else {
-		u8 *tx_buf = (u8 *)t->tx_buf + tqspi->cur_tx_pos;
-		unsigned int i, count, consume, write_bytes;
-
-		/*
-		 * Fill tx_dma_buf to contain single packet in each word based
-		 * on bits per word from SPI core tx_buf.
-		 */
-		consume = tqspi->curr_dma_words * tqspi->bytes_per_word;
-		if (consume > t->len - tqspi->cur_pos)
-			consume = t->len - tqspi->cur_pos;
-		write_bytes = consume;
-		for (count = 0; count < tqspi->curr_dma_words; count++) {
-			u32 x = 0;
+		return;
+	}
 
-			for (i = 0; consume && (i < tqspi->bytes_per_word); i++, consume--)
-				x |= (u32)(*tx_buf++) << (i * 8);
-			tqspi->tx_dma_buf[count] = x;
-		}
+	dma_sync_single_for_cpu(tqspi->dev, tqspi->tx_dma_phys,
+				tqspi->dma_buf_size, DMA_TO_DEVICE);
 
-		tqspi->cur_tx_pos += write_bytes;
+	/*
+	 * Fill tx_dma_buf to contain single packet in each word based
+	 * on bits per word from SPI core tx_buf.
+	 */
+	consume = tqspi->curr_dma_words * tqspi->bytes_per_word;
+	if (consume > t->len - tqspi->cur_pos)
+		consume = t->len - tqspi->cur_pos;
+	write_bytes = consume;
+	for (count = 0; count < tqspi->curr_dma_words; count++) {
+		u32 x = 0;
+
+		for (i = 0; consume && (i < tqspi->bytes_per_word); i++, consume--)
+			x |= (u32)(*tx_buf++) << (i * 8);
+		tqspi->tx_dma_buf[count] = x;
 	}
 
+	tqspi->cur_tx_pos += write_bytes;
+
 	dma_sync_single_for_device(tqspi->dev, tqspi->tx_dma_phys,
 				   tqspi->dma_buf_size, DMA_TO_DEVICE);
 }
@@ -508,35 +511,37 @@ tegra_qspi_copy_client_txbuf_to_qspi_txbuf(struct tegra_qspi *tqspi, struct spi_
 static void
 tegra_qspi_copy_qspi_rxbuf_to_client_rxbuf(struct tegra_qspi *tqspi, struct spi_transfer *t)
 {
-	dma_sync_single_for_cpu(tqspi->dev, tqspi->rx_dma_phys,
-				tqspi->dma_buf_size, DMA_FROM_DEVICE);
+	unsigned char *rx_buf = t->rx_buf + tqspi->cur_rx_pos;
+	u32 rx_mask = ((u32)1 << t->bits_per_word) - 1;
+	unsigned int i, count, consume, read_bytes;
 
+	/* packed mode DMA goes straight into the mapped client buffer */
 	if (tqspi->is_packed) {
 		tqspi->cur_rx_pos += tqspi->curr_dma_words * tqspi->bytes_per_word;
-	} else {
-		unsigned char *rx_buf = t->rx_buf + tqspi->cur_rx_pos;
-		u32 rx_mask = ((u32)1 << t->bits_per_word) - 1;
-		unsigned int i, count, consume, read_bytes;
+		return;
+	}
 
-		/*
-		 * Each FIFO word contains single data packet.
-		 * Skip invalid bits in each FIFO word based on bits per word
-		 * and align bytes while filling in SPI core rx_buf.
-		 */
-		consume = tqspi->curr_dma_words * tqspi->bytes_per_word;
-		if (consume > t->len - tqspi->cur_pos)
-			consume = t->len - tqspi->cur_pos;
-		read_bytes = consume;
-		for (count = 0; count < tqspi->curr_dma_words; count++) {
-			u32 x = tqspi->rx_dma_buf[count] & rx_mask;
-
-			for (i = 0; consume && (i < tqspi->bytes_per_word); i++, consume--)
-				*rx_buf++ = (x >> (i * 8)) & 0xff;
-		}
+	dma_sync_single_for_cpu(tqspi->dev, tqspi->rx_dma_phys,
+				tqspi->dma_buf_size, DMA_FROM_DEVICE);
 
-		tqspi->cur_rx_pos += read_bytes;
+	/*
+	 * Each FIFO word contains single data packet.
+	 * Skip invalid bits in each FIFO word based on bits per word
+	 * and align bytes while filling in SPI core rx_buf.
+	 */
+	consume = tqspi->curr_dma_words * tqspi->bytes_per_word;
+	if (consume > t->len - tqspi->cur_pos)
+		consume = t->len - tqspi->cur_pos;
+	read_bytes = consume;
+	for (count = 0; count < tqspi->curr_dma_words; count++) {
+		u32 x = tqspi->rx_dma_buf[count] & rx_mask;
+
+		for (i = 0; consume && (i < tqspi->bytes_per_word); i++, consume--)
+			*rx_buf++ = (x >> (i * 8)) & 0xff;
 	}
 
+	tqspi->cur_rx_pos += read_bytes;
+
 	dma_sync_single_for_device(tqspi->dev, tqspi->rx_dma_phys,
 				   tqspi->dma_buf_size, DMA_FROM_DEVICE);
 }
@@ -764,9 +769,10 @@ static int tegra_qspi_start_dma_based_transfer(struct tegra_qspi *tqspi, struct
 			return ret;
 		}
 
-		dma_sync_single_for_device(tqspi->dev, tqspi->rx_dma_phys,
-					   tqspi->dma_buf_size,
-					   DMA_FROM_DEVICE);
+		if (!tqspi->is_packed)
+			dma_sync_single_for_device(tqspi->dev, tqspi->rx_dma_phys,
+						   tqspi->dma_buf_size,
+						   DMA_FROM_DEVICE);
 
 		ret = tegra_qspi_start_rx_dma(tqspi, t, len);
 		if (ret < 0) {
@@ -1229,6 +1235,8 @@ static int tegra_qspi_combined_seq_xfer(struct tegra_qspi *tqspi,
 	val = tegra_qspi_readl(tqspi, QSPI_GLOBAL_CONFIG);
 	val |= QSPI_CMB_SEQ_EN;
 	tegra_qspi_writel(tqspi, val, QSPI_GLOBAL_CONFIG);
+	/* a sequence without dummy transfer must not inherit the last count */
+	tqspi->dummy_cycles = 0;
 	/* Process individual transfer list */
 	list_for_each_entry(xfer, &msg->transfers, transfer_list) {
 		switch (transfer_phase) {
@@ -1505,6 +1513,146 @@ static int tegra_qspi_transfer_one_message(struct spi_master *master,
 	return ret;
 }
 
+/*
+ * Reads that match the combined sequence shape are issued as one hardware
+ * sequence of command, address, dummy cycles and data, up to max_buf_size
+ * of data, with the data DMA'd straight into the caller's buffer.
+ */
+static bool tegra_qspi_mem_cmb_op(struct tegra_qspi *tqspi, const struct spi_mem_op *op)
+{
+	if (!tqspi->soc_data->cmb_xfer_capable)
+		return false;
+
+	if (op->data.dir != SPI_MEM_DATA_IN || op->cmd.dtr || op->addr.dtr ||
+	    op->dummy.dtr || op->data.dtr)
+		return false;
+
+	if (!op->cmd.nbytes || op->cmd.nbytes > 2)
+		return false;
+
+	if (op->addr.nbytes < 3 || op->addr.nbytes > 4)
+		return false;
+
+	if (op->dummy.nbytes &&
+	    (op->dummy.nbytes * 8 / op->dummy.buswidth) > QSPI_DUMMY_CYCLES_MAX)
+		return false;
+
+	return true;
+}
+
+static int tegra_qspi_mem_cmb_read(struct tegra_qspi *tqspi, struct spi_device *spi,
+				   const struct spi_mem_op *op, u64 addr,
+				   size_t len, void *buf)
+{
+	struct spi_transfer xfers[4] = { };
+	struct spi_message msg;
+	u8 cmd_buf[2], addr_buf[4] = { };
+	int i, n = 0;
+
+	for (i = 0; i < op->cmd.nbytes; i++)
+		cmd_buf[i] = op->cmd.opcode >> (8 * (op->cmd.nbytes - i - 1));
+	xfers[n].tx_buf = cmd_buf;
+	xfers[n].len = op->cmd.nbytes;
+	xfers[n].tx_nbits = op->cmd.buswidth;
+	n++;
+
+	for (i = 0; i < op->addr.nbytes; i++)
+		addr_buf[i] = addr >> (8 * (op->addr.nbytes - i - 1));
+	xfers[n].tx_buf = addr_buf;
+	xfers[n].len = op->addr.nbytes;
+	xfers[n].tx_nbits = op->addr.buswidth;
+	n++;
+
+	/* only the length matters, the controller generates the clocks */
+	if (op->dummy.nbytes) {
+		xfers[n].len = op->dummy.nbytes;
+		xfers[n].tx_nbits = op->dummy.buswidth;
+		xfers[n].dummy_data = 1;
+		n++;
+	}
+
+	xfers[n].rx_buf = buf;
+	xfers[n].len = len;
+	xfers[n].rx_nbits = op->data.buswidth;
+	n++;
+
+	for (i = 0; i < n; i++) {
+		xfers[i].speed_hz = spi->max_speed_hz;
+		xfers[i].bits_per_word = 8;
+	}
+
+	spi_message_init_with_transfers(&msg, xfers, n);
+	msg.spi = spi;
+
+	tqspi->tx_status = 0;
+	tqspi->rx_status = 0;
+
+	return tegra_qspi_combined_seq_xfer(tqspi, &msg);
+}
+
+static int tegra_qspi_mem_adjust_op_size(struct spi_mem *mem, struct spi_mem_op *op)
+{
+	struct tegra_qspi *tqspi = spi_master_get_devdata(mem->spi->master);
+
+	/*
+	 * Split long reads so that every piece still fits one combined
+	 * sequence, instead of falling back to separate transfers.
+	 */
+	if (tegra_qspi_mem_cmb_op(tqspi, op))
+		op->data.nbytes = min_t(unsigned int, op->data.nbytes,
+					tqspi->max_buf_size);
+
+	return 0;
+}
+
+static int tegra_qspi_mem_exec_op(struct spi_mem *mem, const struct spi_mem_op *op)
+{
+	struct tegra_qspi *tqspi = spi_master_get_devdata(mem->spi->master);
+
+	/* everything else goes through transfer_one_message */
+	if (!tegra_qspi_mem_cmb_op(tqspi, op) || !op->data.nbytes ||
+	    op->data.nbytes > tqspi->max_buf_size)
+		return -EOPNOTSUPP;
+
+	return tegra_qspi_mem_cmb_read(tqspi, mem->spi, op, op->addr.val,
+				       op->data.nbytes, op->data.buf.in);
+}
+
+static int tegra_qspi_mem_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	struct tegra_qspi *tqspi = spi_master_get_devdata(desc->mem->spi->master);
+
+	/* spi-mem falls back to exec_op based reads and writes */
+	if (!tegra_qspi_mem_cmb_op(tqspi, &desc->info.op_tmpl))
+		return -EOPNOTSUPP;
+
+	return 0;
+}
+
+static ssize_t tegra_qspi_mem_dirmap_read(struct spi_mem_dirmap_desc *desc,
+					  u64 offs, size_t len, void *buf)
+{
+	struct spi_device *spi = desc->mem->spi;
+	struct tegra_qspi *tqspi = spi_master_get_devdata(spi->master);
+	int ret;
+
+	len = min_t(size_t, len, tqspi->max_buf_size);
+
+	ret = tegra_qspi_mem_cmb_read(tqspi, spi, &desc->info.op_tmpl,
+				      desc->info.offset + offs, len, buf);
+	if (ret < 0)
+		return ret;
+
+	return len;
+}
+
+static const struct spi_controller_mem_ops tegra_qspi_mem_ops = {
+	.adjust_op_size = tegra_qspi_mem_adjust_op_size,
+	.exec_op = tegra_qspi_mem_exec_op,
+	.dirmap_create = tegra_qspi_mem_dirmap_create,
+	.dirmap_read = tegra_qspi_mem_dirmap_read,
+};
+
 static irqreturn_t handle_cpu_based_xfer(struct tegra_qspi *tqspi)
 {
 	struct spi_transfer *t = tqspi->curr_xfer;
@@ -1732,6 +1880,7 @@ static int tegra_qspi_probe(struct platform_device *pdev)
 	master->bits_per_word_mask = SPI_BPW_MASK(32) | SPI_BPW_MASK(16) | SPI_BPW_MASK(8);
 	master->setup = tegra_qspi_setup;
 	master->transfer_one_message = tegra_qspi_transfer_one_message;
+	master->mem_ops = &tegra_qspi_mem_ops;
 	master->num_chipselect = 1;
 	master->auto_runtime_pm = true;
 
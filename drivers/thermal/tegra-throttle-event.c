@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/notifier.h>
+#include <linux/platform/tegra/throttle-event.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+
+static BLOCKING_NOTIFIER_HEAD(tegra_throttle_event_chain_head);
+static DEFINE_SPINLOCK(tegra_throttle_event_lock);
+static DEFINE_MUTEX(tegra_throttle_event_notify_lock);
+static unsigned int tegra_throttle_event_cnt;
+static bool tegra_throttle_event_notified;
+
+/*
+ * The sources report from thermal framework callbacks and BPMP polling, so
+ * the clients, which end up changing clock rates, are called from a work
+ * item and only on a change of the aggregated state.
+ */
+static void tegra_throttle_event_work_fn(struct work_struct *work)
+{
+	bool active;
+
+	mutex_lock(&tegra_throttle_event_notify_lock);
+
+	active = READ_ONCE(tegra_throttle_event_cnt) > 0;
+	if (active != tegra_throttle_event_notified) {
+		WRITE_ONCE(tegra_throttle_event_notified, active);
+		blocking_notifier_call_chain(&tegra_throttle_event_chain_head,
+					     active ? TEGRA_THROTTLE_EVENT_ACTIVE :
+						      TEGRA_THROTTLE_EVENT_INACTIVE,
+					     NULL);
+	}
+
+	mutex_unlock(&tegra_throttle_event_notify_lock);
+}
+
+static DECLARE_WORK(tegra_throttle_event_work, tegra_throttle_event_work_fn);
+
+/* Clients register for notification of throttle events */
+int tegra_throttle_event_register_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_register(&tegra_throttle_event_chain_head, nb);
+}
+EXPORT_SYMBOL(tegra_throttle_event_register_notifier);
+
+/* Clients unregister for notification of throttle events */
+int tegra_throttle_event_unregister_notifier(struct notifier_block *nb)
+{
+	return blocking_notifier_chain_unregister(&tegra_throttle_event_chain_head, nb);
+}
+EXPORT_SYMBOL(tegra_throttle_event_unregister_notifier);
+
+bool tegra_throttle_event_is_active(void)
+{
+	return READ_ONCE(tegra_throttle_event_notified);
+}
+EXPORT_SYMBOL(tegra_throttle_event_is_active);
+
+void tegra_throttle_event_get(void)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&tegra_throttle_event_lock, flags);
+	if (tegra_throttle_event_cnt++ == 0)
+		queue_work(system_highpri_wq, &tegra_throttle_event_work);
+	spin_unlock_irqrestore(&tegra_throttle_event_lock, flags);
+}
+EXPORT_SYMBOL(tegra_throttle_event_get);
+
+void tegra_throttle_event_put(void)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&tegra_throttle_event_lock, flags);
+	if (!WARN_ON(tegra_throttle_event_cnt == 0) &&
+	    --tegra_throttle_event_cnt == 0)
+		queue_work(system_highpri_wq, &tegra_throttle_event_work);
+	spin_unlock_irqrestore(&tegra_throttle_event_lock, flags);
+}
+EXPORT_SYMBOL(tegra_throttle_event_put);
+
+static void __exit tegra_throttle_event_exit(void)
+{
+	cancel_work_sync(&tegra_throttle_event_work);
+}
+module_exit(tegra_throttle_event_exit);
+
+MODULE_DESCRIPTION("NVIDIA Tegra thermal trip and overcurrent event notifier");
+MODULE_LICENSE("GPL v2");
@@ -8,7 +8,9 @@
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
+#include <linux/platform/tegra/throttle-event.h>
 #include <linux/sysfs.h>
+#include <linux/workqueue.h>
 #include <soc/tegra/bpmp-abi.h>
 #include <soc/tegra/bpmp.h>
 
@@ -16,12 +18,92 @@ struct oc_soc_data {
 	const struct attribute_group **attr_groups;
 };
 
+/*
+ * OC events are throttled by hardware right away. Polling the event counters
+ * lets the in-kernel DVFS clients cap their boost targets for a while after
+ * an event, so that the following ones and the throttling they cause become
+ * less likely.
+ */
+static unsigned int oc_poll_ms = 100;
+module_param(oc_poll_ms, uint, 0444);
+MODULE_PARM_DESC(oc_poll_ms, "OC event counter polling period in ms, 0 to disable");
+
+static unsigned int oc_hold_ms = 1000;
+module_param(oc_hold_ms, uint, 0644);
+MODULE_PARM_DESC(oc_hold_ms, "Time in ms the throttle event stays active after an OC event");
+
 struct tegra234_oc_event {
 	struct device *hwmon;
 	struct tegra_bpmp *bpmp;
 	const struct oc_soc_data *soc_data;
+	struct delayed_work poll_work;
+	u64 event_cnt;
+	unsigned long last_event;
+	bool throttle_active;
 };
 
+static int tegra234_oc_get_status(struct tegra234_oc_event *tegra234_oc,
+				  struct mrq_oc_status_response *resp)
+{
+	struct tegra_bpmp_message msg = {
+		.mrq = MRQ_OC_STATUS,
+		.rx = {
+			.data = resp,
+			.size = sizeof(*resp),
+		},
+	};
+	int err;
+
+	err = tegra_bpmp_transfer(tegra234_oc->bpmp, &msg);
+	if (err)
+		return err;
+
+	if (msg.rx.ret < 0)
+		return -EINVAL;
+
+	return 0;
+}
+
+static u64 tegra234_oc_event_sum(const struct mrq_oc_status_response *resp)
+{
+	u64 sum = 0;
+	int i;
+
+	for (i = 0; i < OC_STATUS_MAX_SIZE; i++)
+		sum += resp->event_cnt[i];
+
+	return sum;
+}
+
+static void tegra234_oc_poll_work_fn(struct work_struct *work)
+{
+	struct tegra234_oc_event *tegra234_oc = container_of(to_delayed_work(work),
+							     struct tegra234_oc_event,
+							     poll_work);
+	struct mrq_oc_status_response resp;
+	u64 cnt;
+
+	if (!tegra234_oc_get_status(tegra234_oc, &resp)) {
+		cnt = tegra234_oc_event_sum(&resp);
+		if (cnt != tegra234_oc->event_cnt) {
+			tegra234_oc->event_cnt = cnt;
+			tegra234_oc->last_event = jiffies;
+			if (!tegra234_oc->throttle_active) {
+				tegra234_oc->throttle_active = true;
+				tegra_throttle_event_get();
+			}
+		} else if (tegra234_oc->throttle_active &&
+			   time_after(jiffies, tegra234_oc->last_event +
+					       msecs_to_jiffies(oc_hold_ms))) {
+			tegra234_oc->throttle_active = false;
+			tegra_throttle_event_put();
+		}
+	}
+
+	queue_delayed_work(system_power_efficient_wq, &tegra234_oc->poll_work,
+			   msecs_to_jiffies(oc_poll_ms));
+}
+
 static ssize_t throt_en_show(struct device *dev, struct device_attribute *attr,
 			     char *buf)
 {
@@ -188,6 +270,17 @@ static int tegra234_oc_event_probe(struct platform_device *pdev)
 		goto put_bpmp;
 	}
 
+	INIT_DELAYED_WORK(&tegra234_oc->poll_work, tegra234_oc_poll_work_fn);
+	if (oc_poll_ms) {
+		struct mrq_oc_status_response resp;
+
+		if (!tegra234_oc_get_status(tegra234_oc, &resp))
+			tegra234_oc->event_cnt = tegra234_oc_event_sum(&resp);
+
+		queue_delayed_work(system_power_efficient_wq, &tegra234_oc->poll_work,
+				   msecs_to_jiffies(oc_poll_ms));
+	}
+
 	return err;
 
 put_bpmp:
@@ -203,6 +296,10 @@ static int tegra234_oc_event_remove(struct platform_device *pdev)
 	if (!tegra234_oc)
 		return -EINVAL;
 
+	cancel_delayed_work_sync(&tegra234_oc->poll_work);
+	if (tegra234_oc->throttle_active)
+		tegra_throttle_event_put();
+
 	tegra_bpmp_put(tegra234_oc->bpmp);
 	return 0;
 }
@@ -4,6 +4,7 @@
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
+#include <linux/platform/tegra/throttle-event.h>
 #include <linux/thermal.h>
 #include <linux/wait.h>
 
@@ -64,6 +65,11 @@ static int tte_cdev_set_cur_state(struct thermal_cooling_device *tcd,
 	 * driver removal.
 	 */
 	mutex_lock(&tte->cur_state_lock);
+	/* let the in-kernel DVFS clients back off before hardware throttling */
+	if (tte->cur_state == CDEV_INACTIVE)
+		tegra_throttle_event_get();
+	else if (state == CDEV_INACTIVE)
+		tegra_throttle_event_put();
 	tte->cur_state = state;
 	mutex_unlock(&tte->cur_state_lock);
 
@@ -214,6 +220,8 @@ static int thermal_trip_event_remove(struct platform_device *pdev)
 	 * cooling device is going to be destroyed soon.
 	 */
 	mutex_lock(&tte->cur_state_lock);
+	if (tte->cur_state != CDEV_INACTIVE)
+		tegra_throttle_event_put();
 	tte->cur_state = CDEV_DESTROY;
 	mutex_unlock(&tte->cur_state_lock);
 
@@ -700,6 +700,7 @@ struct wch_ser_port {
     unsigned char mcr_mask;
     unsigned char mcr_force;
     unsigned char lsr_break_flag;
+    int rx_level;
 };
 
 /*-------------------------------------------------------------------------------
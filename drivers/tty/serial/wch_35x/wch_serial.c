@@ -215,7 +215,9 @@ static unsigned char READ_UART_RX(struct wch_ser_port *sp)
 static unsigned char READ_UART_RX_BUFFER(struct wch_ser_port *sp, unsigned char *buf, int count)
 {
     if (sp->port.iobase) {
-        {
+        if (ch365_32s) {
+            readsb(sp->port.port_membase + UART_RX, buf, count);
+        } else {
             insb(sp->port.iobase + UART_RX, buf, count);
         }
     }
@@ -897,7 +899,8 @@ check_and_exit:
     }
 
     if (state->info->flags & WCH_UIF_INITIALIZED) {
-        if (((old_flags ^ port->flags) & WCH_UPF_SPD_MASK) || old_custom_divisor != port->custom_divisor) {
+        if (((old_flags ^ port->flags) & (WCH_UPF_SPD_MASK | WCH_UPF_LOW_LATENCY)) ||
+            old_custom_divisor != port->custom_divisor) {
             if (port->flags & WCH_UPF_SPD_MASK) {
                 printk("WCH Info : %s sets custom speed on ttyWCH%d. This is deprecated.\n", current->comm, port->line);
             }
@@ -1969,6 +1972,23 @@ static unsigned int wch_ser_get_divisor(struct ser_port *port, unsigned int baud
     return quot;
 }
 
+/*
+ * FCR receive trigger bits for a trigger level of the port fifo. The four
+ * levels of every chip are 1, a small one, fifosize / 2 and 7/8 of the fifo.
+ */
+static unsigned char wch_ser_trigger_fcr(struct ser_port *port, int level)
+{
+    if (level <= 1) {
+        return UART_TRIGGER00_FCR;
+    } else if (level >= port->fifosize * 7 / 8) {
+        return UART_TRIGGER11_FCR;
+    } else if (level >= port->fifosize / 2) {
+        return UART_TRIGGER10_FCR;
+    }
+
+    return UART_TRIGGER01_FCR;
+}
+
 #if defined(NV_TTY_OPERATIONS_STRUCT_SET_TERMIOS_HAS_CONST_KTERMIOS_ARG) /* Linux 6.1 */
 static void wch_ser_set_termios(struct ser_port *port, struct WCHTERMIOS *termios, const struct WCHTERMIOS *old)
 #else
@@ -2043,8 +2063,15 @@ static void wch_ser_set_termios(struct ser_port *port, struct WCHTERMIOS *termio
         sp->ier &= ~(1 << 5);
     }
 
+    /*
+     * Interrupt at the trigger level of the chip, or on every byte for
+     * ports set to low_latency with setserial.
+     */
     if (sp->capabilities & UART_USE_FIFO) {
-        fcr = UART_FCR_ENABLE_FIFO | UART_FCR_R_TRIG_10;
+        sp->rx_level = (port->flags & WCH_UPF_LOW_LATENCY) ? 1 : port->rx_trigger;
+        fcr = UART_FCR_ENABLE_FIFO | wch_ser_trigger_fcr(port, sp->rx_level);
+    } else {
+        sp->rx_level = 1;
     }
 
     sp->mcr &= ~UART_MCR_AFE;
@@ -2150,11 +2177,30 @@ static _INLINE_ void ser_receive_chars(struct wch_ser_port *sp, unsigned char *s
 
     do {
         if (iir == UART_IIR_RDI) {
-            READ_UART_RX_BUFFER(sp, rbuf, sp->port.rx_trigger);
-            sp->port.icount.rx += sp->port.rx_trigger;
-            count = sp->port.rx_trigger;
+            READ_UART_RX_BUFFER(sp, rbuf, sp->rx_level);
+            sp->port.icount.rx += sp->rx_level;
+            count = sp->rx_level;
             readcont = 1;
             iir = 0;
+        } else if (!(lsr & (UART_LSR_BI | UART_LSR_PE | UART_LSR_FE | UART_LSR_OE)) && !I_IXOFF(tty) && !I_IXON(tty)) {
+            /*
+             * Drain the error free bytes left below the trigger level into
+             * rbuf and hand them to the tty layer in one go.
+             */
+            count = 0;
+            do {
+                rbuf[count++] = READ_UART_RX(sp);
+                lsr = READ_UART_LSR(sp);
+                if (lsr == 0xff) {
+                    lsr = 0x01;
+                }
+            } while ((lsr & UART_LSR_DR) && !(lsr & (UART_LSR_BI | UART_LSR_PE | UART_LSR_FE | UART_LSR_OE)) &&
+                     (count < sizeof(rbuf)));
+
+            sp->port.icount.rx += count;
+            ser_insert_buffer(&sp->port, 0, UART_LSR_OE, rbuf, count, TTY_NORMAL);
+            max_count -= count;
+            continue;
         } else {
             ch = READ_UART_RX(sp);
             sp->port.icount.rx++;
@@ -2252,7 +2298,8 @@ static _INLINE_ void ser_transmit_chars(struct wch_ser_port *sp)
         return;
     }
 
-    count = sp->port.fifosize / 2;
+    /* THRI is raised on an empty tx fifo, so refill all of it. */
+    count = sp->port.fifosize;
 
     do {
         WRITE_UART_TX(sp, xmit->buf[xmit->tail]);
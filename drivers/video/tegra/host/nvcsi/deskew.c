@@ -8,6 +8,7 @@
 #include "deskew.h"
 
 #include <linux/mutex.h>
+#include <linux/debugfs.h>
 #include <linux/device.h>
 #include <linux/export.h>
 #include <linux/module.h>
@@ -23,6 +24,7 @@
 #include <linux/uaccess.h>
 #include <linux/regulator/consumer.h>
 #include <linux/slab.h>
+#include <linux/seq_file.h>
 #include <linux/nvhost.h>
 
 #include <media/mc_common.h>
@@ -40,6 +42,33 @@ static int debugfs_deskew_data_stats_high[NVCSI_PHY_CIL_NUM_LANE];
 static unsigned int enabled_deskew_lanes;
 static unsigned int done_deskew_lanes;
 
+/*
+ * Trimmer settings of a successful calibration, keyed by the lanes and the
+ * data rate they were calibrated at. An entry is reused by later stream
+ * starts until it expires, a calibration or apply error on its lanes
+ * drops it, or debugfs deskew/recalibrate flushes the cache.
+ */
+struct nvcsi_deskew_cache_entry {
+	unsigned int lanes;
+	u64 data_rate;
+	unsigned long stamp;
+	u32 cila_inadj[DESKEW_NUM_PHY];
+	u32 cilb_inadj[DESKEW_NUM_PHY];
+};
+
+static struct nvcsi_deskew_cache_entry deskew_cache[DESKEW_CACHE_ENTRIES];
+static bool deskew_cache_enable = true;
+static u32 deskew_cache_max_age_ms = DESKEW_CACHE_MAX_AGE_MSEC;
+
+static struct nvcsi_deskew_cache_stats {
+	u64 hits;
+	u64 misses;
+	u64 calibrations;
+	u64 calib_errors;
+	u64 invalidations;
+	u64 expired;
+} deskew_cache_stats;
+
 static int nvcsi_deskew_apply_helper(unsigned int active_lanes);
 
 static bool is_t19x_or_greater;
@@ -85,6 +114,75 @@ static const uint32_t t194_regs[REGS_COUNT] = {
 0x8c,		//< NVCSI_CIL_B_OFFSET				regs[35]
 };
 
+static int nvcsi_deskew_cache_show(struct seq_file *s, void *data)
+{
+	struct nvcsi_deskew_cache_entry *entry;
+	unsigned int i;
+
+	mutex_lock(&deskew_lock);
+	seq_printf(s, "hits %llu misses %llu calibrations %llu calib_errors %llu\n",
+		   deskew_cache_stats.hits, deskew_cache_stats.misses,
+		   deskew_cache_stats.calibrations,
+		   deskew_cache_stats.calib_errors);
+	seq_printf(s, "invalidations %llu expired %llu\n",
+		   deskew_cache_stats.invalidations,
+		   deskew_cache_stats.expired);
+	for (i = 0; i < DESKEW_CACHE_ENTRIES; i++) {
+		entry = &deskew_cache[i];
+		if (!entry->lanes)
+			continue;
+		seq_printf(s, "lanes 0x%04x rate %llu age %u ms\n",
+			   entry->lanes, entry->data_rate,
+			   jiffies_to_msecs(jiffies - entry->stamp));
+	}
+	mutex_unlock(&deskew_lock);
+
+	return 0;
+}
+
+static int nvcsi_deskew_cache_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvcsi_deskew_cache_show, inode->i_private);
+}
+
+static const struct file_operations nvcsi_deskew_cache_fops = {
+	.open = nvcsi_deskew_cache_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static ssize_t nvcsi_deskew_recalibrate_write(struct file *file,
+		const char __user *buf, size_t count, loff_t *ppos)
+{
+	nvcsi_deskew_invalidate(~0U);
+
+	return count;
+}
+
+static const struct file_operations nvcsi_deskew_recalibrate_fops = {
+	.open = simple_open,
+	.write = nvcsi_deskew_recalibrate_write,
+	.llseek = noop_llseek,
+};
+
+static void nvcsi_deskew_debugfs_init(struct dentry *parent)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("deskew", parent);
+	if (IS_ERR_OR_NULL(dir))
+		return;
+
+	debugfs_create_file("cache", 0444, dir, NULL,
+			    &nvcsi_deskew_cache_fops);
+	debugfs_create_file("recalibrate", 0200, dir, NULL,
+			    &nvcsi_deskew_recalibrate_fops);
+	debugfs_create_bool("cache_enable", 0644, dir, &deskew_cache_enable);
+	debugfs_create_u32("cache_max_age_ms", 0644, dir,
+			   &deskew_cache_max_age_ms);
+}
+
 void nvcsi_deskew_platform_setup(struct tegra_csi_device *dev, bool t19x)
 {
 	int i;
@@ -97,6 +195,10 @@ void nvcsi_deskew_platform_setup(struct tegra_csi_device *dev, bool t19x)
 	if (is_t19x_or_greater)
 		for (i = 0; i < REGS_COUNT; ++i)
 			regs[i] = t194_regs[i];
+	memset(deskew_cache, 0, sizeof(deskew_cache));
+	memset(&deskew_cache_stats, 0, sizeof(deskew_cache_stats));
+	if (dev->debugdir)
+		nvcsi_deskew_debugfs_init(dev->debugdir);
 }
 
 static inline void set_enabled_with_lock(unsigned int active_lanes)
@@ -147,6 +249,150 @@ static inline unsigned int nvcsi_phy_readl(unsigned int phy_num,
 	return val;
 }
 
+/* called with deskew_lock held */
+static void nvcsi_deskew_cache_drop(unsigned int lanes)
+{
+	unsigned int i;
+
+	for (i = 0; i < DESKEW_CACHE_ENTRIES; i++) {
+		if (!(deskew_cache[i].lanes & lanes))
+			continue;
+		deskew_cache[i].lanes = 0;
+		deskew_cache_stats.invalidations++;
+	}
+}
+
+/* called with deskew_lock held */
+static struct nvcsi_deskew_cache_entry *nvcsi_deskew_cache_find(
+	unsigned int lanes, u64 data_rate)
+{
+	struct nvcsi_deskew_cache_entry *entry;
+	unsigned int i;
+
+	for (i = 0; i < DESKEW_CACHE_ENTRIES; i++) {
+		entry = &deskew_cache[i];
+		if (entry->lanes != lanes || entry->data_rate != data_rate)
+			continue;
+
+		/* the eye drifts with temperature, recalibrate now and then */
+		if (deskew_cache_max_age_ms &&
+		    time_after(jiffies, entry->stamp +
+				msecs_to_jiffies(deskew_cache_max_age_ms))) {
+			entry->lanes = 0;
+			deskew_cache_stats.expired++;
+			return NULL;
+		}
+		return entry;
+	}
+
+	return NULL;
+}
+
+static void nvcsi_deskew_cache_store(unsigned int lanes, u64 data_rate)
+{
+	struct nvcsi_deskew_cache_entry *entry = NULL;
+	unsigned int cil_lanes;
+	unsigned int phy_num;
+	unsigned int i;
+
+	if (!deskew_cache_enable || !data_rate)
+		return;
+
+	mutex_lock(&deskew_lock);
+	/* replace the results of any overlapping lanes, else the oldest */
+	nvcsi_deskew_cache_drop(lanes);
+	for (i = 0; i < DESKEW_CACHE_ENTRIES; i++) {
+		if (!deskew_cache[i].lanes) {
+			entry = &deskew_cache[i];
+			break;
+		}
+		if (!entry || time_before(deskew_cache[i].stamp, entry->stamp))
+			entry = &deskew_cache[i];
+	}
+
+	for (phy_num = 0; phy_num < DESKEW_NUM_PHY; phy_num++) {
+		cil_lanes = (lanes >> (phy_num * 4)) & 0xf;
+		entry->cila_inadj[phy_num] = 0;
+		entry->cilb_inadj[phy_num] = 0;
+		if (cil_lanes & (NVCSI_PHY_0_NVCSI_CIL_A_IO0 |
+				 NVCSI_PHY_0_NVCSI_CIL_A_IO1))
+			entry->cila_inadj[phy_num] = nvcsi_phy_readl(phy_num,
+				NVCSI_CIL_A_DPHY_INADJ_CTRL_0_OFFSET);
+		if (cil_lanes & (NVCSI_PHY_0_NVCSI_CIL_B_IO0 |
+				 NVCSI_PHY_0_NVCSI_CIL_B_IO1))
+			entry->cilb_inadj[phy_num] = nvcsi_phy_readl(phy_num,
+				NVCSI_CIL_B_DPHY_INADJ_CTRL_0_OFFSET);
+	}
+	entry->lanes = lanes;
+	entry->data_rate = data_rate;
+	entry->stamp = jiffies;
+	mutex_unlock(&deskew_lock);
+}
+
+/*
+ * Programs the cached trimmers of ctx->deskew_lanes, if any, in place of a
+ * calibration sweep. Returns true when the lanes are done.
+ */
+static bool nvcsi_deskew_cache_apply(struct nvcsi_deskew_context *ctx)
+{
+	struct nvcsi_deskew_cache_entry *entry;
+	unsigned int cil_lanes;
+	unsigned int phy_num;
+
+	if (!deskew_cache_enable || !ctx->data_rate)
+		return false;
+
+	mutex_lock(&deskew_lock);
+	/* another context is calibrating some of these lanes */
+	if (ctx->deskew_lanes & enabled_deskew_lanes) {
+		mutex_unlock(&deskew_lock);
+		return false;
+	}
+
+	entry = nvcsi_deskew_cache_find(ctx->deskew_lanes, ctx->data_rate);
+	if (!entry) {
+		deskew_cache_stats.misses++;
+		mutex_unlock(&deskew_lock);
+		return false;
+	}
+
+	for (phy_num = 0; phy_num < DESKEW_NUM_PHY; phy_num++) {
+		cil_lanes = (entry->lanes >> (phy_num * 4)) & 0xf;
+		if (cil_lanes & (NVCSI_PHY_0_NVCSI_CIL_A_IO0 |
+				 NVCSI_PHY_0_NVCSI_CIL_A_IO1))
+			nvcsi_phy_write(phy_num,
+				NVCSI_CIL_A_DPHY_INADJ_CTRL_0_OFFSET,
+				entry->cila_inadj[phy_num]);
+		if (cil_lanes & (NVCSI_PHY_0_NVCSI_CIL_B_IO0 |
+				 NVCSI_PHY_0_NVCSI_CIL_B_IO1))
+			nvcsi_phy_write(phy_num,
+				NVCSI_CIL_B_DPHY_INADJ_CTRL_0_OFFSET,
+				entry->cilb_inadj[phy_num]);
+	}
+
+	done_deskew_lanes |= ctx->deskew_lanes;
+	deskew_cache_stats.hits++;
+	mutex_unlock(&deskew_lock);
+
+	dev_dbg(mc_csi->dev, "deskew cached for lanes 0x%04x\n",
+		ctx->deskew_lanes);
+
+	return true;
+}
+
+/**
+ * nvcsi_deskew_invalidate - Drops the cached calibration of lanes.
+ *
+ * @lanes : lane mask, the next stream start on them recalibrates.
+ */
+void nvcsi_deskew_invalidate(unsigned int lanes)
+{
+	mutex_lock(&deskew_lock);
+	nvcsi_deskew_cache_drop(lanes);
+	mutex_unlock(&deskew_lock);
+}
+EXPORT_SYMBOL(nvcsi_deskew_invalidate);
+
 static void nvcsi_deskew_setup_start(unsigned int active_lanes)
 {
 	unsigned int phy_num = 0;
@@ -371,6 +617,7 @@ static int nvcsi_deskew_thread(void *data)
 	if (!ret) {
 		dev_info(mc_csi->dev, "deskew finished for lanes 0x%04x",
 							ctx->deskew_lanes);
+		nvcsi_deskew_cache_store(ctx->deskew_lanes, ctx->data_rate);
 		set_done_with_lock(ctx->deskew_lanes);
 	} else {
 		dev_info(mc_csi->dev,
@@ -390,6 +637,10 @@ err:
 	else if (ret == -EINVAL)
 		dev_info(mc_csi->dev, "deskew calib err for lanes 0x%04x",
 					ctx->deskew_lanes);
+	mutex_lock(&deskew_lock);
+	deskew_cache_stats.calib_errors++;
+	nvcsi_deskew_cache_drop(ctx->deskew_lanes);
+	mutex_unlock(&deskew_lock);
 	unset_enabled_with_lock(ctx->deskew_lanes);
 	complete(&ctx->thread_done);
 
@@ -414,8 +665,18 @@ int nvcsi_deskew_setup(struct nvcsi_deskew_context *ctx)
 	done_deskew_lanes &= ~(ctx->deskew_lanes);
 	mutex_unlock(&deskew_lock);
 
+	ctx->cached = nvcsi_deskew_cache_apply(ctx);
+	if (ctx->cached) {
+		init_completion(&ctx->thread_done);
+		complete(&ctx->thread_done);
+		return 0;
+	}
+
 	new_lanes = ctx->deskew_lanes & ~enabled_deskew_lanes;
 	if (new_lanes) {
+		mutex_lock(&deskew_lock);
+		deskew_cache_stats.calibrations++;
+		mutex_unlock(&deskew_lock);
 		set_enabled_with_lock(new_lanes);
 		nvcsi_deskew_setup_start(new_lanes);
 		init_completion(&ctx->thread_done);
@@ -660,6 +921,9 @@ int nvcsi_deskew_apply_check(struct nvcsi_deskew_context *ctx)
 		return -ETIMEDOUT;
 	if (ctx->deskew_lanes ==
 			(done_deskew_lanes & ctx->deskew_lanes)) {
+		// cached trimmers are set before streaming starts
+		if (ctx->cached)
+			return 0;
 		// sleep for a frame to make sure deskew result is reflected
 		usleep_range(35*1000, 36*1000);
 		return 0;
@@ -132,8 +132,19 @@
 
 #define DESKEW_TIMEOUT_MSEC 100
 
+/* calibration results kept for reuse across stream restarts */
+#define DESKEW_CACHE_ENTRIES		8
+#define DESKEW_CACHE_MAX_AGE_MSEC	(300 * 1000)
+#define DESKEW_NUM_PHY			(NVCSI_PHY_CIL_NUM_LANE / 4)
+
+/*
+ * data_rate identifies the link rate of the lanes for the calibration
+ * cache, 0 means unknown and disables caching for the request.
+ */
 struct nvcsi_deskew_context {
 	unsigned int deskew_lanes;
+	u64 data_rate;
+	bool cached;
 	struct task_struct *deskew_kthread;
 	struct completion thread_done;
 };
@@ -141,6 +152,7 @@ struct nvcsi_deskew_context {
 
 int nvcsi_deskew_apply_check(struct nvcsi_deskew_context *ctx);
 int nvcsi_deskew_setup(struct nvcsi_deskew_context *ctx);
+void nvcsi_deskew_invalidate(unsigned int lanes);
 
 void nvcsi_deskew_platform_setup(struct tegra_csi_device *dev, bool is_t19x);
 
@@ -90,6 +90,8 @@ static long nvcsi_ioctl(struct file *file, unsigned int cmd,
 		dev_dbg(mc_csi->dev, "ioctl: deskew_setup\n");
 		priv->deskew_ctx.deskew_lanes = get_user(active_lanes,
 				(long __user *)arg);
+		/* the link rate is not known here, do not cache */
+		priv->deskew_ctx.data_rate = 0;
 		ret = nvcsi_deskew_setup(&priv->deskew_ctx);
 		return ret;
 		}
@@ -25,15 +25,28 @@
 
 #define CMDBUF_SIZE	4096
 
+/*
+ * Task memory is allocated in segments of NVDLA_TASK_POOL_SEGMENT_TASKS
+ * tasks. A queue starts with one segment and grows on demand up to the
+ * number of tasks requested at queue allocation, so queues that only ever
+ * have a few tasks in flight do not pin the full pool.
+ */
+#define NVDLA_TASK_POOL_SEGMENT_TASKS	8U
+#define NVDLA_TASK_POOL_MAX_SEGMENTS	\
+	DIV_ROUND_UP(BITS_PER_LONG, NVDLA_TASK_POOL_SEGMENT_TASKS)
+
 /**
  * @brief Describe a task pool struct
  *
- * Array of fixed task memory is allocated during queue_alloc call.
- * The memory will be shared for various task based on availability
+ * Array of task memory segments allocated during queue_alloc call and
+ * grown on demand. The memory will be shared for various task based on
+ * availability
  *
- * dma_addr		Physical address of task memory pool
- * va			Virtual address of the task memory pool
- * kmem_addr		Kernel memory for task struct
+ * dma_addr		Physical address of each task memory segment
+ * va			Virtual address of each task memory segment
+ * kmem_addr		Kernel memory for task struct of each segment
+ * num_segments		Number of allocated segments
+ * segment_tasks	Number of tasks held by one segment
  * lock			Mutex lock for the array access.
  * alloc_table		Keep track of the index being assigned
  *			and freed for a task
@@ -43,9 +56,11 @@
  */
 
 struct nvdla_queue_task_pool {
-	dma_addr_t dma_addr;
-	void *va;
-	void *kmem_addr;
+	dma_addr_t dma_addr[NVDLA_TASK_POOL_MAX_SEGMENTS];
+	void *va[NVDLA_TASK_POOL_MAX_SEGMENTS];
+	void *kmem_addr[NVDLA_TASK_POOL_MAX_SEGMENTS];
+	unsigned int num_segments;
+	unsigned int segment_tasks;
 	struct mutex lock;
 
 	unsigned long alloc_table;
@@ -55,39 +70,76 @@ struct nvdla_queue_task_pool {
 	int cleanup_wait;
 };
 
-static int nvdla_queue_task_pool_alloc(struct platform_device *pdev,
-					struct nvdla_queue *queue,
-					unsigned int num_tasks)
+static unsigned long nvdla_queue_task_pool_cnt(
+				struct nvdla_queue_task_pool *task_pool)
 {
-	int err = 0;
-	struct nvdla_queue_task_pool *task_pool;
+	return min_t(unsigned long, task_pool->max_task_cnt,
+		     task_pool->num_segments * task_pool->segment_tasks);
+}
 
-	task_pool = queue->task_pool;
+static int nvdla_queue_task_pool_grow(struct platform_device *pdev,
+				      struct nvdla_queue *queue)
+{
+	struct nvdla_queue_task_pool *task_pool = queue->task_pool;
+	unsigned int seg = task_pool->num_segments;
+	size_t num_tasks = task_pool->segment_tasks;
+
+	if ((seg >= NVDLA_TASK_POOL_MAX_SEGMENTS) ||
+	    (seg * num_tasks >= task_pool->max_task_cnt))
+		return -ENOMEM;
 
 	/* Allocate the kernel memory needed for the task */
 	if (queue->task_kmem_size) {
-		size_t kmem_pool_size = num_tasks * queue->task_kmem_size;
-		task_pool->kmem_addr = vzalloc(kmem_pool_size);
-		if (!task_pool->kmem_addr) {
+		task_pool->kmem_addr[seg] =
+			vzalloc(num_tasks * queue->task_kmem_size);
+		if (!task_pool->kmem_addr[seg]) {
 			dev_err(&pdev->dev,
 				"failed to allocate task_pool->kmem_addr\n");
-			err = -ENOMEM;
-			goto err_alloc_task_kmem;
+			return -ENOMEM;
 		}
 	}
 
 	/* Allocate memory for the task itself */
-	task_pool->va = dma_alloc_attrs(&pdev->dev,
+	task_pool->va[seg] = dma_alloc_attrs(&pdev->dev,
 				queue->task_dma_size * num_tasks,
-				&task_pool->dma_addr, GFP_KERNEL,
+				&task_pool->dma_addr[seg], GFP_KERNEL,
 				0);
-
-	if (task_pool->va == NULL) {
+	if (task_pool->va[seg] == NULL) {
 		dev_err(&pdev->dev, "failed to allocate task_pool->va\n");
-		err = -ENOMEM;
-		goto err_alloc_task_pool;
+		vfree(task_pool->kmem_addr[seg]);
+		task_pool->kmem_addr[seg] = NULL;
+		return -ENOMEM;
 	}
+
+	task_pool->num_segments = seg + 1U;
+
+	return 0;
+}
+
+static int nvdla_queue_task_pool_alloc(struct platform_device *pdev,
+					struct nvdla_queue *queue,
+					unsigned int num_tasks)
+{
+	int err = 0;
+	struct nvdla_queue_task_pool *task_pool;
+
+	task_pool = queue->task_pool;
+
+	if ((num_tasks == 0U) || (num_tasks > BITS_PER_LONG)) {
+		dev_err(&pdev->dev, "invalid task pool size %u\n", num_tasks);
+		return -EINVAL;
+	}
+
 	task_pool->max_task_cnt = num_tasks;
+	task_pool->segment_tasks = min(num_tasks,
+				       NVDLA_TASK_POOL_SEGMENT_TASKS);
+	task_pool->num_segments = 0U;
+
+	err = nvdla_queue_task_pool_grow(pdev, queue);
+	if (err < 0) {
+		task_pool->max_task_cnt = 0;
+		return err;
+	}
 
 	mutex_init(&task_pool->lock);
 
@@ -95,11 +147,6 @@ static int nvdla_queue_task_pool_alloc(struct platform_device *pdev,
 	task_pool->cleanup_wait = 0;
 
 	return err;
-
-err_alloc_task_pool:
-	vfree(task_pool->kmem_addr);
-err_alloc_task_kmem:
-	return err;
 }
 
 static void nvdla_queue_task_free_pool(struct platform_device *pdev,
@@ -107,13 +154,20 @@ static void nvdla_queue_task_free_pool(struct platform_device *pdev,
 {
 	struct nvdla_queue_task_pool *task_pool =
 		(struct nvdla_queue_task_pool *)queue->task_pool;
+	unsigned int seg;
 
-	dma_free_attrs(&queue->vm_pdev->dev,
-			queue->task_dma_size * task_pool->max_task_cnt,
-			task_pool->va, task_pool->dma_addr,
+	for (seg = 0U; seg < task_pool->num_segments; seg++) {
+		dma_free_attrs(&queue->vm_pdev->dev,
+			queue->task_dma_size * task_pool->segment_tasks,
+			task_pool->va[seg], task_pool->dma_addr[seg],
 			0);
 
-	vfree(task_pool->kmem_addr);
+		vfree(task_pool->kmem_addr[seg]);
+		task_pool->va[seg] = NULL;
+		task_pool->kmem_addr[seg] = NULL;
+	}
+
+	task_pool->num_segments = 0;
 	task_pool->max_task_cnt = 0;
 	task_pool->alloc_table = 0;
 }
@@ -352,9 +406,11 @@ struct nvdla_queue *nvdla_queue_alloc(struct nvdla_queue_pool *pool,
 	/* initialize task list */
 	INIT_LIST_HEAD(&queue->tasklist);
 	mutex_init(&queue->list_lock);
+	queue->timing_ring = NULL;
 
 	/* initialize task list */
 	queue->attr = NULL;
+	queue->priority = 0U;
 	mutex_init(&queue->attr_lock);
 
 	mutex_unlock(&pool->queue_lock);
@@ -574,6 +630,7 @@ int nvdla_queue_alloc_task_memory(
 {
 	int err = 0;
 	int index, hw_offset, sw_offset;
+	unsigned int seg;
 	struct platform_device *pdev = queue->pool->pdev;
 	struct nvdla_queue_task_pool *task_pool =
 		(struct nvdla_queue_task_pool *)queue->task_pool;
@@ -593,11 +650,18 @@ int nvdla_queue_alloc_task_memory(
 	mutex_lock(&task_pool->lock);
 
 	index = find_first_zero_bit(&task_pool->alloc_table,
-				    task_pool->max_task_cnt);
-
-	/* quit if pre-allocated task array is not free */
-	if (index >= task_pool->max_task_cnt) {
-		dev_warn(&pdev->dev, "failed to get Task Pool Memory\n");
+				    nvdla_queue_task_pool_cnt(task_pool));
+
+	/* grow the pool before making the caller wait for a free task */
+	if ((index >= nvdla_queue_task_pool_cnt(task_pool)) &&
+	    (nvdla_queue_task_pool_grow(queue->vm_pdev, queue) == 0))
+		nvdla_dbg_info(pdev, "task pool grown to %lu tasks",
+			       nvdla_queue_task_pool_cnt(task_pool));
+
+	/* quit if task array is not free */
+	if (index >= nvdla_queue_task_pool_cnt(task_pool)) {
+		dev_warn_ratelimited(&pdev->dev,
+			"failed to get Task Pool Memory\n");
 		task_pool->cleanup_wait = 1; // wait for cleanup
 		err = -EAGAIN;
 		goto err_alloc_task_mem;
@@ -605,12 +669,13 @@ int nvdla_queue_alloc_task_memory(
 
 	/* assign the task array */
 	set_bit(index, &task_pool->alloc_table);
-	hw_offset = index * queue->task_dma_size;
-	sw_offset = index * queue->task_kmem_size;
+	seg = index / task_pool->segment_tasks;
+	hw_offset = (index % task_pool->segment_tasks) * queue->task_dma_size;
+	sw_offset = (index % task_pool->segment_tasks) * queue->task_kmem_size;
 	task_mem_info->kmem_addr =
-			(void *)((u8 *)task_pool->kmem_addr + sw_offset);
-	task_mem_info->va = (void *)((u8 *)task_pool->va + hw_offset);
-	task_mem_info->dma_addr = task_pool->dma_addr + hw_offset;
+			(void *)((u8 *)task_pool->kmem_addr[seg] + sw_offset);
+	task_mem_info->va = (void *)((u8 *)task_pool->va[seg] + hw_offset);
+	task_mem_info->dma_addr = task_pool->dma_addr[seg] + hw_offset;
 	task_mem_info->pool_index = index;
 
 err_alloc_task_mem:
@@ -622,15 +687,17 @@ err_alloc_task_mem:
 void nvdla_queue_free_task_memory(struct nvdla_queue *queue, int index)
 {
 	int hw_offset, sw_offset;
+	unsigned int seg;
 	u8 *task_kmem, *task_dma_va;
 	struct nvdla_queue_task_pool *task_pool =
 			(struct nvdla_queue_task_pool *)queue->task_pool;
 
 	/* clear task kernel and dma virtual memory contents*/
-	hw_offset = index * queue->task_dma_size;
-	sw_offset = index * queue->task_kmem_size;
-	task_kmem = (u8 *)task_pool->kmem_addr + sw_offset;
-	task_dma_va = (u8 *)task_pool->va + hw_offset;
+	seg = index / task_pool->segment_tasks;
+	hw_offset = (index % task_pool->segment_tasks) * queue->task_dma_size;
+	sw_offset = (index % task_pool->segment_tasks) * queue->task_kmem_size;
+	task_kmem = (u8 *)task_pool->kmem_addr[seg] + sw_offset;
+	task_dma_va = (u8 *)task_pool->va[seg] + hw_offset;
 
 	memset(task_kmem, 0, queue->task_kmem_size);
 	memset(task_dma_va, 0, queue->task_dma_size);
@@ -14,6 +14,7 @@
 #define NVDLA_TASK_MEM_AVAIL_RETRY_PERIOD 1 /* 1 ms */
 
 struct nvdla_queue_task_pool;
+struct nvdla_task_timing_ring;
 
 /**
  * @brief	Describe a allocated task mem struct
@@ -46,6 +47,7 @@ struct nvdla_queue_task_mem_info {
  * task_dma_size	dma size used in hardware for a task
  * task_kmem_size	kernel memory size for a task
  * attr			queue attribute associated with the host module
+ * timing_ring		task timing ring of the fd owning the queue, or NULL
  *
  */
 struct nvdla_queue {
@@ -69,9 +71,11 @@ struct nvdla_queue {
 
 	struct mutex attr_lock;
 	void *attr;
+	u32 priority;
 
 	struct mutex list_lock;
 	struct list_head tasklist;
+	struct nvdla_task_timing_ring *timing_ring;
 };
 
 /**
@@ -1121,6 +1121,7 @@ static int nvdla_probe(struct platform_device *pdev)
 	pdata->private_data = nvdla_dev;
 	platform_set_drvdata(pdev, pdata);
 	nvdla_dev->dbg_mask = debug_err;
+	nvdla_dev->buffer_cache.max_size = NVDLA_BUFFER_CACHE_DEFAULT_MAX_SIZE;
 
 	err = nvhost_client_device_get_resources(pdev);
 	if (err)
@@ -152,6 +152,11 @@ enum {
  */
 #define MAX_NVDLA_TASK_COUNT	32
 
+/**
+ * Number of log2 microsecond buckets of the task latency histogram
+ */
+#define NVDLA_LATENCY_HIST_BUCKETS	24
+
 /**
  * Maximum number of buffers per pin request
  */
@@ -279,6 +284,8 @@ enum nvdla_submit_mode {
  * @window_mem_va       virtual address of window size buffer
  * @is_suspended	flag to check if module is in suspend state.
  * @ping_lock	lock to synchronize the ping operation requests.
+ * @buffer_cache	settings and statistics of the buffer mapping cache
+ * @latency_hist	submit to completion latency per queue priority
  */
 struct nvdla_device {
 	struct device *dev;
@@ -312,6 +319,9 @@ struct nvdla_device {
 	bool is_suspended;
 #endif
 	struct mutex ping_lock;
+	struct nvdla_buffer_cache buffer_cache;
+	atomic64_t latency_hist[NVDLA_QUEUE_PRIORITY_NUM]
+			       [NVDLA_LATENCY_HIST_BUCKETS];
 };
 
 /**
@@ -351,6 +361,8 @@ struct nvdla_emu_task {
  * @buf_size		Total size of task dma alloc
  * @timeout		max timeout to wait for task completion
  * @op_handle		pointer to handle list of operation descriptor
+ * @submit_ns		time of submission, for the latency histogram
+ * @submit_ts		time of submission in TSC ticks, for the timing ring
  *
  */
 struct nvdla_task {
@@ -381,6 +393,8 @@ struct nvdla_task {
 	size_t buf_size;
 	int timeout;
 	int pool_index;
+	u64 submit_ns;
+	u64 submit_ts;
 
 	struct dma_buf *memory_dmabuf[MAX_NVDLA_BUFFERS_PER_TASK];
 	struct dma_buf *prefences_sem_dmabuf[MAX_NVDLA_PREFENCES_PER_TASK];
@@ -396,6 +410,29 @@ struct dla_mem_addr {
 	uint64_t val;
 };
 
+struct vm_area_struct;
+
+/**
+ * struct nvdla_task_timing_ring	task timing ring shared read-only with
+ *					user space, see NVDLA_QUEUE_ATTR_TIMING_RING
+ *
+ * @va			vmalloc_user() address of the ring
+ * @size		page aligned size of @va
+ * @num_records		number of records, power of two
+ * @header		ring header at the start of @va
+ * @records		records following @header
+ *
+ * Records are appended under the list_lock of the queue the ring is
+ * attached to.
+ */
+struct nvdla_task_timing_ring {
+	void *va;
+	size_t size;
+	u32 num_records;
+	struct nvdla_task_timing_header *header;
+	struct nvdla_task_timing_record *records;
+};
+
 extern const struct file_operations tegra_nvdla_ctrl_ops;
 extern struct nvdla_queue_ops nvdla_queue_ops;
 
@@ -498,6 +535,37 @@ int nvdla_fill_task_desc(struct nvdla_task *task, bool bypass_exec);
 int nvdla_send_postfences(struct nvdla_task *task,
 			struct nvdla_ioctl_submit_task *usr_task);
 
+/**
+ * nvdla_task_timing_ring_alloc()	allocate a task timing ring
+ *
+ * @num_records		number of records, power of two
+ *
+ * Return		allocated ring in success, otherwise pointer to err
+ */
+struct nvdla_task_timing_ring *nvdla_task_timing_ring_alloc(u32 num_records);
+
+/**
+ * nvdla_task_timing_ring_free()	free a task timing ring
+ *
+ * @ring		ring to free, may be NULL
+ *
+ * Return		void
+ *
+ * The ring must not be attached to a queue or mapped by user space.
+ */
+void nvdla_task_timing_ring_free(struct nvdla_task_timing_ring *ring);
+
+/**
+ * nvdla_task_timing_ring_mmap()	map a task timing ring read-only
+ *
+ * @ring		ring to map
+ * @vma			user mapping at offset 0, no larger than the ring
+ *
+ * Return		0 on success otherwise negative
+ */
+int nvdla_task_timing_ring_mmap(struct nvdla_task_timing_ring *ring,
+				struct vm_area_struct *vma);
+
 int nvdla_get_cmd_memory(struct platform_device *pdev,
 				struct nvdla_cmd_mem_info *cmd_mem_info);
 int nvdla_put_cmd_memory(struct platform_device *pdev, int index);
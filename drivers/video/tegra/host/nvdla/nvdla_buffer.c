@@ -29,6 +29,8 @@
  * @access_flags	access (rw/ro)
  * @rb_node:		pinned buffer node
  * @list_head:		List entry
+ * @idle_node:		Entry in the LRU list of unpinned mappings
+ * @idle:		Mapping is unpinned and kept only as a cache entry
  *
  */
 struct nvdla_vm_buffer {
@@ -48,6 +50,8 @@ struct nvdla_vm_buffer {
 	u32 access_flags;
 	struct rb_node rb_node;
 	struct list_head list_head;
+	struct list_head idle_node;
+	bool idle;
 };
 
 static struct nvdla_vm_buffer *nvdla_find_map_buffer(
@@ -181,13 +185,13 @@ static void nvdla_free_buffers(struct kref *kref)
 	kfree(nvdla_buffers);
 }
 
-static void nvdla_buffer_unmap(struct nvdla_buffers *nvdla_buffers,
-				struct nvdla_vm_buffer *vm)
+static void nvdla_buffer_destroy(struct nvdla_buffers *nvdla_buffers,
+				 struct nvdla_vm_buffer *vm)
 {
-	pr_debug("%s\n", __func__);
-
-	if ((vm->user_map_count != 0) || (vm->submit_map_count != 0))
-		return;
+	if (vm->idle) {
+		list_del(&vm->idle_node);
+		nvdla_buffers->idle_size -= vm->size;
+	}
 
 	if (vm->access_flags == NVDLA_MEM_ACCESS_READ)
 		dma_buf_unmap_attachment(vm->attach, vm->sgt, DMA_TO_DEVICE);
@@ -203,7 +207,82 @@ static void nvdla_buffer_unmap(struct nvdla_buffers *nvdla_buffers,
 	kfree(vm);
 }
 
-struct nvdla_buffers *nvdla_buffer_init(struct platform_device *pdev)
+static void nvdla_buffer_unmap(struct nvdla_buffers *nvdla_buffers,
+				struct nvdla_vm_buffer *vm)
+{
+	struct nvdla_buffer_cache *cache = nvdla_buffers->cache;
+	struct nvdla_vm_buffer *lru;
+	u64 max_size;
+
+	pr_debug("%s\n", __func__);
+
+	if ((vm->user_map_count != 0) || (vm->submit_map_count != 0) ||
+	    vm->idle)
+		return;
+
+	max_size = (cache != NULL) ? READ_ONCE(cache->max_size) : 0ULL;
+	if (nvdla_buffers->releasing || (vm->size > max_size)) {
+		nvdla_buffer_destroy(nvdla_buffers, vm);
+		return;
+	}
+
+	/*
+	 * Keep the mapping around, clients typically pin the same small
+	 * set of buffers again for the next frame. The handle stays in the
+	 * tree so that the next pin can find it, but submits are refused
+	 * until the buffer is pinned again.
+	 */
+	vm->idle = true;
+	list_add_tail(&vm->idle_node, &nvdla_buffers->idle_list);
+	nvdla_buffers->idle_size += vm->size;
+
+	while (nvdla_buffers->idle_size > max_size) {
+		lru = list_first_entry(&nvdla_buffers->idle_list,
+				       struct nvdla_vm_buffer, idle_node);
+		nvdla_buffer_destroy(nvdla_buffers, lru);
+		atomic64_inc(&cache->evictions);
+	}
+}
+
+/*
+ * Try to reuse a cached mapping for a pin request. Returns true if @vm was
+ * revived, false if the caller has to map the buffer. A stale entry, i.e.
+ * one whose handle now refers to another dma-buf, is dropped.
+ */
+static bool nvdla_buffer_revive(struct nvdla_buffers *nvdla_buffers,
+				struct nvdla_mem_share_handle *desc,
+				struct nvdla_vm_buffer *vm)
+{
+	struct dma_buf *dmabuf;
+	bool match;
+
+	dmabuf = dma_buf_get((__s32)desc->import_id);
+	if (IS_ERR_OR_NULL(dmabuf))
+		dmabuf = NULL;
+
+	match = (dmabuf == vm->dmabuf) &&
+		(vm->attach->dev == &nvdla_buffers->pdev->dev) &&
+		(desc->access_flags == vm->access_flags) &&
+		(desc->offset == vm->offset);
+
+	if (dmabuf != NULL)
+		dma_buf_put(dmabuf);
+
+	if (!match) {
+		nvdla_buffer_destroy(nvdla_buffers, vm);
+		return false;
+	}
+
+	list_del(&vm->idle_node);
+	nvdla_buffers->idle_size -= vm->size;
+	vm->idle = false;
+	vm->user_map_count = 1;
+
+	return true;
+}
+
+struct nvdla_buffers *nvdla_buffer_init(struct platform_device *pdev,
+					struct nvdla_buffer_cache *cache)
 {
 	struct nvdla_buffers *nvdla_buffers;
 	int err = 0;
@@ -218,6 +297,8 @@ struct nvdla_buffers *nvdla_buffer_init(struct platform_device *pdev)
 	mutex_init(&nvdla_buffers->mutex);
 	nvdla_buffers->rb_root = RB_ROOT;
 	INIT_LIST_HEAD(&nvdla_buffers->list_head);
+	nvdla_buffers->cache = cache;
+	INIT_LIST_HEAD(&nvdla_buffers->idle_list);
 	kref_init(&nvdla_buffers->kref);
 
 	return nvdla_buffers;
@@ -252,7 +333,7 @@ int nvdla_buffer_submit_pin(struct nvdla_buffers *nvdla_buffers,
 
 	for (i = 0; i < count; i++) {
 		vm = nvdla_find_map_buffer(nvdla_buffers, handles[i]);
-		if (vm == NULL)
+		if ((vm == NULL) || vm->idle)
 			goto submit_err;
 
 		vm->submit_map_count++;
@@ -290,11 +371,19 @@ int nvdla_buffer_pin(struct nvdla_buffers *nvdla_buffers,
 
 	for (i = 0; i < count; i++) {
 		vm = nvdla_find_map_buffer(nvdla_buffers, descs[i].share_id);
-		if (vm) {
+		if (vm && !vm->idle) {
 			vm->user_map_count++;
 			continue;
 		}
 
+		if (vm && nvdla_buffer_revive(nvdla_buffers, &descs[i], vm)) {
+			atomic64_inc(&nvdla_buffers->cache->hits);
+			continue;
+		}
+
+		if (nvdla_buffers->cache != NULL)
+			atomic64_inc(&nvdla_buffers->cache->misses);
+
 		vm = kzalloc(sizeof(struct nvdla_vm_buffer), GFP_KERNEL);
 		if (!vm) {
 			pr_err("%s: could not allocate vm_buffer\n", __func__);
@@ -377,10 +466,14 @@ void nvdla_buffer_release(struct nvdla_buffers *nvdla_buffers)
 
 	/* Go through each entry and remove it safely */
 	mutex_lock(&nvdla_buffers->mutex);
+	nvdla_buffers->releasing = true;
 	list_for_each_entry_safe(vm, n, &nvdla_buffers->list_head,
 				 list_head) {
 		vm->user_map_count = 0;
-		nvdla_buffer_unmap(nvdla_buffers, vm);
+		if (vm->idle)
+			nvdla_buffer_destroy(nvdla_buffers, vm);
+		else
+			nvdla_buffer_unmap(nvdla_buffers, vm);
 	}
 	mutex_unlock(&nvdla_buffers->mutex);
 
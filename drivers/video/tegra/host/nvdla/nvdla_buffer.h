@@ -15,6 +15,25 @@ enum nvdla_buffers_heap {
 	NVDLA_BUFFERS_HEAP_DRAM = 0,
 };
 
+#define NVDLA_BUFFER_CACHE_DEFAULT_MAX_SIZE	(64ULL << 20)
+
+/**
+ * @brief		Device wide settings of the buffer mapping cache
+ *
+ * max_size		Maximum bytes of unpinned mappings kept per
+ *			file pointer, 0 disables the cache
+ * hits			Pins served from a cached mapping
+ * misses		Pins that had to map the buffer
+ * evictions		Cached mappings dropped to honour max_size
+ *
+ */
+struct nvdla_buffer_cache {
+	u64 max_size;
+	atomic64_t hits;
+	atomic64_t misses;
+	atomic64_t evictions;
+};
+
 /**
  * @brief		Information needed for buffers
  *
@@ -22,6 +41,10 @@ enum nvdla_buffers_heap {
  * rb_root		RB tree root for of all the buffers used by a file pointer
  * list			List for traversing through all the buffers
  * mutex		Mutex for the buffer tree and the buffer list
+ * cache		Device wide cache settings and statistics
+ * idle_list		LRU list of unpinned mappings kept for reuse
+ * idle_size		Total size of the mappings in idle_list
+ * releasing		File pointer is being closed, do not cache
  * kref			Reference count for the bufferlist
  *
  */
@@ -32,6 +55,11 @@ struct nvdla_buffers {
 	struct rb_root rb_root;
 	struct mutex mutex;
 
+	struct nvdla_buffer_cache *cache;
+	struct list_head idle_list;
+	size_t idle_size;
+	bool releasing;
+
 	struct kref kref;
 };
 
@@ -41,12 +69,14 @@ struct nvdla_buffers {
  * This function allocates nvdla_buffers struct and init the bufferlist
  * and mutex.
  *
- * @param nvdla_buffers	Pointer to nvdla_buffers struct
+ * @param pdev		Pointer to NVHOST device, may be set later
+ * @param cache		Device wide mapping cache, NULL disables caching
  * @return			nvdla_buffers pointer on success
  *					or negative on error
  *
  */
-struct nvdla_buffers *nvdla_buffer_init(struct platform_device *pdev);
+struct nvdla_buffers *nvdla_buffer_init(struct platform_device *pdev,
+					struct nvdla_buffer_cache *cache);
 
 /**
  * @brief	Checks for validity of nvdla_buffer
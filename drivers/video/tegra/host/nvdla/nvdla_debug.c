@@ -10,6 +10,7 @@
 #include <linux/nvhost.h>
 #include <linux/uaccess.h>
 #include <linux/delay.h>
+#include <linux/math64.h>
 #include <linux/version.h>
 
 #include "dla_os_interface.h"
@@ -1169,6 +1170,91 @@ fail_create_file_err_inj:
 }
 #endif /* CONFIG_TEGRA_HSIERRRPTINJ */
 
+static int nvdla_buffer_cache_show(struct seq_file *s, void *data)
+{
+	struct nvdla_device *nvdla_dev = (struct nvdla_device *)s->private;
+	struct nvdla_buffer_cache *cache = &nvdla_dev->buffer_cache;
+	s64 hits = atomic64_read(&cache->hits);
+	s64 misses = atomic64_read(&cache->misses);
+
+	seq_printf(s, "hits: %lld\n", hits);
+	seq_printf(s, "misses: %lld\n", misses);
+	seq_printf(s, "evictions: %lld\n", atomic64_read(&cache->evictions));
+	seq_printf(s, "hit_rate: %lld%%\n",
+		   (hits + misses) ? div64_s64(hits * 100, hits + misses) : 0);
+
+	return 0;
+}
+
+static int nvdla_buffer_cache_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvdla_buffer_cache_show, inode->i_private);
+}
+
+static const struct file_operations nvdla_buffer_cache_fops = {
+	.open		= nvdla_buffer_cache_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int nvdla_queue_latency_show(struct seq_file *s, void *data)
+{
+	static const char * const names[NVDLA_QUEUE_PRIORITY_NUM] = {
+		[NVDLA_QUEUE_PRIORITY_DEFAULT] = "default",
+		[NVDLA_QUEUE_PRIORITY_HIGH] = "high",
+	};
+	struct nvdla_device *nvdla_dev = (struct nvdla_device *)s->private;
+	s64 count;
+	u32 prio, i;
+
+	for (prio = 0U; prio < NVDLA_QUEUE_PRIORITY_NUM; prio++) {
+		seq_printf(s, "%s:\n", names[prio]);
+		for (i = 0U; i < NVDLA_LATENCY_HIST_BUCKETS; i++) {
+			count = atomic64_read(&nvdla_dev->latency_hist[prio][i]);
+			if (count == 0)
+				continue;
+
+			if (i == NVDLA_LATENCY_HIST_BUCKETS - 1U)
+				seq_printf(s, "  >= %llu us: %lld\n",
+					   1ULL << (i - 1U), count);
+			else
+				seq_printf(s, "  < %llu us: %lld\n",
+					   1ULL << i, count);
+		}
+	}
+
+	return 0;
+}
+
+static int nvdla_queue_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvdla_queue_latency_show, inode->i_private);
+}
+
+static ssize_t nvdla_queue_latency_write(struct file *file,
+	const char __user *buffer, size_t count, loff_t *off)
+{
+	struct seq_file *s = file->private_data;
+	struct nvdla_device *nvdla_dev = (struct nvdla_device *)s->private;
+	u32 prio, i;
+
+	/* any write clears the histograms */
+	for (prio = 0U; prio < NVDLA_QUEUE_PRIORITY_NUM; prio++)
+		for (i = 0U; i < NVDLA_LATENCY_HIST_BUCKETS; i++)
+			atomic64_set(&nvdla_dev->latency_hist[prio][i], 0);
+
+	return count;
+}
+
+static const struct file_operations nvdla_queue_latency_fops = {
+	.open		= nvdla_queue_latency_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+	.write		= nvdla_queue_latency_write,
+};
+
 void nvdla_debug_init(struct platform_device *pdev)
 {
 	struct nvhost_device_data *pdata = platform_get_drvdata(pdev);
@@ -1186,6 +1272,12 @@ void nvdla_debug_init(struct platform_device *pdev)
 #endif
 	debugfs_create_u32("submit_mode", S_IRUGO | S_IWUSR, de,
 			&nvdla_dev->submit_mode);
+	debugfs_create_u64("buffer_cache_max_size", S_IRUGO | S_IWUSR, de,
+			&nvdla_dev->buffer_cache.max_size);
+	debugfs_create_file("buffer_cache", S_IRUGO, de, nvdla_dev,
+			&nvdla_buffer_cache_fops);
+	debugfs_create_file("queue_latency", S_IRUGO | S_IWUSR, de, nvdla_dev,
+			&nvdla_queue_latency_fops);
 
 	/* Check if isolate context enabled if submit mode is CHANNEL */
 	nvdla_dev->submit_mode = nvdla_dev->submit_mode &&
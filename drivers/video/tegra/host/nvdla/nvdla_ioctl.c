@@ -27,12 +27,14 @@
  * @pdev		pointer to platform device
  * @queue		pointer to nvdla_queue
  * @buffers		pointer to nvdla_buffer
+ * @timing_ring		task timing ring, see NVDLA_QUEUE_ATTR_TIMING_RING
  */
 
 struct nvdla_private {
 	struct platform_device *pdev;
 	struct nvdla_queue *queue;
 	struct nvdla_buffers *buffers;
+	struct nvdla_task_timing_ring *timing_ring;
 };
 
 static int nvdla_get_fw_ver(struct nvdla_private *priv,
@@ -107,6 +109,59 @@ inval_cmd:
 	return err;
 }
 
+/*
+ * The ring belongs to the fd rather than the queue, so that it outlives
+ * both a NVDLA_IOCTL_RELEASE_QUEUE and the user mappings of it.
+ */
+static int nvdla_set_timing_ring(struct nvdla_private *priv,
+				 struct nvdla_queue *queue, u32 num_records)
+{
+	struct platform_device *pdev = priv->pdev;
+	struct nvdla_task_timing_ring *ring;
+	int err = 0;
+
+	ring = nvdla_task_timing_ring_alloc(num_records);
+	if (IS_ERR(ring)) {
+		nvdla_dbg_err(pdev, "invalid timing ring size %u", num_records);
+		return PTR_ERR(ring);
+	}
+
+	mutex_lock(&queue->attr_lock);
+	if (priv->timing_ring != NULL) {
+		err = -EBUSY;
+	} else {
+		mutex_lock(&queue->list_lock);
+		queue->timing_ring = ring;
+		mutex_unlock(&queue->list_lock);
+		WRITE_ONCE(priv->timing_ring, ring);
+	}
+	mutex_unlock(&queue->attr_lock);
+
+	if (err)
+		nvdla_task_timing_ring_free(ring);
+
+	return err;
+}
+
+static int nvdla_set_queue_attr(struct nvdla_private *priv, void *args)
+{
+	struct nvdla_queue_attr_args *attr = args;
+	struct platform_device *pdev = priv->pdev;
+	struct nvdla_queue *queue = priv->queue;
+
+	nvdla_dbg_fn(pdev, "");
+
+	if (!queue) {
+		nvdla_dbg_err(pdev, "invalid queue\n");
+		return -EINVAL;
+	}
+
+	if (attr->id == NVDLA_QUEUE_ATTR_TIMING_RING)
+		return nvdla_set_timing_ring(priv, queue, attr->value);
+
+	return nvdla_queue_set_attr(queue, args);
+}
+
 static int nvdla_get_q_status(struct nvdla_private *priv, void *args)
 {
 	struct nvdla_get_q_status_args *queue_arg =
@@ -987,6 +1042,9 @@ static int nvdla_queue_alloc_handler(struct nvdla_private *priv, void *arg)
 	/* Set nvdla_buffers platform device */
 	nvdla_buffer_set_platform_device(priv->buffers, priv->queue->vm_pdev);
 
+	/* Keep recording into the ring of a previously released queue */
+	priv->queue->timing_ring = priv->timing_ring;
+
 fail:
 	return err;
 }
@@ -1014,6 +1072,12 @@ static int nvdla_queue_release_handler(struct nvdla_private *priv, void *arg)
 
 	/* Release the queue */
 	(void) nvdla_queue_abort(priv->queue);
+
+	/* Completions of tasks the abort left behind must not see the ring */
+	mutex_lock(&priv->queue->list_lock);
+	priv->queue->timing_ring = NULL;
+	mutex_unlock(&priv->queue->list_lock);
+
 	nvdla_queue_put(priv->queue);
 
 	priv->queue = NULL;
@@ -1225,6 +1289,9 @@ static long nvdla_ioctl(struct file *file, unsigned int cmd,
 	case NVDLA_IOCTL_RELEASE_QUEUE:
 		err = nvdla_queue_release_handler(priv, (void*)buf);
 		break;
+	case NVDLA_IOCTL_SET_QUEUE_ATTR:
+		err = nvdla_set_queue_attr(priv, (void *)buf);
+		break;
 	default:
 		nvdla_dbg_err(pdev, "invalid IOCTL CMD");
 		err = -ENOIOCTLCMD;
@@ -1243,6 +1310,7 @@ static int nvdla_open(struct inode *inode, struct file *file)
 	struct nvhost_device_data *pdata = container_of(inode->i_cdev,
 					struct nvhost_device_data, ctrl_cdev);
 	struct platform_device *pdev = pdata->pdev;
+	struct nvdla_device *nvdla_dev = pdata->private_data;
 	struct nvdla_private *priv;
 	int err = 0, index;
 
@@ -1280,12 +1348,13 @@ static int nvdla_open(struct inode *inode, struct file *file)
 
 	/* Zero out explicitly */
 	priv->queue = NULL;
+	priv->timing_ring = NULL;
 
 	/**
 	 * Platform device corresponding to buffers is deferred
 	 * to queue allocation.
 	 **/
-	priv->buffers = nvdla_buffer_init(NULL);
+	priv->buffers = nvdla_buffer_init(NULL, &nvdla_dev->buffer_cache);
 	if (IS_ERR(priv->buffers)) {
 		err = PTR_ERR(priv->buffers);
 		goto err_alloc_buffer;
@@ -1321,12 +1390,24 @@ static int nvdla_release(struct inode *inode, struct file *file)
 	}
 
 	nvdla_buffer_release(priv->buffers);
+	nvdla_task_timing_ring_free(priv->timing_ring);
 	nvhost_module_remove_client(pdev, priv);
 
 	kfree(priv);
 	return 0;
 }
 
+static int nvdla_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct nvdla_private *priv = file->private_data;
+	struct nvdla_task_timing_ring *ring = READ_ONCE(priv->timing_ring);
+
+	if (ring == NULL)
+		return -EINVAL;
+
+	return nvdla_task_timing_ring_mmap(ring, vma);
+}
+
 const struct file_operations tegra_nvdla_ctrl_ops = {
 	.owner = THIS_MODULE,
 	.llseek = no_llseek,
@@ -1336,4 +1417,5 @@ const struct file_operations tegra_nvdla_ctrl_ops = {
 #endif
 	.open = nvdla_open,
 	.release = nvdla_release,
+	.mmap = nvdla_mmap,
 };
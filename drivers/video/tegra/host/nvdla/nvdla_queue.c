@@ -13,6 +13,10 @@
 #include <linux/dma-mapping.h>
 #include <linux/uaccess.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
 
 #include <uapi/linux/nvhost_ioctl.h>
 
@@ -320,6 +324,108 @@ static inline size_t nvdla_profile_status_offset(struct nvdla_task *task)
 	return offset;
 }
 
+static void nvdla_queue_record_latency(struct nvdla_queue *queue,
+				       struct nvdla_task *task)
+{
+	struct nvhost_device_data *pdata =
+			platform_get_drvdata(queue->pool->pdev);
+	struct nvdla_device *nvdla_dev = pdata->private_data;
+	u64 latency_us;
+	u32 bucket;
+
+	/* bucket 0 is below 1us, bucket n covers [2^(n-1), 2^n) us */
+	latency_us = div_u64(ktime_get_ns() - task->submit_ns, NSEC_PER_USEC);
+	bucket = min_t(u32, fls64(latency_us), NVDLA_LATENCY_HIST_BUCKETS - 1);
+
+	atomic64_inc(&nvdla_dev->latency_hist[READ_ONCE(queue->priority)]
+					     [bucket]);
+}
+
+struct nvdla_task_timing_ring *nvdla_task_timing_ring_alloc(u32 num_records)
+{
+	struct nvdla_task_timing_ring *ring;
+	size_t size;
+
+	if ((num_records == 0U) ||
+	    (num_records > NVDLA_TASK_TIMING_MAX_RECORDS) ||
+	    !is_power_of_2(num_records))
+		return ERR_PTR(-EINVAL);
+
+	ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+	if (ring == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	size = sizeof(struct nvdla_task_timing_header) +
+	       ((size_t)num_records * sizeof(struct nvdla_task_timing_record));
+	ring->size = PAGE_ALIGN(size);
+	ring->va = vmalloc_user(ring->size);
+	if (ring->va == NULL) {
+		kfree(ring);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	ring->num_records = num_records;
+	ring->header = ring->va;
+	ring->records = ring->va + sizeof(struct nvdla_task_timing_header);
+
+	ring->header->version = NVDLA_TASK_TIMING_VERSION;
+	ring->header->record_size = sizeof(struct nvdla_task_timing_record);
+	ring->header->num_records = num_records;
+	ring->header->records_offset = sizeof(struct nvdla_task_timing_header);
+	ring->header->head = 0;
+
+	return ring;
+}
+
+void nvdla_task_timing_ring_free(struct nvdla_task_timing_ring *ring)
+{
+	if (ring == NULL)
+		return;
+
+	vfree(ring->va);
+	kfree(ring);
+}
+
+int nvdla_task_timing_ring_mmap(struct nvdla_task_timing_ring *ring,
+				struct vm_area_struct *vma)
+{
+	if ((vma->vm_pgoff != 0) ||
+	    ((vma->vm_end - vma->vm_start) > ring->size))
+		return -EINVAL;
+
+	/* The ring is written by the driver only */
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+#if defined(NV_VM_AREA_STRUCT_HAS_CONST_VM_FLAGS) /* Linux v6.3 */
+	vm_flags_clear(vma, VM_MAYWRITE);
+#else
+	vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+
+	return remap_vmalloc_range(vma, ring->va, 0);
+}
+
+static void nvdla_task_timing_ring_record(struct nvdla_task_timing_ring *ring,
+					  struct nvdla_task *task, u32 task_id,
+					  u16 status, u64 start, u64 end)
+{
+	struct nvdla_task_timing_record *rec;
+	u64 head;
+
+	head = ring->header->head;
+	rec = &ring->records[head & (ring->num_records - 1U)];
+
+	rec->task_id = task_id;
+	rec->status = status;
+	rec->submit_time = task->submit_ts;
+	rec->start_time = start;
+	rec->end_time = end;
+
+	/* Publish the record before moving head past it */
+	smp_wmb();
+	WRITE_ONCE(ring->header->head, head + 1U);
+}
 
 #if IS_ENABLED(CONFIG_TEGRA_GRHOST)
 /*
@@ -375,6 +481,11 @@ static void nvdla_queue_update(void *priv)
 						task->postfences[i].syncpoint_value);
 			}
 		}
+			if (queue->timing_ring != NULL)
+				nvdla_task_timing_ring_record(queue->timing_ring,
+					task, task_id, tsp_notifier->status,
+					timestamp_start, timestamp_end);
+			nvdla_queue_record_latency(queue, task);
 			nvdla_task_free_locked(task);
 			n_tasks_completed++;
 		}
@@ -1337,6 +1448,8 @@ static int nvdla_queue_submit_op(struct nvdla_queue *queue, void *in_task)
 
 	/* Report timestamp in TSC ticks. */
 	timestamp = arch_timer_read_counter();
+	task->submit_ns = ktime_get_ns();
+	task->submit_ts = timestamp;
 
 	/* get pm refcount */
 	if (nvhost_module_busy(pdev))
@@ -1508,9 +1621,42 @@ list_empty:
 	return err;
 }
 
+static int nvdla_queue_set_attribute_op(struct nvdla_queue *queue, void *arg)
+{
+	struct nvdla_queue_attr_args *attr = (struct nvdla_queue_attr_args *)arg;
+	struct platform_device *pdev = queue->pool->pdev;
+	int err = 0;
+
+	nvdla_dbg_fn(pdev, "");
+
+	mutex_lock(&queue->attr_lock);
+
+	switch (attr->id) {
+	case NVDLA_QUEUE_ATTR_PRIORITY:
+		if (attr->value >= NVDLA_QUEUE_PRIORITY_NUM) {
+			nvdla_dbg_err(pdev, "invalid priority %u", attr->value);
+			err = -EINVAL;
+			break;
+		}
+		WRITE_ONCE(queue->priority, attr->value);
+		nvdla_dbg_info(pdev, "Q id %d priority %u", queue->id,
+			       attr->value);
+		break;
+	default:
+		nvdla_dbg_err(pdev, "invalid queue attr %u", attr->id);
+		err = -EINVAL;
+		break;
+	}
+
+	mutex_unlock(&queue->attr_lock);
+
+	return err;
+}
+
 struct nvdla_queue_ops nvdla_queue_ops = {
 	.abort = nvdla_queue_abort_op,
 	.submit = nvdla_queue_submit_op,
 	.get_task_size =  nvdla_get_task_desc_memsize_op,
 	.dump = nvdla_queue_dump_op,
+	.set_attribute = nvdla_queue_set_attribute_op,
 };
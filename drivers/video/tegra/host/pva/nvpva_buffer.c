@@ -8,7 +8,9 @@
 #include <linux/uaccess.h>
 #include <linux/slab.h>
 #include <linux/dma-buf.h>
+#include <linux/jiffies.h>
 #include <linux/nvhost.h>
+#include <linux/workqueue.h>
 
 #include "pva.h"
 #include "nvpva_buffer.h"
@@ -25,6 +27,9 @@
  * @submit_map_count:	Buffer reference count from task submit
  * @rb_node:		pinned buffer node
  * @list_head:		List entry
+ * @idle_node:		Entry in the idle list while the mapping is cached
+ * @idle_since:		jiffies when the last reference was dropped
+ * @idle:		Mapping has no users and is only kept for reuse
  *
  */
 struct nvpva_vm_buffer {
@@ -44,8 +49,19 @@ struct nvpva_vm_buffer {
 	struct				rb_node rb_node;
 	struct				rb_node rb_node_id;
 	struct				list_head list_head;
+	struct				list_head idle_node;
+	unsigned long			idle_since;
+	bool				idle;
 };
 
+static struct pva *nvpva_buffers_to_pva(struct nvpva_buffers *nvpva_buffers)
+{
+	struct nvhost_device_data *pdata =
+		platform_get_drvdata(nvpva_buffers->pdev);
+
+	return pdata->private_data;
+}
+
 static uint32_t get_unique_id(struct nvpva_buffers *nvpva_buffers)
 {
 	struct nvhost_device_data *pdata =
@@ -302,16 +318,14 @@ static void nvpva_free_buffers(struct kref *kref)
 	kfree(nvpva_buffers);
 }
 
-static void nvpva_buffer_unmap(struct nvpva_buffers *nvpva_buffers,
-				struct nvpva_vm_buffer *vm)
+static void nvpva_buffer_destroy(struct nvpva_buffers *nvpva_buffers,
+				 struct nvpva_vm_buffer *vm)
 {
-	struct nvhost_device_data *pdata = platform_get_drvdata(nvpva_buffers->pdev);
-	struct pva *pva = pdata->private_data;
-
-	nvpva_dbg_fn(pva, "");
-
-	if ((vm->user_map_count != 0) || (vm->submit_map_count != 0))
-		return;
+	if (vm->idle) {
+		list_del(&vm->idle_node);
+		nvpva_buffers->idle_size -= vm->size;
+		vm->idle = false;
+	}
 
 	dma_buf_unmap_attachment(vm->attach, vm->sgt, DMA_BIDIRECTIONAL);
 	dma_buf_detach(vm->dmabuf, vm->attach);
@@ -325,6 +339,94 @@ static void nvpva_buffer_unmap(struct nvpva_buffers *nvpva_buffers,
 	kfree(vm);
 }
 
+/*
+ * Keep an unused mapping around so that pinning the same buffer again does
+ * not go through dma_buf_map_attachment() and the IOMMU. Idle mappings are
+ * dropped once they have been unused for pin_cache_timeout_ms, or oldest
+ * first when they add up to more than pin_cache_max_size.
+ */
+static bool nvpva_buffer_park(struct nvpva_buffers *nvpva_buffers,
+			      struct nvpva_vm_buffer *vm)
+{
+	struct pva *pva = nvpva_buffers_to_pva(nvpva_buffers);
+	u32 timeout_ms = READ_ONCE(pva->pin_cache_timeout_ms);
+	u64 max_size = READ_ONCE(pva->pin_cache_max_size);
+	struct nvpva_vm_buffer *old;
+
+	if (vm->idle)
+		return true;
+
+	if (nvpva_buffers->releasing || (timeout_ms == 0U) ||
+	    (vm->size > max_size))
+		return false;
+
+	vm->idle = true;
+	vm->idle_since = jiffies;
+	list_add_tail(&vm->idle_node, &nvpva_buffers->idle_list);
+	nvpva_buffers->idle_size += vm->size;
+
+	while (nvpva_buffers->idle_size > max_size) {
+		old = list_first_entry(&nvpva_buffers->idle_list,
+				       struct nvpva_vm_buffer, idle_node);
+		nvpva_buffer_destroy(nvpva_buffers, old);
+	}
+
+	schedule_delayed_work(&nvpva_buffers->idle_work,
+			      msecs_to_jiffies(timeout_ms));
+
+	return true;
+}
+
+static void nvpva_buffer_unpark(struct nvpva_buffers *nvpva_buffers,
+				struct nvpva_vm_buffer *vm)
+{
+	list_del(&vm->idle_node);
+	nvpva_buffers->idle_size -= vm->size;
+	vm->idle = false;
+}
+
+static void nvpva_buffer_idle_work(struct work_struct *work)
+{
+	struct nvpva_buffers *nvpva_buffers =
+		container_of(to_delayed_work(work), struct nvpva_buffers,
+			     idle_work);
+	struct pva *pva = nvpva_buffers_to_pva(nvpva_buffers);
+	unsigned long timeout;
+	struct nvpva_vm_buffer *vm;
+
+	timeout = msecs_to_jiffies(READ_ONCE(pva->pin_cache_timeout_ms));
+
+	mutex_lock(&nvpva_buffers->mutex);
+	while (!list_empty(&nvpva_buffers->idle_list)) {
+		vm = list_first_entry(&nvpva_buffers->idle_list,
+				      struct nvpva_vm_buffer, idle_node);
+		if (time_before(jiffies, vm->idle_since + timeout)) {
+			schedule_delayed_work(&nvpva_buffers->idle_work,
+					      vm->idle_since + timeout - jiffies);
+			break;
+		}
+
+		nvpva_buffer_destroy(nvpva_buffers, vm);
+	}
+	mutex_unlock(&nvpva_buffers->mutex);
+}
+
+static void nvpva_buffer_unmap(struct nvpva_buffers *nvpva_buffers,
+				struct nvpva_vm_buffer *vm)
+{
+	struct pva *pva = nvpva_buffers_to_pva(nvpva_buffers);
+
+	nvpva_dbg_fn(pva, "");
+
+	if ((vm->user_map_count != 0) || (vm->submit_map_count != 0))
+		return;
+
+	if (nvpva_buffer_park(nvpva_buffers, vm))
+		return;
+
+	nvpva_buffer_destroy(nvpva_buffers, vm);
+}
+
 struct nvpva_buffers
 *nvpva_buffer_init(struct platform_device *pdev,
 		   struct platform_device *pdev_priv,
@@ -346,6 +448,8 @@ struct nvpva_buffers
 	nvpva_buffers->rb_root = RB_ROOT;
 	nvpva_buffers->rb_root_id = RB_ROOT;
 	INIT_LIST_HEAD(&nvpva_buffers->list_head);
+	INIT_LIST_HEAD(&nvpva_buffers->idle_list);
+	INIT_DELAYED_WORK(&nvpva_buffers->idle_work, nvpva_buffer_idle_work);
 	kref_init(&nvpva_buffers->kref);
 	memset(nvpva_buffers->ids, 0, sizeof(nvpva_buffers->ids));
 	nvpva_buffers->num_assigned_ids = 0;
@@ -374,7 +478,7 @@ int nvpva_buffer_submit_pin_id(struct nvpva_buffers *nvpva_buffers,
 
 	for (i = 0; i < count; i++) {
 		vm = nvpva_find_map_buffer_id(nvpva_buffers, ids[i]);
-		if (vm == NULL)
+		if ((vm == NULL) || vm->idle)
 			goto submit_err;
 
 		vm->submit_map_count++;
@@ -411,6 +515,7 @@ int nvpva_buffer_pin(struct nvpva_buffers *nvpva_buffers,
 		     u32 *id,
 		     u32 *eerr)
 {
+	struct pva *pva = nvpva_buffers_to_pva(nvpva_buffers);
 	struct nvpva_vm_buffer *vm;
 	int i = 0;
 	int err = 0;
@@ -442,11 +547,19 @@ int nvpva_buffer_pin(struct nvpva_buffers *nvpva_buffers,
 					   size[i],
 					   dmabufs[i]);
 		if (vm) {
+			if (vm->idle) {
+				nvpva_buffer_unpark(nvpva_buffers, vm);
+				vm->user_serial_id = serial_id[i];
+				atomic64_inc(&pva->pin_cache_hits);
+			}
+
 			vm->user_map_count++;
 			id[i] = vm->id;
 			continue;
 		}
 
+		atomic64_inc(&pva->pin_cache_misses);
+
 		vm = kzalloc(sizeof(struct nvpva_vm_buffer), GFP_KERNEL);
 		if (!vm) {
 			err = -ENOMEM;
@@ -582,12 +695,18 @@ void nvpva_buffer_release(struct nvpva_buffers *nvpva_buffers)
 
 	/* Go through each entry and remove it safely */
 	mutex_lock(&nvpva_buffers->mutex);
+	nvpva_buffers->releasing = true;
 	list_for_each_entry_safe(vm, n, &nvpva_buffers->list_head,
 				 list_head) {
 		vm->user_map_count = 0;
-		nvpva_buffer_unmap(nvpva_buffers, vm);
+		if (vm->idle)
+			nvpva_buffer_destroy(nvpva_buffers, vm);
+		else
+			nvpva_buffer_unmap(nvpva_buffers, vm);
 	}
 	mutex_unlock(&nvpva_buffers->mutex);
 
+	cancel_delayed_work_sync(&nvpva_buffers->idle_work);
+
 	kref_put(&nvpva_buffers->kref, nvpva_free_buffers);
 }
@@ -9,6 +9,7 @@
 #define __NVPVA_NVPVA_BUFFER_H__
 
 #include <linux/dma-buf.h>
+#include <linux/workqueue.h>
 #include "pva_bit_helpers.h"
 
 enum nvpva_buffers_heap {
@@ -24,6 +25,10 @@ enum nvpva_buffers_heap {
  * mutex		Mutex for the buffer tree and the buffer list
  * kref			Reference count for the bufferlist
  * ids			unique ID assigned to a pinned buffer
+ * idle_list		Unused mappings kept for reuse, oldest first
+ * idle_size		Total size of the buffers in idle_list
+ * idle_work		Drops idle mappings once they time out
+ * releasing		Set once the bufferlist is released, disables caching
  */
 #define NVPVA_ID_SEGMENT_SIZE		32
 #define NVPVA_MAX_NUM_UNIQUE_IDS	(NVPVA_ID_SEGMENT_SIZE * 1024)
@@ -40,6 +45,10 @@ struct nvpva_buffers {
 	struct kref kref;
 	uint32_t ids[NVPVA_NUM_ID_SEGMENTS];
 	uint32_t num_assigned_ids;
+	struct list_head idle_list;
+	size_t idle_size;
+	struct delayed_work idle_work;
+	bool releasing;
 };
 
 /**
@@ -1372,6 +1372,11 @@ static int pva_probe(struct platform_device *pdev)
 
 	mutex_init(&pva->pva_auth.allow_list_lock);
 	mutex_init(&pva->pva_auth_sys.allow_list_lock);
+	pva_vpu_app_cache_init(pva);
+	pva->pin_cache_timeout_ms = PVA_PIN_CACHE_DEFAULT_TIMEOUT_MS;
+	pva->pin_cache_max_size = PVA_PIN_CACHE_DEFAULT_MAX_SIZE;
+	atomic64_set(&pva->pin_cache_hits, 0);
+	atomic64_set(&pva->pin_cache_misses, 0);
 	if (pdata->version <= PVA_HW_GEN2) {
 		pva->pva_auth.pva_auth_enable = true;
 		pva->pva_auth_sys.pva_auth_enable = true;
@@ -1516,6 +1521,7 @@ static int __exit pva_remove(struct platform_device *pdev)
 
 	pva_auth_allow_list_destroy(&pva->pva_auth_sys);
 	pva_auth_allow_list_destroy(&pva->pva_auth);
+	pva_vpu_app_cache_deinit(pva);
 	pva_free_task_status_buffer(pva);
 	nvpva_syncpt_unit_interface_deinit(pdev, pva->aux_pdev);
 	nvpva_client_context_deinit(pva);
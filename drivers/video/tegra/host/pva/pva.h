@@ -9,6 +9,7 @@
 #define __NVHOST_PVA_H__
 
 #include <linux/firmware.h>
+#include <linux/list.h>
 #include <linux/mutex.h>
 #include <linux/version.h>
 #include <linux/workqueue.h>
@@ -87,6 +88,12 @@ struct pva_version_info {
  */
 #define NUM_VPU_BLOCKS 2
 
+/**
+ * Defaults for keeping unused buffer mappings of a client around
+ */
+#define PVA_PIN_CACHE_DEFAULT_TIMEOUT_MS	500U
+#define PVA_PIN_CACHE_DEFAULT_MAX_SIZE		(64ULL * 1024ULL * 1024ULL)
+
 /**
  * nvpva_dbg_* macros provide wrappers around kernel print functions
  * that use a debug mask configurable at runtime to provide control over
@@ -313,6 +320,25 @@ struct pva_vpu_util_info {
 	struct pva_vpu_stats_s	*stats_fw_buffer_va;
 };
 
+/**
+ * @brief		Device wide cache of parsed VPU applications
+ *
+ * lru			entries, most recently used first
+ * lock		protects lru and size
+ * size		bytes currently held by the cache
+ * max_size		upper bound for size, 0 disables the cache
+ * hits			number of registrations served from the cache
+ * misses		number of registrations that parsed the ELF
+ */
+struct pva_vpu_app_cache {
+	struct list_head	lru;
+	struct mutex		lock;
+	size_t			size;
+	size_t			max_size;
+	u64			hits;
+	u64			misses;
+};
+
 struct scatterlist;
 struct nvpva_syncpt_desc {
 	dma_addr_t addr;
@@ -378,6 +404,7 @@ struct pva {
 	struct nvpva_carveout_info fw_carveout;
 	struct pva_vpu_auth_s pva_auth;
 	struct pva_vpu_auth_s pva_auth_sys;
+	struct pva_vpu_app_cache vpu_app_cache;
 	struct nvpva_syncpts_desc syncpts;
 
 	int irq[MAX_PVA_IRQS];
@@ -442,6 +469,12 @@ struct pva {
 	struct nvpva_client_context *clients;
 	struct mutex clients_lock;
 
+	/* Unused buffer mappings are cached per client, see nvpva_buffer.c */
+	u32 pin_cache_timeout_ms;
+	u64 pin_cache_max_size;
+	atomic64_t pin_cache_hits;
+	atomic64_t pin_cache_misses;
+
 	struct pva_vpu_dbg_block vpu_dbg_blocks[NUM_VPU_BLOCKS];
 
 	struct tegra_soc_hwpm_ip_ops hwpm_ip_ops;
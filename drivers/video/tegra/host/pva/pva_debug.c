@@ -21,6 +21,7 @@
 
 #include "pva.h"
 #include "pva_vpu_ocd.h"
+#include "pva_vpu_exe.h"
 #include "pva-fw-address-map.h"
 
 static void pva_read_crashdump(struct seq_file *s, struct pva_seg_info *seg_info)
@@ -325,6 +326,52 @@ static const struct file_operations pva_stats_fops = {
 	.release = single_release,
 };
 
+static int print_vpu_app_cache(struct seq_file *s, void *data)
+{
+	struct pva *pva = s->private;
+	struct pva_vpu_app_cache *cache = &pva->vpu_app_cache;
+
+	mutex_lock(&cache->lock);
+	seq_printf(s, "size: %zu\nmax_size: %zu\nhits: %llu\nmisses: %llu\n",
+		   cache->size, cache->max_size, cache->hits, cache->misses);
+	mutex_unlock(&cache->lock);
+
+	return 0;
+}
+
+static int pva_vpu_app_cache_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, print_vpu_app_cache, inode->i_private);
+}
+
+static const struct file_operations pva_vpu_app_cache_fops = {
+	.open = pva_vpu_app_cache_open,
+	.read = seq_read,
+	.release = single_release,
+};
+
+static int print_pin_cache(struct seq_file *s, void *data)
+{
+	struct pva *pva = s->private;
+
+	seq_printf(s, "hits: %lld\nmisses: %lld\n",
+		   (long long)atomic64_read(&pva->pin_cache_hits),
+		   (long long)atomic64_read(&pva->pin_cache_misses));
+
+	return 0;
+}
+
+static int pva_pin_cache_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, print_pin_cache, inode->i_private);
+}
+
+static const struct file_operations pva_pin_cache_fops = {
+	.open = pva_pin_cache_open,
+	.read = seq_read,
+	.release = single_release,
+};
+
 static int get_authentication(void *data, u64 *val)
 {
 	struct pva *pva = (struct pva *) data;
@@ -340,8 +387,10 @@ static int set_authentication(void *data, u64 val)
 
 	pva->pva_auth.pva_auth_enable = (val == 1) ? true : false;
 
-	if (pva->pva_auth.pva_auth_enable)
+	if (pva->pva_auth.pva_auth_enable) {
 		pva->pva_auth.pva_auth_allow_list_parsed = false;
+		pva_vpu_app_cache_flush(pva);
+	}
 
 	return 0;
 }
@@ -449,6 +498,15 @@ void pva_debugfs_init(struct platform_device *pdev)
 	debugfs_create_u32("profiling_level", 0644, de, &pva->profiling_level);
 	debugfs_create_bool("stats_enabled", 0644, de, &pva->stats_enabled);
 	debugfs_create_file("vpu_stats", 0644, de, pva, &pva_stats_fops);
+	debugfs_create_file("vpu_app_cache", 0444, de, pva,
+			    &pva_vpu_app_cache_fops);
+	debugfs_create_size_t("vpu_app_cache_max_size", 0644, de,
+			      &pva->vpu_app_cache.max_size);
+	debugfs_create_file("pin_cache", 0444, de, pva, &pva_pin_cache_fops);
+	debugfs_create_u32("pin_cache_timeout_ms", 0644, de,
+			   &pva->pin_cache_timeout_ms);
+	debugfs_create_u64("pin_cache_max_size", 0644, de,
+			   &pva->pin_cache_max_size);
 
 	mutex_init(&pva->fw_debug_log.saved_log_lock);
 	pva->fw_debug_log.size = FW_DEBUG_LOG_BUFFER_SIZE;
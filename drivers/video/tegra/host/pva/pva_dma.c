@@ -4,6 +4,7 @@
 #include <linux/kernel.h>
 #include <linux/seq_file.h>
 #include <linux/nospec.h>
+#include <linux/slab.h>
 #include "pva_dma.h"
 #include "pva_queue.h"
 #include "pva-sys-dma.h"
@@ -152,12 +153,16 @@ done:
 	return err;
 }
 
-static int32_t check_address_range(struct nvpva_dma_descriptor const *desc,
-				   uint64_t max_size,
-				   uint64_t max_size2,
-				   bool src_dst,
-				   bool dst2,
-				   int8_t block_height_log2)
+/*
+ * Computes the extent of the surface accessed by one side of a descriptor,
+ * relative to the start of its buffer. Only the check against the buffer
+ * size is left to check_range_size(), so the result of a registered DMA
+ * config can be reused by every task referencing it.
+ */
+static int32_t compute_address_range(struct nvpva_dma_descriptor const *desc,
+				     bool src_dst,
+				     int8_t block_height_log2,
+				     struct pva_dma_desc_range *range)
 {
 	int32_t err = 0;
 	int64_t start = 0;
@@ -173,9 +178,13 @@ static int32_t check_address_range(struct nvpva_dma_descriptor const *desc,
 	int64_t last_tx = (int64_t)desc->tx - 1;
 	int64_t last_ty = (int64_t)desc->ty - 1;
 
+	range->no_access = false;
+
 	/** dummy transfer mode with no data transfer */
-	if (desc->tx == 0U)
+	if (desc->tx == 0U) {
+		range->no_access = true;
 		return err;
+	}
 
 	/** ty = 0 is not allowed */
 	if (desc->ty == 0U)
@@ -197,8 +206,10 @@ static int32_t check_address_range(struct nvpva_dma_descriptor const *desc,
 		if (desc->dstCbEnable == 1U) {
 			/* ((DLP_ADV * (Ty-1)) + Tx) * BPP <= DB_SIZE */
 			if (((s[1] + last_tx + 1) * bppSize) <=
-			    (int64_t)desc->dstCbSize)
+			    (int64_t)desc->dstCbSize) {
+				range->no_access = true;
 				return 0;
+			}
 
 			pr_err("invalid dst cb advance");
 			return -EINVAL;
@@ -227,8 +238,10 @@ static int32_t check_address_range(struct nvpva_dma_descriptor const *desc,
 		if (desc->srcCbEnable == 1U) {
 			/* ((SLP_ADV * (Ty-1)) + Tx) * BPP <= SB_SIZE */
 			if (((s[1] + last_tx + 1) * bppSize) <=
-			    (int64_t)desc->srcCbSize)
+			    (int64_t)desc->srcCbSize) {
+				range->no_access = true;
 				return 0;
+			}
 			pr_err("invalid src cb");
 				return -EINVAL;
 		}
@@ -251,30 +264,74 @@ static int32_t check_address_range(struct nvpva_dma_descriptor const *desc,
 		end += max(s[i]*bppSize, 0LL);
 	}
 
+	range->start = start;
+	range->end = end;
+	range->offset = offset;
+	range->offset2 = offset2;
+out:
+	return err;
+}
+
+static int32_t check_range_size(const struct pva_dma_desc_range *range,
+				uint64_t max_size,
+				uint64_t max_size2,
+				bool dst2)
+{
+	int32_t err = 0;
+
+	if (range->err)
+		return range->err;
+
+	if (range->no_access)
+		return 0;
+
 	/* check for out of range access */
 	if (((int64_t) max_size) < 0) {
 		pr_err("max_size too large");
-		err = -EINVAL;
-		goto out;
+		return -EINVAL;
 	}
 
-	if (!(((offset + start) >= 0)
-	    && ((offset + end) < (int64_t)max_size))) {
+	if (!(((range->offset + range->start) >= 0)
+	    && ((range->offset + range->end) < (int64_t)max_size))) {
 		pr_err("ERROR: Out of range detected");
 		err = -EINVAL;
 	}
 
 	if (dst2) {
-		if ((max_size2 > UINT_MAX) || !(((offset2 + start) >= 0)
-		    && ((offset2 + end) < (int64_t)max_size2))) {
+		if ((max_size2 > UINT_MAX) || !(((range->offset2 + range->start) >= 0)
+		    && ((range->offset2 + range->end) < (int64_t)max_size2))) {
 			pr_err("ERROR: Out of range detected");
 			err = -EINVAL;
 		}
 	}
-out:
+
 	return err;
 }
 
+static int32_t check_address_range(struct pva_submit_task *task,
+				   u8 desc_id,
+				   struct nvpva_dma_descriptor const *desc,
+				   uint64_t max_size,
+				   uint64_t max_size2,
+				   bool src_dst,
+				   bool dst2,
+				   int8_t block_height_log2)
+{
+	const struct pva_dma_desc_range *range = NULL;
+	struct pva_dma_desc_range local;
+
+	if (task->dma_cfg != NULL)
+		range = &task->dma_cfg->range[desc_id][src_dst ? 1 : 0];
+
+	if ((range == NULL) || !range->cached) {
+		local.err = compute_address_range(desc, src_dst,
+						  block_height_log2, &local);
+		range = &local;
+	}
+
+	return check_range_size(range, max_size, max_size2, dst2);
+}
+
 static uint16_t
 get_sym_exe_id(struct pva_submit_task *task)
 {
@@ -347,7 +404,7 @@ patch_dma_desc_address(struct pva_submit_task *task,
 			}
 
 			addr_base = mem->dma_addr;
-			err = check_address_range(umd_dma_desc,
+			err = check_address_range(task, desc_id, umd_dma_desc,
 						  mem->size,
 						  0,
 						  false,
@@ -357,7 +414,7 @@ patch_dma_desc_address(struct pva_submit_task *task,
 		} else {
 			addr_base = 0;
 			if (!is_hwseq_mode_frm(task, desc_id))
-				err = check_address_range(umd_dma_desc,
+				err = check_address_range(task, desc_id, umd_dma_desc,
 							  task->l2_alloc_size,
 							  0,
 							  false,
@@ -390,7 +447,7 @@ patch_dma_desc_address(struct pva_submit_task *task,
 			goto out;
 		}
 
-		err = check_address_range(umd_dma_desc,
+		err = check_address_range(task, desc_id, umd_dma_desc,
 					  size,
 					  0,
 					  false,
@@ -445,7 +502,7 @@ patch_dma_desc_address(struct pva_submit_task *task,
 			goto out;
 		}
 		if (!is_hwseq_mode_frm(task, desc_id))
-			err = check_address_range(umd_dma_desc,
+			err = check_address_range(task, desc_id, umd_dma_desc,
 						  mem->size,
 						  0,
 						  false,
@@ -528,7 +585,7 @@ patch_dma_desc_address(struct pva_submit_task *task,
 			}
 
 			addr_base = mem->dma_addr;
-			err = check_address_range(umd_dma_desc,
+			err = check_address_range(task, desc_id, umd_dma_desc,
 						  mem->size,
 						  0,
 						  true,
@@ -537,7 +594,7 @@ patch_dma_desc_address(struct pva_submit_task *task,
 			buff_info->dst_buffer_size = mem->size;
 		} else {
 			addr_base = 0;
-			err = check_address_range(umd_dma_desc,
+			err = check_address_range(task, desc_id, umd_dma_desc,
 						  task->l2_alloc_size,
 						  0,
 						  true,
@@ -603,7 +660,7 @@ patch_dma_desc_address(struct pva_submit_task *task,
 			check_size2 = true;
 		}
 
-		err = check_address_range(umd_dma_desc,
+		err = check_address_range(task, desc_id, umd_dma_desc,
 					  size,
 					  size2,
 					  true,
@@ -633,7 +690,7 @@ patch_dma_desc_address(struct pva_submit_task *task,
 			goto out;
 		}
 
-		err = check_address_range(umd_dma_desc,
+		err = check_address_range(task, desc_id, umd_dma_desc,
 					  mem->size,
 					  0,
 					  true,
@@ -810,6 +867,66 @@ validate_descriptor(const struct nvpva_dma_descriptor *desc,
 
 	return retval;
 }
+static inline u8 pva_dma_config_valid_bit(u32 trigger_mode,
+					  bool dim3_check_relaxed)
+{
+	return 1U << (((trigger_mode == NVPVA_HWSEQTM_DMATRIG) ? 2U : 0U) +
+		      (dim3_check_relaxed ? 1U : 0U));
+}
+
+void pva_dma_config_init(struct pva_dma_config *cfg)
+{
+	const u32 trigger_modes[] = {
+		NVPVA_HWSEQTM_VPUTRIG,
+		NVPVA_HWSEQTM_DMATRIG
+	};
+	struct nvpva_dma_descriptor const *desc;
+	struct pva_dma_desc_range *range;
+	unsigned int i, j;
+
+	for (i = 0; i < cfg->num_descriptors; i++) {
+		desc = &cfg->descriptors[i];
+
+		/* the trigger mode and hwseq mode are only known per task */
+		cfg->desc_valid[i] = 0U;
+		for (j = 0; j < ARRAY_SIZE(trigger_modes); j++) {
+			if (validate_descriptor(desc, trigger_modes[j], false) == 0)
+				cfg->desc_valid[i] |=
+					pva_dma_config_valid_bit(trigger_modes[j], false);
+			if (validate_descriptor(desc, trigger_modes[j], true) == 0)
+				cfg->desc_valid[i] |=
+					pva_dma_config_valid_bit(trigger_modes[j], true);
+		}
+
+		/*
+		 * The block height of block linear surfaces comes from the
+		 * channels of the task, so only pitch linear ranges are kept.
+		 */
+		range = &cfg->range[i][0];
+		range->cached = (desc->srcFormat == 0U);
+		if (range->cached)
+			range->err = compute_address_range(desc, false, 0, range);
+
+		range = &cfg->range[i][1];
+		range->cached = (desc->dstFormat == 0U);
+		if (range->cached)
+			range->err = compute_address_range(desc, true, 0, range);
+	}
+}
+
+static void pva_dma_config_release(struct kref *ref)
+{
+	struct pva_dma_config *cfg =
+		container_of(ref, struct pva_dma_config, ref);
+
+	kfree(cfg);
+}
+
+void pva_dma_config_put(struct pva_dma_config *cfg)
+{
+	kref_put(&cfg->ref, pva_dma_config_release);
+}
+
 /* User to FW DMA descriptor structure mapping helper */
 /* TODO: Need to handle DMA descriptor like dst2ptr and dst2Offset */
 static int32_t nvpva_task_dma_desc_mapping(struct pva_submit_task *task,
@@ -860,9 +977,14 @@ static int32_t nvpva_task_dma_desc_mapping(struct pva_submit_task *task,
 		dim3_check_relaxed = is_hwseq_mode_frm(task, desc_num)
 					|| is_hwseq_mode_t26x(task, desc_num);
 
-		err = validate_descriptor(umd_dma_desc,
-					  task->hwseq_config.hwseqTrigMode,
-					  dim3_check_relaxed);
+		if (task->dma_cfg != NULL)
+			err = (task->dma_cfg->desc_valid[desc_num] &
+			       pva_dma_config_valid_bit(task->hwseq_config.hwseqTrigMode,
+							dim3_check_relaxed)) ? 0 : -EINVAL;
+		else
+			err = validate_descriptor(umd_dma_desc,
+						  task->hwseq_config.hwseqTrigMode,
+						  dim3_check_relaxed);
 		if (err) {
 			task_err(
 			    task,
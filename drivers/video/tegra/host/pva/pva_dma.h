@@ -6,6 +6,8 @@
 #ifndef PVA_DMA_H
 #define PVA_DMA_H
 
+#include <linux/kref.h>
+
 #include "pva_queue.h"
 
 enum nvpva_task_dma_trig_vpu_hw_events {
@@ -77,6 +79,51 @@ enum pva_dma_chan_sig {
 	PVA_HWSEQ_VPUWRITE_START = 0x10000
 };
 
+/**
+ * Extent of the surface accessed by one side of a descriptor
+ *
+ * @start, @end: first and last byte accessed relative to @offset
+ * @offset, @offset2: pitch linear offset of the dst and dst2 surfaces
+ * @err: error found while computing the range
+ * @no_access: dummy transfer or circular buffer, no range check needed
+ * @cached: the range was computed when the config was registered
+ */
+struct pva_dma_desc_range {
+	s64 start;
+	s64 end;
+	s64 offset;
+	s64 offset2;
+	int err;
+	bool no_access;
+	bool cached;
+};
+
+/**
+ * DMA descriptors registered with NVPVA_IOCTL_REGISTER_DMA_CONFIG
+ *
+ * The checks that only depend on the descriptors are done once when the
+ * config is registered. Tasks referencing it get a copy of @descriptors and
+ * only look up, patch and size check the buffer addresses on submit.
+ *
+ * @desc_valid: validate_descriptor() result per trigger mode and DIM3 check
+ * @range: src and dst ranges, see struct pva_dma_desc_range
+ */
+struct pva_dma_config {
+	struct kref ref;
+	u8 num_descriptors;
+	u8 desc_valid[MAX_NUM_DESCS];
+	struct pva_dma_desc_range range[MAX_NUM_DESCS][2];
+	struct nvpva_dma_descriptor descriptors[MAX_NUM_DESCS];
+};
+
+void pva_dma_config_init(struct pva_dma_config *cfg);
+void pva_dma_config_put(struct pva_dma_config *cfg);
+
+static inline void pva_dma_config_get(struct pva_dma_config *cfg)
+{
+	kref_get(&cfg->ref);
+}
+
 int pva_task_write_dma_info(struct pva_submit_task *task,
 			    struct pva_hw_task *hw_task);
 
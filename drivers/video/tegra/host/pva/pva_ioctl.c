@@ -23,12 +23,14 @@
 #include <linux/firmware.h>
 
 #include "pva.h"
+#include "pva_dma.h"
 #include "pva_queue.h"
 #include "nvpva_buffer.h"
 #include "pva_vpu_exe.h"
 #include "pva_vpu_app_auth.h"
 #include "pva_system_allow_list.h"
 #include "nvpva_client.h"
+#include "pva_trace.h"
 /**
  * @brief pva_private - Per-fd specific data
  *
@@ -40,7 +42,12 @@ struct pva_private {
 	struct pva *pva;
 	struct nvpva_queue *queue;
 	struct pva_cb *vpu_print_buffer;
+	struct pva_task_timing_ring *timing_ring;
 	struct nvpva_client_context *client;
+
+	/* DMA configs registered on this file, id - 1 indexes the array */
+	struct mutex dma_configs_lock;
+	struct pva_dma_config *dma_configs[NVPVA_MAX_DMA_CONFIGS];
 };
 
 static int copy_part_from_user(void *kbuffer, size_t kbuffer_size,
@@ -192,7 +199,10 @@ static int pva_copy_task(struct nvpva_ioctl_task *ioctl_task,
 	task->num_user_fence_actions = IOCTL_ARRAY_SIZE(user_fence_actions);
 	task->num_input_task_status = IOCTL_ARRAY_SIZE(input_task_status);
 	task->num_output_task_status = IOCTL_ARRAY_SIZE(output_task_status);
-	task->num_dma_descriptors = IOCTL_ARRAY_SIZE(dma_descriptors);
+	if (task->dma_cfg != NULL)
+		task->num_dma_descriptors = task->dma_cfg->num_descriptors;
+	else
+		task->num_dma_descriptors = IOCTL_ARRAY_SIZE(dma_descriptors);
 	task->num_dma_channels = IOCTL_ARRAY_SIZE(dma_channels);
 	task->num_symbols = IOCTL_ARRAY_SIZE(symbols);
 
@@ -221,9 +231,14 @@ static int pva_copy_task(struct nvpva_ioctl_task *ioctl_task,
 	if (err)
 		goto out;
 
-	err = copy_part_from_user(&task->dma_descriptors,
-				  sizeof(task->dma_descriptors),
-				  ioctl_task->dma_descriptors);
+	if (task->dma_cfg != NULL)
+		memcpy(task->dma_descriptors, task->dma_cfg->descriptors,
+		       task->num_dma_descriptors *
+		       sizeof(task->dma_descriptors[0]));
+	else
+		err = copy_part_from_user(&task->dma_descriptors,
+					  sizeof(task->dma_descriptors),
+					  ioctl_task->dma_descriptors);
 	if (err)
 		goto out;
 
@@ -306,6 +321,68 @@ out:
 	return err;
 }
 
+/* Returns the config with a reference held for the task, or NULL */
+static struct pva_dma_config *pva_dma_config_lookup(struct pva_private *priv,
+						    u64 id)
+{
+	struct pva_dma_config *cfg = NULL;
+
+	if ((id == 0U) || (id > NVPVA_MAX_DMA_CONFIGS))
+		return NULL;
+
+	id = array_index_nospec(id - 1U, NVPVA_MAX_DMA_CONFIGS);
+
+	mutex_lock(&priv->dma_configs_lock);
+	cfg = priv->dma_configs[id];
+	if (cfg != NULL)
+		pva_dma_config_get(cfg);
+	mutex_unlock(&priv->dma_configs_lock);
+
+	return cfg;
+}
+
+/*
+ * Every L2SRAM consumer in a submit needs an earlier producer and every
+ * producer a later consumer, the L2SRAM window is released at the end of
+ * the submit.
+ */
+static int pva_check_l2sram_handoff(struct pva_submit_tasks *tasks_header)
+{
+	bool handoff = false;
+	u32 flags;
+	u16 i;
+
+	for (i = 0; i < tasks_header->num_tasks; i++) {
+		struct pva_submit_task *task = tasks_header->tasks[i];
+
+		flags = task->flags &
+			(NVPVA_L2SRAM_PRODUCER | NVPVA_L2SRAM_CONSUMER);
+		if (flags == 0U)
+			continue;
+
+		if ((task->pva->version == PVA_HW_GEN1) ||
+		    (task->l2_alloc_size == 0U)) {
+			task_err(task, "L2SRAM handoff needs an L2SRAM allocation");
+			return -EINVAL;
+		}
+
+		if ((flags & NVPVA_L2SRAM_CONSUMER) && !handoff) {
+			task_err(task, "L2SRAM consumer without a producer");
+			return -EINVAL;
+		}
+
+		handoff = (flags & NVPVA_L2SRAM_PRODUCER) != 0U;
+	}
+
+	if (handoff) {
+		task_err(tasks_header->tasks[tasks_header->num_tasks - 1U],
+			 "L2SRAM producer without a consumer");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 /**
  * @brief	Submit a task to PVA
  *
@@ -427,14 +504,31 @@ static int pva_submit(struct pva_private *priv, void *arg)
 
 		nvpva_client_context_get(task->client);
 
+		if (ioctl_tasks[i].flags & NVPVA_DMA_CONFIG_ID) {
+			task->dma_cfg = pva_dma_config_lookup(priv,
+					ioctl_tasks[i].dma_descriptors.addr);
+			if (task->dma_cfg == NULL) {
+				task_err(task, "invalid DMA config id: %llu",
+					 ioctl_tasks[i].dma_descriptors.addr);
+				err = -EINVAL;
+				goto free_tasks;
+			}
+		}
+
 		err = pva_copy_task(ioctl_tasks + i, task);
 		if (err)
 			goto free_tasks;
 
 		if (priv->pva->vpu_printf_enabled)
 			task->stdout = priv->vpu_print_buffer;
+
+		task->timing_ring = priv->timing_ring;
 	}
 
+	err = pva_check_l2sram_handoff(tasks_header);
+	if (err)
+		goto free_tasks;
+
 	/* Populate header structure */
 	tasks_header->execution_timeout_us =
 		ioctl_tasks_header->execution_timeout_us;
@@ -495,6 +589,79 @@ out:
 	return err;
 }
 
+static int pva_register_dma_config(struct pva_private *priv, void *arg)
+{
+	union nvpva_dma_config_register_args *args =
+		(union nvpva_dma_config_register_args *)arg;
+	struct nvpva_ioctl_part part = args->in.dma_descriptors;
+	struct pva_dma_config *cfg;
+	u32 i;
+	int err;
+
+	if ((part.size == 0U) ||
+	    (part.size % sizeof(cfg->descriptors[0]) != 0U))
+		return -EINVAL;
+
+	cfg = kzalloc(sizeof(*cfg), GFP_KERNEL);
+	if (cfg == NULL)
+		return -ENOMEM;
+
+	kref_init(&cfg->ref);
+	err = copy_part_from_user(cfg->descriptors, sizeof(cfg->descriptors),
+				  part);
+	if (err)
+		goto free;
+
+	cfg->num_descriptors = part.size / sizeof(cfg->descriptors[0]);
+	pva_dma_config_init(cfg);
+
+	mutex_lock(&priv->dma_configs_lock);
+	for (i = 0; i < NVPVA_MAX_DMA_CONFIGS; i++) {
+		if (priv->dma_configs[i] == NULL)
+			break;
+	}
+
+	if (i < NVPVA_MAX_DMA_CONFIGS) {
+		priv->dma_configs[i] = cfg;
+		args->out.config_id = i + 1U;
+		cfg = NULL;
+	} else {
+		err = -ENOSPC;
+	}
+	mutex_unlock(&priv->dma_configs_lock);
+
+free:
+	if (cfg != NULL)
+		pva_dma_config_put(cfg);
+
+	return err;
+}
+
+static int pva_unregister_dma_config(struct pva_private *priv, void *arg)
+{
+	union nvpva_dma_config_unregister_args *args =
+		(union nvpva_dma_config_unregister_args *)arg;
+	struct pva_dma_config *cfg = NULL;
+	u32 id = args->in.config_id;
+
+	if ((id == 0U) || (id > NVPVA_MAX_DMA_CONFIGS))
+		return -EINVAL;
+
+	id = array_index_nospec(id - 1U, NVPVA_MAX_DMA_CONFIGS);
+
+	/* tasks already submitted keep their own reference */
+	mutex_lock(&priv->dma_configs_lock);
+	swap(cfg, priv->dma_configs[id]);
+	mutex_unlock(&priv->dma_configs_lock);
+
+	if (cfg == NULL)
+		return -EINVAL;
+
+	pva_dma_config_put(cfg);
+
+	return 0;
+}
+
 static int pva_pin(struct pva_private *priv, void *arg)
 {
 	int err = 0;
@@ -614,6 +781,7 @@ static int pva_register_vpu_exec(struct pva_private *priv, void *arg)
 	void			*exec_data = NULL;
 	uint16_t		exe_id;
 	bool			is_system = false;
+	uint32_t		digest[PVA_VPU_APP_DIGEST_WORDS];
 	uint64_t		data_size;
 	int			err = 0;
 
@@ -634,6 +802,11 @@ static int pva_register_vpu_exec(struct pva_private *priv, void *arg)
 		goto free_mem;
 	}
 
+	pva_vpu_app_digest((uint8_t *)exec_data, data_size, digest);
+	if (pva_vpu_app_cache_lookup(priv->pva, digest, &is_system))
+		goto load;
+
+	is_system = false;
 	err = pva_authenticate_vpu_app(priv->pva,
 				       &priv->pva->pva_auth,
 				       (uint8_t *)exec_data,
@@ -651,10 +824,12 @@ static int pva_register_vpu_exec(struct pva_private *priv, void *arg)
 		is_system = true;
 	}
 
+load:
 	err = pva_load_vpu_app(&priv->client->elf_ctx, exec_data,
 				data_size, &exe_id,
 				is_system,
-				priv->pva->version);
+				priv->pva->version,
+				digest);
 
 	if (err) {
 		nvpva_err(&priv->pva->pdev->dev,
@@ -830,6 +1005,41 @@ out:
 	return err;
 }
 
+/*
+ * The timing ring can be set up once per file descriptor. It may be mapped
+ * by user space and referenced by in-flight tasks, so it stays until the
+ * file is released.
+ */
+static int pva_set_task_timing_ring_size(struct pva_private *priv, void *arg)
+{
+	union nvpva_set_task_timing_ring_size_args *in_arg =
+		(union nvpva_set_task_timing_ring_size_args *)arg;
+	struct pva_task_timing_ring *ring;
+	int err = 0;
+
+	ring = pva_task_timing_ring_alloc(in_arg->in.num_records);
+	if (IS_ERR(ring)) {
+		dev_err(&priv->pva->pdev->dev,
+			"failed to allocate task timing ring of %u records\n",
+			in_arg->in.num_records);
+		return PTR_ERR(ring);
+	}
+
+	mutex_lock(&priv->queue->list_lock);
+	if (priv->timing_ring != NULL) {
+		err = -EBUSY;
+		goto unlock;
+	}
+
+	priv->timing_ring = ring;
+	ring = NULL;
+unlock:
+	mutex_unlock(&priv->queue->list_lock);
+	pva_task_timing_ring_free(ring);
+
+	return err;
+}
+
 static ssize_t pva_read_cb(struct pva_cb *cb, u8 __user *buffer,
 			   size_t buffer_size)
 {
@@ -958,6 +1168,15 @@ static long pva_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 	case NVPVA_IOCTL_SET_VPU_PRINT_BUFFER_SIZE:
 		err = pva_set_vpu_print_buffer_size(priv, buf);
 		break;
+	case NVPVA_IOCTL_SET_TASK_TIMING_RING_SIZE:
+		err = pva_set_task_timing_ring_size(priv, buf);
+		break;
+	case NVPVA_IOCTL_REGISTER_DMA_CONFIG:
+		err = pva_register_dma_config(priv, buf);
+		break;
+	case NVPVA_IOCTL_UNREGISTER_DMA_CONFIG:
+		err = pva_unregister_dma_config(priv, buf);
+		break;
 	default:
 		err2 = -ENOIOCTLCMD;
 		break;
@@ -988,6 +1207,7 @@ static int pva_open(struct inode *inode, struct file *file)
 
 	file->private_data = priv;
 	priv->pva = pva;
+	mutex_init(&priv->dma_configs_lock);
 	priv->client = nvpva_client_context_alloc(pdev, pva, current->pid);
 	if (priv->client == NULL) {
 		err = -ENOMEM;
@@ -1020,6 +1240,7 @@ err_alloc_queue:
 	nvpva_client_context_put(priv->client);
 err_alloc_context:
 	nvhost_module_remove_client(pdev, priv);
+	mutex_destroy(&priv->dma_configs_lock);
 	kfree(priv);
 err_alloc_priv:
 	return err;
@@ -1104,6 +1325,15 @@ static int pva_release(struct inode *inode, struct file *file)
 		priv->vpu_print_buffer = NULL;
 	}
 
+	pva_task_timing_ring_free(priv->timing_ring);
+	priv->timing_ring = NULL;
+
+	for (i = 0; i < NVPVA_MAX_DMA_CONFIGS; i++) {
+		if (priv->dma_configs[i] != NULL)
+			pva_dma_config_put(priv->dma_configs[i]);
+	}
+	mutex_destroy(&priv->dma_configs_lock);
+
 	/* Finally, release the private data */
 	kfree(priv);
 
@@ -1132,6 +1362,20 @@ static ssize_t pva_read_vpu_print_buffer(struct file *file,
 	return ret;
 }
 
+static int pva_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct pva_private *priv = file->private_data;
+	int err = -ENODEV;
+
+	mutex_lock(&priv->queue->list_lock);
+	if (priv->timing_ring != NULL)
+		err = pva_task_timing_ring_mmap(priv->timing_ring, vma);
+
+	mutex_unlock(&priv->queue->list_lock);
+
+	return err;
+}
+
 const struct file_operations tegra_pva_ctrl_ops = {
 	.owner = THIS_MODULE,
 	.llseek = no_llseek,
@@ -1142,4 +1386,5 @@ const struct file_operations tegra_pva_ctrl_ops = {
 	.open = pva_open,
 	.release = pva_release,
 	.read = pva_read_vpu_print_buffer,
+	.mmap = pva_mmap,
 };
@@ -40,6 +40,7 @@
 #include "pva_mailbox.h"
 #include "pva_queue.h"
 #include "pva_regs.h"
+#include "pva_trace.h"
 
 #include "pva-vpu-perf.h"
 #include "pva-interface.h"
@@ -147,12 +148,35 @@ static void pva_task_unpin_mem(struct pva_submit_task *task)
 	task->num_pinned = 0;
 }
 
+static struct pva_pinned_memory *find_pinned_mem(struct pva_submit_task *task,
+						 int id)
+{
+	u32 i;
+
+	for (i = 0; i < task->num_pinned; i++)
+		if (task->pinned_memory[i].id == id)
+			return &task->pinned_memory[i];
+	return NULL;
+}
+
+/*
+ * Pin a buffer for the lifetime of the task. DMA descriptors, symbols,
+ * fences and status buffers of one task commonly refer to the same buffer,
+ * so an id already pinned by this task is returned as is, which keeps the
+ * buffer reference taken once and the pinned_memory slots free.
+ */
 struct pva_pinned_memory *pva_task_pin_mem(struct pva_submit_task *task,
 					   u32 id)
 {
 	int err;
 	struct pva_pinned_memory *mem;
 
+	if (id != 0) {
+		mem = find_pinned_mem(task, id);
+		if (mem != NULL)
+			return mem;
+	}
+
 	if (task->num_pinned >= ARRAY_SIZE(task->pinned_memory)) {
 		task_err(task, "too many objects to pin");
 		err = -ENOMEM;
@@ -959,6 +983,9 @@ void pva_task_free(struct kref *ref)
 	mutex_unlock(&my_queue->tail_lock);
 
 	pva_task_unpin_mem(task);
+	if (task->dma_cfg != NULL)
+		pva_dma_config_put(task->dma_cfg);
+
 	if (task->pinned_app) {
 		pva_task_release_ref_vpu_app(&task->client->elf_ctx,
 						     task->exe_id1);
@@ -1022,6 +1049,11 @@ static void update_one_task(struct pva *pva)
 		task_info.error == PVA_ERR_BAD_TASK_ACTION_LIST);
 	hw_task = (struct pva_hw_task *)task->va;
 	stats = &hw_task->statistics;
+	if (task->timing_ring != NULL)
+		pva_task_timing_ring_record(task->timing_ring, task->id,
+					    task->prog_id, task->stream_id,
+					    stats);
+
 	if (!task->pva->stats_enabled)
 		goto prof;
 
@@ -1339,13 +1371,27 @@ update_batch_tasks(const struct pva_submit_tasks *task_header)
 	u32 l2s_start_index, l2s_end_index;
 	u32 l2sram_max_size = 0U;
 	u32 invalid_index = task_header->num_tasks + 1U;
+	bool handoff = false;
+	bool in_window;
 
 	l2s_start_index = invalid_index;
 	l2s_end_index = invalid_index;
 
 	for (task_num = 0; task_num < task_header->num_tasks; task_num++) {
 		task = task_header->tasks[task_num];
-		if (task->l2_alloc_size > 0) {
+
+		/*
+		 * Tasks between an L2SRAM producer and its consumer stay in
+		 * the window, so that the allocation and its contents are not
+		 * released before the consumer runs.
+		 */
+		in_window = (task->l2_alloc_size > 0) || handoff;
+		if (task->flags & NVPVA_L2SRAM_CONSUMER)
+			handoff = false;
+		if (task->flags & NVPVA_L2SRAM_PRODUCER)
+			handoff = true;
+
+		if (in_window) {
 			if (l2s_start_index == invalid_index)
 				l2s_start_index = task_num;
 
@@ -1445,17 +1491,6 @@ unlock:
 	return err;
 }
 
-static struct pva_pinned_memory *find_pinned_mem(struct pva_submit_task *task,
-						 int id)
-{
-	u32 i;
-
-	for (i = 0; i < task->num_pinned; i++)
-		if (task->pinned_memory[i].id == id)
-			return &task->pinned_memory[i];
-	return NULL;
-}
-
 static void pva_queue_cleanup_semaphore(struct pva_submit_task *task,
 					struct nvpva_submit_fence *fence)
 {
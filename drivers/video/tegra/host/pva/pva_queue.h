@@ -36,6 +36,7 @@
 				  NVPVA_TASK_MAX_DMA_CHANNELS_T26X)
 
 struct dma_buf;
+struct pva_dma_config;
 
 extern struct nvpva_queue_ops pva_queue_ops;
 
@@ -132,6 +133,8 @@ struct pva_submit_task {
 
 	u32 l2_alloc_size; /* Not applicable for Xavier */
 	struct pva_cb *stdout;
+	struct pva_task_timing_ring *timing_ring;
+	struct pva_dma_config *dma_cfg;
 	u32 symbol_payload_size;
 
 	u32 flags;
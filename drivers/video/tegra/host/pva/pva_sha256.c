@@ -3,11 +3,19 @@
  * Copyright (c) 2021-2023, NVIDIA Corporation.  All rights reserved.
  */
 
+#include <crypto/hash.h>
+#include <linux/err.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 #include <linux/string.h>
 #include "pva_sha256.h"
 
+/*
+ * The C implementation only keeps the low 32 bits of the message length,
+ * stay on it for anything larger so digests never change.
+ */
+#define PVA_SHA256_CRYPTO_MAX_LEN	(U32(1) << 29)
+
 #define ROTLEFT(a, b) (((a) << (b)) | ((a) >> (32 - (b))))
 #define ROTRIGHT(a, b) (((a) >> (b)) | ((a) << (32 - (b))))
 
@@ -201,3 +209,53 @@ sha256_finalize(struct sha256_ctx_s *ctx,
 	out[6] = SWAP32(ctx->state[6]);
 	out[7] = SWAP32(ctx->state[7]);
 }
+
+/**
+ * Calculate the digest through the kernel crypto API, which picks the
+ * ARMv8 crypto extension implementation when the CPU has it.
+ */
+static int
+pva_sha256_digest_crypto(const void *data,
+			 size_t len,
+			 uint32_t out[8])
+{
+	struct crypto_shash *tfm;
+	int err;
+
+	tfm = crypto_alloc_shash("sha256", 0, 0);
+	if (IS_ERR(tfm))
+		return PTR_ERR(tfm);
+
+	{
+		SHASH_DESC_ON_STACK(desc, tfm);
+
+		desc->tfm = tfm;
+		err = crypto_shash_digest(desc, data, len, (u8 *)out);
+		shash_desc_zero(desc);
+	}
+
+	crypto_free_shash(tfm);
+
+	return err;
+}
+
+void
+pva_sha256_digest(const void *data,
+		  size_t len,
+		  uint32_t out[8])
+{
+	struct sha256_ctx_s ctx;
+	size_t off;
+
+	if ((len < PVA_SHA256_CRYPTO_MAX_LEN) &&
+	    (pva_sha256_digest_crypto(data, len, out) == 0))
+		return;
+
+	sha256_init(&ctx);
+	off = (len / U32(64)) * U32(64);
+	if (off > 0U)
+		pva_sha256_update(&ctx, data, off);
+
+	sha256_finalize(&ctx, ((const uint8_t *)data) + off,
+			len % U32(64), out);
+}
@@ -79,4 +79,21 @@ sha256_finalize(struct sha256_ctx_s *ctx,
 void sha256_copy(const struct sha256_ctx_s *ctx_in,
 		 struct sha256_ctx_s *ctx_out);
 
+/**
+ * \brief
+ * Calculate the sha256 key of a complete buffer in one go. Uses the kernel
+ * crypto API when available and falls back to \ref pva_sha256_update()
+ * and \ref sha256_finalize() otherwise.
+ *
+ * \param[in] data pointer to the data to be hashed
+ * \param[in] len length in bytes of the data to be hashed
+ * \param[out] out places the calcuated sha256 key in out.
+ *
+ * \return void
+ */
+void
+pva_sha256_digest(const void *data,
+		  size_t len,
+		  uint32_t out[8]);
+
 #endif   /* PVA_SHA256_H */
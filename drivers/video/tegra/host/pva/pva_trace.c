@@ -5,10 +5,16 @@
  * PVA trace log
  */
 
+#include <linux/err.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
 #include <trace/events/nvpva_ftrace.h>
+#include <uapi/linux/nvpva_ioctl.h>
 
 #include "pva.h"
 #include "pva_trace.h"
+#include "pva-task.h"
 
 static void read_linear(struct pva *pva, struct pva_trace_log *trace, u32 toff)
 {
@@ -93,3 +99,100 @@ void pva_trace_copy_to_ftrace(struct pva *pva)
 		read_linear(pva, trace, toff);
 	}
 }
+
+struct pva_task_timing_ring *pva_task_timing_ring_alloc(u32 num_records)
+{
+	struct pva_task_timing_ring *ring;
+	size_t size;
+
+	if ((num_records == 0U) ||
+	    (num_records > NVPVA_TASK_TIMING_MAX_RECORDS) ||
+	    !is_power_of_2(num_records))
+		return ERR_PTR(-EINVAL);
+
+	ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+	if (ring == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	size = sizeof(struct nvpva_task_timing_header) +
+	       ((size_t)num_records * sizeof(struct nvpva_task_timing_record));
+	ring->size = PAGE_ALIGN(size);
+	ring->va = vmalloc_user(ring->size);
+	if (ring->va == NULL) {
+		kfree(ring);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	ring->num_records = num_records;
+	ring->header = ring->va;
+	ring->records = ring->va + sizeof(struct nvpva_task_timing_header);
+	spin_lock_init(&ring->lock);
+
+	ring->header->version = NVPVA_TASK_TIMING_VERSION;
+	ring->header->record_size = sizeof(struct nvpva_task_timing_record);
+	ring->header->num_records = num_records;
+	ring->header->records_offset = sizeof(struct nvpva_task_timing_header);
+	ring->header->head = 0;
+
+	return ring;
+}
+
+void pva_task_timing_ring_free(struct pva_task_timing_ring *ring)
+{
+	if (ring == NULL)
+		return;
+
+	vfree(ring->va);
+	kfree(ring);
+}
+
+int pva_task_timing_ring_mmap(struct pva_task_timing_ring *ring,
+			      struct vm_area_struct *vma)
+{
+	if ((vma->vm_pgoff != 0) ||
+	    ((vma->vm_end - vma->vm_start) > ring->size))
+		return -EINVAL;
+
+	/* The ring is written by the driver only */
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+#if defined(NV_VM_AREA_STRUCT_HAS_CONST_VM_FLAGS) /* Linux v6.3 */
+	vm_flags_clear(vma, VM_MAYWRITE);
+#else
+	vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+
+	return remap_vmalloc_range(vma, ring->va, 0);
+}
+
+void pva_task_timing_ring_record(struct pva_task_timing_ring *ring,
+				 u32 task_id, u64 prog_id, u64 stream_id,
+				 const struct pva_task_statistics_s *stats)
+{
+	struct nvpva_task_timing_record *rec;
+	unsigned long flags;
+	u64 head;
+
+	spin_lock_irqsave(&ring->lock, flags);
+	head = ring->header->head;
+	rec = &ring->records[head & (ring->num_records - 1U)];
+
+	rec->task_id = task_id;
+	rec->queue_id = stats->queue_id;
+	rec->vpu = stats->vpu_assigned;
+	rec->prog_id = prog_id;
+	rec->stream_id = stream_id;
+	rec->queued_time = stats->queued_time;
+	rec->head_time = stats->head_time;
+	rec->input_actions_complete = stats->input_actions_complete;
+	rec->vpu_assigned_time = stats->vpu_assigned_time;
+	rec->vpu_start_time = stats->vpu_start_time;
+	rec->vpu_complete_time = stats->vpu_complete_time;
+	rec->complete_time = stats->complete_time;
+
+	/* Publish the record before moving head past it */
+	smp_wmb();
+	WRITE_ONCE(ring->header->head, head + 1U);
+	spin_unlock_irqrestore(&ring->lock, flags);
+}
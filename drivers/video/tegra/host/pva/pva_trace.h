@@ -6,6 +6,9 @@
 #ifndef _PVA_TRACE_H_
 #define _PVA_TRACE_H_
 
+#include <linux/spinlock.h>
+#include <linux/types.h>
+
 /*
  * Individual Trace point
  *
@@ -43,4 +46,30 @@ struct pva_trace_header {
 
 };
 
+struct vm_area_struct;
+struct pva_task_statistics_s;
+struct nvpva_task_timing_header;
+struct nvpva_task_timing_record;
+
+/*
+ * Task timing ring shared read-only with user space, see
+ * NVPVA_IOCTL_SET_TASK_TIMING_RING_SIZE
+ */
+struct pva_task_timing_ring {
+	void *va;
+	size_t size;
+	u32 num_records;
+	struct nvpva_task_timing_header *header;
+	struct nvpva_task_timing_record *records;
+	spinlock_t lock;
+};
+
+struct pva_task_timing_ring *pva_task_timing_ring_alloc(u32 num_records);
+void pva_task_timing_ring_free(struct pva_task_timing_ring *ring);
+int pva_task_timing_ring_mmap(struct pva_task_timing_ring *ring,
+			      struct vm_area_struct *vma);
+void pva_task_timing_ring_record(struct pva_task_timing_ring *ring,
+				 u32 task_id, u64 prog_id, u64 stream_id,
+				 const struct pva_task_statistics_s *stats);
+
 #endif
@@ -189,38 +189,21 @@ pva_auth_allow_list_destroy(struct pva_vpu_auth_s *pva_auth)
 
 /**
  * \brief
- * is_key_match calculates the sha256 key of ELF and checks if it matches with key.
- * \param[in] dataptr Pointer to the data to which sha256 to ba calculated
- * \param[in] size length in bytes of the data to which sha256 to be calculated.
+ * is_key_match checks if the calculated sha256 key of ELF matches with key.
+ * \param[in] calc_key the sha256 key calculated for the ELF.
  * \param[in] key the key with which calculated key would be compared for match.
  * \return The completion status of the operation. Possible values are:
  * \ref 0 Success. Passed in key matched wth calculated key.
  * \ref -EACCES. Passed in Key doesn't match with calcualted key.
  */
 static int32_t
-is_key_match(uint8_t *dataptr,
-	     size_t size,
-	     struct shakey_s key)
+is_key_match(const uint32_t calc_key[8],
+	     const struct shakey_s *key)
 {
 	int32_t err = 0;
-	uint32_t calc_key[8];
-	size_t off;
-	struct sha256_ctx_s ctx1;
-	struct sha256_ctx_s ctx2;
-
-	sha256_init(&ctx1);
-	off = (size / 64U) * 64U;
-	if (off > 0U)
-		pva_sha256_update(&ctx1, dataptr, off);
-
-	/* clone */
-	sha256_copy(&ctx1, &ctx2);
-
-	/* finalize with leftover, if any */
-	sha256_finalize(&ctx2, dataptr + off, size % 64U, calc_key);
 
-	err = memcmp((void *)&(key.sha_key),
-		     (void *)calc_key,
+	err = memcmp((const void *)&(key->sha_key),
+		     (const void *)calc_key,
 		     NVPVA_SHA256_DIGEST_SIZE);
 	if (err != 0)
 		err = -EACCES;
@@ -230,8 +213,8 @@ is_key_match(uint8_t *dataptr,
 
 /**
  * \brief
- * Keeps checking all the keys accociated with match_hash
- * against the calculated sha256 key for dataptr, until it finds a match.
+ * Calculates the sha256 key for dataptr once and keeps checking all the
+ * keys accociated with match_hash against it, until it finds a match.
  * \param[in] pva  Pointer to PVA driver context structure struct \ref nvpva_drv_ctx
  * \param[in] dataptr pointer to ELF data
  * \param[in] size length (in bytes) of ELF data
@@ -248,10 +231,10 @@ check_all_keys_for_match(struct shakey_s *pallkeys,
 			 size_t size,
 			 const struct vpu_hash_vector_s *match_hash)
 {
-	int32_t err = 0;
+	int32_t err = -EACCES;
+	uint32_t calc_key[8];
 	uint32_t idx;
 	uint32_t count;
-	struct shakey_s key;
 	uint32_t i;
 
 	idx = match_hash->index;
@@ -261,9 +244,12 @@ check_all_keys_for_match(struct shakey_s *pallkeys,
 		goto fail;
 	}
 
+	if (count == 0U)
+		goto fail;
+
+	pva_sha256_digest(dataptr, size, calc_key);
 	for (i = 0; i < count; i++) {
-		key = pallkeys[idx+i];
-		err = is_key_match(dataptr, size, key);
+		err = is_key_match(calc_key, &pallkeys[idx+i]);
 		if (err == 0)
 			break;
 	}
@@ -4,6 +4,8 @@
  */
 
 #include <linux/dma-mapping.h>
+#include <linux/kref.h>
+#include <linux/list.h>
 #include <linux/types.h>
 #include <linux/slab.h>
 #include "nvpva_elf_parser.h"
@@ -11,6 +13,7 @@
 #include "pva.h"
 #include "hw_vmem_pva.h"
 #include "pva_vpu_exe.h"
+#include "pva_sha256.h"
 
 #ifdef CONFIG_TEGRA_T26X_GRHOST_PVA
 #include "hw_vmem_pva_t264.h"
@@ -988,9 +991,309 @@ int32_t pva_task_acquire_ref_vpu_app(struct nvpva_elf_context *d,
 	return err;
 }
 
+/*
+ * VPU application cache
+ *
+ * Registering a VPU app authenticates the ELF and parses it into symbol and
+ * segment tables before anything is copied to DMA memory. Clients that keep
+ * restarting register the same ELFs over and over, so the parsed result is
+ * kept per device, keyed by the SHA-256 of the ELF contents. The DMA buffers
+ * themselves are still allocated per registration, since they are mapped
+ * into the SMMU context of the registering client and can not be shared.
+ */
+struct pva_vpu_app_cache_entry {
+	struct list_head node;
+	struct kref ref;
+	uint32_t digest[PVA_VPU_APP_DIGEST_WORDS];
+	/* True if the ELF passed authentication when it was inserted */
+	bool auth_verified;
+	bool is_system_app;
+	/* Bytes accounted against the cache size */
+	size_t size;
+	/* Parsed image, no DMA memory attached */
+	struct pva_elf_image *image;
+};
+
+void pva_vpu_app_digest(const uint8_t *buffer, size_t size,
+			uint32_t digest[PVA_VPU_APP_DIGEST_WORDS])
+{
+	pva_sha256_digest(buffer, size, digest);
+}
+
+static void pva_elf_image_free_local(struct pva_elf_image *image)
+{
+	uint32_t i;
+
+	for (i = 0; i < image->num_symbols; i++)
+		kfree(image->sym[i].symbol_name);
+
+	for (i = 0; i < PVA_SEG_VPU_MAX_TYPE; i++)
+		kfree(image->vpu_segments_buffer[i].localbuffer);
+
+	kfree(image->vpu_data_segment_info.localbuffer);
+}
+
+static int32_t pva_elf_buffer_dup_local(struct pva_elf_buffer *dst,
+					const struct pva_elf_buffer *src)
+{
+	dst->localbuffer = NULL;
+	if (src->localbuffer == NULL)
+		return 0;
+
+	dst->localbuffer = kmemdup(src->localbuffer, src->localsize,
+				   GFP_KERNEL);
+	if (dst->localbuffer == NULL)
+		return -ENOMEM;
+
+	return 0;
+}
+
+/*
+ * Copy the parsed state of src into dst. Every pointer owned by dst is either
+ * a private copy or NULL on return, so a partially copied image can be
+ * released with vpu_bin_clean().
+ */
+static int32_t pva_elf_image_dup_local(struct pva_elf_image *dst,
+				       const struct pva_elf_image *src)
+{
+	int32_t err = 0;
+	uint32_t i;
+
+	(void)memcpy(dst, src, sizeof(*dst));
+	for (i = 0; i < dst->num_symbols; i++)
+		dst->sym[i].symbol_name = NULL;
+
+	for (i = 0; i < PVA_SEG_VPU_MAX_TYPE; i++)
+		dst->vpu_segments_buffer[i].localbuffer = NULL;
+
+	dst->vpu_data_segment_info.localbuffer = NULL;
+
+	for (i = 0; i < dst->num_symbols; i++) {
+		dst->sym[i].symbol_name = kmemdup(src->sym[i].symbol_name,
+						  ELF_MAX_SYMBOL_LENGTH,
+						  GFP_KERNEL);
+		if (dst->sym[i].symbol_name == NULL) {
+			err = -ENOMEM;
+			goto out;
+		}
+	}
+
+	for (i = 0; i < PVA_SEG_VPU_MAX_TYPE; i++) {
+		err = pva_elf_buffer_dup_local(&dst->vpu_segments_buffer[i],
+					       &src->vpu_segments_buffer[i]);
+		if (err)
+			goto out;
+	}
+
+	err = pva_elf_buffer_dup_local(&dst->vpu_data_segment_info,
+				       &src->vpu_data_segment_info);
+out:
+	return err;
+}
+
+static size_t pva_elf_image_local_size(const struct pva_elf_image *image)
+{
+	size_t size = sizeof(*image);
+	uint32_t i;
+
+	size += (size_t)image->num_symbols * ELF_MAX_SYMBOL_LENGTH;
+	for (i = 0; i < PVA_SEG_VPU_MAX_TYPE; i++)
+		size += image->vpu_segments_buffer[i].localsize;
+
+	size += image->vpu_data_segment_info.localsize;
+
+	return size;
+}
+
+static void pva_vpu_app_cache_entry_release(struct kref *ref)
+{
+	struct pva_vpu_app_cache_entry *entry =
+		container_of(ref, struct pva_vpu_app_cache_entry, ref);
+
+	pva_elf_image_free_local(entry->image);
+	kfree(entry->image);
+	kfree(entry);
+}
+
+static void pva_vpu_app_cache_evict_locked(struct pva_vpu_app_cache *cache,
+					   struct pva_vpu_app_cache_entry *entry)
+{
+	list_del(&entry->node);
+	cache->size -= entry->size;
+	kref_put(&entry->ref, pva_vpu_app_cache_entry_release);
+}
+
+static struct pva_vpu_app_cache_entry *
+pva_vpu_app_cache_get(struct pva_vpu_app_cache *cache,
+		      const uint32_t *digest)
+{
+	struct pva_vpu_app_cache_entry *entry;
+
+	mutex_lock(&cache->lock);
+	list_for_each_entry(entry, &cache->lru, node) {
+		if (memcmp(entry->digest, digest, sizeof(entry->digest)) != 0)
+			continue;
+
+		list_move(&entry->node, &cache->lru);
+		kref_get(&entry->ref);
+		mutex_unlock(&cache->lock);
+		return entry;
+	}
+	mutex_unlock(&cache->lock);
+
+	return NULL;
+}
+
+bool pva_vpu_app_cache_lookup(struct pva *pva, const uint32_t *digest,
+			      bool *is_system_app)
+{
+	struct pva_vpu_app_cache_entry *entry;
+	bool verified = false;
+
+	entry = pva_vpu_app_cache_get(&pva->vpu_app_cache, digest);
+	if (entry == NULL)
+		goto out;
+
+	verified = entry->auth_verified;
+	*is_system_app = entry->is_system_app;
+	kref_put(&entry->ref, pva_vpu_app_cache_entry_release);
+out:
+	return verified;
+}
+
+/*
+ * Fill a freshly assigned image from the cache. Returns -ENOENT on a miss,
+ * in which case the image is left untouched.
+ */
+static int32_t pva_vpu_app_cache_clone(struct pva *pva,
+				       const uint32_t *digest,
+				       struct pva_elf_image *image)
+{
+	struct pva_vpu_app_cache *cache = &pva->vpu_app_cache;
+	struct pva_vpu_app_cache_entry *entry;
+	uint16_t elf_id = image->elf_id;
+	bool is_system_app = image->is_system_app;
+	int32_t err;
+
+	entry = pva_vpu_app_cache_get(cache, digest);
+	if (entry == NULL) {
+		mutex_lock(&cache->lock);
+		cache->misses++;
+		mutex_unlock(&cache->lock);
+		return -ENOENT;
+	}
+
+	err = pva_elf_image_dup_local(image, entry->image);
+	image->elf_id = elf_id;
+	image->is_system_app = is_system_app;
+	kref_put(&entry->ref, pva_vpu_app_cache_entry_release);
+
+	if (err == 0) {
+		mutex_lock(&cache->lock);
+		cache->hits++;
+		mutex_unlock(&cache->lock);
+	}
+
+	return err;
+}
+
+static void pva_vpu_app_cache_insert(struct pva *pva,
+				     const uint32_t *digest,
+				     const struct pva_elf_image *image)
+{
+	struct pva_vpu_app_cache *cache = &pva->vpu_app_cache;
+	struct pva_vpu_app_cache_entry *entry;
+	struct pva_vpu_app_cache_entry *tmp;
+	size_t size = pva_elf_image_local_size(image);
+
+	if (size > READ_ONCE(cache->max_size))
+		return;
+
+	entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+	if (entry == NULL)
+		return;
+
+	entry->image = kzalloc(sizeof(*entry->image), GFP_KERNEL);
+	if (entry->image == NULL)
+		goto free_entry;
+
+	if (pva_elf_image_dup_local(entry->image, image) != 0)
+		goto free_image;
+
+	entry->image->user_registered = false;
+	atomic_set(&entry->image->submit_refcount, 0);
+	(void)memcpy(entry->digest, digest, sizeof(entry->digest));
+	entry->is_system_app = image->is_system_app;
+	entry->auth_verified = image->is_system_app ?
+			       pva->pva_auth_sys.pva_auth_enable :
+			       pva->pva_auth.pva_auth_enable;
+	entry->size = size;
+	kref_init(&entry->ref);
+
+	mutex_lock(&cache->lock);
+	list_for_each_entry(tmp, &cache->lru, node) {
+		if (memcmp(tmp->digest, digest, sizeof(tmp->digest)) == 0) {
+			/* Raced with another registration of the same ELF */
+			mutex_unlock(&cache->lock);
+			kref_put(&entry->ref, pva_vpu_app_cache_entry_release);
+			return;
+		}
+	}
+
+	while (!list_empty(&cache->lru) &&
+	       (cache->size + size > cache->max_size)) {
+		tmp = list_last_entry(&cache->lru,
+				      struct pva_vpu_app_cache_entry, node);
+		pva_vpu_app_cache_evict_locked(cache, tmp);
+	}
+
+	list_add(&entry->node, &cache->lru);
+	cache->size += size;
+	mutex_unlock(&cache->lock);
+
+	return;
+
+free_image:
+	pva_elf_image_free_local(entry->image);
+	kfree(entry->image);
+free_entry:
+	kfree(entry);
+}
+
+void pva_vpu_app_cache_flush(struct pva *pva)
+{
+	struct pva_vpu_app_cache *cache = &pva->vpu_app_cache;
+	struct pva_vpu_app_cache_entry *entry;
+	struct pva_vpu_app_cache_entry *tmp;
+
+	mutex_lock(&cache->lock);
+	list_for_each_entry_safe(entry, tmp, &cache->lru, node)
+		pva_vpu_app_cache_evict_locked(cache, entry);
+	mutex_unlock(&cache->lock);
+}
+
+void pva_vpu_app_cache_init(struct pva *pva)
+{
+	struct pva_vpu_app_cache *cache = &pva->vpu_app_cache;
+
+	INIT_LIST_HEAD(&cache->lru);
+	mutex_init(&cache->lock);
+	cache->size = 0;
+	cache->max_size = PVA_VPU_APP_CACHE_DEFAULT_SIZE;
+	cache->hits = 0;
+	cache->misses = 0;
+}
+
+void pva_vpu_app_cache_deinit(struct pva *pva)
+{
+	pva_vpu_app_cache_flush(pva);
+	mutex_destroy(&pva->vpu_app_cache.lock);
+}
+
 int32_t pva_load_vpu_app(struct nvpva_elf_context *d, uint8_t *buffer,
 			 size_t size, uint16_t *exe_id,
-			 bool is_system_app, int hw_gen)
+			 bool is_system_app, int hw_gen,
+			 const uint32_t *digest)
 {
 	void *elf = NULL;
 	int32_t err = 0;
@@ -1011,6 +1314,16 @@ int32_t pva_load_vpu_app(struct nvpva_elf_context *d, uint8_t *buffer,
 	}
 	elf = (void *)buffer;
 	image = get_elf_image(d, assigned_exe_id);
+	if (digest != NULL) {
+		err = pva_vpu_app_cache_clone(pva, digest, image);
+		if (err == 0)
+			goto write_bin_info;
+
+		if (err != -ENOENT) {
+			dev_err(dev, "Copying cached VPU app failed");
+			goto out_elf_end;
+		}
+	}
 	err = populate_symtab(elf, d, assigned_exe_id, pva->version);
 	if (err) {
 		dev_err(dev, "Populating symbol table failed");
@@ -1023,6 +1336,9 @@ int32_t pva_load_vpu_app(struct nvpva_elf_context *d, uint8_t *buffer,
 		err = -EINVAL;
 		goto out_elf_end;
 	}
+	if (digest != NULL)
+		pva_vpu_app_cache_insert(pva, digest, image);
+write_bin_info:
 	err = write_bin_info(d, image);
 	if (err) {
 		dev_err(dev, "Writing bin_info failed");
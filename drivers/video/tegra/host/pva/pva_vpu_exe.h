@@ -17,6 +17,8 @@
 #define MAX_NUM_VPU_EXE		65535U
 #define ALOC_SEGMENT_SIZE	32U
 #define NUM_ALLOC_SEGMENTS	((MAX_NUM_VPU_EXE + 1)/ALOC_SEGMENT_SIZE)
+#define PVA_VPU_APP_DIGEST_WORDS	8U
+#define PVA_VPU_APP_CACHE_DEFAULT_SIZE	(16U * 1024U * 1024U)
 
 /**
  * enum to identify different types of symbols
@@ -246,6 +248,8 @@ struct pva_elf_image *get_elf_image(struct nvpva_elf_context *d,
  *			by this function
  * @param hwid		HWID associated with the VPU APP used for
  *			allocation
+ * @param *digest	SHA-256 of the VPU APP elf file used to look up
+ *			and populate the VPU app cache, NULL to bypass it
  *
  * @return		0 if everything is valid and VPU APP is
  *			loaded successfully
@@ -253,7 +257,46 @@ struct pva_elf_image *get_elf_image(struct nvpva_elf_context *d,
 int32_t
 pva_load_vpu_app(struct nvpva_elf_context *d, uint8_t *buffer,
 		     size_t size, uint16_t *exe_id,
-		     bool is_system_app, int hw_gen);
+		     bool is_system_app, int hw_gen,
+		     const uint32_t *digest);
+
+/**
+ * Calculate the VPU app cache key of an elf file
+ *
+ * @param *buffer	Buffer containing the VPU APP elf file
+ * @param size		Size of the VPU APP elf file
+ * @param digest	SHA-256 of the buffer, filled by this function
+ */
+void pva_vpu_app_digest(const uint8_t *buffer, size_t size,
+			uint32_t digest[PVA_VPU_APP_DIGEST_WORDS]);
+
+/**
+ * Check if an authenticated copy of an elf file is cached
+ *
+ * @param pva		Pointer to the PVA device
+ * @param *digest	SHA-256 of the VPU APP elf file
+ * @param *is_system_app	Filled with the cached system app flag
+ *
+ * @return		true if the elf file is cached and passed
+ *			authentication when it was cached
+ */
+bool pva_vpu_app_cache_lookup(struct pva *pva, const uint32_t *digest,
+			      bool *is_system_app);
+
+/**
+ * Drop all entries from the VPU app cache
+ *
+ * @param pva		Pointer to the PVA device
+ */
+void pva_vpu_app_cache_flush(struct pva *pva);
+
+/**
+ * Initialize and deinitialize the VPU app cache of a PVA device
+ *
+ * @param pva		Pointer to the PVA device
+ */
+void pva_vpu_app_cache_init(struct pva *pva);
+void pva_vpu_app_cache_deinit(struct pva *pva);
 
 /**
  * Unload VPU APP elf file
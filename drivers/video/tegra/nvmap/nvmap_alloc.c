@@ -34,6 +34,7 @@ bool nvmap_convert_iovmm_to_carveout;
 
 u32 nvmap_max_handle_count;
 u64 nvmap_big_page_allocs;
+u64 nvmap_huge_page_allocs;
 u64 nvmap_total_page_allocs;
 
 /* handles may be arbitrarily large (16+MiB), and any handle allocated from
@@ -474,6 +475,50 @@ static int alloc_colored(u32 nr_pages,
 	return 0;
 }
 
+#ifdef CONFIG_ARM64_4K_PAGES
+static bool s_huge_pages = true;
+module_param_named(huge_pages, s_huge_pages, bool, 0644);
+
+/*
+ * Fill pages[start, nr_page) with naturally aligned, physically contiguous
+ * chunks of chunk_pages pages taken straight from the buddy allocator, and
+ * return the index of the first page left unfilled. Only opportunistic: the
+ * gfp mask avoids direct/kswapd reclaim and emergency reserves, so the caller
+ * falls back to smaller chunks as soon as memory is fragmented.
+ *
+ * The chunks are split into order-0 pages so that free and the page pool
+ * keep treating them like any other handle pages. sg_alloc_table_from_pages()
+ * merges them back into one segment, which the SMMU then maps with the
+ * matching block size, provided the chunk lands at an equally aligned IOVA
+ * offset. Callers must therefore fill the largest chunks first.
+ */
+static int handle_alloc_chunks(struct page **pages, int start, size_t nr_page,
+			       int chunk_pages, gfp_t gfp, int numa_id)
+{
+	gfp_t gfp_no_reclaim = (gfp | __GFP_NOMEMALLOC | __GFP_NOWARN) &
+				~__GFP_RECLAIM;
+	int i, idx;
+
+	if (chunk_pages <= 1)
+		return start;
+
+	for (i = start; (nr_page - i) >= chunk_pages; i += chunk_pages) {
+		struct page *page;
+
+		page = nvmap_alloc_pages_exact(gfp_no_reclaim,
+				chunk_pages << PAGE_SHIFT, true, numa_id);
+		if (!page)
+			break;
+
+		for (idx = 0; idx < chunk_pages; idx++)
+			pages[i + idx] = nth_page(page, idx);
+		nvmap_clean_cache(&pages[i], chunk_pages);
+	}
+
+	return i;
+}
+#endif /* CONFIG_ARM64_4K_PAGES */
+
 static int handle_page_alloc(struct nvmap_client *client,
 			     struct nvmap_handle *h, bool contiguous)
 {
@@ -488,6 +533,7 @@ static int handle_page_alloc(struct nvmap_client *client,
 #else
 	int pages_per_big_pg = 0;
 #endif
+	int huge_index;
 #endif /* CONFIG_ARM64_4K_PAGES */
 #if KERNEL_VERSION(4, 15, 0) > LINUX_VERSION_CODE
 	static u32 chipid;
@@ -522,34 +568,34 @@ static int handle_page_alloc(struct nvmap_client *client,
 
 	} else {
 #ifdef CONFIG_ARM64_4K_PAGES
+		/*
+		 * Large handles (DL tensors, frame buffers) are backed by 2M
+		 * chunks first so the SMMU can map them with block entries.
+		 * They have to come before the 64K chunks: the IOVA of the
+		 * mapping is aligned to its size, so only the leading part of
+		 * the page array keeps 2M alignment between IOVA and PA.
+		 */
+		if (s_huge_pages) {
+			page_index = handle_alloc_chunks(pages, 0, nr_page,
+					NVMAP_HUGE_PAGE_SIZE >> PAGE_SHIFT,
+					gfp, h->numa_id);
+			nvmap_huge_page_allocs += page_index;
+		}
+		huge_index = page_index;
 #ifdef NVMAP_CONFIG_PAGE_POOLS
 		/* Get as many big pages from the pool as possible. */
-		page_index = nvmap_page_pool_alloc_lots_bp(&nvmap_dev->pool, pages,
-							nr_page, true, h->numa_id);
+		page_index += nvmap_page_pool_alloc_lots_bp(&nvmap_dev->pool,
+							&pages[page_index],
+							nr_page - page_index,
+							true, h->numa_id);
 		pages_per_big_pg = nvmap_dev->pool.pages_per_big_pg;
 #endif
 		/* Try to allocate big pages from page allocator */
-		for (i = page_index;
-		     i < nr_page && pages_per_big_pg > 1 && (nr_page - i) >= pages_per_big_pg;
-		     i += pages_per_big_pg, page_index += pages_per_big_pg) {
-			struct page *page;
-			int idx;
-			/*
-			 * set the gfp not to trigger direct/kswapd reclaims and
-			 * not to use emergency reserves.
-			 */
-			gfp_t gfp_no_reclaim = (gfp | __GFP_NOMEMALLOC) & ~__GFP_RECLAIM;
-
-			page = nvmap_alloc_pages_exact(gfp_no_reclaim,
-					pages_per_big_pg << PAGE_SHIFT, true, h->numa_id);
-			if (!page)
-				break;
-
-			for (idx = 0; idx < pages_per_big_pg; idx++)
-				pages[i + idx] = nth_page(page, idx);
-			nvmap_clean_cache(&pages[i], pages_per_big_pg);
-		}
-		nvmap_big_page_allocs += page_index;
+		page_index = handle_alloc_chunks(pages, page_index, nr_page,
+						 pages_per_big_pg, gfp,
+						 h->numa_id);
+		nvmap_big_page_allocs += page_index - huge_index;
+		i = page_index;
 #endif /* CONFIG_ARM64_4K_PAGES */
 		if (s_nr_colors <= 1) {
 #ifdef NVMAP_CONFIG_PAGE_POOLS
@@ -843,6 +889,28 @@ static const unsigned int heap_policy_excl[] = {
 	0,
 };
 
+/*
+ * Commit the usage charged by nvmap_alloc_handle to the client's reference
+ * to the handle, and charge the handle to its tag.
+ */
+static void nvmap_account_alloc(struct nvmap_client *client,
+				struct nvmap_handle *h)
+{
+	struct nvmap_handle_ref *ref;
+
+	nvmap_tag_usage_charge(h);
+
+	nvmap_ref_lock(client);
+	ref = __nvmap_validate_locked(client, h, false);
+	if (ref && !ref->accounted) {
+		ref->accounted = true;
+		nvmap_usage_commit(&client->usage, h);
+	} else {
+		nvmap_usage_cancel(&client->usage, h->size);
+	}
+	nvmap_ref_unlock(client);
+}
+
 int nvmap_alloc_handle(struct nvmap_client *client,
 		       struct nvmap_handle *h, unsigned int heap_mask,
 		       size_t align,
@@ -855,6 +923,8 @@ int nvmap_alloc_handle(struct nvmap_client *client,
 	int err = -ENOMEM;
 	int tag, i;
 	bool alloc_from_excl = false;
+	bool charged = false;
+	ktime_t lat_start = nvmap_lat_start();
 
 	h = nvmap_handle_get(h);
 
@@ -917,6 +987,11 @@ int nvmap_alloc_handle(struct nvmap_client *client,
 		goto out;
 	}
 
+	/* err is still -ENOMEM here */
+	if (nvmap_usage_try_charge(&client->usage, h->size))
+		goto out;
+	charged = true;
+
 	alloc_policy = alloc_from_excl ? heap_policy_excl :
 			(nr_page == 1) ? heap_policy_small : heap_policy_large;
 
@@ -948,13 +1023,17 @@ out:
 			nvmap_stats_inc(NS_KALLOC, h->size);
 		else
 			nvmap_stats_inc(NS_UALLOC, h->size);
+		nvmap_account_alloc(client, h);
 		NVMAP_TAG_TRACE(trace_nvmap_alloc_handle_done,
 			NVMAP_TP_ARGS_CHR(client, h, NULL));
 		err = 0;
 	} else {
+		if (charged)
+			nvmap_usage_cancel(&client->usage, h->size);
 		nvmap_stats_dec(NS_TOTAL, h->size);
 		nvmap_stats_dec(NS_ALLOC, h->size);
 	}
+	nvmap_lat_record(NL_ALLOC, h->size, lat_start);
 	nvmap_handle_put(h);
 	return err;
 }
@@ -1030,6 +1109,7 @@ void _nvmap_handle_free(struct nvmap_handle *h)
 	if (!h->alloc)
 		goto out;
 
+	nvmap_tag_usage_uncharge(h);
 	nvmap_stats_inc(NS_RELEASE, h->size);
 	nvmap_stats_dec(NS_TOTAL, h->size);
 	if (!h->heap_pgalloc) {
@@ -1121,8 +1201,11 @@ void nvmap_free_handle(struct nvmap_client *client,
 
 	smp_rmb();
 	rb_erase(&ref->node, &client->handle_refs);
+	nvmap_ref_hash_remove(client, ref);
 	client->handle_count--;
 	atomic_dec(&ref->handle->share_count);
+	if (ref->accounted)
+		nvmap_usage_uncharge(&client->usage, h);
 
 	nvmap_ref_unlock(client);
 
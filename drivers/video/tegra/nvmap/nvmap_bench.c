@@ -0,0 +1,226 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Nvmap allocation, cache maintenance and dma-buf map microbenchmark
+ */
+
+#include <linux/debugfs.h>
+#include <linux/dma-buf.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
+#include <linux/nvmap.h>
+#include <linux/seq_file.h>
+#include <linux/sizes.h>
+
+#include "nvmap_priv.h"
+
+/*
+ * Reading nvmap/bench/run allocates, cache maintains, dma-buf maps and frees
+ * iterations handles of each power of two size from min_size to max_size,
+ * from heap_mask with the given handle flags, one handle at a time so that
+ * the frees refill the page pool for the next allocation. ns/op is the mean
+ * over the iterations, the pool columns are the deltas over one size.
+ * cflush is the bytes written back, counted only while stats/collect is set.
+ */
+static u32 bench_heap_mask = NVMAP_HEAP_IOVMM;
+static u32 bench_flags = NVMAP_HANDLE_CACHEABLE;
+static u32 bench_min_size = PAGE_SIZE;
+static u32 bench_max_size = SZ_4M;
+static u32 bench_iterations = 64;
+static DEFINE_MUTEX(bench_lock);
+
+struct nvmap_bench_result {
+	u64 alloc_ns;
+	u64 maint_ns;
+	u64 map_ns;
+	u64 free_ns;
+	u64 cflush_bytes;
+	s64 pp_zeroed;
+#ifdef NVMAP_CONFIG_PAGE_POOL_DEBUG
+	u64 pp_hits;
+	u64 pp_misses;
+#endif
+};
+
+static u64 nvmap_bench_pp_zeroed(void)
+{
+#ifdef NVMAP_CONFIG_PAGE_POOLS
+	return nvmap_page_pool_get_zeroed_pages();
+#else
+	return 0;
+#endif
+}
+
+static int nvmap_bench_one(struct nvmap_client *client, size_t size,
+			   struct nvmap_bench_result *res)
+{
+	struct nvmap_handle_ref *ref;
+	struct dma_buf_attachment *attach;
+	struct nvmap_handle *h;
+	struct sg_table *sgt;
+	ktime_t t0, t1;
+	int err;
+
+	t0 = ktime_get();
+	ref = nvmap_create_handle(client, size, false);
+	if (IS_ERR(ref))
+		return PTR_ERR(ref);
+	h = ref->handle;
+
+	err = nvmap_alloc_handle(client, h, bench_heap_mask, PAGE_SIZE,
+				 0, /* no kind */
+				 bench_flags, NVMAP_IVM_INVALID_PEER);
+	t1 = ktime_get();
+	if (err)
+		goto free;
+	res->alloc_ns += ktime_to_ns(ktime_sub(t1, t0));
+
+	t0 = ktime_get();
+	err = __nvmap_do_cache_maint(client, h, 0, h->size,
+				     NVMAP_CACHE_OP_WB_INV, false);
+	t1 = ktime_get();
+	if (err)
+		goto free;
+	res->maint_ns += ktime_to_ns(ktime_sub(t1, t0));
+
+	t0 = ktime_get();
+	attach = dma_buf_attach(h->dmabuf, nvmap_dev->dev_user.parent);
+	if (IS_ERR(attach)) {
+		err = PTR_ERR(attach);
+		goto free;
+	}
+
+	sgt = dma_buf_map_attachment(attach, DMA_BIDIRECTIONAL);
+	if (IS_ERR(sgt)) {
+		err = PTR_ERR(sgt);
+		dma_buf_detach(h->dmabuf, attach);
+		goto free;
+	}
+
+	dma_buf_unmap_attachment(attach, sgt, DMA_BIDIRECTIONAL);
+	dma_buf_detach(h->dmabuf, attach);
+	t1 = ktime_get();
+	res->map_ns += ktime_to_ns(ktime_sub(t1, t0));
+
+free:
+	t0 = ktime_get();
+	nvmap_free_handle(client, h, false);
+	t1 = ktime_get();
+	res->free_ns += ktime_to_ns(ktime_sub(t1, t0));
+
+	return err;
+}
+
+static int nvmap_bench_run_show(struct seq_file *s, void *unused)
+{
+	struct nvmap_bench_result res;
+	struct nvmap_client *client;
+	u32 iterations;
+	size_t size;
+	u64 cflush;
+	s64 zeroed;
+	int err = 0;
+	u32 i;
+
+	mutex_lock(&bench_lock);
+
+	iterations = max_t(u32, bench_iterations, 1);
+	if (!bench_min_size || bench_min_size > bench_max_size) {
+		err = -EINVAL;
+		goto unlock;
+	}
+
+	client = __nvmap_create_client(nvmap_dev, "bench");
+	if (!client) {
+		err = -ENOMEM;
+		goto unlock;
+	}
+
+	seq_printf(s, "heap_mask 0x%x flags 0x%x iterations %u\n",
+		   bench_heap_mask, bench_flags, iterations);
+	seq_printf(s, "%10s %10s %10s %10s %10s %12s %10s",
+		   "size", "alloc_ns", "maint_ns", "map_ns", "free_ns",
+		   "cflush", "pp_zeroed");
+#ifdef NVMAP_CONFIG_PAGE_POOL_DEBUG
+	seq_printf(s, " %10s %10s", "pp_hits", "pp_misses");
+#endif
+	seq_puts(s, "\n");
+
+	for (size = PAGE_ALIGN(bench_min_size); size <= bench_max_size;
+	     size <<= 1) {
+		memset(&res, 0, sizeof(res));
+		cflush = nvmap_stats_read(NS_CFLUSH_DONE);
+		zeroed = nvmap_bench_pp_zeroed();
+#ifdef NVMAP_CONFIG_PAGE_POOL_DEBUG
+		res.pp_hits = nvmap_dev->pool.hits;
+		res.pp_misses = nvmap_dev->pool.misses;
+#endif
+
+		for (i = 0; i < iterations; i++) {
+			err = nvmap_bench_one(client, size, &res);
+			if (err)
+				break;
+			cond_resched();
+		}
+
+		if (err) {
+			seq_printf(s, "%10zu failed: %d\n", size, err);
+			break;
+		}
+
+		res.cflush_bytes = nvmap_stats_read(NS_CFLUSH_DONE) - cflush;
+		res.pp_zeroed = (s64)nvmap_bench_pp_zeroed() - zeroed;
+		seq_printf(s, "%10zu %10llu %10llu %10llu %10llu %12llu %10lld",
+			   size, div_u64(res.alloc_ns, iterations),
+			   div_u64(res.maint_ns, iterations),
+			   div_u64(res.map_ns, iterations),
+			   div_u64(res.free_ns, iterations),
+			   res.cflush_bytes, res.pp_zeroed);
+#ifdef NVMAP_CONFIG_PAGE_POOL_DEBUG
+		seq_printf(s, " %10llu %10llu",
+			   nvmap_dev->pool.hits - res.pp_hits,
+			   nvmap_dev->pool.misses - res.pp_misses);
+#endif
+		seq_puts(s, "\n");
+	}
+
+	nvmap_client_put(client);
+unlock:
+	mutex_unlock(&bench_lock);
+	return err;
+}
+
+static int nvmap_bench_run_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvmap_bench_run_show, inode->i_private);
+}
+
+static const struct file_operations nvmap_bench_run_fops = {
+	.open = nvmap_bench_run_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+void nvmap_bench_init(struct dentry *nvmap_debug_root)
+{
+	struct dentry *bench_root;
+
+	bench_root = debugfs_create_dir("bench", nvmap_debug_root);
+	if (IS_ERR_OR_NULL(bench_root))
+		return;
+
+	debugfs_create_x32("heap_mask", S_IRUGO | S_IWUSR, bench_root,
+			   &bench_heap_mask);
+	debugfs_create_x32("flags", S_IRUGO | S_IWUSR, bench_root,
+			   &bench_flags);
+	debugfs_create_u32("min_size", S_IRUGO | S_IWUSR, bench_root,
+			   &bench_min_size);
+	debugfs_create_u32("max_size", S_IRUGO | S_IWUSR, bench_root,
+			   &bench_max_size);
+	debugfs_create_u32("iterations", S_IRUGO | S_IWUSR, bench_root,
+			   &bench_iterations);
+	debugfs_create_file("run", S_IRUSR, bench_root, NULL,
+			    &nvmap_bench_run_fops);
+}
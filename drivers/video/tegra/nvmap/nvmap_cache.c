@@ -68,23 +68,10 @@ void inner_cache_maint(unsigned int op, void *vaddr, size_t size)
 		__dma_map_area(vaddr, size, DMA_TO_DEVICE);
 }
 
-static void heap_page_cache_maint(
-	struct nvmap_handle *h, unsigned long start, unsigned long end,
-	unsigned int op, bool inner, bool outer, bool clean_only_dirty)
+static void heap_page_range_cache_maint(struct nvmap_handle *h,
+		unsigned long start, unsigned long end, unsigned int op,
+		bool inner, bool outer)
 {
-	/* Don't perform cache maint for RO mapped buffers */
-	if (h->from_va && h->is_ro)
-		return;
-
-	if (h->userflags & NVMAP_HANDLE_CACHE_SYNC) {
-		/*
-		 * zap user VA->PA mappings so that any access to the pages
-		 * will result in a fault and can be marked dirty
-		 */
-		nvmap_handle_mkclean(h, start, end-start);
-		nvmap_zap_handle(h, start, end - start);
-	}
-
 	if (inner) {
 		if (!h->vaddr) {
 			if (__nvmap_mmap(h))
@@ -123,6 +110,78 @@ per_page_cache_maint:
 	}
 }
 
+/*
+ * Write back only the pages of [start, end) that were dirtied through a user
+ * mapping since the last maintenance, coalescing adjacent dirty pages into a
+ * single range. The user mappings are zapped before the dirty bits are
+ * sampled, so a CPU write racing with this refaults in nvmap_vma_fault() and
+ * marks its page dirty again for the next pass.
+ */
+static void heap_page_dirty_cache_maint(struct nvmap_handle *h,
+		unsigned long start, unsigned long end, unsigned int op,
+		bool inner, bool outer)
+{
+	unsigned long first = start >> PAGE_SHIFT;
+	unsigned long last = PAGE_ALIGN(end) >> PAGE_SHIFT;
+	unsigned long run = last;
+	unsigned long i;
+	int nclean = 0;
+
+	nvmap_zap_handle(h, start, end - start);
+
+	mutex_lock(&h->lock);
+	for (i = first; i <= last; i++) {
+		if (i < last && nvmap_page_mkclean(&h->pgalloc.pages[i])) {
+			nclean++;
+			if (run == last)
+				run = i;
+			continue;
+		}
+
+		if (run != last) {
+			heap_page_range_cache_maint(h,
+					max(start, run << PAGE_SHIFT),
+					min(end, i << PAGE_SHIFT),
+					op, inner, outer);
+			run = last;
+		}
+	}
+	mutex_unlock(&h->lock);
+
+	atomic_sub(nclean, &h->pgalloc.ndirty);
+}
+
+static void heap_page_cache_maint(
+	struct nvmap_handle *h, unsigned long start, unsigned long end,
+	unsigned int op, bool inner, bool outer, bool clean_only_dirty)
+{
+	/* Don't perform cache maint for RO mapped buffers */
+	if (h->from_va && h->is_ro)
+		return;
+
+#ifndef NVMAP_LOADABLE_MODULE
+	/*
+	 * Dirty tracking relies on zapping the user mappings, which the
+	 * loadable module can't do; always fall back to the full range there.
+	 */
+	if (clean_only_dirty && (h->userflags & NVMAP_HANDLE_CACHE_SYNC)) {
+		heap_page_dirty_cache_maint(h, start, end, op, inner, outer);
+		return;
+	}
+#endif /* !NVMAP_LOADABLE_MODULE */
+
+	if (h->userflags & NVMAP_HANDLE_CACHE_SYNC) {
+		/*
+		 * zap user VA->PA mappings so that any access to the pages
+		 * will result in a fault and can be marked dirty
+		 */
+		nvmap_handle_mkclean(h, start, end-start);
+		nvmap_zap_handle(h, start, end - start);
+	}
+
+	heap_page_range_cache_maint(h, start, end, op, inner, outer);
+}
+
 struct cache_maint_op {
 	phys_addr_t start;
 	phys_addr_t end;
@@ -238,6 +297,7 @@ int __nvmap_do_cache_maint(struct nvmap_client *client,
 {
 	int err;
 	struct cache_maint_op cache_op;
+	ktime_t lat_start = nvmap_lat_start();
 
 	h = nvmap_handle_get(h);
 	if (!h)
@@ -275,6 +335,8 @@ int __nvmap_do_cache_maint(struct nvmap_client *client,
 	nvmap_stats_inc(NS_CFLUSH_RQ, end - start);
 	err = do_cache_maint(&cache_op);
 	nvmap_kmaps_dec(h);
+	nvmap_lat_record(NL_CACHE_MAINT, cache_op.end - cache_op.start,
+			 lat_start);
 	nvmap_handle_put(h);
 	return err;
 }
@@ -320,13 +382,34 @@ int __nvmap_cache_maint(struct nvmap_client *client,
 	end = start + op->len;
 
 	err = __nvmap_do_cache_maint(client, priv->handle, start, end, op->op,
-				     false);
+				     true);
 out:
 	nvmap_release_mmap_read_lock(current->mm);
 	nvmap_handle_put(handle);
 	return err;
 }
 
+/*
+ * Cache list operations whose regions add up to at least this many bytes are
+ * merged: all regions of a handle are folded into the one span covering them
+ * and maintained in a single pass instead of region by region.
+ */
+static ulong cache_maint_merge_thresh = ~0UL;
+module_param(cache_maint_merge_thresh, ulong, 0644);
+
+static void nvmap_cache_list_region(struct nvmap_handle **handles,
+				    u64 *offsets, u64 *sizes, bool is_32,
+				    u32 i, u64 *offset, u64 *size)
+{
+	u32 *offs_32 = (u32 *)offsets, *sizes_32 = (u32 *)sizes;
+
+	*size = is_32 ? sizes_32[i] : sizes[i];
+	*offset = is_32 ? offs_32[i] : offsets[i];
+
+	*size = *size ?: handles[i]->size;
+	*offset = *offset ?: 0;
+}
+
 /*
  * Perform cache op on the list of memory regions within passed handles.
  * A memory region within handle[i] is identified by offsets[i], sizes[i]
@@ -335,9 +418,10 @@ out:
  * this is done by replacing offsets[i] = 0, sizes[i] = handles[i]->size.
  * So, the input arrays sizes, offsets  are not guaranteed to be read-only
  *
- * This will optimze the op if it can.
- * In the case that all the handles together are larger than the inner cache
- * maint threshold it is possible to just do an entire inner cache flush.
+ * This will optimze the op if it can. Write backs of handles with dirty
+ * tracking only touch the pages dirtied since the last maintenance, and
+ * once the list is larger than cache_maint_merge_thresh the regions of each
+ * handle are merged into a single operation.
  *
  * NOTE: this omits outer cache operations which is fine for ARM64
  */
@@ -345,9 +429,10 @@ static int __nvmap_do_cache_maint_list(struct nvmap_handle **handles,
 				u64 *offsets, u64 *sizes, int op, u32 nr_ops,
 				bool is_32)
 {
-	u32 i;
+	u32 i, j;
 	u64 total = 0;
-	u64 thresh = ~0;
+	u64 thresh = cache_maint_merge_thresh;
+	bool merge;
 
 	WARN(!IS_ENABLED(CONFIG_ARM64),
 		"cache list operation may not function properly");
@@ -363,7 +448,8 @@ static int __nvmap_do_cache_maint_list(struct nvmap_handle **handles,
 			continue;
 
 		if ((op == NVMAP_CACHE_OP_WB) && nvmap_handle_track_dirty(handles[i]))
-			total += atomic_read(&handles[i]->pgalloc.ndirty);
+			total += (u64)atomic_read(&handles[i]->pgalloc.ndirty) <<
+				 PAGE_SHIFT;
 		else
 			total += size ? size : handles[i]->size;
 	}
@@ -371,43 +457,43 @@ static int __nvmap_do_cache_maint_list(struct nvmap_handle **handles,
 	if (!total)
 		return 0;
 
-	/* Full flush in the case the passed list is bigger than our
-	 * threshold. */
-	if (total >= thresh) {
-		for (i = 0; i < nr_ops; i++) {
-			if (handles[i]->userflags &
-			    NVMAP_HANDLE_CACHE_SYNC) {
-				nvmap_handle_mkclean(handles[i], 0,
-						     handles[i]->size);
-				nvmap_zap_handle(handles[i], 0,
-						 handles[i]->size);
+	merge = total >= thresh;
+
+	for (i = 0; i < nr_ops; i++) {
+		u64 size, offset, end;
+		int err;
+
+		nvmap_cache_list_region(handles, offsets, sizes, is_32, i,
+					&offset, &size);
+		end = offset + size;
+
+		if (merge) {
+			/* Only the first region of a handle issues the op */
+			for (j = 0; j < i; j++)
+				if (handles[j] == handles[i])
+					break;
+			if (j < i)
+				continue;
+
+			for (j = i + 1; j < nr_ops; j++) {
+				u64 o, sz;
+
+				if (handles[j] != handles[i])
+					continue;
+				nvmap_cache_list_region(handles, offsets, sizes,
+							is_32, j, &o, &sz);
+				offset = min(offset, o);
+				end = max(end, o + sz);
 			}
 		}
 
-		nvmap_stats_inc(NS_CFLUSH_RQ, total);
-		nvmap_stats_inc(NS_CFLUSH_DONE, thresh);
-		trace_nvmap_cache_flush(total,
-					nvmap_stats_read(NS_ALLOC),
-					nvmap_stats_read(NS_CFLUSH_RQ),
-					nvmap_stats_read(NS_CFLUSH_DONE));
-	} else {
-		for (i = 0; i < nr_ops; i++) {
-			u32 *offs_32 = (u32 *)offsets, *sizes_32 = (u32 *)sizes;
-			u64 size = is_32 ? sizes_32[i] : sizes[i];
-			u64 offset = is_32 ? offs_32[i] : offsets[i];
-			int err;
-
-			size = size ?: handles[i]->size;
-			offset = offset ?: 0;
-			err = __nvmap_do_cache_maint(handles[i]->owner,
-						     handles[i], offset,
-						     offset + size,
-						     op, false);
-			if (err) {
-				pr_err("cache maint per handle failed [%d]\n",
-						err);
-				return err;
-			}
+		err = __nvmap_do_cache_maint(handles[i]->owner,
+					     handles[i], offset, end, op,
+					     op == NVMAP_CACHE_OP_WB);
+		if (err) {
+			pr_err("cache maint per handle failed [%d]\n",
+					err);
+			return err;
 		}
 	}
 
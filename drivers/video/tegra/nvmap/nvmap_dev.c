@@ -93,6 +93,7 @@ static const struct file_operations nvmap_user_fops = {
 };
 
 static const struct file_operations debug_handles_by_pid_fops;
+static const struct file_operations debug_usage_by_pid_fops;
 
 struct nvmap_pid_data {
 	struct rb_node node;
@@ -228,6 +229,12 @@ unlock:
 	client->handle_refs = RB_ROOT;
 	client->task = task;
 
+	if (nvmap_ref_hash_init(client)) {
+		kfree(client);
+		mutex_unlock(&dev->clients_lock);
+		return NULL;
+	}
+
 	mutex_init(&client->ref_lock);
 	atomic_set(&client->count, 1);
 	client->kernel_client = false;
@@ -244,6 +251,15 @@ unlock:
 		pid_t pid = nvmap_client_pid(client);
 		nvmap_pid_get_locked(dev, pid);
 	}
+	if (!IS_ERR_OR_NULL(dev->usage_by_pid)) {
+		char name[16];
+
+		/* clients are shared per process, so the pid is unique */
+		snprintf(name, sizeof(name), "%d", nvmap_client_pid(client));
+		client->usage_file = debugfs_create_file(name,
+				S_IRUGO | S_IWUSR, dev->usage_by_pid, client,
+				&debug_usage_by_pid_fops);
+	}
 	mutex_unlock(&dev->clients_lock);
 	return client;
 }
@@ -260,6 +276,9 @@ static void destroy_client(struct nvmap_client *client)
 	client->ida = NULL;
 #endif
 
+	/* waits for the readers of the file, which don't take any lock */
+	debugfs_remove(client->usage_file);
+
 	mutex_lock(&nvmap_dev->clients_lock);
 	if (!IS_ERR_OR_NULL(nvmap_dev->handles_by_pid)) {
 		pid_t pid = nvmap_client_pid(client);
@@ -283,6 +302,8 @@ static void destroy_client(struct nvmap_client *client)
 			dma_buf_put(ref->handle->dmabuf);
 		rb_erase(&ref->node, &client->handle_refs);
 		atomic_dec(&ref->handle->share_count);
+		if (ref->accounted)
+			nvmap_usage_uncharge(&client->usage, ref->handle);
 
 		dupes = atomic_read(&ref->dupes);
 		while (dupes--)
@@ -290,6 +311,7 @@ static void destroy_client(struct nvmap_client *client)
 
 		kfree(ref);
 	}
+	nvmap_ref_hash_destroy(client);
 
 	if (client->task)
 		put_task_struct(client->task);
@@ -297,6 +319,17 @@ static void destroy_client(struct nvmap_client *client)
 	kfree(client);
 }
 
+/*
+ * Drops a reference taken by __nvmap_create_client. count field tracks the
+ * number of namespaces within a process, the client is destroyed only after
+ * all of them close the /dev/nvmap node.
+ */
+void nvmap_client_put(struct nvmap_client *client)
+{
+	if (!atomic_dec_return(&client->count))
+		destroy_client(client);
+}
+
 static int nvmap_open(struct inode *inode, struct file *filp)
 {
 	struct miscdevice *miscdev = filp->private_data;
@@ -327,12 +360,7 @@ static int nvmap_release(struct inode *inode, struct file *filp)
 		return 0;
 
 	trace_nvmap_release(priv, priv->name);
-	/*
-	 * count field tracks the number of namespaces within a process.
-	 * Destroy the client only after all namespaces close the /dev/nvmap node.
-	 */
-	if (!atomic_dec_return(&priv->count))
-		destroy_client(priv);
+	nvmap_client_put(priv);
 
 	return 0;
 }
@@ -490,6 +518,17 @@ static long nvmap_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 	case NVMAP_IOC_GET_FD_FOR_RANGE_FROM_LIST:
 		err = nvmap_ioctl_get_fd_from_list(filp, uarg);
 		break;
+	case NVMAP_IOC_ALLOC_BATCH:
+		err = nvmap_ioctl_alloc_batch(filp, uarg);
+		break;
+
+	case NVMAP_IOC_GET_SCIIPCID_LIST:
+		err = nvmap_ioctl_get_sci_ipc_id_list(filp, uarg);
+		break;
+
+	case NVMAP_IOC_HANDLE_FROM_SCIIPCID_LIST:
+		err = nvmap_ioctl_handle_from_sci_ipc_id_list(filp, uarg);
+		break;
 	default:
 		pr_warn("Unknown NVMAP_IOC = 0x%x\n", cmd);
 	}
@@ -1118,6 +1157,55 @@ static int nvmap_debug_handles_by_pid_show(struct seq_file *s, void *unused)
 
 DEBUGFS_OPEN_FOPS_STATIC(handles_by_pid);
 
+/*
+ * Incrementally maintained usage of a client, in bytes, read without taking
+ * any nvmap lock. Writing a byte count sets the limit for the allocations
+ * of the client, 0 removes it.
+ */
+static int nvmap_debug_usage_by_pid_show(struct seq_file *s, void *unused)
+{
+	struct nvmap_client *client = s->private;
+	struct nvmap_usage *usage = &client->usage;
+
+	seq_printf(s, "total %llu\niovmm %llu\ncarveout %llu\nlimit %llu\n",
+		   (u64)atomic64_read(&usage->total),
+		   (u64)atomic64_read(&usage->iovmm),
+		   (u64)atomic64_read(&usage->carveout),
+		   READ_ONCE(usage->limit));
+	return 0;
+}
+
+static ssize_t nvmap_debug_usage_by_pid_write(struct file *file,
+		const char __user *buf, size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct nvmap_client *client = s->private;
+	u64 limit;
+	int err;
+
+	err = kstrtou64_from_user(buf, count, 0, &limit);
+	if (err)
+		return err;
+
+	WRITE_ONCE(client->usage.limit, limit);
+	return count;
+}
+
+static int nvmap_debug_usage_by_pid_open(struct inode *inode,
+					 struct file *file)
+{
+	return single_open(file, nvmap_debug_usage_by_pid_show,
+			   inode->i_private);
+}
+
+static const struct file_operations debug_usage_by_pid_fops = {
+	.open = nvmap_debug_usage_by_pid_open,
+	.read = seq_read,
+	.write = nvmap_debug_usage_by_pid_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 #define PRINT_MEM_STATS_NOTE(x) \
 do { \
 	seq_printf(s, "Note: total memory is precise account of pages " \
@@ -1416,6 +1504,12 @@ int __init nvmap_probe(struct platform_device *pdev)
 	dev->handles = RB_ROOT;
 	dev->serial_id_counter = 0;
 
+	e = nvmap_handle_hash_init(dev);
+	if (e) {
+		nvmap_dev = NULL;
+		goto finish;
+	}
+
 #ifdef NVMAP_CONFIG_PAGE_POOLS
 	e = nvmap_page_pool_init(dev);
 	if (e)
@@ -1441,6 +1535,9 @@ int __init nvmap_probe(struct platform_device *pdev)
 				   nvmap_debug_root, &nvmap_max_handle_count);
 		nvmap_dev->handles_by_pid = debugfs_create_dir("handles_by_pid",
 							nvmap_debug_root);
+		nvmap_dev->usage_by_pid = debugfs_create_dir("usage_by_pid",
+							nvmap_debug_root);
+		nvmap_tag_usage_debugfs_init(nvmap_debug_root);
 #if defined(CONFIG_DEBUG_FS)
 		debugfs_create_ulong("nvmap_init_time", S_IRUGO | S_IWUSR,
 				     nvmap_dev->debug_root, &nvmap_init_time);
@@ -1462,6 +1559,7 @@ int __init nvmap_probe(struct platform_device *pdev)
 	nvmap_page_pool_debugfs_init(nvmap_dev->debug_root);
 #endif
 	nvmap_stats_init(nvmap_debug_root);
+	nvmap_bench_init(nvmap_debug_root);
 	platform_set_drvdata(pdev, dev);
 
 	e = nvmap_dmabuf_stash_init();
@@ -1511,6 +1609,7 @@ fail:
 #ifdef NVMAP_CONFIG_PAGE_POOLS
 	nvmap_page_pool_fini(nvmap_dev);
 #endif
+	nvmap_handle_hash_destroy(dev);
 	kfree(dev->heaps);
 	if (dev->dev_user.minor != MISC_DYNAMIC_MINOR)
 		misc_deregister(&dev->dev_user);
@@ -1533,6 +1632,7 @@ int nvmap_remove(struct platform_device *pdev)
 	nvmap_dmabuf_stash_deinit();
 	debugfs_remove_recursive(dev->debug_root);
 	misc_deregister(&dev->dev_user);
+	nvmap_stats_fini();
 #ifdef NVMAP_CONFIG_PAGE_POOLS
 	nvmap_page_pool_clear();
 	nvmap_page_pool_fini(nvmap_dev);
@@ -1542,6 +1642,8 @@ int nvmap_remove(struct platform_device *pdev)
 		rb_erase(&h->node, &dev->handles);
 		kfree(h);
 	}
+	nvmap_handle_hash_destroy(dev);
+	nvmap_tag_usage_fini();
 
 	for (i = 0; i < dev->nr_carveouts; i++) {
 		struct nvmap_carveout_node *node = &dev->heaps[i];
@@ -39,62 +39,201 @@
 #define NVMAP_DMABUF_ATTACH  __nvmap_dmabuf_attach
 #endif
 
+struct nvmap_stash_dev;
+
 struct nvmap_handle_sgt {
 	enum dma_data_direction dir;
 	struct sg_table *sgt;
 	struct device *dev;
 	struct list_head maps_entry;
 	struct nvmap_handle_info *owner;
+	struct nvmap_stash_dev *sdev;
+	struct list_head lru_entry;	/* entry on sdev->lru */
+	u32 users;			/* attachments currently mapping sgt */
 } ____cacheline_aligned_in_smp;
 
-static struct kmem_cache *handle_sgt_cache;
-
 /*
- * Initialize a kmem cache for allocating nvmap_handle_sgt's.
+ * Stashed sgts are also accounted per attaching device. Each device keeps
+ * its entries, across all dmabufs, on an LRU bounded by stash_max_per_dev,
+ * so a consumer cycling through many buffers can't hold on to an unbounded
+ * number of IOVA mappings. Devices are only ever added, so the records
+ * double as the history used to prefetch the stash at attach time.
+ *
+ * Lock order: nvmap_handle_info::maps_lock, then nvmap_stash_lock.
  */
-int nvmap_dmabuf_stash_init(void)
+struct nvmap_stash_dev {
+	struct list_head node;		/* entry on nvmap_stash_devs */
+	struct device *dev;
+	const char *name;
+	struct list_head lru;		/* oldest entry first */
+	u32 count;
+	enum dma_data_direction last_dir;
+	u64 hits;
+	u64 misses;
+	u64 evictions;
+	u64 prefetches;
+};
+
+static LIST_HEAD(nvmap_stash_devs);
+static DEFINE_MUTEX(nvmap_stash_lock);
+
+static uint stash_max_per_dev = 1024;
+module_param(stash_max_per_dev, uint, 0644);
+static bool stash_prefetch = true;
+module_param(stash_prefetch, bool, 0644);
+
+static struct kmem_cache *handle_sgt_cache;
+
+static void __nvmap_dmabuf_unmap_dma_buf(struct nvmap_handle_sgt *nvmap_sgt);
+
+static struct nvmap_stash_dev *nvmap_stash_dev_find_locked(struct device *dev)
 {
-	handle_sgt_cache = KMEM_CACHE(nvmap_handle_sgt, 0);
-	if (IS_ERR_OR_NULL(handle_sgt_cache)) {
-		pr_err("Failed to make kmem cache for nvmap_handle_sgt.\n");
-		return -ENOMEM;
+	struct nvmap_stash_dev *sdev;
+
+	list_for_each_entry(sdev, &nvmap_stash_devs, node)
+		if (sdev->dev == dev)
+			return sdev;
+
+	return NULL;
+}
+
+static struct nvmap_stash_dev *nvmap_stash_dev_get_locked(struct device *dev)
+{
+	struct nvmap_stash_dev *sdev = nvmap_stash_dev_find_locked(dev);
+
+	if (sdev)
+		return sdev;
+
+	sdev = kzalloc(sizeof(*sdev), GFP_KERNEL);
+	if (!sdev)
+		return NULL;
+
+	sdev->name = kstrdup_const(dev_name(dev), GFP_KERNEL);
+	if (!sdev->name) {
+		kfree(sdev);
+		return NULL;
 	}
+	sdev->dev = dev;
+	sdev->last_dir = DMA_BIDIRECTIONAL;
+	INIT_LIST_HEAD(&sdev->lru);
+	list_add_tail(&sdev->node, &nvmap_stash_devs);
 
-	return 0;
+	return sdev;
 }
 
-void nvmap_dmabuf_stash_deinit(void)
+/* Note: the caller must hold both the owner's maps_lock and nvmap_stash_lock */
+static void nvmap_stash_unlink_locked(struct nvmap_handle_sgt *nvmap_sgt)
 {
-	kmem_cache_destroy(handle_sgt_cache);
+	list_del(&nvmap_sgt->maps_entry);
+	if (nvmap_sgt->sdev) {
+		list_del(&nvmap_sgt->lru_entry);
+		nvmap_sgt->sdev->count--;
+	}
 }
 
-static int __nvmap_dmabuf_attach(struct dma_buf *dmabuf, struct device *dev,
-			       struct dma_buf_attachment *attach)
+/*
+ * Trim sdev back to stash_max_per_dev entries. Entries still mapped by an
+ * attachment can't go, and neither can entries of a dmabuf whose maps_lock
+ * is contended: taking it unconditionally would invert the lock order
+ * against another mapper of that dmabuf. The trylocked maps_lock is held
+ * across the unmap so the owner can't be released underneath it.
+ */
+static void nvmap_stash_evict(struct nvmap_stash_dev *sdev,
+			      struct nvmap_handle_info *locked)
 {
-	struct nvmap_handle_info *info = dmabuf->priv;
+	struct nvmap_handle_sgt *nvmap_sgt, *tmp;
+	struct nvmap_handle_info *owner;
+	u32 max = READ_ONCE(stash_max_per_dev);
 
-	trace_nvmap_dmabuf_attach(dmabuf, dev);
+	if (!max)
+		return;
+
+	mutex_lock(&nvmap_stash_lock);
+restart:
+	list_for_each_entry_safe(nvmap_sgt, tmp, &sdev->lru, lru_entry) {
+		if (sdev->count <= max)
+			break;
+		if (nvmap_sgt->users)
+			continue;
+
+		owner = nvmap_sgt->owner;
+		if (owner != locked && !mutex_trylock(&owner->maps_lock))
+			continue;
+
+		nvmap_stash_unlink_locked(nvmap_sgt);
+		sdev->evictions++;
+		mutex_unlock(&nvmap_stash_lock);
+
+		__nvmap_dmabuf_unmap_dma_buf(nvmap_sgt);
+		kmem_cache_free(handle_sgt_cache, nvmap_sgt);
+		if (owner != locked)
+			mutex_unlock(&owner->maps_lock);
+
+		mutex_lock(&nvmap_stash_lock);
+		goto restart;
+	}
+	mutex_unlock(&nvmap_stash_lock);
+}
+
+static int nvmap_stash_stats_show(struct seq_file *s, void *unused)
+{
+	struct nvmap_stash_dev *sdev;
+
+	seq_printf(s, "%-32s %8s %12s %12s %12s %12s\n", "device", "stashed",
+		   "hits", "misses", "evictions", "prefetches");
+
+	mutex_lock(&nvmap_stash_lock);
+	list_for_each_entry(sdev, &nvmap_stash_devs, node)
+		seq_printf(s, "%-32s %8u %12llu %12llu %12llu %12llu\n",
+			   sdev->name, sdev->count, sdev->hits, sdev->misses,
+			   sdev->evictions, sdev->prefetches);
+	mutex_unlock(&nvmap_stash_lock);
 
-	dev_dbg(dev, "%s() 0x%p\n", __func__, info->handle);
 	return 0;
 }
 
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 4, 0)
-static int nvmap_dmabuf_attach(struct dma_buf *dmabuf,
-			       struct dma_buf_attachment *attach)
+static int nvmap_stash_stats_open(struct inode *inode, struct file *file)
 {
-	return __nvmap_dmabuf_attach(dmabuf, attach->dev, attach);
+	return single_open(file, nvmap_stash_stats_show, inode->i_private);
 }
-#endif
 
-static void nvmap_dmabuf_detach(struct dma_buf *dmabuf,
-				struct dma_buf_attachment *attach)
+static const struct file_operations nvmap_stash_stats_fops = {
+	.open = nvmap_stash_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/*
+ * Initialize a kmem cache for allocating nvmap_handle_sgt's.
+ */
+int nvmap_dmabuf_stash_init(void)
 {
-	struct nvmap_handle_info *info = dmabuf->priv;
+	handle_sgt_cache = KMEM_CACHE(nvmap_handle_sgt, 0);
+	if (IS_ERR_OR_NULL(handle_sgt_cache)) {
+		pr_err("Failed to make kmem cache for nvmap_handle_sgt.\n");
+		return -ENOMEM;
+	}
 
-	trace_nvmap_dmabuf_detach(dmabuf, attach->dev);
+	if (!IS_ERR_OR_NULL(nvmap_dev->debug_root))
+		debugfs_create_file("sgt_stash_stats", S_IRUGO,
+				    nvmap_dev->debug_root, NULL,
+				    &nvmap_stash_stats_fops);
 
-	dev_dbg(attach->dev, "%s() 0x%p\n", __func__, info->handle);
+	return 0;
+}
+
+void nvmap_dmabuf_stash_deinit(void)
+{
+	struct nvmap_stash_dev *sdev, *tmp;
+
+	kmem_cache_destroy(handle_sgt_cache);
+
+	list_for_each_entry_safe(sdev, tmp, &nvmap_stash_devs, node) {
+		list_del(&sdev->node);
+		kfree_const(sdev->name);
+		kfree(sdev);
+	}
 }
 
 static inline bool access_vpr_phys(struct device *dev)
@@ -112,59 +251,206 @@ static inline bool access_vpr_phys(struct device *dev)
 	return !!of_find_property(dev->of_node, "access-vpr-phys", NULL);
 }
 
-static int nvmap_dmabuf_stash_sgt_locked(struct dma_buf_attachment *attach,
-					 enum dma_data_direction dir,
-					 struct sg_table *sgt)
+static struct nvmap_handle_sgt *
+nvmap_dmabuf_stash_sgt_locked(struct nvmap_handle_info *info,
+			      struct device *dev,
+			      enum dma_data_direction dir,
+			      struct sg_table *sgt)
 {
 	struct nvmap_handle_sgt *nvmap_sgt;
-	struct nvmap_handle_info *info = attach->dmabuf->priv;
 
 	nvmap_sgt = kmem_cache_alloc(handle_sgt_cache, GFP_KERNEL);
 	if (IS_ERR_OR_NULL(nvmap_sgt)) {
 		pr_err("Stashing SGT failed.\n");
-		return -ENOMEM;
+		return NULL;
 	}
 
 	nvmap_sgt->dir = dir;
 	nvmap_sgt->sgt = sgt;
-	nvmap_sgt->dev = attach->dev;
+	nvmap_sgt->dev = dev;
 	nvmap_sgt->owner = info;
+	nvmap_sgt->users = 0;
 	list_add(&nvmap_sgt->maps_entry, &info->maps);
 
-	return 0;
+	mutex_lock(&nvmap_stash_lock);
+	/* Without a device record the entry is just not bounded */
+	nvmap_sgt->sdev = nvmap_stash_dev_get_locked(dev);
+	if (nvmap_sgt->sdev) {
+		list_add_tail(&nvmap_sgt->lru_entry, &nvmap_sgt->sdev->lru);
+		nvmap_sgt->sdev->count++;
+		nvmap_sgt->sdev->misses++;
+		nvmap_sgt->sdev->last_dir = dir;
+	}
+	mutex_unlock(&nvmap_stash_lock);
+
+	return nvmap_sgt;
 }
 
-static struct sg_table *nvmap_dmabuf_get_sgt_from_stash(struct dma_buf_attachment *attach,
-							enum dma_data_direction dir)
+static struct nvmap_handle_sgt *
+nvmap_dmabuf_get_sgt_from_stash(struct nvmap_handle_info *info,
+				struct device *dev,
+				enum dma_data_direction dir)
 {
-	struct nvmap_handle_info *info = attach->dmabuf->priv;
 	struct nvmap_handle_sgt *nvmap_sgt;
-	struct sg_table *sgt = NULL;
 
 	list_for_each_entry(nvmap_sgt, &info->maps, maps_entry) {
-		if (nvmap_sgt->dir != dir || nvmap_sgt->dev != attach->dev)
+		if (nvmap_sgt->dir != dir || nvmap_sgt->dev != dev)
 			continue;
 
 		/* found sgt in stash */
-		sgt = nvmap_sgt->sgt;
-		break;
+		if (nvmap_sgt->sdev) {
+			mutex_lock(&nvmap_stash_lock);
+			list_move_tail(&nvmap_sgt->lru_entry,
+				       &nvmap_sgt->sdev->lru);
+			nvmap_sgt->sdev->hits++;
+			mutex_unlock(&nvmap_stash_lock);
+		}
+		return nvmap_sgt;
 	}
 
-	return sgt;
+	return NULL;
+}
+
+/*
+ * Look up the stashed sgt of info's handle for dev/dir, building, mapping and
+ * stashing a new one on a miss.
+ *
+ * Note: to call this function make sure you own info->maps_lock.
+ */
+static struct nvmap_handle_sgt *
+nvmap_dmabuf_stash_map_locked(struct nvmap_handle_info *info,
+			      struct device *dev,
+			      enum dma_data_direction dir)
+{
+	struct nvmap_handle_sgt *nvmap_sgt;
+	struct sg_table *sgt;
+	int ents = 0;
+	DEFINE_DMA_ATTRS(attrs);
+
+	nvmap_sgt = nvmap_dmabuf_get_sgt_from_stash(info, dev, dir);
+	if (nvmap_sgt)
+		return nvmap_sgt;
+
+	sgt = __nvmap_sg_table(NULL, info->handle);
+	if (IS_ERR(sgt))
+		return ERR_CAST(sgt);
+
+	if (!info->handle->alloc) {
+		goto err_map;
+	} else if (!(nvmap_dev->dynamic_dma_map_mask &
+			info->handle->heap_type)) {
+		sg_dma_address(sgt->sgl) = info->handle->carveout->base;
+	} else if (info->handle->heap_type == NVMAP_HEAP_CARVEOUT_VPR &&
+			access_vpr_phys(dev)) {
+		sg_dma_address(sgt->sgl) = 0;
+	} else {
+		dma_set_attr(DMA_ATTR_SKIP_CPU_SYNC, __DMA_ATTR(attrs));
+		ents = dma_map_sg_attrs(dev, sgt->sgl,
+					sgt->nents, dir, __DMA_ATTR(attrs));
+		if (ents <= 0)
+			goto err_map;
+	}
+
+	nvmap_sgt = nvmap_dmabuf_stash_sgt_locked(info, dev, dir, sgt);
+	if (!nvmap_sgt) {
+		WARN(1, "No mem to prep sgt.\n");
+		if (ents > 0)
+			dma_unmap_sg_attrs(dev, sgt->sgl, sgt->nents, dir,
+					   DMA_ATTR_SKIP_CPU_SYNC);
+		goto err_map;
+	}
+
+	return nvmap_sgt;
+
+err_map:
+	__nvmap_free_sg_table(NULL, info->handle, sgt);
+	return ERR_PTR(-ENOMEM);
+}
+
+/*
+ * Map the buffer for a device that mapped nvmap buffers before, in the
+ * direction it last used, so that its first map_dma_buf() of this buffer
+ * already hits the stash. Failures are harmless: map_dma_buf() retries.
+ */
+static void nvmap_dmabuf_stash_prefetch(struct nvmap_handle_info *info,
+					struct device *dev)
+{
+	struct nvmap_handle_sgt *nvmap_sgt;
+	struct nvmap_stash_dev *sdev;
+	enum dma_data_direction dir;
+
+	if (!stash_prefetch || !info->handle->alloc)
+		return;
+
+	mutex_lock(&nvmap_stash_lock);
+	sdev = nvmap_stash_dev_find_locked(dev);
+	dir = sdev ? sdev->last_dir : DMA_NONE;
+	mutex_unlock(&nvmap_stash_lock);
+
+	if (!sdev || dir == DMA_NONE)
+		return;
+	if (info->handle->from_va && info->handle->is_ro &&
+	    dir != DMA_TO_DEVICE)
+		return;
+
+	mutex_lock(&info->maps_lock);
+	nvmap_sgt = nvmap_dmabuf_stash_map_locked(info, dev, dir);
+	if (!IS_ERR(nvmap_sgt)) {
+		mutex_lock(&nvmap_stash_lock);
+		sdev->prefetches++;
+		mutex_unlock(&nvmap_stash_lock);
+	}
+	mutex_unlock(&info->maps_lock);
+
+	nvmap_stash_evict(sdev, NULL);
+}
+
+static int __nvmap_dmabuf_attach(struct dma_buf *dmabuf, struct device *dev,
+			       struct dma_buf_attachment *attach)
+{
+	struct nvmap_handle_info *info = dmabuf->priv;
+	ktime_t lat_start = nvmap_lat_start();
+
+	trace_nvmap_dmabuf_attach(dmabuf, dev);
+
+	dev_dbg(dev, "%s() 0x%p\n", __func__, info->handle);
+
+	nvmap_dmabuf_stash_prefetch(info, dev);
+	nvmap_lat_record(NL_DMABUF_ATTACH, info->handle->size, lat_start);
+	return 0;
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 4, 0)
+static int nvmap_dmabuf_attach(struct dma_buf *dmabuf,
+			       struct dma_buf_attachment *attach)
+{
+	return __nvmap_dmabuf_attach(dmabuf, attach->dev, attach);
+}
+#endif
+
+static void nvmap_dmabuf_detach(struct dma_buf *dmabuf,
+				struct dma_buf_attachment *attach)
+{
+	struct nvmap_handle_info *info = dmabuf->priv;
+
+	trace_nvmap_dmabuf_detach(dmabuf, attach->dev);
+
+	dev_dbg(attach->dev, "%s() 0x%p\n", __func__, info->handle);
 }
 
 static struct sg_table *nvmap_dmabuf_map_dma_buf(struct dma_buf_attachment *attach,
 						  enum dma_data_direction dir)
 {
 	struct nvmap_handle_info *info = attach->dmabuf->priv;
-	int ents = 0;
+	struct nvmap_handle_sgt *nvmap_sgt;
+	struct nvmap_stash_dev *sdev;
 	struct sg_table *sgt = NULL;
+	ktime_t lat_start = nvmap_lat_start();
 #ifdef NVMAP_CONFIG_DEBUG_MAPS
 	char *device_name = NULL;
 	u32 heap_type;
 	u64 dma_mask;
 #endif /* NVMAP_CONFIG_DEBUG_MAPS */
-	DEFINE_DMA_ATTRS(attrs);
 
 	trace_nvmap_dmabuf_map_dma_buf(attach->dmabuf, attach->dev);
 
@@ -180,39 +466,19 @@ static struct sg_table *nvmap_dmabuf_map_dma_buf(struct dma_buf_attachment *atta
 	nvmap_lru_reset(info->handle);
 	mutex_lock(&info->maps_lock);
 
-	atomic_inc(&info->handle->pin);
-
-	sgt = nvmap_dmabuf_get_sgt_from_stash(attach, dir);
-	if (sgt)
-		goto cache_hit;
+	if (atomic_inc_return(&info->handle->pin) == 1)
+		nvmap_tag_usage_pin(info->handle, true);
 
-	sgt = __nvmap_sg_table(NULL, info->handle);
-	if (IS_ERR(sgt)) {
-		atomic_dec(&info->handle->pin);
+	nvmap_sgt = nvmap_dmabuf_stash_map_locked(info, attach->dev, dir);
+	if (IS_ERR(nvmap_sgt)) {
+		if (atomic_dec_return(&info->handle->pin) == 0)
+			nvmap_tag_usage_pin(info->handle, false);
 		mutex_unlock(&info->maps_lock);
-		return sgt;
+		return ERR_CAST(nvmap_sgt);
 	}
-
-	if (!info->handle->alloc) {
-		goto err_map;
-	} else if (!(nvmap_dev->dynamic_dma_map_mask &
-			info->handle->heap_type)) {
-		sg_dma_address(sgt->sgl) = info->handle->carveout->base;
-	} else if (info->handle->heap_type == NVMAP_HEAP_CARVEOUT_VPR &&
-			access_vpr_phys(attach->dev)) {
-		sg_dma_address(sgt->sgl) = 0;
-	} else {
-		dma_set_attr(DMA_ATTR_SKIP_CPU_SYNC, __DMA_ATTR(attrs));
-		ents = dma_map_sg_attrs(attach->dev, sgt->sgl,
-					sgt->nents, dir, __DMA_ATTR(attrs));
-		if (ents <= 0)
-			goto err_map;
-	}
-
-	if (nvmap_dmabuf_stash_sgt_locked(attach, dir, sgt))
-		WARN(1, "No mem to prep sgt.\n");
-
-cache_hit:
+	nvmap_sgt->users++;
+	sgt = nvmap_sgt->sgt;
+	sdev = nvmap_sgt->sdev;
 	attach->priv = sgt;
 
 #ifdef NVMAP_CONFIG_DEBUG_MAPS
@@ -225,14 +491,11 @@ cache_hit:
 		nvmap_add_device_name(device_name, dma_mask, heap_type);
 	}
 #endif /* NVMAP_CONFIG_DEBUG_MAPS */
+	if (sdev)
+		nvmap_stash_evict(sdev, info);
 	mutex_unlock(&info->maps_lock);
+	nvmap_lat_record(NL_DMABUF_MAP, info->handle->size, lat_start);
 	return sgt;
-
-err_map:
-	__nvmap_free_sg_table(NULL, info->handle, sgt);
-	atomic_dec(&info->handle->pin);
-	mutex_unlock(&info->maps_lock);
-	return ERR_PTR(-ENOMEM);
 }
 
 static void __nvmap_dmabuf_unmap_dma_buf(struct nvmap_handle_sgt *nvmap_sgt)
@@ -260,6 +523,8 @@ static void nvmap_dmabuf_unmap_dma_buf(struct dma_buf_attachment *attach,
 				       enum dma_data_direction dir)
 {
 	struct nvmap_handle_info *info = attach->dmabuf->priv;
+	struct nvmap_handle_sgt *nvmap_sgt;
+	int pin;
 #ifdef NVMAP_CONFIG_DEBUG_MAPS
 	char *device_name = NULL;
 	u32 heap_type = 0;
@@ -268,11 +533,23 @@ static void nvmap_dmabuf_unmap_dma_buf(struct dma_buf_attachment *attach,
 	trace_nvmap_dmabuf_unmap_dma_buf(attach->dmabuf, attach->dev);
 
 	mutex_lock(&info->maps_lock);
-	if (!atomic_add_unless(&info->handle->pin, -1, 0)) {
+	pin = atomic_dec_if_positive(&info->handle->pin);
+	if (pin < 0) {
 		mutex_unlock(&info->maps_lock);
 		WARN(1, "Unpinning handle that has yet to be pinned!\n");
 		return;
 	}
+	if (pin == 0)
+		nvmap_tag_usage_pin(info->handle, false);
+
+	/* The sgt stays stashed, it just becomes evictable again */
+	list_for_each_entry(nvmap_sgt, &info->maps, maps_entry) {
+		if (nvmap_sgt->sgt == sgt) {
+			if (!WARN_ON(!nvmap_sgt->users))
+				nvmap_sgt->users--;
+			break;
+		}
+	}
 
 #ifdef NVMAP_CONFIG_DEBUG_MAPS
 	/* Remove the device name from the list of carveout accessing devices */
@@ -299,8 +576,10 @@ static void nvmap_dmabuf_release(struct dma_buf *dmabuf)
 		nvmap_sgt = list_first_entry(&info->maps,
 					     struct nvmap_handle_sgt,
 					     maps_entry);
+		mutex_lock(&nvmap_stash_lock);
+		nvmap_stash_unlink_locked(nvmap_sgt);
+		mutex_unlock(&nvmap_stash_lock);
 		__nvmap_dmabuf_unmap_dma_buf(nvmap_sgt);
-		list_del(&nvmap_sgt->maps_entry);
 		kmem_cache_free(handle_sgt_cache, nvmap_sgt);
 	}
 	mutex_unlock(&info->maps_lock);
@@ -461,11 +740,20 @@ int __nvmap_map(struct nvmap_handle *h, struct vm_area_struct *vma)
 			  VM_DONTDUMP | VM_DONTCOPY |
 			  (h->heap_pgalloc ? 0 : VM_PFNMAP);
 #endif
+	/* lets the fault handler insert pages around the faulting one */
+	if (h->heap_pgalloc && h->heap_type == NVMAP_HEAP_IOVMM && !h->from_va) {
+#if defined(NV_VM_AREA_STRUCT_HAS_CONST_VM_FLAGS) /* Linux v6.3 */
+		vm_flags_set(vma, VM_MIXEDMAP);
+#else
+		vma->vm_flags |= VM_MIXEDMAP;
+#endif
+	}
 	vma->vm_ops = &nvmap_vma_ops;
 	BUG_ON(vma->vm_private_data != NULL);
 	vma->vm_private_data = priv;
 	vma->vm_page_prot = nvmap_pgprot(h, vma->vm_page_prot);
 	nvmap_vma_open(vma);
+	nvmap_vma_prefault(vma);
 	return 0;
 }
 
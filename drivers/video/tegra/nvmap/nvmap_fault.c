@@ -7,6 +7,7 @@
 
 #include <trace/events/nvmap.h>
 #include <linux/highmem.h>
+#include <linux/moduleparam.h>
 
 #include "nvmap_priv.h"
 
@@ -32,6 +33,113 @@ int is_nvmap_vma(struct vm_area_struct *vma)
 	return vma->vm_ops == &nvmap_vma_ops;
 }
 
+/*
+ * A fault on an IOVMM handle also maps the other pages of the aligned
+ * NVMAP_FAULT_AROUND_PAGES block around it, and with prefault_on_mmap set
+ * the whole VMA is mapped at mmap time. Handles with dirty page tracking
+ * are left to fault one page at a time, since each first touch there
+ * does cache maintenance and marks the page dirty.
+ */
+#define NVMAP_FAULT_AROUND_PAGES	16
+
+static bool prefault_on_mmap;
+module_param(prefault_on_mmap, bool, 0644);
+
+static bool nvmap_vma_can_insert(struct vm_area_struct *vma,
+				 struct nvmap_handle *h)
+{
+	return (vma->vm_flags & VM_MIXEDMAP) && h->alloc &&
+		h->heap_type == NVMAP_HEAP_IOVMM && h->pgalloc.pages &&
+		!h->from_va && !nvmap_handle_track_dirty(h) &&
+		!atomic_read(&h->pgalloc.reserved);
+}
+
+/* Maps nr pages of h from page pgoff at addr, returns the pages mapped. */
+static unsigned long nvmap_vma_insert_pages(struct vm_area_struct *vma,
+		struct nvmap_handle *h, unsigned long addr, size_t pgoff,
+		unsigned long nr)
+{
+	struct page *pages[NVMAP_FAULT_AROUND_PAGES];
+	unsigned long inserted = 0;
+	unsigned long batch, left, i;
+	int err;
+
+	while (nr) {
+		batch = min_t(unsigned long, nr, NVMAP_FAULT_AROUND_PAGES);
+		for (i = 0; i < batch; i++)
+			pages[i] = nvmap_to_page(h->pgalloc.pages[pgoff + i]);
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 8, 0)
+		left = batch;
+		err = vm_insert_pages(vma, addr, pages, &left);
+		inserted += batch - left;
+		/* skip a page that is already mapped and carry on past it */
+		if (err && left)
+			left--;
+		batch -= left;
+#else
+		for (i = 0; i < batch; i++) {
+			err = vm_insert_page(vma, addr + (i << PAGE_SHIFT),
+					     pages[i]);
+			if (!err)
+				inserted++;
+		}
+#endif
+		addr += batch << PAGE_SHIFT;
+		pgoff += batch;
+		nr -= batch;
+	}
+
+	return inserted;
+}
+
+static void nvmap_fault_around(struct vm_area_struct *vma,
+		struct nvmap_handle *h, unsigned long addr, size_t pgoff)
+{
+	unsigned long block = NVMAP_FAULT_AROUND_PAGES << PAGE_SHIFT;
+	unsigned long start, end, before, after, mapped;
+
+	if (!nvmap_vma_can_insert(vma, h))
+		return;
+
+	addr &= PAGE_MASK;
+	start = max(ALIGN_DOWN(addr, block), vma->vm_start);
+	end = min(ALIGN_DOWN(addr, block) + block, vma->vm_end);
+
+	/* pages on either side of the faulting one, kept inside the handle */
+	before = min_t(unsigned long, (addr - start) >> PAGE_SHIFT, pgoff);
+	after = min_t(unsigned long, ((end - addr) >> PAGE_SHIFT) - 1,
+		      (h->size >> PAGE_SHIFT) - pgoff - 1);
+
+	/* the faulting page itself is mapped by the caller */
+	mapped = nvmap_vma_insert_pages(vma, h, addr - (before << PAGE_SHIFT),
+					pgoff - before, before);
+	mapped += nvmap_vma_insert_pages(vma, h, addr + PAGE_SIZE, pgoff + 1,
+					 after);
+
+	nvmap_stats_inc(NS_FAULT_AROUND, mapped);
+}
+
+void nvmap_vma_prefault(struct vm_area_struct *vma)
+{
+	struct nvmap_vma_priv *priv = vma->vm_private_data;
+	struct nvmap_handle *h = priv->handle;
+	size_t pgoff = priv->offs >> PAGE_SHIFT;
+	size_t nr_pages = h->size >> PAGE_SHIFT;
+	unsigned long mapped;
+
+	if (!prefault_on_mmap || !nvmap_vma_can_insert(vma, h))
+		return;
+
+	pgoff += vma->vm_pgoff;
+	if (pgoff >= nr_pages)
+		return;
+
+	mapped = nvmap_vma_insert_pages(vma, h, vma->vm_start, pgoff,
+			min_t(unsigned long, vma_pages(vma), nr_pages - pgoff));
+	nvmap_stats_inc(NS_PREFAULT, mapped);
+}
+
 /* to ensure that the backing store for the VMA isn't freed while a fork'd
  * reference still exists, nvmap_vma_open increments the reference count on
  * the handle, and nvmap_vma_close decrements it. alternatively, we could
@@ -197,6 +305,8 @@ static int nvmap_vma_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 	if (offs >= priv->handle->size)
 		return VM_FAULT_SIGBUS;
 
+	nvmap_stats_inc(NS_FAULT, 1);
+
 	if (!priv->handle->pgalloc.pages) {
 		unsigned long pfn;
 
@@ -233,8 +343,12 @@ static int nvmap_vma_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
 					return VM_FAULT_SIGSEGV;
 			}
 
-			if (!nvmap_handle_track_dirty(priv->handle))
+			if (!nvmap_handle_track_dirty(priv->handle)) {
+				nvmap_fault_around(vma, priv->handle,
+						   (unsigned long)vmf_address,
+						   offs);
 				goto finish;
+			}
 			mutex_lock(&priv->handle->lock);
 			if (nvmap_page_dirty(priv->handle->pgalloc.pages[offs])) {
 				mutex_unlock(&priv->handle->lock);
@@ -15,6 +15,8 @@
 #include <linux/list.h>
 #include <linux/mm.h>
 #include <linux/rbtree.h>
+#include <linux/rhashtable.h>
+#include <linux/jhash.h>
 #include <linux/dma-buf.h>
 #include <linux/moduleparam.h>
 #include <linux/nvmap.h>
@@ -33,6 +35,73 @@
 #include "nvmap_priv.h"
 #include "nvmap_ioctl.h"
 
+/*
+ * Handles are hashed by their own address, which is all nvmap_validate_get()
+ * gets to go by. Client refs are hashed by handle address and RO-ness, see
+ * nvmap_ref_key(). Both lookups stay O(1) however many handles a process has.
+ */
+static u32 nvmap_handle_obj_hashfn(const void *data, u32 len, u32 seed)
+{
+	unsigned long key = (unsigned long)data;
+
+	return jhash(&key, sizeof(key), seed);
+}
+
+static int nvmap_handle_obj_cmpfn(struct rhashtable_compare_arg *arg,
+				  const void *obj)
+{
+	return *(const unsigned long *)arg->key != (unsigned long)obj;
+}
+
+static const struct rhashtable_params nvmap_handle_hash_params = {
+	.key_len = sizeof(unsigned long),
+	.head_offset = offsetof(struct nvmap_handle, hash_node),
+	.hashfn = jhash,
+	.obj_hashfn = nvmap_handle_obj_hashfn,
+	.obj_cmpfn = nvmap_handle_obj_cmpfn,
+	.automatic_shrinking = true,
+};
+
+static const struct rhashtable_params nvmap_ref_hash_params = {
+	.key_len = sizeof(unsigned long),
+	.key_offset = offsetof(struct nvmap_handle_ref, key),
+	.head_offset = offsetof(struct nvmap_handle_ref, hash_node),
+	.automatic_shrinking = true,
+};
+
+static inline unsigned long nvmap_ref_key(struct nvmap_handle *h, bool is_ro)
+{
+	return (unsigned long)h | is_ro;
+}
+
+int nvmap_handle_hash_init(struct nvmap_device *dev)
+{
+	return rhashtable_init(&dev->handle_hash, &nvmap_handle_hash_params);
+}
+
+void nvmap_handle_hash_destroy(struct nvmap_device *dev)
+{
+	rhashtable_destroy(&dev->handle_hash);
+}
+
+int nvmap_ref_hash_init(struct nvmap_client *client)
+{
+	return rhashtable_init(&client->ref_hash, &nvmap_ref_hash_params);
+}
+
+void nvmap_ref_hash_destroy(struct nvmap_client *client)
+{
+	rhashtable_destroy(&client->ref_hash);
+}
+
+/* Note: to call this function make sure you own the client ref lock. */
+void nvmap_ref_hash_remove(struct nvmap_client *client,
+			   struct nvmap_handle_ref *ref)
+{
+	rhashtable_remove_fast(&client->ref_hash, &ref->hash_node,
+			       nvmap_ref_hash_params);
+}
+
 /*
  * Verifies that the passed ID is a valid handle ID. Then the passed client's
  * reference to the handle is returned.
@@ -43,28 +112,26 @@ struct nvmap_handle_ref *__nvmap_validate_locked(struct nvmap_client *c,
 						 struct nvmap_handle *h,
 						 bool is_ro)
 {
-	struct rb_node *n = c->handle_refs.rb_node;
-
-	while (n) {
-		struct nvmap_handle_ref *ref;
-		ref = rb_entry(n, struct nvmap_handle_ref, node);
-		if ((ref->handle == h) && (ref->is_ro == is_ro))
-			return ref;
-		else if ((uintptr_t)h > (uintptr_t)ref->handle)
-			n = n->rb_right;
-		else
-			n = n->rb_left;
-	}
+	unsigned long key = nvmap_ref_key(h, is_ro);
 
-	return NULL;
+	return rhashtable_lookup_fast(&c->ref_hash, &key,
+				      nvmap_ref_hash_params);
 }
 /* adds a newly-created handle to the device master tree */
-void nvmap_handle_add(struct nvmap_device *dev, struct nvmap_handle *h)
+int nvmap_handle_add(struct nvmap_device *dev, struct nvmap_handle *h)
 {
 	struct rb_node **p;
 	struct rb_node *parent = NULL;
+	int err;
 
 	spin_lock(&dev->handle_lock);
+	err = rhashtable_insert_fast(&dev->handle_hash, &h->hash_node,
+				     nvmap_handle_hash_params);
+	if (err) {
+		spin_unlock(&dev->handle_lock);
+		return err;
+	}
+
 	p = &dev->handles.rb_node;
 	while (*p) {
 		struct nvmap_handle *b;
@@ -86,6 +153,7 @@ void nvmap_handle_add(struct nvmap_device *dev, struct nvmap_handle *h)
 	 */
 	h->serial_id = dev->serial_id_counter++;
 	spin_unlock(&dev->handle_lock);
+	return 0;
 }
 
 /* remove a handle from the device's tree of all handles; called
@@ -104,8 +172,13 @@ int nvmap_handle_remove(struct nvmap_device *dev, struct nvmap_handle *h)
 	BUG_ON(atomic_read(&h->ref) < 0);
 	BUG_ON(atomic_read(&h->pin) != 0);
 
-	nvmap_lru_del(h);
-	rb_erase(&h->node, &dev->handles);
+	/* nvmap_create_handle() may fail before the handle was added */
+	if (!RB_EMPTY_NODE(&h->node)) {
+		nvmap_lru_del(h);
+		rb_erase(&h->node, &dev->handles);
+		rhashtable_remove_fast(&dev->handle_hash, &h->hash_node,
+				       nvmap_handle_hash_params);
+	}
 
 	spin_unlock(&dev->handle_lock);
 	return 0;
@@ -115,35 +188,34 @@ int nvmap_handle_remove(struct nvmap_device *dev, struct nvmap_handle *h)
  * client has permission to access it. */
 struct nvmap_handle *nvmap_validate_get(struct nvmap_handle *id)
 {
-	struct nvmap_handle *h = NULL;
-	struct rb_node *n;
+	unsigned long key = (unsigned long)id;
+	struct nvmap_handle *h;
 
 	spin_lock(&nvmap_dev->handle_lock);
-
-	n = nvmap_dev->handles.rb_node;
-
-	while (n) {
-		h = rb_entry(n, struct nvmap_handle, node);
-		if (h == id) {
-			h = nvmap_handle_get(h);
-			spin_unlock(&nvmap_dev->handle_lock);
-			return h;
-		}
-		if (id > h)
-			n = n->rb_right;
-		else
-			n = n->rb_left;
-	}
+	h = rhashtable_lookup_fast(&nvmap_dev->handle_hash, &key,
+				   nvmap_handle_hash_params);
+	if (h)
+		h = nvmap_handle_get(h);
 	spin_unlock(&nvmap_dev->handle_lock);
-	return NULL;
+	return h;
 }
 
-static void add_handle_ref(struct nvmap_client *client,
-			   struct nvmap_handle_ref *ref)
+static int add_handle_ref(struct nvmap_client *client,
+			  struct nvmap_handle_ref *ref)
 {
 	struct rb_node **p, *parent = NULL;
+	int err;
+
+	ref->key = nvmap_ref_key(ref->handle, ref->is_ro);
 
 	nvmap_ref_lock(client);
+	err = rhashtable_insert_fast(&client->ref_hash, &ref->hash_node,
+				     nvmap_ref_hash_params);
+	if (err) {
+		nvmap_ref_unlock(client);
+		return err;
+	}
+
 	p = &client->handle_refs.rb_node;
 	while (*p) {
 		struct nvmap_handle_ref *node;
@@ -160,7 +232,12 @@ static void add_handle_ref(struct nvmap_client *client,
 	if (client->handle_count > nvmap_max_handle_count)
 		nvmap_max_handle_count = client->handle_count;
 	atomic_inc(&ref->handle->share_count);
+	if (ref->handle->alloc && !ref->handle->from_va) {
+		ref->accounted = true;
+		nvmap_usage_charge(&client->usage, ref->handle);
+	}
 	nvmap_ref_unlock(client);
+	return 0;
 }
 
 struct nvmap_handle_ref *nvmap_create_handle_from_va(struct nvmap_client *client,
@@ -234,6 +311,7 @@ struct nvmap_handle_ref *nvmap_create_handle(struct nvmap_client *client,
 
 	atomic_set(&h->ref, 1);
 	atomic_set(&h->pin, 0);
+	RB_CLEAR_NODE(&h->node);
 	h->owner = client;
 	BUG_ON(!h->owner);
 	h->orig_size = size;
@@ -261,19 +339,20 @@ struct nvmap_handle_ref *nvmap_create_handle(struct nvmap_client *client,
 	else
 		h->dmabuf_ro = dmabuf;
 
-	nvmap_handle_add(nvmap_dev, h);
-
 	/*
 	 * Major assumption here: the dma_buf object that the handle contains
 	 * is created with a ref count of 1.
 	 */
 	atomic_set(&ref->dupes, 1);
 	ref->handle = h;
-	add_handle_ref(client, ref);
-	if (ro_buf)
-		ref->is_ro = true;
-	else
-		ref->is_ro = false;
+	ref->is_ro = ro_buf;
+
+	if (nvmap_handle_add(nvmap_dev, h) || add_handle_ref(client, ref)) {
+		/* Dropping the only dmabuf ref frees the handle as well */
+		kfree(ref);
+		dma_buf_put(dmabuf);
+		return ERR_PTR(-ENOMEM);
+	}
 	trace_nvmap_create_handle(client, client->name, h, size, ref);
 	return ref;
 
@@ -360,6 +439,7 @@ struct nvmap_handle_ref *nvmap_duplicate_handle(struct nvmap_client *client,
 					bool is_ro)
 {
 	struct nvmap_handle_ref *ref = NULL;
+	int err;
 
 	BUG_ON(!client);
 
@@ -382,6 +462,7 @@ struct nvmap_handle_ref *nvmap_duplicate_handle(struct nvmap_client *client,
 		return ERR_PTR(-EINVAL);
 	}
 
+again:
 	nvmap_ref_lock(client);
 	ref = __nvmap_validate_locked(client, h, is_ro);
 
@@ -401,15 +482,22 @@ struct nvmap_handle_ref *nvmap_duplicate_handle(struct nvmap_client *client,
 
 	atomic_set(&ref->dupes, 1);
 	ref->handle = h;
-	add_handle_ref(client, ref);
+	ref->is_ro = is_ro;
+	err = add_handle_ref(client, ref);
+	if (err) {
+		kfree(ref);
+		/* Lost a race with a concurrent duplicate of the same handle */
+		if (err == -EEXIST)
+			goto again;
+		nvmap_handle_put(h);
+		return ERR_PTR(err);
+	}
 
 	if (is_ro) {
-		ref->is_ro = true;
 		if (!h->dmabuf_ro)
 			goto exit;
 		get_dma_buf(h->dmabuf_ro);
 	} else {
-		ref->is_ro = false;
 		if (!h->dmabuf)
 			goto exit;
 		get_dma_buf(h->dmabuf);
@@ -9,6 +9,8 @@
 
 #include <linux/debugfs.h>
 #include <linux/device.h>
+#include <linux/dma-buf.h>
+#include <linux/fs.h>
 #include <linux/kernel.h>
 #include <linux/list.h>
 #include <linux/mm.h>
@@ -21,6 +23,9 @@
 #include <linux/io.h>
 #include <linux/version.h>
 #include <linux/limits.h>
+#include <linux/moduleparam.h>
+#include <linux/seq_file.h>
+#include <linux/sort.h>
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 14, 0)
 #include <linux/sched/clock.h>
@@ -41,6 +46,10 @@
 #include "include/linux/nvmap_exports.h"
 #endif
 
+#ifdef NVMAP_UPSTREAM_KERNEL
+#include <linux/libnvdimm.h>
+#endif /* NVMAP_UPSTREAM_KERNEL */
+
 /*
  * "carveouts" are platform-defined regions of physically contiguous memory
  * which are not managed by the OS. A platform may specify multiple carveouts,
@@ -52,6 +61,22 @@
 
 static struct kmem_cache *heap_block_cache;
 
+/*
+ * Freed blocks are parked on per size class free lists, still marked busy in
+ * the carveout bitmap, so that the common free/alloc churn of same sized
+ * buffers skips the bitmap search. The lists are drained back to the bitmap
+ * whenever an allocation can't be satisfied otherwise.
+ */
+static bool carveout_free_lists = true;
+module_param(carveout_free_lists, bool, 0644);
+
+/*
+ * Try compacting a carveout, by moving unmapped blocks towards its base,
+ * before failing an allocation from it.
+ */
+static bool carveout_compact_on_fail;
+module_param(carveout_compact_on_fail, bool, 0644);
+
 struct device *dma_dev_from_handle(unsigned long type)
 {
 	int i;
@@ -84,6 +109,104 @@ size_t nvmap_query_heap_size(struct nvmap_heap *heap)
 	return heap->len;
 }
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 10, 0)
+/* Walk the carveout bitmap for the largest free extent and the extent count */
+static size_t nvmap_heap_free_extents(struct nvmap_heap *heap,
+				      unsigned long *nr_extents)
+{
+	struct dma_coherent_mem_replica *mem;
+	unsigned long start, end, size, flags;
+	unsigned int shift = PAGE_SHIFT;
+	size_t largest = 0;
+
+	*nr_extents = 0;
+	if (heap->cma_dev || !heap->dma_dev->dma_mem)
+		return 0;
+
+	mem = (struct dma_coherent_mem_replica *)heap->dma_dev->dma_mem;
+	if (heap->is_gpu_co)
+		shift = PAGE_SHIFT_GRANULE(heap->granule_size);
+	size = mem->size;
+
+	spin_lock_irqsave(&mem->spinlock, flags);
+	for (start = find_first_zero_bit(mem->bitmap, size); start < size;
+	     start = find_next_zero_bit(mem->bitmap, size, end)) {
+		end = find_next_bit(mem->bitmap, size, start);
+		largest = max_t(size_t, largest, (end - start) << shift);
+		(*nr_extents)++;
+	}
+	spin_unlock_irqrestore(&mem->spinlock, flags);
+	return largest;
+}
+#else
+static size_t nvmap_heap_free_extents(struct nvmap_heap *heap,
+				      unsigned long *nr_extents)
+{
+	*nr_extents = 0;
+	return 0;
+}
+#endif
+
+size_t nvmap_query_heap_largest_free(struct nvmap_heap *heap)
+{
+	unsigned long nr_extents;
+
+	if (!heap)
+		return 0;
+
+	return nvmap_heap_free_extents(heap, &nr_extents);
+}
+
+static int heap_fragmentation_show(struct seq_file *s, void *unused)
+{
+	struct nvmap_heap *heap = s->private;
+	unsigned long nr_extents;
+	size_t largest;
+
+	largest = nvmap_heap_free_extents(heap, &nr_extents);
+
+	mutex_lock(&heap->lock);
+	seq_printf(s, "free_size:      %zu\n", heap->free_size);
+	seq_printf(s, "cached_size:    %zu\n", heap->cached_size);
+	seq_printf(s, "largest_free:   %zu\n", largest);
+	seq_printf(s, "free_extents:   %lu\n", nr_extents);
+	seq_printf(s, "cache_hits:     %llu\n", heap->cache_hits);
+	seq_printf(s, "cache_misses:   %llu\n", heap->cache_misses);
+	seq_printf(s, "cache_drains:   %llu\n", heap->cache_drains);
+	seq_printf(s, "compact_runs:   %llu\n", heap->compact_runs);
+	seq_printf(s, "compact_moves:  %llu\n", heap->compact_moves);
+	seq_printf(s, "compact_bytes:  %llu\n", heap->compact_bytes);
+	mutex_unlock(&heap->lock);
+	return 0;
+}
+
+static int heap_fragmentation_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, heap_fragmentation_show, inode->i_private);
+}
+
+static const struct file_operations heap_fragmentation_fops = {
+	.open = heap_fragmentation_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static ssize_t heap_compact_write(struct file *file, const char __user *buf,
+				  size_t count, loff_t *ppos)
+{
+	struct nvmap_heap *heap = file->private_data;
+
+	nvmap_heap_compact(heap);
+	return count;
+}
+
+static const struct file_operations heap_compact_fops = {
+	.open = simple_open,
+	.write = heap_compact_write,
+	.llseek = noop_llseek,
+};
+
 void nvmap_heap_debugfs_init(struct dentry *heap_root, struct nvmap_heap *heap)
 {
 	if (sizeof(heap->base) == sizeof(u64))
@@ -104,6 +227,10 @@ void nvmap_heap_debugfs_init(struct dentry *heap_root, struct nvmap_heap *heap)
 	else
 		debugfs_create_x32("free_size", S_IRUGO,
 			heap_root, (u32 *)&heap->free_size);
+	debugfs_create_file("fragmentation", S_IRUGO,
+			heap_root, heap, &heap_fragmentation_fops);
+	debugfs_create_file("compact", S_IWUSR,
+			heap_root, heap, &heap_compact_fops);
 }
 
 static phys_addr_t nvmap_alloc_mem(struct nvmap_heap *h, size_t len,
@@ -238,6 +365,85 @@ static void nvmap_free_mem(struct nvmap_heap *h, phys_addr_t base,
 	}
 }
 
+static int nvmap_heap_size_class(size_t len)
+{
+	unsigned long nr_pages = PAGE_ALIGN(len) >> PAGE_SHIFT;
+	int class;
+
+	if (!nr_pages)
+		return -1;
+
+	class = fls_long(nr_pages) - 1;
+	return class < NVMAP_HEAP_NR_CLASSES ? class : -1;
+}
+
+/* Take an exactly sized, suitably aligned block off the free lists. */
+static struct list_block *nvmap_heap_cache_get(struct nvmap_heap *heap,
+					       size_t len, size_t align)
+{
+	struct list_block *lb;
+	int class;
+
+	if (!heap->cached_size)
+		return NULL;
+
+	class = nvmap_heap_size_class(len);
+	if (class < 0)
+		return NULL;
+
+	list_for_each_entry(lb, &heap->free_lists[class], free_list) {
+		if (lb->size == len && IS_ALIGNED(lb->block.base, align)) {
+			list_del(&lb->free_list);
+			heap->cached_size -= lb->size;
+			heap->cache_hits++;
+			return lb;
+		}
+	}
+	heap->cache_misses++;
+	return NULL;
+}
+
+/* Park a freed block on its free list; false if it must really be freed. */
+static bool nvmap_heap_cache_put(struct nvmap_heap *heap, struct list_block *lb)
+{
+	int class;
+
+	if (!heap->can_cache || !carveout_free_lists)
+		return false;
+
+	class = nvmap_heap_size_class(lb->size);
+	if (class < 0 || heap->cached_size + lb->size > heap->cache_limit)
+		return false;
+
+	list_del(&lb->all_list);
+	lb->block.handle = NULL;
+	list_add(&lb->free_list, &heap->free_lists[class]);
+	heap->cached_size += lb->size;
+	heap->free_size += lb->size;
+	return true;
+}
+
+/* Return all parked blocks to the carveout bitmap. */
+static void nvmap_heap_cache_drain(struct nvmap_heap *heap)
+{
+	struct list_block *lb, *tmp;
+	int i;
+
+	if (!heap->cached_size)
+		return;
+
+	for (i = 0; i < NVMAP_HEAP_NR_CLASSES; i++) {
+		list_for_each_entry_safe(lb, tmp, &heap->free_lists[i],
+					 free_list) {
+			list_del(&lb->free_list);
+			nvmap_free_mem(heap, lb->block.base, lb->size, NULL);
+			kmem_cache_free(heap_block_cache, lb);
+		}
+	}
+	heap->cached_size = 0;
+	heap->cache_drains++;
+}
+
 /*
  * base_max limits position of allocated chunk in memory.
  * if base_max is 0 then there is no such limitation.
@@ -267,6 +473,14 @@ static struct nvmap_heap_block *do_heap_alloc(struct nvmap_heap *heap,
 	if (heap->is_ivm)
 		align = max_t(size_t, align, NVMAP_IVM_ALIGNMENT);
 
+	if (!start) {
+		heap_block = nvmap_heap_cache_get(heap, len, align);
+		if (heap_block) {
+			dev_base = heap_block->block.base;
+			goto init_block;
+		}
+	}
+
 	heap_block = kmem_cache_zalloc(heap_block_cache, GFP_KERNEL);
 	if (!heap_block) {
 		dev_err(dev, "%s: failed to alloc heap block %s\n",
@@ -275,6 +489,11 @@ static struct nvmap_heap_block *do_heap_alloc(struct nvmap_heap *heap,
 	}
 
 	dev_base = nvmap_alloc_mem(heap, len, start, handle);
+	if (dma_mapping_error(dev, dev_base) && heap->cached_size) {
+		/* parked blocks may be what is in the way, retry without them */
+		nvmap_heap_cache_drain(heap);
+		dev_base = nvmap_alloc_mem(heap, len, start, handle);
+	}
 	if (dma_mapping_error(dev, dev_base)) {
 		dev_err(dev, "failed to alloc mem of size (%zu)\n",
 			len);
@@ -290,6 +509,7 @@ static struct nvmap_heap_block *do_heap_alloc(struct nvmap_heap *heap,
 		goto fail_dma_alloc;
 	}
 
+init_block:
 	heap_block->block.base = dev_base;
 	heap_block->orig_addr = dev_base;
 	heap_block->size = len;
@@ -312,6 +532,9 @@ static void do_heap_free(struct nvmap_heap_block *block)
 	struct list_block *b = container_of(block, struct list_block, block);
 	struct nvmap_heap *heap = b->heap;
 
+	if (nvmap_heap_cache_put(heap, b))
+		return;
+
 	list_del(&b->all_list);
 
 	nvmap_free_mem(heap, block->base, b->size, block->handle);
@@ -369,6 +592,12 @@ struct nvmap_heap_block *nvmap_heap_alloc(struct nvmap_heap *h,
 
 	align = max_t(size_t, align, L1_CACHE_BYTES);
 	b = do_heap_alloc(h, len, align, prot, 0, start, handle);
+	if (!b && !start && carveout_compact_on_fail && h->can_cache) {
+		mutex_unlock(&h->lock);
+		nvmap_heap_compact(h);
+		mutex_lock(&h->lock);
+		b = do_heap_alloc(h, len, align, prot, 0, start, handle);
+	}
 	if (b) {
 		b->handle = handle;
 		handle->carveout = b;
@@ -440,6 +669,211 @@ void nvmap_heap_free(struct nvmap_heap_block *b)
 	mutex_unlock(&h->lock);
 }
 
+struct nvmap_compact_entry {
+	struct nvmap_handle *handle;
+	phys_addr_t base;
+};
+
+static int nvmap_compact_entry_cmp(const void *a, const void *b)
+{
+	const struct nvmap_compact_entry *ea = a, *eb = b;
+
+	if (ea->base == eb->base)
+		return 0;
+	return ea->base < eb->base ? -1 : 1;
+}
+
+/*
+ * A block can move only while nothing holds its address: no device
+ * mapping (stashed or live), no user or kernel CPU mapping and no pin.
+ * Called with h->lock and the maps_lock of every dmabuf of h held.
+ */
+static bool nvmap_heap_block_movable(struct nvmap_handle *h,
+				     struct dma_buf **bufs, int nr_bufs)
+{
+	struct nvmap_handle_info *info;
+	int i;
+
+	if (!h->alloc || h->heap_pgalloc || !h->carveout || h->pgalloc.pages)
+		return false;
+
+	if (h->heap_type & NVMAP_HEAP_CARVEOUT_VPR ||
+	    !(h->heap_type & nvmap_dev->cpu_access_mask))
+		return false;
+
+	if (atomic_read(&h->pin) || atomic_read(&h->umap_count) ||
+	    atomic_read(&h->kmap_count) || h->vaddr ||
+	    !list_empty(&h->vmas))
+		return false;
+
+	for (i = 0; i < nr_bufs; i++) {
+		info = bufs[i]->priv;
+		if (!list_empty(&info->maps))
+			return false;
+	}
+	return true;
+}
+
+static void nvmap_heap_copy_block(phys_addr_t dst, phys_addr_t src, size_t len)
+{
+	void *dst_va, *src_va;
+
+	src_va = memremap(src, len, MEMREMAP_WB);
+	dst_va = memremap(dst, len, MEMREMAP_WB);
+	if (src_va && dst_va) {
+		memcpy(dst_va, src_va, len);
+#ifdef NVMAP_UPSTREAM_KERNEL
+		arch_invalidate_pmem(dst_va, len);
+		arch_invalidate_pmem(src_va, len);
+#else
+		__dma_flush_area(dst_va, len);
+		__dma_flush_area(src_va, len);
+#endif
+	}
+	if (dst_va)
+		memunmap(dst_va);
+	if (src_va)
+		memunmap(src_va);
+}
+
+/*
+ * Move the block of h to the lowest free spot below it, if there is one.
+ * Everything is trylocked: compaction is best effort and must not add lock
+ * dependencies on the handles it walks.
+ */
+static size_t nvmap_heap_move_block(struct nvmap_heap *heap,
+				    struct nvmap_handle *h)
+{
+	struct dma_buf *bufs[2];
+	struct dma_buf *dmabufs[2];
+	struct list_block *lb;
+	phys_addr_t new_base, old_base;
+	size_t moved = 0;
+	int i, nr_bufs = 0, nr_locked = 0;
+
+	if (!mutex_trylock(&h->lock))
+		return 0;
+	dmabufs[0] = h->dmabuf;
+	dmabufs[1] = h->dmabuf_ro;
+	for (i = 0; i < ARRAY_SIZE(dmabufs); i++) {
+		if (!dmabufs[i])
+			continue;
+		/* same as get_dma_buf(), unless release already started */
+		if (!atomic_long_inc_not_zero(&dmabufs[i]->file->f_count)) {
+			mutex_unlock(&h->lock);
+			goto put_bufs;
+		}
+		bufs[nr_bufs++] = dmabufs[i];
+	}
+	mutex_unlock(&h->lock);
+
+	/* nvmap_dmabuf_release() nests h->lock inside maps_lock */
+	for (nr_locked = 0; nr_locked < nr_bufs; nr_locked++) {
+		struct nvmap_handle_info *info = bufs[nr_locked]->priv;
+
+		if (!mutex_trylock(&info->maps_lock))
+			goto unlock_maps;
+	}
+	if (!mutex_trylock(&h->lock))
+		goto unlock_maps;
+
+	if (!nvmap_heap_block_movable(h, bufs, nr_bufs))
+		goto unlock_handle;
+
+	lb = container_of(h->carveout, struct list_block, block);
+	if (lb->heap != heap)
+		goto unlock_handle;
+
+	mutex_lock(&heap->lock);
+	old_base = lb->block.base;
+	new_base = nvmap_alloc_mem(heap, lb->size, NULL, h);
+	if (dma_mapping_error(heap->dma_dev, new_base))
+		goto unlock_heap;
+	if (new_base >= old_base) {
+		nvmap_free_mem(heap, new_base, lb->size, h);
+		goto unlock_heap;
+	}
+
+	nvmap_flush_heap_block(NULL, &lb->block, lb->size, lb->mem_prot);
+	nvmap_heap_copy_block(new_base, old_base, PAGE_ALIGN(lb->size));
+	lb->block.base = new_base;
+	lb->orig_addr = new_base;
+	nvmap_free_mem(heap, old_base, lb->size, h);
+	heap->compact_moves++;
+	heap->compact_bytes += lb->size;
+	moved = lb->size;
+unlock_heap:
+	mutex_unlock(&heap->lock);
+unlock_handle:
+	mutex_unlock(&h->lock);
+unlock_maps:
+	while (nr_locked--) {
+		struct nvmap_handle_info *info = bufs[nr_locked]->priv;
+
+		mutex_unlock(&info->maps_lock);
+	}
+put_bufs:
+	while (nr_bufs--)
+		dma_buf_put(bufs[nr_bufs]);
+	return moved;
+}
+
+/*
+ * nvmap_heap_compact: slide movable blocks towards the heap base, lowest
+ * first, so that free space coalesces at the top of the carveout. Returns
+ * the number of bytes moved. Must be called without heap->lock held.
+ */
+size_t nvmap_heap_compact(struct nvmap_heap *heap)
+{
+	struct nvmap_compact_entry *entries;
+	struct list_block *lb;
+	size_t nr = 0, i, moved = 0;
+
+	if (!heap || !heap->can_cache)
+		return 0;
+
+	mutex_lock(&heap->lock);
+	nvmap_heap_cache_drain(heap);
+	heap->compact_runs++;
+	list_for_each_entry(lb, &heap->all_list, all_list)
+		nr++;
+	if (!nr) {
+		mutex_unlock(&heap->lock);
+		return 0;
+	}
+
+	entries = kvmalloc_array(nr, sizeof(*entries), GFP_KERNEL);
+	if (!entries) {
+		mutex_unlock(&heap->lock);
+		return 0;
+	}
+
+	nr = 0;
+	list_for_each_entry(lb, &heap->all_list, all_list) {
+		struct nvmap_handle *h = lb->block.handle;
+
+		/* skip handles whose last reference is already gone */
+		if (!h || !atomic_inc_not_zero(&h->ref))
+			continue;
+		entries[nr].handle = h;
+		entries[nr].base = lb->block.base;
+		nr++;
+	}
+	mutex_unlock(&heap->lock);
+
+	sort(entries, nr, sizeof(*entries), nvmap_compact_entry_cmp, NULL);
+
+	for (i = 0; i < nr; i++) {
+		moved += nvmap_heap_move_block(heap, entries[i].handle);
+		nvmap_handle_put(entries[i].handle);
+	}
+	kvfree(entries);
+
+	if (moved)
+		pr_debug("%s: moved %zu bytes\n", heap->name, moved);
+	return moved;
+}
+
 /* nvmap_heap_create: create a heap object of len bytes, starting from
  * address base.
  */
@@ -448,6 +882,7 @@ struct nvmap_heap *nvmap_heap_create(struct device *parent,
 				     phys_addr_t base, size_t len, void *arg)
 {
 	struct nvmap_heap *h;
+	int i;
 
 	h = kzalloc(sizeof(*h), GFP_KERNEL);
 	if (!h) {
@@ -519,6 +954,11 @@ struct nvmap_heap *nvmap_heap_create(struct device *parent,
 
 	INIT_LIST_HEAD(&h->all_list);
 	mutex_init(&h->lock);
+	for (i = 0; i < NVMAP_HEAP_NR_CLASSES; i++)
+		INIT_LIST_HEAD(&h->free_lists[i]);
+	/* IVM offsets are exported and GPU/CMA blocks are freed specially */
+	h->can_cache = !h->is_ivm && !h->is_gpu_co && !h->cma_dev;
+	h->cache_limit = len / 16;
 #ifdef NVMAP_CONFIG_DEBUG_MAPS
 	h->device_names = RB_ROOT;
 #endif /* NVMAP_CONFIG_DEBUG_MAPS */
@@ -555,6 +995,10 @@ fail:
 /* nvmap_heap_destroy: frees all resources in heap */
 void nvmap_heap_destroy(struct nvmap_heap *heap)
 {
+	mutex_lock(&heap->lock);
+	nvmap_heap_cache_drain(heap);
+	mutex_unlock(&heap->lock);
+
 	WARN_ON(!list_empty(&heap->all_list));
 	if (heap->dma_dev->kobj.name)
 		kfree_const(heap->dma_dev->kobj.name);
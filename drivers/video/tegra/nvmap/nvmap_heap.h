@@ -12,6 +12,12 @@ struct device;
 struct nvmap_heap;
 struct nvmap_client;
 
+/*
+ * Freed blocks of up to PAGE_SIZE << (NVMAP_HEAP_NR_CLASSES - 1) bytes are
+ * kept on per size class free lists for quick reuse.
+ */
+#define NVMAP_HEAP_NR_CLASSES	10
+
 struct nvmap_heap_block {
 	phys_addr_t	base;
 	unsigned int	type;
@@ -40,6 +46,18 @@ struct nvmap_heap {
 #ifdef NVMAP_CONFIG_DEBUG_MAPS
 	struct rb_root device_names;
 #endif /* NVMAP_CONFIG_DEBUG_MAPS */
+	/* size class free lists, protected by lock */
+	struct list_head free_lists[NVMAP_HEAP_NR_CLASSES];
+	bool can_cache;
+	size_t cached_size;
+	size_t cache_limit;
+	u64 cache_hits;
+	u64 cache_misses;
+	u64 cache_drains;
+	/* online compaction statistics */
+	u64 compact_runs;
+	u64 compact_moves;
+	u64 compact_bytes;
 };
 
 struct list_block {
@@ -78,5 +96,8 @@ void nvmap_heap_debugfs_init(struct dentry *heap_root, struct nvmap_heap *heap);
 
 int nvmap_query_heap_peer(struct nvmap_heap *heap, unsigned int *peer);
 size_t nvmap_query_heap_size(struct nvmap_heap *heap);
+size_t nvmap_query_heap_largest_free(struct nvmap_heap *heap);
+
+size_t nvmap_heap_compact(struct nvmap_heap *heap);
 
 #endif
@@ -282,6 +282,166 @@ int nvmap_ioctl_alloc_ivm(struct file *filp, void __user *arg)
 	return err;
 }
 
+/* Upper bound on handles created by one NVMAP_IOC_ALLOC_BATCH call */
+#define NVMAP_ALLOC_BATCH_MAX	64
+
+/*
+ * Create, allocate and export op.count handles sharing one set of
+ * parameters. Either every handle is handed to userspace or none is: fds
+ * are only installed once the whole array was copied out, and any failure
+ * unwinds the handles created so far.
+ */
+int nvmap_ioctl_alloc_batch(struct file *filp, void __user *arg)
+{
+	struct nvmap_client *client = filp->private_data;
+	struct nvmap_alloc_batch op;
+	struct nvmap_handle_ref **refs;
+	struct nvmap_handle *h;
+	unsigned int page_sz = PAGE_SIZE;
+	u32 granule_size = 0;
+	u32 i, created = 0, exported = 0;
+	u32 *ids;
+	size_t bytes;
+	u64 size;
+	int err = 0;
+	int fd;
+
+	if (!client)
+		return -ENODEV;
+
+	if (copy_from_user(&op, arg, sizeof(op)))
+		return -EFAULT;
+
+	if (!op.count || op.count > NVMAP_ALLOC_BATCH_MAX || !op.size ||
+	    !op.handles || op.reserved)
+		return -EINVAL;
+
+	if (op.align & (op.align - 1))
+		return -EINVAL;
+
+	if (op.numa_nid > MAX_NUMNODES || (op.numa_nid != NUMA_NO_NODE && op.numa_nid < 0)) {
+		pr_err("numa id:%d is invalid\n", op.numa_nid);
+		return -EINVAL;
+	}
+
+	if (!ACCESS_OK(VERIFY_WRITE, (void __user *)op.handles,
+		       op.count * sizeof(u32)))
+		return -EFAULT;
+
+	/*
+	 * In case of Gpu carveout, the handle size needs to be aligned to granule.
+	 */
+	size = op.size;
+	if (op.heap_mask & NVMAP_HEAP_CARVEOUT_GPU) {
+		for (i = 0; i < nvmap_dev->nr_carveouts; i++)
+			if (nvmap_dev->heaps[i].heap_bit & NVMAP_HEAP_CARVEOUT_GPU)
+				granule_size = nvmap_dev->heaps[i].carveout->granule_size;
+		size = ALIGN_GRANULE_SIZE(PAGE_ALIGN(size), granule_size);
+		page_sz = granule_size;
+	}
+
+	if (size > SIZE_MAX / op.count)
+		return -EINVAL;
+
+	/* Fail early rather than after allocating part of the batch */
+	if (!is_nvmap_memory_available(size * op.count, op.heap_mask))
+		return -ENOMEM;
+
+	/* user-space handles are aligned to page boundaries, to prevent
+	 * data leakage. */
+	op.align = max_t(size_t, op.align, page_sz);
+
+	bytes = op.count * (sizeof(*refs) + sizeof(*ids));
+	refs = nvmap_altalloc(bytes);
+	if (!refs)
+		return -ENOMEM;
+	ids = (u32 *)(refs + op.count);
+
+	for (created = 0; created < op.count; created++) {
+		refs[created] = nvmap_create_handle(client, op.size, false);
+		if (IS_ERR(refs[created])) {
+			err = PTR_ERR(refs[created]);
+			goto unwind;
+		}
+
+		/*
+		 * Hold a dup so that a racing NvRmMemHandleFree on a guessed
+		 * id cannot drop the handle under us.
+		 */
+		atomic_inc(&refs[created]->dupes);
+		h = refs[created]->handle;
+		h->orig_size = op.size;
+		if (op.heap_mask & NVMAP_HEAP_CARVEOUT_GPU)
+			h->size = ALIGN_GRANULE_SIZE(h->size, granule_size);
+		h->numa_id = op.numa_nid;
+
+		err = nvmap_alloc_handle(client, h, op.heap_mask, op.align,
+					  0, /* no kind */
+					  op.flags & (~NVMAP_HANDLE_KIND_SPECIFIED),
+					  NVMAP_IVM_INVALID_PEER);
+		if (err) {
+			atomic_dec(&refs[created]->dupes);
+			nvmap_free_handle(client, h, false);
+			goto unwind;
+		}
+	}
+
+	for (exported = 0; exported < op.count; exported++) {
+		h = refs[exported]->handle;
+		if (client->ida) {
+			if (nvmap_id_array_id_alloc(client->ida,
+					&ids[exported], h->dmabuf) < 0) {
+				err = -ENOMEM;
+				goto unwind;
+			}
+			continue;
+		}
+
+		fd = nvmap_get_dmabuf_fd(client, h, false);
+		if (fd < 0) {
+			err = fd;
+			goto unwind;
+		}
+		ids[exported] = fd;
+	}
+
+	if (copy_to_user((void __user *)op.handles, ids,
+			 op.count * sizeof(u32))) {
+		err = -EFAULT;
+		goto unwind;
+	}
+
+	for (i = 0; i < op.count; i++) {
+		h = refs[i]->handle;
+		if (!client->ida)
+			fd_install(ids[i], h->dmabuf->file);
+		trace_refcount_create_handle(h, h->dmabuf,
+			atomic_read(&h->ref),
+			atomic_long_read(&h->dmabuf->file->f_count),
+			"RW");
+		atomic_dec(&refs[i]->dupes);
+	}
+	goto out;
+
+unwind:
+	for (i = 0; i < created; i++) {
+		h = refs[i]->handle;
+		if (i < exported) {
+			if (client->ida) {
+				nvmap_id_array_id_release(client->ida, ids[i]);
+			} else {
+				put_unused_fd(ids[i]);
+				dma_buf_put(h->dmabuf);
+			}
+		}
+		atomic_dec(&refs[i]->dupes);
+		nvmap_free_handle(client, h, false);
+	}
+out:
+	nvmap_altfree(refs, bytes);
+	return err;
+}
+
 int nvmap_ioctl_vpr_floor_size(struct file *filp, void __user *arg)
 {
 	int err=0;
@@ -1223,49 +1383,34 @@ exit:
 }
 
 #ifdef NVMAP_CONFIG_SCIIPC
-int nvmap_ioctl_get_sci_ipc_id(struct file *filp, void __user *arg)
+#define NVMAP_SCIIPC_LIST_MAX	64
+
+static int nvmap_export_sci_ipc_id(struct nvmap_client *client, u32 id,
+		u32 flags, NvSciIpcEndpointVuid pr_vuid, u64 *sci_ipc_id)
 {
-	struct nvmap_client *client = filp->private_data;
-	NvSciIpcEndpointVuid pr_vuid, lclu_vuid;
 	struct nvmap_handle *handle = NULL;
-	struct nvmap_sciipc_map op;
 	struct dma_buf *dmabuf = NULL;
 	bool is_ro = false;
 	int ret = 0;
 
-	if (copy_from_user(&op, arg, sizeof(op)))
-		return -EFAULT;
-
-	handle = nvmap_handle_get_from_id(client, op.handle);
+	handle = nvmap_handle_get_from_id(client, id);
 	if (IS_ERR_OR_NULL(handle))
 		return -ENODEV;
 
-	if (is_nvmap_id_ro(client, op.handle, &is_ro) != 0) {
+	if (is_nvmap_id_ro(client, id, &is_ro) != 0) {
 		pr_err("Handle ID RO check failed\n");
 		ret = -EINVAL;
 		goto exit;
 	}
 
 	/* Cannot create RW handle from RO handle */
-	if (is_ro && (op.flags != PROT_READ)) {
+	if (is_ro && (flags != PROT_READ)) {
 		ret = -EPERM;
 		goto exit;
 	}
 
-	ret = nvmap_validate_sci_ipc_params(client, op.auth_token,
-		&pr_vuid, &lclu_vuid);
-	if (ret)
-		goto exit;
-
-	ret = nvmap_create_sci_ipc_id(client, handle, op.flags,
-			 &op.sci_ipc_id, pr_vuid, is_ro);
-	if (ret)
-		goto exit;
-
-	if (copy_to_user(arg, &op, sizeof(op))) {
-		pr_err("copy_to_user failed\n");
-		ret = -EINVAL;
-	}
+	ret = nvmap_create_sci_ipc_id(client, handle, flags,
+			 sci_ipc_id, pr_vuid, is_ro);
 
 exit:
 	if (!ret) {
@@ -1280,6 +1425,34 @@ exit:
 	return ret;
 }
 
+int nvmap_ioctl_get_sci_ipc_id(struct file *filp, void __user *arg)
+{
+	struct nvmap_client *client = filp->private_data;
+	NvSciIpcEndpointVuid pr_vuid, lclu_vuid;
+	struct nvmap_sciipc_map op;
+	int ret = 0;
+
+	if (copy_from_user(&op, arg, sizeof(op)))
+		return -EFAULT;
+
+	ret = nvmap_validate_sci_ipc_params(client, op.auth_token,
+		&pr_vuid, &lclu_vuid);
+	if (ret)
+		return ret;
+
+	ret = nvmap_export_sci_ipc_id(client, op.handle, op.flags, pr_vuid,
+			&op.sci_ipc_id);
+	if (ret)
+		return ret;
+
+	if (copy_to_user(arg, &op, sizeof(op))) {
+		pr_err("copy_to_user failed\n");
+		ret = -EINVAL;
+	}
+
+	return ret;
+}
+
 int nvmap_ioctl_handle_from_sci_ipc_id(struct file *filp, void __user *arg)
 {
 	struct nvmap_client *client = filp->private_data;
@@ -1309,6 +1482,134 @@ int nvmap_ioctl_handle_from_sci_ipc_id(struct file *filp, void __user *arg)
 exit:
 	return ret;
 }
+
+static int nvmap_sciipc_list_get_op(struct nvmap_sciipc_map_list *op,
+		void __user *arg, u32 **handles, u64 **sci_ipc_ids)
+{
+	if (copy_from_user(op, arg, sizeof(*op)))
+		return -EFAULT;
+
+	if (!op->count || op->count > NVMAP_SCIIPC_LIST_MAX ||
+	    !op->handles || !op->sci_ipc_ids ||
+	    op->reserved[0] || op->reserved[1])
+		return -EINVAL;
+
+	*sci_ipc_ids = nvmap_altalloc(op->count * (sizeof(u64) + sizeof(u32)));
+	if (!*sci_ipc_ids)
+		return -ENOMEM;
+	*handles = (u32 *)(*sci_ipc_ids + op->count);
+
+	return 0;
+}
+
+/*
+ * Export a list of handles to the same peer: the auth token is validated
+ * once and the ids are only handed out once the whole list succeeded.
+ */
+int nvmap_ioctl_get_sci_ipc_id_list(struct file *filp, void __user *arg)
+{
+	struct nvmap_client *client = filp->private_data;
+	NvSciIpcEndpointVuid pr_vuid, lclu_vuid;
+	struct nvmap_sciipc_map_list op;
+	u32 *handles;
+	u64 *sci_ipc_ids;
+	u32 i, exported = 0;
+	int ret;
+
+	ret = nvmap_sciipc_list_get_op(&op, arg, &handles, &sci_ipc_ids);
+	if (ret)
+		return ret;
+
+	if (copy_from_user(handles, (void __user *)op.handles,
+			   op.count * sizeof(u32))) {
+		ret = -EFAULT;
+		goto out;
+	}
+
+	ret = nvmap_validate_sci_ipc_params(client, op.auth_token,
+		&pr_vuid, &lclu_vuid);
+	if (ret)
+		goto out;
+
+	for (exported = 0; exported < op.count; exported++) {
+		ret = nvmap_export_sci_ipc_id(client, handles[exported],
+				op.flags, pr_vuid, &sci_ipc_ids[exported]);
+		if (ret)
+			goto unwind;
+	}
+
+	if (copy_to_user((void __user *)op.sci_ipc_ids, sci_ipc_ids,
+			 op.count * sizeof(u64))) {
+		pr_err("copy_to_user failed\n");
+		ret = -EINVAL;
+		goto unwind;
+	}
+
+	goto out;
+
+unwind:
+	for (i = 0; i < exported; i++)
+		nvmap_release_sci_ipc_id(sci_ipc_ids[i]);
+out:
+	nvmap_altfree(sci_ipc_ids, op.count * (sizeof(u64) + sizeof(u32)));
+	return ret;
+}
+
+/*
+ * Import a list of ids from the same peer. Imported handles cannot be taken
+ * back once installed, so the import stops at the first failing id and
+ * count is updated to the number of handles written to the handles array.
+ */
+int nvmap_ioctl_handle_from_sci_ipc_id_list(struct file *filp,
+		void __user *arg)
+{
+	struct nvmap_client *client = filp->private_data;
+	NvSciIpcEndpointVuid pr_vuid, lclu_vuid;
+	struct nvmap_sciipc_map_list op;
+	struct nvmap_sciipc_map_list __user *uop = arg;
+	u32 *handles;
+	u64 *sci_ipc_ids;
+	u32 imported = 0;
+	int ret;
+
+	ret = nvmap_sciipc_list_get_op(&op, arg, &handles, &sci_ipc_ids);
+	if (ret)
+		return ret;
+
+	if (copy_from_user(sci_ipc_ids, (void __user *)op.sci_ipc_ids,
+			   op.count * sizeof(u64))) {
+		ret = -EFAULT;
+		goto out;
+	}
+
+	ret = nvmap_validate_sci_ipc_params(client, op.auth_token,
+		&pr_vuid, &lclu_vuid);
+	if (ret)
+		goto out;
+
+	for (imported = 0; imported < op.count; imported++) {
+		ret = nvmap_get_handle_from_sci_ipc_id(client, op.flags,
+				sci_ipc_ids[imported], lclu_vuid,
+				&handles[imported]);
+		if (ret)
+			break;
+	}
+
+	if (imported && copy_to_user((void __user *)op.handles, handles,
+				     imported * sizeof(u32))) {
+		pr_err("copy_to_user failed\n");
+		ret = -EINVAL;
+	}
+
+	if (put_user(imported, &uop->count)) {
+		pr_err("put_user failed\n");
+		ret = -EINVAL;
+	}
+
+out:
+	nvmap_altfree(sci_ipc_ids, op.count * (sizeof(u64) + sizeof(u32)));
+	return ret;
+}
 #else
 int nvmap_ioctl_get_sci_ipc_id(struct file *filp, void __user *arg)
 {
@@ -1318,6 +1619,15 @@ int nvmap_ioctl_handle_from_sci_ipc_id(struct file *filp, void __user *arg)
 {
 	return -EPERM;
 }
+int nvmap_ioctl_get_sci_ipc_id_list(struct file *filp, void __user *arg)
+{
+	return -EPERM;
+}
+int nvmap_ioctl_handle_from_sci_ipc_id_list(struct file *filp,
+		void __user *arg)
+{
+	return -EPERM;
+}
 #endif
 
 /*
@@ -1404,6 +1714,9 @@ int nvmap_ioctl_query_heap_params(struct file *filp, void __user *arg)
 				heap = nvmap_dev->heaps[i].carveout;
 				op.total = nvmap_query_heap_size(heap);
 				op.free = heap->free_size;
+				op.largest_free_block = max_t(u64,
+					nvmap_query_heap_largest_free(heap),
+					op.largest_free_block);
 				if (nvmap_dev->heaps[i].carveout->is_gpu_co)
 					op.granule_size = nvmap_dev->heaps[i].carveout->granule_size;
 				break;
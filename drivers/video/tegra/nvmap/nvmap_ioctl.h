@@ -62,9 +62,16 @@ int nvmap_ioctl_get_sci_ipc_id(struct file *filp, void __user *arg);
 
 int nvmap_ioctl_handle_from_sci_ipc_id(struct file *filp, void __user *arg);
 
+int nvmap_ioctl_get_sci_ipc_id_list(struct file *filp, void __user *arg);
+
+int nvmap_ioctl_handle_from_sci_ipc_id_list(struct file *filp,
+		void __user *arg);
+
 int nvmap_ioctl_query_heap_params(struct file *filp, void __user *arg);
 
 int nvmap_ioctl_dup_handle(struct file *filp, void __user *arg);
 
 int nvmap_ioctl_get_fd_from_list(struct file *filp, void __user *arg);
+
+int nvmap_ioctl_alloc_batch(struct file *filp, void __user *arg);
 #endif	/*  __VIDEO_TEGRA_NVMAP_IOCTL_H */
@@ -18,6 +18,8 @@
 #include <linux/debugfs.h>
 #include <linux/freezer.h>
 #include <linux/highmem.h>
+#include <linux/percpu.h>
+#include <linux/seq_file.h>
 #include <linux/version.h>
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 14, 0)
@@ -31,11 +33,30 @@
 
 #define NVMAP_TEST_PAGE_POOL_SHRINKER     1
 #define PENDING_PAGES_SIZE                (SZ_1M / PAGE_SIZE)
+#define NVMAP_PP_MAX_ZERO_THREADS         (8)
 
 static bool enable_pp = 1;
 static u32 pool_size;
+static bool enable_pp_mag = 1;
+module_param(enable_pp_mag, bool, 0644);
 
-static struct task_struct *background_allocator;
+/*
+ * Number of background zeroing threads; 0 picks one per four online CPUs.
+ * The threads run SCHED_NORMAL at zero_thread_nice.
+ */
+static uint zero_threads;
+module_param(zero_threads, uint, 0444);
+static int zero_thread_nice = MAX_NICE;
+module_param(zero_thread_nice, int, 0444);
+
+struct nvmap_pp_zero_worker {
+	struct task_struct *task;
+	struct page **pending;	/* Batch being zeroed, too big for the stack */
+	int nid;		/* Node whose dirty pages are zeroed first */
+};
+
+static struct nvmap_pp_zero_worker bg_zero_workers[NVMAP_PP_MAX_ZERO_THREADS];
+static u32 nr_bg_zero_workers;
 static DECLARE_WAIT_QUEUE_HEAD(nvmap_bg_wait);
 
 #ifdef NVMAP_CONFIG_PAGE_POOL_DEBUG
@@ -55,6 +76,25 @@ static inline void __pp_dbg_var_add(u64 *dbg_var, u32 nr)
 static int __nvmap_page_pool_fill_lots_locked(struct nvmap_page_pool *pool,
 				       struct page **pages, u32 nr);
 
+/*
+ * Take the global pool lock, accounting for the times another allocator
+ * already held it.
+ */
+static inline void nvmap_pp_lock(struct nvmap_page_pool *pool)
+{
+	if (rt_mutex_trylock(&pool->lock))
+		return;
+
+	atomic64_inc(&pool->lock_contended);
+	rt_mutex_lock(&pool->lock);
+}
+
+/* Pages accounted against pool->max: the zeroed lists plus the magazines. */
+static inline u32 nvmap_pp_held_pages(struct nvmap_page_pool *pool)
+{
+	return pool->count + atomic_read(&pool->mag_count);
+}
+
 static inline struct page *get_zero_list_page(struct nvmap_page_pool *pool, bool use_numa,
 					int numa_id)
 {
@@ -144,8 +184,13 @@ static inline bool nvmap_bg_should_run(struct nvmap_page_pool *pool)
 	return !list_empty(&pool->zero_list);
 }
 
+/*
+ * clear_highpage() ends up in the arch clear_page(), which on arm64 zeroes
+ * whole blocks with DC ZVA without pulling the lines into the cache first.
+ */
 static void nvmap_pp_zero_pages(struct page **pages, int nr)
 {
+	ktime_t lat_start = nvmap_lat_start();
 	int i;
 
 	for (i = 0; i < nr; i++) {
@@ -153,54 +198,75 @@ static void nvmap_pp_zero_pages(struct page **pages, int nr)
 		nvmap_clean_cache_page(pages[i]);
 	}
 
+	nvmap_lat_record(NL_PP_ZERO, (size_t)nr << PAGE_SHIFT, lat_start);
 	trace_nvmap_pp_zero_pages(nr);
 }
 
-static void nvmap_pp_do_background_zero_pages(struct nvmap_page_pool *pool)
+/*
+ * Take a dirty page for the worker, preferring its own node so that the
+ * zeroing stores stay local. Pages of any node are taken once the local ones
+ * run out, since not every node is guaranteed a worker.
+ */
+static struct page *get_zero_list_page_worker(struct nvmap_page_pool *pool,
+				struct nvmap_pp_zero_worker *worker)
+{
+	struct page *page = NULL;
+
+	if (num_online_nodes() > 1)
+		page = get_zero_list_page(pool, true, worker->nid);
+	if (!page)
+		page = get_zero_list_page(pool, false, 0);
+
+	return page;
+}
+
+static void nvmap_pp_do_background_zero_pages(struct nvmap_page_pool *pool,
+				struct nvmap_pp_zero_worker *worker)
 {
 	int i;
 	struct page *page;
 	int ret;
-	/*
-	 * Statically declared array of pages to be zeroed in a batch,
-	 * local to this thread but too big for the stack.
-	 */
-	static struct page *pending_zero_pages[PENDING_PAGES_SIZE];
 
-	rt_mutex_lock(&pool->lock);
+	nvmap_pp_lock(pool);
 	for (i = 0; i < PENDING_PAGES_SIZE; i++) {
-		page = get_zero_list_page(pool, false, 0);
+		page = get_zero_list_page_worker(pool, worker);
 		if (page == NULL)
 			break;
-		pending_zero_pages[i] = page;
+		worker->pending[i] = page;
 		pool->under_zero++;
 	}
 	rt_mutex_unlock(&pool->lock);
 
-	nvmap_pp_zero_pages(pending_zero_pages, i);
+	if (!i)
+		return;
 
-	rt_mutex_lock(&pool->lock);
-	ret = __nvmap_page_pool_fill_lots_locked(pool, pending_zero_pages, i);
+	nvmap_pp_zero_pages(worker->pending, i);
+	nvmap_stats_inc(NS_PP_BG_ZERO, (size_t)i << PAGE_SHIFT);
+
+	nvmap_pp_lock(pool);
+	ret = __nvmap_page_pool_fill_lots_locked(pool, worker->pending, i);
 	pool->under_zero -= i;
 	rt_mutex_unlock(&pool->lock);
 
 	trace_nvmap_pp_do_background_zero_pages(ret, i);
 
 	for (; ret < i; ret++)
-		__free_page(pending_zero_pages[ret]);
+		__free_page(worker->pending[ret]);
 }
 
 /*
- * This thread fills the page pools with zeroed pages. We avoid releasing the
+ * These threads fill the page pools with zeroed pages. We avoid releasing the
  * pages directly back into the page pools since we would then have to zero
  * them ourselves. Instead it is easier to just reallocate zeroed pages. This
  * happens in the background so that the overhead of allocating zeroed pages is
  * not directly seen by userspace. Of course if the page pools are empty user
- * space will suffer.
+ * space will suffer, so under heavy churn several threads drain the zero list
+ * in parallel, each one a batch at a time.
  */
 static int nvmap_background_zero_thread(void *arg)
 {
 	struct nvmap_page_pool *pool = &nvmap_dev->pool;
+	struct nvmap_pp_zero_worker *worker = arg;
 #if LINUX_VERSION_CODE < KERNEL_VERSION(5, 9, 0)
 	struct sched_param param = { .sched_priority = 0 };
 #endif
@@ -210,13 +276,14 @@ static int nvmap_background_zero_thread(void *arg)
 	set_freezable();
 #if LINUX_VERSION_CODE < KERNEL_VERSION(5, 9, 0)
 	sched_setscheduler(current, SCHED_NORMAL, &param);
+	set_user_nice(current, zero_thread_nice);
 #else
-	sched_set_normal(current, MAX_NICE);
+	sched_set_normal(current, zero_thread_nice);
 #endif
 
 	while (!kthread_should_stop()) {
 		while (nvmap_bg_should_run(pool))
-			nvmap_pp_do_background_zero_pages(pool);
+			nvmap_pp_do_background_zero_pages(pool, worker);
 
 		wait_event_freezable(nvmap_bg_wait,
 				nvmap_bg_should_run(pool) ||
@@ -226,6 +293,73 @@ static int nvmap_background_zero_thread(void *arg)
 	return 0;
 }
 
+static void nvmap_pp_stop_zero_workers(void)
+{
+	struct nvmap_pp_zero_worker *worker;
+	u32 i;
+
+	for (i = 0; i < nr_bg_zero_workers; i++) {
+		worker = &bg_zero_workers[i];
+		kthread_stop(worker->task);
+		kfree(worker->pending);
+		worker->task = NULL;
+		worker->pending = NULL;
+	}
+	nr_bg_zero_workers = 0;
+}
+
+/*
+ * Start the zeroing threads, spreading them round robin over the memory
+ * nodes. Only failing to start the first one is fatal.
+ */
+static int nvmap_pp_start_zero_workers(void)
+{
+	struct nvmap_pp_zero_worker *worker;
+	u32 nr = zero_threads;
+	int nid = first_memory_node;
+	u32 i;
+
+	if (!nr)
+		nr = DIV_ROUND_UP(num_online_cpus(), 4);
+	nr = clamp_t(u32, nr, 1, NVMAP_PP_MAX_ZERO_THREADS);
+	zero_thread_nice = clamp(zero_thread_nice, MIN_NICE, MAX_NICE);
+
+	for (i = 0; i < nr; i++) {
+		worker = &bg_zero_workers[i];
+		worker->nid = nid;
+		worker->pending = kcalloc(PENDING_PAGES_SIZE,
+					  sizeof(*worker->pending), GFP_KERNEL);
+		if (!worker->pending)
+			break;
+
+		worker->task = kthread_create_on_node(
+				nvmap_background_zero_thread, worker, nid,
+				"nvmap-bz/%u", i);
+		if (IS_ERR(worker->task)) {
+			kfree(worker->pending);
+			worker->pending = NULL;
+			worker->task = NULL;
+			break;
+		}
+		if (num_online_nodes() > 1 &&
+		    !cpumask_empty(cpumask_of_node(nid)))
+			set_cpus_allowed_ptr(worker->task,
+					     cpumask_of_node(nid));
+		wake_up_process(worker->task);
+		nr_bg_zero_workers++;
+
+		nid = next_memory_node(nid);
+		if (nid >= MAX_NUMNODES)
+			nid = first_memory_node;
+	}
+
+	if (!nr_bg_zero_workers)
+		return -ENOMEM;
+
+	pr_info("%u PP zeroing threads\n", nr_bg_zero_workers);
+	return 0;
+}
+
 #ifdef NVMAP_CONFIG_PAGE_POOL_DEBUG
 static void nvmap_pgcount(struct page *page, bool incr)
 {
@@ -233,12 +367,45 @@ static void nvmap_pgcount(struct page *page, bool incr)
 }
 #endif /* NVMAP_CONFIG_PAGE_POOL_DEBUG */
 
+/*
+ * Release up to nr_pages held in the magazines back to the system.
+ *
+ * You must lock the page pool before using this.
+ */
+static ulong nvmap_pp_mag_drain_locked(struct nvmap_page_pool *pool,
+				       ulong nr_pages)
+{
+	struct nvmap_pp_magazine *mag;
+	ulong freed = 0;
+	int cpu;
+
+	if (!pool->mags)
+		return 0;
+
+	for_each_possible_cpu(cpu) {
+		mag = per_cpu_ptr(pool->mags, cpu);
+		spin_lock(&mag->lock);
+		while (mag->count && freed < nr_pages) {
+			__free_page(mag->pages[--mag->count]);
+			freed++;
+		}
+		spin_unlock(&mag->lock);
+		if (freed == nr_pages)
+			break;
+	}
+
+	atomic_sub(freed, &pool->mag_count);
+
+	return freed;
+}
+
 /*
  * Free the passed number of pages from the page pool. This happens regardless
  * of whether the page pools are enabled. This lets one disable the page pools
  * and then free all the memory therein.
  *
- * FIXME: Pages in pending_zero_pages[] can still be unreleased.
+ * FIXME: Pages in the zeroing workers' pending batches can still be
+ * unreleased.
  */
 static ulong nvmap_page_pool_free_pages_locked(struct nvmap_page_pool *pool,
 						      ulong nr_pages)
@@ -298,10 +465,106 @@ static ulong nvmap_page_pool_free_pages_locked(struct nvmap_page_pool *pool,
 #endif /* CONFIG_ARM64_4K_PAGES */
 	}
 
+	if (nr_pages)
+		nr_pages -= nvmap_pp_mag_drain_locked(pool, nr_pages);
+
 	pr_debug("remaining pages to release=%ld\n", nr_pages);
 	return nr_pages;
 }
 
+/*
+ * Hand out up to nr pages from this CPU's magazine. Magazine pages are always
+ * zeroed and come from whatever node the refilling CPU was allocating on, so
+ * callers asking for a specific node bypass the magazines.
+ */
+static u32 nvmap_pp_mag_alloc(struct nvmap_page_pool *pool,
+			      struct page **pages, u32 nr)
+{
+	struct nvmap_pp_magazine *mag;
+	u32 take;
+
+	if (!pool->mags)
+		return 0;
+
+	mag = raw_cpu_ptr(pool->mags);
+	spin_lock(&mag->lock);
+	take = min(nr, mag->count);
+	mag->count -= take;
+	memcpy(pages, &mag->pages[mag->count], take * sizeof(*pages));
+	mag->hits += take;
+	spin_unlock(&mag->lock);
+
+	if (take)
+		atomic_sub(take, &pool->mag_count);
+
+#ifdef NVMAP_CONFIG_PAGE_POOL_DEBUG
+	for (nr = 0; nr < take; nr++) {
+		nvmap_pgcount(pages[nr], false);
+		BUG_ON(page_count(pages[nr]) != 1);
+	}
+#endif /* NVMAP_CONFIG_PAGE_POOL_DEBUG */
+
+	return take;
+}
+
+/*
+ * Pull up to NVMAP_PP_MAG_BATCH zeroed pages out of the global lists so they
+ * can be stashed in a magazine once pool->lock is dropped.
+ *
+ * You must lock the page pool before using this.
+ */
+static u32 nvmap_pp_mag_grab_locked(struct nvmap_page_pool *pool,
+				    struct page **batch)
+{
+	struct page *page;
+	u32 nr = 0;
+
+	while (nr < NVMAP_PP_MAG_BATCH) {
+		page = get_page_list_page(pool, false, 0);
+		if (!page)
+			break;
+		batch[nr++] = page;
+	}
+
+	atomic_add(nr, &pool->mag_count);
+
+	return nr;
+}
+
+/*
+ * Stash a batch grabbed by nvmap_pp_mag_grab_locked() in this CPU's magazine.
+ * Whatever doesn't fit (another task may have refilled it meanwhile) goes
+ * back onto the global page list.
+ */
+static void nvmap_pp_mag_refill(struct nvmap_page_pool *pool,
+				struct page **batch, u32 nr)
+{
+	struct nvmap_pp_magazine *mag;
+	u32 put;
+
+	mag = raw_cpu_ptr(pool->mags);
+	spin_lock(&mag->lock);
+	put = min_t(u32, nr, NVMAP_PP_MAG_SIZE - mag->count);
+	memcpy(&mag->pages[mag->count], batch, put * sizeof(*batch));
+	mag->count += put;
+	if (put) {
+		mag->refills++;
+		mag->refill_pages += put;
+	}
+	spin_unlock(&mag->lock);
+
+	if (put == nr)
+		return;
+
+	nvmap_pp_lock(pool);
+	atomic_sub(nr - put, &pool->mag_count);
+	for (; put < nr; put++) {
+		list_add(&batch[put]->lru, &pool->page_list);
+		pool->count++;
+	}
+	rt_mutex_unlock(&pool->lock);
+}
+
 /*
  * Alloc a bunch of pages from the page pool. This will alloc as many as it can
  * and return the number of pages allocated. Pages are placed into the passed
@@ -314,11 +577,27 @@ int nvmap_page_pool_alloc_lots(struct nvmap_page_pool *pool,
 	u32 ind = 0;
 	u32 non_zero_idx;
 	u32 non_zero_cnt = 0;
+	struct page *batch[NVMAP_PP_MAG_BATCH];
+	u32 batch_nr = 0;
+	bool use_mag;
+	ktime_t lat_start;
 
 	if (!enable_pp || !nr)
 		return 0;
 
-	rt_mutex_lock(&pool->lock);
+	lat_start = nvmap_lat_start();
+
+	use_mag = enable_pp_mag && pool->mags &&
+		  (!use_numa || numa_id == NUMA_NO_NODE ||
+		   numa_id == numa_mem_id());
+
+	if (use_mag) {
+		ind = nvmap_pp_mag_alloc(pool, pages, nr);
+		if (ind == nr)
+			goto out;
+	}
+
+	nvmap_pp_lock(pool);
 
 	while (ind < nr) {
 		struct page *page = NULL;
@@ -342,16 +621,31 @@ int nvmap_page_pool_alloc_lots(struct nvmap_page_pool *pool,
 #endif /* NVMAP_CONFIG_PAGE_POOL_DEBUG */
 	}
 
+	/*
+	 * Small requests are the ones that fight over pool->lock, so top up
+	 * the local magazine while we hold it anyway.
+	 */
+	if (use_mag && ind == nr && nr < NVMAP_PP_MAG_BATCH)
+		batch_nr = nvmap_pp_mag_grab_locked(pool, batch);
+
 	rt_mutex_unlock(&pool->lock);
 
+	if (batch_nr)
+		nvmap_pp_mag_refill(pool, batch, batch_nr);
+
 	/* Zero non-zeroed pages, if any */
-	if (non_zero_cnt)
+	if (non_zero_cnt) {
 		nvmap_pp_zero_pages(&pages[non_zero_idx], non_zero_cnt);
+		nvmap_stats_inc(NS_PP_INLINE_ZERO,
+				(size_t)non_zero_cnt << PAGE_SHIFT);
+	}
 
+out:
 	pp_alloc_add(pool, ind);
 	pp_hit_add(pool, ind);
 	pp_miss_add(pool, nr - ind);
 
+	nvmap_lat_record(NL_PP_ALLOC, (size_t)nr << PAGE_SHIFT, lat_start);
 	trace_nvmap_pp_alloc_lots(ind, nr);
 
 	return ind;
@@ -369,7 +663,7 @@ int nvmap_page_pool_alloc_lots_bp(struct nvmap_page_pool *pool,
 	    nr_pages < pool->pages_per_big_pg)
 		return 0;
 
-	rt_mutex_lock(&pool->lock);
+	nvmap_pp_lock(pool);
 
 	while (nr_pages - ind >= pool->pages_per_big_pg) {
 		int i;
@@ -430,8 +724,8 @@ static int __nvmap_page_pool_fill_lots_locked(struct nvmap_page_pool *pool,
 	if (!enable_pp)
 		return 0;
 
-	BUG_ON(pool->count > pool->max);
-	real_nr = min_t(u32, pool->max - pool->count, nr);
+	BUG_ON(nvmap_pp_held_pages(pool) > pool->max);
+	real_nr = min_t(u32, pool->max - nvmap_pp_held_pages(pool), nr);
 	pages_to_fill = real_nr;
 	if (real_nr == 0)
 		return 0;
@@ -458,7 +752,7 @@ static int __nvmap_page_pool_fill_lots_locked(struct nvmap_page_pool *pool,
 	}
 
 	pool->count += ind;
-	BUG_ON(pool->count > pool->max);
+	BUG_ON(nvmap_pp_held_pages(pool) > pool->max);
 	pp_fill_add(pool, ind);
 
 	return ind;
@@ -470,12 +764,14 @@ u32 nvmap_page_pool_fill_lots(struct nvmap_page_pool *pool,
 	u32 ret = 0;
 	u32 i;
 	u32 save_to_zero;
+	ktime_t lat_start = nvmap_lat_start();
 
-	rt_mutex_lock(&pool->lock);
+	nvmap_pp_lock(pool);
 
 	save_to_zero = pool->to_zero;
 
-	ret = min(nr, pool->max - pool->count - pool->to_zero - pool->under_zero);
+	ret = min(nr, pool->max - nvmap_pp_held_pages(pool) - pool->to_zero -
+		  pool->under_zero);
 
 	for (i = 0; i < ret; i++) {
 		/* If page has additonal referecnces, Don't add it into
@@ -500,9 +796,28 @@ u32 nvmap_page_pool_fill_lots(struct nvmap_page_pool *pool,
 
 	rt_mutex_unlock(&pool->lock);
 
+	nvmap_lat_record(NL_PP_FILL, (size_t)nr << PAGE_SHIFT, lat_start);
 	return ret;
 }
 
+/* Zeroed pages ready to be handed out, including the magazines. */
+u64 nvmap_page_pool_get_zeroed_pages(void)
+{
+	if (!nvmap_dev)
+		return 0;
+
+	return nvmap_pp_held_pages(&nvmap_dev->pool);
+}
+
+/* Freed pages still waiting for, or undergoing, background zeroing. */
+u64 nvmap_page_pool_get_dirty_pages(void)
+{
+	if (!nvmap_dev)
+		return 0;
+
+	return nvmap_dev->pool.to_zero + nvmap_dev->pool.under_zero;
+}
+
 ulong nvmap_page_pool_get_unused_pages(void)
 {
 	unsigned long total = 0;
@@ -510,7 +825,7 @@ ulong nvmap_page_pool_get_unused_pages(void)
 	if (!nvmap_dev)
 		return 0;
 
-	total = nvmap_dev->pool.count + nvmap_dev->pool.to_zero;
+	total = nvmap_pp_held_pages(&nvmap_dev->pool) + nvmap_dev->pool.to_zero;
 
 	return total;
 }
@@ -525,10 +840,12 @@ int nvmap_page_pool_clear(void)
 
 	rt_mutex_lock(&pool->lock);
 
-	(void)nvmap_page_pool_free_pages_locked(pool, pool->count + pool->to_zero);
+	(void)nvmap_page_pool_free_pages_locked(pool,
+			nvmap_pp_held_pages(pool) + pool->to_zero);
 
 	/* For some reason, if an error occured... */
-	if (!list_empty(&pool->page_list) || !list_empty(&pool->zero_list)) {
+	if (!list_empty(&pool->page_list) || !list_empty(&pool->zero_list) ||
+	    atomic_read(&pool->mag_count)) {
 		rt_mutex_unlock(&pool->lock);
 		return -ENOMEM;
 	}
@@ -688,6 +1005,50 @@ static struct kernel_param_ops pool_size_ops = {
 
 module_param_cb(pool_size, &pool_size_ops, &pool_size, 0644);
 
+static int nvmap_pp_mag_stats_show(struct seq_file *s, void *unused)
+{
+	struct nvmap_page_pool *pool = s->private;
+	struct nvmap_pp_magazine *mag;
+	u64 hits = 0, refills = 0, refill_pages = 0;
+	int cpu;
+
+	seq_printf(s, "%-6s %8s %16s %16s %16s\n",
+		   "cpu", "pages", "hits", "refills", "refill_pages");
+
+	if (pool->mags) {
+		for_each_possible_cpu(cpu) {
+			mag = per_cpu_ptr(pool->mags, cpu);
+			spin_lock(&mag->lock);
+			seq_printf(s, "%-6d %8u %16llu %16llu %16llu\n", cpu,
+				   mag->count, mag->hits, mag->refills,
+				   mag->refill_pages);
+			hits += mag->hits;
+			refills += mag->refills;
+			refill_pages += mag->refill_pages;
+			spin_unlock(&mag->lock);
+		}
+	}
+
+	seq_printf(s, "%-6s %8d %16llu %16llu %16llu\n", "total",
+		   atomic_read(&pool->mag_count), hits, refills, refill_pages);
+	seq_printf(s, "pool lock contended: %lld\n",
+		   (long long)atomic64_read(&pool->lock_contended));
+
+	return 0;
+}
+
+static int nvmap_pp_mag_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvmap_pp_mag_stats_show, inode->i_private);
+}
+
+static const struct file_operations nvmap_pp_mag_stats_fops = {
+	.open = nvmap_pp_mag_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 int nvmap_page_pool_debugfs_init(struct dentry *nvmap_root)
 {
 	struct dentry *pp_root;
@@ -715,10 +1076,19 @@ int nvmap_page_pool_debugfs_init(struct dentry *nvmap_root)
 	debugfs_create_u64("total_big_page_allocs",
 			   S_IRUGO, pp_root,
 			   &nvmap_big_page_allocs);
+	debugfs_create_u64("total_huge_page_allocs",
+			   S_IRUGO, pp_root,
+			   &nvmap_huge_page_allocs);
 #endif /* CONFIG_ARM64_4K_PAGES */
 	debugfs_create_u64("total_page_allocs",
 			   S_IRUGO, pp_root,
 			   &nvmap_total_page_allocs);
+	debugfs_create_atomic_t("page_pool_magazine_pages",
+			   S_IRUGO, pp_root,
+			   &nvmap_dev->pool.mag_count);
+	debugfs_create_file("page_pool_magazine_stats",
+			   S_IRUGO, pp_root,
+			   &nvmap_dev->pool, &nvmap_pp_mag_stats_fops);
 
 #ifdef NVMAP_CONFIG_PAGE_POOL_DEBUG
 	debugfs_create_u64("page_pool_allocs",
@@ -742,11 +1112,23 @@ int nvmap_page_pool_init(struct nvmap_device *dev)
 {
 	struct sysinfo info;
 	struct nvmap_page_pool *pool = &dev->pool;
+	int cpu;
 
 	memset(pool, 0x0, sizeof(*pool));
 	rt_mutex_init(&pool->lock);
 	INIT_LIST_HEAD(&pool->page_list);
 	INIT_LIST_HEAD(&pool->zero_list);
+	atomic_set(&pool->mag_count, 0);
+	atomic64_set(&pool->lock_contended, 0);
+
+	/* Magazines are an optimisation; carry on with the global pool alone */
+	pool->mags = alloc_percpu(struct nvmap_pp_magazine);
+	if (pool->mags) {
+		for_each_possible_cpu(cpu)
+			spin_lock_init(&per_cpu_ptr(pool->mags, cpu)->lock);
+	} else {
+		pr_warn("per-CPU page pool magazines unavailable\n");
+	}
 #ifdef CONFIG_ARM64_4K_PAGES
 	INIT_LIST_HEAD(&pool->page_list_bp);
 
@@ -771,9 +1153,7 @@ int nvmap_page_pool_init(struct nvmap_device *dev)
 	pr_info("nvmap page pool size: %u pages (%u MB)\n", pool->max,
 		(pool->max * info.mem_unit) >> 20);
 
-	background_allocator = kthread_run(nvmap_background_zero_thread,
-					    NULL, "nvmap-bz");
-	if (IS_ERR(background_allocator))
+	if (nvmap_pp_start_zero_workers())
 		goto fail;
 #if defined(NV_SHRINKER_ALLOC_PRESENT) /* Linux 6.7 */
 	nvmap_page_pool_shrinker = shrinker_alloc(0, "nvmap_pp_shrinker");
@@ -809,18 +1189,25 @@ int nvmap_page_pool_fini(struct nvmap_device *dev)
 	 * properly initialized, then shrinker is also not
 	 * registered
 	 */
-	if (!IS_ERR_OR_NULL(background_allocator)) {
+	if (nr_bg_zero_workers) {
 #if defined(NV_SHRINKER_ALLOC_PRESENT) /* Linux 6.7 */
 		shrinker_free(nvmap_page_pool_shrinker);
 		nvmap_page_pool_shrinker = NULL;
 #else
 		unregister_shrinker(&nvmap_page_pool_shrinker);
 #endif
-		kthread_stop(background_allocator);
-		background_allocator = NULL;
+		nvmap_pp_stop_zero_workers();
 	}
 
 	WARN_ON(!list_empty(&pool->page_list));
 
+	if (pool->mags) {
+		rt_mutex_lock(&pool->lock);
+		(void)nvmap_pp_mag_drain_locked(pool, ULONG_MAX);
+		rt_mutex_unlock(&pool->lock);
+		free_percpu(pool->mags);
+		pool->mags = NULL;
+	}
+
 	return 0;
 }
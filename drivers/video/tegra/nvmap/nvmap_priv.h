@@ -15,6 +15,7 @@
 #include <linux/mutex.h>
 #include <linux/rtmutex.h>
 #include <linux/rbtree.h>
+#include <linux/rhashtable.h>
 #include <linux/sched.h>
 #include <linux/wait.h>
 #include <linux/atomic.h>
@@ -145,12 +146,14 @@ void _nvmap_handle_free(struct nvmap_handle *h);
 /* holds max number of handles allocted per process at any time */
 extern u32 nvmap_max_handle_count;
 extern u64 nvmap_big_page_allocs;
+extern u64 nvmap_huge_page_allocs;
 extern u64 nvmap_total_page_allocs;
 
 extern bool nvmap_convert_iovmm_to_carveout;
 extern bool nvmap_convert_carveout_to_iovmm;
 
 extern struct vm_operations_struct nvmap_vma_ops;
+void nvmap_vma_prefault(struct vm_area_struct *vma);
 
 #ifdef CONFIG_ARM64
 #define PG_PROT_KERNEL PAGE_KERNEL
@@ -224,6 +227,7 @@ struct nvmap_handle_dmabuf_priv {
 
 struct nvmap_handle {
 	struct rb_node node;	/* entry on global handle tree */
+	struct rhash_head hash_node;	/* entry in nvmap_dev->handle_hash */
 	atomic_t ref;		/* reference count (i.e., # of duplications) */
 	atomic_t pin;		/* pin count */
 	u32 flags;		/* caching flags */
@@ -271,6 +275,7 @@ struct nvmap_handle {
 	wait_queue_head_t waitq;
 	int numa_id;
 	u64 serial_id;
+	struct nvmap_tag_usage *tag_usage;	/* tag the handle is charged to */
 };
 
 struct nvmap_handle_info {
@@ -286,6 +291,29 @@ struct nvmap_tag_entry {
 	u32 tag;
 };
 
+/*
+ * Bytes allocated with a tag, maintained at handle alloc/free and at the
+ * first pin/last unpin of a handle. Entries live until nvmap is removed so
+ * that they can be read without locking.
+ */
+struct nvmap_tag_usage {
+	atomic64_t iovmm;
+	atomic64_t carveout;
+	atomic64_t pinned;
+};
+
+/*
+ * Bytes of the handles a client holds a reference to, shared handles are
+ * accounted in full to each client. total is charged before the allocation
+ * so that it can be checked against limit (0: no limit).
+ */
+struct nvmap_usage {
+	atomic64_t total;
+	atomic64_t iovmm;
+	atomic64_t carveout;
+	u64 limit;
+};
+
 /* handle_ref objects are client-local references to an nvmap_handle;
  * they are distinct objects so that handles can be unpinned and
  * unreferenced the correct number of times when a client abnormally
@@ -293,10 +321,22 @@ struct nvmap_tag_entry {
 struct nvmap_handle_ref {
 	struct nvmap_handle *handle;
 	struct rb_node	node;
+	struct rhash_head hash_node;	/* entry in client->ref_hash */
+	unsigned long	key;	/* handle pointer | is_ro */
 	atomic_t	dupes;	/* number of times to free on file close */
 	bool is_ro;
+	bool accounted;	/* handle is charged to the client usage */
 };
 
+#ifdef CONFIG_ARM64_4K_PAGES
+/*
+ * Size of the physically contiguous chunks IOVMM handles are built from when
+ * the buddy allocator can provide them without reclaim. 2M matches the SMMU
+ * block size for a 4K granule, so such chunks map with a single PMD entry.
+ */
+#define NVMAP_HUGE_PAGE_SIZE             (0x200000)
+#endif /* CONFIG_ARM64_4K_PAGES */
+
 #if defined(NVMAP_CONFIG_PAGE_POOLS)
 /*
  * This is the default ratio defining pool size. It can be thought of as pool
@@ -309,8 +349,29 @@ struct nvmap_handle_ref {
 #ifdef CONFIG_ARM64_4K_PAGES
 #define NVMAP_PP_BIG_PAGE_SIZE           (0x10000)
 #endif /* CONFIG_ARM64_4K_PAGES */
+
+/*
+ * Per-CPU magazine of zeroed pages sitting in front of the global pool. Small
+ * allocations are served from the local magazine without touching pool->lock,
+ * and the magazine is refilled in batches of NVMAP_PP_MAG_BATCH pages.
+ */
+#define NVMAP_PP_MAG_SIZE                (64)
+#define NVMAP_PP_MAG_BATCH               (32)
+
+struct nvmap_pp_magazine {
+	spinlock_t lock;
+	u32 count;
+	struct page *pages[NVMAP_PP_MAG_SIZE];
+	u64 hits;          /* Pages handed out from this magazine */
+	u64 refills;       /* Number of bulk refills from the global pool */
+	u64 refill_pages;  /* Pages moved in by those refills */
+};
+
 struct nvmap_page_pool {
 	struct rt_mutex lock;
+	struct nvmap_pp_magazine __percpu *mags;
+	atomic_t mag_count;        /* Pages held in all the magazines */
+	atomic64_t lock_contended; /* pool->lock acquisitions that had to wait */
 	u32 count;      /* Number of pages in the page & dirty list. */
 	u32 max;        /* Max no. of pages in all lists. */
 	u32 to_zero;    /* Number of pages on the zero list */
@@ -347,6 +408,8 @@ u32 nvmap_page_pool_fill_lots(struct nvmap_page_pool *pool,
 				       struct page **pages, u32 nr);
 int nvmap_page_pool_clear(void);
 int nvmap_page_pool_debugfs_init(struct dentry *nvmap_root);
+u64 nvmap_page_pool_get_zeroed_pages(void);
+u64 nvmap_page_pool_get_dirty_pages(void);
 #endif
 
 #define NVMAP_IVM_INVALID_PEER		(-1)
@@ -360,6 +423,7 @@ struct xarray {};
 struct nvmap_client {
 	const char			*name;
 	struct rb_root			handle_refs;
+	struct rhashtable		ref_hash;	/* handle_refs by key */
 	struct mutex			ref_lock;
 	bool				kernel_client;
 	atomic_t			count;
@@ -371,6 +435,8 @@ struct nvmap_client {
 	int				tag_warned;
 	struct xarray			id_array;
 	struct xarray			*ida;
+	struct nvmap_usage		usage;
+	struct dentry			*usage_file;
 };
 
 struct nvmap_vma_priv {
@@ -381,6 +447,7 @@ struct nvmap_vma_priv {
 
 struct nvmap_device {
 	struct rb_root	handles;
+	struct rhashtable handle_hash;	/* handles by address, for validation */
 	spinlock_t	handle_lock;
 	struct miscdevice dev_user;
 	struct nvmap_carveout_node *heaps;
@@ -395,6 +462,7 @@ struct nvmap_device {
 	struct list_head lru_handles;
 	spinlock_t	lru_lock;
 	struct dentry *handles_by_pid;
+	struct dentry *usage_by_pid;
 	struct dentry *debug_root;
 	struct nvmap_platform_data *plat;
 	struct rb_root	tags;
@@ -569,7 +637,14 @@ void nvmap_free_handle_from_fd(struct nvmap_client *c, int fd);
 
 int nvmap_handle_remove(struct nvmap_device *dev, struct nvmap_handle *h);
 
-void nvmap_handle_add(struct nvmap_device *dev, struct nvmap_handle *h);
+int nvmap_handle_add(struct nvmap_device *dev, struct nvmap_handle *h);
+
+int nvmap_handle_hash_init(struct nvmap_device *dev);
+void nvmap_handle_hash_destroy(struct nvmap_device *dev);
+int nvmap_ref_hash_init(struct nvmap_client *client);
+void nvmap_ref_hash_destroy(struct nvmap_client *client);
+void nvmap_ref_hash_remove(struct nvmap_client *client,
+			   struct nvmap_handle_ref *ref);
 
 int is_nvmap_vma(struct vm_area_struct *vma);
 
@@ -619,6 +694,12 @@ int __nvmap_do_cache_maint(struct nvmap_client *client, struct nvmap_handle *h,
 			   unsigned int op, bool clean_only_dirty);
 struct nvmap_client *__nvmap_create_client(struct nvmap_device *dev,
 					   const char *name);
+void nvmap_client_put(struct nvmap_client *client);
+int nvmap_usage_try_charge(struct nvmap_usage *usage, size_t size);
+void nvmap_usage_cancel(struct nvmap_usage *usage, size_t size);
+void nvmap_usage_commit(struct nvmap_usage *usage, struct nvmap_handle *h);
+void nvmap_usage_charge(struct nvmap_usage *usage, struct nvmap_handle *h);
+void nvmap_usage_uncharge(struct nvmap_usage *usage, struct nvmap_handle *h);
 int __nvmap_dmabuf_fd(struct nvmap_client *client,
 		      struct dma_buf *dmabuf, int flags);
 
@@ -802,6 +883,12 @@ int nvmap_define_tag(struct nvmap_device *dev, u32 tag,
 
 int nvmap_remove_tag(struct nvmap_device *dev, u32 tag);
 
+void nvmap_tag_usage_charge(struct nvmap_handle *h);
+void nvmap_tag_usage_uncharge(struct nvmap_handle *h);
+void nvmap_tag_usage_pin(struct nvmap_handle *h, bool pin);
+void nvmap_tag_usage_debugfs_init(struct dentry *nvmap_debug_root);
+void nvmap_tag_usage_fini(void);
+
 /* must hold tag_lock */
 static inline char *__nvmap_tag_name(struct nvmap_device *dev, u32 tag)
 {
@@ -11,7 +11,7 @@
 
 #include <linux/slab.h>
 #include <linux/nvmap.h>
-#include <linux/rbtree.h>
+#include <linux/hashtable.h>
 #include <linux/list.h>
 #include <linux/mman.h>
 #include <linux/wait.h>
@@ -23,8 +23,12 @@
 #include "nvmap_priv.h"
 #include "nvmap_sci_ipc.h"
 
+#define NVMAP_SCI_IPC_HASH_BITS	9
+
 struct nvmap_sci_ipc {
-	struct rb_root entries;
+	/* Entries hashed by sci_ipc_id and by (handle, flags, peer_vuid) */
+	DECLARE_HASHTABLE(ids, NVMAP_SCI_IPC_HASH_BITS);
+	DECLARE_HASHTABLE(handles, NVMAP_SCI_IPC_HASH_BITS);
 	struct mutex mlock;
 	struct list_head free_sid_list;
 };
@@ -34,9 +38,10 @@ struct free_sid_node {
 	u64 sid;
 };
 
-/* An rb-tree root node for holding sci_ipc_id of clients */
+/* A hash table entry for holding sci_ipc_id of clients */
 struct nvmap_sci_ipc_entry {
-	struct rb_node entry;
+	struct hlist_node id_node;
+	struct hlist_node handle_node;
 	struct nvmap_client *client;
 	struct nvmap_handle *handle;
 	u64 sci_ipc_id;
@@ -97,19 +102,22 @@ ret_id:
 	return id;
 }
 
+static inline u64 nvmap_sci_ipc_handle_key(struct nvmap_handle *h,
+		u32 flags, NvSciIpcEndpointVuid peer_vuid)
+{
+	return (u64)(uintptr_t)h ^ peer_vuid ^ ((u64)flags << 32);
+}
+
 static struct nvmap_sci_ipc_entry *nvmap_search_sci_ipc_entry(
-	struct rb_root *root,
 	struct nvmap_handle *h,
 	u32 flags,
 	NvSciIpcEndpointVuid peer_vuid)
 {
-	struct rb_node *node;  /* top of the tree */
 	struct nvmap_sci_ipc_entry *entry;
 
-	for (node = rb_first(root); node; node = rb_next(node)) {
-		entry = rb_entry(node, struct nvmap_sci_ipc_entry, entry);
-
-		if (entry && entry->handle == h
+	hash_for_each_possible(nvmapsciipc->handles, entry, handle_node,
+			nvmap_sci_ipc_handle_key(h, flags, peer_vuid)) {
+		if (entry->handle == h
 			&& entry->flags == flags
 			&& entry->peer_vuid == peer_vuid)
 			return entry;
@@ -117,29 +125,36 @@ static struct nvmap_sci_ipc_entry *nvmap_search_sci_ipc_entry(
 	return NULL;
 }
 
-static void nvmap_insert_sci_ipc_entry(struct rb_root *root,
-		struct nvmap_sci_ipc_entry *new)
+static void nvmap_insert_sci_ipc_entry(struct nvmap_sci_ipc_entry *new)
 {
-	struct nvmap_sci_ipc_entry *entry;
-	struct rb_node *parent = NULL;
-	u64 sid = new->sci_ipc_id;
-	struct rb_node **link;
-
-	link = &root->rb_node;
-	/* Go to the bottom of the tree */
-	while (*link) {
-		parent = *link;
-		entry = rb_entry(parent, struct nvmap_sci_ipc_entry, entry);
-
-		if (entry->sci_ipc_id > sid)
-			link = &parent->rb_left;
-		else
-			link = &parent->rb_right;
+	hash_add(nvmapsciipc->ids, &new->id_node, new->sci_ipc_id);
+	hash_add(nvmapsciipc->handles, &new->handle_node,
+		nvmap_sci_ipc_handle_key(new->handle, new->flags,
+			new->peer_vuid));
+}
+
+/* Drop one reference of an entry, recycling its id with the last one */
+static int nvmap_put_sci_ipc_entry(struct nvmap_sci_ipc_entry *entry)
+{
+	struct free_sid_node *free_node;
+	int ret = 0;
+
+	entry->refcount--;
+	if (entry->refcount != 0U)
+		return 0;
+
+	hash_del(&entry->id_node);
+	hash_del(&entry->handle_node);
+	free_node = kzalloc(sizeof(*free_node), GFP_KERNEL);
+	if (free_node == NULL) {
+		ret = -ENOMEM;
+	} else {
+		free_node->sid = entry->sci_ipc_id;
+		list_add_tail(&free_node->list, &nvmapsciipc->free_sid_list);
 	}
+	kfree(entry);
 
-	/* Put the new node there */
-	rb_link_node(&new->entry, parent, link);
-	rb_insert_color(&new->entry, root);
+	return ret;
 }
 
 int nvmap_create_sci_ipc_id(struct nvmap_client *client,
@@ -156,8 +171,7 @@ int nvmap_create_sci_ipc_id(struct nvmap_client *client,
 
 	mutex_lock(&nvmapsciipc->mlock);
 
-	entry = nvmap_search_sci_ipc_entry(&nvmapsciipc->entries,
-			h, flags, peer_vuid);
+	entry = nvmap_search_sci_ipc_entry(h, flags, peer_vuid);
 	if (entry) {
 		entry->refcount++;
 		*sci_ipc_id = entry->sci_ipc_id;
@@ -183,7 +197,7 @@ int nvmap_create_sci_ipc_id(struct nvmap_client *client,
 			__LINE__, new_entry->sci_ipc_id, new_entry->peer_vuid,
 			new_entry->flags, new_entry->handle);
 
-		nvmap_insert_sci_ipc_entry(&nvmapsciipc->entries, new_entry);
+		nvmap_insert_sci_ipc_entry(new_entry);
 		ret = 0;
 	}
 unlock:
@@ -196,19 +210,36 @@ unlock:
 	return ret;
 }
 
-static struct nvmap_sci_ipc_entry *nvmap_find_entry_for_id(struct rb_root *es,
-					 u64 id)
+static struct nvmap_sci_ipc_entry *nvmap_find_entry_for_id(u64 id)
+{
+	struct nvmap_sci_ipc_entry *e;
+
+	hash_for_each_possible(nvmapsciipc->ids, e, id_node, id) {
+		if (e->sci_ipc_id == id)
+			return e;
+	}
+	return NULL;
+}
+
+/*
+ * Undo nvmap_create_sci_ipc_id(), for exports that could not be handed out
+ * to userspace.
+ */
+void nvmap_release_sci_ipc_id(u64 sci_ipc_id)
 {
-	struct nvmap_sci_ipc_entry *e = NULL;
-	struct rb_node *n;
+	struct nvmap_sci_ipc_entry *entry;
+	struct nvmap_handle *h = NULL;
 
-	for (n = rb_first(es); n; n = rb_next(n)) {
-		e = rb_entry(n, struct nvmap_sci_ipc_entry, entry);
-		if (e && e->sci_ipc_id == id)
-			goto found;
+	mutex_lock(&nvmapsciipc->mlock);
+	entry = nvmap_find_entry_for_id(sci_ipc_id);
+	if (entry != NULL) {
+		h = entry->handle;
+		nvmap_put_sci_ipc_entry(entry);
 	}
-found:
-	return e;
+	mutex_unlock(&nvmapsciipc->mlock);
+
+	if (h != NULL)
+		nvmap_handle_put(h);
 }
 
 int nvmap_get_handle_from_sci_ipc_id(struct nvmap_client *client, u32 flags,
@@ -228,7 +259,7 @@ int nvmap_get_handle_from_sci_ipc_id(struct nvmap_client *client, u32 flags,
 	pr_debug("%d: Sci_Ipc_Id %lld local_vuid: %llu flags: %u\n",
 		__LINE__, sci_ipc_id, localu_vuid, flags);
 
-	entry = nvmap_find_entry_for_id(&nvmapsciipc->entries, sci_ipc_id);
+	entry = nvmap_find_entry_for_id(sci_ipc_id);
 	if ((entry == NULL) || (entry->handle == NULL) ||
 		(entry->peer_vuid != localu_vuid) || (entry->flags != flags)) {
 
@@ -327,21 +358,7 @@ int nvmap_get_handle_from_sci_ipc_id(struct nvmap_client *client, u32 flags,
 			fd_install(fd, dmabuf->file);
 		}
 	}
-	entry->refcount--;
-	if (entry->refcount == 0U) {
-		struct free_sid_node *free_node;
-
-		rb_erase(&entry->entry, &nvmapsciipc->entries);
-		free_node = kzalloc(sizeof(*free_node), GFP_KERNEL);
-		if (free_node == NULL) {
-			ret = -ENOMEM;
-			kfree(entry);
-			goto unlock;
-		}
-		free_node->sid = entry->sci_ipc_id;
-		list_add_tail(&free_node->list, &nvmapsciipc->free_sid_list);
-		kfree(entry);
-	}
+	ret = nvmap_put_sci_ipc_entry(entry);
 unlock:
 	mutex_unlock(&nvmapsciipc->mlock);
 
@@ -368,7 +385,8 @@ int nvmap_sci_ipc_init(void)
 	nvmapsciipc = kzalloc(sizeof(*nvmapsciipc), GFP_KERNEL);
 	if (!nvmapsciipc)
 		return -ENOMEM;
-	nvmapsciipc->entries = RB_ROOT;
+	hash_init(nvmapsciipc->ids);
+	hash_init(nvmapsciipc->handles);
 	INIT_LIST_HEAD(&nvmapsciipc->free_sid_list);
 	mutex_init(&nvmapsciipc->mlock);
 
@@ -379,12 +397,13 @@ void nvmap_sci_ipc_exit(void)
 {
 	struct nvmap_sci_ipc_entry *e;
 	struct free_sid_node *fnode, *temp;
-	struct rb_node *n;
+	struct hlist_node *n;
+	int bkt;
 
 	mutex_lock(&nvmapsciipc->mlock);
-	while ((n = rb_first(&nvmapsciipc->entries))) {
-		e = rb_entry(n, struct nvmap_sci_ipc_entry, entry);
-		rb_erase(&e->entry, &nvmapsciipc->entries);
+	hash_for_each_safe(nvmapsciipc->ids, bkt, n, e, id_node) {
+		hash_del(&e->id_node);
+		hash_del(&e->handle_node);
 		kfree(e);
 	}
 
@@ -24,4 +24,6 @@ int nvmap_get_handle_from_sci_ipc_id(struct nvmap_client *client,
 				u64 sci_ipc_id,
 				NvSciIpcEndpointVuid localusr_vuid,
 				u32 *h);
+
+void nvmap_release_sci_ipc_id(u64 sci_ipc_id);
 #endif /*  __VIDEO_TEGRA_NVMAP_SCI_IPC_H */
@@ -6,11 +6,47 @@
  */
 
 #include <linux/debugfs.h>
+#include <linux/log2.h>
+#include <linux/percpu.h>
+#include <linux/seq_file.h>
+#include <linux/sizes.h>
 
 #include "nvmap_priv.h"
 
 struct nvmap_stats nvmap_stats;
 
+/*
+ * Latency histograms, per operation and size class, with power of two
+ * buckets from 512ns (bucket 0 holds anything faster) up to ~4s. Updated
+ * per cpu so they can be left enabled, allocated dynamically as they are
+ * too large for the static percpu area of a module.
+ */
+#define NVMAP_LAT_SIZE_CLASSES	5	/* 4K, 64K, 1M, 16M, larger */
+#define NVMAP_LAT_BUCKETS	24
+#define NVMAP_LAT_MIN_SHIFT	9
+
+struct nvmap_lat_hist {
+	u64 count[NL_NUM][NVMAP_LAT_SIZE_CLASSES][NVMAP_LAT_BUCKETS];
+	u64 sum_ns[NL_NUM][NVMAP_LAT_SIZE_CLASSES];
+};
+
+static struct nvmap_lat_hist __percpu *nvmap_lat_hist;
+static bool nvmap_lat_enable = true;
+
+static const char * const nvmap_lat_names[NL_NUM] = {
+	[NL_ALLOC] = "alloc",
+	[NL_PP_ALLOC] = "pp_alloc",
+	[NL_PP_FILL] = "pp_fill",
+	[NL_PP_ZERO] = "pp_zero",
+	[NL_CACHE_MAINT] = "cache_maint",
+	[NL_DMABUF_ATTACH] = "dmabuf_attach",
+	[NL_DMABUF_MAP] = "dmabuf_map",
+};
+
+static const char * const nvmap_lat_size_names[NVMAP_LAT_SIZE_CLASSES] = {
+	"4K", "64K", "1M", "16M", "large",
+};
+
 static int nvmap_stats_reset(void *data, u64 val)
 {
 	int i;
@@ -42,8 +78,160 @@ static int nvmap_stats_set(void *data, u64 val)
 	return 0;
 }
 
+#ifdef NVMAP_CONFIG_PAGE_POOLS
+static int nvmap_stats_pp_zeroed_get(void *data, u64 *val)
+{
+	*val = nvmap_page_pool_get_zeroed_pages();
+	return 0;
+}
+
+static int nvmap_stats_pp_dirty_get(void *data, u64 *val)
+{
+	*val = nvmap_page_pool_get_dirty_pages();
+	return 0;
+}
+#endif /* NVMAP_CONFIG_PAGE_POOLS */
+
+static void nvmap_lat_sum(struct nvmap_lat_hist *sum)
+{
+	int cpu, op, c, b;
+
+	memset(sum, 0, sizeof(*sum));
+	for_each_possible_cpu(cpu) {
+		struct nvmap_lat_hist *hist = per_cpu_ptr(nvmap_lat_hist, cpu);
+
+		for (op = 0; op < NL_NUM; op++) {
+			for (c = 0; c < NVMAP_LAT_SIZE_CLASSES; c++) {
+				sum->sum_ns[op][c] += READ_ONCE(hist->sum_ns[op][c]);
+				for (b = 0; b < NVMAP_LAT_BUCKETS; b++)
+					sum->count[op][c][b] +=
+						READ_ONCE(hist->count[op][c][b]);
+			}
+		}
+	}
+}
+
+/* Upper bound in ns of the bucket holding the given percentile. */
+static u64 nvmap_lat_percentile(u64 *count, u64 total, u32 pct)
+{
+	u64 target = div_u64(total * pct + 99, 100);
+	u64 seen = 0;
+	int b;
+
+	for (b = 0; b < NVMAP_LAT_BUCKETS; b++) {
+		seen += count[b];
+		if (seen >= target)
+			break;
+	}
+	return 1ULL << (NVMAP_LAT_MIN_SHIFT + min(b, NVMAP_LAT_BUCKETS - 1));
+}
+
+static int nvmap_lat_show(struct seq_file *s, void *unused)
+{
+	struct nvmap_lat_hist *sum;
+	int op, c, b;
+
+	sum = vmalloc(sizeof(*sum));
+	if (!sum)
+		return -ENOMEM;
+	nvmap_lat_sum(sum);
+
+	seq_printf(s, "%-14s %-6s %10s %10s %10s %10s %10s\n", "OP", "SIZE",
+		   "COUNT", "AVG_NS", "P50_NS", "P90_NS", "P99_NS");
+	for (op = 0; op < NL_NUM; op++) {
+		for (c = 0; c < NVMAP_LAT_SIZE_CLASSES; c++) {
+			u64 *count = sum->count[op][c];
+			u64 total = 0;
+
+			for (b = 0; b < NVMAP_LAT_BUCKETS; b++)
+				total += count[b];
+			if (!total)
+				continue;
+
+			seq_printf(s, "%-14s %-6s %10llu %10llu %10llu %10llu %10llu\n",
+				   nvmap_lat_names[op], nvmap_lat_size_names[c],
+				   total, div64_u64(sum->sum_ns[op][c], total),
+				   nvmap_lat_percentile(count, total, 50),
+				   nvmap_lat_percentile(count, total, 90),
+				   nvmap_lat_percentile(count, total, 99));
+		}
+	}
+
+	vfree(sum);
+	return 0;
+}
+
+static int nvmap_lat_hist_show(struct seq_file *s, void *unused)
+{
+	struct nvmap_lat_hist *sum;
+	int op, c, b;
+
+	sum = vmalloc(sizeof(*sum));
+	if (!sum)
+		return -ENOMEM;
+	nvmap_lat_sum(sum);
+
+	seq_printf(s, "# bucket b counts latencies below %uns << b\n",
+		   1U << NVMAP_LAT_MIN_SHIFT);
+	for (op = 0; op < NL_NUM; op++) {
+		for (c = 0; c < NVMAP_LAT_SIZE_CLASSES; c++) {
+			seq_printf(s, "%-14s %-6s", nvmap_lat_names[op],
+				   nvmap_lat_size_names[c]);
+			for (b = 0; b < NVMAP_LAT_BUCKETS; b++)
+				seq_printf(s, " %llu", sum->count[op][c][b]);
+			seq_puts(s, "\n");
+		}
+	}
+
+	vfree(sum);
+	return 0;
+}
+
+static int nvmap_lat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvmap_lat_show, inode->i_private);
+}
+
+static const struct file_operations nvmap_lat_fops = {
+	.open = nvmap_lat_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int nvmap_lat_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvmap_lat_hist_show, inode->i_private);
+}
+
+static const struct file_operations nvmap_lat_hist_fops = {
+	.open = nvmap_lat_hist_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int nvmap_lat_reset(void *data, u64 val)
+{
+	int cpu;
+
+	if (val) {
+		for_each_possible_cpu(cpu)
+			memset(per_cpu_ptr(nvmap_lat_hist, cpu), 0,
+			       sizeof(struct nvmap_lat_hist));
+	}
+	return 0;
+}
+
 DEFINE_SIMPLE_ATTRIBUTE(reset_stats_fops, NULL, nvmap_stats_reset, "%llu\n");
+DEFINE_SIMPLE_ATTRIBUTE(lat_reset_fops, NULL, nvmap_lat_reset, "%llu\n");
 DEFINE_SIMPLE_ATTRIBUTE(stats_fops, nvmap_stats_get, nvmap_stats_set, "%llu\n");
+#ifdef NVMAP_CONFIG_PAGE_POOLS
+DEFINE_SIMPLE_ATTRIBUTE(pp_zeroed_fops, nvmap_stats_pp_zeroed_get, NULL,
+			"%llu\n");
+DEFINE_SIMPLE_ATTRIBUTE(pp_dirty_fops, nvmap_stats_pp_dirty_get, NULL,
+			"%llu\n");
+#endif /* NVMAP_CONFIG_PAGE_POOLS */
 
 void nvmap_stats_init(struct dentry *nvmap_debug_root)
 {
@@ -66,17 +254,50 @@ void nvmap_stats_init(struct dentry *nvmap_debug_root)
 		CREATE_DF(ucflush_done, nvmap_stats.stats[NS_UCFLUSH_DONE]);
 		CREATE_DF(kcflush_rq, nvmap_stats.stats[NS_KCFLUSH_RQ]);
 		CREATE_DF(kcflush_done, nvmap_stats.stats[NS_KCFLUSH_DONE]);
+		CREATE_DF(pp_bg_zero, nvmap_stats.stats[NS_PP_BG_ZERO]);
+		CREATE_DF(pp_inline_zero, nvmap_stats.stats[NS_PP_INLINE_ZERO]);
+		CREATE_DF(faults, nvmap_stats.stats[NS_FAULT]);
+		CREATE_DF(fault_around_pages, nvmap_stats.stats[NS_FAULT_AROUND]);
+		CREATE_DF(prefault_pages, nvmap_stats.stats[NS_PREFAULT]);
 		CREATE_DF(total_memory, nvmap_stats.stats[NS_TOTAL]);
+#ifdef NVMAP_CONFIG_PAGE_POOLS
+		/* Pool levels in pages, zeroed vs. waiting to be zeroed */
+		debugfs_create_file("pp_zeroed_pages", S_IRUGO, stats_root,
+				    NULL, &pp_zeroed_fops);
+		debugfs_create_file("pp_dirty_pages", S_IRUGO, stats_root,
+				    NULL, &pp_dirty_fops);
+#endif /* NVMAP_CONFIG_PAGE_POOLS */
 
 		debugfs_create_file("collect", S_IRUGO | S_IWUSR,
 			stats_root, &nvmap_stats.collect, &stats_fops);
 		debugfs_create_file("reset", S_IWUSR,
 			stats_root, NULL, &reset_stats_fops);
+
+
+		nvmap_lat_hist = alloc_percpu(struct nvmap_lat_hist);
+		if (nvmap_lat_hist) {
+			debugfs_create_bool("latency_enable", S_IRUGO | S_IWUSR,
+				stats_root, &nvmap_lat_enable);
+			debugfs_create_file("latency", S_IRUGO,
+				stats_root, NULL, &nvmap_lat_fops);
+			debugfs_create_file("latency_hist", S_IRUGO,
+				stats_root, NULL, &nvmap_lat_hist_fops);
+			debugfs_create_file("latency_reset", S_IWUSR,
+				stats_root, NULL, &lat_reset_fops);
+		}
 	}
 
 #undef CREATE_DF
 }
 
+void nvmap_stats_fini(void)
+{
+	struct nvmap_lat_hist __percpu *hist = nvmap_lat_hist;
+
+	nvmap_lat_hist = NULL;
+	free_percpu(hist);
+}
+
 void nvmap_stats_inc(enum nvmap_stats_t stat, size_t size)
 {
 	if (atomic64_read(&nvmap_stats.collect) || stat == NS_TOTAL)
@@ -94,3 +315,76 @@ u64 nvmap_stats_read(enum nvmap_stats_t stat)
 	return atomic64_read(&nvmap_stats.stats[stat]);
 }
 
+/* Start of an operation timed by nvmap_lat_record(), 0 when disabled. */
+ktime_t nvmap_lat_start(void)
+{
+	return READ_ONCE(nvmap_lat_enable) ? ktime_get() : 0;
+}
+
+void nvmap_lat_record(enum nvmap_lat_t op, size_t size, ktime_t start)
+{
+	struct nvmap_lat_hist *hist;
+	u64 ns;
+	int c, b;
+
+	if (!start || !nvmap_lat_hist)
+		return;
+
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	c = size <= SZ_4K ? 0 : size <= SZ_64K ? 1 : size <= SZ_1M ? 2 :
+	    size <= SZ_16M ? 3 : 4;
+	b = ns >> NVMAP_LAT_MIN_SHIFT ? ilog2(ns) - NVMAP_LAT_MIN_SHIFT + 1 : 0;
+	b = min(b, NVMAP_LAT_BUCKETS - 1);
+
+	hist = get_cpu_ptr(nvmap_lat_hist);
+	hist->count[op][c][b]++;
+	hist->sum_ns[op][c] += ns;
+	put_cpu_ptr(nvmap_lat_hist);
+}
+
+
+static atomic64_t *nvmap_usage_heap(struct nvmap_usage *usage,
+				    struct nvmap_handle *h)
+{
+	return h->heap_type == NVMAP_HEAP_IOVMM ? &usage->iovmm :
+						  &usage->carveout;
+}
+
+/*
+ * Charge size to the usage total ahead of an allocation, failing if that
+ * takes it over the limit. Followed by nvmap_usage_commit() once the handle
+ * is allocated or nvmap_usage_cancel() if the allocation failed.
+ */
+int nvmap_usage_try_charge(struct nvmap_usage *usage, size_t size)
+{
+	u64 limit = READ_ONCE(usage->limit);
+
+	if (atomic64_add_return(size, &usage->total) > limit && limit) {
+		atomic64_sub(size, &usage->total);
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+void nvmap_usage_cancel(struct nvmap_usage *usage, size_t size)
+{
+	atomic64_sub(size, &usage->total);
+}
+
+void nvmap_usage_commit(struct nvmap_usage *usage, struct nvmap_handle *h)
+{
+	atomic64_add(h->size, nvmap_usage_heap(usage, h));
+}
+
+/* Charge an allocated handle, regardless of the limit. */
+void nvmap_usage_charge(struct nvmap_usage *usage, struct nvmap_handle *h)
+{
+	atomic64_add(h->size, &usage->total);
+	nvmap_usage_commit(usage, h);
+}
+
+void nvmap_usage_uncharge(struct nvmap_usage *usage, struct nvmap_handle *h)
+{
+	atomic64_sub(h->size, nvmap_usage_heap(usage, h));
+	atomic64_sub(h->size, &usage->total);
+}
@@ -6,6 +6,8 @@
 #ifndef __VIDEO_TEGRA_NVMAP_STATS_H
 #define __VIDEO_TEGRA_NVMAP_STATS_H
 
+#include <linux/ktime.h>
+
 enum nvmap_stats_t {
 	NS_ALLOC = 0,
 	NS_RELEASE,
@@ -19,6 +21,11 @@ enum nvmap_stats_t {
 	NS_UCFLUSH_DONE,
 	NS_KCFLUSH_RQ,
 	NS_KCFLUSH_DONE,
+	NS_PP_BG_ZERO,
+	NS_PP_INLINE_ZERO,
+	NS_FAULT,
+	NS_FAULT_AROUND,
+	NS_PREFAULT,
 	NS_TOTAL,
 	NS_NUM,
 };
@@ -28,10 +35,26 @@ struct nvmap_stats {
 	atomic64_t collect;
 };
 
+/* Operations with a latency histogram, see nvmap_lat_record() */
+enum nvmap_lat_t {
+	NL_ALLOC = 0,
+	NL_PP_ALLOC,
+	NL_PP_FILL,
+	NL_PP_ZERO,
+	NL_CACHE_MAINT,
+	NL_DMABUF_ATTACH,
+	NL_DMABUF_MAP,
+	NL_NUM,
+};
+
 extern struct nvmap_stats nvmap_stats;
 
 void nvmap_stats_init(struct dentry *nvmap_debug_root);
+void nvmap_stats_fini(void);
 void nvmap_stats_inc(enum nvmap_stats_t, size_t size);
 void nvmap_stats_dec(enum nvmap_stats_t, size_t size);
 u64 nvmap_stats_read(enum nvmap_stats_t);
+ktime_t nvmap_lat_start(void);
+void nvmap_lat_record(enum nvmap_lat_t op, size_t size, ktime_t start);
+void nvmap_bench_init(struct dentry *nvmap_debug_root);
 #endif /* __VIDEO_TEGRA_NVMAP_STATS_H */
@@ -7,7 +7,10 @@
 
 #define pr_fmt(fmt)	"%s: " fmt, __func__
 
+#include <linux/debugfs.h>
 #include <linux/moduleparam.h>
+#include <linux/seq_file.h>
+#include <linux/xarray.h>
 
 #include <trace/events/nvmap.h>
 
@@ -101,3 +104,111 @@ int nvmap_remove_tag(struct nvmap_device *dev, u32 tag)
 
 	return 0;
 }
+
+/* struct nvmap_tag_usage by tag, entries are only freed on removal */
+static DEFINE_XARRAY(nvmap_tag_usage);
+
+static struct nvmap_tag_usage *nvmap_tag_usage_get(u32 tag)
+{
+	struct nvmap_tag_usage *usage, *old;
+
+	usage = xa_load(&nvmap_tag_usage, tag);
+	if (usage)
+		return usage;
+
+	usage = kzalloc(sizeof(*usage), GFP_KERNEL);
+	if (!usage)
+		return NULL;
+
+	old = xa_cmpxchg(&nvmap_tag_usage, tag, NULL, usage, GFP_KERNEL);
+	if (old) {
+		kfree(usage);
+		return xa_is_err(old) ? NULL : old;
+	}
+
+	return usage;
+}
+
+static atomic64_t *nvmap_tag_usage_heap(struct nvmap_handle *h)
+{
+	return h->heap_type == NVMAP_HEAP_IOVMM ? &h->tag_usage->iovmm :
+						  &h->tag_usage->carveout;
+}
+
+/* Called once the handle is allocated. */
+void nvmap_tag_usage_charge(struct nvmap_handle *h)
+{
+	h->tag_usage = nvmap_tag_usage_get(h->userflags >> 16);
+	if (h->tag_usage)
+		atomic64_add(h->size, nvmap_tag_usage_heap(h));
+}
+
+void nvmap_tag_usage_uncharge(struct nvmap_handle *h)
+{
+	if (h->tag_usage)
+		atomic64_sub(h->size, nvmap_tag_usage_heap(h));
+}
+
+/* Called on the first pin and the last unpin of the handle. */
+void nvmap_tag_usage_pin(struct nvmap_handle *h, bool pin)
+{
+	if (!h->tag_usage)
+		return;
+
+	if (pin)
+		atomic64_add(h->size, &h->tag_usage->pinned);
+	else
+		atomic64_sub(h->size, &h->tag_usage->pinned);
+}
+
+static int nvmap_tag_usage_show(struct seq_file *s, void *unused)
+{
+	struct nvmap_tag_usage *usage;
+	unsigned long tag;
+
+	seq_printf(s, "%-8s %-24s %12s %12s %12s %12s\n", "TAG", "NAME",
+		   "TOTAL", "IOVMM", "CARVEOUT", "PINNED");
+
+	/* the tag names need tags_lock, the counters need nothing */
+	mutex_lock(&nvmap_dev->tags_lock);
+	xa_for_each(&nvmap_tag_usage, tag, usage) {
+		u64 iovmm = atomic64_read(&usage->iovmm);
+		u64 carveout = atomic64_read(&usage->carveout);
+
+		seq_printf(s, "%-8lu %-24s %12llu %12llu %12llu %12llu\n",
+			   tag, __nvmap_tag_name(nvmap_dev, tag),
+			   iovmm + carveout, iovmm, carveout,
+			   (u64)atomic64_read(&usage->pinned));
+	}
+	mutex_unlock(&nvmap_dev->tags_lock);
+
+	return 0;
+}
+
+static int nvmap_tag_usage_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nvmap_tag_usage_show, inode->i_private);
+}
+
+static const struct file_operations nvmap_tag_usage_fops = {
+	.open = nvmap_tag_usage_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+void nvmap_tag_usage_debugfs_init(struct dentry *nvmap_debug_root)
+{
+	debugfs_create_file("usage_by_tag", S_IRUGO, nvmap_debug_root, NULL,
+			    &nvmap_tag_usage_fops);
+}
+
+void nvmap_tag_usage_fini(void)
+{
+	struct nvmap_tag_usage *usage;
+	unsigned long tag;
+
+	xa_for_each(&nvmap_tag_usage, tag, usage)
+		kfree(usage);
+	xa_destroy(&nvmap_tag_usage);
+}
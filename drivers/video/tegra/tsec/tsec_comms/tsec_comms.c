@@ -19,6 +19,8 @@
 #define TSEC_QUEUE_OFFSET_MAGIC     (0x01000000)
 #define TSEC_EMEM_SIZE              (0x2000)
 #define TSEC_MAX_MSG_SIZE           (128)
+#define TSEC_CMDQ_SIZE              (0x80)
+#define TSEC_MAX_OUTSTANDING_CMDS   (8)
 
 #define DO_IPC_OVER_GSC_CO  (1)
 
@@ -55,6 +57,71 @@ struct callback_t {
 };
 static struct callback_t s_callbacks[RM_GSP_UNIT_END];
 
+/*
+ * Callbacks of the commands outstanding with each unit, oldest first.
+ * TSEC answers the commands of a unit in the order they were queued,
+ * so several commands can be in flight for the same unit and every
+ * response completes the oldest of them.
+ */
+struct cmd_callbacks_t {
+	struct callback_t cbs[TSEC_MAX_OUTSTANDING_CMDS];
+	u32 rd;
+	u32 count;
+};
+static struct cmd_callbacks_t s_cmd_callbacks[RM_GSP_UNIT_END];
+
+static u32 s_cmdq_start;
+
+/* Must be called with comms mutex held */
+static int push_cmd_cb(u8 unit_id, callback_func_t cb_func, void *cb_ctx)
+{
+	struct cmd_callbacks_t *unit = &s_cmd_callbacks[unit_id];
+	u32 idx;
+
+	if (unit->count >= TSEC_MAX_OUTSTANDING_CMDS)
+		return -TSEC_EINVAL;
+
+	idx = (unit->rd + unit->count) % TSEC_MAX_OUTSTANDING_CMDS;
+	unit->cbs[idx].cb_func = cb_func;
+	unit->cbs[idx].cb_ctx  = cb_ctx;
+	unit->count++;
+
+	return 0;
+}
+
+/* Must be called with comms mutex held */
+static void pop_cmd_cb(u8 unit_id, callback_func_t *cb_func, void **cb_ctx)
+{
+	struct cmd_callbacks_t *unit = &s_cmd_callbacks[unit_id];
+
+	*cb_func = NULL;
+	*cb_ctx  = NULL;
+	if (!unit->count)
+		return;
+
+	*cb_func = unit->cbs[unit->rd].cb_func;
+	*cb_ctx  = unit->cbs[unit->rd].cb_ctx;
+	unit->cbs[unit->rd].cb_func = NULL;
+	unit->cbs[unit->rd].cb_ctx  = NULL;
+	unit->rd = (unit->rd + 1) % TSEC_MAX_OUTSTANDING_CMDS;
+	unit->count--;
+}
+
+/* Must be called with comms mutex held, undoes the last push_cmd_cb */
+static void drop_last_cmd_cb(u8 unit_id)
+{
+	struct cmd_callbacks_t *unit = &s_cmd_callbacks[unit_id];
+	u32 idx;
+
+	if (!unit->count)
+		return;
+
+	unit->count--;
+	idx = (unit->rd + unit->count) % TSEC_MAX_OUTSTANDING_CMDS;
+	unit->cbs[idx].cb_func = NULL;
+	unit->cbs[idx].cb_ctx  = NULL;
+}
+
 static int validate_cmd(struct RM_FLCN_QUEUE_HDR *cmd_hdr)
 {
 	if (cmd_hdr == NULL)
@@ -240,6 +307,12 @@ static void invoke_init_cb(void *unused)
 		cb_func(cb_ctx, (void *)s_init_tsec_msg);
 }
 
+/*
+ * When invoked from the message interrupt the queue is known to be
+ * non empty, or was drained already by the previous interrupt when
+ * TSEC sent several messages back to back, so only poll for a message
+ * when draining without an interrupt.
+ */
 void tsec_comms_drain_msg(bool invoke_cb)
 {
 	int i;
@@ -277,7 +350,7 @@ void tsec_comms_drain_msg(bool invoke_cb)
 	for (i = 0; i < TSEC_QUEUE_POLL_COUNT; i++) {
 		tail = tsec_plat_reg_read(msgq_tail_reg);
 		head = tsec_plat_reg_read(msgq_head_reg);
-		if (tail != head)
+		if (tail != head || invoke_cb)
 			break;
 		tsec_plat_udelay(TSEC_QUEUE_POLL_INTERVAL_US);
 	}
@@ -357,17 +430,12 @@ void tsec_comms_drain_msg(bool invoke_cb)
 					msg_hdr->unitId);
 			}
 
-			/* Invoke the callback and clear it */
-			if (invoke_cb) {
-				tsec_plat_acquire_comms_mutex();
-				cb_func = s_callbacks[msg_hdr->unitId].cb_func;
-				cb_ctx  = s_callbacks[msg_hdr->unitId].cb_ctx;
-				s_callbacks[msg_hdr->unitId].cb_func = NULL;
-				s_callbacks[msg_hdr->unitId].cb_ctx = NULL;
-				tsec_plat_release_comms_mutex();
-				if (cb_func)
-					cb_func(cb_ctx, (void *)tsec_msg);
-			}
+			/* Complete the oldest outstanding cmd of the unit */
+			tsec_plat_acquire_comms_mutex();
+			pop_cmd_cb(msg_hdr->unitId, &cb_func, &cb_ctx);
+			tsec_plat_release_comms_mutex();
+			if (cb_func && invoke_cb)
+				cb_func(cb_ctx, (void *)tsec_msg);
 		} else {
 			plat_print(LVL_DBG,
 				"msg received from unknown unitId 0x%x >= RM_GSP_UNIT_END\n",
@@ -497,124 +565,198 @@ void tsec_comms_free_gscco_mem(void *page_va)
 EXPORT_SYMBOL_COMMS(tsec_comms_free_gscco_mem);
 
 
-int tsec_comms_send_cmd(void *cmd, u32 queue_id,
-	callback_func_t cb_func, void *cb_ctx)
+static int cmdq_get_start(void)
 {
+	u32 cmdq_tail_reg = tsec_cmdq_tail_r(TSEC_CMD_QUEUE_PORT);
 	int i;
-	int placeholder;
-	u32 head;
-	u32 tail;
-	u8  cmd_size;
-	u32 cmd_size_aligned;
-	u32 cmdq_head_reg;
-	u32 cmdq_tail_reg;
-	static u32 sCmdq_size = 0x80;
-	static u32 sCmdq_start;
-	struct RM_FLCN_QUEUE_HDR *cmd_hdr;
-	struct RM_FLCN_QUEUE_HDR hdr;
-
-	if (!s_init_msg_rcvd) {
-		plat_print(LVL_ERR, "TSEC RISCV hasn't booted successfully\n");
-		return -TSEC_ENODEV;
-	}
 
-	if (queue_id != TSEC_CMD_QUEUE_PORT)
-		return -TSEC_EINVAL;
-
-	cmdq_head_reg = tsec_cmdq_head_r(TSEC_CMD_QUEUE_PORT);
-	cmdq_tail_reg = tsec_cmdq_tail_r(TSEC_CMD_QUEUE_PORT);
-
-	for (i = 0; !sCmdq_start && i < TSEC_QUEUE_POLL_COUNT; i++) {
-		sCmdq_start = tsec_plat_reg_read(cmdq_tail_reg);
-		if (!sCmdq_start)
+	for (i = 0; !s_cmdq_start && i < TSEC_QUEUE_POLL_COUNT; i++) {
+		s_cmdq_start = tsec_plat_reg_read(cmdq_tail_reg);
+		if (!s_cmdq_start)
 			tsec_plat_udelay(TSEC_QUEUE_POLL_INTERVAL_US);
 	}
 
-	if (!sCmdq_start) {
-		plat_print(LVL_WARN, "cmdq_start=0x%x\n", sCmdq_start);
+	if (!s_cmdq_start) {
+		plat_print(LVL_WARN, "cmdq_start=0x%x\n", s_cmdq_start);
 		return -TSEC_ENODEV;
 	}
 
-	if (validate_cmd(cmd)) {
-		plat_print(LVL_DBG, "CMD: %s: %d Invalid command\n",
-			__func__, __LINE__);
-		return -TSEC_EINVAL;
-	}
+	return 0;
+}
 
-	cmd_hdr = (struct RM_FLCN_QUEUE_HDR *)cmd;
-	tsec_plat_acquire_comms_mutex();
-	if (s_callbacks[cmd_hdr->unitId].cb_func) {
-		tsec_plat_release_comms_mutex();
-		plat_print(LVL_ERR, "more than 1 outstanding cmd for unit 0x%x\n",
-			cmd_hdr->unitId);
-		return -TSEC_EINVAL;
-	}
-	tsec_plat_release_comms_mutex();
-	cmd_size = cmd_hdr->size;
-	placeholder = ALIGN(cmd_size, 4);
-	if (placeholder < 0) {
-		plat_print(LVL_ERR, "Alignment found to be negative\n");
-		return -TSEC_EINVAL;
-	}
-	cmd_size_aligned = (unsigned int) placeholder;
-	head = tsec_plat_reg_read(cmdq_head_reg);
+/*
+ * Copy one command to the CMDQ at *head without ringing the doorbell,
+ * i.e. without updating the CMDQ head register. The commands copied so
+ * far are published before waiting for space, as TSEC can only free
+ * space by consuming the commands it has been told about; *published
+ * tracks the head last written to the register.
+ */
+static int cmdq_write_cmd(struct RM_FLCN_QUEUE_HDR *cmd_hdr,
+	u32 *head, u32 *published)
+{
+	u32 tail;
+	u32 cmd_size_aligned;
+	u32 cmdq_head_reg;
+	u32 cmdq_tail_reg;
+	struct RM_FLCN_QUEUE_HDR hdr;
+
+	cmdq_head_reg = tsec_cmdq_head_r(TSEC_CMD_QUEUE_PORT);
+	cmdq_tail_reg = tsec_cmdq_tail_r(TSEC_CMD_QUEUE_PORT);
+	cmd_size_aligned = ALIGN(cmd_hdr->size, 4);
 
 check_space:
 	tail = tsec_plat_reg_read(cmdq_tail_reg);
-	if (head < sCmdq_start || tail < sCmdq_start)
-		plat_print(LVL_ERR, "head/tail less than sCmdq_start, h=0x%x,t=0x%x\n",
-			head, tail);
-	if (UINT_MAX - head < cmd_size_aligned) {
-		pr_err("addition of head and offset wraps\n");
-		return -EINVAL;
+	if (*head < s_cmdq_start || tail < s_cmdq_start)
+		plat_print(LVL_ERR, "head/tail less than cmdq_start, h=0x%x,t=0x%x\n",
+			*head, tail);
+	if (UINT_MAX - *head < cmd_size_aligned) {
+		plat_print(LVL_ERR, "addition of head and offset wraps\n");
+		return -TSEC_EINVAL;
 	}
-	if (tail > head) {
-		if ((head + cmd_size_aligned) < tail)
+	if (tail > *head) {
+		if ((*head + cmd_size_aligned) < tail)
 			goto enqueue;
-		tsec_plat_udelay(TSEC_QUEUE_POLL_INTERVAL_US);
-		goto check_space;
+		goto wait_space;
 	} else {
-		if ((head + cmd_size_aligned) < (sCmdq_start + sCmdq_size)) {
+		if ((*head + cmd_size_aligned) < (s_cmdq_start + TSEC_CMDQ_SIZE))
 			goto enqueue;
-		} else {
-			if ((sCmdq_start + cmd_size_aligned) < tail) {
-				goto rewind;
-			} else {
-				tsec_plat_udelay(TSEC_QUEUE_POLL_INTERVAL_US);
-				goto check_space;
-			}
-		}
+		else if ((s_cmdq_start + cmd_size_aligned) < tail)
+			goto rewind;
+		goto wait_space;
+	}
+
+wait_space:
+	if (*published != *head) {
+		tsec_plat_reg_write(cmdq_head_reg, *head);
+		*published = *head;
 	}
+	tsec_plat_udelay(TSEC_QUEUE_POLL_INTERVAL_US);
+	goto check_space;
 
 rewind:
 	hdr.unitId = RM_GSP_UNIT_REWIND;
 	hdr.size = RM_FLCN_QUEUE_HDR_SIZE;
 	hdr.ctrlFlags = 0;
 	hdr.seqNumId = 0;
-	if (ipc_write(head, (u8 *)&hdr, hdr.size))
+	if (ipc_write(*head, (u8 *)&hdr, hdr.size))
 		return -TSEC_EINVAL;
-	head = sCmdq_start;
-	tsec_plat_reg_write(cmdq_head_reg, head);
-	plat_print(LVL_DBG, "CMDQ: rewind h=%x,t=%x\n", head, tail);
+	*head = s_cmdq_start;
+	tsec_plat_reg_write(cmdq_head_reg, *head);
+	*published = *head;
+	plat_print(LVL_DBG, "CMDQ: rewind h=%x,t=%x\n", *head, tail);
 
 enqueue:
+	if (ipc_write(*head, (u8 *)cmd_hdr, cmd_hdr->size))
+		return -TSEC_EINVAL;
+	*head += cmd_size_aligned;
+
+	return 0;
+}
+
+int tsec_comms_send_cmds(struct tsec_comms_cmd *cmds, u32 num_cmds,
+	u32 queue_id)
+{
+	u32 i;
+	u32 j;
+	u32 head;
+	u32 published;
+	u32 cmdq_head_reg;
+	struct RM_FLCN_QUEUE_HDR *cmd_hdr;
+	int err;
+
+	if (!s_init_msg_rcvd) {
+		plat_print(LVL_ERR, "TSEC RISCV hasn't booted successfully\n");
+		return -TSEC_ENODEV;
+	}
+
+	if (queue_id != TSEC_CMD_QUEUE_PORT || !cmds || !num_cmds)
+		return -TSEC_EINVAL;
+
+	err = cmdq_get_start();
+	if (err)
+		return err;
+
+	for (i = 0; i < num_cmds; i++) {
+		cmd_hdr = (struct RM_FLCN_QUEUE_HDR *)cmds[i].cmd;
+		if (validate_cmd(cmd_hdr)) {
+			plat_print(LVL_DBG, "CMD: %s: %d Invalid command %u\n",
+				__func__, __LINE__, i);
+			return -TSEC_EINVAL;
+		}
+		/* Must fit in the CMDQ along with a rewind */
+		if ((ALIGN(cmd_hdr->size, 4) + RM_FLCN_QUEUE_HDR_SIZE) >=
+				TSEC_CMDQ_SIZE) {
+			plat_print(LVL_ERR, "cmd %u size 0x%x too large\n",
+				i, cmd_hdr->size);
+			return -TSEC_EINVAL;
+		}
+	}
+
+	/*
+	 * Register the callbacks before any command is visible to TSEC so
+	 * that no response can arrive ahead of its callback.
+	 */
 	tsec_plat_acquire_comms_mutex();
-	s_callbacks[cmd_hdr->unitId].cb_func = cb_func;
-	s_callbacks[cmd_hdr->unitId].cb_ctx  = cb_ctx;
+	for (i = 0; i < num_cmds; i++) {
+		if (!cmds[i].cb_func)
+			continue;
+		cmd_hdr = (struct RM_FLCN_QUEUE_HDR *)cmds[i].cmd;
+		if (push_cmd_cb(cmd_hdr->unitId, cmds[i].cb_func,
+				cmds[i].cb_ctx)) {
+			plat_print(LVL_ERR, "too many outstanding cmds for unit 0x%x\n",
+				cmd_hdr->unitId);
+			for (j = i; j-- > 0; ) {
+				if (cmds[j].cb_func)
+					drop_last_cmd_cb(((struct RM_FLCN_QUEUE_HDR *)
+						cmds[j].cmd)->unitId);
+			}
+			tsec_plat_release_comms_mutex();
+			return -TSEC_EINVAL;
+		}
+	}
 	tsec_plat_release_comms_mutex();
-	if (ipc_write(head, (u8 *)cmd, cmd_size)) {
+
+	cmdq_head_reg = tsec_cmdq_head_r(TSEC_CMD_QUEUE_PORT);
+	head = tsec_plat_reg_read(cmdq_head_reg);
+	published = head;
+
+	for (i = 0; i < num_cmds; i++) {
+		cmd_hdr = (struct RM_FLCN_QUEUE_HDR *)cmds[i].cmd;
+		err = cmdq_write_cmd(cmd_hdr, &head, &published);
+		if (err)
+			break;
+		plat_print(LVL_DBG, "Cmd queued to unit 0x%x\n", cmd_hdr->unitId);
+	}
+
+	/* One doorbell for all the commands copied */
+	if (published != head)
+		tsec_plat_reg_write(cmdq_head_reg, head);
+
+	if (err) {
+		/* Commands from i on never reached TSEC */
 		tsec_plat_acquire_comms_mutex();
-		s_callbacks[cmd_hdr->unitId].cb_func = NULL;
-		s_callbacks[cmd_hdr->unitId].cb_ctx  = NULL;
+		for (j = num_cmds; j-- > i; ) {
+			if (cmds[j].cb_func)
+				drop_last_cmd_cb(((struct RM_FLCN_QUEUE_HDR *)
+					cmds[j].cmd)->unitId);
+		}
 		tsec_plat_release_comms_mutex();
-		return -TSEC_EINVAL;
 	}
-	head += cmd_size_aligned;
-	tsec_plat_reg_write(cmdq_head_reg, head);
 
-	plat_print(LVL_DBG, "Cmd sent to unit 0x%x\n", cmd_hdr->unitId);
+	return err;
+}
+EXPORT_SYMBOL_COMMS(tsec_comms_send_cmds);
 
-	return 0;
+int tsec_comms_send_cmd(void *cmd, u32 queue_id,
+	callback_func_t cb_func, void *cb_ctx)
+{
+	struct tsec_comms_cmd tsec_cmd = {
+		.cmd = cmd,
+		.cb_func = cb_func,
+		.cb_ctx = cb_ctx,
+	};
+
+	return tsec_comms_send_cmds(&tsec_cmd, 1, queue_id);
 }
 EXPORT_SYMBOL_COMMS(tsec_comms_send_cmd);
 
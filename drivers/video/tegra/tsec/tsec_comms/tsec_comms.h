@@ -10,6 +10,13 @@
 
 typedef void (*callback_func_t)(void *, void *);
 
+/* A command and the callback to be invoked with its response */
+struct tsec_comms_cmd {
+	void            *cmd;
+	callback_func_t cb_func;
+	void            *cb_ctx;
+};
+
 /* -------- Tsec driver internal functions to be called by platform dependent code --------- */
 
 /* @brief: Initialises IPC CO and reserves pages on the same.
@@ -75,6 +82,26 @@ void tsec_comms_clear_init_cb(void);
 int tsec_comms_send_cmd(void *cmd, u32 queue_id,
 	callback_func_t cb_func, void *cb_ctx);
 
+/* @brief: Send several commands by putting them into the tsec queue
+ * and notifying tsec once for all of them. Each response is delivered
+ * from the message interrupt to the callback of its command. Up to 8
+ * commands with a callback may be outstanding per unit, the responses
+ * of a unit complete its commands in order.
+ * Concurrent senders must be serialised by the caller.
+ *
+ * usage: Called when sending a burst of commands to tsec, e.g. the
+ * HDCP session setup.
+ *
+ * params[in]: cmds     array of commands with their callbacks,
+ *                      cb_func may be NULL
+ *             num_cmds number of entries in cmds
+ *             queue_id Id of the queue being used.
+ *
+ * params[out]: return value(0 for success)
+ */
+int tsec_comms_send_cmds(struct tsec_comms_cmd *cmds, u32 num_cmds,
+	u32 queue_id);
+
 /* @brief: Retrieves a page from the carevout memory
  *
  * usage: Called to get a particular page from the carveout.
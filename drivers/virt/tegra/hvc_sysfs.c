@@ -26,14 +26,16 @@
 #include <linux/io.h>
 #include <soc/tegra/virt/syscalls.h>
 #include <soc/tegra/virt/hv-ivc.h>
+#include "tegra_hv.h"
 #define TEGRA_HV_ERR(...) pr_err("hvc_sysfs: " __VA_ARGS__)
 #define TEGRA_HV_INFO(...) pr_info("hvc_sysfs: " __VA_ARGS__)
 
 
 /*
  * This file implements a hypervisor control driver that can be accessed
- * from user-space via the sysfs interface. Currently, the only supported
- * use case is retrieval of the HV trace log when it is available.
+ * from user-space via the sysfs interface. It provides retrieval of the
+ * HV trace log when it is available, and per-queue IVC notification
+ * counters and coalescing settings through the "ivc_notify" node.
  */
 
 #define MAX_NAME_SIZE 50
@@ -121,6 +123,58 @@ static int create_log_mask_node(struct kobject *kobj)
 	return sysfs_create_bin_file(kobj, &log_mask_attr);
 }
 
+/*
+ * One line per IVC queue:
+ * id frames usecs raised deferred coalesced timer threshold irqs
+ */
+static ssize_t ivc_notify_show(struct kobject *kobj,
+	struct kobj_attribute *attr, char *buf)
+{
+	const struct ivc_info_page *info = tegra_hv_get_ivc_info();
+	struct tegra_hv_ivc_notify_stats stats;
+	uint32_t i, frames, usecs;
+	ssize_t len = 0;
+
+	if (IS_ERR(info))
+		return PTR_ERR(info);
+
+	for (i = 0; i < info->nr_queues; i++) {
+		uint32_t id = ivc_info_queue_array(info)[i].id;
+
+		if (tegra_hv_ivc_get_notify_stats(id, &frames, &usecs,
+				&stats) != 0)
+			continue;
+
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+			"%u %u %u %llu %llu %llu %llu %llu %llu\n",
+			id, frames, usecs, stats.raised, stats.deferred,
+			stats.coalesced, stats.timer_flushes,
+			stats.threshold_flushes, stats.irqs);
+	}
+
+	return len;
+}
+
+/* "<queue id> <frames> <usecs>" configures coalescing, usecs 0 disables it */
+static ssize_t ivc_notify_store(struct kobject *kobj,
+	struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	uint32_t id, frames, usecs;
+	int ret;
+
+	if (sscanf(buf, "%u %u %u", &id, &frames, &usecs) != 3)
+		return -EINVAL;
+
+	ret = tegra_hv_ivc_set_coalesce(id, frames, usecs);
+	if (ret != 0)
+		return ret;
+
+	return count;
+}
+
+static struct kobj_attribute ivc_notify_attr =
+	__ATTR(ivc_notify, 0600, ivc_notify_show, ivc_notify_store);
+
 /* Set up all relevant hypervisor control nodes */
 static int __init hvc_sysfs_register(void)
 {
@@ -217,6 +271,10 @@ static int __init hvc_sysfs_register(void)
 	else
 		TEGRA_HV_INFO("pct is unavailable\n");
 
+	ret = sysfs_create_file(kobj, &ivc_notify_attr.attr);
+	if (ret != 0)
+		TEGRA_HV_INFO("ivc notification counters are unavailable\n");
+
 	iounmap((void __iomem *)info);
 
 	return 0;
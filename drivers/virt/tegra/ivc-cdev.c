@@ -16,7 +16,10 @@
 #include <linux/slab.h>
 #include <linux/mm.h>
 #include <linux/sched.h>
+#include <linux/spinlock.h>
+#include <linux/eventfd.h>
 #include <soc/tegra/fuse.h>
+#include <soc/tegra/ivc_ext.h>
 
 #include <uapi/linux/tegra-ivc-dev.h>
 #include "tegra_hv.h"
@@ -47,6 +50,12 @@ struct ivc_dev {
 	struct mutex		file_lock;
 	/* Bool to store whether we received any ivc interrupt */
 	bool			ivc_intr_rcvd;
+	/*
+	 * Optional eventfd signalled from the hard IRQ handler in place of
+	 * waking the IRQ thread; protected by eventfd_lock.
+	 */
+	spinlock_t		eventfd_lock;
+	struct eventfd_ctx	*eventfd;
 };
 
 static dev_t ivc_dev;
@@ -73,11 +82,90 @@ static irqreturn_t ivc_dev_handler(int irq, void *data)
 
 static irqreturn_t ivc_threaded_irq_handler(int irq, void *dev_id)
 {
+	struct ivc_dev *ivcd = dev_id;
+	irqreturn_t ret = IRQ_WAKE_THREAD;
+
 	/*
 	 * Virtual IRQs are known to be edge-triggered, so no action is needed
 	 * to acknowledge them.
+	 *
+	 * When userspace registered an eventfd, signal it right here and skip
+	 * the IRQ thread; this saves a context switch per notification.
 	 */
-	return IRQ_WAKE_THREAD;
+	spin_lock(&ivcd->eventfd_lock);
+	if (ivcd->eventfd != NULL) {
+#if defined(NV_EVENTFD_SIGNAL_HAS_COUNTER_ARG) /* Linux v6.8 */
+		eventfd_signal(ivcd->eventfd, 1);
+#else
+		eventfd_signal(ivcd->eventfd);
+#endif
+		ret = IRQ_HANDLED;
+	}
+	spin_unlock(&ivcd->eventfd_lock);
+
+	return ret;
+}
+
+static int ivc_dev_set_eventfd(struct ivc_dev *ivcd, int32_t fd)
+{
+	struct eventfd_ctx *ctx = NULL, *old;
+	unsigned long flags;
+
+	if (fd >= 0) {
+		ctx = eventfd_ctx_fdget(fd);
+		if (IS_ERR(ctx))
+			return PTR_ERR(ctx);
+	} else if (fd != -1) {
+		return -EINVAL;
+	}
+
+	spin_lock_irqsave(&ivcd->eventfd_lock, flags);
+	old = ivcd->eventfd;
+	ivcd->eventfd = ctx;
+	spin_unlock_irqrestore(&ivcd->eventfd_lock, flags);
+
+	if (old != NULL)
+		eventfd_ctx_put(old);
+
+	return 0;
+}
+
+/*
+ * Decide whether the remote needs a notification for the frames userspace
+ * produced and consumed since its previous doorbell. The remote only sleeps
+ * on an empty rx queue or a full tx queue, so the notification is needed
+ * when our tx queue held no more than the new frames, or our rx queue was
+ * full before the released frames were consumed.
+ */
+static bool ivc_dev_doorbell_needed(struct ivc_dev *ivcd,
+		const struct nvipc_ivc_doorbell *db)
+{
+	struct tegra_ivc *ivc = tegra_hv_ivc_convert_cookie(ivcd->ivck);
+	uint32_t nframes = ivcd->qd->nframes;
+	uint32_t tx_pending, rx_pending;
+
+	if ((db->flags & NVIPC_IVC_DOORBELL_FORCE) ||
+			(db->tx_frames == 0 && db->rx_frames == 0))
+		return true;
+
+	/* order the caller's frame and counter writes before our reads */
+	smp_mb();
+
+#if defined(NV_TEGRA_IVC_STRUCT_HAS_IOSYS_MAP)
+	tx_pending = nframes - tegra_ivc_frames_available(ivc, &ivc->tx.map);
+	rx_pending = nframes - tegra_ivc_frames_available(ivc, &ivc->rx.map);
+#else
+	tx_pending = nframes - tegra_ivc_frames_available(ivc, ivc->tx.channel);
+	rx_pending = nframes - tegra_ivc_frames_available(ivc, ivc->rx.channel);
+#endif
+
+	if (db->tx_frames != 0 && tx_pending <= db->tx_frames)
+		return true;
+
+	if (db->rx_frames != 0 && rx_pending + db->rx_frames >= nframes)
+		return true;
+
+	return false;
 }
 
 static int ivc_dev_open(struct inode *inode, struct file *filp)
@@ -129,6 +217,7 @@ static int ivc_dev_release(struct inode *inode, struct file *filp)
 	ivck = ivcd->ivck;
 
 	devm_free_irq(ivcd->device, ivck->irq, ivcd);
+	ivc_dev_set_eventfd(ivcd, -1);
 
 	ivcd->ivck = NULL;
 
@@ -244,7 +333,9 @@ static long ivc_dev_ioctl(struct file *filp, unsigned int cmd,
 {
 	struct ivc_dev *ivcd = filp->private_data;
 	struct nvipc_ivc_info info;
+	struct nvipc_ivc_doorbell db;
 	uint64_t ivc_area_ipa, ivc_area_size;
+	int32_t fd;
 	long ret = 0;
 
 	/* validate the cmd */
@@ -332,6 +423,35 @@ static long ivc_dev_ioctl(struct file *filp, unsigned int cmd,
 		}
 		break;
 
+	case NVIPC_IVC_IOCTL_SET_EVENTFD:
+		if (copy_from_user(&fd, (void __user *) arg, sizeof(fd))) {
+			ret = -EFAULT;
+			break;
+		}
+		ret = ivc_dev_set_eventfd(ivcd, fd);
+		break;
+
+	case NVIPC_IVC_IOCTL_DOORBELL:
+		if (copy_from_user(&db, (void __user *) arg, sizeof(db))) {
+			ret = -EFAULT;
+			break;
+		}
+
+		if ((db.flags & ~NVIPC_IVC_DOORBELL_FORCE) != 0 ||
+				db.tx_frames > ivcd->qd->nframes ||
+				db.rx_frames > ivcd->qd->nframes) {
+			ret = -EINVAL;
+			break;
+		}
+
+		db.notified = ivc_dev_doorbell_needed(ivcd, &db) ? 1 : 0;
+		if (db.notified)
+			tegra_hv_ivc_notify(ivcd->ivck);
+
+		if (copy_to_user((void __user *) arg, &db, sizeof(db)))
+			ret = -EFAULT;
+		break;
+
 	default:
 		ret = -ENOTTY;
 	}
@@ -453,6 +573,7 @@ static int __init add_ivc(int i)
 	}
 
 	mutex_init(&ivc->file_lock);
+	spin_lock_init(&ivc->eventfd_lock);
 	init_waitqueue_head(&ivc->wq);
 
 	/* parent is this hvd dev */
@@ -19,6 +19,7 @@
 #include <linux/mutex.h>
 #include <linux/sched.h>
 #include <linux/interrupt.h>
+#include <linux/hrtimer.h>
 #include <linux/of.h>
 #include <linux/module.h>
 #include <linux/of.h>
@@ -34,6 +35,9 @@
 #define INFO(...) pr_info("tegra_hv: " __VA_ARGS__)
 #define DRV_NAME	"tegra_hv"
 
+/* upper bound for the notification coalescing delay */
+#define IVC_COALESCE_USECS_MAX	10000U
+
 struct tegra_hv_data;
 
 static struct property interrupts_prop = {
@@ -65,6 +69,19 @@ struct hv_ivc {
 
 	char			name[16];
 	int			irq;
+
+	/*
+	 * Notification coalescing. With coalesce_usecs set, doorbells raised
+	 * by the IVC core are held back until coalesce_frames frames are
+	 * pending in the tx queue or coalesce_usecs have elapsed, whichever
+	 * comes first. This lock protects the fields below.
+	 */
+	spinlock_t		notify_lock;
+	struct hrtimer		notify_timer;
+	uint32_t		coalesce_frames;
+	uint32_t		coalesce_usecs;
+	bool			notify_pending;
+	struct tegra_hv_ivc_notify_stats stats;
 };
 
 #define cookie_to_ivc_dev(_cookie) \
@@ -134,12 +151,87 @@ bool is_tegra_hypervisor_mode(void)
 }
 EXPORT_SYMBOL(is_tegra_hypervisor_mode);
 
+/* must be called with notify_lock held */
+static void ivc_ring_doorbell(struct hv_ivc *ivc)
+{
+	ivc->notify_pending = false;
+	ivc->stats.raised++;
+	*ivc->cookie.notify_va = ivc->qd->raise_irq;
+}
+
 static void ivc_raise_irq(struct tegra_ivc *ivc_channel, void *data)
 {
 	struct hv_ivc *ivc = container_of(ivc_channel, struct hv_ivc, ivc);
+	unsigned long flags;
+
 	if (WARN_ON(!ivc->cookie.notify_va))
 		return;
-	*ivc->cookie.notify_va = ivc->qd->raise_irq;
+
+	spin_lock_irqsave(&ivc->notify_lock, flags);
+	if (ivc->coalesce_usecs == 0U) {
+		ivc_ring_doorbell(ivc);
+	} else if (ivc->notify_pending) {
+		ivc->stats.coalesced++;
+	} else {
+		ivc->notify_pending = true;
+		ivc->stats.deferred++;
+		hrtimer_start(&ivc->notify_timer,
+			      ns_to_ktime((u64)ivc->coalesce_usecs * NSEC_PER_USEC),
+			      HRTIMER_MODE_REL);
+	}
+	spin_unlock_irqrestore(&ivc->notify_lock, flags);
+}
+
+static enum hrtimer_restart ivc_notify_timer_fn(struct hrtimer *timer)
+{
+	struct hv_ivc *ivc = container_of(timer, struct hv_ivc, notify_timer);
+	unsigned long flags;
+
+	spin_lock_irqsave(&ivc->notify_lock, flags);
+	if (ivc->notify_pending) {
+		ivc->stats.timer_flushes++;
+		ivc_ring_doorbell(ivc);
+	}
+	spin_unlock_irqrestore(&ivc->notify_lock, flags);
+
+	return HRTIMER_NORESTART;
+}
+
+/*
+ * Ring a held back doorbell once enough frames are pending in the tx queue.
+ * Called after every frame written through the tegra_hv_ivc_write* helpers.
+ */
+static void ivc_coalesce_check(struct hv_ivc *ivc)
+{
+	uint32_t threshold = READ_ONCE(ivc->coalesce_frames);
+	uint32_t pending;
+	unsigned long flags;
+	bool rung = false;
+
+	if (!READ_ONCE(ivc->notify_pending) || threshold == 0U)
+		return;
+
+#if defined(NV_TEGRA_IVC_STRUCT_HAS_IOSYS_MAP)
+	pending = ivc->qd->nframes -
+		tegra_ivc_frames_available(&ivc->ivc, &ivc->ivc.tx.map);
+#else
+	pending = ivc->qd->nframes -
+		tegra_ivc_frames_available(&ivc->ivc, ivc->ivc.tx.channel);
+#endif
+	if (pending < threshold)
+		return;
+
+	spin_lock_irqsave(&ivc->notify_lock, flags);
+	if (ivc->notify_pending) {
+		ivc->stats.threshold_flushes++;
+		ivc_ring_doorbell(ivc);
+		rung = true;
+	}
+	spin_unlock_irqrestore(&ivc->notify_lock, flags);
+
+	/* the callback may already be running; it finds nothing pending */
+	if (rung)
+		hrtimer_try_to_cancel(&ivc->notify_timer);
 }
 
 static struct tegra_hv_data *get_hvd(void)
@@ -193,6 +285,11 @@ static void ivc_handle_notification(struct hv_ivc *ivc)
 static irqreturn_t ivc_dev_cookie_irq_handler(int irq, void *data)
 {
 	struct hv_ivc *ivcd = data;
+
+	spin_lock(&ivcd->notify_lock);
+	ivcd->stats.irqs++;
+	spin_unlock(&ivcd->notify_lock);
+
 	ivc_handle_notification(ivcd);
 	return IRQ_HANDLED;
 }
@@ -254,6 +351,9 @@ static int tegra_hv_add_ivc(struct tegra_hv_data *hvd,
 	BUG_ON(ivc->givci->shmem == 0);
 
 	mutex_init(&ivc->lock);
+	spin_lock_init(&ivc->notify_lock);
+	hrtimer_init(&ivc->notify_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	ivc->notify_timer.function = ivc_notify_timer_fn;
 
 	if (qd->peers[0] == qd->peers[1]) {
 		/*
@@ -373,9 +473,16 @@ static struct hv_ivc *ivc_device_by_id(struct tegra_hv_data *hvd, uint32_t id)
 
 static void tegra_hv_ivc_cleanup(struct tegra_hv_data *hvd)
 {
+	uint32_t i;
+
 	if (!hvd->ivc_devs)
 		return;
 
+	for (i = 0; i <= hvd->max_qid; i++) {
+		if (hvd->ivc_devs[i].valid)
+			hrtimer_cancel(&hvd->ivc_devs[i].notify_timer);
+	}
+
 	kfree(hvd->ivc_devs);
 	hvd->ivc_devs = NULL;
 }
@@ -710,6 +817,7 @@ EXPORT_SYMBOL(tegra_hv_ivc_reserve);
 void tegra_hv_ivc_notify(struct tegra_hv_ivc_cookie *ivck)
 {
 	struct hv_ivc *ivc;
+	unsigned long flags;
 
 	if (ivck == NULL)
 		return;
@@ -717,10 +825,68 @@ void tegra_hv_ivc_notify(struct tegra_hv_ivc_cookie *ivck)
 	ivc = cookie_to_ivc_dev(ivck);
 	if (WARN_ON(!ivc->cookie.notify_va))
 		return;
-	*ivc->cookie.notify_va = ivc->qd->raise_irq;
+
+	spin_lock_irqsave(&ivc->notify_lock, flags);
+	ivc_ring_doorbell(ivc);
+	spin_unlock_irqrestore(&ivc->notify_lock, flags);
 }
 EXPORT_SYMBOL(tegra_hv_ivc_notify);
 
+int tegra_hv_ivc_set_coalesce(uint32_t id, uint32_t frames, uint32_t usecs)
+{
+	struct tegra_hv_data *hvd = get_hvd();
+	struct hv_ivc *ivc;
+	unsigned long flags;
+
+	if (IS_ERR(hvd))
+		return PTR_ERR(hvd);
+
+	ivc = ivc_device_by_id(hvd, id);
+	if (ivc == NULL)
+		return -ENODEV;
+
+	if (frames > ivc->qd->nframes || usecs > IVC_COALESCE_USECS_MAX)
+		return -EINVAL;
+
+	spin_lock_irqsave(&ivc->notify_lock, flags);
+	ivc->coalesce_frames = frames;
+	ivc->coalesce_usecs = usecs;
+	/* never strand a held back doorbell when coalescing is turned off */
+	if (usecs == 0U && ivc->notify_pending)
+		ivc_ring_doorbell(ivc);
+	spin_unlock_irqrestore(&ivc->notify_lock, flags);
+
+	if (usecs == 0U)
+		hrtimer_cancel(&ivc->notify_timer);
+
+	return 0;
+}
+EXPORT_SYMBOL(tegra_hv_ivc_set_coalesce);
+
+int tegra_hv_ivc_get_notify_stats(uint32_t id, uint32_t *frames,
+		uint32_t *usecs, struct tegra_hv_ivc_notify_stats *stats)
+{
+	struct tegra_hv_data *hvd = get_hvd();
+	struct hv_ivc *ivc;
+	unsigned long flags;
+
+	if (IS_ERR(hvd))
+		return PTR_ERR(hvd);
+
+	ivc = ivc_device_by_id(hvd, id);
+	if (ivc == NULL)
+		return -ENODEV;
+
+	spin_lock_irqsave(&ivc->notify_lock, flags);
+	*frames = ivc->coalesce_frames;
+	*usecs = ivc->coalesce_usecs;
+	*stats = ivc->stats;
+	spin_unlock_irqrestore(&ivc->notify_lock, flags);
+
+	return 0;
+}
+EXPORT_SYMBOL(tegra_hv_ivc_get_notify_stats);
+
 int tegra_hv_ivc_get_info(struct tegra_hv_ivc_cookie *ivck, uint64_t *pa,
 			  uint64_t *size)
 {
@@ -776,8 +942,12 @@ int tegra_hv_ivc_write(struct tegra_hv_ivc_cookie *ivck, const void *buf,
 		int size)
 {
 	struct hv_ivc *ivc = cookie_to_ivc_dev(ivck);
+	int ret;
+
+	ret = tegra_ivc_write(&ivc->ivc, NULL, buf, size);
+	ivc_coalesce_check(ivc);
 
-	return tegra_ivc_write(&ivc->ivc, NULL, buf, size);
+	return ret;
 }
 EXPORT_SYMBOL(tegra_hv_ivc_write);
 
@@ -785,8 +955,12 @@ int tegra_hv_ivc_write_user(struct tegra_hv_ivc_cookie *ivck, const void __user
 		int size)
 {
 	struct hv_ivc *ivc = cookie_to_ivc_dev(ivck);
+	int ret;
 
-	return tegra_ivc_write(&ivc->ivc, buf, NULL, size);
+	ret = tegra_ivc_write(&ivc->ivc, buf, NULL, size);
+	ivc_coalesce_check(ivc);
+
+	return ret;
 }
 EXPORT_SYMBOL(tegra_hv_ivc_write_user);
 
@@ -873,8 +1047,12 @@ EXPORT_SYMBOL(tegra_hv_ivc_write_get_next_frame);
 int tegra_hv_ivc_write_advance(struct tegra_hv_ivc_cookie *ivck)
 {
 	struct hv_ivc *ivc = cookie_to_ivc_dev(ivck);
+	int ret;
 
-	return tegra_ivc_write_advance(&ivc->ivc);
+	ret = tegra_ivc_write_advance(&ivc->ivc);
+	ivc_coalesce_check(ivc);
+
+	return ret;
 }
 EXPORT_SYMBOL(tegra_hv_ivc_write_advance);
 
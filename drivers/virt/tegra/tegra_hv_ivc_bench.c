@@ -0,0 +1,520 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// SPDX-FileCopyrightText: Copyright (c) 2024, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+
+/*
+ * Latency and throughput benchmark of a hypervisor IVC queue.
+ *
+ * Both ends of the queue load this module and write the queue id to
+ * /sys/kernel/debug/tegra_hv_ivc_bench/queue. One end reads echo, which
+ * serves the other end until it stops the test. The other end reads
+ * pingpong or stream, which run a test and print its results:
+ *
+ * pingpong: count frames of frame_size bytes, each echoed back before the
+ *  next one is sent. Reports the round trip time histogram.
+ * stream: count frames of frame_size bytes written back to back, the peer
+ *  only acks the last one. Reports the throughput, the histogram of the
+ *  time spent waiting for tx room and the doorbells raised per frame.
+ *
+ * poll selects busy polling of the queue instead of sleeping until the
+ * queue interrupt. coalesce_frames and coalesce_usecs are applied with
+ * tegra_hv_ivc_set_coalesce() before each run.
+ */
+
+#define pr_fmt(fmt) "%s:%s(): " fmt, KBUILD_MODNAME, __func__
+
+#include <linux/debugfs.h>
+#include <linux/delay.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/sched/signal.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/wait.h>
+#include <soc/tegra/virt/hv-ivc.h>
+
+#define IVC_BENCH_MAGIC		0x49564342U	/* "IVCB" */
+#define IVC_BENCH_TIMEOUT_MS	5000
+#define IVC_BENCH_HIST_N	40
+
+enum ivc_bench_type {
+	IVC_BENCH_PING,		/* echoed back as is */
+	IVC_BENCH_DATA,		/* counted */
+	IVC_BENCH_DONE,		/* acked with the DATA frames counted */
+	IVC_BENCH_STOP,		/* acked, ends echo */
+};
+
+struct ivc_bench_hdr {
+	u32 magic;
+	u32 type;
+	u32 seq;
+	u32 count;
+};
+
+struct ivc_bench_hist {
+	u64 bucket[IVC_BENCH_HIST_N];	/* [2^i, 2^(i+1)) nsec */
+	u64 min;
+	u64 max;
+	u64 sum;
+	u64 n;
+};
+
+struct ivc_bench {
+	struct dentry *debugfs;
+	struct mutex lock;
+	wait_queue_head_t wq;
+	struct tegra_hv_ivc_cookie *ivck;
+	void *buf;
+
+	/* debugfs knobs */
+	u32 queue;
+	u32 frame_size;
+	u32 count;
+	u32 poll;
+	u32 coalesce_frames;
+	u32 coalesce_usecs;
+};
+
+static struct ivc_bench bench;
+
+static void ivc_bench_rdy(struct tegra_hv_ivc_cookie *ivck)
+{
+	wake_up_interruptible(&bench.wq);
+}
+
+static const struct tegra_hv_ivc_ops ivc_bench_ops = {
+	.rx_rdy = ivc_bench_rdy,
+	.tx_rdy = ivc_bench_rdy,
+};
+
+static bool ivc_bench_ready(struct ivc_bench *b, bool tx)
+{
+	return tx ? tegra_hv_ivc_can_write(b->ivck) :
+		    tegra_hv_ivc_can_read(b->ivck);
+}
+
+/* Wait for room in the tx queue or for a frame in the rx queue. */
+static int ivc_bench_wait(struct ivc_bench *b, bool tx)
+{
+	ktime_t end = ktime_add_ms(ktime_get(), IVC_BENCH_TIMEOUT_MS);
+	long ret;
+
+	while (!ivc_bench_ready(b, tx)) {
+		if (ktime_after(ktime_get(), end))
+			return -ETIMEDOUT;
+
+		if (b->poll) {
+			if (signal_pending(current))
+				return -EINTR;
+			cond_resched();
+			continue;
+		}
+
+		ret = wait_event_interruptible_timeout(b->wq,
+				ivc_bench_ready(b, tx),
+				msecs_to_jiffies(IVC_BENCH_TIMEOUT_MS));
+		if (ret < 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int ivc_bench_send(struct ivc_bench *b, u32 type, u32 seq, u32 count,
+			  u32 size)
+{
+	struct ivc_bench_hdr *hdr = b->buf;
+	int ret;
+
+	ret = ivc_bench_wait(b, true);
+	if (ret)
+		return ret;
+
+	hdr->magic = IVC_BENCH_MAGIC;
+	hdr->type = type;
+	hdr->seq = seq;
+	hdr->count = count;
+
+	ret = tegra_hv_ivc_write(b->ivck, b->buf, size);
+
+	return ret < 0 ? ret : 0;
+}
+
+static int ivc_bench_recv(struct ivc_bench *b, struct ivc_bench_hdr *hdr)
+{
+	int ret;
+
+	ret = ivc_bench_wait(b, false);
+	if (ret)
+		return ret;
+
+	ret = tegra_hv_ivc_read(b->ivck, b->buf, b->ivck->frame_size);
+	if (ret < 0)
+		return ret;
+
+	memcpy(hdr, b->buf, sizeof(*hdr));
+	if (ret < sizeof(*hdr) || hdr->magic != IVC_BENCH_MAGIC)
+		return -EPROTO;
+
+	return 0;
+}
+
+static void ivc_bench_hist_add(struct ivc_bench_hist *h, u64 ns)
+{
+	u32 i = ns ? min_t(u32, ilog2(ns), IVC_BENCH_HIST_N - 1) : 0;
+
+	h->bucket[i]++;
+	h->min = h->n ? min(h->min, ns) : ns;
+	h->max = max(h->max, ns);
+	h->sum += ns;
+	h->n++;
+}
+
+static void ivc_bench_hist_show(struct seq_file *s, const char *name,
+				struct ivc_bench_hist *h)
+{
+	u32 i;
+
+	if (!h->n)
+		return;
+
+	seq_printf(s, "%s nsec: min %llu avg %llu max %llu\n", name, h->min,
+		   div64_u64(h->sum, h->n), h->max);
+
+	for (i = 0; i < IVC_BENCH_HIST_N; i++)
+		if (h->bucket[i])
+			seq_printf(s, "  %12llu - %12llu: %llu\n", BIT_ULL(i),
+				   BIT_ULL(i + 1) - 1, h->bucket[i]);
+}
+
+/* Reserve the queue and wait for the peer to sync it. */
+static int ivc_bench_start(struct ivc_bench *b, struct seq_file *s)
+{
+	ktime_t end;
+	int ret;
+
+	b->ivck = tegra_hv_ivc_reserve(NULL, b->queue, &ivc_bench_ops);
+	if (IS_ERR(b->ivck)) {
+		ret = PTR_ERR(b->ivck);
+		b->ivck = NULL;
+		seq_printf(s, "failed to reserve queue %u: %d\n", b->queue, ret);
+		return ret;
+	}
+
+	b->buf = kzalloc(b->ivck->frame_size, GFP_KERNEL);
+	if (!b->buf) {
+		ret = -ENOMEM;
+		goto unreserve;
+	}
+
+	end = ktime_add_ms(ktime_get(), IVC_BENCH_TIMEOUT_MS);
+	while (tegra_hv_ivc_channel_notified(b->ivck) != 0) {
+		if (ktime_after(ktime_get(), end) || signal_pending(current)) {
+			seq_printf(s, "queue %u not established\n", b->queue);
+			ret = -ETIMEDOUT;
+			goto free;
+		}
+		usleep_range(100, 200);
+	}
+
+	ret = tegra_hv_ivc_set_coalesce(b->queue, b->coalesce_frames,
+					b->coalesce_usecs);
+	if (ret)
+		seq_printf(s, "coalescing not set: %d\n", ret);
+
+	return 0;
+
+free:
+	kfree(b->buf);
+	b->buf = NULL;
+unreserve:
+	tegra_hv_ivc_unreserve(b->ivck);
+	b->ivck = NULL;
+	return ret;
+}
+
+static void ivc_bench_stop(struct ivc_bench *b)
+{
+	kfree(b->buf);
+	b->buf = NULL;
+	tegra_hv_ivc_unreserve(b->ivck);
+	b->ivck = NULL;
+}
+
+/* Frame size of a run, at least the header and at most the queue frame. */
+static u32 ivc_bench_size(struct ivc_bench *b)
+{
+	return clamp_t(u32, b->frame_size, sizeof(struct ivc_bench_hdr),
+		       b->ivck->frame_size);
+}
+
+static int ivc_bench_pingpong(struct seq_file *s, void *data)
+{
+	struct ivc_bench *b = &bench;
+	struct ivc_bench_hist *rtt;
+	struct ivc_bench_hdr hdr;
+	ktime_t t0;
+	u32 i, size;
+	int ret;
+
+	rtt = kzalloc(sizeof(*rtt), GFP_KERNEL);
+	if (!rtt)
+		return -ENOMEM;
+
+	mutex_lock(&b->lock);
+
+	ret = ivc_bench_start(b, s);
+	if (ret)
+		goto out;
+
+	size = ivc_bench_size(b);
+
+	for (i = 0; i < b->count; i++) {
+		t0 = ktime_get();
+
+		ret = ivc_bench_send(b, IVC_BENCH_PING, i, 0, size);
+		if (ret)
+			break;
+
+		ret = ivc_bench_recv(b, &hdr);
+		if (ret)
+			break;
+
+		if (hdr.type != IVC_BENCH_PING || hdr.seq != i) {
+			ret = -EPROTO;
+			break;
+		}
+
+		ivc_bench_hist_add(rtt, ktime_to_ns(ktime_sub(ktime_get(), t0)));
+	}
+
+	seq_printf(s, "queue %u pingpong: %llu of %u frames of %u bytes, %s\n",
+		   b->queue, rtt->n, b->count, size, b->poll ? "poll" : "irq");
+	if (ret)
+		seq_printf(s, "failed at frame %u: %d\n", i, ret);
+	ivc_bench_hist_show(s, "round trip", rtt);
+
+	ivc_bench_stop(b);
+out:
+	mutex_unlock(&b->lock);
+	kfree(rtt);
+	return 0;
+}
+
+static int ivc_bench_stream(struct seq_file *s, void *data)
+{
+	struct ivc_bench *b = &bench;
+	struct tegra_hv_ivc_notify_stats st0 = {}, st1 = {};
+	struct ivc_bench_hist *stall;
+	struct ivc_bench_hdr hdr;
+	u32 i, size, frames, usecs;
+	bool stats;
+	ktime_t t0, t1;
+	u64 diff;
+	int ret;
+
+	stall = kzalloc(sizeof(*stall), GFP_KERNEL);
+	if (!stall)
+		return -ENOMEM;
+
+	mutex_lock(&b->lock);
+
+	ret = ivc_bench_start(b, s);
+	if (ret)
+		goto out;
+
+	size = ivc_bench_size(b);
+	stats = !tegra_hv_ivc_get_notify_stats(b->queue, &frames, &usecs, &st0);
+
+	t0 = ktime_get();
+	for (i = 0; i < b->count; i++) {
+		if (!tegra_hv_ivc_can_write(b->ivck)) {
+			t1 = ktime_get();
+			ret = ivc_bench_wait(b, true);
+			if (ret)
+				break;
+			ivc_bench_hist_add(stall, ktime_to_ns(ktime_sub(ktime_get(), t1)));
+		}
+
+		ret = ivc_bench_send(b, IVC_BENCH_DATA, i, 0, size);
+		if (ret)
+			break;
+	}
+
+	if (!ret)
+		ret = ivc_bench_send(b, IVC_BENCH_DONE, i, 0, size);
+	if (!ret)
+		ret = ivc_bench_recv(b, &hdr);
+	if (!ret && hdr.type != IVC_BENCH_DONE)
+		ret = -EPROTO;
+	diff = ktime_to_ns(ktime_sub(ktime_get(), t0));
+
+	if (stats)
+		stats = !tegra_hv_ivc_get_notify_stats(b->queue, &frames, &usecs, &st1);
+
+	seq_printf(s, "queue %u stream: %u frames of %u bytes, %s, coalesce %u frames %u usecs\n",
+		   b->queue, b->count, size, b->poll ? "poll" : "irq",
+		   b->coalesce_frames, b->coalesce_usecs);
+
+	if (ret) {
+		seq_printf(s, "failed at frame %u: %d\n", i, ret);
+	} else {
+		seq_printf(s, "peer got %u frames in %llu nsec, %llu frames/s, %llu KB/s\n",
+			   hdr.count, diff,
+			   div64_u64((u64)hdr.count * NSEC_PER_SEC, diff),
+			   div64_u64((u64)hdr.count * size * NSEC_PER_SEC, diff * 1024));
+		if (stats && i)
+			seq_printf(s, "doorbells %llu, %llu per 1000 frames\n",
+				   st1.raised - st0.raised,
+				   div64_u64((st1.raised - st0.raised) * 1000, i));
+	}
+	ivc_bench_hist_show(s, "tx full stall", stall);
+
+	ivc_bench_stop(b);
+out:
+	mutex_unlock(&b->lock);
+	kfree(stall);
+	return 0;
+}
+
+static int ivc_bench_echo(struct seq_file *s, void *data)
+{
+	struct ivc_bench *b = &bench;
+	struct ivc_bench_hdr hdr;
+	u64 pings = 0, frames = 0;
+	u32 count = 0;
+	int ret;
+
+	mutex_lock(&b->lock);
+
+	ret = ivc_bench_start(b, s);
+	if (ret)
+		goto out;
+
+	for (;;) {
+		ret = ivc_bench_recv(b, &hdr);
+		if (ret == -ETIMEDOUT)
+			continue;
+		if (ret)
+			break;
+
+		frames++;
+
+		switch (hdr.type) {
+		case IVC_BENCH_PING:
+			pings++;
+			/* b->buf still holds the frame */
+			ret = ivc_bench_send(b, IVC_BENCH_PING, hdr.seq, 0,
+					     b->ivck->frame_size);
+			break;
+		case IVC_BENCH_DATA:
+			count++;
+			break;
+		case IVC_BENCH_DONE:
+			ret = ivc_bench_send(b, IVC_BENCH_DONE, hdr.seq, count,
+					     sizeof(hdr));
+			count = 0;
+			break;
+		case IVC_BENCH_STOP:
+			ret = ivc_bench_send(b, IVC_BENCH_STOP, hdr.seq, 0,
+					     sizeof(hdr));
+			goto done;
+		default:
+			ret = -EPROTO;
+			break;
+		}
+
+		if (ret)
+			break;
+	}
+
+done:
+	seq_printf(s, "queue %u echo: %llu frames, %llu pings\n", b->queue,
+		   frames, pings);
+	if (ret)
+		seq_printf(s, "stopped: %d\n", ret);
+
+	ivc_bench_stop(b);
+out:
+	mutex_unlock(&b->lock);
+	return 0;
+}
+
+/* Stops the echo running on the peer. */
+static int ivc_bench_peer_stop(struct seq_file *s, void *data)
+{
+	struct ivc_bench *b = &bench;
+	struct ivc_bench_hdr hdr;
+	int ret;
+
+	mutex_lock(&b->lock);
+
+	ret = ivc_bench_start(b, s);
+	if (ret)
+		goto out;
+
+	ret = ivc_bench_send(b, IVC_BENCH_STOP, 0, 0, sizeof(hdr));
+	if (!ret)
+		ret = ivc_bench_recv(b, &hdr);
+	seq_printf(s, "queue %u stop: %d\n", b->queue, ret);
+
+	ivc_bench_stop(b);
+out:
+	mutex_unlock(&b->lock);
+	return 0;
+}
+
+DEFINE_SHOW_ATTRIBUTE(ivc_bench_pingpong);
+DEFINE_SHOW_ATTRIBUTE(ivc_bench_stream);
+DEFINE_SHOW_ATTRIBUTE(ivc_bench_echo);
+DEFINE_SHOW_ATTRIBUTE(ivc_bench_peer_stop);
+
+static int __init ivc_bench_init(void)
+{
+	struct ivc_bench *b = &bench;
+
+	if (!is_tegra_hypervisor_mode()) {
+		pr_err("hypervisor is not present\n");
+		return -ENODEV;
+	}
+
+	mutex_init(&b->lock);
+	init_waitqueue_head(&b->wq);
+	b->frame_size = 64;
+	b->count = 1000;
+
+	b->debugfs = debugfs_create_dir("tegra_hv_ivc_bench", NULL);
+	debugfs_create_u32("queue", 0644, b->debugfs, &b->queue);
+	debugfs_create_u32("frame_size", 0644, b->debugfs, &b->frame_size);
+	debugfs_create_u32("count", 0644, b->debugfs, &b->count);
+	debugfs_create_u32("poll", 0644, b->debugfs, &b->poll);
+	debugfs_create_u32("coalesce_frames", 0644, b->debugfs,
+			   &b->coalesce_frames);
+	debugfs_create_u32("coalesce_usecs", 0644, b->debugfs,
+			   &b->coalesce_usecs);
+	debugfs_create_file("pingpong", 0444, b->debugfs, NULL,
+			    &ivc_bench_pingpong_fops);
+	debugfs_create_file("stream", 0444, b->debugfs, NULL,
+			    &ivc_bench_stream_fops);
+	debugfs_create_file("echo", 0444, b->debugfs, NULL,
+			    &ivc_bench_echo_fops);
+	debugfs_create_file("stop", 0444, b->debugfs, NULL,
+			    &ivc_bench_peer_stop_fops);
+
+	return 0;
+}
+
+static void __exit ivc_bench_exit(void)
+{
+	debugfs_remove_recursive(bench.debugfs);
+	mutex_destroy(&bench.lock);
+}
+
+module_init(ivc_bench_init);
+module_exit(ivc_bench_exit);
+
+MODULE_DESCRIPTION("Tegra hypervisor IVC benchmark");
+MODULE_LICENSE("GPL");
@@ -27,6 +27,7 @@
 #define MAX_YIELD_VM_COUNT 10
 #define MAX_VCPU_YIELD_TIMEOUT_US 1000000
 #define MAX_IVC_READ_FLUSH 10
+#define MIN_ADAPTIVE_YIELD_US 20
 
 #define DRV_NAME	"tegra_hv_vcpu_yield"
 
@@ -45,6 +46,27 @@ struct vcpu_yield_dev {
 	char name[32];
 	bool char_is_open;
 	bool yield_in_progress;
+
+	/* Result of the last vcpu_yield_func() run */
+	ktime_t yield_start;
+	ktime_t yield_end;
+	bool yield_ivc_rcvd;
+
+	/*
+	 * Wakeup latency of the low prio VM, i.e. the time from the start of
+	 * a yield to its IVC message, in ns: the smoothed mean scaled by 8 and
+	 * the mean deviation scaled by 4. Protected by mutex_lock, as are the
+	 * stats.
+	 */
+	u64 lat_avg;
+	u64 lat_mdev;
+
+	/* Per vcpu yield statistics, all times in ns */
+	u64 yield_count;
+	u64 ivc_wakeups;
+	u64 timeouts;
+	u64 yield_time;
+	u64 run_time;
 };
 
 struct vcpu_yield_plat_dev {
@@ -56,6 +78,58 @@ struct vcpu_yield_plat_dev {
 
 static uint32_t max_timeout_us = MAX_VCPU_YIELD_TIMEOUT_US;
 
+/*
+ * The adaptive window covers the mean wakeup latency plus four mean
+ * deviations, so the low prio VM keeps the VCPU for the time it usually
+ * needs while a late peer doesn't hold it up to the full timeout.
+ */
+static uint32_t vcpu_yield_adaptive_timeout(struct vcpu_yield_dev *vcpu_yield,
+					    uint32_t timeout_us)
+{
+	u64 window;
+
+	if (!vcpu_yield->ivc_wakeups)
+		return timeout_us;
+
+	window = (vcpu_yield->lat_avg >> 3) + vcpu_yield->lat_mdev;
+	window = max_t(u64, div_u64(window, NSEC_PER_USEC),
+		       MIN_ADAPTIVE_YIELD_US);
+
+	return min_t(u64, window, timeout_us);
+}
+
+static void vcpu_yield_update_stats(struct vcpu_yield_dev *vcpu_yield,
+				    ktime_t prev_end)
+{
+	u64 yield_ns = ktime_to_ns(ktime_sub(vcpu_yield->yield_end,
+					     vcpu_yield->yield_start));
+	s64 err;
+
+	vcpu_yield->yield_count++;
+	vcpu_yield->yield_time += yield_ns;
+	if (prev_end)
+		vcpu_yield->run_time += ktime_to_ns(ktime_sub(
+				vcpu_yield->yield_start, prev_end));
+
+	if (!vcpu_yield->yield_ivc_rcvd) {
+		vcpu_yield->timeouts++;
+		return;
+	}
+
+	/* Only completed yields measure the latency of the low prio VM */
+	if (!vcpu_yield->ivc_wakeups++) {
+		vcpu_yield->lat_avg = yield_ns << 3;
+		vcpu_yield->lat_mdev = yield_ns << 1;
+		return;
+	}
+
+	err = yield_ns - (vcpu_yield->lat_avg >> 3);
+	vcpu_yield->lat_avg += err;
+	if (err < 0)
+		err = -err;
+	vcpu_yield->lat_mdev += err - (vcpu_yield->lat_mdev >> 2);
+}
+
 static enum hrtimer_restart timer_callback_func(struct hrtimer *hrt)
 {
 	return HRTIMER_NORESTART;
@@ -79,6 +153,7 @@ static long vcpu_yield_func(void *data)
 	bool ivc_rcvd = false;
 
 	timeout = ktime_set(0, (NSEC_PER_USEC * vcpu_yield->timeout_us));
+	vcpu_yield->yield_ivc_rcvd = false;
 
 	do {
 		if (tegra_hv_ivc_read_advance(vcpu_yield->ivck))
@@ -91,6 +166,8 @@ static long vcpu_yield_func(void *data)
 		return -EBUSY;
 	}
 
+	vcpu_yield->yield_start = ktime_get();
+
 	while ((timeout > 0) && (ivc_rcvd == false)) {
 
 		preempt_disable();
@@ -117,6 +194,9 @@ static long vcpu_yield_func(void *data)
 		preempt_enable();
 	}
 
+	vcpu_yield->yield_end = ktime_get();
+	vcpu_yield->yield_ivc_rcvd = ivc_rcvd;
+
 	return 0;
 }
 
@@ -168,9 +248,11 @@ static long tegra_hv_vcpu_yield_ioctl(struct file *filp, unsigned int cmd,
 	struct vcpu_yield_dev *data =
 		(struct vcpu_yield_dev *)filp->private_data;
 	struct vcpu_yield_start_ctl yield_start_ctl_data;
+	ktime_t prev_end;
 
 	switch (cmd) {
 	case VCPU_YIELD_START_IOCTL:
+	case VCPU_YIELD_START_ADAPTIVE_IOCTL:
 
 		mutex_lock(&data->mutex_lock);
 
@@ -196,6 +278,13 @@ static long tegra_hv_vcpu_yield_ioctl(struct file *filp, unsigned int cmd,
 			if (data->timeout_us > max_timeout_us)
 				data->timeout_us = max_timeout_us;
 
+			mutex_lock(&data->mutex_lock);
+			if (cmd == VCPU_YIELD_START_ADAPTIVE_IOCTL)
+				data->timeout_us = vcpu_yield_adaptive_timeout(
+						data, data->timeout_us);
+			prev_end = data->yield_end;
+			mutex_unlock(&data->mutex_lock);
+
 			ret = work_on_cpu_safe(data->vcpu, vcpu_yield_func,
 					(void *)data);
 			if (ret)
@@ -203,6 +292,8 @@ static long tegra_hv_vcpu_yield_ioctl(struct file *filp, unsigned int cmd,
 		}
 
 		mutex_lock(&data->mutex_lock);
+		if (!ret)
+			vcpu_yield_update_stats(data, prev_end);
 		data->yield_in_progress = false;
 		mutex_unlock(&data->mutex_lock);
 
@@ -217,6 +308,43 @@ out:
 	return ret;
 }
 
+#define VCPU_YIELD_STAT_ATTR(_name, _val)				\
+static ssize_t _name##_show(struct device *dev,				\
+			    struct device_attribute *attr, char *buf)	\
+{									\
+	struct vcpu_yield_dev *data = dev_get_drvdata(dev);		\
+	u64 val;							\
+									\
+	mutex_lock(&data->mutex_lock);					\
+	val = (_val);							\
+	mutex_unlock(&data->mutex_lock);				\
+									\
+	return sprintf(buf, "%llu\n", val);				\
+}									\
+static DEVICE_ATTR_RO(_name)
+
+VCPU_YIELD_STAT_ATTR(yield_count, data->yield_count);
+VCPU_YIELD_STAT_ATTR(ivc_wakeups, data->ivc_wakeups);
+VCPU_YIELD_STAT_ATTR(timeouts, data->timeouts);
+VCPU_YIELD_STAT_ATTR(yield_time_us, div_u64(data->yield_time, NSEC_PER_USEC));
+VCPU_YIELD_STAT_ATTR(run_time_us, div_u64(data->run_time, NSEC_PER_USEC));
+VCPU_YIELD_STAT_ATTR(adaptive_latency_us,
+		     div_u64(data->lat_avg >> 3, NSEC_PER_USEC));
+VCPU_YIELD_STAT_ATTR(adaptive_timeout_us,
+		     vcpu_yield_adaptive_timeout(data, max_timeout_us));
+
+static struct attribute *vcpu_yield_attrs[] = {
+	&dev_attr_yield_count.attr,
+	&dev_attr_ivc_wakeups.attr,
+	&dev_attr_timeouts.attr,
+	&dev_attr_yield_time_us.attr,
+	&dev_attr_run_time_us.attr,
+	&dev_attr_adaptive_latency_us.attr,
+	&dev_attr_adaptive_timeout_us.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(vcpu_yield);
+
 static const struct file_operations fops = {
 	.owner = THIS_MODULE,
 	.open = tegra_hv_vcpu_yield_open,
@@ -391,6 +519,7 @@ static int tegra_hv_vcpu_yield_probe(struct platform_device *pdev)
 		vcpu_yield->low_prio_vmid = vmid_list[i];
 		vcpu_yield->ivc = ivc_list[i];
 		vcpu_yield->vcpu = vcpu_list[i];
+		mutex_init(&vcpu_yield->mutex_lock);
 		cdev_init(&vcpu_yield->cdev, &fops);
 		result = snprintf(vcpu_yield->name, sizeof(vcpu_yield->name) - 1,
 				"tegra_hv_vcpu_yield_vm%d", vmid_list[i]);
@@ -403,9 +532,11 @@ static int tegra_hv_vcpu_yield_probe(struct platform_device *pdev)
 			pr_err("%s: Failed adding cdev to subsystem retval:%d\n", __func__, result);
 			goto out;
 		} else {
-			vcpu_yield->device = device_create(vcpu_yield_class,
-						&pdev->dev, vcpu_yield->dev,
-						vcpu_yield, vcpu_yield->name);
+			vcpu_yield->device = device_create_with_groups(
+						vcpu_yield_class, &pdev->dev,
+						vcpu_yield->dev, vcpu_yield,
+						vcpu_yield_groups,
+						"%s", vcpu_yield->name);
 			if (IS_ERR(vcpu_yield->device)) {
 				pr_err("device_create() failed for %s\n", vcpu_yield->name);
 				result = PTR_ERR(vcpu_yield->device);
@@ -414,8 +545,6 @@ static int tegra_hv_vcpu_yield_probe(struct platform_device *pdev)
 
 		}
 
-		mutex_init(&vcpu_yield->mutex_lock);
-
 		ivck = tegra_hv_ivc_reserve(NULL, vcpu_yield->ivc, NULL);
 		if (IS_ERR_OR_NULL(ivck)) {
 			pr_err("%s: Failed to reserve IVC %d\n", __func__,	vcpu_yield->ivc);
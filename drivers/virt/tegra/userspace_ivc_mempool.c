@@ -14,6 +14,10 @@
 #include <linux/sched.h>
 #include <linux/slab.h>
 #include <linux/mm.h>
+#include <linux/huge_mm.h>
+#if defined(NV_VMF_INSERT_PFN_PMD_HAS_PFN_T_ARG)
+#include <linux/pfn_t.h>
+#endif
 #include <soc/tegra/fuse.h>
 #include <soc/tegra/virt/hv-ivc.h>
 #include <uapi/linux/nvhvivc_mempool_ioctl.h>
@@ -159,6 +163,56 @@ static ssize_t ivc_mempool_write(struct file *filp,
 	return -ENOTSUPP;
 }
 
+#if defined(CONFIG_ARCH_SUPPORTS_PMD_PFNMAP)
+/*
+ * Shared mappings of the mempool are populated on fault so that the
+ * 2M aligned parts of a 2M aligned mempool get block (PMD) mappings
+ * instead of 4K PTEs. Everything else falls back to 4K pages.
+ */
+static vm_fault_t ivc_mempool_huge_fault(struct vm_fault *vmf,
+		unsigned int order)
+{
+	struct vm_area_struct *vma = vmf->vma;
+	struct ivc_mempool_dev *mempooldev = vma->vm_private_data;
+	unsigned long size = PAGE_SIZE << order;
+	unsigned long addr = vmf->address & ~(size - 1);
+	unsigned long pfn;
+
+	if ((addr < vma->vm_start) || (addr + size > vma->vm_end))
+		return VM_FAULT_FALLBACK;
+
+	pfn = (mempooldev->mempoolcfg->pa >> PAGE_SHIFT) +
+		((addr - vma->vm_start) >> PAGE_SHIFT);
+	if (!IS_ALIGNED(pfn, 1UL << order))
+		return VM_FAULT_FALLBACK;
+
+	switch (order) {
+	case 0:
+		return vmf_insert_pfn(vma, vmf->address, pfn);
+	case PMD_ORDER:
+#if defined(NV_VMF_INSERT_PFN_PMD_HAS_PFN_T_ARG)
+		return vmf_insert_pfn_pmd(vmf, __pfn_to_pfn_t(pfn, PFN_DEV),
+				vmf->flags & FAULT_FLAG_WRITE);
+#else
+		return vmf_insert_pfn_pmd(vmf, pfn,
+				vmf->flags & FAULT_FLAG_WRITE);
+#endif
+	default:
+		return VM_FAULT_FALLBACK;
+	}
+}
+
+static vm_fault_t ivc_mempool_fault(struct vm_fault *vmf)
+{
+	return ivc_mempool_huge_fault(vmf, 0);
+}
+
+static const struct vm_operations_struct ivc_mempool_vm_ops = {
+	.fault		= ivc_mempool_fault,
+	.huge_fault	= ivc_mempool_huge_fault,
+};
+#endif
+
 static int ivc_mempool_mmap(struct file *filp, struct vm_area_struct *vma)
 {
 	struct ivc_mempool_dev *mempooldev = filp->private_data;
@@ -179,6 +233,17 @@ static int ivc_mempool_mmap(struct file *filp, struct vm_area_struct *vma)
 		mpool_ipa_pfn =
 			(mempooldev->mempoolcfg->pa >> PAGE_SHIFT);
 
+#if defined(CONFIG_ARCH_SUPPORTS_PMD_PFNMAP)
+		if ((vma->vm_flags & VM_SHARED) &&
+				(map_region_sz >= PMD_SIZE)) {
+			vm_flags_set(vma, VM_IO | VM_PFNMAP |
+					VM_DONTEXPAND | VM_DONTDUMP);
+			vma->vm_private_data = mempooldev;
+			vma->vm_ops = &ivc_mempool_vm_ops;
+			return 0;
+		}
+#endif
+
 		if (remap_pfn_range(vma, vma->vm_start,
 					mpool_ipa_pfn,
 					map_region_sz,
@@ -234,6 +299,10 @@ static const struct file_operations ivc_mempool_fops = {
 	.write		= ivc_mempool_write,
 	.unlocked_ioctl	= ivc_mempool_dev_ioctl,
 	.mmap		= ivc_mempool_mmap,
+#if defined(CONFIG_ARCH_SUPPORTS_PMD_PFNMAP)
+	/* place the mapping on a 2M boundary so that it can use PMDs */
+	.get_unmapped_area = thp_get_unmapped_area,
+#endif
 };
 
 
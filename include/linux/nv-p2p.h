@@ -28,10 +28,13 @@
 	(NVIDIA_P2P_MINOR_VERSION((p)->version) >= \
 	(NVIDIA_P2P_MINOR_VERSION(v))))
 
+struct nvidia_p2p_cache_entry;
+
 enum nvidia_p2p_page_size_type {
 	NVIDIA_P2P_PAGE_SIZE_4KB = 0,
 	NVIDIA_P2P_PAGE_SIZE_64KB,
 	NVIDIA_P2P_PAGE_SIZE_128KB,
+	NVIDIA_P2P_PAGE_SIZE_2MB,
 	NVIDIA_P2P_PAGE_SIZE_COUNT
 };
 
@@ -50,6 +53,13 @@ typedef struct nvidia_p2p_page_table {
 	struct mutex lock;
 	void (*free_callback)(void *data);
 	void *data;
+
+	/*
+	 * Largest page size the pinned memory is physically contiguous and
+	 * aligned in. The pages array and entries stay in PAGE_SIZE units.
+	 */
+	u32 phys_page_size;
+	struct nvidia_p2p_cache_entry *cache_entry;
 } nvidia_p2p_page_table_t;
 
 typedef struct nvidia_p2p_dma_mapping {
@@ -64,7 +74,7 @@ typedef struct nvidia_p2p_dma_mapping {
 	enum dma_data_direction direction;
 } nvidia_p2p_dma_mapping_t;
 
-#define NVIDIA_P2P_PAGE_TABLE_VERSION   0x00010000
+#define NVIDIA_P2P_PAGE_TABLE_VERSION   0x00010001
 
 #define NVIDIA_P2P_PAGE_TABLE_VERSION_COMPATIBLE(p) \
 	NVIDIA_P2P_VERSION_COMPATIBLE(p, NVIDIA_P2P_PAGE_TABLE_VERSION)
@@ -80,7 +90,10 @@ typedef struct nvidia_p2p_dma_mapping {
  *   The size of the requested mapping.
  *   Size must be a multiple of Page size.
  * @param[out]    **page_table
- *   A pointer to struct nvidia_p2p_page_table
+ *   A pointer to struct nvidia_p2p_page_table. With the registration
+ *   cache enabled, the pages of a range released with
+ *   nvidia_p2p_put_pages() stay pinned until the range is invalidated and
+ *   are reused by the next call for the same range.
  * @param[in]     free_callback
  *   A non-NULL pointer to the function to be invoked when the pages
  *   underlying the virtual address range are freed
@@ -44,6 +44,23 @@ typedef void (*tegra_dce_client_ipc_callback_t)(u32 handle,
 	      u32 interface_type, u32 msg_length,
 	      void *msg_data, void *usr_ctx);
 
+/*
+ * tegra_dce_client_ipc_async_cb_t - callback function to notify the
+ * client that an rpc submitted with tegra_dce_client_ipc_send_async()
+ * has completed.
+ *
+ * @handle: handle the rpc was submitted on.
+ * @seq: sequence number returned at submission.
+ * @status: 0 if the response was read into @msg->rx, else the error.
+ * @msg: message passed at submission.
+ * @usr_ctx: Any user context if present.
+ *
+ * Called from the DCE client workqueue, the callback may submit further
+ * rpcs but must not wait for a tegra_dce_client_ipc_send_recv().
+ */
+typedef void (*tegra_dce_client_ipc_async_cb_t)(u32 handle, u32 seq,
+	      int status, struct dce_ipc_message *msg, void *usr_ctx);
+
 /*
  * tegra_dce_register_ipc_client() - used by clients to register with dce driver
  * @interface_type: Interface for which this client is expected to send rpcs and
@@ -75,4 +92,23 @@ int tegra_dce_unregister_ipc_client(u32 handle);
  */
 int tegra_dce_client_ipc_send_recv(u32 handle, struct dce_ipc_message *msg);
 
+/*
+ * tegra_dce_client_ipc_send_async() - used by clients to queue rpcs to dce
+ * without waiting for the response
+ * @handle : client_id registered with dce driver
+ * @msg : message to be sent and received, must stay valid until completion
+ * @callback_fn : called once the response has been read into @msg->rx
+ * @usr_ctx : Any user context if present.
+ * @seqp : returns the sequence number of the rpc, may be NULL.
+ *
+ * Several rpcs may be in flight per client. DCE answers them in order, so
+ * the responses are matched to the rpcs, and the callbacks run, in the
+ * order of their sequence numbers.
+ *
+ * Return: 0 if the rpc was queued else corresponding error value.
+ */
+int tegra_dce_client_ipc_send_async(u32 handle, struct dce_ipc_message *msg,
+		tegra_dce_client_ipc_async_cb_t callback_fn, void *usr_ctx,
+		u32 *seqp);
+
 #endif
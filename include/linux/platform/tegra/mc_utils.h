@@ -96,4 +96,44 @@ u8 get_dram_num_channels(void);
  * Return: mc clk in MHz.
  */
 unsigned long dram_clk_to_mc_clk(unsigned long dram_clk);
+
+struct tegra_emc_bw_req;
+
+/*
+ * Register a client of the EMC bandwidth aggregator.
+ *
+ * The ISO and non-ISO bandwidth requested by all the clients are summed,
+ * scaled by the EMC efficiency of the DRAM configuration and turned into a
+ * single EMC floor, instead of each client converting and padding its own
+ * request.
+ *
+ * @name Client name, reported in debugfs.
+ *
+ * Return: Request handle or ERR_PTR.
+ */
+struct tegra_emc_bw_req *tegra_emc_bw_register(const char *name);
+
+/*
+ * Update the bandwidth requested by a client.
+ *
+ * @req Request handle from tegra_emc_bw_register().
+ * @iso_kbps ISO bandwidth in KBps.
+ * @noniso_kbps Non-ISO bandwidth in KBps.
+ *
+ * Return: 0 on success, error from setting the EMC floor otherwise.
+ */
+int tegra_emc_bw_set(struct tegra_emc_bw_req *req, unsigned long iso_kbps,
+		     unsigned long noniso_kbps);
+
+/*
+ * Drop the request of a client and free it.
+ *
+ * @req Request handle from tegra_emc_bw_register().
+ */
+void tegra_emc_bw_unregister(struct tegra_emc_bw_req *req);
+
+/*
+ * Return: EMC floor in KHz resulting from the requests of all the clients.
+ */
+unsigned long tegra_emc_bw_floor(void);
 #endif /* __TEGRA_MC_UTILS_H */
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/* SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved. */
+
+#ifndef __TEGRA_THROTTLE_EVENT_H
+#define __TEGRA_THROTTLE_EVENT_H
+
+#include <linux/minmax.h>
+#include <linux/notifier.h>
+#include <linux/types.h>
+
+/*
+ * Events of the throttle event chain. ACTIVE is sent when the first source
+ * reports a thermal trip or an overcurrent event, INACTIVE when the last one
+ * has cleared. Subscribers are called in process context.
+ */
+#define TEGRA_THROTTLE_EVENT_INACTIVE	0
+#define TEGRA_THROTTLE_EVENT_ACTIVE	1
+
+/* clients registering / unregistering for throttle events */
+int tegra_throttle_event_register_notifier(struct notifier_block *nb);
+int tegra_throttle_event_unregister_notifier(struct notifier_block *nb);
+
+/* state last sent to the clients */
+bool tegra_throttle_event_is_active(void);
+
+/* event sources reporting an event becoming active / cleared */
+void tegra_throttle_event_get(void);
+void tegra_throttle_event_put(void);
+
+/*
+ * Highest frequency of a devfreq frequency table that does not exceed pct
+ * percent of the highest one, for clients capping their targets while
+ * the throttle event is active.
+ */
+static inline unsigned long tegra_throttle_event_cap_freq(const unsigned long *freq_table,
+							  unsigned int count,
+							  unsigned int pct)
+{
+	unsigned long max_freq = 0, cap, freq = 0;
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		max_freq = max(max_freq, freq_table[i]);
+
+	cap = max_freq / 100 * min(pct, 100U);
+
+	for (i = 0; i < count; i++)
+		if (freq_table[i] <= cap && freq_table[i] > freq)
+			freq = freq_table[i];
+
+	/* never cap below the lowest frequency */
+	if (!freq)
+		for (i = 0, freq = max_freq; i < count; i++)
+			freq = min(freq, freq_table[i]);
+
+	return freq;
+}
+
+#endif /* __TEGRA_THROTTLE_EVENT_H */
@@ -37,6 +37,24 @@ int tegra_capture_ivc_capture_submit(
 	const void *capture_desc,
 	size_t len);
 
+/**
+ * @brief Submit an array of capture message binary blobs to capture-IVC
+ *	driver, which are transferred back to back over capture IVC channel
+ *	to RTCPU with a single notification where possible.
+ *
+ * @param[in]	capture_descs	array of capture message descriptors, each
+ *				of them opaque to capture-IVC driver.
+ * @param[in]	len		size of one capture message descriptor.
+ * @param[in]	count		number of descriptors in capture_descs.
+ *
+ * @returns	number of messages submitted (success, may be less than
+ *		count if submission stopped on error), neg. errno (failure)
+ */
+int tegra_capture_ivc_capture_submit_batch(
+	const void *capture_descs,
+	size_t len,
+	unsigned int count);
+
 /**
  * @brief Callback function to be registered by client to receive the rtcpu
  *	notifications through control or capture IVC channel.
@@ -71,6 +71,9 @@ struct tegra_ivc_channel {
 	atomic_t bus_resets;
 	u16 group;
 	bool is_ready;
+	/* doorbells rung by this task are held back, see ring_hold */
+	struct task_struct *ring_holder;
+	bool ring_pending;
 };
 
 static inline bool tegra_ivc_channel_online_check(
@@ -124,6 +127,16 @@ static inline struct device *tegra_ivc_channel_to_camrtc_dev(
 int tegra_ivc_channel_runtime_get(struct tegra_ivc_channel *chan);
 void tegra_ivc_channel_runtime_put(struct tegra_ivc_channel *chan);
 
+/*
+ * Coalesce the doorbells of a burst of writes. Between hold and release,
+ * doorbells rung by the calling task are recorded instead of raised and
+ * a single one is sent by flush or release. The caller must serialize
+ * writers, and must flush before waiting on the peer for space.
+ */
+void tegra_ivc_channel_ring_hold(struct tegra_ivc_channel *chan);
+void tegra_ivc_channel_ring_flush(struct tegra_ivc_channel *chan);
+void tegra_ivc_channel_ring_release(struct tegra_ivc_channel *chan);
+
 struct tegra_ivc_channel_ops {
 	int (*probe)(struct tegra_ivc_channel *);
 	void (*ready)(struct tegra_ivc_channel *, bool online);
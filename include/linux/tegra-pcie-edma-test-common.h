@@ -8,8 +8,13 @@
 #ifndef TEGRA_PCIE_EDMA_TEST_COMMON_H
 #define TEGRA_PCIE_EDMA_TEST_COMMON_H
 
+#include <linux/mm.h>
 #include <linux/pci-epf.h>
 #include <linux/pcie_dma.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
 #include <linux/tegra-pcie-edma.h>
 
 #define EDMA_ABORT_TEST_EN	(edma->edma_ch & 0x40000000)
@@ -25,6 +30,16 @@
 #define EDMA_PRIV_LR_OFF	(EDMA_PRIV_CH_OFF + 2)
 #define EDMA_PRIV_XF_OFF	(EDMA_PRIV_LR_OFF + 1)
 
+#define EDMA_BENCH_MAX_ITER	SZ_64K
+#define EDMA_BENCH_TIMEOUT_MS	5000
+
+/* One submission of the benchmark, passed as priv of the transfer. */
+struct edmalib_bench_xfer {
+	ktime_t submit;
+	u64 lat_ns;
+	edma_xfer_status_t status;
+};
+
 struct edmalib_common {
 	struct device *fdev;
 	void (*raise_irq)(void *p);
@@ -54,6 +69,8 @@ struct edmalib_common {
 	u32 nents_per_ch;
 	u32 st_as_ch;
 	u32 ls_as_ch;
+	atomic_t bench_pending;
+	wait_queue_head_t bench_wq;
 };
 
 static struct edmalib_common *l_edma;
@@ -332,4 +349,232 @@ fail:
 	return -1;
 }
 
+static void edma_bench_complete(void *priv, edma_xfer_status_t status,
+				struct tegra_pcie_edma_desc *desc)
+{
+	struct edmalib_common *edma = l_edma;
+	struct edmalib_bench_xfer *xfer = priv;
+
+	xfer->lat_ns = ktime_to_ns(ktime_sub(ktime_get(), xfer->submit));
+	xfer->status = status;
+
+	if (atomic_dec_and_test(&edma->bench_pending))
+		wake_up(&edma->bench_wq);
+}
+
+static int edma_bench_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/*
+ * debugfs to benchmark eDMA lib transfers. Uses the same edma_ch, dma_size,
+ * nents and stress_count as edmalib_common_test: every enabled channel gets
+ * stress_count transfers of nents / enabled channels descriptors of dma_size
+ * each, submitted round robin over the channels so that async channels run
+ * concurrently. The library only drives the engine in linked list mode,
+ * nents equal to the number of channels gives single descriptor transfers.
+ *
+ * Latency is from submission to completion of a transfer, including the
+ * retries on a full descriptor ring. CPU time is the one of the task running
+ * the benchmark, as accounted by the scheduler, split over the transfers.
+ */
+static int edmalib_common_bench(struct edmalib_common *edma, struct seq_file *s)
+{
+	struct tegra_pcie_edma_desc *ll_desc = edma->ll_desc;
+	struct tegra_pcie_edma_init_info info = {};
+	struct tegra_pcie_edma_chans_info *chan_info;
+	struct tegra_pcie_edma_xfer_info tx_info = {};
+	struct edmalib_bench_xfer *xfers, *xfer;
+	u32 chans[DMA_WR_CHNL_NUM], en_mask = 0, async_mask = 0;
+	u32 i, j, k, n = 0, chan_count, num_chans = 0, nents_per_ch, num_descriptors;
+	u32 iters = edma->stress_count, retries = 0, failed = 0, max_size;
+	u64 *lat, sum = 0, bytes, diff, cpu;
+	edma_xfer_type_t xfer_type;
+	edma_xfer_status_t ret;
+	char *xfer_str[2] = {"WR", "RD"};
+	char *l_r_str[2] = {"local", "remote"};
+	u32 l_r;
+	ktime_t start, t0;
+	long to;
+
+	if (iters == 0 || iters > EDMA_BENCH_MAX_ITER) {
+		seq_printf(s, "stress_count %u should be 1 to %u\n", iters,
+			   EDMA_BENCH_MAX_ITER);
+		return 0;
+	}
+
+	l_edma = edma;
+
+	if (edma->cookie && edma->prev_edma_ch != edma->edma_ch) {
+		tegra_pcie_edma_deinit(edma->cookie);
+		edma->cookie = NULL;
+	}
+
+	info.np = edma->of_node;
+
+	if (REMOTE_EDMA_TEST_EN) {
+		num_descriptors = 1024;
+		info.rx[0].desc_phy_base = edma->bar0_phy + SZ_512K;
+		info.rx[0].desc_iova = 0xf0000000 + SZ_512K;
+		info.rx[1].desc_phy_base = edma->bar0_phy + SZ_512K + SZ_256K;
+		info.rx[1].desc_iova = 0xf0000000 + SZ_512K + SZ_256K;
+		info.edma_remote = &edma->edma_remote;
+		chan_count = DMA_RD_CHNL_NUM;
+		chan_info = &info.rx[0];
+		xfer_type = EDMA_XFER_READ;
+		l_r = 1;
+	} else {
+		chan_count = DMA_WR_CHNL_NUM;
+		num_descriptors = 4096;
+		chan_info = &info.tx[0];
+		xfer_type = EDMA_XFER_WRITE;
+		l_r = 0;
+	}
+
+	for (i = 0; i < chan_count; i++) {
+		struct tegra_pcie_edma_chans_info *ch = chan_info + i;
+
+		ch->ch_type = IS_EDMA_CH_ASYNC(i) ? EDMA_CHAN_XFER_ASYNC :
+						    EDMA_CHAN_XFER_SYNC;
+		if (IS_EDMA_CH_ENABLED(i)) {
+			ch->num_descriptors = num_descriptors;
+			en_mask |= BIT(i);
+			if (ch->ch_type == EDMA_CHAN_XFER_ASYNC)
+				async_mask |= BIT(i);
+			chans[num_chans++] = i;
+		} else {
+			ch->num_descriptors = 0;
+		}
+	}
+
+	max_size = (BAR0_DMA_BUF_SIZE - BAR0_DMA_BUF_OFFSET) / 2;
+	if (num_chans == 0 || edma->nents < num_chans || edma->nents > NUM_EDMA_DESC ||
+	    (edma->dma_size * edma->nents) > max_size) {
+		seq_printf(s, "nents %u should be %u to %u, dma_size * nents <= 0x%x\n",
+			   edma->nents, num_chans, NUM_EDMA_DESC, max_size);
+		return 0;
+	}
+	nents_per_ch = edma->nents / num_chans;
+
+	for (j = 0; j < edma->nents; j++) {
+		ll_desc[j].src = edma->src_dma_addr + (j * edma->dma_size);
+		ll_desc[j].dst = edma->dst_dma_addr + (j * edma->dma_size);
+		ll_desc[j].sz = edma->dma_size;
+	}
+
+	if (!edma->cookie) {
+		edma->cookie = tegra_pcie_edma_initialize(&info);
+		if (!edma->cookie) {
+			seq_puts(s, "edma lib init failed\n");
+			return 0;
+		}
+		edma->prev_edma_ch = edma->edma_ch;
+		edma->st_as_ch = -1;
+	}
+
+	xfers = kvcalloc((size_t)iters * num_chans, sizeof(*xfers), GFP_KERNEL);
+	lat = kvcalloc((size_t)iters * num_chans, sizeof(*lat), GFP_KERNEL);
+	if (!xfers || !lat) {
+		kvfree(xfers);
+		kvfree(lat);
+		return -ENOMEM;
+	}
+
+	atomic_set(&edma->bench_pending, 1);
+	init_waitqueue_head(&edma->bench_wq);
+
+	cpu = current->se.sum_exec_runtime;
+	start = ktime_get();
+
+	for (k = 0; k < iters; k++) {
+		for (i = 0; i < num_chans; i++) {
+			u32 ch = chans[i];
+			bool async = async_mask & BIT(ch);
+
+			xfer = &xfers[k * num_chans + i];
+			tx_info.channel_num = ch;
+			tx_info.type = xfer_type;
+			tx_info.desc = &ll_desc[i * nents_per_ch];
+			tx_info.nents = nents_per_ch;
+			tx_info.complete = async ? edma_bench_complete : NULL;
+			tx_info.priv = xfer;
+
+			if (async)
+				atomic_inc(&edma->bench_pending);
+
+			t0 = ktime_get();
+			xfer->submit = t0;
+			do {
+				ret = tegra_pcie_edma_submit_xfer(edma->cookie, &tx_info);
+				if (ret != EDMA_XFER_FAIL_NOMEM)
+					break;
+				retries++;
+				usleep_range(10, 20);
+			} while (ktime_ms_delta(ktime_get(), t0) < EDMA_BENCH_TIMEOUT_MS);
+
+			if (ret != EDMA_XFER_SUCCESS) {
+				if (async)
+					atomic_dec(&edma->bench_pending);
+				seq_printf(s, "ch %u iter %u failed: %d\n", ch, k, ret);
+				goto wait;
+			}
+
+			if (!async) {
+				xfer->lat_ns = ktime_to_ns(ktime_sub(ktime_get(), t0));
+				xfer->status = ret;
+			}
+		}
+	}
+
+wait:
+	if (!atomic_dec_and_test(&edma->bench_pending)) {
+		to = wait_event_timeout(edma->bench_wq,
+					atomic_read(&edma->bench_pending) == 0,
+					msecs_to_jiffies(EDMA_BENCH_TIMEOUT_MS));
+		if (to == 0) {
+			/* completes the pending transfers with EDMA_XFER_DEINIT */
+			seq_puts(s, "timed out waiting for async transfers\n");
+			tegra_pcie_edma_deinit(edma->cookie);
+			edma->cookie = NULL;
+		}
+	}
+
+	diff = ktime_to_ns(ktime_sub(ktime_get(), start));
+	cpu = current->se.sum_exec_runtime - cpu;
+
+	for (j = 0; j < iters * num_chans; j++) {
+		if (xfers[j].lat_ns == 0)
+			continue;
+		if (xfers[j].status != EDMA_XFER_SUCCESS) {
+			failed++;
+			continue;
+		}
+		lat[n++] = xfers[j].lat_ns;
+		sum += xfers[j].lat_ns;
+	}
+
+	bytes = (u64)n * nents_per_ch * edma->dma_size;
+
+	seq_printf(s, "%s-%s chans 0x%x async 0x%x: %u x %u desc of %u B per chan\n",
+		   xfer_str[xfer_type], l_r_str[l_r], en_mask, async_mask, iters, nents_per_ch, edma->dma_size);
+	seq_printf(s, "xfers %u failed %u retries %u time %llu nsec\n", n, failed, retries, diff);
+
+	if (n != 0) {
+		sort(lat, n, sizeof(*lat), edma_bench_cmp, NULL);
+		seq_printf(s, "perf %llu Mbps\n", diff ? div64_u64(bytes * 8 * 1000, diff) : 0);
+		seq_printf(s, "latency nsec: min %llu avg %llu p50 %llu p90 %llu p99 %llu max %llu\n",
+			   lat[0], div64_u64(sum, n), lat[(n - 1) * 50 / 100],
+			   lat[(n - 1) * 90 / 100], lat[(n - 1) * 99 / 100], lat[n - 1]);
+		seq_printf(s, "cpu nsec per xfer %llu\n", div64_u64(cpu, n));
+	}
+
+	kvfree(lat);
+	kvfree(xfers);
+
+	return 0;
+}
+
 #endif /* TEGRA_PCIE_EDMA_TEST_COMMON_H */
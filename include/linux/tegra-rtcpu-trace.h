@@ -16,6 +16,7 @@ struct tegra_rtcpu_trace *tegra_rtcpu_trace_create(
 	struct camrtc_device_group *camera_devices);
 int tegra_rtcpu_trace_boot_sync(struct tegra_rtcpu_trace *tracer);
 void tegra_rtcpu_trace_flush(struct tegra_rtcpu_trace *tracer);
+void tegra_rtcpu_trace_doorbell(struct tegra_rtcpu_trace *tracer, u16 group);
 void tegra_rtcpu_trace_destroy(struct tegra_rtcpu_trace *tracer);
 
 #endif
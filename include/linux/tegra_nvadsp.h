@@ -141,6 +141,10 @@ void msgq_init(msgq_t *msgq, int32_t size);
 int32_t msgq_queue_message(msgq_t *msgq, const msgq_message_t *message);
 int32_t msgq_dequeue_message(msgq_t *msgq, msgq_message_t *message);
 #define msgq_discard_message(msgq) msgq_dequeue_message(msgq, NULL)
+int32_t msgq_peek_message(msgq_t *msgq, msgq_message_t **message);
+int32_t msgq_commit_message(msgq_t *msgq);
+int32_t msgq_queue_messages(msgq_t *msgq, const msgq_message_t **messages,
+	int32_t count);
 
 /*
  * DRAM Sharing
@@ -285,6 +289,10 @@ typedef struct nvadsp_app_info {
 	struct work_struct complete_work;
 	enum adsp_app_status_msg status_msg;
 	void *priv;
+	/* host side residency accounting, start to complete status */
+	ktime_t start_ts;
+	u64 run_ns;
+	u32 run_count;
 } nvadsp_app_info_t;
 
 nvadsp_app_handle_t __must_check nvadsp_app_load(const char *, const char *);
@@ -364,6 +372,7 @@ void nvadsp_set_adma_dump_reg(void (*cb_adma_regdump)(void));
  */
 unsigned long adsp_override_freq(unsigned long freq);
 void adsp_update_dfs_min_rate(unsigned long freq);
+void adsp_update_dfs_app_min_rate(unsigned long freq, bool add);
 
 /* Enable / disable dynamic freq scaling */
 void adsp_update_dfs(bool enable);
@@ -378,6 +387,12 @@ static inline void adsp_update_dfs_min_rate(unsigned long freq)
 	return;
 }
 
+static inline void adsp_update_dfs_app_min_rate(unsigned long freq,
+						bool add)
+{
+	return;
+}
+
 static inline void adsp_update_dfs(bool enable)
 {
 	return;
@@ -298,6 +298,7 @@ struct ep2h_empty_list {
 	int len;
 	dma_addr_t iova;
 	struct sk_buff *skb;
+	struct page *page;
 	struct list_head list;
 };
 
@@ -331,6 +332,65 @@ struct dma_desc_cnt {
 };
 #endif
 
+/* Linear part plus one segment per page frag */
+#define TVNET_TX_MAX_SEGS	(MAX_SKB_FRAGS + 1)
+
+struct tvnet_tx_seg {
+	dma_addr_t iova;
+	u32 len;
+};
+
+static inline void tvnet_unmap_skb(struct device *dev, struct sk_buff *skb,
+				   struct tvnet_tx_seg *seg, int nsegs)
+{
+	int i = 0;
+
+	if (skb_headlen(skb) && nsegs) {
+		dma_unmap_single(dev, seg[0].iova, seg[0].len, DMA_TO_DEVICE);
+		i = 1;
+	}
+
+	for (; i < nsegs; i++)
+		dma_unmap_page(dev, seg[i].iova, seg[i].len, DMA_TO_DEVICE);
+}
+
+/*
+ * Map linear data and page frags of skb in place so that they can be
+ * gathered by the DMA engine without a bounce copy.
+ * Returns number of segments mapped or negative error.
+ */
+static inline int tvnet_map_skb(struct device *dev, struct sk_buff *skb,
+				struct tvnet_tx_seg *seg)
+{
+	struct skb_shared_info *info = skb_shinfo(skb);
+	int i, nsegs = 0;
+
+	if (skb_headlen(skb)) {
+		seg[0].len = skb_headlen(skb);
+		seg[0].iova = dma_map_single(dev, skb->data, seg[0].len,
+					     DMA_TO_DEVICE);
+		if (dma_mapping_error(dev, seg[0].iova))
+			return -ENOMEM;
+		nsegs++;
+	}
+
+	for (i = 0; i < info->nr_frags; i++) {
+		skb_frag_t *frag = &info->frags[i];
+
+		seg[nsegs].len = skb_frag_size(frag);
+		seg[nsegs].iova = skb_frag_dma_map(dev, frag, 0,
+						   seg[nsegs].len,
+						   DMA_TO_DEVICE);
+		if (dma_mapping_error(dev, seg[nsegs].iova)) {
+			tvnet_unmap_skb(dev, skb, seg, nsegs);
+			return -ENOMEM;
+		}
+		nsegs++;
+	}
+
+	return nsegs;
+}
+
 static inline bool tvnet_ivc_empty(struct tvnet_counter *counter)
 {
 	u32 rd, wr;
@@ -105,6 +105,36 @@ regmap_util_write_table_16_as_8(struct regmap *regmap,
 				int num_override_regs,
 				u16 wait_ms_addr, u16 end_addr);
 
+#define REGMAP_UTIL_TXN_MAX_MSGS	16
+#define REGMAP_UTIL_TXN_MAX_BURST	16
+#define REGMAP_UTIL_TXN_BUF_SIZE	256
+
+/*
+ * Register write transaction: writes to consecutive registers are merged
+ * into auto-increment bursts, and the bursts are issued back to back in a
+ * single i2c_transfer() on commit.
+ */
+struct regmap_util_txn {
+	struct regmap *regmap;
+	struct i2c_client *client;
+	unsigned int reg_bytes;
+	unsigned int num_msgs;
+	unsigned int buf_len;
+	unsigned int regs[REGMAP_UTIL_TXN_MAX_MSGS];
+	struct i2c_msg msgs[REGMAP_UTIL_TXN_MAX_MSGS];
+	u8 buf[REGMAP_UTIL_TXN_BUF_SIZE];
+};
+
+void regmap_util_txn_begin(struct regmap_util_txn *txn,
+			   struct regmap *regmap,
+			   struct i2c_client *client,
+			   unsigned int reg_bits);
+
+int regmap_util_txn_write(struct regmap_util_txn *txn, unsigned int reg,
+			  const u8 *vals, unsigned int count);
+
+int regmap_util_txn_commit(struct regmap_util_txn *txn);
+
 enum switch_state {
 	SWITCH_OFF,
 	SWITCH_ON,
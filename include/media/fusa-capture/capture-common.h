@@ -17,6 +17,7 @@
 
 struct capture_buffer_table;
 struct capture_mapping;
+struct eventfd_ctx;
 
 /**
  * @defgroup CAPTURE_PROGRESS_NOTIFIER_STATES
@@ -62,6 +63,19 @@ struct capture_mapping;
 /** @brief  max pin count per request. Used to preallocate unpin list */
 #define MAX_PIN_BUFFER_PER_REQUEST 	(U32_C(24))
 
+/** @brief Max no. of buffers in a pre-pinned capture buffer ring */
+#define CAPTURE_BUFFER_RING_MAX_SLOTS	(U32_C(64))
+
+/**
+ * @brief Memory handle flag selecting a buffer ring slot instead of a memfd;
+ * memfds are non-negative so they never have this bit set.
+ */
+#define CAPTURE_BUFFER_RING_HANDLE_FLAG	(U32_C(0x80000000))
+
+/** @brief Memory handle of buffer ring slot @a index, for capture descriptors */
+#define CAPTURE_BUFFER_RING_HANDLE(index) \
+	(CAPTURE_BUFFER_RING_HANDLE_FLAG | (uint32_t)(index))
+
 
 
 /**
@@ -96,6 +110,26 @@ int capture_buffer_request(
 	uint32_t memfd,
 	uint32_t flag);
 
+/**
+ * @brief Pin and IOVA-resolve a ring of capture surface buffers once.
+ *
+ * Capture descriptors may then reference buffer @a i of the ring with the
+ * memory handle @ref CAPTURE_BUFFER_RING_HANDLE(i), which is resolved without
+ * a table lookup or refcounting per request. The ring stays registered until
+ * the table is destroyed; it can be registered only once.
+ *
+ * @param[in,out]	tab	Surface buffer management table
+ * @param[in]		memfds	FDs or NvRm handles of the ring buffers
+ * @param[in]		count	No. of buffers, at most
+ *				@ref CAPTURE_BUFFER_RING_MAX_SLOTS
+ *
+ * @returns		0 (success), neg. errno (failure)
+ */
+int capture_buffer_ring_register(
+	struct capture_buffer_table *tab,
+	const uint32_t *memfds,
+	uint32_t count);
+
 /**
  * @brief Add a capture surface buffer to the buffer management table.
  *
@@ -145,6 +179,8 @@ struct capture_common_status_notifier {
 	struct dma_buf *buf; /**< dma_buf handle */
 	void *va; /**< buffer virtual mapping to kernel address space */
 	uint32_t offset; /**< status notifier offset [byte] */
+	struct eventfd_ctx *eventfd;
+		/**< eventfd signalled on each status update (optional) */
 };
 
 /**
@@ -174,6 +210,23 @@ int capture_common_setup_progress_status_notifier(
 int capture_common_release_progress_status_notifier(
 	struct capture_common_status_notifier *progress_status_notifier);
 
+/**
+ * @brief Attach an eventfd to the progress status notifier, which is then
+ * signalled after every status update. The eventfd counter accumulates
+ * updates that userspace has not read yet, so one read() drains a whole
+ * batch of completions.
+ *
+ * @param[in,out]	progress_status_notifier	Progress status notifier
+ *							handle
+ * @param[in]		fd				eventfd file descriptor,
+ *							or -1 to detach
+ *
+ * @returns	0 (success), neg. errno (failure)
+ */
+int capture_common_set_progress_status_eventfd(
+	struct capture_common_status_notifier *progress_status_notifier,
+	int fd);
+
 /**
  * @brief Update the progress status for a capture request.
  *
@@ -233,4 +286,58 @@ int capture_common_pin_and_get_iova(struct capture_buffer_table *buf_ctx,
 		uint64_t *meminfo_base_address, uint64_t *meminfo_size,
 		struct capture_common_unpins *unpins);
 
+/**
+ * @brief Capture pipeline latency stages, see capture_latency_record().
+ */
+enum capture_latency_stage {
+	CAPTURE_LATENCY_VI_FRAME = 0,	/**< VI SOF to EOF */
+	CAPTURE_LATENCY_VI_STATUS,	/**< VI EOF to status indication */
+	CAPTURE_LATENCY_VI_DONE,	/**< VI status indication to vb2 done */
+	CAPTURE_LATENCY_VI_TOTAL,	/**< VI SOF to vb2 done */
+	CAPTURE_LATENCY_ISP_PROGRAM,	/**< ISP program submit to status */
+	CAPTURE_LATENCY_NUM,
+};
+
+/**
+ * @brief Current time in the TSC based timebase of the RCE timestamps (ns).
+ *
+ * @returns	TSC time [ns]
+ */
+uint64_t capture_latency_now(void);
+
+/**
+ * @brief Account a latency sample to a pipeline stage histogram.
+ *
+ * @param[in]	stage		Pipeline stage
+ * @param[in]	start_ns	Start of the stage, TSC time [ns]
+ * @param[in]	end_ns		End of the stage, TSC time [ns]
+ */
+void capture_latency_record(enum capture_latency_stage stage,
+		uint64_t start_ns, uint64_t end_ns);
+
+/**
+ * @brief Record the latency of a VI frame delivered to vb2, keyed by the VI
+ * channel and capture sequence, and account its stages.
+ *
+ * @param[in]	channel		VI channel id
+ * @param[in]	sequence	Frame sequence
+ * @param[in]	sof_ns		RCE SOF timestamp [ns]
+ * @param[in]	eof_ns		RCE EOF timestamp [ns]
+ * @param[in]	status_ns	Status indication arrival, TSC time [ns]
+ * @param[in]	done_ns		vb2 buffer done, TSC time [ns]
+ */
+void capture_latency_vi_frame(uint32_t channel, uint32_t sequence,
+		uint64_t sof_ns, uint64_t eof_ns, uint64_t status_ns,
+		uint64_t done_ns);
+
+/**
+ * @brief Create the capture latency debugfs nodes.
+ */
+void capture_latency_init(void);
+
+/**
+ * @brief Remove the capture latency debugfs nodes.
+ */
+void capture_latency_exit(void);
+
 #endif /* __FUSA_CAPTURE_COMMON_H__*/
@@ -346,6 +346,19 @@ int isp_capture_set_progress_status_notifier(
 	struct tegra_isp_channel *chan,
 	struct isp_capture_progress_status_req *req);
 
+/**
+ * @brief Attach an eventfd that is signalled whenever RCE reports a process
+ * or program status through the progress status notifier.
+ *
+ * @param[in]	chan	ISP channel context
+ * @param[in]	fd	eventfd file descriptor, or -1 to detach
+ *
+ * @returns	0 (success), neg. errno (failure)
+ */
+int isp_capture_set_status_eventfd(
+	struct tegra_isp_channel *chan,
+	int32_t fd);
+
 /**
  * @brief Perform a buffer management operation on an ISP capture buffer.
  *
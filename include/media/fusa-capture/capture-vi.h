@@ -28,6 +28,16 @@
 struct tegra_vi_channel;
 struct capture_buffer_table;
 
+/**
+ * @brief In-kernel capture status hook, invoked from the capture IVC status
+ * callback for every capture status indication in place of signalling
+ * @ref vi_capture::capture_resp.
+ *
+ * @param[in]	priv		Client context
+ * @param[in]	buffer_index	Capture descriptor queue index
+ */
+typedef void (*vi_capture_status_notify_fn)(void *priv, uint32_t buffer_index);
+
 /**
  * @brief VI channel capture context.
  */
@@ -54,6 +64,9 @@ struct vi_capture {
 		/**< No. of capture descriptors */
 	bool is_progress_status_notifier_set;
 		/**< Whether progress_status_notifer has been initialized */
+	vi_capture_status_notify_fn status_notify;
+		/**< In-kernel client capture status hook (optional) */
+	void *status_notify_priv; /**< Client context for status_notify */
 
 	uint32_t stream_id; /**< NVCSI PixelParser index [0-5] */
 	uint32_t csi_port; /**< NVCSI ports A-H [0-7] */
@@ -197,6 +210,39 @@ struct vi_capture_req {
 		 */
 } __VI_CAPTURE_ALIGN;
 
+/**
+ * @brief Maximum number of capture requests in a group request.
+ */
+#define VI_CAPTURE_GROUP_MAX_REQUESTS	16U
+
+/**
+ * @brief Entry of a VI capture group request.
+ */
+struct vi_capture_group_entry {
+	int32_t channel_fd;
+		/**<
+		 * VI channel file descriptor the request is for, or -1 for the
+		 * channel the IOCTL is issued on.
+		 */
+	uint32_t __pad;
+	struct vi_capture_req req; /**< Capture request for the channel */
+} __VI_CAPTURE_ALIGN;
+
+/**
+ * @brief VI capture group request (IOCTL payload).
+ *
+ * Submits one capture request per channel for a set of synchronized
+ * cameras in a single pass.
+ */
+struct vi_capture_group_req {
+	uint32_t num_requests;
+		/**< Number of entries, at most @ref VI_CAPTURE_GROUP_MAX_REQUESTS */
+	uint32_t num_submitted;
+		/**< [out] Number of requests handed to RCE, in entry order */
+	uint64_t entries;
+		/**< Pointer to an array of struct @ref vi_capture_group_entry */
+} __VI_CAPTURE_ALIGN;
+
 /**
  * @brief VI capture progress status setup config (IOCTL payload)
  */
@@ -215,6 +261,17 @@ struct vi_buffer_req {
 	uint32_t flag; /**< Buffer @ref CAPTURE_BUFFER_OPS bitmask. */
 } __VI_CAPTURE_ALIGN;
 
+/**
+ * @brief Register a ring of pre-pinned VI capture surface buffers (IOCTL
+ * payload)
+ */
+struct vi_buffer_ring_req {
+	uint32_t num_buffers;
+		/**< No. of buffers, at most @ref CAPTURE_BUFFER_RING_MAX_SLOTS */
+	uint32_t __pad;
+	uint64_t mems; /**< Pointer to an array of uint32_t NvRm handles */
+} __VI_CAPTURE_ALIGN;
+
 /**
  * @brief The compand configuration describes a piece-wise linear tranformation
  * function used by the VI companding module.
@@ -426,6 +483,30 @@ int vi_capture_request(
 	struct tegra_vi_channel *chan,
 	struct vi_capture_req *req);
 
+/**
+ * @brief Send capture requests for a group of VI channels via the capture
+ * IVC channel to RCE.
+ *
+ * The requests are written back to back while holding the reset lock of
+ * every channel in the group, so that RCE receives them in one batch with
+ * minimal skew between channels. Each capture still completes on its own
+ * channel's progress syncpoint.
+ *
+ * This is a non-blocking call.
+ *
+ * @param[in]	chans		VI channel contexts, each listed once
+ * @param[in]	reqs		VI capture requests, one per channel
+ * @param[in]	count		Number of channels in the group
+ * @param[out]	submitted	Number of requests handed to RCE
+ *
+ * @returns	0 (success), neg. errno (failure)
+ */
+int vi_capture_request_group(
+	struct tegra_vi_channel **chans,
+	struct vi_capture_req *reqs,
+	uint32_t count,
+	uint32_t *submitted);
+
 /**
  * @brief Wait on receipt of the capture status of the head of the capture
  *	  request FIFO queue to RCE. The RCE VI driver sends a
@@ -455,4 +536,35 @@ int vi_capture_set_progress_status_notifier(
 	struct tegra_vi_channel *chan,
 	struct vi_capture_progress_status_req *req);
 
+/**
+ * @brief Attach an eventfd that is signalled whenever RCE reports a capture
+ * status through the progress status notifier.
+ *
+ * @param[in]	chan	VI channel context
+ * @param[in]	fd	eventfd file descriptor, or -1 to detach
+ *
+ * @returns	0 (success), neg. errno (failure)
+ */
+int vi_capture_set_status_eventfd(
+	struct tegra_vi_channel *chan,
+	int32_t fd);
+
+/**
+ * @brief Route capture status indications of a VI channel to an in-kernel
+ * client, which then completes its frames directly from the IVC status
+ * callback instead of waiting in @ref vi_capture_status. The hook is read
+ * without locking, so set it before the first capture request is submitted;
+ * it is dropped on channel release.
+ *
+ * @param[in]	chan	VI channel context
+ * @param[in]	notify	Status hook, or NULL to restore completions
+ * @param[in]	priv	Client context passed to @a notify
+ *
+ * @returns	0 (success), neg. errno (failure)
+ */
+int vi_capture_set_status_notify(
+	struct tegra_vi_channel *chan,
+	vi_capture_status_notify_fn notify,
+	void *priv);
+
 #endif /* __FUSA_CAPTURE_VI_H__ */
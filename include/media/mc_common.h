@@ -116,6 +116,10 @@ struct tegra_vi_graph_entity {
  *
  * @kthread_capture: kernel thread task structure of this video channel
  * @wait: wait queue structure for kernel thread
+ * @capture_event_mode: buffers are completed and requeued from the VI capture
+ *                      status callback instead of the capture kthreads
+ * @capture_event_lock: serializes capture enqueue and completion in
+ *                      @capture_event_mode
  *
  * @format: active V4L2 pixel format
  * @fmtinfo: format information corresponding to the active @format
@@ -126,6 +130,11 @@ struct tegra_vi_graph_entity {
  *
  * @capture: list of queued buffers for capture
  * @queued_lock: protects the buf_queued list
+ * @inflight: lock-free ring of buffers in flight through VI, one slot per
+ *            vb2 buffer; single producer (capture thread) and single
+ *            consumer (release thread)
+ * @inflight_head: inflight capture sequence, advanced by the producer only
+ * @inflight_tail: released capture sequence, advanced by the consumer only
  *
  * @csi: CSI register bases
  * @stride_align: channel buffer stride alignment, default is 1
@@ -190,14 +199,17 @@ struct tegra_channel {
 	wait_queue_head_t release_wait;
 	struct task_struct *kthread_capture_dequeue;
 	wait_queue_head_t dequeue_wait;
+	bool capture_event_mode;
+	struct mutex capture_event_lock;
 	struct vb2_queue queue;
 	void *alloc_ctx;
 	bool init_done;
 	struct list_head capture;
-	struct list_head release;
+	struct tegra_channel_buffer **inflight;
+	u32 inflight_head;
+	u32 inflight_tail;
 	struct list_head dequeue;
 	spinlock_t start_lock;
-	spinlock_t release_lock;
 	spinlock_t dequeue_lock;
 	struct work_struct status_work;
 	struct work_struct error_work;
@@ -217,6 +229,7 @@ struct tegra_channel {
 	unsigned int saved_ctx_bypass;
 	unsigned int saved_ctx_pgmode;
 	unsigned int gang_mode;
+	unsigned int requested_gang_mode;
 	unsigned int gang_width;
 	unsigned int gang_height;
 	unsigned int gang_bytesperline;
@@ -397,6 +410,7 @@ void set_timestamp(struct tegra_channel_buffer *buf,
 void enqueue_inflight(struct tegra_channel *chan,
 			struct tegra_channel_buffer *buf);
 struct tegra_channel_buffer *dequeue_inflight(struct tegra_channel *chan);
+bool tegra_channel_has_inflight(struct tegra_channel *chan);
 int tegra_channel_set_power(struct tegra_channel *chan, bool on);
 
 int tegra_channel_init_video(struct tegra_channel *chan);
@@ -418,6 +432,7 @@ struct tegra_vi_fops {
 	void (*vi_stride_align)(unsigned int *bpl);
 	void (*vi_unit_get_device_handle)(struct platform_device *pdev,
 		uint32_t csi_steam_id, struct device **dev);
+	void (*vi_buffer_queued)(struct tegra_channel *chan);
 };
 
 struct tegra_csi_fops {
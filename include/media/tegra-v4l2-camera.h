@@ -48,6 +48,7 @@
 #define TEGRA_CAMERA_CID_SENSOR_DV_TIMINGS         (TEGRA_CAMERA_CID_BASE+108)
 #define TEGRA_CAMERA_CID_LOW_LATENCY         (TEGRA_CAMERA_CID_BASE+109)
 #define TEGRA_CAMERA_CID_VI_PREFERRED_STRIDE (TEGRA_CAMERA_CID_BASE+110)
+#define TEGRA_CAMERA_CID_VI_GANG_MODE        (TEGRA_CAMERA_CID_BASE+111)
 
 /**
  * This is temporary with the current v4l2 infrastructure
@@ -32,8 +32,21 @@ struct tegracam_device {
 
 u32 tegracam_version(u8 major, u8 minor, u8 patch);
 u32 tegracam_query_version(const char *of_dev_name);
+int tegracam_call_device(const char *of_dev_name,
+		int (*fn)(struct tegracam_device *tc_dev, void *data),
+		void *data);
 struct tegracam_device *to_tegracam_device(struct camera_common_data *data);
 
+/*
+ * Serialise the probe and power-up of sensors sharing a probe group, see
+ * tegracam_core.c. Sensor drivers probe with PROBE_PREFER_ASYNCHRONOUS and
+ * hold the group across their probe.
+ */
+struct tegracam_probe_group;
+struct tegracam_probe_group *tegracam_probe_group_lock(
+		struct i2c_client *client);
+void tegracam_probe_group_unlock(struct tegracam_probe_group *group);
+
 void tegracam_set_privdata(struct tegracam_device *tc_dev, void *priv);
 void *tegracam_get_privdata(struct tegracam_device *tc_dev);
 
@@ -25,6 +25,16 @@ struct tegra_hv_ivc_ops {
 	void (*tx_rdy)(struct tegra_hv_ivc_cookie *ivck);
 };
 
+/* per-queue doorbell accounting, see tegra_hv_ivc_set_coalesce() */
+struct tegra_hv_ivc_notify_stats {
+	uint64_t raised;		/* doorbells rung towards the remote */
+	uint64_t deferred;		/* doorbells held back by coalescing */
+	uint64_t coalesced;		/* doorbells folded into a held one */
+	uint64_t timer_flushes;		/* held doorbells rung by the timer */
+	uint64_t threshold_flushes;	/* held doorbells rung by the threshold */
+	uint64_t irqs;			/* interrupts for queues with ops */
+};
+
 struct tegra_hv_ivm_cookie {
 	uint64_t ipa;
 	uint64_t size;
@@ -305,6 +315,29 @@ int tegra_hv_ivc_get_info(struct tegra_hv_ivc_cookie *ivck, uint64_t *pa,
  */
 void tegra_hv_ivc_notify(struct tegra_hv_ivc_cookie *ivck);
 
+/**
+ * tegra_hv_ivc_set_coalesce - Configure notification coalescing of a queue
+ * @id		Id number of the queue
+ * @frames	Ring the doorbell once this many frames are pending, 0 to
+ *		rely on the timer only
+ * @usecs	Longest delay of a doorbell, 0 disables coalescing
+ *
+ * Returns 0 on success and an error code otherwise
+ */
+int tegra_hv_ivc_set_coalesce(uint32_t id, uint32_t frames, uint32_t usecs);
+
+/**
+ * tegra_hv_ivc_get_notify_stats - Get notification settings and counters
+ * @id		Id number of the queue
+ * @frames	Returns the coalescing frame threshold
+ * @usecs	Returns the coalescing delay
+ * @stats	Returns the notification counters
+ *
+ * Returns 0 on success and an error code otherwise
+ */
+int tegra_hv_ivc_get_notify_stats(uint32_t id, uint32_t *frames,
+		uint32_t *usecs, struct tegra_hv_ivc_notify_stats *stats);
+
 struct tegra_ivc *tegra_hv_ivc_convert_cookie(struct tegra_hv_ivc_cookie *ivck);
 #else
 static inline bool is_tegra_hypervisor_mode(void)
@@ -446,6 +479,19 @@ static inline void tegra_hv_ivc_notify(struct tegra_hv_ivc_cookie *ivck)
 	return;
 };
 
+static inline int tegra_hv_ivc_set_coalesce(uint32_t id, uint32_t frames,
+		uint32_t usecs)
+{
+	return -ENOTSUPP;
+};
+
+static inline int tegra_hv_ivc_get_notify_stats(uint32_t id,
+		uint32_t *frames, uint32_t *usecs,
+		struct tegra_hv_ivc_notify_stats *stats)
+{
+	return -ENOTSUPP;
+};
+
 static inline struct tegra_ivc *tegra_hv_ivc_convert_cookie(
 		struct tegra_hv_ivc_cookie *ivck)
 {
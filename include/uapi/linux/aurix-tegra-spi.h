@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#ifndef __UAPI_AURIX_TEGRA_SPI_H__
+#define __UAPI_AURIX_TEGRA_SPI_H__
+
+#include <linux/types.h>
+
+/*
+ * Layout of the message link exported by /dev/aurix_tegra_spi.
+ *
+ * Every SPI frame exchanged with the Aurix carries frame_packets packets
+ * of packet_size bytes (nvidia,frame-packets in the device tree, 1 by
+ * default). Pending Tx packets are packed into the next frame in queue
+ * order and the rest of the frame is filled with idle packets, all bytes
+ * 0xFF. Frames are clocked by the Aurix, so a queued packet goes out with
+ * the frame after the one currently armed.
+ *
+ * The header sits at offset 0 of the mapping. The Tx ring at tx_offset
+ * holds tx_entries packets: userspace owns tx_head and the driver owns
+ * tx_tail. The Rx ring at rx_offset holds rx_entries frames of
+ * rx_frame_size bytes, as received on the wire: the driver owns rx_head
+ * and userspace owns rx_tail. All indices are free running and wrap at
+ * 2^32, a slot is (idx & (entries - 1)). Read the other side's index with
+ * acquire semantics and publish your own with release semantics.
+ *
+ * Rx frames holding only idle packets and power management commands are
+ * not queued; the driver acts on the commands itself. Userspace skips the
+ * idle and command packets of a queued frame. Frames arriving while the
+ * Rx ring is full are counted in rx_dropped. poll() reports EPOLLIN once
+ * rx_head != rx_tail and EPOLLOUT while the Tx ring has room.
+ */
+#define AURIX_TEGRA_SPI_MAGIC		0x41535049	/* "ASPI" */
+#define AURIX_TEGRA_SPI_VERSION		1
+
+struct aurix_tegra_spi_hdr {
+	__u32 magic;
+	__u32 version;
+	__u32 packet_size;
+	__u32 frame_packets;
+	__u32 tx_offset;
+	__u32 tx_entries;	/* packets */
+	__u32 rx_offset;
+	__u32 rx_entries;	/* frames */
+	__u32 rx_frame_size;
+	__u32 tx_head;		/* written by userspace */
+	__u32 tx_tail;		/* written by the driver */
+	__u32 rx_head;		/* written by the driver */
+	__u32 rx_tail;		/* written by userspace */
+	__u32 rx_dropped;	/* frames lost on a full Rx ring */
+	__u32 reserved[2];
+};
+
+#endif /* __UAPI_AURIX_TEGRA_SPI_H__ */
@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#ifndef __UAPI_MTTCAN_FILTER_H__
+#define __UAPI_MTTCAN_FILTER_H__
+
+#include <linux/types.h>
+#include <linux/can.h>
+#include <linux/sockios.h>
+
+/*
+ * Program the mttcan hardware acceptance filters from a CAN_RAW style
+ * filter set. ifr_data points to a struct mttcan_hw_filters followed by
+ * count struct can_filter entries, interpreted as for CAN_RAW_FILTER.
+ *
+ * Hardware filtering is a superset of the given set: the CAN_RAW socket
+ * filters still apply on top of it. Frames matching no entry are dropped
+ * by the controller. RTR matching is not done in hardware, and a set
+ * holding a CAN_INV_FILTER entry accepts every frame. A count of 0
+ * removes all standard and extended ID filter elements and accepts
+ * every frame again.
+ *
+ * The call replaces the filter elements set through sysfs and is only
+ * allowed while the interface is down.
+ */
+#define MTTCAN_IOCTL_SET_FILTERS	(SIOCDEVPRIVATE + 0)
+
+#define MTTCAN_HW_FILTERS_MAX		256
+
+struct mttcan_hw_filters {
+	__u32 count;
+	__u32 reserved;			/* must be zero */
+	struct can_filter filters[];
+};
+
+#endif /* __UAPI_MTTCAN_FILTER_H__ */
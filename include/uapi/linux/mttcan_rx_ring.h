@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#ifndef __UAPI_MTTCAN_RX_RING_H__
+#define __UAPI_MTTCAN_RX_RING_H__
+
+#include <linux/types.h>
+#include <linux/can.h>
+
+/*
+ * Layout of the bulk Rx ring exported by /dev/<canX>_rxring.
+ *
+ * The ring is enabled by writing a power of two entry count to the
+ * rx_ring_entries sysfs attribute of the CAN netdev while it is down.
+ * Once enabled, received frames are no longer delivered as skbs to the
+ * CAN socket layer; they are only stored in the ring.
+ *
+ * The header sits at offset 0 of the mapping and the entries start at
+ * entries_offset. The driver owns head and userspace owns tail; both are
+ * free running and wrap at 2^32, an entry index is (idx & (num_entries - 1)).
+ * Userspace must read head with acquire semantics and publish tail with
+ * release semantics. poll() reports EPOLLIN once head != tail; the driver
+ * publishes head and wakes readers once per NAPI poll, not per frame.
+ */
+#define MTTCAN_RX_RING_MAGIC		0x4D525852	/* "MRXR" */
+#define MTTCAN_RX_RING_VERSION		1
+
+/* mttcan_rx_ring_entry.source */
+#define MTTCAN_RX_RING_SRC_BUFFER	0
+#define MTTCAN_RX_RING_SRC_FIFO0	1
+#define MTTCAN_RX_RING_SRC_FIFO1	2
+#define MTTCAN_RX_RING_SRC_HPM		3
+
+/* mttcan_rx_ring_entry.flags */
+#define MTTCAN_RX_RING_FL_FD		(1U << 0)	/* CAN FD frame */
+#define MTTCAN_RX_RING_FL_TSTAMP	(1U << 1)	/* tstamp_ns valid */
+
+struct mttcan_rx_ring_hdr {
+	__u32 magic;
+	__u32 version;
+	__u32 entry_size;
+	__u32 num_entries;
+	__u32 entries_offset;
+	__u32 head;		/* written by the driver */
+	__u32 tail;		/* written by userspace */
+	__u32 dropped;		/* frames lost on a full ring */
+};
+
+struct mttcan_rx_ring_entry {
+	__u64 tstamp_ns;	/* hardware Rx timestamp, see flags */
+	__u16 source;
+	__u16 flags;
+	__u32 reserved;
+	struct canfd_frame frame;	/* len is the payload length */
+};
+
+#endif /* __UAPI_MTTCAN_RX_RING_H__ */
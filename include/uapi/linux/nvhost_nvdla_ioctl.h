@@ -246,6 +246,63 @@ struct nvdla_status_notify {
 	__u32 status;
 };
 
+/**
+ * struct nvdla_queue_attr_args structure for queue attributes
+ *
+ * @id			attribute to set, one of NVDLA_QUEUE_ATTR_*
+ * @value		value of the attribute
+ *
+ * NVDLA_QUEUE_ATTR_TIMING_RING allocates a ring of @value task timing
+ * records for the fd, see struct nvdla_task_timing_header. @value is a
+ * power of two no larger than NVDLA_TASK_TIMING_MAX_RECORDS and the ring
+ * can be set once per fd.
+ *
+ */
+struct nvdla_queue_attr_args {
+#define NVDLA_QUEUE_ATTR_PRIORITY	0U
+#define NVDLA_QUEUE_ATTR_TIMING_RING	1U
+	__u32 id;
+#define NVDLA_QUEUE_PRIORITY_DEFAULT	0U
+#define NVDLA_QUEUE_PRIORITY_HIGH	1U
+#define NVDLA_QUEUE_PRIORITY_NUM	2U
+	__u32 value;
+};
+
+/**
+ * Task timing ring
+ *
+ * The ring is mapped read-only with mmap() at offset 0 of the DLA fd and
+ * starts with struct nvdla_task_timing_header. The driver appends one
+ * record per completed task at records_offset + (head % num_records) *
+ * record_size and then increments head, so a reader that sees head move
+ * past a record can read it until head wraps back onto it.
+ *
+ * submit_time is sampled by the driver at submit, start_time and end_time
+ * come from the profiling notifier written by the firmware at the end of
+ * the task. All three are in TSC ticks, as reported by the job trace events.
+ */
+#define NVDLA_TASK_TIMING_VERSION	1U
+#define NVDLA_TASK_TIMING_MAX_RECORDS	4096U
+
+struct nvdla_task_timing_header {
+	__u32 version;
+	__u32 record_size;
+	__u32 num_records;
+	__u32 records_offset;
+	__u64 head;
+	__u8 reserved[40];
+};
+
+struct nvdla_task_timing_record {
+	__u32 task_id;
+	/* status reported by the firmware in the profiling notifier */
+	__u16 status;
+	__u8 reserved[2];
+	__u64 submit_time;
+	__u64 start_time;
+	__u64 end_time;
+};
+
 #define NVHOST_NVDLA_IOCTL_MAGIC 'D'
 
 #define NVDLA_IOCTL_PING		\
@@ -268,8 +325,10 @@ struct nvdla_status_notify {
 	_IO(NVHOST_NVDLA_IOCTL_MAGIC, 9)
 #define NVDLA_IOCTL_RELEASE_QUEUE \
 	_IO(NVHOST_NVDLA_IOCTL_MAGIC, 10)
+#define NVDLA_IOCTL_SET_QUEUE_ATTR \
+	_IOW(NVHOST_NVDLA_IOCTL_MAGIC, 11, struct nvdla_queue_attr_args)
 #define NVDLA_IOCTL_LAST		\
-		_IOC_NR(NVDLA_IOCTL_RELEASE_QUEUE)
+		_IOC_NR(NVDLA_IOCTL_SET_QUEUE_ATTR)
 
 #define NVDLA_IOCTL_MAX_ARG_SIZE  \
 		sizeof(struct nvdla_pin_unpin_args)
@@ -263,6 +263,29 @@ struct nvmap_fd_for_range_from_list {
 	__s32 fd; /* Sub range Dma Buf fd to be returned*/
 };
 
+/**
+ * Struct used while creating and allocating several identical handles
+ */
+struct nvmap_alloc_batch {
+	__u64 size;		/* size of each handle */
+	__u64 handles;		/* Ptr to u32 type array, receives the handles */
+	__u32 count;		/* Number of handles to create */
+	__u32 heap_mask;	/* heaps to allocate from */
+	__u32 flags;		/* wb/wc/uc/iwb etc. */
+	__u32 align;		/* min alignment necessary */
+	__s32 numa_nid;		/* NUMA node id */
+	__u32 reserved;
+};
+
+struct nvmap_sciipc_map_list {
+	__u64 auth_token;	/* AuthToken */
+	__u64 handles;		/* Ptr to u32 type array of nvmap handles */
+	__u64 sci_ipc_ids;	/* Ptr to u64 type array of sci_ipc ids */
+	__u32 flags;		/* Exporter permission flags */
+	__u32 count;		/* Number of entries, at most 64 */
+	__u32 reserved[2];
+};
+
 #define NVMAP_IOC_MAGIC 'N'
 
 /* Creates a new memory handle. On input, the argument is the size of the new
@@ -369,6 +392,21 @@ struct nvmap_fd_for_range_from_list {
 #define NVMAP_IOC_GET_FD_FOR_RANGE_FROM_LIST _IOR(NVMAP_IOC_MAGIC, 107, \
 		struct nvmap_fd_for_range_from_list)
 
-#define NVMAP_IOC_MAXNR (_IOC_NR(NVMAP_IOC_GET_FD_FOR_RANGE_FROM_LIST))
+/* Create, allocate and export count handles of the same size and attributes */
+#define NVMAP_IOC_ALLOC_BATCH _IOW(NVMAP_IOC_MAGIC, 108, \
+		struct nvmap_alloc_batch)
+
+/* Get SCI_IPC_IDs for a list of handles exported to one peer */
+#define NVMAP_IOC_GET_SCIIPCID_LIST _IOWR(NVMAP_IOC_MAGIC, 109, \
+		struct nvmap_sciipc_map_list)
+
+/*
+ * Get Nvmap handles from a list of SCI_IPC_IDs, count returns the number of
+ * handles imported
+ */
+#define NVMAP_IOC_HANDLE_FROM_SCIIPCID_LIST _IOWR(NVMAP_IOC_MAGIC, 110, \
+		struct nvmap_sciipc_map_list)
+
+#define NVMAP_IOC_MAXNR (_IOC_NR(NVMAP_IOC_HANDLE_FROM_SCIIPCID_LIST))
 
 #endif /* __UAPI_LINUX_NVMAP_H */
@@ -23,7 +23,7 @@ struct nvpps_version {
 #define NVPPS_VERSION_MAJOR	0
 #define NVPPS_VERSION_MINOR	2
 #define NVPPS_API_MAJOR		0
-#define NVPPS_API_MINOR         4
+#define NVPPS_API_MINOR         5
 
 struct nvpps_params {
 	__u32	evt_mode;
@@ -68,6 +68,47 @@ struct nvpps_timestamp_struct {
 	__u64		extra[2];
 };
 
+/*
+ * History of the last NVPPS_RING_EVENTS PPS events, mapped read-only by
+ * mmap() of the device at offset 0, so time-sync daemons can read every
+ * event without a syscall.
+ *
+ * head counts the events written so far, the latest one is at
+ * events[(head - 1) % NVPPS_RING_EVENTS]. Each entry is protected by its
+ * own sequence count, odd while the entry is being written:
+ *
+ *	do {
+ *		seq = load_acquire(&ev->seq);
+ *		copy = *ev;
+ *		rmb();
+ *	} while ((seq & 1) || seq != ev->seq);
+ *
+ * An entry whose evt_nb is newer than expected was overwritten because the
+ * reader fell behind by a full ring. tsc is in the units of
+ * NVPPS_TSC_COUNTER, see tsc_res_ns; sys_ns is CLOCK_REALTIME when the
+ * event was processed.
+ */
+#define NVPPS_RING_EVENTS	64
+
+struct nvpps_ring_event {
+	__u32	seq;
+	__u32	evt_nb;
+	__u32	evt_mode;
+	__u32	reserved;
+	__u64	tsc;
+	__u64	ptp;
+	__u64	secondary_ptp;
+	__u64	irq_latency;
+	__u64	sys_ns;
+};
+
+struct nvpps_ring {
+	__u32	num_events;
+	__u32	reserved;
+	__u64	tsc_res_ns;
+	__u64	head;
+	struct nvpps_ring_event events[NVPPS_RING_EVENTS];
+};
 
 #define NVPPS_GETVERSION	_IOR('p', 0x1, struct nvpps_version *)
 #define NVPPS_GETPARAMS		_IOR('p', 0x2, struct nvpps_params *)
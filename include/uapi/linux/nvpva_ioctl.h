@@ -213,7 +213,21 @@ enum nvpva_flags {
 	NVPVA_ERR_MASK_ILLEGAL_INSTR = 1U << 3U,
 	NVPVA_ERR_MASK_DIVIDE_BY_0 = 1U << 4U,
 	NVPVA_ERR_MASK_FP_NAN = 1U << 5U,
-	NVPVA_GR_CHECK_EXE_FLAG = 1U << 6U
+	NVPVA_GR_CHECK_EXE_FLAG = 1U << 6U,
+	/*
+	 * dma_descriptors.addr of the task is the config_id of a DMA config
+	 * registered with NVPVA_IOCTL_REGISTER_DMA_CONFIG, used instead of
+	 * descriptors copied from userspace. dma_descriptors.size is ignored.
+	 */
+	NVPVA_DMA_CONFIG_ID = 1U << 7U,
+	/*
+	 * The L2SRAM contents of a producer task are kept for the next
+	 * consumer task of the same submit, which reads them through its
+	 * L2RAM descriptors instead of a round trip through DRAM. Both need
+	 * a non-zero l2_alloc_size, tasks in between may have none.
+	 */
+	NVPVA_L2SRAM_PRODUCER = 1U << 8U,
+	NVPVA_L2SRAM_CONSUMER = 1U << 9U
 };
 
 enum nvpva_fence_action_type {
@@ -524,6 +538,99 @@ union nvpva_set_vpu_print_buffer_size_args {
 	struct nvpva_set_vpu_print_buffer_size_in_arg in;
 };
 
+/**
+ * Per-queue task timing ring
+ *
+ * Once NVPVA_IOCTL_SET_TASK_TIMING_RING_SIZE has been issued on a file
+ * descriptor, the driver appends one nvpva_task_timing_record for every
+ * task of that queue that completes. The ring is read by mmap()ing the
+ * file descriptor at offset 0; it starts with a nvpva_task_timing_header
+ * followed by num_records records at records_offset.
+ *
+ * head counts the records written so far. Record n is stored at index
+ * n % num_records and is complete once head > n. Readers should load head,
+ * copy the records they need and load head again; records older than
+ * head - num_records at that point may have been overwritten.
+ *
+ * All timestamps are in TSC ticks.
+ */
+#define NVPVA_TASK_TIMING_VERSION 1U
+#define NVPVA_TASK_TIMING_MAX_RECORDS (64U * 1024U)
+
+struct nvpva_task_timing_header {
+	uint32_t version;
+	uint32_t record_size;
+	uint32_t num_records;
+	uint32_t records_offset;
+	uint64_t head;
+	uint8_t reserved[40];
+};
+
+struct nvpva_task_timing_record {
+	uint32_t task_id;
+	uint8_t queue_id;
+	uint8_t vpu;
+	uint8_t reserved[2];
+	uint64_t prog_id;
+	uint64_t stream_id;
+	/* Time when the task was queued by KMD */
+	uint64_t queued_time;
+	/* Time when the task reached the head of the FW queue */
+	uint64_t head_time;
+	/* Time when prefences and input actions were done */
+	uint64_t input_actions_complete;
+	/* Time when the task was assigned a VPU */
+	uint64_t vpu_assigned_time;
+	/* Time when the VPU started and completed execution */
+	uint64_t vpu_start_time;
+	uint64_t vpu_complete_time;
+	/* Time when the task including output actions completed */
+	uint64_t complete_time;
+};
+
+struct nvpva_set_task_timing_ring_size_in_arg {
+	/* Number of records, power of two, 0 < num_records <= MAX_RECORDS */
+	uint32_t num_records;
+};
+
+union nvpva_set_task_timing_ring_size_args {
+	struct nvpva_set_task_timing_ring_size_in_arg in;
+};
+
+/**
+ * Registered DMA configs
+ *
+ * NVPVA_IOCTL_REGISTER_DMA_CONFIG validates an array of nvpva_dma_descriptor
+ * once and returns a config_id for it. Tasks submitted on the same file
+ * descriptor with NVPVA_DMA_CONFIG_ID reference it instead of passing the
+ * descriptors again, so only the buffer addresses of the descriptors are
+ * resolved and checked per task. A file descriptor holds up to
+ * NVPVA_MAX_DMA_CONFIGS configs.
+ */
+#define NVPVA_MAX_DMA_CONFIGS 16U
+
+struct nvpva_dma_config_register_in_arg {
+	struct nvpva_ioctl_part dma_descriptors;
+};
+
+struct nvpva_dma_config_register_out_arg {
+	/* Id assigned by KMD for the config, never 0 */
+	uint32_t config_id;
+};
+
+union nvpva_dma_config_register_args {
+	struct nvpva_dma_config_register_in_arg in;
+	struct nvpva_dma_config_register_out_arg out;
+};
+
+struct nvpva_dma_config_unregister_in_arg {
+	uint32_t config_id;
+};
+
+union nvpva_dma_config_unregister_args {
+	struct nvpva_dma_config_unregister_in_arg in;
+};
+
 /**
  * There are 64 DMA descriptors in T19x. But R5 FW reserves
  * 4 DMA descriptors for internal use.
@@ -595,7 +702,16 @@ union nvpva_set_vpu_print_buffer_size_args {
 #define NVPVA_IOCTL_PIN_EX \
 	_IOWR(NVPVA_IOCTL_MAGIC, 12, union nvpva_pin_args_ex)
 
-#define NVPVA_IOCTL_NUMBER_MAX 12
+#define NVPVA_IOCTL_SET_TASK_TIMING_RING_SIZE \
+	_IOW(NVPVA_IOCTL_MAGIC, 13, union nvpva_set_task_timing_ring_size_args)
+
+#define NVPVA_IOCTL_REGISTER_DMA_CONFIG \
+	_IOWR(NVPVA_IOCTL_MAGIC, 14, union nvpva_dma_config_register_args)
+
+#define NVPVA_IOCTL_UNREGISTER_DMA_CONFIG \
+	_IOW(NVPVA_IOCTL_MAGIC, 15, union nvpva_dma_config_unregister_args)
+
+#define NVPVA_IOCTL_NUMBER_MAX 15
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #define NVPVA_IOCTL_MAX_SIZE                                 \
@@ -607,7 +723,10 @@ union nvpva_set_vpu_print_buffer_size_args {
 	    MAX(sizeof(union nvpva_ioctl_submit_args), \
 	    MAX(sizeof(union nvpva_get_sym_tab_args), \
 	    MAX(sizeof(union nvpva_set_vpu_print_buffer_size_args), \
-	    0))))))))
+	    MAX(sizeof(union nvpva_set_task_timing_ring_size_args), \
+	    MAX(sizeof(union nvpva_dma_config_register_args), \
+	    MAX(sizeof(union nvpva_dma_config_unregister_args), \
+	    0)))))))))))
 
 /* NvPva Task param limits */
 #define NVPVA_TASK_MAX_PREFENCES 8U
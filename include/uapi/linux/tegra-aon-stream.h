@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#ifndef __UAPI_TEGRA_AON_STREAM_H__
+#define __UAPI_TEGRA_AON_STREAM_H__
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/*
+ * Zero-copy streaming from SPE over an AON IVC channel marked with
+ * nvidia,stream in DT, exported by /dev/aon_<channel>.
+ *
+ * The rx queue of the channel is mapped read-only with mmap() at offset 0,
+ * frame i starts at frames_offset + i * frame_size of the mapping.
+ * TEGRA_AON_STREAM_ACQUIRE returns the frames received and not yet
+ * released, starting at the current read position; the window never
+ * wraps past the last frame, so a second ACQUIRE after a RELEASE may be
+ * needed to reach frames at the start of the queue. The frames stay valid
+ * until TEGRA_AON_STREAM_RELEASE hands the given number of frames, oldest
+ * first, back to SPE. poll() reports EPOLLIN while frames are available.
+ *
+ * Only one file may be open at a time.
+ */
+struct tegra_aon_stream_info {
+	__u32 frame_size;
+	__u32 nframes;
+	__u32 frames_offset;
+	__u32 map_size;
+};
+
+struct tegra_aon_stream_frames {
+	__u32 index;	/* out: first frame */
+	__u32 count;	/* in: max frames, out: frames available */
+};
+
+#define TEGRA_AON_STREAM_IOC_MAGIC	'O'
+#define TEGRA_AON_STREAM_GET_INFO	_IOR(TEGRA_AON_STREAM_IOC_MAGIC, 1, \
+					     struct tegra_aon_stream_info)
+#define TEGRA_AON_STREAM_ACQUIRE	_IOWR(TEGRA_AON_STREAM_IOC_MAGIC, 2, \
+					      struct tegra_aon_stream_frames)
+#define TEGRA_AON_STREAM_RELEASE	_IOW(TEGRA_AON_STREAM_IOC_MAGIC, 3, \
+					     __u32)
+
+#endif /* __UAPI_TEGRA_AON_STREAM_H__ */
@@ -0,0 +1,74 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#ifndef __UAPI_TEGRA_DCE_PERF_H__
+#define __UAPI_TEGRA_DCE_PERF_H__
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/*
+ * Binary perf stream of the DCE driver, exported by /dev/tegra_dce_perf.
+ *
+ * TEGRA_DCE_PERF_START starts recording into a ring of records, read()
+ * returns whole records and poll() reports EPOLLIN while the ring is not
+ * empty. Records are:
+ *
+ * TEGRA_DCE_PERF_REC_RPC: one per completed client rpc, with the time from
+ *  submission to completion and the number of rpcs of the client pending or
+ *  in flight when it was submitted. id is the DCE_CLIENT_IPC_TYPE_*.
+ *
+ * TEGRA_DCE_PERF_REC_FW_EVENT: the event counters of DCE fw, sampled every
+ *  fw_period_ms. Counters are cumulative since they were last cleared. id is
+ *  the fw event index.
+ *
+ * TEGRA_DCE_PERF_REC_LOST: records dropped while the ring was full.
+ *
+ * Only one file may be open at a time. Recording stops on STOP or close.
+ */
+#define TEGRA_DCE_PERF_REC_RPC		1U
+#define TEGRA_DCE_PERF_REC_FW_EVENT	2U
+#define TEGRA_DCE_PERF_REC_LOST		3U
+
+#define TEGRA_DCE_PERF_EVENT_NAME_LEN	32U
+
+struct tegra_dce_perf_rpc {
+	__u32 seq;
+	__u32 queue_depth;
+	__u64 latency_ns;
+	__s32 status;
+	__u32 reserved;
+};
+
+struct tegra_dce_perf_fw_event {
+	char name[TEGRA_DCE_PERF_EVENT_NAME_LEN];
+	__u64 accumulate;
+	__u64 iterations;
+	__u64 min;
+	__u64 max;
+};
+
+struct tegra_dce_perf_record {
+	__u32 type;
+	__u32 id;
+	__u64 tstamp_ns;	/* CLOCK_MONOTONIC */
+	union {
+		struct tegra_dce_perf_rpc rpc;
+		struct tegra_dce_perf_fw_event fw_event;
+		__u64 lost;
+	};
+};
+
+struct tegra_dce_perf_cfg {
+	__u32 fw_period_ms;	/* 0 to not sample fw events */
+	__u32 fw_events;	/* fw event enable mask, 0 to keep the current */
+};
+
+#define TEGRA_DCE_PERF_IOC_MAGIC	'D'
+#define TEGRA_DCE_PERF_START	_IOW(TEGRA_DCE_PERF_IOC_MAGIC, 1, \
+				     struct tegra_dce_perf_cfg)
+#define TEGRA_DCE_PERF_STOP	_IO(TEGRA_DCE_PERF_IOC_MAGIC, 2)
+
+#endif /* __UAPI_TEGRA_DCE_PERF_H__ */
@@ -37,6 +37,9 @@ struct tegra_gte_hts_event_req {
  * struct hts_event_data - event data
  * @timestamp: hardware timestamp in nanosecond
  * @dir: direction of the event
+ *
+ * read() on the event file returns as many whole events as are pending
+ * and fit in the buffer, so high-rate inputs can be drained in batches.
  */
 
 struct tegra_gte_hts_event_data {
@@ -39,7 +39,36 @@ struct nvipc_ivc_info {
 #define NVIPC_IVC_IOCTL_GET_VMID \
 	_IOR(NVIPC_IVC_IOCTL_MAGIC, 3, uint32_t)
 
-#define NVIPC_IVC_IOCTL_NUMBER_MAX 3
+/*
+ * register an eventfd that is signalled on every ivc interrupt, or pass -1
+ * to unregister it. While an eventfd is registered the interrupt is reported
+ * only through the eventfd and poll() on the ivc device does not see it.
+ */
+#define NVIPC_IVC_IOCTL_SET_EVENTFD \
+	_IOW(NVIPC_IVC_IOCTL_MAGIC, 4, int32_t)
+
+/* notify remote unconditionally, regardless of the queue state */
+#define NVIPC_IVC_DOORBELL_FORCE (1U << 0)
+
+/*
+ * Batched doorbell for the mmap()ed queues. Userspace writes and releases
+ * frames directly in the shared area and reports how many it produced and
+ * consumed since its last doorbell. The remote is only notified when it may
+ * have observed an empty tx queue or a full rx queue, so one doorbell covers
+ * any number of frames.
+ */
+struct nvipc_ivc_doorbell {
+	uint32_t tx_frames; /* frames written to tx since last doorbell */
+	uint32_t rx_frames; /* frames released from rx since last doorbell */
+	uint32_t flags;     /* NVIPC_IVC_DOORBELL_* */
+	uint32_t notified;  /* out: 1 if the remote was notified */
+};
+
+/* notify remote for a batch of frames */
+#define NVIPC_IVC_IOCTL_DOORBELL \
+	_IOWR(NVIPC_IVC_IOCTL_MAGIC, 5, struct nvipc_ivc_doorbell)
+
+#define NVIPC_IVC_IOCTL_NUMBER_MAX 5
 
 int ivc_cdev_get_peer_vmid(uint32_t qid, uint32_t *peer_vmid);
 int ivc_cdev_get_noti_type(uint32_t qid, uint32_t *noti_type);
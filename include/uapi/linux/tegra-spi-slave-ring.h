@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ */
+
+#ifndef __UAPI_TEGRA_SPI_SLAVE_RING_H__
+#define __UAPI_TEGRA_SPI_SLAVE_RING_H__
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+/*
+ * Continuous Rx mode of the Tegra SPI slave controller, exported by
+ * /dev/spi<bus>_rxring.
+ *
+ * TEGRA_SPI_SLAVE_RING_START binds the ring to the slave device at
+ * chip_select (its mode, bits-per-word and max frequency are used) and
+ * keeps the controller armed for back-to-back frames of frame_len bytes.
+ * The DMA engine writes each frame straight into a ring slot, so frames
+ * are never copied. The controller is re-armed for the next frame from
+ * the frame-end interrupt, and the slave-ready GPIO, if any, is asserted
+ * only while the controller is armed.
+ *
+ * The ring memory is allocated by the first START on an open file and
+ * mapped with mmap() at offset 0 afterwards; its geometry cannot change
+ * until the file is closed. Only one file may be open at a time. Regular
+ * spi_message transfers fail with -EBUSY while the ring runs.
+ *
+ * The header sits at offset 0, the frame descriptors at descs_offset and
+ * the frame data at data_offset + idx * frame_stride. The driver owns head
+ * and userspace owns tail; both are free running and wrap at 2^32, a slot
+ * index is (idx & (num_frames - 1)). Userspace must read head with acquire
+ * semantics and publish tail with release semantics. Frames arriving while
+ * the ring is full are counted in dropped and discarded.
+ *
+ * poll() reports EPOLLIN once head != tail, and EPOLLERR when a FIFO
+ * error or a short frame stopped the controller. The ring then has to be
+ * restarted with STOP and START.
+ */
+#define TEGRA_SPI_SLAVE_RING_MAGIC		0x53525852	/* "SRXR" */
+#define TEGRA_SPI_SLAVE_RING_VERSION		1
+
+#define TEGRA_SPI_SLAVE_RING_MAX_FRAMES		1024
+
+/* tegra_spi_slave_ring_hdr.status */
+#define TEGRA_SPI_SLAVE_RING_ST_RUNNING		(1U << 0)
+#define TEGRA_SPI_SLAVE_RING_ST_ERROR		(1U << 1)
+
+struct tegra_spi_slave_ring_cfg {
+	__u32 frame_len;	/* bytes per frame, multiple of 4 */
+	__u32 num_frames;	/* power of two, 2 to MAX_FRAMES */
+	__u32 speed_hz;		/* bus clock, 0 for the device max */
+	__u8 chip_select;
+	__u8 reserved[3];	/* must be zero */
+};
+
+struct tegra_spi_slave_ring_hdr {
+	__u32 magic;
+	__u32 version;
+	__u32 frame_len;
+	__u32 frame_stride;
+	__u32 num_frames;
+	__u32 descs_offset;
+	__u32 data_offset;
+	__u32 status;
+	__u32 head;		/* written by the driver */
+	__u32 tail;		/* written by userspace */
+	__u32 dropped;		/* frames lost on a full ring */
+	__u32 reserved;
+};
+
+struct tegra_spi_slave_ring_desc {
+	__u64 tstamp_ns;	/* CLOCK_MONOTONIC at the frame-end interrupt */
+	__u32 len;		/* bytes received */
+	__u32 reserved;
+};
+
+#define TEGRA_SPI_SLAVE_RING_IOC_MAGIC	'k'
+#define TEGRA_SPI_SLAVE_RING_START	_IOW(TEGRA_SPI_SLAVE_RING_IOC_MAGIC, \
+					0x40, struct tegra_spi_slave_ring_cfg)
+#define TEGRA_SPI_SLAVE_RING_STOP	_IO(TEGRA_SPI_SLAVE_RING_IOC_MAGIC, 0x41)
+
+#endif /* __UAPI_TEGRA_SPI_SLAVE_RING_H__ */
@@ -10,6 +10,7 @@
 
 #define VCPU_YIELD_IOC_MAGIC    'Y'
 #define VCPU_YIELD_START_CMDID  1
+#define VCPU_YIELD_START_ADAPTIVE_CMDID  2
 
 /* Control data for VCPU Yield Start ioctl */
 struct vcpu_yield_start_ctl {
@@ -20,4 +21,12 @@ struct vcpu_yield_start_ctl {
 #define VCPU_YIELD_START_IOCTL _IOW(VCPU_YIELD_IOC_MAGIC, \
 		VCPU_YIELD_START_CMDID, struct vcpu_yield_start_ctl)
 
+/*
+ * Adaptive VCPU Yield Start ioctl: the VCPU is yielded for at most
+ * timeout_us, shortened to the wakeup latency measured for the low prio
+ * VM on earlier yields (see the adaptive_* attributes of the device).
+ */
+#define VCPU_YIELD_START_ADAPTIVE_IOCTL _IOW(VCPU_YIELD_IOC_MAGIC, \
+		VCPU_YIELD_START_ADAPTIVE_CMDID, struct vcpu_yield_start_ctl)
+
 #endif /* #ifndef _UAPI_TEGRA_HV_VCPU_YIELD_IOCTL_H_ */
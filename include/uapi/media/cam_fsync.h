@@ -6,7 +6,38 @@
 #ifndef __CAM_FSYNC_H__
 #define __CAM_FSYNC_H__
 
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
 #define CAM_FSYNC_GRP_ABS_START_VAL \
 	_IOW('T', 1, uint64_t)
 
+/* Max. number of generators described by a group schedule */
+#define CAM_FSYNC_SCHEDULE_MAX_GENERATORS	8
+
+/*
+ * Edge schedule of one generator in TSC ticks. Rising edge n occurs at
+ * start_ticks + n * period_ticks, the signal then stays high for
+ * active_ticks.
+ */
+struct cam_fsync_generator_schedule {
+	__u64 start_ticks;
+	__u32 period_ticks;
+	__u32 active_ticks;
+};
+
+/*
+ * Read-only schedule of a generator group, mapped with mmap() of one page
+ * at offset 0 of the group node. seq is odd while the schedule is being
+ * rewritten; readers retry while seq is odd or changes across the read.
+ * num_generators is 0 while the group is stopped.
+ */
+struct cam_fsync_group_schedule {
+	__u32 seq;
+	__u32 num_generators;
+	__u64 tsc_hz;
+	struct cam_fsync_generator_schedule
+		generators[CAM_FSYNC_SCHEDULE_MAX_GENERATORS];
+};
+
 #endif
@@ -12,6 +12,7 @@
 #define CDI_DEV_IOCTL_RW	          _IOW('o', 1, struct cdi_dev_package)
 #define CDI_DEV_IOCTL_GET_PWR_INFO    _IOW('o', 2, struct cdi_dev_pwr_ctrl_info)
 #define CDI_DEV_IOCTL_FRSYNC_MUX      _IOW('o', 3, struct cdi_dev_fsync_mux)
+#define CDI_DEV_IOCTL_RW_VEC          _IOW('o', 4, struct cdi_dev_package_vec)
 
 #define DES_PWR_NVCCP    0U
 #define DES_PWR_GPIO     1U
@@ -42,4 +43,18 @@ struct __attribute__ ((__packed__)) cdi_dev_package {
 	unsigned long buffer;
 };
 
+/* maximum number of packages in one CDI_DEV_IOCTL_RW_VEC call */
+#define CDI_DEV_VEC_MAX_PKGS	256U
+
+/*
+ * Vector of packages executed as a single I2C transfer, in order.
+ * pkgs points to an array of num_pkgs struct cdi_dev_package; the
+ * transfer stops at the first NAK and no read data is returned.
+ */
+struct cdi_dev_package_vec {
+	__u32 num_pkgs;
+	__u32 reserved;
+	__u64 pkgs;
+};
+
 #endif  /* __UAPI_CDI_DEV_H__ */
@@ -12,6 +12,7 @@
 #define ISC_DEV_PKG_FLAG_WR	1
 
 #define ISC_DEV_IOCTL_RW	_IOW('o', 1, struct isc_dev_package)
+#define ISC_DEV_IOCTL_RW_VEC	_IOW('o', 2, struct isc_dev_package_vec)
 
 struct __attribute__ ((__packed__)) isc_dev_package {
 	__u16 offset;
@@ -21,4 +22,18 @@ struct __attribute__ ((__packed__)) isc_dev_package {
 	unsigned long buffer;
 };
 
+/* maximum number of packages in one ISC_DEV_IOCTL_RW_VEC call */
+#define ISC_DEV_VEC_MAX_PKGS	256U
+
+/*
+ * Vector of packages executed as a single I2C transfer, in order.
+ * pkgs points to an array of num_pkgs struct isc_dev_package; the
+ * transfer stops at the first NAK and no read data is returned.
+ */
+struct isc_dev_package_vec {
+	__u32 num_pkgs;
+	__u32 reserved;
+	__u64 pkgs;
+};
+
 #endif  /* __UAPI_ISC_DEV_H__ */
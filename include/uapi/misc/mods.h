@@ -8,7 +8,7 @@
 
 /* Driver version */
 #define MODS_DRIVER_VERSION_MAJOR 4
-#define MODS_DRIVER_VERSION_MINOR 22
+#define MODS_DRIVER_VERSION_MINOR 23
 #define MODS_DRIVER_VERSION ((MODS_DRIVER_VERSION_MAJOR << 8) | \
 			     ((MODS_DRIVER_VERSION_MINOR / 10) << 4) | \
 			     (MODS_DRIVER_VERSION_MINOR % 10))
@@ -1682,6 +1682,46 @@ struct MODS_DMA_TX_DESC	{
 	__s32 cookie;
 };
 
+#define MODS_DMA_MAX_SG_ENTRIES 64
+
+struct MODS_DMA_SG_ENTRY {
+	__u64 phys;
+	__u64 phys_2; /* only valid for MEMCPY */
+	__u32 length;
+	__u32 reserved;
+};
+
+/* Issue the transfers and wait for them in the ioctl */
+#define MODS_DMA_SG_FLAG_WAIT 1
+
+/* Used by MODS_ESC_DMA_TX_SUBMIT_SG ioctl.
+ *
+ * Submits num_entries transfers in one call.  Slave transfers are submitted
+ * as a single scatter-gather descriptor, MEMCPY transfers as one descriptor
+ * per entry with only the last one interrupting.  cookie is the cookie of
+ * the last descriptor and can be passed to MODS_ESC_DMA_TX_WAIT.
+ *
+ * With MODS_DMA_SG_FLAG_WAIT the transfers are also issued and waited for,
+ * for up to timeout_ms (0 for 1s), and transfer_ns is the time from issuing
+ * them to the completion of the last one.  submit_ns is the time taken to
+ * prepare and submit the descriptors.
+ *
+ * Available only on Tegra.
+ */
+struct MODS_DMA_TX_SG_DESC {
+	/* IN */
+	struct MODS_DMA_SG_ENTRY entries[MODS_DMA_MAX_SG_ENTRIES];
+	struct MODS_DMA_HANDLE handle;
+	__u32 data_dir;
+	__u32 num_entries;
+	__u32 flags;
+	__u32 timeout_ms;
+	/* OUT */
+	__u64 submit_ns;
+	__u64 transfer_ns;
+	__s32 cookie;
+};
+
 enum MODS_DMA_WAIT_TYPE {
 	MODS_DMA_SYNC_WAIT,     /* wait until finished */
 	MODS_DMA_ASYNC_WAIT     /* just check tx status */
@@ -2164,5 +2204,6 @@ struct MODS_IDLE {
 #define MODS_ESC_BPMP_UPHY_LANE_EOM_SCAN MODSIO(WR, 146, \
 						MODS_BPMP_UPHY_LANE_EOM_SCAN_PARAMS)
 #define MODS_ESC_IDLE MODSIO(W, 147, MODS_IDLE)
+#define MODS_ESC_DMA_TX_SUBMIT_SG MODSIO(WR, 148, MODS_DMA_TX_SG_DESC)
 
 #endif /* _UAPI_MODS_H_  */
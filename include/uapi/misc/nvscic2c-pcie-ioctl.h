@@ -111,6 +111,22 @@ struct nvscic2c_pcie_map_obj_args {
 	struct nvscic2c_pcie_map_out_arg out;
 };
 
+/**
+ * stream extensions - Map a batch of Mem/Sync objects.
+ *
+ * @num_objs: number of entries in @objs.
+ *
+ * @objs: user memory atleast of size:
+ *  num_objs * sizeof(struct nvscic2c_pcie_map_obj_args)
+ *
+ * Each entry is mapped as with NVSCIC2C_PCIE_IOCTL_MAP and its out.handle
+ * written back to @objs. On failure, none of the entries remain mapped.
+ */
+struct nvscic2c_pcie_map_batch_args {
+	__u64 num_objs;
+	__u64 objs;
+};
+
 /**
  * stream extensions - Export.
  */
@@ -187,6 +203,24 @@ struct nvscic2c_pcie_submit_copy_args {
 	__u64 remote_post_fence_values;
 };
 
+/**
+ * stream extensions - Submit a batch of copy requests as one eDMA transfer.
+ *
+ * @num_copy_requests: number of copy requests in @copy_requests, shall not
+ *  exceed @max_copy_requests of @nvscic2c_pcie_max_copy_args.
+ *
+ * @copy_requests: user memory atleast of size:
+ *  num_copy_requests * sizeof(struct nvscic2c_pcie_submit_copy_args)
+ *
+ * The flush ranges of all the copy requests are chained into a single eDMA
+ * transfer. Once it completes, post-fences of each copy request are
+ * signalled in submission order.
+ */
+struct nvscic2c_pcie_submit_copy_batch_args {
+	__u64 num_copy_requests;
+	__u64 copy_requests;
+};
+
 /**
  * stream extensions - Pass upper limit for the total possible outstanding
  * submit copy requests.
@@ -202,15 +236,30 @@ struct nvscic2c_pcie_max_copy_args {
 	__u64 max_post_fences;
 };
 
+/*
+ * Busy-poll the notifications from peer.
+ * @timeout_us: A blocking poll() on the endpoint spins for up to these many
+ *  microseconds on the endpoint syncpoint value for a notification from peer
+ *  before it sleeps. 0, the default on open(), disables spinning. Shall not
+ *  exceed NVSCIC2C_PCIE_MAX_BUSY_POLL_US.
+ */
+#define NVSCIC2C_PCIE_MAX_BUSY_POLL_US	(1000U)
+struct nvscic2c_pcie_busy_poll_args {
+	__u32 timeout_us;
+};
+
 /* Only to facilitate calculation of maximum size of ioctl arguments.*/
 union nvscic2c_pcie_ioctl_arg_max_size {
 	struct nvscic2c_pcie_max_copy_args mc;
 	struct nvscic2c_pcie_submit_copy_args cr;
+	struct nvscic2c_pcie_submit_copy_batch_args cb;
 	struct nvscic2c_pcie_free_obj_args fo;
 	struct nvscic2c_pcie_import_obj_args io;
 	struct nvscic2c_pcie_export_obj_args eo;
 	struct nvscic2c_pcie_map_obj_args mp;
+	struct nvscic2c_pcie_map_batch_args mb;
 	struct nvscic2c_pcie_endpoint_info ep;
+	struct nvscic2c_pcie_busy_poll_args bp;
 };
 
 /* IOCTL magic number - seen available in ioctl-number.txt*/
@@ -268,6 +317,27 @@ union nvscic2c_pcie_ioctl_arg_max_size {
 	_IOW(NVSCIC2C_PCIE_IOCTL_MAGIC, 8,\
 	      struct nvscic2c_pcie_max_copy_args)
 
-#define NVSCIC2C_PCIE_IOCTL_NUMBER_MAX 8
+/**
+ * Submit a batch of Copy requests for transfer.
+ */
+#define NVSCIC2C_PCIE_IOCTL_SUBMIT_COPY_BATCH \
+	_IOW(NVSCIC2C_PCIE_IOCTL_MAGIC, 9,\
+	      struct nvscic2c_pcie_submit_copy_batch_args)
+
+/**
+ * Map a batch of Local or Remote Mem/Sync objects.
+ */
+#define NVSCIC2C_PCIE_IOCTL_MAP_BATCH \
+	_IOW(NVSCIC2C_PCIE_IOCTL_MAGIC, 10,\
+	      struct nvscic2c_pcie_map_batch_args)
+
+/**
+ * Set the busy-poll window of poll() for notifications from peer.
+ */
+#define NVSCIC2C_PCIE_IOCTL_SET_BUSY_POLL \
+	_IOW(NVSCIC2C_PCIE_IOCTL_MAGIC, 11,\
+	      struct nvscic2c_pcie_busy_poll_args)
+
+#define NVSCIC2C_PCIE_IOCTL_NUMBER_MAX 11
 
 #endif /*__UAPI_NVSCIC2C_PCIE_IOCTL_H__*/
@@ -27,6 +27,7 @@
 #define TEGRA_NVVSE_CMDID_GET_IVC_DB			12
 #define TEGRA_NVVSE_CMDID_TSEC_SIGN_VERIFY		13
 #define TEGRA_NVVSE_CMDID_TSEC_GET_KEYLOAD_STATUS	14
+#define TEGRA_NVVSE_CMDID_BATCH				15
 
 /** Defines the length of the AES-CBC Initial Vector */
 #define TEGRA_NVVSE_AES_IV_LEN				16U
@@ -412,5 +413,68 @@ struct tegra_nvvse_aes_drng_ctl {
 #define NVVSE_IOCTL_CMDID_AES_DRNG _IOWR(TEGRA_NVVSE_IOC_MAGIC, TEGRA_NVVSE_CMDID_AES_DRNG, \
 						struct tegra_nvvse_aes_drng_ctl)
 
-#endif
+/**
+ * \brief Defines the maximum number of jobs in one batch request
+ */
+#define TEGRA_NVVSE_BATCH_MAX_JOBS	64U
+
+/**
+ * \brief Defines the job types supported by the batch request
+ */
+enum tegra_nvvse_batch_job_type {
+	/** Defines a one shot SHA digest job */
+	TEGRA_NVVSE_BATCH_JOB_SHA = 0u,
+	/** Defines a one shot AES CMAC sign job */
+	TEGRA_NVVSE_BATCH_JOB_CMAC_SIGN,
+	/** Defines a one shot AES CMAC verify job */
+	TEGRA_NVVSE_BATCH_JOB_CMAC_VERIFY,
+	/** Defines the maximum job type */
+	TEGRA_NVVSE_BATCH_JOB_MAX,
+};
+
+/**
+ * \brief Holds one job of a batch request
+ */
+struct tegra_nvvse_batch_job {
+	/** [in] Holds the enum which indicates the job type */
+	enum tegra_nvvse_batch_job_type job_type;
+	/** [in] Holds the enum which indicates SHA mode, used by SHA jobs only */
+	enum tegra_nvvse_sha_type sha_type;
+	/** [in] Holds a keyslot handle, used by CMAC jobs only */
+	uint8_t key_slot[KEYSLOT_SIZE_BYTES];
+	/** [in] Holds the Key length, used by CMAC jobs only
+	 * Supported keylength is only 16 bytes and 32 bytes
+	 */
+	uint8_t key_length;
+	/** [in] Holds the Length of the input source buffer */
+	uint32_t data_length;
+	/** [in] Holds a pointer to the input source buffer */
+	uint8_t *src_buffer;
+	/** [in] Holds the digest size. Only used for SHAKE128/SHAKE256 and
+	 * limited to 256 bytes for batched jobs.
+	 */
+	uint32_t digest_size;
+	/** [inout] Holds a pointer to the digest or CMAC signature buffer.
+	 * Written by the driver for SHA and CMAC sign jobs, provided by the
+	 * client for CMAC verify jobs.
+	 */
+	uint8_t *digest_buffer;
+	/** [out] Holds the job status, 0 on success or a negative error code */
+	int32_t status;
+	/** [out] Holds the CMAC verify result, 0 indicates a match */
+	uint8_t result;
+};
 
+/**
+ * \brief Holds a batch of independent SHA/CMAC jobs executed by one IO control
+ */
+struct tegra_nvvse_batch_ctl {
+	/** [in] Holds the number of entries in jobs, at most TEGRA_NVVSE_BATCH_MAX_JOBS */
+	uint32_t num_jobs;
+	/** [inout] Holds a pointer to the array of jobs */
+	struct tegra_nvvse_batch_job *jobs;
+};
+#define NVVSE_IOCTL_CMDID_BATCH _IOWR(TEGRA_NVVSE_IOC_MAGIC, TEGRA_NVVSE_CMDID_BATCH, \
+						struct tegra_nvvse_batch_ctl)
+
+#endif
@@ -6225,6 +6225,25 @@ compile_test() {
             compile_check_conftest "$CODE" "NV_VM_AREA_STRUCT_HAS_CONST_VM_FLAGS" "" "types"
         ;;
 
+        vmf_insert_pfn_pmd_has_pfn_t_arg)
+            #
+            # Determine if the function vmf_insert_pfn_pmd() takes a
+            # 'pfn_t' argument.
+            #
+            # The 'pfn_t' type was removed and vmf_insert_pfn_pmd() changed
+            # to take an 'unsigned long' pfn in v6.17.
+            #
+            CODE="
+            #include <linux/huge_mm.h>
+            #include <linux/pfn_t.h>
+            vm_fault_t conftest_vmf_insert_pfn_pmd_has_pfn_t_arg(
+                    struct vm_fault *vmf, pfn_t pfn) {
+                return vmf_insert_pfn_pmd(vmf, pfn, false);
+            }"
+
+            compile_check_conftest "$CODE" "NV_VMF_INSERT_PFN_PMD_HAS_PFN_T_ARG" "" "functions"
+        ;;
+
         drm_driver_has_dumb_destroy)
             #
             # Determine if the 'drm_driver' structure has a 'dumb_destroy'
@@ -6523,6 +6542,67 @@ compile_test() {
             compile_check_conftest "$CODE" "NV_BLK_MQ_DESTROY_QUEUE_PRESENT" "" "functions"
         ;;
 
+        blk_queue_max_secure_erase_sectors)
+            #
+            # Determine whether function blk_queue_max_secure_erase_sectors()
+            # is present.
+            #
+            # In Linux v5.19, commit 44abff2c0b97 ("block: decouple
+            # REQ_OP_SECURE_ERASE from REQ_OP_DISCARD") added the function
+            # blk_queue_max_secure_erase_sectors() and removed
+            # QUEUE_FLAG_SECERASE.
+            #
+            CODE="
+            #include <linux/blkdev.h>
+            void conftest_blk_queue_max_secure_erase_sectors(void) {
+                blk_queue_max_secure_erase_sectors();
+            }"
+
+            compile_check_conftest "$CODE" "NV_BLK_QUEUE_MAX_SECURE_ERASE_SECTORS_PRESENT" "" "functions"
+        ;;
+
+        blk_mq_ops_struct_map_queues_has_void_return)
+            #
+            # Determine if the 'map_queues' function pointer from the
+            # 'blk_mq_ops' structure has a void return type.
+            #
+            # In Linux v6.2, commit a4e1d0b76e7b ("block: Change the return
+            # type of blk_mq_map_queues() into void") made the 'map_queues'
+            # callback and blk_mq_map_queues() return void.
+            #
+            CODE="
+            #include <linux/blk-mq.h>
+            void conftest_blk_mq_ops_struct_map_queues_has_void_return(
+                struct blk_mq_ops *ops,
+                struct blk_mq_tag_set *set) {
+                    return ops->map_queues(set);
+            }"
+
+            compile_check_conftest "$CODE" \
+                    "NV_BLK_MQ_OPS_STRUCT_MAP_QUEUES_HAS_VOID_RETURN" "" "types"
+        ;;
+
+        blk_mq_ops_struct_poll_has_io_comp_batch_arg)
+            #
+            # Determine if the 'poll' function pointer from the 'blk_mq_ops'
+            # structure has a 'struct io_comp_batch' argument.
+            #
+            # In Linux v5.16, commit 5a72e899ceb4 ("block: add a struct
+            # io_comp_batch argument to fops->iopoll()") added the argument.
+            #
+            CODE="
+            #include <linux/blk-mq.h>
+            int conftest_blk_mq_ops_struct_poll_has_io_comp_batch_arg(
+                struct blk_mq_ops *ops,
+                struct blk_mq_hw_ctx *hctx,
+                struct io_comp_batch *iob) {
+                    return ops->poll(hctx, iob);
+            }"
+
+            compile_check_conftest "$CODE" \
+                    "NV_BLK_MQ_OPS_STRUCT_POLL_HAS_IO_COMP_BATCH_ARG" "" "types"
+        ;;
+
         block_device_operations_open_has_gendisk_arg)
             #
             # Determine if the 'open' function pointer from the
@@ -6835,6 +6915,24 @@ compile_test() {
             compile_check_conftest "$CODE" "NV_DRM_DRIVER_STRUCT_HAS_IRQ_ENABLED_ARG" "" "types"
         ;;
 
+        drm_driver_struct_has_show_fdinfo)
+            #
+            # Determine if the 'drm_driver' structure has the 'show_fdinfo'
+            # callback.
+            #
+            # Commit 376c25f8ca47 ("drm: Add common fdinfo helper") added
+            # the show_fdinfo callback and the drm_show_fdinfo() helper in
+            # Linux v6.5.
+            #
+            CODE="
+            #include <drm/drm_drv.h>
+            int conftest_drm_driver_struct_has_show_fdinfo(void) {
+                return offsetof(struct drm_driver, show_fdinfo);
+            }"
+
+            compile_check_conftest "$CODE" "NV_DRM_DRIVER_STRUCT_HAS_SHOW_FDINFO" "" "types"
+        ;;
+
         drm_fb_helper_alloc_info)
             #
             # Determine if the function 'drm_fb_helper_alloc_info' is present.
@@ -6954,6 +7052,23 @@ compile_test() {
                     "NV_DRM_SCDC_GET_SET_HAS_STRUCT_DRM_CONNECTOR_ARG" "" "types"
         ;;
 
+        eventfd_signal_has_counter_arg)
+            #
+            # Determine if the function 'eventfd_signal' has the 'n' counter
+            # argument.
+            #
+            # Commit 3652117f8548 ("eventfd: simplify eventfd_signal()")
+            # dropped the counter argument in Linux v6.8.
+            #
+            CODE="
+            #include <linux/eventfd.h>
+            void conftest_eventfd_signal_has_counter_arg(struct eventfd_ctx *ctx) {
+                    eventfd_signal(ctx, 1);
+            }"
+
+            compile_check_conftest "$CODE" "NV_EVENTFD_SIGNAL_HAS_COUNTER_ARG" "" "types"
+        ;;
+
         ethtool_ops_get_set_coalesce_has_coal_and_extack_args)
             #
             # Determine if the 'get_coalesce' and 'set_coalesce' ethtool_ops
@@ -7059,6 +7174,41 @@ compile_test() {
             compile_check_conftest "$CODE" "NV_NETIF_NAPI_ADD_WEIGHT_PRESENT" "" "functions"
         ;;
 
+        dev_set_threaded)
+            #
+            # Determine if dev_set_threaded() function is present
+            #
+            # Added by commit 5fdd2f0e5c64 ("net: add sysfs attribute to
+            # control napi threaded mode") in Linux v5.12.
+            #
+            CODE="
+            #include <linux/netdevice.h>
+            void conftest_dev_set_threaded(void)
+            {
+                    dev_set_threaded();
+            }
+            "
+            compile_check_conftest "$CODE" "NV_DEV_SET_THREADED_PRESENT" "" "functions"
+        ;;
+
+        net_dim_has_sample_ptr_arg)
+            #
+            # Determine if net_dim() takes a pointer to struct dim_sample.
+            #
+            # The sample argument was changed from a struct passed by value
+            # to a const pointer in Linux v6.13.
+            #
+            CODE="
+            #include <linux/dim.h>
+            void conftest_net_dim_has_sample_ptr_arg(struct dim *dim,
+                                                     const struct dim_sample *sample)
+            {
+                    net_dim(dim, sample);
+            }
+            "
+            compile_check_conftest "$CODE" "NV_NET_DIM_HAS_SAMPLE_PTR_ARG" "" "types"
+        ;;
+
         iommu_map_has_gfp_arg)
             #
             # Determine if iommu_map() has 'gfp' argument.
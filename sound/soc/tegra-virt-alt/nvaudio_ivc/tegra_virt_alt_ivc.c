@@ -43,6 +43,24 @@ int nvaudio_ivc_send_retry(struct nvaudio_ivc_ctxt *ictxt,
 }
 EXPORT_SYMBOL_GPL(nvaudio_ivc_send_retry);
 
+/*
+ * Queue a set request without waiting for the server. The server replies
+ * only to requests with ack_required set and handles requests in order, so
+ * a later nvaudio_ivc_send_receive() observes the update. Errors of posted
+ * requests are not reported back.
+ */
+int nvaudio_ivc_post(struct nvaudio_ivc_ctxt *ictxt,
+		struct nvaudio_ivc_msg *msg, int size)
+{
+	if (!msg)
+		return -EINVAL;
+
+	msg->ack_required = false;
+
+	return nvaudio_ivc_send_retry(ictxt, msg, size);
+}
+EXPORT_SYMBOL_GPL(nvaudio_ivc_post);
+
 int nvaudio_ivc_send(struct nvaudio_ivc_ctxt *ictxt,
 		struct nvaudio_ivc_msg *msg, int size)
 {
@@ -38,6 +38,10 @@ int nvaudio_ivc_send_retry(struct nvaudio_ivc_ctxt *ictxt,
 				struct nvaudio_ivc_msg *msg,
 				int size);
 
+int nvaudio_ivc_post(struct nvaudio_ivc_ctxt *ictxt,
+				struct nvaudio_ivc_msg *msg,
+				int size);
+
 int nvaudio_ivc_send_receive(struct nvaudio_ivc_ctxt *ictxt,
 				struct nvaudio_ivc_msg *msg,
 				int size);
@@ -11,6 +11,11 @@
 
 static const struct soc_enum *tegra_virt_enum_source;
 
+static bool async_route = true;
+module_param(async_route, bool, 0644);
+MODULE_PARM_DESC(async_route,
+	"Post crossbar route updates without waiting for the audio server");
+
 #define DAI(sname)						\
 	{							\
 		.name = #sname " CIF",				\
@@ -1069,11 +1074,20 @@ int tegra_virt_put_route(struct snd_kcontrol *kcontrol,
 
 	msg.params.xbar_info.tx_idx =
 		ucontrol->value.integer.value[0] - 1;
-	msg.ack_required = true;
 
-	err = nvaudio_ivc_send_receive(hivc_client,
-			&msg,
-			sizeof(struct nvaudio_ivc_msg));
+	/*
+	 * Switching a route graph updates dozens of muxes, posting them
+	 * saves a round trip to the audio server for each one.
+	 */
+	if (async_route) {
+		err = nvaudio_ivc_post(hivc_client, &msg,
+				sizeof(struct nvaudio_ivc_msg));
+	} else {
+		msg.ack_required = true;
+		err = nvaudio_ivc_send_receive(hivc_client,
+				&msg,
+				sizeof(struct nvaudio_ivc_msg));
+	}
 	if (err < 0) {
 		pr_err("%s: error on ivc_send_receive\n", __func__);
 
@@ -190,6 +190,10 @@ static snd_pcm_uframes_t tegra_alt_pcm_pointer
 	struct snd_pcm_runtime *runtime = substream->runtime;
 	char *appl_ptr;
 
+	/*
+	 * The guest owns its ADMA channel, so the position is read from the
+	 * channel's residue without a round trip to the audio server.
+	 */
 	pos = snd_dmaengine_pcm_pointer(substream);
 
 	/* In DRAINING state pointer callback comes from dma completion, here
@@ -347,6 +347,48 @@ static int tegra_admaif_hw_params(struct snd_pcm_substream *substream,
 	return 0;
 }
 
+/*
+ * Capture channels can be put in a sync group through the
+ * "ADMAIFx Capture Sync Group" control. The RX channels of a group are
+ * only enabled once every member has been triggered, and then all of
+ * them back to back with interrupts off, so that a multi channel capture
+ * split over several ADMAIF channels (e.g. linked PCMs) starts on the
+ * same frame. Returns false if the channel is not in a group.
+ */
+static bool tegra_admaif_group_start(struct tegra_admaif *admaif,
+				     unsigned int id)
+{
+	unsigned int group = admaif->capture_group[id];
+	unsigned long flags;
+	u32 members = 0;
+	unsigned int i;
+
+	if (!group)
+		return false;
+
+	for (i = 0; i < admaif->soc_data->num_ch; i++)
+		if (admaif->capture_group[i] == group)
+			members |= BIT(i);
+
+	spin_lock_irqsave(&admaif->group_lock, flags);
+
+	admaif->capture_group_armed |= BIT(id);
+	if ((admaif->capture_group_armed & members) == members) {
+		for (i = 0; i < admaif->soc_data->num_ch; i++) {
+			if (!(members & BIT(i)))
+				continue;
+			regmap_update_bits(admaif->regmap,
+				CH_RX_REG(TEGRA_ADMAIF_RX_ENABLE, i),
+				RX_ENABLE_MASK, RX_ENABLE);
+		}
+		admaif->capture_group_armed &= ~members;
+	}
+
+	spin_unlock_irqrestore(&admaif->group_lock, flags);
+
+	return true;
+}
+
 static int tegra_admaif_start(struct snd_soc_dai *dai, int direction)
 {
 	struct tegra_admaif *admaif = snd_soc_dai_get_drvdata(dai);
@@ -359,6 +401,9 @@ static int tegra_admaif_start(struct snd_soc_dai *dai, int direction)
 		reg = CH_TX_REG(TEGRA_ADMAIF_TX_ENABLE, dai->id);
 		break;
 	case SNDRV_PCM_STREAM_CAPTURE:
+		if (tegra_admaif_group_start(admaif, dai->id))
+			return 0;
+
 		mask = RX_ENABLE_MASK;
 		val = RX_ENABLE;
 		reg = CH_RX_REG(TEGRA_ADMAIF_RX_ENABLE, dai->id);
@@ -376,6 +421,7 @@ static int tegra_admaif_stop(struct snd_soc_dai *dai, int direction)
 {
 	struct tegra_admaif *admaif = snd_soc_dai_get_drvdata(dai);
 	unsigned int enable_reg, status_reg, reset_reg, mask, val;
+	unsigned long flags;
 	char *dir_name;
 	int err, enable;
 
@@ -389,6 +435,10 @@ static int tegra_admaif_stop(struct snd_soc_dai *dai, int direction)
 		reset_reg = CH_TX_REG(TEGRA_ADMAIF_TX_SOFT_RESET, dai->id);
 		break;
 	case SNDRV_PCM_STREAM_CAPTURE:
+		spin_lock_irqsave(&admaif->group_lock, flags);
+		admaif->capture_group_armed &= ~BIT(dai->id);
+		spin_unlock_irqrestore(&admaif->group_lock, flags);
+
 		mask = RX_ENABLE_MASK;
 		enable = RX_ENABLE;
 		dir_name = "RX";
@@ -626,6 +676,40 @@ static int tegra210_admaif_cput_client_ch(struct snd_kcontrol *kcontrol,
 	return 1;
 }
 
+static int tegra210_admaif_cget_sync_group(struct snd_kcontrol *kcontrol,
+	struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *cmpnt = snd_soc_kcontrol_component(kcontrol);
+	struct tegra_admaif *admaif = snd_soc_component_get_drvdata(cmpnt);
+	struct soc_mixer_control *mc =
+		(struct soc_mixer_control *)kcontrol->private_value;
+
+	ucontrol->value.integer.value[0] = admaif->capture_group[mc->reg];
+
+	return 0;
+}
+
+static int tegra210_admaif_cput_sync_group(struct snd_kcontrol *kcontrol,
+	struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_component *cmpnt = snd_soc_kcontrol_component(kcontrol);
+	struct tegra_admaif *admaif = snd_soc_component_get_drvdata(cmpnt);
+	struct soc_mixer_control *mc =
+		(struct soc_mixer_control *)kcontrol->private_value;
+	unsigned int value = ucontrol->value.integer.value[0];
+	unsigned long flags;
+
+	if (admaif->capture_group[mc->reg] == value)
+		return 0;
+
+	spin_lock_irqsave(&admaif->group_lock, flags);
+	admaif->capture_group[mc->reg] = value;
+	admaif->capture_group_armed &= ~BIT(mc->reg);
+	spin_unlock_irqrestore(&admaif->group_lock, flags);
+
+	return 1;
+}
+
 static int tegra210_admaif_get_reg_dump(struct snd_kcontrol *kcontrol,
 	struct snd_ctl_elem_value *ucontrol)
 {
@@ -1089,7 +1173,11 @@ static const char * const tegra_admaif_mono_conv_text[] = {
 		       tegra210_admaif_pput_client_ch),			  \
 	SOC_SINGLE_EXT("ADMAIF" #reg " Capture Client Channels", reg - 1, \
 		       0, 16, 0, tegra210_admaif_cget_client_ch,	  \
-		       tegra210_admaif_cput_client_ch)
+		       tegra210_admaif_cput_client_ch),			  \
+	SOC_SINGLE_EXT("ADMAIF" #reg " Capture Sync Group", reg - 1,	  \
+		       0, TEGRA_ADMAIF_MAX_SYNC_GROUPS, 0,		  \
+		       tegra210_admaif_cget_sync_group,			  \
+		       tegra210_admaif_cput_sync_group)
 
 /*
  * Below macro is added to avoid looping over all ADMAIFx controls related
@@ -1310,6 +1398,14 @@ static int tegra_admaif_probe(struct platform_device *pdev)
 			return -ENOMEM;
 	}
 
+	admaif->capture_group =
+		devm_kcalloc(&pdev->dev, admaif->soc_data->num_ch,
+			     sizeof(unsigned int), GFP_KERNEL);
+	if (!admaif->capture_group)
+		return -ENOMEM;
+
+	spin_lock_init(&admaif->group_lock);
+
 	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
 
 	regs = devm_ioremap_resource(&pdev->dev, res);
@@ -22,6 +22,9 @@
 #define TEGRA186_ADMAIF_RX_BASE				0x0
 #define TEGRA186_ADMAIF_TX_BASE				0x500
 #define TEGRA186_ADMAIF_GLOBAL_BASE			0xd00
+/* Max number of capture sync groups, see tegra_admaif_group_start() */
+#define TEGRA_ADMAIF_MAX_SYNC_GROUPS			10
+
 /* Global registers */
 #define TEGRA_ADMAIF_GLOBAL_ENABLE			0x0
 #define TEGRA_ADMAIF_GLOBAL_CG_0			0x8
@@ -160,6 +163,9 @@ struct tegra_admaif {
 	void __iomem *base_addr;
 	unsigned int *mono_to_stereo[ADMAIF_PATHS];
 	unsigned int *stereo_to_mono[ADMAIF_PATHS];
+	unsigned int *capture_group;
+	u32 capture_group_armed;
+	spinlock_t group_lock;
 	struct regmap *regmap;
 };
 
@@ -23,6 +23,7 @@
 #include <linux/platform_device.h>
 #include <linux/firmware.h>
 #include <linux/kthread.h>
+#include <linux/async.h>
 #include <linux/tegra_nvadsp.h>
 #include <linux/of_device.h>
 
@@ -186,7 +187,8 @@ static const struct snd_pcm_hardware adsp_pcm_hardware = {
 				  SNDRV_PCM_INFO_PAUSE |
 				  SNDRV_PCM_INFO_RESUME |
 				  SNDRV_PCM_INFO_INTERLEAVED |
-				  SNDRV_PCM_INFO_DRAIN_TRIGGER,
+				  SNDRV_PCM_INFO_DRAIN_TRIGGER |
+				  SNDRV_PCM_INFO_NO_PERIOD_WAKEUP,
 	.formats		= SNDRV_PCM_FMTBIT_S8 |
 				  SNDRV_PCM_FMTBIT_S16_LE |
 				  SNDRV_PCM_FMTBIT_S24_LE |
@@ -378,6 +380,15 @@ static void tegra210_adsp_deallocate_dma_buffer(struct snd_dma_buffer *buf)
 void tegra_adma_dump_ch_reg(void);
 #endif
 
+static ASYNC_DOMAIN_EXCLUSIVE(tegra210_adsp_app_load_domain);
+
+static void tegra210_adsp_app_load_async(void *data, async_cookie_t cookie)
+{
+	struct tegra210_adsp_app_desc *desc = data;
+
+	desc->handle = nvadsp_app_load(desc->name, desc->fw_name);
+}
+
 /* ADSP OS boot and init API */
 static int tegra210_adsp_init(struct tegra210_adsp *adsp)
 {
@@ -400,11 +411,17 @@ static int tegra210_adsp_init(struct tegra210_adsp *adsp)
 		goto exit;
 	}
 
-	/* Load ADSP audio apps */
+	/*
+	 * Load ADSP audio apps. Apps are independent of each other, so
+	 * fetch and relocate them in parallel and wait for all of them.
+	 */
+	for (i = 0; i < adsp_app_count; i++)
+		async_schedule_domain(tegra210_adsp_app_load_async,
+				      &adsp_app_desc[i],
+				      &tegra210_adsp_app_load_domain);
+	async_synchronize_full_domain(&tegra210_adsp_app_load_domain);
+
 	for (i = 0; i < adsp_app_count; i++) {
-		adsp_app_desc[i].handle = nvadsp_app_load(
-				adsp_app_desc[i].name,
-				adsp_app_desc[i].fw_name);
 		if (adsp_app_desc[i].handle) {
 			dev_info(adsp->dev, "Loaded app %s",
 				 adsp_app_desc[i].name);
@@ -1865,6 +1882,7 @@ static int tegra210_adsp_pcm_hw_params(struct snd_soc_component *component,
 {
 	struct tegra210_adsp_pcm_rtd *prtd = substream->runtime->private_data;
 	struct snd_dma_buffer *buf = &substream->dma_buffer;
+	size_t notify_size;
 	int ret = 0;
 
 	dev_vdbg(prtd->dev, "%s rate %d chan %d bps %d"
@@ -1880,8 +1898,20 @@ static int tegra210_adsp_pcm_hw_params(struct snd_soc_component *component,
 	if (ret < 0)
 		return ret;
 
-	ret = tegra210_adsp_send_period_size_msg(prtd->fe_apm,
-			params_buffer_bytes(params)/params_periods(params),
+	/*
+	 * Position is read from APM shared state in pcm_pointer, so with
+	 * no period wakeup ADSP only needs to notify once per buffer for
+	 * xrun accounting instead of a mailbox round trip every period.
+	 * runtime->no_period_wakeup is set only after this callback.
+	 */
+	if ((params->info & SNDRV_PCM_INFO_NO_PERIOD_WAKEUP) &&
+	    (params->flags & SNDRV_PCM_HW_PARAMS_NO_PERIOD_WAKEUP))
+		notify_size = params_buffer_bytes(params);
+	else
+		notify_size = params_buffer_bytes(params) /
+			params_periods(params);
+
+	ret = tegra210_adsp_send_period_size_msg(prtd->fe_apm, notify_size,
 			TEGRA210_ADSP_MSG_FLAG_SEND);
 	if (ret < 0)
 		return ret;
@@ -2772,7 +2802,8 @@ static int tegra210_adsp_widget_event(struct snd_soc_dapm_widget *w,
 				return ret;
 			}
 			if (app->min_adsp_clock)
-				adsp_update_dfs_min_rate(app->min_adsp_clock * 1000);
+				adsp_update_dfs_app_min_rate(
+					app->min_adsp_clock * 1000, true);
 
 			ret = tegra210_adsp_send_state_msg(app,
 				nvfx_state_active, TEGRA210_ADSP_MSG_FLAG_SEND);
@@ -2802,7 +2833,8 @@ static int tegra210_adsp_widget_event(struct snd_soc_dapm_widget *w,
 			if (ret < 0)
 				dev_err(adsp->dev, "Failed to reset.");
 			if (app->min_adsp_clock)
-				adsp_update_dfs_min_rate(0);
+				adsp_update_dfs_app_min_rate(
+					app->min_adsp_clock * 1000, false);
 
 			pm_runtime_put(adsp->dev);
 		}
@@ -13,6 +13,7 @@
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
 #include <linux/regmap.h>
+#include <linux/slab.h>
 #include <sound/soc.h>
 #include "tegra210_ahub.h"
 
@@ -1611,9 +1612,35 @@ static int __maybe_unused tegra_ahub_runtime_resume(struct device *dev)
 	return 0;
 }
 
+/*
+ * All XBAR mux registers come out of reset as 0 (no input selected).
+ * Telling regmap so lets regcache_sync() on runtime resume restore only
+ * the routes that are set, instead of writing every register of the
+ * XBAR aperture.
+ */
+static struct reg_default *tegra_ahub_zero_defaults(const struct regmap_config *cfg,
+						    unsigned int *num)
+{
+	struct reg_default *defs;
+	unsigned int i;
+
+	*num = cfg->max_register / cfg->reg_stride + 1;
+
+	defs = kcalloc(*num, sizeof(*defs), GFP_KERNEL);
+	if (!defs)
+		return NULL;
+
+	for (i = 0; i < *num; i++)
+		defs[i].reg = i * cfg->reg_stride;
+
+	return defs;
+}
+
 static int tegra_ahub_probe(struct platform_device *pdev)
 {
 	struct tegra_ahub *ahub;
+	struct regmap_config regmap_config;
+	struct reg_default *reg_defaults;
 	void __iomem *regs;
 	int err;
 
@@ -1635,8 +1662,16 @@ static int tegra_ahub_probe(struct platform_device *pdev)
 	if (IS_ERR(regs))
 		return PTR_ERR(regs);
 
-	ahub->regmap = devm_regmap_init_mmio(&pdev->dev, regs,
-					     ahub->soc_data->regmap_config);
+	regmap_config = *ahub->soc_data->regmap_config;
+	reg_defaults = tegra_ahub_zero_defaults(&regmap_config,
+						&regmap_config.num_reg_defaults);
+	if (!reg_defaults)
+		return -ENOMEM;
+	regmap_config.reg_defaults = reg_defaults;
+
+	/* regcache keeps its own copy of the defaults */
+	ahub->regmap = devm_regmap_init_mmio(&pdev->dev, regs, &regmap_config);
+	kfree(reg_defaults);
 	if (IS_ERR(ahub->regmap)) {
 		dev_err(&pdev->dev, "regmap init failed\n");
 		return PTR_ERR(ahub->regmap);
@@ -10,6 +10,9 @@
  *
  * Example Usage:
  *	tegra_gte_mon -d <device> -g <global gpio pin> -r -f
+ *
+ * Benchmark of a high-rate input, 256 events per read():
+ *	tegra_gte_mon -d <device> -g <global gpio pin> -r -f -b 256 -B
  */
 
 #include <unistd.h>
@@ -25,23 +28,100 @@
 #include <inttypes.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
+#include <time.h>
 #include <linux/tegra-gte-ioctl.h>
 
+#define MAX_BATCH	4096
+
+struct bench_stats {
+	uint64_t start_ns;
+	uint64_t last_ns;
+	uint64_t events;
+	uint64_t last_events;
+	uint64_t reads;
+	uint64_t drops;
+	int last_dir;
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * With both edges monitored the direction must alternate, two events in
+ * a row with the same direction mean at least one edge was dropped.
+ */
+static void bench_account(struct bench_stats *stats, unsigned int eventflags,
+			  const struct tegra_gte_hts_event_data *events,
+			  unsigned int num)
+{
+	unsigned int i;
+
+	stats->events += num;
+	stats->reads++;
+
+	if (eventflags != TEGRA_GTE_EVENT_REQ_BOTH_EDGES)
+		return;
+
+	for (i = 0; i < num; i++) {
+		if (stats->last_dir != -1 && events[i].dir == stats->last_dir)
+			stats->drops++;
+		stats->last_dir = events[i].dir;
+	}
+}
+
+static void bench_report(struct bench_stats *stats, unsigned int eventflags,
+			 bool final)
+{
+	uint64_t now = now_ns();
+	uint64_t period = now - (final ? stats->start_ns : stats->last_ns);
+	uint64_t events = stats->events - (final ? 0 : stats->last_events);
+
+	if (!final && period < 1000000000ULL)
+		return;
+
+	fprintf(stdout, "%s%.0f events/s, %" PRIu64 " events, %.1f events/read",
+		final ? "total: " : "",
+		period ? events * 1e9 / period : 0.0, stats->events,
+		stats->reads ? (double)stats->events / stats->reads : 0.0);
+	if (eventflags == TEGRA_GTE_EVENT_REQ_BOTH_EDGES)
+		fprintf(stdout, ", %" PRIu64 " dropped\n", stats->drops);
+	else
+		fprintf(stdout, ", drops need both edges\n");
+
+	stats->last_ns = now;
+	stats->last_events = stats->events;
+}
+
 int monitor_device(const char *device_name,
 		   unsigned int gnum,
 		   unsigned int eventflags,
-		   unsigned int loops)
+		   unsigned int loops,
+		   unsigned int batch,
+		   bool bench)
 {
 	struct tegra_gte_hts_event_req req = {0};
-	struct tegra_gte_hts_event_data event;
+	struct tegra_gte_hts_event_data *events;
+	struct bench_stats stats = { .last_dir = -1 };
 	char *chrdev_name;
+	unsigned int num, j;
 	int fd;
 	int ret;
-	int i = 0;
+	unsigned int i = 0;
+
+	events = calloc(batch, sizeof(*events));
+	if (!events)
+		return -ENOMEM;
 
 	ret = asprintf(&chrdev_name, "/dev/%s", device_name);
-	if (ret < 0)
+	if (ret < 0) {
+		free(events);
 		return -ENOMEM;
+	}
 
 	fd = open(chrdev_name, 0);
 	if (fd == -1) {
@@ -64,10 +144,14 @@ int monitor_device(const char *device_name,
 
 	fprintf(stdout, "Monitoring line %d on %s\n", gnum, device_name);
 
+	stats.start_ns = now_ns();
+	stats.last_ns = stats.start_ns;
+
 	while (1) {
-		ret = read(req.fd, &event, sizeof(event));
+		/* the event file returns as many whole events as fit */
+		ret = read(req.fd, events, batch * sizeof(*events));
 		if (ret == -1) {
-			if (errno == -EAGAIN) {
+			if (errno == EAGAIN) {
 				fprintf(stderr, "nothing available\n");
 				continue;
 			} else {
@@ -78,24 +162,38 @@ int monitor_device(const char *device_name,
 			}
 		}
 
-		if (ret != sizeof(event)) {
+		if (ret == 0 || ret % sizeof(*events)) {
 			fprintf(stderr, "Reading event failed\n");
 			ret = -EIO;
 			break;
 		}
 
-		fprintf(stdout, "HW timestamp GPIO EVENT %" PRIu64 "\n",
-			event.timestamp);
+		num = ret / sizeof(*events);
+		ret = 0;
+
+		if (bench) {
+			bench_account(&stats, eventflags, events, num);
+			bench_report(&stats, eventflags, false);
+		} else {
+			for (j = 0; j < num; j++)
+				fprintf(stdout,
+					"HW timestamp GPIO EVENT %" PRIu64 "\n",
+					events[j].timestamp);
+		}
 
-		i++;
-		if (i == loops)
+		i += num;
+		if (loops && i >= loops)
 			break;
 	}
 
+	if (bench)
+		bench_report(&stats, eventflags, true);
+
 exit_close_error:
 	if (close(fd) == -1)
 		perror("Failed to close GPIO character device file");
 	free(chrdev_name);
+	free(events);
 	return ret;
 }
 
@@ -107,13 +205,15 @@ void print_usage(char *bin_name)
 		"  -g <n>     GPIO global id\n"
 		"  -r         Listen for rising edges\n"
 		"  -f         Listen for falling edges\n"
-		" [-c <n>]    Do <n> loops (optional, infinite loop if not stated)\n"
+		" [-c <n>]    Read <n> events (optional, infinite loop if not stated)\n"
+		" [-b <n>]    Read up to <n> events per read() (default 1, max %u)\n"
+		" [-B]        Benchmark: report events/s and drops instead of events\n"
 		"  -h         This helptext\n"
 		"\n"
 		"Example:\n"
 		"%s -d gtechip0 -g 257 -r -f\n"
 		"(means GPIO 257 rising and falling edge monitoring)\n",
-		bin_name, bin_name
+		bin_name, MAX_BATCH, bin_name
 	);
 }
 
@@ -123,10 +223,18 @@ int main(int argc, char **argv)
 	unsigned int gnum = -1;
 	unsigned int loops = 0;
 	unsigned int eventflags = 0;
+	unsigned int batch = 1;
+	bool bench = false;
 	int c;
 
-	while ((c = getopt(argc, argv, "c:g:d:rfh")) != -1) {
+	while ((c = getopt(argc, argv, "b:Bc:g:d:rfh")) != -1) {
 		switch (c) {
+		case 'b':
+			batch = strtoul(optarg, NULL, 10);
+			break;
+		case 'B':
+			bench = true;
+			break;
 		case 'c':
 			loops = strtoul(optarg, NULL, 10);
 			break;
@@ -148,7 +256,7 @@ int main(int argc, char **argv)
 		}
 	}
 
-	if (!device_name || gnum == -1) {
+	if (!device_name || gnum == -1 || !batch || batch > MAX_BATCH) {
 		print_usage(argv[0]);
 		return 1;
 	}
@@ -158,5 +266,6 @@ int main(int argc, char **argv)
 		       "falling edges\n");
 		eventflags = TEGRA_GTE_EVENT_REQ_BOTH_EDGES;
 	}
-	return monitor_device(device_name, gnum, eventflags, loops);
+	return monitor_device(device_name, gnum, eventflags, loops, batch,
+			      bench);
 }